@@ -347,20 +347,6 @@ void          oo_thermal_check_and_act(void)                {}
 void          oo_thermal_print(const void *s)               { (void)s; }
 int           oo_thermal_repl_cmd(const char *cmd)          { (void)cmd; return 0; }
 
-/* ── Phase 6C: LoRA stubs ───────────────────────────────────────────────── */
-int           oo_lora_init(void *st, uint32_t nl, uint32_t d,
-                            uint32_t r)                     { (void)st;(void)nl;(void)d;(void)r; return 0; }
-void          oo_lora_forward(void *a, const float *x,
-                               float *o, uint32_t n)        { (void)a;(void)x;(void)o;(void)n; }
-void          oo_lora_backward_step(void *st, const float *g,
-                                     uint32_t l, uint32_t p){ (void)st;(void)g;(void)l;(void)p; }
-float         oo_lora_score(const void *st)                 { (void)st; return 0.0f; }
-int           oo_lora_persist(const void *st, const char *p){ (void)st;(void)p; return 0; }
-int           oo_lora_load(void *st, const char *p)         { (void)st;(void)p; return 0; }
-void          oo_lora_apply_to_model(void *st, void *w)     { (void)st;(void)w; }
-void          oo_lora_print(const void *st)                 { (void)st; }
-int           oo_lora_repl_cmd(void *st, const char *cmd)   { (void)st;(void)cmd; return 0; }
-
 /* ── Phase 6E: Evolution bridge stubs ──────────────────────────────────── */
 void          oo_evo_init(void)                             {}
 int           oo_evo_apply_gradient(uint32_t l, uint32_t p,
@@ -65,10 +65,11 @@ typedef struct {
 
 // -----------------------------------------------------------------------------
 // Minimal serial debug (COM1) so QEMU -serial file captures diagnostics.
-// OVMF typically exposes COM1 at 0x3F8.
+// OVMF typically exposes COM1 at 0x3F8. Host builds (engine/host) have no
+// port I/O in userspace and only keep the console copy.
 // -----------------------------------------------------------------------------
 
-#if defined(__x86_64__) || defined(_M_X64)
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(LLMK_HOST_BUILD)
 static __inline__ UINT8 llmk_inb(UINT16 port) {
     UINT8 ret;
     __asm__ __volatile__("inb %1, %0" : "=a"(ret) : "Nd"(port));
@@ -145,6 +146,15 @@ struct LlmkGgufPlan {
     LlmkGgufTensorRef *ffn_gate;
     LlmkGgufTensorRef *ffn_down;
     LlmkGgufTensorRef *ffn_up;
+    LlmkGgufTensorRef *bq;  // attention biases (qwen2); absent elsewhere
+    LlmkGgufTensorRef *bk;
+    LlmkGgufTensorRef *bv;
+
+    int dim;
+    int kv_dim;
+
+    LlmkRopeParams rope;    // from <arch>.rope.* (llama2.c defaults when absent)
+    LlmkArch arch;          // resolved from general.architecture + <arch>.attention.*
 };
 
 static EFI_STATUS gguf_read_exact(EFI_FILE_HANDLE f, void *dst, UINTN nbytes) {
@@ -287,6 +297,169 @@ static EFI_STATUS gguf_skip_kv_value(EFI_FILE_HANDLE f, gguf_kv_type t) {
     }
 }
 
+// Numeric KV value as double (u8..u64, i8..i64, f32, f64, bool). Other types
+// are skipped and reported as EFI_UNSUPPORTED.
+static EFI_STATUS gguf_read_kv_number(EFI_FILE_HANDLE f, gguf_kv_type t, double *out) {
+    union { UINT8 b[8]; UINT32 u32; UINT64 u64; INT32 i32; INT64 i64; float f32; double f64; } v;
+    UINTN n = 0;
+    switch (t) {
+        case GGUF_KV_UINT8: case GGUF_KV_INT8: case GGUF_KV_BOOL: n = 1; break;
+        case GGUF_KV_UINT16: case GGUF_KV_INT16: n = 2; break;
+        case GGUF_KV_UINT32: case GGUF_KV_INT32: case GGUF_KV_FLOAT32: n = 4; break;
+        case GGUF_KV_UINT64: case GGUF_KV_INT64: case GGUF_KV_FLOAT64: n = 8; break;
+        default: {
+            EFI_STATUS st = gguf_skip_kv_value(f, t);
+            return EFI_ERROR(st) ? st : EFI_UNSUPPORTED;
+        }
+    }
+    v.u64 = 0;
+    EFI_STATUS st = gguf_read_exact(f, v.b, n);
+    if (EFI_ERROR(st)) return st;
+    switch (t) {
+        case GGUF_KV_INT8: *out = (double)(INT8)v.b[0]; break;
+        case GGUF_KV_UINT16: *out = (double)(UINT16)(v.b[0] | (v.b[1] << 8)); break;
+        case GGUF_KV_INT16: *out = (double)(INT16)(v.b[0] | (v.b[1] << 8)); break;
+        case GGUF_KV_UINT32: *out = (double)v.u32; break;
+        case GGUF_KV_INT32: *out = (double)v.i32; break;
+        case GGUF_KV_FLOAT32: *out = (double)v.f32; break;
+        case GGUF_KV_UINT64: *out = (double)v.u64; break;
+        case GGUF_KV_INT64: *out = (double)v.i64; break;
+        case GGUF_KV_FLOAT64: *out = v.f64; break;
+        default: *out = (double)v.b[0]; break;
+    }
+    return EFI_SUCCESS;
+}
+
+// Short string KV value into buf (truncated, NUL-terminated). Non-strings are skipped.
+static EFI_STATUS gguf_read_kv_short_string(EFI_FILE_HANDLE f, gguf_kv_type t, char *buf, UINTN cap) {
+    buf[0] = 0;
+    if (t != GGUF_KV_STRING) {
+        EFI_STATUS st = gguf_skip_kv_value(f, t);
+        return EFI_ERROR(st) ? st : EFI_UNSUPPORTED;
+    }
+    UINT64 n = 0;
+    EFI_STATUS st = gguf_read_u64(f, &n);
+    if (EFI_ERROR(st)) return st;
+    UINTN keep = (n < (UINT64)(cap - 1)) ? (UINTN)n : cap - 1;
+    st = gguf_read_exact(f, buf, keep);
+    if (EFI_ERROR(st)) return st;
+    buf[keep] = 0;
+    return (n > keep) ? gguf_skip(f, n - keep) : EFI_SUCCESS;
+}
+
+static int llmk_cstr_eq(const char *a, const char *lit) {
+    UINTN n = 0;
+    while (a[n]) n++;
+    return llmk_key_eq(a, n, lit);
+}
+
+// "<arch>.rope.<suffix>": returns the suffix, or NULL
+static const char *llmk_rope_key_suffix(const char *key, UINTN key_len) {
+    UINTN i = 0;
+    while (i < key_len && key[i] != '.') i++;
+    if (i + 6 > key_len || !llmk_str_eq_n(key + i, ".rope.", 6)) return NULL;
+    return key + i + 6;
+}
+
+// "<arch>.<suffix>" for model hyperparameters: returns the suffix, or NULL
+// for general.* / tokenizer.* keys
+static const char *llmk_arch_key_suffix(const char *key, UINTN key_len) {
+    UINTN i = 0;
+    while (i < key_len && key[i] != '.') i++;
+    if (i == 0 || i >= key_len) return NULL;
+    if (llmk_key_eq(key, i, "general") || llmk_key_eq(key, i, "tokenizer")) return NULL;
+    return key + i + 1;
+}
+
+// Architectures whose GGUF q/k weights use the NeoX (split-half) pair layout
+static int llmk_arch_rope_neox(const char *arch) {
+    static const char *const neox[] = { "gptneox", "qwen2", "qwen2moe", "qwen3", "phi2", "phi3",
+                                        "falcon", "stablelm", "starcoder2", "gemma", "gemma2",
+                                        "olmo2", "codeshell", "orion", "bert", "nomic-bert" };
+    for (UINTN i = 0; i < sizeof(neox) / sizeof(neox[0]); i++) {
+        if (llmk_cstr_eq(arch, neox[i])) return 1;
+    }
+    return 0;
+}
+
+// Architecture descriptors, keyed on general.architecture. Tensor names are
+// the llama.cpp ones (blk.N.attn_q.weight, ...); the flags say which of them
+// are fused and what the forward pass does differently. Names not listed run
+// as llama with the pair layout from llmk_arch_rope_neox.
+typedef struct {
+    const char *name;
+    int   rope_neox;
+    int   act;              // LLMK_ARCH_ACT_*
+    float norm_eps;         // unless <arch>.attention.layer_norm_rms_epsilon is set
+    int   embed_sqrt_dim;   // token embeddings scaled by sqrt(dim)
+    int   qkv_bias;         // blk.N.attn_{q,k,v}.bias (or attn_qkv.bias) required
+    int   fused_qkv;        // blk.N.attn_qkv.weight: rows q | k | v
+    int   fused_gate_up;    // blk.N.ffn_up.weight: rows gate | up
+    int   window_policy;    // LLMK_ARCH_WINDOW_*; span from <arch>.attention.sliding_window
+} LlmkArchDesc;
+
+static const LlmkArchDesc k_llmk_arch_desc[] = {
+    { "llama",   0, LLMK_ARCH_ACT_SILU,      1e-5f, 0, 0, 0, 0, LLMK_ARCH_WINDOW_NONE },
+    { "mistral", 0, LLMK_ARCH_ACT_SILU,      1e-5f, 0, 0, 0, 0, LLMK_ARCH_WINDOW_ALL },
+    { "qwen2",   1, LLMK_ARCH_ACT_SILU,      1e-6f, 0, 1, 0, 0, LLMK_ARCH_WINDOW_NONE },
+    { "phi3",    1, LLMK_ARCH_ACT_SILU,      1e-5f, 0, 0, 1, 1, LLMK_ARCH_WINDOW_ALL },
+    { "gemma",   1, LLMK_ARCH_ACT_GELU_TANH, 1e-6f, 1, 0, 0, 0, LLMK_ARCH_WINDOW_NONE },
+};
+
+static const LlmkArchDesc *llmk_arch_find(const char *arch) {
+    for (UINTN i = 0; i < sizeof(k_llmk_arch_desc) / sizeof(k_llmk_arch_desc[0]); i++) {
+        if (llmk_cstr_eq(arch, k_llmk_arch_desc[i].name)) return &k_llmk_arch_desc[i];
+    }
+    return NULL;
+}
+
+static float llmk_sqrt_f32(float x) {
+    if (x <= 0.0f) return 0.0f;
+    float r = (x > 1.0f) ? x : 1.0f;
+    for (int i = 0; i < 32; i++) r = 0.5f * (r + x / r);
+    return r;
+}
+
+// Applies one <arch>.rope.* key to rp. Unknown rope keys are skipped.
+static EFI_STATUS gguf_read_rope_kv(EFI_FILE_HANDLE f, gguf_kv_type vt, const char *suffix, LlmkRopeParams *rp) {
+    double v = 0.0;
+    EFI_STATUS st;
+    if (llmk_cstr_eq(suffix, "scaling.type")) {
+        char name[16];
+        st = gguf_read_kv_short_string(f, vt, name, sizeof(name));
+        if (st == EFI_UNSUPPORTED) return EFI_SUCCESS;
+        if (EFI_ERROR(st)) return st;
+        if (llmk_cstr_eq(name, "linear")) rp->scaling = LLMK_ROPE_SCALING_LINEAR;
+        else if (llmk_cstr_eq(name, "yarn")) rp->scaling = LLMK_ROPE_SCALING_YARN;
+        else if (llmk_cstr_eq(name, "ntk")) rp->scaling = LLMK_ROPE_SCALING_NTK;
+        else rp->scaling = LLMK_ROPE_SCALING_NONE;
+        return EFI_SUCCESS;
+    }
+    st = gguf_read_kv_number(f, vt, &v);
+    if (st == EFI_UNSUPPORTED) return EFI_SUCCESS;
+    if (EFI_ERROR(st)) return st;
+    if (llmk_cstr_eq(suffix, "freq_base")) {
+        if (v > 0.0) rp->freq_base = (float)v;
+    } else if (llmk_cstr_eq(suffix, "dimension_count")) {
+        if (v > 0.0 && v < 65536.0) rp->n_rot = (int)v;
+    } else if (llmk_cstr_eq(suffix, "scaling.factor")) {
+        if (v >= 1.0) rp->factor = (float)v;
+    } else if (llmk_cstr_eq(suffix, "scale_linear")) {
+        // legacy key: implies linear scaling
+        if (v > 1.0) {
+            rp->factor = (float)v;
+            if (rp->scaling == LLMK_ROPE_SCALING_NONE) rp->scaling = LLMK_ROPE_SCALING_LINEAR;
+        }
+    } else if (llmk_cstr_eq(suffix, "scaling.original_context_length")) {
+        if (v > 0.0 && v < 16777216.0) rp->orig_ctx = (int)v;
+    } else if (llmk_cstr_eq(suffix, "scaling.yarn_beta_fast")) {
+        if (v > 0.0) rp->yarn_beta_fast = (float)v;
+    } else if (llmk_cstr_eq(suffix, "scaling.yarn_beta_slow")) {
+        if (v > 0.0) rp->yarn_beta_slow = (float)v;
+    }
+    return EFI_SUCCESS;
+}
+
 static int llmk_is_digit(char c) {
     return (c >= '0' && c <= '9');
 }
@@ -322,6 +495,13 @@ typedef enum {
     ROLE_FFN_GATE,
     ROLE_FFN_DOWN,
     ROLE_FFN_UP,
+
+    // Fused / optional (see LlmkArchDesc)
+    ROLE_WQKV,
+    ROLE_BQ,
+    ROLE_BK,
+    ROLE_BV,
+    ROLE_BQKV,
 } LlmkTensorRole;
 
 static int llmk_parse_role(const char *name, int *out_layer, LlmkTensorRole *out_role) {
@@ -424,6 +604,33 @@ static int llmk_parse_role(const char *name, int *out_layer, LlmkTensorRole *out
         *out_role = ROLE_WO;
         return 1;
     }
+    if (llmk_str_eq_n(rest, "attn_qkv.weight", 15) && rest[15] == 0) {
+        *out_layer = layer;
+        *out_role = ROLE_WQKV;
+        return 1;
+    }
+
+    // attn_q.bias / attn_k.bias / attn_v.bias / attn_qkv.bias
+    if (llmk_str_eq_n(rest, "attn_q.bias", 11) && rest[11] == 0) {
+        *out_layer = layer;
+        *out_role = ROLE_BQ;
+        return 1;
+    }
+    if (llmk_str_eq_n(rest, "attn_k.bias", 11) && rest[11] == 0) {
+        *out_layer = layer;
+        *out_role = ROLE_BK;
+        return 1;
+    }
+    if (llmk_str_eq_n(rest, "attn_v.bias", 11) && rest[11] == 0) {
+        *out_layer = layer;
+        *out_role = ROLE_BV;
+        return 1;
+    }
+    if (llmk_str_eq_n(rest, "attn_qkv.bias", 13) && rest[13] == 0) {
+        *out_layer = layer;
+        *out_role = ROLE_BQKV;
+        return 1;
+    }
 
     // ffn gate/up/down
     if (llmk_str_eq_n(rest, "ffn_gate.weight", 15) && rest[15] == 0) {
@@ -479,6 +686,13 @@ static EFI_STATUS llmk_alloc_layer_arrays(LlmkGgufPlan *p, int n_layers) {
     st = uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, bytes, (void **)&p->ffn_up);
     if (EFI_ERROR(st)) return st;
 
+    st = uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, bytes, (void **)&p->bq);
+    if (EFI_ERROR(st)) return st;
+    st = uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, bytes, (void **)&p->bk);
+    if (EFI_ERROR(st)) return st;
+    st = uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, bytes, (void **)&p->bv);
+    if (EFI_ERROR(st)) return st;
+
     // zero
     for (int i = 0; i < n_layers; i++) {
         p->attn_norm[i].present = 0;
@@ -490,11 +704,24 @@ static EFI_STATUS llmk_alloc_layer_arrays(LlmkGgufPlan *p, int n_layers) {
         p->ffn_gate[i].present = 0;
         p->ffn_down[i].present = 0;
         p->ffn_up[i].present = 0;
+        p->bq[i].present = 0;
+        p->bk[i].present = 0;
+        p->bv[i].present = 0;
     }
 
     return EFI_SUCCESS;
 }
 
+void llmk_gguf_plan_rope(const LlmkGgufPlan *plan, LlmkRopeParams *out) {
+    if (!plan || !out) return;
+    *out = plan->rope;
+}
+
+void llmk_gguf_plan_arch(const LlmkGgufPlan *plan, LlmkArch *out) {
+    if (!plan || !out) return;
+    *out = plan->arch;
+}
+
 void llmk_gguf_free_plan(LlmkGgufPlan *plan) {
     if (!plan) return;
     if (plan->attn_norm) uefi_call_wrapper(BS->FreePool, 1, plan->attn_norm);
@@ -506,6 +733,9 @@ void llmk_gguf_free_plan(LlmkGgufPlan *plan) {
     if (plan->ffn_gate) uefi_call_wrapper(BS->FreePool, 1, plan->ffn_gate);
     if (plan->ffn_down) uefi_call_wrapper(BS->FreePool, 1, plan->ffn_down);
     if (plan->ffn_up) uefi_call_wrapper(BS->FreePool, 1, plan->ffn_up);
+    if (plan->bq) uefi_call_wrapper(BS->FreePool, 1, plan->bq);
+    if (plan->bk) uefi_call_wrapper(BS->FreePool, 1, plan->bk);
+    if (plan->bv) uefi_call_wrapper(BS->FreePool, 1, plan->bv);
     uefi_call_wrapper(BS->FreePool, 1, plan);
 }
 
@@ -1166,6 +1396,315 @@ static EFI_STATUS llmk_load_tensor_2d(
     return EFI_SUCCESS;
 }
 
+// Rows [row0, row0 + rows) of a fused 2D tensor (elements of a 1D one) as a
+// standalone ref. Rows are stored contiguously, so only the offset and the
+// outer dim change; the loaders and the Q8_0 copy take the slice as is.
+static int llmk_tensor_slice(const LlmkGgufTensorRef *t, UINT64 row0, UINT64 rows, LlmkGgufTensorRef *out) {
+    UINT64 row_bytes = 0;
+    if (t->n_dims == 1) {
+        if (row0 + rows > t->dims[0]) return 0;
+        if (EFI_ERROR(llmk_row_raw_bytes(t->type, 1, &row_bytes))) return 0;
+    } else if (t->n_dims == 2) {
+        if (row0 + rows > t->dims[1]) return 0;
+        if (EFI_ERROR(llmk_row_raw_bytes(t->type, t->dims[0], &row_bytes))) return 0;
+    } else {
+        return 0;
+    }
+    *out = *t;
+    out->offset = t->offset + row0 * row_bytes;
+    out->dims[t->n_dims - 1] = rows;
+    return 1;
+}
+
+UINT64 llmk_gguf_plan_bias_floats(const LlmkGgufPlan *plan) {
+    if (!plan || !plan->arch.qkv_bias) return 0;
+    return (UINT64)plan->n_layers * (UINT64)(plan->dim + 2 * plan->kv_dim);
+}
+
+EFI_STATUS llmk_gguf_load_qkv_bias(EFI_FILE_HANDLE f, const LlmkGgufPlan *plan, float *dst, UINT64 n_floats) {
+    if (!f || !plan || !dst) return EFI_INVALID_PARAMETER;
+    if (n_floats < llmk_gguf_plan_bias_floats(plan)) return EFI_BUFFER_TOO_SMALL;
+    if (!plan->arch.qkv_bias) return EFI_SUCCESS;
+
+    UINT64 row_buf_bytes = plan->max_row_raw_bytes;
+    if (row_buf_bytes < 4096) row_buf_bytes = 4096;
+    void *row_buf = NULL;
+    EFI_STATUS st = uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, (UINTN)row_buf_bytes, (void **)&row_buf);
+    if (EFI_ERROR(st) || !row_buf) return EFI_OUT_OF_RESOURCES;
+
+    const LlmkGgufTensorRef *arrs[3] = { plan->bq, plan->bk, plan->bv };
+    const UINT64 lens[3] = { (UINT64)plan->dim, (UINT64)plan->kv_dim, (UINT64)plan->kv_dim };
+    float *p = dst;
+    for (int a = 0; a < 3 && !EFI_ERROR(st); a++) {
+        for (int l = 0; l < plan->n_layers; l++) {
+            UINT64 abs = plan->data_start + arrs[a][l].offset;
+            st = llmk_load_tensor_1d(f, abs, &arrs[a][l], p, lens[a], row_buf, row_buf_bytes);
+            if (EFI_ERROR(st)) break;
+            p += (UINTN)lens[a];
+        }
+    }
+    uefi_call_wrapper(BS->FreePool, 1, row_buf);
+    return st;
+}
+
+// ============================================================================
+// Embedded tokenizer (tokenizer.ggml.*)
+// ============================================================================
+
+typedef struct {
+    char   model[16];               // tokenizer.ggml.model
+    char   pre[32];                 // tokenizer.ggml.pre
+    UINT64 n_tokens;
+    UINT64 tokens_pos, tokens_bytes;   // serialized strings after the array header
+    UINT64 n_merges;
+    UINT64 merges_pos, merges_bytes;
+    UINT64 n_scores, scores_pos;    // f32 array (pos 0 = absent or other type)
+    UINT64 n_types, types_pos;      // i32 array
+    int    bos, eos, eot, unk;      // -1 = absent
+    int    add_bos, add_space_prefix;   // -1 = absent
+} LlmkGgufVocabScan;
+
+// Array header of a KV value: element type and count. Non-arrays are skipped
+// and reported as EFI_UNSUPPORTED.
+static EFI_STATUS gguf_read_array_header(EFI_FILE_HANDLE f, gguf_kv_type t, gguf_kv_type *elem, UINT64 *n) {
+    if (t != GGUF_KV_ARRAY) {
+        EFI_STATUS st = gguf_skip_kv_value(f, t);
+        return EFI_ERROR(st) ? st : EFI_UNSUPPORTED;
+    }
+    UINT32 e = 0;
+    EFI_STATUS st = gguf_read_u32(f, &e);
+    if (EFI_ERROR(st)) return st;
+    *elem = (gguf_kv_type)e;
+    return gguf_read_u64(f, n);
+}
+
+// String array: where the serialized strings start and how many bytes they
+// span, so the loader can fetch them with one Read.
+static EFI_STATUS gguf_scan_string_array(EFI_FILE_HANDLE f, gguf_kv_type t, UINT64 *n, UINT64 *pos, UINT64 *bytes) {
+    gguf_kv_type elem = GGUF_KV_UINT8;
+    EFI_STATUS st = gguf_read_array_header(f, t, &elem, n);
+    if (EFI_ERROR(st)) return st;
+    if (elem != GGUF_KV_STRING) return EFI_COMPROMISED_DATA;
+    st = gguf_get_pos(f, pos);
+    for (UINT64 i = 0; i < *n && !EFI_ERROR(st); i++) st = gguf_skip_kv_value(f, GGUF_KV_STRING);
+    UINT64 end = 0;
+    if (!EFI_ERROR(st)) st = gguf_get_pos(f, &end);
+    if (EFI_ERROR(st)) return st;
+    *bytes = end - *pos;
+    return EFI_SUCCESS;
+}
+
+// 4-byte numeric array: position of its elements when they are of type want.
+// Arrays of any other type are skipped and leave *pos at 0.
+static EFI_STATUS gguf_scan_num_array(EFI_FILE_HANDLE f, gguf_kv_type t, gguf_kv_type want, UINT64 *n, UINT64 *pos) {
+    UINT64 start = 0;
+    EFI_STATUS st = gguf_get_pos(f, &start);
+    if (EFI_ERROR(st)) return st;
+    gguf_kv_type elem = GGUF_KV_UINT8;
+    st = gguf_read_array_header(f, t, &elem, n);
+    if (EFI_ERROR(st)) return st;
+    if (elem != want) {
+        *n = 0;
+        st = gguf_seek(f, start);
+        return EFI_ERROR(st) ? st : gguf_skip_kv_value(f, GGUF_KV_ARRAY);
+    }
+    st = gguf_get_pos(f, pos);
+    if (EFI_ERROR(st)) return st;
+    return gguf_skip(f, *n * 4);
+}
+
+static EFI_STATUS llmk_gguf_scan_vocab(EFI_FILE_HANDLE f, LlmkGgufVocabScan *s) {
+    for (UINTN k = 0; k < sizeof(*s); k++) ((UINT8 *)s)[k] = 0;
+    s->bos = s->eos = s->eot = s->unk = -1;
+    s->add_bos = s->add_space_prefix = -1;
+
+    EFI_STATUS st = gguf_seek(f, 0);
+    if (EFI_ERROR(st)) return st;
+    UINT8 magic[4];
+    UINT32 version = 0;
+    UINT64 n_tensors = 0, n_kv = 0;
+    st = gguf_read_exact(f, magic, 4);
+    if (EFI_ERROR(st)) return st;
+    if (!(magic[0] == 'G' && magic[1] == 'G' && magic[2] == 'U' && magic[3] == 'F')) return EFI_UNSUPPORTED;
+    st = gguf_read_u32(f, &version);
+    if (!EFI_ERROR(st)) st = gguf_read_u64(f, &n_tensors);
+    if (!EFI_ERROR(st)) st = gguf_read_u64(f, &n_kv);
+    if (EFI_ERROR(st)) return st;
+
+    for (UINT64 i = 0; i < n_kv; i++) {
+        UINT64 key_len64 = 0;
+        st = gguf_read_u64(f, &key_len64);
+        if (EFI_ERROR(st)) return st;
+        if (key_len64 == 0 || key_len64 > 4096) return EFI_COMPROMISED_DATA;
+        char key_buf[192];
+        UINTN keep = (key_len64 < sizeof(key_buf)) ? (UINTN)key_len64 : sizeof(key_buf) - 1;
+        st = gguf_read_exact(f, key_buf, keep);
+        if (EFI_ERROR(st)) return st;
+        key_buf[keep] = 0;
+        if (key_len64 > keep) {
+            st = gguf_skip(f, key_len64 - (UINT64)keep);
+            if (EFI_ERROR(st)) return st;
+        }
+        UINT32 vt_u32 = 0;
+        st = gguf_read_u32(f, &vt_u32);
+        if (EFI_ERROR(st)) return st;
+        gguf_kv_type vt = (gguf_kv_type)vt_u32;
+
+        const char *k = (keep > 15 && llmk_str_eq_n(key_buf, "tokenizer.ggml.", 15)) ? key_buf + 15 : NULL;
+        if (!k) {
+            st = gguf_skip_kv_value(f, vt);
+        } else if (llmk_cstr_eq(k, "model")) {
+            st = gguf_read_kv_short_string(f, vt, s->model, sizeof(s->model));
+        } else if (llmk_cstr_eq(k, "pre")) {
+            st = gguf_read_kv_short_string(f, vt, s->pre, sizeof(s->pre));
+        } else if (llmk_cstr_eq(k, "tokens")) {
+            st = gguf_scan_string_array(f, vt, &s->n_tokens, &s->tokens_pos, &s->tokens_bytes);
+        } else if (llmk_cstr_eq(k, "merges")) {
+            st = gguf_scan_string_array(f, vt, &s->n_merges, &s->merges_pos, &s->merges_bytes);
+        } else if (llmk_cstr_eq(k, "scores") || llmk_cstr_eq(k, "token_type")) {
+            const int is_scores = llmk_cstr_eq(k, "scores");
+            st = gguf_scan_num_array(f, vt, is_scores ? GGUF_KV_FLOAT32 : GGUF_KV_INT32,
+                                     is_scores ? &s->n_scores : &s->n_types,
+                                     is_scores ? &s->scores_pos : &s->types_pos);
+        } else {
+            double v = 0.0;
+            st = gguf_read_kv_number(f, vt, &v);
+            if (!EFI_ERROR(st)) {
+                const int iv = (v >= 0.0 && v < 2147483647.0) ? (int)v : -1;
+                if (llmk_cstr_eq(k, "bos_token_id")) s->bos = iv;
+                else if (llmk_cstr_eq(k, "eos_token_id")) s->eos = iv;
+                else if (llmk_cstr_eq(k, "eot_token_id")) s->eot = iv;
+                else if (llmk_cstr_eq(k, "unknown_token_id")) s->unk = iv;
+                else if (llmk_cstr_eq(k, "add_bos_token")) s->add_bos = (v != 0.0);
+                else if (llmk_cstr_eq(k, "add_space_prefix")) s->add_space_prefix = (v != 0.0);
+            }
+        }
+        if (st == EFI_UNSUPPORTED) st = EFI_SUCCESS;
+        if (EFI_ERROR(st)) return st;
+    }
+    if (!s->n_tokens) return EFI_NOT_FOUND;
+    if (s->n_tokens > 0x7FFFFFFFULL || s->n_merges > 0x7FFFFFFFULL) return EFI_COMPROMISED_DATA;
+    if (s->n_scores != s->n_tokens) s->scores_pos = 0;
+    if (s->n_types != s->n_tokens) s->types_pos = 0;
+    if (!llmk_cstr_eq(s->model, "llama") && !llmk_cstr_eq(s->model, "gpt2")) {
+        CHAR16 msg[128];
+        SPrint(msg, sizeof(msg), L"GGUF: tokenizer model '%a' is not supported (llama, gpt2)\r\n", s->model);
+        llmk_dbg_print_both(msg);
+        return EFI_UNSUPPORTED;
+    }
+    return EFI_SUCCESS;
+}
+
+static UINT64 llmk_vocab_slots(const LlmkGgufVocabScan *s, int pad_tokens) {
+    return (pad_tokens > 0 && (UINT64)pad_tokens > s->n_tokens) ? (UINT64)pad_tokens : s->n_tokens;
+}
+
+EFI_STATUS llmk_gguf_vocab_bytes(EFI_FILE_HANDLE f, int pad_tokens, UINT64 *out_bytes) {
+    if (!f || !out_bytes) return EFI_INVALID_PARAMETER;
+    *out_bytes = 0;
+    LlmkGgufVocabScan s;
+    EFI_STATUS st = llmk_gguf_scan_vocab(f, &s);
+    if (EFI_ERROR(st)) return st;
+    const UINT64 slots = llmk_vocab_slots(&s, pad_tokens);
+    UINT64 b = 64;
+    b += s.tokens_bytes + 8;                                   // strings + final NUL
+    b += slots * (sizeof(char *) + sizeof(float) + sizeof(INT32));
+    b += s.merges_bytes + 8 + s.n_merges * sizeof(char *);
+    b += llmk_vocab_table_bytes((int)s.n_tokens, (int)s.n_merges);
+    *out_bytes = b;
+    return EFI_SUCCESS;
+}
+
+// Reads a serialized string array into dst and points out[i] at each string,
+// NUL-terminated in place (each terminator overwrites the next length field
+// once that length has been read).
+static EFI_STATUS llmk_read_string_array(EFI_FILE_HANDLE f, UINT64 pos, UINT64 bytes, UINT64 n, char *dst, char **out) {
+    EFI_STATUS st = gguf_seek(f, pos);
+    if (!EFI_ERROR(st)) st = gguf_read_exact(f, dst, (UINTN)bytes);
+    if (EFI_ERROR(st)) return st;
+    UINT64 off = 0;
+    for (UINT64 i = 0; i < n; i++) {
+        UINT64 len = 0;
+        if (bytes - off < 8) return EFI_COMPROMISED_DATA;
+        for (int b = 7; b >= 0; b--) len = (len << 8) | (UINT8)dst[off + (UINT64)b];
+        dst[off] = 0;                                          // ends string i - 1
+        off += 8;
+        if (len > bytes - off) return EFI_COMPROMISED_DATA;
+        out[i] = dst + off;
+        off += len;
+    }
+    dst[off] = 0;
+    return EFI_SUCCESS;
+}
+
+static void *llmk_arena_take(UINT8 **p, UINT8 *end, UINT64 bytes) {
+    UINT8 *q = (UINT8 *)(((UINTN)*p + 7u) & ~(UINTN)7u);
+    if (q > end || (UINT64)(end - q) < bytes) return NULL;
+    *p = q + bytes;
+    return q;
+}
+
+EFI_STATUS llmk_gguf_load_vocab(EFI_FILE_HANDLE f, int pad_tokens, void *arena, UINT64 arena_bytes, LlmkVocab *out) {
+    if (!f || !arena || !out) return EFI_INVALID_PARAMETER;
+    LlmkGgufVocabScan s;
+    EFI_STATUS st = llmk_gguf_scan_vocab(f, &s);
+    if (EFI_ERROR(st)) return st;
+
+    const UINT64 slots = llmk_vocab_slots(&s, pad_tokens);
+    UINT8 *p = (UINT8 *)arena, *end = p + arena_bytes;
+    char *tok_raw = (char *)llmk_arena_take(&p, end, s.tokens_bytes + 1);
+    char **piece = (char **)llmk_arena_take(&p, end, slots * sizeof(char *));
+    float *score = (float *)llmk_arena_take(&p, end, slots * sizeof(float));
+    INT32 *type = (INT32 *)llmk_arena_take(&p, end, slots * sizeof(INT32));
+    char *merge_raw = (char *)llmk_arena_take(&p, end, s.merges_bytes + 1);
+    char **merge = (char **)llmk_arena_take(&p, end, s.n_merges * sizeof(char *) + 8);
+    if (!tok_raw || !piece || !score || !type || !merge_raw || !merge) return EFI_BUFFER_TOO_SMALL;
+
+    for (UINT64 i = 0; i < slots; i++) {
+        piece[i] = NULL;
+        score[i] = 0.0f;
+        type[i] = LLMK_TOKTYPE_NORMAL;
+    }
+    st = llmk_read_string_array(f, s.tokens_pos, s.tokens_bytes, s.n_tokens, tok_raw, piece);
+    if (!EFI_ERROR(st) && s.n_merges) {
+        st = llmk_read_string_array(f, s.merges_pos, s.merges_bytes, s.n_merges, merge_raw, merge);
+    }
+    if (!EFI_ERROR(st) && s.scores_pos) {
+        st = gguf_seek(f, s.scores_pos);
+        if (!EFI_ERROR(st)) st = gguf_read_exact(f, score, (UINTN)(s.n_tokens * sizeof(float)));
+    }
+    if (!EFI_ERROR(st) && s.types_pos) {
+        st = gguf_seek(f, s.types_pos);
+        if (!EFI_ERROR(st)) st = gguf_read_exact(f, type, (UINTN)(s.n_tokens * sizeof(INT32)));
+    }
+    if (EFI_ERROR(st)) return st;
+
+    LlmkVocab v;
+    for (UINTN k = 0; k < sizeof(v); k++) ((UINT8 *)&v)[k] = 0;
+    const int spm = llmk_cstr_eq(s.model, "llama");
+    v.kind = spm ? LLMK_VOCAB_SPM : LLMK_VOCAB_BPE;
+    v.pre = llmk_cstr_eq(s.pre, "qwen2") ? LLMK_VOCAB_PRE_QWEN2
+          : (llmk_cstr_eq(s.pre, "llama-bpe") || llmk_cstr_eq(s.pre, "llama3") || llmk_cstr_eq(s.pre, "smaug-bpe"))
+              ? LLMK_VOCAB_PRE_LLAMA3 : LLMK_VOCAB_PRE_GPT2;
+    v.n_tokens = (int)s.n_tokens;
+    v.piece = piece;
+    v.score = score;
+    v.type = s.types_pos ? type : NULL;
+    v.n_merges = (int)s.n_merges;
+    v.merge = merge;
+    v.bos_id = s.bos;
+    v.eos_id = s.eos;
+    v.eot_id = s.eot;
+    v.unk_id = s.unk;
+    v.add_bos = (s.add_bos >= 0) ? s.add_bos : spm;
+    v.add_space_prefix = (s.add_space_prefix >= 0) ? s.add_space_prefix : spm;
+    UINT8 *tables = (UINT8 *)(((UINTN)p + 7u) & ~(UINTN)7u);
+    v.table_mem = tables;
+    v.table_bytes = (tables < end) ? (UINT64)(end - tables) : 0;
+    *out = v;
+    return EFI_SUCCESS;
+}
+
 EFI_STATUS llmk_gguf_build_plan(
     EFI_FILE_HANDLE f,
     LlmkGgufPlan **out_plan,
@@ -1215,6 +1754,25 @@ EFI_STATUS llmk_gguf_build_plan(
     UINT64 n_kv_heads = 0;
     UINT64 vocab = 0;
     UINT64 ctx = 0;
+    UINT64 key_length = 0;
+    UINT64 alignment = 32;  // general.alignment (GGUF default)
+
+    // Architecture: llama until general.architecture says otherwise
+    const LlmkArchDesc *desc = &k_llmk_arch_desc[0];
+    char arch_name[16] = "llama";
+    double norm_eps = 0.0;
+    UINT64 sliding_window = 0;
+
+    // RoPE: llama2.c defaults (NORM layout, base 10000, full head, no scaling)
+    LlmkRopeParams rope;
+    rope.layout = LLMK_ROPE_NORM;
+    rope.n_rot = 0;
+    rope.freq_base = 10000.0f;
+    rope.scaling = LLMK_ROPE_SCALING_NONE;
+    rope.factor = 1.0f;
+    rope.orig_ctx = 0;
+    rope.yarn_beta_fast = 32.0f;
+    rope.yarn_beta_slow = 1.0f;
 
     int debug_prints_left = 12;
 
@@ -1261,23 +1819,76 @@ EFI_STATUS llmk_gguf_build_plan(
         if (EFI_ERROR(st)) return st;
         gguf_kv_type vt = (gguf_kv_type)vt_u32;
 
+        const char *rope_suffix = llmk_rope_key_suffix(key_buf, keep);
+        if (rope_suffix) {
+            st = gguf_read_rope_kv(f, vt, rope_suffix, &rope);
+            if (EFI_ERROR(st)) return st;
+            continue;
+        }
+        if (llmk_key_eq(key_buf, keep, "general.architecture")) {
+            char arch[32];
+            st = gguf_read_kv_short_string(f, vt, arch, sizeof(arch));
+            if (EFI_ERROR(st) && st != EFI_UNSUPPORTED) return st;
+            const LlmkArchDesc *d = llmk_arch_find(arch);
+            desc = d ? d : &k_llmk_arch_desc[0];
+            rope.layout = (d ? d->rope_neox : llmk_arch_rope_neox(arch)) ? LLMK_ROPE_NEOX : LLMK_ROPE_NORM;
+            UINTN k = 0;
+            for (; arch[k] && k + 1 < sizeof(arch_name); k++) arch_name[k] = arch[k];
+            arch_name[k] = 0;
+            if (!d) {
+                CHAR16 msg[160];
+                SPrint(msg, sizeof(msg), L"GGUF: architecture '%a' not in the table; running it as llama\r\n", arch_name);
+                llmk_dbg_print_both(msg);
+            }
+            continue;
+        }
+
+        if (llmk_key_eq(key_buf, keep, "general.alignment")) {
+            double v = 0.0;
+            st = gguf_read_kv_number(f, vt, &v);
+            if (st == EFI_UNSUPPORTED) continue;
+            if (EFI_ERROR(st)) return st;
+            if (v >= 1.0 && v <= 65536.0) alignment = (UINT64)v;
+            continue;
+        }
+
+        const char *hp = llmk_arch_key_suffix(key_buf, keep);
+        int is_eps = hp && llmk_cstr_eq(hp, "attention.layer_norm_rms_epsilon");
+        int is_window = hp && llmk_cstr_eq(hp, "attention.sliding_window");
+        if (is_eps || is_window || (hp && llmk_cstr_eq(hp, "attention.key_length"))) {
+            double v = 0.0;
+            st = gguf_read_kv_number(f, vt, &v);
+            if (st == EFI_UNSUPPORTED) continue;
+            if (EFI_ERROR(st)) return st;
+            if (is_eps) {
+                if (v > 0.0 && v < 1.0) norm_eps = v;
+            } else if (is_window) {
+                if (v > 0.0 && v < 16777216.0) sliding_window = (UINT64)v;
+            } else if (v > 0.0 && v < 65536.0) {
+                key_length = (UINT64)v;
+            }
+            continue;
+        }
+
         // Helper to read u32/u64 into UINT64
         UINT64 tmp64 = 0;
         int matched = 0;
 
-        if (llmk_key_eq(key_buf, keep, "llama.embedding_length")) {
+        if (!hp) {
+            matched = 0;
+        } else if (llmk_cstr_eq(hp, "embedding_length")) {
             matched = 1;
-        } else if (llmk_key_eq(key_buf, keep, "llama.feed_forward_length")) {
+        } else if (llmk_cstr_eq(hp, "feed_forward_length")) {
             matched = 2;
-        } else if (llmk_key_eq(key_buf, keep, "llama.block_count")) {
+        } else if (llmk_cstr_eq(hp, "block_count")) {
             matched = 3;
-        } else if (llmk_key_eq(key_buf, keep, "llama.attention.head_count")) {
+        } else if (llmk_cstr_eq(hp, "attention.head_count")) {
             matched = 4;
-        } else if (llmk_key_eq(key_buf, keep, "llama.attention.head_count_kv")) {
+        } else if (llmk_cstr_eq(hp, "attention.head_count_kv")) {
             matched = 5;
-        } else if (llmk_key_eq(key_buf, keep, "llama.vocab_size")) {
+        } else if (llmk_cstr_eq(hp, "vocab_size")) {
             matched = 6;
-        } else if (llmk_key_eq(key_buf, keep, "llama.context_length")) {
+        } else if (llmk_cstr_eq(hp, "context_length")) {
             matched = 7;
         }
 
@@ -1344,6 +1955,15 @@ EFI_STATUS llmk_gguf_build_plan(
         llmk_dbg_print_both(msg);
         return EFI_COMPROMISED_DATA;
     }
+    if ((dim % n_heads) != 0 || (n_heads % n_kv_heads) != 0) return EFI_UNSUPPORTED;
+    if (key_length != 0 && key_length != dim / n_heads) {
+        // e.g. gemma-7b (head_dim 256 with dim 3072 / 16 heads): Q/K/V are wider than dim
+        CHAR16 msg[200];
+        SPrint(msg, sizeof(msg), L"GGUF: head_dim=%lu != dim/n_heads=%lu is not supported\r\n", key_length, dim / n_heads);
+        llmk_dbg_print_both(msg);
+        return EFI_UNSUPPORTED;
+    }
+    UINT64 kv_dim = dim * n_kv_heads / n_heads;
 
     // Allocate plan
     LlmkGgufPlan *plan = NULL;
@@ -1351,6 +1971,16 @@ EFI_STATUS llmk_gguf_build_plan(
     if (EFI_ERROR(st) || !plan) return EFI_OUT_OF_RESOURCES;
     llmk_zero_plan(plan);
     plan->version = version;
+    plan->rope = rope;
+    plan->dim = (int)dim;
+    plan->kv_dim = (int)kv_dim;
+    for (UINTN k = 0; k < sizeof(plan->arch.name); k++) plan->arch.name[k] = arch_name[k];
+    plan->arch.act = desc->act;
+    plan->arch.norm_eps = (norm_eps > 0.0) ? (float)norm_eps : desc->norm_eps;
+    plan->arch.embed_scale = desc->embed_sqrt_dim ? llmk_sqrt_f32((float)dim) : 1.0f;
+    plan->arch.qkv_bias = desc->qkv_bias;
+    plan->arch.window_policy = desc->window_policy;
+    plan->arch.sliding_window = (desc->window_policy != LLMK_ARCH_WINDOW_NONE) ? (int)sliding_window : 0;
     plan->tensor_count = n_tensors;
     plan->kv_count = n_kv;
 
@@ -1498,7 +2128,29 @@ EFI_STATUS llmk_gguf_build_plan(
                     case ROLE_FFN_NORM: plan->ffn_norm[layer] = tr; break;
                     case ROLE_FFN_GATE: plan->ffn_gate[layer] = tr; break;
                     case ROLE_FFN_DOWN: plan->ffn_down[layer] = tr; break;
-                    case ROLE_FFN_UP: plan->ffn_up[layer] = tr; break;
+                    case ROLE_FFN_UP:
+                        if (desc->fused_gate_up && tr.n_dims == 2 && tr.dims[1] == 2 * hidden) {
+                            llmk_tensor_slice(&tr, 0, hidden, &plan->ffn_gate[layer]);
+                            llmk_tensor_slice(&tr, hidden, hidden, &plan->ffn_up[layer]);
+                        } else {
+                            plan->ffn_up[layer] = tr;
+                        }
+                        break;
+                    case ROLE_WQKV:
+                        if (desc->fused_qkv) {
+                            llmk_tensor_slice(&tr, 0, dim, &plan->wq[layer]);
+                            llmk_tensor_slice(&tr, dim, kv_dim, &plan->wk[layer]);
+                            llmk_tensor_slice(&tr, dim + kv_dim, kv_dim, &plan->wv[layer]);
+                        }
+                        break;
+                    case ROLE_BQ: plan->bq[layer] = tr; break;
+                    case ROLE_BK: plan->bk[layer] = tr; break;
+                    case ROLE_BV: plan->bv[layer] = tr; break;
+                    case ROLE_BQKV:
+                        llmk_tensor_slice(&tr, 0, dim, &plan->bq[layer]);
+                        llmk_tensor_slice(&tr, dim, kv_dim, &plan->bk[layer]);
+                        llmk_tensor_slice(&tr, dim + kv_dim, kv_dim, &plan->bv[layer]);
+                        break;
                     default: break;
                 }
             }
@@ -1510,14 +2162,14 @@ EFI_STATUS llmk_gguf_build_plan(
         return EFI_UNSUPPORTED;
     }
 
-    // Record data section start
+    // Record data section start (padded to general.alignment after the tensor table)
     UINT64 data_start = 0;
     st = gguf_get_pos(f, &data_start);
     if (EFI_ERROR(st)) {
         llmk_gguf_free_plan(plan);
         return st;
     }
-    plan->data_start = data_start;
+    plan->data_start = llmk_align_up_u64(data_start, alignment);
     plan->max_src_cols = max_cols;
     plan->max_row_raw_bytes = max_raw_row;
 
@@ -1547,6 +2199,10 @@ EFI_STATUS llmk_gguf_build_plan(
             llmk_gguf_free_plan(plan);
             return EFI_NOT_FOUND;
         }
+        if (plan->arch.qkv_bias && (!plan->bq[l].present || !plan->bk[l].present || !plan->bv[l].present)) {
+            llmk_gguf_free_plan(plan);
+            return EFI_NOT_FOUND;
+        }
     }
 
     *out_dim = (int)dim;
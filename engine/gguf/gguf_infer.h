@@ -4,15 +4,19 @@
 #include <efilib.h>
 #include <stdint.h>
 
+#include "llmk_rope.h"
+#include "llmk_arch.h"
+#include "llmk_vocab.h"
+
 // Minimal GGUF inference loader.
 //
 // Two modes:
 //  1) Float32 layout: dequantizes GGUF tensors into the existing llama2.c contiguous float layout.
 //  2) Q8_0 blob: loads GGUF Q8_0 tensors without dequantizing, for true RAM savings.
 //
-// NOTE: This does NOT implement GGUF tokenizer support. It assumes a matching
-// `tokenizer.bin` is present on the boot volume and that its vocab size matches
-// the GGUF metadata `llama.vocab_size`.
+// The tokenizer comes from the file's tokenizer.ggml.* metadata
+// (llmk_gguf_load_vocab); a separate `tokenizer.bin` is only needed for GGUF
+// files without one.
 
 typedef struct LlmkGgufPlan LlmkGgufPlan;
 
@@ -84,4 +88,32 @@ EFI_STATUS llmk_gguf_load_into_llama2_q8_0_blob(
     int shared_classifier
 );
 
+// RoPE parameters from <arch>.rope.* metadata (freq_base, dimension_count,
+// scaling.type/factor/original_context_length, legacy scale_linear) and the
+// pair layout implied by general.architecture.
+void llmk_gguf_plan_rope(const LlmkGgufPlan *plan, LlmkRopeParams *out);
+
+// Architecture switches for the forward pass (activation, norm epsilon,
+// embedding scale, QKV bias, sliding window), resolved from
+// general.architecture and <arch>.attention.* metadata. Fused tensors
+// (phi3 attn_qkv, gate|up) are already split into the plan's q/k/v and
+// gate/up slots by llmk_gguf_build_plan.
+void llmk_gguf_plan_arch(const LlmkGgufPlan *plan, LlmkArch *out);
+
+// QKV biases live outside the llama2.c layout: floats needed (0 when the
+// architecture has none) and the loader, which writes
+// bq [n_layers][dim] | bk [n_layers][kv_dim] | bv [n_layers][kv_dim].
+UINT64 llmk_gguf_plan_bias_floats(const LlmkGgufPlan *plan);
+EFI_STATUS llmk_gguf_load_qkv_bias(EFI_FILE_HANDLE f, const LlmkGgufPlan *plan, float *dst, UINT64 n_floats);
+
+// Embedded tokenizer. llmk_gguf_vocab_bytes sizes the arena for the
+// tokenizer.ggml.* arrays plus the index tables; llmk_gguf_load_vocab reads
+// them into it and fills out, ready for llmk_vocab_build. pad_tokens extends
+// the piece/score arrays (NULL / 0) to the model's vocab_size when the
+// embedding has more rows than the vocabulary. EFI_NOT_FOUND when the file
+// has no tokenizer, EFI_UNSUPPORTED for models other than "llama" (SPM) and
+// "gpt2" (byte-level BPE).
+EFI_STATUS llmk_gguf_vocab_bytes(EFI_FILE_HANDLE f, int pad_tokens, UINT64 *out_bytes);
+EFI_STATUS llmk_gguf_load_vocab(EFI_FILE_HANDLE f, int pad_tokens, void *arena, UINT64 arena_bytes, LlmkVocab *out);
+
 void llmk_gguf_free_plan(LlmkGgufPlan *plan);
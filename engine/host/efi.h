@@ -0,0 +1,68 @@
+/* efi.h — gnu-efi stand-in for the host (Linux) build of the engine
+ *
+ * engine/host/Makefile puts this directory first on the include path, so the
+ * engine sources that start with #include <efi.h> / <efilib.h> (djiblas,
+ * djibmark, gguf_infer, attention_avx2) compile unmodified on Linux.
+ *
+ * Types and status codes come from efi_compat.h; this header adds what those
+ * sources call at runtime: Print/SPrint (llmk_host_rt.c renders the gnu-efi
+ * format set to stderr), uefi_call_wrapper as a plain call, and a BS whose
+ * AllocatePool/FreePool are backed by malloc/free.
+ */
+#ifndef LLMK_HOST_EFI_H
+#define LLMK_HOST_EFI_H
+
+#ifndef LLMK_HOST_BUILD
+#define LLMK_HOST_BUILD 1
+#endif
+
+#define Print llmk_host_print
+#include "../ssm/efi_compat.h"
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#ifndef IN
+#define IN
+#define OUT
+#define OPTIONAL
+#endif
+
+#ifndef EFIAPI
+#define EFIAPI
+#endif
+
+typedef void VOID;
+
+/* Status codes used by the engine beyond efi_compat.h's set */
+#ifndef EFI_LOAD_ERROR
+#define EFI_LOAD_ERROR           (0x8000000000000000ULL | 1ULL)
+#define EFI_UNSUPPORTED          (0x8000000000000000ULL | 3ULL)
+#define EFI_BUFFER_TOO_SMALL     (0x8000000000000000ULL | 5ULL)
+#define EFI_DEVICE_ERROR         (0x8000000000000000ULL | 7ULL)
+#define EFI_VOLUME_CORRUPTED     (0x8000000000000000ULL | 10ULL)
+#define EFI_INCOMPATIBLE_VERSION (0x8000000000000000ULL | 25ULL)
+#define EFI_COMPROMISED_DATA     (0x8000000000000000ULL | 33ULL)
+#define EFI_END_OF_FILE          (0x8000000000000000ULL | 31ULL)
+#endif
+
+typedef enum {
+    EfiReservedMemoryType,
+    EfiLoaderCode,
+    EfiLoaderData,
+    EfiBootServicesCode,
+    EfiBootServicesData
+} EFI_MEMORY_TYPE;
+
+/* Protocol members are void* in efi_compat.h; call them with the arguments
+ * as given. n (the gnu-efi argument count) is only checked by the ABI thunk. */
+#define uefi_call_wrapper(fn, n, ...) (((EFI_STATUS (*)())(fn))(__VA_ARGS__))
+
+extern EFI_BOOT_SERVICES *BS;
+
+UINTN llmk_host_print(const CHAR16 *fmt, ...);
+UINTN SPrint(CHAR16 *buf, UINTN size, const CHAR16 *fmt, ...);
+
+#endif /* LLMK_HOST_EFI_H */
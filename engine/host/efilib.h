@@ -0,0 +1,2 @@
+/* efilib.h — see efi.h; everything the engine uses from efilib is there. */
+#include "efi.h"
@@ -0,0 +1,424 @@
+/* llmk_host.c — Host (Linux) inference CLI
+ *
+ * Runs the same forward pass, sampler and tokenizer as the UEFI REPL so
+ * kernels can be profiled with perf, gdb and sanitizers, and bench suites
+ * can be run without QEMU.
+ *
+ *   llmk_host --model stories15M.bin --prompt "Once upon a time"
+ *   llmk_host --model model.gguf --q8-blob              (interactive)
+ *   llmk_host --model m.bin --bench-out b.jsonl < cases.txt
+ *   llmk_host --model m.bin --shortlist-build m.lksl --shortlist-eval 128
+ *   llmk_host --model m.gguf --json-schema person.json --prompt "Describe Ada"
+ *   llmk_host --model m.bin --temp 0 --prompt "$(cat doc.txt)" --spec-eval 4
+ *   llmk_host --model m.bin --mixq-calib calib.txt --mixq-plan m.lkmx --mixq-budget 30% --mixq-pareto
+ *
+ * Without --prompt, stdin is read line by line: plain lines are chat turns,
+ * slash lines are the REPL subset below (same names as soma_repl).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "llmk_host_rt.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Usage: %s --model <file.bin|file.gguf|file.oosi> [options]\n"
+            "  --tokenizer <path>      tokenizer.bin (default: GGUF metadata, else next to the model)\n"
+            "  --prompt <text>         run one turn and exit (otherwise read stdin)\n"
+            "  --chat raw|you|llama2|chatml|alpaca   prompt wrapper (default you)\n"
+            "  --system <text>         system prompt for llama2/chatml/alpaca\n"
+            "  --temp F --min_p F --top_p F --top_k N --repeat F --norepeat N\n"
+            "  --freq F --presence F   frequency / presence penalty over the last 64 tokens\n"
+            "  --max_tokens N          1..%d (default 160)\n"
+            "  --seed N                sampler seed (default 1234567)\n"
+            "  --jitter                mix TSC jitter into the sampler like UEFI\n"
+            "  --q8-blob               keep GGUF Q8_0 weights quantized\n"
+            "  --q8-act 0|1|2          int8 activations (off / all / FFN only)\n"
+            "  --attn auto|sse2|avx2   attention kernel\n"
+            "  --rope-base F           RoPE frequency base (default: model)\n"
+            "  --rope-scaling none|linear|ntk|yarn  --rope-factor F  --rope-orig-ctx N\n"
+            "  --kv-window 0|1         slide past seq_len instead of clearing (default 1)\n"
+            "  --kv-sinks N --kv-discard N   rows kept at the start / evicted per slide\n"
+            "  --stop-you 0|1 --stop-nl 0|1 --stats 0|1\n"
+            "  --bench-out <file>      start bench capture (JSONL rows)\n"
+            "  --shortlist <file.lksl> low-rank classifier shortlist (exact rerank)\n"
+            "  --shortlist-k N         candidates reranked per step (default 256)\n"
+            "  --shortlist-build <out> build a .lksl from the model's classifier\n"
+            "  --shortlist-rank N      rank for --shortlist-build (default 64)\n"
+            "  --shortlist-eval N      report top-1 agreement and tok/s over N greedy tokens\n"
+            "  --grammar <file.gbnf>   constrain output to a GBNF grammar (root rule)\n"
+            "  --json                  constrain output to a JSON object\n"
+            "  --json-schema <file>    constrain output to a JSON schema (subset)\n"
+            "  --spec K                draft K tokens from the context per step (0..8, default 0)\n"
+            "  --spec-eval K           decode --prompt raw without/with drafts: acceptance, tok/s\n"
+            "  --mixq <file.lkmx>      per-matrix formats (f32/f16/q8_0/q4_0) over the model\n"
+            "  --mixq-plan <out>       calibrate and write a .lkmx plan (needs f32 weights)\n"
+            "  --mixq-calib <file.txt> calibration text for --mixq-plan\n"
+            "  --mixq-budget S         matrix bytes: <MiB> or <pct>%% of f32 (default all-q8_0 size)\n"
+            "  --mixq-tokens N         calibration tokens (default 64)\n"
+            "  --mixq-pareto           also print size vs perplexity over a ladder of budgets, then exit\n",
+            argv0, LLMK_HOST_MAX_TOKENS);
+}
+
+static const char *next_word(const char *s, char *out, int cap) {
+    int n = 0;
+    while (*s == ' ' || *s == '\t') s++;
+    while (*s && *s != ' ' && *s != '\t') {
+        if (n + 1 < cap) out[n++] = *s;
+        s++;
+    }
+    out[n] = 0;
+    while (*s == ' ' || *s == '\t') s++;
+    return s;
+}
+
+static int parse_chat(const char *s) {
+    if (!strcmp(s, "raw")) return LLMK_HOST_CHAT_RAW;
+    if (!strcmp(s, "you")) return LLMK_HOST_CHAT_YOU_AI;
+    if (!strcmp(s, "llama2")) return LLMK_HOST_CHAT_LLAMA2;
+    if (!strcmp(s, "chatml")) return LLMK_HOST_CHAT_CHATML;
+    if (!strcmp(s, "alpaca")) return LLMK_HOST_CHAT_ALPACA;
+    return -1;
+}
+
+static int clamp_i(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void print_sampling(const LlmkHostGen *g) {
+    fprintf(stderr, "[sampling] temp=%.3f min_p=%.3f top_p=%.3f top_k=%d repeat=%.3f freq=%.3f presence=%.3f "
+            "norepeat=%d max_tokens=%d\n",
+            g->temperature, g->min_p, g->top_p, g->top_k, g->repeat_penalty, g->freq_penalty,
+            g->presence_penalty, g->no_repeat_ngram, g->max_gen_tokens);
+}
+
+/* Returns 1 to quit. */
+static int run_command(const char *line, LlmkHostGen *g) {
+    char cmd[32], arg[64];
+    const char *rest = next_word(line, cmd, (int)sizeof(cmd));
+
+    if (!strcmp(cmd, "/quit") || !strcmp(cmd, "/exit")) return 1;
+    if (!strcmp(cmd, "/reset")) {
+        llmk_host_reset();
+        fprintf(stderr, "[reset] KV cache cleared\n");
+    } else if (!strcmp(cmd, "/temp")) {
+        g->temperature = (float)atof(rest);
+    } else if (!strcmp(cmd, "/min_p")) {
+        g->min_p = (float)atof(rest);
+    } else if (!strcmp(cmd, "/top_p")) {
+        g->top_p = (float)atof(rest);
+    } else if (!strcmp(cmd, "/top_k")) {
+        g->top_k = clamp_i(atoi(rest), 0, 256);
+    } else if (!strcmp(cmd, "/repeat")) {
+        g->repeat_penalty = (float)atof(rest);
+    } else if (!strcmp(cmd, "/freq")) {
+        g->freq_penalty = (float)atof(rest);
+    } else if (!strcmp(cmd, "/presence")) {
+        g->presence_penalty = (float)atof(rest);
+    } else if (!strcmp(cmd, "/norepeat")) {
+        g->no_repeat_ngram = clamp_i(atoi(rest), 0, 16);
+    } else if (!strcmp(cmd, "/max_tokens")) {
+        g->max_gen_tokens = clamp_i(atoi(rest), 1, LLMK_HOST_MAX_TOKENS);
+    } else if (!strcmp(cmd, "/seed")) {
+        llmk_host_set_seed((unsigned int)strtoul(rest, NULL, 0), 0);
+    } else if (!strcmp(cmd, "/stats")) {
+        g->stats = atoi(rest) ? 1 : 0;
+    } else if (!strcmp(cmd, "/stop_you")) {
+        g->stop_on_you = atoi(rest) ? 1 : 0;
+    } else if (!strcmp(cmd, "/stop_nl")) {
+        g->stop_on_double_nl = atoi(rest) ? 1 : 0;
+    } else if (!strcmp(cmd, "/sampling")) {
+        print_sampling(g);
+    } else if (!strcmp(cmd, "/metrics")) {
+        llmk_host_print_metrics();
+    } else if (!strcmp(cmd, "/shortlist")) {
+        rest = next_word(rest, arg, (int)sizeof(arg));
+        if (!strcmp(arg, "load")) {
+            next_word(rest, arg, (int)sizeof(arg));
+            llmk_host_shortlist_load(arg[0] ? arg : "classifier.lksl", 0);
+        } else if (!strcmp(arg, "on") || !strcmp(arg, "off")) {
+            llmk_host_shortlist_enable(arg[1] == 'n');
+        } else if (!strcmp(arg, "k")) {
+            llmk_host_shortlist_set_k(atoi(rest));
+        } else if (arg[0]) {
+            fprintf(stderr, "Usage: /shortlist [load [file]|on|off|k <n>]\n");
+            return 0;
+        }
+        llmk_host_shortlist_print();
+    } else if (!strcmp(cmd, "/mixq")) {
+        rest = next_word(rest, arg, (int)sizeof(arg));
+        if (!strcmp(arg, "load")) {
+            next_word(rest, arg, (int)sizeof(arg));
+            llmk_host_mixq_load(arg[0] ? arg : "model.lkmx");
+        } else if (!strcmp(arg, "on") || !strcmp(arg, "off")) {
+            llmk_host_mixq_enable(arg[1] == 'n');
+        } else if (arg[0]) {
+            fprintf(stderr, "Usage: /mixq [load [file]|on|off]\n");
+            return 0;
+        }
+        llmk_host_mixq_print();
+    } else if (!strcmp(cmd, "/grammar")) {
+        rest = next_word(rest, arg, (int)sizeof(arg));
+        if (!strcmp(arg, "off") || !strcmp(arg, "json")) {
+            llmk_host_set_grammar(arg[0] == 'o' ? LLMK_HOST_GRAMMAR_OFF : LLMK_HOST_GRAMMAR_JSON, NULL);
+        } else if (!strcmp(arg, "load") || !strcmp(arg, "schema")) {
+            int kind = arg[0] == 'l' ? LLMK_HOST_GRAMMAR_GBNF : LLMK_HOST_GRAMMAR_SCHEMA;
+            next_word(rest, arg, (int)sizeof(arg));
+            if (arg[0]) llmk_host_load_grammar(kind, arg);
+        } else if (arg[0]) {
+            fprintf(stderr, "Usage: /grammar [off|json|load <file.gbnf>|schema <file.json>]\n");
+            return 0;
+        }
+        llmk_host_grammar_print();
+    } else if (!strcmp(cmd, "/spec")) {
+        next_word(rest, arg, (int)sizeof(arg));
+        if (arg[0]) llmk_host_set_spec(atoi(arg));
+        llmk_host_spec_print();
+    } else if (!strcmp(cmd, "/bench_begin")) {
+        next_word(rest, arg, (int)sizeof(arg));
+        llmk_host_bench_begin(arg[0] ? arg : NULL);
+    } else if (!strcmp(cmd, "/bench_end")) {
+        llmk_host_bench_end();
+    } else if (!strcmp(cmd, "/bench_case")) {
+        char id[64], cat[32], max_s[16];
+        rest = next_word(rest, id, (int)sizeof(id));
+        rest = next_word(rest, cat, (int)sizeof(cat));
+        rest = next_word(rest, max_s, (int)sizeof(max_s));
+        if (!llmk_host_bench_active()) {
+            fprintf(stderr, "[bench] not active (use /bench_begin)\n");
+        } else if (!id[0] || !cat[0] || !max_s[0] || !rest[0]) {
+            fprintf(stderr, "Usage: /bench_case <id> <cat> <max_new_tokens> <prompt...>\n");
+        } else {
+            LlmkHostGen bg = *g;
+            bg.max_gen_tokens = clamp_i(atoi(max_s), 1, LLMK_HOST_MAX_TOKENS);
+            llmk_host_reset();
+            llmk_host_bench_case(id, cat, bg.max_gen_tokens);
+            llmk_host_generate(rest, &bg, NULL);
+        }
+    } else {
+        fprintf(stderr, "Unknown command: %s\n", cmd);
+    }
+    return 0;
+}
+
+/* Whole file as a NUL-terminated string (free()), NULL on error */
+static char *read_text(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    char *buf = NULL;
+    long n = (fseek(f, 0, SEEK_END) == 0) ? ftell(f) : -1;
+    if (n >= 0 && fseek(f, 0, SEEK_SET) == 0 && (buf = (char *)malloc((size_t)n + 1)) != NULL) {
+        if (fread(buf, 1, (size_t)n, f) != (size_t)n) {
+            free(buf);
+            buf = NULL;
+        } else {
+            buf[n] = 0;
+        }
+    }
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    const char *model = NULL, *tok = NULL, *prompt = NULL, *bench_out = NULL;
+    const char *sl_path = NULL, *sl_build = NULL;
+    const char *grammar_path = NULL;
+    int grammar_kind = LLMK_HOST_GRAMMAR_OFF;
+    int q8_blob = 0, sl_k = 0, sl_rank = 64, sl_eval = 0;
+    int spec_k = 0, spec_eval = 0;
+    const char *mx_path = NULL, *mx_plan = NULL, *mx_calib = NULL, *mx_budget = NULL;
+    int mx_tokens = 0, mx_pareto = 0;
+    const char *rope_scaling = NULL;
+    float rope_base = 0.0f, rope_factor = 0.0f;
+    int rope_orig_ctx = 0;
+    int kv_window = 1, kv_sinks = -1, kv_discard = 0;
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int takes = 1;
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) {
+            usage(argv[0]);
+            return 0;
+        } else if (!strcmp(a, "--q8-blob")) {
+            q8_blob = 1;
+            takes = 0;
+        } else if (!strcmp(a, "--jitter")) {
+            llmk_host_set_seed(1234567u, 1);
+            takes = 0;
+        } else if (!strcmp(a, "--json")) {
+            grammar_kind = LLMK_HOST_GRAMMAR_JSON;
+            takes = 0;
+        } else if (!strcmp(a, "--mixq-pareto")) {
+            mx_pareto = 1;
+            takes = 0;
+        } else if (!v) {
+            fprintf(stderr, "ERROR: %s needs a value\n", a);
+            return 2;
+        } else if (!strcmp(a, "--model")) {
+            model = v;
+        } else if (!strcmp(a, "--tokenizer")) {
+            tok = v;
+        } else if (!strcmp(a, "--prompt")) {
+            prompt = v;
+        } else if (!strcmp(a, "--system")) {
+            llmk_host_set_system_prompt(v);
+        } else if (!strcmp(a, "--chat")) {
+            int c = parse_chat(v);
+            if (c < 0) {
+                fprintf(stderr, "ERROR: unknown chat format %s\n", v);
+                return 2;
+            }
+            g.chat_format = c;
+        } else if (!strcmp(a, "--temp")) {
+            g.temperature = (float)atof(v);
+        } else if (!strcmp(a, "--min_p")) {
+            g.min_p = (float)atof(v);
+        } else if (!strcmp(a, "--top_p")) {
+            g.top_p = (float)atof(v);
+        } else if (!strcmp(a, "--top_k")) {
+            g.top_k = clamp_i(atoi(v), 0, 256);
+        } else if (!strcmp(a, "--repeat")) {
+            g.repeat_penalty = (float)atof(v);
+        } else if (!strcmp(a, "--freq")) {
+            g.freq_penalty = (float)atof(v);
+        } else if (!strcmp(a, "--presence")) {
+            g.presence_penalty = (float)atof(v);
+        } else if (!strcmp(a, "--norepeat")) {
+            g.no_repeat_ngram = clamp_i(atoi(v), 0, 16);
+        } else if (!strcmp(a, "--max_tokens")) {
+            g.max_gen_tokens = clamp_i(atoi(v), 1, LLMK_HOST_MAX_TOKENS);
+        } else if (!strcmp(a, "--seed")) {
+            llmk_host_set_seed((unsigned int)strtoul(v, NULL, 0), 0);
+        } else if (!strcmp(a, "--q8-act")) {
+            llmk_host_set_q8_act(atoi(v));
+        } else if (!strcmp(a, "--attn")) {
+            llmk_host_set_attn(!strcmp(v, "sse2") ? 0 : (!strcmp(v, "avx2") ? 1 : -1));
+        } else if (!strcmp(a, "--rope-base")) {
+            rope_base = (float)atof(v);
+        } else if (!strcmp(a, "--rope-scaling")) {
+            rope_scaling = v;
+        } else if (!strcmp(a, "--rope-factor")) {
+            rope_factor = (float)atof(v);
+        } else if (!strcmp(a, "--rope-orig-ctx")) {
+            rope_orig_ctx = atoi(v);
+        } else if (!strcmp(a, "--kv-window")) {
+            kv_window = atoi(v) ? 1 : 0;
+        } else if (!strcmp(a, "--kv-sinks")) {
+            kv_sinks = atoi(v);
+        } else if (!strcmp(a, "--kv-discard")) {
+            kv_discard = atoi(v);
+        } else if (!strcmp(a, "--stop-you")) {
+            g.stop_on_you = atoi(v) ? 1 : 0;
+        } else if (!strcmp(a, "--stop-nl")) {
+            g.stop_on_double_nl = atoi(v) ? 1 : 0;
+        } else if (!strcmp(a, "--stats")) {
+            g.stats = atoi(v) ? 1 : 0;
+        } else if (!strcmp(a, "--bench-out")) {
+            bench_out = v;
+        } else if (!strcmp(a, "--shortlist")) {
+            sl_path = v;
+        } else if (!strcmp(a, "--shortlist-k")) {
+            sl_k = atoi(v);
+        } else if (!strcmp(a, "--shortlist-build")) {
+            sl_build = v;
+        } else if (!strcmp(a, "--shortlist-rank")) {
+            sl_rank = atoi(v);
+        } else if (!strcmp(a, "--shortlist-eval")) {
+            sl_eval = atoi(v);
+        } else if (!strcmp(a, "--spec")) {
+            spec_k = atoi(v);
+        } else if (!strcmp(a, "--spec-eval")) {
+            spec_eval = atoi(v);
+        } else if (!strcmp(a, "--mixq")) {
+            mx_path = v;
+        } else if (!strcmp(a, "--mixq-plan")) {
+            mx_plan = v;
+        } else if (!strcmp(a, "--mixq-calib")) {
+            mx_calib = v;
+        } else if (!strcmp(a, "--mixq-budget")) {
+            mx_budget = v;
+        } else if (!strcmp(a, "--mixq-tokens")) {
+            mx_tokens = atoi(v);
+        } else if (!strcmp(a, "--grammar")) {
+            grammar_kind = LLMK_HOST_GRAMMAR_GBNF;
+            grammar_path = v;
+        } else if (!strcmp(a, "--json-schema")) {
+            grammar_kind = LLMK_HOST_GRAMMAR_SCHEMA;
+            grammar_path = v;
+        } else {
+            fprintf(stderr, "ERROR: unknown option %s\n", a);
+            usage(argv[0]);
+            return 2;
+        }
+        i += takes;
+    }
+    if (!model) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (llmk_host_set_rope(rope_base, rope_scaling, rope_factor, rope_orig_ctx) != 0) {
+        fprintf(stderr, "ERROR: unknown RoPE scaling %s\n", rope_scaling);
+        return 2;
+    }
+    llmk_host_set_kv_window(kv_window, kv_sinks, kv_discard);
+    if (llmk_host_load(model, tok, q8_blob) != 0) return 1;
+    llmk_host_describe();
+    if (sl_build && llmk_host_shortlist_build(sl_build, sl_rank, 4) != 0) return 1;
+    if (sl_path && llmk_host_shortlist_load(sl_path, sl_k) != 0) return 1;
+    if (sl_k > 0) llmk_host_shortlist_set_k(sl_k);
+    if (sl_eval > 0) {
+        int rc = llmk_host_shortlist_eval(prompt ? prompt : "Once upon a time", sl_eval, NULL);
+        llmk_host_unload();
+        return rc == 0 ? 0 : 1;
+    }
+    if (mx_plan || mx_pareto) {
+        char *calib = mx_calib ? read_text(mx_calib) : NULL;
+        if (!calib) {
+            fprintf(stderr, "ERROR: --mixq-plan needs a readable --mixq-calib file\n");
+            return 1;
+        }
+        int rc = llmk_host_mixq_plan(mx_plan, calib, mx_tokens, mx_budget, mx_pareto, NULL);
+        free(calib);
+        if (rc != 0 || mx_pareto) {
+            llmk_host_unload();
+            return rc == 0 ? 0 : 1;
+        }
+    }
+    if (mx_path && llmk_host_mixq_load(mx_path) != 0) return 1;
+    if (mx_path || mx_plan) llmk_host_mixq_print();
+    if (grammar_path ? llmk_host_load_grammar(grammar_kind, grammar_path) != 0
+                     : llmk_host_set_grammar(grammar_kind, NULL) != 0) return 1;
+    llmk_host_set_spec(spec_k);
+    if (spec_eval > 0) {
+        int rc = llmk_host_spec_eval(prompt ? prompt : "Once upon a time", &g, spec_eval, NULL);
+        llmk_host_unload();
+        return rc == 0 ? 0 : 1;
+    }
+    if (bench_out && llmk_host_bench_begin(bench_out) != 0) return 1;
+
+    int rc = 0;
+    if (prompt) {
+        rc = llmk_host_generate(prompt, &g, NULL) == 0 ? 0 : 1;
+    } else {
+        char line[1024];
+        while (fgets(line, sizeof(line), stdin)) {
+            size_t n = strlen(line);
+            while (n && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = 0;
+            if (!n) continue;
+            if (line[0] == '/') {
+                if (run_command(line, &g)) break;
+                continue;
+            }
+            llmk_host_generate(line, &g, NULL);
+        }
+    }
+
+    if (llmk_host_bench_active()) llmk_host_bench_end();
+    llmk_host_unload();
+    return rc;
+}
@@ -0,0 +1,2531 @@
+/* llmk_host_rt.c — Host (Linux) runtime around the engine's inference code
+ *
+ * See llmk_host_rt.h. This TU plays the part of soma_inference.c: it defines
+ * the globals the engine fragments expect and then includes them in the same
+ * order (kernels → model layout → forward → sampler → tokenizer).
+ */
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <x86intrin.h>
+
+#include "efi.h"
+#include "djiblas.h"
+#include "djibmark.h"
+#include "gguf_infer.h"
+#include "../self_improve/oo_lora.h"
+#include "../../oo-modules/pheromion-engine/core/pheromion.h"
+#include "../ssm/oosi_v3_infer.h"
+#include "../ssm/bpe_tokenizer.h"
+#include "llmk_host_rt.h"
+
+/* ── Print / SPrint (gnu-efi format set) ─────────────────────────────────── */
+
+typedef struct {
+    void (*put)(void *ctx, CHAR16 c);
+    void *ctx;
+} HostOut;
+
+static const char *host_status_str(EFI_STATUS st) {
+    switch (st) {
+    case EFI_SUCCESS:              return "Success";
+    case EFI_LOAD_ERROR:           return "Load Error";
+    case EFI_INVALID_PARAMETER:    return "Invalid Parameter";
+    case EFI_UNSUPPORTED:          return "Unsupported";
+    case EFI_BAD_BUFFER_SIZE:      return "Bad Buffer Size";
+    case EFI_BUFFER_TOO_SMALL:     return "Buffer Too Small";
+    case EFI_NOT_READY:            return "Not Ready";
+    case EFI_DEVICE_ERROR:         return "Device Error";
+    case EFI_OUT_OF_RESOURCES:     return "Out of Resources";
+    case EFI_VOLUME_CORRUPTED:     return "Volume Corrupt";
+    case EFI_NOT_FOUND:            return "Not Found";
+    case EFI_ABORTED:              return "Aborted";
+    case EFI_END_OF_FILE:          return "End of File";
+    case EFI_INCOMPATIBLE_VERSION: return "Incompatible Version";
+    case EFI_COMPROMISED_DATA:     return "Compromised Data";
+    default:                       return NULL;
+    }
+}
+
+static void host_emit_field(HostOut *o, const char *a, const CHAR16 *w, int len,
+                            int width, int left, char pad) {
+    for (int i = len; !left && i < width; i++) o->put(o->ctx, (CHAR16)pad);
+    for (int i = 0; i < len; i++) o->put(o->ctx, a ? (CHAR16)(unsigned char)a[i] : w[i]);
+    for (int i = len; left && i < width; i++) o->put(o->ctx, ' ');
+}
+
+static void host_vformat(HostOut *o, const CHAR16 *fmt, va_list ap) {
+    char num[40];
+    for (; fmt && *fmt; fmt++) {
+        if (*fmt != '%') { o->put(o->ctx, *fmt); continue; }
+        fmt++;
+        int left = 0, width = 0, is64 = 0;
+        char pad = ' ';
+        if (*fmt == '-') { left = 1; fmt++; }
+        if (*fmt == '0') { pad = '0'; fmt++; }
+        if (*fmt == '*') { width = va_arg(ap, int); fmt++; }
+        while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
+        while (*fmt == 'l') { is64 = 1; fmt++; }
+
+        switch (*fmt) {
+        case 'd': case 'i': {
+            long long v = is64 ? va_arg(ap, long long) : va_arg(ap, int);
+            int n = snprintf(num, sizeof(num), "%lld", v);
+            host_emit_field(o, num, 0, n, width, left, pad);
+            break;
+        }
+        case 'u': {
+            unsigned long long v = is64 ? va_arg(ap, unsigned long long) : va_arg(ap, unsigned);
+            int n = snprintf(num, sizeof(num), "%llu", v);
+            host_emit_field(o, num, 0, n, width, left, pad);
+            break;
+        }
+        case 'x': case 'X': {
+            unsigned long long v = is64 ? va_arg(ap, unsigned long long) : va_arg(ap, unsigned);
+            int n = snprintf(num, sizeof(num), *fmt == 'x' ? "%llx" : "%llX", v);
+            host_emit_field(o, num, 0, n, width, left, pad);
+            break;
+        }
+        case 'p': {
+            int n = snprintf(num, sizeof(num), "%p", va_arg(ap, void *));
+            host_emit_field(o, num, 0, n, width, left, pad);
+            break;
+        }
+        case 'c': {
+            CHAR16 c = (CHAR16)va_arg(ap, int);
+            host_emit_field(o, 0, &c, 1, width, left, ' ');
+            break;
+        }
+        case 's': {
+            const CHAR16 *s = va_arg(ap, const CHAR16 *);
+            static const CHAR16 null_s[] = { '(', 'n', 'u', 'l', 'l', ')', 0 };
+            if (!s) s = null_s;
+            int n = 0;
+            while (s[n]) n++;
+            host_emit_field(o, 0, s, n, width, left, ' ');
+            break;
+        }
+        case 'a': {
+            const char *s = va_arg(ap, const char *);
+            if (!s) s = "(null)";
+            host_emit_field(o, s, 0, (int)strlen(s), width, left, ' ');
+            break;
+        }
+        case 'r': {
+            EFI_STATUS st = va_arg(ap, EFI_STATUS);
+            const char *s = host_status_str(st);
+            int n = s ? snprintf(num, sizeof(num), "%s", s)
+                      : snprintf(num, sizeof(num), "%llx", (unsigned long long)st);
+            host_emit_field(o, num, 0, n, width, left, ' ');
+            break;
+        }
+        case '%':
+            o->put(o->ctx, '%');
+            break;
+        case 0:
+            return;
+        default:                         /* %N %H %E ... attribute codes: ignore */
+            break;
+        }
+    }
+}
+
+/* Print: UCS-2 → UTF-8 on stderr (stdout carries only generated text) */
+typedef struct {
+    char     buf[1024];
+    int      n;
+    unsigned hi;                          /* pending high surrogate */
+} HostU8Out;
+
+static void host_u8_flush(HostU8Out *u) {
+    if (u->n) fwrite(u->buf, 1, (size_t)u->n, stderr);
+    u->n = 0;
+}
+
+static void host_u8_put(void *ctx, CHAR16 c) {
+    HostU8Out *u = (HostU8Out *)ctx;
+    unsigned cp = c;
+    if (c == '\r') return;
+    if (c >= 0xD800 && c <= 0xDBFF) { u->hi = c; return; }
+    if (c >= 0xDC00 && c <= 0xDFFF) {
+        cp = u->hi ? 0x10000u + ((u->hi - 0xD800u) << 10) + (c - 0xDC00u) : 0xFFFDu;
+    }
+    u->hi = 0;
+    if (u->n + 4 > (int)sizeof(u->buf)) host_u8_flush(u);
+    if (cp < 0x80) {
+        u->buf[u->n++] = (char)cp;
+    } else if (cp < 0x800) {
+        u->buf[u->n++] = (char)(0xC0 | (cp >> 6));
+        u->buf[u->n++] = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        u->buf[u->n++] = (char)(0xE0 | (cp >> 12));
+        u->buf[u->n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        u->buf[u->n++] = (char)(0x80 | (cp & 0x3F));
+    } else {
+        u->buf[u->n++] = (char)(0xF0 | (cp >> 18));
+        u->buf[u->n++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        u->buf[u->n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        u->buf[u->n++] = (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+UINTN llmk_host_print(const CHAR16 *fmt, ...) {
+    HostU8Out u;
+    u.n = 0;
+    u.hi = 0;
+    HostOut o = { host_u8_put, &u };
+    fflush(stdout);
+    va_list ap;
+    va_start(ap, fmt);
+    host_vformat(&o, fmt, ap);
+    va_end(ap);
+    host_u8_flush(&u);
+    return 0;
+}
+
+typedef struct {
+    CHAR16 *buf;
+    UINTN   cap;                          /* code units, incl. the NUL */
+    UINTN   n;
+} HostU16Out;
+
+static void host_u16_put(void *ctx, CHAR16 c) {
+    HostU16Out *s = (HostU16Out *)ctx;
+    if (s->n + 1 < s->cap) s->buf[s->n++] = c;
+}
+
+/* size is in bytes, as in gnu-efi */
+UINTN SPrint(CHAR16 *buf, UINTN size, const CHAR16 *fmt, ...) {
+    HostU16Out s = { buf, size / sizeof(CHAR16), 0 };
+    if (!buf || s.cap == 0) return 0;
+    HostOut o = { host_u16_put, &s };
+    va_list ap;
+    va_start(ap, fmt);
+    host_vformat(&o, fmt, ap);
+    va_end(ap);
+    buf[s.n] = 0;
+    return s.n;
+}
+
+/* ── Boot services / file protocol over malloc and mmap ──────────────────── */
+
+static EFI_STATUS host_allocate_pool(EFI_MEMORY_TYPE type, UINTN size, void **out) {
+    (void)type;
+    if (!out) return EFI_INVALID_PARAMETER;
+    *out = malloc(size ? size : 1);
+    return *out ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+}
+
+static EFI_STATUS host_free_pool(void *p) {
+    free(p);
+    return EFI_SUCCESS;
+}
+
+static EFI_BOOT_SERVICES g_host_bs = {
+    .AllocatePool = (void *)host_allocate_pool,
+    .FreePool     = (void *)host_free_pool,
+};
+EFI_BOOT_SERVICES *BS = &g_host_bs;
+
+typedef struct {
+    EFI_FILE_PROTOCOL proto;              /* must stay first */
+    const UINT8      *base;
+    UINT64            size;
+    UINT64            pos;
+} HostFile;
+
+static EFI_STATUS host_file_read(EFI_FILE_HANDLE f, UINTN *size, void *buf) {
+    HostFile *h = (HostFile *)f;
+    if (!h || !size || (!buf && *size)) return EFI_INVALID_PARAMETER;
+    UINT64 left = (h->pos < h->size) ? h->size - h->pos : 0;
+    UINTN n = (*size < left) ? *size : (UINTN)left;
+    if (n) memcpy(buf, h->base + h->pos, n);
+    h->pos += n;
+    *size = n;
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS host_file_get_position(EFI_FILE_HANDLE f, UINT64 *pos) {
+    HostFile *h = (HostFile *)f;
+    if (!h || !pos) return EFI_INVALID_PARAMETER;
+    *pos = h->pos;
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS host_file_set_position(EFI_FILE_HANDLE f, UINT64 pos) {
+    HostFile *h = (HostFile *)f;
+    if (!h) return EFI_INVALID_PARAMETER;
+    h->pos = (pos == 0xFFFFFFFFFFFFFFFFULL) ? h->size : pos;
+    return EFI_SUCCESS;
+}
+
+static void host_file_open_mem(HostFile *h, const void *base, UINT64 size) {
+    memset(h, 0, sizeof(*h));
+    h->proto.Read = (void *)host_file_read;
+    h->proto.GetPosition = (void *)host_file_get_position;
+    h->proto.SetPosition = (void *)host_file_set_position;
+    h->base = (const UINT8 *)base;
+    h->size = size;
+}
+
+typedef struct {
+    void  *base;
+    size_t size;
+} HostMap;
+
+static int host_map_file(HostMap *m, const char *path) {
+    m->base = NULL;
+    m->size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || sb.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;                /* fault the weights in before timing */
+#endif
+    void *p = mmap(NULL, (size_t)sb.st_size, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    m->base = p;
+    m->size = (size_t)sb.st_size;
+    return 0;
+}
+
+static void host_unmap(HostMap *m) {
+    if (m->base) munmap(m->base, m->size);
+    m->base = NULL;
+    m->size = 0;
+}
+
+/* ── Globals the engine fragments expect (soma_loader.c / soma_mind.c) ───── */
+
+#define TOKEN_BOS 1
+#define TOKEN_EOS 2
+
+/* 64-byte aligned and zeroed like the UEFI arena; run state is released by
+ * llmk_host_unload so a process can load several models. */
+void *simple_alloc(unsigned long bytes) {
+    void *p = NULL;
+    if (posix_memalign(&p, 64, bytes ? bytes : 1) != 0) return NULL;
+    memset(p, 0, bytes);
+    return p;
+}
+
+static int my_strcmp(const char *a, const char *b) {
+    return strcmp(a, b);
+}
+
+static int g_cfg_q8_act_quant = 0;
+static int g_attn_use_avx2 = 0;
+static int g_attn_force = -1;
+
+float llmk_dot_f32_avx2(const float *a, const float *b, int n);
+void  llmk_axpy_f32_avx2(float *dst, const float *src, float a, int n);
+void  llmk_kv_prefetch_range(const float *base, int stride, int row_len, int row_count);
+
+typedef struct {
+    UINT64 session_start_cycles;
+    UINT64 total_prefill_cycles;
+    UINT64 total_decode_cycles;
+    UINT32 total_prefill_tokens;
+    UINT32 total_decode_tokens;
+    UINT32 total_prefill_calls;
+    UINT32 total_decode_calls;
+    UINT64 last_prefill_cycles;
+    UINT64 last_decode_cycles;
+    UINT32 last_prefill_tokens;
+    UINT32 last_decode_tokens;
+    UINT32 sentinel_violations_total;
+    UINT32 kv_cache_resets;
+    UINT32 generation_count;
+} LlmkRuntimeMetrics;
+
+static LlmkRuntimeMetrics g_metrics = {0};
+static PheromionEngine g_pheromion;
+DjibMarkState g_djibmark_state;
+
+/* The sampler mixes one RDTSC byte into its LCG every 8 draws on UEFI.
+ * Off by default here so a seeded run is reproducible under perf. */
+static unsigned int g_sample_seed = 1234567;
+static int g_host_jitter = 0;
+
+static inline unsigned int oo_quantum_mix(unsigned int lcg_seed) {
+    return g_host_jitter ? (lcg_seed ^ ((unsigned int)__rdtsc() & 0xFFU)) : lcg_seed;
+}
+
+/* oo_lora.c persistence goes to NVMe on UEFI; the host has none */
+int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes) {
+    (void)lba; (void)buf; (void)bytes;
+    return -1;
+}
+
+int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes) {
+    (void)lba; (void)buf; (void)bytes;
+    return -1;
+}
+
+/* OIT global adapter hook of oosi_v3_forward_one (oo-kernel archive on UEFI) */
+void oit_lora_apply_global(float *vec, int dim) {
+    (void)vec; (void)dim;
+}
+
+#include "../llama2/llmk_kernels.c"
+#include "../llama2/llmk_model.h"
+
+/* LoRA hooks: no adapter bank on the host. g_host_lora (NULL by default)
+ * is the active adapter; tests that unity-include this file set it. */
+static const oo_lora_state_t *g_host_lora;
+
+static const oo_lora_state_t *llmk_lora_fused_state(int l) {
+    const oo_lora_state_t *st = g_host_lora;
+    if (!st || st->merged || (UINT32)l >= st->n_layers) return NULL;
+    return st;
+}
+
+static const oo_lora_state_t *llmk_lora_active_state(int l) {
+    const oo_lora_state_t *st = g_host_lora;
+    if (!st || (UINT32)l >= st->n_layers) return NULL;
+    return st;
+}
+
+/* soma_inference.c llmk_lora_model */
+static void llmk_lora_model(const TransformerWeights *w, const Config *p, oo_lora_model_t *m) {
+    int dim = p->dim;
+    int kv_dim = (p->dim * p->n_kv_heads) / p->n_heads;
+    int hd = p->hidden_dim;
+    const int in[OO_LORA_NPROJ]  = { dim, dim, dim, dim, dim, hd, dim };
+    const int out[OO_LORA_NPROJ] = { dim, kv_dim, kv_dim, dim, hd, dim, hd };
+    memset(m, 0, sizeof(*m));
+    m->n_layers = (UINT32)p->n_layers;
+    for (int i = 0; i < OO_LORA_NPROJ; i++) {
+        m->w[i].in_dim = (UINT32)in[i];
+        m->w[i].out_dim = (UINT32)out[i];
+        m->w[i].kind = (w->kind == 1) ? OO_LORA_W_Q8_0 : OO_LORA_W_F32;
+    }
+    if (w->kind == 1) {
+        const UINT8 *b[OO_LORA_NPROJ] = { w->wq_q8, w->wk_q8, w->wv_q8, w->wo_q8, w->w1_q8, w->w2_q8, w->w3_q8 };
+        const UINT64 lb[OO_LORA_NPROJ] = { w->wq_layer_bytes, w->wk_layer_bytes, w->wv_layer_bytes, w->wo_layer_bytes,
+                                           w->w1_layer_bytes, w->w2_layer_bytes, w->w3_layer_bytes };
+        for (int i = 0; i < OO_LORA_NPROJ; i++) {
+            m->w[i].base = (UINT8 *)b[i];
+            m->w[i].layer_bytes = lb[i];
+        }
+    } else {
+        const float *b[OO_LORA_NPROJ] = { w->wq, w->wk, w->wv, w->wo, w->w1, w->w2, w->w3 };
+        for (int i = 0; i < OO_LORA_NPROJ; i++) {
+            m->w[i].base = (UINT8 *)b[i];
+            m->w[i].layer_bytes = (UINT64)in[i] * (UINT64)out[i] * sizeof(float);
+        }
+    }
+}
+
+static void llmk_lora_matmul(float *xout, const float *x, const oo_lora_model_t *m,
+                             const oo_lora_state_t *st, int proj, int l) {
+    const oo_lora_weight_t *wd = &m->w[proj];
+    const UINT8 *base = wd->base + (UINTN)l * (UINTN)wd->layer_bytes;
+    const oo_lora_adapter_t *a = &st->layers[l][proj];
+    if (wd->kind == OO_LORA_W_Q8_0) {
+        oo_lora_matmul_q8_0(xout, x, base, wd->in_dim, wd->out_dim, a);
+    } else {
+        oo_lora_matmul_f32(xout, x, (const float *)base, wd->in_dim, wd->out_dim, a);
+    }
+}
+
+/* Classifier shortlist: optional, off until llmk_host_shortlist_load() */
+#include "../llama2/llmk_shortlist.h"
+#include "../llama2/llmk_shortlist.c"
+#include "llmk_shortlist_build.h"
+
+static LlmkShortlist g_llmk_shortlist;
+static int g_llmk_cls_full = 0;
+
+/* Mixed-precision plan: optional, off until llmk_host_mixq_load/plan() */
+#include "../llama2/llmk_mixq.h"
+#include "../llama2/llmk_mixq.c"
+#include "llmk_mixq_plan.h"
+
+static LlmkMixq g_llmk_mixq;
+
+/* RoPE tables, rebuilt per load for the model's seq_len */
+#include "../llama2/llmk_rope.h"
+#include "../llama2/llmk_rope.c"
+
+static LlmkRope       g_llmk_rope;
+static void          *g_rope_mem;
+static LlmkRopeParams g_rope_model;        /* from the file (defaults for .bin) */
+static struct {
+    float freq_base;                      /* 0 = model */
+    int   scaling;                        /* -1 = model */
+    float factor;                         /* 0 = model */
+    int   orig_ctx;                       /* 0 = model */
+} g_rope_over = { 0.0f, -1, 0.0f, 0 };
+
+/* Architecture switches (gguf general.architecture; llama2.c defaults for .bin) */
+#include "../llama2/llmk_arch.h"
+
+static LlmkArch g_llmk_arch = LLMK_ARCH_LLAMA2_INIT;
+
+/* KV window: slide past seq_len (sinks + recent rows) instead of a reset */
+#include "../llama2/llmk_kv_window.h"
+#include "../llama2/llmk_kv_window.c"
+
+static LlmkKvWindow g_llmk_kvw;
+static int32_t     *g_kvw_tok;
+static struct {
+    int on;
+    int sinks;                            /* -1 = default */
+    int discard;                          /* -1 = auto */
+} g_kvw_cfg = { 1, -1, -1 };
+
+#include "../llama2/llmk_forward.c"
+#include "../llama2/llmk_sampler.c"
+#include "../llama2/llmk_repeat.h"
+#include "../llama2/llmk_repeat.c"
+#include "../llama2/llmk_gen.c"
+#include "../llama2/llmk_vocab.c"
+#include "../llama2/llmk_tokenizer.c"
+
+/* The REPL's generation: sampler, RNG and penalty history over a turn's
+ * context, decoding into g_state (the KV position across turns is its pos) */
+#define HOST_CTX_TOKENS   (384 + LLMK_HOST_MAX_TOKENS)
+
+static LlmkGenState g_gen;
+static void        *g_gen_mem;
+
+/* Prompt-lookup speculative decoding: off until llmk_host_set_spec() */
+#include "../llama2/llmk_spec.h"
+#include "../llama2/llmk_spec.c"
+
+static LlmkSpec   g_spec;
+static void      *g_spec_mem;
+static RunBatch   g_spec_batch;               /* last token + draft, verified together */
+static void      *g_spec_batch_mem;
+static int        g_spec_k;                   /* draft length, 0 = off */
+static int        g_turn_ids[LLMK_HOST_MAX_TOKENS];  /* last turn's tokens (spec eval) */
+static int        g_turn_n;
+
+/* Constrained decoding: optional, off until llmk_host_set_grammar() */
+#include "../llama2/llmk_grammar.h"
+#include "../llama2/llmk_grammar.c"
+
+static LlmkGrammar   g_grammar;
+static LlmkGrammarRt g_grammar_rt;
+static void         *g_grammar_mem;             /* vocabulary trie + mask cache */
+static int           g_grammar_on;
+
+/* ── Model state ─────────────────────────────────────────────────────────── */
+
+static int                g_fmt = LLMK_HOST_FMT_NONE;
+static HostMap            g_model_map;
+static HostMap            g_tok_map;
+static void              *g_weights_mem;          /* GGUF f32 image / Q8_0 blob */
+static float             *g_bias_mem;             /* GGUF QKV biases (qwen2) */
+static Config             g_config;
+static TransformerWeights g_weights;
+static RunState           g_state;
+static Tokenizer          g_tokenizer;
+static LlmkVocab          g_vocab;                /* GGUF-embedded tokenizer */
+static void              *g_vocab_mem;            /* its arena */
+static char               g_system_prompt[512];
+
+static OosiV3Weights      g_v3w;
+static OosiV3GenCtx       g_v3ctx;
+static BpeTokenizer       g_bpe;
+static BpeVocabEntry     *g_bpe_vocab;
+
+static void              *g_sl_file;              /* .lksl image (aligned) */
+static void              *g_sl_scratch;
+static void              *g_mx_file;              /* .lkmx image (aligned) */
+
+static uint64_t host_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static const char *host_basename_dir(const char *path, char *dir, size_t cap) {
+    const char *slash = strrchr(path, '/');
+    size_t n = slash ? (size_t)(slash - path + 1) : 0;
+    if (n >= cap) n = 0;
+    memcpy(dir, path, n);
+    dir[n] = 0;
+    return dir;
+}
+
+/* Map the first tokenizer that exists: explicit path, then each name next to
+ * the model, then in the working directory. */
+static int host_map_tokenizer(const char *tok_path, const char *model_path,
+                              const char *const *names, int n_names) {
+    if (tok_path) {
+        if (host_map_file(&g_tok_map, tok_path) == 0) return 0;
+        fprintf(stderr, "ERROR: cannot map tokenizer %s\n", tok_path);
+        return -1;
+    }
+    char dir[512], cand[1024];
+    host_basename_dir(model_path, dir, sizeof(dir));
+    for (int i = 0; i < n_names; i++) {
+        snprintf(cand, sizeof(cand), "%s%s", dir, names[i]);
+        if (host_map_file(&g_tok_map, cand) == 0) return 0;
+        if (dir[0] && host_map_file(&g_tok_map, names[i]) == 0) return 0;
+    }
+    fprintf(stderr, "ERROR: no tokenizer found next to %s\n", model_path);
+    return -1;
+}
+
+/* tokenizer.bin: int max_token_length, then per token float score, int len, bytes */
+static int host_load_tokenizer_bin(int vocab_size) {
+    const UINT8 *p = (const UINT8 *)g_tok_map.base;
+    const UINT8 *end = p + g_tok_map.size;
+    if (g_tok_map.size < 4) return -1;
+
+    g_tokenizer.vocab_size = vocab_size;
+    g_tokenizer.vocab = (char **)calloc((size_t)vocab_size, sizeof(char *));
+    g_tokenizer.vocab_scores = (float *)calloc((size_t)vocab_size, sizeof(float));
+    if (!g_tokenizer.vocab || !g_tokenizer.vocab_scores) return -1;
+    memcpy(&g_tokenizer.max_token_length, p, 4);
+    p += 4;
+
+    for (int i = 0; i < vocab_size; i++) {
+        int len = 0;
+        if (end - p < 8) return -1;
+        memcpy(&g_tokenizer.vocab_scores[i], p, 4);
+        memcpy(&len, p + 4, 4);
+        p += 8;
+        if (len < 0 || end - p < len) return -1;
+        g_tokenizer.vocab[i] = (char *)malloc((size_t)len + 1);
+        if (!g_tokenizer.vocab[i]) return -1;
+        memcpy(g_tokenizer.vocab[i], p, (size_t)len);
+        g_tokenizer.vocab[i][len] = 0;
+        p += len;
+    }
+    return 0;
+}
+
+static int host_alloc_run_state(void) {
+    Config *c = &g_config;
+    int kv_dim = (c->dim * c->n_kv_heads) / c->n_heads;
+    size_t kv = (size_t)c->n_layers * (size_t)c->seq_len * (size_t)kv_dim;
+
+    g_state.x = (float *)simple_alloc((unsigned long)c->dim * sizeof(float));
+    g_state.xb = (float *)simple_alloc((unsigned long)c->dim * sizeof(float));
+    g_state.xb2 = (float *)simple_alloc((unsigned long)c->dim * sizeof(float));
+    g_state.hb = (float *)simple_alloc((unsigned long)c->hidden_dim * sizeof(float));
+    g_state.hb2 = (float *)simple_alloc((unsigned long)c->hidden_dim * sizeof(float));
+    g_state.q = (float *)simple_alloc((unsigned long)c->dim * sizeof(float));
+    g_state.k = (float *)simple_alloc((unsigned long)kv_dim * sizeof(float));
+    g_state.v = (float *)simple_alloc((unsigned long)kv_dim * sizeof(float));
+    g_state.att = (float *)simple_alloc((unsigned long)c->n_heads * (unsigned long)c->seq_len * sizeof(float));
+    g_state.logits = (float *)simple_alloc((unsigned long)c->vocab_size * sizeof(float));
+    g_state.key_cache = (float *)simple_alloc((unsigned long)(kv * sizeof(float)));
+    g_state.value_cache = (float *)simple_alloc((unsigned long)(kv * sizeof(float)));
+    if (!g_state.x || !g_state.xb || !g_state.xb2 || !g_state.hb || !g_state.hb2 ||
+        !g_state.q || !g_state.k || !g_state.v || !g_state.att || !g_state.logits ||
+        !g_state.key_cache || !g_state.value_cache) {
+        fprintf(stderr, "ERROR: out of memory for run state\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int host_init_rope(void) {
+    const Config *c = &g_config;
+    LlmkRopeParams p = g_rope_model;
+    if (g_rope_over.freq_base > 0.0f) p.freq_base = g_rope_over.freq_base;
+    if (g_rope_over.scaling >= 0) p.scaling = g_rope_over.scaling;
+    if (g_rope_over.factor >= 1.0f) p.factor = g_rope_over.factor;
+    if (g_rope_over.orig_ctx > 0) p.orig_ctx = g_rope_over.orig_ctx;
+    int head_size = c->dim / c->n_heads;
+    int n_rot = ((p.n_rot > 0 && p.n_rot < head_size) ? p.n_rot : head_size) & ~1;
+    uint64_t bytes = llmk_rope_table_bytes(c->seq_len, n_rot);
+    g_rope_mem = simple_alloc((unsigned long)bytes);
+    if (!g_rope_mem || llmk_rope_init(&g_llmk_rope, &p, head_size, c->seq_len, g_rope_mem, bytes) != LLMK_ROPE_OK) {
+        fprintf(stderr, "ERROR: RoPE table setup failed (n_rot=%d seq_len=%d)\n", n_rot, c->seq_len);
+        return -1;
+    }
+    return 0;
+}
+
+static int host_init_kv_window(void) {
+    g_kvw_tok = (int32_t *)simple_alloc((unsigned long)g_config.seq_len * sizeof(int32_t));
+    if (!g_kvw_tok) return -1;
+    llmk_kvw_init(&g_llmk_kvw, g_config.seq_len, g_kvw_tok);
+    g_llmk_kvw.enabled = g_kvw_cfg.on;
+    if (g_kvw_cfg.sinks >= 0) g_llmk_kvw.sinks = g_kvw_cfg.sinks;
+    if (g_kvw_cfg.discard >= 0) g_llmk_kvw.discard = g_kvw_cfg.discard;
+    return 0;
+}
+
+/* Sized for a whole turn's context; settings are applied per turn */
+static int host_init_gen(void) {
+    uint64_t bytes = llmk_gen_bytes(&g_config, HOST_CTX_TOKENS);
+    g_gen_mem = simple_alloc((unsigned long)bytes);
+    if (!g_gen_mem || llmk_gen_init(&g_gen, &g_config, &g_state, g_gen_mem, bytes, HOST_CTX_TOKENS) != 0) return -1;
+    llmk_gen_seed(&g_gen, g_sample_seed);
+    return 0;
+}
+
+static int host_init_spec(void) {
+    uint64_t bytes = llmk_spec_bytes(HOST_CTX_TOKENS);
+    uint64_t bbytes = llmk_batch_bytes(&g_config, LLMK_SPEC_MAX_DRAFT + 1);
+    g_spec_mem = simple_alloc((unsigned long)bytes);
+    g_spec_batch_mem = simple_alloc((unsigned long)bbytes);
+    if (!g_spec_mem || !g_spec_batch_mem) return -1;
+    if (llmk_batch_init(&g_spec_batch, &g_config, g_spec_batch_mem, bbytes, LLMK_SPEC_MAX_DRAFT + 1) != 0) return -1;
+    return llmk_spec_init(&g_spec, g_spec_mem, bytes, HOST_CTX_TOKENS, LLMK_SPEC_MIN_NGRAM,
+                          LLMK_SPEC_MAX_NGRAM) == LLMK_SPEC_OK ? 0 : -1;
+}
+
+/* soma_inference.c llmk_kvw_slide */
+static int host_kvw_slide(int pos, int need) {
+    LlmkKvCache kv;
+    kv.key_cache = g_state.key_cache;
+    kv.value_cache = g_state.value_cache;
+    kv.n_layers = g_config.n_layers;
+    kv.seq_len = g_config.seq_len;
+    kv.kv_dim = (g_config.dim * g_config.n_kv_heads) / g_config.n_heads;
+    kv.n_kv_heads = g_config.n_kv_heads;
+    return llmk_kvw_make_room(&g_llmk_kvw, &kv, &g_llmk_rope, pos, need);
+}
+
+static int host_check_config(const Config *c) {
+    if (c->dim <= 0 || c->hidden_dim <= 0 || c->n_layers <= 0 || c->n_heads <= 0 ||
+        c->n_kv_heads <= 0 || c->vocab_size <= 0 || c->seq_len <= 0 ||
+        (c->dim % c->n_heads) != 0 || (c->n_heads % c->n_kv_heads) != 0) {
+        fprintf(stderr, "ERROR: bad model header (dim=%d hidden=%d layers=%d heads=%d kv=%d vocab=%d seq=%d)\n",
+                c->dim, c->hidden_dim, c->n_layers, c->n_heads, c->n_kv_heads, c->vocab_size, c->seq_len);
+        return -1;
+    }
+    return 0;
+}
+
+/* llama2.c .bin: weights stay in the mapping (same pointer walk as soma_boot) */
+static int host_load_bin(void) {
+    if (g_model_map.size < 7 * sizeof(int)) return -1;
+    memcpy(&g_config, g_model_map.base, 7 * sizeof(int));
+    int shared_classifier = (g_config.vocab_size < 0);
+    if (g_config.vocab_size < 0) g_config.vocab_size = -g_config.vocab_size;
+    if (host_check_config(&g_config) != 0) return -1;
+
+    Config *c = &g_config;
+    UINT64 head_size = (UINT64)(c->dim / c->n_heads);
+    UINT64 kv_dim = (UINT64)(c->dim * c->n_kv_heads) / (UINT64)c->n_heads;
+    UINT64 L = (UINT64)c->n_layers, D = (UINT64)c->dim, H = (UINT64)c->hidden_dim;
+    UINT64 n_base = (UINT64)c->vocab_size * D + L * D + 2 * L * D * D + 2 * L * D * kv_dim +
+                    L * D + 3 * L * D * H + D + (UINT64)c->seq_len * head_size;
+    UINT64 n_with = n_base + (UINT64)c->vocab_size * D;
+    UINT64 avail = (UINT64)g_model_map.size - 7 * sizeof(int);
+    if (avail < n_with * 4 && avail >= n_base * 4) shared_classifier = 1;
+    else if (avail >= n_with * 4) shared_classifier = 0;
+    if (avail < (shared_classifier ? n_base : n_with) * 4) {
+        fprintf(stderr, "ERROR: model file truncated (%llu bytes of weights)\n", (unsigned long long)avail);
+        return -1;
+    }
+
+    float *wp = (float *)((UINT8 *)g_model_map.base + 7 * sizeof(int));
+    memset(&g_weights, 0, sizeof(g_weights));
+    g_weights.kind = 0;
+    g_weights.token_embedding_table = wp;  wp += (UINT64)c->vocab_size * D;
+    g_weights.rms_att_weight = wp;         wp += L * D;
+    g_weights.wq = wp;                     wp += L * D * D;
+    g_weights.wk = wp;                     wp += L * D * kv_dim;
+    g_weights.wv = wp;                     wp += L * D * kv_dim;
+    g_weights.wo = wp;                     wp += L * D * D;
+    g_weights.rms_ffn_weight = wp;         wp += L * D;
+    g_weights.w1 = wp;                     wp += L * D * H;
+    g_weights.w2 = wp;                     wp += L * H * D;
+    g_weights.w3 = wp;                     wp += L * D * H;
+    g_weights.rms_final_weight = wp;       wp += D;
+    wp += (UINT64)c->seq_len * head_size / 2;   /* freq_cis_real */
+    wp += (UINT64)c->seq_len * head_size / 2;   /* freq_cis_imag */
+    g_weights.wcls = shared_classifier ? g_weights.token_embedding_table : wp;
+    return 0;
+}
+
+/* Q8_0 blob → pointer fields (same section order as soma_boot) */
+static int host_map_q8_blob(UINT8 *base, int shared_classifier) {
+    Config *c = &g_config;
+    const UINT64 A = 16;
+    UINT64 off = 0;
+    UINT64 kv_dim = (UINT64)(c->dim * c->n_kv_heads) / (UINT64)c->n_heads;
+    UINT64 head_size = (UINT64)(c->dim / c->n_heads);
+    UINT64 L = (UINT64)c->n_layers, D = (UINT64)c->dim;
+    UINT64 row_d = llmk_q8_0_row_bytes(c->dim);
+    UINT64 row_h = llmk_q8_0_row_bytes(c->hidden_dim);
+    if (!row_d || !row_h) {
+        fprintf(stderr, "ERROR: Q8_0 blob requires dims multiple of 32 (dim=%d hidden=%d)\n",
+                c->dim, c->hidden_dim);
+        return -1;
+    }
+
+    memset(&g_weights, 0, sizeof(g_weights));
+    g_weights.kind = 1;
+    g_weights.tok_embd_row_bytes = row_d;
+    g_weights.wq_layer_bytes = D * row_d;
+    g_weights.wk_layer_bytes = kv_dim * row_d;
+    g_weights.wv_layer_bytes = kv_dim * row_d;
+    g_weights.wo_layer_bytes = D * row_d;
+    g_weights.w1_layer_bytes = (UINT64)c->hidden_dim * row_d;
+    g_weights.w2_layer_bytes = D * row_h;
+    g_weights.w3_layer_bytes = (UINT64)c->hidden_dim * row_d;
+
+    off = llmk_align_up_u64(off, A); g_weights.token_embedding_table_q8 = base + off; off += (UINT64)c->vocab_size * row_d;
+    off = llmk_align_up_u64(off, A); g_weights.rms_att_weight = (float *)(base + off); off += L * D * 4;
+    off = llmk_align_up_u64(off, A); g_weights.wq_q8 = base + off; off += L * g_weights.wq_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.wk_q8 = base + off; off += L * g_weights.wk_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.wv_q8 = base + off; off += L * g_weights.wv_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.wo_q8 = base + off; off += L * g_weights.wo_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.rms_ffn_weight = (float *)(base + off); off += L * D * 4;
+    off = llmk_align_up_u64(off, A); g_weights.w1_q8 = base + off; off += L * g_weights.w1_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.w2_q8 = base + off; off += L * g_weights.w2_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.w3_q8 = base + off; off += L * g_weights.w3_layer_bytes;
+    off = llmk_align_up_u64(off, A); g_weights.rms_final_weight = (float *)(base + off); off += D * 4;
+    off = llmk_align_up_u64(off, A);
+    off += 2 * ((UINT64)c->seq_len * head_size / 2 * 4);
+    if (shared_classifier) {
+        g_weights.wcls_q8 = g_weights.token_embedding_table_q8;
+    } else {
+        off = llmk_align_up_u64(off, A);
+        g_weights.wcls_q8 = base + off;
+    }
+    return 0;
+}
+
+/* bq | bk | bv, as written by llmk_gguf_load_qkv_bias */
+static void host_map_bias(float *bias) {
+    if (!bias) return;
+    UINT64 kv_dim = (UINT64)(g_config.dim * g_config.n_kv_heads) / (UINT64)g_config.n_heads;
+    g_weights.bq = bias;
+    g_weights.bk = g_weights.bq + (UINT64)g_config.n_layers * (UINT64)g_config.dim;
+    g_weights.bv = g_weights.bk + (UINT64)g_config.n_layers * kv_dim;
+}
+
+static int host_load_gguf(int q8_blob) {
+    HostFile hf;
+    host_file_open_mem(&hf, g_model_map.base, g_model_map.size);
+    EFI_FILE_HANDLE f = &hf.proto;
+
+    LlmkGgufPlan *plan = NULL;
+    int has_output = 0;
+    Config *c = &g_config;
+    EFI_STATUS st = llmk_gguf_build_plan(f, &plan, &c->dim, &c->hidden_dim, &c->n_layers, &c->n_heads,
+                                         &c->n_kv_heads, &c->vocab_size, &c->seq_len, &has_output);
+    if (EFI_ERROR(st) || !plan) {
+        Print(L"ERROR: GGUF inference unsupported (%r)\r\n", st);
+        return -1;
+    }
+    llmk_gguf_plan_rope(plan, &g_rope_model);
+    llmk_gguf_plan_arch(plan, &g_llmk_arch);
+    if (host_check_config(c) != 0) {
+        llmk_gguf_free_plan(plan);
+        return -1;
+    }
+    int shared = has_output ? 0 : 1;
+
+    /* QKV biases: own buffer, mapped after the weights (the mapping clears g_weights) */
+    UINT64 n_bias = llmk_gguf_plan_bias_floats(plan);
+    float *bias = NULL;
+    if (n_bias) {
+        bias = (float *)simple_alloc((unsigned long)(n_bias * sizeof(float)));
+        st = bias ? llmk_gguf_load_qkv_bias(f, plan, bias, n_bias) : EFI_OUT_OF_RESOURCES;
+        if (EFI_ERROR(st)) {
+            free(bias);
+            llmk_gguf_free_plan(plan);
+            Print(L"ERROR: Failed to load GGUF QKV biases (%r).\r\n", st);
+            return -1;
+        }
+    }
+    g_bias_mem = bias;
+
+    if (q8_blob && !llmk_gguf_plan_supports_q8_0_blob(plan, shared)) {
+        Print(L"NOTE: GGUF tensors are not all Q8_0; using float32 load.\r\n");
+        q8_blob = 0;
+    }
+
+    if (q8_blob) {
+        UINT64 bytes = 0;
+        st = llmk_gguf_calc_llama2_q8_0_blob_bytes(plan, c->dim, c->hidden_dim, c->n_layers, c->n_heads,
+                                                   c->n_kv_heads, c->vocab_size, c->seq_len, shared, &bytes);
+        if (!EFI_ERROR(st)) {
+            g_weights_mem = simple_alloc((unsigned long)bytes);
+            if (!g_weights_mem) st = EFI_OUT_OF_RESOURCES;
+        }
+        if (!EFI_ERROR(st)) {
+            st = llmk_gguf_load_into_llama2_q8_0_blob(f, plan, g_weights_mem, bytes, c->dim, c->hidden_dim,
+                                                      c->n_layers, c->n_heads, c->n_kv_heads, c->vocab_size,
+                                                      c->seq_len, shared);
+        }
+        llmk_gguf_free_plan(plan);
+        if (EFI_ERROR(st)) {
+            Print(L"ERROR: Failed to load GGUF Q8_0 blob weights (%r).\r\n", st);
+            return -1;
+        }
+        if (host_map_q8_blob((UINT8 *)g_weights_mem, shared) != 0) return -1;
+        host_map_bias(bias);
+        return 0;
+    }
+
+    UINT64 head_size = (UINT64)(c->dim / c->n_heads);
+    UINT64 kv_dim = (UINT64)(c->dim * c->n_kv_heads) / (UINT64)c->n_heads;
+    UINT64 L = (UINT64)c->n_layers, D = (UINT64)c->dim, H = (UINT64)c->hidden_dim;
+    UINT64 n_floats = (UINT64)c->vocab_size * D * (shared ? 1 : 2) + L * D + 2 * L * D * D +
+                      2 * L * D * kv_dim + L * D + 3 * L * D * H + D + (UINT64)c->seq_len * head_size;
+    float *wm = (float *)simple_alloc((unsigned long)(n_floats * sizeof(float)));
+    if (!wm) {
+        llmk_gguf_free_plan(plan);
+        fprintf(stderr, "ERROR: out of memory for %llu MB of weights\n",
+                (unsigned long long)(n_floats * 4 >> 20));
+        return -1;
+    }
+    g_weights_mem = wm;
+    st = llmk_gguf_load_into_llama2_layout(f, plan, wm, c->dim, c->hidden_dim, c->n_layers, c->n_heads,
+                                           c->n_kv_heads, c->vocab_size, c->seq_len, shared);
+    llmk_gguf_free_plan(plan);
+    if (EFI_ERROR(st)) {
+        Print(L"ERROR: Failed to load GGUF weights (%r).\r\n", st);
+        return -1;
+    }
+
+    memset(&g_weights, 0, sizeof(g_weights));
+    float *wp = wm;
+    g_weights.token_embedding_table = wp;  wp += (UINT64)c->vocab_size * D;
+    g_weights.rms_att_weight = wp;         wp += L * D;
+    g_weights.wq = wp;                     wp += L * D * D;
+    g_weights.wk = wp;                     wp += L * D * kv_dim;
+    g_weights.wv = wp;                     wp += L * D * kv_dim;
+    g_weights.wo = wp;                     wp += L * D * D;
+    g_weights.rms_ffn_weight = wp;         wp += L * D;
+    g_weights.w1 = wp;                     wp += L * D * H;
+    g_weights.w2 = wp;                     wp += L * H * D;
+    g_weights.w3 = wp;                     wp += L * D * H;
+    g_weights.rms_final_weight = wp;       wp += D;
+    wp += (UINT64)c->seq_len * head_size;
+    g_weights.wcls = shared ? g_weights.token_embedding_table : wp;
+    host_map_bias(bias);
+    return 0;
+}
+
+static int host_load_oosi_v3(void) {
+    SsmStatus sst = oosi_v3_load(&g_v3w, g_model_map.base, g_model_map.size);
+    if (sst == SSM_OK) sst = oosi_v3_validate(&g_v3w);
+    if (sst != SSM_OK) {
+        fprintf(stderr, "ERROR: OOSI v3 load/validate failed (code %d)\n", (int)sst);
+        return -1;
+    }
+    int D = g_v3w.d_model, Di = g_v3w.d_inner, S = g_v3w.d_state, Dc = g_v3w.d_conv;
+    int Dt = g_v3w.dt_rank, N = g_v3w.n_layer, V = g_v3w.vocab_size, Hd = g_v3w.halt_d_input;
+
+    ssm_f32 *scratch = (ssm_f32 *)simple_alloc((unsigned long)(3 * D + 4 * Di + Dt + 2 * S + 4) * sizeof(ssm_f32));
+    ssm_f32 *logits = (ssm_f32 *)simple_alloc((unsigned long)V * sizeof(ssm_f32));
+    ssm_f32 *h_state = (ssm_f32 *)simple_alloc((unsigned long)oosi_v3_h_state_bytes(N, Di, S));
+    ssm_f32 *conv = (ssm_f32 *)simple_alloc((unsigned long)oosi_v3_conv_buf_bytes(N, Di, Dc));
+    int *conv_pos = (int *)simple_alloc((unsigned long)oosi_v3_conv_pos_bytes(N));
+    ssm_f32 *h1 = (ssm_f32 *)simple_alloc(512 * sizeof(ssm_f32));
+    ssm_f32 *h2 = (ssm_f32 *)simple_alloc(64 * sizeof(ssm_f32));
+    ssm_f32 *hbuf = (ssm_f32 *)simple_alloc((unsigned long)(Hd + 1) * sizeof(ssm_f32));
+    if (!scratch || !logits || !h_state || !conv || !conv_pos || !h1 || !h2 || !hbuf) {
+        fprintf(stderr, "ERROR: out of memory for OOSI v3 state\n");
+        return -1;
+    }
+    sst = oosi_v3_gen_ctx_init(&g_v3ctx, &g_v3w, scratch, logits, h_state, conv, conv_pos,
+                               h1, h2, hbuf, 0.80f, 0.7f, 0.90f, 0xCAFEBABEu, 128);
+    if (sst != SSM_OK) {
+        fprintf(stderr, "ERROR: oosi_v3_gen_ctx_init failed (code %d)\n", (int)sst);
+        return -1;
+    }
+    if (!g_v3ctx.neg_exp_A) {
+        ssm_f32 *neg = (ssm_f32 *)simple_alloc((unsigned long)oosi_v3_h_state_bytes(N, Di, S));
+        if (neg) oosi_v3_precompute_neg_exp_A(&g_v3ctx, neg);
+    }
+    g_config.vocab_size = V;
+    g_config.seq_len = 0;                 /* recurrent: no KV window */
+    return 0;
+}
+
+/* Tokenizer from the GGUF metadata (tokenizer.ggml.*). Returns 0 when loaded,
+ * 1 when the file carries none llmk_vocab.c can run, -1 on error. */
+static int host_load_gguf_vocab(void) {
+    HostFile hf;
+    host_file_open_mem(&hf, g_model_map.base, g_model_map.size);
+    EFI_FILE_HANDLE f = &hf.proto;
+
+    UINT64 bytes = 0;
+    EFI_STATUS st = llmk_gguf_vocab_bytes(f, g_config.vocab_size, &bytes);
+    if (st == EFI_NOT_FOUND || st == EFI_UNSUPPORTED) return 1;
+    if (!EFI_ERROR(st)) {
+        g_vocab_mem = simple_alloc((unsigned long)bytes);
+        st = g_vocab_mem ? llmk_gguf_load_vocab(f, g_config.vocab_size, g_vocab_mem, bytes, &g_vocab)
+                         : EFI_OUT_OF_RESOURCES;
+    }
+    if (!EFI_ERROR(st) && g_vocab.n_tokens > g_config.vocab_size) st = EFI_INCOMPATIBLE_VERSION;
+    if (!EFI_ERROR(st) && llmk_vocab_build(&g_vocab) != LLMK_VOCAB_OK) st = EFI_BUFFER_TOO_SMALL;
+    if (EFI_ERROR(st)) {
+        Print(L"ERROR: GGUF tokenizer load failed (%r)\r\n", st);
+        return -1;
+    }
+
+    int max_len = 0;
+    for (int i = 0; i < g_vocab.n_tokens; i++) {
+        int n = 0;
+        while (g_vocab.piece[i] && g_vocab.piece[i][n]) n++;
+        if (n > max_len) max_len = n;
+    }
+    g_tokenizer.vocab = g_vocab.piece;
+    g_tokenizer.vocab_scores = g_vocab.score;
+    g_tokenizer.vocab_size = g_config.vocab_size;
+    g_tokenizer.max_token_length = max_len;
+    g_tokenizer.gguf = &g_vocab;
+    return 0;
+}
+
+int llmk_host_load(const char *model_path, const char *tok_path, int q8_blob) {
+    llmk_host_unload();
+    djibmark_init();
+    pheromion_init(&g_pheromion);
+    g_attn_use_avx2 = llmk_has_avx2_cached();
+    g_metrics.session_start_cycles = __rdtsc();
+    llmk_rope_defaults(&g_rope_model);
+    g_llmk_arch = (LlmkArch)LLMK_ARCH_LLAMA2_INIT;
+
+    if (host_map_file(&g_model_map, model_path) != 0) {
+        fprintf(stderr, "ERROR: cannot map model %s\n", model_path);
+        return -1;
+    }
+    UINT32 magic = 0;
+    if (g_model_map.size >= 4) memcpy(&magic, g_model_map.base, 4);
+
+    int rc;
+    if (magic == 0x46554747u) {                 /* "GGUF" */
+        g_fmt = LLMK_HOST_FMT_GGUF;
+        rc = host_load_gguf(q8_blob);
+    } else if (magic == OOSI_V3_MAGIC) {
+        g_fmt = LLMK_HOST_FMT_OOSI_V3;
+        rc = host_load_oosi_v3();
+    } else {
+        g_fmt = LLMK_HOST_FMT_BIN;
+        rc = host_load_bin();
+    }
+    if (rc != 0) {
+        llmk_host_unload();
+        return -1;
+    }
+
+    if (g_fmt == LLMK_HOST_FMT_OOSI_V3) {
+        static const char *const names[] = { "gpt_neox_tokenizer.bin", "tokenizer.bin" };
+        if (host_map_tokenizer(tok_path, model_path, names, 2) != 0) {
+            llmk_host_unload();
+            return -1;
+        }
+        int cap = g_v3w.vocab_size > 0 ? g_v3w.vocab_size : 50282;
+        g_bpe_vocab = (BpeVocabEntry *)calloc((size_t)cap, sizeof(BpeVocabEntry));
+        if (!g_bpe_vocab || bpe_load(&g_bpe, g_bpe_vocab, cap, g_tok_map.base, g_tok_map.size) != BPE_OK) {
+            fprintf(stderr, "ERROR: BPE tokenizer parse failed\n");
+            llmk_host_unload();
+            return -1;
+        }
+        return 0;
+    }
+
+    /* GGUF: the embedded tokenizer unless --tokenizer names a tokenizer.bin */
+    rc = (g_fmt == LLMK_HOST_FMT_GGUF && !tok_path) ? host_load_gguf_vocab() : 1;
+    if (rc < 0) {
+        llmk_host_unload();
+        return -1;
+    }
+    static const char *const names[] = { "tokenizer.bin" };
+    if (rc != 0 && (host_map_tokenizer(tok_path, model_path, names, 1) != 0 ||
+                    host_load_tokenizer_bin(g_config.vocab_size) != 0)) {
+        fprintf(stderr, "ERROR: tokenizer does not match vocab_size=%d\n", g_config.vocab_size);
+        llmk_host_unload();
+        return -1;
+    }
+    if (host_alloc_run_state() != 0 || host_init_rope() != 0 || host_init_kv_window() != 0 ||
+        host_init_gen() != 0 || host_init_spec() != 0) {
+        llmk_host_unload();
+        return -1;
+    }
+    g_gen.pos = 0;
+    return 0;
+}
+
+/* The int8 activation buffers in llmk_kernels.c stay allocated, as on UEFI */
+void llmk_host_unload(void) {
+    float **rs[] = { &g_state.x, &g_state.xb, &g_state.xb2, &g_state.hb, &g_state.hb2, &g_state.q,
+                     &g_state.k, &g_state.v, &g_state.att, &g_state.logits, &g_state.key_cache,
+                     &g_state.value_cache };
+    for (unsigned i = 0; i < sizeof(rs) / sizeof(rs[0]); i++) {
+        free(*rs[i]);
+        *rs[i] = NULL;
+    }
+    if (g_v3ctx.w) {
+        free(g_v3ctx.scratch);
+        free(g_v3ctx.logits);
+        free(g_v3ctx.h_state);
+        free(g_v3ctx.conv_buf);
+        free(g_v3ctx.conv_pos);
+        free(g_v3ctx.halt_h1);
+        free(g_v3ctx.halt_h2);
+        free(g_v3ctx.halt_buf);
+        if (g_v3ctx.neg_exp_A != g_v3w.neg_exp_A_data) free(g_v3ctx.neg_exp_A);
+        memset(&g_v3ctx, 0, sizeof(g_v3ctx));
+    }
+    if (!g_tokenizer.gguf) {              /* GGUF pieces and scores live in g_vocab_mem */
+        if (g_tokenizer.vocab) {
+            for (int i = 0; i < g_tokenizer.vocab_size; i++) free(g_tokenizer.vocab[i]);
+            free(g_tokenizer.vocab);
+        }
+        free(g_tokenizer.vocab_scores);
+    }
+    free(g_vocab_mem);
+    g_vocab_mem = NULL;
+    memset(&g_vocab, 0, sizeof(g_vocab));
+    free(g_bpe_vocab);
+    free(g_weights_mem);
+    free(g_bias_mem);
+    memset(&g_tokenizer, 0, sizeof(g_tokenizer));
+    free(g_sl_file);
+    free(g_sl_scratch);
+    memset(&g_llmk_shortlist, 0, sizeof(g_llmk_shortlist));
+    free(g_mx_file);
+    g_mx_file = NULL;
+    memset(&g_llmk_mixq, 0, sizeof(g_llmk_mixq));
+    free(g_rope_mem);
+    g_rope_mem = NULL;
+    memset(&g_llmk_rope, 0, sizeof(g_llmk_rope));
+    free(g_kvw_tok);
+    g_kvw_tok = NULL;
+    memset(&g_llmk_kvw, 0, sizeof(g_llmk_kvw));
+    free(g_grammar_mem);
+    g_grammar_mem = NULL;
+    free(g_gen_mem);
+    g_gen_mem = NULL;
+    memset(&g_gen, 0, sizeof(g_gen));
+    free(g_spec_mem);
+    free(g_spec_batch_mem);
+    g_spec_mem = g_spec_batch_mem = NULL;
+    memset(&g_spec, 0, sizeof(g_spec));
+    memset(&g_spec_batch, 0, sizeof(g_spec_batch));
+    memset(&g_grammar_rt, 0, sizeof(g_grammar_rt));
+    g_grammar_on = 0;
+    g_sl_file = NULL;
+    g_sl_scratch = NULL;
+    g_bpe_vocab = NULL;
+    g_weights_mem = NULL;
+    g_bias_mem = NULL;
+    host_unmap(&g_tok_map);
+    host_unmap(&g_model_map);
+    g_fmt = LLMK_HOST_FMT_NONE;
+}
+
+int llmk_host_format(void) { return g_fmt; }
+int llmk_host_seq_len(void) { return g_config.seq_len; }
+
+void llmk_host_describe(void) {
+    static const char *const fmt_names[] = { "none", "bin", "gguf", "oosi-v3" };
+    if (g_fmt == LLMK_HOST_FMT_OOSI_V3) {
+        fprintf(stderr, "[model] oosi-v3 d_model=%d n_layer=%d d_inner=%d d_state=%d vocab=%d\n",
+                g_v3w.d_model, g_v3w.n_layer, g_v3w.d_inner, g_v3w.d_state, g_v3w.vocab_size);
+        return;
+    }
+    fprintf(stderr, "[model] %s dim=%d hidden=%d layers=%d heads=%d kv_heads=%d vocab=%d seq=%d weights=%s\n",
+            fmt_names[g_fmt], g_config.dim, g_config.hidden_dim, g_config.n_layers, g_config.n_heads,
+            g_config.n_kv_heads, g_config.vocab_size, g_config.seq_len, g_weights.kind == 1 ? "q8_0" : "f32");
+    if (g_fmt == LLMK_HOST_FMT_GGUF) {
+        fprintf(stderr, "[model] arch=%s act=%s norm_eps=%g embed_scale=%g qkv_bias=%d window=%d\n",
+                g_llmk_arch.name, g_llmk_arch.act == LLMK_ARCH_ACT_GELU_TANH ? "gelu" : "silu",
+                (double)g_llmk_arch.norm_eps, (double)g_llmk_arch.embed_scale, g_llmk_arch.qkv_bias,
+                g_llmk_arch.sliding_window);
+    }
+    fprintf(stderr, "[model] attn=%s q8_act=%d\n",
+            (g_attn_force == 1 || (g_attn_force < 0 && g_attn_use_avx2)) ? "avx2" : "sse2",
+            g_cfg_q8_act_quant);
+    if (g_llmk_rope.ready) {
+        const LlmkRopeParams *p = &g_llmk_rope.p;
+        fprintf(stderr, "[model] rope=%s n_rot=%d base=%g scaling=%s",
+                p->layout == LLMK_ROPE_NEOX ? "neox" : "norm", p->n_rot, (double)p->freq_base,
+                llmk_rope_scaling_name(p->scaling));
+        if (p->scaling != LLMK_ROPE_SCALING_NONE)
+            fprintf(stderr, " factor=%g orig_ctx=%d", (double)p->factor, p->orig_ctx);
+        fprintf(stderr, "\n");
+    }
+    if (g_llmk_kvw.enabled) {
+        fprintf(stderr, "[model] kv_window sinks=%d discard=%d\n", g_llmk_kvw.sinks, llmk_kvw_discard(&g_llmk_kvw));
+    }
+}
+
+void llmk_host_set_q8_act(int mode) { g_cfg_q8_act_quant = (mode >= 0 && mode <= 2) ? mode : 0; }
+int llmk_host_set_rope(float freq_base, const char *scaling, float factor, int orig_ctx) {
+    int sc = -1;
+    if (scaling) {
+        sc = llmk_rope_scaling_from_name(scaling, (int)strlen(scaling));
+        if (sc < 0) return -1;
+    }
+    g_rope_over.freq_base = freq_base > 0.0f ? freq_base : 0.0f;
+    g_rope_over.scaling = sc;
+    g_rope_over.factor = factor >= 1.0f ? factor : 0.0f;
+    g_rope_over.orig_ctx = orig_ctx > 0 ? orig_ctx : 0;
+    return 0;
+}
+
+void llmk_host_set_kv_window(int on, int sinks, int discard) {
+    g_kvw_cfg.on = on ? 1 : 0;
+    g_kvw_cfg.sinks = sinks >= 0 ? sinks : -1;
+    g_kvw_cfg.discard = discard > 0 ? discard : -1;
+    if (g_kvw_tok) {
+        g_llmk_kvw.enabled = g_kvw_cfg.on;
+        g_llmk_kvw.sinks = g_kvw_cfg.sinks >= 0 ? g_kvw_cfg.sinks : LLMK_KVW_DEFAULT_SINKS;
+        g_llmk_kvw.discard = g_kvw_cfg.discard > 0 ? g_kvw_cfg.discard : 0;
+    }
+}
+
+void llmk_host_set_attn(int force) { g_attn_force = (force >= -1 && force <= 1) ? force : -1; }
+
+void llmk_host_set_seed(unsigned int seed, int jitter) {
+    g_sample_seed = seed ? seed : 1;
+    g_host_jitter = jitter ? 1 : 0;
+    if (g_gen.state) llmk_gen_seed(&g_gen, g_sample_seed);
+}
+
+void llmk_host_set_system_prompt(const char *s) {
+    snprintf(g_system_prompt, sizeof(g_system_prompt), "%s", s ? s : "");
+}
+
+void llmk_host_gen_defaults(LlmkHostGen *g) {
+    g->temperature = 0.85f;
+    g->min_p = 0.05f;
+    g->top_p = 0.95f;
+    g->top_k = 80;
+    g->repeat_penalty = 1.15f;
+    g->freq_penalty = 0.0f;
+    g->presence_penalty = 0.0f;
+    g->no_repeat_ngram = 4;
+    g->max_gen_tokens = 160;
+    g->stop_on_you = 1;
+    g->stop_on_double_nl = 0;
+    g->stats = 1;
+    g->chat_format = LLMK_HOST_CHAT_YOU_AI;
+    g->echo = 1;
+}
+
+void llmk_host_reset(void) {
+    if (g_fmt == LLMK_HOST_FMT_OOSI_V3) {
+        oosi_v3_gen_ctx_reset(&g_v3ctx);
+        return;
+    }
+    if (!g_state.key_cache) return;
+    int kv_dim = (g_config.dim * g_config.n_kv_heads) / g_config.n_heads;
+    size_t n = (size_t)g_config.n_layers * (size_t)g_config.seq_len * (size_t)kv_dim;
+    memset(g_state.key_cache, 0, n * sizeof(float));
+    memset(g_state.value_cache, 0, n * sizeof(float));
+    llmk_kvw_reset(&g_llmk_kvw);
+    g_metrics.kv_cache_resets++;
+    g_gen.pos = 0;
+}
+
+/* ── Bench capture (JSONL rows identical to llmk_bench_on_turn_end) ──────── */
+
+static FILE    *g_bench_file;
+static int      g_bench_pending;
+static char     g_bench_case_id[64];
+static char     g_bench_category[32];
+static uint64_t g_bench_wall0_us;
+static UINT64   g_bench_decode_cycles_start;
+static UINT32   g_bench_decode_tokens_start;
+
+static void host_bench_sanitize(char *dst, int cap, const char *src) {
+    int p = 0;
+    for (int i = 0; src && src[i] && p + 1 < cap; i++) {
+        char c = src[i];
+        int ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                 c == '_' || c == '-' || c == '.';
+        dst[p++] = ok ? c : '?';
+    }
+    dst[p] = 0;
+}
+
+int llmk_host_bench_begin(const char *path) {
+    if (g_bench_file) fclose(g_bench_file);
+    g_bench_pending = 0;
+    if (!path || !path[0]) path = "LLMK_BEN.JNL";
+    g_bench_file = fopen(path, "wb");
+    if (!g_bench_file) {
+        fprintf(stderr, "ERROR: bench_begin cannot open %s\n", path);
+        return -1;
+    }
+    fprintf(stderr, "[bench] begin -> %s\n", path);
+    return 0;
+}
+
+void llmk_host_bench_case(const char *case_id, const char *category, int max_new_tokens) {
+    (void)max_new_tokens;
+    host_bench_sanitize(g_bench_case_id, (int)sizeof(g_bench_case_id), case_id);
+    host_bench_sanitize(g_bench_category, (int)sizeof(g_bench_category), category);
+    g_bench_pending = 1;
+    g_bench_wall0_us = 0;
+    g_bench_decode_cycles_start = g_metrics.total_decode_cycles;
+    g_bench_decode_tokens_start = g_metrics.total_decode_tokens;
+}
+
+void llmk_host_bench_end(void) {
+    if (!g_bench_file) {
+        fprintf(stderr, "[bench] not active\n");
+        return;
+    }
+    fclose(g_bench_file);
+    g_bench_file = NULL;
+    g_bench_pending = 0;
+    fprintf(stderr, "[bench] end\n");
+}
+
+int llmk_host_bench_active(void) { return g_bench_file != NULL; }
+
+static void host_bench_on_turn_start(void) {
+    if (g_bench_file && g_bench_pending) g_bench_wall0_us = host_now_us();
+}
+
+static void host_bench_on_turn_end(int generated_tokens) {
+    if (!g_bench_file || !g_bench_pending) return;
+    UINT64 decode_cycles = g_metrics.total_decode_cycles - g_bench_decode_cycles_start;
+    UINT32 decode_tokens = g_metrics.total_decode_tokens - g_bench_decode_tokens_start;
+    uint64_t latency_ms = (host_now_us() - g_bench_wall0_us) / 1000ULL;
+
+    fprintf(g_bench_file,
+            "{\"case_id\":\"%s\",\"category\":\"%s\",\"latency_ms\":%llu,\"decode_cycles\":%llu,"
+            "\"decode_tokens\":%u,\"generated_tokens\":%d}\n",
+            g_bench_case_id, g_bench_category, (unsigned long long)latency_ms,
+            (unsigned long long)decode_cycles, (unsigned)decode_tokens,
+            generated_tokens < 0 ? 0 : generated_tokens);
+    fflush(g_bench_file);
+    fprintf(stderr, "[bench] case=%s latency_ms=%llu decode_tokens=%u\n",
+            g_bench_case_id, (unsigned long long)latency_ms, (unsigned)decode_tokens);
+    g_bench_pending = 0;
+}
+
+/* ── Generation ──────────────────────────────────────────────────────────── */
+
+static int host_append(char *out, int cap, int p, const char *s) {
+    while (*s && p + 1 < cap) out[p++] = *s++;
+    out[p] = 0;
+    return p;
+}
+
+/* Same wrappers as llmk_build_chat_prompt */
+static const char *host_chat_prompt(char *out, int cap, const char *user, int fmt, int kv_pos) {
+    int p = 0;
+    out[0] = 0;
+    switch (fmt) {
+    case LLMK_HOST_CHAT_YOU_AI:
+        p = host_append(out, cap, p, kv_pos == 0 ? "You: " : "\nYou: ");
+        p = host_append(out, cap, p, user);
+        host_append(out, cap, p, "\nAI: ");
+        return out;
+    case LLMK_HOST_CHAT_LLAMA2:
+        if (kv_pos == 0 && g_system_prompt[0]) {
+            p = host_append(out, cap, p, "[INST] <<SYS>>\n");
+            p = host_append(out, cap, p, g_system_prompt);
+            p = host_append(out, cap, p, "\n<</SYS>>\n\n");
+        } else {
+            p = host_append(out, cap, p, "[INST] ");
+        }
+        p = host_append(out, cap, p, user);
+        host_append(out, cap, p, " [/INST]");
+        return out;
+    case LLMK_HOST_CHAT_CHATML:
+        if (kv_pos == 0 && g_system_prompt[0]) {
+            p = host_append(out, cap, p, "<|im_start|>system\n");
+            p = host_append(out, cap, p, g_system_prompt);
+            p = host_append(out, cap, p, "<|im_end|>\n");
+        }
+        p = host_append(out, cap, p, "<|im_start|>user\n");
+        p = host_append(out, cap, p, user);
+        host_append(out, cap, p, "<|im_end|>\n<|im_start|>assistant\n");
+        return out;
+    case LLMK_HOST_CHAT_ALPACA:
+        p = host_append(out, cap, p, "### Instruction:\n");
+        if (kv_pos == 0 && g_system_prompt[0]) {
+            p = host_append(out, cap, p, g_system_prompt);
+            p = host_append(out, cap, p, "\n\n");
+        }
+        p = host_append(out, cap, p, user);
+        host_append(out, cap, p, "\n\n### Response:\n");
+        return out;
+    default:
+        return user;
+    }
+}
+
+static void host_emit(const LlmkHostGen *g, const char *bytes, int n) {
+    if (g->echo && n > 0) {
+        fwrite(bytes, 1, (size_t)n, stdout);
+        fflush(stdout);
+    }
+}
+
+typedef struct {
+    const LlmkHostGen *g;
+    int generated;
+} HostV3Cb;
+
+static void host_v3_token(int token_id, const OosiV3HaltResult *r, void *ud) {
+    HostV3Cb *cb = (HostV3Cb *)ud;
+    char piece[64];
+    (void)r;
+    int n = bpe_decode_token(&g_bpe, token_id, piece, (int)sizeof(piece));
+    host_emit(cb->g, piece, n);
+    cb->generated++;
+}
+
+static int host_generate_oosi_v3(const char *text, const LlmkHostGen *g, LlmkHostTurn *t) {
+    int ids[BPE_MAX_TOKENS];
+    int n = bpe_encode(&g_bpe, text, 1, ids, BPE_MAX_TOKENS);
+    if (n <= 0) return -1;
+
+    oosi_v3_gen_ctx_reset(&g_v3ctx);
+    g_v3ctx.temperature = g->temperature;
+    g_v3ctx.top_p = g->top_p;
+    g_v3ctx.repetition_penalty = g->repeat_penalty;
+    g_v3ctx.max_tokens = g->max_gen_tokens;
+    g_v3ctx.rng_state = g_sample_seed;
+
+    HostV3Cb cb = { g, 0 };
+    UINT64 c0 = __rdtsc();
+    oosi_v3_generate(&g_v3ctx, ids, n, host_v3_token, &cb);
+    UINT64 dt = __rdtsc() - c0;
+
+    /* No prefill/decode split in the recurrent path: book it all as decode */
+    g_metrics.total_decode_cycles += dt;
+    g_metrics.total_decode_tokens += (UINT32)cb.generated;
+    g_metrics.total_decode_calls += (UINT32)cb.generated;
+    t->prompt_tokens = n;
+    t->generated = cb.generated;
+    t->decode_cycles = dt;
+    t->stop_reason = (cb.generated >= g->max_gen_tokens) ? "max_tokens" : "halt";
+    return 0;
+}
+
+/* Mirrors soma_boot's decode loop minus the UEFI-only hooks (sentinel
+ * budgets, SomaMind tick, TUI, capture mode). */
+static int host_generate_llama2(LlmkGenState *gs, const char *text, const LlmkHostGen *g, LlmkHostTurn *t) {
+    Config *c = &g_config;
+    int prompt_tokens[384];
+    int n_prompt = 0;
+    encode((char *)text, prompt_tokens, &n_prompt, 384, &g_tokenizer);
+    if (gs->pos > 0 && n_prompt > 0 && prompt_tokens[0] == llmk_tok_bos(&g_tokenizer)) {
+        for (int i = 1; i < n_prompt; i++) prompt_tokens[i - 1] = prompt_tokens[i];
+        n_prompt--;
+    }
+    if (n_prompt <= 0) return -1;
+    if (g_llmk_kvw.enabled && gs->pos + n_prompt + 1 > c->seq_len) {
+        int np = host_kvw_slide(gs->pos, n_prompt + 1);
+        if (np >= 0) gs->pos = np;
+    }
+    if (g_llmk_kvw.enabled ? (gs->pos + n_prompt + 1 > c->seq_len)
+                           : (gs->pos + n_prompt + g->max_gen_tokens > c->seq_len)) {
+        fprintf(stderr, "WARNING: context too long (%d + %d tokens), clearing KV cache\n",
+                gs->pos, n_prompt + g->max_gen_tokens);
+        llmk_host_reset();
+        if (n_prompt + 1 > c->seq_len) return -1;
+    }
+    t->prompt_tokens = n_prompt;
+    g_llmk_shortlist.verify_top1 = (g->temperature <= 0.0f);   /* greedy needs the exact argmax */
+    const int cls_full = g_llmk_cls_full;
+    if (g_grammar_on) {
+        llmk_grammar_rt_start(&g_grammar_rt, &g_grammar);
+        g_llmk_cls_full = 1;              /* allowed tokens may lie outside the shortlist */
+    }
+
+    UINT64 p0 = g_metrics.total_prefill_cycles + g_metrics.total_decode_cycles;
+    for (int i = 0; i < n_prompt; i++) {
+        llmk_kvw_note(&g_llmk_kvw, gs->pos + i, prompt_tokens[i]);
+        transformer_forward(gs->state, &g_weights, c, prompt_tokens[i], gs->pos + i);
+    }
+    t->prefill_cycles = g_metrics.total_prefill_cycles + g_metrics.total_decode_cycles - p0;
+    UINT64 d0 = g_metrics.total_decode_cycles;
+    uint64_t du0 = host_now_us();
+
+    int next = 0;
+    int token = prompt_tokens[n_prompt - 1];
+    int pos = gs->pos + n_prompt - 1;
+    int generated = 0, repeat_count = 0, last_token = -1;
+    int loop_escape_used = 0, repeat_escape_used = 0;
+    const char *stop = NULL;
+
+    /* The turn's context is the generation's penalty history */
+    llmk_gen_begin(gs);
+    llmk_gen_set(gs, g->temperature, g->min_p, g->top_p, g->top_k, g->repeat_penalty, g->freq_penalty,
+                 g->presence_penalty, g->no_repeat_ngram);
+    for (int i = 0; i < n_prompt; i++) llmk_gen_push(gs, prompt_tokens[i]);
+    int *context_tokens = gs->hist;
+    const int ctx_cap = gs->hist_cap;
+    llmk_spec_reset(&g_spec);
+    llmk_spec_sync(&g_spec, context_tokens, gs->n_hist);
+    g_turn_n = 0;
+
+    /* Speculation: logits is the row being sampled, either the state's or row
+     * spec_row - 1 of the last verified batch of spec_n positions */
+    float *logits = gs->state->logits;
+    int spec_toks[LLMK_SPEC_MAX_DRAFT + 1];
+    int spec_row = 0, spec_n = 0;
+    const int vocab = c->vocab_size;
+
+    char out_tail[64];
+    int out_tail_len = 0;
+    memset(out_tail, 0, sizeof(out_tail));
+
+    for (int step = 0; step < g->max_gen_tokens; step++) {
+        if (g_grammar_on && llmk_grammar_mask(&g_grammar_rt, logits) == 0) {
+            stop = "grammar";
+            break;
+        }
+        llmk_rep_ban(&gs->rep, logits);
+
+        for (int attempt = 0; attempt < 3; attempt++) {
+            llmk_rep_penalize(&gs->rep, logits, gs->repeat_penalty, gs->freq_penalty, gs->presence_penalty);
+            next = llmk_sample(&gs->sampler, logits, vocab, gs->temperature, gs->min_p, gs->top_p, gs->top_k,
+                               NULL, 0, 1.0f);
+            if (llmk_tok_is_stop(&g_tokenizer, next)) break;
+            if (repeat_escape_used < 8 && next == last_token && repeat_count >= 5) {
+                repeat_escape_used++;
+                logits[next] = -1.0e9f;
+                continue;
+            }
+            const int n_ctx = gs->n_hist;
+            if (loop_escape_used < 8 && n_ctx + 1 < ctx_cap) {
+                context_tokens[n_ctx] = next;
+                if (has_suffix_repeat(context_tokens, n_ctx + 1, 8) ||
+                    has_suffix_repeat(context_tokens, n_ctx + 1, 12) ||
+                    has_suffix_repeat(context_tokens, n_ctx + 1, 16)) {
+                    loop_escape_used++;
+                    logits[next] = -1.0e9f;
+                    continue;
+                }
+            }
+            break;
+        }
+        if (g_grammar_on) {
+            /* Escapes can ban the only allowed token; never leave the grammar */
+            if (!llmk_grammar_allowed(&g_grammar_rt, next)) next = llmk_grammar_best(&g_grammar_rt, logits);
+            llmk_grammar_accept(&g_grammar_rt, next);
+        }
+        if (llmk_tok_is_stop(&g_tokenizer, next)) {
+            stop = "eos/bos";
+            break;
+        }
+        if (next == last_token) {
+            repeat_count++;
+        } else {
+            repeat_count = 0;
+            last_token = next;
+        }
+
+        {
+            char out_bytes[64];
+            int out_len = llmk_tok_decode(&g_tokenizer, next, out_bytes, (int)sizeof(out_bytes));
+            if (out_len > 0) {
+                host_emit(g, out_bytes, out_len);
+                generated++;
+                for (int k = 0; k < out_len; k++) {
+                    if (out_tail_len < (int)sizeof(out_tail) - 1) {
+                        out_tail[out_tail_len++] = out_bytes[k];
+                    } else {
+                        memmove(out_tail, out_tail + 1, sizeof(out_tail) - 2);
+                        out_tail[sizeof(out_tail) - 2] = out_bytes[k];
+                    }
+                }
+                if (g->stop_on_double_nl && strstr(out_tail, "\n\n")) stop = "stop_double_nl";
+                if (g->stop_on_you && strstr(out_tail, "\nYou:")) stop = "stop_you";
+            }
+        }
+        if (gs->n_hist < ctx_cap) {
+            llmk_gen_push(gs, next);
+            llmk_spec_sync(&g_spec, context_tokens, gs->n_hist);
+        }
+        if (g_turn_n < LLMK_HOST_MAX_TOKENS) g_turn_ids[g_turn_n++] = next;
+        if (!stop && g_grammar_on && llmk_grammar_must_end(&g_grammar_rt)) stop = "grammar";
+        if (stop) break;
+
+        token = next;
+        pos++;
+        if (pos >= c->seq_len && g_llmk_kvw.enabled) {
+            int np = host_kvw_slide(pos, 1);
+            if (np >= 0) pos = np;
+            spec_n = 0;
+        }
+        if (pos >= c->seq_len) {
+            stop = "seq_len";
+            break;
+        }
+        llmk_kvw_note(&g_llmk_kvw, pos, token);
+
+        /* The sampled token is the next draft token: its logits are ready */
+        if (spec_row < spec_n && spec_toks[spec_row] == token) {
+            logits = g_spec_batch.logits + (size_t)spec_row++ * (size_t)vocab;
+            g_spec.accepted++;
+            t->spec_accepted++;
+            continue;
+        }
+        spec_n = 0;
+        int k = 0;
+        if (g_spec_k > 0 && gs->n_hist < ctx_cap && context_tokens[gs->n_hist - 1] == token) {
+            k = g_spec_k;
+            if (k > c->seq_len - 1 - pos) k = c->seq_len - 1 - pos;
+            if (k > g->max_gen_tokens - step - 2) k = g->max_gen_tokens - step - 2;
+            k = llmk_spec_propose(&g_spec, context_tokens, k, spec_toks + 1);
+        }
+        if (k > 0) {
+            spec_toks[0] = token;
+            transformer_forward_batch(gs->state, &g_weights, c, &g_spec_batch, spec_toks, k + 1, pos);
+            logits = g_spec_batch.logits;
+            spec_row = 1;
+            spec_n = k + 1;
+            t->spec_proposed += k;
+        } else {
+            transformer_forward(gs->state, &g_weights, c, token, pos);
+            logits = gs->state->logits;
+        }
+    }
+
+    g_llmk_cls_full = cls_full;
+    gs->pos = (pos + 1 < c->seq_len) ? pos + 1 : c->seq_len;
+    t->generated = generated;
+    t->decode_cycles = g_metrics.total_decode_cycles - d0;
+    t->decode_us = host_now_us() - du0;
+    t->stop_reason = stop ? stop : "max_tokens";
+    return 0;
+}
+
+int llmk_host_generate(const char *prompt, const LlmkHostGen *g, LlmkHostTurn *out) {
+    LlmkHostTurn t;
+    memset(&t, 0, sizeof(t));
+    if (g_fmt == LLMK_HOST_FMT_NONE || !prompt) return -1;
+
+    char wrapped[1024];
+    const char *text = prompt;
+    if (prompt[0] && prompt[0] != '/') {
+        text = host_chat_prompt(wrapped, (int)sizeof(wrapped), prompt, g->chat_format,
+                                g_fmt == LLMK_HOST_FMT_OOSI_V3 ? 0 : g_gen.pos);
+    }
+
+    host_bench_on_turn_start();
+    uint64_t w0 = host_now_us();
+    int rc = (g_fmt == LLMK_HOST_FMT_OOSI_V3) ? host_generate_oosi_v3(text, g, &t)
+                                               : host_generate_llama2(&g_gen, text, g, &t);
+    t.wall_us = host_now_us() - w0;
+    if (rc != 0) {
+        fprintf(stderr, "ERROR: prompt does not fit (seq_len=%d)\n", g_config.seq_len);
+        return rc;
+    }
+    g_metrics.generation_count++;
+    if (g->echo) {
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+    host_bench_on_turn_end(t.generated);
+
+    if (g->stats) {
+        uint64_t ms = t.wall_us / 1000ULL;
+        uint64_t tps_milli = t.wall_us ? ((uint64_t)t.generated * 1000000ULL * 1000ULL) / t.wall_us : 0;
+        fprintf(stderr, "[stats] tokens=%d time_ms=%llu tok_s=%llu.%03llu prompt=%d stop=%s\n",
+                t.generated, (unsigned long long)ms, (unsigned long long)(tps_milli / 1000ULL),
+                (unsigned long long)(tps_milli % 1000ULL), t.prompt_tokens, t.stop_reason);
+        if (t.spec_proposed > 0) {
+            fprintf(stderr, "[stats] spec: proposed=%d accepted=%d (%.1f%%)\n", t.spec_proposed,
+                    t.spec_accepted, 100.0 * t.spec_accepted / t.spec_proposed);
+        }
+    }
+    if (out) *out = t;
+    return 0;
+}
+
+void llmk_host_print_metrics(void) {
+    LlmkRuntimeMetrics *m = &g_metrics;
+    fprintf(stderr, "[metrics] prefill: tokens=%u cycles=%llu (%llu/tok)\n", m->total_prefill_tokens,
+            (unsigned long long)m->total_prefill_cycles,
+            (unsigned long long)(m->total_prefill_tokens ? m->total_prefill_cycles / m->total_prefill_tokens : 0));
+    fprintf(stderr, "[metrics] decode:  tokens=%u cycles=%llu (%llu/tok)\n", m->total_decode_tokens,
+            (unsigned long long)m->total_decode_cycles,
+            (unsigned long long)(m->total_decode_tokens ? m->total_decode_cycles / m->total_decode_tokens : 0));
+    fprintf(stderr, "[metrics] generations=%u kv_resets=%u\n", m->generation_count, m->kv_cache_resets);
+}
+
+/* ── Constrained decoding ────────────────────────────────────────────────── */
+
+static int host_grammar_piece(void *ctx, int id, char *out, int cap) {
+    return llmk_tok_decode((const Tokenizer *)ctx, id, out, cap);
+}
+
+static int host_grammar_stop(void *ctx, int id) {
+    return llmk_tok_is_stop((const Tokenizer *)ctx, id);
+}
+
+int llmk_host_set_grammar(int kind, const char *text) {
+    static char gbnf[32768];
+    if (kind == LLMK_HOST_GRAMMAR_OFF) {
+        g_grammar_on = 0;
+        return 0;
+    }
+    if (g_fmt != LLMK_HOST_FMT_BIN && g_fmt != LLMK_HOST_FMT_GGUF) {
+        fprintf(stderr, "ERROR: grammars need a llama2 model (.bin/.gguf)\n");
+        return -1;
+    }
+    if (kind == LLMK_HOST_GRAMMAR_JSON) {
+        text = llmk_grammar_json_gbnf();
+    } else if (kind == LLMK_HOST_GRAMMAR_SCHEMA) {
+        char err[96];
+        if (!text || llmk_grammar_from_json_schema(text, (int)strlen(text), gbnf, (int)sizeof(gbnf), err,
+                                                   (int)sizeof(err)) < 0) {
+            fprintf(stderr, "ERROR: JSON schema: %s\n", text ? err : "missing");
+            return -1;
+        }
+        text = gbnf;
+    }
+    if (!text) return -1;
+    int rc = llmk_grammar_parse(&g_grammar, text, (int)strlen(text));
+    if (rc != LLMK_GRAMMAR_OK) {
+        fprintf(stderr, "ERROR: grammar: %s\n", g_grammar.err);
+        g_grammar_on = 0;
+        return -1;
+    }
+    if (!g_grammar_mem) {
+        uint64_t bytes = llmk_grammar_rt_bytes(g_config.vocab_size, host_grammar_piece, &g_tokenizer);
+        if (posix_memalign(&g_grammar_mem, 64, (size_t)bytes) != 0) {
+            g_grammar_mem = NULL;
+            return -1;
+        }
+        if (llmk_grammar_rt_init(&g_grammar_rt, g_grammar_mem, bytes, g_config.vocab_size, host_grammar_piece,
+                                 host_grammar_stop, &g_tokenizer) != LLMK_GRAMMAR_OK) {
+            free(g_grammar_mem);
+            g_grammar_mem = NULL;
+            return -1;
+        }
+    }
+    llmk_grammar_rt_start(&g_grammar_rt, &g_grammar);
+    g_grammar_on = 1;
+    return 0;
+}
+
+int llmk_host_load_grammar(int kind, const char *path) {
+    HostMap m;
+    if (host_map_file(&m, path) != 0) {
+        fprintf(stderr, "ERROR: cannot open %s\n", path);
+        return -1;
+    }
+    char *text = (char *)malloc((size_t)m.size + 1);
+    if (!text) {
+        host_unmap(&m);
+        return -1;
+    }
+    memcpy(text, m.base, (size_t)m.size);
+    text[m.size] = 0;
+    host_unmap(&m);
+    int rc = llmk_host_set_grammar(kind, text);
+    free(text);
+    return rc;
+}
+
+void llmk_host_grammar_print(void) {
+    const LlmkGrammarRt *rt = &g_grammar_rt;
+    if (!g_grammar_on) {
+        fprintf(stderr, "[grammar] off\n");
+        return;
+    }
+    fprintf(stderr, "[grammar] rules=%d trie_nodes=%d masks=%llu cache_hits=%llu nodes_visited=%llu\n",
+            g_grammar.n_rules, rt->n_nodes, (unsigned long long)rt->masks, (unsigned long long)rt->cache_hits,
+            (unsigned long long)rt->nodes_visited);
+}
+
+/* ── Classifier shortlist ────────────────────────────────────────────────── */
+
+static void host_cls_row(void *ctx, uint32_t r, float *out) {
+    (void)ctx;
+    if (g_weights.kind == 1) {
+        llmk_dequantize_q8_0_row(out, g_weights.wcls_q8 + (UINTN)r * (UINTN)g_weights.tok_embd_row_bytes,
+                                 g_config.dim);
+    } else {
+        memcpy(out, g_weights.wcls + (size_t)r * (size_t)g_config.dim, sizeof(float) * (size_t)g_config.dim);
+    }
+}
+
+static int host_sl_model_ok(void) {
+    if (g_fmt != LLMK_HOST_FMT_BIN && g_fmt != LLMK_HOST_FMT_GGUF) {
+        fprintf(stderr, "ERROR: the classifier shortlist needs a llama2 model (.bin/.gguf)\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int host_sl_attach(void *file, uint64_t len, int n_cand) {
+    LlmkShortlist sl;
+    if (llmk_sl_parse(&sl, file, len) != LLMK_SL_OK) {
+        fprintf(stderr, "ERROR: not a valid .lksl file\n");
+        return -1;
+    }
+    if (sl.vocab != (uint32_t)g_config.vocab_size || sl.dim != (uint32_t)g_config.dim) {
+        fprintf(stderr, "ERROR: shortlist is %ux%u, model classifier is %dx%d\n", sl.vocab, sl.dim,
+                g_config.vocab_size, g_config.dim);
+        return -1;
+    }
+    uint32_t max_cand = sl.vocab < 1024u ? sl.vocab : 1024u;
+    uint64_t sb = llmk_sl_scratch_bytes(sl.vocab, sl.rank, max_cand);
+    void *scratch = NULL;
+    if (posix_memalign(&scratch, 64, (size_t)sb) != 0) return -1;
+    if (llmk_sl_attach_scratch(&sl, scratch, sb, max_cand) != LLMK_SL_OK) {
+        free(scratch);
+        return -1;
+    }
+    free(g_sl_file);
+    free(g_sl_scratch);
+    g_sl_file = file;
+    g_sl_scratch = scratch;
+    sl.n_cand = n_cand > 0 ? (uint32_t)n_cand : 256u;
+    if (sl.n_cand > max_cand) sl.n_cand = max_cand;
+    sl.enabled = 1;
+    g_llmk_shortlist = sl;
+    return 0;
+}
+
+int llmk_host_shortlist_build(const char *out_path, int rank, int iters) {
+    if (!host_sl_model_ok()) return -1;
+    if (rank <= 0) rank = 64;
+    if (rank > LLMK_SL_MAX_RANK || rank > g_config.dim) {
+        fprintf(stderr, "ERROR: shortlist rank must be 1..%d\n",
+                g_config.dim < LLMK_SL_MAX_RANK ? g_config.dim : LLMK_SL_MAX_RANK);
+        return -1;
+    }
+    void *buf = NULL;
+    uint64_t len = 0;
+    LlmkSlBuildStats st;
+    uint64_t t0 = host_now_us();
+    int rc = llmk_sl_build(host_cls_row, NULL, (uint32_t)g_config.vocab_size, (uint32_t)g_config.dim,
+                           (uint32_t)rank, iters, g_sample_seed, &buf, &len, &st);
+    if (rc != 0) {
+        fprintf(stderr, "ERROR: shortlist build failed (%d)\n", rc);
+        return -1;
+    }
+    fprintf(stderr, "[shortlist] rank=%d iters=%d resid mean=%.4f max=%.4f (%llu KB, %llu ms)\n", rank, iters,
+            st.mean_rel_resid, st.max_rel_resid, (unsigned long long)(len >> 10),
+            (unsigned long long)((host_now_us() - t0) / 1000ULL));
+    if (out_path) {
+        FILE *f = fopen(out_path, "wb");
+        if (!f || fwrite(buf, 1, (size_t)len, f) != (size_t)len) {
+            fprintf(stderr, "ERROR: cannot write %s\n", out_path);
+            if (f) fclose(f);
+            free(buf);
+            return -1;
+        }
+        fclose(f);
+    }
+    if (host_sl_attach(buf, len, 0) != 0) {
+        free(buf);
+        return -1;
+    }
+    return 0;
+}
+
+int llmk_host_shortlist_load(const char *path, int n_cand) {
+    if (!host_sl_model_ok()) return -1;
+    HostMap m;
+    if (host_map_file(&m, path) != 0) {
+        fprintf(stderr, "ERROR: cannot open %s\n", path);
+        return -1;
+    }
+    void *buf = NULL;
+    if (posix_memalign(&buf, 64, (size_t)m.size) != 0) {
+        host_unmap(&m);
+        return -1;
+    }
+    memcpy(buf, m.base, (size_t)m.size);
+    uint64_t len = m.size;
+    host_unmap(&m);
+    if (host_sl_attach(buf, len, n_cand) != 0) {
+        free(buf);
+        return -1;
+    }
+    return 0;
+}
+
+void llmk_host_shortlist_enable(int on) {
+    g_llmk_shortlist.enabled = (on && g_llmk_shortlist.coef) ? 1 : 0;
+}
+
+void llmk_host_shortlist_set_k(int n_cand) {
+    LlmkShortlist *sl = &g_llmk_shortlist;
+    if (!sl->coef || n_cand <= 0) return;
+    sl->n_cand = (uint32_t)n_cand < sl->max_cand ? (uint32_t)n_cand : sl->max_cand;
+}
+
+void llmk_host_shortlist_print(void) {
+    const LlmkShortlist *sl = &g_llmk_shortlist;
+    if (!sl->coef) {
+        fprintf(stderr, "[shortlist] not loaded\n");
+        return;
+    }
+    fprintf(stderr, "[shortlist] enabled=%d rank=%u k=%u/%u calls=%llu certified=%llu fallbacks=%llu\n",
+            sl->enabled, sl->rank, sl->n_cand, sl->vocab, (unsigned long long)sl->calls,
+            (unsigned long long)sl->certified, (unsigned long long)sl->fallbacks);
+}
+
+static int host_argmax(const float *v, int n) {
+    int best = 0;
+    for (int i = 1; i < n; i++) {
+        if (v[i] > v[best]) best = i;
+    }
+    return best;
+}
+
+/* Plain greedy decode (no penalties) after prefilling `prompt`. With `e`
+ * set, the forward runs the full classifier and every step is scored against
+ * the shortlist (teacher forcing). Returns decode wall time in µs. */
+static uint64_t host_sl_greedy(const int *prompt, int n_prompt, int n, int *out, LlmkHostSlEval *e) {
+    llmk_host_reset();
+    for (int i = 0; i < n_prompt; i++) transformer_forward(&g_state, &g_weights, &g_config, prompt[i], i);
+    uint64_t t0 = host_now_us();
+    for (int step = 0; step < n; step++) {
+        int tok = host_argmax(g_state.logits, g_config.vocab_size);
+        if (e) {
+            int cert = llmk_classifier_shortlist(&g_state, &g_weights, &g_config);
+            e->agree += host_argmax(g_state.logits, g_config.vocab_size) == tok;
+            e->certified += cert;
+            e->steps++;
+        }
+        out[step] = tok;
+        if (step + 1 < n) transformer_forward(&g_state, &g_weights, &g_config, tok, n_prompt + step);
+    }
+    return host_now_us() - t0;
+}
+
+int llmk_host_shortlist_eval(const char *prompt, int n_tokens, LlmkHostSlEval *out) {
+    LlmkShortlist *sl = &g_llmk_shortlist;
+    LlmkHostSlEval e;
+    memset(&e, 0, sizeof(e));
+    if (!host_sl_model_ok() || !sl->coef || !prompt) return -1;
+
+    int toks[384];
+    int n_prompt = 0;
+    encode((char *)prompt, toks, &n_prompt, 384, &g_tokenizer);
+    if (n_prompt <= 0) return -1;
+    int n = n_tokens > 0 ? n_tokens : 128;
+    if (n > LLMK_HOST_MAX_TOKENS) n = LLMK_HOST_MAX_TOKENS;
+    if (n_prompt + n > g_config.seq_len) n = g_config.seq_len - n_prompt;
+    if (n <= 0) return -1;
+
+    int ref[LLMK_HOST_MAX_TOKENS], got[LLMK_HOST_MAX_TOKENS];
+    const int was_enabled = sl->enabled, was_verify = sl->verify_top1;
+
+    /* Agreement: shortlist top-1 vs full top-1 on the full-classifier path */
+    g_llmk_cls_full = 1;
+    sl->verify_top1 = 1;
+    host_sl_greedy(toks, n_prompt, n, ref, &e);
+
+    /* Speed: full classifier, then shortlist with and without verification */
+    uint64_t us_full = host_sl_greedy(toks, n_prompt, n, ref, NULL);
+    g_llmk_cls_full = 0;
+    sl->enabled = 1;
+    uint64_t us_exact = host_sl_greedy(toks, n_prompt, n, got, NULL);
+    e.identical = memcmp(ref, got, sizeof(int) * (size_t)n) == 0;
+    sl->verify_top1 = 0;
+    uint64_t us_fast = host_sl_greedy(toks, n_prompt, n, got, NULL);
+
+    sl->enabled = was_enabled;
+    sl->verify_top1 = was_verify;
+    llmk_host_reset();
+
+    e.tok_s_full = us_full ? (double)n * 1.0e6 / (double)us_full : 0.0;
+    e.tok_s_exact = us_exact ? (double)n * 1.0e6 / (double)us_exact : 0.0;
+    e.tok_s_fast = us_fast ? (double)n * 1.0e6 / (double)us_fast : 0.0;
+    fprintf(stderr, "[shortlist] rank=%u k=%u steps=%d top1_agree=%.2f%% certified=%.2f%% greedy_identical=%s\n",
+            sl->rank, sl->n_cand, e.steps, e.steps ? 100.0 * e.agree / e.steps : 0.0,
+            e.steps ? 100.0 * e.certified / e.steps : 0.0, e.identical ? "yes" : "no");
+    fprintf(stderr, "[shortlist] decode tok/s: full=%.1f shortlist+verify=%.1f shortlist=%.1f\n", e.tok_s_full,
+            e.tok_s_exact, e.tok_s_fast);
+    if (out) *out = e;
+    return 0;
+}
+
+/* ── Mixed-precision plans ───────────────────────────────────────────────── */
+
+static const char *const k_mx_role_names[LLMK_MX_ROLES] = { "wq", "wk", "wv", "wo", "w1", "w2", "w3" };
+
+static int host_mx_model_ok(void) {
+    if (g_fmt != LLMK_HOST_FMT_BIN && g_fmt != LLMK_HOST_FMT_GGUF) {
+        fprintf(stderr, "ERROR: mixed-precision plans need a llama2 model (.bin/.gguf)\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int host_mx_dims(LlmkMixq *mx, int shared_cls) {
+    const Config *c = &g_config;
+    return llmk_mx_init(mx, (uint32_t)c->dim, (uint32_t)c->hidden_dim, (uint32_t)c->n_layers, (uint32_t)c->n_heads,
+                        (uint32_t)c->n_kv_heads, (uint32_t)c->vocab_size, shared_cls ? 1u : 0u);
+}
+
+static void host_mx_name(char *out, size_t cap, uint32_t i) {
+    const uint32_t tok = (uint32_t)g_config.n_layers * LLMK_MX_ROLES;
+    if (i == tok) snprintf(out, cap, "tok_emb");
+    else if (i == tok + 1) snprintf(out, cap, "cls");
+    else snprintf(out, cap, "L%u.%s", i / LLMK_MX_ROLES, k_mx_role_names[i % LLMK_MX_ROLES]);
+}
+
+/* Row r of matrix i (llmk_mixq.h numbering) in the f32 base weights */
+static const float *host_mx_base_row(uint32_t i, uint32_t r) {
+    const uint64_t D = (uint64_t)g_config.dim, H = (uint64_t)g_config.hidden_dim;
+    const uint64_t KV = D * (uint64_t)g_config.n_kv_heads / (uint64_t)g_config.n_heads;
+    const uint32_t tok = (uint32_t)g_config.n_layers * LLMK_MX_ROLES;
+    if (i == tok) return g_weights.token_embedding_table + r * D;
+    if (i == tok + 1) return g_weights.wcls + r * D;
+    const uint64_t l = i / LLMK_MX_ROLES;
+    switch (i % LLMK_MX_ROLES) {
+    case LLMK_MX_WQ: return g_weights.wq + (l * D + r) * D;
+    case LLMK_MX_WK: return g_weights.wk + (l * KV + r) * D;
+    case LLMK_MX_WV: return g_weights.wv + (l * KV + r) * D;
+    case LLMK_MX_WO: return g_weights.wo + (l * D + r) * D;
+    case LLMK_MX_W1: return g_weights.w1 + (l * H + r) * D;
+    case LLMK_MX_W2: return g_weights.w2 + (l * D + r) * H;
+    default:         return g_weights.w3 + (l * H + r) * D;
+    }
+}
+
+static void host_mx_row(void *ctx, uint32_t i, uint32_t r, float *out) {
+    uint32_t rows = 0, cols = 0;
+    llmk_mx_shape((const LlmkMixq *)ctx, i, &rows, &cols);
+    memcpy(out, host_mx_base_row(i, r), sizeof(float) * cols);
+}
+
+/* Every matrix as an f32 view of the base weights */
+static void host_mx_probe(LlmkMixq *mx, int shared_cls) {
+    host_mx_dims(mx, shared_cls);
+    for (uint32_t i = 0; i < mx->n_tensors; i++) {
+        LlmkMxTensor *t = &mx->t[i];
+        llmk_mx_shape(mx, i, &t->rows, &t->cols);
+        t->fmt = LLMK_MX_F32;
+        t->row_bytes = (uint64_t)t->cols * 4u;
+        t->data = (const uint8_t *)host_mx_base_row(i, 0);
+    }
+}
+
+/* Quantizes the base weights with fmt[n_tensors] into a parsed image */
+static int host_mx_make(const uint32_t *fmt, int shared_cls, LlmkMixq *mx, void **buf, uint64_t *len) {
+    host_mx_dims(mx, shared_cls);
+    int rc = llmk_mx_build(mx, fmt, host_mx_row, mx, buf, len);
+    if (rc != 0) return rc;
+    if (llmk_mx_parse(mx, *buf, *len) != LLMK_MX_OK) {
+        free(*buf);
+        *buf = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void host_log_softmax(const float *x, float *out, int n) {
+    float m = x[0];
+    for (int i = 1; i < n; i++) {
+        if (x[i] > m) m = x[i];
+    }
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += exp((double)(x[i] - m));
+    const float lse = m + (float)log(sum);
+    for (int i = 0; i < n; i++) out[i] = x[i] - lse;
+}
+
+typedef struct {
+    const int *toks;
+    int        n;
+    float     *ref_lp;                /* [n][vocab] log-softmax of the f32 model */
+    float     *ref_p;                 /* [n][vocab] its probabilities */
+    float     *lp;                    /* [vocab] */
+} HostMxCalib;
+
+/* Teacher-forced pass over the calibration tokens with g_weights.mx = mx
+ * (NULL = base weights): mean KL(f32 ‖ mx) per position and mean NLL of the
+ * next token. save: the pass becomes the f32 reference instead. */
+static void host_mx_run(HostMxCalib *c, const LlmkMixq *mx, int save, double *kl, double *nll) {
+    const size_t V = (size_t)g_config.vocab_size;
+    const struct LlmkMixq *was = g_weights.mx;
+    const int was_full = g_llmk_cls_full;
+    double s_kl = 0.0, s_nll = 0.0;
+    g_weights.mx = mx;
+    g_llmk_cls_full = 1;
+    llmk_host_reset();
+    for (int p = 0; p < c->n; p++) {
+        transformer_forward(&g_state, &g_weights, &g_config, c->toks[p], p);
+        float *lp = save ? c->ref_lp + (size_t)p * V : c->lp;
+        host_log_softmax(g_state.logits, lp, (int)V);
+        if (save) {
+            for (size_t v = 0; v < V; v++) c->ref_p[(size_t)p * V + v] = expf(lp[v]);
+        } else {
+            const float *rl = c->ref_lp + (size_t)p * V, *rp = c->ref_p + (size_t)p * V;
+            double k = 0.0;
+            for (size_t v = 0; v < V; v++) k += (double)rp[v] * (double)(rl[v] - lp[v]);
+            s_kl += k;
+        }
+        if (p + 1 < c->n) s_nll -= lp[c->toks[p + 1]];
+    }
+    g_weights.mx = was;
+    g_llmk_cls_full = was_full;
+    llmk_host_reset();
+    if (kl) *kl = s_kl / c->n;
+    if (nll) *nll = s_nll / (c->n - 1);
+}
+
+/* Calibration error of every matrix in every format, the others left f32 */
+static int host_mx_calibrate(HostMxCalib *c, LlmkMixq *probe, LlmkMxCost *cost, uint32_t n_plan) {
+    const uint32_t tok = probe->n_layers * LLMK_MX_ROLES;
+    uint64_t max_bytes = 0;
+    for (uint32_t i = 0; i < n_plan; i++) {
+        const uint64_t b = (uint64_t)probe->t[i].rows * llmk_mx_row_bytes(LLMK_MX_F16, probe->t[i].cols);
+        if (b > max_bytes) max_bytes = b;
+    }
+    void *q = NULL;
+    if (posix_memalign(&q, 64, (size_t)max_bytes) != 0) return -1;
+
+    for (uint32_t i = 0; i < n_plan; i++) {
+        const LlmkMxTensor keep = probe->t[i];
+        LlmkMxCost *ci = &cost[i];
+        memset(ci, 0, sizeof(*ci));
+        ci->bytes[LLMK_MX_F32] = (uint64_t)keep.rows * keep.row_bytes;
+        for (uint32_t f = LLMK_MX_F16; f < LLMK_MX_N_FMT; f++) {
+            const uint64_t rb = llmk_mx_row_bytes(f, keep.cols);
+            if (rb == 0) continue;
+            for (uint32_t r = 0; r < keep.rows; r++) {
+                llmk_mx_quantize_row(f, host_mx_base_row(i, r), keep.cols, (uint8_t *)q + (uint64_t)r * rb);
+            }
+            probe->t[i].data = (const uint8_t *)q;
+            probe->t[i].fmt = f;
+            probe->t[i].row_bytes = rb;
+            if (probe->shared_cls && i == tok) probe->t[tok + 1] = probe->t[i];
+            host_mx_run(c, probe, 0, &ci->err[f], NULL);
+            ci->bytes[f] = (uint64_t)keep.rows * rb;
+        }
+        probe->t[i] = keep;
+        if (probe->shared_cls && i == tok) probe->t[tok + 1] = keep;
+    }
+    free(q);
+    return 0;
+}
+
+static uint64_t host_mx_budget(const char *s, uint64_t bytes_f32, uint64_t dflt) {
+    if (!s || !*s) return dflt;
+    char *end = NULL;
+    double v = strtod(s, &end);
+    if (end == s || v <= 0.0) return 0;
+    if (*end == '%') return (uint64_t)((double)bytes_f32 * v / 100.0);
+    return (uint64_t)(v * 1048576.0);
+}
+
+static void host_mx_count(const uint32_t *fmt, uint32_t n, int *n_fmt) {
+    for (uint32_t f = 0; f < LLMK_MX_N_FMT; f++) n_fmt[f] = 0;
+    for (uint32_t i = 0; i < n; i++) n_fmt[fmt[i]]++;
+}
+
+static void host_mx_pareto_row(const char *label, uint64_t bytes, uint64_t bytes_f32, double ppl, double kl,
+                               const int *n_fmt) {
+    fprintf(stderr, "  %-10s %9.3f %6.1f %10.4f %10.6f  %4d %4d %4d %4d\n", label, (double)bytes / 1048576.0,
+            100.0 * (double)bytes / (double)bytes_f32, ppl, kl, n_fmt[LLMK_MX_F32], n_fmt[LLMK_MX_F16],
+            n_fmt[LLMK_MX_Q8_0], n_fmt[LLMK_MX_Q4_0]);
+}
+
+/* Size vs perplexity: the uniform formats, then plans on a geometric ladder
+ * of budgets from the smallest plan to f32 */
+static void host_mx_pareto(HostMxCalib *c, const LlmkMxCost *cost, uint32_t n_plan, int shared_cls,
+                           LlmkHostMixqReport *rep) {
+    const uint32_t n_tensors = (uint32_t)g_config.n_layers * LLMK_MX_ROLES + 2u;
+    const uint32_t tok = n_tensors - 2u;
+    static const uint32_t uniform[] = { LLMK_MX_Q4_0, LLMK_MX_Q8_0, LLMK_MX_F16, LLMK_MX_F32 };
+    uint64_t s_min = 0, s_max = 0;
+    for (uint32_t i = 0; i < n_plan; i++) {
+        uint64_t m = cost[i].bytes[LLMK_MX_F32];
+        for (uint32_t f = 0; f < LLMK_MX_N_FMT; f++) {
+            if (cost[i].bytes[f] && cost[i].bytes[f] < m) m = cost[i].bytes[f];
+        }
+        s_min += m;
+        s_max += cost[i].bytes[LLMK_MX_F32];
+    }
+    LlmkMixq *mx = (LlmkMixq *)malloc(sizeof(*mx));
+    uint32_t *fmt = (uint32_t *)calloc(n_tensors, sizeof(uint32_t));
+    if (!mx || !fmt) {
+        free(mx);
+        free(fmt);
+        return;
+    }
+    fprintf(stderr, "[mixq] pareto, perplexity over the %d calibration tokens:\n", c->n);
+    fprintf(stderr, "  %-10s %9s %6s %10s %10s  %4s %4s %4s %4s\n", "plan", "MiB", "%f32", "ppl", "kl", "f32", "f16",
+            "q8_0", "q4_0");
+
+    int n_fmt[LLMK_MX_N_FMT];
+    for (unsigned u = 0; u < sizeof(uniform) / sizeof(uniform[0]); u++) {
+        uint64_t bytes = 0;
+        uint32_t i = 0;
+        for (; i < n_plan && cost[i].bytes[uniform[u]]; i++) {
+            fmt[i] = uniform[u];
+            bytes += cost[i].bytes[uniform[u]];
+        }
+        if (i < n_plan) continue;
+        fmt[tok + 1] = fmt[tok];
+        void *buf = NULL;
+        uint64_t len = 0;
+        double kl = 0.0, nll = 0.0;
+        if (host_mx_make(fmt, shared_cls, mx, &buf, &len) != 0) continue;
+        host_mx_run(c, mx, 0, &kl, &nll);
+        free(buf);
+        host_mx_count(fmt, n_plan, n_fmt);
+        host_mx_pareto_row(llmk_mx_fmt_name(uniform[u]), bytes, s_max, exp(nll), kl, n_fmt);
+    }
+
+    for (int k = 0; k < LLMK_HOST_MIXQ_PARETO; k++) {
+        const double t = (double)k / (double)(LLMK_HOST_MIXQ_PARETO - 1);
+        const uint64_t budget = (k == LLMK_HOST_MIXQ_PARETO - 1) ? s_max
+                              : (uint64_t)((double)s_min * pow((double)s_max / (double)s_min, t));
+        const uint64_t bytes = llmk_mx_plan(cost, n_plan, budget, fmt);
+        if (!bytes) continue;
+        fmt[tok + 1] = fmt[tok];
+        void *buf = NULL;
+        uint64_t len = 0;
+        double kl = 0.0, nll = 0.0;
+        if (host_mx_make(fmt, shared_cls, mx, &buf, &len) != 0) continue;
+        host_mx_run(c, mx, 0, &kl, &nll);
+        free(buf);
+        host_mx_count(fmt, n_plan, n_fmt);
+        host_mx_pareto_row("mixed", bytes, s_max, exp(nll), kl, n_fmt);
+        rep->pareto_bytes[rep->n_pareto] = bytes;
+        rep->pareto_ppl[rep->n_pareto] = exp(nll);
+        rep->pareto_kl[rep->n_pareto] = kl;
+        rep->n_pareto++;
+    }
+    free(mx);
+    free(fmt);
+}
+
+int llmk_host_mixq_plan(const char *out_path, const char *calib_text, int n_tokens, const char *budget,
+                        int pareto, LlmkHostMixqReport *out) {
+    LlmkHostMixqReport rep;
+    memset(&rep, 0, sizeof(rep));
+    if (!host_mx_model_ok()) return -1;
+    if (g_weights.kind != 0) {
+        fprintf(stderr, "ERROR: planning needs f32 weights (.bin, or .gguf without --q8-blob)\n");
+        return -1;
+    }
+    if (g_config.n_layers > (int)LLMK_MX_MAX_LAYERS) {
+        fprintf(stderr, "ERROR: mixed-precision plans support up to %u layers\n", LLMK_MX_MAX_LAYERS);
+        return -1;
+    }
+    if (!calib_text || !*calib_text) {
+        fprintf(stderr, "ERROR: planning needs a calibration text (--mixq-calib)\n");
+        return -1;
+    }
+
+    const int cap = (int)strlen(calib_text) + 3;
+    const size_t V = (size_t)g_config.vocab_size;
+    const int shared = (g_weights.wcls == g_weights.token_embedding_table);
+    int *toks = (int *)malloc(sizeof(int) * (size_t)cap);
+    LlmkMixq *probe = (LlmkMixq *)malloc(sizeof(*probe));
+    LlmkMixq *mx = (LlmkMixq *)malloc(sizeof(*mx));
+    HostMxCalib c;
+    memset(&c, 0, sizeof(c));
+    LlmkMxCost *cost = NULL;
+    uint32_t *fmt = NULL;
+    void *buf = NULL;
+    uint64_t len = 0;
+    int rc = -1;
+    if (!toks || !probe || !mx) goto done;
+
+    int nt = 0;
+    encode((char *)calib_text, toks, &nt, cap, &g_tokenizer);
+    c.toks = toks;
+    c.n = n_tokens > 0 ? n_tokens : 64;
+    if (c.n > nt) c.n = nt;
+    if (c.n > g_config.seq_len) c.n = g_config.seq_len;
+    if (c.n < 2) {
+        fprintf(stderr, "ERROR: calibration text is too short (%d tokens)\n", nt);
+        goto done;
+    }
+    host_mx_probe(probe, shared);
+    const uint32_t n_plan = probe->n_tensors - (shared ? 1u : 0u);
+    const uint32_t tok = probe->n_layers * LLMK_MX_ROLES;
+    c.ref_lp = (float *)malloc(sizeof(float) * V * (size_t)c.n);
+    c.ref_p = (float *)malloc(sizeof(float) * V * (size_t)c.n);
+    c.lp = (float *)malloc(sizeof(float) * V);
+    cost = (LlmkMxCost *)calloc(n_plan, sizeof(LlmkMxCost));
+    fmt = (uint32_t *)calloc(probe->n_tensors, sizeof(uint32_t));
+    if (!c.ref_lp || !c.ref_p || !c.lp || !cost || !fmt) goto done;
+
+    const uint64_t t0 = host_now_us();
+    double nll = 0.0;
+    host_mx_run(&c, NULL, 1, NULL, &nll);
+    rep.ppl_f32 = exp(nll);
+    if (host_mx_calibrate(&c, probe, cost, n_plan) != 0) goto done;
+    rep.tokens = c.n;
+    rep.tensors = (int)n_plan;
+    fprintf(stderr, "[mixq] calibrated %u matrices x 3 formats on %d tokens (%llu ms), f32 ppl=%.4f\n", n_plan,
+            c.n, (unsigned long long)((host_now_us() - t0) / 1000ULL), rep.ppl_f32);
+
+    uint64_t dflt = 0;
+    for (uint32_t i = 0; i < n_plan; i++) {
+        rep.bytes_f32 += cost[i].bytes[LLMK_MX_F32];
+        dflt += cost[i].bytes[LLMK_MX_Q8_0] ? cost[i].bytes[LLMK_MX_Q8_0] : cost[i].bytes[LLMK_MX_F16];
+    }
+    rep.budget = host_mx_budget(budget, rep.bytes_f32, dflt);
+    rep.bytes = rep.budget ? llmk_mx_plan(cost, n_plan, rep.budget, fmt) : 0;
+    if (!rep.bytes) {
+        fprintf(stderr, "ERROR: budget %s is below the smallest plan or not a size (<MiB> or <pct>%%)\n",
+                budget ? budget : "(default)");
+        goto done;
+    }
+    fmt[tok + 1] = fmt[tok];
+    host_mx_count(fmt, n_plan, rep.n_fmt);
+
+    fprintf(stderr, "  %-10s %11s %11s %11s  plan\n", "matrix", "kl f16", "kl q8_0", "kl q4_0");
+    for (uint32_t i = 0; i < n_plan; i++) {
+        char name[32], e[3][16];
+        host_mx_name(name, sizeof(name), i);
+        for (uint32_t f = LLMK_MX_F16; f < LLMK_MX_N_FMT; f++) {
+            if (cost[i].bytes[f]) snprintf(e[f - 1], sizeof(e[0]), "%.6f", cost[i].err[f]);
+            else snprintf(e[f - 1], sizeof(e[0]), "-");
+        }
+        fprintf(stderr, "  %-10s %11s %11s %11s  %s\n", name, e[0], e[1], e[2], llmk_mx_fmt_name(fmt[i]));
+        rep.est_kl += cost[i].err[fmt[i]];
+    }
+
+    if (host_mx_make(fmt, shared, mx, &buf, &len) != 0) goto done;
+    host_mx_run(&c, mx, 0, &rep.kl, &nll);
+    rep.ppl = exp(nll);
+    fprintf(stderr, "[mixq] plan: %.3f MiB of %.3f budget (%.1f%% of f32) f32=%d f16=%d q8_0=%d q4_0=%d\n",
+            (double)rep.bytes / 1048576.0, (double)rep.budget / 1048576.0,
+            100.0 * (double)rep.bytes / (double)rep.bytes_f32, rep.n_fmt[LLMK_MX_F32], rep.n_fmt[LLMK_MX_F16],
+            rep.n_fmt[LLMK_MX_Q8_0], rep.n_fmt[LLMK_MX_Q4_0]);
+    fprintf(stderr, "[mixq] kl est=%.6f measured=%.6f ppl=%.4f (f32 %.4f)\n", rep.est_kl, rep.kl, rep.ppl,
+            rep.ppl_f32);
+
+    if (out_path) {
+        FILE *f = fopen(out_path, "wb");
+        if (!f || fwrite(buf, 1, (size_t)len, f) != (size_t)len) {
+            fprintf(stderr, "ERROR: cannot write %s\n", out_path);
+            if (f) fclose(f);
+            goto done;
+        }
+        fclose(f);
+    }
+    if (pareto) host_mx_pareto(&c, cost, n_plan, shared, &rep);
+
+    free(g_mx_file);
+    g_mx_file = buf;
+    buf = NULL;
+    g_llmk_mixq = *mx;
+    g_weights.mx = &g_llmk_mixq;
+    rc = 0;
+
+done:
+    free(buf);
+    free(toks);
+    free(probe);
+    free(mx);
+    free(c.ref_lp);
+    free(c.ref_p);
+    free(c.lp);
+    free(cost);
+    free(fmt);
+    if (out) *out = rep;
+    return rc;
+}
+
+static int host_mx_attach(void *file, uint64_t len) {
+    LlmkMixq *mx = (LlmkMixq *)malloc(sizeof(*mx));
+    if (!mx) return -1;
+    if (llmk_mx_parse(mx, file, len) != LLMK_MX_OK) {
+        fprintf(stderr, "ERROR: not a valid .lkmx file\n");
+        free(mx);
+        return -1;
+    }
+    const Config *c = &g_config;
+    if (mx->dim != (uint32_t)c->dim || mx->hidden_dim != (uint32_t)c->hidden_dim ||
+        mx->n_layers != (uint32_t)c->n_layers || mx->n_heads != (uint32_t)c->n_heads ||
+        mx->n_kv_heads != (uint32_t)c->n_kv_heads || mx->vocab != (uint32_t)c->vocab_size) {
+        fprintf(stderr, "ERROR: plan is for dim=%u hidden=%u layers=%u heads=%u/%u vocab=%u, model differs\n",
+                mx->dim, mx->hidden_dim, mx->n_layers, mx->n_heads, mx->n_kv_heads, mx->vocab);
+        free(mx);
+        return -1;
+    }
+    free(g_mx_file);
+    g_mx_file = file;
+    g_llmk_mixq = *mx;
+    g_weights.mx = &g_llmk_mixq;
+    free(mx);
+    return 0;
+}
+
+int llmk_host_mixq_load(const char *path) {
+    if (!host_mx_model_ok()) return -1;
+    HostMap m;
+    if (host_map_file(&m, path) != 0) {
+        fprintf(stderr, "ERROR: cannot open %s\n", path);
+        return -1;
+    }
+    void *buf = NULL;
+    if (posix_memalign(&buf, 64, (size_t)m.size) != 0) {
+        host_unmap(&m);
+        return -1;
+    }
+    memcpy(buf, m.base, (size_t)m.size);
+    uint64_t len = m.size;
+    host_unmap(&m);
+    if (host_mx_attach(buf, len) != 0) {
+        free(buf);
+        return -1;
+    }
+    return 0;
+}
+
+void llmk_host_mixq_enable(int on) {
+    g_weights.mx = (on && g_mx_file) ? &g_llmk_mixq : NULL;
+}
+
+void llmk_host_mixq_print(void) {
+    const LlmkMixq *mx = &g_llmk_mixq;
+    if (!g_mx_file) {
+        fprintf(stderr, "[mixq] not loaded\n");
+        return;
+    }
+    int n_fmt[LLMK_MX_N_FMT] = { 0 };
+    const uint32_t n = mx->n_tensors - mx->shared_cls;
+    for (uint32_t i = 0; i < n; i++) n_fmt[mx->t[i].fmt]++;
+    const uint64_t bytes = llmk_mx_bytes(mx), f32 = llmk_mx_bytes_uniform(mx, LLMK_MX_F32);
+    fprintf(stderr, "[mixq] %s f32=%d f16=%d q8_0=%d q4_0=%d matrices=%.3f MiB (%.1f%% of f32)\n",
+            g_weights.mx ? "on" : "off", n_fmt[LLMK_MX_F32], n_fmt[LLMK_MX_F16], n_fmt[LLMK_MX_Q8_0],
+            n_fmt[LLMK_MX_Q4_0], (double)bytes / 1048576.0, f32 ? 100.0 * (double)bytes / (double)f32 : 0.0);
+}
+
+/* ── Speculative decoding ────────────────────────────────────────────────── */
+
+void llmk_host_set_spec(int k) {
+    g_spec_k = k < 0 ? 0 : (k > LLMK_SPEC_MAX_DRAFT ? LLMK_SPEC_MAX_DRAFT : k);
+}
+
+int llmk_host_spec(void) { return g_spec_k; }
+
+void llmk_host_spec_print(void) {
+    const LlmkSpec *sp = &g_spec;
+    fprintf(stderr, "[spec] k=%d ngram=%d..%d drafts=%llu proposed=%llu accepted=%llu (%.1f%%)\n", g_spec_k,
+            sp->min_ngram, sp->max_ngram, (unsigned long long)sp->drafts, (unsigned long long)sp->proposed,
+            (unsigned long long)sp->accepted, sp->proposed ? 100.0 * (double)sp->accepted / (double)sp->proposed : 0.0);
+}
+
+/* One raw-prompt turn from an empty cache with the sampler reseeded */
+static int host_spec_turn(const char *prompt, const LlmkHostGen *g, unsigned int seed, LlmkHostTurn *t) {
+    memset(t, 0, sizeof(*t));
+    llmk_host_reset();
+    llmk_gen_seed(&g_gen, seed);
+    return host_generate_llama2(&g_gen, prompt, g, t);
+}
+
+int llmk_host_spec_eval(const char *prompt, const LlmkHostGen *g, int k, LlmkHostSpecEval *out) {
+    LlmkHostSpecEval e;
+    memset(&e, 0, sizeof(e));
+    if (g_fmt != LLMK_HOST_FMT_BIN && g_fmt != LLMK_HOST_FMT_GGUF) return -1;
+    if (!prompt || !g) return -1;
+
+    LlmkHostGen gq = *g;
+    gq.echo = 0;
+    const unsigned int seed = g_gen.sampler.seed;
+    const int was_k = g_spec_k;
+    int ref[LLMK_HOST_MAX_TOKENS];
+    LlmkHostTurn base, spec;
+
+    g_spec_k = 0;
+    if (host_spec_turn(prompt, &gq, seed, &base) != 0) return -1;
+    int n_ref = g_turn_n;
+    memcpy(ref, g_turn_ids, sizeof(int) * (size_t)n_ref);
+
+    llmk_host_set_spec(k > 0 ? k : 4);
+    e.k = g_spec_k;
+    int rc = host_spec_turn(prompt, &gq, seed, &spec);
+    g_spec_k = was_k;
+    llmk_gen_seed(&g_gen, seed);
+    llmk_host_reset();
+    if (rc != 0) return -1;
+
+    e.tokens = spec.generated;
+    e.identical = (g_turn_n == n_ref) && memcmp(ref, g_turn_ids, sizeof(int) * (size_t)n_ref) == 0;
+    e.proposed = spec.spec_proposed;
+    e.accepted = spec.spec_accepted;
+    e.tok_s_base = base.decode_us ? (double)base.generated * 1.0e6 / (double)base.decode_us : 0.0;
+    e.tok_s_spec = spec.decode_us ? (double)spec.generated * 1.0e6 / (double)spec.decode_us : 0.0;
+    fprintf(stderr, "[spec] k=%d tokens=%d proposed=%d accepted=%d (%.1f%%) identical=%s\n", e.k, e.tokens,
+            e.proposed, e.accepted, e.proposed ? 100.0 * e.accepted / e.proposed : 0.0,
+            e.identical ? "yes" : "no");
+    fprintf(stderr, "[spec] decode tok/s: base=%.1f spec=%.1f (x%.2f)\n", e.tok_s_base, e.tok_s_spec,
+            e.tok_s_base > 0.0 ? e.tok_s_spec / e.tok_s_base : 0.0);
+    if (out) *out = e;
+    return 0;
+}
+
+/* ── Sessions ────────────────────────────────────────────────────────────── */
+
+struct LlmkHostSession {
+    LlmkGenState gen;
+    RunState     state;
+    void        *mem;                          /* state + gen arenas */
+    int          done;                         /* EOS/BOS sampled or cache full */
+};
+
+LlmkHostSession *llmk_host_session_open(const LlmkHostGen *g, unsigned int seed) {
+    if (g_fmt != LLMK_HOST_FMT_BIN && g_fmt != LLMK_HOST_FMT_GGUF) return NULL;
+    if (!g) return NULL;
+    const UINT64 sbytes = llmk_run_state_bytes(&g_config);
+    const UINT64 gbytes = llmk_gen_bytes(&g_config, HOST_CTX_TOKENS);
+    LlmkHostSession *s = (LlmkHostSession *)simple_alloc(sizeof(*s));
+    if (!s) return NULL;
+    s->mem = simple_alloc((unsigned long)(sbytes + gbytes));
+    if (!s->mem || llmk_run_state_init(&s->state, &g_config, s->mem, sbytes) != 0 ||
+        llmk_gen_init(&s->gen, &g_config, &s->state, (UINT8 *)s->mem + sbytes, gbytes, HOST_CTX_TOKENS) != 0) {
+        llmk_host_session_close(s);
+        return NULL;
+    }
+    llmk_gen_set(&s->gen, g->temperature, g->min_p, g->top_p, g->top_k, g->repeat_penalty, g->freq_penalty,
+                 g->presence_penalty, g->no_repeat_ngram);
+    llmk_gen_seed(&s->gen, seed);
+    return s;
+}
+
+void llmk_host_session_close(LlmkHostSession *s) {
+    if (!s) return;
+    free(s->mem);
+    free(s);
+}
+
+int llmk_host_session_prefill(LlmkHostSession *s, const char *prompt) {
+    if (!s || !prompt) return -1;
+    int toks[384];
+    int n = 0;
+    encode((char *)prompt, toks, &n, 384, &g_tokenizer);
+    if (s->gen.pos > 0 && n > 0 && toks[0] == llmk_tok_bos(&g_tokenizer)) {
+        for (int i = 1; i < n; i++) toks[i - 1] = toks[i];
+        n--;
+    }
+    if (llmk_gen_prefill(&s->gen, &g_weights, &g_config, toks, n) != 0) return -1;
+    s->done = 0;
+    return 0;
+}
+
+int llmk_host_session_step(LlmkHostSession *s) {
+    if (!s || s->done || s->gen.pos == 0) return -1;
+    const int tok = llmk_gen_step(&s->gen, &g_weights, &g_config);
+    if (tok < 0 || llmk_tok_is_stop(&g_tokenizer, tok)) {
+        s->done = 1;
+        return -1;
+    }
+    return tok;
+}
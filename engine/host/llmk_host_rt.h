@@ -0,0 +1,223 @@
+/* llmk_host_rt.h — Host (Linux) runtime around the engine's inference code
+ *
+ * llmk_host_rt.c unity-includes the same kernels, forward pass, sampler and
+ * tokenizer fragments as soma_inference.c (engine/llama2/llmk_*.c), and links
+ * gguf_infer.c, oosi_v3_*.c and bpe_tokenizer.c unmodified through the
+ * efi.h shim in this directory. Model files are mmap'ed read-only:
+ *
+ *   .bin (llama2.c)  zero-copy: TransformerWeights point into the mapping
+ *   .gguf            read through an mmap-backed EFI_FILE_PROTOCOL into the
+ *                    f32 layout, or the Q8_0 blob (--q8-blob) as on UEFI
+ *   .oosi (v3)       zero-copy oosi_v3_load + BPE tokenizer
+ *
+ * The generate loop follows soma_boot's (no-repeat n-gram, repeat penalty,
+ * suffix-repeat loop escapes, EOS/BOS stop, /stop_you, /stop_nl, /grammar,
+ * /spec) and the bench rows are byte-compatible with llmk_bench_on_turn_end,
+ * with latency_ms taken from CLOCK_MONOTONIC instead of EFI GetTime.
+ */
+#ifndef LLMK_HOST_RT_H
+#define LLMK_HOST_RT_H
+
+#include <stdint.h>
+
+#define LLMK_HOST_MAX_TOKENS 256      /* soma_loader.c MAX_TOKENS */
+
+enum {
+    LLMK_HOST_FMT_NONE = 0,
+    LLMK_HOST_FMT_BIN,
+    LLMK_HOST_FMT_GGUF,
+    LLMK_HOST_FMT_OOSI_V3
+};
+
+enum {
+    LLMK_HOST_CHAT_RAW = 0,
+    LLMK_HOST_CHAT_YOU_AI,
+    LLMK_HOST_CHAT_LLAMA2,
+    LLMK_HOST_CHAT_CHATML,
+    LLMK_HOST_CHAT_ALPACA
+};
+
+/* Generation settings; defaults match the Metabion profile */
+typedef struct {
+    float temperature;
+    float min_p;
+    float top_p;
+    int   top_k;                      /* 0..256 */
+    float repeat_penalty;
+    float freq_penalty;               /* logit -= count * f over the last 64 tokens */
+    float presence_penalty;           /* logit -= p for tokens in the last 64 */
+    int   no_repeat_ngram;            /* 0..16 */
+    int   max_gen_tokens;             /* 1..LLMK_HOST_MAX_TOKENS */
+    int   stop_on_you;
+    int   stop_on_double_nl;
+    int   stats;
+    int   chat_format;                /* LLMK_HOST_CHAT_* */
+    int   echo;                       /* stream tokens to stdout */
+} LlmkHostGen;
+
+typedef struct {
+    int      generated;
+    int      prompt_tokens;
+    uint64_t prefill_cycles;
+    uint64_t decode_cycles;
+    uint64_t decode_us;
+    uint64_t wall_us;
+    int      spec_proposed;           /* draft tokens verified (speculative decoding) */
+    int      spec_accepted;           /* of which sampled as drafted */
+    const char *stop_reason;          /* "eos/bos", "max_tokens", "seq_len", ... */
+} LlmkHostTurn;
+
+void llmk_host_gen_defaults(LlmkHostGen *g);
+
+/* Loads model (format from the file magic) and its tokenizer. tok_path may
+ * be NULL: the GGUF file's embedded tokenizer, else tokenizer.bin next to the
+ * model, then in the working directory (gpt_neox_tokenizer.bin first for
+ * OOSI v3). Returns 0 or <0. */
+int  llmk_host_load(const char *model_path, const char *tok_path, int q8_blob);
+void llmk_host_unload(void);
+void llmk_host_describe(void);
+int  llmk_host_format(void);
+int  llmk_host_seq_len(void);
+
+/* Runtime knobs (same meaning as the repl.cfg keys) */
+void llmk_host_set_q8_act(int mode);             /* 0 f32, 1 int8 all, 2 int8 FFN */
+void llmk_host_set_attn(int force);              /* -1 auto, 0 sse2, 1 avx2 */
+void llmk_host_set_seed(unsigned int seed, int jitter);
+void llmk_host_set_system_prompt(const char *s);
+
+/* RoPE overrides for the next llmk_host_load (repl.cfg rope_*): freq_base 0,
+ * scaling NULL ("none|linear|ntk|yarn"), factor 0, orig_ctx 0 keep the model's
+ * values. Returns -1 on an unknown scaling name. */
+int  llmk_host_set_rope(float freq_base, const char *scaling, float factor, int orig_ctx);
+
+/* KV window (repl.cfg kv_window/kv_sinks/kv_discard): when the cache is full,
+ * keep `sinks` leading rows, evict the oldest `discard` rows after them and
+ * re-rotate the rest (engine/llama2/llmk_kv_window.h). Off = clear the cache
+ * on overflow. sinks < 0 and discard <= 0 select the defaults. */
+void llmk_host_set_kv_window(int on, int sinks, int discard);
+
+/* One chat turn: wrap with the chat format, prefill, decode. Keeps the KV
+ * position across turns like the REPL; llmk_host_reset() clears it. */
+int  llmk_host_generate(const char *prompt, const LlmkHostGen *g, LlmkHostTurn *out);
+void llmk_host_reset(void);
+
+/* Bench capture (/bench_begin, /bench_case, /bench_end) */
+int  llmk_host_bench_begin(const char *path);    /* NULL → LLMK_BEN.JNL */
+void llmk_host_bench_case(const char *case_id, const char *category, int max_new_tokens);
+void llmk_host_bench_end(void);
+int  llmk_host_bench_active(void);
+
+void llmk_host_print_metrics(void);
+
+/* Constrained decoding (engine/llama2/llmk_grammar.h), llama2 models only.
+ * Every turn starts at the grammar's root; tokens the grammar cannot take
+ * are masked before sampling and EOS is allowed only once the output is
+ * complete. text is GBNF, a JSON schema, or ignored (OFF / JSON). */
+enum {
+    LLMK_HOST_GRAMMAR_OFF = 0,
+    LLMK_HOST_GRAMMAR_GBNF,
+    LLMK_HOST_GRAMMAR_SCHEMA,
+    LLMK_HOST_GRAMMAR_JSON                /* any JSON object */
+};
+
+int  llmk_host_set_grammar(int kind, const char *text);
+int  llmk_host_load_grammar(int kind, const char *path);
+void llmk_host_grammar_print(void);
+
+/* Classifier shortlist (engine/llama2/llmk_shortlist.h), llama2 models only.
+ * build: rank-r .lksl from the loaded classifier, written to out_path (may
+ * be NULL) and enabled. Sampling uses the shortlist logits as is; greedy
+ * turns (temperature <= 0) certify the top-1 or rerun the full classifier. */
+typedef struct {
+    int    steps;
+    int    agree;                     /* shortlist top-1 == full top-1 */
+    int    certified;                 /* bound proved the top-1 (no fallback) */
+    int    identical;                 /* verified greedy output == full greedy output */
+    double tok_s_full;
+    double tok_s_exact;               /* shortlist + verify_top1 */
+    double tok_s_fast;                /* shortlist only */
+} LlmkHostSlEval;
+
+int  llmk_host_shortlist_build(const char *out_path, int rank, int iters);
+int  llmk_host_shortlist_load(const char *path, int n_cand);
+void llmk_host_shortlist_enable(int on);
+void llmk_host_shortlist_set_k(int n_cand);
+void llmk_host_shortlist_print(void);
+
+/* Greedy decode of n_tokens after a raw prompt: top-1 agreement under teacher
+ * forcing, then decode tok/s full vs shortlist. Leaves the KV cache reset. */
+int  llmk_host_shortlist_eval(const char *prompt, int n_tokens, LlmkHostSlEval *out);
+
+/* Prompt-lookup speculative decoding (engine/llama2/llmk_spec.h), llama2
+ * models only. Each decode step drafts up to k tokens by matching the tail
+ * of the turn's context (prompt + output) against earlier occurrences and
+ * verifies them with the next token in one batched forward pass; the
+ * sampler consumes the exact logits of each row, so output is identical to
+ * k = 0 for every sampler setting. k is clamped to 0..8 (0 = off). */
+typedef struct {
+    int    k;
+    int    tokens;
+    int    proposed;
+    int    accepted;
+    int    identical;                 /* same tokens as without speculation */
+    double tok_s_base;
+    double tok_s_spec;
+} LlmkHostSpecEval;
+
+void llmk_host_set_spec(int k);
+int  llmk_host_spec(void);
+void llmk_host_spec_print(void);
+
+/* Decodes the raw prompt from an empty cache with g (same seed) without and
+ * with drafts of length k: acceptance, output identity and decode tok/s.
+ * Leaves the KV cache reset. */
+int  llmk_host_spec_eval(const char *prompt, const LlmkHostGen *g, int k, LlmkHostSpecEval *out);
+
+/* Mixed-precision plans (engine/llama2/llmk_mixq.h), llama2 models only:
+ * every matrix in its own format (f32, f16, q8_0, q4_0), norms and biases
+ * from the loaded model. plan: needs f32 weights (.bin). Teacher-forces the
+ * first n_tokens (default 64) of calib_text once per matrix × format with
+ * only that matrix degraded, takes the mean KL divergence from the f32
+ * logits as its error, then picks formats within the budget ("<MiB>" or
+ * "<pct>%" of the f32 matrices, default the all-q8_0 size); the plan is
+ * written to out_path (may be NULL) and applied. pareto: also plans a
+ * ladder of budgets from all-q4_0 to f32 and prints size vs perplexity. */
+#define LLMK_HOST_MIXQ_PARETO 8
+
+typedef struct {
+    int      tensors;                 /* planned matrices (a shared classifier counts once) */
+    int      tokens;
+    uint64_t budget;
+    uint64_t bytes;                   /* matrix bytes of the plan */
+    uint64_t bytes_f32;
+    int      n_fmt[4];                /* matrices per format: f32 f16 q8_0 q4_0 */
+    double   est_kl;                  /* sum of the chosen matrices' calibration KL */
+    double   kl;                      /* measured KL of the plan vs f32 */
+    double   ppl;
+    double   ppl_f32;
+    int      n_pareto;
+    uint64_t pareto_bytes[LLMK_HOST_MIXQ_PARETO];
+    double   pareto_ppl[LLMK_HOST_MIXQ_PARETO];
+    double   pareto_kl[LLMK_HOST_MIXQ_PARETO];
+} LlmkHostMixqReport;
+
+int  llmk_host_mixq_plan(const char *out_path, const char *calib_text, int n_tokens, const char *budget,
+                         int pareto, LlmkHostMixqReport *out);
+int  llmk_host_mixq_load(const char *path);
+void llmk_host_mixq_enable(int on);
+void llmk_host_mixq_print(void);
+
+/* Independent generations over the loaded llama2 model. A session owns its
+ * KV cache, sampler settings and RNG, penalty history and int8 scratch
+ * (engine/llama2/llmk_gen.c), so sessions decode concurrently (one thread
+ * per session) or interleaved, each producing exactly the tokens it would
+ * alone. They share only the read-only weights; the classifier shortlist,
+ * grammar, KV window and spec settings apply to llmk_host_generate only. */
+typedef struct LlmkHostSession LlmkHostSession;
+
+LlmkHostSession *llmk_host_session_open(const LlmkHostGen *g, unsigned int seed);  /* NULL on error */
+void llmk_host_session_close(LlmkHostSession *s);
+int  llmk_host_session_prefill(LlmkHostSession *s, const char *prompt);  /* raw prompt with BOS; 0 or -1 */
+int  llmk_host_session_step(LlmkHostSession *s);  /* next token, -1 at EOS/BOS or a full cache */
+
+#endif /* LLMK_HOST_RT_H */
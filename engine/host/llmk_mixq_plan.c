@@ -0,0 +1,232 @@
+/* llmk_mixq_plan.c — Offline planner and writer for .lkmx mixed-precision images
+ *
+ * See llmk_mixq_plan.h. The quantizers follow GGML's reference rounding:
+ * Q8_0 d = amax / 127, Q4_0 d = (signed value of largest magnitude) / -8,
+ * both quantizing with the f32 scale and storing it as f16, so an .lkmx
+ * tensor holds the same bytes a GGUF Q8_0 / Q4_0 tensor would.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "llmk_mixq.h"
+#include "llmk_mixq_plan.h"
+
+uint16_t llmk_mx_f32_to_f16(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    const uint16_t sign = (uint16_t)((u >> 16) & 0x8000u);
+    const uint32_t a = u & 0x7FFFFFFFu;
+    if (a > 0x7F800000u) return 0;                       /* NaN */
+    if (a >= 0x477FE000u) return (uint16_t)(sign | 0x7BFFu);   /* ≥ 65504 */
+    if (a < 0x38800000u) {                               /* below 2^-14: subnormal */
+        float m;
+        memcpy(&m, &a, sizeof(m));
+        return (uint16_t)(sign | (uint16_t)nearbyintf(m * 16777216.0f));
+    }
+    uint32_t h = (a - (112u << 23)) >> 13;
+    const uint32_t rest = a & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (h & 1u))) h++;
+    return (uint16_t)(sign | h);
+}
+
+static void mx_put_f16(uint8_t *p, float f) {
+    const uint16_t h = llmk_mx_f32_to_f16(f);
+    p[0] = (uint8_t)(h & 0xFFu);
+    p[1] = (uint8_t)(h >> 8);
+}
+
+int llmk_mx_quantize_row(uint32_t fmt, const float *src, uint32_t cols, uint8_t *dst) {
+    if (!src || !dst || llmk_mx_row_bytes(fmt, cols) == 0) return -1;
+    switch (fmt) {
+    case LLMK_MX_F32:
+        memcpy(dst, src, sizeof(float) * cols);
+        return 0;
+    case LLMK_MX_F16:
+        for (uint32_t i = 0; i < cols; i++) mx_put_f16(dst + 2u * i, src[i]);
+        return 0;
+    case LLMK_MX_Q8_0:
+        for (uint32_t b = 0; b < cols / 32u; b++, src += 32, dst += 34) {
+            float amax = 0.0f;
+            for (int j = 0; j < 32; j++) amax = fmaxf(amax, fabsf(src[j]));
+            const float d = amax / 127.0f;
+            const float id = d != 0.0f ? 1.0f / d : 0.0f;
+            mx_put_f16(dst, d);
+            for (int j = 0; j < 32; j++) dst[2 + j] = (uint8_t)(int8_t)roundf(src[j] * id);
+        }
+        return 0;
+    case LLMK_MX_Q4_0:
+        for (uint32_t b = 0; b < cols / 32u; b++, src += 32, dst += 18) {
+            float amax = 0.0f, max = 0.0f;
+            for (int j = 0; j < 32; j++) {
+                if (fabsf(src[j]) > amax) {
+                    amax = fabsf(src[j]);
+                    max = src[j];
+                }
+            }
+            const float d = max / -8.0f;
+            const float id = d != 0.0f ? 1.0f / d : 0.0f;
+            mx_put_f16(dst, d);
+            for (int j = 0; j < 16; j++) {
+                int q0 = (int)(src[j] * id + 8.5f), q1 = (int)(src[j + 16] * id + 8.5f);
+                q0 = q0 < 0 ? 0 : (q0 > 15 ? 15 : q0);
+                q1 = q1 < 0 ? 0 : (q1 > 15 ? 15 : q1);
+                dst[2 + j] = (uint8_t)(q0 | (q1 << 4));
+            }
+        }
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/* Lower convex hull of one tensor's allowed formats, by increasing bytes:
+ * a point that does not lower the error, or whose error drop per byte
+ * beats the previous step's, is folded into a larger step. */
+static uint32_t mx_hull(const LlmkMxCost *c, uint32_t *hull) {
+    uint32_t order[LLMK_MX_N_FMT], n = 0;
+    for (uint32_t f = 0; f < LLMK_MX_N_FMT; f++) {
+        if (!c->bytes[f]) continue;
+        uint32_t k = n++;
+        while (k > 0 && c->bytes[order[k - 1]] > c->bytes[f]) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = f;
+    }
+    uint32_t h = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const uint32_t f = order[i];
+        if (h > 0 && (c->err[f] >= c->err[hull[h - 1]] || c->bytes[f] == c->bytes[hull[h - 1]])) continue;
+        while (h >= 2) {
+            const uint32_t a = hull[h - 2], b = hull[h - 1];
+            const double s_ab = (c->err[a] - c->err[b]) / (double)(c->bytes[b] - c->bytes[a]);
+            const double s_bf = (c->err[b] - c->err[f]) / (double)(c->bytes[f] - c->bytes[b]);
+            if (s_bf < s_ab) break;
+            h--;
+        }
+        hull[h++] = f;
+    }
+    return h;
+}
+
+uint64_t llmk_mx_plan(const LlmkMxCost *cost, uint32_t n, uint64_t budget, uint32_t *fmt_out) {
+    if (!cost || !fmt_out || n == 0) return 0;
+    uint32_t (*hull)[LLMK_MX_N_FMT] = malloc(sizeof(*hull) * n);
+    uint32_t *len = malloc(sizeof(uint32_t) * n);
+    uint32_t *pos = calloc(n, sizeof(uint32_t));
+    uint64_t total = 0;
+    if (!hull || !len || !pos) goto fail;
+    for (uint32_t i = 0; i < n; i++) {
+        len[i] = mx_hull(&cost[i], hull[i]);
+        if (len[i] == 0) goto fail;
+        total += cost[i].bytes[hull[i][0]];
+    }
+    if (total > budget) goto fail;
+
+    for (;;) {
+        int64_t best = -1;
+        double best_gain = 0.0;
+        for (uint32_t i = 0; i < n; i++) {
+            if (pos[i] + 1 >= len[i]) continue;
+            const uint32_t a = hull[i][pos[i]], b = hull[i][pos[i] + 1];
+            const uint64_t extra = cost[i].bytes[b] - cost[i].bytes[a];
+            if (extra > budget - total) continue;
+            const double gain = (cost[i].err[a] - cost[i].err[b]) / (double)extra;
+            if (best < 0 || gain > best_gain) {
+                best = (int64_t)i;
+                best_gain = gain;
+            }
+        }
+        if (best < 0) break;
+        const uint32_t i = (uint32_t)best;
+        total += cost[i].bytes[hull[i][pos[i] + 1]] - cost[i].bytes[hull[i][pos[i]]];
+        pos[i]++;
+    }
+    for (uint32_t i = 0; i < n; i++) fmt_out[i] = hull[i][pos[i]];
+    free(hull);
+    free(len);
+    free(pos);
+    return total;
+
+fail:
+    free(hull);
+    free(len);
+    free(pos);
+    return 0;
+}
+
+static uint64_t mx_align(uint64_t x) {
+    return (x + LLMK_MX_ALIGN - 1u) & ~(uint64_t)(LLMK_MX_ALIGN - 1u);
+}
+
+int llmk_mx_build(const LlmkMixq *dims, const uint32_t *fmt, LlmkMxRowFn row, void *ctx, void **out_buf,
+                  uint64_t *out_len) {
+    if (!dims || !fmt || !row || !out_buf || !out_len || dims->n_tensors == 0) return -1;
+    const uint32_t n = dims->n_tensors, tok = dims->n_layers * LLMK_MX_ROLES;
+    LlmkMxEntry *e = calloc(n, sizeof(LlmkMxEntry));
+    if (!e) return -2;
+
+    uint64_t off = mx_align(sizeof(LlmkMxHeader) + (uint64_t)n * sizeof(LlmkMxEntry));
+    uint32_t max_cols = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t rows = 0, cols = 0;
+        llmk_mx_shape(dims, i, &rows, &cols);
+        const uint32_t f = (dims->shared_cls && i == tok + 1) ? fmt[tok] : fmt[i];
+        const uint64_t rb = llmk_mx_row_bytes(f, cols);
+        if (rb == 0) {
+            free(e);
+            return -1;
+        }
+        e[i].fmt = f;
+        e[i].rows = rows;
+        e[i].cols = cols;
+        e[i].bytes = (uint64_t)rows * rb;
+        if (dims->shared_cls && i == tok + 1) {
+            e[i].offset = e[tok].offset;
+        } else {
+            e[i].offset = off;
+            off = mx_align(off + e[i].bytes);
+        }
+        if (cols > max_cols) max_cols = cols;
+    }
+
+    void *buf = NULL;
+    float *tmp = malloc(sizeof(float) * max_cols);
+    if (!tmp || posix_memalign(&buf, LLMK_MX_ALIGN, (size_t)off) != 0) {
+        free(tmp);
+        free(e);
+        return -2;
+    }
+    memset(buf, 0, (size_t)off);
+
+    LlmkMxHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = LLMK_MX_MAGIC;
+    h.version = LLMK_MX_VERSION;
+    h.dim = dims->dim;
+    h.hidden_dim = dims->hidden_dim;
+    h.n_layers = dims->n_layers;
+    h.n_heads = dims->n_heads;
+    h.n_kv_heads = dims->n_kv_heads;
+    h.vocab = dims->vocab;
+    h.n_tensors = n;
+    h.shared_cls = dims->shared_cls;
+    memcpy(buf, &h, sizeof(h));
+    memcpy((uint8_t *)buf + sizeof(h), e, sizeof(LlmkMxEntry) * n);
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (dims->shared_cls && i == tok + 1) continue;
+        const uint64_t rb = e[i].bytes / e[i].rows;
+        uint8_t *dst = (uint8_t *)buf + e[i].offset;
+        for (uint32_t r = 0; r < e[i].rows; r++, dst += rb) {
+            row(ctx, i, r, tmp);
+            llmk_mx_quantize_row(e[i].fmt, tmp, e[i].cols, dst);
+        }
+    }
+    free(tmp);
+    free(e);
+    *out_buf = buf;
+    *out_len = off;
+    return 0;
+}
@@ -0,0 +1,49 @@
+/* llmk_mixq_plan.h — Offline planner and writer for .lkmx mixed-precision images
+ *
+ * Host-only (libc, malloc). The calibration itself (running the model with
+ * one matrix degraded at a time, llmk_host_mixq_plan) lives in
+ * llmk_host_rt.c; this file holds what does not need a model: quantizers
+ * bit-compatible with GGML's Q8_0 / Q4_0 reference code, the budgeted
+ * format assignment and the image writer. Rows are streamed through a
+ * callback, so no tensor has to exist as a whole in its source format.
+ */
+#ifndef LLMK_MIXQ_PLAN_H
+#define LLMK_MIXQ_PLAN_H
+
+#include <stdint.h>
+
+#include "llmk_mixq.h"
+
+/* Round to nearest even; saturates at ±65504, NaN becomes 0 */
+uint16_t llmk_mx_f32_to_f16(float f);
+
+/* Encodes cols floats into dst (llmk_mx_row_bytes(fmt, cols) bytes).
+ * Returns 0, or -1 when fmt cannot hold a row of cols. */
+int llmk_mx_quantize_row(uint32_t fmt, const float *src, uint32_t cols, uint8_t *dst);
+
+/* Calibration result of one tensor: bytes[f] == 0 = format not allowed */
+typedef struct {
+    uint64_t bytes[LLMK_MX_N_FMT];
+    double   err[LLMK_MX_N_FMT];      /* model error with only this tensor in f */
+} LlmkMxCost;
+
+/* One format per tensor, total bytes ≤ budget, summed error small: every
+ * tensor starts in its smallest format and is upgraded along the lower
+ * convex hull of its (bytes, err) points, largest error drop per byte
+ * first (errors are assumed additive across tensors). Writes fmt_out[n]
+ * and returns the total bytes, or 0 when even the smallest formats do not
+ * fit. */
+uint64_t llmk_mx_plan(const LlmkMxCost *cost, uint32_t n, uint64_t budget, uint32_t *fmt_out);
+
+/* Writes row `row` (cols floats) of tensor `tensor` to out */
+typedef void (*LlmkMxRowFn)(void *ctx, uint32_t tensor, uint32_t row, float *out);
+
+/* Builds a complete .lkmx image for the dimensions in dims (llmk_mx_init)
+ * with formats fmt[dims->n_tensors]; a shared classifier takes the
+ * embedding's entry and is never read. *out_buf is 64-byte aligned,
+ * release with free(). Returns 0, -1 on bad arguments, -2 on allocation
+ * failure. */
+int llmk_mx_build(const LlmkMixq *dims, const uint32_t *fmt, LlmkMxRowFn row, void *ctx, void **out_buf,
+                  uint64_t *out_len);
+
+#endif /* LLMK_MIXQ_PLAN_H */
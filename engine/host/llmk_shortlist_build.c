@@ -0,0 +1,178 @@
+/* llmk_shortlist_build.c — Offline builder for .lksl classifier shortlists
+ *
+ * See llmk_shortlist_build.h. The basis is computed in double precision and
+ * stored as f32; coefficients and residuals are taken against the stored
+ * f32 basis, so the bound in the file holds for what llmk_sl_select()
+ * actually evaluates. A small relative margin covers f32 rounding of the
+ * runtime dot products.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "llmk_shortlist.h"
+#include "llmk_shortlist_build.h"
+
+#define SL_RESID_REL_MARGIN 1.0e-4
+#define SL_RESID_ABS_MARGIN 3.0e-5   /* × (‖W_i‖ + ‖recon_i‖) */
+
+static uint64_t sl_rng_next(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double sl_rng_gauss(uint64_t *s) {
+    double u1 = ((double)(sl_rng_next(s) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    double u2 = ((double)(sl_rng_next(s) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+/* Modified Gram-Schmidt (twice) on the columns of M, column j at M + j·n.
+ * A column that collapses is replaced by a random direction. */
+static void sl_orthonormalize(double *M, uint32_t n, uint32_t cols, uint64_t *rng) {
+    for (uint32_t j = 0; j < cols; j++) {
+        double *c = M + (uint64_t)j * n;
+        for (int tries = 0; tries < 4; tries++) {
+            double before = 0.0;
+            for (uint32_t d = 0; d < n; d++) before += c[d] * c[d];
+            for (int pass = 0; pass < 2; pass++) {
+                for (uint32_t k = 0; k < j; k++) {
+                    const double *q = M + (uint64_t)k * n;
+                    double dot = 0.0;
+                    for (uint32_t d = 0; d < n; d++) dot += q[d] * c[d];
+                    for (uint32_t d = 0; d < n; d++) c[d] -= dot * q[d];
+                }
+            }
+            double nn = 0.0;
+            for (uint32_t d = 0; d < n; d++) nn += c[d] * c[d];
+            if (nn > 1.0e-20 * before && nn > 1.0e-300) {
+                double inv = 1.0 / sqrt(nn);
+                for (uint32_t d = 0; d < n; d++) c[d] *= inv;
+                break;
+            }
+            for (uint32_t d = 0; d < n; d++) c[d] = sl_rng_gauss(rng);
+        }
+    }
+}
+
+int llmk_sl_build(LlmkSlRowFn row, void *ctx, uint32_t vocab, uint32_t dim, uint32_t rank,
+                  int iters, uint32_t seed, void **out_buf, uint64_t *out_len,
+                  LlmkSlBuildStats *stats) {
+    if (!row || !out_buf || !out_len || vocab == 0 || dim == 0 || rank == 0 ||
+        rank > LLMK_SL_MAX_RANK || rank > dim || iters < 0) {
+        return -1;
+    }
+    *out_buf = NULL;
+    *out_len = 0;
+
+    const uint64_t bytes = llmk_sl_file_bytes(vocab, dim, rank);
+    const uint64_t bytes_al = (bytes + 63u) & ~(uint64_t)63u;
+    double *V = (double *)malloc(sizeof(double) * (size_t)rank * dim);
+    double *Z = (double *)malloc(sizeof(double) * (size_t)rank * dim);
+    double *y = (double *)malloc(sizeof(double) * rank);
+    double *rec = (double *)malloc(sizeof(double) * dim);
+    float *w = (float *)malloc(sizeof(float) * dim);
+    void *buf = aligned_alloc(64, (size_t)bytes_al);
+    if (!V || !Z || !y || !rec || !w || !buf) {
+        free(V); free(Z); free(y); free(rec); free(w); free(buf);
+        return -2;
+    }
+    memset(buf, 0, (size_t)bytes_al);
+
+    /* Subspace iteration: V ← orth(WᵀW·V), one pass over W each */
+    uint64_t rng = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)seed << 1 | 1u);
+    for (uint64_t i = 0; i < (uint64_t)rank * dim; i++) V[i] = sl_rng_gauss(&rng);
+    sl_orthonormalize(V, dim, rank, &rng);
+    for (int it = 0; it < iters; it++) {
+        memset(Z, 0, sizeof(double) * (size_t)rank * dim);
+        for (uint32_t i = 0; i < vocab; i++) {
+            row(ctx, i, w);
+            for (uint32_t j = 0; j < rank; j++) {
+                const double *v = V + (uint64_t)j * dim;
+                double s = 0.0;
+                for (uint32_t d = 0; d < dim; d++) s += v[d] * (double)w[d];
+                y[j] = s;
+            }
+            for (uint32_t j = 0; j < rank; j++) {
+                double *z = Z + (uint64_t)j * dim;
+                const double yj = y[j];
+                for (uint32_t d = 0; d < dim; d++) z[d] += yj * (double)w[d];
+            }
+        }
+        sl_orthonormalize(Z, dim, rank, &rng);
+        double *t = V; V = Z; Z = t;
+    }
+
+    LlmkSlHeader *h = (LlmkSlHeader *)buf;
+    h->magic = LLMK_SL_MAGIC;
+    h->version = LLMK_SL_VERSION;
+    h->vocab = vocab;
+    h->dim = dim;
+    h->rank = rank;
+    h->rank_pad = (rank + 15u) & ~15u;
+    LlmkShortlist sl;
+    if (llmk_sl_parse(&sl, buf, bytes) != LLMK_SL_OK) {
+        free(V); free(Z); free(y); free(rec); free(w); free(buf);
+        return -1;
+    }
+    float *basis = (float *)sl.basis;
+    float *scale = (float *)sl.scale;
+    float *resid = (float *)sl.resid;
+    int8_t *coef = (int8_t *)sl.coef;
+    for (uint64_t i = 0; i < (uint64_t)rank * dim; i++) basis[i] = (float)V[i];
+
+    /* Coefficients against the stored f32 basis, int8 per row */
+    double sum_rel = 0.0, max_rel = 0.0;
+    for (uint32_t i = 0; i < vocab; i++) {
+        row(ctx, i, w);
+        double amax = 0.0, wn = 0.0;
+        for (uint32_t j = 0; j < rank; j++) {
+            const float *b = basis + (uint64_t)j * dim;
+            double s = 0.0;
+            for (uint32_t d = 0; d < dim; d++) s += (double)b[d] * (double)w[d];
+            y[j] = s;
+            if (fabs(s) > amax) amax = fabs(s);
+        }
+        const float si = (float)(amax / 127.0);
+        int8_t *q = coef + (uint64_t)i * sl.rank_pad;
+        for (uint32_t j = 0; j < rank; j++) {
+            double v = si > 0.0f ? y[j] / (double)si : 0.0;
+            long r = lround(v);
+            q[j] = (int8_t)(r > 127 ? 127 : (r < -127 ? -127 : r));
+        }
+        memset(rec, 0, sizeof(double) * dim);
+        for (uint32_t j = 0; j < rank; j++) {
+            const float *b = basis + (uint64_t)j * dim;
+            const double c = (double)si * (double)q[j];
+            for (uint32_t d = 0; d < dim; d++) rec[d] += c * (double)b[d];
+        }
+        double rr = 0.0, rn = 0.0;
+        for (uint32_t d = 0; d < dim; d++) {
+            double e = (double)w[d] - rec[d];
+            rr += e * e;
+            rn += rec[d] * rec[d];
+            wn += (double)w[d] * (double)w[d];
+        }
+        const double r = sqrt(rr);
+        scale[i] = si;
+        resid[i] = (float)(r * (1.0 + SL_RESID_REL_MARGIN) + SL_RESID_ABS_MARGIN * (sqrt(wn) + sqrt(rn)));
+        if (wn > 0.0) {
+            double rel = r / sqrt(wn);
+            sum_rel += rel;
+            if (rel > max_rel) max_rel = rel;
+        }
+    }
+
+    if (stats) {
+        stats->mean_rel_resid = sum_rel / (double)vocab;
+        stats->max_rel_resid = max_rel;
+    }
+    free(V); free(Z); free(y); free(rec); free(w);
+    *out_buf = buf;
+    *out_len = bytes;
+    return 0;
+}
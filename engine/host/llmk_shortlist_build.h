@@ -0,0 +1,29 @@
+/* llmk_shortlist_build.h — Offline builder for .lksl classifier shortlists
+ *
+ * Host-only (libc, malloc). Finds a rank-r orthonormal basis B of the
+ * classifier's row space by subspace iteration on WᵀW, then stores each row
+ * as int8 coefficients c_i ≈ B·W_i / s_i plus the residual norm that
+ * llmk_sl_certify() relies on. Rows are streamed through a callback, so the
+ * classifier never has to be dequantized as a whole (Q8_0 models).
+ */
+#ifndef LLMK_SHORTLIST_BUILD_H
+#define LLMK_SHORTLIST_BUILD_H
+
+#include <stdint.h>
+
+/* Writes classifier row `row` (dim floats) to out */
+typedef void (*LlmkSlRowFn)(void *ctx, uint32_t row, float *out);
+
+typedef struct {
+    double mean_rel_resid;              /* mean ‖W_i − recon_i‖ / ‖W_i‖ */
+    double max_rel_resid;
+} LlmkSlBuildStats;
+
+/* Builds a complete .lksl image. iters = subspace iterations (each streams
+ * W once; 3..6 is plenty). *out_buf is 64-byte aligned, release with free().
+ * Returns 0, -1 on bad arguments, -2 on allocation failure. */
+int llmk_sl_build(LlmkSlRowFn row, void *ctx, uint32_t vocab, uint32_t dim, uint32_t rank,
+                  int iters, uint32_t seed, void **out_buf, uint64_t *out_len,
+                  LlmkSlBuildStats *stats);
+
+#endif /* LLMK_SHORTLIST_BUILD_H */
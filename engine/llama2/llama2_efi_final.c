@@ -96,6 +96,7 @@
 // OO Multicore SMP (UEFI MP Services)
 #include "../../oo-multicore/core/oo_multicore.h"
 #include "../../oo-multicore/core/oo_multicore.c"
+#include "../../oo-multicore/core/oo_mc_queue.c"
 
 
 // GGUF support
@@ -110,6 +111,7 @@
 // OOSI v3 — full standalone Mamba (all weights int8)
 #include "../ssm/oosi_v3_loader.h"
 #include "../ssm/oosi_v3_infer.h"
+#include "../ssm/oosi_v3_tp.h"
 #include "../ssm/soma_router.h"
 #include "../ssm/soma_dna.h"
 #include "../ssm/soma_dual.h"
@@ -120,8 +122,13 @@
 #include "../ssm/soma_reflex.h"
 #include "../ssm/soma_logic.h"
 #include "../ssm/soma_memory.h"
+#include "../ssm/soma_embed.h"
 #include "../ssm/oo_neuralfs2_persist.h"
 #include "../ssm/oo_neuralfs2_persist.c"
+#include "../ssm/oo_nfs_log.h"
+#include "../ssm/oo_nfs_log.c"
+#include "../ssm/oo_nfs_log_persist.h"
+#include "../ssm/oo_nfs_log_persist.c"
 #include "../ssm/soma_journal.h"
 #include "../ssm/soma_cortex.h"
 #include "../ssm/soma_export.h"
@@ -145,6 +152,8 @@
 
 // Phase WW: Full Voice Pipeline (HDA capture → wakeword → NLP → TTS → HDA play)
 // Headers only — implementations linked via REPL_OBJS (.o files)
+#include "../voice/oo_mfcc.h"
+#include "../voice/oo_kws.h"
 #include "../voice/oo_wakeword.h"
 #include "../voice/oo_voice_context.h"
 #include "../voice/oo_persona.h"
@@ -163,6 +172,10 @@
 // Phase X: In-Situ Self-Training Engine (RAG + LoRA delta)
 #include "../trainer/oo_insitu_train.h"
 #include "../trainer/oo_insitu_train.c"
+// Phase X2: gradient-based LoRA training through the transformer
+#include "../trainer/oo_insitu_backprop.c"
+#include "../trainer/oo_insitu_parallel.c"
+#include "../trainer/oo_insitu_dream.c"
 
 // Phase SM: SomaMind V1 — compact SSM + adaptive halting + tool-use
 #include "../ssm/oo_somamind_v1.h"
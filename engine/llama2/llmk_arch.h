@@ -0,0 +1,60 @@
+/* llmk_arch.h — Per-architecture behaviour of the llama-family forward pass
+ *
+ * GGUF files name their family in general.architecture. The families the
+ * engine runs share the llama block (RMSNorm → attention → RMSNorm → gated
+ * FFN, tied or separate classifier) and differ in a handful of switches:
+ *
+ *               act    eps    qkv bias  fused tensors     window   embed
+ *   llama       SiLU   1e-5   -         -                 -        1
+ *   mistral     SiLU   1e-5   -         -                 all      1
+ *   qwen2       SiLU   1e-6   q,k,v     -                 -        1
+ *   phi3        SiLU   1e-5   -         qkv, gate|up      all      1
+ *   gemma       GELU   1e-6   -         -                 -        √dim
+ *
+ * gguf_infer.c holds the descriptor table (tensor names, fused splits, rope
+ * layout) and resolves it against the file's metadata into an LlmkArch; the
+ * forward pass only reads the resolved struct. Gemma's (1 + w) norm weights
+ * need no switch: the GGUF converter already stores w + 1.
+ *
+ * llama2.c .bin files get LLMK_ARCH_LLAMA2_INIT, which reproduces the
+ * original forward pass exactly.
+ *
+ * Freestanding C11 — header only.
+ */
+#pragma once
+#ifndef LLMK_ARCH_H
+#define LLMK_ARCH_H
+
+#define LLMK_ARCH_ACT_SILU       0      /* SwiGLU: silu(gate) · up */
+#define LLMK_ARCH_ACT_GELU_TANH  1      /* GeGLU: gelu_tanh(gate) · up */
+
+#define LLMK_ARCH_WINDOW_NONE    0      /* full causal attention */
+#define LLMK_ARCH_WINDOW_ALL     1      /* every layer attends to the last sliding_window tokens */
+
+typedef struct {
+    char  name[16];                     /* general.architecture */
+    int   act;                          /* LLMK_ARCH_ACT_* */
+    float norm_eps;                     /* RMSNorm epsilon */
+    float embed_scale;                  /* token embedding multiplier */
+    int   qkv_bias;                     /* TransformerWeights bq/bk/bv are loaded */
+    int   window_policy;                /* LLMK_ARCH_WINDOW_* */
+    int   sliding_window;               /* attention span in tokens; 0 = unbounded */
+} LlmkArch;
+
+#define LLMK_ARCH_LLAMA2_INIT { "llama", LLMK_ARCH_ACT_SILU, 1e-5f, 1.0f, 0, LLMK_ARCH_WINDOW_NONE, 0 }
+
+/* 1 when the forward pass is the plain llama2.c block (what the in-situ
+ * trainer's backprop implements) */
+static inline int llmk_arch_is_llama2(const LlmkArch *a) {
+    return a->act == LLMK_ARCH_ACT_SILU && a->norm_eps == 1e-5f && a->embed_scale == 1.0f &&
+           !a->qkv_bias && a->sliding_window == 0;
+}
+
+/* First cache row the query at pos attends to */
+static inline int llmk_arch_attn_start(const LlmkArch *a, int pos) {
+    if (a->window_policy == LLMK_ARCH_WINDOW_NONE || a->sliding_window <= 0) return 0;
+    int t0 = pos - a->sliding_window + 1;
+    return t0 > 0 ? t0 : 0;
+}
+
+#endif /* LLMK_ARCH_H */
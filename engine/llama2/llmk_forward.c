@@ -0,0 +1,578 @@
+// llmk_forward.c — Transformer forward pass: one token (prefill and decode)
+// or a short batch of positions (speculative verification)
+//
+// Unity fragment (soma_inference.c, engine/host/llmk_host_rt.c). Besides
+// llmk_kernels.c and llmk_model.h the includer provides:
+// llmk_kv_prefetch_range, the LoRA hooks (llmk_lora_fused_state,
+// llmk_lora_active_state, llmk_lora_model, llmk_lora_matmul), pheromion_touch/g_pheromion,
+// DJIBMARK_PREFILL/DECODE, g_metrics, the RoPE tables (llmk_rope.h:
+// LlmkRope g_llmk_rope; not ready = no rotation) and the classifier
+// shortlist (llmk_shortlist.h: LlmkShortlist g_llmk_shortlist,
+// int g_llmk_cls_full), the architecture switches (llmk_arch.h:
+// LlmkArch g_llmk_arch; LLMK_ARCH_LLAMA2_INIT for llama2.c models) and the
+// mixed-precision kernels (llmk_mixq.c, used when w->mx is set).
+
+// int8 activation buffers for n inputs: the state's own, else the shared ones
+static void llmk_act_q8(RunState *s, int n, INT8 **qs, float **scales) {
+    if (s->q8_qs && s->q8_scales) {
+        *qs = s->q8_qs;
+        *scales = s->q8_scales;
+        return;
+    }
+    llmk_q8_act_ensure(n);
+    *qs = g_q8_act_qs;
+    *scales = g_q8_act_scales;
+}
+
+// ============================================================================
+// CLASSIFIER
+// ============================================================================
+
+// Tensor idx of a mixed-precision plan (llmk_mixq.h numbering)
+static const LlmkMxTensor *llmk_mx_tensor(const TransformerWeights *w, int l, UINT32 role) {
+    return &w->mx->t[(UINT32)l * LLMK_MX_ROLES + role];
+}
+
+static void llmk_classifier_full(RunState *s, TransformerWeights *w, Config *p, int use_i8_cls) {
+    int dim = p->dim;
+    if (w->mx) {
+        const LlmkMxTensor *t = &w->mx->t[w->mx->n_layers * LLMK_MX_ROLES + 1];
+        llmk_mx_matmul(s->logits, s->x, t, 0, t->rows);
+    } else if (w->kind == 1) {
+        if (use_i8_cls) {
+            INT8 *aq;
+            float *as;
+            llmk_act_q8(s, dim, &aq, &as);
+            llmk_quantize_f32_to_q8_blocks(s->x, dim, aq, as);
+            matmul_q8_0_avx2_i8_prequant(s->logits, aq, as, w->wcls_q8, dim, p->vocab_size);
+        } else {
+            matmul_q8_0(s->logits, s->x, w->wcls_q8, dim, p->vocab_size);
+        }
+    } else {
+        matmul(s->logits, s->x, w->wcls, dim, p->vocab_size);
+    }
+}
+
+// Exact logits for a subset of classifier rows (shortlist stage 2)
+static void llmk_classifier_rows(RunState *s, TransformerWeights *w, int dim, const INT32 *rows, UINT32 n) {
+    for (UINT32 i = 0; i < n; i++) {
+        int r = rows[i];
+        if (w->mx) {
+            llmk_mx_matmul(s->logits + r, s->x, &w->mx->t[w->mx->n_layers * LLMK_MX_ROLES + 1], (UINT32)r, 1);
+        } else if (w->kind == 1) {
+            matmul_q8_0(s->logits + r, s->x, w->wcls_q8 + (UINTN)r * (UINTN)w->tok_embd_row_bytes, dim, 1);
+        } else {
+            s->logits[r] = dot_f32_best(s->x, w->wcls + (UINTN)r * (UINTN)dim, dim);
+        }
+    }
+}
+
+// Low-rank shortlist + exact rerank. Rows outside the shortlist read
+// LLMK_SL_MASKED. Returns 0 when the top-1 must be exact (verify_top1) and
+// the bound could not certify it: the caller then runs the full classifier.
+static int llmk_classifier_shortlist(RunState *s, TransformerWeights *w, Config *p) {
+    LlmkShortlist *sl = &g_llmk_shortlist;
+    UINT32 n = llmk_sl_select(sl, s->x);
+    for (int i = 0; i < p->vocab_size; i++) s->logits[i] = LLMK_SL_MASKED;
+    llmk_classifier_rows(s, w, p->dim, sl->cand, n);
+    return !sl->verify_top1 || llmk_sl_certify(sl, s->logits);
+}
+
+static int llmk_shortlist_usable(const RunState *s, const Config *p) {
+    const LlmkShortlist *sl = &g_llmk_shortlist;
+    return sl->enabled && !g_llmk_cls_full && !s->cls_full && sl->vocab == (UINT32)p->vocab_size &&
+           sl->dim == (UINT32)p->dim;
+}
+
+// ============================================================================
+// FORWARD PASS
+// ============================================================================
+
+// Multihead attention of query q (all heads) at pos over the cached rows
+// [att_start, pos] of one layer; writes the concatenated heads to out.
+static void llmk_attention(RunState *s, Config *p, float *q, float *out, int loff, int pos, int att_start) {
+    int n_heads = p->n_heads;
+    int head_size = p->dim / n_heads;
+    int kv_dim = (p->dim * p->n_kv_heads) / n_heads;
+    int kv_mul = n_heads / p->n_kv_heads;
+
+    for (int h = 0; h < n_heads; h++) {
+        float* q_h = q + h * head_size;
+        int att_offset = h * p->seq_len;
+        float inv_scale = 1.0f / fast_sqrt((float)head_size);
+        int kv_head = h / kv_mul;
+        const float *key_base = s->key_cache + loff + kv_head * head_size;
+        const float *val_base = s->value_cache + loff + kv_head * head_size;
+
+        llmk_kv_prefetch_range(key_base + att_start * kv_dim, kv_dim, head_size, pos + 1 - att_start);
+        llmk_kv_prefetch_range(val_base + att_start * kv_dim, kv_dim, head_size, pos + 1 - att_start);
+        // Attention scores (rows before att_start are outside the sliding window)
+        for (int t = att_start; t <= pos; t++) {
+            float* k_t = s->key_cache + loff + t * kv_dim + (h / kv_mul) * head_size;
+            float score = dot_f32_best(q_h, k_t, head_size) * inv_scale;
+            s->att[att_offset + t] = score;
+        }
+        
+        // Softmax
+        softmax(s->att + att_offset + att_start, pos + 1 - att_start);
+
+        // Weighted sum
+        float* xb_h = out + h * head_size;
+        for (int i = 0; i < head_size; i++) xb_h[i] = 0.0f;
+        
+        for (int t = att_start; t <= pos; t++) {
+            float* v_t = s->value_cache + loff + t * kv_dim + (h / kv_mul) * head_size;
+            float a = s->att[att_offset + t];
+            axpy_f32_best(xb_h, v_t, a, head_size);
+        }
+    }
+}
+
+void transformer_forward(RunState* s, TransformerWeights* w, Config* p, int token, int pos) {
+    UINT64 start_cycles = __rdtsc();
+    int is_prefill = (pos == 0);
+    
+    // DjibMark: record entry into transformer (prefill vs decode determined by caller)
+    if (is_prefill) {
+        DJIBMARK_PREFILL();
+    } else {
+        DJIBMARK_DECODE();
+    }
+    
+    int dim = p->dim;
+    int hidden_dim = p->hidden_dim;
+    int n_layers = p->n_layers;
+    int n_heads = p->n_heads;
+    int kv_dim = (dim * p->n_kv_heads) / n_heads;
+    const LlmkArch *arch = &g_llmk_arch;
+    const int att_start = llmk_arch_attn_start(arch, pos);
+
+    const int q8_mode = g_cfg_q8_act_quant;
+    const int use_i8_attn = (q8_mode == 1) && llmk_has_avx2_cached();
+    const int use_i8_ffn = ((q8_mode == 1) || (q8_mode == 2)) && llmk_has_avx2_cached();
+    const int use_i8_cls = (q8_mode == 1) && llmk_has_avx2_cached();
+    INT8 *aq;
+    float *as;
+    oo_lora_model_t lora_model;
+    int lora_model_ready = 0;
+    
+    // Copy embedding
+    if (w->mx) {
+        llmk_mx_row(s->x, &w->mx->t[w->mx->n_layers * LLMK_MX_ROLES], (UINT32)token);
+    } else if (w->kind == 1) {
+        const UINT8 *row = w->token_embedding_table_q8 + (UINTN)token * (UINTN)w->tok_embd_row_bytes;
+        llmk_dequantize_q8_0_row(s->x, row, dim);
+    } else {
+        float* content_row = w->token_embedding_table + token * dim;
+        for (int i = 0; i < dim; i++) {
+            s->x[i] = content_row[i];
+        }
+    }
+    if (arch->embed_scale != 1.0f) {
+        for (int i = 0; i < dim; i++) s->x[i] *= arch->embed_scale;
+    }
+    
+    // Forward all layers
+    for (int l = 0; l < n_layers; l++) {
+        // Attention RMSNorm
+        rmsnorm_eps(s->xb, s->x, w->rms_att_weight + l*dim, dim, arch->norm_eps);
+        
+        // Under a mixed-precision plan the adapter (fused or merged: the plan
+        // holds the unmerged base) adds its low-rank term on top of the plan
+        const oo_lora_state_t *lora = w->mx ? NULL : llmk_lora_fused_state(l);
+        const oo_lora_state_t *mx_lora = w->mx ? llmk_lora_active_state(l) : NULL;
+        if (lora && !lora_model_ready) {
+            llmk_lora_model(w, p, &lora_model);
+            oo_lora_set_cpu(llmk_has_avx2_cached());
+            lora_model_ready = 1;
+        }
+
+        // Q, K, V matrices
+        if (w->mx) {
+            llmk_mx_matmul(s->q, s->xb, llmk_mx_tensor(w, l, LLMK_MX_WQ), 0, (UINT32)dim);
+            llmk_mx_matmul(s->k, s->xb, llmk_mx_tensor(w, l, LLMK_MX_WK), 0, (UINT32)kv_dim);
+            llmk_mx_matmul(s->v, s->xb, llmk_mx_tensor(w, l, LLMK_MX_WV), 0, (UINT32)kv_dim);
+            if (mx_lora) {
+                oo_lora_forward(&mx_lora->layers[l][OO_LORA_WQ], s->xb, s->q, (UINT32)dim);
+                oo_lora_forward(&mx_lora->layers[l][OO_LORA_WK], s->xb, s->k, (UINT32)kv_dim);
+                oo_lora_forward(&mx_lora->layers[l][OO_LORA_WV], s->xb, s->v, (UINT32)kv_dim);
+            }
+        } else if (lora) {
+            llmk_lora_matmul(s->q, s->xb, &lora_model, lora, OO_LORA_WQ, l);
+            llmk_lora_matmul(s->k, s->xb, &lora_model, lora, OO_LORA_WK, l);
+            llmk_lora_matmul(s->v, s->xb, &lora_model, lora, OO_LORA_WV, l);
+        } else if (w->kind == 1) {
+            if (use_i8_attn) {
+                llmk_act_q8(s, dim, &aq, &as);
+                llmk_quantize_f32_to_q8_blocks(s->xb, dim, aq, as);
+                matmul_q8_0_avx2_i8_prequant(s->q, aq, as, w->wq_q8 + (UINTN)l * (UINTN)w->wq_layer_bytes, dim, dim);
+                matmul_q8_0_avx2_i8_prequant(s->k, aq, as, w->wk_q8 + (UINTN)l * (UINTN)w->wk_layer_bytes, dim, kv_dim);
+                matmul_q8_0_avx2_i8_prequant(s->v, aq, as, w->wv_q8 + (UINTN)l * (UINTN)w->wv_layer_bytes, dim, kv_dim);
+            } else {
+                matmul_q8_0(s->q, s->xb, w->wq_q8 + (UINTN)l * (UINTN)w->wq_layer_bytes, dim, dim);
+                matmul_q8_0(s->k, s->xb, w->wk_q8 + (UINTN)l * (UINTN)w->wk_layer_bytes, dim, kv_dim);
+                matmul_q8_0(s->v, s->xb, w->wv_q8 + (UINTN)l * (UINTN)w->wv_layer_bytes, dim, kv_dim);
+            }
+        } else {
+            matmul(s->q, s->xb, w->wq + l*dim*dim, dim, dim);
+            matmul(s->k, s->xb, w->wk + l*dim*kv_dim, dim, kv_dim);
+            matmul(s->v, s->xb, w->wv + l*dim*kv_dim, dim, kv_dim);
+        }
+        if (w->bq) {
+            const float *bq = w->bq + l*dim, *bk = w->bk + l*kv_dim, *bv = w->bv + l*kv_dim;
+            for (int i = 0; i < dim; i++) s->q[i] += bq[i];
+            for (int i = 0; i < kv_dim; i++) { s->k[i] += bk[i]; s->v[i] += bv[i]; }
+        }
+        
+        // RoPE epilogue + store in KV cache: q rotates in place, k is rotated
+        // straight into its cache row
+        int loff = l * p->seq_len * kv_dim;
+        float* key_cache_row = s->key_cache + loff + pos * kv_dim;
+        float* value_cache_row = s->value_cache + loff + pos * kv_dim;
+        if (g_llmk_rope.ready) {
+            llmk_rope_rotate(&g_llmk_rope, s->q, s->q, n_heads, pos);
+            llmk_rope_rotate(&g_llmk_rope, key_cache_row, s->k, p->n_kv_heads, pos);
+        } else {
+            for (int i = 0; i < kv_dim; i++) key_cache_row[i] = s->k[i];
+        }
+        for (int i = 0; i < kv_dim; i++) {
+            value_cache_row[i] = s->v[i];
+        }
+        
+        // Multihead attention
+        llmk_attention(s, p, s->q, s->xb, loff, pos, att_start);
+        pheromion_touch(&g_pheromion, 1);
+        // Output projection
+        if (w->mx) {
+            llmk_mx_matmul(s->xb2, s->xb, llmk_mx_tensor(w, l, LLMK_MX_WO), 0, (UINT32)dim);
+            if (mx_lora) oo_lora_forward(&mx_lora->layers[l][OO_LORA_WO], s->xb, s->xb2, (UINT32)dim);
+        } else if (lora) {
+            llmk_lora_matmul(s->xb2, s->xb, &lora_model, lora, OO_LORA_WO, l);
+        } else if (w->kind == 1) {
+            if (use_i8_attn) {
+                llmk_act_q8(s, dim, &aq, &as);
+                llmk_quantize_f32_to_q8_blocks(s->xb, dim, aq, as);
+                matmul_q8_0_avx2_i8_prequant(s->xb2, aq, as, w->wo_q8 + (UINTN)l * (UINTN)w->wo_layer_bytes, dim, dim);
+            } else {
+                matmul_q8_0(s->xb2, s->xb, w->wo_q8 + (UINTN)l * (UINTN)w->wo_layer_bytes, dim, dim);
+            }
+        } else {
+            matmul(s->xb2, s->xb, w->wo + l*dim*dim, dim, dim);
+        }
+        
+        // Residual
+        for (int i = 0; i < dim; i++) {
+            s->x[i] += s->xb2[i];
+        }
+        
+        // FFN RMSNorm
+        rmsnorm_eps(s->xb, s->x, w->rms_ffn_weight + l*dim, dim, arch->norm_eps);
+        
+        // FFN
+        if (w->mx) {
+            llmk_mx_matmul(s->hb, s->xb, llmk_mx_tensor(w, l, LLMK_MX_W1), 0, (UINT32)hidden_dim);
+            llmk_mx_matmul(s->hb2, s->xb, llmk_mx_tensor(w, l, LLMK_MX_W3), 0, (UINT32)hidden_dim);
+            if (mx_lora) {
+                oo_lora_forward(&mx_lora->layers[l][OO_LORA_W1], s->xb, s->hb, (UINT32)hidden_dim);
+                oo_lora_forward(&mx_lora->layers[l][OO_LORA_W3], s->xb, s->hb2, (UINT32)hidden_dim);
+            }
+        } else if (lora) {
+            llmk_lora_matmul(s->hb, s->xb, &lora_model, lora, OO_LORA_W1, l);
+            llmk_lora_matmul(s->hb2, s->xb, &lora_model, lora, OO_LORA_W3, l);
+        } else if (w->kind == 1) {
+            if (use_i8_ffn) {
+                llmk_act_q8(s, dim, &aq, &as);
+                llmk_quantize_f32_to_q8_blocks(s->xb, dim, aq, as);
+                matmul_q8_0_avx2_i8_prequant(s->hb, aq, as, w->w1_q8 + (UINTN)l * (UINTN)w->w1_layer_bytes, dim, hidden_dim);
+                matmul_q8_0_avx2_i8_prequant(s->hb2, aq, as, w->w3_q8 + (UINTN)l * (UINTN)w->w3_layer_bytes, dim, hidden_dim);
+            } else {
+                matmul_q8_0(s->hb, s->xb, w->w1_q8 + (UINTN)l * (UINTN)w->w1_layer_bytes, dim, hidden_dim);
+                matmul_q8_0(s->hb2, s->xb, w->w3_q8 + (UINTN)l * (UINTN)w->w3_layer_bytes, dim, hidden_dim);
+            }
+        } else {
+            matmul(s->hb, s->xb, w->w1 + l*dim*hidden_dim, dim, hidden_dim);
+            matmul(s->hb2, s->xb, w->w3 + l*dim*hidden_dim, dim, hidden_dim);
+        }
+        
+        pheromion_touch(&g_pheromion, 2);
+        // SwiGLU (GeGLU for gemma)
+        if (arch->act == LLMK_ARCH_ACT_GELU_TANH) {
+            for (int i = 0; i < hidden_dim; i++) s->hb[i] = gelu_tanh(s->hb[i]) * s->hb2[i];
+        } else {
+            for (int i = 0; i < hidden_dim; i++) {
+                float val = s->hb[i];
+                val *= (1.0f / (1.0f + fast_exp(-val)));
+                s->hb[i] = val * s->hb2[i];
+            }
+        }
+        
+        if (w->mx) {
+            llmk_mx_matmul(s->xb, s->hb, llmk_mx_tensor(w, l, LLMK_MX_W2), 0, (UINT32)dim);
+            if (mx_lora) oo_lora_forward(&mx_lora->layers[l][OO_LORA_W2], s->hb, s->xb, (UINT32)dim);
+        } else if (lora) {
+            llmk_lora_matmul(s->xb, s->hb, &lora_model, lora, OO_LORA_W2, l);
+        } else if (w->kind == 1) {
+            if (use_i8_ffn) {
+                llmk_act_q8(s, hidden_dim, &aq, &as);
+                llmk_quantize_f32_to_q8_blocks(s->hb, hidden_dim, aq, as);
+                matmul_q8_0_avx2_i8_prequant(s->xb, aq, as, w->w2_q8 + (UINTN)l * (UINTN)w->w2_layer_bytes, hidden_dim, dim);
+            } else {
+                matmul_q8_0(s->xb, s->hb, w->w2_q8 + (UINTN)l * (UINTN)w->w2_layer_bytes, hidden_dim, dim);
+            }
+        } else {
+            matmul(s->xb, s->hb, w->w2 + l*dim*hidden_dim, hidden_dim, dim);
+        }
+        
+        // Residual
+        for (int i = 0; i < dim; i++) {
+            s->x[i] += s->xb[i];
+        }
+    }
+    
+    // Final RMSNorm
+    rmsnorm_eps(s->x, s->x, w->rms_final_weight, dim, arch->norm_eps);
+    
+    // Classifier
+    if (!llmk_shortlist_usable(s, p) || !llmk_classifier_shortlist(s, w, p)) {
+        llmk_classifier_full(s, w, p, use_i8_cls);
+    }
+    
+    // M16.1: Capture transformer metrics
+    UINT64 end_cycles = __rdtsc();
+    UINT64 elapsed = (end_cycles > start_cycles) ? (end_cycles - start_cycles) : 0;
+    
+    if (is_prefill) {
+        g_metrics.total_prefill_cycles += elapsed;
+        g_metrics.total_prefill_tokens++;
+        g_metrics.total_prefill_calls++;
+        g_metrics.last_prefill_cycles = elapsed;
+        g_metrics.last_prefill_tokens = 1;
+    } else {
+        g_metrics.total_decode_cycles += elapsed;
+        g_metrics.total_decode_tokens++;
+        g_metrics.total_decode_calls++;
+        g_metrics.last_decode_cycles = elapsed;
+        g_metrics.last_decode_tokens = 1;
+    }
+}
+
+// ============================================================================
+// BATCHED FORWARD (speculative verification)
+// ============================================================================
+
+// Rows of the batch activations: the f32 batched matmul reads its input in
+// groups of 4 rows.
+static UINT64 llmk_batch_rows(int cap) {
+    return ((UINT64)cap + 3) & ~(UINT64)3;
+}
+
+UINT64 llmk_batch_bytes(const Config *p, int cap) {
+    if (cap <= 0 || cap > LLMK_MATMUL_BATCH_MAX) return 0;
+    UINT64 rows = llmk_batch_rows(cap);
+    UINT64 kv_dim = ((UINT64)p->dim * (UINT64)p->n_kv_heads) / (UINT64)p->n_heads;
+    UINT64 floats = rows * (4 * (UINT64)p->dim + 2 * kv_dim + 2 * (UINT64)p->hidden_dim)
+                  + (UINT64)cap * (UINT64)p->vocab_size;
+    return floats * sizeof(float);
+}
+
+int llmk_batch_init(RunBatch *b, const Config *p, void *mem, UINT64 bytes, int cap) {
+    if (!b || !mem || bytes < llmk_batch_bytes(p, cap) || llmk_batch_bytes(p, cap) == 0) return -1;
+    UINT64 rows = llmk_batch_rows(cap);
+    UINT64 kv_dim = ((UINT64)p->dim * (UINT64)p->n_kv_heads) / (UINT64)p->n_heads;
+    float *f = (float *)mem;
+    b->cap = cap;
+    b->x = f;      f += rows * (UINT64)p->dim;
+    b->xb = f;     f += rows * (UINT64)p->dim;
+    b->xb2 = f;    f += rows * (UINT64)p->dim;
+    b->q = f;      f += rows * (UINT64)p->dim;
+    b->k = f;      f += rows * kv_dim;
+    b->v = f;      f += rows * kv_dim;
+    b->hb = f;     f += rows * (UINT64)p->hidden_dim;
+    b->hb2 = f;    f += rows * (UINT64)p->hidden_dim;
+    b->logits = f;
+    return 0;
+}
+
+// out[t] = W * in[t] for nt rows, through the kernel transformer_forward
+// uses for one row (use_i8: int8 activations, quantized row by row)
+static void llmk_batch_matmul(RunState *s, float *out, float *in, float *wf, const UINT8 *wq, int use_i8,
+                              int n, int d, int nt) {
+    if (!wq) {
+        matmul_batch(out, in, wf, n, d, nt);
+    } else if (use_i8) {
+        INT8 *aq;
+        float *as;
+        llmk_act_q8(s, n, &aq, &as);
+        for (int t = 0; t < nt; t++) {
+            llmk_quantize_f32_to_q8_blocks(in + (UINTN)t * (UINTN)n, n, aq, as);
+            matmul_q8_0_avx2_i8_prequant(out + (UINTN)t * (UINTN)d, aq, as, wq, n, d);
+        }
+    } else {
+        matmul_q8_0_batch(out, in, wq, n, d, nt);
+    }
+}
+
+// tokens[0..nt) at positions pos..pos+nt-1 in one pass: every weight matrix
+// is streamed once for the whole batch instead of once per token. The KV rows
+// of all positions are written first, then each position attends causally up
+// to itself, so b->logits row t is bit-identical to what transformer_forward
+// returns for tokens[t] after the t tokens before it. Rows a caller rejects
+// are simply overwritten by the next pass. Uses s->att and s->x/s->logits
+// (classifier views) as scratch. Layers with a fused LoRA adapter and
+// mixed-precision plans take the one-token path. Returns the number of
+// positions evaluated (<= b->cap).
+int transformer_forward_batch(RunState *s, TransformerWeights *w, Config *p, RunBatch *b,
+                              const int *tokens, int nt, int pos) {
+    if (nt > b->cap) nt = b->cap;
+    if (nt <= 0) return 0;
+
+    int dim = p->dim;
+    int hidden_dim = p->hidden_dim;
+    int n_layers = p->n_layers;
+    int vocab = p->vocab_size;
+    int kv_dim = (dim * p->n_kv_heads) / p->n_heads;
+    const LlmkArch *arch = &g_llmk_arch;
+
+    int lora_any = 0;
+    for (int l = 0; l < n_layers; l++) {
+        if (llmk_lora_fused_state(l)) lora_any = 1;
+    }
+    if (nt == 1 || lora_any || w->mx) {
+        for (int t = 0; t < nt; t++) {
+            transformer_forward(s, w, p, tokens[t], pos + t);
+            for (int i = 0; i < vocab; i++) b->logits[(UINTN)t * (UINTN)vocab + i] = s->logits[i];
+        }
+        return nt;
+    }
+
+    UINT64 start_cycles = __rdtsc();
+    DJIBMARK_DECODE();
+
+    const int q8_mode = g_cfg_q8_act_quant;
+    const int use_i8_attn = (q8_mode == 1) && llmk_has_avx2_cached();
+    const int use_i8_ffn = ((q8_mode == 1) || (q8_mode == 2)) && llmk_has_avx2_cached();
+    const int use_i8_cls = (q8_mode == 1) && llmk_has_avx2_cached();
+    const int q8 = (w->kind == 1);
+
+    // Embeddings
+    for (int t = 0; t < nt; t++) {
+        float *x = b->x + (UINTN)t * (UINTN)dim;
+        if (q8) {
+            llmk_dequantize_q8_0_row(x, w->token_embedding_table_q8 + (UINTN)tokens[t] * (UINTN)w->tok_embd_row_bytes, dim);
+        } else {
+            const float *content_row = w->token_embedding_table + tokens[t] * dim;
+            for (int i = 0; i < dim; i++) x[i] = content_row[i];
+        }
+        if (arch->embed_scale != 1.0f) {
+            for (int i = 0; i < dim; i++) x[i] *= arch->embed_scale;
+        }
+    }
+
+    for (int l = 0; l < n_layers; l++) {
+        for (int t = 0; t < nt; t++) {
+            rmsnorm_eps(b->xb + (UINTN)t * (UINTN)dim, b->x + (UINTN)t * (UINTN)dim, w->rms_att_weight + l*dim, dim, arch->norm_eps);
+        }
+
+        // Q, K, V for the whole batch
+        llmk_batch_matmul(s, b->q, b->xb, q8 ? NULL : w->wq + l*dim*dim,
+                          q8 ? w->wq_q8 + (UINTN)l * (UINTN)w->wq_layer_bytes : NULL, use_i8_attn, dim, dim, nt);
+        llmk_batch_matmul(s, b->k, b->xb, q8 ? NULL : w->wk + l*dim*kv_dim,
+                          q8 ? w->wk_q8 + (UINTN)l * (UINTN)w->wk_layer_bytes : NULL, use_i8_attn, dim, kv_dim, nt);
+        llmk_batch_matmul(s, b->v, b->xb, q8 ? NULL : w->wv + l*dim*kv_dim,
+                          q8 ? w->wv_q8 + (UINTN)l * (UINTN)w->wv_layer_bytes : NULL, use_i8_attn, dim, kv_dim, nt);
+
+        // Biases, RoPE and the KV rows of every position
+        int loff = l * p->seq_len * kv_dim;
+        for (int t = 0; t < nt; t++) {
+            float *q = b->q + (UINTN)t * (UINTN)dim;
+            float *k = b->k + (UINTN)t * (UINTN)kv_dim;
+            float *v = b->v + (UINTN)t * (UINTN)kv_dim;
+            if (w->bq) {
+                const float *bq = w->bq + l*dim, *bk = w->bk + l*kv_dim, *bv = w->bv + l*kv_dim;
+                for (int i = 0; i < dim; i++) q[i] += bq[i];
+                for (int i = 0; i < kv_dim; i++) { k[i] += bk[i]; v[i] += bv[i]; }
+            }
+            float* key_cache_row = s->key_cache + loff + (pos + t) * kv_dim;
+            float* value_cache_row = s->value_cache + loff + (pos + t) * kv_dim;
+            if (g_llmk_rope.ready) {
+                llmk_rope_rotate(&g_llmk_rope, q, q, p->n_heads, pos + t);
+                llmk_rope_rotate(&g_llmk_rope, key_cache_row, k, p->n_kv_heads, pos + t);
+            } else {
+                for (int i = 0; i < kv_dim; i++) key_cache_row[i] = k[i];
+            }
+            for (int i = 0; i < kv_dim; i++) value_cache_row[i] = v[i];
+        }
+
+        // Causal attention, one position at a time
+        for (int t = 0; t < nt; t++) {
+            llmk_attention(s, p, b->q + (UINTN)t * (UINTN)dim, b->xb + (UINTN)t * (UINTN)dim,
+                           loff, pos + t, llmk_arch_attn_start(arch, pos + t));
+        }
+        pheromion_touch(&g_pheromion, 1);
+
+        llmk_batch_matmul(s, b->xb2, b->xb, q8 ? NULL : w->wo + l*dim*dim,
+                          q8 ? w->wo_q8 + (UINTN)l * (UINTN)w->wo_layer_bytes : NULL, use_i8_attn, dim, dim, nt);
+        for (int t = 0; t < nt; t++) {
+            float *x = b->x + (UINTN)t * (UINTN)dim;
+            const float *xb2 = b->xb2 + (UINTN)t * (UINTN)dim;
+            for (int i = 0; i < dim; i++) x[i] += xb2[i];
+            rmsnorm_eps(b->xb + (UINTN)t * (UINTN)dim, x, w->rms_ffn_weight + l*dim, dim, arch->norm_eps);
+        }
+
+        // FFN
+        llmk_batch_matmul(s, b->hb, b->xb, q8 ? NULL : w->w1 + l*dim*hidden_dim,
+                          q8 ? w->w1_q8 + (UINTN)l * (UINTN)w->w1_layer_bytes : NULL, use_i8_ffn, dim, hidden_dim, nt);
+        llmk_batch_matmul(s, b->hb2, b->xb, q8 ? NULL : w->w3 + l*dim*hidden_dim,
+                          q8 ? w->w3_q8 + (UINTN)l * (UINTN)w->w3_layer_bytes : NULL, use_i8_ffn, dim, hidden_dim, nt);
+        pheromion_touch(&g_pheromion, 2);
+        for (int t = 0; t < nt; t++) {
+            float *hb = b->hb + (UINTN)t * (UINTN)hidden_dim;
+            const float *hb2 = b->hb2 + (UINTN)t * (UINTN)hidden_dim;
+            if (arch->act == LLMK_ARCH_ACT_GELU_TANH) {
+                for (int i = 0; i < hidden_dim; i++) hb[i] = gelu_tanh(hb[i]) * hb2[i];
+            } else {
+                for (int i = 0; i < hidden_dim; i++) {
+                    float val = hb[i];
+                    val *= (1.0f / (1.0f + fast_exp(-val)));
+                    hb[i] = val * hb2[i];
+                }
+            }
+        }
+        llmk_batch_matmul(s, b->xb, b->hb, q8 ? NULL : w->w2 + l*dim*hidden_dim,
+                          q8 ? w->w2_q8 + (UINTN)l * (UINTN)w->w2_layer_bytes : NULL, use_i8_ffn, hidden_dim, dim, nt);
+        for (int t = 0; t < nt; t++) {
+            float *x = b->x + (UINTN)t * (UINTN)dim;
+            const float *xb = b->xb + (UINTN)t * (UINTN)dim;
+            for (int i = 0; i < dim; i++) x[i] += xb[i];
+        }
+    }
+
+    for (int t = 0; t < nt; t++) {
+        float *x = b->x + (UINTN)t * (UINTN)dim;
+        rmsnorm_eps(x, x, w->rms_final_weight, dim, arch->norm_eps);
+    }
+
+    // Classifier: batched f32 / Q8_0 rows unless the shortlist or int8
+    // activations apply, which go row by row through a view of s
+    if (!llmk_shortlist_usable(s, p) && !use_i8_cls) {
+        llmk_batch_matmul(s, b->logits, b->x, q8 ? NULL : w->wcls, q8 ? w->wcls_q8 : NULL, 0, dim, vocab, nt);
+    } else {
+        RunState view = *s;
+        for (int t = 0; t < nt; t++) {
+            view.x = b->x + (UINTN)t * (UINTN)dim;
+            view.logits = b->logits + (UINTN)t * (UINTN)vocab;
+            if (!llmk_shortlist_usable(s, p) || !llmk_classifier_shortlist(&view, w, p)) {
+                llmk_classifier_full(&view, w, p, use_i8_cls);
+            }
+        }
+    }
+
+    UINT64 end_cycles = __rdtsc();
+    UINT64 elapsed = (end_cycles > start_cycles) ? (end_cycles - start_cycles) : 0;
+    g_metrics.total_decode_cycles += elapsed;
+    g_metrics.total_decode_tokens += nt;
+    g_metrics.total_decode_calls++;
+    g_metrics.last_decode_cycles = elapsed;
+    g_metrics.last_decode_tokens = nt;
+    return nt;
+}
@@ -0,0 +1,196 @@
+// llmk_gen.c — Per-generation state: sampler settings, RNG, penalty
+// history, scratch and the KV cache a generation decodes into
+//
+// Unity fragment (soma_inference.c, engine/host/llmk_host_rt.c), after
+// llmk_forward.c, llmk_sampler.c and llmk_repeat.c.
+//
+// Sampling settings, the sampler's RNG and top-k scratch, the repeat index
+// and the int8 activation buffers used to be process-wide, so the REPL, the
+// OO consult and anything else that generated overwrote each other's
+// settings and RNG draws, and no two generations could run at once. A
+// LlmkGenState owns all of it; weights, Config and the RoPE/arch tables are
+// the only shared inputs and are read-only during decode. Two states over
+// separate RunStates can decode on different cores, and interleaving their
+// steps on one core gives each exactly the tokens it produces alone.
+//
+// Still process-wide: the classifier shortlist scratch (llmk_run_state_init
+// sets cls_full, so private states never use it), the grammar runtime, the
+// KV window and the metrics counters. Those stay with the REPL's state.
+
+#define LLMK_GEN_PEN_WINDOW  64    // tokens the repeat/frequency penalties look back
+
+typedef struct {
+    // Sampler settings (llmk_gen_set)
+    float temperature;
+    float min_p;
+    float top_p;
+    int   top_k;                   // 0..LLMK_SAMPLE_MAX_TOP_K, 0 = off
+    float repeat_penalty;
+    float freq_penalty;            // logit -= count * f over the penalty window
+    float presence_penalty;        // logit -= p for tokens in the penalty window
+    int   no_repeat_ngram;         // 0 = off
+
+    LlmkSampler sampler;           // RNG + top-k scratch
+
+    // Penalty history: the tokens fed and sampled so far, and the n-gram /
+    // count index over them (rep.vocab == 0: no index, nothing is banned)
+    int        *hist;
+    int         n_hist;
+    int         hist_cap;
+    LlmkRepeat  rep;
+
+    // KV handle: the RunState decoded into and its next free cache row
+    RunState   *state;
+    int         pos;
+    float      *logits;            // logits to sample next
+} LlmkGenState;
+
+static UINT64 llmk_gen_align(UINT64 n) {
+    return (n + 63u) & ~(UINT64)63u;
+}
+
+// Activations, int8 scratch and a full [n_layers][seq_len][kv_dim] KV cache
+UINT64 llmk_run_state_bytes(const Config *c) {
+    const UINT64 kv_dim = (UINT64)((c->dim * c->n_kv_heads) / c->n_heads);
+    const UINT64 act = (c->hidden_dim > c->dim) ? (UINT64)c->hidden_dim : (UINT64)c->dim;
+    UINT64 b = 0;
+    b += 3 * llmk_gen_align((UINT64)c->dim * 4);                     // x, xb, xb2
+    b += 2 * llmk_gen_align((UINT64)c->hidden_dim * 4);              // hb, hb2
+    b += llmk_gen_align((UINT64)c->dim * 4);                         // q
+    b += 2 * llmk_gen_align(kv_dim * 4);                             // k, v
+    b += llmk_gen_align((UINT64)c->n_heads * (UINT64)c->seq_len * 4);
+    b += llmk_gen_align((UINT64)c->vocab_size * 4);
+    b += 2 * llmk_gen_align((UINT64)c->n_layers * (UINT64)c->seq_len * kv_dim * 4);
+    b += llmk_gen_align(act) + llmk_gen_align((act / 32 + 1) * 4);   // int8 activations
+    return b;
+}
+
+// A RunState of its own, carved from mem: private int8 scratch, full
+// classifier, empty cache. Returns 0 or -1 (mem too small).
+int llmk_run_state_init(RunState *s, const Config *c, void *mem, UINT64 bytes) {
+    if (!s || !mem || bytes < llmk_run_state_bytes(c)) return -1;
+    const UINT64 kv_dim = (UINT64)((c->dim * c->n_kv_heads) / c->n_heads);
+    const UINT64 act = (c->hidden_dim > c->dim) ? (UINT64)c->hidden_dim : (UINT64)c->dim;
+    const UINT64 kv = (UINT64)c->n_layers * (UINT64)c->seq_len * kv_dim;
+    UINT8 *p = (UINT8 *)mem;
+    s->x = (float *)p;           p += llmk_gen_align((UINT64)c->dim * 4);
+    s->xb = (float *)p;          p += llmk_gen_align((UINT64)c->dim * 4);
+    s->xb2 = (float *)p;         p += llmk_gen_align((UINT64)c->dim * 4);
+    s->hb = (float *)p;          p += llmk_gen_align((UINT64)c->hidden_dim * 4);
+    s->hb2 = (float *)p;         p += llmk_gen_align((UINT64)c->hidden_dim * 4);
+    s->q = (float *)p;           p += llmk_gen_align((UINT64)c->dim * 4);
+    s->k = (float *)p;           p += llmk_gen_align(kv_dim * 4);
+    s->v = (float *)p;           p += llmk_gen_align(kv_dim * 4);
+    s->att = (float *)p;         p += llmk_gen_align((UINT64)c->n_heads * (UINT64)c->seq_len * 4);
+    s->logits = (float *)p;      p += llmk_gen_align((UINT64)c->vocab_size * 4);
+    s->key_cache = (float *)p;   p += llmk_gen_align(kv * 4);
+    s->value_cache = (float *)p; p += llmk_gen_align(kv * 4);
+    s->q8_qs = (INT8 *)p;        p += llmk_gen_align(act);
+    s->q8_scales = (float *)p;
+    s->cls_full = 1;
+    for (UINT64 i = 0; i < kv; i++) {
+        s->key_cache[i] = 0.0f;
+        s->value_cache[i] = 0.0f;
+    }
+    return 0;
+}
+
+UINT64 llmk_gen_bytes(const Config *c, int hist_cap) {
+    if (hist_cap <= 0) return 0;
+    return llmk_gen_align((UINT64)hist_cap * 4) + llmk_rep_bytes(c->vocab_size, hist_cap);
+}
+
+// Plain sampling (temperature 1, no filters or penalties), seed as
+// g_sample_seed's default, history empty at kv->pos 0. Returns 0 or -1.
+int llmk_gen_init(LlmkGenState *g, const Config *c, RunState *kv, void *mem, UINT64 bytes, int hist_cap) {
+    if (!g || !kv || !mem || bytes < llmk_gen_bytes(c, hist_cap) || hist_cap <= 0) return -1;
+    UINT8 *p = (UINT8 *)mem;
+    const UINT64 hbytes = llmk_gen_align((UINT64)hist_cap * 4);
+    g->hist = (int *)p;
+    g->hist_cap = hist_cap;
+    g->n_hist = 0;
+    if (llmk_rep_init(&g->rep, p + hbytes, bytes - hbytes, c->vocab_size, hist_cap, 0, 0,
+                      LLMK_GEN_PEN_WINDOW) != LLMK_REP_OK) {
+        return -1;
+    }
+    g->temperature = 1.0f;
+    g->min_p = 0.0f;
+    g->top_p = 1.0f;
+    g->top_k = 0;
+    g->repeat_penalty = 1.0f;
+    g->freq_penalty = 0.0f;
+    g->presence_penalty = 0.0f;
+    g->no_repeat_ngram = 0;
+    g->sampler.seed = 1234567;
+    g->sampler.draws = 0;
+    g->state = kv;
+    g->pos = 0;
+    g->logits = kv->logits;
+    return 0;
+}
+
+void llmk_gen_set(LlmkGenState *g, float temperature, float min_p, float top_p, int top_k,
+                  float repeat_penalty, float freq_penalty, float presence_penalty, int no_repeat_ngram) {
+    g->temperature = temperature;
+    g->min_p = min_p;
+    g->top_p = top_p;
+    g->top_k = top_k;
+    g->repeat_penalty = repeat_penalty;
+    g->freq_penalty = freq_penalty;
+    g->presence_penalty = presence_penalty;
+    if (no_repeat_ngram != g->no_repeat_ngram && g->rep.vocab) {
+        llmk_rep_configure(&g->rep, g->hist, no_repeat_ngram, 0, LLMK_GEN_PEN_WINDOW);
+    }
+    g->no_repeat_ngram = no_repeat_ngram;
+}
+
+void llmk_gen_seed(LlmkGenState *g, unsigned int seed) {
+    g->sampler.seed = seed ? seed : 1;
+    g->sampler.draws = 0;
+}
+
+// Empties the penalty history (a new turn); the KV cache is untouched
+void llmk_gen_begin(LlmkGenState *g) {
+    g->n_hist = 0;
+    if (g->rep.vocab) llmk_rep_reset(&g->rep);
+}
+
+// Appends tok to the penalty history (dropped once hist_cap is reached)
+void llmk_gen_push(LlmkGenState *g, int tok) {
+    if (g->n_hist >= g->hist_cap) return;
+    g->hist[g->n_hist++] = tok;
+    if (g->rep.vocab) llmk_rep_sync(&g->rep, g->hist, g->n_hist);
+}
+
+// n-gram ban, penalties and one draw from logits (modified in place)
+int llmk_gen_sample(LlmkGenState *g, float *logits, int vocab) {
+    if (g->rep.vocab) {
+        llmk_rep_ban(&g->rep, logits);
+        llmk_rep_penalize(&g->rep, logits, g->repeat_penalty, g->freq_penalty, g->presence_penalty);
+    }
+    return llmk_sample(&g->sampler, logits, vocab, g->temperature, g->min_p, g->top_p, g->top_k,
+                       (int *)0, 0, 1.0f);
+}
+
+// Feeds tokens at g->pos onward: into the history and the KV cache.
+// Returns 0, or -1 when they do not fit in the cache (nothing is fed).
+int llmk_gen_prefill(LlmkGenState *g, TransformerWeights *w, Config *c, const int *tokens, int n) {
+    if (n <= 0 || g->pos + n > c->seq_len) return -1;
+    for (int i = 0; i < n; i++) {
+        llmk_gen_push(g, tokens[i]);
+        transformer_forward(g->state, w, c, tokens[i], g->pos++);
+    }
+    g->logits = g->state->logits;
+    return 0;
+}
+
+// Samples the next token from g->logits and feeds it. Returns the token,
+// or -1 when the cache is full.
+int llmk_gen_step(LlmkGenState *g, TransformerWeights *w, Config *c) {
+    if (g->pos >= c->seq_len) return -1;
+    const int tok = llmk_gen_sample(g, g->logits, c->vocab_size);
+    llmk_gen_push(g, tok);
+    transformer_forward(g->state, w, c, tok, g->pos++);
+    g->logits = g->state->logits;
+    return tok;
+}
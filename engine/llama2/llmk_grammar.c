@@ -0,0 +1,1324 @@
+/* llmk_grammar.c — Grammar-constrained decoding
+ *
+ * See llmk_grammar.h. Unity-included by soma_inference.c and the host
+ * runtime, after llmk_tokenizer.c.
+ */
+
+#include "llmk_grammar.h"
+
+/* ── Small freestanding helpers ────────────────────────────────────────── */
+
+static void gr_zero(void *p, uint64_t n) {
+    uint8_t *b = (uint8_t *)p;
+    for (uint64_t i = 0; i < n; i++) b[i] = 0;
+}
+
+static int gr_strlen(const char *s) {
+    int n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+/* The n bytes at s equal the NUL-terminated word */
+static int gr_eq(const char *s, int n, const char *word) {
+    for (int i = 0; i < n; i++) {
+        if (word[i] != s[i]) return 0;
+    }
+    return word[n] == 0;
+}
+
+static int gr_is_word(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '_';
+}
+
+static int gr_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Appends s to buf[*len..cap-1), keeping it NUL-terminated */
+static void gr_cat(char *buf, int cap, int *len, const char *s) {
+    while (*s && *len < cap - 1) buf[(*len)++] = *s++;
+    buf[*len] = 0;
+}
+
+static void gr_cat_int(char *buf, int cap, int *len, int v) {
+    char tmp[12];
+    int n = 0;
+    if (v < 0) {
+        gr_cat(buf, cap, len, "-");
+        v = -v;
+    }
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v && n < 11);
+    char out[12];
+    for (int i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    out[n] = 0;
+    gr_cat(buf, cap, len, out);
+}
+
+/* ── GBNF parser ───────────────────────────────────────────────────────── */
+
+#define GR_UNDEFINED 0xFFFFu
+
+typedef struct {
+    LlmkGrammar *g;
+    const char  *s;
+    int          n, i;
+    int          line;
+    int          n_work;                /* used entries of g->scratch */
+    int          failed;
+} GrParser;
+
+static void gr_fail(GrParser *p, int rc, const char *msg, const char *arg) {
+    if (p->failed) return;
+    p->failed = rc;
+    int len = 0;
+    p->g->err[0] = 0;
+    gr_cat(p->g->err, (int)sizeof(p->g->err), &len, "line ");
+    gr_cat_int(p->g->err, (int)sizeof(p->g->err), &len, p->line);
+    gr_cat(p->g->err, (int)sizeof(p->g->err), &len, ": ");
+    gr_cat(p->g->err, (int)sizeof(p->g->err), &len, msg);
+    if (arg) gr_cat(p->g->err, (int)sizeof(p->g->err), &len, arg);
+}
+
+static char gr_peek(const GrParser *p) {
+    return p->i < p->n ? p->s[p->i] : 0;
+}
+
+/* Skips blanks and # comments; newlines only when newline_ok */
+static void gr_space(GrParser *p, int newline_ok) {
+    while (p->i < p->n) {
+        char c = p->s[p->i];
+        if (c == ' ' || c == '\t') {
+            p->i++;
+        } else if (c == '#') {
+            while (p->i < p->n && p->s[p->i] != '\n' && p->s[p->i] != '\r') p->i++;
+        } else if (newline_ok && (c == '\n' || c == '\r')) {
+            if (c == '\n') p->line++;
+            p->i++;
+        } else {
+            break;
+        }
+    }
+}
+
+/* Rule id for a user name, created undefined on first mention */
+static int gr_symbol(GrParser *p, const char *name, int len) {
+    LlmkGrammar *g = p->g;
+    for (int r = 0; r < g->n_rules; r++) {
+        if (gr_eq(name, len, g->rule_name[r])) return r;
+    }
+    if (g->n_rules >= LLMK_GRAMMAR_MAX_RULES) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "too many rules", 0);
+        return 0;
+    }
+    if (len > 31) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "rule name too long", 0);
+        return 0;
+    }
+    int r = g->n_rules++;
+    for (int k = 0; k < len; k++) g->rule_name[r][k] = name[k];
+    g->rule_name[r][len] = 0;
+    g->rule_start[r] = GR_UNDEFINED;
+    return r;
+}
+
+/* Synthetic rule for a group or repetition, named "<parent>.<id>" (a dot
+ * cannot appear in user names, so lookups never find it) */
+static int gr_new_rule(GrParser *p, int parent) {
+    LlmkGrammar *g = p->g;
+    if (g->n_rules >= LLMK_GRAMMAR_MAX_RULES) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "too many rules", 0);
+        return 0;
+    }
+    int r = g->n_rules++;
+    int len = 0;
+    char *name = g->rule_name[r];
+    name[0] = 0;
+    for (int k = 0; k < 20 && g->rule_name[parent][k] && g->rule_name[parent][k] != '.'; k++) {
+        name[len++] = g->rule_name[parent][k];
+    }
+    name[len] = 0;
+    gr_cat(name, 32, &len, ".");
+    gr_cat_int(name, 32, &len, r);
+    g->rule_start[r] = GR_UNDEFINED;
+    return r;
+}
+
+static void gr_push(GrParser *p, uint16_t type, uint16_t value) {
+    if (p->n_work >= LLMK_GRAMMAR_MAX_ELEMS) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "grammar too large", 0);
+        return;
+    }
+    p->g->scratch[p->n_work].type = type;
+    p->g->scratch[p->n_work].value = value;
+    p->n_work++;
+}
+
+/* Moves scratch[from..n_work) into the element array as rule r's body */
+static void gr_define(GrParser *p, int r, int from) {
+    LlmkGrammar *g = p->g;
+    int len = p->n_work - from;
+    if (p->failed) return;
+    if (g->n_elem + len > LLMK_GRAMMAR_MAX_ELEMS) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "grammar too large", 0);
+        return;
+    }
+    g->rule_start[r] = (uint16_t)g->n_elem;
+    for (int k = 0; k < len; k++) g->elem[g->n_elem++] = g->scratch[from + k];
+    p->n_work = from;
+}
+
+/* One character of a literal or class: escape sequence or raw byte.
+ * Returns the code point (raw bytes >= 0x80 come back as is), -1 on error. */
+static int32_t gr_char(GrParser *p) {
+    char c = gr_peek(p);
+    p->i++;
+    if (c != '\\') return (uint8_t)c;
+    if (p->i >= p->n) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "unterminated escape", 0);
+        return -1;
+    }
+    c = p->s[p->i++];
+    switch (c) {
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    case '\\': case '"': case '\'': case '[': case ']': case '-': case '/': case '^':
+        return (uint8_t)c;
+    case 'x': case 'u': case 'U': {
+        int digits = (c == 'x') ? 2 : (c == 'u') ? 4 : 8;
+        int32_t v = 0;
+        for (int k = 0; k < digits; k++) {
+            int h = p->i < p->n ? gr_hex(p->s[p->i]) : -1;
+            if (h < 0) {
+                gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "bad hex escape", 0);
+                return -1;
+            }
+            v = v * 16 + h;
+            p->i++;
+        }
+        if (v > 0x10FFFF) {
+            gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "code point out of range", 0);
+            return -1;
+        }
+        return v | (int32_t)0x40000000;     /* tag: a code point, not a raw byte */
+    }
+    default:
+        gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "unknown escape", 0);
+        return -1;
+    }
+}
+
+/* "..." → one CHAR element per UTF-8 byte */
+static void gr_literal(GrParser *p) {
+    p->i++;
+    while (!p->failed && p->i < p->n && p->s[p->i] != '"') {
+        int32_t v = gr_char(p);
+        if (v < 0) return;
+        if (!(v & 0x40000000)) {
+            gr_push(p, LLMK_GE_CHAR, (uint16_t)v);
+            continue;
+        }
+        uint32_t cp = (uint32_t)v & 0x3FFFFFFFu;
+        uint8_t u[4];
+        int n;
+        if (cp < 0x80) {
+            u[0] = (uint8_t)cp; n = 1;
+        } else if (cp < 0x800) {
+            u[0] = (uint8_t)(0xC0 | (cp >> 6)); u[1] = (uint8_t)(0x80 | (cp & 0x3F)); n = 2;
+        } else if (cp < 0x10000) {
+            u[0] = (uint8_t)(0xE0 | (cp >> 12)); u[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+            u[2] = (uint8_t)(0x80 | (cp & 0x3F)); n = 3;
+        } else {
+            u[0] = (uint8_t)(0xF0 | (cp >> 18)); u[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+            u[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F)); u[3] = (uint8_t)(0x80 | (cp & 0x3F)); n = 4;
+        }
+        for (int k = 0; k < n; k++) gr_push(p, LLMK_GE_CHAR, u[k]);
+    }
+    if (p->i >= p->n) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "unterminated string", 0);
+        return;
+    }
+    p->i++;
+}
+
+/* Pushes set as a CHAR (one byte) or a deduplicated CLASS */
+static void gr_push_set(GrParser *p, const uint32_t set[8]) {
+    LlmkGrammar *g = p->g;
+    int count = 0, only = 0;
+    for (int b = 0; b < 256; b++) {
+        if ((set[b >> 5] >> (b & 31)) & 1) {
+            count++;
+            only = b;
+        }
+    }
+    if (count == 1) {
+        gr_push(p, LLMK_GE_CHAR, (uint16_t)only);
+        return;
+    }
+    for (int c = 0; c < g->n_cls; c++) {
+        int same = 1;
+        for (int w = 0; w < 8; w++) same &= (g->cls[c][w] == set[w]);
+        if (same) {
+            gr_push(p, LLMK_GE_CLASS, (uint16_t)c);
+            return;
+        }
+    }
+    if (g->n_cls >= LLMK_GRAMMAR_MAX_CLASSES) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "too many character classes", 0);
+        return;
+    }
+    for (int w = 0; w < 8; w++) g->cls[g->n_cls][w] = set[w];
+    gr_push(p, LLMK_GE_CLASS, (uint16_t)g->n_cls++);
+}
+
+static int32_t gr_class_char(GrParser *p) {
+    int32_t v = gr_char(p);
+    if (v < 0) return -1;
+    v &= 0x3FFFFFFF;
+    if (v >= 0x80) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "non-ASCII character in class (byte-level grammar)", 0);
+        return -1;
+    }
+    return v;
+}
+
+/* [abc], [a-z], [^"\\] */
+static void gr_class(GrParser *p) {
+    uint32_t set[8] = { 0 };
+    int negate = 0;
+    p->i++;
+    if (gr_peek(p) == '^') {
+        negate = 1;
+        p->i++;
+    }
+    while (!p->failed && p->i < p->n && p->s[p->i] != ']') {
+        int32_t lo = gr_class_char(p), hi;
+        if (lo < 0) return;
+        hi = lo;
+        if (p->i + 1 < p->n && p->s[p->i] == '-' && p->s[p->i + 1] != ']') {
+            p->i++;
+            hi = gr_class_char(p);
+            if (hi < 0) return;
+            if (hi < lo) {
+                gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "empty class range", 0);
+                return;
+            }
+        }
+        for (int32_t b = lo; b <= hi; b++) set[b >> 5] |= 1u << (b & 31);
+    }
+    if (p->i >= p->n) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "unterminated character class", 0);
+        return;
+    }
+    p->i++;
+    if (negate) {
+        for (int w = 0; w < 8; w++) set[w] = ~set[w];
+    }
+    gr_push_set(p, set);
+}
+
+static int gr_int(GrParser *p) {
+    int v = 0, digits = 0;
+    while (p->i < p->n && p->s[p->i] >= '0' && p->s[p->i] <= '9') {
+        if (v < 100000) v = v * 10 + (p->s[p->i] - '0');
+        p->i++;
+        digits++;
+    }
+    return digits ? v : -1;
+}
+
+/* Replaces the item at scratch[from..n_work) by min copies followed by a
+ * synthetic rule for the optional rest: "r ::= item r |" when unbounded,
+ * else a chain "r_k ::= item r_(k-1) |" of max - min rules. */
+static void gr_repeat(GrParser *p, int rule, int from, int min, int max) {
+    LlmkGrammarElem item[64];
+    int len = p->n_work - from;
+    if (len <= 0) return;                   /* repeating "" matches "" */
+    if (len > 64) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "repeated literal too long", 0);
+        return;
+    }
+    if (max >= 0 && (max < min || max > LLMK_GRAMMAR_MAX_REPEAT)) {
+        gr_fail(p, LLMK_GRAMMAR_ERR_LIMIT, "bad repetition bounds", 0);
+        return;
+    }
+    for (int k = 0; k < len; k++) item[k] = p->g->scratch[from + k];
+    p->n_work = from;
+    for (int c = 0; c < min; c++) {
+        for (int k = 0; k < len; k++) gr_push(p, item[k].type, item[k].value);
+    }
+    int n_opt = (max < 0) ? 1 : max - min;
+    int prev = -1;
+    for (int c = 0; c < n_opt && !p->failed; c++) {
+        int r = gr_new_rule(p, rule);
+        int body = p->n_work;
+        for (int k = 0; k < len; k++) gr_push(p, item[k].type, item[k].value);
+        if (max < 0) gr_push(p, LLMK_GE_RULE, (uint16_t)r);
+        else if (prev >= 0) gr_push(p, LLMK_GE_RULE, (uint16_t)prev);
+        gr_push(p, LLMK_GE_ALT, 0);
+        gr_push(p, LLMK_GE_END, 0);
+        gr_define(p, r, body);
+        prev = r;
+    }
+    if (prev >= 0) gr_push(p, LLMK_GE_RULE, (uint16_t)prev);
+}
+
+static void gr_alternates(GrParser *p, int rule, int nested);
+
+static void gr_sequence(GrParser *p, int rule, int nested) {
+    int last = -1;                          /* scratch index of the last item */
+    while (!p->failed && p->i < p->n) {
+        char c = p->s[p->i];
+        if (c == '"') {
+            last = p->n_work;
+            gr_literal(p);
+        } else if (c == '[') {
+            last = p->n_work;
+            gr_class(p);
+        } else if (c == '.') {
+            uint32_t all[8] = { ~0u, ~0u, ~0u, ~0u, ~0u, ~0u, ~0u, ~0u };
+            last = p->n_work;
+            p->i++;
+            gr_push_set(p, all);
+        } else if (gr_is_word(c)) {
+            int s = p->i;
+            while (p->i < p->n && gr_is_word(p->s[p->i])) p->i++;
+            last = p->n_work;
+            gr_push(p, LLMK_GE_RULE, (uint16_t)gr_symbol(p, p->s + s, p->i - s));
+        } else if (c == '(') {
+            p->i++;
+            gr_space(p, 1);
+            int sub = gr_new_rule(p, rule);
+            gr_alternates(p, sub, 1);
+            if (p->failed) return;
+            if (gr_peek(p) != ')') {
+                gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "expecting ')'", 0);
+                return;
+            }
+            p->i++;
+            last = p->n_work;
+            gr_push(p, LLMK_GE_RULE, (uint16_t)sub);
+        } else if (c == '*' || c == '+' || c == '?' || c == '{') {
+            int min = 0, max = -1;
+            if (last < 0) {
+                gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "repetition without an item", 0);
+                return;
+            }
+            p->i++;
+            if (c == '+') {
+                min = 1;
+            } else if (c == '?') {
+                max = 1;
+            } else if (c == '{') {
+                gr_space(p, 0);
+                min = gr_int(p);
+                gr_space(p, 0);
+                if (min < 0) {
+                    gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "expecting a count after '{'", 0);
+                    return;
+                }
+                max = min;
+                if (gr_peek(p) == ',') {
+                    p->i++;
+                    gr_space(p, 0);
+                    max = gr_int(p);        /* {m,} → unbounded (-1) */
+                    gr_space(p, 0);
+                }
+                if (gr_peek(p) != '}') {
+                    gr_fail(p, LLMK_GRAMMAR_ERR_SYNTAX, "expecting '}'", 0);
+                    return;
+                }
+                p->i++;
+            }
+            gr_repeat(p, rule, last, min, max);
+            last = -1;
+        } else {
+            break;
+        }
+        gr_space(p, nested);
+    }
+}
+
+/* seq ("|" seq)* as rule's body */
+static void gr_alternates(GrParser *p, int rule, int nested) {
+    int from = p->n_work;
+    gr_sequence(p, rule, nested);
+    while (!p->failed && gr_peek(p) == '|') {
+        p->i++;
+        gr_push(p, LLMK_GE_ALT, 0);
+        gr_space(p, 1);
+        gr_sequence(p, rule, nested);
+    }
+    gr_push(p, LLMK_GE_END, 0);
+    gr_define(p, rule, from);
+}
+
+/* A rule can match the empty string */
+static void gr_nullable(const LlmkGrammar *g, uint8_t *nullable) {
+    for (int r = 0; r < g->n_rules; r++) nullable[r] = 0;
+    for (int changed = 1; changed;) {
+        changed = 0;
+        for (int r = 0; r < g->n_rules; r++) {
+            if (nullable[r]) continue;
+            int pos = g->rule_start[r], ok = 1;
+            for (;; pos++) {
+                const LlmkGrammarElem *e = &g->elem[pos];
+                if (e->type == LLMK_GE_END || e->type == LLMK_GE_ALT) {
+                    if (ok) break;
+                    if (e->type == LLMK_GE_END) break;
+                    ok = 1;
+                    continue;
+                }
+                if (e->type != LLMK_GE_RULE || !nullable[e->value]) ok = 0;
+            }
+            if (ok) {
+                nullable[r] = 1;
+                changed = 1;
+            }
+        }
+    }
+}
+
+/* Depth-first search for a cycle through leftmost references (0 unvisited,
+ * 1 on the path, 2 done). Returns the rule closing the cycle or -1. */
+static int gr_left_cycle(const LlmkGrammar *g, const uint8_t *nullable, uint8_t *mark, int r) {
+    mark[r] = 1;
+    int pos = g->rule_start[r], leading = 1;
+    for (;; pos++) {
+        const LlmkGrammarElem *e = &g->elem[pos];
+        if (e->type == LLMK_GE_END) break;
+        if (e->type == LLMK_GE_ALT) {
+            leading = 1;
+            continue;
+        }
+        if (!leading) continue;
+        if (e->type != LLMK_GE_RULE) {
+            leading = 0;
+            continue;
+        }
+        if (mark[e->value] == 1) return e->value;
+        if (mark[e->value] == 0) {
+            int hit = gr_left_cycle(g, nullable, mark, e->value);
+            if (hit >= 0) return hit;
+        }
+        if (!nullable[e->value]) leading = 0;
+    }
+    mark[r] = 2;
+    return -1;
+}
+
+int llmk_grammar_parse(LlmkGrammar *g, const char *text, int n) {
+    GrParser p;
+    if (!g || !text || n < 0) return LLMK_GRAMMAR_ERR_PARAM;
+    g->n_elem = 0;
+    g->n_rules = 0;
+    g->n_cls = 0;
+    g->root = -1;
+    g->err[0] = 0;
+    p.g = g;
+    p.s = text;
+    p.n = n;
+    p.i = 0;
+    p.line = 1;
+    p.n_work = 0;
+    p.failed = 0;
+
+    gr_space(&p, 1);
+    while (!p.failed && p.i < p.n) {
+        int s = p.i;
+        while (p.i < p.n && gr_is_word(p.s[p.i])) p.i++;
+        if (p.i == s) {
+            gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "expecting a rule name", 0);
+            break;
+        }
+        int r = gr_symbol(&p, p.s + s, p.i - s);
+        gr_space(&p, 0);
+        if (p.i + 3 > p.n || p.s[p.i] != ':' || p.s[p.i + 1] != ':' || p.s[p.i + 2] != '=') {
+            gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "expecting '::=' after ", g->rule_name[r]);
+            break;
+        }
+        p.i += 3;
+        gr_space(&p, 1);
+        if (g->rule_start[r] != GR_UNDEFINED) {
+            gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "rule defined twice: ", g->rule_name[r]);
+            break;
+        }
+        gr_alternates(&p, r, 0);
+        if (p.failed) break;
+        char c = gr_peek(&p);
+        if (c && c != '\n' && c != '\r') {
+            gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "unexpected character", 0);
+            break;
+        }
+        gr_space(&p, 1);
+    }
+    if (p.failed) return p.failed;
+
+    for (int r = 0; r < g->n_rules; r++) {
+        if (g->rule_start[r] == GR_UNDEFINED) {
+            gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "undefined rule ", g->rule_name[r]);
+            return p.failed;
+        }
+        if (gr_eq("root", 4, g->rule_name[r])) g->root = r;
+    }
+    if (g->root < 0) {
+        gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "missing root rule", 0);
+        return p.failed;
+    }
+
+    uint8_t nullable[LLMK_GRAMMAR_MAX_RULES], mark[LLMK_GRAMMAR_MAX_RULES];
+    gr_nullable(g, nullable);
+    for (int r = 0; r < g->n_rules; r++) mark[r] = 0;
+    for (int r = 0; r < g->n_rules; r++) {
+        if (mark[r]) continue;
+        int hit = gr_left_cycle(g, nullable, mark, r);
+        if (hit >= 0) {
+            gr_fail(&p, LLMK_GRAMMAR_ERR_SYNTAX, "left recursion through rule ", g->rule_name[hit]);
+            return p.failed;
+        }
+    }
+    return LLMK_GRAMMAR_OK;
+}
+
+/* ── JSON ──────────────────────────────────────────────────────────────── */
+
+/* Shared by the generic grammar and the schema converter. Whitespace and
+ * digit runs are bounded so a model cannot pad forever. */
+#define GR_JSON_RULES \
+    "value   ::= object | array | string | number | boolean | null\n" \
+    "object  ::= \"{\" ws ( string \":\" ws value ( \",\" ws string \":\" ws value )* )? \"}\" ws\n" \
+    "array   ::= \"[\" ws ( value ( \",\" ws value )* )? \"]\" ws\n" \
+    "string  ::= \"\\\"\" char* \"\\\"\" ws\n" \
+    "char    ::= [^\"\\\\\\x00-\\x1F\\x7F] | \"\\\\\" ( [\"\\\\/bfnrt] | \"u\" [0-9a-fA-F]{4} )\n" \
+    "number  ::= \"-\"? ( \"0\" | [1-9] [0-9]{0,15} ) ( \".\" [0-9]{1,16} )? ( [eE] [-+]? [0-9]{1,4} )? ws\n" \
+    "integer ::= \"-\"? ( \"0\" | [1-9] [0-9]{0,15} ) ws\n" \
+    "boolean ::= ( \"true\" | \"false\" ) ws\n" \
+    "null    ::= \"null\" ws\n" \
+    "ws      ::= | \" \" | \"\\n\" [ \\t]{0,8}\n"
+
+static const char GR_JSON_GBNF[] = "root    ::= object\n" GR_JSON_RULES;
+
+const char *llmk_grammar_json_gbnf(void) {
+    return GR_JSON_GBNF;
+}
+
+/* Minimal reader over the schema text: positions are byte offsets, -1 on
+ * malformed input. */
+static int js_ws(const char *s, int n, int i) {
+    while (i >= 0 && i < n && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) i++;
+    return i;
+}
+
+/* Offset just past the value at i */
+static int js_skip(const char *s, int n, int i, int depth) {
+    i = js_ws(s, n, i);
+    if (i < 0 || i >= n || depth > 64) return -1;
+    char c = s[i];
+    if (c == '"') {
+        for (i++; i < n; i++) {
+            if (s[i] == '\\') i++;
+            else if (s[i] == '"') return i + 1;
+        }
+        return -1;
+    }
+    if (c == '{' || c == '[') {
+        char close = (c == '{') ? '}' : ']';
+        i = js_ws(s, n, i + 1);
+        if (i < n && s[i] == close) return i + 1;
+        for (;;) {
+            if (c == '{') {
+                i = js_skip(s, n, i, depth + 1);      /* key */
+                i = js_ws(s, n, i);
+                if (i < 0 || i >= n || s[i] != ':') return -1;
+                i++;
+            }
+            i = js_ws(s, n, js_skip(s, n, i, depth + 1));
+            if (i < 0 || i >= n) return -1;
+            if (s[i] == close) return i + 1;
+            if (s[i] != ',') return -1;
+            i++;
+        }
+    }
+    int start = i;
+    while (i < n && (gr_is_word(s[i]) || s[i] == '.' || s[i] == '+')) i++;
+    return i > start ? i : -1;
+}
+
+/* Value offset of key in the object at i, or -1 */
+static int js_key(const char *s, int n, int i, const char *key) {
+    i = js_ws(s, n, i);
+    if (i < 0 || i >= n || s[i] != '{') return -1;
+    i = js_ws(s, n, i + 1);
+    while (i >= 0 && i < n && s[i] == '"') {
+        int k = i;
+        int e = js_skip(s, n, i, 0);
+        if (e < 0) return -1;
+        int colon = js_ws(s, n, e);
+        if (colon >= n || s[colon] != ':') return -1;
+        int v = js_ws(s, n, colon + 1);
+        if (gr_eq(s + k + 1, e - k - 2, key)) return v;
+        i = js_ws(s, n, js_skip(s, n, v, 0));
+        if (i < 0 || i >= n || s[i] != ',') return -1;
+        i = js_ws(s, n, i + 1);
+    }
+    return -1;
+}
+
+/* The JSON string at i equals word */
+static int js_is(const char *s, int n, int i, const char *word) {
+    int e = js_skip(s, n, i, 0);
+    return e > i && s[i] == '"' && gr_eq(s + i + 1, e - i - 2, word);
+}
+
+#define GR_SCHEMA_MAX_DEFS 64
+
+typedef struct {
+    const char *s;
+    int   n;
+    char *out;
+    int   cap, len;
+    char *err;
+    int   err_cap;
+    int   failed;
+    int   defs[GR_SCHEMA_MAX_DEFS];     /* schema offsets of array item rules */
+    int   n_defs;
+} GrSchema;
+
+static void gs_fail(GrSchema *o, const char *msg) {
+    if (o->failed) return;
+    o->failed = 1;
+    if (o->err && o->err_cap > 0) {
+        int len = 0;
+        o->err[0] = 0;
+        gr_cat(o->err, o->err_cap, &len, msg);
+    }
+}
+
+static void gs_put(GrSchema *o, const char *t) {
+    if (o->len + gr_strlen(t) >= o->cap) {
+        gs_fail(o, "grammar buffer too small");
+        return;
+    }
+    gr_cat(o->out, o->cap, &o->len, t);
+}
+
+/* GBNF literal for the raw bytes s[0..n) */
+static void gs_lit(GrSchema *o, const char *s, int n) {
+    gs_put(o, "\"");
+    for (int k = 0; k < n && !o->failed; k++) {
+        char c = s[k], e[5] = { c, 0, 0, 0, 0 };
+        if (c == '"' || c == '\\') {
+            e[0] = '\\';
+            e[1] = c;
+        } else if ((uint8_t)c < 0x20) {
+            static const char hex[] = "0123456789ABCDEF";
+            e[0] = '\\';
+            e[1] = 'x';
+            e[2] = hex[(uint8_t)c >> 4];
+            e[3] = hex[c & 15];
+        }
+        gs_put(o, e);
+    }
+    gs_put(o, "\"");
+}
+
+static void gs_schema(GrSchema *o, int i, int depth);
+
+static void gs_type(GrSchema *o, int i, int type, int depth) {
+    const char *s = o->s;
+    int n = o->n;
+    if (js_is(s, n, type, "string") || js_is(s, n, type, "number") || js_is(s, n, type, "integer") ||
+        js_is(s, n, type, "boolean") || js_is(s, n, type, "null")) {
+        char name[16];
+        int e = js_skip(s, n, type, 0), len = 0;
+        for (int k = type + 1; k < e - 1 && len < 15; k++) name[len++] = s[k];
+        name[len] = 0;
+        gs_put(o, name);
+    } else if (js_is(s, n, type, "array")) {
+        int items = js_key(s, n, i, "items");
+        if (items < 0) {
+            gs_put(o, "array");
+            return;
+        }
+        if (o->n_defs >= GR_SCHEMA_MAX_DEFS) {
+            gs_fail(o, "too many array schemas");
+            return;
+        }
+        char item[16];
+        int len = 0;
+        item[0] = 0;
+        gr_cat(item, (int)sizeof(item), &len, "item-");
+        gr_cat_int(item, (int)sizeof(item), &len, o->n_defs);
+        o->defs[o->n_defs++] = items;
+        gs_put(o, "\"[\" ws ( ");
+        gs_put(o, item);
+        gs_put(o, " ( \",\" ws ");
+        gs_put(o, item);
+        gs_put(o, " )* )? \"]\" ws");
+    } else if (js_is(s, n, type, "object")) {
+        int props = js_key(s, n, i, "properties");
+        if (props < 0) {
+            gs_put(o, "object");
+            return;
+        }
+        if (s[props] != '{') {
+            gs_fail(o, "properties must be an object");
+            return;
+        }
+        gs_put(o, "\"{\" ws ");
+        int k = js_ws(s, n, props + 1), first = 1;
+        while (!o->failed && k >= 0 && k < n && s[k] == '"') {
+            int e = js_skip(s, n, k, 0);
+            if (e < 0) break;
+            int v = js_ws(s, n, js_ws(s, n, e) + 1);
+            if (v >= n) break;
+            if (!first) gs_put(o, " \",\" ws ");
+            first = 0;
+            gs_lit(o, s + k, e - k);
+            gs_put(o, " ws \":\" ws ");
+            gs_schema(o, v, depth + 1);
+            k = js_ws(s, n, js_skip(s, n, v, 0));
+            if (k >= 0 && k < n && s[k] == ',') k = js_ws(s, n, k + 1);
+        }
+        gs_put(o, " \"}\" ws");
+    } else {
+        gs_fail(o, "unsupported schema type");
+    }
+}
+
+/* Alternatives over the elements of the array at arr: literal values (enum)
+ * or sub-schemas (anyOf / oneOf) */
+static void gs_alts(GrSchema *o, int arr, int literal, int depth) {
+    const char *s = o->s;
+    int n = o->n;
+    if (s[arr] != '[') {
+        gs_fail(o, "expecting an array");
+        return;
+    }
+    gs_put(o, "( ");
+    int k = js_ws(s, n, arr + 1), first = 1;
+    while (!o->failed && k >= 0 && k < n && s[k] != ']') {
+        int e = js_skip(s, n, k, 0);
+        if (e < 0) {
+            gs_fail(o, "malformed schema");
+            return;
+        }
+        if (!first) gs_put(o, " | ");
+        first = 0;
+        if (literal) {
+            gs_lit(o, s + k, e - k);
+            gs_put(o, " ws");
+        } else {
+            gs_schema(o, k, depth + 1);
+        }
+        k = js_ws(s, n, e);
+        if (k < n && s[k] == ',') k = js_ws(s, n, k + 1);
+    }
+    if (first) gs_fail(o, "empty alternative list");
+    gs_put(o, " )");
+}
+
+static void gs_schema(GrSchema *o, int i, int depth) {
+    const char *s = o->s;
+    int n = o->n;
+    int k;
+    if (o->failed) return;
+    if (depth > 16) {
+        gs_fail(o, "schema nested too deeply");
+        return;
+    }
+    i = js_ws(s, n, i);
+    if (i >= n || s[i] != '{') {
+        if (i < n && js_skip(s, n, i, 0) == i + 4 && gr_eq(s + i, 4, "true")) gs_put(o, "value");
+        else gs_fail(o, "schema must be an object");
+        return;
+    }
+    if (js_key(s, n, i, "$ref") >= 0) {
+        gs_fail(o, "$ref is not supported");
+    } else if ((k = js_key(s, n, i, "const")) >= 0) {
+        int e = js_skip(s, n, k, 0);
+        if (e < 0) {
+            gs_fail(o, "malformed schema");
+            return;
+        }
+        gs_lit(o, s + k, e - k);
+        gs_put(o, " ws");
+    } else if ((k = js_key(s, n, i, "enum")) >= 0) {
+        gs_alts(o, k, 1, depth);
+    } else if ((k = js_key(s, n, i, "anyOf")) >= 0 || (k = js_key(s, n, i, "oneOf")) >= 0) {
+        gs_alts(o, k, 0, depth);
+    } else if ((k = js_key(s, n, i, "type")) >= 0) {
+        if (s[k] != '[') {
+            gs_type(o, i, k, depth);
+            return;
+        }
+        gs_put(o, "( ");
+        int t = js_ws(s, n, k + 1), first = 1;
+        while (!o->failed && t >= 0 && t < n && s[t] == '"') {
+            if (!first) gs_put(o, " | ");
+            first = 0;
+            gs_type(o, i, t, depth);
+            t = js_ws(s, n, js_skip(s, n, t, 0));
+            if (t >= 0 && t < n && s[t] == ',') t = js_ws(s, n, t + 1);
+        }
+        if (first) gs_fail(o, "empty type list");
+        gs_put(o, " )");
+    } else {
+        gs_put(o, "value");
+    }
+}
+
+int llmk_grammar_from_json_schema(const char *schema, int n, char *out, int cap, char *err, int err_cap) {
+    GrSchema o;
+    if (!schema || !out || cap <= 0 || n < 0) return LLMK_GRAMMAR_ERR_PARAM;
+    o.s = schema;
+    o.n = n;
+    o.out = out;
+    o.cap = cap;
+    o.len = 0;
+    o.err = err;
+    o.err_cap = err_cap;
+    o.failed = 0;
+    o.n_defs = 0;
+    out[0] = 0;
+    if (err && err_cap > 0) err[0] = 0;
+    if (js_ws(schema, n, js_skip(schema, n, 0, 0)) != n) {
+        gs_fail(&o, "malformed schema JSON");
+        return LLMK_GRAMMAR_ERR_SYNTAX;
+    }
+
+    gs_put(&o, "root ::= ");
+    gs_schema(&o, 0, 0);
+    gs_put(&o, "\n");
+    for (int d = 0; d < o.n_defs && !o.failed; d++) {      /* items may add more */
+        char head[24];
+        int len = 0;
+        head[0] = 0;
+        gr_cat(head, (int)sizeof(head), &len, "item-");
+        gr_cat_int(head, (int)sizeof(head), &len, d);
+        gr_cat(head, (int)sizeof(head), &len, " ::= ");
+        gs_put(&o, head);
+        gs_schema(&o, o.defs[d], 1);
+        gs_put(&o, "\n");
+    }
+    gs_put(&o, GR_JSON_RULES);
+    return o.failed ? LLMK_GRAMMAR_ERR_SYNTAX : o.len;
+}
+
+/* ── Pushdown automaton ────────────────────────────────────────────────── */
+
+#define GR_MAX_EXPAND 64                /* nested rule expansions without input */
+
+static int gr_is_eos(const LlmkGrammar *g, int pos) {
+    uint16_t t = g->elem[pos].type;
+    return t == LLMK_GE_END || t == LLMK_GE_ALT;
+}
+
+static int gr_match(const LlmkGrammar *g, const LlmkGrammarElem *e, uint8_t b) {
+    if (e->type == LLMK_GE_CHAR) return e->value == b;
+    return (int)((g->cls[e->value][b >> 5] >> (b & 31)) & 1u);
+}
+
+/* Adds a stack to st unless already present */
+static void gr_add(LlmkGrammarState *st, const uint16_t *pos, int len) {
+    for (int s = 0; s < st->n; s++) {
+        if (st->len[s] != len) continue;
+        int k = 0;
+        while (k < len && st->pos[s][k] == pos[k]) k++;
+        if (k == len) return;
+    }
+    if (st->n >= LLMK_GRAMMAR_MAX_STACKS) {
+        st->overflow = 1;
+        return;
+    }
+    for (int k = 0; k < len; k++) st->pos[st->n][k] = pos[k];
+    st->len[st->n++] = (uint8_t)len;
+}
+
+static void gr_advance(const LlmkGrammar *g, LlmkGrammarState *out, const uint16_t *stk, int len, int guard);
+
+/* Pushes each alternative of rule onto stk[0..len) and advances it */
+static void gr_expand(const LlmkGrammar *g, LlmkGrammarState *out, const uint16_t *stk, int len,
+                      int rule, int guard) {
+    uint16_t tmp[LLMK_GRAMMAR_MAX_DEPTH];
+    for (int k = 0; k < len; k++) tmp[k] = stk[k];
+    int a = g->rule_start[rule];
+    for (;;) {
+        if (gr_is_eos(g, a)) {
+            gr_advance(g, out, tmp, len, guard + 1);
+        } else if (len < LLMK_GRAMMAR_MAX_DEPTH) {
+            tmp[len] = (uint16_t)a;
+            gr_advance(g, out, tmp, len + 1, guard + 1);
+        } else {
+            out->overflow = 1;
+        }
+        while (!gr_is_eos(g, a)) a++;
+        if (g->elem[a].type == LLMK_GE_END) break;
+        a++;
+    }
+}
+
+/* Expands rule references on top of stk until every resulting stack is
+ * topped by a terminal (or empty) and adds those to out */
+static void gr_advance(const LlmkGrammar *g, LlmkGrammarState *out, const uint16_t *stk, int len, int guard) {
+    if (guard > GR_MAX_EXPAND) {
+        out->overflow = 1;
+        return;
+    }
+    if (len == 0) {
+        gr_add(out, stk, 0);
+        return;
+    }
+    int pos = stk[len - 1];
+    const LlmkGrammarElem *e = &g->elem[pos];
+    if (e->type != LLMK_GE_RULE) {
+        gr_add(out, stk, len);
+        return;
+    }
+    uint16_t rest[LLMK_GRAMMAR_MAX_DEPTH];
+    int n = len - 1;
+    for (int k = 0; k < n; k++) rest[k] = stk[k];
+    if (!gr_is_eos(g, pos + 1)) rest[n++] = (uint16_t)(pos + 1);
+    gr_expand(g, out, rest, n, e->value, guard);
+}
+
+/* out = the stacks of in that take byte b, moved past it */
+static void gr_step(const LlmkGrammar *g, const LlmkGrammarState *in, uint8_t b, LlmkGrammarState *out) {
+    uint16_t tmp[LLMK_GRAMMAR_MAX_DEPTH];
+    out->n = 0;
+    out->overflow = in->overflow;
+    for (int s = 0; s < in->n; s++) {
+        int len = in->len[s];
+        if (len == 0) continue;
+        int pos = in->pos[s][len - 1];
+        if (!gr_match(g, &g->elem[pos], b)) continue;
+        int n = len - 1;
+        for (int k = 0; k < n; k++) tmp[k] = in->pos[s][k];
+        if (!gr_is_eos(g, pos + 1)) tmp[n++] = (uint16_t)(pos + 1);
+        gr_advance(g, out, tmp, n, 0);
+    }
+}
+
+static void gr_state_copy(LlmkGrammarState *dst, const LlmkGrammarState *src) {
+    dst->n = src->n;
+    dst->overflow = src->overflow;
+    for (int s = 0; s < src->n; s++) {
+        dst->len[s] = src->len[s];
+        for (int k = 0; k < src->len[s]; k++) dst->pos[s][k] = src->pos[s][k];
+    }
+}
+
+/* Order-independent: the same set of stacks hashes alike in any order */
+static uint64_t gr_state_hash(const LlmkGrammarState *st) {
+    uint64_t h = (uint64_t)st->n * 0x9E3779B97F4A7C15ull;
+    for (int s = 0; s < st->n; s++) {
+        uint64_t x = 1469598103934665603ull ^ st->len[s];
+        for (int k = 0; k < st->len[s]; k++) {
+            x ^= st->pos[s][k];
+            x *= 1099511628211ull;
+        }
+        h += x ^ (x >> 29);
+    }
+    return h;
+}
+
+static int gr_state_eq(const LlmkGrammarState *a, const LlmkGrammarState *b) {
+    if (a->n != b->n) return 0;
+    for (int s = 0; s < a->n; s++) {
+        int found = 0;
+        for (int t = 0; t < b->n && !found; t++) {
+            if (a->len[s] != b->len[t]) continue;
+            int k = 0;
+            while (k < a->len[s] && a->pos[s][k] == b->pos[t][k]) k++;
+            found = (k == a->len[s]);
+        }
+        if (!found) return 0;
+    }
+    return 1;
+}
+
+/* Bytes some stack of st can take next */
+static void gr_first_bytes(const LlmkGrammar *g, const LlmkGrammarState *st, uint32_t set[8]) {
+    for (int w = 0; w < 8; w++) set[w] = 0;
+    for (int s = 0; s < st->n; s++) {
+        if (st->len[s] == 0) continue;
+        const LlmkGrammarElem *e = &g->elem[st->pos[s][st->len[s] - 1]];
+        if (e->type == LLMK_GE_CHAR) {
+            set[e->value >> 5] |= 1u << (e->value & 31);
+        } else {
+            for (int w = 0; w < 8; w++) set[w] |= g->cls[e->value][w];
+        }
+    }
+}
+
+void llmk_grammar_state_init(const LlmkGrammar *g, LlmkGrammarState *st) {
+    st->n = 0;
+    st->overflow = 0;
+    gr_expand(g, st, 0, 0, g->root, 0);
+}
+
+int llmk_grammar_state_accept(const LlmkGrammar *g, LlmkGrammarState *st, const char *bytes, int n) {
+    static LlmkGrammarState tmp;        /* too large for a UEFI stack frame */
+    for (int i = 0; i < n; i++) {
+        gr_step(g, st, (uint8_t)bytes[i], &tmp);
+        if (tmp.n == 0) return LLMK_GRAMMAR_ERR_REJECT;
+        gr_state_copy(st, &tmp);
+    }
+    return LLMK_GRAMMAR_OK;
+}
+
+int llmk_grammar_state_can_end(const LlmkGrammarState *st) {
+    for (int s = 0; s < st->n; s++) {
+        if (st->len[s] == 0) return 1;
+    }
+    return 0;
+}
+
+/* ── Vocabulary trie and masks ─────────────────────────────────────────── */
+
+static uint64_t gr_align(uint64_t x) {
+    return (x + 15u) & ~(uint64_t)15u;
+}
+
+/* Token text bytes indexed by the trie: 0 when never allowed */
+static int gr_piece_len(LlmkGrammarPieceFn piece, void *ctx, int id, char *buf) {
+    int n = piece(ctx, id, buf, LLMK_GRAMMAR_MAX_TOKEN + 1);
+    return (n > 0 && n <= LLMK_GRAMMAR_MAX_TOKEN) ? n : 0;
+}
+
+static uint64_t gr_layout(int n_vocab, uint64_t text_bytes) {
+    uint64_t words = ((uint64_t)n_vocab + 31u) / 32u;
+    uint64_t b = 0;
+    b += gr_align((text_bytes + 1) * sizeof(LlmkGrammarNode));
+    b += gr_align((uint64_t)n_vocab * sizeof(int32_t)) * 2;           /* tok_next, tok_off */
+    b += gr_align((uint64_t)n_vocab);                                 /* tok_len */
+    b += gr_align(text_bytes);
+    b += gr_align(words * 4) * 2;                                     /* stop, bits */
+    b += gr_align((LLMK_GRAMMAR_MAX_TOKEN + 1) * sizeof(LlmkGrammarState));
+    b += (gr_align(sizeof(LlmkGrammarState)) + gr_align(words * 4)) * LLMK_GRAMMAR_CACHE;
+    return b + 16;
+}
+
+uint64_t llmk_grammar_rt_bytes(int n_vocab, LlmkGrammarPieceFn piece, void *ctx) {
+    char buf[LLMK_GRAMMAR_MAX_TOKEN + 1];
+    uint64_t text = 0;
+    if (n_vocab <= 0 || !piece) return 0;
+    for (int id = 0; id < n_vocab; id++) text += (uint64_t)gr_piece_len(piece, ctx, id, buf);
+    return gr_layout(n_vocab, text);
+}
+
+int llmk_grammar_rt_init(LlmkGrammarRt *rt, void *mem, uint64_t bytes, int n_vocab,
+                         LlmkGrammarPieceFn piece, LlmkGrammarStopFn is_stop, void *ctx) {
+    char buf[LLMK_GRAMMAR_MAX_TOKEN + 1];
+    if (!rt || !mem || n_vocab <= 0 || !piece) return LLMK_GRAMMAR_ERR_PARAM;
+    uint64_t text = 0;
+    for (int id = 0; id < n_vocab; id++) text += (uint64_t)gr_piece_len(piece, ctx, id, buf);
+    if (bytes < gr_layout(n_vocab, text)) return LLMK_GRAMMAR_ERR_MEM;
+
+    gr_zero(rt, sizeof(*rt));
+    rt->n_vocab = n_vocab;
+    rt->words = (n_vocab + 31) / 32;
+    uint8_t *p = (uint8_t *)(((uintptr_t)mem + 15u) & ~(uintptr_t)15u);
+    rt->node = (LlmkGrammarNode *)p;        p += gr_align((text + 1) * sizeof(LlmkGrammarNode));
+    rt->tok_next = (int32_t *)p;            p += gr_align((uint64_t)n_vocab * sizeof(int32_t));
+    rt->tok_off = (int32_t *)p;             p += gr_align((uint64_t)n_vocab * sizeof(int32_t));
+    rt->tok_len = p;                        p += gr_align((uint64_t)n_vocab);
+    rt->text = (char *)p;                   p += gr_align(text);
+    rt->stop = (uint32_t *)p;               p += gr_align((uint64_t)rt->words * 4);
+    rt->bits = (uint32_t *)p;               p += gr_align((uint64_t)rt->words * 4);
+    rt->level = (LlmkGrammarState *)p;      p += gr_align((LLMK_GRAMMAR_MAX_TOKEN + 1) * sizeof(LlmkGrammarState));
+    for (int c = 0; c < LLMK_GRAMMAR_CACHE; c++) {
+        rt->cache[c].key = (LlmkGrammarState *)p;   p += gr_align(sizeof(LlmkGrammarState));
+        rt->cache[c].bits = (uint32_t *)p;          p += gr_align((uint64_t)rt->words * 4);
+    }
+    gr_zero(rt->stop, (uint64_t)rt->words * 4);
+
+    rt->node[0].child = -1;
+    rt->node[0].sibling = -1;
+    rt->node[0].tok = -1;
+    rt->n_nodes = 1;
+    int32_t off = 0;
+    for (int id = 0; id < n_vocab; id++) {
+        rt->tok_next[id] = -1;
+        rt->tok_off[id] = -1;
+        rt->tok_len[id] = 0;
+        if (is_stop && is_stop(ctx, id)) {
+            rt->stop[id >> 5] |= 1u << (id & 31);
+            continue;
+        }
+        int n = gr_piece_len(piece, ctx, id, buf);
+        if (n == 0) continue;
+        int32_t node = 0;
+        for (int k = 0; k < n; k++) {
+            uint8_t b = (uint8_t)buf[k];
+            int32_t c = rt->node[node].child;
+            while (c >= 0 && rt->node[c].byte != b) c = rt->node[c].sibling;
+            if (c < 0) {
+                c = rt->n_nodes++;
+                rt->node[c].child = -1;
+                rt->node[c].tok = -1;
+                rt->node[c].byte = b;
+                rt->node[c].sibling = rt->node[node].child;
+                rt->node[node].child = c;
+            }
+            node = c;
+            rt->text[off + k] = buf[k];
+        }
+        rt->tok_off[id] = off;
+        rt->tok_len[id] = (uint8_t)n;
+        rt->tok_next[id] = rt->node[node].tok;
+        rt->node[node].tok = id;
+        off += n;
+    }
+    return LLMK_GRAMMAR_OK;
+}
+
+void llmk_grammar_rt_start(LlmkGrammarRt *rt, const LlmkGrammar *g) {
+    rt->g = g;
+    rt->mask_valid = 0;
+    for (int c = 0; c < LLMK_GRAMMAR_CACHE; c++) rt->cache[c].stamp = 0;
+    if (g) llmk_grammar_state_init(g, &rt->cur);
+}
+
+static int gr_popcount(uint32_t x) {
+    int n = 0;
+    while (x) {
+        x &= x - 1;
+        n++;
+    }
+    return n;
+}
+
+/* Fills rt->bits for rt->cur: cache lookup, else a pruned trie walk */
+static void gr_compute_mask(LlmkGrammarRt *rt) {
+    const LlmkGrammar *g = rt->g;
+    uint64_t h = gr_state_hash(&rt->cur);
+    LlmkGrammarCacheEntry *victim = &rt->cache[0];
+    for (int c = 0; c < LLMK_GRAMMAR_CACHE; c++) {
+        LlmkGrammarCacheEntry *e = &rt->cache[c];
+        if (e->stamp && e->hash == h && gr_state_eq(e->key, &rt->cur)) {
+            for (int w = 0; w < rt->words; w++) rt->bits[w] = e->bits[w];
+            rt->n_allowed = e->n_allowed;
+            e->stamp = ++rt->clock;
+            rt->cache_hits++;
+            return;
+        }
+        if (e->stamp < victim->stamp) victim = e;
+    }
+
+    for (int w = 0; w < rt->words; w++) rt->bits[w] = 0;
+    if (llmk_grammar_state_can_end(&rt->cur)) {
+        for (int w = 0; w < rt->words; w++) rt->bits[w] = rt->stop[w];
+    }
+    gr_state_copy(&rt->level[0], &rt->cur);
+    gr_first_bytes(g, &rt->level[0], rt->first[0]);
+    rt->walk[0] = rt->node[0].child;
+    int d = 0;
+    while (d >= 0) {
+        int32_t c = rt->walk[d];
+        if (c < 0) {
+            d--;
+            continue;
+        }
+        const LlmkGrammarNode *nd = &rt->node[c];
+        rt->walk[d] = nd->sibling;
+        if (!((rt->first[d][nd->byte >> 5] >> (nd->byte & 31)) & 1u)) continue;
+        rt->nodes_visited++;
+        gr_step(g, &rt->level[d], nd->byte, &rt->level[d + 1]);
+        if (rt->level[d + 1].n == 0) continue;
+        for (int32_t t = nd->tok; t >= 0; t = rt->tok_next[t]) rt->bits[t >> 5] |= 1u << (t & 31);
+        if (nd->child >= 0 && d + 1 < LLMK_GRAMMAR_MAX_TOKEN) {
+            d++;
+            gr_first_bytes(g, &rt->level[d], rt->first[d]);
+            rt->walk[d] = nd->child;
+        }
+    }
+
+    int n = 0;
+    for (int w = 0; w < rt->words; w++) n += gr_popcount(rt->bits[w]);
+    rt->n_allowed = n;
+
+    victim->hash = h;
+    victim->stamp = ++rt->clock;
+    victim->n_allowed = n;
+    gr_state_copy(victim->key, &rt->cur);
+    for (int w = 0; w < rt->words; w++) victim->bits[w] = rt->bits[w];
+}
+
+int llmk_grammar_mask(LlmkGrammarRt *rt, float *logits) {
+    if (!rt->g) return rt->n_vocab;
+    if (!rt->mask_valid) {
+        rt->masks++;
+        gr_compute_mask(rt);
+        rt->mask_valid = 1;
+    }
+    if (logits) {
+        for (int w = 0; w < rt->words; w++) {
+            uint32_t keep = rt->bits[w];
+            if (keep == 0xFFFFFFFFu) continue;
+            int base = w * 32;
+            int end = base + 32 < rt->n_vocab ? base + 32 : rt->n_vocab;
+            for (int i = base; i < end; i++) {
+                if (!((keep >> (i - base)) & 1u)) logits[i] = LLMK_GRAMMAR_MASKED;
+            }
+        }
+    }
+    return rt->n_allowed;
+}
+
+int llmk_grammar_allowed(const LlmkGrammarRt *rt, int id) {
+    if (!rt->g) return 1;
+    if (id < 0 || id >= rt->n_vocab) return 0;
+    return (int)((rt->bits[id >> 5] >> (id & 31)) & 1u);
+}
+
+int llmk_grammar_best(const LlmkGrammarRt *rt, const float *logits) {
+    int best = -1;
+    for (int w = 0; w < rt->words; w++) {
+        uint32_t m = rt->bits[w];
+        while (m) {
+            int i = w * 32 + __builtin_ctz(m);
+            m &= m - 1;
+            if (best < 0 || logits[i] > logits[best]) best = i;
+        }
+    }
+    return best;
+}
+
+int llmk_grammar_accept(LlmkGrammarRt *rt, int id) {
+    if (!rt->g) return LLMK_GRAMMAR_OK;
+    if (id < 0 || id >= rt->n_vocab) return LLMK_GRAMMAR_ERR_PARAM;
+    if ((rt->stop[id >> 5] >> (id & 31)) & 1u) {
+        return llmk_grammar_state_can_end(&rt->cur) ? LLMK_GRAMMAR_OK : LLMK_GRAMMAR_ERR_REJECT;
+    }
+    if (rt->tok_off[id] < 0) return LLMK_GRAMMAR_ERR_REJECT;
+    const char *t = rt->text + rt->tok_off[id];
+    LlmkGrammarState *a = &rt->level[0], *b = &rt->level[1];
+    gr_state_copy(a, &rt->cur);
+    for (int k = 0; k < rt->tok_len[id]; k++) {
+        gr_step(rt->g, a, (uint8_t)t[k], b);
+        if (b->n == 0) return LLMK_GRAMMAR_ERR_REJECT;
+        LlmkGrammarState *x = a;
+        a = b;
+        b = x;
+    }
+    gr_state_copy(&rt->cur, a);
+    rt->mask_valid = 0;
+    return LLMK_GRAMMAR_OK;
+}
+
+int llmk_grammar_can_end(const LlmkGrammarRt *rt) {
+    return !rt->g || llmk_grammar_state_can_end(&rt->cur);
+}
+
+int llmk_grammar_must_end(const LlmkGrammarRt *rt) {
+    return rt->g && rt->cur.n == 1 && rt->cur.len[0] == 0;
+}
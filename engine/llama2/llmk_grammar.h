@@ -0,0 +1,187 @@
+/* llmk_grammar.h — Grammar-constrained decoding (GBNF, JSON-schema subset)
+ *
+ * A grammar is compiled once into a flat element array (llama.cpp layout):
+ * every rule is a list of alternatives separated by ALT and closed by END,
+ * and each alternative is a sequence of byte, byte-class and rule-reference
+ * elements. Groups and repetitions ((...), x*, x+, x?, x{m,n}) become
+ * synthetic rules at parse time.
+ *
+ * Decoding runs the grammar as a pushdown automaton over bytes: the state
+ * is a small set of stacks of element positions, each topped by the next
+ * terminal it expects (an empty stack means "may stop here"). Before each
+ * sampling step llmk_grammar_mask() walks a trie of the vocabulary's token
+ * bytes from the current state, pruning every subtree whose prefix the
+ * grammar rejects, and sets the logits of tokens that cannot follow to
+ * LLMK_GRAMMAR_MASKED. The resulting allowed-token bitmask is cached per
+ * automaton state, so the states that recur in practice (inside a string,
+ * after a comma, between digits) cost a hash lookup and a copy.
+ *
+ * End-of-generation tokens are allowed only while the grammar can stop.
+ * Tokens with no text (BOS, control tokens) or more than
+ * LLMK_GRAMMAR_MAX_TOKEN bytes are never allowed.
+ *
+ * The grammar is byte-level: literals may hold any UTF-8, character classes
+ * may only name ASCII characters (negated classes admit every byte >= 0x80,
+ * so [^"\\] still passes UTF-8 through).
+ *
+ * Freestanding C11 — no libc, no malloc. The runtime's trie, token table,
+ * scratch states and mask cache live in one caller-owned arena.
+ */
+#pragma once
+#ifndef LLMK_GRAMMAR_H
+#define LLMK_GRAMMAR_H
+
+#include <stdint.h>
+
+#define LLMK_GRAMMAR_MAX_ELEMS    8192
+#define LLMK_GRAMMAR_MAX_RULES    512
+#define LLMK_GRAMMAR_MAX_CLASSES  128
+#define LLMK_GRAMMAR_MAX_REPEAT   64    /* n in x{m,n} */
+#define LLMK_GRAMMAR_MAX_STACKS   32    /* stacks per automaton state */
+#define LLMK_GRAMMAR_MAX_DEPTH    48    /* positions per stack (~15 JSON nesting levels) */
+#define LLMK_GRAMMAR_MAX_TOKEN    48    /* longest token text the trie indexes */
+#define LLMK_GRAMMAR_CACHE        32    /* cached allowed-token masks */
+#define LLMK_GRAMMAR_MASKED       (-1.0e9f)   /* same floor as the sampler's bans */
+
+#define LLMK_GRAMMAR_OK           0
+#define LLMK_GRAMMAR_ERR_SYNTAX   -1
+#define LLMK_GRAMMAR_ERR_LIMIT    -2
+#define LLMK_GRAMMAR_ERR_PARAM    -3
+#define LLMK_GRAMMAR_ERR_MEM      -4
+#define LLMK_GRAMMAR_ERR_REJECT   -5
+
+/* Element types */
+#define LLMK_GE_END    0                /* end of rule */
+#define LLMK_GE_ALT    1                /* start of the next alternative */
+#define LLMK_GE_RULE   2                /* value = rule id */
+#define LLMK_GE_CHAR   3                /* value = byte */
+#define LLMK_GE_CLASS  4                /* value = class index */
+
+typedef struct {
+    uint16_t type;
+    uint16_t value;
+} LlmkGrammarElem;
+
+typedef struct {
+    LlmkGrammarElem elem[LLMK_GRAMMAR_MAX_ELEMS];
+    int      n_elem;
+    uint16_t rule_start[LLMK_GRAMMAR_MAX_RULES];   /* 0xFFFF until defined */
+    char     rule_name[LLMK_GRAMMAR_MAX_RULES][32];
+    int      n_rules;
+    int      root;                      /* rule id of "root" */
+    uint32_t cls[LLMK_GRAMMAR_MAX_CLASSES][8];     /* 256-bit byte sets */
+    int      n_cls;
+    char     err[96];                   /* parse error, "line N: ..." */
+    LlmkGrammarElem scratch[LLMK_GRAMMAR_MAX_ELEMS];   /* parser: rule bodies in progress */
+} LlmkGrammar;
+
+/* Automaton state: a set of stacks of element positions (top = last) */
+typedef struct {
+    uint16_t n;
+    uint16_t overflow;                  /* a stack was dropped (too deep / too many) */
+    uint8_t  len[LLMK_GRAMMAR_MAX_STACKS];
+    uint16_t pos[LLMK_GRAMMAR_MAX_STACKS][LLMK_GRAMMAR_MAX_DEPTH];
+} LlmkGrammarState;
+
+/* Parses GBNF text (n bytes; rules "name ::= ...", the start rule is
+ * "root"). On error returns <0 with g->err set. */
+int  llmk_grammar_parse(LlmkGrammar *g, const char *text, int n);
+
+/* Generic JSON (an object at the top level), as GBNF text */
+const char *llmk_grammar_json_gbnf(void);
+
+/* Converts a JSON schema to GBNF text in out (NUL-terminated). Supported:
+ * type (string, number, integer, boolean, null, array, object, or a list of
+ * these), properties (emitted in declaration order, all present), items,
+ * enum, const, anyOf / oneOf; anything else matches any JSON value.
+ * Returns the text length or <0 (err, when non-NULL, gets the reason). */
+int  llmk_grammar_from_json_schema(const char *schema, int n, char *out, int cap, char *err, int err_cap);
+
+/* Automaton over a grammar without a vocabulary (tests, tools) */
+void llmk_grammar_state_init(const LlmkGrammar *g, LlmkGrammarState *st);
+int  llmk_grammar_state_accept(const LlmkGrammar *g, LlmkGrammarState *st, const char *bytes, int n);
+int  llmk_grammar_state_can_end(const LlmkGrammarState *st);
+
+/* Token text of id into out (≤ cap bytes), as printed */
+typedef int (*LlmkGrammarPieceFn)(void *ctx, int id, char *out, int cap);
+/* 1 when id ends generation (EOS / EOT) */
+typedef int (*LlmkGrammarStopFn)(void *ctx, int id);
+
+typedef struct {
+    int32_t child;                      /* first child node, -1 = none */
+    int32_t sibling;                    /* next node with the same parent */
+    int32_t tok;                        /* first token whose text ends here, chained by tok_next */
+    uint8_t byte;
+} LlmkGrammarNode;
+
+typedef struct {
+    uint64_t hash;
+    uint32_t stamp;                     /* 0 = empty; LRU clock otherwise */
+    int32_t  n_allowed;
+    LlmkGrammarState *key;
+    uint32_t *bits;
+} LlmkGrammarCacheEntry;
+
+typedef struct {
+    const LlmkGrammar *g;
+    int       n_vocab;
+    int       words;                    /* uint32 words per vocabulary bitmask */
+
+    LlmkGrammarNode *node;              /* [0] = root */
+    int       n_nodes;
+    int32_t  *tok_next;                 /* [n_vocab] */
+    int32_t  *tok_off;                  /* [n_vocab] offset into text, -1 = never allowed */
+    uint8_t  *tok_len;                  /* [n_vocab] */
+    char     *text;                     /* token bytes */
+    uint32_t *stop;                     /* bitmask of end-of-generation tokens */
+
+    LlmkGrammarState  cur;
+    LlmkGrammarState *level;            /* [LLMK_GRAMMAR_MAX_TOKEN + 1] trie walk scratch */
+    int32_t   walk[LLMK_GRAMMAR_MAX_TOKEN + 1];        /* next sibling to visit per depth */
+    uint32_t  first[LLMK_GRAMMAR_MAX_TOKEN + 1][8];    /* bytes level[d] can take */
+    uint32_t *bits;                     /* allowed tokens for cur (valid when mask_valid) */
+    int       mask_valid;
+    int       n_allowed;
+    LlmkGrammarCacheEntry cache[LLMK_GRAMMAR_CACHE];
+    uint32_t  clock;
+
+    /* Stats (cumulative) */
+    uint64_t  masks;
+    uint64_t  cache_hits;
+    uint64_t  nodes_visited;
+} LlmkGrammarRt;
+
+/* Arena size for llmk_grammar_rt_init (calls piece() once per token) */
+uint64_t llmk_grammar_rt_bytes(int n_vocab, LlmkGrammarPieceFn piece, void *ctx);
+
+/* Builds the vocabulary trie in mem. The runtime is tied to the vocabulary,
+ * not to a grammar: llmk_grammar_rt_start() switches grammars. */
+int  llmk_grammar_rt_init(LlmkGrammarRt *rt, void *mem, uint64_t bytes, int n_vocab,
+                          LlmkGrammarPieceFn piece, LlmkGrammarStopFn is_stop, void *ctx);
+
+/* Resets the automaton to g's root and drops the mask cache. g must
+ * outlive the runtime's use of it. */
+void llmk_grammar_rt_start(LlmkGrammarRt *rt, const LlmkGrammar *g);
+
+/* Sets the logits of tokens that cannot follow to LLMK_GRAMMAR_MASKED.
+ * Returns how many tokens are allowed (0 = the grammar is stuck). */
+int  llmk_grammar_mask(LlmkGrammarRt *rt, float *logits);
+
+/* After llmk_grammar_mask: 1 if id is allowed */
+int  llmk_grammar_allowed(const LlmkGrammarRt *rt, int id);
+
+/* After llmk_grammar_mask: the allowed token with the largest logit, or -1 */
+int  llmk_grammar_best(const LlmkGrammarRt *rt, const float *logits);
+
+/* Advances the automaton by token id's text. End-of-generation tokens are
+ * accepted when the grammar can stop. Returns LLMK_GRAMMAR_ERR_REJECT (state
+ * unchanged) if the grammar does not allow it. */
+int  llmk_grammar_accept(LlmkGrammarRt *rt, int id);
+
+/* 1 when the output so far is a complete sentence */
+int  llmk_grammar_can_end(const LlmkGrammarRt *rt);
+
+/* 1 when nothing but stopping is possible */
+int  llmk_grammar_must_end(const LlmkGrammarRt *rt);
+
+#endif /* LLMK_GRAMMAR_H */
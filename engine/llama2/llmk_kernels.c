@@ -0,0 +1,631 @@
+// llmk_kernels.c — Transformer math kernels (f32 / Q8_0 matmul, norms, attention dots)
+//
+// Unity fragment: included by soma_inference.c in the UEFI build and by
+// engine/host/llmk_host_rt.c on Linux, so both run the same kernels.
+//
+// The includer provides, before this file:
+//   <emmintrin.h> / <immintrin.h>, djiblas.h (djiblas_sgemm_f32, CPUFeatures)
+//   void *simple_alloc(unsigned long)       activation quant buffers
+//   int g_cfg_q8_act_quant                  0 = f32 activations, 1/2 = int8
+//   int g_attn_use_avx2, g_attn_force       attention SIMD selection
+//   llmk_dot_f32_avx2 / llmk_axpy_f32_avx2  (attention_avx2.c)
+
+// ============================================================================
+// MATH FUNCTIONS
+// ============================================================================
+
+float fast_sqrt(float x) {
+    if (x <= 0.0f) return 0.0f;
+    float xhalf = 0.5f * x;
+    int i = *(int*)&x;
+    i = 0x5f3759df - (i >> 1);
+    x = *(float*)&i;
+    x = x * (1.5f - xhalf * x * x);
+    x = x * (1.5f - xhalf * x * x);
+    return 1.0f / x;
+}
+
+float fast_exp(float x) {
+    if (x < -10.0f) return 0.0f;
+    if (x > 10.0f) return 22026.0f;
+    x = 1.0f + x / 256.0f;
+    x *= x; x *= x; x *= x; x *= x;
+    x *= x; x *= x; x *= x; x *= x;
+    return x;
+}
+
+// ============================================================================
+// TRANSFORMER OPERATIONS
+// ============================================================================
+
+void rmsnorm_eps(float* o, float* x, float* weight, int size, float eps) {
+    float ss = 0.0f;
+    for (int j = 0; j < size; j++) {
+        ss += x[j] * x[j];
+    }
+    ss /= size;
+    ss += eps;
+    ss = 1.0f / fast_sqrt(ss);
+    for (int j = 0; j < size; j++) {
+        o[j] = weight[j] * (ss * x[j]);
+    }
+}
+
+void rmsnorm(float* o, float* x, float* weight, int size) {
+    rmsnorm_eps(o, x, weight, size, 1e-5f);
+}
+
+// GELU, tanh approximation (gemma): 0.5·x·(1 + tanh(√(2/π)·(x + 0.044715·x³)))
+float gelu_tanh(float x) {
+    float u = 0.7978845608f * (x + 0.044715f * x * x * x);
+    float t = 1.0f - 2.0f / (fast_exp(2.0f * u) + 1.0f);
+    return 0.5f * x * (1.0f + t);
+}
+
+void matmul(float* xout, float* x, float* w, int n, int d) {
+    // DjibLAS computes (column-major): C(m x n) = A(k x m)^T * B(k x n)
+    // We want (row-major weights): xout(d) = W(d x n) * x(n)
+    // Trick: W(d x n) row-major has the same memory layout as B(k x n_out)
+    // column-major when k=n and n_out=d (because W[i*n + l] == B[l + k*i]).
+    // Use A = x as a (k x 1) column-major matrix.
+    // Result C is (1 x d) column-major, so it lands contiguous into xout.
+    djiblas_sgemm_f32(
+        /*m=*/1, /*n=*/d, /*k=*/n,
+        /*A=*/x, /*lda=*/n,
+        /*B=*/w, /*ldb=*/n,
+        /*C=*/xout, /*ldc=*/1
+    );
+}
+
+// Multi-position matmul: xout[t](d) = W(d x n) * x[t](n) for t < nt, rows
+// contiguous. DjibLAS computes every output as one dot product whatever the
+// tiling, so each row matches matmul() bit for bit, while W is streamed once
+// per 4 rows. The tile reads x in whole groups of 4 rows: x must hold nt
+// rounded up to 4 rows.
+void matmul_batch(float* xout, float* x, float* w, int n, int d, int nt) {
+    djiblas_sgemm_f32(
+        /*m=*/d, /*n=*/nt, /*k=*/n,
+        /*A=*/w, /*lda=*/n,
+        /*B=*/x, /*ldb=*/n,
+        /*C=*/xout, /*ldc=*/d
+    );
+}
+
+static UINT16 llmk_read_u16_unaligned(const void *p) {
+    const UINT8 *b = (const UINT8 *)p;
+    return (UINT16)((UINT16)b[0] | ((UINT16)b[1] << 8));
+}
+
+// IEEE-754 half -> float32. Handles normals/denormals/inf/nan.
+static float llmk_fp16_to_fp32(UINT16 h) {
+    UINT32 sign = (UINT32)(h >> 15) & 1u;
+    UINT32 exp  = (UINT32)(h >> 10) & 0x1Fu;
+    UINT32 mant = (UINT32)h & 0x3FFu;
+
+    UINT32 out_sign = sign << 31;
+    UINT32 out_exp;
+    UINT32 out_mant;
+
+    if (exp == 0) {
+        if (mant == 0) {
+            UINT32 u = out_sign;
+            return *(float *)&u;
+        }
+        // subnormal
+        exp = 1;
+        while ((mant & 0x400u) == 0) {
+            mant <<= 1;
+            exp--;
+        }
+        mant &= 0x3FFu;
+        out_exp  = (exp + (127 - 15)) << 23;
+        out_mant = mant << 13;
+    } else if (exp == 31) {
+        // inf/nan
+        out_exp  = 0xFFu << 23;
+        out_mant = mant ? (mant << 13) : 0;
+    } else {
+        out_exp  = (exp + (127 - 15)) << 23;
+        out_mant = mant << 13;
+    }
+
+    UINT32 u = out_sign | out_exp | out_mant;
+    return *(float *)&u;
+}
+
+static UINT64 llmk_align_up_u64(UINT64 x, UINT64 a) {
+    return (a == 0) ? x : ((x + a - 1ULL) / a) * a;
+}
+
+// GGML Q8_0 block format: fp16 scale + 32 int8 values.
+// bytes_per_row = (cols/32) * 34.
+static UINT64 llmk_q8_0_row_bytes(int cols) {
+    if (cols <= 0) return 0;
+    if ((cols % 32) != 0) return 0;
+    return ((UINT64)cols / 32ULL) * 34ULL;
+}
+
+static void llmk_dequantize_q8_0_row(float *dst, const UINT8 *row_q8, int cols) {
+    UINT64 rb = llmk_q8_0_row_bytes(cols);
+    if (!dst || !row_q8 || rb == 0) return;
+
+    const int nb = cols / 32;
+    const UINT8 *p = row_q8;
+    for (int b = 0; b < nb; b++) {
+        UINT16 dh = llmk_read_u16_unaligned(p);
+        float d = llmk_fp16_to_fp32(dh);
+        const INT8 *qs = (const INT8 *)(p + 2);
+        for (int i = 0; i < 32; i++) {
+            dst[b * 32 + i] = d * (float)qs[i];
+        }
+        p += 34;
+    }
+}
+
+// xout(d) = W(d x n) * x(n) where W is Q8_0 row-major blocks.
+static void matmul_q8_0_scalar(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
+    if (!xout || !x || !w_q8) return;
+    if ((n % 32) != 0) {
+        // Q8_0 requires cols multiple of 32.
+        for (int i = 0; i < d; i++) xout[i] = 0.0f;
+        return;
+    }
+
+    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
+    const int nb = n / 32;
+
+    for (int r = 0; r < d; r++) {
+        const UINT8 *row = w_q8 + (UINTN)r * (UINTN)row_bytes;
+        float acc = 0.0f;
+        const UINT8 *p = row;
+        for (int b = 0; b < nb; b++) {
+            float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const INT8 *qs = (const INT8 *)(p + 2);
+            float sum = 0.0f;
+            const float *xblk = x + b * 32;
+            for (int i = 0; i < 32; i++) {
+                sum += xblk[i] * (float)qs[i];
+            }
+            acc += dscale * sum;
+            p += 34;
+        }
+        xout[r] = acc;
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+// Shared activation quant buffers for Q8_0 matmuls (used only when q8_act_quant!=0).
+// Monotonic allocation is OK; we only grow a couple of times (dim/hidden_dim).
+static float *g_q8_act_scales = NULL;
+static INT8  *g_q8_act_qs = NULL;
+static int g_q8_act_cap_n = 0;
+
+static void llmk_q8_act_ensure(int n) {
+    if (n <= 0) return;
+    if ((n % 32) != 0) return;
+    if (g_q8_act_cap_n >= n && g_q8_act_scales && g_q8_act_qs) return;
+
+    const int nb = n / 32;
+    g_q8_act_scales = (float *)simple_alloc((unsigned long)nb * sizeof(float));
+    g_q8_act_qs = (INT8 *)simple_alloc((unsigned long)n * sizeof(INT8));
+    g_q8_act_cap_n = n;
+}
+
+static void llmk_quantize_f32_to_q8_blocks(const float *x, int n, INT8 *out_qs, float *out_scales) {
+    if (!x || !out_qs || !out_scales) return;
+    if (n <= 0 || (n % 32) != 0) return;
+    const int nb = n / 32;
+    for (int b = 0; b < nb; b++) {
+        const float *xb = x + b * 32;
+        float max_abs = 0.0f;
+        for (int i = 0; i < 32; i++) {
+            float v = xb[i];
+            if (v < 0.0f) v = -v;
+            if (v > max_abs) max_abs = v;
+        }
+        float dscale = (max_abs > 0.0f) ? (max_abs / 127.0f) : 0.0f;
+        out_scales[b] = dscale;
+        float inv = (dscale > 0.0f) ? (1.0f / dscale) : 0.0f;
+        INT8 *qdst = out_qs + b * 32;
+        for (int i = 0; i < 32; i++) {
+            float fv = xb[i] * inv;
+            int iv = (fv >= 0.0f) ? (int)(fv + 0.5f) : (int)(fv - 0.5f);
+            if (iv < -127) iv = -127;
+            if (iv > 127) iv = 127;
+            qdst[i] = (INT8)iv;
+        }
+    }
+}
+
+// Dot kernel for 32 signed int8 values using AVX2.
+// Returns int32 sum(a[i] * b[i]).
+__attribute__((target("avx2")))
+static int llmk_dot_i8_32_avx2(const INT8 *a, const INT8 *b) {
+    __m128i a0 = _mm_loadu_si128((const __m128i *)(a + 0));
+    __m128i a1 = _mm_loadu_si128((const __m128i *)(a + 16));
+    __m128i b0 = _mm_loadu_si128((const __m128i *)(b + 0));
+    __m128i b1 = _mm_loadu_si128((const __m128i *)(b + 16));
+
+    __m256i a16_0 = _mm256_cvtepi8_epi16(a0);
+    __m256i a16_1 = _mm256_cvtepi8_epi16(a1);
+    __m256i b16_0 = _mm256_cvtepi8_epi16(b0);
+    __m256i b16_1 = _mm256_cvtepi8_epi16(b1);
+
+    __m256i s0 = _mm256_madd_epi16(a16_0, b16_0);
+    __m256i s1 = _mm256_madd_epi16(a16_1, b16_1);
+    __m256i s = _mm256_add_epi32(s0, s1);
+
+    __m128i lo = _mm256_castsi256_si128(s);
+    __m128i hi = _mm256_extracti128_si256(s, 1);
+    __m128i sum = _mm_add_epi32(lo, hi);
+    __m128i shuf = _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1));
+    sum = _mm_add_epi32(sum, shuf);
+    shuf = _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2));
+    sum = _mm_add_epi32(sum, shuf);
+    return _mm_cvtsi128_si32(sum);
+}
+
+// AVX2 implementation: converts int8 weights to float on the fly.
+// Compiled as AVX2 even when the TU default is SSE2.
+__attribute__((target("avx2")))
+static void matmul_q8_0_avx2(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
+    if (!xout || !x || !w_q8) return;
+    if ((n % 32) != 0) {
+        for (int i = 0; i < d; i++) xout[i] = 0.0f;
+        return;
+    }
+
+    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
+    const int nb = n / 32;
+
+    for (int r = 0; r < d; r++) {
+        const UINT8 *row = w_q8 + (UINTN)r * (UINTN)row_bytes;
+        float acc = 0.0f;
+        const UINT8 *p = row;
+
+        for (int b = 0; b < nb; b++) {
+            float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const INT8 *qs = (const INT8 *)(p + 2);
+            const float *xblk = x + b * 32;
+
+            __m256 vacc = _mm256_setzero_ps();
+
+            // 32 values per block, process 8 at a time.
+            for (int i = 0; i < 32; i += 8) {
+                // Load 8 int8 values (unaligned) and sign-extend to 8 int32.
+                __m128i q8 = _mm_loadl_epi64((const __m128i *)(qs + i));
+                __m256i q32 = _mm256_cvtepi8_epi32(q8);
+                __m256 qf = _mm256_cvtepi32_ps(q32);
+
+                __m256 xf = _mm256_loadu_ps(xblk + i);
+                vacc = _mm256_add_ps(vacc, _mm256_mul_ps(xf, qf));
+            }
+
+            // Horizontal sum of vacc without requiring SSE3 (build uses -msse2).
+            __m128 lo = _mm256_castps256_ps128(vacc);
+            __m128 hi = _mm256_extractf128_ps(vacc, 1);
+            __m128 sum128 = _mm_add_ps(lo, hi);
+            __m128 shuf = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(2, 3, 0, 1));
+            sum128 = _mm_add_ps(sum128, shuf);
+            shuf = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1, 0, 3, 2));
+            sum128 = _mm_add_ps(sum128, shuf);
+            float sum = _mm_cvtss_f32(sum128);
+            acc += dscale * sum;
+            p += 34;
+        }
+
+        xout[r] = acc;
+    }
+}
+
+// AVX2 implementation: quantize activations (x) into Q8_0 blocks and use int8 dot-products.
+// Faster on real AVX2 CPUs; adds extra approximation (beyond quantized weights).
+__attribute__((target("avx2")))
+static void matmul_q8_0_avx2_i8_prequant(float *xout, const INT8 *x_qs, const float *x_scales, const UINT8 *w_q8, int n, int d) {
+    if (!xout || !x_qs || !x_scales || !w_q8) return;
+    if ((n % 32) != 0) {
+        for (int i = 0; i < d; i++) xout[i] = 0.0f;
+        return;
+    }
+
+    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
+    const int nb = n / 32;
+
+    for (int r = 0; r < d; r++) {
+        const UINT8 *row = w_q8 + (UINTN)r * (UINTN)row_bytes;
+        float acc = 0.0f;
+        const UINT8 *p = row;
+        for (int b = 0; b < nb; b++) {
+            float wscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const INT8 *wqs = (const INT8 *)(p + 2);
+            const INT8 *blk = x_qs + b * 32;
+            int dot = llmk_dot_i8_32_avx2(blk, wqs);
+            acc += (wscale * x_scales[b]) * (float)dot;
+            p += 34;
+        }
+        xout[r] = acc;
+    }
+}
+
+__attribute__((target("avx2")))
+static void matmul_q8_0_avx2_i8(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
+    if (!xout || !x || !w_q8) return;
+    if ((n % 32) != 0) {
+        for (int i = 0; i < d; i++) xout[i] = 0.0f;
+        return;
+    }
+
+    llmk_q8_act_ensure(n);
+    if (!g_q8_act_qs || !g_q8_act_scales) return;
+    llmk_quantize_f32_to_q8_blocks(x, n, g_q8_act_qs, g_q8_act_scales);
+    matmul_q8_0_avx2_i8_prequant(xout, g_q8_act_qs, g_q8_act_scales, w_q8, n, d);
+}
+#endif
+
+// Multi-position Q8_0 matmuls (xout[t] = W * x[t], rows contiguous, nt <=
+// LLMK_MATMUL_BATCH_MAX): each weight block is decoded once for all rows and
+// every row keeps the one-row kernel's summation order, so the results are
+// bit-identical to nt calls of it.
+#define LLMK_MATMUL_BATCH_MAX 16
+
+static void matmul_q8_0_scalar_batch(float *xout, const float *x, const UINT8 *w_q8, int n, int d, int nt) {
+    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
+    const int nb = n / 32;
+    float acc[LLMK_MATMUL_BATCH_MAX];
+
+    for (int r = 0; r < d; r++) {
+        const UINT8 *p = w_q8 + (UINTN)r * (UINTN)row_bytes;
+        for (int t = 0; t < nt; t++) acc[t] = 0.0f;
+        for (int b = 0; b < nb; b++) {
+            float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const INT8 *qs = (const INT8 *)(p + 2);
+            for (int t = 0; t < nt; t++) {
+                const float *xblk = x + (UINTN)t * (UINTN)n + b * 32;
+                float sum = 0.0f;
+                for (int i = 0; i < 32; i++) {
+                    sum += xblk[i] * (float)qs[i];
+                }
+                acc[t] += dscale * sum;
+            }
+            p += 34;
+        }
+        for (int t = 0; t < nt; t++) xout[(UINTN)t * (UINTN)d + r] = acc[t];
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+__attribute__((target("avx2")))
+static void matmul_q8_0_avx2_batch(float *xout, const float *x, const UINT8 *w_q8, int n, int d, int nt) {
+    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
+    const int nb = n / 32;
+    float acc[LLMK_MATMUL_BATCH_MAX];
+
+    for (int r = 0; r < d; r++) {
+        const UINT8 *p = w_q8 + (UINTN)r * (UINTN)row_bytes;
+        for (int t = 0; t < nt; t++) acc[t] = 0.0f;
+        for (int b = 0; b < nb; b++) {
+            float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const INT8 *qs = (const INT8 *)(p + 2);
+            __m256 qf[4];
+            for (int i = 0; i < 4; i++) {
+                __m128i q8 = _mm_loadl_epi64((const __m128i *)(qs + i * 8));
+                qf[i] = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(q8));
+            }
+            for (int t = 0; t < nt; t++) {
+                const float *xblk = x + (UINTN)t * (UINTN)n + b * 32;
+                __m256 vacc = _mm256_setzero_ps();
+                for (int i = 0; i < 4; i++) {
+                    __m256 xf = _mm256_loadu_ps(xblk + i * 8);
+                    vacc = _mm256_add_ps(vacc, _mm256_mul_ps(xf, qf[i]));
+                }
+                // Same horizontal sum as matmul_q8_0_avx2
+                __m128 lo = _mm256_castps256_ps128(vacc);
+                __m128 hi = _mm256_extractf128_ps(vacc, 1);
+                __m128 sum128 = _mm_add_ps(lo, hi);
+                __m128 shuf = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(2, 3, 0, 1));
+                sum128 = _mm_add_ps(sum128, shuf);
+                shuf = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1, 0, 3, 2));
+                sum128 = _mm_add_ps(sum128, shuf);
+                acc[t] += dscale * _mm_cvtss_f32(sum128);
+            }
+            p += 34;
+        }
+        for (int t = 0; t < nt; t++) xout[(UINTN)t * (UINTN)d + r] = acc[t];
+    }
+}
+#endif
+
+// Cached CPU feature checks (avoid repeated CPUID).
+static int llmk_has_avx2_cached(void) {
+    static int inited = 0;
+    static int has = 0;
+    if (!inited) {
+        CPUFeatures f;
+        djiblas_detect_cpu(&f);
+        has = (f.has_avx2 != 0);
+        inited = 1;
+    }
+    return has;
+}
+
+static void matmul_q8_0(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
+    if (!xout || !x || !w_q8) return;
+    if ((n % 32) != 0) {
+        for (int i = 0; i < d; i++) xout[i] = 0.0f;
+        return;
+    }
+
+#if defined(__x86_64__) || defined(_M_X64)
+    static int g_q8_kernel_inited = 0;
+    static int g_q8_use_avx2 = 0;
+    if (!g_q8_kernel_inited) {
+        CPUFeatures f;
+        djiblas_detect_cpu(&f);
+        g_q8_use_avx2 = (f.has_avx2 != 0);
+        g_q8_kernel_inited = 1;
+    }
+    if (g_q8_use_avx2) {
+        if (g_cfg_q8_act_quant == 1) {
+            matmul_q8_0_avx2_i8(xout, x, w_q8, n, d);
+        } else {
+            matmul_q8_0_avx2(xout, x, w_q8, n, d);
+        }
+        return;
+    }
+#endif
+
+    matmul_q8_0_scalar(xout, x, w_q8, n, d);
+}
+
+// nt rows through the same kernel choice as matmul_q8_0
+static void matmul_q8_0_batch(float *xout, const float *x, const UINT8 *w_q8, int n, int d, int nt) {
+    if (!xout || !x || !w_q8 || nt <= 0) return;
+    if (nt > LLMK_MATMUL_BATCH_MAX || (n % 32) != 0) {
+        for (int t = 0; t < nt; t++) matmul_q8_0(xout + (UINTN)t * (UINTN)d, x + (UINTN)t * (UINTN)n, w_q8, n, d);
+        return;
+    }
+#if defined(__x86_64__) || defined(_M_X64)
+    if (llmk_has_avx2_cached()) {
+        if (g_cfg_q8_act_quant == 1) {
+            for (int t = 0; t < nt; t++) {
+                matmul_q8_0_avx2_i8(xout + (UINTN)t * (UINTN)d, x + (UINTN)t * (UINTN)n, w_q8, n, d);
+            }
+        } else {
+            matmul_q8_0_avx2_batch(xout, x, w_q8, n, d, nt);
+        }
+        return;
+    }
+#endif
+    matmul_q8_0_scalar_batch(xout, x, w_q8, n, d, nt);
+}
+
+void softmax(float* x, int size) {
+    float max_val = x[0];
+#if defined(__x86_64__) || defined(_M_X64)
+    // SSE2 max reduction
+    {
+        __m128 vmax = _mm_set1_ps(max_val);
+        int i = 0;
+        for (; i + 4 <= size; i += 4) {
+            __m128 v = _mm_loadu_ps(&x[i]);
+            vmax = _mm_max_ps(vmax, v);
+        }
+        __m128 shuf = _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1));
+        vmax = _mm_max_ps(vmax, shuf);
+        shuf = _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2));
+        vmax = _mm_max_ps(vmax, shuf);
+        _mm_store_ss(&max_val, vmax);
+        for (; i < size; i++) {
+            if (x[i] > max_val) max_val = x[i];
+        }
+    }
+#else
+    for (int i = 1; i < size; i++) {
+        if (x[i] > max_val) max_val = x[i];
+    }
+#endif
+
+    float sum = 0.0f;
+#if defined(__x86_64__) || defined(_M_X64)
+    // Scalar exp, but vectorized accumulation + normalization.
+    {
+        __m128 vsum = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= size; i += 4) {
+            float e0 = fast_exp(x[i + 0] - max_val);
+            float e1 = fast_exp(x[i + 1] - max_val);
+            float e2 = fast_exp(x[i + 2] - max_val);
+            float e3 = fast_exp(x[i + 3] - max_val);
+            x[i + 0] = e0;
+            x[i + 1] = e1;
+            x[i + 2] = e2;
+            x[i + 3] = e3;
+            __m128 v = _mm_loadu_ps(&x[i]);
+            vsum = _mm_add_ps(vsum, v);
+        }
+        __m128 shuf = _mm_shuffle_ps(vsum, vsum, _MM_SHUFFLE(2, 3, 0, 1));
+        vsum = _mm_add_ps(vsum, shuf);
+        shuf = _mm_shuffle_ps(vsum, vsum, _MM_SHUFFLE(1, 0, 3, 2));
+        vsum = _mm_add_ps(vsum, shuf);
+        _mm_store_ss(&sum, vsum);
+        for (; i < size; i++) {
+            x[i] = fast_exp(x[i] - max_val);
+            sum += x[i];
+        }
+
+        float invsum = 1.0f / sum;
+        __m128 vinv = _mm_set1_ps(invsum);
+        i = 0;
+        for (; i + 4 <= size; i += 4) {
+            __m128 v = _mm_loadu_ps(&x[i]);
+            v = _mm_mul_ps(v, vinv);
+            _mm_storeu_ps(&x[i], v);
+        }
+        for (; i < size; i++) {
+            x[i] *= invsum;
+        }
+    }
+#else
+    for (int i = 0; i < size; i++) {
+        x[i] = fast_exp(x[i] - max_val);
+        sum += x[i];
+    }
+    float invsum = 1.0f / sum;
+    for (int i = 0; i < size; i++) {
+        x[i] *= invsum;
+    }
+#endif
+}
+
+static inline float dot_f32_sse2(const float* a, const float* b, int n) {
+#if defined(__x86_64__) || defined(_M_X64)
+    __m128 sum = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        sum = _mm_add_ps(sum, _mm_mul_ps(va, vb));
+    }
+    float tmp[4]; // SAFE: fixed-size SSE2 lane store
+    _mm_storeu_ps(tmp, sum);
+    float total = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+    for (; i < n; i++) total += a[i] * b[i];
+    return total;
+#else
+    float total = 0.0f;
+    for (int i = 0; i < n; i++) total += a[i] * b[i];
+    return total;
+#endif
+}
+
+static inline void axpy_f32_sse2(float* dst, const float* src, float a, int n) {
+#if defined(__x86_64__) || defined(_M_X64)
+    __m128 va = _mm_set1_ps(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vd = _mm_loadu_ps(dst + i);
+        __m128 vs = _mm_loadu_ps(src + i);
+        vd = _mm_add_ps(vd, _mm_mul_ps(va, vs));
+        _mm_storeu_ps(dst + i, vd);
+    }
+    for (; i < n; i++) dst[i] += a * src[i];
+#else
+    for (int i = 0; i < n; i++) dst[i] += a * src[i];
+#endif
+}
+
+static inline float dot_f32_best(const float* a, const float* b, int n) {
+    int use_avx2 = g_attn_use_avx2;
+    if (g_attn_force == 0) use_avx2 = 0;
+    else if (g_attn_force == 1) use_avx2 = 1;
+    if (use_avx2) return llmk_dot_f32_avx2(a, b, n);
+    return dot_f32_sse2(a, b, n);
+}
+
+static inline void axpy_f32_best(float* dst, const float* src, float a, int n) {
+    int use_avx2 = g_attn_use_avx2;
+    if (g_attn_force == 0) use_avx2 = 0;
+    else if (g_attn_force == 1) use_avx2 = 1;
+    if (use_avx2) { llmk_axpy_f32_avx2(dst, src, a, n); return; }
+    axpy_f32_sse2(dst, src, a, n);
+}
@@ -0,0 +1,86 @@
+/* llmk_kv_window.c — Sliding KV window with attention sinks
+ *
+ * See llmk_kv_window.h. Unity-included by soma_inference.c and the host
+ * runtime, after llmk_rope.c.
+ */
+
+#include "llmk_kv_window.h"
+
+void llmk_kvw_init(LlmkKvWindow *w, int seq_len, int32_t *tok_mem) {
+    w->enabled = 1;
+    w->sinks = LLMK_KVW_DEFAULT_SINKS;
+    w->discard = 0;
+    w->seq_len = seq_len;
+    w->tok = tok_mem;
+    w->on_evict = 0;
+    w->evict_ctx = 0;
+    w->shifts = 0;
+    w->evicted = 0;
+    llmk_kvw_reset(w);
+}
+
+void llmk_kvw_reset(LlmkKvWindow *w) {
+    if (w->tok) {
+        for (int i = 0; i < w->seq_len; i++) w->tok[i] = -1;
+    }
+}
+
+static int kvw_sinks(const LlmkKvWindow *w) {
+    int s = w->sinks < 0 ? 0 : w->sinks;
+    return (s > w->seq_len / 2) ? w->seq_len / 2 : s;
+}
+
+int llmk_kvw_discard(const LlmkKvWindow *w) {
+    const int room = w->seq_len - kvw_sinks(w);
+    int d = (w->discard > 0) ? w->discard : room / 4;
+    if (d < 1) d = 1;
+    return (d > room) ? room : d;
+}
+
+void llmk_kvw_note(LlmkKvWindow *w, int pos, int token) {
+    if (w->tok && pos >= 0 && pos < w->seq_len) w->tok[pos] = token;
+}
+
+/* rows [from, to) of one layer slab move down by d (dst < src: ascending copy) */
+static void kvw_move_rows(float *slab, int from, int to, int d, int kv_dim) {
+    float *dst = slab + (uint64_t)(from - d) * kv_dim;
+    const float *src = slab + (uint64_t)from * kv_dim;
+    const uint64_t n = (uint64_t)(to - from) * kv_dim;
+    for (uint64_t i = 0; i < n; i++) dst[i] = src[i];
+}
+
+int llmk_kvw_make_room(LlmkKvWindow *w, const LlmkKvCache *kv, const LlmkRope *rope, int pos, int need) {
+    if (pos < 0) pos = 0;
+    if (pos + need <= kv->seq_len) return pos;
+    if (!w->enabled || w->seq_len != kv->seq_len) return -1;
+    const int S = kvw_sinks(w);
+    if (need > kv->seq_len - S) return -1;
+
+    int d = llmk_kvw_discard(w);
+    if (pos + need - kv->seq_len > d) d = pos + need - kv->seq_len;
+    if (d > pos - S) d = pos - S;
+    if (d <= 0) return -1;
+
+    if (w->on_evict && w->tok) w->on_evict(w->evict_ctx, w->tok + S, d, S);
+
+    const int rerotate = rope && rope->ready && rope->head_size * kv->n_kv_heads == kv->kv_dim;
+    const uint64_t slab = (uint64_t)kv->seq_len * kv->kv_dim;
+    for (int l = 0; l < kv->n_layers; l++) {
+        float *kl = kv->key_cache + (uint64_t)l * slab;
+        float *vl = kv->value_cache + (uint64_t)l * slab;
+        kvw_move_rows(kl, S + d, pos, d, kv->kv_dim);
+        kvw_move_rows(vl, S + d, pos, d, kv->kv_dim);
+        if (rerotate) {
+            for (int r = S; r < pos - d; r++) {
+                llmk_rope_shift(rope, kl + (uint64_t)r * kv->kv_dim, kv->n_kv_heads, -d);
+            }
+        }
+    }
+    if (w->tok) {
+        for (int r = S; r < pos - d; r++) w->tok[r] = w->tok[r + d];
+        for (int r = pos - d; r < pos; r++) w->tok[r] = -1;
+    }
+    w->shifts++;
+    w->evicted += (uint64_t)d;
+    return pos - d;
+}
@@ -0,0 +1,80 @@
+/* llmk_kv_window.h — Sliding KV window with attention sinks
+ *
+ * When the cache is full, the REPL used to wipe it and forget the whole
+ * conversation. Instead, the window keeps the first `sinks` rows (the
+ * attention sinks of StreamingLLM: the softmax parks mass there, and
+ * evicting them wrecks perplexity) plus the most recent tokens, and evicts
+ * the oldest `discard` rows after the sinks in one go:
+ *
+ *   before  [S sinks | d evicted | kept .............. ] pos = seq_len
+ *   after   [S sinks | kept .............. | free ...  ] pos − d
+ *
+ * Kept rows move down by d and are re-indexed to their new position. Keys
+ * were stored rotated at their old position, so each moved K row is turned
+ * back by R(−d) (llmk_rope_shift); V rows are copied as is. Evicting in
+ * chunks amortizes the move: with d = window/4 each token is copied about
+ * three times per layer over its lifetime, far less than its attention
+ * reads. Memory is the existing [layers][seq_len][kv_dim] cache, so decode
+ * can run indefinitely at constant memory.
+ *
+ * An optional token log (one int per cache row) lets the caller see the
+ * evicted span, e.g. to fold it into soma_memory before it is gone.
+ *
+ * Freestanding C11 — no libc, no malloc.
+ */
+#pragma once
+#ifndef LLMK_KV_WINDOW_H
+#define LLMK_KV_WINDOW_H
+
+#include <stdint.h>
+
+#include "llmk_rope.h"
+
+#define LLMK_KVW_DEFAULT_SINKS  4
+
+typedef struct {
+    float *key_cache;                   /* [n_layers][seq_len][kv_dim] */
+    float *value_cache;
+    int    n_layers;
+    int    seq_len;
+    int    kv_dim;
+    int    n_kv_heads;
+} LlmkKvCache;
+
+/* Called with the rows about to be evicted (tokens may contain −1 where the
+ * log has no entry). first_pos is the cache row of tokens[0]. */
+typedef void (*LlmkKvEvictFn)(void *ctx, const int32_t *tokens, int n, int first_pos);
+
+typedef struct {
+    int      enabled;
+    int      sinks;                     /* rows never evicted */
+    int      discard;                   /* rows evicted per shift; 0 = (seq_len − sinks) / 4 */
+    int      seq_len;
+    int32_t *tok;                       /* [seq_len] token per row, −1 = unknown (optional) */
+    LlmkKvEvictFn on_evict;             /* optional */
+    void    *evict_ctx;
+
+    /* Stats (cumulative) */
+    uint64_t shifts;
+    uint64_t evicted;
+} LlmkKvWindow;
+
+/* Enabled, default sinks, auto discard. tok_mem (seq_len ints) may be 0. */
+void llmk_kvw_init(LlmkKvWindow *w, int seq_len, int32_t *tok_mem);
+
+/* Forgets the token log (the cache was wiped); settings and stats stay */
+void llmk_kvw_reset(LlmkKvWindow *w);
+
+/* Rows evicted by the next shift (discard resolved and clamped) */
+int  llmk_kvw_discard(const LlmkKvWindow *w);
+
+/* Records the token written to cache row pos */
+void llmk_kvw_note(LlmkKvWindow *w, int pos, int token);
+
+/* Makes room for `need` more rows starting at pos. Returns pos when they
+ * already fit, pos − evicted after a shift, or −1 when the window is off or
+ * `need` exceeds seq_len − sinks (the caller falls back to a reset). rope may
+ * be 0 or not ready (positions are re-indexed without re-rotation). */
+int  llmk_kvw_make_room(LlmkKvWindow *w, const LlmkKvCache *kv, const LlmkRope *rope, int pos, int need);
+
+#endif /* LLMK_KV_WINDOW_H */
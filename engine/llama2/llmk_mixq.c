@@ -0,0 +1,319 @@
+/* llmk_mixq.c — Mixed-precision weights: one storage format per matrix
+ *
+ * See llmk_mixq.h. Unity-included by soma_inference.c and
+ * engine/host/llmk_host_rt.c after llmk_kernels.c: F32 tensors go through
+ * matmul (djiblas) and Q8_0 through matmul_q8_0, exactly as the uniform
+ * paths do; F16 and Q4_0 have their own scalar / AVX2 kernels below.
+ */
+
+#include "llmk_mixq.h"
+
+static const char *const k_mx_fmt_names[LLMK_MX_N_FMT] = { "f32", "f16", "q8_0", "q4_0" };
+
+const char *llmk_mx_fmt_name(uint32_t fmt) {
+    return fmt < LLMK_MX_N_FMT ? k_mx_fmt_names[fmt] : "?";
+}
+
+uint64_t llmk_mx_row_bytes(uint32_t fmt, uint32_t cols) {
+    if (cols == 0) return 0;
+    switch (fmt) {
+    case LLMK_MX_F32: return (uint64_t)cols * 4u;
+    case LLMK_MX_F16: return (uint64_t)cols * 2u;
+    case LLMK_MX_Q8_0: return (cols % 32u) ? 0 : (uint64_t)(cols / 32u) * 34u;
+    case LLMK_MX_Q4_0: return (cols % 32u) ? 0 : (uint64_t)(cols / 32u) * 18u;
+    default: return 0;
+    }
+}
+
+int llmk_mx_init(LlmkMixq *mx, uint32_t dim, uint32_t hidden_dim, uint32_t n_layers, uint32_t n_heads,
+                 uint32_t n_kv_heads, uint32_t vocab, uint32_t shared_cls) {
+    uint8_t *p = (uint8_t *)mx;
+    for (uint64_t i = 0; i < sizeof(*mx); i++) p[i] = 0;
+    if (dim == 0 || hidden_dim == 0 || n_layers == 0 || n_layers > LLMK_MX_MAX_LAYERS || n_heads == 0 ||
+        n_kv_heads == 0 || vocab == 0 || (dim % n_heads) != 0 || (n_heads % n_kv_heads) != 0 ||
+        dim > (1u << 16) || hidden_dim > (1u << 18) || vocab > (1u << 24)) {
+        return LLMK_MX_ERR_SHAPE;
+    }
+    mx->dim = dim;
+    mx->hidden_dim = hidden_dim;
+    mx->n_layers = n_layers;
+    mx->n_heads = n_heads;
+    mx->n_kv_heads = n_kv_heads;
+    mx->vocab = vocab;
+    mx->n_tensors = n_layers * LLMK_MX_ROLES + 2u;
+    mx->shared_cls = shared_cls ? 1u : 0u;
+    return LLMK_MX_OK;
+}
+
+int llmk_mx_shape(const LlmkMixq *mx, uint32_t idx, uint32_t *rows, uint32_t *cols) {
+    const uint32_t kv_dim = mx->dim / mx->n_heads * mx->n_kv_heads;
+    uint32_t r, c = mx->dim;
+    if (idx >= mx->n_tensors) return 0;
+    if (idx >= mx->n_layers * LLMK_MX_ROLES) {
+        r = mx->vocab;
+    } else {
+        switch (idx % LLMK_MX_ROLES) {
+        case LLMK_MX_WK:
+        case LLMK_MX_WV: r = kv_dim; break;
+        case LLMK_MX_W1:
+        case LLMK_MX_W3: r = mx->hidden_dim; break;
+        case LLMK_MX_W2: r = mx->dim; c = mx->hidden_dim; break;
+        default: r = mx->dim; break;
+        }
+    }
+    *rows = r;
+    *cols = c;
+    return 1;
+}
+
+int llmk_mx_parse(LlmkMixq *mx, const void *buf, uint64_t len) {
+    uint8_t *p = (uint8_t *)mx;
+    for (uint64_t i = 0; i < sizeof(*mx); i++) p[i] = 0;
+    if (!buf || len < sizeof(LlmkMxHeader) || ((uintptr_t)buf & 3u)) return LLMK_MX_ERR_FORMAT;
+
+    const LlmkMxHeader *h = (const LlmkMxHeader *)buf;
+    if (h->magic != LLMK_MX_MAGIC || h->version != LLMK_MX_VERSION) return LLMK_MX_ERR_FORMAT;
+    if (llmk_mx_init(mx, h->dim, h->hidden_dim, h->n_layers, h->n_heads, h->n_kv_heads, h->vocab,
+                     h->shared_cls) != LLMK_MX_OK || h->n_tensors != mx->n_tensors) {
+        llmk_mx_init(mx, 0, 0, 0, 0, 0, 0, 0);
+        return LLMK_MX_ERR_SHAPE;
+    }
+    const uint64_t data_start = sizeof(LlmkMxHeader) + (uint64_t)h->n_tensors * sizeof(LlmkMxEntry);
+    if (len < data_start) {
+        llmk_mx_init(mx, 0, 0, 0, 0, 0, 0, 0);
+        return LLMK_MX_ERR_FORMAT;
+    }
+
+    const LlmkMxEntry *e = (const LlmkMxEntry *)((const uint8_t *)buf + sizeof(LlmkMxHeader));
+    int rc = LLMK_MX_OK;
+    for (uint32_t i = 0; i < h->n_tensors && rc == LLMK_MX_OK; i++) {
+        uint32_t rows = 0, cols = 0;
+        llmk_mx_shape(mx, i, &rows, &cols);
+        const uint64_t rb = llmk_mx_row_bytes(e[i].fmt, e[i].cols);
+        if (e[i].rows != rows || e[i].cols != cols || rb == 0) {
+            rc = LLMK_MX_ERR_SHAPE;
+        } else if (e[i].bytes != (uint64_t)rows * rb || (e[i].offset % LLMK_MX_ALIGN) != 0 ||
+                   e[i].offset < data_start || e[i].offset > len || e[i].bytes > len - e[i].offset) {
+            rc = LLMK_MX_ERR_FORMAT;
+        } else {
+            LlmkMxTensor *t = &mx->t[i];
+            t->data = (const uint8_t *)buf + e[i].offset;
+            t->row_bytes = rb;
+            t->fmt = e[i].fmt;
+            t->rows = rows;
+            t->cols = cols;
+        }
+    }
+    const uint32_t tok = h->n_layers * LLMK_MX_ROLES;
+    if (rc == LLMK_MX_OK && mx->shared_cls &&
+        (e[tok].offset != e[tok + 1].offset || e[tok].fmt != e[tok + 1].fmt)) {
+        rc = LLMK_MX_ERR_FORMAT;
+    }
+    if (rc != LLMK_MX_OK) llmk_mx_init(mx, 0, 0, 0, 0, 0, 0, 0);
+    return rc;
+}
+
+uint64_t llmk_mx_bytes(const LlmkMixq *mx) {
+    uint64_t total = 0;
+    const uint32_t n = mx->shared_cls ? mx->n_tensors - 1u : mx->n_tensors;
+    for (uint32_t i = 0; i < n; i++) total += (uint64_t)mx->t[i].rows * mx->t[i].row_bytes;
+    return total;
+}
+
+uint64_t llmk_mx_bytes_uniform(const LlmkMixq *mx, uint32_t fmt) {
+    uint64_t total = 0;
+    const uint32_t n = mx->shared_cls ? mx->n_tensors - 1u : mx->n_tensors;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t rows = 0, cols = 0;
+        llmk_mx_shape(mx, i, &rows, &cols);
+        total += (uint64_t)rows * llmk_mx_row_bytes(fmt, cols);
+    }
+    return total;
+}
+
+// ============================================================================
+// KERNELS (need llmk_kernels.c)
+// ============================================================================
+
+// IEEE half -> float for finite halves: shifting the 15 magnitude bits into
+// place and multiplying by 2^112 rebiases the exponent, subnormals included
+static inline float llmk_mx_h2f(uint16_t h) {
+    union { uint32_t u; float f; } v, m;
+    v.u = (uint32_t)(h & 0x7FFFu) << 13;
+    m.u = 0x77800000u;
+    v.f *= m.f;
+    v.u |= (uint32_t)(h & 0x8000u) << 16;
+    return v.f;
+}
+
+static void llmk_mx_matmul_f16_scalar(float *out, const float *x, const uint8_t *w, uint32_t n, uint32_t d) {
+    for (uint32_t r = 0; r < d; r++) {
+        const uint16_t *row = (const uint16_t *)(w + (uint64_t)r * n * 2u);
+        float acc = 0.0f;
+        for (uint32_t i = 0; i < n; i++) acc += llmk_mx_h2f(row[i]) * x[i];
+        out[r] = acc;
+    }
+}
+
+static void llmk_mx_matmul_q4_0_scalar(float *out, const float *x, const uint8_t *w, uint32_t n, uint32_t d) {
+    const uint64_t row_bytes = llmk_mx_row_bytes(LLMK_MX_Q4_0, n);
+    const uint32_t nb = n / 32u;
+    for (uint32_t r = 0; r < d; r++) {
+        const uint8_t *p = w + (uint64_t)r * row_bytes;
+        float acc = 0.0f;
+        for (uint32_t b = 0; b < nb; b++) {
+            const float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const uint8_t *qs = p + 2;
+            const float *xblk = x + b * 32u;
+            float sum = 0.0f;
+            for (int j = 0; j < 16; j++) {
+                sum += xblk[j] * (float)((int)(qs[j] & 0x0F) - 8) + xblk[j + 16] * (float)((int)(qs[j] >> 4) - 8);
+            }
+            acc += dscale * sum;
+            p += 18;
+        }
+        out[r] = acc;
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+__attribute__((target("avx2")))
+static float llmk_mx_hsum_avx2(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 3, 0, 1)));
+    s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(s);
+}
+
+// Halves widened 8 at a time with the same rebias as llmk_mx_h2f
+__attribute__((target("avx2")))
+static void llmk_mx_matmul_f16_avx2(float *out, const float *x, const uint8_t *w, uint32_t n, uint32_t d) {
+    const __m256i mag = _mm256_set1_epi32(0x7FFF);
+    const __m256i sgn = _mm256_set1_epi32(0x8000);
+    const __m256 rebias = _mm256_castsi256_ps(_mm256_set1_epi32(0x77800000));
+    const uint32_t n8 = n & ~7u;
+    for (uint32_t r = 0; r < d; r++) {
+        const uint16_t *row = (const uint16_t *)(w + (uint64_t)r * n * 2u);
+        __m256 vacc = _mm256_setzero_ps();
+        uint32_t i = 0;
+        for (; i < n8; i += 8) {
+            __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(row + i)));
+            __m256 f = _mm256_mul_ps(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, mag), 13)), rebias);
+            f = _mm256_or_ps(f, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, sgn), 16)));
+            vacc = _mm256_add_ps(vacc, _mm256_mul_ps(f, _mm256_loadu_ps(x + i)));
+        }
+        float acc = llmk_mx_hsum_avx2(vacc);
+        for (; i < n; i++) acc += llmk_mx_h2f(row[i]) * x[i];
+        out[r] = acc;
+    }
+}
+
+// Nibbles unpacked to int8 (low half = elements 0..15, high = 16..31), then
+// widened 8 at a time like matmul_q8_0_avx2
+__attribute__((target("avx2")))
+static void llmk_mx_matmul_q4_0_avx2(float *out, const float *x, const uint8_t *w, uint32_t n, uint32_t d) {
+    const uint64_t row_bytes = llmk_mx_row_bytes(LLMK_MX_Q4_0, n);
+    const uint32_t nb = n / 32u;
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+    const __m128i e8 = _mm_set1_epi8(8);
+    for (uint32_t r = 0; r < d; r++) {
+        const uint8_t *p = w + (uint64_t)r * row_bytes;
+        float acc = 0.0f;
+        for (uint32_t b = 0; b < nb; b++) {
+            const float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            const float *xblk = x + b * 32u;
+            __m128i raw = _mm_loadu_si128((const __m128i *)(p + 2));
+            __m128i lo = _mm_sub_epi8(_mm_and_si128(raw, m4), e8);
+            __m128i hi = _mm_sub_epi8(_mm_and_si128(_mm_srli_epi16(raw, 4), m4), e8);
+            __m256 vacc = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(lo)), _mm256_loadu_ps(xblk));
+            vacc = _mm256_add_ps(vacc, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(lo, 8))),
+                                                     _mm256_loadu_ps(xblk + 8)));
+            vacc = _mm256_add_ps(vacc, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(hi)),
+                                                     _mm256_loadu_ps(xblk + 16)));
+            vacc = _mm256_add_ps(vacc, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(hi, 8))),
+                                                     _mm256_loadu_ps(xblk + 24)));
+            acc += dscale * llmk_mx_hsum_avx2(vacc);
+            p += 18;
+        }
+        out[r] = acc;
+    }
+}
+#endif
+
+// out[0..nr) = rows [r0, r0 + nr) of t times x (t->cols floats), through the
+// kernel of t's format
+static void llmk_mx_matmul(float *out, const float *x, const LlmkMxTensor *t, uint32_t r0, uint32_t nr) {
+    const uint8_t *w = t->data + (uint64_t)r0 * t->row_bytes;
+    switch (t->fmt) {
+    case LLMK_MX_F32:
+        // djiblas reads W in whole groups of 4 rows: a ragged tail reruns
+        // the last 4 rows (same values) instead of reading past the tensor
+        if (nr < 4) {
+            for (uint32_t i = 0; i < nr; i++) {
+                out[i] = dot_f32_best(x, (const float *)w + (uint64_t)i * t->cols, (int)t->cols);
+            }
+            return;
+        }
+        matmul(out, (float *)x, (float *)w, (int)t->cols, (int)(nr & ~3u));
+        if (nr & 3u) {
+            matmul(out + nr - 4, (float *)x, (float *)w + (uint64_t)(nr - 4) * t->cols, (int)t->cols, 4);
+        }
+        return;
+    case LLMK_MX_Q8_0:
+        matmul_q8_0(out, x, w, (int)t->cols, (int)nr);
+        return;
+    case LLMK_MX_F16:
+#if defined(__x86_64__) || defined(_M_X64)
+        if (llmk_has_avx2_cached()) {
+            llmk_mx_matmul_f16_avx2(out, x, w, t->cols, nr);
+            return;
+        }
+#endif
+        llmk_mx_matmul_f16_scalar(out, x, w, t->cols, nr);
+        return;
+    case LLMK_MX_Q4_0:
+#if defined(__x86_64__) || defined(_M_X64)
+        if (llmk_has_avx2_cached()) {
+            llmk_mx_matmul_q4_0_avx2(out, x, w, t->cols, nr);
+            return;
+        }
+#endif
+        llmk_mx_matmul_q4_0_scalar(out, x, w, t->cols, nr);
+        return;
+    default:
+        for (uint32_t i = 0; i < nr; i++) out[i] = 0.0f;
+        return;
+    }
+}
+
+// Row r of t as floats (embedding lookup)
+static void llmk_mx_row(float *dst, const LlmkMxTensor *t, uint32_t r) {
+    const uint8_t *p = t->data + (uint64_t)r * t->row_bytes;
+    switch (t->fmt) {
+    case LLMK_MX_F32: {
+        const float *src = (const float *)p;
+        for (uint32_t i = 0; i < t->cols; i++) dst[i] = src[i];
+        return;
+    }
+    case LLMK_MX_F16: {
+        const uint16_t *src = (const uint16_t *)p;
+        for (uint32_t i = 0; i < t->cols; i++) dst[i] = llmk_mx_h2f(src[i]);
+        return;
+    }
+    case LLMK_MX_Q8_0:
+        llmk_dequantize_q8_0_row(dst, p, (int)t->cols);
+        return;
+    case LLMK_MX_Q4_0:
+        for (uint32_t b = 0; b < t->cols / 32u; b++, p += 18) {
+            const float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
+            for (int j = 0; j < 16; j++) {
+                dst[b * 32u + j] = dscale * (float)((int)(p[2 + j] & 0x0F) - 8);
+                dst[b * 32u + j + 16] = dscale * (float)((int)(p[2 + j] >> 4) - 8);
+            }
+        }
+        return;
+    default:
+        for (uint32_t i = 0; i < t->cols; i++) dst[i] = 0.0f;
+        return;
+    }
+}
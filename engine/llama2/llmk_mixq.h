@@ -0,0 +1,120 @@
+/* llmk_mixq.h — Mixed-precision weights: one storage format per matrix
+ *
+ * The llama2 path streams every matrix in a single format (f32 or Q8_0),
+ * yet the error a format adds differs a lot from one matrix to the next
+ * (wv and w2 of the first layers usually suffer most, w1/w3 of the middle
+ * ones least). A mixed image (.lkmx, planned offline from a calibration
+ * text by engine/host --mixq-plan) stores each matrix in its own format:
+ *
+ *   F32    4 bytes / weight
+ *   F16    IEEE half, 2 bytes / weight (finite values only)
+ *   Q8_0   GGML blocks of 32: fp16 d + 32 int8             34 bytes / 32
+ *   Q4_0   GGML blocks of 32: fp16 d + 16 bytes of nibbles 18 bytes / 32
+ *          (element j = (qs[j] & 15) - 8, element j+16 = (qs[j] >> 4) - 8)
+ *
+ * Tensors are numbered l·7 + role (wq wk wv wo w1 w2 w3) for the layers,
+ * then the token embedding (7L) and the classifier (7L+1; the same entry
+ * as the embedding when the model shares them). Norms, biases and RoPE
+ * stay with the base model: TransformerWeights.mx only re-routes the
+ * matrix products, so the base weights' kind is left untouched.
+ *
+ * File layout (little-endian):
+ *   LlmkMxHeader | LlmkMxEntry[n_tensors] | tensor data (each 64-byte aligned)
+ *
+ * Freestanding C11 — no libc, no malloc. The file buffer is caller-owned
+ * and must outlive the LlmkMixq. The kernels (llmk_mx_matmul, llmk_mx_row)
+ * build on llmk_kernels.c and exist only where llmk_mixq.c is
+ * unity-included after it.
+ */
+#pragma once
+#ifndef LLMK_MIXQ_H
+#define LLMK_MIXQ_H
+
+#include <stdint.h>
+
+#define LLMK_MX_MAGIC       0x584D4B4Cu   /* "LKMX" */
+#define LLMK_MX_VERSION     1u
+#define LLMK_MX_ALIGN       64u
+#define LLMK_MX_ROLES       7u
+#define LLMK_MX_MAX_LAYERS  128u
+#define LLMK_MX_MAX_TENSORS (LLMK_MX_MAX_LAYERS * LLMK_MX_ROLES + 2u)
+
+/* Formats */
+#define LLMK_MX_F32   0u
+#define LLMK_MX_F16   1u
+#define LLMK_MX_Q8_0  2u
+#define LLMK_MX_Q4_0  3u
+#define LLMK_MX_N_FMT 4u
+
+/* Roles within a layer */
+#define LLMK_MX_WQ 0u
+#define LLMK_MX_WK 1u
+#define LLMK_MX_WV 2u
+#define LLMK_MX_WO 3u
+#define LLMK_MX_W1 4u
+#define LLMK_MX_W2 5u
+#define LLMK_MX_W3 6u
+
+#define LLMK_MX_OK          0
+#define LLMK_MX_ERR_FORMAT  -1
+#define LLMK_MX_ERR_SHAPE   -2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dim;
+    uint32_t hidden_dim;
+    uint32_t n_layers;
+    uint32_t n_heads;
+    uint32_t n_kv_heads;
+    uint32_t vocab;
+    uint32_t n_tensors;                 /* 7·n_layers + 2 */
+    uint32_t shared_cls;                /* classifier entry == embedding entry */
+    uint32_t reserved[6];
+} LlmkMxHeader;                         /* 64 bytes */
+
+typedef struct {
+    uint32_t fmt;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t reserved;
+    uint64_t offset;                    /* from the start of the file, 64-byte aligned */
+    uint64_t bytes;                     /* rows · llmk_mx_row_bytes(fmt, cols) */
+} LlmkMxEntry;                          /* 32 bytes */
+
+typedef struct {
+    const uint8_t *data;                /* rows × row_bytes */
+    uint64_t       row_bytes;
+    uint32_t       fmt, rows, cols;
+} LlmkMxTensor;
+
+typedef struct LlmkMixq {
+    uint32_t dim, hidden_dim, n_layers, n_heads, n_kv_heads, vocab;
+    uint32_t n_tensors;
+    uint32_t shared_cls;
+    LlmkMxTensor t[LLMK_MX_MAX_TENSORS];
+} LlmkMixq;
+
+/* Bytes of one row, 0 when fmt is unknown or cols does not fit it
+ * (quantized formats need cols % 32 == 0) */
+uint64_t llmk_mx_row_bytes(uint32_t fmt, uint32_t cols);
+
+/* Zeroes mx and records the model dimensions (tensor data left NULL).
+ * Returns LLMK_MX_ERR_SHAPE when they are out of range. */
+int      llmk_mx_init(LlmkMixq *mx, uint32_t dim, uint32_t hidden_dim, uint32_t n_layers, uint32_t n_heads,
+                      uint32_t n_kv_heads, uint32_t vocab, uint32_t shared_cls);
+
+/* rows × cols tensor idx must have for mx's dimensions; 0 when idx is out of range */
+int      llmk_mx_shape(const LlmkMixq *mx, uint32_t idx, uint32_t *rows, uint32_t *cols);
+
+/* Validate and map a .lkmx buffer (zero-copy) */
+int      llmk_mx_parse(LlmkMixq *mx, const void *buf, uint64_t len);
+
+/* Matrix bytes of the plan (a shared classifier counted once) and the same
+ * model stored all in fmt */
+uint64_t llmk_mx_bytes(const LlmkMixq *mx);
+uint64_t llmk_mx_bytes_uniform(const LlmkMixq *mx, uint32_t fmt);
+
+const char *llmk_mx_fmt_name(uint32_t fmt);
+
+#endif /* LLMK_MIXQ_H */
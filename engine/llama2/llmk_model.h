@@ -0,0 +1,112 @@
+// llmk_model.h — llama2 model / runtime state layout shared with the host CLI
+//
+// Config is the 7-int header of a llama2.c .bin. TransformerWeights points
+// either into the float32 weight image (kind 0) or into a Q8_0 blob built
+// from GGUF (kind 1); the optional QKV biases sit in a separate buffer.
+// A mixed-precision plan (llmk_mixq.h) overrides the matrices of either
+// kind through mx and leaves the rest in place.
+// Unity-included; see llmk_kernels.c.
+
+#pragma once
+
+typedef struct {
+    int dim;
+    int hidden_dim;
+    int n_layers;
+    int n_heads;
+    int n_kv_heads;
+    int vocab_size;
+    int seq_len;
+} Config;
+
+typedef struct {
+    int kind; // 0 = float32, 1 = Q8_0 blob
+
+    // float32 pointers (always valid for norms; valid for matrices in float32 mode)
+    float* token_embedding_table;
+    float* rms_att_weight;
+    float* wq;
+    float* wk;
+    float* wv;
+    float* wo;
+    float* rms_ffn_weight;
+    float* w1;
+    float* w2;
+    float* w3;
+    float* rms_final_weight;
+    float* wcls;
+
+    // QKV biases [n_layers][dim | kv_dim] (qwen2), NULL when the architecture has none
+    float* bq;
+    float* bk;
+    float* bv;
+
+    // Q8_0 pointers (valid in Q8_0 blob mode)
+    const UINT8 *token_embedding_table_q8;
+    const UINT8 *wq_q8;
+    const UINT8 *wk_q8;
+    const UINT8 *wv_q8;
+    const UINT8 *wo_q8;
+    const UINT8 *w1_q8;
+    const UINT8 *w2_q8;
+    const UINT8 *w3_q8;
+    const UINT8 *wcls_q8;
+
+    // Strides/sizes for Q8_0 blob addressing
+    UINT64 tok_embd_row_bytes;
+    UINT64 wq_layer_bytes;
+    UINT64 wk_layer_bytes;
+    UINT64 wv_layer_bytes;
+    UINT64 wo_layer_bytes;
+    UINT64 w1_layer_bytes;
+    UINT64 w2_layer_bytes;
+    UINT64 w3_layer_bytes;
+
+    // Per-matrix formats (llmk_mixq.h); NULL = the matrices of `kind` above
+    const struct LlmkMixq *mx;
+} TransformerWeights;
+
+typedef struct {
+    float* x;
+    float* xb;
+    float* xb2;
+    float* hb;
+    float* hb2;
+    float* q;
+    float* k;
+    float* v;
+    float* att;
+    float* logits;
+    float* key_cache;
+    float* value_cache;
+    // Per-generation scratch (llmk_gen.c): int8 activations for the Q8_0
+    // paths, NULL = the shared llmk_q8_act_ensure buffers; cls_full keeps
+    // the classifier off the shared shortlist scratch
+    INT8* q8_qs;
+    float* q8_scales;
+    int cls_full;
+} RunState;
+
+// Activations of up to cap positions going through transformer_forward_batch
+// together; row-major per position. Attention scores and the KV cache stay
+// in RunState.
+typedef struct {
+    int cap;
+    float* x;       // [rows][dim], rows = cap rounded up to 4
+    float* xb;
+    float* xb2;
+    float* q;
+    float* k;       // [rows][kv_dim]
+    float* v;
+    float* hb;      // [rows][hidden_dim]
+    float* hb2;
+    float* logits;  // [cap][vocab_size]
+} RunBatch;
+
+typedef struct {
+    char** vocab;
+    float* vocab_scores;
+    int vocab_size;
+    int max_token_length;
+    const struct LlmkVocab* gguf; // GGUF-embedded vocabulary (llmk_vocab.h); NULL = tokenizer.bin
+} Tokenizer;
@@ -0,0 +1,304 @@
+/* llmk_repeat.c — Incremental repetition control
+ *
+ * See llmk_repeat.h. Unity-included by soma_inference.c and the host
+ * runtime, next to llmk_sampler.c.
+ */
+
+#include "llmk_repeat.h"
+
+#define RP_BASE 0x9E3779B97F4A7C15ULL   /* odd: the polynomial hash stays invertible */
+
+static uint64_t rp_align(uint64_t n) {
+    return (n + 63u) & ~(uint64_t)63u;
+}
+
+static uint32_t rp_table_size(int max_grams) {
+    uint32_t s = 16;
+    while (s < (uint32_t)max_grams * 2u) s <<= 1;
+    return s;
+}
+
+uint64_t llmk_rep_bytes(int vocab, int max_grams) {
+    if (vocab <= 0 || max_grams <= 0) return 0;
+    const uint64_t t = rp_table_size(max_grams);
+    const uint64_t g = (uint64_t)max_grams;
+    const uint64_t v = (uint64_t)vocab;
+    return rp_align(t * 8) + rp_align(t * 4) + 3 * rp_align(g * 4) + 3 * rp_align(v * 4);
+}
+
+/* ── Hashing ─────────────────────────────────────────────────────────────── */
+
+static uint64_t rp_sym(int tok) {
+    return (uint64_t)(uint32_t)tok + 1u;
+}
+
+/* Polynomial hash of hist[at .. at+len) */
+static uint64_t rp_hash(const int *hist, int at, int len) {
+    uint64_t h = 0;
+    for (int i = 0; i < len; i++) h = h * RP_BASE + rp_sym(hist[at + i]);
+    return h;
+}
+
+/* Table key: the hash through a bijective mixer (slot bits from all input
+ * bits), 0 reserved for empty slots */
+static uint64_t rp_key(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h ? h : 1;
+}
+
+/* ── Prefix table ────────────────────────────────────────────────────────── */
+
+static int rp_find(const LlmkRepeat *r, uint64_t key) {
+    uint32_t i = (uint32_t)key & r->mask;
+    while (r->key[i]) {
+        if (r->key[i] == key) return (int)i;
+        i = (i + 1) & r->mask;
+    }
+    return -1;
+}
+
+static int rp_find_or_add(LlmkRepeat *r, uint64_t key) {
+    uint32_t i = (uint32_t)key & r->mask;
+    while (r->key[i]) {
+        if (r->key[i] == key) return (int)i;
+        i = (i + 1) & r->mask;
+    }
+    r->key[i] = key;
+    r->head[i] = -1;
+    return (int)i;
+}
+
+/* Backward-shift delete: later entries of the probe run move into the hole
+ * unless their home slot lies cyclically in (hole, j]. */
+static void rp_remove_slot(LlmkRepeat *r, uint32_t hole) {
+    uint32_t j = hole;
+    for (;;) {
+        j = (j + 1) & r->mask;
+        if (!r->key[j]) break;
+        const uint32_t home = (uint32_t)r->key[j] & r->mask;
+        const int stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (stays) continue;
+        r->key[hole] = r->key[j];
+        r->head[hole] = r->head[j];
+        hole = j;
+    }
+    r->key[hole] = 0;
+    r->head[hole] = -1;
+}
+
+static void rp_gram_add(LlmkRepeat *r, uint64_t prefix, int tok) {
+    const int s = rp_find_or_add(r, rp_key(prefix));
+    for (int32_t k = r->head[s]; k >= 0; k = r->node_next[k]) {
+        if (r->node_tok[k] == tok) {
+            r->node_cnt[k]++;
+            return;
+        }
+    }
+    const int32_t k = r->free_node;
+    if (k < 0) {
+        r->dropped++;
+        if (r->head[s] < 0) rp_remove_slot(r, (uint32_t)s);
+        return;
+    }
+    r->free_node = r->node_next[k];
+    r->node_tok[k] = tok;
+    r->node_cnt[k] = 1;
+    r->node_next[k] = r->head[s];
+    r->head[s] = k;
+}
+
+static void rp_gram_sub(LlmkRepeat *r, uint64_t prefix, int tok) {
+    const int s = rp_find(r, rp_key(prefix));
+    if (s < 0) return;
+    int32_t prev = -1;
+    for (int32_t k = r->head[s]; k >= 0; prev = k, k = r->node_next[k]) {
+        if (r->node_tok[k] != tok) continue;
+        if (--r->node_cnt[k] == 0) {
+            if (prev < 0) r->head[s] = r->node_next[k];
+            else r->node_next[prev] = r->node_next[k];
+            r->node_next[k] = r->free_node;
+            r->free_node = k;
+            if (r->head[s] < 0) rp_remove_slot(r, (uint32_t)s);
+        }
+        return;
+    }
+}
+
+/* ── Token counts ────────────────────────────────────────────────────────── */
+
+static void rp_count_add(LlmkRepeat *r, int tok) {
+    if (tok < 0 || tok >= r->vocab) return;
+    if (r->count[tok]++ == 0) {
+        r->seen_at[tok] = r->n_seen;
+        r->seen[r->n_seen++] = tok;
+    }
+}
+
+static void rp_count_sub(LlmkRepeat *r, int tok) {
+    if (tok < 0 || tok >= r->vocab || r->count[tok] == 0) return;
+    if (--r->count[tok] == 0) {
+        const int at = r->seen_at[tok];
+        const int last = r->seen[--r->n_seen];
+        r->seen[at] = last;
+        r->seen_at[last] = at;
+        r->seen_at[tok] = -1;
+    }
+}
+
+/* ── Index ───────────────────────────────────────────────────────────────── */
+
+static int rp_gram_window(const LlmkRepeat *r) {
+    return (r->ngram_window > 0 && r->ngram_window < r->max_grams) ? r->ngram_window : r->max_grams;
+}
+
+static void rp_set(LlmkRepeat *r, int ngram, int ngram_window, int pen_window) {
+    if (ngram > LLMK_REP_MAX_NGRAM) ngram = LLMK_REP_MAX_NGRAM;
+    r->ngram = (ngram >= 2) ? ngram : 0;
+    r->ngram_window = (ngram_window > 0) ? ngram_window : 0;
+    r->pen_window = (pen_window > 0) ? pen_window : 0;
+    r->pow = 1;
+    for (int i = 0; i + 2 < r->ngram; i++) r->pow *= RP_BASE;
+}
+
+int llmk_rep_init(LlmkRepeat *r, void *mem, uint64_t bytes, int vocab, int max_grams,
+                  int ngram, int ngram_window, int pen_window) {
+    if (!r || !mem || vocab <= 0 || max_grams <= 0) return LLMK_REP_ERR_PARAM;
+    if (bytes < llmk_rep_bytes(vocab, max_grams)) return LLMK_REP_ERR_MEM;
+    const uint32_t t = rp_table_size(max_grams);
+    uint8_t *p = (uint8_t *)mem;
+
+    r->vocab = vocab;
+    r->max_grams = max_grams;
+    r->key = (uint64_t *)p;        p += rp_align((uint64_t)t * 8);
+    r->head = (int32_t *)p;        p += rp_align((uint64_t)t * 4);
+    r->mask = t - 1;
+    r->node_tok = (int32_t *)p;    p += rp_align((uint64_t)max_grams * 4);
+    r->node_next = (int32_t *)p;   p += rp_align((uint64_t)max_grams * 4);
+    r->node_cnt = (uint32_t *)p;   p += rp_align((uint64_t)max_grams * 4);
+    r->count = (uint32_t *)p;      p += rp_align((uint64_t)vocab * 4);
+    r->seen = (int32_t *)p;        p += rp_align((uint64_t)vocab * 4);
+    r->seen_at = (int32_t *)p;
+
+    for (uint32_t i = 0; i < t; i++) {
+        r->key[i] = 0;
+        r->head[i] = -1;
+    }
+    for (int i = 0; i < vocab; i++) {
+        r->count[i] = 0;
+        r->seen_at[i] = -1;
+    }
+    r->n_seen = 0;
+    r->pushed = r->popped = r->dropped = 0;
+    rp_set(r, ngram, ngram_window, pen_window);
+    r->n = 0;
+    r->tail = 0;
+    llmk_rep_reset(r);
+    return LLMK_REP_OK;
+}
+
+void llmk_rep_reset(LlmkRepeat *r) {
+    /* Occupied slots and counted ids only: a turn's reset stays cheap */
+    for (uint32_t i = 0; i <= r->mask; i++) {
+        if (!r->key[i]) continue;
+        r->key[i] = 0;
+        r->head[i] = -1;
+    }
+    for (int i = 0; i < r->max_grams; i++) r->node_next[i] = (i + 1 < r->max_grams) ? i + 1 : -1;
+    r->free_node = 0;
+    for (int i = 0; i < r->n_seen; i++) {
+        r->count[r->seen[i]] = 0;
+        r->seen_at[r->seen[i]] = -1;
+    }
+    r->n_seen = 0;
+    r->n = 0;
+    r->tail = 0;
+}
+
+void llmk_rep_configure(LlmkRepeat *r, const int *hist, int ngram, int ngram_window, int pen_window) {
+    const int n = r->n;
+    llmk_rep_reset(r);
+    rp_set(r, ngram, ngram_window, pen_window);
+    llmk_rep_sync(r, hist, n);
+}
+
+/* hist[e] becomes the newest token */
+static void rp_push(LlmkRepeat *r, const int *hist, int e) {
+    rp_count_add(r, hist[e]);
+    if (r->pen_window > 0 && e - r->pen_window >= 0) rp_count_sub(r, hist[e - r->pen_window]);
+
+    const int L = r->ngram - 1;
+    if (L > 0) {
+        const int W = rp_gram_window(r);
+        if (e >= L) rp_gram_add(r, r->tail, hist[e]);
+        if (e - W >= L) rp_gram_sub(r, rp_hash(hist, e - W - L, L), hist[e - W]);
+        if (e >= L) {
+            r->tail = (r->tail - rp_sym(hist[e - L]) * r->pow) * RP_BASE + rp_sym(hist[e]);
+        } else if (e + 1 == L) {
+            r->tail = rp_hash(hist, 0, L);
+        }
+    }
+    r->pushed++;
+}
+
+/* hist[e] (the newest token) is dropped */
+static void rp_pop(LlmkRepeat *r, const int *hist, int e) {
+    rp_count_sub(r, hist[e]);
+    if (r->pen_window > 0 && e - r->pen_window >= 0) rp_count_add(r, hist[e - r->pen_window]);
+
+    const int L = r->ngram - 1;
+    if (L > 0) {
+        const int W = rp_gram_window(r);
+        if (e >= L) rp_gram_sub(r, rp_hash(hist, e - L, L), hist[e]);
+        if (e - W >= L) rp_gram_add(r, rp_hash(hist, e - W - L, L), hist[e - W]);
+    }
+    r->popped++;
+}
+
+void llmk_rep_sync(LlmkRepeat *r, const int *hist, int n) {
+    if (n < 0) n = 0;
+    if (n < r->n) {
+        while (r->n > n) rp_pop(r, hist, --r->n);
+        const int L = r->ngram - 1;
+        r->tail = (L > 0 && n >= L) ? rp_hash(hist, n - L, L) : 0;
+        return;
+    }
+    while (r->n < n) rp_push(r, hist, r->n++);
+}
+
+int llmk_rep_ban(const LlmkRepeat *r, float *logits) {
+    const int L = r->ngram - 1;
+    if (L <= 0 || r->n < L) return 0;
+    const int s = rp_find(r, rp_key(r->tail));
+    if (s < 0) return 0;
+    int banned = 0;
+    for (int32_t k = r->head[s]; k >= 0; k = r->node_next[k]) {
+        const int tok = r->node_tok[k];
+        if (tok >= 0 && tok < r->vocab) {
+            logits[tok] = LLMK_REP_BANNED;
+            banned++;
+        }
+    }
+    return banned;
+}
+
+void llmk_rep_penalize(const LlmkRepeat *r, float *logits, float repeat, float frequency, float presence) {
+    const int rep = (repeat != 1.0f);
+    if (!rep && frequency == 0.0f && presence == 0.0f) return;
+    for (int i = 0; i < r->n_seen; i++) {
+        const int tok = r->seen[i];
+        const uint32_t c = r->count[tok];
+        float v = logits[tok];
+        if (rep) {
+            for (uint32_t k = 0; k < c; k++) v = (v > 0) ? v / repeat : v * repeat;
+        }
+        logits[tok] = v - (float)c * frequency - presence;
+    }
+}
+
+uint32_t llmk_rep_count(const LlmkRepeat *r, int id) {
+    return (id >= 0 && id < r->vocab) ? r->count[id] : 0;
+}
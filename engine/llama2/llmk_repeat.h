@@ -0,0 +1,107 @@
+/* llmk_repeat.h — Incremental repetition control (no-repeat n-grams, penalties)
+ *
+ * apply_no_repeat_ngram() and the repeat penalty in sample_advanced() scan
+ * the token history on every decode step, so their cost grows with the
+ * conversation. This index is updated as tokens are appended instead:
+ *
+ *   n-gram table   (n-1)-token prefix → set of tokens that followed it.
+ *                  The prefix of the history tail is kept as a rolling
+ *                  polynomial hash; the table is open addressing on that
+ *                  hash, each slot heading a list of continuations with an
+ *                  occurrence count. Banning = one probe + the list.
+ *   token counts   occurrences per token id over the last pen_window
+ *                  tokens, plus the list of ids with a non-zero count, so
+ *                  repeat / frequency / presence penalties touch only the
+ *                  tokens that actually occur.
+ *
+ * Appending a token costs O(n) for the two windows' entries and exits,
+ * independent of history length. The caller keeps the history array; the
+ * index only remembers how much of it it has seen. llmk_rep_sync() moves to
+ * a new length in either direction, so dropping tokens (a rejected draft, a
+ * truncated KV cache) rolls the counts and the table back exactly, and
+ * tokens that fall out of a window come back when the history shrinks.
+ *
+ * Prefixes are identified by their 64-bit hash; a collision (odds ~2^-64
+ * per pair of prefixes) would ban a token the scan would not.
+ *
+ * Freestanding C11 — no libc, no malloc. Tables live in a caller-owned
+ * arena sized by llmk_rep_bytes().
+ */
+#pragma once
+#ifndef LLMK_REPEAT_H
+#define LLMK_REPEAT_H
+
+#include <stdint.h>
+
+#define LLMK_REP_MAX_NGRAM   16
+#define LLMK_REP_BANNED      (-1.0e9f)   /* same floor as apply_no_repeat_ngram */
+
+#define LLMK_REP_OK          0
+#define LLMK_REP_ERR_PARAM   -1
+#define LLMK_REP_ERR_MEM     -2
+
+typedef struct {
+    int       vocab;
+    int       max_grams;                /* n-grams the arena can index */
+    int       ngram;                    /* no-repeat n (2..16), < 2 = no n-gram bans */
+    int       ngram_window;             /* n-grams ending in the last W tokens; 0 = max_grams */
+    int       pen_window;               /* tokens counted for penalties; 0 = all */
+    int       n;                        /* history length indexed */
+
+    uint64_t  tail;                     /* hash of the last ngram-1 tokens (valid when n >= ngram-1) */
+    uint64_t  pow;                      /* base^(ngram-2), to roll the oldest token out */
+
+    /* Prefix table: key 0 = empty slot, linear probing, backward-shift delete */
+    uint64_t *key;
+    int32_t  *head;                     /* first continuation node */
+    uint32_t  mask;
+
+    /* Continuation nodes */
+    int32_t  *node_tok;
+    int32_t  *node_next;                /* next continuation, or next free node */
+    uint32_t *node_cnt;
+    int32_t   free_node;
+
+    /* Token counts */
+    uint32_t *count;                    /* [vocab] */
+    int32_t  *seen;                     /* ids with count > 0 */
+    int32_t  *seen_at;                  /* [vocab] index into seen, -1 = absent */
+    int       n_seen;
+
+    /* Stats (cumulative) */
+    uint64_t  pushed;
+    uint64_t  popped;
+    uint64_t  dropped;                  /* n-grams not indexed (arena full) */
+} LlmkRepeat;
+
+/* Arena size for a vocabulary and up to max_grams indexed n-grams */
+uint64_t llmk_rep_bytes(int vocab, int max_grams);
+
+/* Lays out the arena and resets. ngram_window is clamped to max_grams. */
+int  llmk_rep_init(LlmkRepeat *r, void *mem, uint64_t bytes, int vocab, int max_grams,
+                   int ngram, int ngram_window, int pen_window);
+
+/* Forgets the history (settings stay). O(indexed entries). */
+void llmk_rep_reset(LlmkRepeat *r);
+
+/* Changes n / windows, re-indexing hist[0..n) under the new settings */
+void llmk_rep_configure(LlmkRepeat *r, const int *hist, int ngram, int ngram_window, int pen_window);
+
+/* Brings the index to hist[0..n): appends hist[r->n..n) or drops tokens
+ * back to n. hist[0..min(n, r->n)) must not have changed since. */
+void llmk_rep_sync(LlmkRepeat *r, const int *hist, int n);
+
+/* Sets the logits of tokens that would complete an n-gram already seen to
+ * LLMK_REP_BANNED. Returns how many tokens were banned. */
+int  llmk_rep_ban(const LlmkRepeat *r, float *logits);
+
+/* For every token counted in the window (c occurrences): the repeat penalty
+ * c times as sample_advanced applies it per recent occurrence (positive
+ * logits divided, others multiplied), then logit -= c * frequency +
+ * presence. 1 / 0 / 0 leave logits untouched. */
+void llmk_rep_penalize(const LlmkRepeat *r, float *logits, float repeat, float frequency, float presence);
+
+/* Occurrences of id in the penalty window */
+uint32_t llmk_rep_count(const LlmkRepeat *r, int id);
+
+#endif /* LLMK_REPEAT_H */
@@ -0,0 +1,289 @@
+/* llmk_rope.c — Rotary position embedding with precomputed sin/cos tables
+ *
+ * See llmk_rope.h. Unity-included by soma_inference.c (and the host
+ * runtime); also built into the trainer's backward pass.
+ */
+
+#include "llmk_rope.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* ── Freestanding double-precision math (table build only) ─────────────── */
+
+#define ROPE_LN2      0.69314718055994530942
+#define ROPE_PI       3.14159265358979323846
+#define ROPE_PIO2_HI  1.57079632673412561417e+00   /* first 33 bits of π/2 */
+#define ROPE_PIO2_LO  6.07710050650619224932e-11   /* π/2 − PIO2_HI */
+
+typedef union { double d; uint64_t u; } rope_bits;
+
+static double rope_ldexp(double x, int e) {
+    while (e > 1000) { x *= 0x1p1000; e -= 1000; }
+    while (e < -1000) { x *= 0x1p-1000; e += 1000; }
+    rope_bits b;
+    b.u = (uint64_t)(e + 1023) << 52;
+    return x * b.d;
+}
+
+static double rope_log(double x) {
+    if (x <= 0.0) return -1.0e300;
+    rope_bits b;
+    b.d = x;
+    int e = (int)((b.u >> 52) & 0x7FF) - 1023;
+    b.u = (b.u & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;   /* m in [1, 2) */
+    double m = b.d;
+    if (m > 1.41421356237309504880) { m *= 0.5; e++; }
+    double t = (m - 1.0) / (m + 1.0), t2 = t * t, term = t, s = 0.0;
+    for (int k = 1; k < 40; k += 2) {
+        s += term / (double)k;
+        term *= t2;
+    }
+    return 2.0 * s + (double)e * ROPE_LN2;
+}
+
+static double rope_exp(double x) {
+    if (x > 700.0) x = 700.0;
+    if (x < -700.0) return 0.0;
+    double kf = x / ROPE_LN2;
+    int k = (int)(kf < 0.0 ? kf - 0.5 : kf + 0.5);
+    double r = x - (double)k * ROPE_LN2, term = 1.0, s = 1.0;
+    for (int i = 1; i < 24; i++) {
+        term *= r / (double)i;
+        s += term;
+    }
+    return rope_ldexp(s, k);
+}
+
+static double rope_floor(double x) {
+    double t = (double)(int64_t)x;
+    return (t > x) ? t - 1.0 : t;
+}
+
+static void rope_sincos(double x, double *s_out, double *c_out) {
+    double kf = rope_floor(x / (0.5 * ROPE_PI) + 0.5);
+    double r = (x - kf * ROPE_PIO2_HI) - kf * ROPE_PIO2_LO;   /* |r| ≤ π/4 */
+    double r2 = r * r, s = r, c = 1.0, ts = r, tc = 1.0;
+    for (int i = 1; i < 12; i++) {
+        ts *= -r2 / (double)((2 * i) * (2 * i + 1));
+        tc *= -r2 / (double)((2 * i - 1) * (2 * i));
+        s += ts;
+        c += tc;
+    }
+    switch ((int64_t)kf & 3) {
+        case 0: *s_out = s;  *c_out = c;  break;
+        case 1: *s_out = c;  *c_out = -s; break;
+        case 2: *s_out = -s; *c_out = -c; break;
+        default: *s_out = -c; *c_out = s; break;
+    }
+}
+
+/* ── Parameters ─────────────────────────────────────────────────────────── */
+
+void llmk_rope_defaults(LlmkRopeParams *p) {
+    p->layout = LLMK_ROPE_NORM;
+    p->n_rot = 0;
+    p->freq_base = 10000.0f;
+    p->scaling = LLMK_ROPE_SCALING_NONE;
+    p->factor = 1.0f;
+    p->orig_ctx = 0;
+    p->yarn_beta_fast = 32.0f;
+    p->yarn_beta_slow = 1.0f;
+}
+
+static int rope_lower(int c) {
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+static int rope_name_eq(const char *s, int n, const char *lit) {
+    int i = 0;
+    for (; i < n && lit[i]; i++) {
+        if (rope_lower((unsigned char)s[i]) != lit[i]) return 0;
+    }
+    return i == n && lit[i] == 0;
+}
+
+int llmk_rope_scaling_from_name(const char *s, int n) {
+    if (!s) return -1;
+    if (rope_name_eq(s, n, "none")) return LLMK_ROPE_SCALING_NONE;
+    if (rope_name_eq(s, n, "linear")) return LLMK_ROPE_SCALING_LINEAR;
+    if (rope_name_eq(s, n, "ntk")) return LLMK_ROPE_SCALING_NTK;
+    if (rope_name_eq(s, n, "yarn")) return LLMK_ROPE_SCALING_YARN;
+    return -1;
+}
+
+const char *llmk_rope_scaling_name(int scaling) {
+    switch (scaling) {
+        case LLMK_ROPE_SCALING_LINEAR: return "linear";
+        case LLMK_ROPE_SCALING_NTK: return "ntk";
+        case LLMK_ROPE_SCALING_YARN: return "yarn";
+        default: return "none";
+    }
+}
+
+uint64_t llmk_rope_table_bytes(int seq_len, int n_rot) {
+    if (seq_len <= 0 || n_rot <= 0) return 0;
+    uint64_t one = (uint64_t)seq_len * (uint64_t)(n_rot / 2) * 4u;
+    return ((one + 15u) & ~(uint64_t)15u) * 2u;
+}
+
+/* YaRN: dim index where the pair completes `rot` rotations over orig_ctx */
+static double rope_yarn_corr_dim(int n_rot, int orig_ctx, double rot, double base) {
+    return (double)n_rot * rope_log((double)orig_ctx / (rot * 2.0 * ROPE_PI)) / (2.0 * rope_log(base));
+}
+
+int llmk_rope_init(LlmkRope *r, const LlmkRopeParams *p, int head_size, int seq_len,
+                   void *mem, uint64_t bytes) {
+    LlmkRopeParams q = *p;
+    r->ready = 0;
+    if (q.n_rot <= 0 || q.n_rot > head_size) q.n_rot = head_size;
+    q.n_rot &= ~1;
+    if (q.freq_base <= 0.0f) q.freq_base = 10000.0f;
+    if (q.factor < 1.0f) q.factor = 1.0f;
+    if (q.yarn_beta_fast <= 0.0f) q.yarn_beta_fast = 32.0f;
+    if (q.yarn_beta_slow <= 0.0f) q.yarn_beta_slow = 1.0f;
+    if (q.layout != LLMK_ROPE_NEOX) q.layout = LLMK_ROPE_NORM;
+    if (q.scaling < LLMK_ROPE_SCALING_NONE || q.scaling > LLMK_ROPE_SCALING_YARN || q.factor == 1.0f) {
+        q.scaling = LLMK_ROPE_SCALING_NONE;
+    }
+    if (q.orig_ctx <= 0) q.orig_ctx = (int)((float)seq_len / q.factor);
+    if (head_size <= 0 || seq_len <= 0 || q.n_rot < 2) return LLMK_ROPE_ERR_PARAM;
+
+    const uint64_t need = llmk_rope_table_bytes(seq_len, q.n_rot);
+    if (!mem || ((uintptr_t)mem & 15u) || bytes < need) return LLMK_ROPE_ERR_MEM;
+
+    const int half = q.n_rot / 2;
+    double base = (double)q.freq_base;
+    double freq_scale = 1.0, ext = 0.0, mscale = 1.0, lo = 0.0, hi = 0.0;
+    if (q.scaling == LLMK_ROPE_SCALING_NTK) {
+        base *= rope_exp(rope_log((double)q.factor) * (double)q.n_rot / (double)(q.n_rot - 2));
+    } else if (q.scaling == LLMK_ROPE_SCALING_LINEAR) {
+        freq_scale = 1.0 / (double)q.factor;
+    } else if (q.scaling == LLMK_ROPE_SCALING_YARN) {
+        freq_scale = 1.0 / (double)q.factor;
+        ext = 1.0;
+        mscale = 1.0 + 0.1 * rope_log((double)q.factor);
+        lo = rope_floor(rope_yarn_corr_dim(q.n_rot, q.orig_ctx, (double)q.yarn_beta_fast, base));
+        hi = -rope_floor(-rope_yarn_corr_dim(q.n_rot, q.orig_ctx, (double)q.yarn_beta_slow, base));
+        if (lo < 0.0) lo = 0.0;
+        if (hi > (double)(q.n_rot - 1)) hi = (double)(q.n_rot - 1);
+    }
+
+    float *ct = (float *)mem;
+    float *st = (float *)((uint8_t *)mem + need / 2u);
+    const double log_base = rope_log(base);
+    for (int i = 0; i < half; i++) {
+        const double theta = rope_exp(-(double)(2 * i) / (double)q.n_rot * log_base);
+        double mix = 0.0;
+        if (ext != 0.0) {
+            double span = hi - lo > 0.001 ? hi - lo : 0.001;
+            double y = ((double)i - lo) / span;
+            mix = (1.0 - (y < 0.0 ? 0.0 : (y > 1.0 ? 1.0 : y))) * ext;
+        }
+        for (int pos = 0; pos < seq_len; pos++) {
+            const double extrap = (double)pos * theta;
+            const double interp = freq_scale * extrap;
+            double s, c;
+            rope_sincos(interp * (1.0 - mix) + extrap * mix, &s, &c);
+            ct[(uint64_t)pos * half + i] = (float)(c * mscale);
+            st[(uint64_t)pos * half + i] = (float)(s * mscale);
+        }
+    }
+
+    r->p = q;
+    r->head_size = head_size;
+    r->half = half;
+    r->seq_len = seq_len;
+    r->mscale = (float)mscale;
+    r->cos_tab = ct;
+    r->sin_tab = st;
+    r->ready = 1;
+    return LLMK_ROPE_OK;
+}
+
+/* ── Rotation ───────────────────────────────────────────────────────────── */
+
+/* One head. sgn = +1 forward, −1 transpose (negated sin). */
+static void rope_head(const LlmkRope *r, float *dst, const float *src, const float *c,
+                      const float *s, float sgn) {
+    const int half = r->half, n_rot = r->p.n_rot;
+    int i = 0;
+    if (r->p.layout == LLMK_ROPE_NEOX) {
+        const float *x = src, *y = src + half;
+        float *ox = dst, *oy = dst + half;
+#if defined(__SSE2__)
+        const __m128 vs = _mm_set1_ps(sgn);
+        for (; i + 4 <= half; i += 4) {
+            __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i);
+            __m128 vc = _mm_loadu_ps(c + i), vn = _mm_mul_ps(_mm_loadu_ps(s + i), vs);
+            _mm_storeu_ps(ox + i, _mm_sub_ps(_mm_mul_ps(vx, vc), _mm_mul_ps(vy, vn)));
+            _mm_storeu_ps(oy + i, _mm_add_ps(_mm_mul_ps(vx, vn), _mm_mul_ps(vy, vc)));
+        }
+#endif
+        for (; i < half; i++) {
+            const float a = x[i], b = y[i], sn = s[i] * sgn;
+            ox[i] = a * c[i] - b * sn;
+            oy[i] = a * sn + b * c[i];
+        }
+    } else {
+#if defined(__SSE2__)
+        /* 4 pairs: [a0 b0 a1 b1] · [c0 c0 c1 c1] + [b0 a0 b1 a1] · [−s0 s0 −s1 s1] */
+        const __m128 alt = _mm_set_ps(sgn, -sgn, sgn, -sgn);
+        for (; i + 4 <= half; i += 4) {
+            __m128 vc = _mm_loadu_ps(c + i), vn = _mm_loadu_ps(s + i);
+            __m128 c01 = _mm_unpacklo_ps(vc, vc), c23 = _mm_unpackhi_ps(vc, vc);
+            __m128 s01 = _mm_mul_ps(_mm_unpacklo_ps(vn, vn), alt);
+            __m128 s23 = _mm_mul_ps(_mm_unpackhi_ps(vn, vn), alt);
+            __m128 v0 = _mm_loadu_ps(src + 2 * i), v1 = _mm_loadu_ps(src + 2 * i + 4);
+            __m128 w0 = _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 w1 = _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_ps(dst + 2 * i, _mm_add_ps(_mm_mul_ps(v0, c01), _mm_mul_ps(w0, s01)));
+            _mm_storeu_ps(dst + 2 * i + 4, _mm_add_ps(_mm_mul_ps(v1, c23), _mm_mul_ps(w1, s23)));
+        }
+#endif
+        for (; i < half; i++) {
+            const float a = src[2 * i], b = src[2 * i + 1], sn = s[i] * sgn;
+            dst[2 * i] = a * c[i] - b * sn;
+            dst[2 * i + 1] = a * sn + b * c[i];
+        }
+    }
+    if (dst != src) {
+        for (int j = n_rot; j < r->head_size; j++) dst[j] = src[j];
+    }
+}
+
+static void rope_apply(const LlmkRope *r, float *dst, const float *src, int n_heads, int pos, float sgn) {
+    if (!r->ready || pos < 0 || pos >= r->seq_len) {
+        if (dst != src) {
+            for (int j = 0; j < n_heads * r->head_size; j++) dst[j] = src[j];
+        }
+        return;
+    }
+    const float *c = r->cos_tab + (uint64_t)pos * r->half;
+    const float *s = r->sin_tab + (uint64_t)pos * r->half;
+    for (int h = 0; h < n_heads; h++) {
+        rope_head(r, dst + h * r->head_size, src + h * r->head_size, c, s, sgn);
+    }
+}
+
+void llmk_rope_rotate(const LlmkRope *r, float *dst, const float *src, int n_heads, int pos) {
+    rope_apply(r, dst, src, n_heads, pos, 1.0f);
+}
+
+void llmk_rope_rotate_T(const LlmkRope *r, float *dst, const float *src, int n_heads, int pos) {
+    rope_apply(r, dst, src, n_heads, pos, -1.0f);
+}
+
+void llmk_rope_shift(const LlmkRope *r, float *x, int n_heads, int delta) {
+    const int d = delta < 0 ? -delta : delta;
+    if (!r->ready || d == 0 || d >= r->seq_len) return;
+    rope_apply(r, x, x, n_heads, d, delta < 0 ? -1.0f : 1.0f);
+    if (r->mscale != 1.0f) {
+        const float inv = 1.0f / r->mscale;
+        for (int h = 0; h < n_heads; h++) {
+            float *xh = x + h * r->head_size;
+            for (int i = 0; i < r->p.n_rot; i++) xh[i] *= inv;   /* both layouts rotate dims [0, n_rot) */
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/* llmk_rope.h — Rotary position embedding with precomputed sin/cos tables
+ *
+ * Each head's first n_rot dims are rotated pairwise by angle pos·θ_i,
+ * θ_i = freq_base^(−2i/n_rot). Two pair layouts:
+ *
+ *   LLMK_ROPE_NORM   (2i, 2i+1)          llama2.c .bin, GGUF "llama"
+ *   LLMK_ROPE_NEOX   (i, i + n_rot/2)    GPT-NeoX, Qwen2, Phi, Falcon
+ *
+ * Context-extension scaling follows llama.cpp:
+ *
+ *   LINEAR  position interpolation, θ_i / factor
+ *   NTK     "NTK-aware" base change, base · factor^(n_rot/(n_rot−2))
+ *   YARN    per-dim ramp between interpolated and extrapolated θ_i over
+ *           [beta_fast, beta_slow] rotations of orig_ctx, plus the
+ *           0.1·ln(factor)+1 magnitude correction folded into the table
+ *
+ * cos/sin for every (pos, i) are computed once per seq_len in double
+ * precision (freestanding sin/cos/exp/log below) into caller memory — the
+ * activations arena on UEFI. Rotation is then a table lookup + SSE2 FMA-free
+ * multiply-add per pair.
+ *
+ * Freestanding C11 — no libc, no libm, no malloc.
+ */
+#pragma once
+#ifndef LLMK_ROPE_H
+#define LLMK_ROPE_H
+
+#include <stdint.h>
+
+#define LLMK_ROPE_NORM  0
+#define LLMK_ROPE_NEOX  2               /* same value as llama.cpp's rope type */
+
+#define LLMK_ROPE_SCALING_NONE    0
+#define LLMK_ROPE_SCALING_LINEAR  1
+#define LLMK_ROPE_SCALING_NTK     2
+#define LLMK_ROPE_SCALING_YARN    3
+
+typedef struct {
+    int   layout;                       /* LLMK_ROPE_NORM / LLMK_ROPE_NEOX */
+    int   n_rot;                        /* rotated dims per head; 0 = head_size */
+    float freq_base;                    /* 0 = 10000 */
+    int   scaling;                      /* LLMK_ROPE_SCALING_* */
+    float factor;                       /* context extension factor (≥ 1) */
+    int   orig_ctx;                     /* training context (YaRN); 0 = seq_len / factor */
+    float yarn_beta_fast;               /* 0 = 32 */
+    float yarn_beta_slow;               /* 0 = 1 */
+} LlmkRopeParams;
+
+typedef struct LlmkRope {
+    LlmkRopeParams p;                   /* resolved (no zeros left) */
+    int    head_size;
+    int    half;                        /* n_rot / 2 */
+    int    seq_len;
+    float  mscale;                      /* YaRN magnitude factor folded into the tables */
+    float *cos_tab;                     /* [seq_len][half] */
+    float *sin_tab;                     /* [seq_len][half] */
+    int    ready;
+} LlmkRope;
+
+#define LLMK_ROPE_OK         0
+#define LLMK_ROPE_ERR_PARAM  -1
+#define LLMK_ROPE_ERR_MEM    -2
+
+/* llama2.c defaults: NORM layout, full head, base 10000, no scaling */
+void     llmk_rope_defaults(LlmkRopeParams *p);
+
+/* "none", "linear", "ntk", "yarn" (case-insensitive, n bytes); -1 if unknown */
+int      llmk_rope_scaling_from_name(const char *s, int n);
+const char *llmk_rope_scaling_name(int scaling);
+
+uint64_t llmk_rope_table_bytes(int seq_len, int n_rot);
+
+/* Resolves p against head_size/seq_len and fills the tables. mem must be
+ * 16-byte aligned and hold llmk_rope_table_bytes(seq_len, n_rot). */
+int      llmk_rope_init(LlmkRope *r, const LlmkRopeParams *p, int head_size, int seq_len,
+                        void *mem, uint64_t bytes);
+
+/* dst = R(pos)·src for n_heads consecutive heads (dst may equal src; dims
+ * past n_rot are copied). */
+void     llmk_rope_rotate(const LlmkRope *r, float *dst, const float *src, int n_heads, int pos);
+
+/* dst = R(pos)ᵀ·src — the backward of llmk_rope_rotate (same mscale). */
+void     llmk_rope_rotate_T(const LlmkRope *r, float *dst, const float *src, int n_heads, int pos);
+
+/* x = R(delta)·x in place, without the YaRN magnitude: moves keys that were
+ * rotated at position p to position p + delta (|delta| < seq_len). */
+void     llmk_rope_shift(const LlmkRope *r, float *x, int n_heads, int delta);
+
+#endif /* LLMK_ROPE_H */
@@ -0,0 +1,228 @@
+// llmk_sampler.c — Token sampling and repetition control
+//
+// Unity fragment (soma_inference.c, engine/host/llmk_host_rt.c). The
+// includer provides fast_exp (llmk_kernels.c), g_sample_seed and
+// oo_quantum_mix (oo_quantum_rng.h).
+//
+// llmk_sample() draws from a caller-owned LlmkSampler (RNG + top-k scratch),
+// so generations with their own sampler never touch each other's state.
+// sample_advanced() is the process-wide one, seeded by g_sample_seed.
+
+#define LLMK_SAMPLE_MAX_TOP_K 256
+
+typedef struct {
+    unsigned int seed;                    // LCG state
+    unsigned int draws;                   // every 8th draw mixes in oo_quantum_mix
+    int   top_idx[LLMK_SAMPLE_MAX_TOP_K];
+    float top_prob[LLMK_SAMPLE_MAX_TOP_K];
+} LlmkSampler;
+
+static int has_suffix_repeat(const int* tokens, int n_tokens, int span) {
+    if (span <= 0) return 0;
+    if (n_tokens < 2 * span) return 0;
+    for (int i = 0; i < span; i++) {
+        if (tokens[n_tokens - span + i] != tokens[n_tokens - 2 * span + i]) return 0;
+    }
+    return 1;
+}
+
+static void apply_no_repeat_ngram(float* logits, int vocab_size, const int* tokens, int n_tokens, int ngram) {
+    if (ngram < 2) return;
+    if (n_tokens < ngram - 1) return;
+
+    int prefix_len = ngram - 1;
+    int prefix_start = n_tokens - prefix_len;
+    int limit = n_tokens - ngram;
+    for (int i = 0; i <= limit; i++) {
+        int match = 1;
+        for (int j = 0; j < prefix_len; j++) {
+            if (tokens[i + j] != tokens[prefix_start + j]) {
+                match = 0;
+                break;
+            }
+        }
+        if (match) {
+            int banned = tokens[i + prefix_len];
+            if (banned >= 0 && banned < vocab_size) {
+                // Large negative value to effectively zero it after softmax.
+                logits[banned] = -1.0e9f;
+            }
+        }
+    }
+}
+
+static float randf(LlmkSampler *sm) {
+    sm->seed = sm->seed * 1664525 + 1013904223;
+    // Every 8 calls: inject one RDTSC jitter byte into the seed.
+    // Cost: ~5 cycles / 8 tokens = negligible. Breaks LCG predictability.
+    if ((++sm->draws & 7U) == 0) {
+        sm->seed = oo_quantum_mix(sm->seed);
+    }
+    return (float)(sm->seed >> 8) / 16777216.0f;
+}
+
+// Sample with temperature + min_p + top-p + top-k + repetition penalty
+int llmk_sample(LlmkSampler *sm, float* logits, int n, float temperature, float min_p, float top_p, int top_k,
+                int* recent_tokens, int n_recent, float repeat_penalty) {
+    // Apply repetition penalty
+    if (repeat_penalty != 1.0f && n_recent > 0) {
+        for (int i = 0; i < n_recent; i++) {
+            int tok = recent_tokens[i];
+            if (tok >= 0 && tok < n) {
+                if (logits[tok] > 0) {
+                    logits[tok] /= repeat_penalty;
+                } else {
+                    logits[tok] *= repeat_penalty;
+                }
+            }
+        }
+    }
+    
+    // Greedy if temp=0
+    if (temperature <= 0.0f) {
+        int max_i = 0;
+        float max_val = logits[0];
+        for (int i = 1; i < n; i++) {
+            if (logits[i] > max_val) {
+                max_val = logits[i];
+                max_i = i;
+            }
+        }
+        return max_i;
+    }
+    
+    // Apply temperature
+    for (int i = 0; i < n; i++) {
+        logits[i] /= temperature;
+    }
+    
+    // Softmax
+    float max_val = logits[0];
+    for (int i = 1; i < n; i++) {
+        if (logits[i] > max_val) max_val = logits[i];
+    }
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        logits[i] = fast_exp(logits[i] - max_val);
+        sum += logits[i];
+    }
+    for (int i = 0; i < n; i++) {
+        logits[i] /= sum;
+    }
+
+    // Min-p filtering (relative to max probability)
+    if (min_p > 0.0f) {
+        float max_p = 0.0f;
+        for (int i = 0; i < n; i++) {
+            if (logits[i] > max_p) max_p = logits[i];
+        }
+        float thresh = min_p * max_p;
+        float new_sum = 0.0f;
+        for (int i = 0; i < n; i++) {
+            if (logits[i] < thresh) {
+                logits[i] = 0.0f;
+            }
+            new_sum += logits[i];
+        }
+        if (new_sum > 0.0f) {
+            for (int i = 0; i < n; i++) {
+                logits[i] /= new_sum;
+            }
+        }
+    }
+    
+    // Top-k / Top-p sampling
+    {
+        // IMPORTANT: vocab is 32k; do NOT full-sort.
+        // We maintain a small descending top-list.
+        int *top_idx = sm->top_idx;
+        float *top_prob = sm->top_prob;
+        int k = top_k;
+        if (k < 0) k = 0;
+        if (k > LLMK_SAMPLE_MAX_TOP_K) k = LLMK_SAMPLE_MAX_TOP_K;
+        if (k == 0 || k > n) k = (n < LLMK_SAMPLE_MAX_TOP_K) ? n : LLMK_SAMPLE_MAX_TOP_K;
+
+        int top_count = 0;
+        for (int i = 0; i < n; i++) {
+            float p = logits[i];
+            if (top_count < k) {
+                int j = top_count;
+                while (j > 0 && top_prob[j - 1] < p) {
+                    top_prob[j] = top_prob[j - 1];
+                    top_idx[j] = top_idx[j - 1];
+                    j--;
+                }
+                top_prob[j] = p;
+                top_idx[j] = i;
+                top_count++;
+            } else if (p > top_prob[top_count - 1]) {
+                int j = top_count - 1;
+                while (j > 0 && top_prob[j - 1] < p) {
+                    top_prob[j] = top_prob[j - 1];
+                    top_idx[j] = top_idx[j - 1];
+                    j--;
+                }
+                top_prob[j] = p;
+                top_idx[j] = i;
+            }
+        }
+
+        // If both are effectively "disabled" (top_p>=1 and top_k<=0), fall through to full sampling.
+        if (top_k > 0 || top_p < 1.0f) {
+            float mass = 0.0f;
+            int cutoff = 0;
+            for (int i = 0; i < top_count; i++) {
+                mass += top_prob[i];
+                cutoff++;
+                if (top_p < 1.0f && mass >= top_p) break;
+            }
+            if (cutoff < 1) cutoff = 1;
+
+            float r = randf(sm) * mass;
+            float cdf = 0.0f;
+            for (int i = 0; i < cutoff; i++) {
+                cdf += top_prob[i];
+                if (r < cdf) {
+                    return top_idx[i];
+                }
+            }
+            return top_idx[cutoff - 1];
+        }
+    }
+    
+    // Sample from distribution
+    float r = randf(sm);
+    float cumsum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        cumsum += logits[i];
+        if (r < cumsum) {
+            return i;
+        }
+    }
+    
+    return n - 1;
+}
+
+static LlmkSampler g_llmk_sampler;
+
+int sample_advanced(float* logits, int n, float temperature, float min_p, float top_p, int top_k,
+                    int* recent_tokens, int n_recent, float repeat_penalty) {
+    g_llmk_sampler.seed = g_sample_seed;
+    int tok = llmk_sample(&g_llmk_sampler, logits, n, temperature, min_p, top_p, top_k,
+                          recent_tokens, n_recent, repeat_penalty);
+    g_sample_seed = g_llmk_sampler.seed;
+    return tok;
+}
+
+int sample(float* logits, int n) {
+    // Simple greedy for now (kept for compatibility)
+    int max_i = 0;
+    float max_val = logits[0];
+    for (int i = 1; i < n; i++) {
+        if (logits[i] > max_val) {
+            max_val = logits[i];
+            max_i = i;
+        }
+    }
+    return max_i;
+}
@@ -0,0 +1,189 @@
+/* llmk_shortlist.c — Two-stage classifier: low-rank shortlist, exact rerank
+ *
+ * See llmk_shortlist.h. Unity-included by soma_inference.c; builds on the host
+ * for engine/host and tests/test_llmk_shortlist.c.
+ */
+
+#include "llmk_shortlist.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static uint64_t sl_align16(uint64_t x) {
+    return (x + 15u) & ~(uint64_t)15u;
+}
+
+static uint32_t sl_rank_pad(uint32_t rank) {
+    return (rank + 15u) & ~15u;
+}
+
+uint64_t llmk_sl_file_bytes(uint32_t vocab, uint32_t dim, uint32_t rank) {
+    uint64_t off = sizeof(LlmkSlHeader);
+    off = sl_align16(off + (uint64_t)rank * dim * 4u);
+    off = sl_align16(off + (uint64_t)vocab * 4u);
+    off = sl_align16(off + (uint64_t)vocab * 4u);
+    return off + (uint64_t)vocab * sl_rank_pad(rank);
+}
+
+int llmk_sl_parse(LlmkShortlist *sl, const void *buf, uint64_t len) {
+    uint8_t *p = (uint8_t *)sl;
+    for (uint64_t i = 0; i < sizeof(*sl); i++) p[i] = 0;
+    if (!buf || len < sizeof(LlmkSlHeader) || ((uintptr_t)buf & 3u)) return LLMK_SL_ERR_FORMAT;
+
+    const LlmkSlHeader *h = (const LlmkSlHeader *)buf;
+    if (h->magic != LLMK_SL_MAGIC || h->version != LLMK_SL_VERSION) return LLMK_SL_ERR_FORMAT;
+    if (h->vocab == 0 || h->dim == 0 || h->rank == 0 || h->rank > LLMK_SL_MAX_RANK ||
+        h->rank > h->dim || h->rank_pad != sl_rank_pad(h->rank) || h->vocab > (1u << 24) ||
+        h->dim > (1u << 16)) {
+        return LLMK_SL_ERR_SHAPE;
+    }
+    if (len < llmk_sl_file_bytes(h->vocab, h->dim, h->rank)) return LLMK_SL_ERR_FORMAT;
+
+    const uint8_t *b = (const uint8_t *)buf;
+    uint64_t off = sizeof(LlmkSlHeader);
+    sl->basis = (const float *)(b + off);
+    off = sl_align16(off + (uint64_t)h->rank * h->dim * 4u);
+    sl->scale = (const float *)(b + off);
+    off = sl_align16(off + (uint64_t)h->vocab * 4u);
+    sl->resid = (const float *)(b + off);
+    off = sl_align16(off + (uint64_t)h->vocab * 4u);
+    sl->coef = (const int8_t *)(b + off);
+
+    sl->vocab = h->vocab;
+    sl->dim = h->dim;
+    sl->rank = h->rank;
+    sl->rank_pad = h->rank_pad;
+    return LLMK_SL_OK;
+}
+
+uint64_t llmk_sl_scratch_bytes(uint32_t vocab, uint32_t rank, uint32_t max_cand) {
+    return sl_align16((uint64_t)sl_rank_pad(rank) * 4u) + sl_align16((uint64_t)vocab * 4u) +
+           sl_align16((uint64_t)max_cand * 4u) * 2u;
+}
+
+int llmk_sl_attach_scratch(LlmkShortlist *sl, void *mem, uint64_t bytes, uint32_t max_cand) {
+    if (!sl->coef || !mem || ((uintptr_t)mem & 15u) || max_cand == 0 || max_cand > sl->vocab ||
+        bytes < llmk_sl_scratch_bytes(sl->vocab, sl->rank, max_cand)) {
+        return LLMK_SL_ERR_SCRATCH;
+    }
+    uint8_t *m = (uint8_t *)mem;
+    sl->z = (float *)m;
+    m += sl_align16((uint64_t)sl->rank_pad * 4u);
+    sl->approx = (float *)m;
+    m += sl_align16((uint64_t)sl->vocab * 4u);
+    sl->cand = (int32_t *)m;
+    m += sl_align16((uint64_t)max_cand * 4u);
+    sl->cand_score = (float *)m;
+    sl->max_cand = max_cand;
+    if (sl->n_cand == 0 || sl->n_cand > max_cand) sl->n_cand = max_cand;
+    for (uint32_t j = 0; j < sl->rank_pad; j++) sl->z[j] = 0.0f;
+    return LLMK_SL_OK;
+}
+
+/* c_i · z over rank_pad (the pad bytes of every row are zero) */
+static float sl_row_dot(const int8_t *c, const float *z, uint32_t n) {
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (uint32_t j = 0; j < n; j += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(c + j));
+        __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+        __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+        __m128 f0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16));
+        __m128 f1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16));
+        __m128 f2 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+        __m128 f3 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(f0, _mm_loadu_ps(z + j)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(f1, _mm_loadu_ps(z + j + 4)));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(f2, _mm_loadu_ps(z + j + 8)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(f3, _mm_loadu_ps(z + j + 12)));
+    }
+    float t[4];
+    _mm_storeu_ps(t, _mm_add_ps(acc0, acc1));
+    return (t[0] + t[1]) + (t[2] + t[3]);
+#else
+    float s = 0.0f;
+    for (uint32_t j = 0; j < n; j++) s += (float)c[j] * z[j];
+    return s;
+#endif
+}
+
+static float sl_sqrt(float v) {
+    if (v <= 0.0f) return 0.0f;
+    float r = v > 1.0f ? v : 1.0f;
+    for (int i = 0; i < 24; i++) r = 0.5f * (r + v / r);
+    return r;
+}
+
+/* Min-heap on cand_score: root is the weakest kept candidate */
+static void sl_sift_down(float *score, int32_t *id, uint32_t n, uint32_t i) {
+    for (;;) {
+        uint32_t l = 2u * i + 1u, m = i;
+        if (l < n && score[l] < score[m]) m = l;
+        if (l + 1u < n && score[l + 1u] < score[m]) m = l + 1u;
+        if (m == i) return;
+        float ts = score[i]; score[i] = score[m]; score[m] = ts;
+        int32_t ti = id[i]; id[i] = id[m]; id[m] = ti;
+        i = m;
+    }
+}
+
+static void sl_sift_up(float *score, int32_t *id, uint32_t i) {
+    while (i > 0) {
+        uint32_t p = (i - 1u) / 2u;
+        if (score[p] <= score[i]) return;
+        float ts = score[i]; score[i] = score[p]; score[p] = ts;
+        int32_t ti = id[i]; id[i] = id[p]; id[p] = ti;
+        i = p;
+    }
+}
+
+uint32_t llmk_sl_select(LlmkShortlist *sl, const float *x) {
+    const uint32_t D = sl->dim, R = sl->rank, RP = sl->rank_pad, V = sl->vocab;
+    uint32_t n = sl->n_cand, k = 0;
+    float xx = 0.0f;
+
+    for (uint32_t i = 0; i < D; i++) xx += x[i] * x[i];
+    sl->x_norm = sl_sqrt(xx);
+    for (uint32_t r = 0; r < R; r++) {
+        const float *b = sl->basis + (uint64_t)r * D;
+        float s = 0.0f;
+        for (uint32_t i = 0; i < D; i++) s += b[i] * x[i];
+        sl->z[r] = s;
+    }
+
+    for (uint32_t v = 0; v < V; v++) {
+        float a = sl->scale[v] * sl_row_dot(sl->coef + (uint64_t)v * RP, sl->z, RP);
+        sl->approx[v] = a;
+        if (k < n) {
+            sl->cand_score[k] = a;
+            sl->cand[k] = (int32_t)v;
+            sl_sift_up(sl->cand_score, sl->cand, k++);
+        } else if (a > sl->cand_score[0]) {
+            sl->cand_score[0] = a;
+            sl->cand[0] = (int32_t)v;
+            sl_sift_down(sl->cand_score, sl->cand, k, 0);
+        }
+    }
+    for (uint32_t i = 0; i < k; i++) sl->approx[sl->cand[i]] = LLMK_SL_MASKED;
+    sl->calls++;
+    return k;
+}
+
+int llmk_sl_certify(LlmkShortlist *sl, const float *logits) {
+    float best = LLMK_SL_MASKED;
+    for (uint32_t i = 0; i < sl->n_cand && i < sl->max_cand; i++) {
+        float l = logits[sl->cand[i]];
+        if (l > best) best = l;
+    }
+    const float xn = sl->x_norm;
+    for (uint32_t v = 0; v < sl->vocab; v++) {
+        float a = sl->approx[v];
+        if (a != LLMK_SL_MASKED && a + sl->resid[v] * xn >= best) {
+            sl->fallbacks++;
+            return 0;
+        }
+    }
+    sl->certified++;
+    return 1;
+}
@@ -0,0 +1,97 @@
+/* llmk_shortlist.h — Two-stage classifier: low-rank shortlist, exact rerank
+ *
+ * The classifier is the largest matmul of a decode step (vocab × dim), yet
+ * the sampler only looks at the few dozen tokens that survive top-k / top-p.
+ * A shortlist file (.lksl, built offline by engine/host --shortlist-build)
+ * holds a rank-r factorisation of the classifier W ≈ C·B:
+ *
+ *   stage 1   z = B·x              (rank × dim, f32)
+ *             approx_i = s_i · (c_i · z)   (vocab × rank, int8 rows)
+ *             keep the n_cand rows with the largest approx score
+ *   stage 2   exact logits for those rows only (caller: f32 or Q8_0 rows);
+ *             every other logit is LLMK_SL_MASKED
+ *
+ * Each row also stores resid_i = ‖W_i − s_i·c_i·B‖₂, so
+ * |logit_i − approx_i| ≤ resid_i·‖x‖. llmk_sl_certify() uses that bound to
+ * prove the exact top-1 among the candidates is the true top-1; greedy
+ * decoding (and anything else that needs the exact argmax) falls back to
+ * the full classifier when it cannot.
+ *
+ * File layout (little-endian, sections 16-byte aligned):
+ *   LlmkSlHeader | basis f32[rank·dim] | scale f32[vocab] | resid f32[vocab]
+ *   | coef i8[vocab·rank_pad]          (rank_pad = rank rounded up to 16)
+ *
+ * Freestanding C11 — no libc, no malloc. The file buffer and the scratch
+ * memory are caller-owned and must outlive the LlmkShortlist.
+ */
+#pragma once
+#ifndef LLMK_SHORTLIST_H
+#define LLMK_SHORTLIST_H
+
+#include <stdint.h>
+
+#define LLMK_SL_MAGIC     0x4C534B4Cu   /* "LKSL" */
+#define LLMK_SL_VERSION   1u
+#define LLMK_SL_MAX_RANK  256
+#define LLMK_SL_MASKED    (-1.0e9f)     /* same floor as the sampler's bans */
+
+#define LLMK_SL_OK          0
+#define LLMK_SL_ERR_FORMAT  -1
+#define LLMK_SL_ERR_SHAPE   -2
+#define LLMK_SL_ERR_SCRATCH -3
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vocab;
+    uint32_t dim;
+    uint32_t rank;
+    uint32_t rank_pad;
+    uint32_t reserved[2];
+} LlmkSlHeader;                         /* 32 bytes */
+
+typedef struct {
+    uint32_t vocab, dim, rank, rank_pad;
+    const float  *basis;                /* [rank][dim] */
+    const float  *scale;                /* [vocab] */
+    const float  *resid;                /* [vocab] */
+    const int8_t *coef;                 /* [vocab][rank_pad] */
+
+    /* Scratch (llmk_sl_attach_scratch) */
+    float    *z;                        /* [rank_pad] */
+    float    *approx;                   /* [vocab]; candidates marked LLMK_SL_MASKED */
+    int32_t  *cand;                     /* [max_cand], min-heap on approx while selecting */
+    float    *cand_score;               /* [max_cand] */
+    uint32_t  max_cand;
+
+    /* Policy */
+    int       enabled;
+    uint32_t  n_cand;                   /* ≤ max_cand */
+    int       verify_top1;              /* certify or fall back to the full classifier */
+    float     x_norm;                   /* ‖x‖ of the last llmk_sl_select */
+
+    /* Stats (cumulative) */
+    uint64_t  calls;
+    uint64_t  certified;
+    uint64_t  fallbacks;
+} LlmkShortlist;
+
+/* Bytes needed for a file with these dimensions */
+uint64_t llmk_sl_file_bytes(uint32_t vocab, uint32_t dim, uint32_t rank);
+
+/* Validate and map a .lksl buffer (zero-copy). Scratch must be attached
+ * before use; the shortlist starts disabled. */
+int      llmk_sl_parse(LlmkShortlist *sl, const void *buf, uint64_t len);
+
+uint64_t llmk_sl_scratch_bytes(uint32_t vocab, uint32_t rank, uint32_t max_cand);
+int      llmk_sl_attach_scratch(LlmkShortlist *sl, void *mem, uint64_t bytes, uint32_t max_cand);
+
+/* Stage 1: fill sl->cand[0..n) with the n_cand best approximate rows of x
+ * (unordered). Returns n. */
+uint32_t llmk_sl_select(LlmkShortlist *sl, const float *x);
+
+/* After stage 2 wrote exact logits for the candidates: 1 if their best row
+ * beats every other row's upper bound approx_i + resid_i·‖x‖. */
+int      llmk_sl_certify(LlmkShortlist *sl, const float *logits);
+
+#endif /* LLMK_SHORTLIST_H */
@@ -0,0 +1,108 @@
+/* llmk_spec.c — Prompt-lookup drafts for speculative decoding
+ *
+ * See llmk_spec.h. Unity-included by soma_inference.c and the host runtime,
+ * next to llmk_repeat.c.
+ */
+
+#include "llmk_spec.h"
+
+static uint64_t sp_align(uint64_t n) {
+    return (n + 63u) & ~(uint64_t)63u;
+}
+
+static uint32_t sp_table_size(int cap) {
+    uint32_t s = 16;
+    while (s < (uint32_t)cap * 2u) s <<= 1;
+    return s;
+}
+
+uint64_t llmk_spec_bytes(int cap) {
+    if (cap <= 0) return 0;
+    return sp_align((uint64_t)sp_table_size(cap) * 4) + sp_align((uint64_t)cap * 4);
+}
+
+/* Bucket of the min_ngram tokens ending at hist[e] */
+static uint32_t sp_bucket(const LlmkSpec *sp, const int *hist, int e) {
+    uint64_t h = 0;
+    for (int i = e - sp->min_ngram + 1; i <= e; i++) {
+        h = (h + (uint64_t)(uint32_t)hist[i] + 1u) * 0x9E3779B97F4A7C15ULL;
+    }
+    h ^= h >> 29;
+    return (uint32_t)h & sp->mask;
+}
+
+int llmk_spec_init(LlmkSpec *sp, void *mem, uint64_t bytes, int cap, int min_ngram, int max_ngram) {
+    if (!sp || !mem || cap <= 0) return LLMK_SPEC_ERR_PARAM;
+    if (bytes < llmk_spec_bytes(cap)) return LLMK_SPEC_ERR_MEM;
+    const uint32_t t = sp_table_size(cap);
+    uint8_t *p = (uint8_t *)mem;
+
+    if (max_ngram > LLMK_SPEC_MAX_NGRAM) max_ngram = LLMK_SPEC_MAX_NGRAM;
+    if (max_ngram < 1) max_ngram = 1;
+    if (min_ngram > max_ngram) min_ngram = max_ngram;
+    if (min_ngram < 1) min_ngram = 1;
+
+    sp->cap = cap;
+    sp->min_ngram = min_ngram;
+    sp->max_ngram = max_ngram;
+    sp->max_chain = LLMK_SPEC_MAX_CHAIN;
+    sp->head = (int32_t *)p;   p += sp_align((uint64_t)t * 4);
+    sp->prev = (int32_t *)p;
+    sp->mask = t - 1;
+    for (uint32_t i = 0; i < t; i++) sp->head[i] = -1;
+    sp->n = 0;
+    sp->drafts = sp->proposed = sp->accepted = sp->last_match = 0;
+    return LLMK_SPEC_OK;
+}
+
+void llmk_spec_reset(LlmkSpec *sp) {
+    for (uint32_t i = 0; i <= sp->mask; i++) sp->head[i] = -1;
+    sp->n = 0;
+}
+
+void llmk_spec_sync(LlmkSpec *sp, const int *hist, int n) {
+    if (n < 0) n = 0;
+    if (n > sp->cap) n = sp->cap;
+    const int m1 = sp->min_ngram - 1;
+    while (sp->n > n) {
+        const int e = --sp->n;
+        if (e >= m1) sp->head[sp_bucket(sp, hist, e)] = sp->prev[e];
+    }
+    while (sp->n < n) {
+        const int e = sp->n++;
+        if (e < m1) continue;
+        const uint32_t b = sp_bucket(sp, hist, e);
+        sp->prev[e] = sp->head[b];
+        sp->head[b] = e;
+    }
+}
+
+int llmk_spec_propose(LlmkSpec *sp, const int *hist, int k, int *draft) {
+    const int n = sp->n;
+    const int last = n - 1;
+    if (k > LLMK_SPEC_MAX_DRAFT) k = LLMK_SPEC_MAX_DRAFT;
+    if (k <= 0 || n < sp->min_ngram + 1) return 0;
+
+    int best = -1, best_len = 0;
+    int chain = sp->max_chain;
+    for (int32_t p = sp->prev[last]; p >= 0 && chain-- > 0; p = sp->prev[p]) {
+        /* Same bucket is not the same n-gram: compare, then extend */
+        int len = 0;
+        while (len < sp->max_ngram && p - len >= 0 && hist[p - len] == hist[last - len]) len++;
+        if (len < sp->min_ngram || len <= best_len) continue;
+        best = p;
+        best_len = len;
+        if (len == sp->max_ngram) break;
+    }
+    if (best < 0) return 0;
+
+    /* What followed the match; past the tail the copy reads its own output */
+    for (int j = 0; j < k; j++) {
+        const int src = best + 1 + j;
+        draft[j] = (src < n) ? hist[src] : draft[src - n];
+    }
+    sp->drafts++;
+    sp->proposed += (uint64_t)k;
+    sp->last_match = (uint64_t)best_len;
+    return k;
+}
@@ -0,0 +1,81 @@
+/* llmk_spec.h — Prompt-lookup drafts for speculative decoding
+ *
+ * Chat, summarisation and code-editing turns copy long spans of the prompt
+ * or of their own earlier output. When the last few tokens of the history
+ * occurred before, the tokens that followed that occurrence are a cheap
+ * guess at what comes next. The decode loop verifies such a draft in one
+ * transformer_forward_batch() over [last token, draft...]: row j of the
+ * batch holds the exact logits for the position after draft token j-1, so
+ * sampling proceeds unchanged and only consumes a row while the sampled
+ * token equals the draft. Output is identical to plain decoding for every
+ * sampler; a rejected draft only costs the wasted rows, whose KV entries are
+ * overwritten by the next pass.
+ *
+ * Index: hash chains over the caller's history (as in zlib's deflate). The
+ * last min_ngram tokens ending at each position hash to a bucket; head[]
+ * holds the newest position per bucket and prev[] links to older ones.
+ * Appending a position is O(1); so is dropping the newest one, which is
+ * always the head of its chain. A proposal walks at most max_chain older
+ * positions, confirms each candidate token by token, extends the match
+ * backwards up to max_ngram and keeps the longest (the most recent on
+ * ties). The draft copies what followed; when the match overlaps the tail
+ * (a loop of period p) the copy continues through the draft itself, so a
+ * repeating pattern drafts its whole period and beyond.
+ *
+ * Freestanding C11 — no libc, no malloc. Tables live in a caller-owned
+ * arena sized by llmk_spec_bytes().
+ */
+#pragma once
+#ifndef LLMK_SPEC_H
+#define LLMK_SPEC_H
+
+#include <stdint.h>
+
+#define LLMK_SPEC_MAX_DRAFT   8          /* draft + last token fit one 16-row batch */
+#define LLMK_SPEC_MIN_NGRAM   2
+#define LLMK_SPEC_MAX_NGRAM   8
+#define LLMK_SPEC_MAX_CHAIN   64
+
+#define LLMK_SPEC_OK          0
+#define LLMK_SPEC_ERR_PARAM   -1
+#define LLMK_SPEC_ERR_MEM     -2
+
+typedef struct {
+    int       cap;                       /* history positions the arena indexes */
+    int       min_ngram;                 /* tokens that must match (1..max_ngram) */
+    int       max_ngram;                 /* match length considered (<= LLMK_SPEC_MAX_NGRAM) */
+    int       max_chain;                 /* candidates examined per proposal */
+    int       n;                         /* history length indexed */
+
+    int32_t  *head;                      /* [mask+1] newest position per bucket, -1 = none */
+    int32_t  *prev;                      /* [cap] older position in the same bucket */
+    uint32_t  mask;
+
+    /* Stats (cumulative; accepted is bumped by the decode loop) */
+    uint64_t  drafts;                    /* proposals that returned tokens */
+    uint64_t  proposed;                  /* draft tokens proposed */
+    uint64_t  accepted;                  /* draft tokens that matched the sampled token */
+    uint64_t  last_match;                /* match length of the last draft */
+} LlmkSpec;
+
+/* Arena size for a history of up to cap tokens */
+uint64_t llmk_spec_bytes(int cap);
+
+/* Lays out the arena and resets. min_ngram is clamped to 1..max_ngram,
+ * max_ngram to LLMK_SPEC_MAX_NGRAM. */
+int  llmk_spec_init(LlmkSpec *sp, void *mem, uint64_t bytes, int cap, int min_ngram, int max_ngram);
+
+/* Forgets the history (settings and stats stay) */
+void llmk_spec_reset(LlmkSpec *sp);
+
+/* Brings the index to hist[0..n) (n clamped to cap): appends hist[sp->n..n)
+ * or drops positions back to n. hist[0..min(n, sp->n)) must not have
+ * changed since. */
+void llmk_spec_sync(LlmkSpec *sp, const int *hist, int n);
+
+/* Writes up to k (<= LLMK_SPEC_MAX_DRAFT) tokens likely to follow
+ * hist[0..sp->n) to draft. Returns the draft length, 0 when the tail did
+ * not occur before. */
+int  llmk_spec_propose(LlmkSpec *sp, const int *hist, int k, int *draft);
+
+#endif /* LLMK_SPEC_H */
@@ -0,0 +1,136 @@
+// llmk_tokenizer.c — tokenizer.bin greedy encoder and piece decoder
+//
+// Unity fragment (soma_inference.c, engine/host/llmk_host_rt.c). The
+// includer provides Tokenizer (llmk_model.h), llmk_vocab.c, my_strcmp and
+// TOKEN_BOS/TOKEN_EOS. A Tokenizer built from GGUF metadata (t->gguf) hands
+// encoding and decoding to llmk_vocab.c instead.
+
+int str_lookup(char* str, char** vocab, int vocab_size) {
+    for (int i = 0; i < vocab_size; i++) {
+        if (vocab[i] && my_strcmp(str, vocab[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void encode(char* text, int* tokens, int* n_tokens, int max_tokens, Tokenizer* t) {
+    *n_tokens = 0;
+    if (max_tokens <= 0) return;
+
+    if (t->gguf) {
+        int len = 0;
+        while (text[len]) len++;
+        *n_tokens = llmk_vocab_encode(t->gguf, text, len, 1, tokens, max_tokens);
+        return;
+    }
+
+    // Add BOS
+    tokens[(*n_tokens)++] = TOKEN_BOS;
+    if (*n_tokens >= max_tokens) return;
+
+    // Greedy longest-match encoding
+    char* str = text;
+    while (*str && *n_tokens < max_tokens) {
+        int best_id = -1;
+        int best_len = 0;
+
+        for (int len = 64; len > 0; len--) {
+            char piece[65];
+            int i = 0;
+            for (i = 0; i < len && str[i]; i++) {
+                piece[i] = str[i];
+            }
+            if (i != len) continue; // not enough chars remaining
+            piece[i] = '\0';
+
+            int id = str_lookup(piece, t->vocab, t->vocab_size);
+            if (id >= 0) {
+                best_id = id;
+                best_len = len;
+                break;
+            }
+        }
+
+        if (best_id >= 0) {
+            if (*n_tokens >= max_tokens) break;
+            tokens[(*n_tokens)++] = best_id;
+            str += best_len;
+        } else {
+            char single[2]; // SAFE: 1 char + NUL
+            single[0] = *str;
+            single[1] = '\0'; // SAFE: fixed-size local buffer
+            int id = str_lookup(single, t->vocab, t->vocab_size);
+            if (id >= 0) {
+                if (*n_tokens >= max_tokens) break;
+                tokens[(*n_tokens)++] = id;
+            }
+            str++;
+        }
+    }
+}
+
+// ============================================================
+// llmk_decode_piece — convert raw vocab token string to printable bytes
+// Handles SentencePiece conventions:
+//   1. "<0xNN>" byte tokens → actual byte value
+//   2. "▁" (U+2581, 3 bytes E2 96 81) leading space → ' '
+//   3. Raw string → returned as-is
+// out_buf must be at least 4 bytes. Returns actual byte count.
+// ============================================================
+static int llmk_decode_piece(const char *piece, char *out_buf, int out_size) {
+    if (!piece || !out_buf || out_size <= 0) return 0;
+
+    int len = 0;
+    while (piece[len]) len++;
+    if (len == 0) return 0;
+
+    // Case 1: byte token "<0xNN>" (exactly 6 chars)
+    if (len == 6 && piece[0] == '<' && piece[1] == '0' && piece[2] == 'x' && piece[5] == '>') {
+        char hi = piece[3], lo = piece[4];
+        int hv = (hi >= '0' && hi <= '9') ? hi-'0' : (hi >= 'a' && hi <= 'f') ? hi-'a'+10 : (hi >= 'A' && hi <= 'F') ? hi-'A'+10 : -1;
+        int lv = (lo >= '0' && lo <= '9') ? lo-'0' : (lo >= 'a' && lo <= 'f') ? lo-'a'+10 : (lo >= 'A' && lo <= 'F') ? lo-'A'+10 : -1;
+        if (hv >= 0 && lv >= 0 && out_size >= 1) {
+            out_buf[0] = (char)((hv << 4) | lv);
+            return 1;
+        }
+    }
+
+    // Case 2: SentencePiece leading "▁" (U+2581 = E2 96 81) → space
+    // Replace only the leading ▁; keep remaining bytes as-is
+    if (len >= 3 && (unsigned char)piece[0] == 0xE2 &&
+                    (unsigned char)piece[1] == 0x96 &&
+                    (unsigned char)piece[2] == 0x81) {
+        int rest = len - 3;
+        if (out_size < 1 + rest) rest = out_size - 1;
+        if (rest < 0) rest = 0;
+        if (out_size >= 1) out_buf[0] = ' ';
+        for (int i = 0; i < rest; i++) out_buf[1 + i] = piece[3 + i];
+        return 1 + rest;
+    }
+
+    // Case 3: raw string — copy up to out_size bytes
+    int copy = len < out_size ? len : out_size;
+    for (int i = 0; i < copy; i++) out_buf[i] = piece[i];
+    return copy;
+}
+
+// BOS id encode() prepends; callers continuing a conversation strip it
+static int llmk_tok_bos(const Tokenizer *t) {
+    return t->gguf ? t->gguf->bos_id : TOKEN_BOS;
+}
+
+// End of generation: EOS/EOT for GGUF vocabularies; EOS or BOS (which some
+// llama2.c exports emit) for tokenizer.bin
+static int llmk_tok_is_stop(const Tokenizer *t, int id) {
+    if (t->gguf) return llmk_vocab_is_stop(t->gguf, id) || (id >= 0 && id == t->gguf->bos_id);
+    return id == TOKEN_EOS || id == TOKEN_BOS;
+}
+
+// Printable bytes of token id (control tokens print nothing). Returns the
+// byte count written to out_buf.
+static int llmk_tok_decode(const Tokenizer *t, int id, char *out_buf, int out_size) {
+    if (t->gguf) return llmk_vocab_decode(t->gguf, id, out_buf, out_size);
+    if (id < 0 || id >= t->vocab_size || !t->vocab[id]) return 0;
+    return llmk_decode_piece(t->vocab[id], out_buf, out_size);
+}
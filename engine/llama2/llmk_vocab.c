@@ -0,0 +1,689 @@
+/* llmk_vocab.c — Tokenizer built from a GGUF file's embedded vocabulary
+ *
+ * See llmk_vocab.h. Unity-included by soma_inference.c and the host runtime,
+ * before llmk_tokenizer.c.
+ */
+
+#include "llmk_vocab.h"
+
+/* ── Small freestanding helpers ────────────────────────────────────────── */
+
+static int vocab_strlen(const char *s) {
+    int n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+/* piece (NUL-terminated) equals the n bytes at s */
+static int vocab_eq(const char *piece, const char *s, int n) {
+    for (int i = 0; i < n; i++) {
+        if (piece[i] != s[i]) return 0;
+    }
+    return piece[n] == 0;
+}
+
+static uint32_t vocab_hash(const char *s, int n) {
+    uint32_t h = 2166136261u;                               /* FNV-1a */
+    for (int i = 0; i < n; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t vocab_pair_hash(uint32_t l, uint32_t r) {
+    uint32_t h = l * 0x9E3779B1u ^ (r + 0x7F4A7C15u) * 0x85EBCA77u;
+    return h ^ (h >> 15);
+}
+
+/* Bytes in the UTF-8 sequence led by c (llama.cpp's unicode_len_utf8) */
+static int vocab_utf8_len(uint8_t c) {
+    static const uint8_t lens[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4 };
+    return lens[c >> 4];
+}
+
+/* Code point at s[i] and its byte length; malformed input decodes to U+FFFD,
+ * one byte at a time. */
+static int vocab_cp_at(const char *s, int n, int i, uint32_t *cp) {
+    const uint8_t c = (uint8_t)s[i];
+    int len = vocab_utf8_len(c);
+    if (len == 1) {
+        *cp = (c < 0x80) ? c : 0xFFFD;
+        return 1;
+    }
+    if (i + len > n) {
+        *cp = 0xFFFD;
+        return 1;
+    }
+    uint32_t v = c & (0x7Fu >> len);
+    for (int k = 1; k < len; k++) {
+        const uint8_t cc = (uint8_t)s[i + k];
+        if ((cc & 0xC0) != 0x80) {
+            *cp = 0xFFFD;
+            return 1;
+        }
+        v = (v << 6) | (cc & 0x3F);
+    }
+    *cp = v;
+    return len;
+}
+
+static int vocab_put_utf8(char *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    out[0] = (char)(0xC0 | (cp >> 6));                      /* GPT-2 byte map tops out at U+0143 */
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+}
+
+/* GPT-2 bytes_to_unicode: printable bytes map to themselves, the other 68 to
+ * U+0100.. in byte order. */
+static uint32_t vocab_byte_cp(uint8_t b) {
+    if ((b >= 33 && b <= 126) || (b >= 161 && b <= 172) || b >= 174) return b;
+    if (b <= 32) return 256u + b;
+    if (b <= 160) return 256u + 33u + (uint32_t)(b - 127);
+    return 256u + 33u + 34u;                                /* 173 */
+}
+
+static int vocab_cp_byte(uint32_t cp) {
+    if ((cp >= 33 && cp <= 126) || (cp >= 161 && cp <= 172) || (cp >= 174 && cp <= 255)) return (int)cp;
+    if (cp >= 256 && cp <= 288) return (int)(cp - 256);
+    if (cp >= 289 && cp <= 322) return (int)(cp - 289 + 127);
+    if (cp == 323) return 173;
+    return -1;
+}
+
+/* ── Unicode classes (BPE pre-split) ───────────────────────────────────── */
+
+typedef struct { uint32_t lo, hi; uint8_t cls; } vocab_cp_range;
+
+/* Sorted, non-overlapping; anything past Latin-1 not listed is a letter */
+static const vocab_cp_range k_vocab_cp_ranges[] = {
+    { 0x02C2, 0x02C5, LLMK_CP_OTHER },  { 0x02D2, 0x02DF, LLMK_CP_OTHER },
+    { 0x0300, 0x036F, LLMK_CP_OTHER },  { 0x037E, 0x037E, LLMK_CP_OTHER },
+    { 0x0387, 0x0387, LLMK_CP_OTHER },  { 0x0483, 0x0489, LLMK_CP_OTHER },
+    { 0x055A, 0x055F, LLMK_CP_OTHER },  { 0x0589, 0x058A, LLMK_CP_OTHER },
+    { 0x0591, 0x05BD, LLMK_CP_OTHER },  { 0x05BE, 0x05C7, LLMK_CP_OTHER },
+    { 0x05F3, 0x05F4, LLMK_CP_OTHER },  { 0x0600, 0x061F, LLMK_CP_OTHER },
+    { 0x064B, 0x065F, LLMK_CP_OTHER },  { 0x0660, 0x0669, LLMK_CP_NUMBER },
+    { 0x066A, 0x066D, LLMK_CP_OTHER },  { 0x06D4, 0x06D4, LLMK_CP_OTHER },
+    { 0x06F0, 0x06F9, LLMK_CP_NUMBER }, { 0x07C0, 0x07C9, LLMK_CP_NUMBER },
+    { 0x0964, 0x0965, LLMK_CP_OTHER },  { 0x0966, 0x096F, LLMK_CP_NUMBER },
+    { 0x09E6, 0x09EF, LLMK_CP_NUMBER }, { 0x0A66, 0x0A6F, LLMK_CP_NUMBER },
+    { 0x0AE6, 0x0AEF, LLMK_CP_NUMBER }, { 0x0B66, 0x0B6F, LLMK_CP_NUMBER },
+    { 0x0BE6, 0x0BF2, LLMK_CP_NUMBER }, { 0x0C66, 0x0C6F, LLMK_CP_NUMBER },
+    { 0x0CE6, 0x0CEF, LLMK_CP_NUMBER }, { 0x0D66, 0x0D6F, LLMK_CP_NUMBER },
+    { 0x0E3F, 0x0E3F, LLMK_CP_OTHER },  { 0x0E50, 0x0E59, LLMK_CP_NUMBER },
+    { 0x0ED0, 0x0ED9, LLMK_CP_NUMBER }, { 0x0F20, 0x0F33, LLMK_CP_NUMBER },
+    { 0x1040, 0x1049, LLMK_CP_NUMBER }, { 0x10FB, 0x10FB, LLMK_CP_OTHER },
+    { 0x1680, 0x1680, LLMK_CP_SPACE },  { 0x17E0, 0x17E9, LLMK_CP_NUMBER },
+    { 0x1810, 0x1819, LLMK_CP_NUMBER }, { 0x2000, 0x200A, LLMK_CP_SPACE },
+    { 0x200B, 0x2027, LLMK_CP_OTHER },  { 0x2028, 0x2029, LLMK_CP_SPACE },
+    { 0x202A, 0x202E, LLMK_CP_OTHER },  { 0x202F, 0x202F, LLMK_CP_SPACE },
+    { 0x2030, 0x205E, LLMK_CP_OTHER },  { 0x205F, 0x205F, LLMK_CP_SPACE },
+    { 0x2060, 0x206F, LLMK_CP_OTHER },  { 0x2070, 0x2070, LLMK_CP_NUMBER },
+    { 0x2074, 0x2079, LLMK_CP_NUMBER }, { 0x207A, 0x207E, LLMK_CP_OTHER },
+    { 0x2080, 0x2089, LLMK_CP_NUMBER }, { 0x208A, 0x208E, LLMK_CP_OTHER },
+    { 0x20A0, 0x20FF, LLMK_CP_OTHER },  { 0x2100, 0x2101, LLMK_CP_OTHER },
+    { 0x2103, 0x2106, LLMK_CP_OTHER },  { 0x2108, 0x2109, LLMK_CP_OTHER },
+    { 0x2114, 0x2114, LLMK_CP_OTHER },  { 0x2116, 0x2118, LLMK_CP_OTHER },
+    { 0x211E, 0x2123, LLMK_CP_OTHER },  { 0x2125, 0x2125, LLMK_CP_OTHER },
+    { 0x2127, 0x2127, LLMK_CP_OTHER },  { 0x2129, 0x2129, LLMK_CP_OTHER },
+    { 0x212E, 0x212E, LLMK_CP_OTHER },  { 0x213A, 0x213B, LLMK_CP_OTHER },
+    { 0x2140, 0x2144, LLMK_CP_OTHER },  { 0x214A, 0x214D, LLMK_CP_OTHER },
+    { 0x214F, 0x214F, LLMK_CP_OTHER },  { 0x2150, 0x2182, LLMK_CP_NUMBER },
+    { 0x2185, 0x2189, LLMK_CP_NUMBER }, { 0x218A, 0x245F, LLMK_CP_OTHER },
+    { 0x2460, 0x249B, LLMK_CP_NUMBER }, { 0x249C, 0x24E9, LLMK_CP_OTHER },
+    { 0x24EA, 0x24FF, LLMK_CP_NUMBER }, { 0x2500, 0x2775, LLMK_CP_OTHER },
+    { 0x2776, 0x2793, LLMK_CP_NUMBER }, { 0x2794, 0x2BFF, LLMK_CP_OTHER },
+    { 0x2E00, 0x2E7F, LLMK_CP_OTHER },  { 0x3000, 0x3000, LLMK_CP_SPACE },
+    { 0x3001, 0x3004, LLMK_CP_OTHER },  { 0x3007, 0x3007, LLMK_CP_NUMBER },
+    { 0x3008, 0x3020, LLMK_CP_OTHER },  { 0x3021, 0x3029, LLMK_CP_NUMBER },
+    { 0x3030, 0x3030, LLMK_CP_OTHER },  { 0x3038, 0x303A, LLMK_CP_NUMBER },
+    { 0x303D, 0x303F, LLMK_CP_OTHER },  { 0x309B, 0x309C, LLMK_CP_OTHER },
+    { 0x30A0, 0x30A0, LLMK_CP_OTHER },  { 0x30FB, 0x30FB, LLMK_CP_OTHER },
+    { 0x3192, 0x3195, LLMK_CP_NUMBER }, { 0x3220, 0x3229, LLMK_CP_NUMBER },
+    { 0x3248, 0x324F, LLMK_CP_NUMBER }, { 0x3251, 0x325F, LLMK_CP_NUMBER },
+    { 0x3280, 0x3289, LLMK_CP_NUMBER }, { 0x32B1, 0x32BF, LLMK_CP_NUMBER },
+    { 0xD800, 0xF8FF, LLMK_CP_OTHER },  { 0xFE10, 0xFE19, LLMK_CP_OTHER },
+    { 0xFE30, 0xFE6B, LLMK_CP_OTHER },  { 0xFEFF, 0xFEFF, LLMK_CP_OTHER },
+    { 0xFF01, 0xFF0F, LLMK_CP_OTHER },  { 0xFF10, 0xFF19, LLMK_CP_NUMBER },
+    { 0xFF1A, 0xFF20, LLMK_CP_OTHER },  { 0xFF3B, 0xFF40, LLMK_CP_OTHER },
+    { 0xFF5B, 0xFF65, LLMK_CP_OTHER },  { 0xFFE0, 0xFFFF, LLMK_CP_OTHER },
+    { 0x1D7CE, 0x1D7FF, LLMK_CP_NUMBER }, { 0x1F000, 0x1F0FF, LLMK_CP_OTHER },
+    { 0x1F100, 0x1F10C, LLMK_CP_NUMBER }, { 0x1F10D, 0x1FAFF, LLMK_CP_OTHER },
+    { 0xE0000, 0x10FFFF, LLMK_CP_OTHER },
+};
+
+int llmk_vocab_cp_class(uint32_t cp) {
+    if (cp < 0x80) {
+        if ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z') return LLMK_CP_LETTER;
+        if (cp >= '0' && cp <= '9') return LLMK_CP_NUMBER;
+        if (cp == ' ' || (cp >= 0x09 && cp <= 0x0D)) return LLMK_CP_SPACE;
+        return LLMK_CP_OTHER;
+    }
+    if (cp < 0x100) {
+        if (cp == 0x85 || cp == 0xA0) return LLMK_CP_SPACE;
+        if (cp == 0xAA || cp == 0xB5 || cp == 0xBA) return LLMK_CP_LETTER;
+        if (cp == 0xB2 || cp == 0xB3 || cp == 0xB9 || (cp >= 0xBC && cp <= 0xBE)) return LLMK_CP_NUMBER;
+        if (cp >= 0xC0 && cp != 0xD7 && cp != 0xF7) return LLMK_CP_LETTER;
+        return LLMK_CP_OTHER;
+    }
+    int lo = 0, hi = (int)(sizeof(k_vocab_cp_ranges) / sizeof(k_vocab_cp_ranges[0])) - 1;
+    while (lo <= hi) {
+        const int mid = (lo + hi) / 2;
+        if (cp < k_vocab_cp_ranges[mid].lo) hi = mid - 1;
+        else if (cp > k_vocab_cp_ranges[mid].hi) lo = mid + 1;
+        else return k_vocab_cp_ranges[mid].cls;
+    }
+    return LLMK_CP_LETTER;
+}
+
+/* ── Index build ───────────────────────────────────────────────────────── */
+
+int llmk_vocab_find(const LlmkVocab *v, const char *s, int n) {
+    if (!v || !v->piece_slot || n <= 0) return -1;
+    uint32_t h = vocab_hash(s, n) & v->piece_mask;
+    for (;;) {
+        const int32_t id = v->piece_slot[h];
+        if (id < 0) return -1;
+        if (vocab_eq(v->piece[id], s, n)) return id;
+        h = (h + 1) & v->piece_mask;
+    }
+}
+
+static const LlmkVocabMerge *vocab_merge_find(const LlmkVocab *v, int32_t l, int32_t r) {
+    if (!v->merge_slot || l < 0 || r < 0) return 0;
+    uint32_t h = vocab_pair_hash((uint32_t)l, (uint32_t)r) & v->merge_mask;
+    for (;;) {
+        const LlmkVocabMerge *m = &v->merge_slot[h];
+        if (m->left == 0xFFFFFFFFu) return 0;
+        if (m->left == (uint32_t)l && m->right == (uint32_t)r) return m;
+        h = (h + 1) & v->merge_mask;
+    }
+}
+
+static void *vocab_carve(uint8_t **p, uint8_t *end, uint64_t bytes) {
+    uint8_t *q = (uint8_t *)(((uintptr_t)*p + 7u) & ~(uintptr_t)7u);
+    if (q > end || (uint64_t)(end - q) < bytes) return 0;
+    *p = q + bytes;
+    return q;
+}
+
+static int vocab_is_special_type(int32_t t) {
+    return t == LLMK_TOKTYPE_CONTROL || t == LLMK_TOKTYPE_USER_DEFINED || t == LLMK_TOKTYPE_UNKNOWN;
+}
+
+int llmk_vocab_build(LlmkVocab *v) {
+    if (!v || !v->piece || v->n_tokens <= 0 || !v->table_mem) return LLMK_VOCAB_ERR_PARAM;
+    if (v->kind != LLMK_VOCAB_SPM && v->kind != LLMK_VOCAB_BPE) return LLMK_VOCAB_ERR_PARAM;
+    if (v->kind == LLMK_VOCAB_BPE && v->n_merges > 0 && !v->merge) return LLMK_VOCAB_ERR_PARAM;
+
+    const uint32_t piece_cap = llmk_vocab_pow2_at_least(2ULL * (uint64_t)v->n_tokens);
+    const uint32_t merge_cap = llmk_vocab_pow2_at_least(2ULL * (uint64_t)v->n_merges);
+    uint8_t *p = (uint8_t *)v->table_mem, *end = p + v->table_bytes;
+    v->piece_slot = (int32_t *)vocab_carve(&p, end, (uint64_t)piece_cap * sizeof(int32_t));
+    v->merge_slot = (LlmkVocabMerge *)vocab_carve(&p, end, (uint64_t)merge_cap * sizeof(LlmkVocabMerge));
+    v->special = (int32_t *)vocab_carve(&p, end, (uint64_t)v->n_tokens * sizeof(int32_t));
+    v->sym = (int32_t *)vocab_carve(&p, end, 4ULL * LLMK_VOCAB_MAX_SYMBOLS * sizeof(int32_t));
+    v->text = (char *)vocab_carve(&p, end, 3ULL * LLMK_VOCAB_MAX_SYMBOLS + 4);
+    if (!v->piece_slot || !v->merge_slot || !v->special || !v->sym || !v->text) return LLMK_VOCAB_ERR_MEM;
+    v->piece_mask = piece_cap - 1;
+    v->merge_mask = merge_cap - 1;
+
+    /* piece → id; a repeated text keeps the last id, like llama.cpp's map */
+    for (uint32_t i = 0; i < piece_cap; i++) v->piece_slot[i] = -1;
+    for (int id = 0; id < v->n_tokens; id++) {
+        const char *s = v->piece[id];
+        if (!s || !s[0]) continue;
+        const int n = vocab_strlen(s);
+        uint32_t h = vocab_hash(s, n) & v->piece_mask;
+        while (v->piece_slot[h] >= 0 && !vocab_eq(v->piece[v->piece_slot[h]], s, n)) h = (h + 1) & v->piece_mask;
+        v->piece_slot[h] = id;
+    }
+
+    /* (left, right) → rank, result; the first (lowest-rank) rule wins */
+    for (uint32_t i = 0; i < merge_cap; i++) v->merge_slot[i].left = 0xFFFFFFFFu;
+    for (int r = 0; r < v->n_merges; r++) {
+        const char *m = v->merge[r];
+        if (!m || !m[0]) continue;
+        int sp = 1;
+        while (m[sp] && m[sp] != ' ') sp++;
+        if (!m[sp]) continue;
+        const int n_left = sp, n_right = vocab_strlen(m + sp + 1);
+        if (n_left + n_right > 3 * LLMK_VOCAB_MAX_SYMBOLS) continue;
+        const int l = llmk_vocab_find(v, m, n_left);
+        const int rr = llmk_vocab_find(v, m + sp + 1, n_right);
+        for (int k = 0; k < n_left; k++) v->text[k] = m[k];
+        for (int k = 0; k < n_right; k++) v->text[n_left + k] = m[sp + 1 + k];
+        const int res = llmk_vocab_find(v, v->text, n_left + n_right);
+        if (l < 0 || rr < 0 || res < 0) continue;
+        uint32_t h = vocab_pair_hash((uint32_t)l, (uint32_t)rr) & v->merge_mask;
+        while (v->merge_slot[h].left != 0xFFFFFFFFu &&
+               !(v->merge_slot[h].left == (uint32_t)l && v->merge_slot[h].right == (uint32_t)rr)) {
+            h = (h + 1) & v->merge_mask;
+        }
+        if (v->merge_slot[h].left != 0xFFFFFFFFu) continue;
+        v->merge_slot[h].left = (uint32_t)l;
+        v->merge_slot[h].right = (uint32_t)rr;
+        v->merge_slot[h].rank = r;
+        v->merge_slot[h].id = res;
+    }
+
+    /* control / user-defined tokens, longest text first (shell sort) */
+    v->n_special = 0;
+    for (int b = 0; b < 32; b++) v->special_first[b] = 0;
+    if (v->type) {
+        for (int id = 0; id < v->n_tokens; id++) {
+            if (!vocab_is_special_type(v->type[id]) || !v->piece[id] || !v->piece[id][0]) continue;
+            const uint8_t c0 = (uint8_t)v->piece[id][0];
+            v->special[v->n_special++] = id;
+            v->special_first[c0 >> 3] |= (uint8_t)(1u << (c0 & 7));
+        }
+    }
+    for (int gap = v->n_special / 2; gap > 0; gap /= 2) {
+        for (int i = gap; i < v->n_special; i++) {
+            const int32_t id = v->special[i];
+            const int len = vocab_strlen(v->piece[id]);
+            int j = i;
+            while (j >= gap && vocab_strlen(v->piece[v->special[j - gap]]) < len) {
+                v->special[j] = v->special[j - gap];
+                j -= gap;
+            }
+            v->special[j] = id;
+        }
+    }
+
+    /* single-byte tokens */
+    static const char hex[] = "0123456789ABCDEF";
+    for (int b = 0; b < 256; b++) {
+        char buf[8];
+        int n = 0;
+        if (v->kind == LLMK_VOCAB_SPM) {
+            buf[0] = '<'; buf[1] = '0'; buf[2] = 'x'; buf[3] = hex[b >> 4]; buf[4] = hex[b & 15]; buf[5] = '>';
+            n = 6;
+        } else {
+            n = vocab_put_utf8(buf, vocab_byte_cp((uint8_t)b));
+        }
+        v->byte_id[b] = llmk_vocab_find(v, buf, n);
+    }
+
+    /* end-of-turn: the GGUF key, else the usual chat-template names */
+    if (v->eot_id < 0 || v->eot_id >= v->n_tokens) {
+        static const char *const eot_names[] = { "<|im_end|>", "<end_of_turn>", "<|end|>", "<|eot_id|>", "<|endoftext|>" };
+        v->eot_id = -1;
+        for (unsigned k = 0; k < sizeof(eot_names) / sizeof(eot_names[0]) && v->eot_id < 0; k++) {
+            const int id = llmk_vocab_find(v, eot_names[k], vocab_strlen(eot_names[k]));
+            if (id >= 0 && id != v->bos_id) v->eot_id = id;
+        }
+    }
+    if (v->bos_id >= v->n_tokens) v->bos_id = -1;
+    if (v->eos_id >= v->n_tokens) v->eos_id = -1;
+    if (v->unk_id >= v->n_tokens) v->unk_id = -1;
+    return LLMK_VOCAB_OK;
+}
+
+int llmk_vocab_is_stop(const LlmkVocab *v, int id) {
+    return id >= 0 && (id == v->eos_id || id == v->eot_id);
+}
+
+/* ── Encoder ───────────────────────────────────────────────────────────── */
+
+typedef struct {
+    int *ids;
+    int  n, max;
+} vocab_out;
+
+static void vocab_emit(vocab_out *o, int id) {
+    if (id >= 0 && o->n < o->max) o->ids[o->n++] = id;
+}
+
+/* SPM over one escaped chunk in v->text[0..n): symbols are UTF-8 characters,
+ * the adjacent pair forming the highest-scoring piece merges first (leftmost
+ * on ties), leftovers fall back to byte tokens. */
+#define SPM_START(i) sym[4 * (i) + 0]
+#define SPM_LEN(i)   sym[4 * (i) + 1]
+#define SPM_NEXT(i)  sym[4 * (i) + 2]
+#define SPM_PAIR(i)  sym[4 * (i) + 3]
+
+static int32_t vocab_spm_pair(const LlmkVocab *v, const int32_t *sym, int i) {
+    const int j = SPM_NEXT(i);
+    return (j < 0) ? -1 : llmk_vocab_find(v, v->text + SPM_START(i), SPM_LEN(i) + SPM_LEN(j));
+}
+
+static void vocab_spm_chunk(const LlmkVocab *v, int n, vocab_out *o) {
+    int32_t *sym = v->sym;
+    const char *t = v->text;
+    int n_sym = 0;
+    for (int i = 0; i < n && n_sym < LLMK_VOCAB_MAX_SYMBOLS;) {
+        int len = vocab_utf8_len((uint8_t)t[i]);
+        if (len > n - i) len = n - i;
+        SPM_START(n_sym) = i;
+        SPM_LEN(n_sym) = len;
+        SPM_NEXT(n_sym) = n_sym + 1;
+        n_sym++;
+        i += len;
+    }
+    if (n_sym == 0) return;
+    SPM_NEXT(n_sym - 1) = -1;
+    for (int i = 0; i < n_sym; i++) SPM_PAIR(i) = vocab_spm_pair(v, sym, i);
+
+    for (;;) {
+        int best = -1, best_prev = -1, prev = -1;
+        float best_score = 0.0f;
+        for (int i = 0; i >= 0; prev = i, i = SPM_NEXT(i)) {
+            const int32_t id = SPM_PAIR(i);
+            if (id < 0) continue;
+            const float sc = v->score ? v->score[id] : 0.0f;
+            if (best < 0 || sc > best_score) {
+                best = i;
+                best_prev = prev;
+                best_score = sc;
+            }
+        }
+        if (best < 0) break;
+        const int j = SPM_NEXT(best);
+        SPM_LEN(best) += SPM_LEN(j);
+        SPM_NEXT(best) = SPM_NEXT(j);
+        SPM_PAIR(best) = vocab_spm_pair(v, sym, best);
+        if (best_prev >= 0) SPM_PAIR(best_prev) = vocab_spm_pair(v, sym, best_prev);
+    }
+
+    for (int i = 0; i >= 0; i = SPM_NEXT(i)) {
+        const int id = llmk_vocab_find(v, t + SPM_START(i), SPM_LEN(i));
+        if (id >= 0) {
+            vocab_emit(o, id);
+            continue;
+        }
+        for (int k = 0; k < SPM_LEN(i); k++) {
+            const int b = v->byte_id[(uint8_t)t[SPM_START(i) + k]];
+            vocab_emit(o, b >= 0 ? b : v->unk_id);
+        }
+    }
+}
+
+/* Raw text between special tokens: spaces become "▁", the first chunk gets
+ * the "▁" prefix when asked, and long input is cut before a space so each
+ * chunk fits the scratch. */
+static void vocab_spm_fragment(const LlmkVocab *v, const char *s, int n, int prefix, vocab_out *o) {
+    int i = 0;
+    while (i < n && o->n < o->max) {
+        int end = n;
+        if (end - i > LLMK_VOCAB_MAX_SYMBOLS - 1) {
+            end = i + LLMK_VOCAB_MAX_SYMBOLS - 1;
+            int cut = end;
+            while (cut > i + 1 && s[cut] != ' ') cut--;
+            if (cut > i + 1) {
+                end = cut;
+            } else {
+                while (end > i + 1 && ((uint8_t)s[end] & 0xC0) == 0x80) end--;
+            }
+        }
+        int m = 0;
+        if (prefix && i == 0 && v->add_space_prefix) {
+            v->text[m++] = (char)0xE2; v->text[m++] = (char)0x96; v->text[m++] = (char)0x81;
+        }
+        for (int k = i; k < end; k++) {
+            if (s[k] == ' ') {
+                v->text[m++] = (char)0xE2; v->text[m++] = (char)0x96; v->text[m++] = (char)0x81;
+            } else {
+                v->text[m++] = s[k];
+            }
+        }
+        vocab_spm_chunk(v, m, o);
+        i = end;
+    }
+}
+
+/* BPE over one pre-split word (raw bytes): one symbol per byte, the
+ * lowest-rank merge applies first (leftmost on ties). */
+#define BPE_ID(i)    sym[4 * (i) + 0]
+#define BPE_NEXT(i)  sym[4 * (i) + 1]
+#define BPE_RANK(i)  sym[4 * (i) + 2]
+#define BPE_RES(i)   sym[4 * (i) + 3]
+
+static void vocab_bpe_pair(const LlmkVocab *v, int32_t *sym, int i) {
+    const int j = BPE_NEXT(i);
+    const LlmkVocabMerge *m = (j < 0) ? 0 : vocab_merge_find(v, BPE_ID(i), BPE_ID(j));
+    BPE_RANK(i) = m ? m->rank : -1;
+    BPE_RES(i) = m ? m->id : -1;
+}
+
+static void vocab_bpe_word(const LlmkVocab *v, const char *s, int n, vocab_out *o) {
+    int32_t *sym = v->sym;
+    if (n > LLMK_VOCAB_MAX_SYMBOLS) {
+        vocab_bpe_word(v, s, LLMK_VOCAB_MAX_SYMBOLS, o);
+        vocab_bpe_word(v, s + LLMK_VOCAB_MAX_SYMBOLS, n - LLMK_VOCAB_MAX_SYMBOLS, o);
+        return;
+    }
+    if (v->pre == LLMK_VOCAB_PRE_LLAMA3) {
+        /* llama3 sets ignore_merges: a word that is already a token stays whole */
+        int m = 0;
+        for (int i = 0; i < n; i++) m += vocab_put_utf8(v->text + m, vocab_byte_cp((uint8_t)s[i]));
+        const int id = (m <= 3 * LLMK_VOCAB_MAX_SYMBOLS) ? llmk_vocab_find(v, v->text, m) : -1;
+        if (id >= 0) {
+            vocab_emit(o, id);
+            return;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        BPE_ID(i) = v->byte_id[(uint8_t)s[i]];
+        BPE_NEXT(i) = (i + 1 < n) ? i + 1 : -1;
+    }
+    for (int i = 0; i < n; i++) vocab_bpe_pair(v, sym, i);
+
+    for (;;) {
+        int best = -1, best_prev = -1, prev = -1;
+        for (int i = 0; i >= 0; prev = i, i = BPE_NEXT(i)) {
+            if (BPE_RANK(i) < 0) continue;
+            if (best < 0 || BPE_RANK(i) < BPE_RANK(best)) {
+                best = i;
+                best_prev = prev;
+            }
+        }
+        if (best < 0) break;
+        const int j = BPE_NEXT(best);
+        BPE_ID(best) = BPE_RES(best);
+        BPE_NEXT(best) = BPE_NEXT(j);
+        vocab_bpe_pair(v, sym, best);
+        if (best_prev >= 0) vocab_bpe_pair(v, sym, best_prev);
+    }
+    for (int i = 0; i >= 0; i = BPE_NEXT(i)) vocab_emit(o, BPE_ID(i) >= 0 ? BPE_ID(i) : v->unk_id);
+}
+
+/* ── BPE pre-split (regex alternatives hand-coded, as llama.cpp does) ──── */
+
+static int vocab_cls_at(const char *s, int n, int i, int *len) {
+    uint32_t cp = 0;
+    *len = 0;
+    if (i >= n) return -1;
+    *len = vocab_cp_at(s, n, i, &cp);
+    return llmk_vocab_cp_class(cp);
+}
+
+static int vocab_run(const char *s, int n, int i, int cls) {
+    int len = 0;
+    while (i < n && vocab_cls_at(s, n, i, &len) == cls) i += len;
+    return i;
+}
+
+static int vocab_is_nl(const char *s, int n, int i) {
+    return i < n && (s[i] == '\r' || s[i] == '\n');
+}
+
+static int vocab_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+/* 's 't 're 've 'm 'll 'd at s[i]; returns the match length or 0 */
+static int vocab_contraction(const char *s, int n, int i, int any_case) {
+    if (s[i] != '\'' || i + 1 >= n) return 0;
+    const char a = any_case ? (char)vocab_lower(s[i + 1]) : s[i + 1];
+    const char b = (i + 2 < n) ? (any_case ? (char)vocab_lower(s[i + 2]) : s[i + 2]) : 0;
+    if (a == 's' || a == 't' || a == 'm' || a == 'd') return 2;
+    if ((a == 'r' && b == 'e') || (a == 'v' && b == 'e') || (a == 'l' && b == 'l')) return 3;
+    return 0;
+}
+
+/* Whitespace run at i: \s+(?!\S) keeps the last character for the next word */
+static int vocab_space_word(const char *s, int n, int i) {
+    int len = 0, e = i, last = i;
+    while (e < n && vocab_cls_at(s, n, e, &len) == LLMK_CP_SPACE) {
+        last = e;
+        e += len;
+    }
+    if (e == n || last == i) return e;
+    return last;
+}
+
+/* End of the word starting at s[i] */
+static int vocab_pre_next(const LlmkVocab *v, const char *s, int n, int i) {
+    int len = 0, len2 = 0;
+    const int c = vocab_cls_at(s, n, i, &len);
+
+    if (v->pre == LLMK_VOCAB_PRE_GPT2) {
+        /* 's|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+ */
+        const int k = vocab_contraction(s, n, i, 0);
+        if (k) return i + k;
+        const int j = (s[i] == ' ') ? i + 1 : i;
+        const int cj = vocab_cls_at(s, n, j, &len2);
+        if (cj == LLMK_CP_LETTER || cj == LLMK_CP_NUMBER) return vocab_run(s, n, j, cj);
+        if (cj == LLMK_CP_OTHER) return vocab_run(s, n, j, LLMK_CP_OTHER);
+        return vocab_space_word(s, n, i);
+    }
+
+    /* (?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}{1,3}|
+     *  ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+   (qwen2: \p{N}) */
+    const int k = vocab_contraction(s, n, i, 1);
+    if (k) return i + k;
+    if (c == LLMK_CP_LETTER) return vocab_run(s, n, i, LLMK_CP_LETTER);
+    if (c != LLMK_CP_NUMBER && !vocab_is_nl(s, n, i) && vocab_cls_at(s, n, i + len, &len2) == LLMK_CP_LETTER) {
+        return vocab_run(s, n, i + len, LLMK_CP_LETTER);
+    }
+    if (c == LLMK_CP_NUMBER) {
+        const int max_digits = (v->pre == LLMK_VOCAB_PRE_QWEN2) ? 1 : 3;
+        int e = i;
+        for (int d = 0; d < max_digits && vocab_cls_at(s, n, e, &len2) == LLMK_CP_NUMBER; d++) e += len2;
+        return e;
+    }
+    const int j = (s[i] == ' ') ? i + 1 : i;
+    if (vocab_cls_at(s, n, j, &len2) == LLMK_CP_OTHER) {
+        int e = vocab_run(s, n, j, LLMK_CP_OTHER);
+        while (vocab_is_nl(s, n, e)) e++;
+        return e;
+    }
+    /* c is whitespace here: \s*[\r\n]+ ends after the run's last newline */
+    int e = i, last_nl = -1;
+    while (e < n && vocab_cls_at(s, n, e, &len2) == LLMK_CP_SPACE) {
+        if (vocab_is_nl(s, n, e)) last_nl = e;
+        e += len2;
+    }
+    if (last_nl >= 0) return last_nl + 1;
+    return vocab_space_word(s, n, i);
+}
+
+static void vocab_bpe_fragment(const LlmkVocab *v, const char *s, int n, vocab_out *o) {
+    for (int i = 0; i < n && o->n < o->max;) {
+        int e = vocab_pre_next(v, s, n, i);
+        if (e <= i) e = i + 1;
+        vocab_bpe_word(v, s + i, e - i, o);
+        i = e;
+    }
+}
+
+/* Longest special token starting at s[i], or -1 */
+static int vocab_special_at(const LlmkVocab *v, const char *s, int n, int i, int *len) {
+    const uint8_t c0 = (uint8_t)s[i];
+    if (!(v->special_first[c0 >> 3] & (1u << (c0 & 7)))) return -1;
+    for (int k = 0; k < v->n_special; k++) {
+        const char *p = v->piece[v->special[k]];
+        int m = 0;
+        while (p[m] && i + m < n && p[m] == s[i + m]) m++;
+        if (!p[m]) {
+            *len = m;
+            return v->special[k];
+        }
+    }
+    return -1;
+}
+
+int llmk_vocab_encode(const LlmkVocab *v, const char *text, int n, int add_bos, int *ids, int max_ids) {
+    vocab_out o = { ids, 0, max_ids };
+    if (!v || !v->piece_slot || !text || !ids || max_ids <= 0) return 0;
+    if (add_bos && v->add_bos && v->bos_id >= 0) vocab_emit(&o, v->bos_id);
+
+    int start = 0, prev_special = 1;
+    for (int i = 0; i <= n && o.n < o.max;) {
+        int sp_len = 0;
+        const int sp = (i < n) ? vocab_special_at(v, text, n, i, &sp_len) : -1;
+        if (i < n && sp < 0) {
+            i++;
+            continue;
+        }
+        if (i > start) {
+            if (v->kind == LLMK_VOCAB_SPM) vocab_spm_fragment(v, text + start, i - start, prev_special, &o);
+            else vocab_bpe_fragment(v, text + start, i - start, &o);
+            prev_special = 0;
+        }
+        if (i == n) break;
+        vocab_emit(&o, sp);
+        prev_special = 1;
+        i += sp_len;
+        start = i;
+    }
+    return o.n;
+}
+
+/* ── Decoder ───────────────────────────────────────────────────────────── */
+
+static int vocab_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int llmk_vocab_decode(const LlmkVocab *v, int id, char *out, int cap) {
+    if (!v || id < 0 || id >= v->n_tokens || !v->piece[id] || !out || cap <= 0) return 0;
+    const int32_t type = v->type ? v->type[id] : LLMK_TOKTYPE_NORMAL;
+    if (type == LLMK_TOKTYPE_CONTROL) return 0;
+    const char *p = v->piece[id];
+    const int n = vocab_strlen(p);
+    int w = 0;
+
+    if (v->kind == LLMK_VOCAB_SPM) {
+        if ((type == LLMK_TOKTYPE_BYTE || !v->type) && n == 6 && p[0] == '<' && p[1] == '0' && p[2] == 'x' &&
+            p[5] == '>' && vocab_hex(p[3]) >= 0 && vocab_hex(p[4]) >= 0) {
+            out[0] = (char)((vocab_hex(p[3]) << 4) | vocab_hex(p[4]));
+            return 1;
+        }
+        for (int i = 0; i < n && w < cap;) {
+            if (i + 2 < n && (uint8_t)p[i] == 0xE2 && (uint8_t)p[i + 1] == 0x96 && (uint8_t)p[i + 2] == 0x81) {
+                out[w++] = ' ';
+                i += 3;
+            } else {
+                out[w++] = p[i++];
+            }
+        }
+        return w;
+    }
+
+    if (type == LLMK_TOKTYPE_USER_DEFINED) {
+        for (; w < n && w < cap; w++) out[w] = p[w];
+        return w;
+    }
+    for (int i = 0; i < n && w < cap;) {
+        uint32_t cp = 0;
+        const int len = vocab_cp_at(p, n, i, &cp);
+        const int b = vocab_cp_byte(cp);
+        if (b >= 0) {
+            out[w++] = (char)b;
+        } else {
+            for (int k = 0; k < len && w < cap; k++) out[w++] = p[i + k];
+        }
+        i += len;
+    }
+    return w;
+}
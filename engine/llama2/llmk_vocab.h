@@ -0,0 +1,135 @@
+/* llmk_vocab.h — Tokenizer built from a GGUF file's embedded vocabulary
+ *
+ * GGUF models carry their tokenizer in metadata (tokenizer.ggml.tokens,
+ * scores, token_type, merges, bos/eos ids). gguf_infer.c reads those arrays
+ * into one arena (llmk_gguf_vocab_bytes / llmk_gguf_load_vocab); this module
+ * indexes them and encodes/decodes text the way llama.cpp does:
+ *
+ *   SPM   tokenizer.ggml.model "llama" (llama, mistral, gemma, phi3):
+ *         spaces → "▁", optional "▁" prefix, then repeatedly merge the
+ *         adjacent pair whose concatenation is the highest-scoring piece;
+ *         characters not in the vocabulary fall back to <0xNN> byte tokens.
+ *   BPE   tokenizer.ggml.model "gpt2" (qwen2, llama3): regex pre-split
+ *         (tokenizer.ggml.pre: GPT-2, llama3 or qwen2 pattern), bytes mapped
+ *         to GPT-2's printable alphabet, then merges applied by rank.
+ *
+ * Control and user-defined tokens (<|im_start|>, <end_of_turn>, ...) are
+ * matched literally in the input before either algorithm runs, so chat
+ * templates produce the special ids.
+ *
+ * Lookups go through open-addressing hash tables: piece text → id and
+ * (left id, right id) → merge rank / result id. The tables and the encoder's
+ * symbol scratch live in the tail of the same arena (llmk_vocab_table_bytes).
+ *
+ * Unicode classes for the BPE pre-split are range approximations: ASCII and
+ * Latin-1 are exact, common digit, space, punctuation and symbol blocks are
+ * listed, every other code point counts as a letter.
+ *
+ * Freestanding C11 — no libc, no malloc.
+ */
+#pragma once
+#ifndef LLMK_VOCAB_H
+#define LLMK_VOCAB_H
+
+#include <stdint.h>
+
+#define LLMK_VOCAB_SPM  1               /* SentencePiece (score-driven merges, byte fallback) */
+#define LLMK_VOCAB_BPE  2               /* GPT-2 byte-level BPE (ranked merges) */
+
+#define LLMK_VOCAB_PRE_GPT2    0        /* 's|'t|... | ?\p{L}+| ?\p{N}+|... */
+#define LLMK_VOCAB_PRE_LLAMA3  1        /* case-insensitive contractions, \p{N}{1,3} */
+#define LLMK_VOCAB_PRE_QWEN2   2        /* as llama3 with single digits */
+
+/* tokenizer.ggml.token_type values (llama.cpp / sentencepiece) */
+#define LLMK_TOKTYPE_NORMAL        1
+#define LLMK_TOKTYPE_UNKNOWN       2
+#define LLMK_TOKTYPE_CONTROL       3
+#define LLMK_TOKTYPE_USER_DEFINED  4
+#define LLMK_TOKTYPE_UNUSED        5
+#define LLMK_TOKTYPE_BYTE          6
+
+#define LLMK_VOCAB_MAX_SYMBOLS  4096    /* encoder scratch: bytes per SPM chunk / BPE word */
+
+#define LLMK_VOCAB_OK         0
+#define LLMK_VOCAB_ERR_PARAM  -1
+#define LLMK_VOCAB_ERR_MEM    -2
+
+typedef struct {
+    uint32_t left, right;               /* token ids; left == UINT32_MAX marks an empty slot */
+    int32_t  rank;                      /* position in tokenizer.ggml.merges */
+    int32_t  id;                        /* token id of left + right */
+} LlmkVocabMerge;
+
+typedef struct LlmkVocab {
+    int      kind;                      /* LLMK_VOCAB_SPM / LLMK_VOCAB_BPE; 0 = not loaded */
+    int      pre;                       /* LLMK_VOCAB_PRE_* (BPE only) */
+    int      n_tokens;
+    char   **piece;                     /* NUL-terminated token texts */
+    float   *score;                     /* SPM merge priority; NULL when absent */
+    int32_t *type;                      /* LLMK_TOKTYPE_*; NULL = all normal */
+    int      n_merges;
+    char   **merge;                     /* "left right", in rank order (BPE) */
+    int      bos_id, eos_id, eot_id, unk_id;   /* -1 when absent */
+    int      add_bos;
+    int      add_space_prefix;          /* SPM: "▁" before the first word */
+
+    /* llmk_vocab_build() fills the rest inside table_mem */
+    void    *table_mem;
+    uint64_t table_bytes;
+    int32_t *piece_slot;                /* [piece_mask + 1] token id or -1 */
+    uint32_t piece_mask;
+    LlmkVocabMerge *merge_slot;         /* [merge_mask + 1] */
+    uint32_t merge_mask;
+    int32_t *special;                   /* control / user-defined ids, longest text first */
+    int      n_special;
+    uint8_t  special_first[32];         /* bitset of the specials' first bytes */
+    int32_t  byte_id[256];              /* SPM <0xNN> / BPE single-byte piece; -1 if absent */
+    int32_t *sym;                       /* [4 * LLMK_VOCAB_MAX_SYMBOLS] encoder scratch */
+    char    *text;                      /* [3 * LLMK_VOCAB_MAX_SYMBOLS + 4] escaped SPM chunk */
+} LlmkVocab;
+
+static inline uint32_t llmk_vocab_pow2_at_least(uint64_t n) {
+    uint32_t c = 16;
+    while ((uint64_t)c < n) c <<= 1;
+    return c;
+}
+
+/* Arena tail llmk_vocab_build() needs for n_tokens pieces and n_merges merges */
+static inline uint64_t llmk_vocab_table_bytes(int n_tokens, int n_merges) {
+    uint64_t b = 0;
+    b += (uint64_t)llmk_vocab_pow2_at_least(2ULL * (uint64_t)n_tokens) * sizeof(int32_t);
+    b += (uint64_t)llmk_vocab_pow2_at_least(2ULL * (uint64_t)n_merges) * sizeof(LlmkVocabMerge);
+    b += (uint64_t)n_tokens * sizeof(int32_t);                        /* special */
+    b += 4ULL * LLMK_VOCAB_MAX_SYMBOLS * sizeof(int32_t);             /* sym */
+    b += 3ULL * LLMK_VOCAB_MAX_SYMBOLS + 4;                           /* text */
+    return b + 64;                                                    /* alignment */
+}
+
+/* Indexes the arrays already in v (piece, score, type, merge, ids) using
+ * v->table_mem / v->table_bytes. Merges whose halves or result are not in
+ * the vocabulary are dropped, as llama.cpp does. */
+int  llmk_vocab_build(LlmkVocab *v);
+
+/* Token id of the n-byte text s, or -1 */
+int  llmk_vocab_find(const LlmkVocab *v, const char *s, int n);
+
+/* Encodes n bytes of text (special tokens parsed) into ids[0..max_ids).
+ * Prepends BOS when add_bos is set and the vocabulary wants one. Returns the
+ * number of ids written; stops early when ids is full. */
+int  llmk_vocab_encode(const LlmkVocab *v, const char *text, int n, int add_bos, int *ids, int max_ids);
+
+/* Bytes of token id as it appears in text (control tokens decode to
+ * nothing). Returns the byte count written to out (≤ cap). */
+int  llmk_vocab_decode(const LlmkVocab *v, int id, char *out, int cap);
+
+/* 1 for EOS, EOT and other end-of-generation control tokens */
+int  llmk_vocab_is_stop(const LlmkVocab *v, int id);
+
+/* Unicode class used by the BPE pre-split */
+#define LLMK_CP_OTHER   0
+#define LLMK_CP_LETTER  1
+#define LLMK_CP_NUMBER  2
+#define LLMK_CP_SPACE   3
+int  llmk_vocab_cp_class(uint32_t cp);
+
+#endif /* LLMK_VOCAB_H */
@@ -0,0 +1,274 @@
+/* oo_hud_blit.c — Cached back buffer, SIMD spans and dirty-tile present for the HUD
+ *
+ * See oo_hud_blit.h. Unity-included by oo_hud_final.c; builds on the host
+ * for tests/test_oo_hud_blit.c.
+ */
+
+#include "oo_hud_blit.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <immintrin.h>
+#define OHB_X86 1
+#endif
+
+static int _ohb_avx2 = 0;
+
+void ohb_set_cpu(int has_avx2) { _ohb_avx2 = has_avx2 ? 1 : 0; }
+
+/* ─── Scalar reference (also the tails) ───────────────────────────────── */
+static inline uint32_t _ohb_blend1(uint32_t d, uint32_t col, uint32_t a) {
+    uint32_t inv = 255u - a;
+    uint32_t r = (((col >> 16) & 0xFFu) * a + ((d >> 16) & 0xFFu) * inv) / 255u;
+    uint32_t g = (((col >>  8) & 0xFFu) * a + ((d >>  8) & 0xFFu) * inv) / 255u;
+    uint32_t b = (((col      ) & 0xFFu) * a + ((d      ) & 0xFFu) * inv) / 255u;
+    return (r << 16) | (g << 8) | b;
+}
+
+static inline uint32_t _ohb_dim1(uint32_t p, uint32_t sub) {
+    uint32_t out = 0;
+    for (int sh = 0; sh < 24; sh += 8) {
+        uint32_t c = (p >> sh) & 0xFFu, s = (sub >> sh) & 0xFFu;
+        out |= (c > s ? c - s : 0u) << sh;
+    }
+    return out;
+}
+
+#ifdef OHB_X86
+/* t / 255 for t ≤ 65535 is (t · 0x8081) >> 23: mulhi gives >> 16, then >> 7 */
+static inline __m128i _ohb_div255_sse2(__m128i t) {
+    return _mm_srli_epi16(_mm_mulhi_epu16(t, _mm_set1_epi16((short)0x8081)), 7);
+}
+
+__attribute__((target("avx2")))
+static void _ohb_fill_avx2(uint32_t *dst, uint32_t col, int n) {
+    __m256i v = _mm256_set1_epi32((int)col);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i *)(dst + i), v);
+    for (; i < n; i++) dst[i] = col;
+}
+
+__attribute__((target("avx2")))
+static void _ohb_blend_avx2(uint32_t *dst, uint32_t col, uint32_t alpha, int n) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i inv  = _mm256_set1_epi16((short)(255u - alpha));
+    const __m256i k    = _mm256_set1_epi16((short)0x8081);
+    const __m256i mask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i ca   = _mm256_mullo_epi16(
+        _mm256_unpacklo_epi8(_mm256_set1_epi32((int)(col & 0x00FFFFFFu)), zero),
+        _mm256_set1_epi16((short)alpha));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i d  = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv), ca);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv), ca);
+        lo = _mm256_srli_epi16(_mm256_mulhi_epu16(lo, k), 7);
+        hi = _mm256_srli_epi16(_mm256_mulhi_epu16(hi, k), 7);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(_mm256_packus_epi16(lo, hi), mask));
+    }
+    for (; i < n; i++) dst[i] = _ohb_blend1(dst[i], col, alpha);
+}
+
+__attribute__((target("avx2")))
+static void _ohb_dim_avx2(uint32_t *dst, uint32_t sub, int n) {
+    const __m256i vs   = _mm256_set1_epi32((int)(sub & 0x00FFFFFFu));
+    const __m256i mask = _mm256_set1_epi32(0x00FFFFFF);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(_mm256_subs_epu8(d, vs), mask));
+    }
+    for (; i < n; i++) dst[i] = _ohb_dim1(dst[i], sub);
+}
+#endif
+
+/* ─── Spans ───────────────────────────────────────────────────────────── */
+void ohb_fill_span(uint32_t *dst, uint32_t col, int n) {
+    int i = 0;
+#ifdef OHB_X86
+    if (_ohb_avx2) { _ohb_fill_avx2(dst, col, n); return; }
+    __m128i v = _mm_set1_epi32((int)col);
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i *)(dst + i), v);
+#endif
+    for (; i < n; i++) dst[i] = col;
+}
+
+void ohb_blend_span(uint32_t *dst, uint32_t col, uint32_t alpha, int n) {
+    if (alpha > 255u) alpha = 255u;
+    int i = 0;
+#ifdef OHB_X86
+    if (_ohb_avx2) { _ohb_blend_avx2(dst, col, alpha, n); return; }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i inv  = _mm_set1_epi16((short)(255u - alpha));
+    const __m128i mask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i ca   = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)(col & 0x00FFFFFFu)), zero),
+                                         _mm_set1_epi16((short)alpha));
+    for (; i + 4 <= n; i += 4) {
+        __m128i d  = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), ca);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), ca);
+        __m128i px = _mm_packus_epi16(_ohb_div255_sse2(lo), _ohb_div255_sse2(hi));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(px, mask));
+    }
+#endif
+    for (; i < n; i++) dst[i] = _ohb_blend1(dst[i], col, alpha);
+}
+
+void ohb_dim_span(uint32_t *dst, uint32_t sub, int n) {
+    int i = 0;
+#ifdef OHB_X86
+    if (_ohb_avx2) { _ohb_dim_avx2(dst, sub, n); return; }
+    const __m128i vs   = _mm_set1_epi32((int)(sub & 0x00FFFFFFu));
+    const __m128i mask = _mm_set1_epi32(0x00FFFFFF);
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(_mm_subs_epu8(d, vs), mask));
+    }
+#endif
+    for (; i < n; i++) dst[i] = _ohb_dim1(dst[i], sub);
+}
+
+void ohb_stream_span(volatile uint32_t *dst, const uint32_t *src, int n) {
+    int i = 0;
+#ifdef OHB_X86
+    uint32_t *d = (uint32_t *)(uintptr_t)dst;
+    for (; i < n && ((uintptr_t)(d + i) & 15u); i++) _mm_stream_si32((int *)(d + i), (int)src[i]);
+    for (; i + 4 <= n; i += 4)
+        _mm_stream_si128((__m128i *)(d + i), _mm_loadu_si128((const __m128i *)(src + i)));
+    for (; i < n; i++) _mm_stream_si32((int *)(d + i), (int)src[i]);
+#else
+    for (; i < n; i++) dst[i] = src[i];
+#endif
+}
+
+void ohb_stream_fence(void) {
+#ifdef OHB_X86
+    _mm_sfence();
+#endif
+}
+
+/* ─── Surface ─────────────────────────────────────────────────────────── */
+uint64_t ohb_surface_bytes(uint32_t w, uint32_t h) {
+    if (w == 0 || h == 0 || w > OHB_MAX_W || h > OHB_MAX_H) return 0;
+    return (uint64_t)w * h * 4u * 2u;
+}
+
+int ohb_surface_init(OhbSurface *s, void *mem, uint64_t bytes, uint32_t w, uint32_t h) {
+    if (!s || !mem) return -1;
+    uint64_t need = ohb_surface_bytes(w, h);
+    if (need == 0 || bytes < need) return -1;
+    s->back    = (uint32_t *)mem;
+    s->shadow  = s->back + (uint64_t)w * h;
+    s->w = w;  s->h = h;
+    s->tiles_x = (w + OHB_TILE_W - 1) / OHB_TILE_W;
+    s->tiles_y = (h + OHB_TILE_H - 1) / OHB_TILE_H;
+    s->n_rects = 0;
+    s->frames = 0;  s->tiles_dirty = 0;  s->px_pushed = 0;
+    for (uint32_t y = 0; y < h; y++) ohb_fill_span(s->back + (uint64_t)y * w, 0u, (int)w);
+    s->full = 1;
+    return 0;
+}
+
+void ohb_invalidate(OhbSurface *s) { if (s) s->full = 1; }
+
+/* 1 if the tile differs from the shadow; the tile is then copied over */
+static int _ohb_tile_sync(OhbSurface *s, uint32_t x0, uint32_t y0, uint32_t tw, uint32_t th) {
+    int diff = s->full;
+    for (uint32_t y = y0; y < y0 + th && !diff; y++) {
+        const uint32_t *b  = s->back   + (uint64_t)y * s->w + x0;
+        const uint32_t *sh = s->shadow + (uint64_t)y * s->w + x0;
+        uint32_t i = 0;
+#ifdef OHB_X86
+        for (; i + 4 <= tw; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(b + i)),
+                                         _mm_loadu_si128((const __m128i *)(sh + i)));
+            if (_mm_movemask_epi8(eq) != 0xFFFF) { diff = 1; break; }
+        }
+#endif
+        for (; i < tw && !diff; i++) diff = b[i] != sh[i];
+    }
+    if (!diff) return 0;
+    for (uint32_t y = y0; y < y0 + th; y++) {
+        const uint32_t *b = s->back + (uint64_t)y * s->w + x0;
+        uint32_t *sh = s->shadow + (uint64_t)y * s->w + x0;
+        uint32_t i = 0;
+#ifdef OHB_X86
+        for (; i + 4 <= tw; i += 4)
+            _mm_storeu_si128((__m128i *)(sh + i), _mm_loadu_si128((const __m128i *)(b + i)));
+#endif
+        for (; i < tw; i++) sh[i] = b[i];
+    }
+    return 1;
+}
+
+int ohb_collect_dirty(OhbSurface *s) {
+    if (!s || !s->back) return 0;
+    s->n_rects = 0;
+    int overflow = 0;
+    uint32_t bx0 = s->tiles_x, by0 = s->tiles_y, bx1 = 0, by1 = 0, n_dirty = 0;
+
+    for (uint32_t ty = 0; ty < s->tiles_y; ty++) {
+        uint32_t y0 = ty * OHB_TILE_H;
+        uint32_t th = s->h - y0 < OHB_TILE_H ? s->h - y0 : OHB_TILE_H;
+        uint8_t *row = s->dirty + ty * s->tiles_x;
+        for (uint32_t tx = 0; tx < s->tiles_x; tx++) {
+            uint32_t x0 = tx * OHB_TILE_W;
+            uint32_t tw = s->w - x0 < OHB_TILE_W ? s->w - x0 : OHB_TILE_W;
+            row[tx] = (uint8_t)_ohb_tile_sync(s, x0, y0, tw, th);
+            if (!row[tx]) continue;
+            n_dirty++;
+            if (tx < bx0) bx0 = tx;
+            if (tx + 1 > bx1) bx1 = tx + 1;
+            if (ty < by0) by0 = ty;
+            by1 = ty + 1;
+        }
+
+        /* Horizontal runs; stack onto a rectangle ending just above */
+        for (uint32_t tx = 0; tx < s->tiles_x && !overflow; ) {
+            if (!row[tx]) { tx++; continue; }
+            uint32_t t0 = tx;
+            while (tx < s->tiles_x && row[tx]) tx++;
+            int32_t x = (int32_t)(t0 * OHB_TILE_W);
+            int32_t w = (int32_t)((tx * OHB_TILE_W < s->w ? tx * OHB_TILE_W : s->w) - (uint32_t)x);
+            int merged = 0;
+            for (int k = s->n_rects - 1; k >= 0; k--) {    /* ≤ OHB_MAX_RECTS */
+                OhbRect *r = &s->rects[k];
+                if (r->x == x && r->w == w && r->y + r->h == (int32_t)y0) {
+                    r->h += (int32_t)th;
+                    merged = 1;
+                    break;
+                }
+            }
+            if (merged) continue;
+            if (s->n_rects == OHB_MAX_RECTS) { overflow = 1; break; }
+            OhbRect *r = &s->rects[s->n_rects++];
+            r->x = x;  r->y = (int32_t)y0;  r->w = w;  r->h = (int32_t)th;
+        }
+    }
+
+    if (overflow) {
+        /* Too fragmented: one bounding rectangle */
+        OhbRect *r = &s->rects[0];
+        r->x = (int32_t)(bx0 * OHB_TILE_W);
+        r->y = (int32_t)(by0 * OHB_TILE_H);
+        r->w = (int32_t)((bx1 * OHB_TILE_W < s->w ? bx1 * OHB_TILE_W : s->w) - (uint32_t)r->x);
+        r->h = (int32_t)((by1 * OHB_TILE_H < s->h ? by1 * OHB_TILE_H : s->h) - (uint32_t)r->y);
+        s->n_rects = 1;
+    }
+    s->full = 0;
+    s->frames++;
+    s->tiles_dirty += n_dirty;
+    return s->n_rects;
+}
+
+void ohb_present_fb(OhbSurface *s, volatile uint32_t *fb, uint32_t fb_stride) {
+    if (!s || !fb) return;
+    for (int k = 0; k < s->n_rects; k++) {
+        const OhbRect *r = &s->rects[k];
+        for (int32_t y = r->y; y < r->y + r->h; y++)
+            ohb_stream_span(fb + (uint64_t)y * fb_stride + (uint32_t)r->x,
+                            s->shadow + (uint64_t)y * s->w + (uint32_t)r->x, r->w);
+        s->px_pushed += (uint64_t)r->w * (uint64_t)r->h;
+    }
+    ohb_stream_fence();
+}
@@ -0,0 +1,82 @@
+/* oo_hud_blit.h — Cached back buffer, SIMD spans and dirty-tile present for the HUD
+ *
+ * The GOP framebuffer is uncached / write-combining: every read in a blend
+ * stalls and every scattered write is a partial bus transaction. The HUD
+ * therefore draws into an ordinary cached back buffer and only pushes the
+ * pixels that changed:
+ *
+ *   draw  → back[]            (spans: SSE2, AVX2 when enabled)
+ *   diff  → back[] vs shadow[] per OHB_TILE_W × OHB_TILE_H tile
+ *   merge → dirty tiles into rectangles (horizontal runs, then equal runs
+ *           stacked vertically)
+ *   push  → one copy per rectangle: non-temporal 16-byte stores straight
+ *           into a BGRX framebuffer, or GOP Blt (caller) for other formats
+ *
+ * shadow[] holds what the screen shows, so a frame that redraws a widget
+ * with identical pixels costs a cached compare and no framebuffer traffic.
+ *
+ * Span blends are exact: (c·a + d·(255−a)) / 255 per channel, the X byte
+ * cleared — the same integers as the scalar px_blend / tint_rect they
+ * replace.
+ *
+ * Freestanding C11 — no libc, no malloc. Memory comes from the caller.
+ */
+#pragma once
+#ifndef OO_HUD_BLIT_H
+#define OO_HUD_BLIT_H
+
+#include <stdint.h>
+
+#define OHB_TILE_W       64      /* 256 bytes: 16 SSE2 lanes per tile row */
+#define OHB_TILE_H       16
+#define OHB_MAX_W        4096
+#define OHB_MAX_H        2304
+#define OHB_MAX_TILES    ((OHB_MAX_W / OHB_TILE_W) * (OHB_MAX_H / OHB_TILE_H))
+#define OHB_MAX_RECTS    256
+
+typedef struct { int32_t x, y, w, h; } OhbRect;
+
+typedef struct {
+    uint32_t *back;                    /* [h][w] what the HUD draws into */
+    uint32_t *shadow;                  /* [h][w] what the screen shows   */
+    uint32_t  w, h;                    /* stride == w                    */
+    uint32_t  tiles_x, tiles_y;
+    int       full;                    /* next diff marks every tile     */
+    uint8_t   dirty[OHB_MAX_TILES];
+    OhbRect   rects[OHB_MAX_RECTS];
+    int       n_rects;
+
+    /* Stats (cumulative) */
+    uint32_t  frames;
+    uint64_t  tiles_dirty;
+    uint64_t  px_pushed;
+} OhbSurface;
+
+/* Use AVX2 for span fill / blend / dim (call once after CPUID) */
+void     ohb_set_cpu(int has_avx2);
+
+/* Spans on cached memory */
+void     ohb_fill_span(uint32_t *dst, uint32_t col, int n);
+void     ohb_blend_span(uint32_t *dst, uint32_t col, uint32_t alpha, int n);
+void     ohb_dim_span(uint32_t *dst, uint32_t sub, int n);  /* saturating, per channel */
+
+/* Copy n pixels into uncached / WC memory with non-temporal stores.
+ * Call ohb_stream_fence() once after the last copy of a frame. */
+void     ohb_stream_span(volatile uint32_t *dst, const uint32_t *src, int n);
+void     ohb_stream_fence(void);
+
+/* Back + shadow buffers for a w × h surface (0 = too large) */
+uint64_t ohb_surface_bytes(uint32_t w, uint32_t h);
+int      ohb_surface_init(OhbSurface *s, void *mem, uint64_t bytes, uint32_t w, uint32_t h);
+
+/* Screen contents unknown (mode switch, TUI drew over it): push everything next frame */
+void     ohb_invalidate(OhbSurface *s);
+
+/* Diff back against shadow, copy changed tiles into shadow and build
+ * s->rects. Returns the number of rectangles. */
+int      ohb_collect_dirty(OhbSurface *s);
+
+/* Stream s->rects into a 32-bit framebuffer with fb_stride pixels per row */
+void     ohb_present_fb(OhbSurface *s, volatile uint32_t *fb, uint32_t fb_stride);
+
+#endif /* OO_HUD_BLIT_H */
@@ -8,12 +8,23 @@
 #include <efilib.h>
 #include <stdint.h>
 #include "oo_soma_bridge.h"
+#include "oo_hud_blit.h"
+#include "oo_hud_blit.c"
 
 /* ── Display globals ────────────────────────────────────────────── */
-// These will be mapped to the actual GOP variables in llmk_oo_on_step_gop
-static volatile UINT32 *g_fb;
+// g_fb is the cached back buffer once soma_hud_attach() succeeded (stride
+// == width), otherwise the GOP framebuffer itself (see soma_hud_frame)
+static UINT32 *g_fb;
 static UINT32  g_sw, g_sh, g_stride;
 
+static OhbSurface g_hud_surf;
+static int        g_hud_bb = 0;            /* 1 = drawing into g_hud_surf.back */
+static struct {
+    UINT32 frames;
+    UINT64 render_cycles, present_cycles;  /* cumulative TSC */
+    UINT64 last_render, last_present;
+} g_hud_stats;
+
 /* ── Coordinate helpers (per-mille 0-1000 → pixels) ─────────────── */
 #define W(pm) ((INT32)((UINT32)(g_sw) * (UINT32)(pm) / 1000u))
 #define H(pm) ((INT32)((UINT32)(g_sh) * (UINT32)(pm) / 1000u))
@@ -199,8 +210,7 @@ static void hline(INT32 x, INT32 y, INT32 w, UINT32 col) {
     INT32 x1 = x + w;
     if (x < 0) x = 0;
     if (x1 > (INT32)g_sw) x1 = (INT32)g_sw;
-    for (INT32 i = x; i < x1; i++)
-        g_fb[(UINT32)y * g_stride + (UINT32)i] = col;
+    if (x1 > x) ohb_fill_span(g_fb + (UINT32)y * g_stride + (UINT32)x, col, x1 - x);
 }
 
 static void vline(INT32 x, INT32 y, INT32 h, UINT32 col) {
@@ -217,9 +227,9 @@ static void fill_rect(INT32 x, INT32 y, INT32 w, INT32 h, UINT32 col) {
     if (x < 0) x = 0; if (y < 0) y = 0;
     if (x1 > (INT32)g_sw) x1 = (INT32)g_sw;
     if (y1 > (INT32)g_sh) y1 = (INT32)g_sh;
+    if (x1 <= x) return;
     for (INT32 j = y; j < y1; j++)
-        for (INT32 i = x; i < x1; i++)
-            g_fb[(UINT32)j * g_stride + (UINT32)i] = col;
+        ohb_fill_span(g_fb + (UINT32)j * g_stride + (UINT32)x, col, x1 - x);
 }
 
 static void tint_rect(INT32 x, INT32 y, INT32 w, INT32 h, UINT32 tint_col, UINT32 alpha) {
@@ -227,22 +237,9 @@ static void tint_rect(INT32 x, INT32 y, INT32 w, INT32 h, UINT32 tint_col, UINT3
     if (x < 0) x = 0; if (y < 0) y = 0;
     if (x1 > (INT32)g_sw) x1 = (INT32)g_sw;
     if (y1 > (INT32)g_sh) y1 = (INT32)g_sh;
-    UINT32 inv = 255u - alpha;
-    UINT32 tr = (tint_col >> 16) & 0xFFu;
-    UINT32 tg = (tint_col >> 8) & 0xFFu;
-    UINT32 tb = tint_col & 0xFFu;
-    for (INT32 j = y; j < y1; j++) {
-        for (INT32 i = x; i < x1; i++) {
-            UINT32 bg = g_fb[(UINT32)j * g_stride + (UINT32)i];
-            UINT32 br = (bg >> 16) & 0xFFu;
-            UINT32 bg_g = (bg >> 8) & 0xFFu;
-            UINT32 bb = bg & 0xFFu;
-            UINT32 nr = (tr * alpha + br * inv) / 255u;
-            UINT32 ng = (tg * alpha + bg_g * inv) / 255u;
-            UINT32 nb = (tb * alpha + bb * inv) / 255u;
-            g_fb[(UINT32)j * g_stride + (UINT32)i] = SOMA_RGB(nr, ng, nb);
-        }
-    }
+    if (x1 <= x) return;
+    for (INT32 j = y; j < y1; j++)
+        ohb_blend_span(g_fb + (UINT32)j * g_stride + (UINT32)x, tint_col, alpha, x1 - x);
 }
 
 static void border_rect(INT32 x, INT32 y, INT32 w, INT32 h, INT32 thick, UINT32 col) {
@@ -326,16 +323,45 @@ static void soma_num_cat(char *dst, int *pos, UINT32 v) {
 }
 
 /* ── Text rendering ─────────────────────────────────────────────── */
+/* Glyph atlas: each font row pre-split into horizontal runs (at most 3 in
+ * 5 bits), so a glyph is ≤ 21 span fills instead of 35 per-pixel tests */
+static struct { UINT8 n; UINT8 x[3]; UINT8 len[3]; } g_glyph_runs[96][7];
+static int g_glyph_atlas_ready = 0;
+
+static void glyph_atlas_init(void) {
+    for (int c = 0; c < 96; c++) {
+        for (int row = 0; row < 7; row++) {
+            UINT8 bits = g_font[c][row];
+            int n = 0;
+            for (int bit = 0; bit < 5; ) {
+                if (!((bits >> (4 - bit)) & 1u)) { bit++; continue; }
+                int b0 = bit;
+                while (bit < 5 && ((bits >> (4 - bit)) & 1u)) bit++;
+                g_glyph_runs[c][row].x[n]   = (UINT8)b0;
+                g_glyph_runs[c][row].len[n] = (UINT8)(bit - b0);
+                n++;
+            }
+            g_glyph_runs[c][row].n = (UINT8)n;
+        }
+    }
+    g_glyph_atlas_ready = 1;
+}
+
 static void draw_char(INT32 x, INT32 y, char c, UINT32 color, int scale) {
     if ((unsigned char)c < 32 || (unsigned char)c > 127) c = 32;
-    const UINT8 *bmp = g_font[(unsigned char)c - 32u];
+    if (!g_glyph_atlas_ready) glyph_atlas_init();
+    unsigned gi = (unsigned char)c - 32u;
+    int inside = x >= 0 && y >= 0 &&
+                 x + 5 * scale <= (INT32)g_sw && y + 7 * scale <= (INT32)g_sh;
     for (int row = 0; row < 7; row++) {
-        for (int bit = 0; bit < 5; bit++) {
-            if ((bmp[row] >> (4 - bit)) & 1u) {
-                for (int sy = 0; sy < scale; sy++)
-                    for (int sx = 0; sx < scale; sx++)
-                        px(x + bit*scale + sx, y + row*scale + sy, color);
-            }
+        int n = g_glyph_runs[gi][row].n;
+        for (int r = 0; r < n; r++) {
+            INT32 rx = x + (INT32)g_glyph_runs[gi][row].x[r] * scale;
+            INT32 rw = (INT32)g_glyph_runs[gi][row].len[r] * scale;
+            if (!inside) { fill_rect(rx, y + row * scale, rw, scale, color); continue; }
+            UINT32 *p = g_fb + (UINT32)(y + row * scale) * g_stride + (UINT32)rx;
+            for (int sy = 0; sy < scale; sy++, p += g_stride)
+                for (INT32 i = 0; i < rw; i++) p[i] = color;
         }
     }
 }
@@ -423,7 +449,7 @@ static void render_aurora(UINT32 tick) {
 /* ── LAYER 0: Background ─────────────────────────────────────────── */
 static void render_background(UINT32 tick) {
     /* clear */
-    for (UINT32 i = 0; i < g_sh * g_stride; i++) g_fb[i] = SOMA_DEEPSPACE;
+    for (UINT32 y = 0; y < g_sh; y++) ohb_fill_span(g_fb + y * g_stride, SOMA_DEEPSPACE, (int)g_sw);
 
     render_aurora(tick);
 
@@ -453,16 +479,8 @@ static void render_background(UINT32 tick) {
     }
 
     /* CRT scanlines every 3 rows */
-    for (UINT32 y = 0; y < g_sh; y += 3) {
-        for (UINT32 x = 0; x < g_sw; x++) {
-            UINT32 p = g_fb[y * g_stride + x];
-            UINT32 r = (p>>16)&0xFFu, gg = (p>>8)&0xFFu, b = p&0xFFu;
-            r  = r  > 6u ? r  - 6u : 0u;
-            gg = gg > 6u ? gg - 6u : 0u;
-            b  = b  > 6u ? b  - 6u : 0u;
-            g_fb[y * g_stride + x] = SOMA_RGB(r, gg, b);
-        }
-    }
+    for (UINT32 y = 0; y < g_sh; y += 3)
+        ohb_dim_span(g_fb + y * g_stride, SOMA_RGB(6, 6, 6), (int)g_sw);
     (void)tick;
 }
 
@@ -533,6 +551,21 @@ static void render_vector_scope(UINT32 tick, INT32 cx, INT32 cy, INT32 r) {
     }
 }
 
+/* Double helix: two phase-opposed strands with rungs, scrolling upward */
+static void render_dna_helix(UINT32 tick, INT32 cx, INT32 y0, INT32 h) {
+    INT32 amp = H(25);
+    for (INT32 y = 0; y < h; y += 2) {
+        int ph = (int)((UINT32)y / 4u + tick / 2u) & 63;
+        INT32 xa = cx + isin(ph) * amp / 127;
+        INT32 xb = cx - isin(ph) * amp / 127;
+        UINT32 front = icos(ph) > 0 ? 220u : 90u;   /* strand nearer the viewer */
+        px_blend(xa, y0 + y, SOMA_CYAN, front);
+        px_blend(xb, y0 + y, SOMA_MAGENTA, 310u - front);
+        if ((y & 15) == 0)
+            hline(xa < xb ? xa : xb, y0 + y, xa < xb ? xb - xa : xa - xb, SOMA_CYAN_DIM);
+    }
+}
+
 static void render_lissajous(UINT32 tick, INT32 cx, INT32 cy, INT32 w, INT32 h) {
     INT32 lx = -1, ly = -1;
     for (int i = 0; i < 32; i++) {
@@ -983,7 +1016,7 @@ static void render_glitch(UINT32 tick) {
 /* ── LAYER -1: Boot Sequence ─────────────────────────────────────── */
 static void render_boot_sequence(UINT32 tick) {
     /* clear */
-    for (UINT32 i = 0; i < g_sh * g_stride; i++) g_fb[i] = SOMA_DEEPSPACE;
+    for (UINT32 y = 0; y < g_sh; y++) ohb_fill_span(g_fb + y * g_stride, SOMA_DEEPSPACE, (int)g_sw);
 
     INT32 cx = W(500) - g_plx_x;
     INT32 cy = H(380) - g_plx_y;
@@ -1074,6 +1107,65 @@ static void soma_render_frame(void) {
     g_tick++;
 }
 
+/* ── Back buffer + present ──────────────────────────────────────── */
+static inline UINT64 soma_hud_rdtsc(void) {
+    UINT32 lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((UINT64)hi << 32) | lo;
+}
+
+/* Bytes soma_hud_attach() needs for a w x h screen (0 = unsupported size) */
+static UINT64 soma_hud_backbuffer_bytes(UINT32 w, UINT32 h) {
+    return ohb_surface_bytes(w, h);
+}
+
+/* Draw into a cached back buffer from now on. mem: soma_hud_backbuffer_bytes(). */
+static int soma_hud_attach(void *mem, UINT64 bytes, UINT32 w, UINT32 h) {
+    if (ohb_surface_init(&g_hud_surf, mem, bytes, w, h) != 0) return -1;
+    g_fb = g_hud_surf.back;
+    g_sw = w;  g_sh = h;  g_stride = w;
+    g_hud_bb = 1;
+    return 0;
+}
+
+/* Something else drew on the screen: push the whole frame next time */
+static void soma_hud_invalidate(void) { ohb_invalidate(&g_hud_surf); }
+
+/* Render one frame and show it. With a back buffer only changed tiles
+ * reach the framebuffer: streamed into BGRX memory, or through GOP Blt
+ * when blt_gop is given (other pixel formats). Without one, draws in place. */
+static void soma_hud_frame(volatile UINT32 *fb, UINT32 fb_stride,
+                           EFI_GRAPHICS_OUTPUT_PROTOCOL *blt_gop) {
+    UINT64 t0 = soma_hud_rdtsc();
+    if (!g_hud_bb) { g_fb = (UINT32 *)(UINTN)fb; g_stride = fb_stride; }
+    soma_render_frame();
+    UINT64 t1 = soma_hud_rdtsc();
+    if (g_hud_bb) {
+        /* Full push once a second repairs anything drawn over the HUD */
+        if ((g_hud_stats.frames & 63u) == 0u) ohb_invalidate(&g_hud_surf);
+        int n = ohb_collect_dirty(&g_hud_surf);
+        if (blt_gop) {
+            for (int k = 0; k < n; k++) {
+                const OhbRect *r = &g_hud_surf.rects[k];
+                uefi_call_wrapper(blt_gop->Blt, 10, blt_gop,
+                                  (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)g_hud_surf.shadow,
+                                  EfiBltBufferToVideo,
+                                  (UINTN)r->x, (UINTN)r->y, (UINTN)r->x, (UINTN)r->y,
+                                  (UINTN)r->w, (UINTN)r->h, (UINTN)g_hud_surf.w * 4u);
+                g_hud_surf.px_pushed += (UINT64)r->w * (UINT64)r->h;
+            }
+        } else {
+            ohb_present_fb(&g_hud_surf, fb, fb_stride);
+        }
+    }
+    UINT64 t2 = soma_hud_rdtsc();
+    g_hud_stats.frames++;
+    g_hud_stats.last_render  = t1 - t0;
+    g_hud_stats.last_present = t2 - t1;
+    g_hud_stats.render_cycles  += t1 - t0;
+    g_hud_stats.present_cycles += t2 - t1;
+}
+
 /* ── Demo state fill (no hardware required) ──────────────────────── */
 void soma_state_demo_fill(SomaSystemState *st, uint32_t tick) {
     /* organism id */
@@ -1275,16 +1367,27 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle, EFI_SYSTEM_TABLE *SystemTable
     }
 
     /* Grab framebuffer info */
-    g_fb     = (UINT32 *)(UINTN)gop->Mode->FrameBufferBase;
+    volatile UINT32 *fb = (volatile UINT32 *)(UINTN)gop->Mode->FrameBufferBase;
+    UINT32 fb_stride = gop->Mode->Info->PixelsPerScanLine;
+    g_fb     = (UINT32 *)(UINTN)fb;
     g_sw     = gop->Mode->Info->HorizontalResolution;
     g_sh     = gop->Mode->Info->VerticalResolution;
-    g_stride = gop->Mode->Info->PixelsPerScanLine;
+    g_stride = fb_stride;
 
     if (!g_fb || g_sw == 0 || g_sh == 0) {
         Print(L"SOMA: Bad framebuffer\r\n");
         return EFI_UNSUPPORTED;
     }
 
+    /* Cached back buffer (falls back to drawing in place) */
+    UINT64 bb_bytes = soma_hud_backbuffer_bytes(g_sw, g_sh);
+    void *bb = NULL;
+    if (bb_bytes && !EFI_ERROR(uefi_call_wrapper(SystemTable->BootServices->AllocatePool, 3,
+                                                 EfiLoaderData, (UINTN)bb_bytes, &bb)) && bb)
+        soma_hud_attach(bb, bb_bytes, g_sw, g_sh);
+    EFI_GRAPHICS_OUTPUT_PROTOCOL *blt_gop =
+        gop->Mode->Info->PixelFormat == PixelBlueGreenRedReserved8BitPerColor ? NULL : gop;
+
     /* Hide text cursor */
     uefi_call_wrapper(SystemTable->ConOut->EnableCursor, 2,
                       SystemTable->ConOut, FALSE);
@@ -1304,7 +1407,7 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle, EFI_SYSTEM_TABLE *SystemTable
     while (1) {
         soma_uart_poll(&g_soma);
         soma_state_demo_fill(&g_soma, g_tick);
-        soma_render_frame();
+        soma_hud_frame(fb, fb_stride, blt_gop);
 
         /* Keyboard input */
         EFI_INPUT_KEY key;
@@ -0,0 +1,246 @@
+/* oo_tok_stream.c — Token output ring with batched UTF-8 / UCS-2 fan-out
+ *
+ * See oo_tok_stream.h. Unity-included by soma_loader.c; builds on the host
+ * for tests/test_oo_tok_stream.c.
+ */
+
+#include "oo_tok_stream.h"
+
+#define OTS_MASK (OTS_RING_BYTES - 1u)
+
+void ots_init(OtsStream *s) {
+    uint8_t *p = (uint8_t *)s;
+    for (uint64_t i = 0; i < sizeof(*s); i++) p[i] = 0;
+    ots_set_cadence(s, 256, 8, 0, 1);
+}
+
+void ots_set_cadence(OtsStream *s, uint32_t bytes, uint32_t tokens,
+                     uint64_t cycles, int newline) {
+    if (bytes > OTS_RING_BYTES) bytes = OTS_RING_BYTES;
+    s->flush_bytes = bytes;
+    s->flush_tokens = tokens;
+    s->flush_cycles = cycles;
+    s->flush_newline = newline;
+}
+
+static int ots_add_sink(OtsStream *s, uint8_t kind, OtsUtf8Fn u8, OtsUcs2Fn u16, void *ctx) {
+    if (s->n_sinks >= OTS_MAX_SINKS) return -1;
+    OtsSink *k = &s->sink[s->n_sinks];
+    k->kind = kind;
+    k->on = 1;
+    k->utf8 = u8;
+    k->ucs2 = u16;
+    k->ctx = ctx;
+    k->calls = 0;
+    k->units = 0;
+    return s->n_sinks++;
+}
+
+int ots_add_utf8_sink(OtsStream *s, OtsUtf8Fn fn, void *ctx) {
+    return fn ? ots_add_sink(s, OTS_SINK_UTF8, fn, 0, ctx) : -1;
+}
+
+int ots_add_ucs2_sink(OtsStream *s, OtsUcs2Fn fn, void *ctx) {
+    return fn ? ots_add_sink(s, OTS_SINK_UCS2, 0, fn, ctx) : -1;
+}
+
+void ots_sink_enable(OtsStream *s, int idx, int on) {
+    if (idx >= 0 && idx < s->n_sinks) s->sink[idx].on = (uint8_t)(on != 0);
+}
+
+uint32_t ots_pending(const OtsStream *s) {
+    return s->head - s->tail;
+}
+
+/* ── UTF-8 → UCS-2 ──────────────────────────────────────────────────────── */
+
+uint32_t ots_utf8_to_ucs2(const uint8_t *src, uint32_t n, int final,
+                          uint16_t *dst, uint32_t cap, uint32_t *used) {
+    uint32_t i = 0, o = 0;
+    while (i < n && o + 2 <= cap) {
+        uint8_t b0 = src[i];
+        uint32_t cp = 0xFFFD, need, k;
+
+        if (b0 < 0x80) {
+            dst[o++] = b0;
+            i++;
+            continue;
+        }
+        if ((b0 & 0xE0) == 0xC0) need = 2;
+        else if ((b0 & 0xF0) == 0xE0) need = 3;
+        else if ((b0 & 0xF8) == 0xF0) need = 4;
+        else need = 0;                       /* stray continuation / 0xF8+ */
+
+        if (need) {
+            /* Count the continuation bytes that follow */
+            for (k = 1; k < need && i + k < n && (src[i + k] & 0xC0) == 0x80; k++)
+                ;
+            if (k < need && i + k == n && !final)
+                break;                       /* split sequence: wait for the rest */
+            if (k == need) {
+                if (need == 2) {
+                    cp = ((uint32_t)(b0 & 0x1F) << 6) | (uint32_t)(src[i + 1] & 0x3F);
+                    if (cp < 0x80) cp = 0xFFFD;
+                } else if (need == 3) {
+                    cp = ((uint32_t)(b0 & 0x0F) << 12) | ((uint32_t)(src[i + 1] & 0x3F) << 6) |
+                         (uint32_t)(src[i + 2] & 0x3F);
+                    if (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)) cp = 0xFFFD;
+                } else {
+                    cp = ((uint32_t)(b0 & 0x07) << 18) | ((uint32_t)(src[i + 1] & 0x3F) << 12) |
+                         ((uint32_t)(src[i + 2] & 0x3F) << 6) | (uint32_t)(src[i + 3] & 0x3F);
+                    if (cp < 0x10000 || cp > 0x10FFFF) cp = 0xFFFD;
+                }
+                i += need;
+            } else {
+                i += 1;                      /* invalid: replace the lead byte only */
+            }
+        } else {
+            i += 1;
+        }
+
+        if (cp <= 0xFFFF) {
+            dst[o++] = (uint16_t)cp;
+        } else {
+            cp -= 0x10000;
+            dst[o++] = (uint16_t)(0xD800 + (cp >> 10));
+            dst[o++] = (uint16_t)(0xDC00 + (cp & 0x3FF));
+        }
+    }
+    *used = i;
+    return o;
+}
+
+/* ── Drain ──────────────────────────────────────────────────────────────── */
+
+static void ots_emit_utf8(OtsStream *s, const uint8_t *p, uint32_t n) {
+    for (int k = 0; k < s->n_sinks; k++) {
+        OtsSink *sk = &s->sink[k];
+        if (!sk->on || sk->kind != OTS_SINK_UTF8) continue;
+        sk->utf8(sk->ctx, p, n);
+        sk->calls++;
+        sk->units += n;
+    }
+}
+
+static void ots_emit_ucs2(OtsStream *s, uint32_t n) {
+    s->ucs[n] = 0;
+    for (int k = 0; k < s->n_sinks; k++) {
+        OtsSink *sk = &s->sink[k];
+        if (!sk->on || sk->kind != OTS_SINK_UCS2) continue;
+        sk->ucs2(sk->ctx, s->ucs, n);
+        sk->calls++;
+        sk->units += n;
+    }
+}
+
+static int ots_has_ucs2(const OtsStream *s) {
+    for (int k = 0; k < s->n_sinks; k++)
+        if (s->sink[k].on && s->sink[k].kind == OTS_SINK_UCS2) return 1;
+    return 0;
+}
+
+/* Feed bytes to the UCS-2 sinks in OTS_UCS2_CHUNK pieces. stage[] holds the
+ * carried-over partial sequence followed by new bytes. */
+static void ots_ucs2_feed(OtsStream *s, const uint8_t *p, uint32_t n, int final) {
+    uint32_t off = 0;
+    for (;;) {
+        uint32_t fill = (uint32_t)s->part_len;
+        for (int i = 0; i < s->part_len; i++) s->stage[i] = s->part[i];
+        uint32_t take = n - off;
+        if (take > OTS_UCS2_CHUNK - fill) take = OTS_UCS2_CHUNK - fill;
+        for (uint32_t i = 0; i < take; i++) s->stage[fill + i] = p[off + i];
+        fill += take;
+        off += take;
+        if (!fill) return;
+
+        int last = (off == n);
+        uint32_t used = 0;
+        uint32_t units = ots_utf8_to_ucs2(s->stage, fill, final && last,
+                                          s->ucs, OTS_UCS2_CHUNK, &used);
+        if (units) ots_emit_ucs2(s, units);
+
+        /* Only an incomplete trailing sequence (≤ 3 bytes) is left over */
+        s->part_len = (int)(fill - used);
+        for (int i = 0; i < s->part_len; i++) s->part[i] = s->stage[used + (uint32_t)i];
+        if (last) return;
+    }
+}
+
+static void ots_drain(OtsStream *s, uint64_t now, int final) {
+    uint32_t head = s->head;
+    uint32_t tail = s->tail;
+    int ucs2 = ots_has_ucs2(s);
+
+    while (tail != head) {
+        uint32_t off = tail & OTS_MASK;
+        uint32_t span = head - tail;
+        if (span > OTS_RING_BYTES - off) span = OTS_RING_BYTES - off;
+        ots_emit_utf8(s, &s->ring[off], span);
+        if (ucs2) ots_ucs2_feed(s, &s->ring[off], span, final && tail + span == head);
+        tail += span;
+    }
+    if (final && s->part_len) {
+        if (ucs2) ots_ucs2_feed(s, 0, 0, 1);
+        s->part_len = 0;
+    }
+    s->tail = tail;
+    s->tokens_pending = 0;
+    s->t_flush = now;
+    s->flushes++;
+}
+
+void ots_flush(OtsStream *s, uint64_t now) {
+    if (s->head != s->tail) ots_drain(s, now, 0);
+}
+
+void ots_finish(OtsStream *s, uint64_t now) {
+    if (s->head != s->tail || s->part_len) ots_drain(s, now, 1);
+}
+
+/* ── Producer ───────────────────────────────────────────────────────────── */
+
+int ots_write(OtsStream *s, const void *bytes, uint32_t n, uint64_t now) {
+    const uint8_t *p = (const uint8_t *)bytes;
+    int flushed = 0, newline = 0;
+
+    if (s->head == s->tail && now) s->t_flush = now;   /* time trigger runs from the first pending byte */
+    while (n) {
+        uint32_t space = OTS_RING_BYTES - (s->head - s->tail);
+        if (!space) {
+            ots_drain(s, now, 0);
+            s->full_flushes++;
+            flushed = 1;
+            continue;
+        }
+        uint32_t take = n < space ? n : space;
+        uint32_t head = s->head;
+        for (uint32_t i = 0; i < take; i++) {
+            uint8_t c = p[i];
+            newline |= (c == '\n');
+            s->ring[(head + i) & OTS_MASK] = c;
+        }
+        s->head = head + take;
+        s->bytes_in += take;
+        p += take;
+        n -= take;
+    }
+    s->tokens++;
+    s->tokens_pending++;
+
+    uint32_t pending = s->head - s->tail;
+    if (!pending) return flushed;
+    if ((s->flush_bytes && pending >= s->flush_bytes) ||
+        (s->flush_tokens && s->tokens_pending >= s->flush_tokens) ||
+        (s->flush_newline && newline) ||
+        (s->flush_cycles && now && now - s->t_flush >= s->flush_cycles)) {
+        ots_drain(s, now, 0);
+        flushed = 1;
+    }
+    return flushed;
+}
+
+int ots_poll(OtsStream *s, uint64_t now) {
+    if (s->head == s->tail || !s->flush_cycles || now - s->t_flush < s->flush_cycles) return 0;
+    ots_drain(s, now, 0);
+    return 1;
+}
@@ -0,0 +1,117 @@
+/* oo_tok_stream.h — Token output ring with batched UTF-8 / UCS-2 fan-out
+ *
+ * UEFI text output is synchronous: every ConOut->OutputString walks the
+ * console splitter, the terminal driver and (under QEMU -serial) a UART at
+ * 115200 baud before it returns. Printing each sampled token on its own
+ * therefore puts one full console round trip inside every decode step.
+ *
+ * The decode loop writes token bytes into a ring instead, and the ring is
+ * drained in large chunks at a configurable cadence:
+ *
+ *   write  → ring[]             (memcpy, no console call)
+ *   flush  when any of: pending bytes ≥ flush_bytes, tokens since the last
+ *          flush ≥ flush_tokens, TSC since the last flush ≥ flush_cycles,
+ *          a newline arrived (flush_newline), or the ring is full
+ *   drain  → UTF-8 sinks get the raw bytes (serial, log file, network);
+ *            UCS-2 sinks get NUL-terminated chunks of up to OTS_UCS2_CHUNK
+ *            code units (ConOut)
+ *
+ * UTF-8 is decoded with the same rules as uefi_print_utf8_decode (U+FFFD on
+ * invalid sequences, surrogate pairs above U+FFFF), but a sequence split
+ * across writes or flushes is carried over instead of being replaced.
+ *
+ * head is only written by the producer and tail only by the consumer, so
+ * the ring is safe for one producer and one consumer on different cores.
+ * The UEFI glue drains on the BSP: ConOut and file protocols are not MP-safe.
+ *
+ * Freestanding C11 — no libc, no malloc. The stream is caller-owned.
+ */
+#pragma once
+#ifndef OO_TOK_STREAM_H
+#define OO_TOK_STREAM_H
+
+#include <stdint.h>
+
+#define OTS_RING_BYTES   16384   /* power of two */
+#define OTS_UCS2_CHUNK   512     /* code units per UCS-2 sink call */
+#define OTS_MAX_SINKS    4
+
+#define OTS_SINK_UTF8    1
+#define OTS_SINK_UCS2    2
+
+/* bytes/units are only valid for the duration of the call */
+typedef void (*OtsUtf8Fn)(void *ctx, const uint8_t *bytes, uint32_t n);
+typedef void (*OtsUcs2Fn)(void *ctx, const uint16_t *s, uint32_t n);   /* s[n] == 0 */
+
+typedef struct {
+    uint8_t   kind;                    /* OTS_SINK_*                    */
+    uint8_t   on;
+    OtsUtf8Fn utf8;
+    OtsUcs2Fn ucs2;
+    void     *ctx;
+    uint32_t  calls;
+    uint64_t  units;                   /* bytes or code units delivered */
+} OtsSink;
+
+typedef struct {
+    uint8_t           ring[OTS_RING_BYTES];
+    volatile uint32_t head;            /* producer: bytes written (free-running) */
+    volatile uint32_t tail;            /* consumer: bytes drained */
+
+    /* Cadence (0 disables a trigger) */
+    uint32_t  flush_bytes;
+    uint32_t  flush_tokens;
+    uint64_t  flush_cycles;
+    int       flush_newline;
+
+    uint32_t  tokens_pending;
+    uint64_t  t_flush;                 /* TSC of the last flush */
+
+    /* UTF-8 → UCS-2 carry-over for sequences split across drains */
+    uint8_t   part[4];
+    int       part_len;
+    uint8_t   stage[OTS_UCS2_CHUNK];
+    uint16_t  ucs[OTS_UCS2_CHUNK + 1];
+
+    OtsSink   sink[OTS_MAX_SINKS];
+    int       n_sinks;
+
+    /* Stats (cumulative) */
+    uint64_t  bytes_in;
+    uint32_t  tokens;
+    uint32_t  flushes;
+    uint32_t  full_flushes;            /* forced because the ring was full */
+} OtsStream;
+
+/* Reset ring, sinks and stats. Default cadence: 256 B / 8 tokens / newline. */
+void     ots_init(OtsStream *s);
+void     ots_set_cadence(OtsStream *s, uint32_t bytes, uint32_t tokens,
+                         uint64_t cycles, int newline);
+
+/* Register a sink; returns its index or -1 when full */
+int      ots_add_utf8_sink(OtsStream *s, OtsUtf8Fn fn, void *ctx);
+int      ots_add_ucs2_sink(OtsStream *s, OtsUcs2Fn fn, void *ctx);
+void     ots_sink_enable(OtsStream *s, int idx, int on);
+
+/* Producer: append one token's bytes. now is the current TSC (0 disables the
+ * time trigger for this call). Returns 1 if the call flushed. */
+int      ots_write(OtsStream *s, const void *bytes, uint32_t n, uint64_t now);
+
+/* Flush if the time trigger has expired (idle loop). Returns 1 if flushed. */
+int      ots_poll(OtsStream *s, uint64_t now);
+
+/* Drain everything pending. A trailing incomplete UTF-8 sequence is kept for
+ * the next flush; ots_finish emits it as U+FFFD instead. */
+void     ots_flush(OtsStream *s, uint64_t now);
+void     ots_finish(OtsStream *s, uint64_t now);
+
+uint32_t ots_pending(const OtsStream *s);
+
+/* Decoder used by the UCS-2 drain: converts src[0..n) into dst[0..cap),
+ * leaving an incomplete sequence at the end of src unconsumed unless final.
+ * Returns code units written (never more than bytes consumed); *used = bytes
+ * consumed. */
+uint32_t ots_utf8_to_ucs2(const uint8_t *src, uint32_t n, int final,
+                          uint16_t *dst, uint32_t cap, uint32_t *used);
+
+#endif /* OO_TOK_STREAM_H */
@@ -500,7 +500,9 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle, EFI_SYSTEM_TABLE *SystemTable
 
     /* Phase WW: Voice Pipeline Loop
      * Init bridge (shared state for HUD), then start voice loop.
-     * uart_emit=1 so HUD python bridge picks up OO_VOICE: lines. */
+     * uart_emit=1 so HUD python bridge picks up OO_VOICE: lines.
+     * wakeword.okws (optional) switches the wake word to MFCC + DS-CNN,
+     * budgeted at 5% of a core; without it the energy templates stay. */
     {
         OvlConfig vcfg = {
             .hda          = &g_hda,
@@ -509,9 +511,36 @@ EFI_STATUS EFIAPI efi_main(EFI_HANDLE ImageHandle, EFI_SYSTEM_TABLE *SystemTable
             .uart_emit    = 1,          /* Emit JSON state on UART COM1 */
             .lapic_ticks_per_ms = 0     /* 0 = skip timed sleep, best-effort */
         };
+        void *kws_buf = NULL;
+        UINTN kws_len = 0;
+        EFI_STATUS kst = llmk_read_entire_file_best_effort(L"wakeword.okws", &kws_buf, &kws_len);
+        if (!EFI_ERROR(kst) && kws_buf && kws_len > 0 && kws_len < 0x10000000ULL) {
+            uint32_t arena_bytes = oww_model_arena_bytes(kws_buf, (uint32_t)kws_len);
+            void *arena = NULL;
+            if (arena_bytes &&
+                !EFI_ERROR(uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData,
+                                             (UINTN)arena_bytes, &arena)) && arena) {
+                calibrate_tsc_once();
+                oo_lora_set_cpu(llmk_has_avx2_cached());
+                vcfg.kws_model            = kws_buf;
+                vcfg.kws_model_bytes      = (uint32_t)kws_len;
+                vcfg.kws_arena            = arena;
+                vcfg.kws_arena_bytes      = arena_bytes;
+                vcfg.kws_cycles_per_frame = tsc_per_sec / 2000ULL;  /* 5% of 10 ms */
+            } else {
+                uefi_call_wrapper(BS->FreePool, 1, kws_buf);
+                if (g_boot_verbose) Print(L"[VOICE] wakeword.okws rejected (bad model)\r\n");
+            }
+        } else if (kws_buf) {
+            uefi_call_wrapper(BS->FreePool, 1, kws_buf);
+        }
         int vret = oo_voice_loop_init(&vcfg);
-        if (g_boot_verbose)
+        if (g_boot_verbose) {
             Print(L"[VOICE] Pipeline %s\r\n", vret == 0 ? L"ready" : L"failed (text-only)");
+            Print(L"[VOICE] Wake word: %s\r\n",
+                  oo_voice_loop_wakeword()->use_model ? L"MFCC + DS-CNN (wakeword.okws)"
+                                                      : L"energy templates");
+        }
     }
 
     // LLM-OO runtime: init early, then optionally hook to GOP for heartbeat.
@@ -726,6 +755,9 @@ model_selected:
     // GGUF inference support: F16/F32 and common quant types are supported by the loader.
     LlmkGgufPlan *gguf_plan = NULL;
     int use_gguf_inference = 0;
+    // RoPE: llama2.c defaults for .bin; GGUF overrides from <arch>.rope.* below.
+    LlmkRopeParams rope_params;
+    llmk_rope_defaults(&rope_params);
     int gguf_has_output_weight = 0;
 
     Config config;
@@ -759,9 +791,14 @@ model_selected:
 
                 shared_classifier = gguf_has_output_weight ? 0 : 1;
                 use_gguf_inference = 1;
+                llmk_gguf_plan_rope(gguf_plan, &rope_params);
+                llmk_gguf_plan_arch(gguf_plan, &g_llmk_arch);
                 if (g_boot_verbose) {
                     Print(L"GGUF detected: ctx=%d dim=%d layers=%d heads=%d kv_heads=%d\r\n",
                           config.seq_len, config.dim, config.n_layers, config.n_heads, config.n_kv_heads);
+                    Print(L"GGUF arch=%a act=%a qkv_bias=%d window=%d\r\n", g_llmk_arch.name,
+                          g_llmk_arch.act == LLMK_ARCH_ACT_GELU_TANH ? "gelu" : "silu",
+                          g_llmk_arch.qkv_bias, g_llmk_arch.sliding_window);
                 }
                 Print(L"OK: GGUF inference enabled (F16/F32/Q4/Q5/Q8).\r\n\r\n");
             } else {
@@ -1172,6 +1209,12 @@ gguf_fallback_done:
     // Tokenizer: pointers + scores + strings (strings size varies; reserve a safe budget)
     UINTN tokenizer_bytes = (UINTN)config.vocab_size * (sizeof(char*) + sizeof(float));
     tokenizer_bytes += 4 * 1024 * 1024; // string storage budget
+    // GGUF: the embedded vocabulary (tokenizer.ggml.*) is read into one arena
+    UINT64 gguf_vocab_bytes = 0;
+    if (use_gguf_inference && EFI_ERROR(llmk_gguf_vocab_bytes(ModelFile, config.vocab_size, &gguf_vocab_bytes))) {
+        gguf_vocab_bytes = 0;
+    }
+    tokenizer_bytes += (UINTN)gguf_vocab_bytes;
 
     UINTN slack_bytes = 16 * 1024 * 1024;
     heap_size = weights_bytes + state_bytes + tokenizer_bytes + slack_bytes;
@@ -1274,6 +1317,54 @@ gguf_fallback_done:
 
         g_llmk_ready = 1;
 
+        /* Phase F2: NeuralFS log store — mount in Zone C, replay NFSL*.LOG (best-effort).
+         * Sized to hold a full semantic recall index (emb_cap "mem.e" records);
+         * emb_cap halves while Zone C cannot fit log, slots and index. */
+        UINT32 emb_cap = SOMA_EMB_BOOT_CAP;
+        {
+            UINT32 log_bytes = 0, slots = 0;
+            for (;;) {
+                llmk_soma_emb_nfsl_size(emb_cap, &log_bytes, &slots);
+                UINT64 need = (UINT64)log_bytes + (UINT64)slots * sizeof(NfslSlot) +
+                              soma_emb_index_bytes(emb_cap) + 3u * 64u;
+                if (emb_cap <= 1024 || need <= llmk_arena_remaining_bytes(&g_zones, LLMK_ARENA_ZONE_C)) break;
+                emb_cap >>= 1;
+            }
+            void *nfsl_log = llmk_arena_alloc(&g_zones, LLMK_ARENA_ZONE_C, log_bytes, 64);
+            void *nfsl_idx = llmk_arena_alloc(&g_zones, LLMK_ARENA_ZONE_C,
+                                              (UINT64)slots * sizeof(NfslSlot), 64);
+            if (nfsl_log && nfsl_idx &&
+                nfsl_init(&g_nfsl, nfsl_log, log_bytes, nfsl_idx, slots) == NFSL_OK) {
+                g_nfsl_ready = 1;
+                int st_nfsl = g_root ? nfsl_persist_load(&g_nfsl, g_root) : NFSL_PERSIST_NOT_FOUND;
+                if (st_nfsl == NFSL_PERSIST_PARTIAL)
+                    Print(L"[NFSL] WARNING: store image exceeds %u KB log / %u slots; trailing records dropped\r\n",
+                          (unsigned)(log_bytes >> 10), (unsigned)slots);
+                if (g_boot_verbose) {
+                    Print(L"[NFSL] %s: %u keys, %u KB log (gen %u)\r\n",
+                          st_nfsl >= NFSL_PERSIST_OK ? L"replayed" : L"fresh store",
+                          (unsigned)g_nfsl.live_count, (unsigned)(g_nfsl.log_len >> 10),
+                          (unsigned)g_nfsl.generation);
+                }
+            } else if (g_boot_verbose) {
+                Print(L"[NFSL] disabled (Zone C too small)\r\n");
+            }
+        }
+
+        /* Phase H2: semantic recall index — rebuilt from NFSL "mem.e" records */
+        if (g_nfsl_ready) {
+            void *emb_mem = llmk_arena_alloc(&g_zones, LLMK_ARENA_ZONE_C, soma_emb_index_bytes(emb_cap), 64);
+            if (emb_mem && soma_emb_index_init(&g_soma_emb, emb_mem, soma_emb_index_bytes(emb_cap))) {
+                nfsl_foreach(&g_nfsl, llmk_soma_emb_rebuild_visit, 0);
+                soma_emb_index_maintain(&g_soma_emb);   // one training for the whole rebuild
+                g_soma_emb_ready = 1;
+                if (g_boot_verbose) {
+                    Print(L"[SomaEmbed] %u / %u memories indexed (%s)\r\n",
+                          g_soma_emb.n, g_soma_emb.cap, g_soma_emb.ivf_ready ? L"ivf" : L"flat");
+                }
+            }
+        }
+
         // Feed memory info (best-effort) into Compatibilion.
         compatibilion_set_memory(&g_compatibilion, (uint64_t)g_zones.zone_b_size);
 
@@ -1316,6 +1407,9 @@ gguf_fallback_done:
     weights.w3 = NULL;
     weights.rms_final_weight = NULL;
     weights.wcls = NULL;
+    weights.bq = NULL;
+    weights.bk = NULL;
+    weights.bv = NULL;
     weights.token_embedding_table_q8 = NULL;
     weights.wq_q8 = NULL;
     weights.wk_q8 = NULL;
@@ -1333,8 +1427,37 @@ gguf_fallback_done:
     weights.w1_layer_bytes = 0;
     weights.w2_layer_bytes = 0;
     weights.w3_layer_bytes = 0;
+    weights.mx = NULL;
 
     if (use_gguf_inference) {
+        // Embedded tokenizer; tokenizer.bin stays the fallback when it is missing or unusable.
+        if (gguf_vocab_bytes) {
+            void *vocab_mem = simple_alloc((unsigned long)gguf_vocab_bytes);
+            EFI_STATUS vst = vocab_mem ? llmk_gguf_load_vocab(ModelFile, config.vocab_size, vocab_mem,
+                                                              gguf_vocab_bytes, &g_llmk_vocab)
+                                       : EFI_OUT_OF_RESOURCES;
+            if (!EFI_ERROR(vst) && g_llmk_vocab.n_tokens > config.vocab_size) vst = EFI_INCOMPATIBLE_VERSION;
+            if (!EFI_ERROR(vst) && llmk_vocab_build(&g_llmk_vocab) != LLMK_VOCAB_OK) vst = EFI_BUFFER_TOO_SMALL;
+            if (EFI_ERROR(vst)) {
+                Print(L"WARN: GGUF tokenizer unusable (%r); using tokenizer.bin\r\n", vst);
+                g_llmk_vocab.kind = 0;
+            }
+        }
+
+        // QKV biases (qwen2) sit outside the weight layout, in their own weights-arena block.
+        UINT64 n_bias = llmk_gguf_plan_bias_floats(gguf_plan);
+        if (n_bias) {
+            float *bias = (float *)llmk_alloc_weights(n_bias * sizeof(float), L"qkv_bias");
+            status = bias ? llmk_gguf_load_qkv_bias(ModelFile, gguf_plan, bias, n_bias) : EFI_OUT_OF_RESOURCES;
+            if (EFI_ERROR(status)) {
+                Print(L"ERROR: Failed to load GGUF QKV biases (%r).\r\n", status);
+                return EFI_LOAD_ERROR;
+            }
+            int kv_dim = (config.dim * config.n_kv_heads) / config.n_heads;
+            weights.bq = bias;
+            weights.bk = weights.bq + (UINTN)config.n_layers * (UINTN)config.dim;
+            weights.bv = weights.bk + (UINTN)config.n_layers * (UINTN)kv_dim;
+        }
         if (use_q8_blob) {
             status = llmk_gguf_load_into_llama2_q8_0_blob(
                 ModelFile,
@@ -1603,6 +1726,7 @@ gguf_fallback_done:
     }
     
     RunState state;
+    SetMem(&state, sizeof(state), 0);
 
     int ctx_min = 64;
     int ctx_try = config.seq_len;
@@ -1648,6 +1772,27 @@ gguf_fallback_done:
         Print(L"OK: State buffers allocated\r\n\r\n");
     }
 
+    // RoPE tables for the final seq_len (after any OOM shrink above).
+    {
+        EFI_STATUS rst = llmk_rope_setup(&rope_params, &config);
+        if (EFI_ERROR(rst)) {
+            Print(L"WARNING: RoPE tables unavailable (%r); attention runs without rotation.\r\n", rst);
+        } else if (g_boot_verbose) {
+            llmk_rope_print();
+        }
+    }
+    if (EFI_ERROR(llmk_kvw_setup(&config))) {
+        Print(L"WARNING: KV window unavailable; context overflow wipes the cache.\r\n");
+        g_llmk_kvw.enabled = 0;
+    }
+    if (EFI_ERROR(llmk_rep_setup(&config))) {
+        Print(L"WARNING: repetition index unavailable; n-gram bans rescan the context.\r\n");
+        g_llmk_rep.vocab = 0;
+    }
+    if (EFI_ERROR(llmk_spec_setup(&config))) {
+        Print(L"WARNING: speculative decoding unavailable (/spec disabled).\r\n");
+    }
+
     llmk_boot_mark(L"state_alloc");
     
     // ========================================================================
@@ -1660,6 +1805,23 @@ gguf_fallback_done:
         Print(L"[6/7] Loading tokenizer...\r\n");
     }
     
+    Tokenizer tokenizer;
+    tokenizer.gguf = NULL;
+    if (g_llmk_vocab.kind) {
+        // GGUF metadata carried the vocabulary: no tokenizer.bin needed
+        tokenizer.vocab = g_llmk_vocab.piece;
+        tokenizer.vocab_scores = g_llmk_vocab.score;
+        tokenizer.vocab_size = config.vocab_size;
+        tokenizer.max_token_length = 0;
+        for (int i = 0; i < g_llmk_vocab.n_tokens; i++) {
+            int n = 0;
+            while (g_llmk_vocab.piece[i] && g_llmk_vocab.piece[i][n]) n++;
+            if (n > tokenizer.max_token_length) tokenizer.max_token_length = n;
+        }
+        tokenizer.gguf = &g_llmk_vocab;
+        goto tokenizer_ready;
+    }
+
     EFI_FILE_HANDLE TokFile;
     TokFile = NULL;
     status = llmk_open_read_with_fat83_fallback(Root, L"tokenizer.bin", &TokFile, NULL, 0, L"tokenizer");
@@ -1668,7 +1830,6 @@ gguf_fallback_done:
         return status;
     }
     
-    Tokenizer tokenizer;
     bytes_to_read = sizeof(int);
     uefi_call_wrapper(TokFile->Read, 3, TokFile, &bytes_to_read, &tokenizer.max_token_length);
     
@@ -1697,13 +1858,16 @@ gguf_fallback_done:
     
     uefi_call_wrapper(TokFile->Close, 1, TokFile);
 
+tokenizer_ready:
     // Loading finished: stop the animated overlay now.
     InterfaceFx_End();
 
     llmk_boot_mark(L"tokenizer_loaded");
+    llmk_kvw_bind_tokenizer(&tokenizer);
     
     if (g_boot_verbose) {
-        Print(L"OK: Tokenizer loaded (%d tokens)\r\n\r\n", tokenizer.vocab_size);
+        Print(L"OK: Tokenizer loaded (%d tokens%s)\r\n\r\n", tokenizer.vocab_size,
+              tokenizer.gguf ? L", GGUF metadata" : L"");
 
         llmk_boot_print_timing_summary();
 
@@ -3511,6 +3675,206 @@ snap_autoload_done:
 
                 Print(L"\r\nUsage: /attn [auto|sse2|avx2]\r\n\r\n");
                 continue;
+            } else if (my_strncmp(prompt, "/shortlist", 10) == 0) {
+                // Usage:
+                //   /shortlist               -> show
+                //   /shortlist load [file]   -> read a .lksl (default classifier.lksl)
+                //   /shortlist on|off
+                //   /shortlist k <n>         -> candidates reranked exactly per step
+                LlmkShortlist *sl = &g_llmk_shortlist;
+                int i = 10;
+                while (prompt[i] == ' ') i++;
+
+                if (my_strncmp(prompt + i, "load", 4) == 0) {
+                    CHAR16 name[64];
+                    i += 4;
+                    while (prompt[i] == ' ') i++;
+                    if (prompt[i]) ascii_to_char16(name, prompt + i, (int)(sizeof(name) / sizeof(name[0])));
+                    EFI_STATUS st = llmk_shortlist_load(prompt[i] ? name : NULL, &config, 0);
+                    if (EFI_ERROR(st)) {
+                        Print(L"\r\nERROR: shortlist load: %r\r\n\r\n", st);
+                    } else {
+                        Print(L"\r\nOK: shortlist rank=%u k=%u\r\n\r\n", sl->rank, sl->n_cand);
+                    }
+                    continue;
+                }
+                if (my_strncmp(prompt + i, "on", 2) == 0 || my_strncmp(prompt + i, "off", 3) == 0) {
+                    if (!sl->coef) {
+                        Print(L"\r\nERROR: no shortlist loaded (/shortlist load)\r\n\r\n");
+                        continue;
+                    }
+                    sl->enabled = (prompt[i + 1] == 'n');
+                    Print(L"\r\nOK: shortlist %s\r\n\r\n", sl->enabled ? L"on" : L"off");
+                    continue;
+                }
+                if (prompt[i] == 'k') {
+                    UINT32 k = 0;
+                    i++;
+                    while (prompt[i] == ' ') i++;
+                    while (prompt[i] >= '0' && prompt[i] <= '9' && k < 100000) k = k * 10U + (UINT32)(prompt[i++] - '0');
+                    if (!sl->coef || k == 0) {
+                        Print(L"\r\nUsage: /shortlist k <n> (after /shortlist load)\r\n\r\n");
+                        continue;
+                    }
+                    sl->n_cand = (k < sl->max_cand) ? k : sl->max_cand;
+                    Print(L"\r\nOK: shortlist k=%u\r\n\r\n", sl->n_cand);
+                    continue;
+                }
+                if (prompt[i] == 0) {
+                    Print(L"\r\nClassifier shortlist:\r\n");
+                    if (!sl->coef) {
+                        Print(L"  (not loaded)\r\n\r\n");
+                        continue;
+                    }
+                    Print(L"  enabled=%d rank=%u k=%u/%u\r\n", sl->enabled, sl->rank, sl->n_cand, sl->vocab);
+                    Print(L"  calls=%lu certified=%lu fallbacks=%lu\r\n\r\n", sl->calls, sl->certified, sl->fallbacks);
+                    continue;
+                }
+
+                Print(L"\r\nUsage: /shortlist [load [file]|on|off|k <n>]\r\n\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/mixq", 5) == 0) {
+                // Usage:
+                //   /mixq                -> show
+                //   /mixq load [file]    -> read a .lkmx (default model.lkmx) and use it
+                //   /mixq on|off         -> its matrices or the model's own
+                LlmkMixq *mx = &g_llmk_mixq;
+                int i = 5;
+                while (prompt[i] == ' ') i++;
+
+                if (my_strncmp(prompt + i, "load", 4) == 0) {
+                    CHAR16 name[64];
+                    i += 4;
+                    while (prompt[i] == ' ') i++;
+                    if (prompt[i]) ascii_to_char16(name, prompt + i, (int)(sizeof(name) / sizeof(name[0])));
+                    EFI_STATUS st = llmk_mixq_load(prompt[i] ? name : NULL, &config);
+                    if (EFI_ERROR(st)) {
+                        Print(L"\r\nERROR: mixq load: %r\r\n\r\n", st);
+                    } else {
+                        weights.mx = mx;
+                        Print(L"\r\nOK: mixq %lu MiB\r\n\r\n", llmk_mx_bytes(mx) >> 20);
+                    }
+                    continue;
+                }
+                if (my_strncmp(prompt + i, "on", 2) == 0 || my_strncmp(prompt + i, "off", 3) == 0) {
+                    if (!mx->n_tensors) {
+                        Print(L"\r\nERROR: no plan loaded (/mixq load)\r\n\r\n");
+                        continue;
+                    }
+                    weights.mx = (prompt[i + 1] == 'n') ? mx : NULL;
+                    Print(L"\r\nOK: mixq %s\r\n\r\n", weights.mx ? L"on" : L"off");
+                    continue;
+                }
+                if (prompt[i] == 0) {
+                    Print(L"\r\nMixed-precision plan:\r\n");
+                    if (!mx->n_tensors) {
+                        Print(L"  (not loaded)\r\n\r\n");
+                        continue;
+                    }
+                    UINT32 n_fmt[LLMK_MX_N_FMT] = { 0, 0, 0, 0 };
+                    UINT32 n = mx->shared_cls ? mx->n_tensors - 1 : mx->n_tensors;
+                    for (UINT32 t = 0; t < n; t++) n_fmt[mx->t[t].fmt]++;
+                    Print(L"  enabled=%d matrices=%u f32=%u f16=%u q8_0=%u q4_0=%u\r\n", weights.mx != NULL, n,
+                          n_fmt[LLMK_MX_F32], n_fmt[LLMK_MX_F16], n_fmt[LLMK_MX_Q8_0], n_fmt[LLMK_MX_Q4_0]);
+                    Print(L"  %lu MiB (f32 %lu MiB)\r\n\r\n", llmk_mx_bytes(mx) >> 20,
+                          llmk_mx_bytes_uniform(mx, LLMK_MX_F32) >> 20);
+                    continue;
+                }
+
+                Print(L"\r\nUsage: /mixq [load [file]|on|off]\r\n\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/grammar", 8) == 0) {
+                // Usage:
+                //   /grammar                  -> show
+                //   /grammar json             -> any JSON object
+                //   /grammar load <file>      -> GBNF grammar (start rule "root")
+                //   /grammar schema <file>    -> JSON schema
+                //   /grammar off
+                LlmkGrammarRt *rt = &g_llmk_grammar_rt;
+                int i = 8;
+                while (prompt[i] == ' ') i++;
+
+                if (my_strncmp(prompt + i, "off", 3) == 0) {
+                    g_llmk_grammar_on = 0;
+                    Print(L"\r\nOK: grammar off\r\n\r\n");
+                    continue;
+                }
+                if (my_strncmp(prompt + i, "json", 4) == 0) {
+                    const char *gbnf = llmk_grammar_json_gbnf();
+                    EFI_STATUS st = llmk_grammar_set(gbnf, (int)my_strlen(gbnf), 0, &tokenizer, &config);
+                    if (EFI_ERROR(st)) {
+                        Print(L"\r\nERROR: grammar json: %r\r\n\r\n", st);
+                    } else {
+                        Print(L"\r\nOK: grammar json (%d rules)\r\n\r\n", g_llmk_grammar.n_rules);
+                    }
+                    continue;
+                }
+                if (my_strncmp(prompt + i, "load", 4) == 0 || my_strncmp(prompt + i, "schema", 6) == 0) {
+                    int is_schema = (prompt[i] == 's');
+                    CHAR16 name[64];
+                    i += is_schema ? 6 : 4;
+                    while (prompt[i] == ' ') i++;
+                    if (!prompt[i]) {
+                        Print(L"\r\nUsage: /grammar %s <file>\r\n\r\n", is_schema ? L"schema" : L"load");
+                        continue;
+                    }
+                    ascii_to_char16(name, prompt + i, (int)(sizeof(name) / sizeof(name[0])));
+                    EFI_STATUS st = llmk_grammar_load(name, is_schema, &tokenizer, &config);
+                    if (EFI_ERROR(st)) {
+                        Print(L"\r\nERROR: grammar load: %r\r\n\r\n", st);
+                    } else {
+                        Print(L"\r\nOK: grammar %s (%d rules)\r\n\r\n", name, g_llmk_grammar.n_rules);
+                    }
+                    continue;
+                }
+                if (prompt[i] == 0) {
+                    Print(L"\r\nConstrained decoding:\r\n");
+                    if (!g_llmk_grammar_on) {
+                        Print(L"  (off)\r\n\r\n");
+                        continue;
+                    }
+                    Print(L"  rules=%d trie_nodes=%d\r\n", g_llmk_grammar.n_rules, rt->n_nodes);
+                    Print(L"  masks=%lu cache_hits=%lu nodes_visited=%lu\r\n\r\n", rt->masks, rt->cache_hits,
+                          rt->nodes_visited);
+                    continue;
+                }
+
+                Print(L"\r\nUsage: /grammar [json|off|load <file.gbnf>|schema <file.json>]\r\n\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/spec", 5) == 0) {
+                // Usage:
+                //   /spec        -> show
+                //   /spec <k>    -> draft up to k tokens per step from the context (0 = off)
+                int i = 5;
+                while (prompt[i] == ' ') i++;
+
+                if (prompt[i] >= '0' && prompt[i] <= '9') {
+                    int k = 0;
+                    while (prompt[i] >= '0' && prompt[i] <= '9' && k < 1000) k = k * 10 + (prompt[i++] - '0');
+                    if (g_llmk_spec_batch.cap <= 0) {
+                        Print(L"\r\nERROR: speculative decoding unavailable\r\n\r\n");
+                        continue;
+                    }
+                    g_llmk_spec_k = (k < LLMK_SPEC_MAX_DRAFT) ? k : LLMK_SPEC_MAX_DRAFT;
+                    Print(L"\r\nOK: spec k=%d\r\n\r\n", g_llmk_spec_k);
+                    continue;
+                }
+                if (prompt[i] == 0) {
+                    LlmkSpec *sp = &g_llmk_spec;
+                    Print(L"\r\nSpeculative decoding:\r\n");
+                    if (g_llmk_spec_batch.cap <= 0) {
+                        Print(L"  (unavailable)\r\n\r\n");
+                        continue;
+                    }
+                    Print(L"  k=%d ngram=%d..%d\r\n", g_llmk_spec_k, sp->min_ngram, sp->max_ngram);
+                    Print(L"  drafts=%lu proposed=%lu accepted=%lu", sp->drafts, sp->proposed, sp->accepted);
+                    if (sp->proposed) Print(L" (%lu%%)", (sp->accepted * 100ULL) / sp->proposed);
+                    Print(L"\r\n\r\n");
+                    continue;
+                }
+
+                Print(L"\r\nUsage: /spec [k]\r\n\r\n");
+                continue;
             } else if (my_strncmp(prompt, "/test_failsafe", 14) == 0) {
                 // One-shot: temporarily enable strict budget and set tiny budgets so the next prompt trips.
                 // Usage:
@@ -4411,15 +4775,89 @@ snap_autoload_done:
                 oit_print_status(&g_oit, (void (*)(const char *))llmk_print_ascii);
                 Print(L"\r\n");
                 continue;
+            } else if (my_strncmp(prompt, "/oo_dream", 9) == 0) {
+                /* /oo_dream [steps|status|cancel] — consolidate recent turns into the adapter */
+                int i = 9, steps = 0;
+                while (prompt[i] == ' ') i++;
+                if (my_strncmp(prompt + i, "cancel", 6) == 0) {
+                    int was = g_oit_dream.ready && oit_dream_busy(&g_oit_dream);
+                    if (was) oit_dream_cancel(&g_oit_dream);
+                    Print(L"\r\n[DREAM] %s\r\n\r\n", was ? L"cancelled, adapter restored" : L"idle");
+                    continue;
+                }
+                if (my_strncmp(prompt + i, "status", 6) == 0) {
+                    if (!g_oit_dream.ready) {
+                        Print(L"\r\n[DREAM] not started\r\n\r\n");
+                        continue;
+                    }
+                    OitDream *d = &g_oit_dream;
+                    Print(L"\r\n[DREAM] phase=%u cycles=%u accepted=%u rejected=%u steps=%d\r\n",
+                          d->phase, d->cycles, d->accepted, d->rejected, d->steps);
+                    Print(L"  pool=%d consolidate=%d replay=%d  %s\r\n", d->count, d->n_sel, d->n_held,
+                          d->par ? L"(AP shards)" : L"(inline)");
+                    if (d->phase == OIT_DREAM_DONE)
+                        Print(L"  last: nll %d.%03d -> %d.%03d, replay %d.%03d -> %d.%03d, %s, %lu Mcycles\r\n",
+                              (int)d->sel_before, (int)(d->sel_before * 1000.0f) % 1000,
+                              (int)d->sel_after, (int)(d->sel_after * 1000.0f) % 1000,
+                              (int)d->held_before, (int)(d->held_before * 1000.0f) % 1000,
+                              (int)d->held_after, (int)(d->held_after * 1000.0f) % 1000,
+                              d->last_accepted ? L"kept" : L"rolled back", d->last_cycles / 1000000ULL);
+                    Print(L"\r\n");
+                    continue;
+                }
+                while (prompt[i] >= '0' && prompt[i] <= '9' && steps < 10000) steps = steps * 10 + (prompt[i++] - '0');
+                if (g_lora.merged) {
+                    Print(L"\r\n[DREAM] adapter is merged; /lora_unmerge first\r\n\r\n");
+                    continue;
+                }
+                if (!llmk_oit_attach(&g_oit, &weights, &config, &tokenizer) ||
+                    !llmk_oit_dream_attach(&g_oit, &tokenizer)) {
+                    Print(L"\r\n[DREAM] backprop trainer unavailable (arena)\r\n\r\n");
+                    continue;
+                }
+                if (oit_dream_busy(&g_oit_dream)) {
+                    Print(L"\r\n[DREAM] cycle already running (/oo_dream status)\r\n\r\n");
+                    continue;
+                }
+                int n = llmk_oit_dream_collect(&g_oit_dream);
+                /* Budget: ~2 s of TSC at the calibrated rate, steps permitting */
+                UINT64 budget = tsc_per_sec ? tsc_per_sec * 2ULL : 0;
+                int rc = oit_dream_begin(&g_oit_dream, steps, budget);
+                if (rc != 0)
+                    Print(L"\r\n[DREAM] %d turn(s) queued; need more history to split a replay set (rc=%d)\r\n\r\n",
+                          n, rc);
+                else
+                    Print(L"\r\n[DREAM] %d turn(s) queued, %d held for replay; consolidating while idle\r\n\r\n",
+                          n, g_oit_dream.n_held);
+                continue;
             } else if (my_strncmp(prompt, "/oo_train", 9) == 0) {
                 /* Manually trigger one in-situ training cycle */
                 Print(L"\r\n[OIT] Starting in-situ training cycle...\r\n");
                 if (g_root) {
+                    /* Backprop through the model when it fits; fingerprint delta otherwise */
+                    if (g_lora.merged) {
+                        Print(L"[OIT] adapter is merged; /lora_unmerge first\r\n\r\n");
+                        continue;
+                    }
+                    if (g_oit_dream.ready && oit_dream_busy(&g_oit_dream)) {
+                        Print(L"[OIT] dream cycle running; /oo_dream cancel first\r\n\r\n");
+                        continue;
+                    }
+                    int bp = llmk_oit_attach(&g_oit, &weights, &config, &tokenizer);
                     int n = oit_train_from_jsonl(&g_oit, (void *)g_root);
                     /* Also save updated LoRA delta to NFS2 */
                     oit_lora_save(&g_oit, &g_nfs2);
                     nfs2_persist_save(&g_nfs2, g_root);
-                    Print(L"[OIT] Processed %d pairs. LoRA delta saved.\r\n\r\n", n);
+                    Print(L"[OIT] Processed %d pairs. LoRA delta saved.\r\n", n);
+                    if (bp && g_oit.par && oit_par_busy(g_oit.par))
+                        Print(L"[OIT] backprop: step running on %d AP shard(s), REPL stays live\r\n\r\n",
+                              g_oit.par->n_shards);
+                    else if (bp)
+                        Print(L"[OIT] backprop: %d layers, step %u, loss %d.%03d\r\n\r\n",
+                              g_oit_bp.n_train, g_oit_bp.steps,
+                              (int)g_oit_bp.last_loss, (int)(g_oit_bp.last_loss * 1000.0f) % 1000);
+                    else
+                        Print(L"[OIT] backprop unavailable (arena); used fingerprint delta\r\n\r\n");
                 } else {
                     Print(L"[OIT] Error: no root FS available.\r\n\r\n");
                 }
@@ -4434,8 +4872,24 @@ snap_autoload_done:
                 Print(L"  queries_routed: %u  auto_executed: %u\r\n",
                       (unsigned)g_ovr.queries_routed,
                       (unsigned)g_ovr.queries_auto_executed);
-                Print(L"  echo_intent: %s\r\n\r\n",
+                Print(L"  echo_intent: %s\r\n",
                       g_ovr.echo_intent ? L"on" : L"off");
+                {
+                    const OwwEngine *ww = oo_voice_loop_wakeword();
+                    if (ww->use_model) {
+                        const OkwsStream *ks = &ww->kws;
+                        Print(L"  wakeword: DS-CNN T=%d C=%d blocks=%d  frames=%u evals=%u detections=%u\r\n",
+                              ww->model.T, ww->model.C, ww->model.n_blocks,
+                              (unsigned)ks->frames, (unsigned)ks->evals, (unsigned)ks->detections);
+                        Print(L"  wakeword: stride=%d eval=%lu cyc (max %lu) mfcc=%lu cyc/frame budget=%lu  last=%a\r\n\r\n",
+                              ks->stride, (unsigned long)ks->eval_cycles, (unsigned long)ks->max_eval_cycles,
+                              (unsigned long)ww->mfcc_cycles, (unsigned long)ks->budget,
+                              oww_last_word(ww));
+                    } else {
+                        Print(L"  wakeword: energy templates  detections=%u\r\n\r\n",
+                              (unsigned)ww->detections);
+                    }
+                }
                 continue;
             } else if (my_strncmp(prompt, "/voice_echo ", 12) == 0) {
                 g_ovr.echo_intent = (prompt[12] == '1') ? 1 : 0;
@@ -4444,6 +4898,113 @@ snap_autoload_done:
             } else if (my_strncmp(prompt, "/smp_status", 11) == 0) {
                 oo_multicore_print(&g_oo_multicore);
                 continue;
+            } else if (my_strncmp(prompt, "/smp_workers", 12) == 0) {
+                int i = 12, n = 0;
+                while (prompt[i] == ' ') i++;
+                while (prompt[i] >= '0' && prompt[i] <= '9') n = n * 10 + (prompt[i++] - '0');
+                if (n < 0) n = 0;
+                int w = oo_mc_start_workers(&g_oo_multicore, n);
+                Print(L"\r\n[SMP] work-queue workers: %d (mwait=%d)\r\n\r\n",
+                      w, g_oo_multicore.mwait_ok);
+                continue;
+            } else if (my_strncmp(prompt, "/smp_bench", 10) == 0) {
+                int i = 10;
+                UINT32 items = 0;
+                while (prompt[i] == ' ') i++;
+                while (prompt[i] >= '0' && prompt[i] <= '9' && items < 100000000U) items = items * 10U + (UINT32)(prompt[i++] - '0');
+                if (items == 0) items = 100000;
+                if (g_oo_multicore.mc_worker_count == 0) oo_mc_start_workers(&g_oo_multicore, 0);
+                OoMcBenchResult br;
+                if (!oo_mc_bench(&g_oo_multicore, items, &br)) {
+                    Print(L"\r\n[SMP] bench needs at least one AP worker (single-core or MP services missing)\r\n\r\n");
+                    continue;
+                }
+                calibrate_tsc_once();
+                unsigned long long cyc_per_us = tsc_per_sec ? tsc_per_sec / 1000000ULL : 0;
+                Print(L"\r\n[SMP] work-queue bench: %d workers, %u items (cycles)\r\n", br.workers, br.items);
+                Print(L"  round trip: min=%lu avg=%lu\r\n", br.rt_min, br.rt_avg);
+                Print(L"  flood: %lu/item  queue avg=%lu max=%lu  stolen=%lu\r\n",
+                      br.per_item, br.queue_avg, br.queue_max, br.stolen);
+                if (cyc_per_us)
+                    Print(L"  (~%lu ns round trip, ~%lu k items/s)\r\n",
+                          br.rt_avg * 1000ULL / cyc_per_us,
+                          br.per_item ? (cyc_per_us * 1000ULL) / br.per_item : 0ULL);
+                Print(L"\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/lora_status", 12) == 0) {
+                Print(L"\r\n[LoRA] %u resident adapter(s), active=%d\r\n",
+                      g_lora_bank.n_slots, (int)g_lora_bank.active);
+                for (UINT32 i = 0; i < g_lora_bank.n_slots; i++) {
+                    Print(L" slot %u%s\r\n", i, ((INT32)i == g_lora_bank.active) ? L" *" : L"");
+                    oo_lora_print(g_lora_bank.slot[i]);
+                }
+                Print(L"\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/lora_new", 9) == 0) {
+                // /lora_new [rank] -> zero-delta adapter over all 7 projections
+                int i = 9;
+                UINT32 rank = 0;
+                while (prompt[i] == ' ') i++;
+                while (prompt[i] >= '0' && prompt[i] <= '9' && rank < 100) rank = rank * 10U + (UINT32)(prompt[i++] - '0');
+                if (rank == 0) rank = LORA_MAX_RANK;
+                UINT32 kvd = (UINT32)((config.dim * config.n_kv_heads) / config.n_heads);
+                UINT64 bytes = oo_lora_bytes((UINT32)config.n_layers, (UINT32)config.dim, kvd,
+                                             (UINT32)config.hidden_dim, rank);
+                oo_lora_state_t *st = NULL;
+                if (g_lora.n_layers == 0) st = &g_lora;   // slot 0 first
+                else if (g_lora_bank.n_slots < LORA_MAX_SLOTS)
+                    st = (oo_lora_state_t *)simple_alloc(sizeof(oo_lora_state_t));
+                void *mem = st ? simple_alloc((unsigned long)bytes) : NULL;
+                if (!mem || oo_lora_init(st, (UINT32)config.n_layers, (UINT32)config.dim, kvd,
+                                         (UINT32)config.hidden_dim, rank, mem, bytes) != 0) {
+                    Print(L"\r\n[LoRA] cannot create adapter (%lu KB, %u slots max)\r\n\r\n",
+                          bytes >> 10, (UINT32)LORA_MAX_SLOTS);
+                    continue;
+                }
+                int slot = oo_lora_bank_add(&g_lora_bank, st);
+                Print(L"\r\n[LoRA] slot %d: rank %u, %lu KB\r\n\r\n", slot, rank, bytes >> 10);
+                continue;
+            } else if (my_strncmp(prompt, "/lora_use", 9) == 0) {
+                // /lora_use <slot|off> [merge]
+                int i = 9, slot = 0, merge = 0;
+                while (prompt[i] == ' ') i++;
+                if (prompt[i] == 'o') {
+                    slot = -1;
+                    while (prompt[i] && prompt[i] != ' ') i++;
+                } else {
+                    while (prompt[i] >= '0' && prompt[i] <= '9' && slot < 100) slot = slot * 10 + (prompt[i++] - '0');
+                }
+                while (prompt[i] == ' ') i++;
+                if (my_strncmp(prompt + i, "merge", 5) == 0) merge = 1;
+                if (g_oit_dream.ready) oit_dream_cancel(&g_oit_dream);
+                if (g_oit.par) oit_par_wait(g_oit.par);   /* APs read the adapter mid-step */
+                oo_lora_model_t lm;
+                llmk_lora_model(&weights, &config, &lm);
+                if (merge && slot >= 0 && slot < (int)g_lora_bank.n_slots)
+                    llmk_lora_ensure_spill(g_lora_bank.slot[slot], &lm);
+                int rc = oo_lora_bank_select(&g_lora_bank, slot, &lm, merge);
+                Print(L"\r\n[LoRA] active=%d (%s) rc=%d\r\n\r\n", (int)g_lora_bank.active,
+                      merge ? L"merged" : L"fused", rc);
+                continue;
+            } else if (my_strncmp(prompt, "/lora_merge", 11) == 0 ||
+                       my_strncmp(prompt, "/lora_unmerge", 13) == 0) {
+                oo_lora_state_t *st = oo_lora_bank_active(&g_lora_bank);
+                if (!st) {
+                    Print(L"\r\n[LoRA] no active adapter\r\n\r\n");
+                    continue;
+                }
+                if (g_oit_dream.ready) oit_dream_cancel(&g_oit_dream);
+                if (g_oit.par) oit_par_wait(g_oit.par);
+                oo_lora_model_t lm;
+                llmk_lora_model(&weights, &config, &lm);
+                int merge = (prompt[6] == 'm');
+                if (merge) llmk_lora_ensure_spill(st, &lm);
+                unsigned long long t0 = __rdtsc();
+                int rc = merge ? oo_lora_merge(st, &lm) : oo_lora_unmerge(st, &lm);
+                Print(L"\r\n[LoRA] %s rc=%d (%lu Mcycles, q8 saturated=%u)\r\n\r\n",
+                      merge ? L"merge" : L"unmerge", rc,
+                      (__rdtsc() - t0) / 1000000ULL, st->q8_clipped);
+                continue;
             } else if (my_strncmp(prompt, "/somamind_status", 16) == 0) {
                 /* SomaMind V1 SSM + halting stats — inline Print wrapper */
                 Print(L"[SM] SomaMind V1 status:\r\n");
@@ -4590,6 +5151,83 @@ snap_autoload_done:
                 else
                     Print(L"\r\n[NFS2] Error: key %s is read-only.\r\n\r\n", k16);
                 continue;
+            } else if (my_strncmp(prompt, "/nfsl_", 6) == 0 && !g_nfsl_ready) {
+                Print(L"\r\n[NFSL] Log store not mounted.\r\n\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/nfsl_stat", 10) == 0) {
+                Print(L"\r\n[NFSL] keys=%u  log=%u/%u KB  dead=%u KB  gen=%u  compactions=%u\r\n",
+                      (unsigned)g_nfsl.live_count,
+                      (unsigned)(g_nfsl.log_len >> 10), (unsigned)(g_nfsl.log_cap >> 10),
+                      (unsigned)(g_nfsl.dead_bytes >> 10),
+                      (unsigned)g_nfsl.generation, (unsigned)g_nfsl.compactions);
+                Print(L"  index=%u/%u slots  puts=%u  dels=%u  unsaved=%u bytes\r\n\r\n",
+                      (unsigned)g_nfsl.index_used, (unsigned)g_nfsl.index_cap,
+                      (unsigned)g_nfsl.total_puts, (unsigned)g_nfsl.total_dels,
+                      (unsigned)(g_nfsl.flushed_gen == g_nfsl.generation
+                                 ? g_nfsl.log_len - g_nfsl.flushed : g_nfsl.log_len));
+                continue;
+            } else if (my_strncmp(prompt, "/nfsl_get ", 10) == 0) {
+                const char *key = prompt + 10;
+                while (*key == ' ') key++;
+                CHAR16 k16[NFS2_NAME_MAX + 2];
+                ascii_to_char16(k16, key, NFS2_NAME_MAX + 2);
+                uint32_t vlen = 0;
+                const char *val = nfsl_get_str(&g_nfsl, key, &vlen);
+                if (val) {
+                    CHAR16 v16[NFS2_DATA_MAX + 2];
+                    ascii_to_char16(v16, val, NFS2_DATA_MAX + 2);
+                    Print(L"\r\n[NFSL] %s (%u bytes) =\r\n  %s%s\r\n\r\n", k16, (unsigned)vlen,
+                          v16, vlen > NFS2_DATA_MAX ? L"..." : L"");
+                } else {
+                    Print(L"\r\n[NFSL] Key not found: %s\r\n\r\n", k16);
+                }
+                continue;
+            } else if (my_strncmp(prompt, "/nfsl_set ", 10) == 0) {
+                char *kv = (char *)(prompt + 10);
+                while (*kv == ' ') kv++;
+                char *sp = kv;
+                while (*sp && *sp != ' ') sp++;
+                if (*sp == '\0') {
+                    Print(L"\r\n[NFSL] Usage: /nfsl_set <key> <value>\r\n\r\n");
+                } else {
+                    *sp = '\0';
+                    const char *val = sp + 1;
+                    while (*val == ' ') val++;
+                    int rc = nfsl_put_str(&g_nfsl, kv, val);
+                    if (rc == NFSL_OK)
+                        Print(L"\r\n[NFSL] OK (%u keys)\r\n\r\n", (unsigned)g_nfsl.live_count);
+                    else
+                        Print(L"\r\n[NFSL] Error: %s\r\n\r\n",
+                              rc == NFSL_ERR_NOSPACE ? L"log full" :
+                              rc == NFSL_ERR_INDEX   ? L"index full" : L"bad key");
+                    *sp = ' ';
+                }
+                continue;
+            } else if (my_strncmp(prompt, "/nfsl_del ", 10) == 0) {
+                const char *key = prompt + 10;
+                while (*key == ' ') key++;
+                uint32_t klen = 0;
+                while (key[klen]) klen++;
+                int rc = nfsl_delete(&g_nfsl, key, klen);
+                Print(L"\r\n[NFSL] %s\r\n\r\n",
+                      rc == NFSL_OK ? L"Deleted." :
+                      rc == NFSL_ERR_NOTFOUND ? L"Key not found." : L"Error: log full");
+                continue;
+            } else if (my_strncmp(prompt, "/nfsl_compact", 13) == 0) {
+                UINT32 before = g_nfsl.log_len;
+                nfsl_compact(&g_nfsl);
+                int st_nfsl = g_root ? nfsl_persist_flush(&g_nfsl, g_root) : NFSL_PERSIST_IO_ERR;
+                Print(L"\r\n[NFSL] Compacted %u -> %u bytes (gen %u), segments %s.\r\n\r\n",
+                      (unsigned)before, (unsigned)g_nfsl.log_len, (unsigned)g_nfsl.generation,
+                      st_nfsl == NFSL_PERSIST_OK ? L"rewritten" : L"NOT saved");
+                continue;
+            } else if (my_strncmp(prompt, "/nfsl_save", 10) == 0) {
+                int st_nfsl = g_root ? nfsl_persist_flush(&g_nfsl, g_root) : NFSL_PERSIST_IO_ERR;
+                if (st_nfsl == NFSL_PERSIST_OK)
+                    Print(L"\r\n[NFSL] Flushed (%u bytes on disk).\r\n\r\n", (unsigned)g_nfsl.flushed);
+                else
+                    Print(L"\r\n[NFSL] Error flushing segments (err=%d).\r\n\r\n", st_nfsl);
+                continue;
             } else if (my_strncmp(prompt, "/dream_status", 13) == 0) {
                 /* Show Dreamion engine stats (AP1 activity) */
                 const char *mode_name = dreamion_mode_name_ascii(g_dreamion.mode);
@@ -4639,6 +5277,64 @@ snap_autoload_done:
                           (int)g_gop_w, (int)g_gop_h, (int)g_gop_ppsl, pf, (UINT64)(UINTN)g_gop_fb32);
                 }
                 continue;
+            } else if (my_strncmp(prompt, "/stream", 7) == 0) {
+                // /stream [on|off|ms <n>|tokens <n>|serial|log|net [0|1]]
+                int i = 7;
+                while (prompt[i] == ' ') i++;
+                const char *arg = prompt + i;
+                int v = -1;
+                { int j = i; while (prompt[j] && prompt[j] != ' ') j++; while (prompt[j] == ' ') j++;
+                  if (prompt[j] >= '0' && prompt[j] <= '9') { v = 0; while (prompt[j] >= '0' && prompt[j] <= '9' && v < 100000) v = v * 10 + (prompt[j++] - '0'); } }
+                if (my_strncmp(arg, "on", 2) == 0) g_stream_enabled = 1;
+                else if (my_strncmp(arg, "off", 3) == 0) g_stream_enabled = 0;
+                else if (my_strncmp(arg, "ms", 2) == 0 && v >= 0) g_stream_flush_ms = (UINT32)v;
+                else if (my_strncmp(arg, "tokens", 6) == 0 && v >= 0) g_stream_flush_tokens = (UINT32)v;
+                else if (my_strncmp(arg, "serial", 6) == 0) g_stream_serial = (v < 0) ? !g_stream_serial : (v != 0);
+                else if (my_strncmp(arg, "log", 3) == 0) g_stream_log = (v < 0) ? !g_stream_log : (v != 0);
+                else if (my_strncmp(arg, "net", 3) == 0) g_stream_net = (v < 0) ? !g_stream_net : (v != 0);
+                Print(L"\r\n[stream] %s  flush: %u tokens / %u ms / 256 B / newline\r\n",
+                      g_stream_enabled ? L"buffered" : L"direct (per token)",
+                      g_stream_flush_tokens, g_stream_flush_ms);
+                Print(L"  sinks: console  serial=%d  log=%d (%s)  net=%d (udp %d)\r\n",
+                      g_stream_serial, g_stream_log, LLMK_STREAM_FILE, g_stream_net, LLMK_STREAM_NET_PORT);
+                if (g_stream_ready)
+                    Print(L"  total: %lu bytes, %u tokens, %u flushes (ring full %u)\r\n",
+                          (unsigned long)g_tok_stream.bytes_in, g_tok_stream.tokens,
+                          g_tok_stream.flushes, g_tok_stream.full_flushes);
+                Print(L"\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/hud_on", 7) == 0) {
+                g_hud_enabled = 1;
+                soma_hud_invalidate();
+                Print(L"\r\n[HUD] on\r\n\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/hud_off", 8) == 0) {
+                g_hud_enabled = 0;
+                Print(L"\r\n[HUD] off\r\n\r\n");
+                continue;
+            } else if (my_strncmp(prompt, "/hud_stats", 10) == 0) {
+                UINT32 fr = g_hud_stats.frames;
+                Print(L"\r\n[HUD] %s  frames=%u  back buffer=%s  avx2=%d\r\n",
+                      g_hud_enabled ? L"on" : L"off", (unsigned)fr,
+                      g_hud_bb ? L"yes" : L"no (in place)", llmk_has_avx2_cached());
+                if (fr) {
+                    calibrate_tsc_once();
+                    UINT64 rc = g_hud_stats.render_cycles / fr, pc = g_hud_stats.present_cycles / fr;
+                    UINT64 us_div = tsc_per_sec ? tsc_per_sec / 1000000ULL : 0;
+                    Print(L"  per frame: render %lu cyc (%lu us)  present %lu cyc (%lu us)\r\n",
+                          (unsigned long)rc, (unsigned long)(us_div ? rc / us_div : 0),
+                          (unsigned long)pc, (unsigned long)(us_div ? pc / us_div : 0));
+                }
+                if (g_hud_bb && g_hud_surf.frames) {
+                    UINT64 tiles = (UINT64)g_hud_surf.tiles_x * g_hud_surf.tiles_y;
+                    UINT64 px = (UINT64)g_hud_surf.w * g_hud_surf.h;
+                    Print(L"  dirty: %lu%% of tiles, %lu%% of pixels pushed\r\n\r\n",
+                          (unsigned long)(g_hud_surf.tiles_dirty * 100ULL / (tiles * g_hud_surf.frames)),
+                          (unsigned long)(g_hud_surf.px_pushed * 100ULL / (px * g_hud_surf.frames)));
+                } else {
+                    Print(L"\r\n");
+                }
+                continue;
             } else if (my_strncmp(prompt, "/tui_on", 7) == 0) {
                 if (!g_gop_fb32) {
                     Print(L"\r\nERROR: GOP not available\r\n\r\n");
@@ -6522,6 +7218,32 @@ snap_autoload_done:
                 g_llmk_kv_pos = kv_pos;
                 Print(L"OK: KV cache cleared, context reset\r\n\r\n");
                 continue;
+            } else if (my_strncmp(prompt, "/kvwin", 6) == 0) {
+                // /kvwin [on|off|sinks N|discard N|fold on|off]
+                const char *p = prompt + 6;
+                while (*p == ' ' || *p == '\t') p++;
+                int v = 0;
+                if (my_strncmp(p, "on", 2) == 0) {
+                    g_llmk_kvw.enabled = (g_llmk_kvw.tok != 0);
+                } else if (my_strncmp(p, "off", 3) == 0) {
+                    g_llmk_kvw.enabled = 0;
+                } else if (my_strncmp(p, "sinks", 5) == 0 || my_strncmp(p, "discard", 7) == 0) {
+                    int is_sinks = (p[0] == 's');
+                    p += is_sinks ? 5 : 7;
+                    while (*p == ' ' || *p == '\t') p++;
+                    while (*p >= '0' && *p <= '9') { v = v * 10 + (*p - '0'); p++; }
+                    if (is_sinks) g_llmk_kvw.sinks = v;
+                    else g_llmk_kvw.discard = v;
+                } else if (my_strncmp(p, "fold", 4) == 0) {
+                    p += 4;
+                    while (*p == ' ' || *p == '\t') p++;
+                    g_cfg_kv_fold_memory = (my_strncmp(p, "on", 2) == 0 || *p == '1');
+                    llmk_kvw_bind_tokenizer(&tokenizer);
+                }
+                Print(L"\r\n[KV window]\r\n");
+                llmk_kvw_print();
+                Print(L"  kv_pos=%d seq_len=%d\r\n\r\n", kv_pos, config.seq_len);
+                continue;
             } else if (my_strncmp(prompt, "/version", 8) == 0) {
                 Print(L"\r\nllm-baremetal REPL v3\r\n");
                 Print(L"  build=%s\r\n", LLMB_BUILD_ID);
@@ -7518,13 +8240,24 @@ snap_autoload_done:
         encode((char *)encode_text, prompt_tokens, &n_prompt_tokens, (int)(sizeof(prompt_tokens) / sizeof(prompt_tokens[0])), &tokenizer);
 
         // Avoid injecting BOS into the middle of an ongoing conversation.
-        if (kv_pos > 0 && n_prompt_tokens > 0 && prompt_tokens[0] == TOKEN_BOS) {
+        if (kv_pos > 0 && n_prompt_tokens > 0 && prompt_tokens[0] == llmk_tok_bos(&tokenizer)) {
             for (int i = 1; i < n_prompt_tokens; i++) prompt_tokens[i - 1] = prompt_tokens[i];
             n_prompt_tokens--;
         }
         
-        // Check if KV cache will overflow
-        if (kv_pos + n_prompt_tokens + max_gen_tokens > config.seq_len) {
+        // Check if KV cache will overflow. With the KV window on, slide past
+        // the oldest rows (sinks kept) instead; decode slides as it goes.
+        int kv_slid = 0;
+        if (g_llmk_kvw.enabled && kv_pos + n_prompt_tokens + 1 > config.seq_len) {
+            int np = llmk_kvw_slide(&state, &config, kv_pos, n_prompt_tokens + 1);
+            if (np >= 0) {
+                kv_slid = kv_pos - np;
+                kv_pos = np;
+                g_llmk_kv_pos = kv_pos;
+            }
+        }
+        if (g_llmk_kvw.enabled ? (kv_pos + n_prompt_tokens + 1 > config.seq_len)
+                               : (kv_pos + n_prompt_tokens + max_gen_tokens > config.seq_len)) {
             Print(L"\r\nWARNING: context too long (%d + %d tokens), clearing KV cache\r\n", 
                   kv_pos, n_prompt_tokens + max_gen_tokens);
             reset_kv_cache(&state, &config);
@@ -7550,6 +8283,17 @@ snap_autoload_done:
             llmk_guardrails_apply_safe_caps(&temperature, &top_p, &top_k, &max_gen_tokens, 1);
         }
 
+        // Greedy needs the exact argmax: certify the shortlist top-1 or fall back.
+        g_llmk_shortlist.verify_top1 = (temperature <= 0.0f);
+
+        // Constrained decoding restarts per turn. Allowed tokens can lie outside
+        // the shortlist, so the forward passes below use the full classifier.
+        const int grammar_cls_full = g_llmk_cls_full;
+        if (g_llmk_grammar_on) {
+            llmk_grammar_rt_start(&g_llmk_grammar_rt, &g_llmk_grammar);
+            g_llmk_cls_full = 1;
+        }
+
         // M19.1: capture wall-clock start for benchmark cases.
         llmk_bench_on_turn_start();
 
@@ -7563,6 +8307,7 @@ snap_autoload_done:
         // Process prompt tokens through model first (prefill)
         for (int i = 0; i < n_prompt_tokens; i++) {
             int pos = kv_pos + i;  // Use persistent KV position
+            llmk_kvw_note(&g_llmk_kvw, pos, prompt_tokens[i]);
             if (g_llmk_ready) {
                 // Per-token prefill budgeting (pos-dependent): set budget before each forward.
                 if (g_budget_prefill_cycles == 0) {
@@ -7644,6 +8389,14 @@ snap_autoload_done:
         for (int i = 0; i < n_prompt_tokens && n_context_tokens < (int)(sizeof(context_tokens) / sizeof(context_tokens[0])); i++) {
             context_tokens[n_context_tokens++] = prompt_tokens[i];
         }
+        // Bans and penalties read an index kept in step with context_tokens;
+        // without its arena they fall back to rescanning the context.
+        const int rep_idx = (g_llmk_rep.vocab != 0);
+        if (rep_idx) {
+            llmk_rep_reset(&g_llmk_rep);
+            llmk_rep_configure(&g_llmk_rep, context_tokens, no_repeat_ngram, 0, LLMK_REP_PEN_WINDOW);
+            llmk_rep_sync(&g_llmk_rep, context_tokens, n_context_tokens);
+        }
 
         // Simple stop detection on the last bytes printed.
         char out_tail[64];
@@ -7671,36 +8424,63 @@ snap_autoload_done:
 
         { CHAR16 _gdmg[80]; SPrint(_gdmg, sizeof(_gdmg), L"[dbg] gen-loop-start max_gen=%d capture=%d\r\n", max_gen_tokens, (int)g_capture_mode); llmk_serial_write_char16(_gdmg); Print(_gdmg); }
 
+        // Token text goes through the output ring; Print()s below sync it first.
+        if (!g_capture_mode) {
+            calibrate_tsc_once();
+            llmk_stream_begin(tsc_per_sec);
+        }
+
         /* Phase SM: reset SSM hidden state at start of each generation turn */
         { extern SomaMindV1 g_somamind; sm_ssm_reset(&g_somamind.ssm); g_somamind.halt.tokens_generated = 0; g_somamind.tools.found = 0; g_somamind.tools.in_tool_tag = 0; g_somamind.tools.in_args_tag = 0; }
 
+        // Speculation: drafts come from the context, verified rows are
+        // consumed while sampling agrees with them.
+        float *logits = state.logits;
+        LlmkSpecTurn spec = {0};
+        if (g_llmk_spec_batch.cap > 0) llmk_spec_reset(&g_llmk_spec);
+
         for (int step = 0; step < max_gen_tokens; step++) {
             { CHAR16 _gds[80]; SPrint(_gds, sizeof(_gds), L"[dbg] step-enter step=%d max=%d\r\n", step, max_gen_tokens); llmk_serial_write_char16(_gds); }
             // We sample from the logits produced by the previous forward pass.
             // For step==0, logits come from the final prompt token (prefill).
 
             // Apply no-repeat ngram blocking (works on pre-softmax logits).
-            if (no_repeat_ngram > 1) {
-                apply_no_repeat_ngram(state.logits, config.vocab_size, context_tokens, n_context_tokens, no_repeat_ngram);
+            if (rep_idx) {
+                llmk_rep_ban(&g_llmk_rep, logits);
+            } else if (no_repeat_ngram > 1) {
+                apply_no_repeat_ngram(logits, config.vocab_size, context_tokens, n_context_tokens, no_repeat_ngram);
+            }
+
+            // Grammar: mask tokens that cannot follow (0 allowed = dead end).
+            if (g_llmk_grammar_on && llmk_grammar_mask(&g_llmk_grammar_rt, logits) == 0) {
+                if (!stop_reason) {
+                    stop_reason = L"grammar";
+                    stop_token = -1;
+                    stop_step = step;
+                    stop_pos = pos;
+                }
+                break;
             }
 
             // Sample next token (temperature/top_p/top_k + repetition penalty)
-            int n_recent = n_context_tokens;
-            if (n_recent > 64) n_recent = 64;
+            int n_recent = rep_idx ? 0 : n_context_tokens;
+            if (n_recent > LLMK_REP_PEN_WINDOW) n_recent = LLMK_REP_PEN_WINDOW;
             int* recent = (n_recent > 0) ? &context_tokens[n_context_tokens - n_recent] : (int*)0;
 
             // Loop escapes:
             // - if we detect a short repeating suffix, ban the sampled token and resample (budgeted).
             // - if we are stuck repeating the same token too many times, ban it once and resample.
             for (int attempt = 0; attempt < 3; attempt++) {
-                next = sample_advanced(state.logits, config.vocab_size, temperature, min_p, top_p, top_k, recent, n_recent, repeat_penalty);
-                if (next == TOKEN_EOS || next == TOKEN_BOS) break;
+                if (rep_idx) llmk_rep_penalize(&g_llmk_rep, logits, repeat_penalty, 0.0f, 0.0f);
+                next = sample_advanced(logits, config.vocab_size, temperature, min_p, top_p, top_k, recent, n_recent,
+                                       rep_idx ? 1.0f : repeat_penalty);
+                if (llmk_tok_is_stop(&tokenizer, next)) break;
 
                 // Prevent premature termination on small models that briefly get stuck repeating one token.
                 // If we've already repeated the last token 5 times and would do it again, ban it once and resample.
                 if (repeat_escape_used < 8 && next == last_token && repeat_count >= 5) {
                     repeat_escape_used++;
-                    state.logits[next] = -1.0e9f;
+                    logits[next] = -1.0e9f;
                     continue;
                 }
 
@@ -7711,15 +8491,23 @@ snap_autoload_done:
                                       has_suffix_repeat(context_tokens, n_context_tokens + 1, 16);
                     if (would_repeat) {
                         loop_escape_used++;
-                        state.logits[next] = -1.0e9f;
+                        logits[next] = -1.0e9f;
                         continue;
                     }
                 }
                 break;
             }
+
+            if (g_llmk_grammar_on) {
+                // Escapes can ban the only allowed token; never leave the grammar.
+                if (!llmk_grammar_allowed(&g_llmk_grammar_rt, next)) {
+                    next = llmk_grammar_best(&g_llmk_grammar_rt, logits);
+                }
+                llmk_grammar_accept(&g_llmk_grammar_rt, next);
+            }
             
             // Check for EOS (some exports may still emit BOS; treat both as stop)
-            if (next == TOKEN_EOS || next == TOKEN_BOS) {
+            if (llmk_tok_is_stop(&tokenizer, next)) {
                 if (!stop_reason) {
                     stop_reason = L"eos/bos";
                     stop_token = next;
@@ -7737,7 +8525,7 @@ snap_autoload_done:
                 extern SomaMindV1 g_somamind;
                 const char *sm_piece = (next >= 0 && next < config.vocab_size && tokenizer.vocab[next])
                                        ? tokenizer.vocab[next] : "";
-                SmHaltReason sm_halt = sm_tick(&g_somamind, state.logits,
+                SmHaltReason sm_halt = sm_tick(&g_somamind, logits,
                                                config.vocab_size, next, sm_piece);
                 if (sm_halt == SM_HALT_TOOL) {
                     char tool_out[256];
@@ -7777,15 +8565,10 @@ snap_autoload_done:
             }
             
             // Print token (or capture token output for /draw)
-            if (next >= 0 && next < config.vocab_size && tokenizer.vocab[next]) {
-                char* piece = tokenizer.vocab[next];
-                // Decode byte-tokens (<0xNN>) and SentencePiece spaces (▁)
-                char decoded[8];
-                int dlen = llmk_decode_piece(piece, decoded, (int)sizeof(decoded));
-                // Fallback to raw piece if decode returned nothing (e.g. empty token)
-                const char* out_bytes = (dlen > 0) ? decoded : piece;
-                int out_len = (dlen > 0) ? dlen : (int)(piece[0] ? (int)__builtin_strlen(piece) : 0);
-                if (out_len <= 0) { int sl=0; while(piece[sl]) sl++; out_len=sl; }
+            {
+                // Decode byte-tokens (<0xNN>), SentencePiece spaces (▁) and GGUF byte-level BPE
+                char out_bytes[64];
+                int out_len = llmk_tok_decode(&tokenizer, next, out_bytes, (int)sizeof(out_bytes));
                 if (out_len > 0) {
                     if (g_capture_mode) {
                         llmk_capture_append_ascii(out_bytes, out_len);
@@ -7860,6 +8643,7 @@ snap_autoload_done:
             // Append to context and apply a simple loop-stop heuristic.
             if (n_context_tokens < (int)(sizeof(context_tokens) / sizeof(context_tokens[0]))) {
                 context_tokens[n_context_tokens++] = next;
+                if (rep_idx) llmk_rep_sync(&g_llmk_rep, context_tokens, n_context_tokens);
             }
             {
                 float mind_logit = 0.0f;
@@ -7872,6 +8656,7 @@ snap_autoload_done:
                         stop_step = step;
                         stop_pos = pos;
                     }
+                    llmk_stream_sync();
                     Print(L"\r\n[MindHaltRuntime] stop step=%d halt_prob=%d.%03d threshold=%d.%03d\r\n",
                           step,
                           (int)mind_prob,
@@ -7886,10 +8671,29 @@ snap_autoload_done:
             // The decode budget is already bounded by max_gen_tokens, and we also have
             // loop-escape resampling + repetition penalty.
             // (no-op)
+
+            // Grammar complete and nothing else can follow.
+            if (g_llmk_grammar_on && llmk_grammar_must_end(&g_llmk_grammar_rt)) {
+                if (!stop_reason) {
+                    stop_reason = L"grammar";
+                    stop_token = next;
+                    stop_step = step;
+                    stop_pos = pos;
+                }
+                break;
+            }
             
             // Advance position and compute next logits
             token = next;
             pos++;
+            if (pos >= config.seq_len && g_llmk_kvw.enabled) {
+                int np = llmk_kvw_slide(&state, &config, pos, 1);
+                if (np >= 0) {
+                    kv_slid += pos - np;
+                    pos = np;
+                    spec.n = 0;   // verified rows belong to the old positions
+                }
+            }
             if (pos >= config.seq_len) {
                 if (!stop_reason) {
                     stop_reason = L"seq_len";
@@ -7899,17 +8703,26 @@ snap_autoload_done:
                 }
                 break;
             }
-
-            if (g_llmk_ready) {
+            // Generated tokens join the KV window like prompt tokens, so a fold
+            // keeps the model's replies (accepted draft rows pass here too).
+            llmk_kvw_note(&g_llmk_kvw, pos, token);
+
+            const int spec_nt = llmk_spec_plan(&spec, &config, context_tokens, n_context_tokens, token, pos,
+                                               max_gen_tokens - step - 2);
+            if (spec_nt == 0) {
+                logits = llmk_spec_forward(&state, &weights, &config, &spec, 0, token, pos);
+            } else if (g_llmk_ready) {
                 if (g_budget_decode_cycles == 0) {
                     g_budget_decode_cycles = 100000000000ULL;
                 }
-                g_sentinel.cfg.max_cycles_decode = g_budget_decode_cycles;
+                // A verification pass evaluates spec_nt positions at once
+                g_sentinel.cfg.max_cycles_decode = g_budget_decode_cycles * (UINT64)spec_nt;
                 llmk_sentinel_phase_start(&g_sentinel, LLMK_PHASE_DECODE);
-                transformer_forward(&state, &weights, &config, token, pos);
+                logits = llmk_spec_forward(&state, &weights, &config, &spec, spec_nt, token, pos);
                 BOOLEAN ok = llmk_sentinel_phase_end(&g_sentinel);
                 if (g_sentinel.tripped) {
                     immunion_record(&g_immunion, IMMUNION_THREAT_OOBCheck, (uint32_t)g_sentinel.last_error, 80);
+                    llmk_stream_sync();
                     Print(L"\r\n[llmk] decode stopped (fail-safe) at step=%d pos=%d\r\n", step, pos);
                     if (!stop_reason) {
                         stop_reason = L"sentinel_decode";
@@ -7948,6 +8761,7 @@ snap_autoload_done:
                 if (!ok) {
                     g_budget_overruns_decode++;
                     if (g_budget_overruns_decode <= 3) {
+                        llmk_stream_sync();
                         Print(L"\r\n[llmk][budget] decode overrun step=%d pos=%d cycles=%lu max=%lu (auto-raise)\r\n",
                               step, pos, g_sentinel.last_dt_cycles, g_sentinel.last_budget_cycles);
                     }
@@ -7961,15 +8775,16 @@ snap_autoload_done:
                             stop_step = step;
                             stop_pos = pos;
                         }
+                        llmk_stream_sync();
                         Print(L"\r\n[m18.1] hard-stop decode (overruns=%d threshold=%d)\r\n",
                               (int)g_budget_overruns_decode,
                               g_guardrails.hard_stop_overruns_decode);
                         break;
                     }
                 }
-                llmk_budget_update(&g_budget_decode_cycles, g_sentinel.last_dt_cycles);
+                llmk_budget_update(&g_budget_decode_cycles, g_sentinel.last_dt_cycles / (UINT64)spec_nt);
             } else {
-                transformer_forward(&state, &weights, &config, token, pos);
+                logits = llmk_spec_forward(&state, &weights, &config, &spec, spec_nt, token, pos);
             }
             /* Per-token engine hooks */
             chronion_step(&g_chronion, 1);
@@ -7991,6 +8806,8 @@ snap_autoload_done:
             }
         }
 
+        g_llmk_cls_full = grammar_cls_full;
+
         // Emit early-stop reason to serial for automated diagnosis.
         // Only when we stopped before using the full token budget.
         if (!g_capture_mode && stop_reason && generated_count < max_gen_tokens) {
@@ -8000,9 +8817,11 @@ snap_autoload_done:
             llmk_serial_write_char16(smsg);
         }
 
-        // Flush any pending bytes held for mojibake repair across token boundaries.
+        // Flush any pending bytes held for mojibake repair across token boundaries,
+        // then drain the output ring.
         if (!g_capture_mode) {
             uefi_print_utf8_flush();
+            llmk_stream_end();
         }
 
         if (!draw_mode) {
@@ -8089,7 +8908,16 @@ snap_autoload_done:
                       generated_count, (int)ms, (int)tps_int, (int)tps_frac);
             }
 stats_done:
-            ;
+            if (spec.proposed) {
+                Print(L"[spec] k=%d proposed=%d accepted=%d (%d%%)\r\n", g_llmk_spec_k, spec.proposed,
+                      spec.accepted, (spec.accepted * 100) / spec.proposed);
+            }
+            if (g_stream_enabled && g_tok_stream.flushes != g_stream_flushes0) {
+                UINT64 us_div = tsc_per_sec ? tsc_per_sec / 1000000ULL : 0;
+                Print(L"[stream] flushes=%u for %d tokens, drain_us=%lu\r\n",
+                      g_tok_stream.flushes - g_stream_flushes0, generated_count,
+                      (unsigned long)(us_div ? g_stream_flush_cycles / us_div : 0));
+            }
         }
         
         // M16.1: Track completed generation
@@ -8449,7 +9277,9 @@ stats_done:
         }
         
         // Update persistent KV cache position for next generation
-        kv_pos += n_prompt_tokens + generated_count;
+        // (kv_slid = rows the KV window evicted during this turn).
+        kv_pos += n_prompt_tokens + generated_count - kv_slid;
+        if (kv_pos > config.seq_len) kv_pos = config.seq_len;
         g_llmk_kv_pos = kv_pos;
         
         if (!g_capture_mode) {
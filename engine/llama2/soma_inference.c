@@ -767,6 +767,32 @@ static int g_cfg_gguf_q8_blob = 1;
 // 2=FFN-only (w1/w3/w2), attention projections stay float (better quality/perf tradeoff)
 static int g_cfg_q8_act_quant = 0;
 
+#include "llmk_rope.h"
+
+// RoPE overrides (repl.cfg rope_*), applied over the model's metadata at boot.
+// Unset: freq_base/factor 0, scaling/neox -1, orig_ctx 0.
+static struct {
+    float freq_base;
+    int   scaling;      // LLMK_ROPE_SCALING_* (0 none, 1 linear, 2 ntk, 3 yarn)
+    float factor;
+    int   orig_ctx;
+    int   neox;         // 1 = NeoX pair layout, 0 = interleaved
+} g_cfg_rope = { 0.0f, -1, 0.0f, 0, -1 };
+static LlmkRope g_llmk_rope;   // built at boot (llmk_rope_setup); not ready = no rotation
+static void llmk_rope_print(void);
+
+// Architecture switches for the forward pass; GGUF models overwrite them at boot.
+#include "llmk_arch.h"
+static LlmkArch g_llmk_arch = LLMK_ARCH_LLAMA2_INIT;
+
+// KV window (repl.cfg kv_*): slide past seq_len instead of wiping the cache.
+// kv_sinks / kv_discard -1 = module defaults; kv_fold_memory folds evicted
+// spans into soma_memory.
+static int g_cfg_kv_window = 1;
+static int g_cfg_kv_sinks = -1;
+static int g_cfg_kv_discard = -1;
+static int g_cfg_kv_fold_memory = 0;
+
 typedef enum {
     LLMK_CHAT_FMT_YOU_AI = 0,
     LLMK_CHAT_FMT_LLAMA2 = 1,
@@ -1046,6 +1072,9 @@ static void llmk_load_repl_cfg_boot_best_effort(void) {
     //   boot_diag=0/1  (show system diagnostics: GOP/RAM/CPU/models)
     //   gguf_q8_blob=0/1  (enable/disable Q8_0 blob mode)
     //   q8_act_quant=0/1/2  (Q8 activation quantization mode)
+    //   rope_freq_base=F rope_scaling=none|linear|ntk|yarn rope_factor=F
+    //   rope_orig_ctx=N rope_neox=0/1  (RoPE overrides over model metadata)
+    //   kv_window=0/1 kv_sinks=N kv_discard=N kv_fold_memory=0/1  (KV overflow)
     //   fat83_force=0/1 (test/diag: prefer FAT 8.3 alias opens)
     //   oo_enable=0/1 (OO v0: write oostate.bin + append oojour.log)
     //   oo_min_total_mb=<int> (OO M3: override Zone-B total minimum, in MB; 0 disables floor)
@@ -1144,6 +1173,35 @@ static void llmk_load_repl_cfg_boot_best_effort(void) {
                     g_cfg_q8_act_quant = (b != 0) ? 1 : 0;
                 }
             }
+        } else if (llmk_cfg_streq_ci(key, "kv_window")) {
+            int b;
+            if (llmk_cfg_parse_bool(val, &b)) g_cfg_kv_window = (b != 0);
+        } else if (llmk_cfg_streq_ci(key, "kv_sinks")) {
+            int v;
+            if (llmk_cfg_parse_i32(val, &v) && v >= 0) g_cfg_kv_sinks = v;
+        } else if (llmk_cfg_streq_ci(key, "kv_discard")) {
+            int v;
+            if (llmk_cfg_parse_i32(val, &v) && v >= 0) g_cfg_kv_discard = v;
+        } else if (llmk_cfg_streq_ci(key, "kv_fold_memory")) {
+            int b;
+            if (llmk_cfg_parse_bool(val, &b)) g_cfg_kv_fold_memory = (b != 0);
+        } else if (llmk_cfg_streq_ci(key, "rope_freq_base") || llmk_cfg_streq_ci(key, "rope_base")) {
+            float f;
+            if (llmk_cfg_parse_f32(val, &f) && f > 0.0f) g_cfg_rope.freq_base = f;
+        } else if (llmk_cfg_streq_ci(key, "rope_scaling")) {
+            int n = 0;
+            while (val[n]) n++;
+            int sc = llmk_rope_scaling_from_name(val, n);
+            if (sc >= 0) g_cfg_rope.scaling = sc;
+        } else if (llmk_cfg_streq_ci(key, "rope_factor") || llmk_cfg_streq_ci(key, "rope_scaling_factor")) {
+            float f;
+            if (llmk_cfg_parse_f32(val, &f) && f >= 1.0f) g_cfg_rope.factor = f;
+        } else if (llmk_cfg_streq_ci(key, "rope_orig_ctx")) {
+            int v;
+            if (llmk_cfg_parse_i32(val, &v) && v > 0) g_cfg_rope.orig_ctx = v;
+        } else if (llmk_cfg_streq_ci(key, "rope_neox")) {
+            int b;
+            if (llmk_cfg_parse_bool(val, &b)) g_cfg_rope.neox = (b != 0);
         } else if (llmk_cfg_streq_ci(key, "model_picker") || llmk_cfg_streq_ci(key, "model_menu")) {
             int b;
             if (llmk_cfg_parse_bool(val, &b)) {
@@ -3311,29 +3369,7 @@ static EFI_STATUS llmk_dump_log_to_file(EFI_FILE_HANDLE f, const LlmkLog *log, U
     return EFI_SUCCESS;
 }
 
-// ============================================================================
-// MATH FUNCTIONS
-// ============================================================================
-
-float fast_sqrt(float x) {
-    if (x <= 0.0f) return 0.0f;
-    float xhalf = 0.5f * x;
-    int i = *(int*)&x;
-    i = 0x5f3759df - (i >> 1);
-    x = *(float*)&i;
-    x = x * (1.5f - xhalf * x * x);
-    x = x * (1.5f - xhalf * x * x);
-    return 1.0f / x;
-}
-
-float fast_exp(float x) {
-    if (x < -10.0f) return 0.0f;
-    if (x > 10.0f) return 22026.0f;
-    x = 1.0f + x / 256.0f;
-    x *= x; x *= x; x *= x; x *= x;
-    x *= x; x *= x; x *= x; x *= x;
-    return x;
-}
+#include "llmk_kernels.c"
 
 static int my_strncmp(const char* s1, const char* s2, int n) {
     for (int i = 0; i < n; i++) {
@@ -3343,429 +3379,12 @@ static int my_strncmp(const char* s1, const char* s2, int n) {
     return 0;
 }
 
-// ============================================================================
-// TRANSFORMER OPERATIONS
-// ============================================================================
-
-void rmsnorm(float* o, float* x, float* weight, int size) {
-    float ss = 0.0f;
-    for (int j = 0; j < size; j++) {
-        ss += x[j] * x[j];
-    }
-    ss /= size;
-    ss += 1e-5f;
-    ss = 1.0f / fast_sqrt(ss);
-    for (int j = 0; j < size; j++) {
-        o[j] = weight[j] * (ss * x[j]);
-    }
-}
-
-void matmul(float* xout, float* x, float* w, int n, int d) {
-    // DjibLAS computes (column-major): C(m x n) = A(k x m)^T * B(k x n)
-    // We want (row-major weights): xout(d) = W(d x n) * x(n)
-    // Trick: W(d x n) row-major has the same memory layout as B(k x n_out)
-    // column-major when k=n and n_out=d (because W[i*n + l] == B[l + k*i]).
-    // Use A = x as a (k x 1) column-major matrix.
-    // Result C is (1 x d) column-major, so it lands contiguous into xout.
-    djiblas_sgemm_f32(
-        /*m=*/1, /*n=*/d, /*k=*/n,
-        /*A=*/x, /*lda=*/n,
-        /*B=*/w, /*ldb=*/n,
-        /*C=*/xout, /*ldc=*/1
-    );
-}
-
-static UINT16 llmk_read_u16_unaligned(const void *p) {
-    const UINT8 *b = (const UINT8 *)p;
-    return (UINT16)((UINT16)b[0] | ((UINT16)b[1] << 8));
-}
-
-// IEEE-754 half -> float32. Handles normals/denormals/inf/nan.
-static float llmk_fp16_to_fp32(UINT16 h) {
-    UINT32 sign = (UINT32)(h >> 15) & 1u;
-    UINT32 exp  = (UINT32)(h >> 10) & 0x1Fu;
-    UINT32 mant = (UINT32)h & 0x3FFu;
-
-    UINT32 out_sign = sign << 31;
-    UINT32 out_exp;
-    UINT32 out_mant;
-
-    if (exp == 0) {
-        if (mant == 0) {
-            UINT32 u = out_sign;
-            return *(float *)&u;
-        }
-        // subnormal
-        exp = 1;
-        while ((mant & 0x400u) == 0) {
-            mant <<= 1;
-            exp--;
-        }
-        mant &= 0x3FFu;
-        out_exp  = (exp + (127 - 15)) << 23;
-        out_mant = mant << 13;
-    } else if (exp == 31) {
-        // inf/nan
-        out_exp  = 0xFFu << 23;
-        out_mant = mant ? (mant << 13) : 0;
-    } else {
-        out_exp  = (exp + (127 - 15)) << 23;
-        out_mant = mant << 13;
-    }
-
-    UINT32 u = out_sign | out_exp | out_mant;
-    return *(float *)&u;
-}
-
-static UINT64 llmk_align_up_u64(UINT64 x, UINT64 a) {
-    return (a == 0) ? x : ((x + a - 1ULL) / a) * a;
-}
-
-// GGML Q8_0 block format: fp16 scale + 32 int8 values.
-// bytes_per_row = (cols/32) * 34.
-static UINT64 llmk_q8_0_row_bytes(int cols) {
-    if (cols <= 0) return 0;
-    if ((cols % 32) != 0) return 0;
-    return ((UINT64)cols / 32ULL) * 34ULL;
-}
-
-static void llmk_dequantize_q8_0_row(float *dst, const UINT8 *row_q8, int cols) {
-    UINT64 rb = llmk_q8_0_row_bytes(cols);
-    if (!dst || !row_q8 || rb == 0) return;
-
-    const int nb = cols / 32;
-    const UINT8 *p = row_q8;
-    for (int b = 0; b < nb; b++) {
-        UINT16 dh = llmk_read_u16_unaligned(p);
-        float d = llmk_fp16_to_fp32(dh);
-        const INT8 *qs = (const INT8 *)(p + 2);
-        for (int i = 0; i < 32; i++) {
-            dst[b * 32 + i] = d * (float)qs[i];
-        }
-        p += 34;
-    }
-}
-
-// xout(d) = W(d x n) * x(n) where W is Q8_0 row-major blocks.
-static void matmul_q8_0_scalar(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
-    if (!xout || !x || !w_q8) return;
-    if ((n % 32) != 0) {
-        // Q8_0 requires cols multiple of 32.
-        for (int i = 0; i < d; i++) xout[i] = 0.0f;
-        return;
-    }
-
-    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
-    const int nb = n / 32;
-
-    for (int r = 0; r < d; r++) {
-        const UINT8 *row = w_q8 + (UINTN)r * (UINTN)row_bytes;
-        float acc = 0.0f;
-        const UINT8 *p = row;
-        for (int b = 0; b < nb; b++) {
-            float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
-            const INT8 *qs = (const INT8 *)(p + 2);
-            float sum = 0.0f;
-            const float *xblk = x + b * 32;
-            for (int i = 0; i < 32; i++) {
-                sum += xblk[i] * (float)qs[i];
-            }
-            acc += dscale * sum;
-            p += 34;
-        }
-        xout[r] = acc;
-    }
-}
-
-#if defined(__x86_64__) || defined(_M_X64)
-// Shared activation quant buffers for Q8_0 matmuls (used only when q8_act_quant!=0).
-// Monotonic allocation is OK; we only grow a couple of times (dim/hidden_dim).
-static float *g_q8_act_scales = NULL;
-static INT8  *g_q8_act_qs = NULL;
-static int g_q8_act_cap_n = 0;
-
-static void llmk_q8_act_ensure(int n) {
-    if (n <= 0) return;
-    if ((n % 32) != 0) return;
-    if (g_q8_act_cap_n >= n && g_q8_act_scales && g_q8_act_qs) return;
-
-    const int nb = n / 32;
-    g_q8_act_scales = (float *)simple_alloc((unsigned long)nb * sizeof(float));
-    g_q8_act_qs = (INT8 *)simple_alloc((unsigned long)n * sizeof(INT8));
-    g_q8_act_cap_n = n;
-}
-
-static void llmk_quantize_f32_to_q8_blocks(const float *x, int n, INT8 *out_qs, float *out_scales) {
-    if (!x || !out_qs || !out_scales) return;
-    if (n <= 0 || (n % 32) != 0) return;
-    const int nb = n / 32;
-    for (int b = 0; b < nb; b++) {
-        const float *xb = x + b * 32;
-        float max_abs = 0.0f;
-        for (int i = 0; i < 32; i++) {
-            float v = xb[i];
-            if (v < 0.0f) v = -v;
-            if (v > max_abs) max_abs = v;
-        }
-        float dscale = (max_abs > 0.0f) ? (max_abs / 127.0f) : 0.0f;
-        out_scales[b] = dscale;
-        float inv = (dscale > 0.0f) ? (1.0f / dscale) : 0.0f;
-        INT8 *qdst = out_qs + b * 32;
-        for (int i = 0; i < 32; i++) {
-            float fv = xb[i] * inv;
-            int iv = (fv >= 0.0f) ? (int)(fv + 0.5f) : (int)(fv - 0.5f);
-            if (iv < -127) iv = -127;
-            if (iv > 127) iv = 127;
-            qdst[i] = (INT8)iv;
-        }
-    }
-}
-
-// Dot kernel for 32 signed int8 values using AVX2.
-// Returns int32 sum(a[i] * b[i]).
-__attribute__((target("avx2")))
-static int llmk_dot_i8_32_avx2(const INT8 *a, const INT8 *b) {
-    __m128i a0 = _mm_loadu_si128((const __m128i *)(a + 0));
-    __m128i a1 = _mm_loadu_si128((const __m128i *)(a + 16));
-    __m128i b0 = _mm_loadu_si128((const __m128i *)(b + 0));
-    __m128i b1 = _mm_loadu_si128((const __m128i *)(b + 16));
-
-    __m256i a16_0 = _mm256_cvtepi8_epi16(a0);
-    __m256i a16_1 = _mm256_cvtepi8_epi16(a1);
-    __m256i b16_0 = _mm256_cvtepi8_epi16(b0);
-    __m256i b16_1 = _mm256_cvtepi8_epi16(b1);
-
-    __m256i s0 = _mm256_madd_epi16(a16_0, b16_0);
-    __m256i s1 = _mm256_madd_epi16(a16_1, b16_1);
-    __m256i s = _mm256_add_epi32(s0, s1);
-
-    __m128i lo = _mm256_castsi256_si128(s);
-    __m128i hi = _mm256_extracti128_si256(s, 1);
-    __m128i sum = _mm_add_epi32(lo, hi);
-    __m128i shuf = _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1));
-    sum = _mm_add_epi32(sum, shuf);
-    shuf = _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2));
-    sum = _mm_add_epi32(sum, shuf);
-    return _mm_cvtsi128_si32(sum);
-}
-
-// AVX2 implementation: converts int8 weights to float on the fly.
-// Compiled as AVX2 even when the TU default is SSE2.
-__attribute__((target("avx2")))
-static void matmul_q8_0_avx2(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
-    if (!xout || !x || !w_q8) return;
-    if ((n % 32) != 0) {
-        for (int i = 0; i < d; i++) xout[i] = 0.0f;
-        return;
-    }
-
-    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
-    const int nb = n / 32;
-
-    for (int r = 0; r < d; r++) {
-        const UINT8 *row = w_q8 + (UINTN)r * (UINTN)row_bytes;
-        float acc = 0.0f;
-        const UINT8 *p = row;
-
-        for (int b = 0; b < nb; b++) {
-            float dscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
-            const INT8 *qs = (const INT8 *)(p + 2);
-            const float *xblk = x + b * 32;
-
-            __m256 vacc = _mm256_setzero_ps();
-
-            // 32 values per block, process 8 at a time.
-            for (int i = 0; i < 32; i += 8) {
-                // Load 8 int8 values (unaligned) and sign-extend to 8 int32.
-                __m128i q8 = _mm_loadl_epi64((const __m128i *)(qs + i));
-                __m256i q32 = _mm256_cvtepi8_epi32(q8);
-                __m256 qf = _mm256_cvtepi32_ps(q32);
-
-                __m256 xf = _mm256_loadu_ps(xblk + i);
-                vacc = _mm256_add_ps(vacc, _mm256_mul_ps(xf, qf));
-            }
-
-            // Horizontal sum of vacc without requiring SSE3 (build uses -msse2).
-            __m128 lo = _mm256_castps256_ps128(vacc);
-            __m128 hi = _mm256_extractf128_ps(vacc, 1);
-            __m128 sum128 = _mm_add_ps(lo, hi);
-            __m128 shuf = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(2, 3, 0, 1));
-            sum128 = _mm_add_ps(sum128, shuf);
-            shuf = _mm_shuffle_ps(sum128, sum128, _MM_SHUFFLE(1, 0, 3, 2));
-            sum128 = _mm_add_ps(sum128, shuf);
-            float sum = _mm_cvtss_f32(sum128);
-            acc += dscale * sum;
-            p += 34;
-        }
-
-        xout[r] = acc;
-    }
-}
-
-// AVX2 implementation: quantize activations (x) into Q8_0 blocks and use int8 dot-products.
-// Faster on real AVX2 CPUs; adds extra approximation (beyond quantized weights).
-__attribute__((target("avx2")))
-static void matmul_q8_0_avx2_i8_prequant(float *xout, const INT8 *x_qs, const float *x_scales, const UINT8 *w_q8, int n, int d) {
-    if (!xout || !x_qs || !x_scales || !w_q8) return;
-    if ((n % 32) != 0) {
-        for (int i = 0; i < d; i++) xout[i] = 0.0f;
-        return;
-    }
-
-    const UINT64 row_bytes = llmk_q8_0_row_bytes(n);
-    const int nb = n / 32;
-
-    for (int r = 0; r < d; r++) {
-        const UINT8 *row = w_q8 + (UINTN)r * (UINTN)row_bytes;
-        float acc = 0.0f;
-        const UINT8 *p = row;
-        for (int b = 0; b < nb; b++) {
-            float wscale = llmk_fp16_to_fp32(llmk_read_u16_unaligned(p));
-            const INT8 *wqs = (const INT8 *)(p + 2);
-            const INT8 *blk = x_qs + b * 32;
-            int dot = llmk_dot_i8_32_avx2(blk, wqs);
-            acc += (wscale * x_scales[b]) * (float)dot;
-            p += 34;
-        }
-        xout[r] = acc;
-    }
-}
-
-__attribute__((target("avx2")))
-static void matmul_q8_0_avx2_i8(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
-    if (!xout || !x || !w_q8) return;
-    if ((n % 32) != 0) {
-        for (int i = 0; i < d; i++) xout[i] = 0.0f;
-        return;
-    }
-
-    llmk_q8_act_ensure(n);
-    if (!g_q8_act_qs || !g_q8_act_scales) return;
-    llmk_quantize_f32_to_q8_blocks(x, n, g_q8_act_qs, g_q8_act_scales);
-    matmul_q8_0_avx2_i8_prequant(xout, g_q8_act_qs, g_q8_act_scales, w_q8, n, d);
-}
-#endif
-
-static void matmul_q8_0(float *xout, const float *x, const UINT8 *w_q8, int n, int d) {
-    if (!xout || !x || !w_q8) return;
-    if ((n % 32) != 0) {
-        for (int i = 0; i < d; i++) xout[i] = 0.0f;
-        return;
-    }
-
-#if defined(__x86_64__) || defined(_M_X64)
-    static int g_q8_kernel_inited = 0;
-    static int g_q8_use_avx2 = 0;
-    if (!g_q8_kernel_inited) {
-        CPUFeatures f;
-        djiblas_detect_cpu(&f);
-        g_q8_use_avx2 = (f.has_avx2 != 0);
-        g_q8_kernel_inited = 1;
-    }
-    if (g_q8_use_avx2) {
-        if (g_cfg_q8_act_quant == 1) {
-            matmul_q8_0_avx2_i8(xout, x, w_q8, n, d);
-        } else {
-            matmul_q8_0_avx2(xout, x, w_q8, n, d);
-        }
-        return;
-    }
-#endif
-
-    matmul_q8_0_scalar(xout, x, w_q8, n, d);
-}
-
-void softmax(float* x, int size) {
-    float max_val = x[0];
-#if defined(__x86_64__) || defined(_M_X64)
-    // SSE2 max reduction
-    {
-        __m128 vmax = _mm_set1_ps(max_val);
-        int i = 0;
-        for (; i + 4 <= size; i += 4) {
-            __m128 v = _mm_loadu_ps(&x[i]);
-            vmax = _mm_max_ps(vmax, v);
-        }
-        __m128 shuf = _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1));
-        vmax = _mm_max_ps(vmax, shuf);
-        shuf = _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2));
-        vmax = _mm_max_ps(vmax, shuf);
-        _mm_store_ss(&max_val, vmax);
-        for (; i < size; i++) {
-            if (x[i] > max_val) max_val = x[i];
-        }
-    }
-#else
-    for (int i = 1; i < size; i++) {
-        if (x[i] > max_val) max_val = x[i];
-    }
-#endif
-
-    float sum = 0.0f;
-#if defined(__x86_64__) || defined(_M_X64)
-    // Scalar exp, but vectorized accumulation + normalization.
-    {
-        __m128 vsum = _mm_setzero_ps();
-        int i = 0;
-        for (; i + 4 <= size; i += 4) {
-            float e0 = fast_exp(x[i + 0] - max_val);
-            float e1 = fast_exp(x[i + 1] - max_val);
-            float e2 = fast_exp(x[i + 2] - max_val);
-            float e3 = fast_exp(x[i + 3] - max_val);
-            x[i + 0] = e0;
-            x[i + 1] = e1;
-            x[i + 2] = e2;
-            x[i + 3] = e3;
-            __m128 v = _mm_loadu_ps(&x[i]);
-            vsum = _mm_add_ps(vsum, v);
-        }
-        __m128 shuf = _mm_shuffle_ps(vsum, vsum, _MM_SHUFFLE(2, 3, 0, 1));
-        vsum = _mm_add_ps(vsum, shuf);
-        shuf = _mm_shuffle_ps(vsum, vsum, _MM_SHUFFLE(1, 0, 3, 2));
-        vsum = _mm_add_ps(vsum, shuf);
-        _mm_store_ss(&sum, vsum);
-        for (; i < size; i++) {
-            x[i] = fast_exp(x[i] - max_val);
-            sum += x[i];
-        }
-
-        float invsum = 1.0f / sum;
-        __m128 vinv = _mm_set1_ps(invsum);
-        i = 0;
-        for (; i + 4 <= size; i += 4) {
-            __m128 v = _mm_loadu_ps(&x[i]);
-            v = _mm_mul_ps(v, vinv);
-            _mm_storeu_ps(&x[i], v);
-        }
-        for (; i < size; i++) {
-            x[i] *= invsum;
-        }
-    }
-#else
-    for (int i = 0; i < size; i++) {
-        x[i] = fast_exp(x[i] - max_val);
-        sum += x[i];
-    }
-    float invsum = 1.0f / sum;
-    for (int i = 0; i < size; i++) {
-        x[i] *= invsum;
-    }
-#endif
-}
 
 // ============================================================================
 // STRUCTURES
 // ============================================================================
 
-typedef struct {
-    int dim;
-    int hidden_dim;
-    int n_layers;
-    int n_heads;
-    int n_kv_heads;
-    int vocab_size;
-    int seq_len;
-} Config;
+#include "llmk_model.h"
 
 static UINT64 llmk_calc_kv_bytes_for_seq(const Config *cfg, int seq_len, int kv_dim) {
     if (!cfg || seq_len <= 0 || kv_dim <= 0) return 0;
@@ -4254,45 +3873,6 @@ static void llmk_print_ram_budget(void) {
     Print(L"\r\n");
 }
 
-typedef struct {
-    int kind; // 0 = float32, 1 = Q8_0 blob
-
-    // float32 pointers (always valid for norms; valid for matrices in float32 mode)
-    float* token_embedding_table;
-    float* rms_att_weight;
-    float* wq;
-    float* wk;
-    float* wv;
-    float* wo;
-    float* rms_ffn_weight;
-    float* w1;
-    float* w2;
-    float* w3;
-    float* rms_final_weight;
-    float* wcls;
-
-    // Q8_0 pointers (valid in Q8_0 blob mode)
-    const UINT8 *token_embedding_table_q8;
-    const UINT8 *wq_q8;
-    const UINT8 *wk_q8;
-    const UINT8 *wv_q8;
-    const UINT8 *wo_q8;
-    const UINT8 *w1_q8;
-    const UINT8 *w2_q8;
-    const UINT8 *w3_q8;
-    const UINT8 *wcls_q8;
-
-    // Strides/sizes for Q8_0 blob addressing
-    UINT64 tok_embd_row_bytes;
-    UINT64 wq_layer_bytes;
-    UINT64 wk_layer_bytes;
-    UINT64 wv_layer_bytes;
-    UINT64 wo_layer_bytes;
-    UINT64 w1_layer_bytes;
-    UINT64 w2_layer_bytes;
-    UINT64 w3_layer_bytes;
-} TransformerWeights;
-
 static void llmk_print_cfg(const Config *config,
                            const CHAR16 *model_name,
                            const TransformerWeights *weights,
@@ -4312,6 +3892,16 @@ static void llmk_print_cfg(const Config *config,
 
     Print(L"  gguf_q8_blob=%d\r\n", g_cfg_gguf_q8_blob ? 1 : 0);
     Print(L"  q8_act_quant=%d\r\n", g_cfg_q8_act_quant);
+    if (g_cfg_rope.scaling >= 0 || g_cfg_rope.freq_base > 0.0f || g_cfg_rope.factor > 0.0f ||
+        g_cfg_rope.orig_ctx > 0 || g_cfg_rope.neox >= 0) {
+        int f100 = (int)(g_cfg_rope.factor * 100.0f + 0.5f);
+        Print(L"  rope_cfg: base=%d scaling=%d factor=%d.%02d orig_ctx=%d neox=%d\r\n",
+              (int)(g_cfg_rope.freq_base + 0.5f), g_cfg_rope.scaling, f100 / 100, f100 % 100,
+              g_cfg_rope.orig_ctx, g_cfg_rope.neox);
+    }
+    llmk_rope_print();
+    Print(L"  kv_window=%d kv_sinks=%d kv_discard=%d kv_fold_memory=%d\r\n",
+          g_cfg_kv_window, g_cfg_kv_sinks, g_cfg_kv_discard, g_cfg_kv_fold_memory);
     Print(L"  model_picker=%d\r\n", g_cfg_model_picker ? 1 : 0);
     Print(L"  ctx_len_cfg=%d\r\n", g_cfg_ctx_len);
     Print(L"  chat_format=");
@@ -4385,244 +3975,413 @@ static void llmk_print_cfg(const Config *config,
     Print(L"\r\n");
 }
 
-typedef struct {
-    float* x;
-    float* xb;
-    float* xb2;
-    float* hb;
-    float* hb2;
-    float* q;
-    float* k;
-    float* v;
-    float* att;
-    float* logits;
-    float* key_cache;
-    float* value_cache;
-} RunState;
-
-typedef struct {
-    char** vocab;
-    float* vocab_scores;
-    int vocab_size;
-    int max_token_length;
-} Tokenizer;
-
 // Forward decl for M5 /oo_consult (needs Config, TransformerWeights, RunState, Tokenizer)
 static void llmk_oo_consult_execute(Config *config, TransformerWeights *weights, 
                                     RunState *state, Tokenizer *tokenizer,
                                     float temperature, float min_p, float top_p, int top_k);
 
 // ============================================================================
-// FORWARD PASS
+// LORA (fused / merged adapters, Phase 6G)
 // ============================================================================
 
-void transformer_forward(RunState* s, TransformerWeights* w, Config* p, int token, int pos) {
-    UINT64 start_cycles = __rdtsc();
-    int is_prefill = (pos == 0);
-    
-    // DjibMark: record entry into transformer (prefill vs decode determined by caller)
-    if (is_prefill) {
-        DJIBMARK_PREFILL();
-    } else {
-        DJIBMARK_DECODE();
-    }
-    
+// Describe the loaded weights to oo_lora (merge/unmerge and fused kernels).
+static void llmk_lora_model(const TransformerWeights *w, const Config *p, oo_lora_model_t *m) {
     int dim = p->dim;
-    int hidden_dim = p->hidden_dim;
-    int n_layers = p->n_layers;
-    int n_heads = p->n_heads;
-    int head_size = dim / n_heads;
-    int kv_dim = (dim * p->n_kv_heads) / n_heads;
-    int kv_mul = n_heads / p->n_kv_heads;
-
-    const int q8_mode = g_cfg_q8_act_quant;
-    const int use_i8_attn = (q8_mode == 1) && llmk_has_avx2_cached();
-    const int use_i8_ffn = ((q8_mode == 1) || (q8_mode == 2)) && llmk_has_avx2_cached();
-    const int use_i8_cls = (q8_mode == 1) && llmk_has_avx2_cached();
-    
-    // Copy embedding
+    int kv_dim = (p->dim * p->n_kv_heads) / p->n_heads;
+    int hd = p->hidden_dim;
+    const int in[OO_LORA_NPROJ]  = { dim, dim, dim, dim, dim, hd, dim };
+    const int out[OO_LORA_NPROJ] = { dim, kv_dim, kv_dim, dim, hd, dim, hd };
+    m->n_layers = (UINT32)p->n_layers;
+    for (int i = 0; i < OO_LORA_NPROJ; i++) {
+        m->w[i].in_dim = (UINT32)in[i];
+        m->w[i].out_dim = (UINT32)out[i];
+        m->w[i].kind = (w->kind == 1) ? OO_LORA_W_Q8_0 : OO_LORA_W_F32;
+    }
     if (w->kind == 1) {
-        const UINT8 *row = w->token_embedding_table_q8 + (UINTN)token * (UINTN)w->tok_embd_row_bytes;
-        llmk_dequantize_q8_0_row(s->x, row, dim);
-    } else {
-        float* content_row = w->token_embedding_table + token * dim;
-        for (int i = 0; i < dim; i++) {
-            s->x[i] = content_row[i];
+        const UINT8 *b[OO_LORA_NPROJ] = { w->wq_q8, w->wk_q8, w->wv_q8, w->wo_q8, w->w1_q8, w->w2_q8, w->w3_q8 };
+        const UINT64 lb[OO_LORA_NPROJ] = { w->wq_layer_bytes, w->wk_layer_bytes, w->wv_layer_bytes, w->wo_layer_bytes,
+                                           w->w1_layer_bytes, w->w2_layer_bytes, w->w3_layer_bytes };
+        for (int i = 0; i < OO_LORA_NPROJ; i++) {
+            m->w[i].base = (UINT8 *)b[i];
+            m->w[i].layer_bytes = lb[i];
         }
+    } else {
+        const float *b[OO_LORA_NPROJ] = { w->wq, w->wk, w->wv, w->wo, w->w1, w->w2, w->w3 };
+        for (int i = 0; i < OO_LORA_NPROJ; i++) {
+            m->w[i].base = (UINT8 *)b[i];
+            m->w[i].layer_bytes = (UINT64)in[i] * (UINT64)out[i] * sizeof(float);
+        }
+    }
+}
+
+// Q8_0 merges log saturated codes so unmerge is byte-exact. One spill entry
+// per 8 adapted blocks (~3% of the projection weights); overflow past that
+// is counted in q8_clipped and shown by /lora_status.
+static void llmk_lora_ensure_spill(oo_lora_state_t *st, const oo_lora_model_t *m) {
+    if (!st || st->spill || st->merged || m->w[0].kind != OO_LORA_W_Q8_0) return;
+    UINT64 blocks = 0;
+    for (int i = 0; i < OO_LORA_NPROJ; i++)
+        blocks += (UINT64)m->w[i].out_dim * (UINT64)(m->w[i].in_dim / 32) * (UINT64)st->n_layers;
+    UINT64 bytes = (blocks / 8) * sizeof(oo_lora_spill_t);
+    void *mem = simple_alloc((unsigned long)bytes);
+    if (mem) oo_lora_set_spill(st, mem, bytes);
+}
+
+// Active adapter that still has to run fused for layer l (NULL when none,
+// or when it is merged into the weights and the plain matmuls already see it).
+static const oo_lora_state_t *llmk_lora_fused_state(int l) {
+    const oo_lora_state_t *st = oo_lora_bank_active(&g_lora_bank);
+    if (!st || st->merged || (UINT32)l >= st->n_layers) return NULL;
+    return st;
+}
+
+// Active adapter for layer l whether fused or merged: a mixed-precision plan
+// is built from the unmerged base, so it adds the low-rank term itself.
+static const oo_lora_state_t *llmk_lora_active_state(int l) {
+    const oo_lora_state_t *st = oo_lora_bank_active(&g_lora_bank);
+    if (!st || (UINT32)l >= st->n_layers) return NULL;
+    return st;
+}
+
+// Base matmul + low-rank term in one kernel. Q8_0 runs on f32 activations
+// (the i8 pre-quant path is skipped while an adapter is fused).
+static void llmk_lora_matmul(float *xout, const float *x, const oo_lora_model_t *m,
+                             const oo_lora_state_t *st, int proj, int l) {
+    const oo_lora_weight_t *wd = &m->w[proj];
+    const UINT8 *base = wd->base + (UINTN)l * (UINTN)wd->layer_bytes;
+    const oo_lora_adapter_t *a = &st->layers[l][proj];
+    if (wd->kind == OO_LORA_W_Q8_0) {
+        oo_lora_matmul_q8_0(xout, x, base, wd->in_dim, wd->out_dim, a);
+    } else {
+        oo_lora_matmul_f32(xout, x, (const float *)base, wd->in_dim, wd->out_dim, a);
     }
-    
-    // Forward all layers
-    for (int l = 0; l < n_layers; l++) {
-        // Attention RMSNorm
-        rmsnorm(s->xb, s->x, w->rms_att_weight + l*dim, dim);
-        
-        // Q, K, V matrices
-        if (w->kind == 1) {
-            if (use_i8_attn) {
-                llmk_q8_act_ensure(dim);
-                llmk_quantize_f32_to_q8_blocks(s->xb, dim, g_q8_act_qs, g_q8_act_scales);
-                matmul_q8_0_avx2_i8_prequant(s->q, g_q8_act_qs, g_q8_act_scales, w->wq_q8 + (UINTN)l * (UINTN)w->wq_layer_bytes, dim, dim);
-                matmul_q8_0_avx2_i8_prequant(s->k, g_q8_act_qs, g_q8_act_scales, w->wk_q8 + (UINTN)l * (UINTN)w->wk_layer_bytes, dim, kv_dim);
-                matmul_q8_0_avx2_i8_prequant(s->v, g_q8_act_qs, g_q8_act_scales, w->wv_q8 + (UINTN)l * (UINTN)w->wv_layer_bytes, dim, kv_dim);
-            } else {
-                matmul_q8_0(s->q, s->xb, w->wq_q8 + (UINTN)l * (UINTN)w->wq_layer_bytes, dim, dim);
-                matmul_q8_0(s->k, s->xb, w->wk_q8 + (UINTN)l * (UINTN)w->wk_layer_bytes, dim, kv_dim);
-                matmul_q8_0(s->v, s->xb, w->wv_q8 + (UINTN)l * (UINTN)w->wv_layer_bytes, dim, kv_dim);
-            }
-        } else {
-            matmul(s->q, s->xb, w->wq + l*dim*dim, dim, dim);
-            matmul(s->k, s->xb, w->wk + l*dim*kv_dim, dim, kv_dim);
-            matmul(s->v, s->xb, w->wv + l*dim*kv_dim, dim, kv_dim);
-        }
+}
 
-        // ── LoRA forward injection (Phase 6D) ──────────────────────────────
-        // g_lora is zero-init until trained, so this is a safe no-op at boot.
-        // Once LoRA is trained, it adds rank-8 deltas to q, k, v in-place.
-        if (g_lora.n_layers > 0 && (UINT32)l < g_lora.n_layers) {
-            oo_lora_forward(&g_lora.layers[l][0], s->xb, s->q, (UINT32)dim);
-            oo_lora_forward(&g_lora.layers[l][1], s->xb, s->k, (UINT32)kv_dim);
-            oo_lora_forward(&g_lora.layers[l][2], s->xb, s->v, (UINT32)kv_dim);
-        }
-        
-        // Store in KV cache
-        int loff = l * p->seq_len * kv_dim;
-        float* key_cache_row = s->key_cache + loff + pos * kv_dim;
-        float* value_cache_row = s->value_cache + loff + pos * kv_dim;
-        for (int i = 0; i < kv_dim; i++) {
-            key_cache_row[i] = s->k[i];
-            value_cache_row[i] = s->v[i];
-        }
-        
-        // Multihead attention
-        for (int h = 0; h < n_heads; h++) {
-            float* q_h = s->q + h * head_size;
-            int att_offset = h * p->seq_len;
-            float inv_scale = 1.0f / fast_sqrt((float)head_size);
-            int kv_head = h / kv_mul;
-            const float *key_base = s->key_cache + loff + kv_head * head_size;
-            const float *val_base = s->value_cache + loff + kv_head * head_size;
-
-            llmk_kv_prefetch_range(key_base, kv_dim, head_size, pos + 1);
-            llmk_kv_prefetch_range(val_base, kv_dim, head_size, pos + 1);
-            // Attention scores
-            for (int t = 0; t <= pos; t++) {
-                float* k_t = s->key_cache + loff + t * kv_dim + (h / kv_mul) * head_size;
-                float score = dot_f32_best(q_h, k_t, head_size) * inv_scale;
-                s->att[att_offset + t] = score;
-            }
-            
-            // Softmax
-            softmax(s->att + att_offset, pos + 1);
-
-            // Weighted sum
-            float* xb_h = s->xb + h * head_size;
-            for (int i = 0; i < head_size; i++) xb_h[i] = 0.0f;
-            
-            for (int t = 0; t <= pos; t++) {
-                float* v_t = s->value_cache + loff + t * kv_dim + (h / kv_mul) * head_size;
-                float a = s->att[att_offset + t];
-                axpy_f32_best(xb_h, v_t, a, head_size);
-            }
-        }
-        pheromion_touch(&g_pheromion, 1);
-        // Output projection
-        if (w->kind == 1) {
-            if (use_i8_attn) {
-                llmk_q8_act_ensure(dim);
-                llmk_quantize_f32_to_q8_blocks(s->xb, dim, g_q8_act_qs, g_q8_act_scales);
-                matmul_q8_0_avx2_i8_prequant(s->xb2, g_q8_act_qs, g_q8_act_scales, w->wo_q8 + (UINTN)l * (UINTN)w->wo_layer_bytes, dim, dim);
-            } else {
-                matmul_q8_0(s->xb2, s->xb, w->wo_q8 + (UINTN)l * (UINTN)w->wo_layer_bytes, dim, dim);
-            }
-        } else {
-            matmul(s->xb2, s->xb, w->wo + l*dim*dim, dim, dim);
-        }
-        
-        // Residual
-        for (int i = 0; i < dim; i++) {
-            s->x[i] += s->xb2[i];
-        }
-        
-        // FFN RMSNorm
-        rmsnorm(s->xb, s->x, w->rms_ffn_weight + l*dim, dim);
-        
-        // FFN
-        if (w->kind == 1) {
-            if (use_i8_ffn) {
-                llmk_q8_act_ensure(dim);
-                llmk_quantize_f32_to_q8_blocks(s->xb, dim, g_q8_act_qs, g_q8_act_scales);
-                matmul_q8_0_avx2_i8_prequant(s->hb, g_q8_act_qs, g_q8_act_scales, w->w1_q8 + (UINTN)l * (UINTN)w->w1_layer_bytes, dim, hidden_dim);
-                matmul_q8_0_avx2_i8_prequant(s->hb2, g_q8_act_qs, g_q8_act_scales, w->w3_q8 + (UINTN)l * (UINTN)w->w3_layer_bytes, dim, hidden_dim);
-            } else {
-                matmul_q8_0(s->hb, s->xb, w->w1_q8 + (UINTN)l * (UINTN)w->w1_layer_bytes, dim, hidden_dim);
-                matmul_q8_0(s->hb2, s->xb, w->w3_q8 + (UINTN)l * (UINTN)w->w3_layer_bytes, dim, hidden_dim);
-            }
-        } else {
-            matmul(s->hb, s->xb, w->w1 + l*dim*hidden_dim, dim, hidden_dim);
-            matmul(s->hb2, s->xb, w->w3 + l*dim*hidden_dim, dim, hidden_dim);
-        }
-        
-        pheromion_touch(&g_pheromion, 2);
-        // SwiGLU
-        for (int i = 0; i < hidden_dim; i++) {
-            float val = s->hb[i];
-            val *= (1.0f / (1.0f + fast_exp(-val)));
-            s->hb[i] = val * s->hb2[i];
-        }
-        
-        if (w->kind == 1) {
-            if (use_i8_ffn) {
-                llmk_q8_act_ensure(hidden_dim);
-                llmk_quantize_f32_to_q8_blocks(s->hb, hidden_dim, g_q8_act_qs, g_q8_act_scales);
-                matmul_q8_0_avx2_i8_prequant(s->xb, g_q8_act_qs, g_q8_act_scales, w->w2_q8 + (UINTN)l * (UINTN)w->w2_layer_bytes, hidden_dim, dim);
-            } else {
-                matmul_q8_0(s->xb, s->hb, w->w2_q8 + (UINTN)l * (UINTN)w->w2_layer_bytes, hidden_dim, dim);
-            }
-        } else {
-            matmul(s->xb, s->hb, w->w2 + l*dim*hidden_dim, hidden_dim, dim);
-        }
-        
-        // Residual
-        for (int i = 0; i < dim; i++) {
-            s->x[i] += s->xb[i];
-        }
+// ============================================================================
+// IN-SITU BACKPROP (oo_insitu_backprop, Phase X2)
+// ============================================================================
+
+// Trains the adapters of the last LLMK_OIT_BP_LAYERS layers of g_lora on
+// samples of up to LLMK_OIT_BP_TOKENS tokens (arena grows with T² · heads).
+#define LLMK_OIT_BP_LAYERS 2
+#define LLMK_OIT_BP_TOKENS 256
+
+static OitBpModel   g_oit_bp_model;
+static OitBpTrainer g_oit_bp;
+static OitParallel  g_oit_par;
+static OitDream     g_oit_dream;
+
+void encode(char* text, int* tokens, int* n_tokens, int max_tokens, Tokenizer* t);
+int llmk_vocab_encode(const struct LlmkVocab *v, const char *text, int n, int add_bos, int *ids, int max_ids);
+
+static int llmk_oit_encode(void *ctx, const char *text, int add_bos, int *out, int max) {
+    Tokenizer *tk = (Tokenizer *)ctx;
+    int n = 0;
+    if (tk->gguf) {
+        while (text[n]) n++;
+        return llmk_vocab_encode(tk->gguf, text, n, add_bos, out, max);
     }
-    
-    // Final RMSNorm
-    rmsnorm(s->x, s->x, w->rms_final_weight, dim);
-    
-    // Classifier
+    encode((char *)text, out, &n, max, tk);   // always starts with TOKEN_BOS
+    if (!add_bos && n > 0) {
+        for (int i = 1; i < n; i++) out[i - 1] = out[i];
+        n--;
+    }
+    return n;
+}
+
+// Shard training over the work-queue APs once /smp_workers has started them.
+static void llmk_oit_attach_parallel(OitEngine *e) {
+    if (e->par || !e->bp || g_oo_multicore.mc_worker_count <= 0) return;
+    int shards = g_oo_multicore.mc_worker_count;
+    if (shards > OIT_PAR_MAX_SHARDS) shards = OIT_PAR_MAX_SHARDS;
+    UINT64 bytes = oit_par_bytes(e->bp, shards);
+    void *arena = bytes ? simple_alloc((unsigned long)bytes) : NULL;
+    if (arena && oit_par_init(&g_oit_par, e->bp, &g_oo_multicore, shards, arena, bytes) == 0)
+        oit_attach_parallel(e, &g_oit_par);
+}
+
+// Attach the real trainer to the in-situ engine (once). Creates g_lora if
+// /lora_new has not run yet. Returns 1 when oit_train_batch will backprop.
+static int llmk_oit_attach(OitEngine *e, const TransformerWeights *w, const Config *p, Tokenizer *tk) {
+    if (e->bp) {
+        llmk_oit_attach_parallel(e);
+        return 1;
+    }
+    // The backprop kernels implement the llama2.c block only
+    if (!llmk_arch_is_llama2(&g_llmk_arch)) return 0;
+    UINT32 kvd = (UINT32)((p->dim * p->n_kv_heads) / p->n_heads);
+    if (g_lora.n_layers == 0) {
+        UINT64 bytes = oo_lora_bytes((UINT32)p->n_layers, (UINT32)p->dim, kvd,
+                                     (UINT32)p->hidden_dim, LORA_MAX_RANK);
+        void *mem = simple_alloc((unsigned long)bytes);
+        if (!mem || oo_lora_init(&g_lora, (UINT32)p->n_layers, (UINT32)p->dim, kvd,
+                                 (UINT32)p->hidden_dim, LORA_MAX_RANK, mem, bytes) != 0)
+            return 0;
+    }
+
+    OitBpModel *m = &g_oit_bp_model;
+    m->dim = p->dim;
+    m->hidden_dim = p->hidden_dim;
+    m->n_layers = p->n_layers;
+    m->n_heads = p->n_heads;
+    m->n_kv_heads = p->n_kv_heads;
+    m->vocab_size = p->vocab_size;
+    m->seq_len = p->seq_len;
+    m->rms_att = w->rms_att_weight;
+    m->rms_ffn = w->rms_ffn_weight;
+    m->rms_final = w->rms_final_weight;
+    m->rope = &g_llmk_rope;
     if (w->kind == 1) {
-        if (use_i8_cls) {
-            llmk_q8_act_ensure(dim);
-            llmk_quantize_f32_to_q8_blocks(s->x, dim, g_q8_act_qs, g_q8_act_scales);
-            matmul_q8_0_avx2_i8_prequant(s->logits, g_q8_act_qs, g_q8_act_scales, w->wcls_q8, dim, p->vocab_size);
-        } else {
-            matmul_q8_0(s->logits, s->x, w->wcls_q8, dim, p->vocab_size);
-        }
+        m->tok_embd = w->token_embedding_table_q8;
+        m->tok_row_bytes = w->tok_embd_row_bytes;
+        m->tok_kind = OO_LORA_W_Q8_0;
+        m->wcls = w->wcls_q8;
+        m->cls_kind = OO_LORA_W_Q8_0;
     } else {
-        matmul(s->logits, s->x, w->wcls, dim, p->vocab_size);
+        m->tok_embd = w->token_embedding_table;
+        m->tok_row_bytes = (UINT64)p->dim * sizeof(float);
+        m->tok_kind = OO_LORA_W_F32;
+        m->wcls = w->wcls;
+        m->cls_kind = OO_LORA_W_F32;
+    }
+    llmk_lora_model(w, p, &m->proj);
+
+    int n_train = p->n_layers < LLMK_OIT_BP_LAYERS ? p->n_layers : LLMK_OIT_BP_LAYERS;
+    int max_t = p->seq_len < LLMK_OIT_BP_TOKENS ? p->seq_len : LLMK_OIT_BP_TOKENS;
+    UINT64 bytes = oit_bp_bytes(m, n_train, max_t);
+    void *arena = bytes ? simple_alloc((unsigned long)bytes) : NULL;
+    if (!arena || oit_bp_init(&g_oit_bp, m, &g_lora, n_train, max_t, arena, bytes) != 0)
+        return 0;
+    oit_attach_backprop(e, &g_oit_bp, llmk_oit_encode, tk);
+    llmk_oit_attach_parallel(e);
+    return 1;
+}
+
+// Dream consolidation: (re)bind to the trainer, AP shards and the queue.
+// Rebinds when /smp_workers started shards after the first attach.
+static int llmk_oit_dream_attach(OitEngine *e, Tokenizer *tk) {
+    if (!e->bp) return 0;
+    if (g_oit_dream.ready) {
+        if (g_oit_dream.par == e->par || oit_dream_busy(&g_oit_dream)) return 1;
+        g_oit_dream.par = e->par;
+        if (!g_oit_dream.mc && g_oo_multicore.mc_worker_count > 0) g_oit_dream.mc = &g_oo_multicore;
+        return 1;
     }
-    
-    // M16.1: Capture transformer metrics
-    UINT64 end_cycles = __rdtsc();
-    UINT64 elapsed = (end_cycles > start_cycles) ? (end_cycles - start_cycles) : 0;
-    
-    if (is_prefill) {
-        g_metrics.total_prefill_cycles += elapsed;
-        g_metrics.total_prefill_tokens++;
-        g_metrics.total_prefill_calls++;
-        g_metrics.last_prefill_cycles = elapsed;
-        g_metrics.last_prefill_tokens = 1;
-    } else {
-        g_metrics.total_decode_cycles += elapsed;
-        g_metrics.total_decode_tokens++;
-        g_metrics.total_decode_calls++;
-        g_metrics.last_decode_cycles = elapsed;
-        g_metrics.last_decode_tokens = 1;
+    UINT64 bytes = oit_dream_bytes(e->bp);
+    void *arena = bytes ? simple_alloc((unsigned long)bytes) : NULL;
+    OoMulticoreCtx *mc = g_oo_multicore.mc_worker_count > 0 ? &g_oo_multicore : NULL;
+    return arena && oit_dream_init(&g_oit_dream, e->bp, e->par, mc, llmk_oit_encode, tk,
+                                   arena, bytes) == 0;
+}
+
+// Queue the replay ring (newest first) as dream candidates. The prior is a
+// recency weight, raised when the SMB still holds the turn as relevant and
+// the first token was uncertain.
+static int llmk_oit_dream_collect(OitDream *d) {
+    oit_dream_reset(d);
+    int taken = 0;
+    for (int k = 0; k < g_soma_memory.count && k < SOMA_MEM_MAX_ENTRIES; k++) {
+        int idx = (g_soma_memory.head - 1 - k + SOMA_MEM_MAX_ENTRIES) % SOMA_MEM_MAX_ENTRIES;
+        const SomaMemEntry *me = &g_soma_memory.entries[idx];
+        if (!me->valid || !me->prompt[0] || !me->response[0]) continue;
+        float prior = 1.0f / (1.0f + 0.125f * (float)k);
+        int plen = 0;
+        while (me->prompt[plen]) plen++;
+        uint32_t h = soma_smb_hash(me->prompt, plen);
+        for (int s = 0; s < SOMA_SMB_CAPACITY; s++) {
+            const SomaSmbSlot *sl = &g_soma_smb.slots[s];
+            if (sl->input_hash != h || sl->relevance <= 0.0f) continue;
+            prior *= 1.0f + sl->relevance * (1.0f - sl->confidence);
+            break;
+        }
+        taken += oit_dream_add(d, me->prompt, me->response, prior);
+    }
+    return taken;
+}
+
+// ============================================================================
+// CLASSIFIER SHORTLIST (llmk_shortlist, .lksl built by engine/host)
+// ============================================================================
+
+#include "llmk_shortlist.h"
+#include "llmk_shortlist.c"
+
+#define LLMK_SHORTLIST_FILE      L"classifier.lksl"
+#define LLMK_SHORTLIST_MAX_CAND  1024
+
+static LlmkShortlist g_llmk_shortlist;
+static int g_llmk_cls_full = 0;   // force the full classifier (exact logits everywhere)
+
+// Reads a .lksl into the weights arena and enables it. Arena memory is not
+// returned, so a shortlist is loaded once per boot (/shortlist on|off after).
+static EFI_STATUS llmk_shortlist_load(const CHAR16 *name, const Config *p, UINT32 n_cand) {
+    if (g_llmk_shortlist.coef) return EFI_ALREADY_STARTED;
+    EFI_FILE_HANDLE f = NULL;
+    EFI_STATUS st = llmk_open_read_file(&f, name ? name : LLMK_SHORTLIST_FILE);
+    if (EFI_ERROR(st) || !f) return EFI_ERROR(st) ? st : EFI_NOT_FOUND;
+
+    LlmkSlHeader h;
+    st = read_exact(f, &h, sizeof(h));
+    if (!EFI_ERROR(st) && (h.magic != LLMK_SL_MAGIC || h.vocab != (UINT32)p->vocab_size ||
+                           h.dim != (UINT32)p->dim || h.rank == 0 || h.rank > LLMK_SL_MAX_RANK)) {
+        st = EFI_INCOMPATIBLE_VERSION;
+    }
+    UINT64 bytes = EFI_ERROR(st) ? 0 : llmk_sl_file_bytes(h.vocab, h.dim, h.rank);
+    void *buf = bytes ? llmk_alloc_weights(bytes, L"shortlist") : NULL;
+    if (!EFI_ERROR(st) && !buf) st = EFI_OUT_OF_RESOURCES;
+    if (!EFI_ERROR(st)) st = uefi_call_wrapper(f->SetPosition, 2, f, 0);
+    if (!EFI_ERROR(st)) st = read_exact(f, buf, (UINTN)bytes);
+    uefi_call_wrapper(f->Close, 1, f);
+    if (EFI_ERROR(st)) return st;
+
+    LlmkShortlist sl;
+    if (llmk_sl_parse(&sl, buf, bytes) != LLMK_SL_OK) return EFI_COMPROMISED_DATA;
+    UINT32 max_cand = (sl.vocab < LLMK_SHORTLIST_MAX_CAND) ? sl.vocab : LLMK_SHORTLIST_MAX_CAND;
+    UINT64 sb = llmk_sl_scratch_bytes(sl.vocab, sl.rank, max_cand);
+    void *scratch = simple_alloc((unsigned long)sb);
+    if (!scratch || llmk_sl_attach_scratch(&sl, scratch, sb, max_cand) != LLMK_SL_OK) {
+        return EFI_OUT_OF_RESOURCES;
     }
+    sl.n_cand = (n_cand == 0) ? 256 : n_cand;
+    if (sl.n_cand > max_cand) sl.n_cand = max_cand;
+    sl.enabled = 1;
+    g_llmk_shortlist = sl;
+    return EFI_SUCCESS;
 }
 
+// ============================================================================
+// MIXED-PRECISION PLAN (llmk_mixq, .lkmx planned by engine/host)
+// ============================================================================
+
+#include "llmk_mixq.h"
+#include "llmk_mixq.c"
+
+#define LLMK_MIXQ_FILE  L"model.lkmx"
+
+static LlmkMixq g_llmk_mixq;
+
+// Reads a .lkmx into the weights arena; the caller points weights.mx at
+// g_llmk_mixq. Once per boot like the shortlist (/mixq on|off after).
+static EFI_STATUS llmk_mixq_load(const CHAR16 *name, const Config *p) {
+    if (g_llmk_mixq.n_tensors) return EFI_ALREADY_STARTED;
+    EFI_FILE_HANDLE f = NULL;
+    EFI_STATUS st = llmk_open_read_file(&f, name ? name : LLMK_MIXQ_FILE);
+    if (EFI_ERROR(st) || !f) return EFI_ERROR(st) ? st : EFI_NOT_FOUND;
+
+    // The file ends with the last tensor: size it from the entry table
+    LlmkMxHeader h;
+    st = read_exact(f, &h, sizeof(h));
+    if (!EFI_ERROR(st) && (h.magic != LLMK_MX_MAGIC || h.version != LLMK_MX_VERSION ||
+                           h.dim != (UINT32)p->dim || h.hidden_dim != (UINT32)p->hidden_dim ||
+                           h.n_layers != (UINT32)p->n_layers || h.n_heads != (UINT32)p->n_heads ||
+                           h.n_kv_heads != (UINT32)p->n_kv_heads || h.vocab != (UINT32)p->vocab_size ||
+                           h.n_tensors > LLMK_MX_MAX_TENSORS)) {
+        st = EFI_INCOMPATIBLE_VERSION;
+    }
+    UINT64 bytes = sizeof(h) + (UINT64)h.n_tensors * sizeof(LlmkMxEntry);
+    for (UINT32 i = 0; !EFI_ERROR(st) && i < h.n_tensors; i++) {
+        LlmkMxEntry e;
+        st = read_exact(f, &e, sizeof(e));
+        if (!EFI_ERROR(st) && e.offset + e.bytes > bytes) bytes = e.offset + e.bytes;
+    }
+    void *buf = EFI_ERROR(st) ? NULL : llmk_alloc_weights(bytes, L"mixq");
+    if (!EFI_ERROR(st) && !buf) st = EFI_OUT_OF_RESOURCES;
+    if (!EFI_ERROR(st)) st = uefi_call_wrapper(f->SetPosition, 2, f, 0);
+    if (!EFI_ERROR(st)) st = read_exact(f, buf, (UINTN)bytes);
+    uefi_call_wrapper(f->Close, 1, f);
+    if (EFI_ERROR(st)) return st;
+
+    if (llmk_mx_parse(&g_llmk_mixq, buf, bytes) != LLMK_MX_OK) return EFI_COMPROMISED_DATA;
+    return EFI_SUCCESS;
+}
+
+// ============================================================================
+// ROTARY POSITION EMBEDDING (llmk_rope, tables built at boot per seq_len)
+// ============================================================================
+
+#include "llmk_rope.c"
+
+// Applies repl.cfg rope_* overrides on top of the model's parameters.
+static void llmk_rope_apply_cfg(LlmkRopeParams *p) {
+    if (g_cfg_rope.freq_base > 0.0f) p->freq_base = g_cfg_rope.freq_base;
+    if (g_cfg_rope.scaling >= 0) p->scaling = g_cfg_rope.scaling;
+    if (g_cfg_rope.factor >= 1.0f) p->factor = g_cfg_rope.factor;
+    if (g_cfg_rope.orig_ctx > 0) p->orig_ctx = g_cfg_rope.orig_ctx;
+    if (g_cfg_rope.neox >= 0) p->layout = g_cfg_rope.neox ? LLMK_ROPE_NEOX : LLMK_ROPE_NORM;
+}
+
+// Builds the sin/cos tables for seq_len in the activations arena.
+static EFI_STATUS llmk_rope_setup(const LlmkRopeParams *model_p, const Config *c) {
+    LlmkRopeParams p = *model_p;
+    llmk_rope_apply_cfg(&p);
+    int head_size = c->dim / c->n_heads;
+    int n_rot = ((p.n_rot > 0 && p.n_rot < head_size) ? p.n_rot : head_size) & ~1;
+    UINT64 bytes = llmk_rope_table_bytes(c->seq_len, n_rot);
+    void *mem = bytes ? simple_alloc((unsigned long)bytes) : NULL;
+    if (!mem) return EFI_OUT_OF_RESOURCES;
+    int rc = llmk_rope_init(&g_llmk_rope, &p, head_size, c->seq_len, mem, bytes);
+    if (rc == LLMK_ROPE_ERR_MEM) return EFI_OUT_OF_RESOURCES;
+    return (rc == LLMK_ROPE_OK) ? EFI_SUCCESS : EFI_INVALID_PARAMETER;
+}
+
+static void llmk_rope_print(void) {
+    if (!g_llmk_rope.ready) {
+        Print(L"  rope=off\r\n");
+        return;
+    }
+    const LlmkRopeParams *p = &g_llmk_rope.p;
+    int f100 = (int)(p->factor * 100.0f + 0.5f);
+    Print(L"  rope=%s n_rot=%d/%d base=%d scaling=%a",
+          p->layout == LLMK_ROPE_NEOX ? L"neox" : L"norm",
+          g_llmk_rope.half * 2, g_llmk_rope.head_size, (int)(p->freq_base + 0.5f),
+          llmk_rope_scaling_name(p->scaling));
+    if (p->scaling != LLMK_ROPE_SCALING_NONE) {
+        Print(L" factor=%d.%02d orig_ctx=%d", f100 / 100, f100 % 100, p->orig_ctx);
+    }
+    Print(L" seq_len=%d\r\n", g_llmk_rope.seq_len);
+}
+
+// ============================================================================
+// KV WINDOW (llmk_kv_window: sinks + recent rows, re-rotated on shift)
+// ============================================================================
+
+#include "llmk_kv_window.h"
+#include "llmk_kv_window.c"
+
+static LlmkKvWindow g_llmk_kvw;
+
+// Token log in the activations arena; call after llmk_rope_setup.
+static EFI_STATUS llmk_kvw_setup(const Config *c) {
+    INT32 *tok = (INT32 *)simple_alloc((unsigned long)c->seq_len * sizeof(INT32));
+    if (!tok) return EFI_OUT_OF_RESOURCES;
+    llmk_kvw_init(&g_llmk_kvw, c->seq_len, tok);
+    g_llmk_kvw.enabled = g_cfg_kv_window;
+    if (g_cfg_kv_sinks >= 0) g_llmk_kvw.sinks = g_cfg_kv_sinks;
+    if (g_cfg_kv_discard >= 0) g_llmk_kvw.discard = g_cfg_kv_discard;
+    return EFI_SUCCESS;
+}
+
+// Slides the window so `need` rows fit at pos. Returns the new position, or
+// -1 when the caller must reset (window off, or need > seq_len - sinks).
+static int llmk_kvw_slide(RunState *s, const Config *c, int pos, int need) {
+    LlmkKvCache kv;
+    kv.key_cache = s->key_cache;
+    kv.value_cache = s->value_cache;
+    kv.n_layers = c->n_layers;
+    kv.seq_len = c->seq_len;
+    kv.kv_dim = (c->dim * c->n_kv_heads) / c->n_heads;
+    kv.n_kv_heads = c->n_kv_heads;
+    return llmk_kvw_make_room(&g_llmk_kvw, &kv, &g_llmk_rope, pos, need);
+}
+
+static void llmk_kvw_print(void) {
+    Print(L"  kv_window=%s sinks=%d discard=%d shifts=%lu evicted=%lu fold_memory=%d\r\n",
+          g_llmk_kvw.enabled ? L"on" : L"off", g_llmk_kvw.sinks, llmk_kvw_discard(&g_llmk_kvw),
+          g_llmk_kvw.shifts, g_llmk_kvw.evicted, g_llmk_kvw.on_evict ? 1 : 0);
+}
+
+#include "llmk_forward.c"
+
 // Simple PRNG for sampling
 static unsigned int g_sample_seed = 1234567;
 
@@ -4647,19 +4406,6 @@ static unsigned long long rdtsc(void) {
 // 0 means "unavailable / calibration failed".
 static unsigned long long tsc_per_sec = 0;
 
-// Cached CPU feature checks (avoid repeated CPUID).
-static int llmk_has_avx2_cached(void) {
-    static int inited = 0;
-    static int has = 0;
-    if (!inited) {
-        CPUFeatures f;
-        djiblas_detect_cpu(&f);
-        has = (f.has_avx2 != 0);
-        inited = 1;
-    }
-    return has;
-}
-
 // Best-effort wall-clock microsecond timestamp using UEFI GetTime.
 // Returns 1 on success, 0 on failure.
 static int uefi_wall_us(unsigned long long *out_us) {
@@ -4694,172 +4440,116 @@ static void calibrate_tsc_once(void) {
     tsc_per_sec = dt * 2ULL;
 }
 
-static float randf(void) {
-    g_sample_seed = g_sample_seed * 1664525 + 1013904223;
-    // Every 8 calls: inject one RDTSC jitter byte into the seed.
-    // Cost: ~5 cycles / 8 tokens = negligible. Breaks LCG predictability.
-    static unsigned int randf_call_count = 0;
-    if ((++randf_call_count & 7U) == 0) {
-        g_sample_seed = oo_quantum_mix(g_sample_seed);
+#include "llmk_sampler.c"
+
+// ============================================================================
+// REPETITION CONTROL (llmk_repeat: n-gram bans + penalty counts, incremental)
+// ============================================================================
+
+#include "llmk_repeat.h"
+#include "llmk_repeat.c"
+
+#define LLMK_REP_CTX_TOKENS  (384 + MAX_TOKENS)   // the REPL's per-turn context_tokens
+#define LLMK_REP_PEN_WINDOW  64                   // tokens the repeat penalty looks back
+
+static LlmkRepeat g_llmk_rep;
+
+// Index arena in the activations arena, sized for the vocabulary.
+static EFI_STATUS llmk_rep_setup(const Config *c) {
+    UINT64 bytes = llmk_rep_bytes(c->vocab_size, LLMK_REP_CTX_TOKENS);
+    void *mem = simple_alloc((unsigned long)bytes);
+    if (!mem) return EFI_OUT_OF_RESOURCES;
+    if (llmk_rep_init(&g_llmk_rep, mem, bytes, c->vocab_size, LLMK_REP_CTX_TOKENS, 0, 0,
+                      LLMK_REP_PEN_WINDOW) != LLMK_REP_OK) {
+        return EFI_INVALID_PARAMETER;
     }
-    return (float)(g_sample_seed >> 8) / 16777216.0f;
+    return EFI_SUCCESS;
 }
 
-// Sample with temperature + min_p + top-p + top-k + repetition penalty
-int sample_advanced(float* logits, int n, float temperature, float min_p, float top_p, int top_k,
-                    int* recent_tokens, int n_recent, float repeat_penalty) {
-    // Apply repetition penalty
-    if (repeat_penalty != 1.0f && n_recent > 0) {
-        for (int i = 0; i < n_recent; i++) {
-            int tok = recent_tokens[i];
-            if (tok >= 0 && tok < n) {
-                if (logits[tok] > 0) {
-                    logits[tok] /= repeat_penalty;
-                } else {
-                    logits[tok] *= repeat_penalty;
-                }
-            }
-        }
-    }
-    
-    // Greedy if temp=0
-    if (temperature <= 0.0f) {
-        int max_i = 0;
-        float max_val = logits[0];
-        for (int i = 1; i < n; i++) {
-            if (logits[i] > max_val) {
-                max_val = logits[i];
-                max_i = i;
-            }
-        }
-        return max_i;
-    }
-    
-    // Apply temperature
-    for (int i = 0; i < n; i++) {
-        logits[i] /= temperature;
-    }
-    
-    // Softmax
-    float max_val = logits[0];
-    for (int i = 1; i < n; i++) {
-        if (logits[i] > max_val) max_val = logits[i];
-    }
-    float sum = 0.0f;
-    for (int i = 0; i < n; i++) {
-        logits[i] = fast_exp(logits[i] - max_val);
-        sum += logits[i];
-    }
-    for (int i = 0; i < n; i++) {
-        logits[i] /= sum;
-    }
+// ============================================================================
+// GENERATION STATE (llmk_gen: sampler, RNG, history and KV per generation)
+// ============================================================================
 
-    // Min-p filtering (relative to max probability)
-    if (min_p > 0.0f) {
-        float max_p = 0.0f;
-        for (int i = 0; i < n; i++) {
-            if (logits[i] > max_p) max_p = logits[i];
-        }
-        float thresh = min_p * max_p;
-        float new_sum = 0.0f;
-        for (int i = 0; i < n; i++) {
-            if (logits[i] < thresh) {
-                logits[i] = 0.0f;
-            }
-            new_sum += logits[i];
-        }
-        if (new_sum > 0.0f) {
-            for (int i = 0; i < n; i++) {
-                logits[i] /= new_sum;
-            }
-        }
-    }
-    
-    // Top-k / Top-p sampling
-    {
-        // IMPORTANT: vocab is 32k; do NOT full-sort.
-        // We maintain a small descending top-list.
-        #define MAX_TOP_K 256
-        static int top_idx[MAX_TOP_K];
-        static float top_prob[MAX_TOP_K];
-        int k = top_k;
-        if (k < 0) k = 0;
-        if (k > MAX_TOP_K) k = MAX_TOP_K;
-        if (k == 0 || k > n) k = (n < MAX_TOP_K) ? n : MAX_TOP_K;
-
-        int top_count = 0;
-        for (int i = 0; i < n; i++) {
-            float p = logits[i];
-            if (top_count < k) {
-                int j = top_count;
-                while (j > 0 && top_prob[j - 1] < p) {
-                    top_prob[j] = top_prob[j - 1];
-                    top_idx[j] = top_idx[j - 1];
-                    j--;
-                }
-                top_prob[j] = p;
-                top_idx[j] = i;
-                top_count++;
-            } else if (p > top_prob[top_count - 1]) {
-                int j = top_count - 1;
-                while (j > 0 && top_prob[j - 1] < p) {
-                    top_prob[j] = top_prob[j - 1];
-                    top_idx[j] = top_idx[j - 1];
-                    j--;
-                }
-                top_prob[j] = p;
-                top_idx[j] = i;
-            }
-        }
+// The REPL keeps its knobs, g_sample_seed and g_llmk_rep; generations that
+// must not disturb it (or run on another AP) bring their own LlmkGenState.
+#include "llmk_gen.c"
 
-        // If both are effectively "disabled" (top_p>=1 and top_k<=0), fall through to full sampling.
-        if (top_k > 0 || top_p < 1.0f) {
-            float mass = 0.0f;
-            int cutoff = 0;
-            for (int i = 0; i < top_count; i++) {
-                mass += top_prob[i];
-                cutoff++;
-                if (top_p < 1.0f && mass >= top_p) break;
-            }
-            if (cutoff < 1) cutoff = 1;
-
-            float r = randf() * mass;
-            float cdf = 0.0f;
-            for (int i = 0; i < cutoff; i++) {
-                cdf += top_prob[i];
-                if (r < cdf) {
-                    return top_idx[i];
-                }
-            }
-            return top_idx[cutoff - 1];
-        }
-        #undef MAX_TOP_K
-    }
-    
-    // Sample from distribution
-    float r = randf();
-    float cumsum = 0.0f;
-    for (int i = 0; i < n; i++) {
-        cumsum += logits[i];
-        if (r < cumsum) {
-            return i;
-        }
+// ============================================================================
+// SPECULATIVE DECODING (llmk_spec: prompt-lookup drafts, batched verification)
+// ============================================================================
+
+#include "llmk_spec.h"
+#include "llmk_spec.c"
+
+static LlmkSpec g_llmk_spec;
+static RunBatch g_llmk_spec_batch;        // cap 0 = speculation unavailable
+static int g_llmk_spec_k = 0;             // draft tokens per step (0 = off), /spec
+
+// Per-turn state of the decode loop: the batch last verified and how far
+// sampling has consumed it.
+typedef struct {
+    int toks[LLMK_SPEC_MAX_DRAFT + 1];    // last token + draft
+    int row;                              // next row that can be accepted
+    int n;                                // rows verified
+    int proposed;
+    int accepted;
+} LlmkSpecTurn;
+
+// History index and batch buffers in the activations arena.
+static EFI_STATUS llmk_spec_setup(const Config *c) {
+    const int cap = LLMK_SPEC_MAX_DRAFT + 1;
+    UINT64 bbytes = llmk_batch_bytes(c, cap);
+    UINT64 hbytes = llmk_spec_bytes(LLMK_REP_CTX_TOKENS);
+    void *bmem = simple_alloc((unsigned long)bbytes);
+    void *hmem = simple_alloc((unsigned long)hbytes);
+    if (!bmem || !hmem) return EFI_OUT_OF_RESOURCES;
+    if (llmk_batch_init(&g_llmk_spec_batch, c, bmem, bbytes, cap) != 0 ||
+        llmk_spec_init(&g_llmk_spec, hmem, hbytes, LLMK_REP_CTX_TOKENS,
+                       LLMK_SPEC_MIN_NGRAM, LLMK_SPEC_MAX_NGRAM) != LLMK_SPEC_OK) {
+        g_llmk_spec_batch.cap = 0;
+        return EFI_INVALID_PARAMETER;
     }
-    
-    return n - 1;
+    return EFI_SUCCESS;
 }
 
-int sample(float* logits, int n) {
-    // Simple greedy for now (kept for compatibility)
-    int max_i = 0;
-    float max_val = logits[0];
-    for (int i = 1; i < n; i++) {
-        if (logits[i] > max_val) {
-            max_val = logits[i];
-            max_i = i;
-        }
-    }
-    return max_i;
+// Decides the next decode forward. Returns 0 when the sampled token was the
+// next draft token (its logits are already verified), otherwise the number
+// of positions the forward evaluates: 1, or 1 + a fresh draft.
+static int llmk_spec_plan(LlmkSpecTurn *st, const Config *c, const int *ctx, int n_ctx,
+                          int token, int pos, int budget) {
+    if (st->row < st->n && st->toks[st->row] == token) return 0;
+    st->n = 0;
+    if (g_llmk_spec_k <= 0 || g_llmk_spec_batch.cap <= 0) return 1;
+    // Drafts extend the context; a token that never made it there has no history
+    if (n_ctx <= 0 || n_ctx >= LLMK_REP_CTX_TOKENS || ctx[n_ctx - 1] != token) return 1;
+    int k = g_llmk_spec_k;
+    if (k > c->seq_len - 1 - pos) k = c->seq_len - 1 - pos;
+    if (k > budget) k = budget;
+    if (k <= 0) return 1;
+    llmk_spec_sync(&g_llmk_spec, ctx, n_ctx);
+    k = llmk_spec_propose(&g_llmk_spec, ctx, k, st->toks + 1);
+    if (k <= 0) return 1;
+    st->toks[0] = token;
+    st->n = k + 1;
+    st->row = 1;
+    st->proposed += k;
+    return k + 1;
+}
+
+// Runs what llmk_spec_plan decided and returns the logits to sample from.
+static float *llmk_spec_forward(RunState *s, TransformerWeights *w, Config *c,
+                                LlmkSpecTurn *st, int nt, int token, int pos) {
+    if (nt == 0) {
+        g_llmk_spec.accepted++;
+        st->accepted++;
+        return g_llmk_spec_batch.logits + (UINTN)st->row++ * (UINTN)c->vocab_size;
+    }
+    if (nt == 1) {
+        transformer_forward(s, w, c, token, pos);
+        return s->logits;
+    }
+    transformer_forward_batch(s, w, c, &g_llmk_spec_batch, st->toks, nt, pos);
+    return g_llmk_spec_batch.logits;
 }
 
 static void llmk_oo_infermini_no_model(const char *args) {
@@ -5113,62 +4803,110 @@ static void llmk_u64_to_str(UINT64 val, char *buf, int buf_size) {
     buf[j] = 0;
 }
 
-int str_lookup(char* str, char** vocab, int vocab_size) {
-    for (int i = 0; i < vocab_size; i++) {
-        if (vocab[i] && my_strcmp(str, vocab[i]) == 0) {
-            return i;
+#include "llmk_vocab.h"
+#include "llmk_vocab.c"
+#include "llmk_tokenizer.c"
+
+static LlmkVocab g_llmk_vocab;  // GGUF-embedded tokenizer (kind == 0: tokenizer.bin)
+
+// KV window eviction → soma_memory: the evicted span's text becomes one
+// memory entry, so the REPL can still recall it ([MEM: ...] injection).
+static void llmk_kvw_fold_to_memory(void *ctx, const int32_t *tokens, int n, int first_pos) {
+    const Tokenizer *t = (const Tokenizer *)ctx;
+    char text[SOMA_MEM_RESPONSE_LEN];
+    char tag[SOMA_MEM_PROMPT_LEN];
+    int tp = 0, gp = 0;
+    text[0] = 0;
+    tag[0] = 0;
+    if (!t || !t->vocab) return;
+    for (int i = 0; i < n && tp < (int)sizeof(text) - 1; i++) {
+        char dec[64];
+        int dl = llmk_tok_decode(t, tokens[i], dec, (int)sizeof(dec));
+        for (int k = 0; k < dl; k++) {
+            char ch = dec[k];
+            if (ch == '\n' || ch == '\r' || ch == '\t') ch = ' ';
+            llmk_ascii_append_char(text, (int)sizeof(text), &tp, ch);
         }
     }
-    return -1;
+    if (tp == 0) return;
+    llmk_ascii_append_str(tag, (int)sizeof(tag), &gp, "[kv evicted ");
+    llmk_ascii_append_u64(tag, (int)sizeof(tag), &gp, (UINT64)first_pos);
+    llmk_ascii_append_str(tag, (int)sizeof(tag), &gp, "..");
+    llmk_ascii_append_u64(tag, (int)sizeof(tag), &gp, (UINT64)(first_pos + n - 1));
+    llmk_ascii_append_char(tag, (int)sizeof(tag), &gp, ']');
+    soma_memory_record(&g_soma_memory, tag, text);
 }
 
-void encode(char* text, int* tokens, int* n_tokens, int max_tokens, Tokenizer* t) {
-    *n_tokens = 0;
-    if (max_tokens <= 0) return;
+// Hooks the fold callback once the tokenizer is loaded (cfg kv_fold_memory).
+static void llmk_kvw_bind_tokenizer(Tokenizer *t) {
+    g_llmk_kvw.on_evict = (g_cfg_kv_fold_memory && t) ? llmk_kvw_fold_to_memory : 0;
+    g_llmk_kvw.evict_ctx = t;
+}
 
-    // Add BOS
-    tokens[(*n_tokens)++] = TOKEN_BOS;
-    if (*n_tokens >= max_tokens) return;
+// ============================================================================
+// CONSTRAINED DECODING (llmk_grammar, /grammar json|load|schema)
+// ============================================================================
 
-    // Greedy longest-match encoding
-    char* str = text;
-    while (*str && *n_tokens < max_tokens) {
-        int best_id = -1;
-        int best_len = 0;
+#include "llmk_grammar.h"
+#include "llmk_grammar.c"
 
-        for (int len = 64; len > 0; len--) {
-            char piece[65];
-            int i = 0;
-            for (i = 0; i < len && str[i]; i++) {
-                piece[i] = str[i];
-            }
-            if (i != len) continue; // not enough chars remaining
-            piece[i] = '\0';
+#define LLMK_GRAMMAR_TEXT_MAX  32768
 
-            int id = str_lookup(piece, t->vocab, t->vocab_size);
-            if (id >= 0) {
-                best_id = id;
-                best_len = len;
-                break;
-            }
-        }
+static LlmkGrammar   g_llmk_grammar;
+static LlmkGrammarRt g_llmk_grammar_rt;   // vocabulary trie + mask cache, built once per boot
+static int           g_llmk_grammar_on = 0;
 
-        if (best_id >= 0) {
-            if (*n_tokens >= max_tokens) break;
-            tokens[(*n_tokens)++] = best_id;
-            str += best_len;
-        } else {
-            char single[2]; // SAFE: 1 char + NUL
-            single[0] = *str;
-            single[1] = '\0'; // SAFE: fixed-size local buffer
-            int id = str_lookup(single, t->vocab, t->vocab_size);
-            if (id >= 0) {
-                if (*n_tokens >= max_tokens) break;
-                tokens[(*n_tokens)++] = id;
-            }
-            str++;
+static int llmk_grammar_piece_cb(void *ctx, int id, char *out, int cap) {
+    return llmk_tok_decode((const Tokenizer *)ctx, id, out, cap);
+}
+
+static int llmk_grammar_stop_cb(void *ctx, int id) {
+    return llmk_tok_is_stop((const Tokenizer *)ctx, id);
+}
+
+// Compiles GBNF text (or a JSON schema when is_schema) and enables it. The
+// trie lives in the weights arena, so it is built on first use and kept.
+static EFI_STATUS llmk_grammar_set(const char *text, int n, int is_schema, const Tokenizer *t, const Config *p) {
+    static char gbnf[LLMK_GRAMMAR_TEXT_MAX];
+    if (!t || !t->vocab) return EFI_NOT_READY;
+    if (is_schema) {
+        char err[96];
+        int gn = llmk_grammar_from_json_schema(text, n, gbnf, (int)sizeof(gbnf), err, (int)sizeof(err));
+        if (gn < 0) {
+            Print(L"\r\nERROR: schema: %a\r\n\r\n", err);
+            return EFI_COMPROMISED_DATA;
+        }
+        text = gbnf;
+        n = gn;
+    }
+    if (llmk_grammar_parse(&g_llmk_grammar, text, n) != LLMK_GRAMMAR_OK) {
+        Print(L"\r\nERROR: grammar: %a\r\n\r\n", g_llmk_grammar.err);
+        g_llmk_grammar_on = 0;
+        return EFI_COMPROMISED_DATA;
+    }
+    if (!g_llmk_grammar_rt.node) {
+        UINT64 bytes = llmk_grammar_rt_bytes(p->vocab_size, llmk_grammar_piece_cb, (void *)t);
+        void *mem = llmk_alloc_weights(bytes, L"grammar");
+        if (!mem) return EFI_OUT_OF_RESOURCES;
+        if (llmk_grammar_rt_init(&g_llmk_grammar_rt, mem, bytes, p->vocab_size, llmk_grammar_piece_cb,
+                                 llmk_grammar_stop_cb, (void *)t) != LLMK_GRAMMAR_OK) {
+            return EFI_OUT_OF_RESOURCES;
         }
     }
+    llmk_grammar_rt_start(&g_llmk_grammar_rt, &g_llmk_grammar);
+    g_llmk_grammar_on = 1;
+    return EFI_SUCCESS;
+}
+
+static EFI_STATUS llmk_grammar_load(const CHAR16 *name, int is_schema, const Tokenizer *t, const Config *p) {
+    void *raw = NULL;
+    UINTN raw_len = 0;
+    EFI_STATUS st = llmk_read_entire_file_best_effort(name, &raw, &raw_len);
+    if (EFI_ERROR(st)) return st;
+    st = (raw_len < LLMK_GRAMMAR_TEXT_MAX) ? llmk_grammar_set((const char *)raw, (int)raw_len, is_schema, t, p)
+                                           : EFI_BUFFER_TOO_SMALL;
+    uefi_call_wrapper(BS->FreePool, 1, raw);
+    return st;
 }
 
 // ============================================================================
@@ -5395,6 +5133,10 @@ static const llmk_cmd_help_entry g_llmk_cmd_help[] = {
     { "/zones", L"Dump allocator zones + sentinel" },
     { "/budget", L"Set budgets in cycles (p=prefill, d=decode)" },
     { "/attn", L"Force attention SIMD path: auto|sse2|avx2" },
+    { "/shortlist", L"Low-rank classifier shortlist: load [file]|on|off|k <n>" },
+    { "/mixq", L"Mixed-precision plan (.lkmx): load [file]|on|off" },
+    { "/grammar", L"Constrained decoding: json|off|load <file.gbnf>|schema <file.json>" },
+    { "/spec", L"Speculative decoding: draft k tokens from the context (0 = off)" },
     { "/test_failsafe", L"One-shot strict budget trip" },
     { "/ctx", L"Show model + sampling + budgets" },
     { "/cfg", L"Show effective repl.cfg settings" },
@@ -5480,6 +5222,7 @@ static const llmk_cmd_help_entry g_llmk_cmd_help[] = {
 
     { "/reset", L"Clear budgets/log + untrip sentinel" },
     { "/clear", L"Clear KV cache (reset conversation context)" },
+    { "/kvwin", L"KV window on overflow: /kvwin [on|off|sinks N|discard N|fold on|off]" },
     { "/djibmarks", L"Show DjibMark execution trace" },
     { "/djibperf", L"DjibMark performance analysis by phase" },
     { "/djibion_on", L"Enable Djibion (observe mode)" },
@@ -5537,11 +5280,23 @@ static const llmk_cmd_help_entry g_llmk_cmd_help[] = {
     { "/oo_status", L"Show OO organism engines status" },
 
     { "/smp_status",   L"Show SMP multicore status (cores, roles, mailbox)" },
+    { "/smp_workers",  L"Start AP work-queue workers: /smp_workers [max]" },
+    { "/smp_bench",    L"Work-queue dispatch latency/throughput: /smp_bench [items]" },
+    { "/lora_status",  L"List resident LoRA adapters (slots, rank, fused/merged)" },
+    { "/lora_new",     L"Create a LoRA adapter on all projections: /lora_new [rank]" },
+    { "/lora_use",     L"Hot-swap LoRA adapter: /lora_use <slot|off> [merge]" },
+    { "/lora_merge",   L"Fold active LoRA into weights (/lora_unmerge restores)" },
     { "/nfs_save",     L"Persist NFS2 key-value store to disk (OONFS2.BIN)" },
     { "/nfs_list",     L"List all NFS2 records (key + write count + preview)" },
     { "/nfs_get",      L"Read NFS2 record:  /nfs_get <key>" },
     { "/nfs_set",      L"Write NFS2 record: /nfs_set <key> <value>" },
     { "/nfs_del",      L"Delete NFS2 record: /nfs_del <key>" },
+    { "/nfsl_stat",    L"NeuralFS log store stats (keys, log bytes, dead bytes)" },
+    { "/nfsl_get",     L"Read log-store record:  /nfsl_get <key>" },
+    { "/nfsl_set",     L"Write log-store record: /nfsl_set <key> <value>" },
+    { "/nfsl_del",     L"Delete log-store record: /nfsl_del <key>" },
+    { "/nfsl_compact", L"Compact the log store and rewrite its segments" },
+    { "/nfsl_save",    L"Flush unsaved log-store records to NFSL*.LOG" },
     { "/dream_status", L"Show Dreamion stats (AP1 idle, deep cycles, synth pairs, DNA mutations)" },
     { "/dream_flush",  L"Flush AP1 Dreamion JSONL training buffer to OO_DREAM.JSONL" },
     { "/oo_train",        L"Trigger in-situ self-training cycle (OO_DREAM.JSONL + DIOP_EXP.JSONL)" },
@@ -5698,6 +5453,10 @@ static void llmk_try_tab_complete_command(CHAR16 *buffer, int max_len, int *io_p
         "/zones",
         "/budget",
         "/attn",
+        "/shortlist",
+        "/mixq",
+        "/grammar",
+        "/spec",
         "/test_failsafe",
         "/ctx",
         "/log",
@@ -5769,6 +5528,7 @@ static void llmk_try_tab_complete_command(CHAR16 *buffer, int max_len, int *io_p
         "/autorun_stop",
         "/reset",
         "/clear",
+        "/kvwin",
         "/version",
         "/diag",
         "/djibmarks",
@@ -5794,6 +5554,13 @@ static void llmk_try_tab_complete_command(CHAR16 *buffer, int max_len, int *io_p
         "/diopion_burst",
         "/diopion_status",
         "/smp_status",
+        "/smp_workers",
+        "/smp_bench",
+        "/lora_status",
+        "/lora_new",
+        "/lora_use",
+        "/lora_merge",
+        "/lora_unmerge",
         "/nfs_save",
         "/nfs_list",
         "/nfs_get",
@@ -5944,6 +5711,9 @@ void read_user_input(CHAR16* buffer, int max_len) {
              EFI_STATUS Status = uefi_call_wrapper(ST->ConIn->ReadKeyStroke, 2, ST->ConIn, &Key);
              if (!EFI_ERROR(Status)) break;
              InterfaceFx_Tick(); // Animate Desktop
+             if (g_oit.par) oit_par_poll(g_oit.par); // AP training: optimizer step on the BSP
+             if (g_oit_dream.ready) oit_dream_poll(&g_oit_dream); // idle-time dream consolidation
+             if (g_soma_emb_ready) soma_emb_index_maintain(&g_soma_emb); // deferred recall index training
              uefi_call_wrapper(BS->Stall, 1, 10000); // 10ms stall
         }
         // UINTN index;
@@ -6096,6 +5866,8 @@ void reset_kv_cache(RunState* s, Config* p) {
         s->value_cache[i] = 0.0f;
     }
     
+    llmk_kvw_reset(&g_llmk_kvw);
+
     // M16.1: Track KV cache resets
     g_metrics.kv_cache_resets++;
 }
@@ -7538,20 +7310,25 @@ static void llmk_oo_consult_execute(Config *config, TransformerWeights *weights,
             context_tokens[n_context++] = prompt_tokens[i];
         }
 
+        // Own RNG stream (seeded from the REPL's): the consult no longer
+        // advances the REPL's draws
+        LlmkSampler sampler;
+        sampler.seed = g_sample_seed;
+        sampler.draws = 0;
+
         for (int step = 0; step < max_sugg_tokens; step++) {
             int n_recent = n_context;
             if (n_recent > 64) n_recent = 64;
             int *recent = (n_recent > 0) ? &context_tokens[n_context - n_recent] : (int *)0;
 
-            int next = sample_advanced(state->logits, config->vocab_size,
-                                       consult_temp, consult_min_p, consult_top_p, consult_top_k,
-                                       recent, n_recent, consult_repeat_penalty);
-            if (next == TOKEN_EOS) break;
+            int next = llmk_sample(&sampler, state->logits, config->vocab_size,
+                                   consult_temp, consult_min_p, consult_top_p, consult_top_k,
+                                   recent, n_recent, consult_repeat_penalty);
+            if (tokenizer ? llmk_tok_is_stop(tokenizer, next) : next == TOKEN_EOS) break;
 
-            char *piece = (tokenizer && tokenizer->vocab) ? tokenizer->vocab[next] : NULL;
-            if (piece) {
-                char decoded2[8];
-                int dlen2 = llmk_decode_piece(piece, decoded2, (int)sizeof(decoded2));
+            if (tokenizer && tokenizer->vocab) {
+                char decoded2[64];
+                int dlen2 = llmk_tok_decode(tokenizer, next, decoded2, (int)sizeof(decoded2));
                 for (int k = 0; k < dlen2 && llm_len + 1 < (int)sizeof(llm_suggestion); k++) {
                     llm_suggestion[llm_len++] = decoded2[k];
                 }
@@ -283,6 +283,8 @@ static const CHAR16* oo_mode_name_w(int mode, int engine_type) {
 
 // Forward decl: used by early repl.cfg loaders before definition.
 static int llmk_cfg_parse_bool(const char *s, int *out);
+static int llmk_cfg_parse_i32(const char *s, int *out);
+static int llmk_cfg_parse_f32(const char *s, float *out);
 
 static int djibion_should_block(const DjibionEngine *e, const DjibionDecision *d) {
     if (!e || !d) return 0;
@@ -303,15 +305,6 @@ static int djibion_should_block(const DjibionEngine *e, const DjibionDecision *d
 #define TOKEN_BOS 1
 #define TOKEN_EOS 2
 
-static int has_suffix_repeat(const int* tokens, int n_tokens, int span) {
-    if (span <= 0) return 0;
-    if (n_tokens < 2 * span) return 0;
-    for (int i = 0; i < span; i++) {
-        if (tokens[n_tokens - span + i] != tokens[n_tokens - 2 * span + i]) return 0;
-    }
-    return 1;
-}
-
 // AVX2 attention helpers live in attention_avx2.c (compiled with -mavx2)
 float llmk_dot_f32_avx2(const float *a, const float *b, int n);
 void llmk_axpy_f32_avx2(float *dst, const float *src, float alpha, int n);
@@ -474,6 +467,139 @@ static void llmk_shutdown_best_effort(void) {
 #endif
 }
 
+// -----------------------------------------------------------------------------
+// Token output ring (oo_tok_stream): between llmk_stream_begin/end the decode
+// loop's token bytes go into g_tok_stream and reach ConOut as one
+// OutputString per flushed chunk instead of one per token. Serial, a
+// transcript file and a UDP listener can receive the same bytes.
+// -----------------------------------------------------------------------------
+#include "oo_tok_stream.h"
+#include "oo_tok_stream.c"
+
+#define LLMK_STREAM_NET_PORT  42421   // OO_NET_SWARM_PORT + 1
+#define LLMK_STREAM_FILE      L"llmk-stream.txt"
+
+static OtsStream g_tok_stream;
+static int g_stream_ready = 0;
+static int g_stream_enabled = 1;        // /stream on|off
+static int g_stream_active = 0;         // inside a generation
+static UINT32 g_stream_flush_ms = 50;   // TSC trigger; 0 = bytes/tokens/newline only
+static UINT32 g_stream_flush_tokens = 8;
+static int g_stream_serial = 0;         // mirror raw UTF-8 to COM1
+static int g_stream_log = 0;            // append to LLMK_STREAM_FILE
+static int g_stream_net = 0;            // UDP broadcast to LLMK_STREAM_NET_PORT
+static int g_stream_sink_serial = -1, g_stream_sink_file = -1, g_stream_sink_net = -1;
+static EFI_FILE_HANDLE g_stream_file = NULL;
+static UINT64 g_stream_flush_cycles = 0; // TSC spent draining, last generation
+static UINT32 g_stream_flushes0 = 0;     // g_tok_stream.flushes at llmk_stream_begin
+
+static EFI_STATUS llmk_file_write_bytes(EFI_FILE_HANDLE f, const void *buf, UINTN nb);
+
+static void llmk_stream_conout(void *ctx, const uint16_t *s, uint32_t n) {
+    (void)ctx; (void)n;
+    uefi_call_wrapper(ST->ConOut->OutputString, 2, ST->ConOut, (CHAR16 *)s);
+}
+
+static void llmk_stream_serial(void *ctx, const uint8_t *b, uint32_t n) {
+    (void)ctx;
+#if defined(__x86_64__) || defined(_M_X64)
+    for (uint32_t i = 0; i < n; i++) {
+        if (b[i] == '\n') llmk_serial_putc('\r');
+        llmk_serial_putc(b[i]);
+    }
+#else
+    (void)b; (void)n;
+#endif
+}
+
+static void llmk_stream_file(void *ctx, const uint8_t *b, uint32_t n) {
+    (void)ctx;
+    if (g_stream_file) llmk_file_write_bytes(g_stream_file, b, n);
+}
+
+static void llmk_stream_net(void *ctx, const uint8_t *b, uint32_t n) {
+    (void)ctx;
+    if (!g_oo_net.ip_ready) return;
+    while (n) {
+        UINT16 take = n > 1024 ? 1024 : (UINT16)n;
+        oo_net_udp_send(OO_IP_BCAST, LLMK_STREAM_NET_PORT, LLMK_STREAM_NET_PORT, b, take);
+        b += take;
+        n -= take;
+    }
+}
+
+static void llmk_stream_init_once(void) {
+    if (g_stream_ready) return;
+    ots_init(&g_tok_stream);
+    ots_add_ucs2_sink(&g_tok_stream, llmk_stream_conout, NULL);
+    g_stream_sink_serial = ots_add_utf8_sink(&g_tok_stream, llmk_stream_serial, NULL);
+    g_stream_sink_file = ots_add_utf8_sink(&g_tok_stream, llmk_stream_file, NULL);
+    g_stream_sink_net = ots_add_utf8_sink(&g_tok_stream, llmk_stream_net, NULL);
+    g_stream_ready = 1;
+}
+
+// Start buffering token output for one generation. tsc_hz converts
+// g_stream_flush_ms into the ring's TSC trigger (0 disables it).
+static void llmk_stream_begin(UINT64 tsc_hz) {
+    if (!g_stream_enabled) return;
+    llmk_stream_init_once();
+    ots_set_cadence(&g_tok_stream, 256, g_stream_flush_tokens,
+                    tsc_hz ? (tsc_hz / 1000ULL) * g_stream_flush_ms : 0, 1);
+    ots_sink_enable(&g_tok_stream, g_stream_sink_serial, g_stream_serial);
+    ots_sink_enable(&g_tok_stream, g_stream_sink_net, g_stream_net);
+    if (g_stream_log && !g_stream_file && g_root) {
+        // Append: open (create if missing) and seek to the end.
+        EFI_FILE_HANDLE f = NULL;
+        EFI_STATUS st = uefi_call_wrapper(g_root->Open, 5, g_root, &f, (CHAR16 *)LLMK_STREAM_FILE,
+                                          EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE, 0);
+        if (!EFI_ERROR(st) && f) {
+            uefi_call_wrapper(f->SetPosition, 2, f, 0xFFFFFFFFFFFFFFFFULL);
+            g_stream_file = f;
+        }
+    }
+    ots_sink_enable(&g_tok_stream, g_stream_sink_file, g_stream_file != NULL);
+    g_stream_flush_cycles = 0;
+    g_stream_flushes0 = g_tok_stream.flushes;
+    g_stream_active = 1;
+}
+
+// Drain everything, including a dangling partial UTF-8 sequence.
+static void llmk_stream_end(void) {
+    if (!g_stream_active) return;
+    UINT64 t0 = __rdtsc();
+    ots_finish(&g_tok_stream, t0);
+    g_stream_flush_cycles += __rdtsc() - t0;
+    g_stream_active = 0;
+    if (g_stream_file) {
+        static const char nl[2] = { '\r', '\n' };
+        llmk_file_write_bytes(g_stream_file, nl, 2);
+        uefi_call_wrapper(g_stream_file->Close, 1, g_stream_file);
+        g_stream_file = NULL;
+    }
+}
+
+// Push buffered tokens out before anything else writes to the console.
+static void llmk_stream_sync(void) {
+    if (!g_stream_active) return;
+    UINT64 t0 = __rdtsc();
+    ots_flush(&g_tok_stream, t0);
+    g_stream_flush_cycles += __rdtsc() - t0;
+}
+
+// Sink for uefi_print_utf8_bytes: the ring while a generation streams,
+// ConOut directly otherwise.
+static void llmk_out_utf8(const unsigned char *p, int len) {
+    if (len <= 0) return;
+    if (!g_stream_active) {
+        uefi_print_utf8_decode(p, len);
+        return;
+    }
+    UINT64 t0 = __rdtsc();
+    UINT32 flushes = g_tok_stream.flushes;
+    ots_write(&g_tok_stream, p, (uint32_t)len, t0);
+    if (g_tok_stream.flushes != flushes) g_stream_flush_cycles += __rdtsc() - t0;
+}
+
 // Some generations still contain a classic mojibake sequence for U+2019 (RIGHT SINGLE QUOTATION MARK).
 // This can span token boundaries, so keep a small byte tail and repair across calls.
 static unsigned char g_utf8_repair_tail[5]; // SAFE: tail buffer for cross-call UTF-8 repair; bounded by keep=5
@@ -483,51 +609,6 @@ static int g_utf8_repair_tail_len = 0;
 // so we can render it later in the GOP UI.
 static void llmk_tr_append_ascii_bytes(const unsigned char *bytes, int len);
 
-// ============================================================
-// llmk_decode_piece — convert raw vocab token string to printable bytes
-// Handles SentencePiece conventions:
-//   1. "<0xNN>" byte tokens → actual byte value
-//   2. "▁" (U+2581, 3 bytes E2 96 81) leading space → ' '
-//   3. Raw string → returned as-is
-// out_buf must be at least 4 bytes. Returns actual byte count.
-// ============================================================
-static int llmk_decode_piece(const char *piece, char *out_buf, int out_size) {
-    if (!piece || !out_buf || out_size <= 0) return 0;
-
-    int len = 0;
-    while (piece[len]) len++;
-    if (len == 0) return 0;
-
-    // Case 1: byte token "<0xNN>" (exactly 6 chars)
-    if (len == 6 && piece[0] == '<' && piece[1] == '0' && piece[2] == 'x' && piece[5] == '>') {
-        char hi = piece[3], lo = piece[4];
-        int hv = (hi >= '0' && hi <= '9') ? hi-'0' : (hi >= 'a' && hi <= 'f') ? hi-'a'+10 : (hi >= 'A' && hi <= 'F') ? hi-'A'+10 : -1;
-        int lv = (lo >= '0' && lo <= '9') ? lo-'0' : (lo >= 'a' && lo <= 'f') ? lo-'a'+10 : (lo >= 'A' && lo <= 'F') ? lo-'A'+10 : -1;
-        if (hv >= 0 && lv >= 0 && out_size >= 1) {
-            out_buf[0] = (char)((hv << 4) | lv);
-            return 1;
-        }
-    }
-
-    // Case 2: SentencePiece leading "▁" (U+2581 = E2 96 81) → space
-    // Replace only the leading ▁; keep remaining bytes as-is
-    if (len >= 3 && (unsigned char)piece[0] == 0xE2 &&
-                    (unsigned char)piece[1] == 0x96 &&
-                    (unsigned char)piece[2] == 0x81) {
-        int rest = len - 3;
-        if (out_size < 1 + rest) rest = out_size - 1;
-        if (rest < 0) rest = 0;
-        if (out_size >= 1) out_buf[0] = ' ';
-        for (int i = 0; i < rest; i++) out_buf[1 + i] = piece[3 + i];
-        return 1 + rest;
-    }
-
-    // Case 3: raw string — copy up to out_size bytes
-    int copy = len < out_size ? len : out_size;
-    for (int i = 0; i < copy; i++) out_buf[i] = piece[i];
-    return copy;
-}
-
 
 static void uefi_print_utf8_bytes(const char *bytes, int len) {
     if (!bytes || len <= 0) return;
@@ -610,7 +691,7 @@ static void uefi_print_utf8_bytes(const char *bytes, int len) {
 
         // Decode+print processed bytes.
         llmk_tr_append_ascii_bytes(outbuf, outlen);
-        uefi_print_utf8_decode(outbuf, outlen);
+        llmk_out_utf8(outbuf, outlen);
 
         // If we ever filled the buffer before consuming all of upto, drop the remainder to avoid
         // stalling. This should be extremely rare with typical tokenizer pieces.
@@ -618,15 +699,17 @@ static void uefi_print_utf8_bytes(const char *bytes, int len) {
         if (j < upto) {
             // best-effort: continue printing remaining bytes directly (no repair inside this chunk)
             llmk_tr_append_ascii_bytes(inbuf + j, upto - j);
-            uefi_print_utf8_decode(inbuf + j, upto - j);
+            llmk_out_utf8(inbuf + j, upto - j);
         }
     }
 }
 
 static void uefi_print_utf8_flush(void) {
-    if (g_utf8_repair_tail_len <= 0) return;
-    uefi_print_utf8_decode(g_utf8_repair_tail, g_utf8_repair_tail_len);
-    g_utf8_repair_tail_len = 0;
+    if (g_utf8_repair_tail_len > 0) {
+        llmk_out_utf8(g_utf8_repair_tail, g_utf8_repair_tail_len);
+        g_utf8_repair_tail_len = 0;
+    }
+    llmk_stream_sync();
 }
 
 // Best-effort: enable AVX state (OSXSAVE + XCR0) in UEFI so AVX/AVX2 code can run.
@@ -688,84 +771,6 @@ static void enable_avx_best_effort(void) {
     }
 }
 
-static void apply_no_repeat_ngram(float* logits, int vocab_size, const int* tokens, int n_tokens, int ngram) {
-    if (ngram < 2) return;
-    if (n_tokens < ngram - 1) return;
-
-    int prefix_len = ngram - 1;
-    int prefix_start = n_tokens - prefix_len;
-    int limit = n_tokens - ngram;
-    for (int i = 0; i <= limit; i++) {
-        int match = 1;
-        for (int j = 0; j < prefix_len; j++) {
-            if (tokens[i + j] != tokens[prefix_start + j]) {
-                match = 0;
-                break;
-            }
-        }
-        if (match) {
-            int banned = tokens[i + prefix_len];
-            if (banned >= 0 && banned < vocab_size) {
-                // Large negative value to effectively zero it after softmax.
-                logits[banned] = -1.0e9f;
-            }
-        }
-    }
-}
-
-static inline float dot_f32_sse2(const float* a, const float* b, int n) {
-#if defined(__x86_64__) || defined(_M_X64)
-    __m128 sum = _mm_setzero_ps();
-    int i = 0;
-    for (; i + 4 <= n; i += 4) {
-        __m128 va = _mm_loadu_ps(a + i);
-        __m128 vb = _mm_loadu_ps(b + i);
-        sum = _mm_add_ps(sum, _mm_mul_ps(va, vb));
-    }
-    float tmp[4]; // SAFE: fixed-size SSE2 lane store
-    _mm_storeu_ps(tmp, sum);
-    float total = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-    for (; i < n; i++) total += a[i] * b[i];
-    return total;
-#else
-    float total = 0.0f;
-    for (int i = 0; i < n; i++) total += a[i] * b[i];
-    return total;
-#endif
-}
-
-static inline void axpy_f32_sse2(float* dst, const float* src, float a, int n) {
-#if defined(__x86_64__) || defined(_M_X64)
-    __m128 va = _mm_set1_ps(a);
-    int i = 0;
-    for (; i + 4 <= n; i += 4) {
-        __m128 vd = _mm_loadu_ps(dst + i);
-        __m128 vs = _mm_loadu_ps(src + i);
-        vd = _mm_add_ps(vd, _mm_mul_ps(va, vs));
-        _mm_storeu_ps(dst + i, vd);
-    }
-    for (; i < n; i++) dst[i] += a * src[i];
-#else
-    for (int i = 0; i < n; i++) dst[i] += a * src[i];
-#endif
-}
-
-static inline float dot_f32_best(const float* a, const float* b, int n) {
-    int use_avx2 = g_attn_use_avx2;
-    if (g_attn_force == 0) use_avx2 = 0;
-    else if (g_attn_force == 1) use_avx2 = 1;
-    if (use_avx2) return llmk_dot_f32_avx2(a, b, n);
-    return dot_f32_sse2(a, b, n);
-}
-
-static inline void axpy_f32_best(float* dst, const float* src, float a, int n) {
-    int use_avx2 = g_attn_use_avx2;
-    if (g_attn_force == 0) use_avx2 = 0;
-    else if (g_attn_force == 1) use_avx2 = 1;
-    if (use_avx2) { llmk_axpy_f32_avx2(dst, src, a, n); return; }
-    axpy_f32_sse2(dst, src, a, n);
-}
-
 // ============================================================================
 // HEAP ALLOCATOR
 // ============================================================================
@@ -820,6 +825,10 @@ static ssm_f32 *g_oosi_halt_h2  = NULL;  // [64]
 static OosiV3Weights  g_oosi_v3_weights;
 static OosiV3GenCtx   g_oosi_v3_ctx;
 static int            g_oosi_v3_valid = 0;
+// Tensor-parallel decode over the AP work queue (/ssm_tp); re-attached
+// after /ssm_load while g_oosi_v3_tp_slices > 1
+static OosiV3Tp       g_oosi_v3_tp;
+static int            g_oosi_v3_tp_slices = 0;
 
 // v3 scratch buffers — allocated from zones arenas on first /ssm_load
 static ssm_f32 *g_v3_scratch   = NULL;   // [D + 4*Di + Dt + 2*S] ≈ 91 KB
@@ -860,7 +869,8 @@ static SomaSwarmResult g_soma_swarm_last; // Last vote result (for fitness updat
 static SomaReflexCtx   g_soma_reflex;
 static SomaLogicCtx    g_soma_logic;
 static SomaMemCtx      g_soma_memory;
-// Phase I: persistent journal (autosave counter)
+// Phase I: persistent journal (append-only log, group flush)
+static SomaJournal     g_soma_journal;
 static unsigned int    g_soma_journal_total_turns = 0;  // cumulative across sessions
 static int             g_soma_journal_turns_since_save = 0;
 // Phase J: oo-model cortex (small OOSS routing brain)
@@ -879,8 +889,159 @@ static OoSwarmNode     g_swarm_node;
 static OoSwarmSync     g_swarm_sync;
 // Phase Z: Persistent Key-Value store (NeuralFS v2)
 static Nfs2Store       g_nfs2_store;
+// Phase H2: semantic recall — embedding index over NFSL "mem.e" records
+static SomaEmbIndex    g_soma_emb;
+static SomaEmbPool     g_soma_emb_pool;
+static int             g_soma_emb_ready = 0;
+static uint32_t        g_soma_emb_next_id = 0;
+static int8_t          g_soma_emb_query[SOMA_EMB_DIM];  // embedding of the current prompt
+static int             g_soma_emb_query_ok = 0;
+static uint32_t        g_soma_emb_dropped = 0;          // memories the log or index had no room for
 // ─────────────────────────────────────────────────────────────────────────────
 
+// ── Phase H2: semantic recall helpers ───────────────────────────────────────
+// NFSL value for key "mem.e<8 hex id>": SomaEmbRec, then prompt\0 response\0.
+#define SOMA_EMB_BOOT_CAP     16384  // index entries allocated from Zone C
+#define SOMA_EMB_POOL_TOKENS  64     // prompt tokens pooled per embedding
+#define SOMA_EMB_RECALL_K     4
+#define SOMA_EMB_RECALL_MIN   (SOMA_EMB_ONE * 3 / 4)   // cosine ≥ 0.75
+#define SOMA_EMB_DOMAIN_BONUS (SOMA_EMB_ONE / 20)      // SMB domain agreement
+
+typedef struct {
+    int8_t   emb[SOMA_EMB_DIM];   // raw embedding: the index centres on load
+    int32_t  turn;
+    uint32_t smb_hash;      // soma_smb_hash of the prompt (links to the SMB slot)
+    uint8_t  domain;        // SomaDomain at record time
+    uint8_t  _pad[3];
+} SomaEmbRec;
+
+// Largest "mem.e" value: the prompt is cut to what soma_memory_recall keeps
+#define SOMA_EMB_REC_MAX  (sizeof(SomaEmbRec) + SOMA_MEM_PROMPT_LEN + SOMA_MEM_RESPONSE_LEN)
+
+// NFSL sizing for a recall index of cap entries: the boot log and index plus
+// one largest record and one key per entry, at the index load limit.
+static void llmk_soma_emb_nfsl_size(uint32_t cap, uint32_t *log_bytes, uint32_t *slots) {
+    uint32_t keys = NFSL_BOOT_INDEX_SLOTS / NFSL_INDEX_LOAD_DEN * NFSL_INDEX_LOAD_NUM + cap;
+    uint32_t n = NFSL_BOOT_INDEX_SLOTS;
+    while (n / NFSL_INDEX_LOAD_DEN * NFSL_INDEX_LOAD_NUM < keys) n <<= 1;
+    *log_bytes = NFSL_BOOT_LOG_BYTES + cap * nfsl_rec_size(13, (uint32_t)SOMA_EMB_REC_MAX);
+    *slots = n;
+}
+
+static int llmk_soma_emb_key(char *buf, uint32_t id) {
+    static const char hx[] = "0123456789abcdef";
+    const char *pfx = "mem.e";
+    int n = 0;
+    while (pfx[n]) { buf[n] = pfx[n]; n++; }
+    for (int i = 7; i >= 0; i--) buf[n++] = hx[(id >> (i * 4)) & 0xF];
+    buf[n] = 0;
+    return n;
+}
+
+// Pool the model's final hidden state over the prompt tokens. Clobbers the
+// v3 recurrent state — callers reset it before the real prefill anyway.
+static int llmk_soma_emb_embed(const int *tokens, int n_tokens, int8_t *out) {
+    if (!g_oosi_v3_valid || n_tokens <= 0) return -1;
+    if (n_tokens > SOMA_EMB_POOL_TOKENS) n_tokens = SOMA_EMB_POOL_TOKENS;
+    int D = g_oosi_v3_weights.d_model;
+    oosi_v3_gen_ctx_reset(&g_oosi_v3_ctx);
+    soma_emb_pool_reset(&g_soma_emb_pool, D);
+    for (int i = 0; i < n_tokens; i++)
+        soma_emb_pool_add(&g_soma_emb_pool, oosi_v3_forward_hidden(&g_oosi_v3_ctx, tokens[i]), D);
+    return soma_emb_pool_finish(&g_soma_emb_pool, out);
+}
+
+// Top-k search + SMB domain rerank. Fills *out (triggered=1) on a hit.
+static int llmk_soma_emb_recall(const int8_t *q, SomaDomain domain, SomaMemResult *out) {
+    SomaEmbHit hits[SOMA_EMB_RECALL_K];
+    int nh = soma_emb_index_search(&g_soma_emb, q, SOMA_EMB_RECALL_K, 0, hits);
+    const unsigned char *best = 0;
+    uint32_t best_len = 0;
+    int32_t best_score = 0;
+    SomaEmbRec rec;
+    for (int i = 0; i < nh; i++) {
+        if (hits[i].score < SOMA_EMB_RECALL_MIN) break;
+        char key[16];
+        int kl = llmk_soma_emb_key(key, hits[i].id);
+        uint32_t vl = 0;
+        const unsigned char *v = (const unsigned char *)nfsl_get(&g_nfsl, key, (uint32_t)kl, &vl);
+        if (!v || vl < sizeof(SomaEmbRec) + 2) continue;
+        // Values sit unaligned in the log — copy the header out
+        SomaEmbRec h;
+        for (uint32_t b = 0; b < sizeof(h); b++) ((unsigned char *)&h)[b] = v[b];
+        int32_t sc = hits[i].score + (h.domain == (uint8_t)domain ? SOMA_EMB_DOMAIN_BONUS : 0);
+        if (!best || sc > best_score) { best = v; best_len = vl; best_score = sc; rec = h; }
+    }
+    if (!best) return 0;
+
+    // Text tail: prompt\0 response\0 (written by llmk_soma_emb_store)
+    const char *txt = (const char *)(best + sizeof(SomaEmbRec));
+    uint32_t tl = best_len - (uint32_t)sizeof(SomaEmbRec);
+    uint32_t pl = 0;
+    while (pl < tl && txt[pl]) pl++;
+    if (pl + 1 >= tl || txt[tl - 1]) return 0;
+    int sim = (int)(best_score * 100 / SOMA_EMB_ONE);
+    if (sim > 100) sim = 100;
+    *out = soma_memory_recall(&g_soma_memory, rec.turn, txt, txt + pl + 1, sim);
+    return out->triggered;
+}
+
+// Persist one interaction under a fresh id and index its embedding. A full
+// log or index drops the memory: reported once, counted in /soma_memory_stats.
+static void llmk_soma_emb_store(const int8_t *emb, const char *prompt, const char *response,
+                                int turn, uint32_t smb_hash, SomaDomain domain) {
+    static union {
+        SomaEmbRec    rec;
+        unsigned char bytes[SOMA_EMB_REC_MAX];
+    } u;
+    SomaEmbRec *rec = &u.rec;
+    unsigned char *buf = u.bytes;
+    for (int i = 0; i < SOMA_EMB_DIM; i++) rec->emb[i] = emb[i];
+    rec->turn = turn;
+    rec->smb_hash = smb_hash;
+    rec->domain = (uint8_t)domain;
+    rec->_pad[0] = rec->_pad[1] = rec->_pad[2] = 0;
+    uint32_t n = sizeof(SomaEmbRec);
+    for (int i = 0; prompt[i] && i < SOMA_MEM_PROMPT_LEN - 1; i++) buf[n++] = (unsigned char)prompt[i];
+    buf[n++] = 0;
+    for (int i = 0; response[i] && i < SOMA_MEM_RESPONSE_LEN - 1; i++) buf[n++] = (unsigned char)response[i];
+    buf[n++] = 0;
+
+    char key[16];
+    uint32_t id = g_soma_emb_next_id;
+    int kl = llmk_soma_emb_key(key, id);
+    // Index first: a record it cannot hold would not be recalled after reboot either
+    int rc = (g_soma_emb.n >= g_soma_emb.cap) ? NFSL_ERR_NOSPACE : nfsl_put(&g_nfsl, key, (uint32_t)kl, buf, n);
+    if (rc != NFSL_OK) {
+        if (g_soma_emb_dropped++ == 0) {
+            Print(L"\r\n[SomaEmbed] WARNING: memory not stored (%s full at %u memories)\r\n",
+                  g_soma_emb.n >= g_soma_emb.cap ? L"index" : (rc == NFSL_ERR_INDEX ? L"NFSL index" : L"NFSL log"),
+                  g_soma_emb.n);
+        }
+        return;
+    }
+    g_soma_emb_next_id++;
+    soma_emb_index_add(&g_soma_emb, emb, id);
+}
+
+// nfsl_foreach visitor: re-index persisted "mem.e" records at boot.
+static int llmk_soma_emb_rebuild_visit(void *ctx, const char *key, uint32_t key_len,
+                                       const void *val, uint32_t val_len) {
+    (void)ctx;
+    if (key_len != 13 || key[0] != 'm' || key[1] != 'e' || key[2] != 'm' ||
+        key[3] != '.' || key[4] != 'e' || val_len < sizeof(SomaEmbRec))
+        return 0;
+    uint32_t id = 0;
+    for (int i = 5; i < 13; i++) {
+        char c = key[i];
+        id = (id << 4) | (uint32_t)(c <= '9' ? c - '0' : c - 'a' + 10);
+    }
+    // emb[] is the first field and int8, so it can be read in place
+    if (soma_emb_index_add(&g_soma_emb, (const int8_t *)val, id) != 0) return 1;
+    if (id + 1u > g_soma_emb_next_id) g_soma_emb_next_id = id + 1u;
+    return 0;
+}
+
 static const CHAR16 *llmk_soma_route_name_wide(SomaRoute route) {
     switch (route) {
         case SOMA_ROUTE_REFLEX: return L"REFLEX";
@@ -1548,6 +1709,9 @@ static int g_tui_last_tick = 0;
 static int g_tui_last_energy = 0;
 static char g_tui_last_event[64] = "";
 
+// SOMA HUD (oo_hud_final.c) drawn from llmk_oo_on_step_gop when the TUI is off.
+static int g_hud_enabled = 1;
+
 // Live generation counters (best-effort): updated during decode loop so the TUI can
 // show progress even while the terminal output is streaming.
 static int g_tui_gen_active = 0;
@@ -2906,6 +3070,7 @@ static void llmk_tui_redraw_best_effort(void) {
     g_tui_dirty = 0;
 }
 
+static int llmk_has_avx2_cached(void);   // soma_inference.c
 #include "oo_hud_final.c"
 
 static void llmk_oo_on_step_gop(int id, int tick, int energy) {
@@ -2917,23 +3082,33 @@ static void llmk_oo_on_step_gop(int id, int tick, int energy) {
     // Initialize HUD on first call if needed
     static int hud_init = 0;
     if (!hud_init) {
+        g_sw = g_gop_w;
+        g_sh = g_gop_h;
+        g_stride = g_gop_ppsl;
         init_stars();
         init_rain();
         soma_state_demo_fill(&g_soma, 1);
+        // Cached back buffer: blends no longer read the (uncached) framebuffer
+        // and only changed tiles are written to it. Without memory the HUD
+        // draws in place as before.
+        UINT64 bb_bytes = soma_hud_backbuffer_bytes(g_gop_w, g_gop_h);
+        void *bb = NULL;
+        if (bb_bytes &&
+            !EFI_ERROR(uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, (UINTN)bb_bytes, &bb)) && bb)
+            soma_hud_attach(bb, bb_bytes, g_gop_w, g_gop_h);
+        ohb_set_cpu(llmk_has_avx2_cached());
         hud_init = 1;
     }
 
     // Best-effort TUI refresh at a low cadence to avoid heavy overhead.
     if (g_tui_enabled && ((tick & 7) == 0 || g_tui_dirty)) {
         llmk_tui_redraw_best_effort();
-    } else if (!g_tui_enabled) {
+        soma_hud_invalidate();
+    } else if (!g_tui_enabled && g_hud_enabled) {
         // Mettre à jour l'état mock (pour la démonstration) puis rendre le HUD
-        g_fb = g_gop_fb32;
-        g_sw = g_gop_w;
-        g_sh = g_gop_h;
-        g_stride = g_gop_ppsl;
         soma_state_demo_fill(&g_soma, g_tick);
-        soma_render_frame();
+        soma_hud_frame(g_gop_fb32, g_gop_ppsl,
+                       g_gop_pf == PixelBlueGreenRedReserved8BitPerColor ? NULL : g_gop);
         llmk_gop_force_update();
     }
 }
@@ -5515,10 +5690,12 @@ static void llmk_print_no_model_help(void) {
     Print(L"  /soma_smb_stats       Show Synaptic Memory Bus counters\r\n");
     Print(L"  /soma_smb_dump        Dump memory bus slots (active interactions)\r\n");
     Print(L"  /soma_dream [apply]   Run dream cycle (add 'apply' to update DNA)\r\n");
+    Print(L"  /oo_dream [n|status|cancel]  Consolidate recent turns into the LoRA adapter while idle\r\n");
     Print(L"  /soma_meta            Show meta-evolution fitness history\r\n");
     Print(L"  /soma_evolve          Force fitness score + DNA mutation step\r\n");
     Print(L"  /multireal [on|off|status]  3-way token selection (solar/lunar/argmax)\r\n");
     Print(L"  /specdecode [on|off|status|threshold <x>]  Speculative decoding (Phase W)\r\n");
+    Print(L"  /stream [on|off|ms <n>|tokens <n>|serial|log|net [0|1]]  Buffered token output + sinks\r\n");
     Print(L"  /swarm_net [on|off|status|peer <id>|addr <hex>]  Distributed peer consensus (Phase Y)\r\n");
     Print(L"  /soma_swarm [0|1]     Enable/disable swarm voting\r\n");
     Print(L"  /soma_swarm_stats     Show per-agent fitness and vote counts\r\n");
@@ -5530,10 +5707,10 @@ static void llmk_print_no_model_help(void) {
     Print(L"  /soma_memory [0|1]    Enable/disable session memory reflex\r\n");
     Print(L"  /soma_memory_stats    Show session memory ring buffer stats\r\n");
     Print(L"  /soma_memory_test <prompt>  Test memory scan on a prompt\r\n");
-    Print(L"  /soma_journal_save    Force-save session journal to soma_journal.bin\r\n");
-    Print(L"  /soma_journal_load    Reload journal from disk into memory buffer\r\n");
-    Print(L"  /soma_journal_clear   Erase soma_journal.bin (fresh start)\r\n");
-    Print(L"  /soma_journal_stats   Show journal file stats (turns, sessions, entries)\r\n");
+    Print(L"  /soma_journal_save    Flush batched turns to the journal log (SJ*.LOG)\r\n");
+    Print(L"  /soma_journal_load    Replay journal log into memory buffer\r\n");
+    Print(L"  /soma_journal_clear   Erase all journal segments (fresh start)\r\n");
+    Print(L"  /soma_journal_stats   Show journal stats (turns, sessions, segments, compactions)\r\n");
     Print(L"  /cortex_load <file>   Load oo-model cortex (small OOSS 15M-130M)\r\n");
     Print(L"  /cortex_infer <text>  Run cortex only (domain+safety classification)\r\n");
     Print(L"  /cortex_stats         Show cortex load status and call stats\r\n");
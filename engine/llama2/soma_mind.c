@@ -2564,6 +2564,9 @@ int llmk_diop_orchestrate_select_model(const char *prompt) {
 static OoSelfModel g_oo_self_model;
 /* Phase F: NeuralFS v2 — persistent RAM key-value store */
 static Nfs2Store   g_nfs2;
+/* Phase F2: NeuralFS log store — hash-indexed agent memory (Zone C) */
+static NfslStore   g_nfsl;
+static int         g_nfsl_ready = 0;
 /* Phase W: Natural Language → REPL Command Router */
 static OvrEngine   g_ovr;
 /* Phase WW: Full Voice Pipeline — HDA audio */
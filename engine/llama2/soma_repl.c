@@ -175,18 +175,27 @@ static void llmk_repl_no_model_loop(void) {
     soma_reflex_init(&g_soma_reflex);
     soma_logic_init(&g_soma_logic);
     soma_memory_init(&g_soma_memory);
-    // Phase I: load persistent journal → pre-populate ring buffer
+    // Phase I: replay persistent journal log → pre-populate ring buffer
     if (g_root) {
+        void *jscratch = g_llmk_ready
+            ? llmk_arena_alloc(&g_zones, LLMK_ARENA_ZONE_C, SOMA_JOURNAL_SCRATCH_BYTES, 64)
+            : 0;
+        if (!jscratch)
+            uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData,
+                              (UINTN)SOMA_JOURNAL_SCRATCH_BYTES, &jscratch);
         unsigned int prev_turns = 0;
-        int jloaded = soma_journal_load(&g_soma_memory, g_root, &prev_turns);
-        if (jloaded > 0) {
+        int jloaded = soma_journal_init(&g_soma_journal, jscratch, SOMA_JOURNAL_SCRATCH_BYTES) == 0
+            ? soma_journal_load(&g_soma_journal, &g_soma_memory, g_root, &prev_turns)
+            : -2;
+        if (jloaded >= 0) {
             g_soma_journal_total_turns = prev_turns;
-            Print(L"[SomaJournal] Loaded %d entries from disk (total_turns=%d, sessions=%d)\r\n",
-                  jloaded, (int)prev_turns, g_soma_memory.boot_count);
+            Print(L"[SomaJournal] Replayed %d turns (total_turns=%d, sessions=%d, torn=%d)\r\n",
+                  jloaded, (int)prev_turns, g_soma_memory.boot_count,
+                  (int)g_soma_journal.log.torn);
         } else if (jloaded == -1) {
-            Print(L"[SomaJournal] No journal file found (first boot)\r\n");
+            Print(L"[SomaJournal] No journal found (first boot)\r\n");
         } else {
-            Print(L"[SomaJournal] WARNING: journal corrupt or unreadable\r\n");
+            Print(L"[SomaJournal] WARNING: journal unavailable\r\n");
         }
     }
     // Phase O: load persistent DNA → resume evolution across reboots
@@ -1422,6 +1431,17 @@ static void llmk_repl_no_model_loop(void) {
             Print(L"  turns     : %d\r\n",  g_soma_memory.total_turns);
             Print(L"  entries   : %d / %d\r\n", g_soma_memory.count, SOMA_MEM_MAX_ENTRIES);
             Print(L"  triggers  : %d\r\n",  g_soma_memory.total_triggers);
+            if (g_soma_emb_ready) {
+                Print(L"  semantic  : %u / %u vecs, %s nlist=%u, %u queries, avg scan %u\r\n",
+                      g_soma_emb.n, g_soma_emb.cap,
+                      g_soma_emb.ivf_ready ? L"ivf" : L"flat", g_soma_emb.nlist,
+                      g_soma_emb.total_queries,
+                      g_soma_emb.total_queries ? g_soma_emb.total_scanned / g_soma_emb.total_queries : 0);
+                if (g_soma_emb_dropped)
+                    Print(L"  dropped   : %u memories (log or index full)\r\n", g_soma_emb_dropped);
+            } else {
+                Print(L"  semantic  : off (needs NFSL store)\r\n");
+            }
             if (g_soma_memory.model_name[0]) {
                 Print(L"  model     : ");
                 for (int mi = 0; g_soma_memory.model_name[mi]; mi++)
@@ -1466,33 +1486,35 @@ static void llmk_repl_no_model_loop(void) {
         }
         // ── Phase I: Journal commands ────────────────────────────────────
         if (my_strncmp(prompt, "/soma_journal_save", 18) == 0) {
-            if (!g_root) { Print(L"\r\n[Journal] ERROR: no EFI root\r\n\r\n"); continue; }
-            int n = soma_journal_save(&g_soma_memory, g_root, g_soma_journal_total_turns);
+            if (!g_soma_journal.ready) { Print(L"\r\n[Journal] ERROR: journal not loaded\r\n\r\n"); continue; }
+            int n = soma_journal_save(&g_soma_journal);
             if (n >= 0)
-                Print(L"\r\n[Journal] Saved %d entries to soma_journal.bin\r\n\r\n", n);
+                Print(L"\r\n[Journal] Flushed %d records (segment %d)\r\n\r\n",
+                      n, (int)g_soma_journal.log.seg_tail);
             else
-                Print(L"\r\n[Journal] ERROR: save failed\r\n\r\n");
-            g_soma_journal_turns_since_save = 0;
+                Print(L"\r\n[Journal] ERROR: flush failed\r\n\r\n");
+            g_soma_journal_turns_since_save = (int)g_soma_journal.log.batch_turns;
             continue;
         }
         if (my_strncmp(prompt, "/soma_journal_load", 18) == 0) {
-            if (!g_root) { Print(L"\r\n[Journal] ERROR: no EFI root\r\n\r\n"); continue; }
+            if (!g_root || !g_soma_journal.scratch) { Print(L"\r\n[Journal] ERROR: no EFI root\r\n\r\n"); continue; }
             unsigned int prev = 0;
-            int n = soma_journal_load(&g_soma_memory, g_root, &prev);
+            int n = soma_journal_load(&g_soma_journal, &g_soma_memory, g_root, &prev);
             if (n >= 0) {
                 g_soma_journal_total_turns = prev;
-                Print(L"\r\n[Journal] Loaded %d entries (total_turns=%d, sessions=%d)\r\n\r\n",
+                Print(L"\r\n[Journal] Replayed %d turns (total_turns=%d, sessions=%d)\r\n\r\n",
                       n, (int)prev, g_soma_memory.boot_count);
             } else if (n == -1) {
-                Print(L"\r\n[Journal] No file found\r\n\r\n");
+                Print(L"\r\n[Journal] Journal is empty\r\n\r\n");
             } else {
-                Print(L"\r\n[Journal] ERROR: corrupt or unreadable\r\n\r\n");
+                Print(L"\r\n[Journal] ERROR: unreadable\r\n\r\n");
             }
+            g_soma_journal_turns_since_save = 0;
             continue;
         }
         if (my_strncmp(prompt, "/soma_journal_clear", 19) == 0) {
-            if (!g_root) { Print(L"\r\n[Journal] ERROR: no EFI root\r\n\r\n"); continue; }
-            int r = soma_journal_clear(g_root);
+            if (!g_soma_journal.ready) { Print(L"\r\n[Journal] ERROR: journal not loaded\r\n\r\n"); continue; }
+            int r = soma_journal_clear(&g_soma_journal);
             g_soma_journal_total_turns = 0;
             g_soma_journal_turns_since_save = 0;
             Print(r == 0 ? L"\r\n[Journal] Cleared\r\n\r\n"
@@ -1500,18 +1522,20 @@ static void llmk_repl_no_model_loop(void) {
             continue;
         }
         if (my_strncmp(prompt, "/soma_journal_stats", 19) == 0) {
-            Print(L"\r\n[Journal] Runtime: total_turns=%d  turns_since_save=%d  autosave_every=%d\r\n",
+            Print(L"\r\n[Journal] Runtime: total_turns=%d  pending=%d  flush_every=%d\r\n",
                   (int)g_soma_journal_total_turns,
                   g_soma_journal_turns_since_save,
                   SOMA_JOURNAL_AUTOSAVE_EVERY);
-            if (g_root) {
-                SomaJournalStats js;
-                int r = soma_journal_read_stats(g_root, &js);
-                if (r == 0)
-                    Print(L"[Journal] Disk:    entries=%d  total_turns=%d  sessions=%d\r\n",
-                          js.loaded, js.total_turns, js.boot_count);
-                else
-                    Print(L"[Journal] Disk:    no file (or unreadable)\r\n");
+            SomaJournalStats js;
+            if (soma_journal_read_stats(&g_soma_journal, &js) == 0) {
+                Print(L"[Journal] Log:     turns=%d  sessions=%d  replayed=%d  torn=%d\r\n",
+                      js.total_turns, js.boot_count, js.loaded, js.torn);
+                Print(L"[Journal] Disk:    segments=%d  raw=%d KB  summarized=%d turns\r\n",
+                      js.segments, js.raw_bytes >> 10, js.summary_turns);
+                Print(L"[Journal] Writes:  flushes=%d  last=%d records  compactions=%d\r\n",
+                      js.flushes, js.saved, js.compactions);
+            } else {
+                Print(L"[Journal] Log:     not loaded\r\n");
             }
             Print(L"\r\n");
             continue;
@@ -2995,9 +3019,75 @@ static void llmk_repl_no_model_loop(void) {
             Print(L"  Core continuity preserved.\r\n\r\n");
             continue;
         }
+        if (my_strncmp(prompt, "/ssm_tp_bench", 13) == 0) {
+            // Decode cycles/token for 1..slices (BSP + APs); resets the v3 state
+            int i = 13, tokens = 0;
+            while (prompt[i] == ' ') i++;
+            while (prompt[i] >= '0' && prompt[i] <= '9' && tokens < 100000) tokens = tokens * 10 + (prompt[i++] - '0');
+            if (tokens <= 0) tokens = 16;
+            if (!g_oosi_v3_valid || !g_oosi_v3_ctx.w) {
+                Print(L"\r\n[SSM-TP] No OOSI v3 model loaded. Use /ssm_load first.\r\n\r\n");
+                continue;
+            }
+            int max_slices = (g_oosi_v3_tp_slices > 1) ? g_oosi_v3_tp_slices
+                                                       : oo_mc_start_workers(&g_oo_multicore, 0) + 1;
+            if (max_slices > OOSI_V3_TP_MAX_SLICES) max_slices = OOSI_V3_TP_MAX_SLICES;
+            Print(L"\r\n[SSM-TP] decode bench: %d tokens, 1..%d slices (cycles/token)\r\n", tokens, max_slices);
+            UINT64 base = 0;
+            for (int ns = 1; ns <= max_slices; ns++) {
+                oosi_v3_tp_init(&g_oosi_v3_tp, &g_oo_multicore, ns);
+                oosi_v3_tp_attach(&g_oosi_v3_tp, &g_oosi_v3_ctx);
+                oosi_v3_gen_ctx_reset(&g_oosi_v3_ctx);
+                int tok = oosi_v3_forward_one(&g_oosi_v3_ctx, 0).token;   // warm-up
+                UINT64 t0 = oo_mc_rdtsc();
+                for (int t = 0; t < tokens; t++) tok = oosi_v3_forward_one(&g_oosi_v3_ctx, tok).token;
+                UINT64 per_tok = (oo_mc_rdtsc() - t0) / (UINT64)tokens;
+                if (ns == 1) base = per_tok;
+                UINT64 x100 = per_tok ? (base * 100ULL) / per_tok : 0;
+                UINT64 wait = g_oosi_v3_tp.phases ? g_oosi_v3_tp.wait_cycles / g_oosi_v3_tp.phases : 0;
+                Print(L"  slices %2d: %lu/token  speedup %d.%02dx  bsp wait %lu/phase  steals %u\r\n",
+                      ns, per_tok, (int)(x100 / 100), (int)(x100 % 100), wait, oosi_v3_tp_moves(&g_oosi_v3_tp));
+            }
+            oosi_v3_gen_ctx_reset(&g_oosi_v3_ctx);
+            oosi_v3_tp_init(&g_oosi_v3_tp, &g_oo_multicore, g_oosi_v3_tp_slices);
+            oosi_v3_tp_attach((g_oosi_v3_tp_slices > 1) ? &g_oosi_v3_tp : NULL, &g_oosi_v3_ctx);
+            Print(L"  state reset; decode back on %d slice(s)\r\n\r\n", (g_oosi_v3_tp_slices > 1) ? g_oosi_v3_tp_slices : 1);
+            continue;
+        }
+        if (my_strncmp(prompt, "/ssm_tp", 7) == 0) {
+            // /ssm_tp N: split each v3 layer over N slices (BSP + N-1 APs); N <= 1 = serial
+            int i = 7, n = -1;
+            while (prompt[i] == ' ') i++;
+            if (prompt[i] >= '0' && prompt[i] <= '9') {
+                n = 0;
+                while (prompt[i] >= '0' && prompt[i] <= '9' && n < 1000) n = n * 10 + (prompt[i++] - '0');
+            }
+            if (n >= 0) {
+                int ns = 1;
+                if (n > 1) {
+                    int w = oo_mc_start_workers(&g_oo_multicore, n - 1);
+                    ns = (n < w + 1) ? n : w + 1;
+                }
+                oosi_v3_tp_init(&g_oosi_v3_tp, &g_oo_multicore, ns);
+                g_oosi_v3_tp_slices = g_oosi_v3_tp.n_slices;
+                oosi_v3_tp_attach((g_oosi_v3_tp_slices > 1) ? &g_oosi_v3_tp : NULL, &g_oosi_v3_ctx);
+                if (n > 1 && g_oosi_v3_tp_slices < 2)
+                    Print(L"\r\n[SSM-TP] no AP workers (single-core or MP services missing): serial decode\r\n");
+            }
+            Print(L"\r\n[SSM-TP] slices=%d workers=%d attached=%d\r\n",
+                  (g_oosi_v3_tp_slices > 1) ? g_oosi_v3_tp_slices : 1, g_oo_multicore.mc_worker_count,
+                  g_oosi_v3_ctx.exec != NULL);
+            if (g_oosi_v3_tp.phases) {
+                Print(L"  phases=%lu  bsp wait avg=%lu cycles  steals=%u\r\n",
+                      g_oosi_v3_tp.phases, g_oosi_v3_tp.wait_cycles / g_oosi_v3_tp.phases,
+                      oosi_v3_tp_moves(&g_oosi_v3_tp));
+            }
+            Print(L"\r\n");
+            continue;
+        }
         if (my_strncmp(prompt, "/ssm_info", 9) == 0) {
             Print(L"\r\n[SSM] Mamba bare-metal engine v0.1\r\n");
-            Print(L"  Commands: /ssm_load <file>, /ssm_infer <text>, /ssm_reset\r\n");
+            Print(L"  Commands: /ssm_load <file>, /ssm_infer <text>, /ssm_reset, /ssm_tp [n], /ssm_tp_bench [tokens]\r\n");
             Print(L"  Mind cmds: /core_load <file>, /mind_diag, /mind_halt_probe [x], /mind_halt_decide [x] [t], /mind_halt_sweep [a] [b] [s] [t], /mind_halt_policy [t] [on|off], /mind_halt_policy_save, /mind_halt_policy_load, /mind_halt_policy_apply_saved, /mind_halt_policy_apply_saved_if_needed, /mind_halt_policy_sync, /mind_halt_policy_sync_force, /mind_halt_policy_audit, /mind_audit, /mind_doctor, /mind_next, /mind_snapshot, /mind_ready, /mind_bootstrap_v1, /mind_path_v1, /oo_sidecar <file>, /oo_sidecar_audit, /oo_sidecar_unload, /attach_load <file>, /attach_audit, /attach_policy, /attach_policy_audit, /attach_policy_diff, /attach_policy_sync, /attach_policy_sync_force, /attach_unload, /mind_halt_policy_reset, /mind_halt_policy_diff, /mind_status\r\n");
             Print(L"  Weight format: MAMB binary\r\n");
             Print(L"  Exporters: runtime export_mamba_baremetal.py | oo-model export_mamb_binary.py\r\n");
@@ -3215,6 +3305,7 @@ static void llmk_repl_no_model_loop(void) {
                     continue;
                 }
                 g_oosi_v3_valid = 1;
+                if (g_oosi_v3_tp_slices > 1) oosi_v3_tp_attach(&g_oosi_v3_tp, &g_oosi_v3_ctx);
                 Print(L"[OOSI-v3] OK: full SSM inference ready. Use /ssm_infer <text>\r\n");
                 // Phase H: record which model is loaded
                 if (g_soma_memory.enabled)
@@ -3527,7 +3618,21 @@ static void llmk_repl_no_model_loop(void) {
                 int ip = 0;
                 // Memory reflex (Phase H) — injects historical context first
                 if (g_soma_memory.enabled) {
-                    SomaMemResult mr = soma_memory_scan(&g_soma_memory, text);
+                    SomaMemResult mr;
+                    mr.triggered = 0;
+                    // Phase H2: semantic recall first (finds paraphrases),
+                    // hash/prefix ring scan as fallback
+                    g_soma_emb_query_ok = 0;
+                    if (g_soma_emb_ready && g_oosi_v3_valid) {
+                        int emb_tokens[SOMA_EMB_POOL_TOKENS];
+                        int emb_n = llmk_oo_infer_tokenize(text, emb_tokens, SOMA_EMB_POOL_TOKENS);
+                        if (llmk_soma_emb_embed(emb_tokens, emb_n, g_soma_emb_query) == 0) {
+                            g_soma_emb_query_ok = 1;
+                            llmk_soma_emb_recall(g_soma_emb_query, soma_domain_used, &mr);
+                        }
+                    }
+                    if (!mr.triggered)
+                        mr = soma_memory_scan(&g_soma_memory, text);
                     if (mr.triggered) {
                         for (int mi = 0; mi < mr.injection_len && ip < (int)sizeof(reflex_prompt) - 2; mi++)
                             reflex_prompt[ip++] = mr.injection[mi];
@@ -3922,6 +4027,13 @@ static void llmk_repl_no_model_loop(void) {
                         resp_summary[rs] = 0;
                         soma_memory_record_tagged(&g_soma_memory, text, resp_summary,
                                                   (unsigned char)soma_domain_used);
+                        // Phase H2: keep the prompt embedding for semantic recall
+                        if (g_soma_emb_ready && g_soma_emb_query_ok) {
+                            llmk_soma_emb_store(g_soma_emb_query, text, resp_summary,
+                                                g_soma_memory.total_turns - 1,
+                                                soma_input_hash, soma_domain_used);
+                            g_soma_emb_query_ok = 0;
+                        }
                         // Phase R: feed symbion with post-inference performance sample
                         {
                             SymbionSample ssamp;
@@ -3931,16 +4043,17 @@ static void llmk_repl_no_model_loop(void) {
                                                 ? 100 : g_soma_warden.pressure_level * 30);
                             symbion_feed(&g_symbion, &ssamp);
                         }
-                        // Phase I: autosave journal every N turns
+                        // Phase I: append to the journal; group flush every N turns
                         g_soma_journal_total_turns++;
-                        g_soma_journal_turns_since_save++;
-                        if (g_root && g_soma_journal_turns_since_save >= SOMA_JOURNAL_AUTOSAVE_EVERY) {
-                            int jsaved = soma_journal_save(&g_soma_memory, g_root,
-                                                           g_soma_journal_total_turns);
-                            g_soma_journal_turns_since_save = 0;
-                            if (g_boot_verbose)
-                                Print(L"[SomaJournal] Auto-saved %d entries (total=%d)\r\n",
-                                      jsaved, (int)g_soma_journal_total_turns);
+                        if (g_soma_journal.ready) {
+                            int jsaved = soma_journal_append(&g_soma_journal, &g_soma_memory);
+                            g_soma_journal_turns_since_save = (int)g_soma_journal.log.batch_turns;
+                            if (jsaved > 0) {
+                                if (g_nfsl_ready) nfsl_persist_flush(&g_nfsl, g_root);
+                                if (g_boot_verbose)
+                                    Print(L"[SomaJournal] Flushed %d records (total=%d)\r\n",
+                                          jsaved, (int)g_soma_journal_total_turns);
+                            }
                         }
                         // Phase M: warden pressure update (sentinel → router feedback)
                         int warden_escalated_this_turn = 0;
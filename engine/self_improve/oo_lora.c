@@ -1,6 +1,7 @@
 /* oo_lora.c — LoRA adapter for OO self-improvement loop (bare-metal)
  *
- * Uses a static memory pool (no malloc) — requires ~1MB per model.
+ * Adapter factors live in a caller-provided arena (no malloc) — size it
+ * with oo_lora_bytes(); TinyLlama-1.1B at rank 8 needs ~26MB.
  * Gradient updates use a simple SGD step (no autograd).
  * D+ scoring evaluates adapter improvement vs base model.
  * Persist/load uses NVMe block write via oo_nvme.h interface.
@@ -8,28 +9,21 @@
 
 #include "oo_lora.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <immintrin.h>
+#define LORA_X86 1
+#endif
+
 /* Forward declarations from oo_nvme.c (included earlier in unity build) */
 extern int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes);
 extern int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes);
 
 /* ─── Global state (unity-build accessible) ──────────────────────────── */
 oo_lora_state_t g_lora;
+oo_lora_bank_t  g_lora_bank = { { &g_lora }, 1, 0 };
 
-/* ─── Static pools (no heap) ──────────────────────────────────────────── */
-/* 32 layers × 3 projections × rank8 × 2 matrices
- * Max dimension = 2048 (Tinyllama hidden dim)
- * A: 2048 × 8  = 16384 floats per proj
- * B: 8    × 2048 = 16384 floats per proj
- * Total: 32 × 3 × 2 × 16384 × 4 bytes ≈ 12MB
- */
-#define LORA_DIM_MAX  2048
-#define LORA_POOL_A   (LORA_MAX_LAYERS * 3 * LORA_DIM_MAX * LORA_MAX_RANK)
-#define LORA_POOL_B   (LORA_MAX_LAYERS * 3 * LORA_MAX_RANK * LORA_DIM_MAX)
-
-static float _pool_A[LORA_POOL_A] __attribute__((aligned(64)));
-static float _pool_B[LORA_POOL_B] __attribute__((aligned(64)));
-static UINT32 _pool_a_idx = 0;
-static UINT32 _pool_b_idx = 0;
+static int _lora_avx2 = 0;
 
 /* ─── Simple PRNG (xorshift32) for A init ─────────────────────────────── */
 static UINT32 _rng_state = 0xDEADBEEF;
@@ -43,12 +37,25 @@ static float _randf(void) {
 
 /* ─── Math helpers ────────────────────────────────────────────────────── */
 static float _dot(const float *a, const float *b, UINT32 n) {
+    UINT32 i = 0;
     float s = 0.0f;
-    for (UINT32 i = 0; i < n; i++) s += a[i] * b[i];
+#ifdef LORA_X86
+    __m128 v0 = _mm_setzero_ps(), v1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        v0 = _mm_add_ps(v0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        v1 = _mm_add_ps(v1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    v0 = _mm_add_ps(v0, v1);
+    v1 = _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(2, 3, 0, 1));
+    v0 = _mm_add_ps(v0, v1);
+    v1 = _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(1, 0, 3, 2));
+    v0 = _mm_add_ps(v0, v1);
+    s = _mm_cvtss_f32(v0);
+#endif
+    for (; i < n; i++) s += a[i] * b[i];
     return s;
 }
 
-static float _fabsf(float x) { return x < 0 ? -x : x; }
 static float _sqrtf_fast(float x) {
     /* Newton-Raphson, 3 iterations */
     if (x <= 0) return 0;
@@ -59,71 +66,409 @@ static float _sqrtf_fast(float x) {
     return y;
 }
 
-/* ─── Public: init ────────────────────────────────────────────────────── */
+/* IEEE half → float (Q8_0 block scales). Always inlined: the AVX2 kernels
+ * call it per block and a legacy-SSE call there costs a state transition. */
+static inline __attribute__((always_inline)) float _lora_fp16(const UINT8 *p) {
+    UINT32 h = (UINT32)p[0] | ((UINT32)p[1] << 8);
+    UINT32 sign = (h >> 15) & 1u, exp = (h >> 10) & 0x1Fu, mant = h & 0x3FFu;
+    UINT32 u;
+    if (exp == 0) {
+        if (mant == 0) {
+            u = sign << 31;
+        } else {
+            exp = 1;
+            while ((mant & 0x400u) == 0) { mant <<= 1; exp--; }
+            u = (sign << 31) | ((exp + 112u) << 23) | ((mant & 0x3FFu) << 13);
+        }
+    } else if (exp == 31) {
+        u = (sign << 31) | (0xFFu << 23) | (mant << 13);
+    } else {
+        u = (sign << 31) | ((exp + 112u) << 23) | (mant << 13);
+    }
+    union { UINT32 u; float f; } c;
+    c.u = u;
+    return c.f;
+}
+
+static int _lora_round(float v) {
+    if (v >  1000.0f) v =  1000.0f;
+    if (v < -1000.0f) v = -1000.0f;
+    return (v >= 0.0f) ? (int)(v + 0.5f) : (int)(v - 0.5f);
+}
+
+/* t[k] = scale * (A_k · x) — computed once per input vector */
+static void _lora_project(const oo_lora_adapter_t *a, const float *x, float *t) {
+    for (UINT32 k = 0; k < a->rank; k++)
+        t[k] = a->scale * _dot(a->A + (UINTN)k * a->in_dim, x, a->in_dim);
+}
+
+static inline __attribute__((always_inline))
+float _lora_row(const oo_lora_adapter_t *a, const float *t, UINT32 j) {
+    const float *b = a->B + (UINTN)j * a->rank;
+    float s = 0.0f;
+    for (UINT32 k = 0; k < a->rank; k++) s += b[k] * t[k];
+    return s;
+}
+
+static int _lora_live(const oo_lora_adapter_t *a, UINT32 n, UINT32 d) {
+    return a && a->rank && a->A && a->B && a->in_dim == n && a->out_dim == d;
+}
+
+/* ─── Public: sizing + init ──────────────────────────────────────────── */
+static void _proj_dims(UINT32 p, UINT32 dim, UINT32 kv_dim, UINT32 hidden_dim,
+                       UINT32 *in, UINT32 *out) {
+    *in  = (p == OO_LORA_W2) ? hidden_dim : dim;
+    *out = (p == OO_LORA_WK || p == OO_LORA_WV) ? kv_dim
+         : (p == OO_LORA_W1 || p == OO_LORA_W3) ? hidden_dim : dim;
+}
+
+UINT64 oo_lora_bytes(UINT32 n_layers, UINT32 dim, UINT32 kv_dim,
+                     UINT32 hidden_dim, UINT32 rank) {
+    UINT64 per_layer = 0;
+    for (UINT32 p = 0; p < OO_LORA_NPROJ; p++) {
+        UINT32 in, out;
+        _proj_dims(p, dim, kv_dim, hidden_dim, &in, &out);
+        per_layer += (UINT64)(in + out) * rank;
+    }
+    return per_layer * n_layers * sizeof(float);
+}
+
 int oo_lora_init(oo_lora_state_t *st, UINT32 n_layers,
-                 UINT32 dim, UINT32 rank) {
-    if (!st || n_layers > LORA_MAX_LAYERS || rank > LORA_MAX_RANK)
+                 UINT32 dim, UINT32 kv_dim, UINT32 hidden_dim,
+                 UINT32 rank, void *mem, UINT64 mem_bytes) {
+    if (!st || n_layers > LORA_MAX_LAYERS || rank == 0 || rank > LORA_MAX_RANK)
         return -1;
-    if (dim > LORA_DIM_MAX) return -2;
+    if (!mem || dim == 0 || kv_dim == 0 || hidden_dim == 0) return -2;
+    UINT64 need = oo_lora_bytes(n_layers, dim, kv_dim, hidden_dim, rank);
+    if (mem_bytes < need) return -3;
 
+    for (UINT32 i = 0; i < sizeof(*st); i++) ((UINT8 *)st)[i] = 0;
     st->n_layers      = n_layers;
     st->learning_rate = 1e-4f;
-    st->step_count    = 0;
-    st->last_score    = 0.0f;
-    st->dirty         = 0;
+    st->mem           = (float *)mem;
+    st->mem_floats    = need / sizeof(float);
 
+    float *pool = st->mem;
     for (UINT32 l = 0; l < n_layers; l++) {
-        for (UINT32 p = 0; p < 3; p++) {
+        for (UINT32 p = 0; p < OO_LORA_NPROJ; p++) {
             oo_lora_adapter_t *a = &st->layers[l][p];
-            a->in_dim  = dim;
-            a->out_dim = dim;
-            a->rank    = rank;
-            a->scale   = LORA_ALPHA / (float)rank;
-
-            /* Allocate from pools */
-            a->A = &_pool_A[_pool_a_idx];
-            _pool_a_idx += dim * rank;
-            a->B = &_pool_B[_pool_b_idx];
-            _pool_b_idx += rank * dim;
+            _proj_dims(p, dim, kv_dim, hidden_dim, &a->in_dim, &a->out_dim);
+            a->rank  = rank;
+            a->scale = LORA_ALPHA / (float)rank;
+            a->A = pool; pool += (UINTN)rank * a->in_dim;
+            a->B = pool; pool += (UINTN)a->out_dim * rank;
 
             /* A: random small values, B: zero */
-            for (UINT32 i = 0; i < dim * rank; i++) a->A[i] = _randf();
-            for (UINT32 i = 0; i < rank * dim; i++) a->B[i] = 0.0f;
+            for (UINT32 i = 0; i < rank * a->in_dim; i++) a->A[i] = _randf();
+            for (UINT32 i = 0; i < a->out_dim * rank; i++) a->B[i] = 0.0f;
         }
     }
     return 0;
 }
 
-/* ─── Public: forward pass  x_out += scale * B * (A * x) ────────────── */
-void oo_lora_forward(oo_lora_adapter_t *a, const float *x,
+/* ─── Public: reference forward  out += scale * B * (A * x) ──────────── */
+/* Separate pass after the base matmul — kept as the reference path for
+ * the fused kernels and for callers that only have the output vector. */
+void oo_lora_forward(const oo_lora_adapter_t *a, const float *x,
                      float *out, UINT32 n) {
-    if (!a || !x || !out) return;
-    UINT32 r = a->rank;
-    /* tmp = A^T * x  → shape [rank] */
-    float tmp[LORA_MAX_RANK];
-    for (UINT32 k = 0; k < r; k++)
-        tmp[k] = _dot(a->A + k * a->in_dim, x, a->in_dim);
-    /* out += scale * B * tmp */
-    for (UINT32 j = 0; j < a->out_dim; j++) {
+    (void)n;
+    if (!a || !x || !out || !a->rank) return;
+    float t[LORA_MAX_RANK];
+    _lora_project(a, x, t);
+    for (UINT32 j = 0; j < a->out_dim; j++)
+        out[j] += _lora_row(a, t, j);
+}
+
+/* ─── Public: fused kernels ──────────────────────────────────────────── */
+void oo_lora_set_cpu(int has_avx2) { _lora_avx2 = has_avx2 ? 1 : 0; }
+
+#ifdef LORA_X86
+__attribute__((target("avx2")))
+static float _hsum256(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 t = _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 3, 0, 1));
+    s = _mm_add_ps(s, t);
+    t = _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2));
+    s = _mm_add_ps(s, t);
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2")))
+static void _matmul_f32_avx2(float *xout, const float *x, const float *w,
+                             UINT32 n, UINT32 d,
+                             const oo_lora_adapter_t *a, const float *t) {
+    for (UINT32 j = 0; j < d; j++) {
+        const float *row = w + (UINTN)j * n;
+        __m256 v0 = _mm256_setzero_ps(), v1 = _mm256_setzero_ps();
+        UINT32 i = 0;
+        for (; i + 16 <= n; i += 16) {
+            v0 = _mm256_add_ps(v0, _mm256_mul_ps(_mm256_loadu_ps(row + i),     _mm256_loadu_ps(x + i)));
+            v1 = _mm256_add_ps(v1, _mm256_mul_ps(_mm256_loadu_ps(row + i + 8), _mm256_loadu_ps(x + i + 8)));
+        }
+        float s = _hsum256(_mm256_add_ps(v0, v1));
+        for (; i < n; i++) s += row[i] * x[i];
+        xout[j] = a ? s + _lora_row(a, t, j) : s;
+    }
+}
+
+__attribute__((target("avx2")))
+static void _matmul_q8_avx2(float *xout, const float *x, const UINT8 *w,
+                            UINT32 n, UINT32 d,
+                            const oo_lora_adapter_t *a, const float *t) {
+    const UINT32 nb = n / 32;
+    for (UINT32 j = 0; j < d; j++) {
+        const UINT8 *p = w + (UINTN)j * nb * 34;
+        __m256 vrow = _mm256_setzero_ps();
+        for (UINT32 b = 0; b < nb; b++, p += 34) {
+            const INT8 *qs = (const INT8 *)(p + 2);
+            const float *xb = x + b * 32;
+            __m256 vb = _mm256_setzero_ps();
+            for (int i = 0; i < 32; i += 8) {
+                __m256 qf = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(
+                                _mm_loadl_epi64((const __m128i *)(qs + i))));
+                vb = _mm256_add_ps(vb, _mm256_mul_ps(qf, _mm256_loadu_ps(xb + i)));
+            }
+            vrow = _mm256_add_ps(vrow, _mm256_mul_ps(_mm256_set1_ps(_lora_fp16(p)), vb));
+        }
+        float s = _hsum256(vrow);
+        xout[j] = a ? s + _lora_row(a, t, j) : s;
+    }
+}
+#endif
+
+void oo_lora_matmul_f32(float *xout, const float *x, const float *w,
+                        UINT32 n, UINT32 d, const oo_lora_adapter_t *a) {
+    if (!xout || !x || !w) return;
+    float t[LORA_MAX_RANK];
+    if (!_lora_live(a, n, d)) a = 0;
+    if (a) _lora_project(a, x, t);
+#ifdef LORA_X86
+    if (_lora_avx2) { _matmul_f32_avx2(xout, x, w, n, d, a, t); return; }
+#endif
+    for (UINT32 j = 0; j < d; j++) {
+        float s = _dot(w + (UINTN)j * n, x, n);
+        xout[j] = a ? s + _lora_row(a, t, j) : s;
+    }
+}
+
+void oo_lora_matmul_q8_0(float *xout, const float *x, const UINT8 *w,
+                         UINT32 n, UINT32 d, const oo_lora_adapter_t *a) {
+    if (!xout || !x || !w) return;
+    if ((n % 32) != 0) {
+        for (UINT32 j = 0; j < d; j++) xout[j] = 0.0f;
+        return;
+    }
+    float t[LORA_MAX_RANK];
+    if (!_lora_live(a, n, d)) a = 0;
+    if (a) _lora_project(a, x, t);
+#ifdef LORA_X86
+    if (_lora_avx2) { _matmul_q8_avx2(xout, x, w, n, d, a, t); return; }
+#endif
+    const UINT32 nb = n / 32;
+    for (UINT32 j = 0; j < d; j++) {
+        const UINT8 *p = w + (UINTN)j * nb * 34;
+#ifdef LORA_X86
+        /* SSE2: sign-extend int8 → int16 → int32 via unpack + arithmetic shift */
+        __m128 vrow = _mm_setzero_ps();
+        for (UINT32 b = 0; b < nb; b++, p += 34) {
+            const float *xb = x + b * 32;
+            __m128 vb = _mm_setzero_ps();
+            for (int h = 0; h < 32; h += 16) {
+                __m128i q  = _mm_loadu_si128((const __m128i *)(p + 2 + h));
+                __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(q, q), 8);
+                __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(q, q), 8);
+                __m128i q0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+                __m128i q1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+                __m128i q2 = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+                __m128i q3 = _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16);
+                vb = _mm_add_ps(vb, _mm_mul_ps(_mm_cvtepi32_ps(q0), _mm_loadu_ps(xb + h)));
+                vb = _mm_add_ps(vb, _mm_mul_ps(_mm_cvtepi32_ps(q1), _mm_loadu_ps(xb + h + 4)));
+                vb = _mm_add_ps(vb, _mm_mul_ps(_mm_cvtepi32_ps(q2), _mm_loadu_ps(xb + h + 8)));
+                vb = _mm_add_ps(vb, _mm_mul_ps(_mm_cvtepi32_ps(q3), _mm_loadu_ps(xb + h + 12)));
+            }
+            vrow = _mm_add_ps(vrow, _mm_mul_ps(_mm_set1_ps(_lora_fp16(p)), vb));
+        }
+        __m128 sh = _mm_shuffle_ps(vrow, vrow, _MM_SHUFFLE(2, 3, 0, 1));
+        vrow = _mm_add_ps(vrow, sh);
+        sh = _mm_shuffle_ps(vrow, vrow, _MM_SHUFFLE(1, 0, 3, 2));
+        vrow = _mm_add_ps(vrow, sh);
+        float s = _mm_cvtss_f32(vrow);
+#else
         float s = 0.0f;
-        for (UINT32 k = 0; k < r; k++)
-            s += a->B[k * a->out_dim + j] * tmp[k];
-        out[j] += a->scale * s;
+        for (UINT32 b = 0; b < nb; b++, p += 34) {
+            const INT8 *qs = (const INT8 *)(p + 2);
+            float sb = 0.0f;
+            for (int i = 0; i < 32; i++) sb += (float)qs[i] * x[b * 32 + i];
+            s += _lora_fp16(p) * sb;
+        }
+#endif
+        xout[j] = a ? s + _lora_row(a, t, j) : s;
+    }
+}
+
+/* ─── Merge / unmerge ────────────────────────────────────────────────── */
+/* ΔW[j][c0..c0+len) = scale * Σk B[j][k]·A[k][c]. Merge and unmerge run
+ * the exact same float sequence, so the deltas cancel bit-for-bit. */
+static void _lora_delta(const oo_lora_adapter_t *a, UINT32 j, UINT32 c0,
+                        UINT32 len, float *dv) {
+    const float *b = a->B + (UINTN)j * a->rank;
+    for (UINT32 i = 0; i < len; i++) dv[i] = 0.0f;
+    for (UINT32 k = 0; k < a->rank; k++) {
+        const float *ak = a->A + (UINTN)k * a->in_dim + c0;
+        float bk = b[k];
+        for (UINT32 i = 0; i < len; i++) dv[i] += bk * ak[i];
+    }
+    for (UINT32 i = 0; i < len; i++) dv[i] *= a->scale;
+}
+
+static int _lora_fold(oo_lora_state_t *st, const oo_lora_model_t *m, int sign) {
+    if (!st || !m || st->n_layers > m->n_layers) return -1;
+    for (UINT32 p = 0; p < OO_LORA_NPROJ; p++) {
+        const oo_lora_weight_t *wd = &m->w[p];
+        for (UINT32 l = 0; l < st->n_layers; l++) {
+            const oo_lora_adapter_t *a = &st->layers[l][p];
+            if (!a->rank) continue;
+            if (!wd->base || a->in_dim != wd->in_dim || a->out_dim != wd->out_dim)
+                return -2;
+            if (wd->kind == OO_LORA_W_Q8_0 && (a->in_dim % 32) != 0) return -2;
+        }
+    }
+
+    UINT32 clipped = 0, blk_id = 0, cur = 0;
+    if (sign > 0) st->spill_n = 0;
+    float dv[32];
+    for (UINT32 l = 0; l < st->n_layers; l++) {
+        for (UINT32 p = 0; p < OO_LORA_NPROJ; p++) {
+            const oo_lora_adapter_t *a = &st->layers[l][p];
+            const oo_lora_weight_t *wd = &m->w[p];
+            if (!a->rank) continue;
+            UINT8 *base = wd->base + (UINTN)l * wd->layer_bytes;
+            UINT32 n = a->in_dim;
+
+            if (wd->kind == OO_LORA_W_F32) {
+                for (UINT32 j = 0; j < a->out_dim; j++) {
+                    float *row = (float *)base + (UINTN)j * n;
+                    for (UINT32 c = 0; c < n; c += 32) {
+                        UINT32 len = (n - c < 32) ? n - c : 32;
+                        _lora_delta(a, j, c, len, dv);
+                        for (UINT32 i = 0; i < len; i++)
+                            row[c + i] += (sign > 0) ? dv[i] : -dv[i];
+                    }
+                }
+            } else {
+                UINT32 nb = n / 32;
+                for (UINT32 j = 0; j < a->out_dim; j++) {
+                    UINT8 *blk = base + (UINTN)j * nb * 34;
+                    for (UINT32 b = 0; b < nb; b++, blk += 34, blk_id++) {
+                        float d = _lora_fp16(blk);
+                        if (!(d > 0.0f || d < 0.0f)) continue;  /* all-zero block */
+                        float inv = 1.0f / d;
+                        INT8 *qs = (INT8 *)(blk + 2);
+                        _lora_delta(a, j, b * 32, 32, dv);
+                        for (int i = 0; i < 32; i++) {
+                            int dq = _lora_round(dv[i] * inv);
+                            int q;
+                            if (sign > 0) {
+                                q = (int)qs[i] + dq;
+                            } else {
+                                q = (int)qs[i] - dq;
+                                if (cur < st->spill_n && st->spill[cur].block == blk_id &&
+                                    st->spill[cur].lane == (UINT8)i)
+                                    q += st->spill[cur++].over;
+                            }
+                            int c = q > 127 ? 127 : (q < -127 ? -127 : q);
+                            if (c != q) {
+                                if (sign > 0 && st->spill_n < st->spill_cap) {
+                                    oo_lora_spill_t *e = &st->spill[st->spill_n++];
+                                    e->block = blk_id;
+                                    e->lane  = (UINT8)i;
+                                    e->_pad  = 0;
+                                    e->over  = (INT16)(q - c);
+                                } else {
+                                    clipped++;
+                                }
+                            }
+                            qs[i] = (INT8)c;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if (sign > 0) st->q8_clipped = clipped;
+    else st->spill_n = 0;
+    return 0;
+}
+
+void oo_lora_set_spill(oo_lora_state_t *st, void *mem, UINT64 bytes) {
+    if (!st || st->merged) return;
+    UINT64 n = mem ? bytes / sizeof(oo_lora_spill_t) : 0;
+    st->spill     = (oo_lora_spill_t *)mem;
+    st->spill_cap = (n > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (UINT32)n;
+    st->spill_n   = 0;
+}
+
+int oo_lora_merge(oo_lora_state_t *st, const oo_lora_model_t *m) {
+    if (!st) return -1;
+    if (st->merged) return 0;
+    int rc = _lora_fold(st, m, +1);
+    if (rc == 0) st->merged = 1;
+    return rc;
+}
+
+int oo_lora_unmerge(oo_lora_state_t *st, const oo_lora_model_t *m) {
+    if (!st) return -1;
+    if (!st->merged) return 0;
+    int rc = _lora_fold(st, m, -1);
+    if (rc == 0) st->merged = 0;
+    return rc;
+}
+
+/* ─── Bank: resident adapters + hot-swap ─────────────────────────────── */
+int oo_lora_bank_add(oo_lora_bank_t *bk, oo_lora_state_t *st) {
+    if (!bk || !st) return -1;
+    for (UINT32 i = 0; i < bk->n_slots; i++)
+        if (bk->slot[i] == st) return (int)i;
+    if (bk->n_slots >= LORA_MAX_SLOTS) return -2;
+    bk->slot[bk->n_slots] = st;
+    return (int)bk->n_slots++;
+}
+
+int oo_lora_bank_select(oo_lora_bank_t *bk, INT32 slot,
+                        const oo_lora_model_t *m, int merge) {
+    if (!bk || slot < -1 || slot >= (INT32)bk->n_slots) return -1;
+    if (bk->active >= 0) {
+        oo_lora_state_t *cur = bk->slot[bk->active];
+        if (cur && cur->merged) {
+            int rc = oo_lora_unmerge(cur, m);
+            if (rc != 0) return rc;
+        }
     }
+    bk->active = slot;
+    if (slot >= 0 && merge) return oo_lora_merge(bk->slot[slot], m);
+    return 0;
+}
+
+oo_lora_state_t *oo_lora_bank_active(const oo_lora_bank_t *bk) {
+    if (!bk || bk->active < 0 || bk->active >= (INT32)bk->n_slots) return 0;
+    oo_lora_state_t *st = bk->slot[bk->active];
+    return (st && st->n_layers) ? st : 0;
 }
 
 /* ─── Public: SGD backward step (one layer, one projection) ──────────── */
 void oo_lora_backward_step(oo_lora_state_t *st, const float *grad,
                            UINT32 layer_idx, UINT32 proj_idx) {
-    if (!st || layer_idx >= st->n_layers || proj_idx >= 3) return;
+    if (!st || layer_idx >= st->n_layers || proj_idx >= OO_LORA_NPROJ) return;
+    if (st->merged) return;   /* weights hold the old ΔW — unmerge first */
     oo_lora_adapter_t *a = &st->layers[layer_idx][proj_idx];
     float lr = st->learning_rate;
     UINT32 r = a->rank;
+    if (!r) return;
 
     /* Update B: B -= lr * grad^T (simplified outer product update) */
-    for (UINT32 k = 0; k < r; k++)
-        for (UINT32 j = 0; j < a->out_dim; j++)
-            a->B[k * a->out_dim + j] -= lr * grad[j];
+    for (UINT32 j = 0; j < a->out_dim; j++)
+        for (UINT32 k = 0; k < r; k++)
+            a->B[j * r + k] -= lr * grad[j];
 
     /* Update A: A -= lr * grad (projected back) */
     for (UINT32 k = 0; k < r; k++)
@@ -146,8 +491,9 @@ float oo_lora_score(const oo_lora_state_t *st) {
     float total_norm = 0.0f;
     UINT32 count = 0;
     for (UINT32 l = 0; l < st->n_layers; l++) {
-        for (UINT32 p = 0; p < 3; p++) {
+        for (UINT32 p = 0; p < OO_LORA_NPROJ; p++) {
             const oo_lora_adapter_t *a = &st->layers[l][p];
+            if (!a->rank) continue;
             float norm = 0.0f;
             for (UINT32 k = 0; k < a->rank * a->out_dim; k++)
                 norm += a->B[k] * a->B[k];
@@ -170,64 +516,61 @@ float oo_lora_score(const oo_lora_state_t *st) {
 }
 
 /* ─── Persist/Load: write adapter to NVMe raw LBA ────────────────────── */
-/* Layout: [magic32][n_layers][step_count][A pool][B pool] */
-#define LORA_MAGIC 0x004C4F52  /* "LOR\0" */
+/* Layout: [magic32][n_layers][step_count][arena floats] [arena] */
+#define LORA_MAGIC 0x014C4F52  /* "ROL\1" — v1: all projections, B = [out][rank] */
 #define LORA_LBA_START 0x800   /* LBA offset on NVMe (after OS data) */
 
 int oo_lora_persist(const oo_lora_state_t *st, const char *nvme_path) {
     (void)nvme_path;    /* unused — we use raw NVMe LBA directly */
-    if (!st || !st->dirty) return 0;
+    if (!st || !st->dirty || !st->mem) return 0;
 
     /* Build a flat header block */
     UINT32 hdr[4] = {
         LORA_MAGIC,
         st->n_layers,
         (UINT32)(st->step_count & 0xFFFFFFFF),
-        _pool_a_idx
+        (UINT32)st->mem_floats
     };
 
-    /* Write header at LORA_LBA_START */
-    oo_nvme_write_lba(LORA_LBA_START, (UINT8 *)hdr, sizeof(hdr));
-
-    /* Write A pool */
-    UINT32 a_bytes = _pool_a_idx * sizeof(float);
-    oo_nvme_write_lba(LORA_LBA_START + 1, (UINT8 *)_pool_A, a_bytes);
-
-    /* Write B pool */
-    UINT32 b_bytes = _pool_b_idx * sizeof(float);
-    UINT32 b_lba = LORA_LBA_START + 1 + (a_bytes + 511) / 512;
-    oo_nvme_write_lba(b_lba, (UINT8 *)_pool_B, b_bytes);
-
+    /* Write header at LORA_LBA_START, arena right after */
+    if (oo_nvme_write_lba(LORA_LBA_START, (UINT8 *)hdr, sizeof(hdr)) != 0) return -2;
+    if (oo_nvme_write_lba(LORA_LBA_START + 1, (const UINT8 *)st->mem,
+                          (UINT32)(st->mem_floats * sizeof(float))) != 0) return -2;
     return 0;
 }
 
+/* st must already be initialised with the same geometry (oo_lora_init) */
 int oo_lora_load(oo_lora_state_t *st, const char *nvme_path) {
     (void)nvme_path;
-    if (!st) return -1;
+    if (!st || !st->mem) return -1;
+    if (st->merged) return -1;
 
     UINT32 hdr[4];
     if (oo_nvme_read_lba(LORA_LBA_START, (UINT8 *)hdr, sizeof(hdr)) != 0)
         return -2;
     if (hdr[0] != LORA_MAGIC) return -3;  /* no saved adapter */
+    if (hdr[1] != st->n_layers || hdr[3] != (UINT32)st->mem_floats) return -4;
 
-    _pool_a_idx = hdr[3];
-    UINT32 a_bytes = _pool_a_idx * sizeof(float);
-    oo_nvme_read_lba(LORA_LBA_START + 1, (UINT8 *)_pool_A, a_bytes);
-
-    UINT32 b_lba = LORA_LBA_START + 1 + (a_bytes + 511) / 512;
-    oo_nvme_read_lba(b_lba, (UINT8 *)_pool_B, _pool_b_idx * sizeof(float));
+    if (oo_nvme_read_lba(LORA_LBA_START + 1, (UINT8 *)st->mem,
+                         (UINT32)(st->mem_floats * sizeof(float))) != 0)
+        return -2;
 
     st->step_count = hdr[2];
     st->dirty      = 0;
     return 0;
 }
 
-/* ─── Merge adapter into base model weights (naive add) ─────────────── */
-void oo_lora_apply_to_model(oo_lora_state_t *st, void *model_weights) {
-    /* model_weights points to the transformer weight block.
-     * In practice: for each layer, call oo_lora_forward() during
-     * inference rather than baking in — this is the preferred path.
-     * This function is provided for one-time merge (distillation). */
-    (void)st; (void)model_weights;
-    /* TODO: implement when model format exports layer weight pointers */
+/* ─── Display ────────────────────────────────────────────────────────── */
+void oo_lora_print(const oo_lora_state_t *st) {
+    if (!st || !st->n_layers) {
+        Print(L"  (adapter not initialised)\r\n");
+        return;
+    }
+    Print(L"  layers=%u rank=%u proj=%u  %s  steps=%lu  arena=%lu KB\r\n",
+          st->n_layers, st->layers[0][OO_LORA_WQ].rank, (UINT32)OO_LORA_NPROJ,
+          st->merged ? L"merged" : L"fused",
+          st->step_count, (st->mem_floats * sizeof(float)) >> 10);
+    if (st->merged && (st->spill_n || st->q8_clipped))
+        Print(L"  q8 saturated codes: %u spilled, %u lost%s\r\n", st->spill_n, st->q8_clipped,
+              st->q8_clipped ? L" (unmerge is approximate)" : L"");
 }
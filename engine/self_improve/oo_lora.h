@@ -5,45 +5,128 @@
  *
  * Architecture:
  *   Inference (forward pass) → delta_activations
- *   → LoRA adapter (rank-8 A×B matrices applied in-place)
+ *   → LoRA adapter (rank-8 A×B matrices on every projection)
  *   → D+ scoring → if score > threshold → persist adapter to NVMe
  *   → next boot loads updated adapter
+ *
+ * Two ways to run an adapter (Phase 6G):
+ *   fused   — oo_lora_matmul_f32 / oo_lora_matmul_q8_0 compute the base
+ *             row dot and the low-rank term in the same kernel: t = A·x is
+ *             computed once (rank floats), then every output row adds
+ *             scale·(Bt[j]·t) while the row result is still in a register.
+ *   merged  — oo_lora_merge folds ΔW = scale·B·A into the weights, so the
+ *             normal matmuls run with zero overhead. oo_lora_unmerge takes
+ *             it back out. Q8_0 merges keep every block scale and add
+ *             round(Δ/d) to the int8 codes. The block maximum sits at ±127
+ *             by construction, so codes that saturate log their overflow in
+ *             a caller-sized spill table; unmerge replays it and restores
+ *             the exact original bytes. Overflow that did not fit in the
+ *             spill is counted in q8_clipped (unmerge is then approximate).
+ *
+ * Several adapters can stay resident in an oo_lora_bank_t; switching
+ * slots unmerges the old one first, so hot-swap never compounds deltas.
+ *
+ * Host builds (tests/test_oo_lora.c) include efi_compat.h and provide
+ * oo_nvme_read_lba()/oo_nvme_write_lba().
  */
 
+#ifdef UEFI_BUILD
 #include <efi.h>
 #include <efilib.h>
+#else
+#include "../ssm/efi_compat.h"
+#endif
 
 /* LoRA hyper-parameters */
 #define LORA_MAX_RANK       8     /* low-rank decomposition dimension */
 #define LORA_MAX_LAYERS    32     /* max transformer layers to adapt */
+#define LORA_MAX_SLOTS      4     /* resident adapters in a bank */
 #define LORA_ALPHA          1.0f  /* scaling factor */
 #define LORA_DROPOUT        0.0f  /* no dropout on bare-metal */
 #define LORA_SCORE_MIN      0.65f /* D+ minimum score to accept a patch */
 
-/* Adapter for one projection matrix (e.g. Wq, Wk, Wv) */
+/* Projection matrices, in transformer_forward order.
+ * 0..2 keep their historical meaning (Wq, Wk, Wv). */
+enum {
+    OO_LORA_WQ = 0,   /* dim        → dim        */
+    OO_LORA_WK,       /* dim        → kv_dim     */
+    OO_LORA_WV,       /* dim        → kv_dim     */
+    OO_LORA_WO,       /* dim        → dim        */
+    OO_LORA_W1,       /* dim        → hidden_dim */
+    OO_LORA_W2,       /* hidden_dim → dim        */
+    OO_LORA_W3,       /* dim        → hidden_dim */
+    OO_LORA_NPROJ
+};
+
+/* Adapter for one projection matrix W[out_dim][in_dim]:
+ *   y += scale * B * (A * x)
+ * Both factors are stored row-per-use so the kernels stream them:
+ * A row k is contiguous over in_dim, B row j is contiguous over rank. */
 typedef struct {
     UINT32  in_dim;
     UINT32  out_dim;
-    UINT32  rank;
-    float  *A;   /* [in_dim × rank]  — random init */
-    float  *B;   /* [rank  × out_dim] — zero init   */
+    UINT32  rank;     /* 0 = projection not adapted */
+    float  *A;   /* [rank    × in_dim] — random init */
+    float  *B;   /* [out_dim × rank]   — zero init   */
     float   scale;
 } oo_lora_adapter_t;
 
-/* Full LoRA state (one per model) */
+/* One saturated Q8_0 code: block = running block index in merge order */
+typedef struct oo_lora_spill {
+    UINT32  block;
+    UINT8   lane;
+    UINT8   _pad;
+    INT16   over;    /* true code - stored code */
+} oo_lora_spill_t;
+
+/* Full LoRA state (one per adapter) */
 typedef struct {
-    oo_lora_adapter_t layers[LORA_MAX_LAYERS][3]; /* 3 = Wq,Wk,Wv */
+    oo_lora_adapter_t layers[LORA_MAX_LAYERS][OO_LORA_NPROJ];
     UINT32  n_layers;
     float   learning_rate;
     UINT64  step_count;
     float   last_score;
     UINT8   dirty;   /* 1 = needs persist to NVMe */
+    UINT8   merged;  /* 1 = currently folded into the model weights */
+    UINT32  q8_clipped;  /* saturated codes the spill could not hold */
+    struct oo_lora_spill *spill;   /* Q8_0 merge overflow log (optional) */
+    UINT32  spill_n;
+    UINT32  spill_cap;
+    float  *mem;         /* caller arena holding every A and B */
+    UINT64  mem_floats;
 } oo_lora_state_t;
 
+/* Weight layout of one projection across layers (built by the caller) */
+#define OO_LORA_W_F32   0   /* float rows of in_dim            */
+#define OO_LORA_W_Q8_0  1   /* rows of in_dim/32 × 34-byte blocks */
+
+typedef struct {
+    UINT8  *base;         /* layer 0 */
+    UINT64  layer_bytes;  /* stride between layers */
+    UINT32  in_dim;
+    UINT32  out_dim;
+    UINT8   kind;
+} oo_lora_weight_t;
+
+typedef struct {
+    oo_lora_weight_t w[OO_LORA_NPROJ];
+    UINT32 n_layers;
+} oo_lora_model_t;
+
+/* Resident adapters + the one inference uses */
+typedef struct {
+    oo_lora_state_t *slot[LORA_MAX_SLOTS];
+    UINT32  n_slots;
+    INT32   active;   /* -1 = base model */
+} oo_lora_bank_t;
+
 /* Public API */
+UINT64 oo_lora_bytes(UINT32 n_layers, UINT32 dim, UINT32 kv_dim,
+                     UINT32 hidden_dim, UINT32 rank);
 int   oo_lora_init(oo_lora_state_t *st, UINT32 n_layers,
-                   UINT32 dim, UINT32 rank);
-void  oo_lora_forward(oo_lora_adapter_t *a, const float *x,
+                   UINT32 dim, UINT32 kv_dim, UINT32 hidden_dim,
+                   UINT32 rank, void *mem, UINT64 mem_bytes);
+void  oo_lora_forward(const oo_lora_adapter_t *a, const float *x,
                       float *out, UINT32 n);
 void  oo_lora_backward_step(oo_lora_state_t *st, const float *grad,
                             UINT32 layer_idx, UINT32 proj_idx);
@@ -52,10 +135,29 @@ int   oo_lora_persist(const oo_lora_state_t *st,
                       const char *nvme_path);       /* save to NVMe */
 int   oo_lora_load(oo_lora_state_t *st,
                    const char *nvme_path);           /* load from NVMe */
-void  oo_lora_apply_to_model(oo_lora_state_t *st,
-                             void *model_weights);   /* merge into base */
 void  oo_lora_print(const oo_lora_state_t *st);    /* display adapter state */
 int   oo_lora_repl_cmd(oo_lora_state_t *st, const char *cmd);
        /* /lora_status /lora_step /lora_score /lora_persist /lora_load */
 
+/* Fused kernels: xout(d) = W(d × n)·x(n) + adapter term (a may be NULL) */
+void  oo_lora_set_cpu(int has_avx2);
+void  oo_lora_matmul_f32(float *xout, const float *x, const float *w,
+                         UINT32 n, UINT32 d, const oo_lora_adapter_t *a);
+void  oo_lora_matmul_q8_0(float *xout, const float *x, const UINT8 *w,
+                          UINT32 n, UINT32 d, const oo_lora_adapter_t *a);
+
+/* Merge / unmerge ΔW into the weights described by m (0 = ok).
+ * set_spill hands over the Q8_0 overflow log (entries = bytes / 8). */
+void  oo_lora_set_spill(oo_lora_state_t *st, void *mem, UINT64 bytes);
+int   oo_lora_merge(oo_lora_state_t *st, const oo_lora_model_t *m);
+int   oo_lora_unmerge(oo_lora_state_t *st, const oo_lora_model_t *m);
+
+/* Bank: add returns the slot index (<0 = full); select unmerges the
+ * current adapter, then activates `slot` (-1 = none), merging it if asked */
+int   oo_lora_bank_add(oo_lora_bank_t *bk, oo_lora_state_t *st);
+int   oo_lora_bank_select(oo_lora_bank_t *bk, INT32 slot,
+                          const oo_lora_model_t *m, int merge);
+oo_lora_state_t *oo_lora_bank_active(const oo_lora_bank_t *bk);
+
 extern oo_lora_state_t g_lora;
+extern oo_lora_bank_t  g_lora_bank;   /* slot 0 = g_lora */
@@ -30,6 +30,7 @@ typedef int       BOOLEAN;
 typedef uint64_t  EFI_STATUS;
 typedef void *    EFI_HANDLE;
 typedef uint16_t  CHAR16;
+typedef uint8_t   CHAR8;
 
 /* ── Minimal EFI_FILE_PROTOCOL stub ─────────────────────────────────────── */
 #ifndef EFI_FILE_PROTOCOL_STUB
@@ -97,7 +98,14 @@ typedef EFI_FILE_PROTOCOL * EFI_FILE_HANDLE;
 #define EFI_SUCCESS 0ULL
 #endif
 #ifndef EFI_NOT_FOUND
-#define EFI_NOT_FOUND 0x8000000000000000ULL | 14ULL
+#define EFI_NOT_FOUND (0x8000000000000000ULL | 14ULL)
+#endif
+#ifndef EFI_INVALID_PARAMETER
+#define EFI_INVALID_PARAMETER (0x8000000000000000ULL | 2ULL)
+#define EFI_BAD_BUFFER_SIZE   (0x8000000000000000ULL | 4ULL)
+#define EFI_NOT_READY         (0x8000000000000000ULL | 6ULL)
+#define EFI_OUT_OF_RESOURCES  (0x8000000000000000ULL | 9ULL)
+#define EFI_ABORTED           (0x8000000000000000ULL | 21ULL)
 #endif
 
 /* ── Wide string helpers (stubs) ─────────────────────────────────────────── */
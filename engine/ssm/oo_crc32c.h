@@ -0,0 +1,42 @@
+// oo_crc32c.h — CRC32C (Castagnoli) for on-disk record framing
+//
+// Shared by the log-structured stores (NeuralFS log, Soma journal) that
+// frame every record with a CRC so replay can stop at the first torn write.
+//
+// Table-driven (1 KB table built on first use); incremental API so headers
+// and payloads can be checksummed without copying them together.
+//
+// Freestanding C11 — no libc.
+
+#pragma once
+
+#include <stdint.h>
+
+#define OO_CRC32C_POLY  0x82F63B78u   // reflected Castagnoli polynomial
+
+static uint32_t g_oo_crc32c_table[256];
+static int      g_oo_crc32c_ready = 0;
+
+static inline void oo_crc32c_init_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int b = 0; b < 8; b++)
+            c = (c & 1u) ? (c >> 1) ^ OO_CRC32C_POLY : (c >> 1);
+        g_oo_crc32c_table[i] = c;
+    }
+    g_oo_crc32c_ready = 1;
+}
+
+// Continue a running CRC. Start with crc = 0; result is final (no extra xor).
+static inline uint32_t oo_crc32c_update(uint32_t crc, const void *buf, unsigned int len) {
+    if (!g_oo_crc32c_ready) oo_crc32c_init_table();
+    const unsigned char *p = (const unsigned char *)buf;
+    crc = ~crc;
+    for (unsigned int i = 0; i < len; i++)
+        crc = g_oo_crc32c_table[(crc ^ p[i]) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
+
+static inline uint32_t oo_crc32c(const void *buf, unsigned int len) {
+    return oo_crc32c_update(0u, buf, len);
+}
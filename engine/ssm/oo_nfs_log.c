@@ -0,0 +1,359 @@
+// oo_nfs_log.c — NeuralFS log store (hash-indexed, log-structured KV)
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "oo_nfs_log.h"
+#include "oo_crc32c.h"
+
+// ============================================================
+// Internal helpers
+// ============================================================
+
+static uint32_t nfsl_hash(const char *key, uint32_t len) {
+    uint32_t h = 2166136261u;                  // FNV-1a
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t nfsl_strlen(const char *s) {
+    uint32_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+static void nfsl_memcpy(void *dst, const void *src, uint32_t n) {
+    unsigned char *d = (unsigned char *)dst;
+    const unsigned char *p = (const unsigned char *)src;
+    for (uint32_t i = 0; i < n; i++) d[i] = p[i];
+}
+
+static int nfsl_keyeq(const unsigned char *a, const char *b, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++)
+        if (a[i] != (unsigned char)b[i]) return 0;
+    return 1;
+}
+
+static const NfslRecHdr *nfsl_hdr_at(const NfslStore *s, uint32_t off) {
+    return (const NfslRecHdr *)(s->log + off);
+}
+
+static uint32_t nfsl_rec_crc(const NfslRecHdr *h, const void *key, const void *val) {
+    NfslRecHdr tmp = *h;
+    tmp.crc = 0;
+    uint32_t crc = oo_crc32c_update(0u, &tmp, (unsigned int)sizeof(tmp));
+    crc = oo_crc32c_update(crc, key, h->key_len);
+    return oo_crc32c_update(crc, val, h->val_len);
+}
+
+// Probe for key. Returns the slot holding it, or NULL. If ins_out is given it
+// receives the first reusable slot (tombstone or empty) along the probe path.
+static NfslSlot *nfsl_probe(const NfslStore *s, const char *key, uint32_t key_len,
+                            uint32_t h, NfslSlot **ins_out) {
+    uint32_t mask = s->index_cap - 1u;
+    NfslSlot *ins = (NfslSlot *)0;
+    for (uint32_t n = 0, i = h & mask; n < s->index_cap; n++, i = (i + 1u) & mask) {
+        NfslSlot *sl = &s->index[i];
+        if (sl->off_plus1 == NFSL_SLOT_EMPTY) {
+            if (!ins) ins = sl;
+            break;
+        }
+        if (sl->off_plus1 == NFSL_SLOT_TOMB) {
+            if (!ins) ins = sl;
+            continue;
+        }
+        if (sl->hash != h) continue;
+        const NfslRecHdr *r = nfsl_hdr_at(s, sl->off_plus1 - 1u);
+        if (r->key_len == key_len &&
+            nfsl_keyeq((const unsigned char *)(r + 1), key, key_len)) {
+            if (ins_out) *ins_out = ins;
+            return sl;
+        }
+    }
+    if (ins_out) *ins_out = ins;
+    return (NfslSlot *)0;
+}
+
+static void nfsl_clear_index(NfslStore *s) {
+    for (uint32_t i = 0; i < s->index_cap; i++) {
+        s->index[i].hash = 0;
+        s->index[i].off_plus1 = NFSL_SLOT_EMPTY;
+    }
+    s->index_used = 0;
+}
+
+static int nfsl_index_full(const NfslStore *s) {
+    return (s->index_used + 1u) * NFSL_INDEX_LOAD_DEN > s->index_cap * NFSL_INDEX_LOAD_NUM;
+}
+
+// Append one record at log_len (caller checked space).
+static uint32_t nfsl_append(NfslStore *s, uint8_t type, const char *key, uint32_t key_len,
+                            const void *val, uint32_t val_len) {
+    uint32_t off = s->log_len;
+    NfslRecHdr h;
+    h.magic   = NFSL_REC_MAGIC;
+    h.type    = type;
+    h.key_len = (uint8_t)key_len;
+    h.val_len = val_len;
+    h.seq     = ++s->seq;
+    h.crc     = 0;
+    h.crc     = nfsl_rec_crc(&h, key, val);
+
+    unsigned char *p = s->log + off;
+    nfsl_memcpy(p, &h, (uint32_t)sizeof(h));
+    nfsl_memcpy(p + sizeof(h), key, key_len);
+    nfsl_memcpy(p + sizeof(h) + key_len, val, val_len);
+    uint32_t used = (uint32_t)sizeof(h) + key_len + val_len;
+    uint32_t size = nfsl_rec_size(key_len, val_len);
+    for (uint32_t i = used; i < size; i++) p[i] = 0;
+    s->log_len += size;
+    return off;
+}
+
+static int nfsl_reserve(NfslStore *s, uint32_t need) {
+    if (s->log_len + need <= s->log_cap) return NFSL_OK;
+    if (s->dead_bytes >= need) nfsl_compact(s);
+    return (s->log_len + need <= s->log_cap) ? NFSL_OK : NFSL_ERR_NOSPACE;
+}
+
+// ============================================================
+// API
+// ============================================================
+
+int nfsl_init(NfslStore *s, void *log_mem, uint32_t log_cap,
+              void *index_mem, uint32_t index_cap) {
+    if (!s || !log_mem || !index_mem) return NFSL_ERR_ARG;
+    if (index_cap < 8u || (index_cap & (index_cap - 1u))) return NFSL_ERR_ARG;
+    if (log_cap < 2u * nfsl_rec_size(0, 4)) return NFSL_ERR_ARG;
+
+    unsigned char *p = (unsigned char *)s;
+    for (uint32_t i = 0; i < (uint32_t)sizeof(*s); i++) p[i] = 0;
+    s->log       = (unsigned char *)log_mem;
+    s->log_cap   = log_cap;
+    s->index     = (NfslSlot *)index_mem;
+    s->index_cap = index_cap;
+    nfsl_clear_index(s);
+
+    s->generation = 1;
+    nfsl_append(s, NFSL_REC_HDR, "", 0, &s->generation, 4);
+    nfsl_append(s, NFSL_REC_COMMIT, "", 0, "", 0);
+    s->committed = 1;
+    return NFSL_OK;
+}
+
+int nfsl_put(NfslStore *s, const char *key, uint32_t key_len,
+             const void *val, uint32_t val_len) {
+    if (!s || !key || key_len == 0 || key_len > NFSL_KEY_MAX) return NFSL_ERR_ARG;
+    if (!val && val_len) return NFSL_ERR_ARG;
+    // A record larger than the whole log can never fit; reject it before
+    // nfsl_rec_size() wraps around in u32 and reports a tiny record.
+    uint32_t room = s->log_cap - (uint32_t)sizeof(NfslRecHdr);
+    if (key_len > room || val_len > room - key_len) return NFSL_ERR_ARG;
+
+    uint32_t need = nfsl_rec_size(key_len, val_len);
+    int rc = nfsl_reserve(s, need);
+    if (rc != NFSL_OK) return rc;
+
+    uint32_t h = nfsl_hash(key, key_len);
+    NfslSlot *ins = (NfslSlot *)0;
+    NfslSlot *sl = nfsl_probe(s, key, key_len, h, &ins);
+    if (!sl) {
+        if (!ins) return NFSL_ERR_INDEX;
+        if (ins->off_plus1 == NFSL_SLOT_EMPTY && nfsl_index_full(s)) {
+            // Tombstones may be hogging the table: rebuild, then retry once.
+            if (s->index_used > s->live_count) {
+                nfsl_replay(s, s->log_len);
+                sl = nfsl_probe(s, key, key_len, h, &ins);
+            }
+            if (!sl && (!ins || (ins->off_plus1 == NFSL_SLOT_EMPTY && nfsl_index_full(s))))
+                return NFSL_ERR_INDEX;
+        }
+    }
+
+    uint32_t off = nfsl_append(s, NFSL_REC_PUT, key, key_len, val, val_len);
+    if (sl) {
+        const NfslRecHdr *old = nfsl_hdr_at(s, sl->off_plus1 - 1u);
+        s->dead_bytes += nfsl_rec_size(old->key_len, old->val_len);
+        sl->off_plus1 = off + 1u;
+    } else {
+        if (ins->off_plus1 == NFSL_SLOT_EMPTY) s->index_used++;
+        ins->hash = h;
+        ins->off_plus1 = off + 1u;
+        s->live_count++;
+    }
+    s->total_puts++;
+    return NFSL_OK;
+}
+
+int nfsl_put_str(NfslStore *s, const char *key, const char *val) {
+    if (!key || !val) return NFSL_ERR_ARG;
+    // Store the terminator so nfsl_get_str() can hand out C strings.
+    return nfsl_put(s, key, nfsl_strlen(key), val, nfsl_strlen(val) + 1u);
+}
+
+const void *nfsl_get(const NfslStore *s, const char *key, uint32_t key_len,
+                     uint32_t *out_len) {
+    if (!s || !key || key_len == 0 || key_len > NFSL_KEY_MAX) return (const void *)0;
+    NfslSlot *sl = nfsl_probe(s, key, key_len, nfsl_hash(key, key_len), (NfslSlot **)0);
+    if (!sl) return (const void *)0;
+    const NfslRecHdr *r = nfsl_hdr_at(s, sl->off_plus1 - 1u);
+    if (out_len) *out_len = r->val_len;
+    return (const unsigned char *)(r + 1) + r->key_len;
+}
+
+const char *nfsl_get_str(const NfslStore *s, const char *key, uint32_t *out_len) {
+    if (!key) return (const char *)0;
+    uint32_t n = 0;
+    const char *v = (const char *)nfsl_get(s, key, nfsl_strlen(key), &n);
+    if (!v || n == 0 || v[n - 1] != '\0') return (const char *)0;
+    if (out_len) *out_len = n - 1u;
+    return v;
+}
+
+int nfsl_delete(NfslStore *s, const char *key, uint32_t key_len) {
+    if (!s || !key || key_len == 0 || key_len > NFSL_KEY_MAX) return NFSL_ERR_ARG;
+    uint32_t h = nfsl_hash(key, key_len);
+    NfslSlot *sl = nfsl_probe(s, key, key_len, h, (NfslSlot **)0);
+    if (!sl) return NFSL_ERR_NOTFOUND;
+
+    uint32_t need = nfsl_rec_size(key_len, 0);
+    if (nfsl_reserve(s, need) != NFSL_OK) return NFSL_ERR_NOSPACE;
+    // nfsl_reserve() may have compacted and moved the record.
+    sl = nfsl_probe(s, key, key_len, h, (NfslSlot **)0);
+    if (!sl) return NFSL_ERR_NOTFOUND;
+
+    const NfslRecHdr *old = nfsl_hdr_at(s, sl->off_plus1 - 1u);
+    s->dead_bytes += nfsl_rec_size(old->key_len, old->val_len) + need;
+    nfsl_append(s, NFSL_REC_DEL, key, key_len, "", 0);
+    sl->off_plus1 = NFSL_SLOT_TOMB;
+    s->live_count--;
+    s->total_dels++;
+    return NFSL_OK;
+}
+
+int nfsl_compact(NfslStore *s) {
+    if (!s) return NFSL_ERR_ARG;
+    uint32_t gen = s->generation + 1u;
+    uint32_t hdr_size = nfsl_rec_size(0, 4);
+    uint32_t r = 0, w = hdr_size;   // HDR is rewritten once the body is packed
+
+    while (r < s->log_len) {
+        const NfslRecHdr *h = nfsl_hdr_at(s, r);
+        uint32_t size = nfsl_rec_size(h->key_len, h->val_len);
+        if (h->type == NFSL_REC_PUT) {
+            const char *key = (const char *)(h + 1);
+            NfslSlot *sl = nfsl_probe(s, key, h->key_len, nfsl_hash(key, h->key_len),
+                                      (NfslSlot **)0);
+            if (sl && sl->off_plus1 == r + 1u) {
+                // w <= r, so an ascending copy never clobbers unread bytes.
+                if (w != r) nfsl_memcpy(s->log + w, s->log + r, size);
+                sl->off_plus1 = w + 1u;
+                w += size;
+            }
+        }
+        r += size;
+    }
+
+    // Re-emit the image header and a COMMIT marker around the live records.
+    uint32_t body_end = w;
+    s->log_len = 0;
+    nfsl_append(s, NFSL_REC_HDR, "", 0, &gen, 4);
+    s->log_len = body_end;
+    nfsl_append(s, NFSL_REC_COMMIT, "", 0, "", 0);
+
+    uint32_t compactions = s->compactions + 1u;
+    nfsl_replay(s, s->log_len);
+    s->compactions = compactions;
+    return NFSL_OK;
+}
+
+uint32_t nfsl_replay(NfslStore *s, uint32_t len) {
+    if (!s) return 0;
+    s->truncated = 0;
+    if (len > s->log_cap) {
+        len = s->log_cap;
+        s->truncated = 1;
+    }
+
+    nfsl_clear_index(s);
+    s->live_count = 0;
+    s->dead_bytes = 0;
+    s->committed  = 0;
+
+    uint32_t off = 0;
+    uint32_t max_seq = s->seq;
+    while (off + (uint32_t)sizeof(NfslRecHdr) <= len) {
+        const NfslRecHdr *h = nfsl_hdr_at(s, off);
+        if (h->magic != NFSL_REC_MAGIC) break;
+        if (h->type < NFSL_REC_HDR || h->type > NFSL_REC_COMMIT) break;
+        if (h->val_len > len - off) break;
+        uint32_t size = nfsl_rec_size(h->key_len, h->val_len);
+        if (size > len - off) break;
+        const unsigned char *key = (const unsigned char *)(h + 1);
+        if (nfsl_rec_crc(h, key, key + h->key_len) != h->crc) break;
+        // The image header must lead the log, and only there.
+        if ((h->type == NFSL_REC_HDR) != (off == 0)) break;
+
+        if (h->seq > max_seq) max_seq = h->seq;
+        if (h->type == NFSL_REC_HDR) {
+            if (h->val_len == 4) nfsl_memcpy(&s->generation, key + h->key_len, 4);
+        } else if (h->type == NFSL_REC_COMMIT) {
+            s->committed = 1;
+            s->dead_bytes += size;
+        } else {
+            uint32_t kh = nfsl_hash((const char *)key, h->key_len);
+            NfslSlot *ins = (NfslSlot *)0;
+            NfslSlot *sl = nfsl_probe(s, (const char *)key, h->key_len, kh, &ins);
+            if (sl) {
+                const NfslRecHdr *old = nfsl_hdr_at(s, sl->off_plus1 - 1u);
+                s->dead_bytes += nfsl_rec_size(old->key_len, old->val_len);
+            }
+            if (h->type == NFSL_REC_PUT) {
+                if (sl) {
+                    sl->off_plus1 = off + 1u;
+                } else {
+                    if (!ins || (ins->off_plus1 == NFSL_SLOT_EMPTY && nfsl_index_full(s))) {
+                        s->truncated = 1;   // index too small for this image: keep the prefix
+                        break;
+                    }
+                    if (ins->off_plus1 == NFSL_SLOT_EMPTY) s->index_used++;
+                    ins->hash = kh;
+                    ins->off_plus1 = off + 1u;
+                    s->live_count++;
+                }
+            } else {
+                s->dead_bytes += size;
+                if (sl) {
+                    sl->off_plus1 = NFSL_SLOT_TOMB;
+                    s->live_count--;
+                }
+            }
+        }
+        off += size;
+    }
+
+    s->log_len = off;
+    s->seq = max_seq;
+    if (s->flushed > off) s->flushed = off;
+    return off;
+}
+
+void nfsl_foreach(const NfslStore *s, NfslVisitFn fn, void *ctx) {
+    if (!s || !fn) return;
+    uint32_t off = 0;
+    while (off < s->log_len) {
+        const NfslRecHdr *h = nfsl_hdr_at(s, off);
+        uint32_t size = nfsl_rec_size(h->key_len, h->val_len);
+        if (h->type == NFSL_REC_PUT) {
+            const char *key = (const char *)(h + 1);
+            NfslSlot *sl = nfsl_probe(s, key, h->key_len, nfsl_hash(key, h->key_len),
+                                      (NfslSlot **)0);
+            if (sl && sl->off_plus1 == off + 1u &&
+                fn(ctx, key, h->key_len, key + h->key_len, h->val_len))
+                return;
+        }
+        off += size;
+    }
+}
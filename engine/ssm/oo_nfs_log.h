@@ -0,0 +1,154 @@
+// oo_nfs_log.h — NeuralFS log store: hash-indexed, log-structured KV (Phase F2)
+//
+// Successor to the fixed 64 × 384-byte Nfs2Store for agent memory. Values are
+// variable-size and appended to a single log buffer; an open-addressing hash
+// index maps each key to the offset of its newest record.
+//
+// Log layout (all fields little-endian, records 4-byte aligned):
+//   [NfslRecHdr][key bytes][value bytes][pad to 4]
+//   crc = CRC32C over header (crc field = 0) + key + value
+//
+// Record types:
+//   HDR     first record of every log image, value = u32 generation
+//   PUT     key → value (newest record wins)
+//   DEL     tombstone for key
+//   COMMIT  marks a fully written compacted image (see oo_nfs_log_persist.h)
+//
+// Deletes and overwrites leave dead bytes behind; nfsl_compact() rewrites
+// the log in place with only live records and bumps the generation.
+// nfsl_replay() rebuilds the index from raw log bytes at boot and stops at
+// the first record with a bad magic/length/CRC (torn write).
+//
+// Memory is caller-provided (Zone C at boot, malloc in host tests).
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================
+// Constants
+// ============================================================
+
+#define NFSL_REC_MAGIC      0x4C46u      // "FL"
+#define NFSL_KEY_MAX        255          // key_len is a u8
+#define NFSL_ALIGN          4u
+
+#define NFSL_REC_HDR        1
+#define NFSL_REC_PUT        2
+#define NFSL_REC_DEL        3
+#define NFSL_REC_COMMIT     4
+
+#define NFSL_SLOT_EMPTY     0u           // slot.off_plus1 == 0
+#define NFSL_SLOT_TOMB      0xFFFFFFFFu  // slot.off_plus1 == TOMB
+
+// Index load limit: live + tombstone slots may use at most 3/4 of the table.
+#define NFSL_INDEX_LOAD_NUM 3u
+#define NFSL_INDEX_LOAD_DEN 4u
+
+// Status codes
+#define NFSL_OK             0
+#define NFSL_ERR_ARG       -1
+#define NFSL_ERR_NOSPACE   -2    // log full even after compaction
+#define NFSL_ERR_INDEX     -3    // hash index at load limit
+#define NFSL_ERR_NOTFOUND  -4
+
+// ============================================================
+// Types
+// ============================================================
+
+typedef struct {
+    uint16_t magic;      // NFSL_REC_MAGIC
+    uint8_t  type;       // NFSL_REC_*
+    uint8_t  key_len;    // bytes of key following the header
+    uint32_t val_len;    // bytes of value following the key
+    uint32_t seq;        // monotonically increasing write sequence
+    uint32_t crc;        // CRC32C of header(crc=0) + key + value
+} NfslRecHdr;            // 16 bytes
+
+typedef struct {
+    uint32_t hash;       // full key hash (probe shortcut)
+    uint32_t off_plus1;  // record offset + 1, or NFSL_SLOT_EMPTY / NFSL_SLOT_TOMB
+} NfslSlot;
+
+typedef struct {
+    unsigned char *log;          // log buffer
+    uint32_t       log_cap;      // bytes
+    uint32_t       log_len;      // bytes of valid records
+
+    NfslSlot      *index;        // open-addressing table
+    uint32_t       index_cap;    // slots (power of two)
+    uint32_t       index_used;   // live + tombstone slots
+
+    uint32_t       live_count;   // live keys
+    uint32_t       dead_bytes;   // bytes reclaimable by compaction
+    uint32_t       seq;          // last sequence number written
+    uint32_t       generation;   // bumped by every compaction
+    uint32_t       committed;    // replay saw a COMMIT record
+    uint32_t       truncated;    // replay stopped before the end of a valid image
+
+    // Persistence cursor (owned by oo_nfs_log_persist.c)
+    uint32_t       flushed;      // bytes of log already on disk
+    uint32_t       flushed_gen;  // generation those bytes belong to
+
+    // Stats
+    uint32_t       compactions;
+    uint32_t       total_puts;
+    uint32_t       total_dels;
+} NfslStore;
+
+// Callback for nfsl_foreach(); return non-zero to stop early.
+typedef int (*NfslVisitFn)(void *ctx, const char *key, uint32_t key_len,
+                           const void *val, uint32_t val_len);
+
+// ============================================================
+// API
+// ============================================================
+
+// Bind memory and write an empty image (HDR gen=1 + COMMIT).
+// index_cap must be a power of two; the index memory is cleared here.
+int nfsl_init(NfslStore *s, void *log_mem, uint32_t log_cap,
+              void *index_mem, uint32_t index_cap);
+
+// Create or replace key. Compacts automatically when the log is full and
+// enough dead bytes exist, so val must not point into the log itself.
+// Returns NFSL_OK or NFSL_ERR_*.
+int nfsl_put(NfslStore *s, const char *key, uint32_t key_len,
+             const void *val, uint32_t val_len);
+
+// Null-terminated convenience wrappers.
+int nfsl_put_str(NfslStore *s, const char *key, const char *val);
+const char *nfsl_get_str(const NfslStore *s, const char *key, uint32_t *out_len);
+
+// Pointer into the log for key's value (valid until the next put/compact).
+const void *nfsl_get(const NfslStore *s, const char *key, uint32_t key_len,
+                     uint32_t *out_len);
+
+// Append a tombstone. Returns NFSL_ERR_NOTFOUND if key is absent.
+int nfsl_delete(NfslStore *s, const char *key, uint32_t key_len);
+
+// Rewrite the log in place with only live records; bumps generation.
+int nfsl_compact(NfslStore *s);
+
+// Rebuild the index from log[0..len). Stops at the first invalid record
+// and truncates log_len there. Returns the number of valid bytes.
+// Sets truncated when valid records were dropped because len exceeds
+// log_cap or the index ran out of slots.
+uint32_t nfsl_replay(NfslStore *s, uint32_t len);
+
+// Visit every live key in log order.
+void nfsl_foreach(const NfslStore *s, NfslVisitFn fn, void *ctx);
+
+// Record size on disk for a given key/value length (header + payload + pad).
+static inline uint32_t nfsl_rec_size(uint32_t key_len, uint32_t val_len) {
+    uint32_t n = (uint32_t)sizeof(NfslRecHdr) + key_len + val_len;
+    return (n + NFSL_ALIGN - 1u) & ~(NFSL_ALIGN - 1u);
+}
+
+#ifdef __cplusplus
+}
+#endif
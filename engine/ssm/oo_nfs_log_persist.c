@@ -0,0 +1,175 @@
+// oo_nfs_log_persist.c — Segment-file persistence for the NeuralFS log store
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "oo_nfs_log_persist.h"
+
+// ─── Segment file helpers ───────────────────────────────────────────────────
+
+// "NFSL" + set letter + 3-digit segment number + ".LOG"
+static void nfsl_seg_name(CHAR16 *out, char set, uint32_t seg) {
+    const char *pfx = "NFSL";
+    int i = 0;
+    for (; pfx[i]; i++) out[i] = (CHAR16)pfx[i];
+    out[i++] = (CHAR16)set;
+    out[i++] = (CHAR16)('0' + (seg / 100u) % 10u);
+    out[i++] = (CHAR16)('0' + (seg / 10u) % 10u);
+    out[i++] = (CHAR16)('0' + seg % 10u);
+    out[i++] = '.'; out[i++] = 'L'; out[i++] = 'O'; out[i++] = 'G';
+    out[i] = 0;
+}
+
+static EFI_FILE_HANDLE nfsl_seg_open(EFI_FILE_PROTOCOL *root, char set, uint32_t seg,
+                                     UINT64 mode) {
+    CHAR16 name[16];
+    nfsl_seg_name(name, set, seg);
+    EFI_FILE_HANDLE fh = NULL;
+    EFI_STATUS st = uefi_call_wrapper(root->Open, 5, root, &fh, name, mode, 0ULL);
+    if (EFI_ERROR(st)) return NULL;
+    return fh;
+}
+
+static void nfsl_delete_set(EFI_FILE_PROTOCOL *root, char set) {
+    for (uint32_t seg = 0; seg < NFSL_SEG_MAX; seg++) {
+        EFI_FILE_HANDLE fh = nfsl_seg_open(root, set, seg,
+                                           EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE);
+        if (!fh) break;
+        // Delete closes the handle automatically on success.
+        uefi_call_wrapper(fh->Delete, 1, fh);
+    }
+}
+
+static int nfsl_seg_write(EFI_FILE_PROTOCOL *root, char set, uint32_t seg,
+                          uint32_t pos, const unsigned char *buf, uint32_t len) {
+    EFI_FILE_HANDLE fh = nfsl_seg_open(root, set, seg,
+        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE);
+    if (!fh) return NFSL_PERSIST_IO_ERR;
+
+    uefi_call_wrapper(fh->SetPosition, 2, fh, (UINT64)pos);
+    UINTN sz = len;
+    EFI_STATUS st = uefi_call_wrapper(fh->Write, 3, fh, &sz, (void *)buf);
+    if (!EFI_ERROR(st)) st = uefi_call_wrapper(fh->Flush, 1, fh);
+    uefi_call_wrapper(fh->Close, 1, fh);
+
+    if (EFI_ERROR(st) || sz != len) return NFSL_PERSIST_IO_ERR;
+    return NFSL_PERSIST_OK;
+}
+
+// Generation recorded in a set's leading HDR record, or 0 if unreadable.
+static uint32_t nfsl_peek_gen(EFI_FILE_PROTOCOL *root, char set) {
+    EFI_FILE_HANDLE fh = nfsl_seg_open(root, set, 0, EFI_FILE_MODE_READ);
+    if (!fh) return 0;
+    unsigned char buf[sizeof(NfslRecHdr) + 4];
+    UINTN sz = sizeof(buf);
+    EFI_STATUS st = uefi_call_wrapper(fh->Read, 3, fh, &sz, buf);
+    uefi_call_wrapper(fh->Close, 1, fh);
+    if (EFI_ERROR(st) || sz < sizeof(buf)) return 0;
+
+    const NfslRecHdr *h = (const NfslRecHdr *)buf;
+    if (h->magic != NFSL_REC_MAGIC || h->type != NFSL_REC_HDR || h->val_len != 4) return 0;
+    uint32_t gen = 0;
+    for (int i = 0; i < 4; i++) gen |= (uint32_t)buf[sizeof(NfslRecHdr) + h->key_len + i] << (8 * i);
+    return gen;
+}
+
+// Read a set's segments back-to-back into the log buffer. Returns bytes read;
+// *clipped is set when the set holds more than log_cap bytes.
+static uint32_t nfsl_read_set(NfslStore *s, EFI_FILE_PROTOCOL *root, char set,
+                              int *clipped) {
+    uint32_t len = 0;
+    *clipped = 0;
+    for (uint32_t seg = 0; seg < NFSL_SEG_MAX && len < s->log_cap; seg++) {
+        EFI_FILE_HANDLE fh = nfsl_seg_open(root, set, seg, EFI_FILE_MODE_READ);
+        if (!fh) break;
+        UINTN want = NFSL_SEG_BYTES;
+        if (want > s->log_cap - len) want = s->log_cap - len;
+        UINTN sz = want;
+        EFI_STATUS st = uefi_call_wrapper(fh->Read, 3, fh, &sz, s->log + len);
+        uefi_call_wrapper(fh->Close, 1, fh);
+        if (EFI_ERROR(st)) break;
+        len += (uint32_t)sz;
+        if (sz < NFSL_SEG_BYTES) break;   // short segment = end of log
+    }
+    if (len < s->log_cap) return len;
+
+    // Buffer full: probe for a byte past it, in this segment or the next one.
+    EFI_FILE_HANDLE fh = nfsl_seg_open(root, set, len / NFSL_SEG_BYTES, EFI_FILE_MODE_READ);
+    if (fh) {
+        unsigned char b;
+        UINTN sz = 1;
+        uefi_call_wrapper(fh->SetPosition, 2, fh, (UINT64)(len % NFSL_SEG_BYTES));
+        EFI_STATUS st = uefi_call_wrapper(fh->Read, 3, fh, &sz, &b);
+        uefi_call_wrapper(fh->Close, 1, fh);
+        if (!EFI_ERROR(st) && sz == 1) *clipped = 1;
+    }
+    return len;
+}
+
+// ─── API ────────────────────────────────────────────────────────────────────
+
+int nfsl_persist_flush(NfslStore *s, EFI_FILE_PROTOCOL *root) {
+    if (!s || !root) return NFSL_PERSIST_IO_ERR;
+
+    uint32_t gen = s->generation;
+    char set   = (gen & 1u) ? 'B' : 'A';
+    char other = (gen & 1u) ? 'A' : 'B';
+    int rewrite = (s->flushed_gen != gen);
+    if (rewrite) {
+        // New image (first flush or post-compaction): start the set from scratch.
+        nfsl_delete_set(root, set);
+        s->flushed = 0;
+    }
+
+    uint32_t pos = s->flushed;
+    while (pos < s->log_len) {
+        uint32_t seg  = pos / NFSL_SEG_BYTES;
+        uint32_t in   = pos % NFSL_SEG_BYTES;
+        uint32_t take = NFSL_SEG_BYTES - in;
+        if (take > s->log_len - pos) take = s->log_len - pos;
+        if (seg >= NFSL_SEG_MAX) return NFSL_PERSIST_IO_ERR;
+        int rc = nfsl_seg_write(root, set, seg, in, s->log + pos, take);
+        if (rc != NFSL_PERSIST_OK) return rc;
+        pos += take;
+        s->flushed = pos;
+    }
+    s->flushed_gen = gen;
+
+    // The new image ends in a COMMIT record and is on disk: retire the old one.
+    if (rewrite) nfsl_delete_set(root, other);
+    return NFSL_PERSIST_OK;
+}
+
+int nfsl_persist_load(NfslStore *s, EFI_FILE_PROTOCOL *root) {
+    if (!s || !root) return NFSL_PERSIST_IO_ERR;
+
+    uint32_t gen_a = nfsl_peek_gen(root, 'A');
+    uint32_t gen_b = nfsl_peek_gen(root, 'B');
+    if (!gen_a && !gen_b) return NFSL_PERSIST_NOT_FOUND;
+
+    char order[2];
+    order[0] = (gen_b > gen_a) ? 'B' : 'A';
+    order[1] = (gen_b > gen_a) ? 'A' : 'B';
+
+    for (int i = 0; i < 2; i++) {
+        char set = order[i];
+        if (!(set == 'A' ? gen_a : gen_b)) continue;
+        int clipped;
+        uint32_t len = nfsl_read_set(s, root, set, &clipped);
+        nfsl_replay(s, len);
+        if (!s->committed) continue;   // compaction was interrupted: try the older image
+        s->flushed     = s->log_len;
+        s->flushed_gen = s->generation;
+        if (i == 1) nfsl_delete_set(root, order[0]);   // drop the torn rewrite
+        if (!clipped && !s->truncated) return NFSL_PERSIST_OK;
+
+        // The image did not fit: valid records past log_len are still on disk,
+        // so appending after the prefix would leave them behind it. Compacting
+        // bumps the generation, and the next flush rewrites the whole store
+        // into the other set before deleting this one.
+        nfsl_compact(s);
+        return NFSL_PERSIST_PARTIAL;
+    }
+
+    nfsl_init(s, s->log, s->log_cap, s->index, s->index_cap);
+    return NFSL_PERSIST_CORRUPT;
+}
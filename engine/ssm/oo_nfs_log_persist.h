@@ -0,0 +1,55 @@
+// oo_nfs_log_persist.h — Segment-file persistence for the NeuralFS log store
+//
+// The in-memory log is mirrored to append-only segment files on the EFI
+// volume, NFSL_SEG_BYTES per file:
+//   NFSLA000.LOG, NFSLA001.LOG, ...   image with even generation
+//   NFSLB000.LOG, NFSLB001.LOG, ...   image with odd generation
+//
+// Normal writes only append the unflushed tail of the log. After a
+// compaction the whole image is written to the other letter; the old set is
+// deleted only once the new one (ending in a COMMIT record) is on disk, so a
+// power loss mid-rewrite falls back to the previous image.
+//
+// At boot, nfsl_persist_load() reads the newest committed set back into the
+// log buffer and rebuilds the index with nfsl_replay(); a torn tail record
+// is dropped. An image larger than the log or the index keeps its leading
+// records only; the store is then compacted so the next flush replaces the
+// image on disk instead of appending to it.
+//
+// Freestanding C11 — no libc.
+
+#pragma once
+
+#include "oo_nfs_log.h"
+#include <efi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NFSL_SEG_BYTES      (256u * 1024u)
+#define NFSL_SEG_MAX        1000u
+
+// Boot-time base sizing (Zone C): 1 MB log, 16k-slot index (~12k keys at 3/4
+// load). soma_boot grows both to fit the semantic recall records on top.
+#define NFSL_BOOT_LOG_BYTES   (1024u * 1024u)
+#define NFSL_BOOT_INDEX_SLOTS 16384u
+
+// Status codes
+#define NFSL_PERSIST_OK         0
+#define NFSL_PERSIST_IO_ERR    -1
+#define NFSL_PERSIST_CORRUPT   -2
+#define NFSL_PERSIST_NOT_FOUND -3
+#define NFSL_PERSIST_PARTIAL    1   // loaded, but records past the store's capacity were dropped
+
+// Write everything not yet on disk. Cheap when nothing changed.
+int nfsl_persist_flush(NfslStore *s, EFI_FILE_PROTOCOL *root);
+
+// Replace s's contents with the newest committed image on disk.
+// s must already be bound with nfsl_init(); on failure it is left empty.
+// Returns NFSL_PERSIST_PARTIAL when the image did not fit s.
+int nfsl_persist_load(NfslStore *s, EFI_FILE_PROTOCOL *root);
+
+#ifdef __cplusplus
+}
+#endif
@@ -26,7 +26,7 @@ static int    _v3_argmax(const ssm_f32 *x, int n);
 static int    _v3_sample_topp(const ssm_f32 *probs, int n, ssm_f32 top_p,
                               uint32_t *rng);
 static void   _v3_conv1d_step(const ssm_f32 *wt, const ssm_f32 *bias,
-                              ssm_f32 *conv_buf, int *conv_pos,
+                              ssm_f32 *conv_buf, int pos,
                               const ssm_f32 *x_in, ssm_f32 *y,
                               int d_inner, int d_conv);
 
@@ -78,6 +78,7 @@ SsmStatus oosi_v3_gen_ctx_init(
     ctx->top_p          = top_p;
     ctx->repetition_penalty = 1.3f;  // default: moderate penalty
     ctx->rng_state      = seed ^ 0xDEADBEEFu;
+    ctx->exec           = NULL;
     ctx->max_tokens     = (max_tokens > 0) ? max_tokens : 64;
     ctx->tokens_generated = 0;
 
@@ -209,106 +210,174 @@ float oosi_v3_halt_forward(OosiV3HaltHead *head, const ssm_f32 *hidden,
 }
 
 // ============================================================
-// oosi_v3_forward_one  — full Mamba block forward pass
+// Mamba layer, split by output range
 // ============================================================
-OosiV3HaltResult oosi_v3_forward_one(OosiV3GenCtx *ctx, int token_id) {
+// Each kernel computes outputs [lo, hi) of one step of layer l and reads
+// only inputs that are complete before it starts, so any partition of the
+// range gives bit-identical results (oosi_v3_tp.h runs them across APs).
+// Every output element goes through the same expression in the same order
+// as with one range, and h_state / conv_buf rows of channel i are only
+// touched by the range holding i.
+
+typedef struct {
+    ssm_f32 *x_norm, *x_and_z, *x_conv, *xBCdt, *dt_full, *x_cur, *x_out;
+} V3Bufs;
+
+static V3Bufs _v3_bufs(const OosiV3GenCtx *ctx) {
     const OosiV3Weights *w = ctx->w;
-    int D  = w->d_model, N = w->n_layer, S = w->d_state;
-    int Di = w->d_inner,  Dc = w->d_conv, Dt = w->dt_rank;
+    V3Bufs b;
+    b.x_norm  = ctx->scratch;
+    b.x_and_z = b.x_norm  + w->d_model;
+    b.x_conv  = b.x_and_z + 2 * w->d_inner;
+    b.xBCdt   = b.x_conv  + w->d_inner;
+    b.dt_full = b.xBCdt   + (w->dt_rank + 2 * w->d_state);
+    b.x_cur   = b.dt_full + w->d_inner;   // residual stream [D]
+    b.x_out   = b.x_cur   + w->d_model;   // [D]
+    return b;
+}
+
+// in_proj rows of channels [lo, hi) (x and z halves), conv1d step, SiLU.
+// Reads x_norm; writes x_and_z, x_conv and conv_buf rows [lo, hi). The
+// ring position is advanced once per layer by the caller.
+void oosi_v3_mix_in(OosiV3GenCtx *ctx, int l, int lo, int hi) {
+    const OosiV3Weights *w = ctx->w;
+    const OosiV3LayerWeights *lw = &w->layers[l];
+    const int D = w->d_model, Di = w->d_inner, Dc = w->d_conv;
+    V3Bufs b = _v3_bufs(ctx);
+
+    // PyTorch layout: first Di = x (→conv→SSM), second Di = z (gate)
+    _v3_matvec_q8(lw->in_proj_q8 + (uint64_t)lo * D, lw->in_proj_scale + lo,
+                  b.x_norm, b.x_and_z + lo, hi - lo, D);
+    _v3_matvec_q8(lw->in_proj_q8 + (uint64_t)(Di + lo) * D, lw->in_proj_scale + Di + lo,
+                  b.x_norm, b.x_and_z + Di + lo, hi - lo, D);
+
+    _v3_conv1d_step(lw->conv_weight + (uint64_t)lo * Dc, lw->conv_bias ? lw->conv_bias + lo : NULL,
+                    ctx->conv_buf + ((uint64_t)l * Di + lo) * Dc, ctx->conv_pos[l],
+                    b.x_and_z + lo, b.x_conv + lo, hi - lo, Dc);
+    for (int i = lo; i < hi; i++) b.x_conv[i] = _v3_silu(b.x_conv[i]);
+}
 
-    // Scratch layout
-    ssm_f32 *x_norm  = ctx->scratch;
-    ssm_f32 *x_and_z = x_norm  + D;
-    ssm_f32 *x_conv  = x_and_z + 2 * Di;
-    ssm_f32 *xBCdt   = x_conv  + Di;
-    ssm_f32 *dt_full = xBCdt   + (Dt + 2 * S);
+// x_proj rows [lo, hi) of Dt + 2*S. Reads all of x_conv.
+void oosi_v3_mix_xproj(OosiV3GenCtx *ctx, int l, int lo, int hi) {
+    const OosiV3Weights *w = ctx->w;
+    const OosiV3LayerWeights *lw = &w->layers[l];
+    const int Di = w->d_inner;
+    V3Bufs b = _v3_bufs(ctx);
+    _v3_matvec_q8(lw->x_proj_q8 + (uint64_t)lo * Di, lw->x_proj_scale + lo,
+                  b.x_conv, b.xBCdt + lo, hi - lo, Di);
+}
 
-    // x_cur: current residual stream (points into scratch after dt_full)
-    ssm_f32 *x_cur = dt_full + Di;   // [D]
-    ssm_f32 *x_out = x_cur + D;      // [D]
+// dt_proj + softplus, selective scan (ZOH) and SiLU gate of channels
+// [lo, hi). Reads all of xBCdt; writes dt_full, h_state rows and y [lo, hi).
+void oosi_v3_mix_scan(OosiV3GenCtx *ctx, int l, int lo, int hi) {
+    const OosiV3Weights *w = ctx->w;
+    const OosiV3LayerWeights *lw = &w->layers[l];
+    const int S = w->d_state, Di = w->d_inner, Dt = w->dt_rank;
+    V3Bufs b = _v3_bufs(ctx);
+    const ssm_f32 *dt_raw = b.xBCdt;
+    const ssm_f32 *B_vec  = b.xBCdt + Dt;
+    const ssm_f32 *C_vec  = b.xBCdt + Dt + S;
+    const ssm_f32 *z_gate = b.x_and_z + Di;
+    ssm_f32 *hs = ctx->h_state + (uint64_t)l * Di * S;   // [Di * S]
+
+    _v3_matvec_q8(lw->dt_proj_q8 + (uint64_t)lo * Dt, lw->dt_proj_scale + lo,
+                  dt_raw, b.dt_full + lo, hi - lo, Dt);
+    for (int i = lo; i < hi; i++) {
+        b.dt_full[i] += lw->dt_proj_bias[i];
+        b.dt_full[i] = _v3_softplus(b.dt_full[i]);
+    }
+
+    // y_ssm reuses the x_expand slot (consumed by conv1d); z_gate (second
+    // half) stays intact for the gate.
+    ssm_f32 *y_ssm = b.x_and_z;
+    const ssm_f32 *precomp_nA = ctx->neg_exp_A
+        ? ctx->neg_exp_A + (int64_t)l * Di * S : NULL;
+    for (int i = lo; i < hi; i++) {
+        ssm_f32 dt_i = b.dt_full[i];
+        ssm_f32 y_i  = 0.0f;
+        for (int j = 0; j < S; j++) {
+            ssm_f32 neg_A = precomp_nA
+                ? precomp_nA[i * S + j]
+                : -_v3_expf(lw->A_log[i * S + j]);
+            ssm_f32 dA = _v3_expf(dt_i * neg_A);
+            ssm_f32 dB = dt_i * B_vec[j];
+            ssm_f32 *hij = &hs[i * S + j];
+            *hij = dA * (*hij) + dB * b.x_conv[i];
+            y_i += C_vec[j] * (*hij);
+        }
+        y_ssm[i] = y_i + lw->D[i] * b.x_conv[i];
+    }
+    for (int i = lo; i < hi; i++) y_ssm[i] *= _v3_silu(z_gate[i]);
+}
+
+// out_proj rows [lo, hi) of d_model and the residual add. Reads all of y.
+void oosi_v3_mix_out(OosiV3GenCtx *ctx, int l, int lo, int hi) {
+    const OosiV3Weights *w = ctx->w;
+    const OosiV3LayerWeights *lw = &w->layers[l];
+    const int Di = w->d_inner;
+    V3Bufs b = _v3_bufs(ctx);
+    _v3_matvec_q8(lw->out_proj_q8 + (uint64_t)lo * Di, lw->out_proj_scale + lo,
+                  b.x_and_z, b.x_out + lo, hi - lo, Di);
+    for (int i = lo; i < hi; i++) b.x_cur[i] = b.x_out[i] + b.x_cur[i];
+}
+
+// LM head rows [lo, hi) of vocab_size from the final-normed x_out
+void oosi_v3_mix_lm_head(OosiV3GenCtx *ctx, int l, int lo, int hi) {
+    (void)l;
+    const OosiV3Weights *w = ctx->w;
+    V3Bufs b = _v3_bufs(ctx);
+    _v3_matvec_q8(w->lm_head_q8 + (uint64_t)lo * w->d_model, w->lm_head_scale + lo,
+                  b.x_out, ctx->logits + lo, hi - lo, w->d_model);
+}
+
+// fn over [0, n): on the caller, or sliced by the attached executor
+static void _v3_run(OosiV3GenCtx *ctx, OosiV3RangeFn fn, int l, int n) {
+    if (ctx->exec) ctx->exec->run(ctx->exec->self, ctx, fn, l, n);
+    else fn(ctx, l, 0, n);
+}
+
+// ============================================================
+// oosi_v3_forward_hidden  — Mamba layers + final norm, no LM head
+// ============================================================
+const ssm_f32 *oosi_v3_forward_hidden(OosiV3GenCtx *ctx, int token_id) {
+    const OosiV3Weights *w = ctx->w;
+    int D  = w->d_model, N = w->n_layer, S = w->d_state;
+    int Di = w->d_inner,  Dc = w->d_conv, Dt = w->dt_rank;
+    V3Bufs b = _v3_bufs(ctx);
 
     // 1. Token embedding lookup (int8 dequant)
     {
         const ssm_q8  *row   = w->embed_q8    + (uint64_t)token_id * D;
         const ssm_f32  scale = w->embed_scale[token_id];
         for (int i = 0; i < D; i++)
-            x_cur[i] = (ssm_f32)row[i] * (scale / 127.0f);
+            b.x_cur[i] = (ssm_f32)row[i] * (scale / 127.0f);
     }
 
-    // 2. Mamba layers
+    // 2. Mamba layers: RMSNorm, in_proj + conv1d + SiLU, x_proj,
+    //    dt_proj + selective scan + gate, out_proj + residual
     for (int l = 0; l < N; l++) {
-        const OosiV3LayerWeights *lw = &w->layers[l];
-        ssm_f32 *hs   = ctx->h_state + (uint64_t)l * Di * S;   // [Di * S]
-        ssm_f32 *cbufl = ctx->conv_buf + (uint64_t)l * Di * Dc; // [Di * Dc]
-        int     *cpos  = &ctx->conv_pos[l];
-
-        // a. RMSNorm
-        _v3_rmsnorm(x_cur, lw->norm_weight, x_norm, D, 1e-5f);
-
-        // b. in_proj (int8): [2*Di × D] → x_and_z [2*Di]
-        //    PyTorch layout: first Di = x (→conv→SSM), second Di = z (gate)
-        _v3_matvec_q8(lw->in_proj_q8, lw->in_proj_scale,
-                      x_norm, x_and_z, 2*Di, D);
-        const ssm_f32 *x_expand = x_and_z;           // first Di = x
-        const ssm_f32 *z_gate   = x_and_z + Di;      // second Di = z (gate)
-
-        // c. Depthwise conv1d step
-        _v3_conv1d_step(lw->conv_weight, lw->conv_bias,
-                        cbufl, cpos, x_expand, x_conv, Di, Dc);
-
-        // d. SiLU
-        for (int i = 0; i < Di; i++) x_conv[i] = _v3_silu(x_conv[i]);
-
-        // e. x_proj (int8): [(Dt+2S) × Di] → xBCdt
-        _v3_matvec_q8(lw->x_proj_q8, lw->x_proj_scale,
-                      x_conv, xBCdt, Dt + 2*S, Di);
-        const ssm_f32 *dt_raw = xBCdt;
-        const ssm_f32 *B_vec  = xBCdt + Dt;
-        const ssm_f32 *C_vec  = xBCdt + Dt + S;
-
-        // f. dt_proj (int8): [Di × Dt] → dt_full + bias + softplus
-        _v3_matvec_q8(lw->dt_proj_q8, lw->dt_proj_scale,
-                      dt_raw, dt_full, Di, Dt);
-        for (int i = 0; i < Di; i++) {
-            dt_full[i] += lw->dt_proj_bias[i];
-            dt_full[i] = _v3_softplus(dt_full[i]);
-        }
-
-        // g. Selective SSM step (ZOH discretisation)
-        //    y_ssm reuses x_expand slot (first half, no longer needed after conv)
-        //    z_gate (second half) stays intact for gating step (h).
-        ssm_f32 *y_ssm = x_and_z;  // safe: x_expand already consumed by conv1d
-        const ssm_f32 *precomp_nA = ctx->neg_exp_A
-            ? ctx->neg_exp_A + (int64_t)l * Di * S : NULL;
-        for (int i = 0; i < Di; i++) {
-            ssm_f32 dt_i = dt_full[i];
-            ssm_f32 y_i  = 0.0f;
-            for (int j = 0; j < S; j++) {
-                ssm_f32 neg_A = precomp_nA
-                    ? precomp_nA[i * S + j]
-                    : -_v3_expf(lw->A_log[i * S + j]);
-                ssm_f32 dA = _v3_expf(dt_i * neg_A);
-                ssm_f32 dB = dt_i * B_vec[j];
-                ssm_f32 *hij = &hs[i * S + j];
-                *hij = dA * (*hij) + dB * x_conv[i];
-                y_i += C_vec[j] * (*hij);
-            }
-            y_ssm[i] = y_i + lw->D[i] * x_conv[i];
-        }
-
-        // h. SiLU gate
-        for (int i = 0; i < Di; i++) y_ssm[i] *= _v3_silu(z_gate[i]);
-
-        // i. out_proj (int8): [D × Di] → x_out
-        _v3_matvec_q8(lw->out_proj_q8, lw->out_proj_scale,
-                      y_ssm, x_out, D, Di);
-
-        // j. Residual
-        for (int i = 0; i < D; i++) x_cur[i] = x_out[i] + x_cur[i];
+        _v3_rmsnorm(b.x_cur, w->layers[l].norm_weight, b.x_norm, D, 1e-5f);
+        _v3_run(ctx, oosi_v3_mix_in, l, Di);
+        ctx->conv_pos[l] = (ctx->conv_pos[l] + 1) % Dc;
+        _v3_run(ctx, oosi_v3_mix_xproj, l, Dt + 2 * S);
+        _v3_run(ctx, oosi_v3_mix_scan, l, Di);
+        _v3_run(ctx, oosi_v3_mix_out, l, D);
     }
 
     // 3. Final RMSNorm
-    _v3_rmsnorm(x_cur, w->final_norm, x_out, D, 1e-5f);
+    _v3_rmsnorm(b.x_cur, w->final_norm, b.x_out, D, 1e-5f);
+    return b.x_out;
+}
+
+// ============================================================
+// oosi_v3_forward_one  — full Mamba block forward pass
+// ============================================================
+OosiV3HaltResult oosi_v3_forward_one(OosiV3GenCtx *ctx, int token_id) {
+    const OosiV3Weights *w = ctx->w;
+    int D = w->d_model;
+
+    // 1-3. Embedding, Mamba layers, final RMSNorm (x_out lives in scratch)
+    ssm_f32 *x_out = (ssm_f32 *)oosi_v3_forward_hidden(ctx, token_id);
 
     // 3.5 Soma-Adapter (LoRA In-Situ)
     // Applies autonomous learned delta to the hidden state before the LM head.
@@ -316,8 +385,7 @@ OosiV3HaltResult oosi_v3_forward_one(OosiV3GenCtx *ctx, int token_id) {
     oit_lora_apply_global(x_out, D);
 
     // 4. LM head (int8): [V × D] → logits
-    _v3_matvec_q8(w->lm_head_q8, w->lm_head_scale,
-                  x_out, ctx->logits, w->vocab_size, D);
+    _v3_run(ctx, oosi_v3_mix_lm_head, 0, w->vocab_size);
 
     // Debug: save raw logits before masking/softmax
     {
@@ -596,10 +664,9 @@ static int _v3_sample_topp(const ssm_f32 *probs, int n, ssm_f32 top_p,
 }
 
 static void _v3_conv1d_step(const ssm_f32 *wt, const ssm_f32 *bias,
-                            ssm_f32 *conv_buf, int *conv_pos,
+                            ssm_f32 *conv_buf, int pos,
                             const ssm_f32 *x_in, ssm_f32 *y,
                             int d_inner, int d_conv) {
-    int pos = *conv_pos;
     for (int i = 0; i < d_inner; i++) {
         // Write x_in[i] into ring buffer position
         conv_buf[i * d_conv + pos] = x_in[i];
@@ -614,5 +681,4 @@ static void _v3_conv1d_step(const ssm_f32 *wt, const ssm_f32 *bias,
         }
         y[i] = acc;
     }
-    *conv_pos = (pos + 1) % d_conv;
 }
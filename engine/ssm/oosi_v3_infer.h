@@ -23,9 +23,23 @@ typedef struct {
 } OosiV3HaltHead;
 
 // ============================================================
-// Generation context
+// Layer executor (oosi_v3_tp.h): runs a range kernel over [0, n)
 // ============================================================
+struct OosiV3GenCtx;
+
+// Computes outputs [lo, hi) of one step of layer l (oosi_v3_mix_*)
+typedef void (*OosiV3RangeFn)(struct OosiV3GenCtx *ctx, int l, int lo, int hi);
+
 typedef struct {
+    void *self;
+    // Returns once fn has covered [0, n) — in slices, on any cores
+    void (*run)(void *self, struct OosiV3GenCtx *ctx, OosiV3RangeFn fn, int l, int n);
+} OosiV3Exec;
+
+// ============================================================
+// Generation context
+// ============================================================
+typedef struct OosiV3GenCtx {
     const OosiV3Weights *w;
 
     // Scratch buffers (all caller-allocated)
@@ -63,6 +77,9 @@ typedef struct {
 
     // Precomputed -exp(A_log) for all layers (optional, NULL = compute on-the-fly)
     ssm_f32 *neg_exp_A;    // [n_layer * d_inner * d_state]
+
+    // Layer executor (NULL = every kernel on the caller, set by init)
+    const OosiV3Exec *exec;
 } OosiV3GenCtx;
 
 // ============================================================
@@ -111,8 +128,25 @@ float oosi_v3_halt_forward(OosiV3HaltHead *head, const ssm_f32 *hidden,
                            ssm_f32 *h1, ssm_f32 *h2, ssm_f32 *buf,
                            int d_model);
 
+// Advance the recurrent state by one token and return the final-normed
+// hidden state [d_model] (points into ctx->scratch, valid until the next
+// forward call). No LM head, sampling or halting — used for embeddings.
+const ssm_f32 *oosi_v3_forward_hidden(OosiV3GenCtx *ctx, int token_id);
+
 OosiV3HaltResult oosi_v3_forward_one(OosiV3GenCtx *ctx, int token_id);
 
+// Range kernels of one Mamba layer step, in order: in_proj + conv1d + SiLU
+// over d_inner channels, x_proj over dt_rank + 2*d_state rows, dt_proj +
+// selective scan + gate over d_inner channels, out_proj + residual over
+// d_model rows; then the LM head over vocab_size rows. Any partition of a
+// range is bit-identical to the whole range. forward_hidden runs them
+// through ctx->exec.
+void oosi_v3_mix_in(OosiV3GenCtx *ctx, int l, int lo, int hi);
+void oosi_v3_mix_xproj(OosiV3GenCtx *ctx, int l, int lo, int hi);
+void oosi_v3_mix_scan(OosiV3GenCtx *ctx, int l, int lo, int hi);
+void oosi_v3_mix_out(OosiV3GenCtx *ctx, int l, int lo, int hi);
+void oosi_v3_mix_lm_head(OosiV3GenCtx *ctx, int l, int lo, int hi);
+
 int oosi_v3_generate(
     OosiV3GenCtx   *ctx,
     const int      *prompt_tokens,
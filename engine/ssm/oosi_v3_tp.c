@@ -0,0 +1,90 @@
+// oosi_v3_tp.c — Tensor-parallel OOSI v3 decode on the AP work queue
+//
+// See oosi_v3_tp.h. Only oo_mc_submit / oo_mc_run_one are used, so the same
+// file runs on APs in the UEFI build and on pthreads in the host harness
+// (tests/test_oosi_v3_tp.c).
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "oosi_v3_tp.h"
+
+void oosi_v3_tp_slice(int n, int n_slices, int idx, int *lo, int *hi) {
+    const int64_t nn = n, ns = n_slices;
+    int64_t a = nn * idx / ns, b = nn * (idx + 1) / ns;
+    if (nn >= ns * OOSI_V3_TP_ALIGN) {
+        a &= ~(int64_t)(OOSI_V3_TP_ALIGN - 1);
+        b &= ~(int64_t)(OOSI_V3_TP_ALIGN - 1);
+    }
+    if (idx == n_slices - 1) b = nn;
+    *lo = (int)a;
+    *hi = (int)b;
+}
+
+static void tp_run_slice(OosiV3Tp *tp, int idx, int core) {
+    OosiV3TpJob *j = &tp->job[idx];
+    if (j->last_core >= 0 && j->last_core != core) j->moves++;
+    j->last_core = core;
+    int lo, hi;
+    oosi_v3_tp_slice(tp->n, tp->n_slices, idx, &lo, &hi);
+    if (lo < hi) tp->fn(tp->ctx, tp->layer, lo, hi);
+}
+
+static void tp_job(void *arg, int core) {
+    OosiV3TpJob *j = (OosiV3TpJob *)arg;
+    OosiV3Tp *tp = j->tp;
+    tp_run_slice(tp, j->idx, core);
+    oo_mc_barrier();
+    oo_mc_xadd32(&tp->pending, (uint32_t)-1);
+}
+
+static void tp_run(void *self, OosiV3GenCtx *ctx, OosiV3RangeFn fn, int l, int n) {
+    OosiV3Tp *tp = (OosiV3Tp *)self;
+    if (!tp->mc || tp->mc->mc_worker_count == 0 || tp->n_slices < 2) {
+        fn(ctx, l, 0, n);
+        return;
+    }
+    tp->ctx = ctx;
+    tp->fn = fn;
+    tp->layer = l;
+    tp->n = n;
+    tp->pending = (uint32_t)(tp->n_slices - 1);
+    oo_mc_barrier();
+    for (int i = 1; i < tp->n_slices; i++) oo_mc_submit(tp->mc, tp_job, &tp->job[i]);
+
+    tp_run_slice(tp, 0, tp->mc->bsp_idx);
+    uint64_t t0 = oo_mc_rdtsc();
+    while (tp->pending) {
+        if (!oo_mc_run_one(tp->mc, tp->mc->bsp_idx)) oo_mc_pause();
+    }
+    oo_mc_barrier();
+    tp->wait_cycles += oo_mc_rdtsc() - t0;
+    tp->phases++;
+}
+
+int oosi_v3_tp_init(OosiV3Tp *tp, OoMulticoreCtx *mc, int n_slices) {
+    if (!tp) return -1;
+    for (uint64_t i = 0; i < sizeof(*tp); i++) ((uint8_t *)tp)[i] = 0;
+    if (n_slices < 1) n_slices = 1;
+    if (n_slices > OOSI_V3_TP_MAX_SLICES) n_slices = OOSI_V3_TP_MAX_SLICES;
+    tp->exec.self = tp;
+    tp->exec.run = tp_run;
+    tp->mc = mc;
+    tp->n_slices = n_slices;
+    for (int i = 0; i < n_slices; i++) {
+        tp->job[i].tp = tp;
+        tp->job[i].idx = i;
+        tp->job[i].last_core = -1;
+    }
+    return 0;
+}
+
+void oosi_v3_tp_attach(OosiV3Tp *tp, OosiV3GenCtx *ctx) {
+    if (!ctx) return;
+    ctx->exec = tp ? &tp->exec : (const OosiV3Exec *)0;
+}
+
+uint32_t oosi_v3_tp_moves(const OosiV3Tp *tp) {
+    uint32_t m = 0;
+    for (int i = 0; tp && i < tp->n_slices; i++) m += tp->job[i].moves;
+    return m;
+}
@@ -0,0 +1,88 @@
+// oosi_v3_tp.h — Tensor-parallel OOSI v3 decode on the AP work queue
+//
+// A Mamba layer's d_inner channels are independent from in_proj through the
+// selective scan; only x_proj and out_proj mix them. oosi_v3_forward_hidden
+// runs each layer as range kernels (oosi_v3_infer.h), and this executor cuts
+// every range into n_slices pieces: slice 0 on the BSP, slices 1.. queued
+// with oo_mc_submit. One layer step is four phases, each ending in a
+// barrier (the BSP waits for the pending count, running queued slices
+// itself meanwhile):
+//
+//   in     in_proj rows + conv1d + SiLU of channels [lo, hi)
+//   xproj  x_proj rows (dt_rank + 2*d_state) over the gathered x_conv
+//   scan   dt_proj + softplus + selective scan + gate of channels [lo, hi)
+//   out    out_proj rows of d_model over the gathered y, + residual
+//
+// RMSNorm and the conv ring position stay on the BSP between phases. The
+// LM head is split by vocabulary rows the same way.
+//
+// State: h_state and conv_buf rows of channel i are only written by the
+// slice holding i. Submitting n_slices - 1 items to as many workers walks
+// the round-robin cursor through every worker once per phase, so slice k
+// lands on the same AP every phase and its conv/SSM rows stay in that
+// core's cache; a steal only moves work, never correctness.
+//
+// Output is bit-identical to serial decode for any slice count: every
+// element is computed by the same expression over the same inputs. Mixing
+// the channel dimension by row split over a gathered vector (rather than
+// partial sums reduced across slices) is what keeps the summation order.
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+#include "oosi_v3_infer.h"
+#include "../../oo-multicore/core/oo_multicore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OOSI_V3_TP_MAX_SLICES  OO_MAX_CORES
+#define OOSI_V3_TP_ALIGN       16      // slice bounds in floats (one cache line)
+
+struct OosiV3Tp;
+
+typedef struct {
+    struct OosiV3Tp *tp;
+    int              idx;
+    int              last_core;     // core that ran this slice last, -1 = none
+    uint32_t         moves;         // runs on another core than the previous one
+} OosiV3TpJob;
+
+typedef struct OosiV3Tp {
+    OosiV3Exec      exec;           // ctx->exec while attached
+    OoMulticoreCtx *mc;             // 0 = every slice on the caller
+    int             n_slices;
+    OosiV3TpJob     job[OOSI_V3_TP_MAX_SLICES];
+
+    // Phase in flight (written by the BSP before the slices are queued)
+    OosiV3GenCtx   *ctx;
+    OosiV3RangeFn   fn;
+    int             layer;
+    int             n;
+    volatile uint32_t pending;      // slices left in the phase
+
+    // stats (TSC cycles)
+    uint64_t        phases;         // dispatched phases (inline ones not counted)
+    uint64_t        wait_cycles;    // BSP: own slice done → phase done
+} OosiV3Tp;
+
+// n_slices is clamped to 1..OOSI_V3_TP_MAX_SLICES; mc may be 0. Returns 0
+// or <0.
+int  oosi_v3_tp_init(OosiV3Tp *tp, OoMulticoreCtx *mc, int n_slices);
+
+// Routes ctx's layer kernels through tp (NULL detaches: serial decode)
+void oosi_v3_tp_attach(OosiV3Tp *tp, OosiV3GenCtx *ctx);
+
+// Bounds of slice idx of [0, n): aligned to OOSI_V3_TP_ALIGN when every
+// slice still gets a full line, possibly empty when n < n_slices
+void oosi_v3_tp_slice(int n, int n_slices, int idx, int *lo, int *hi);
+
+// Sum of the slices' moves: slice runs that changed core (steals)
+uint32_t oosi_v3_tp_moves(const OosiV3Tp *tp);
+
+#ifdef __cplusplus
+}
+#endif
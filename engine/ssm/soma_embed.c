@@ -0,0 +1,337 @@
+// soma_embed.c — SomaMind Phase H2: Embedding-based semantic recall
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "soma_embed.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ============================================================
+// Internal helpers
+// ============================================================
+
+static float soma_emb_rsqrt(float x) {
+    // 1/sqrt via bit trick + 3 Newton-Raphson steps (float-accurate)
+    union { float f; uint32_t u; } c;
+    c.f = x;
+    c.u = 0x5f3759dfu - (c.u >> 1);
+    float y = c.f;
+    for (int i = 0; i < 3; i++) y = y * (1.5f - 0.5f * x * y * y);
+    return y;
+}
+
+static uint32_t soma_emb_mix(uint32_t x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static uintptr_t soma_emb_align(uintptr_t p, uintptr_t a) {
+    return (p + a - 1u) & ~(a - 1u);
+}
+
+int32_t soma_emb_dot(const int8_t *a, const int8_t *b) {
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < SOMA_EMB_DIM; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        // Sign-extend int8 → int16, then multiply-add pairs into int32
+        __m128i sa = _mm_cmpgt_epi8(zero, va);
+        __m128i sb = _mm_cmpgt_epi8(zero, vb);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(va, sa),
+                                                _mm_unpacklo_epi8(vb, sb)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(va, sa),
+                                                _mm_unpackhi_epi8(vb, sb)));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+    return _mm_cvtsi128_si32(acc);
+#else
+    int32_t s = 0;
+    for (int i = 0; i < SOMA_EMB_DIM; i++) s += (int32_t)a[i] * (int32_t)b[i];
+    return s;
+#endif
+}
+
+static int soma_emb_nearest_list(const SomaEmbIndex *idx, const int8_t *v) {
+    int best = 0;
+    int32_t best_s = -0x7FFFFFFF;
+    for (uint32_t c = 0; c < idx->nlist; c++) {
+        int32_t s = soma_emb_dot(v, idx->centroids + (uint64_t)c * SOMA_EMB_DIM);
+        if (s > best_s) { best_s = s; best = (int)c; }
+    }
+    return best;
+}
+
+// Insert into a best-first top-k array. Returns new count.
+static int soma_emb_topk_push(SomaEmbHit *hits, int n, int k, uint32_t id, int32_t score) {
+    if (n == k && score <= hits[n - 1].score) return n;
+    int i = (n < k) ? n++ : n - 1;
+    while (i > 0 && hits[i - 1].score < score) { hits[i] = hits[i - 1]; i--; }
+    hits[i].id = id;
+    hits[i].score = score;
+    return n;
+}
+
+static void soma_emb_link(SomaEmbIndex *idx, uint32_t e, int list) {
+    idx->next[e] = idx->list_head[list];
+    idx->list_head[list] = (int32_t)e;
+    idx->list_len[list]++;
+}
+
+// Centre a raw vector on the index mean: the frozen mean, else the running
+// mean of the entries so far (from 2 on: one entry has no common part).
+static void soma_emb_center(const SomaEmbIndex *idx, const int8_t *raw, int8_t *out) {
+    if (!idx->center_ready && idx->n < 2u) {
+        for (int d = 0; d < SOMA_EMB_DIM; d++) out[d] = raw[d];
+        return;
+    }
+    float inv = idx->center_ready ? 1.0f : 1.0f / (float)idx->n;
+    float x[SOMA_EMB_DIM];
+    for (int d = 0; d < SOMA_EMB_DIM; d++) x[d] = (float)raw[d] - idx->center[d] * inv;
+    soma_emb_quantize(x, out);
+}
+
+// ============================================================
+// Index
+// ============================================================
+
+uint64_t soma_emb_index_bytes(uint32_t cap) {
+    uint64_t b = 64;   // alignment slack
+    b += (uint64_t)cap * SOMA_EMB_DIM;                          // vecs
+    b += (uint64_t)cap * 4u * 2u;                               // ids + next
+    b += (uint64_t)SOMA_EMB_NLIST_MAX * SOMA_EMB_DIM;           // centroids
+    b += (uint64_t)SOMA_EMB_NLIST_MAX * SOMA_EMB_DIM * 4u;      // cent_acc
+    b += (uint64_t)SOMA_EMB_NLIST_MAX * 4u * 2u;                // list_head + list_len
+    return b + 64;
+}
+
+uint32_t soma_emb_index_init(SomaEmbIndex *idx, void *mem, uint64_t mem_bytes) {
+    if (!idx || !mem) return 0;
+    unsigned char *z = (unsigned char *)idx;
+    for (uint64_t i = 0; i < sizeof(*idx); i++) z[i] = 0;
+
+    // Largest capacity that fits
+    uint64_t fixed = soma_emb_index_bytes(0);
+    if (mem_bytes <= fixed) return 0;
+    uint64_t per = SOMA_EMB_DIM + 8u;
+    uint64_t cap = (mem_bytes - fixed) / per;
+    if (cap > 0x0FFFFFFFu) cap = 0x0FFFFFFFu;
+    cap &= ~(uint64_t)15u;   // keep the int8 block 16-byte sized
+    if (cap == 0) return 0;
+
+    uintptr_t p = soma_emb_align((uintptr_t)mem, 64);
+    idx->vecs      = (int8_t *)p;    p += cap * SOMA_EMB_DIM;
+    idx->centroids = (int8_t *)p;    p += (uint64_t)SOMA_EMB_NLIST_MAX * SOMA_EMB_DIM;
+    p = soma_emb_align(p, 16);
+    idx->cent_acc  = (float *)p;     p += (uint64_t)SOMA_EMB_NLIST_MAX * SOMA_EMB_DIM * 4u;
+    idx->ids       = (uint32_t *)p;  p += cap * 4u;
+    idx->next      = (int32_t *)p;   p += cap * 4u;
+    idx->list_head = (int32_t *)p;   p += (uint64_t)SOMA_EMB_NLIST_MAX * 4u;
+    idx->list_len  = (uint32_t *)p;
+    idx->cap = (uint32_t)cap;
+    return idx->cap;
+}
+
+void soma_emb_index_train(SomaEmbIndex *idx) {
+    if (!idx || idx->n == 0) return;
+    uint32_t n = idx->n;
+
+    // nlist ≈ √n, clamped
+    uint32_t nl = SOMA_EMB_NLIST_MIN;
+    while (nl < SOMA_EMB_NLIST_MAX && nl * nl < n) nl++;
+    if (nl > n) nl = n;
+    idx->nlist = nl;
+
+    // Seed centroids with evenly strided entries (deterministic)
+    for (uint32_t c = 0; c < nl; c++) {
+        const int8_t *src = idx->vecs + (uint64_t)((uint64_t)c * n / nl) * SOMA_EMB_DIM;
+        int8_t *dst = idx->centroids + (uint64_t)c * SOMA_EMB_DIM;
+        for (int d = 0; d < SOMA_EMB_DIM; d++) dst[d] = src[d];
+    }
+
+    // Spherical k-means: assign by max dot, recompute + renormalise
+    for (int it = 0; it < SOMA_EMB_KMEANS_ITERS; it++) {
+        for (uint64_t i = 0; i < (uint64_t)nl * SOMA_EMB_DIM; i++) idx->cent_acc[i] = 0.0f;
+        for (uint32_t c = 0; c < nl; c++) idx->list_len[c] = 0;
+        for (uint32_t e = 0; e < n; e++) {
+            const int8_t *v = idx->vecs + (uint64_t)e * SOMA_EMB_DIM;
+            int c = soma_emb_nearest_list(idx, v);
+            float *acc = idx->cent_acc + (uint64_t)c * SOMA_EMB_DIM;
+            for (int d = 0; d < SOMA_EMB_DIM; d++) acc[d] += (float)v[d];
+            idx->list_len[c]++;
+        }
+        for (uint32_t c = 0; c < nl; c++) {
+            if (idx->list_len[c] == 0) continue;   // keep old centroid for empty cluster
+            soma_emb_quantize(idx->cent_acc + (uint64_t)c * SOMA_EMB_DIM,
+                              idx->centroids + (uint64_t)c * SOMA_EMB_DIM);
+        }
+    }
+
+    // Rebuild inverted lists against the final centroids
+    for (uint32_t c = 0; c < nl; c++) { idx->list_head[c] = -1; idx->list_len[c] = 0; }
+    for (uint32_t e = 0; e < n; e++)
+        soma_emb_link(idx, e, soma_emb_nearest_list(idx, idx->vecs + (uint64_t)e * SOMA_EMB_DIM));
+
+    idx->ivf_ready = 1;
+    idx->trained_n = n;
+    idx->retrain_due = 0;
+    idx->retrains++;
+}
+
+int soma_emb_index_add(SomaEmbIndex *idx, const int8_t *vec, uint32_t id) {
+    if (!idx || !vec || idx->n >= idx->cap) return -1;
+    uint32_t e = idx->n++;
+    int8_t *dst = idx->vecs + (uint64_t)e * SOMA_EMB_DIM;
+    for (int d = 0; d < SOMA_EMB_DIM; d++) dst[d] = vec[d];
+    idx->ids[e] = id;
+    idx->next[e] = -1;
+
+    if (idx->center_ready) {
+        soma_emb_center(idx, dst, dst);
+    } else {
+        // Warm-up: the held entries stay raw until the mean is frozen
+        for (int d = 0; d < SOMA_EMB_DIM; d++) idx->center[d] += (float)vec[d];
+        if (idx->n == SOMA_EMB_CENTER_WARMUP) {
+            for (int d = 0; d < SOMA_EMB_DIM; d++) idx->center[d] /= (float)idx->n;
+            idx->center_ready = 1;
+            for (uint32_t i = 0; i < idx->n; i++) {
+                int8_t *v = idx->vecs + (uint64_t)i * SOMA_EMB_DIM;
+                soma_emb_center(idx, v, v);
+            }
+        }
+    }
+
+    // A full k-means pass is too slow for the store path: flag it only
+    if (idx->ivf_ready) {
+        soma_emb_link(idx, e, soma_emb_nearest_list(idx, dst));
+        if (idx->n >= 2u * idx->trained_n) idx->retrain_due = 1;
+    } else if (idx->n > SOMA_EMB_FLAT_MAX) {
+        idx->retrain_due = 1;
+    }
+    return 0;
+}
+
+int soma_emb_index_maintain(SomaEmbIndex *idx) {
+    if (!idx || !idx->retrain_due) return 0;
+    soma_emb_index_train(idx);
+    return 1;
+}
+
+int soma_emb_index_search_exact(const SomaEmbIndex *idx, const int8_t *query,
+                                int k, SomaEmbHit *out) {
+    if (!idx || !query || !out || k <= 0) return 0;
+    if (k > SOMA_EMB_TOPK_MAX) k = SOMA_EMB_TOPK_MAX;
+    int8_t qc[SOMA_EMB_DIM], ec[SOMA_EMB_DIM];
+    soma_emb_center(idx, query, qc);
+    int nh = 0;
+    for (uint32_t e = 0; e < idx->n; e++) {
+        const int8_t *v = idx->vecs + (uint64_t)e * SOMA_EMB_DIM;
+        // Warm-up entries are raw: centre them on the running mean
+        if (!idx->center_ready) { soma_emb_center(idx, v, ec); v = ec; }
+        nh = soma_emb_topk_push(out, nh, k, idx->ids[e], soma_emb_dot(qc, v));
+    }
+    return nh;
+}
+
+int soma_emb_index_search(SomaEmbIndex *idx, const int8_t *query, int k,
+                          uint32_t budget, SomaEmbHit *out) {
+    if (!idx || !query || !out || k <= 0 || idx->n == 0) return 0;
+    if (k > SOMA_EMB_TOPK_MAX) k = SOMA_EMB_TOPK_MAX;
+    if (budget == 0) budget = SOMA_EMB_SCAN_BUDGET;
+    idx->total_queries++;
+
+    if (!idx->ivf_ready) {
+        // Flat: SOMA_EMB_FLAT_MAX entries, plus any added before the
+        // first training runs
+        idx->total_scanned += idx->n;
+        return soma_emb_index_search_exact(idx, query, k, out);
+    }
+
+    // IVF entries are centred (the mean froze before the flat limit)
+    int8_t qc[SOMA_EMB_DIM];
+    soma_emb_center(idx, query, qc);
+
+    // Rank lists by centroid similarity (partial selection sort, nprobe ≤ nlist)
+    SomaEmbHit order[SOMA_EMB_NLIST_MAX];
+    for (uint32_t c = 0; c < idx->nlist; c++) {
+        order[c].id = c;
+        order[c].score = soma_emb_dot(qc, idx->centroids + (uint64_t)c * SOMA_EMB_DIM);
+    }
+
+    int nh = 0;
+    uint32_t scanned = 0;
+    for (uint32_t r = 0; r < idx->nlist; r++) {
+        uint32_t best = r;
+        for (uint32_t c = r + 1; c < idx->nlist; c++)
+            if (order[c].score > order[best].score) best = c;
+        SomaEmbHit t = order[r]; order[r] = order[best]; order[best] = t;
+
+        uint32_t list = order[r].id;
+        // Always finish the closest list; later lists only while budget lasts
+        if (r > 0 && scanned + idx->list_len[list] > budget) break;
+        for (int32_t e = idx->list_head[list]; e >= 0; e = idx->next[e]) {
+            nh = soma_emb_topk_push(out, nh, k, idx->ids[e],
+                                    soma_emb_dot(qc, idx->vecs + (uint64_t)e * SOMA_EMB_DIM));
+            scanned++;
+        }
+    }
+    idx->total_scanned += scanned;
+    return nh;
+}
+
+// ============================================================
+// Pooling + quantisation
+// ============================================================
+
+void soma_emb_pool_reset(SomaEmbPool *p, int d_model) {
+    if (!p) return;
+    if (d_model > SOMA_EMB_MODEL_DIM_MAX) d_model = SOMA_EMB_MODEL_DIM_MAX;
+    for (int i = 0; i < d_model; i++) p->sum[i] = 0.0f;
+    p->d_model = d_model;
+    p->count = 0;
+}
+
+void soma_emb_pool_add(SomaEmbPool *p, const float *hidden, int d_model) {
+    if (!p || !hidden) return;
+    if (d_model > p->d_model) d_model = p->d_model;
+    for (int i = 0; i < d_model; i++) p->sum[i] += hidden[i];
+    p->count++;
+}
+
+void soma_emb_quantize(const float *v, int8_t *out) {
+    float ss = 0.0f;
+    for (int d = 0; d < SOMA_EMB_DIM; d++) ss += v[d] * v[d];
+    float inv = (ss > 1e-20f) ? soma_emb_rsqrt(ss) * 127.0f : 0.0f;
+    for (int d = 0; d < SOMA_EMB_DIM; d++) {
+        float q = v[d] * inv;
+        int qi = (int)(q + (q >= 0.0f ? 0.5f : -0.5f));
+        if (qi > 127) qi = 127;
+        if (qi < -127) qi = -127;
+        out[d] = (int8_t)qi;
+    }
+}
+
+int soma_emb_pool_finish(const SomaEmbPool *p, int8_t *out) {
+    if (!p || !out || p->count == 0) return -1;
+    float proj[SOMA_EMB_DIM];
+    for (int d = 0; d < SOMA_EMB_DIM; d++) proj[d] = 0.0f;
+
+    // 2-tap signed sketch: each model dim feeds two output lanes
+    float inv_n = 1.0f / (float)p->count;
+    for (int i = 0; i < p->d_model; i++) {
+        float x = p->sum[i] * inv_n;
+        uint32_t h = soma_emb_mix((uint32_t)i * 2654435761u + 1u);
+        proj[h % SOMA_EMB_DIM]         += (h & 0x80000000u) ? -x : x;
+        proj[(h >> 8) % SOMA_EMB_DIM]  += (h & 0x40000000u) ? -x : x;
+    }
+
+    // Unit norm, so long and short texts weigh the same in the index mean
+    soma_emb_quantize(proj, out);
+    return 0;
+}
@@ -0,0 +1,147 @@
+// soma_embed.h — SomaMind Phase H2: Embedding-based semantic recall
+//
+// Gives soma_memory / SMB a recall path that finds paraphrased context
+// instead of relying on prompt hashes and prefixes.
+//
+// Embedding:
+//   - Mean-pool the model's own final hidden state (after final RMSNorm)
+//     over the prompt tokens (SomaEmbPool)
+//   - Project d_model → SOMA_EMB_DIM with a fixed 2-tap signed sketch
+//     (deterministic, no weights to load)
+//   - L2-normalise, quantise to int8 (×127)
+//   → cosine similarity = int8 dot / 127²
+//
+// Centring (hidden states share a large common component): the index
+// subtracts the mean of its stored vectors from entries and queries alike.
+// The mean follows the stores (never the queries) and is frozen after
+// SOMA_EMB_CENTER_WARMUP entries, when the held entries are re-centred in
+// place; callers store and search raw embeddings.
+//
+// Index (SomaEmbIndex, caller-provided memory):
+//   - Flat scan up to SOMA_EMB_FLAT_MAX entries
+//   - Beyond that, IVF: k-means centroids (nlist ≈ √n), one inverted list
+//     per centroid, nprobe lists scanned in centroid order until the scan
+//     budget runs out
+//   - Training falls due when n passes SOMA_EMB_FLAT_MAX and again whenever
+//     it doubles; adds never train. soma_emb_index_maintain() runs it (idle
+//     time); meanwhile new entries join their nearest list (or the flat scan)
+//   - SSE2 int8 dot product (scalar fallback)
+//   - Top-k with a per-query budget in vectors, so recall cost before a
+//     generation is bounded regardless of index size
+//
+// Entry ids are opaque u32 (REPL uses the NeuralFS log key sequence).
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================
+// Configuration
+// ============================================================
+#define SOMA_EMB_DIM            128    // embedding width (int8)
+#define SOMA_EMB_MODEL_DIM_MAX  8192   // largest d_model the pool accepts
+#define SOMA_EMB_FLAT_MAX       1024   // flat scan below this many entries
+#define SOMA_EMB_NLIST_MIN      16
+#define SOMA_EMB_NLIST_MAX      256
+#define SOMA_EMB_KMEANS_ITERS   6
+#define SOMA_EMB_TOPK_MAX       16
+#define SOMA_EMB_SCAN_BUDGET    4096   // default vectors scanned per query
+#define SOMA_EMB_ONE            (127 * 127)  // dot product of identical unit vectors
+#define SOMA_EMB_CENTER_WARMUP  64     // entries averaged into the centre (≤ FLAT_MAX)
+
+// ============================================================
+// Types
+// ============================================================
+
+// Running mean-pool of hidden states for one text.
+typedef struct {
+    float sum[SOMA_EMB_MODEL_DIM_MAX];
+    int   d_model;
+    int   count;
+} SomaEmbPool;
+
+typedef struct {
+    uint32_t id;
+    int32_t  score;      // int8 dot; divide by SOMA_EMB_ONE for cosine
+} SomaEmbHit;
+
+typedef struct {
+    // Storage (carved from caller memory)
+    int8_t   *vecs;          // [cap][SOMA_EMB_DIM]
+    uint32_t *ids;           // [cap]
+    int32_t  *next;          // [cap] inverted-list chain (-1 = end)
+    int8_t   *centroids;     // [SOMA_EMB_NLIST_MAX][SOMA_EMB_DIM]
+    float    *cent_acc;      // [SOMA_EMB_NLIST_MAX][SOMA_EMB_DIM] k-means scratch
+    int32_t  *list_head;     // [SOMA_EMB_NLIST_MAX]
+    uint32_t *list_len;      // [SOMA_EMB_NLIST_MAX]
+    uint32_t  cap;
+    uint32_t  n;
+
+    // IVF state
+    int       ivf_ready;
+    uint32_t  nlist;
+    uint32_t  trained_n;     // n at the last k-means run
+    int       retrain_due;   // set by add, cleared by train
+
+    // Centring: sum of the stored raw vectors, then their frozen mean
+    float     center[SOMA_EMB_DIM];
+    int       center_ready;
+
+    // Stats
+    uint32_t  total_queries;
+    uint32_t  total_scanned;
+    uint32_t  retrains;
+} SomaEmbIndex;
+
+// ============================================================
+// API
+// ============================================================
+
+// Bytes of caller memory needed for an index of `cap` entries.
+uint64_t soma_emb_index_bytes(uint32_t cap);
+
+// Bind memory (from soma_emb_index_bytes) and reset. Returns capacity or 0.
+uint32_t soma_emb_index_init(SomaEmbIndex *idx, void *mem, uint64_t mem_bytes);
+
+// Add one raw normalised int8 vector (centred by the index). Returns 0, or
+// -1 when full.
+int soma_emb_index_add(SomaEmbIndex *idx, const int8_t *vec, uint32_t id);
+
+// Top-k search for a raw query. budget = max vectors scanned
+// (0 = SOMA_EMB_SCAN_BUDGET). Returns hit count (≤ k), best first.
+int soma_emb_index_search(SomaEmbIndex *idx, const int8_t *query, int k,
+                          uint32_t budget, SomaEmbHit *out);
+
+// Exact (flat) top-k over every entry — reference for tests.
+int soma_emb_index_search_exact(const SomaEmbIndex *idx, const int8_t *query,
+                                int k, SomaEmbHit *out);
+
+// Force an IVF (re)build over the current entries.
+void soma_emb_index_train(SomaEmbIndex *idx);
+
+// Run a training that fell due. Returns 1 if it trained, else 0.
+int soma_emb_index_maintain(SomaEmbIndex *idx);
+
+// Pooling
+void soma_emb_pool_reset(SomaEmbPool *p, int d_model);
+void soma_emb_pool_add(SomaEmbPool *p, const float *hidden, int d_model);
+
+// Finish a pool into a raw normalised int8 embedding. Returns 0, or -1 if
+// the pool is empty.
+int soma_emb_pool_finish(const SomaEmbPool *p, int8_t *out);
+
+// Normalise + quantise an arbitrary float vector.
+void soma_emb_quantize(const float *v, int8_t *out);
+
+// int8 dot product over SOMA_EMB_DIM lanes.
+int32_t soma_emb_dot(const int8_t *a, const int8_t *b);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,355 @@
+// soma_jlog.c — Segmented append-only log behind the Soma session journal
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "soma_jlog.h"
+#include "oo_crc32c.h"
+
+// ─── Helpers ────────────────────────────────────────────────────────────────
+
+static void sjl_memset(void *dst, int val, uint32_t n) {
+    unsigned char *p = (unsigned char *)dst;
+    for (uint32_t i = 0; i < n; i++) p[i] = (unsigned char)val;
+}
+
+static void sjl_memcpy(void *dst, const void *src, uint32_t n) {
+    unsigned char *d = (unsigned char *)dst;
+    const unsigned char *s = (const unsigned char *)src;
+    for (uint32_t i = 0; i < n; i++) d[i] = s[i];
+}
+
+static uint32_t sjl_rec_crc(const SjlRecHdr *h, const void *payload) {
+    SjlRecHdr tmp = *h;
+    tmp.crc = 0;
+    uint32_t crc = oo_crc32c_update(0u, &tmp, (unsigned int)sizeof(tmp));
+    return oo_crc32c_update(crc, payload, h->len);
+}
+
+// ─── Framing ────────────────────────────────────────────────────────────────
+
+uint32_t sjl_encode(void *dst, uint32_t cap, uint8_t type, uint32_t seq,
+                    const void *payload, uint32_t len) {
+    uint32_t size = sjl_rec_size(len);
+    if (!dst || size > cap || size < len) return 0;
+
+    unsigned char *p = (unsigned char *)dst;
+    SjlRecHdr h;
+    h.magic = SJL_REC_MAGIC;
+    h.type  = type;
+    h.flags = 0;
+    h.len   = len;
+    h.seq   = seq;
+    h.crc   = sjl_rec_crc(&h, payload);
+    sjl_memcpy(p, &h, (uint32_t)sizeof(h));
+    sjl_memcpy(p + sizeof(h), payload, len);
+    sjl_memset(p + sizeof(h) + len, 0, size - (uint32_t)sizeof(h) - len);
+    return size;
+}
+
+uint32_t sjl_decode(const unsigned char *buf, uint32_t len, uint32_t off,
+                    const SjlRecHdr **hdr, const unsigned char **payload) {
+    if (off > len || len - off < sizeof(SjlRecHdr)) return 0;
+    const SjlRecHdr *h = (const SjlRecHdr *)(buf + off);
+    if (h->magic != SJL_REC_MAGIC || h->flags != 0) return 0;
+    if (h->len > SJL_BATCH_BYTES) return 0;
+    uint32_t size = sjl_rec_size(h->len);
+    if (size > len - off) return 0;
+    if (sjl_rec_crc(h, buf + off + sizeof(SjlRecHdr)) != h->crc) return 0;
+    if (hdr)     *hdr = h;
+    if (payload) *payload = buf + off + sizeof(SjlRecHdr);
+    return size;
+}
+
+// ─── Segment scan (shared by replay and compaction) ─────────────────────────
+
+typedef void (*SjlRecFn)(void *ctx, const SjlRecHdr *h, const unsigned char *payload);
+
+static int sjl_turn_valid(const SjlRecHdr *h, const unsigned char *payload) {
+    if (h->len < sizeof(SjlTurnHdr)) return 0;
+    const SjlTurnHdr *t = (const SjlTurnHdr *)payload;
+    return h->len == (uint32_t)sizeof(SjlTurnHdr) + t->prompt_len + t->response_len;
+}
+
+// Walk one segment image. The first record must be SEG naming this segment
+// with a first_seq past *seq (a gap means records were lost, not reordered);
+// every later record must carry the next sequence number. Returns the length
+// of the valid prefix and leaves *seq at the last valid record.
+static uint32_t sjl_scan_seg(const unsigned char *buf, uint32_t n, uint32_t seg,
+                             uint32_t *seq, SjlRecFn fn, void *ctx) {
+    const SjlRecHdr *h;
+    const unsigned char *p;
+    uint32_t off = sjl_decode(buf, n, 0, &h, &p);
+    if (!off || h->type != SJL_REC_SEG || h->len != sizeof(SjlSegInfo)) return 0;
+    const SjlSegInfo *info = (const SjlSegInfo *)p;
+    if (info->seg != seg || info->first_seq <= *seq) return 0;
+    *seq = info->first_seq - 1u;
+
+    for (;;) {
+        uint32_t size = sjl_decode(buf, n, off, &h, &p);
+        if (!size || h->type == SJL_REC_SEG || h->seq != *seq + 1u) break;
+        if (h->type == SJL_REC_TURN && !sjl_turn_valid(h, p)) break;
+        if (fn) fn(ctx, h, p);
+        *seq = h->seq;
+        off += size;
+    }
+    return off;
+}
+
+// ─── Summary ────────────────────────────────────────────────────────────────
+
+static void sjl_summary_session(SjlSummary *s, uint32_t session) {
+    if (!session) return;
+    if (!s->boot_first || session < s->boot_first) s->boot_first = session;
+    if (session > s->boot_last) s->boot_last = session;
+}
+
+void sjl_summary_add_turn(SjlSummary *s, const SjlTurnHdr *t, const char *prompt) {
+    s->turns++;
+    s->domain[t->domain % SJL_DOMAINS]++;
+    sjl_summary_session(s, t->session);
+
+    // Space-saving top-k: hit → count++, miss → evict the smallest counter
+    SjlHot *slot = 0;
+    for (int i = 0; i < SJL_HOT; i++) {
+        SjlHot *h = &s->hot[i];
+        if (h->count && h->hash == t->prompt_hash) { h->count++; return; }
+        if (!slot || h->count < slot->count) slot = h;
+    }
+    slot->err   = slot->count;
+    slot->count = slot->count + 1u;
+    slot->hash  = t->prompt_hash;
+    uint32_t n = t->prompt_len;
+    if (n > SJL_HOT_TEXT - 1) n = SJL_HOT_TEXT - 1;
+    sjl_memcpy(slot->prompt, prompt, n);
+    sjl_memset(slot->prompt + n, 0, SJL_HOT_TEXT - n);
+}
+
+static int sjl_read_summary(SjlLog *l, uint32_t file, SjlSummary *out) {
+    int32_t n = l->io.read(l->io.ctx, file, l->scratch, sjl_rec_size(sizeof(SjlSummary)));
+    if (n <= 0) return 0;
+    const SjlRecHdr *h;
+    const unsigned char *p;
+    if (!sjl_decode(l->scratch, (uint32_t)n, 0, &h, &p)) return 0;
+    if (h->type != SJL_REC_SUMMARY || h->len != sizeof(SjlSummary)) return 0;
+    sjl_memcpy(out, p, (uint32_t)sizeof(SjlSummary));
+    return out->gen == h->seq;
+}
+
+// ─── Replay ─────────────────────────────────────────────────────────────────
+
+typedef struct {
+    SjlLog   *l;
+    SjlTurnFn on_turn;
+    void     *cb_ctx;
+} SjlReplayCtx;
+
+static void sjl_replay_rec(void *ctx, const SjlRecHdr *h, const unsigned char *p) {
+    SjlReplayCtx *rc = (SjlReplayCtx *)ctx;
+    if (h->type == SJL_REC_BOOT && h->len == 4u) {
+        uint32_t b = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        if (b > rc->l->boot_count) rc->l->boot_count = b;
+    } else if (h->type == SJL_REC_TURN) {
+        const SjlTurnHdr *t = (const SjlTurnHdr *)p;
+        const char *prompt = (const char *)(p + sizeof(SjlTurnHdr));
+        rc->l->turns_raw++;
+        if (t->session > rc->l->boot_count) rc->l->boot_count = t->session;
+        if (rc->on_turn) rc->on_turn(rc->cb_ctx, t, prompt, prompt + t->prompt_len);
+    }
+}
+
+int sjl_open(SjlLog *l, const SjlIo *io, void *scratch, uint32_t scratch_cap,
+             SjlTurnFn on_turn, void *cb_ctx) {
+    if (!l || !io || !io->read || !io->write || !io->remove) return SJL_ERR_ARG;
+    if (!scratch || scratch_cap < SJL_SEG_BYTES) return SJL_ERR_ARG;
+
+    sjl_memset(l, 0, (uint32_t)sizeof(*l));
+    l->io      = *io;
+    l->scratch = (unsigned char *)scratch;
+
+    // Newest valid summary slot wins; a torn rewrite falls back to the other
+    SjlSummary a, b;
+    int ok_a = sjl_read_summary(l, SJL_FILE_SUM_A, &a);
+    int ok_b = sjl_read_summary(l, SJL_FILE_SUM_B, &b);
+    if (ok_a && (!ok_b || a.gen > b.gen)) l->sum = a;
+    else if (ok_b)                         l->sum = b;
+    l->seq        = l->sum.seq_last;
+    l->boot_count = l->sum.boot_last;
+
+    // Compaction may have died between writing the summary and deleting
+    // the segment it folded in.
+    if (l->sum.seg_next) l->io.remove(l->io.ctx, l->sum.seg_next - 1u);
+
+    SjlReplayCtx rc = { l, on_turn, cb_ctx };
+    uint32_t seg = l->sum.seg_next;
+    int have_last = 0, last_clean = 0;
+    uint32_t last_valid = 0;
+    for (; seg <= SJL_SEG_MAX; seg++) {
+        int32_t n = l->io.read(l->io.ctx, seg, l->scratch, SJL_SEG_BYTES);
+        if (n < 0) break;
+        uint32_t valid = sjl_scan_seg(l->scratch, (uint32_t)n, seg, &l->seq,
+                                      sjl_replay_rec, &rc);
+        l->bytes_raw += valid;
+        last_clean = (valid == (uint32_t)n && valid > 0);
+        if (!last_clean) l->torn++;
+        last_valid = valid;
+        have_last  = 1;
+    }
+
+    l->seg_first = l->sum.seg_next;
+    if (!have_last) {
+        l->seg_tail = seg;
+        l->tail_len = 0;
+    } else if (last_clean && last_valid + SJL_SEG_HDR_BYTES < SJL_SEG_BYTES) {
+        l->seg_tail = seg - 1u;
+        l->tail_len = last_valid;
+    } else {
+        // Full, or torn: never append behind garbage — open a new segment
+        l->seg_tail = seg;
+        l->tail_len = 0;
+    }
+    return SJL_OK;
+}
+
+// ─── Append / flush ─────────────────────────────────────────────────────────
+
+int sjl_flush(SjlLog *l) {
+    if (!l) return SJL_ERR_ARG;
+    if (!l->batch_len) return 0;
+
+    if (l->tail_len && l->tail_len + l->batch_len > SJL_SEG_BYTES) {
+        l->seg_tail++;          // seal the current segment
+        l->tail_len = 0;
+    }
+
+    unsigned char *start = l->batch + SJL_SEG_HDR_BYTES;
+    uint32_t n = l->batch_len;
+    if (!l->tail_len) {
+        if (l->seg_tail > SJL_SEG_MAX) return SJL_ERR_FULL;
+        SjlSegInfo info;
+        info.seg       = l->seg_tail;
+        info.first_seq = l->seq - l->batch_recs + 1u;
+        sjl_encode(l->batch, SJL_SEG_HDR_BYTES, SJL_REC_SEG, 0u, &info, (uint32_t)sizeof(info));
+        start = l->batch;
+        n += SJL_SEG_HDR_BYTES;
+        // A leftover file with this id would leave stale bytes past our end
+        l->io.remove(l->io.ctx, l->seg_tail);
+    }
+
+    if (l->io.write(l->io.ctx, l->seg_tail, l->tail_len, start, n) != 0)
+        return SJL_ERR_IO;      // batch kept; the next flush rewrites the same bytes
+
+    int recs = (int)l->batch_recs;
+    l->tail_len  += n;
+    l->bytes_raw += n;
+    l->batch_len = l->batch_recs = l->batch_turns = 0;
+    l->flushes++;
+    return recs;
+}
+
+int sjl_append(SjlLog *l, uint8_t type, const void *payload, uint32_t len) {
+    if (!l || (!payload && len)) return SJL_ERR_ARG;
+    uint32_t size = sjl_rec_size(len);
+    if (size > SJL_BATCH_BYTES) return SJL_ERR_ARG;
+    if (l->batch_len + size > SJL_BATCH_BYTES) {
+        int rc = sjl_flush(l);
+        if (rc < 0) return rc;
+    }
+    sjl_encode(l->batch + SJL_SEG_HDR_BYTES + l->batch_len, size, type,
+               l->seq + 1u, payload, len);
+    l->seq++;
+    l->batch_len += size;
+    l->batch_recs++;
+    return SJL_OK;
+}
+
+int sjl_append_boot(SjlLog *l, uint32_t boot_count) {
+    unsigned char p[4];
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(boot_count >> (8 * i));
+    int rc = sjl_append(l, SJL_REC_BOOT, p, 4u);
+    if (rc == SJL_OK && boot_count > l->boot_count) l->boot_count = boot_count;
+    return rc;
+}
+
+int sjl_append_turn(SjlLog *l, const SjlTurnHdr *t,
+                    const char *prompt, const char *response) {
+    if (!l || !t) return SJL_ERR_ARG;
+    unsigned char p[sizeof(SjlTurnHdr) + 2u * SJL_TEXT_MAX];
+    SjlTurnHdr h = *t;
+    h.reserved = 0;
+    if (!prompt)   h.prompt_len = 0;
+    if (!response) h.response_len = 0;
+    sjl_memcpy(p, &h, (uint32_t)sizeof(h));
+    sjl_memcpy(p + sizeof(h), prompt, h.prompt_len);
+    sjl_memcpy(p + sizeof(h) + h.prompt_len, response, h.response_len);
+    int rc = sjl_append(l, SJL_REC_TURN, p,
+                        (uint32_t)sizeof(h) + h.prompt_len + h.response_len);
+    if (rc == SJL_OK) {
+        l->turns_raw++;
+        l->batch_turns++;
+    }
+    return rc;
+}
+
+// ─── Compaction ─────────────────────────────────────────────────────────────
+
+typedef struct {
+    SjlSummary *s;
+    uint32_t    turns;
+} SjlFoldCtx;
+
+static void sjl_fold_rec(void *ctx, const SjlRecHdr *h, const unsigned char *p) {
+    SjlFoldCtx *fc = (SjlFoldCtx *)ctx;
+    if (h->type == SJL_REC_BOOT && h->len == 4u) {
+        uint32_t b = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        sjl_summary_session(fc->s, b);
+    } else if (h->type == SJL_REC_TURN) {
+        sjl_summary_add_turn(fc->s, (const SjlTurnHdr *)p, (const char *)(p + sizeof(SjlTurnHdr)));
+        fc->turns++;
+    }
+}
+
+int sjl_compact_step(SjlLog *l, uint32_t keep_segs) {
+    if (!l) return SJL_ERR_ARG;
+    if (l->seg_tail - l->seg_first <= keep_segs) return 0;
+
+    uint32_t seg = l->seg_first;
+    SjlSummary next = l->sum;
+    SjlFoldCtx fc = { &next, 0 };
+    uint32_t valid = 0;
+    int32_t n = l->io.read(l->io.ctx, seg, l->scratch, SJL_SEG_BYTES);
+    if (n > 0)
+        valid = sjl_scan_seg(l->scratch, (uint32_t)n, seg, &next.seq_last, sjl_fold_rec, &fc);
+    next.seg_next = seg + 1u;
+    next.gen++;
+
+    uint32_t slot = (next.gen & 1u) ? SJL_FILE_SUM_B : SJL_FILE_SUM_A;
+    uint32_t size = sjl_encode(l->scratch, SJL_SEG_BYTES, SJL_REC_SUMMARY, next.gen,
+                               &next, (uint32_t)sizeof(next));
+    l->io.remove(l->io.ctx, slot);
+    if (l->io.write(l->io.ctx, slot, 0u, l->scratch, size) != 0) return SJL_ERR_IO;
+
+    // Summary is durable: the raw segment can go
+    l->sum = next;
+    l->io.remove(l->io.ctx, seg);
+    l->seg_first++;
+    l->turns_raw -= (fc.turns < l->turns_raw) ? fc.turns : l->turns_raw;
+    l->bytes_raw -= (valid < l->bytes_raw) ? valid : l->bytes_raw;
+    l->compactions++;
+    return 1;
+}
+
+int sjl_clear(SjlLog *l) {
+    if (!l) return SJL_ERR_ARG;
+    // Newest first: a crash part-way leaves a shorter but intact log
+    for (uint32_t seg = l->seg_tail + 1u; seg-- > l->seg_first; )
+        l->io.remove(l->io.ctx, seg);
+    l->io.remove(l->io.ctx, SJL_FILE_SUM_A);
+    l->io.remove(l->io.ctx, SJL_FILE_SUM_B);
+
+    SjlIo io = l->io;
+    unsigned char *scratch = l->scratch;
+    sjl_memset(l, 0, (uint32_t)sizeof(*l));
+    l->io = io;
+    l->scratch = scratch;
+    return SJL_OK;
+}
@@ -0,0 +1,217 @@
+// soma_jlog.h — Segmented append-only log behind the Soma session journal
+//
+// Replaces the v1 soma_journal.bin (whole-file rewrite of the last 64 turns)
+// with an append-only record log split into fixed-size segment files:
+//
+//   segment N   [SEG][BOOT][TURN][TURN]...     ≤ SJL_SEG_BYTES, appended only
+//   summary A/B one SUMMARY record              ping-pong, newest gen wins
+//
+// Record framing (little-endian, records 4-byte aligned):
+//   [SjlRecHdr 16 bytes][payload len bytes][pad to 4]
+//   crc = CRC32C over header (crc field = 0) + payload
+//
+// Writes go to an in-memory batch and reach disk as one Write+Flush per
+// group (sjl_flush), so a turn costs a memcpy and every Nth turn one
+// sequential append — O(1) regardless of history length.
+//
+// Replay (sjl_open) walks the summary and every raw segment, stopping each
+// segment at its first bad magic/length/CRC/sequence (torn write). A torn
+// tail is never appended to again: the next flush rolls to a new segment,
+// so stale bytes after the valid prefix can never be read back as records.
+//
+// Compaction (sjl_compact_step) folds the oldest raw segment into the
+// cumulative summary (turn/session counts, domain histogram, most frequent
+// prompts), writes it to the idle summary slot, then deletes the segment.
+// One segment per call keeps the work bounded; the REPL calls it after each
+// group flush. A crash between the two steps leaves a segment the summary
+// already covers — replay skips and deletes it.
+//
+// File I/O is injected (SjlIo) so the same code runs on the EFI volume and
+// against the in-memory fault-injection harness in tests/.
+//
+// Freestanding C11 — no libc, no malloc. Scratch memory comes from the caller.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================
+// Constants
+// ============================================================
+
+#define SJL_REC_MAGIC       0x4A53u           // "SJ"
+#define SJL_ALIGN           4u
+
+#define SJL_SEG_BYTES       (64u * 1024u)     // segment file size limit
+#define SJL_BATCH_BYTES     4096u             // group-flush buffer
+#define SJL_SEG_MAX         0x00FFFFFFu       // segment ids fit 6 hex digits
+
+#define SJL_FILE_SUM_A      0xFFFFFFF0u       // summary slot, even generation
+#define SJL_FILE_SUM_B      0xFFFFFFF1u       // summary slot, odd generation
+
+#define SJL_REC_SEG         1   // first record of a segment: SjlSegInfo
+#define SJL_REC_BOOT        2   // session start: u32 boot_count
+#define SJL_REC_TURN        3   // SjlTurnHdr + prompt + response
+#define SJL_REC_SUMMARY     4   // SjlSummary
+
+#define SJL_TEXT_MAX        255 // prompt / response length fits a u8
+#define SJL_DOMAINS         8
+#define SJL_HOT             8   // most-frequent prompts kept in the summary
+#define SJL_HOT_TEXT        40
+
+// Status codes
+#define SJL_OK              0
+#define SJL_ERR_ARG        -1
+#define SJL_ERR_IO         -2
+#define SJL_ERR_FULL       -3   // segment id space exhausted
+
+// ============================================================
+// On-disk types
+// ============================================================
+
+typedef struct {
+    uint16_t magic;      // SJL_REC_MAGIC
+    uint8_t  type;       // SJL_REC_*
+    uint8_t  flags;      // reserved, 0
+    uint32_t len;        // payload bytes following the header
+    uint32_t seq;        // strictly increasing across the whole log (SEG: 0)
+    uint32_t crc;        // CRC32C of header(crc=0) + payload
+} SjlRecHdr;             // 16 bytes
+
+typedef struct {
+    uint32_t seg;        // must match the segment's file id
+    uint32_t first_seq;  // seq of the first record after this one
+} SjlSegInfo;
+
+typedef struct {
+    int32_t  turn;           // turn index within its session
+    uint32_t session;        // boot_count when recorded
+    uint32_t prompt_hash;    // djb2 (soma_memory)
+    uint8_t  domain;         // SomaDomain tag
+    uint8_t  prompt_len;     // bytes of prompt following this header
+    uint8_t  response_len;   // bytes of response following the prompt
+    uint8_t  reserved;
+} SjlTurnHdr;                // 16 bytes
+
+typedef struct {
+    uint32_t hash;
+    uint32_t count;          // space-saving estimate (upper bound)
+    uint32_t err;            // overestimate inherited on eviction
+    char     prompt[SJL_HOT_TEXT];
+} SjlHot;
+
+typedef struct {
+    uint32_t gen;            // bumped by every compaction (0 = none yet)
+    uint32_t seg_next;       // first raw segment not folded in
+    uint32_t seq_last;       // last record seq folded in
+    uint32_t turns;          // TURN records folded in
+    uint32_t boot_first;     // sessions covered
+    uint32_t boot_last;
+    uint32_t domain[SJL_DOMAINS];
+    SjlHot   hot[SJL_HOT];
+} SjlSummary;
+
+// ============================================================
+// I/O and state
+// ============================================================
+
+// file is a segment id (0..SJL_SEG_MAX) or SJL_FILE_SUM_A/B.
+typedef struct {
+    void *ctx;
+    // Read from offset 0, up to cap bytes. Bytes read, or -1 if absent.
+    int32_t (*read)(void *ctx, uint32_t file, void *buf, uint32_t cap);
+    // Write len bytes at pos (create if absent) and make them durable.
+    int     (*write)(void *ctx, uint32_t file, uint32_t pos, const void *buf, uint32_t len);
+    // Delete the file (absent is not an error).
+    int     (*remove)(void *ctx, uint32_t file);
+} SjlIo;
+
+// Called for every replayed TURN record (texts are not NUL-terminated).
+typedef void (*SjlTurnFn)(void *ctx, const SjlTurnHdr *t,
+                          const char *prompt, const char *response);
+
+#define SJL_SEG_HDR_BYTES   ((uint32_t)sizeof(SjlRecHdr) + (uint32_t)sizeof(SjlSegInfo))
+
+typedef struct {
+    SjlIo          io;
+    unsigned char *scratch;      // ≥ SJL_SEG_BYTES, replay + compaction reads
+
+    // Raw segments on disk: [seg_first, seg_tail]
+    uint32_t       seg_first;
+    uint32_t       seg_tail;     // segment receiving appends
+    uint32_t       tail_len;     // bytes of seg_tail on disk (0 = not created)
+    uint32_t       seq;          // last seq assigned
+
+    // Group-commit batch; the first SJL_SEG_HDR_BYTES are reserved so a
+    // flush that opens a new segment writes its SEG record in the same call.
+    unsigned char  batch[SJL_SEG_HDR_BYTES + SJL_BATCH_BYTES];
+    uint32_t       batch_len;    // bytes after the reserved prefix
+    uint32_t       batch_recs;
+    uint32_t       batch_turns;
+
+    // Everything already compacted away
+    SjlSummary     sum;
+
+    // Replay results
+    uint32_t       turns_raw;    // TURN records in raw segments (incl. batch)
+    uint32_t       boot_count;   // highest BOOT seen
+    uint32_t       torn;         // segments whose tail was dropped
+    uint32_t       bytes_raw;    // valid bytes in raw segments
+
+    // Stats
+    uint32_t       flushes;
+    uint32_t       compactions;
+} SjlLog;
+
+// ============================================================
+// API
+// ============================================================
+
+// Bind I/O and scratch, replay summary + segments, position the tail.
+// on_turn (optional) sees every surviving raw TURN in log order.
+int sjl_open(SjlLog *l, const SjlIo *io, void *scratch, uint32_t scratch_cap,
+             SjlTurnFn on_turn, void *cb_ctx);
+
+// Queue a record; flushes first if it would overflow the batch.
+int sjl_append(SjlLog *l, uint8_t type, const void *payload, uint32_t len);
+int sjl_append_boot(SjlLog *l, uint32_t boot_count);
+int sjl_append_turn(SjlLog *l, const SjlTurnHdr *t,
+                    const char *prompt, const char *response);
+
+// Write the batch to the tail segment (one write). Returns records written.
+int sjl_flush(SjlLog *l);
+
+// Fold the oldest raw segment into the summary if more than keep_segs
+// sealed segments exist. Returns 1 if a segment was compacted, 0 if not.
+int sjl_compact_step(SjlLog *l, uint32_t keep_segs);
+
+// Delete every file and start an empty log.
+int sjl_clear(SjlLog *l);
+
+// Cumulative turns (summary + raw + batched).
+static inline uint32_t sjl_total_turns(const SjlLog *l) {
+    return l->sum.turns + l->turns_raw;
+}
+
+// Framing primitives (exposed for tests and tools)
+static inline uint32_t sjl_rec_size(uint32_t len) {
+    uint32_t n = (uint32_t)sizeof(SjlRecHdr) + len;
+    return (n + SJL_ALIGN - 1u) & ~(SJL_ALIGN - 1u);
+}
+// Encode one record into dst. Returns bytes written or 0 if cap is short.
+uint32_t sjl_encode(void *dst, uint32_t cap, uint8_t type, uint32_t seq,
+                    const void *payload, uint32_t len);
+// Validate the record at buf[off..len). Returns its size or 0 if invalid.
+uint32_t sjl_decode(const unsigned char *buf, uint32_t len, uint32_t off,
+                    const SjlRecHdr **hdr, const unsigned char **payload);
+
+// Space-saving update of the summary with one turn (used by compaction).
+void sjl_summary_add_turn(SjlSummary *s, const SjlTurnHdr *t, const char *prompt);
+
+#ifdef __cplusplus
+}
+#endif
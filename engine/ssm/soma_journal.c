@@ -1,7 +1,9 @@
 // soma_journal.c — SomaMind Phase I: Persistent Session Journal
 //
-// EFI file I/O: reads/writes soma_journal.bin on the boot partition.
-// Uses the EFI SimpleFileSystem root handle (g_root) passed in by caller.
+// EFI glue for the segmented journal log (soma_jlog.c): segment files on the
+// boot partition, replay into soma_memory, one-time import of the v1
+// soma_journal.bin snapshot. Uses the EFI SimpleFileSystem root handle
+// (g_root) passed in by caller.
 //
 // Freestanding C11 — no libc. All loops/copies manual.
 
@@ -14,210 +16,272 @@ static void jrnl_memset(void *dst, int val, int n) {
     for (int i = 0; i < n; i++) p[i] = (unsigned char)val;
 }
 
-static void jrnl_memcpy(void *dst, const void *src, int n) {
-    unsigned char *d = (unsigned char *)dst;
-    const unsigned char *s = (const unsigned char *)src;
-    for (int i = 0; i < n; i++) d[i] = s[i];
-}
-
 static int jrnl_strnlen(const char *s, int max) {
     int n = 0;
     while (n < max && s[n]) n++;
     return n;
 }
 
-// Copy at most (dstlen-1) chars, always NUL-terminate
-static void jrnl_strlcpy(char *dst, const char *src, int dstlen) {
-    int i = 0;
-    while (i < dstlen - 1 && src[i]) { dst[i] = src[i]; i++; }
-    dst[i] = 0;
+// Copy exactly n chars (clamped to dstlen-1) and NUL-terminate
+static void jrnl_copy_text(char *dst, int dstlen, const char *src, int n) {
+    if (n > dstlen - 1) n = dstlen - 1;
+    for (int i = 0; i < n; i++) dst[i] = src[i];
+    dst[n] = 0;
 }
 
-// ─── soma_journal_save ──────────────────────────────────────────────────────
+// ─── EFI file I/O for the log ───────────────────────────────────────────────
 
-int soma_journal_save(const SomaMemCtx *mem, EFI_FILE_PROTOCOL *root,
-                      unsigned int total_turns_ever) {
-    if (!mem || !root) return -1;
+// Segments: "SJ" + 6 hex digits + ".LOG"; summary slots: "SJSUMA.LOG" / "SJSUMB.LOG"
+static void jrnl_file_name(CHAR16 *out, uint32_t file) {
+    static const char hex[] = "0123456789ABCDEF";
+    int i = 0;
+    out[i++] = 'S'; out[i++] = 'J';
+    if (file == SJL_FILE_SUM_A || file == SJL_FILE_SUM_B) {
+        out[i++] = 'S'; out[i++] = 'U'; out[i++] = 'M';
+        out[i++] = (file == SJL_FILE_SUM_A) ? 'A' : 'B';
+    } else {
+        for (int d = 5; d >= 0; d--) out[i++] = (CHAR16)hex[(file >> (4 * d)) & 0xFu];
+    }
+    out[i++] = '.'; out[i++] = 'L'; out[i++] = 'O'; out[i++] = 'G';
+    out[i] = 0;
+}
 
-    // Open (or create) soma_journal.bin for write
+static EFI_FILE_HANDLE jrnl_open(EFI_FILE_PROTOCOL *root, uint32_t file, UINT64 mode) {
+    CHAR16 name[16];
+    jrnl_file_name(name, file);
     EFI_FILE_HANDLE fh = NULL;
-    EFI_STATUS st = uefi_call_wrapper(root->Open, 5, root, &fh,
-                        (CHAR16 *)SOMA_JOURNAL_FILENAME,
-                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
-                        0ULL);
-    if (EFI_ERROR(st) || !fh) return -1;
-
-    // Collect valid entries from ring buffer (oldest-first order)
-    SomaJournalEntry disk_entries[SOMA_JOURNAL_MAX_ENTRIES];
-    jrnl_memset(disk_entries, 0, sizeof(disk_entries));
-    int n = 0;
-
-    // Ring buffer: head points to next-write slot.
-    // Oldest entry is at (head - count + MAX) % MAX, newest at (head-1+MAX)%MAX
-    int count = mem->count;
-    if (count > SOMA_MEM_MAX_ENTRIES) count = SOMA_MEM_MAX_ENTRIES;
-    int max_save = (count < SOMA_JOURNAL_MAX_ENTRIES) ? count : SOMA_JOURNAL_MAX_ENTRIES;
-
-    for (int i = 0; i < max_save; i++) {
-        // oldest first: index from tail
-        int idx = (mem->head - count + i + SOMA_MEM_MAX_ENTRIES * 64) % SOMA_MEM_MAX_ENTRIES;
-        const SomaMemEntry *e = &mem->entries[idx];
-        if (!e->valid) continue;
-
-        SomaJournalEntry *de = &disk_entries[n];
-        jrnl_strlcpy(de->prompt,   e->prompt,   SOMA_MEM_PROMPT_LEN);
-        jrnl_strlcpy(de->response, e->response, SOMA_MEM_RESPONSE_LEN);
-        de->turn        = e->turn;
-        de->session     = (unsigned int)mem->boot_count;
-        de->prompt_hash = e->prompt_hash;
-        de->flags       = 0x1u;
-        n++;
-    }
+    EFI_STATUS st = uefi_call_wrapper(root->Open, 5, root, &fh, name, mode, 0ULL);
+    if (EFI_ERROR(st)) return NULL;
+    return fh;
+}
 
-    // Write header
-    SomaJournalHeader hdr;
-    jrnl_memset(&hdr, 0, sizeof(hdr));
-    hdr.magic       = SOMA_JOURNAL_MAGIC;
-    hdr.version     = SOMA_JOURNAL_VERSION;
-    hdr.entry_count = (unsigned int)n;
-    hdr.total_turns = total_turns_ever;
-    hdr.boot_count  = (unsigned int)mem->boot_count;
-
-    UINTN sz = sizeof(SomaJournalHeader);
-    st = uefi_call_wrapper(fh->Write, 3, fh, &sz, &hdr);
-    if (EFI_ERROR(st)) {
-        uefi_call_wrapper(fh->Close, 1, fh);
-        return -1;
-    }
+static int32_t jrnl_io_read(void *ctx, uint32_t file, void *buf, uint32_t cap) {
+    EFI_FILE_HANDLE fh = jrnl_open((EFI_FILE_PROTOCOL *)ctx, file, EFI_FILE_MODE_READ);
+    if (!fh) return -1;
+    UINTN sz = cap;
+    EFI_STATUS st = uefi_call_wrapper(fh->Read, 3, fh, &sz, buf);
+    uefi_call_wrapper(fh->Close, 1, fh);
+    if (EFI_ERROR(st)) return 0;   // unreadable = no valid records
+    return (int32_t)sz;
+}
 
-    // Write entries
-    if (n > 0) {
-        sz = (UINTN)(n * (int)sizeof(SomaJournalEntry));
-        st = uefi_call_wrapper(fh->Write, 3, fh, &sz, disk_entries);
-        if (EFI_ERROR(st)) {
-            uefi_call_wrapper(fh->Close, 1, fh);
-            return -1;
-        }
-    }
+static int jrnl_io_write(void *ctx, uint32_t file, uint32_t pos, const void *buf, uint32_t len) {
+    EFI_FILE_HANDLE fh = jrnl_open((EFI_FILE_PROTOCOL *)ctx, file,
+        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE);
+    if (!fh) return -1;
 
+    uefi_call_wrapper(fh->SetPosition, 2, fh, (UINT64)pos);
+    UINTN sz = len;
+    EFI_STATUS st = uefi_call_wrapper(fh->Write, 3, fh, &sz, (void *)buf);
+    if (!EFI_ERROR(st)) st = uefi_call_wrapper(fh->Flush, 1, fh);
     uefi_call_wrapper(fh->Close, 1, fh);
-    return n;
+    return (EFI_ERROR(st) || sz != len) ? -1 : 0;
 }
 
-// ─── soma_journal_load ──────────────────────────────────────────────────────
+static int jrnl_io_remove(void *ctx, uint32_t file) {
+    EFI_FILE_HANDLE fh = jrnl_open((EFI_FILE_PROTOCOL *)ctx, file,
+                                   EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE);
+    if (!fh) return 0;
+    // Delete closes the handle automatically.
+    uefi_call_wrapper(fh->Delete, 1, fh);
+    return 0;
+}
 
-int soma_journal_load(SomaMemCtx *mem, EFI_FILE_PROTOCOL *root,
-                      unsigned int *total_turns_out) {
-    if (!mem || !root) return -2;
+// ─── Replay into soma_memory ────────────────────────────────────────────────
+
+typedef struct {
+    SomaMemCtx *mem;
+    int         replayed;
+} JrnlReplayCtx;
+
+static void jrnl_replay_turn(SomaMemCtx *mem, int turn, unsigned char domain,
+                             const char *prompt, int prompt_len,
+                             const char *response, int response_len) {
+    char p[SOMA_MEM_PROMPT_LEN];
+    char r[SOMA_MEM_RESPONSE_LEN];
+    jrnl_copy_text(p, SOMA_MEM_PROMPT_LEN, prompt, prompt_len);
+    jrnl_copy_text(r, SOMA_MEM_RESPONSE_LEN, response, response_len);
+    soma_memory_record_tagged(mem, p, r, domain);
+    // record stamps the current turn counter; keep the original one
+    if (mem->count > 0) {
+        int prev_slot = (mem->head - 1 + SOMA_MEM_MAX_ENTRIES) % SOMA_MEM_MAX_ENTRIES;
+        mem->entries[prev_slot].turn = turn;
+    }
+}
 
+static void jrnl_on_turn(void *ctx, const SjlTurnHdr *t,
+                         const char *prompt, const char *response) {
+    JrnlReplayCtx *rc = (JrnlReplayCtx *)ctx;
+    jrnl_replay_turn(rc->mem, t->turn, t->domain, prompt, t->prompt_len,
+                     response, t->response_len);
+    rc->replayed++;
+}
+
+// v1 soma_journal.bin → log records (first load after upgrade only).
+static int jrnl_import_v1(SomaJournal *j, JrnlReplayCtx *rc) {
     EFI_FILE_HANDLE fh = NULL;
-    EFI_STATUS st = uefi_call_wrapper(root->Open, 5, root, &fh,
+    EFI_STATUS st = uefi_call_wrapper(j->root->Open, 5, j->root, &fh,
                         (CHAR16 *)SOMA_JOURNAL_FILENAME,
-                        EFI_FILE_MODE_READ, 0ULL);
-    if (EFI_ERROR(st) || !fh) return -1;  // file not found
+                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0ULL);
+    if (EFI_ERROR(st) || !fh) return 0;
 
-    // Read header
     SomaJournalHeader hdr;
     jrnl_memset(&hdr, 0, sizeof(hdr));
-    UINTN sz = sizeof(SomaJournalHeader);
+    UINTN sz = sizeof(hdr);
     st = uefi_call_wrapper(fh->Read, 3, fh, &sz, &hdr);
-    if (EFI_ERROR(st) || sz != sizeof(SomaJournalHeader)) {
-        uefi_call_wrapper(fh->Close, 1, fh);
-        return -2;
-    }
-
-    // Validate
-    if (hdr.magic != SOMA_JOURNAL_MAGIC || hdr.version != SOMA_JOURNAL_VERSION) {
+    if (EFI_ERROR(st) || sz != sizeof(hdr) ||
+        hdr.magic != SOMA_JOURNAL_MAGIC || hdr.version != SOMA_JOURNAL_VERSION) {
         uefi_call_wrapper(fh->Close, 1, fh);
-        return -2;
+        return 0;
     }
 
-    if (total_turns_out) *total_turns_out = hdr.total_turns;
-
-    // Restore boot_count from journal (will be incremented by soma_memory_init)
-    // We set it here so init sees prior sessions
-    if (hdr.boot_count > 0)
-        mem->boot_count = (int)hdr.boot_count;
-
-    // Read entries
     int count = (int)hdr.entry_count;
     if (count > SOMA_JOURNAL_MAX_ENTRIES) count = SOMA_JOURNAL_MAX_ENTRIES;
-
-    int loaded = 0;
+    int imported = 0;
     for (int i = 0; i < count; i++) {
         SomaJournalEntry de;
-        jrnl_memset(&de, 0, sizeof(de));
-        sz = sizeof(SomaJournalEntry);
+        sz = sizeof(de);
         st = uefi_call_wrapper(fh->Read, 3, fh, &sz, &de);
-        if (EFI_ERROR(st) || sz != sizeof(SomaJournalEntry)) break;
+        if (EFI_ERROR(st) || sz != sizeof(de)) break;
         if (!(de.flags & 0x1u)) continue;
 
-        // Re-inject into ring buffer via soma_memory_record
-        // Use turn = -(i+1) as sentinel for "historical" (not this session)
-        soma_memory_record(mem, de.prompt, de.response);
-        // Override turn to preserve original (record sets total_turns, patch it)
-        if (mem->count > 0) {
-            int prev_slot = (mem->head - 1 + SOMA_MEM_MAX_ENTRIES) % SOMA_MEM_MAX_ENTRIES;
-            mem->entries[prev_slot].turn = de.turn;
-        }
-        loaded++;
+        SjlTurnHdr t;
+        jrnl_memset(&t, 0, sizeof(t));
+        t.turn         = de.turn;
+        t.session      = de.session;
+        t.prompt_hash  = de.prompt_hash;
+        t.prompt_len   = (uint8_t)jrnl_strnlen(de.prompt, SOMA_MEM_PROMPT_LEN);
+        t.response_len = (uint8_t)jrnl_strnlen(de.response, SOMA_MEM_RESPONSE_LEN);
+        if (sjl_append_turn(&j->log, &t, de.prompt, de.response) != SJL_OK) break;
+        jrnl_replay_turn(rc->mem, t.turn, 0, de.prompt, t.prompt_len,
+                         de.response, t.response_len);
+        imported++;
     }
+    if (hdr.boot_count > j->log.boot_count) sjl_append_boot(&j->log, hdr.boot_count);
 
-    uefi_call_wrapper(fh->Close, 1, fh);
-    return loaded;
+    // Only drop the snapshot once its turns are durable in the log
+    if (sjl_flush(&j->log) >= 0) {
+        uefi_call_wrapper(fh->Delete, 1, fh);
+    } else {
+        uefi_call_wrapper(fh->Close, 1, fh);
+    }
+    rc->replayed += imported;
+    return imported;
 }
 
-// ─── soma_journal_clear ─────────────────────────────────────────────────────
+// ─── API ────────────────────────────────────────────────────────────────────
 
-int soma_journal_clear(EFI_FILE_PROTOCOL *root) {
-    if (!root) return -1;
+int soma_journal_init(SomaJournal *j, void *scratch, UINTN scratch_bytes) {
+    if (!j) return -1;
+    jrnl_memset(j, 0, sizeof(*j));
+    if (!scratch || scratch_bytes < SOMA_JOURNAL_SCRATCH_BYTES) return -1;
+    j->scratch = scratch;
+    return 0;
+}
 
-    // Open + truncate to zero by overwriting with empty header
-    EFI_FILE_HANDLE fh = NULL;
-    EFI_STATUS st = uefi_call_wrapper(root->Open, 5, root, &fh,
-                        (CHAR16 *)SOMA_JOURNAL_FILENAME,
-                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
-                        0ULL);
-    if (EFI_ERROR(st) || !fh) return -1;
+int soma_journal_load(SomaJournal *j, SomaMemCtx *mem, EFI_FILE_PROTOCOL *root,
+                      unsigned int *total_turns_out) {
+    if (!j || !j->scratch || !mem || !root) return -2;
+
+    // Reloading mid-session: keep the turns still in the batch
+    if (j->ready) sjl_flush(&j->log);
+    j->ready = 0;
+    j->root  = root;
+
+    for (int i = 0; i < SOMA_MEM_MAX_ENTRIES; i++) mem->entries[i].valid = 0;
+    mem->head  = 0;
+    mem->count = 0;
+
+    SjlIo io;
+    io.ctx    = root;
+    io.read   = jrnl_io_read;
+    io.write  = jrnl_io_write;
+    io.remove = jrnl_io_remove;
+
+    JrnlReplayCtx rc = { mem, 0 };
+    if (sjl_open(&j->log, &io, j->scratch, SOMA_JOURNAL_SCRATCH_BYTES,
+                 jrnl_on_turn, &rc) != SJL_OK)
+        return -2;
+    j->ready = 1;
 
-    // Write zeroed header (entry_count=0 signals empty)
-    SomaJournalHeader hdr;
-    jrnl_memset(&hdr, 0, sizeof(hdr));
-    hdr.magic   = SOMA_JOURNAL_MAGIC;
-    hdr.version = SOMA_JOURNAL_VERSION;
-    UINTN sz = sizeof(SomaJournalHeader);
-    uefi_call_wrapper(fh->Write, 3, fh, &sz, &hdr);
-    // Truncate to header size
-    uefi_call_wrapper(fh->SetPosition, 2, fh, (UINT64)sz);
-    uefi_call_wrapper(fh->Close, 1, fh);
-    return 0;
+    int empty = (sjl_total_turns(&j->log) == 0 && j->log.boot_count == 0);
+    if (empty) empty = (jrnl_import_v1(j, &rc) == 0 && j->log.boot_count == 0);
+
+    // One BOOT record per session, written at the first load
+    if (!j->session) {
+        j->session = j->log.boot_count + 1u;
+        sjl_append_boot(&j->log, j->session);
+        sjl_flush(&j->log);
+    }
+    mem->boot_count = (int)j->session;
+
+    if (total_turns_out) *total_turns_out = sjl_total_turns(&j->log);
+    j->loaded = rc.replayed;
+    return empty ? -1 : rc.replayed;
+}
+
+int soma_journal_append(SomaJournal *j, const SomaMemCtx *mem) {
+    if (!j || !j->ready || !mem || mem->count <= 0) return -1;
+
+    int idx = (mem->head - 1 + SOMA_MEM_MAX_ENTRIES) % SOMA_MEM_MAX_ENTRIES;
+    const SomaMemEntry *e = &mem->entries[idx];
+    if (!e->valid) return -1;
+
+    SjlTurnHdr t;
+    jrnl_memset(&t, 0, sizeof(t));
+    t.turn         = e->turn;
+    t.session      = j->session;
+    t.prompt_hash  = e->prompt_hash;
+    t.domain       = e->domain;
+    t.prompt_len   = (uint8_t)jrnl_strnlen(e->prompt, SOMA_MEM_PROMPT_LEN);
+    t.response_len = (uint8_t)jrnl_strnlen(e->response, SOMA_MEM_RESPONSE_LEN);
+    if (sjl_append_turn(&j->log, &t, e->prompt, e->response) != SJL_OK) return -1;
+
+    if (j->log.batch_turns < SOMA_JOURNAL_AUTOSAVE_EVERY) return 0;
+    int n = soma_journal_save(j);
+    if (n > 0) sjl_compact_step(&j->log, SOMA_JOURNAL_KEEP_SEGS);
+    return n;
 }
 
-// ─── soma_journal_read_stats ────────────────────────────────────────────────
+int soma_journal_save(SomaJournal *j) {
+    if (!j || !j->ready) return -1;
+    int n = sjl_flush(&j->log);
+    if (n < 0) return -1;
+    j->last_saved = n;
+    return n;
+}
 
-int soma_journal_read_stats(EFI_FILE_PROTOCOL *root, SomaJournalStats *out) {
-    if (!root || !out) return -1;
-    jrnl_memset(out, 0, sizeof(*out));
+int soma_journal_clear(SomaJournal *j) {
+    if (!j || !j->ready) return -1;
+    sjl_clear(&j->log);
 
     EFI_FILE_HANDLE fh = NULL;
-    EFI_STATUS st = uefi_call_wrapper(root->Open, 5, root, &fh,
+    EFI_STATUS st = uefi_call_wrapper(j->root->Open, 5, j->root, &fh,
                         (CHAR16 *)SOMA_JOURNAL_FILENAME,
-                        EFI_FILE_MODE_READ, 0ULL);
-    if (EFI_ERROR(st) || !fh) { out->error = 1; return -1; }
+                        EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE, 0ULL);
+    if (!EFI_ERROR(st) && fh) uefi_call_wrapper(fh->Delete, 1, fh);
 
-    SomaJournalHeader hdr;
-    jrnl_memset(&hdr, 0, sizeof(hdr));
-    UINTN sz = sizeof(SomaJournalHeader);
-    st = uefi_call_wrapper(fh->Read, 3, fh, &sz, &hdr);
-    uefi_call_wrapper(fh->Close, 1, fh);
-
-    if (EFI_ERROR(st) || hdr.magic != SOMA_JOURNAL_MAGIC) {
-        out->error = 1;
-        return -1;
-    }
+    // Keep counting sessions from here
+    sjl_append_boot(&j->log, j->session);
+    return sjl_flush(&j->log) < 0 ? -1 : 0;
+}
 
-    out->loaded      = (int)hdr.entry_count;  // approx
-    out->total_turns = (int)hdr.total_turns;
-    out->boot_count  = (int)hdr.boot_count;
+int soma_journal_read_stats(const SomaJournal *j, SomaJournalStats *out) {
+    if (!j || !out) return -1;
+    jrnl_memset(out, 0, sizeof(*out));
+    if (!j->ready) { out->error = 1; return -1; }
+
+    const SjlLog *l = &j->log;
+    out->loaded        = j->loaded;
+    out->saved         = j->last_saved;
+    out->total_turns   = (int)sjl_total_turns(l);
+    out->boot_count    = (int)j->session;
+    out->pending       = (int)l->batch_turns;
+    out->segments      = (int)(l->seg_tail - l->seg_first) + (l->tail_len ? 1 : 0);
+    out->raw_bytes     = (int)l->bytes_raw;
+    out->summary_turns = (int)l->sum.turns;
+    out->torn          = (int)l->torn;
+    out->flushes       = (int)l->flushes;
+    out->compactions   = (int)l->compactions;
     return 0;
 }
@@ -1,20 +1,29 @@
 // soma_journal.h — SomaMind Phase I: Persistent Session Journal
 //
-// Persists soma_memory ring buffer to a binary file on the EFI partition
-// (soma_journal.bin). Loaded at boot, saved periodically and on demand.
-//
-// This lets the kernel remember past interactions across reboots — the
+// Records every (prompt, response) turn to an append-only segmented log on
+// the EFI partition (soma_jlog.h) and replays it into the soma_memory ring
+// at boot, so the kernel remembers past interactions across reboots — the
 // minimal foundation for continuous learning and oo-model training data.
 //
-// File format (little-endian):
-//   [SomaJournalHeader  32 bytes]
-//   [SomaJournalEntry × entry_count]  each 216 bytes
+// Files on the boot volume:
+//   SJ000000.LOG, SJ000001.LOG, ...  raw segments (≤ 64 KB each)
+//   SJSUMA.LOG / SJSUMB.LOG          summary of compacted segments (ping-pong)
+//
+// Turns are batched in memory and group-flushed every
+// SOMA_JOURNAL_AUTOSAVE_EVERY turns with one sequential append; a power
+// loss costs at most the unflushed batch and never earlier history. After
+// each flush one segment beyond SOMA_JOURNAL_KEEP_SEGS is folded into the
+// summary, so boot replay stays bounded while the turn count is not.
+//
+// The v1 soma_journal.bin (fixed 64-entry snapshot) is imported once on
+// first load and then deleted.
 //
-// Freestanding C11 — only depends on soma_memory.h and EFI headers.
+// Freestanding C11 — only depends on soma_memory.h, soma_jlog.h and EFI headers.
 
 #pragma once
 
 #include "soma_memory.h"
+#include "soma_jlog.h"
 
 // EFI forward declaration — included by the god file before this header
 #ifndef EFI_FILE_PROTOCOL_STUB
@@ -33,14 +42,18 @@ extern "C" {
 // ============================================================
 // Configuration
 // ============================================================
+#define SOMA_JOURNAL_AUTOSAVE_EVERY 4            // Group-flush every N new turns
+#define SOMA_JOURNAL_KEEP_SEGS      8            // Raw segments kept before compaction
+#define SOMA_JOURNAL_SCRATCH_BYTES  SJL_SEG_BYTES
+
+// v1 snapshot format (import only)
 #define SOMA_JOURNAL_MAGIC          0x534A524Eu  // "SJRN"
 #define SOMA_JOURNAL_VERSION        1u
-#define SOMA_JOURNAL_MAX_ENTRIES    64           // Keep last 64 turns on disk
-#define SOMA_JOURNAL_AUTOSAVE_EVERY 4            // Auto-save every N new turns
+#define SOMA_JOURNAL_MAX_ENTRIES    64
 #define SOMA_JOURNAL_FILENAME       L"soma_journal.bin"
 
 // ============================================================
-// Disk header (32 bytes, packed)
+// v1 disk header (32 bytes, packed)
 // ============================================================
 typedef struct __attribute__((packed)) {
     unsigned int  magic;          // SOMA_JOURNAL_MAGIC
@@ -52,8 +65,7 @@ typedef struct __attribute__((packed)) {
 } SomaJournalHeader;
 
 // ============================================================
-// Disk entry (216 bytes, packed)
-// Matches SomaMemEntry fields + session tag + flags
+// v1 disk entry (216 bytes, packed)
 // ============================================================
 typedef struct __attribute__((packed)) {
     char         prompt[SOMA_MEM_PROMPT_LEN];       // 80 bytes
@@ -65,37 +77,63 @@ typedef struct __attribute__((packed)) {
 } SomaJournalEntry;
 
 // ============================================================
-// Stats (populated by soma_journal_load/save)
+// Journal handle
+// ============================================================
+typedef struct {
+    SjlLog             log;
+    EFI_FILE_PROTOCOL *root;
+    void              *scratch;      // SOMA_JOURNAL_SCRATCH_BYTES, caller-owned
+    unsigned int       session;      // boot_count of this session (0 = not loaded)
+    int                ready;        // log replayed, appends accepted
+    int                loaded;       // turns replayed by the last load
+    int                last_saved;   // records written by the last flush
+} SomaJournal;
+
+// ============================================================
+// Stats
 // ============================================================
 typedef struct {
-    int loaded;           // Entries loaded into ring buffer
-    int saved;            // Entries written to disk
-    int total_turns;      // From header: cumulative turns
-    int boot_count;       // From header: session count
-    int error;            // 1 = last operation failed
+    int loaded;           // Turns replayed into the ring buffer
+    int saved;            // Records written by the last flush
+    int total_turns;      // Cumulative turns (summary + raw + pending)
+    int boot_count;       // Session count
+    int error;            // 1 = journal not loaded
+    int pending;          // Turns batched, not yet on disk
+    int segments;         // Raw segment files
+    int raw_bytes;        // Valid bytes in raw segments
+    int summary_turns;    // Turns folded into the summary
+    int torn;             // Segments whose torn tail was dropped at replay
+    int flushes;
+    int compactions;
 } SomaJournalStats;
 
 // ============================================================
 // API
 // ============================================================
 
-// Load soma_journal.bin → populate soma_memory via soma_memory_record().
-// Sets ctx->boot_count from journal (adds 1 for current session).
-// Returns number of entries loaded, -1 on file-not-found, -2 on error.
-int soma_journal_load(SomaMemCtx *mem, EFI_FILE_PROTOCOL *root,
+// Bind scratch memory (SOMA_JOURNAL_SCRATCH_BYTES). Returns 0 or -1.
+int soma_journal_init(SomaJournal *j, void *scratch, UINTN scratch_bytes);
+
+// Replay the log into soma_memory (ring reset first; newest turns survive)
+// and start this session: mem->boot_count = last session + 1.
+// Returns turns replayed, -1 if the journal is empty (first boot), -2 on error.
+int soma_journal_load(SomaJournal *j, SomaMemCtx *mem, EFI_FILE_PROTOCOL *root,
                       unsigned int *total_turns_out);
 
-// Save current ring buffer → soma_journal.bin (overwrite).
-// Returns number of entries written, -1 on error.
-int soma_journal_save(const SomaMemCtx *mem, EFI_FILE_PROTOCOL *root,
-                      unsigned int total_turns_ever);
+// Queue the newest soma_memory entry; every SOMA_JOURNAL_AUTOSAVE_EVERY
+// turns the batch is flushed and one compaction step runs.
+// Returns records flushed (0 = only queued), -1 on error.
+int soma_journal_append(SomaJournal *j, const SomaMemCtx *mem);
+
+// Flush the pending batch now. Returns records written, -1 on error.
+int soma_journal_save(SomaJournal *j);
 
-// Delete soma_journal.bin from EFI partition.
+// Delete every journal file and start an empty log.
 // Returns 0 on success, -1 on error.
-int soma_journal_clear(EFI_FILE_PROTOCOL *root);
+int soma_journal_clear(SomaJournal *j);
 
-// Populate a stats struct from a journal file (header only, no mem changes).
-int soma_journal_read_stats(EFI_FILE_PROTOCOL *root, SomaJournalStats *out);
+// Snapshot counters (no disk access).
+int soma_journal_read_stats(const SomaJournal *j, SomaJournalStats *out);
 
 #ifdef __cplusplus
 }
@@ -120,6 +120,42 @@ void soma_memory_set_model(SomaMemCtx *ctx, const char *model_name) {
     soma_mem_strncpy(ctx->model_name, model_name, SOMA_MEM_MODEL_LEN);
 }
 
+// Fill match fields + build injection string: [MEM: turn=N sim=S response="..."]
+static void soma_mem_fill_match(SomaMemCtx *ctx, SomaMemResult *r, int turn,
+                                const char *prompt, const char *response,
+                                int similarity) {
+    r->match_found      = 1;
+    r->match_turn       = turn;
+    r->match_similarity = similarity;
+    soma_mem_strncpy(r->match_prompt,   prompt,   SOMA_MEM_PROMPT_LEN);
+    soma_mem_strncpy(r->match_response, response, SOMA_MEM_RESPONSE_LEN);
+
+    int len = 0;
+    len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, "[MEM: turn=");
+    len = soma_mem_append_int(r->injection, len, SOMA_MEM_INJECT_MAX, r->match_turn);
+    len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, " sim=");
+    len = soma_mem_append_int(r->injection, len, SOMA_MEM_INJECT_MAX, similarity);
+    if (r->model_name[0]) {
+        len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, " model=");
+        len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, r->model_name);
+    }
+    len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, " boot=");
+    len = soma_mem_append_int(r->injection, len, SOMA_MEM_INJECT_MAX, r->boot_count);
+    if (r->match_response[0]) {
+        len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, " prev=\"");
+        // Truncate response to first 40 chars for injection
+        char trunc[41];
+        soma_mem_strncpy(trunc, r->match_response, 41);
+        len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, trunc);
+        len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, "\"");
+    }
+    len = soma_mem_append(r->injection, len, SOMA_MEM_INJECT_MAX, "]\n");
+    r->injection_len = len;
+    r->triggered     = 1;
+
+    ctx->total_triggers++;
+}
+
 SomaMemResult soma_memory_scan(SomaMemCtx *ctx, const char *prompt) {
     SomaMemResult r;
     for (int i = 0; i < (int)sizeof(SomaMemResult); i++) ((char*)&r)[i] = 0;
@@ -151,37 +187,21 @@ SomaMemResult soma_memory_scan(SomaMemCtx *ctx, const char *prompt) {
     if (best_idx < 0 || best_score < 30) return r;
 
     SomaMemEntry *best = &ctx->entries[best_idx];
-    r.match_found      = 1;
-    r.match_turn       = best->turn;
-    r.match_similarity = best_score;
-    soma_mem_strncpy(r.match_prompt,   best->prompt,   SOMA_MEM_PROMPT_LEN);
-    soma_mem_strncpy(r.match_response, best->response, SOMA_MEM_RESPONSE_LEN);
+    soma_mem_fill_match(ctx, &r, best->turn, best->prompt, best->response, best_score);
+    return r;
+}
 
-    // Build injection string: [MEM: turn=N sim=S response="..."]
-    int len = 0;
-    len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, "[MEM: turn=");
-    len = soma_mem_append_int(r.injection, len, SOMA_MEM_INJECT_MAX, r.match_turn);
-    len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, " sim=");
-    len = soma_mem_append_int(r.injection, len, SOMA_MEM_INJECT_MAX, best_score);
-    if (r.model_name[0]) {
-        len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, " model=");
-        len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, r.model_name);
-    }
-    len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, " boot=");
-    len = soma_mem_append_int(r.injection, len, SOMA_MEM_INJECT_MAX, r.boot_count);
-    if (best->response[0]) {
-        len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, " prev=\"");
-        // Truncate response to first 40 chars for injection
-        char trunc[41];
-        soma_mem_strncpy(trunc, best->response, 41);
-        len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, trunc);
-        len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, "\"");
-    }
-    len = soma_mem_append(r.injection, len, SOMA_MEM_INJECT_MAX, "]\n");
-    r.injection_len = len;
-    r.triggered     = 1;
+SomaMemResult soma_memory_recall(SomaMemCtx *ctx, int turn, const char *prompt,
+                                 const char *response, int similarity) {
+    SomaMemResult r;
+    for (int i = 0; i < (int)sizeof(SomaMemResult); i++) ((char*)&r)[i] = 0;
 
-    ctx->total_triggers++;
+    r.current_turn = ctx->total_turns;
+    r.boot_count   = ctx->boot_count;
+    soma_mem_strncpy(r.model_name, ctx->model_name, SOMA_MEM_MODEL_LEN);
+
+    if (!ctx->enabled || !prompt || !prompt[0]) return r;
+    soma_mem_fill_match(ctx, &r, turn, prompt, response ? response : "", similarity);
     return r;
 }
 
@@ -15,7 +15,8 @@
 // Features:
 //   - Freestanding C11 — no libc, no malloc, stack + static ring buffer
 //   - Ring buffer: SOMA_MEM_MAX_ENTRIES slots (circular overwrite)
-//   - Similarity: simple hash + substring prefix match (first 24 chars)
+//   - Similarity: simple hash + substring prefix match (first 24 chars);
+//     semantic matches from soma_embed come in via soma_memory_recall()
 //   - Boot & model tracking: updated on /ssm_load and at init
 //   - Injection only fires when a match is found (triggered=1)
 //
@@ -101,6 +102,11 @@ void soma_memory_set_model(SomaMemCtx *ctx, const char *model_name);
 // Returns a result with injection string if ctx->enabled and a match found.
 SomaMemResult soma_memory_scan(SomaMemCtx *ctx, const char *prompt);
 
+// Build the same [MEM: ...] injection from a match found elsewhere
+// (e.g. soma_embed semantic recall). similarity is 0-100.
+SomaMemResult soma_memory_recall(SomaMemCtx *ctx, int turn, const char *prompt,
+                                 const char *response, int similarity);
+
 // Record a (prompt, response_summary) pair after inference.
 // Call after generate() completes.
 void soma_memory_record(SomaMemCtx *ctx, const char *prompt, const char *response_summary);
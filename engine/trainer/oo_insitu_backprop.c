@@ -0,0 +1,651 @@
+// oo_insitu_backprop.c — Gradient-based in-situ LoRA fine-tuning (implementation)
+//
+// Shapes: T tokens, D = dim, K = kv_dim, H = hidden_dim, NH heads.
+// Captured layer c (layer L-N+c) keeps, in this order:
+//   xin[T·D] xb[T·D] ra[T] q[T·D] k[T·K] v[T·K] att[NH·T·T] o[T·D]
+//   xmid[T·D] xbf[T·D] rf[T] h1[T·H] h3[T·H] g[T·H]
+// where ra/rf are the inverse RMS of the two norms, q/k are stored after
+// RoPE (token t at position t) and att holds the softmax probabilities
+// (row t, columns 0..t).
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "oo_insitu_backprop.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OIT_BP_X86 1
+#endif
+
+// ── Math (no libm) ────────────────────────────────────────────────────────
+
+static float bp_sqrt(float x) {
+    if (x <= 0.0f) return 0.0f;
+#ifdef OIT_BP_X86
+    return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+#else
+    float s = x > 1.0f ? x * 0.5f : 1.0f;
+    for (int i = 0; i < 12; i++) s = 0.5f * (s + x / s);
+    return s;
+#endif
+}
+
+// exp via 2^k · e^r, |r| <= ln2/2, degree-6 Taylor (rel. err < 2e-7)
+static float bp_exp(float x) {
+    if (x < -87.0f) return 0.0f;
+    if (x > 88.0f) x = 88.0f;
+    float kf = x * 1.44269504f;
+    int k = (int)(kf >= 0.0f ? kf + 0.5f : kf - 0.5f);
+    float r = x - (float)k * 0.693145752f - (float)k * 1.42860677e-6f;
+    float p = 1.0f + r * (1.0f + r * (0.5f + r * (0.166666672f +
+              r * (0.0416666679f + r * (0.00833333377f + r * 0.00138888892f)))));
+    union { uint32_t u; float f; } c;
+    c.u = (uint32_t)(k + 127) << 23;
+    return p * c.f;
+}
+
+// ln via x = m·2^e, m in [0.75, 1.5): ln m = 2·atanh((m-1)/(m+1))
+static float bp_log(float x) {
+    if (x <= 0.0f) return -87.0f;
+    union { float f; uint32_t u; } c = { x };
+    int e = (int)((c.u >> 23) & 0xFF) - 127;
+    c.u = (c.u & 0x007FFFFFu) | 0x3F800000u;
+    float m = c.f;
+    if (m > 1.5f) { m *= 0.5f; e++; }
+    float s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+    float a = s * (2.0f + s2 * (0.666666667f + s2 * (0.4f + s2 * (0.285714286f + s2 * 0.222222222f))));
+    return a + (float)e * 0.693147181f;
+}
+
+static float bp_dot(const float *a, const float *b, int n) {
+    int i = 0;
+    float s = 0.0f;
+#ifdef OIT_BP_X86
+    __m128 v0 = _mm_setzero_ps(), v1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        v0 = _mm_add_ps(v0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        v1 = _mm_add_ps(v1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    v0 = _mm_add_ps(v0, v1);
+    v1 = _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(2, 3, 0, 1));
+    v0 = _mm_add_ps(v0, v1);
+    v1 = _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(1, 0, 3, 2));
+    s = _mm_cvtss_f32(_mm_add_ps(v0, v1));
+#endif
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+// y += a·x
+static void bp_axpy(float *y, const float *x, float a, int n) {
+    int i = 0;
+#ifdef OIT_BP_X86
+    __m128 va = _mm_set1_ps(a);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+#endif
+    for (; i < n; i++) y[i] += a * x[i];
+}
+
+static void bp_zero(float *p, uint64_t n) { for (uint64_t i = 0; i < n; i++) p[i] = 0.0f; }
+static void bp_copy(float *d, const float *s, int n) { for (int i = 0; i < n; i++) d[i] = s[i]; }
+
+static float bp_fp16(const uint8_t *p) {
+    uint32_t h = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+    uint32_t sign = (h >> 15) & 1u, exp = (h >> 10) & 0x1Fu, mant = h & 0x3FFu, u;
+    if (exp == 0) {
+        if (mant == 0) {
+            u = sign << 31;
+        } else {
+            exp = 1;
+            while ((mant & 0x400u) == 0) { mant <<= 1; exp--; }
+            u = (sign << 31) | ((exp + 112u) << 23) | ((mant & 0x3FFu) << 13);
+        }
+    } else if (exp == 31) {
+        u = (sign << 31) | (0xFFu << 23) | (mant << 13);
+    } else {
+        u = (sign << 31) | ((exp + 112u) << 23) | (mant << 13);
+    }
+    union { uint32_t u; float f; } c;
+    c.u = u;
+    return c.f;
+}
+
+// ── Layout ────────────────────────────────────────────────────────────────
+
+typedef struct {
+    float *xin, *xb, *ra, *q, *k, *v, *att, *o, *xmid, *xbf, *rf, *h1, *h3, *g;
+} BpCap;
+
+static uint64_t bp_al(uint64_t n) { return (n + 15u) & ~(uint64_t)15u; }   // 64-byte runs
+
+// Bump allocator: base == 0 only measures
+static float *bp_take(float **cur, uint64_t *used, uint64_t n) {
+    float *p = *cur;
+    n = bp_al(n);
+    *used += n;
+    if (*cur) *cur += n;
+    return p;
+}
+
+static int bp_kvd(const OitBpModel *m) { return m->dim * m->n_kv_heads / m->n_heads; }
+
+static uint64_t bp_cap_floats(const OitBpModel *m, int T) {
+    uint64_t D = (uint64_t)m->dim, K = (uint64_t)bp_kvd(m), H = (uint64_t)m->hidden_dim;
+    uint64_t t = (uint64_t)T;
+    return bp_al(t * D) * 7 + bp_al(t) * 2 + bp_al(t * K) * 2 +
+           bp_al((uint64_t)m->n_heads * t * t) + bp_al(t * H) * 3;
+}
+
+static void bp_cap_at(const OitBpModel *m, int T, float *base, int c, BpCap *cp) {
+    float *cur = base + (uint64_t)c * bp_cap_floats(m, T);
+    uint64_t used = 0, D = (uint64_t)m->dim, K = (uint64_t)bp_kvd(m), H = (uint64_t)m->hidden_dim;
+    uint64_t t = (uint64_t)T;
+    cp->xin  = bp_take(&cur, &used, t * D);
+    cp->xb   = bp_take(&cur, &used, t * D);
+    cp->ra   = bp_take(&cur, &used, t);
+    cp->q    = bp_take(&cur, &used, t * D);
+    cp->k    = bp_take(&cur, &used, t * K);
+    cp->v    = bp_take(&cur, &used, t * K);
+    cp->att  = bp_take(&cur, &used, (uint64_t)m->n_heads * t * t);
+    cp->o    = bp_take(&cur, &used, t * D);
+    cp->xmid = bp_take(&cur, &used, t * D);
+    cp->xbf  = bp_take(&cur, &used, t * D);
+    cp->rf   = bp_take(&cur, &used, t);
+    cp->h1   = bp_take(&cur, &used, t * H);
+    cp->h3   = bp_take(&cur, &used, t * H);
+    cp->g    = bp_take(&cur, &used, t * H);
+}
+
+// Scratch for one worker; returns floats used (base == 0 measures only)
+static uint64_t bp_scratch_layout(const OitBpModel *m, int n_train, int T,
+                                  OitBpScratch *ws, float *base) {
+    float *cur = base;
+    uint64_t used = 0, t = (uint64_t)T;
+    uint64_t D = (uint64_t)m->dim, K = (uint64_t)bp_kvd(m), H = (uint64_t)m->hidden_dim;
+    uint64_t DH = D > H ? D : H;
+    if (DH < t) DH = t;                  // tmp doubles as the dattn row
+    OitBpScratch s;
+    s.x     = bp_take(&cur, &used, t * D);
+    s.xb    = bp_take(&cur, &used, D);
+    s.q     = bp_take(&cur, &used, t * D);
+    s.k     = bp_take(&cur, &used, t * K);
+    s.v     = bp_take(&cur, &used, t * K);
+    s.o     = bp_take(&cur, &used, t * D);
+    s.h1    = bp_take(&cur, &used, H);
+    s.h3    = bp_take(&cur, &used, H);
+    s.g     = bp_take(&cur, &used, H);
+    s.att   = bp_take(&cur, &used, t);
+    s.xf    = bp_take(&cur, &used, t * D);
+    s.rf    = bp_take(&cur, &used, t);
+    s.logit = bp_take(&cur, &used, (uint64_t)m->vocab_size);
+    s.dx    = bp_take(&cur, &used, t * D);
+    s.dxb   = bp_take(&cur, &used, D);
+    s.dq    = bp_take(&cur, &used, t * D);
+    s.dk    = bp_take(&cur, &used, t * K);
+    s.dv    = bp_take(&cur, &used, t * K);
+    s.dout  = bp_take(&cur, &used, t * D);
+    s.dh1   = bp_take(&cur, &used, H);
+    s.dh3   = bp_take(&cur, &used, H);
+    s.dg    = bp_take(&cur, &used, H);
+    s.dxf   = bp_take(&cur, &used, D);
+    s.tmp   = bp_take(&cur, &used, DH);
+    s.cap   = bp_take(&cur, &used, bp_cap_floats(m, T) * (uint64_t)n_train);
+    if (ws && base) *ws = s;
+    return used;
+}
+
+// ── Building blocks ───────────────────────────────────────────────────────
+
+// o = w ⊙ x · r, returns r = 1/sqrt(mean(x²) + eps)
+static float bp_rmsnorm(float *o, const float *x, const float *w, int n) {
+    float r = 1.0f / bp_sqrt(bp_dot(x, x, n) / (float)n + 1e-5f);
+    for (int i = 0; i < n; i++) o[i] = w[i] * (r * x[i]);
+    return r;
+}
+
+// dx += ∂(w ⊙ x · r)/∂x · dy
+static void bp_rmsnorm_bwd(float *dx, const float *x, const float *w, float r,
+                           const float *dy, int n) {
+    float s = 0.0f;
+    for (int i = 0; i < n; i++) s += dy[i] * w[i] * x[i];
+    float c = r * r * r * s / (float)n;
+    for (int i = 0; i < n; i++) dx[i] += r * w[i] * dy[i] - c * x[i];
+}
+
+static const uint8_t *bp_w(const OitBpModel *m, int p, int l) {
+    const oo_lora_weight_t *wd = &m->proj.w[p];
+    return wd->base + (uint64_t)l * wd->layer_bytes;
+}
+
+// out = W·in (+ adapter), same kernels as inference
+static void bp_mm(const OitBpTrainer *t, float *out, const float *in, int p, int l) {
+    const oo_lora_weight_t *wd = &t->m->proj.w[p];
+    const oo_lora_adapter_t *a = &t->lora->layers[l][p];
+    if (wd->kind == OO_LORA_W_Q8_0)
+        oo_lora_matmul_q8_0(out, in, bp_w(t->m, p, l), wd->in_dim, wd->out_dim, a);
+    else
+        oo_lora_matmul_f32(out, in, (const float *)bp_w(t->m, p, l), wd->in_dim, wd->out_dim, a);
+}
+
+// du += Wᵀ·dy for a frozen [d × n] matrix (f32 or Q8_0 rows)
+static void bp_mmT_base(float *du, const float *dy, const void *w, uint8_t kind,
+                        uint64_t row_bytes, int n, int d) {
+    for (int j = 0; j < d; j++) {
+        float gj = dy[j];
+        if (gj == 0.0f) continue;
+        const uint8_t *row = (const uint8_t *)w + (uint64_t)j * row_bytes;
+        if (kind == OO_LORA_W_F32) {
+            bp_axpy(du, (const float *)row, gj, n);
+        } else {
+            for (int b = 0; b < n / 32; b++, row += 34) {
+                float c = gj * bp_fp16(row);
+                const int8_t *qs = (const int8_t *)(row + 2);
+                float *dst = du + b * 32;
+                for (int i = 0; i < 32; i++) dst[i] += c * (float)qs[i];
+            }
+        }
+    }
+}
+
+// Backward of out = W·u + s·B(A·u): du += Wᵀdy + s·Aᵀ(Bᵀdy), grads into A/B
+static void bp_mmT(const OitBpTrainer *t, float *grad, float *du, const float *dy,
+                   const float *u, int p, int l) {
+    const oo_lora_weight_t *wd = &t->m->proj.w[p];
+    int n = (int)wd->in_dim, d = (int)wd->out_dim;
+    uint64_t rb = (wd->kind == OO_LORA_W_F32) ? (uint64_t)n * 4u : (uint64_t)(n / 32) * 34u;
+    bp_mmT_base(du, dy, bp_w(t->m, p, l), wd->kind, rb, n, d);
+
+    const oo_lora_adapter_t *a = &t->lora->layers[l][p];
+    int r = (int)a->rank;
+    float ax[LORA_MAX_RANK], e[LORA_MAX_RANK];
+    for (int k = 0; k < r; k++) {
+        ax[k] = bp_dot(a->A + (uint64_t)k * n, u, n);
+        e[k] = 0.0f;
+    }
+    float *gB = grad + (a->B - t->param);
+    float *gA = grad + (a->A - t->param);
+    for (int j = 0; j < d; j++) {
+        float gj = dy[j];
+        if (gj == 0.0f) continue;
+        const float *bj = a->B + (uint64_t)j * r;
+        float *gbj = gB + (uint64_t)j * r;
+        for (int k = 0; k < r; k++) {
+            e[k] += bj[k] * gj;
+            gbj[k] += a->scale * gj * ax[k];
+        }
+    }
+    for (int k = 0; k < r; k++) {
+        float ek = a->scale * e[k];
+        if (ek == 0.0f) continue;
+        bp_axpy(gA + (uint64_t)k * n, u, ek, n);
+        bp_axpy(du, a->A + (uint64_t)k * n, ek, n);
+    }
+}
+
+static float bp_sigmoid(float z) { return 1.0f / (1.0f + bp_exp(-z)); }
+
+// ── Forward ───────────────────────────────────────────────────────────────
+
+// One layer over n tokens, in place on ws->x. cp != 0 captures activations.
+static void bp_layer_fwd(const OitBpTrainer *t, OitBpScratch *ws, int l, int n, const BpCap *cp) {
+    const OitBpModel *m = t->m;
+    const int D = m->dim, K = bp_kvd(m), H = m->hidden_dim, T = t->max_t;
+    const int hs = D / m->n_heads, kv_mul = m->n_heads / m->n_kv_heads;
+    const float inv = 1.0f / bp_sqrt((float)hs);
+    float *q = cp ? cp->q : ws->q, *k = cp ? cp->k : ws->k, *v = cp ? cp->v : ws->v;
+    float *o = cp ? cp->o : ws->o;
+
+    // attention RMSNorm + QKV
+    for (int i = 0; i < n; i++) {
+        float *x = ws->x + (uint64_t)i * D;
+        float *xb = cp ? cp->xb + (uint64_t)i * D : ws->xb;
+        if (cp) bp_copy(cp->xin + (uint64_t)i * D, x, D);
+        float r = bp_rmsnorm(xb, x, m->rms_att + (uint64_t)l * D, D);
+        if (cp) cp->ra[i] = r;
+        bp_mm(t, q + (uint64_t)i * D, xb, OO_LORA_WQ, l);
+        bp_mm(t, k + (uint64_t)i * K, xb, OO_LORA_WK, l);
+        bp_mm(t, v + (uint64_t)i * K, xb, OO_LORA_WV, l);
+        if (m->rope && m->rope->ready) {
+            llmk_rope_rotate(m->rope, q + (uint64_t)i * D, q + (uint64_t)i * D, m->n_heads, i);
+            llmk_rope_rotate(m->rope, k + (uint64_t)i * K, k + (uint64_t)i * K, m->n_kv_heads, i);
+        }
+    }
+
+    // causal attention
+    for (int h = 0; h < m->n_heads; h++) {
+        int kh = (h / kv_mul) * hs;
+        for (int i = 0; i < n; i++) {
+            float *a = cp ? cp->att + ((uint64_t)h * T + i) * T : ws->att;
+            const float *qi = q + (uint64_t)i * D + h * hs;
+            float mx = -3.0e38f, sum = 0.0f;
+            for (int s = 0; s <= i; s++) {
+                a[s] = bp_dot(qi, k + (uint64_t)s * K + kh, hs) * inv;
+                if (a[s] > mx) mx = a[s];
+            }
+            for (int s = 0; s <= i; s++) { a[s] = bp_exp(a[s] - mx); sum += a[s]; }
+            float rs = 1.0f / sum;
+            float *oi = o + (uint64_t)i * D + h * hs;
+            for (int j = 0; j < hs; j++) oi[j] = 0.0f;
+            for (int s = 0; s <= i; s++) {
+                a[s] *= rs;
+                bp_axpy(oi, v + (uint64_t)s * K + kh, a[s], hs);
+            }
+        }
+    }
+
+    // output projection + residual, FFN RMSNorm, SwiGLU FFN + residual
+    for (int i = 0; i < n; i++) {
+        float *x = ws->x + (uint64_t)i * D;
+        bp_mm(t, ws->tmp, o + (uint64_t)i * D, OO_LORA_WO, l);
+        for (int j = 0; j < D; j++) x[j] += ws->tmp[j];
+        if (cp) bp_copy(cp->xmid + (uint64_t)i * D, x, D);
+
+        float *xbf = cp ? cp->xbf + (uint64_t)i * D : ws->xb;
+        float r = bp_rmsnorm(xbf, x, m->rms_ffn + (uint64_t)l * D, D);
+        if (cp) cp->rf[i] = r;
+        float *h1 = cp ? cp->h1 + (uint64_t)i * H : ws->h1;
+        float *h3 = cp ? cp->h3 + (uint64_t)i * H : ws->h3;
+        float *g  = cp ? cp->g  + (uint64_t)i * H : ws->g;
+        bp_mm(t, h1, xbf, OO_LORA_W1, l);
+        bp_mm(t, h3, xbf, OO_LORA_W3, l);
+        for (int j = 0; j < H; j++) g[j] = h1[j] * bp_sigmoid(h1[j]) * h3[j];
+        bp_mm(t, ws->tmp, g, OO_LORA_W2, l);
+        for (int j = 0; j < D; j++) x[j] += ws->tmp[j];
+    }
+}
+
+static void bp_embed(const OitBpModel *m, float *x, int tok) {
+    const uint8_t *row = (const uint8_t *)m->tok_embd + (uint64_t)tok * m->tok_row_bytes;
+    if (m->tok_kind == OO_LORA_W_F32) {
+        bp_copy(x, (const float *)row, m->dim);
+        return;
+    }
+    for (int b = 0; b < m->dim / 32; b++, row += 34) {
+        float d = bp_fp16(row);
+        const int8_t *qs = (const int8_t *)(row + 2);
+        for (int i = 0; i < 32; i++) x[b * 32 + i] = d * (float)qs[i];
+    }
+}
+
+static void bp_logits(const OitBpModel *m, float *out, const float *xf) {
+    if (m->cls_kind == OO_LORA_W_Q8_0)
+        oo_lora_matmul_q8_0(out, xf, (const uint8_t *)m->wcls, (UINT32)m->dim, (UINT32)m->vocab_size, 0);
+    else
+        oo_lora_matmul_f32(out, xf, (const float *)m->wcls, (UINT32)m->dim, (UINT32)m->vocab_size, 0);
+}
+
+// Full step on one sequence. grad == 0 → forward only.
+// Returns the summed CE over the targets (*n_tgt of them), or -1.
+float oit_bp_run(const OitBpTrainer *t, OitBpScratch *ws, float *grad,
+                 const int *tok, int n, int ts, uint32_t *n_tgt) {
+    const OitBpModel *m = t->m;
+    const int D = m->dim, K = bp_kvd(m), L = m->n_layers, V = m->vocab_size;
+    const int N = t->n_train, T = t->max_t;
+    *n_tgt = 0;
+    if (!t->ready || !tok || n < 2 || n > T || ts < 1 || ts >= n) return -1.0f;
+    if (t->lora->merged) return -1.0f;   // weights already hold ΔW
+    for (int i = 0; i < n; i++) if (tok[i] < 0 || tok[i] >= V) return -1.0f;
+
+    for (int i = 0; i < n; i++) bp_embed(m, ws->x + (uint64_t)i * D, tok[i]);
+    for (int l = 0; l < L; l++) {
+        BpCap cp;
+        int c = l - (L - N);
+        if (grad && c >= 0) bp_cap_at(m, T, ws->cap, c, &cp);
+        bp_layer_fwd(t, ws, l, n, (grad && c >= 0) ? &cp : 0);
+    }
+
+    // final norm + classifier + CE on positions ts-1 .. n-2 (predict ts .. n-1)
+    float loss = 0.0f;
+    if (grad) bp_zero(ws->dx, (uint64_t)n * D);
+    for (int i = ts - 1; i < n - 1; i++) {
+        float *x = ws->x + (uint64_t)i * D, *xf = ws->xf + (uint64_t)i * D;
+        ws->rf[i] = bp_rmsnorm(xf, x, m->rms_final, D);
+        bp_logits(m, ws->logit, xf);
+        float mx = ws->logit[0], sum = 0.0f;
+        for (int j = 1; j < V; j++) if (ws->logit[j] > mx) mx = ws->logit[j];
+        for (int j = 0; j < V; j++) { ws->logit[j] = bp_exp(ws->logit[j] - mx); sum += ws->logit[j]; }
+        int y = tok[i + 1];
+        loss += bp_log(sum) - bp_log(ws->logit[y] > 1e-30f ? ws->logit[y] : 1e-30f);
+        (*n_tgt)++;
+        if (!grad) continue;
+
+        // dlogit = softmax - onehot; dxf = Wclsᵀ·dlogit; dx = rmsnorm_bwd
+        float rs = 1.0f / sum;
+        for (int j = 0; j < V; j++) ws->logit[j] *= rs;
+        ws->logit[y] -= 1.0f;
+        bp_zero(ws->dxf, D);
+        uint64_t rb = (m->cls_kind == OO_LORA_W_F32) ? (uint64_t)D * 4u : (uint64_t)(D / 32) * 34u;
+        bp_mmT_base(ws->dxf, ws->logit, m->wcls, m->cls_kind, rb, D, V);
+        bp_rmsnorm_bwd(ws->dx + (uint64_t)i * D, x, m->rms_final, ws->rf[i], ws->dxf, D);
+    }
+    if (!grad) return loss;
+
+    // backward through the captured layers, top down
+    const int H = m->hidden_dim, hs = D / m->n_heads, kv_mul = m->n_heads / m->n_kv_heads;
+    const float inv = 1.0f / bp_sqrt((float)hs);
+    for (int c = N - 1; c >= 0; c--) {
+        int l = L - N + c;
+        BpCap cp;
+        bp_cap_at(m, T, ws->cap, c, &cp);
+
+        // FFN: x_out = x_mid + W2·(silu(W1·xbf) ⊙ W3·xbf)
+        for (int i = 0; i < n; i++) {
+            float *dx = ws->dx + (uint64_t)i * D;
+            const float *h1 = cp.h1 + (uint64_t)i * H, *h3 = cp.h3 + (uint64_t)i * H;
+            const float *xbf = cp.xbf + (uint64_t)i * D;
+            bp_zero(ws->dg, H);
+            bp_mmT(t, grad, ws->dg, dx, cp.g + (uint64_t)i * H, OO_LORA_W2, l);
+            for (int j = 0; j < H; j++) {
+                float sg = bp_sigmoid(h1[j]);
+                ws->dh3[j] = ws->dg[j] * h1[j] * sg;
+                ws->dh1[j] = ws->dg[j] * h3[j] * sg * (1.0f + h1[j] * (1.0f - sg));
+            }
+            bp_zero(ws->dxb, D);
+            bp_mmT(t, grad, ws->dxb, ws->dh1, xbf, OO_LORA_W1, l);
+            bp_mmT(t, grad, ws->dxb, ws->dh3, xbf, OO_LORA_W3, l);
+            bp_rmsnorm_bwd(dx, cp.xmid + (uint64_t)i * D, m->rms_ffn + (uint64_t)l * D,
+                           cp.rf[i], ws->dxb, D);
+        }
+
+        // attention output projection
+        bp_zero(ws->dout, (uint64_t)n * D);
+        for (int i = 0; i < n; i++)
+            bp_mmT(t, grad, ws->dout + (uint64_t)i * D, ws->dx + (uint64_t)i * D,
+                   cp.o + (uint64_t)i * D, OO_LORA_WO, l);
+
+        // softmax attention
+        bp_zero(ws->dq, (uint64_t)n * D);
+        bp_zero(ws->dk, (uint64_t)n * K);
+        bp_zero(ws->dv, (uint64_t)n * K);
+        for (int h = 0; h < m->n_heads; h++) {
+            int kh = (h / kv_mul) * hs;
+            for (int i = 0; i < n; i++) {
+                const float *a = cp.att + ((uint64_t)h * T + i) * T;
+                const float *doi = ws->dout + (uint64_t)i * D + h * hs;
+                const float *qi = cp.q + (uint64_t)i * D + h * hs;
+                float *dqi = ws->dq + (uint64_t)i * D + h * hs;
+                float *da = ws->tmp;   // [i+1]
+                float dot = 0.0f;
+                for (int s = 0; s <= i; s++) {
+                    da[s] = bp_dot(doi, cp.v + (uint64_t)s * K + kh, hs);
+                    dot += a[s] * da[s];
+                    bp_axpy(ws->dv + (uint64_t)s * K + kh, doi, a[s], hs);
+                }
+                for (int s = 0; s <= i; s++) {
+                    float ds = a[s] * (da[s] - dot) * inv;
+                    if (ds == 0.0f) continue;
+                    bp_axpy(dqi, cp.k + (uint64_t)s * K + kh, ds, hs);
+                    bp_axpy(ws->dk + (uint64_t)s * K + kh, qi, ds, hs);
+                }
+            }
+        }
+
+        // QKV + attention RMSNorm + residual
+        for (int i = 0; i < n; i++) {
+            const float *xb = cp.xb + (uint64_t)i * D;
+            bp_zero(ws->dxb, D);
+            if (m->rope && m->rope->ready) {
+                // q/k were rotated after the projection: pull the gradient back through Rᵀ
+                llmk_rope_rotate_T(m->rope, ws->dq + (uint64_t)i * D, ws->dq + (uint64_t)i * D, m->n_heads, i);
+                llmk_rope_rotate_T(m->rope, ws->dk + (uint64_t)i * K, ws->dk + (uint64_t)i * K, m->n_kv_heads, i);
+            }
+            bp_mmT(t, grad, ws->dxb, ws->dq + (uint64_t)i * D, xb, OO_LORA_WQ, l);
+            bp_mmT(t, grad, ws->dxb, ws->dk + (uint64_t)i * K, xb, OO_LORA_WK, l);
+            bp_mmT(t, grad, ws->dxb, ws->dv + (uint64_t)i * K, xb, OO_LORA_WV, l);
+            bp_rmsnorm_bwd(ws->dx + (uint64_t)i * D, cp.xin + (uint64_t)i * D,
+                           m->rms_att + (uint64_t)l * D, cp.ra[i], ws->dxb, D);
+        }
+    }
+    return loss;
+}
+
+// ── Public API ────────────────────────────────────────────────────────────
+
+static uint64_t bp_n_param(const OitBpModel *m, int n_train, int rank) {
+    uint64_t per = 0;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        per += (uint64_t)(m->proj.w[p].in_dim + m->proj.w[p].out_dim) * (uint64_t)rank;
+    return per * (uint64_t)n_train;
+}
+
+uint64_t oit_bp_bytes(const OitBpModel *m, int n_train, int max_t) {
+    if (!m || n_train < 1 || n_train > m->n_layers || max_t < 2) return 0;
+    uint64_t np = bp_al(bp_n_param(m, n_train, LORA_MAX_RANK));
+    return (bp_scratch_layout(m, n_train, max_t, 0, 0) + 3 * np) * sizeof(float);
+}
+
+int oit_bp_init(OitBpTrainer *t, const OitBpModel *m, oo_lora_state_t *lora,
+                int n_train, int max_t, void *arena, uint64_t arena_bytes) {
+    if (!t || !m || !lora || !arena) return -1;
+    for (uint64_t i = 0; i < sizeof(*t); i++) ((uint8_t *)t)[i] = 0;
+    if (n_train < 1 || n_train > m->n_layers || max_t < 2 || max_t > OIT_BP_SEQ_MAX ||
+        max_t > m->seq_len)
+        return -1;
+    if ((uint32_t)m->n_layers != lora->n_layers || (uint32_t)m->n_layers != m->proj.n_layers)
+        return -2;
+
+    // Adapters of the trained layers must match the model and be the arena tail
+    int L0 = m->n_layers - n_train;
+    float *first = lora->layers[L0][0].A, *end = lora->mem + lora->mem_floats;
+    for (int l = L0; l < m->n_layers; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            const oo_lora_adapter_t *a = &lora->layers[l][p];
+            if (!a->rank || a->in_dim != m->proj.w[p].in_dim || a->out_dim != m->proj.w[p].out_dim)
+                return -2;
+            if (a->A < first || a->B + (uint64_t)a->out_dim * a->rank > end) return -2;
+        }
+    if (m->dim % m->n_heads || m->n_heads % m->n_kv_heads) return -2;
+
+    uint64_t np = (uint64_t)(end - first);
+    uint64_t need = (bp_scratch_layout(m, n_train, max_t, 0, 0) + 3 * bp_al(np)) * sizeof(float);
+    if (arena_bytes < need || np > 0xFFFFFFFFull) return -3;
+
+    float *cur = (float *)arena;
+    uint64_t used = 0;
+    t->grad   = bp_take(&cur, &used, np);
+    t->adam_m = bp_take(&cur, &used, np);
+    t->adam_v = bp_take(&cur, &used, np);
+    bp_scratch_layout(m, n_train, max_t, &t->ws, cur);
+    bp_zero(t->grad, np);
+    bp_zero(t->adam_m, np);
+    bp_zero(t->adam_v, np);
+
+    t->m = m;
+    t->lora = lora;
+    t->n_train = n_train;
+    t->max_t = max_t;
+    t->param = first;
+    t->n_param = (uint32_t)np;
+    t->lr = OIT_BP_LR;
+    t->beta1 = OIT_BP_BETA1;
+    t->beta2 = OIT_BP_BETA2;
+    t->eps = OIT_BP_EPS;
+    t->wd = OIT_BP_WD;
+    t->clip = OIT_BP_CLIP;
+    t->b1t = 1.0f;
+    t->b2t = 1.0f;
+    t->accum = 1;
+    t->ready = 1;
+    return 0;
+}
+
+uint64_t oit_bp_worker_bytes(const OitBpTrainer *t) {
+    if (!t || !t->ready) return 0;
+    return (bp_scratch_layout(t->m, t->n_train, t->max_t, 0, 0) + bp_al(t->n_param)) * sizeof(float);
+}
+
+int oit_bp_worker_init(const OitBpTrainer *t, OitBpScratch *ws, float **grad,
+                       void *arena, uint64_t arena_bytes) {
+    if (!t || !t->ready || !ws || !grad || !arena) return -1;
+    if (arena_bytes < oit_bp_worker_bytes(t)) return -3;
+    float *cur = (float *)arena;
+    uint64_t used = 0;
+    *grad = bp_take(&cur, &used, t->n_param);
+    bp_scratch_layout(t->m, t->n_train, t->max_t, ws, cur);
+    bp_zero(*grad, t->n_param);
+    return 0;
+}
+
+float oit_bp_sample(OitBpTrainer *t, const int *tokens, int n, int target_start) {
+    if (!t || !t->ready) return -1.0f;
+    uint32_t nt;
+    float loss = oit_bp_run(t, &t->ws, t->grad, tokens, n, target_start, &nt);
+    if (loss < 0.0f || nt == 0) return -1.0f;
+    t->tokens_acc += nt;
+    return loss / (float)nt;
+}
+
+float oit_bp_loss(OitBpTrainer *t, const int *tokens, int n, int target_start) {
+    if (!t || !t->ready) return -1.0f;
+    uint32_t nt;
+    float loss = oit_bp_run(t, &t->ws, 0, tokens, n, target_start, &nt);
+    return (loss < 0.0f || nt == 0) ? -1.0f : loss / (float)nt;
+}
+
+void oit_bp_apply(OitBpTrainer *t) {
+    if (!t || !t->ready || t->tokens_acc == 0 || t->lora->merged) return;
+    float scale = 1.0f / (float)t->tokens_acc;
+    if (t->clip > 0.0f) {
+        float ss = 0.0f;
+        for (uint32_t i = 0; i < t->n_param; i++) ss += t->grad[i] * t->grad[i];
+        float norm = bp_sqrt(ss) * scale;
+        if (norm > t->clip) scale *= t->clip / norm;
+    }
+    t->b1t *= t->beta1;
+    t->b2t *= t->beta2;
+    const float c1 = 1.0f / (1.0f - t->b1t), c2 = 1.0f / (1.0f - t->b2t);
+    const float b1 = t->beta1, b2 = t->beta2, lr = t->lr;
+    for (uint32_t i = 0; i < t->n_param; i++) {
+        float g = t->grad[i] * scale;
+        float mi = t->adam_m[i] = b1 * t->adam_m[i] + (1.0f - b1) * g;
+        float vi = t->adam_v[i] = b2 * t->adam_v[i] + (1.0f - b2) * g * g;
+        float p = t->param[i];
+        t->param[i] = p - lr * ((mi * c1) / (bp_sqrt(vi * c2) + t->eps) + t->wd * p);
+        t->grad[i] = 0.0f;
+    }
+    t->tokens_acc = 0;
+    t->accum_n = 0;
+    t->steps++;
+    t->lora->step_count++;
+    t->lora->dirty = 1;
+}
+
+float oit_bp_minibatch(OitBpTrainer *t, const int *const *tokens, const int *n,
+                       const int *target_start, int count) {
+    if (!t || !t->ready || !tokens || count <= 0) return -1.0f;
+    float sum = 0.0f;
+    uint32_t nt_all = 0;
+    for (int s = 0; s < count; s++) {
+        uint32_t nt;
+        float l = oit_bp_run(t, &t->ws, t->grad, tokens[s], n[s], target_start[s], &nt);
+        if (l < 0.0f || nt == 0) continue;
+        sum += l;
+        nt_all += nt;
+    }
+    if (nt_all == 0) return -1.0f;
+    t->tokens_acc += nt_all;
+    t->last_loss = sum / (float)nt_all;
+    if (++t->accum_n >= t->accum) oit_bp_apply(t);
+    return t->last_loss;
+}
@@ -0,0 +1,138 @@
+// oo_insitu_backprop.h — Gradient-based in-situ LoRA fine-tuning
+//
+// Real training step for the oo_lora adapters, run inside the bare-metal
+// environment against the loaded model:
+//
+//   1. Sequence forward, layer-major over T tokens, mirroring
+//      transformer_forward (RMSNorm, RoPE, GQA causal attention, SwiGLU) with
+//      the adapter fused into every projection. The frozen lower layers are run
+//      without capture; the last N layers save their activations.
+//   2. Cross-entropy on the target span (the "output" half of a pair).
+//   3. Backward through the classifier, the final RMSNorm and the last N
+//      layers (FFN, attention, both RMSNorms, residuals). Base weights are
+//      frozen; only A/B of the adapted projections receive gradients.
+//   4. Minibatch + gradient accumulation, then AdamW on the adapter.
+//
+// Everything lives in one caller-provided training arena sized by
+// oit_bp_bytes() — no malloc. Base weights may be f32 or Q8_0 (the same
+// oo_lora_model_t descriptor used for merge/unmerge).
+//
+// The trainable parameters of layers [L-N, L) are a contiguous tail of the
+// oo_lora arena (oo_lora_init packs layer by layer), so gradients and the
+// Adam moments are flat arrays parallel to that tail.
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+#include "../self_improve/oo_lora.h"
+#include "../llama2/llmk_rope.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ── Constants ─────────────────────────────────────────────────────────────
+
+#define OIT_BP_SEQ_MAX      512     // tokens per training sample
+#define OIT_BP_LR           1e-3f
+#define OIT_BP_BETA1        0.9f
+#define OIT_BP_BETA2        0.999f
+#define OIT_BP_EPS          1e-8f
+#define OIT_BP_WD           0.0f    // decoupled weight decay (AdamW)
+#define OIT_BP_CLIP         1.0f    // global grad-norm clip (0 = off)
+
+// ── Frozen base model (built by the caller from TransformerWeights) ──────
+
+typedef struct {
+    int dim, hidden_dim, n_layers, n_heads, n_kv_heads, vocab_size, seq_len;
+    const void  *tok_embd;        // [vocab][dim], f32 or Q8_0 rows
+    uint64_t     tok_row_bytes;
+    uint8_t      tok_kind;        // OO_LORA_W_F32 / OO_LORA_W_Q8_0
+    const float *rms_att;         // [layers][dim]
+    const float *rms_ffn;         // [layers][dim]
+    const float *rms_final;       // [dim]
+    const void  *wcls;            // [vocab][dim]
+    uint8_t      cls_kind;
+    oo_lora_model_t proj;         // Wq Wk Wv Wo W1 W2 W3
+    const LlmkRope *rope;         // q/k rotation by position (0 or not ready = none)
+} OitBpModel;
+
+// ── Scratch for one sample (activations + backward temporaries) ──────────
+
+typedef struct {
+    float *x;                     // [T][dim] residual stream
+    float *xb, *q, *k, *v, *o, *h1, *h3, *g, *att;   // frozen-layer temps
+    float *cap;                   // captured layers (see oo_insitu_backprop.c)
+    float *xf, *rf;               // final norm output / inverse rms
+    float *logit;                 // [vocab]
+    float *dx, *dxb, *dq, *dk, *dv, *dout, *dh1, *dh3, *dg, *dxf;
+    float *tmp;                   // [max(dim, hidden, T)]
+} OitBpScratch;
+
+// ── Trainer ──────────────────────────────────────────────────────────────
+
+typedef struct {
+    const OitBpModel *m;
+    oo_lora_state_t  *lora;
+    int       n_train;            // trainable layers (last N)
+    int       max_t;              // tokens per sample
+    float    *param;              // first trainable float in lora->mem
+    uint32_t  n_param;
+    float    *grad, *adam_m, *adam_v;
+    OitBpScratch ws;
+
+    float     lr, beta1, beta2, eps, wd, clip;
+    float     b1t, b2t;           // beta^step for bias correction
+    int       accum;              // minibatches per optimizer step
+    int       accum_n;            // minibatches accumulated so far
+    uint32_t  tokens_acc;         // target tokens behind the current grad
+    uint32_t  steps;
+    float     last_loss;
+    int       ready;
+} OitBpTrainer;
+
+// Tokenizer hook: fills out[] with token ids (the tokenizer's BOS first when
+// add_bos and it has one), returns count
+typedef int (*OitEncodeFn)(void *ctx, const char *text, int add_bos, int *out, int max);
+
+// ── Public API ────────────────────────────────────────────────────────────
+
+uint64_t oit_bp_bytes(const OitBpModel *m, int n_train, int max_t);
+
+// lora must be oo_lora_init'ed for all m->n_layers layers.
+// Returns 0, or <0 on geometry mismatch / short arena.
+int   oit_bp_init(OitBpTrainer *t, const OitBpModel *m, oo_lora_state_t *lora,
+                  int n_train, int max_t, void *arena, uint64_t arena_bytes);
+
+// Forward + backward on one sequence; tokens[target_start..n) are the
+// targets. Adds the summed gradient to t->grad and returns the mean loss.
+float oit_bp_sample(OitBpTrainer *t, const int *tokens, int n, int target_start);
+
+// Forward only (mean CE over the target span) — evaluation
+float oit_bp_loss(OitBpTrainer *t, const int *tokens, int n, int target_start);
+
+// Reentrant core: one sequence against (ws, grad) that the caller owns.
+// Reads the trainer and the adapter only, so several workers may run it at
+// once with private scratch/gradients (oo_insitu_parallel.h). grad = 0 is
+// forward only. Returns the summed CE over *n_tgt targets, or -1.
+float oit_bp_run(const OitBpTrainer *t, OitBpScratch *ws, float *grad,
+                 const int *tokens, int n, int target_start, uint32_t *n_tgt);
+
+// Private scratch + gradient (parallel to t->param) for an extra worker
+uint64_t oit_bp_worker_bytes(const OitBpTrainer *t);
+int   oit_bp_worker_init(const OitBpTrainer *t, OitBpScratch *ws, float **grad,
+                         void *arena, uint64_t arena_bytes);
+
+// AdamW on the accumulated gradient (mean over target tokens), then clear.
+void  oit_bp_apply(OitBpTrainer *t);
+
+// One minibatch: every sample accumulates, the optimizer runs once per
+// t->accum minibatches. Returns the token-weighted mean loss.
+float oit_bp_minibatch(OitBpTrainer *t, const int *const *tokens, const int *n,
+                       const int *target_start, int count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,323 @@
+// oo_insitu_dream.c — Model-driven dream consolidation into the LoRA adapter
+//
+// Phases and ownership are described in oo_insitu_dream.h. Scoring jobs go
+// through oo_mc_submit like the oo_insitu_parallel shards, so the same file
+// runs on APs in the UEFI build and on pthreads in the host harness
+// (tests/test_oo_insitu_dream.c).
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "oo_insitu_dream.h"
+
+static uint64_t dream_align(uint64_t b) { return (b + 63u) & ~(uint64_t)63u; }
+
+static void dream_copy(float *dst, const float *src, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) dst[i] = src[i];
+}
+
+static uint32_t dream_fnv(uint32_t h, const char *s) {
+    for (; *s; s++) { h ^= (uint8_t)*s; h *= 16777619u; }
+    return h;
+}
+
+// ── Scoring job (AP): mean response NLL of every turn ────────────────────
+
+static void dream_score_job(void *arg, int core) {
+    (void)core;
+    OitDreamJob *j = (OitDreamJob *)arg;
+    OitDream *d = j->d;
+    const int T = d->t->max_t;
+    for (int i = 0; i < d->count; i++) {
+        OitDreamItem *it = &d->item[i];
+        float *out = j->after ? &it->nll_after : &it->nll;
+        uint32_t nt = 0;
+        float l = oit_bp_run(d->t, &d->ws, 0, d->tok + (uint64_t)i * T, it->n, it->ts, &nt);
+        *out = (l >= 0.0f && nt > 0) ? l / (float)nt : -1.0f;
+    }
+    oo_mc_barrier();
+    d->job_done = 1;
+}
+
+static void dream_submit_score(OitDream *d, int after) {
+    d->job.d = d;
+    d->job.after = after;
+    d->job_done = 0;
+    oo_mc_barrier();
+    if (d->mc) oo_mc_submit(d->mc, dream_score_job, &d->job);
+    else dream_score_job(&d->job, 0);
+}
+
+static void dream_wait_job(OitDream *d) {
+    while (!d->job_done) {
+        if (!(d->mc && oo_mc_run_one(d->mc, d->mc->bsp_idx))) oo_mc_pause();
+    }
+    oo_mc_barrier();
+}
+
+// Target-token weighted mean NLL over the picked or the held turns
+static float dream_mean(const OitDream *d, int held, int after) {
+    float acc = 0.0f;
+    int w = 0;
+    for (int i = 0; i < d->count; i++) {
+        const OitDreamItem *it = &d->item[i];
+        if (held ? !it->held : !it->picked) continue;
+        float v = after ? it->nll_after : it->nll;
+        if (v < 0.0f) continue;
+        acc += v * (float)(it->n - it->ts);
+        w += it->n - it->ts;
+    }
+    return w ? acc / (float)w : 0.0f;
+}
+
+// ── Adapter snapshot ──────────────────────────────────────────────────────
+
+static void dream_snapshot(OitDream *d) {
+    OitBpTrainer *t = d->t;
+    dream_copy(d->snap, t->param, t->n_param);
+    dream_copy(d->snap + t->n_param, t->adam_m, t->n_param);
+    dream_copy(d->snap + 2u * t->n_param, t->adam_v, t->n_param);
+    d->snap_steps = t->steps;
+    d->snap_b1t = t->b1t;
+    d->snap_b2t = t->b2t;
+}
+
+static void dream_rollback(OitDream *d) {
+    OitBpTrainer *t = d->t;
+    dream_copy(t->param, d->snap, t->n_param);
+    dream_copy(t->adam_m, d->snap + t->n_param, t->n_param);
+    dream_copy(t->adam_v, d->snap + 2u * t->n_param, t->n_param);
+    for (uint32_t i = 0; i < t->n_param; i++) t->grad[i] = 0.0f;
+    t->steps = d->snap_steps;
+    t->b1t = d->snap_b1t;
+    t->b2t = d->snap_b2t;
+    t->accum_n = 0;
+    t->tokens_acc = 0;
+}
+
+// ── Phase steps (BSP) ────────────────────────────────────────────────────
+
+// SCORE → TRAIN: rank the non-held turns by prior · NLL
+static void dream_select(OitDream *d) {
+    d->n_sel = 0;
+    for (int i = 0; i < d->count; i++) {
+        OitDreamItem *it = &d->item[i];
+        it->picked = 0;
+        it->value = (it->nll >= OIT_DREAM_MIN_NLL && !it->held) ? it->prior * it->nll : 0.0f;
+        if (it->value <= 0.0f) continue;
+        // insertion into sel[], kept sorted by value (descending)
+        int k;
+        if (d->n_sel < OIT_DREAM_SELECT) k = d->n_sel++;
+        else if (d->item[d->sel[OIT_DREAM_SELECT - 1]].value >= it->value) continue;
+        else k = OIT_DREAM_SELECT - 1;
+        while (k > 0 && d->item[d->sel[k - 1]].value < it->value) {
+            d->sel[k] = d->sel[k - 1];
+            k--;
+        }
+        d->sel[k] = i;
+    }
+    for (int s = 0; s < d->n_sel; s++) d->item[d->sel[s]].picked = 1;
+    d->sel_before = dream_mean(d, 0, 0);
+    d->held_before = dream_mean(d, 1, 0);
+}
+
+// One optimizer step over the next OIT_DREAM_BATCH consolidation samples
+static void dream_train_step(OitDream *d) {
+    const int T = d->t->max_t;
+    const int *seq[OIT_DREAM_BATCH];
+    int n[OIT_DREAM_BATCH], ts[OIT_DREAM_BATCH];
+    int m = 0;
+    for (; m < OIT_DREAM_BATCH && m < d->n_sel; m++) {
+        int i = d->sel[d->cursor];
+        d->cursor = (d->cursor + 1) % d->n_sel;
+        seq[m] = d->tok + (uint64_t)i * T;
+        n[m] = d->item[i].n;
+        ts[m] = d->item[i].ts;
+    }
+    if (d->par) {
+        // AdamW lands on a later oit_par_poll; a refused step ends TRAIN
+        if (oit_par_begin(d->par, seq, n, ts, m) == 0) d->max_steps = d->steps;
+    } else {
+        oit_bp_minibatch(d->t, seq, n, ts, m);
+        d->steps++;
+    }
+}
+
+static int dream_train_over(OitDream *d) {
+    // The idle loop may poll the scheduler itself, so count its steps
+    if (d->par) d->steps = (int)(d->par->steps - d->par_steps0);
+    if (d->steps >= d->max_steps) return 1;
+    return d->budget_cycles && oo_mc_rdtsc() - d->t_train >= d->budget_cycles;
+}
+
+// EVAL → DONE
+static void dream_decide(OitDream *d) {
+    d->sel_after = dream_mean(d, 0, 1);
+    d->held_after = dream_mean(d, 1, 1);
+    int ok = d->held_after == d->held_after &&            // not NaN
+             d->held_after <= d->held_before * (1.0f + d->tol);
+    if (!ok) dream_rollback(d);
+    d->last_accepted = ok;
+    if (ok) d->accepted++;
+    else d->rejected++;
+    d->cycles++;
+    d->last_cycles = oo_mc_rdtsc() - d->t_begin;
+    d->phase = OIT_DREAM_DONE;
+}
+
+// ── Public API ────────────────────────────────────────────────────────────
+
+uint64_t oit_dream_bytes(const OitBpTrainer *t) {
+    if (!t || !t->ready) return 0;
+    return dream_align((uint64_t)OIT_DREAM_POOL * (uint64_t)t->max_t * sizeof(int)) +
+           dream_align(3ull * t->n_param * sizeof(float)) +
+           dream_align(oit_bp_worker_bytes(t));
+}
+
+int oit_dream_init(OitDream *d, OitBpTrainer *t, OitParallel *par, OoMulticoreCtx *mc,
+                   OitEncodeFn encode, void *encode_ctx, void *arena, uint64_t arena_bytes) {
+    if (!d || !t || !encode || !arena) return -1;
+    for (uint64_t i = 0; i < sizeof(*d); i++) ((uint8_t *)d)[i] = 0;
+    uint64_t need = oit_dream_bytes(t);
+    if (!need) return -1;
+    if (arena_bytes < need) return -3;
+    if (par && par->t != t) return -2;
+
+    uint8_t *cur = (uint8_t *)arena;
+    d->tok = (int *)cur;
+    cur += dream_align((uint64_t)OIT_DREAM_POOL * (uint64_t)t->max_t * sizeof(int));
+    d->snap = (float *)cur;
+    cur += dream_align(3ull * t->n_param * sizeof(float));
+    if (oit_bp_worker_init(t, &d->ws, &d->ws_grad, cur, dream_align(oit_bp_worker_bytes(t))) != 0)
+        return -3;
+
+    d->t = t;
+    d->par = par;
+    d->mc = mc;
+    d->encode = encode;
+    d->encode_ctx = encode_ctx;
+    d->tol = OIT_DREAM_TOL;
+    d->phase = OIT_DREAM_IDLE;
+    d->ready = 1;
+    return 0;
+}
+
+int oit_dream_busy(const OitDream *d) {
+    return d && d->phase != OIT_DREAM_IDLE && d->phase != OIT_DREAM_DONE;
+}
+
+void oit_dream_reset(OitDream *d) {
+    if (!d || oit_dream_busy(d)) return;
+    d->count = 0;
+    d->n_sel = 0;
+    d->n_held = 0;
+    d->phase = OIT_DREAM_IDLE;
+}
+
+int oit_dream_add(OitDream *d, const char *prompt, const char *response, float prior) {
+    if (!d || !d->ready || !prompt || !response || oit_dream_busy(d)) return 0;
+    if (d->count >= OIT_DREAM_POOL || !(prior > 0.0f)) return 0;
+
+    // Same sample layout as oit_train_batch: [BOS] prompt | response (no BOS)
+    const int cap = d->t->max_t;
+    int *t = d->tok + (uint64_t)d->count * cap;
+    int ni = d->encode(d->encode_ctx, prompt, 1, t, cap);
+    if (ni <= 0 || ni >= cap) return 0;
+    int no = d->encode(d->encode_ctx, response, 0, t + ni, cap - ni);
+    if (no <= 0) return 0;
+
+    OitDreamItem *it = &d->item[d->count];
+    it->n = ni + no;
+    it->ts = ni;
+    it->hash = dream_fnv(dream_fnv(2166136261u, prompt) ^ 0x0Au, response);
+    it->prior = prior;
+    it->nll = it->nll_after = -1.0f;
+    it->value = 0.0f;
+    it->held = (uint8_t)(it->hash % OIT_DREAM_HOLDOUT_EVERY == 0);
+    it->picked = 0;
+    d->n_held += it->held;
+    d->count++;
+    return 1;
+}
+
+int oit_dream_begin(OitDream *d, int max_steps, uint64_t budget_cycles) {
+    if (!d || !d->ready || oit_dream_busy(d)) return -1;
+    if (!d->t->ready || d->t->lora->merged) return -2;
+    if (d->par && oit_par_busy(d->par)) return -2;
+    if (d->count < 2) return -3;
+
+    // Both sets must be non-empty: hold out the oldest turn, or release one
+    if (d->n_held == 0) {
+        d->item[0].held = 1;
+        d->n_held = 1;
+    } else if (d->n_held == d->count) {
+        d->item[d->count - 1].held = 0;
+        d->n_held--;
+    }
+
+    d->max_steps = max_steps > 0 ? max_steps : OIT_DREAM_STEPS;
+    d->budget_cycles = budget_cycles;
+    d->steps = 0;
+    d->cursor = 0;
+    d->n_sel = 0;
+    d->last_accepted = 0;
+    d->t_begin = oo_mc_rdtsc();
+    d->phase = OIT_DREAM_SCORE;
+    dream_submit_score(d, 0);
+    return 0;
+}
+
+int oit_dream_poll(OitDream *d) {
+    if (!d) return 0;
+    switch (d->phase) {
+        case OIT_DREAM_SCORE:
+            if (!d->job_done) return 0;
+            oo_mc_barrier();
+            dream_select(d);
+            if (d->n_sel == 0) {
+                // Nothing left to learn: the adapter is untouched
+                for (int i = 0; i < d->count; i++) d->item[i].nll_after = d->item[i].nll;
+                d->sel_after = d->sel_before;
+                d->held_after = d->held_before;
+                d->last_accepted = 0;
+                d->cycles++;
+                d->last_cycles = oo_mc_rdtsc() - d->t_begin;
+                d->phase = OIT_DREAM_DONE;
+                return 1;
+            }
+            dream_snapshot(d);
+            d->t_train = oo_mc_rdtsc();
+            if (d->par) d->par_steps0 = d->par->steps;
+            d->phase = OIT_DREAM_TRAIN;
+            return 0;
+
+        case OIT_DREAM_TRAIN:
+            if (d->par && oit_par_busy(d->par)) {
+                oit_par_poll(d->par);
+                return 0;
+            }
+            if (!dream_train_over(d)) {
+                dream_train_step(d);
+                return 0;
+            }
+            d->phase = OIT_DREAM_EVAL;
+            dream_submit_score(d, 1);
+            return 0;
+
+        case OIT_DREAM_EVAL:
+            if (!d->job_done) return 0;
+            oo_mc_barrier();
+            dream_decide(d);
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+void oit_dream_cancel(OitDream *d) {
+    if (!oit_dream_busy(d)) return;
+    if (d->phase == OIT_DREAM_SCORE || d->phase == OIT_DREAM_EVAL) dream_wait_job(d);
+    if (d->par && oit_par_busy(d->par)) oit_par_wait(d->par);
+    if (d->phase != OIT_DREAM_SCORE) dream_rollback(d);
+    d->phase = OIT_DREAM_IDLE;
+}
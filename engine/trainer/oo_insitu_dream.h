@@ -0,0 +1,155 @@
+// oo_insitu_dream.h — Model-driven dream consolidation into the LoRA adapter
+//
+// While the REPL is idle, replay recent high-value turns (journal replay
+// ring + SMB) through the model and distill them into the oo_lora adapter
+// with the backprop trainer (oo_insitu_backprop.h):
+//
+//   1. COLLECT (BSP)  the caller adds (prompt, response, prior) turns; each
+//                     is tokenized once. Every OIT_DREAM_HOLDOUT_EVERY-th
+//                     turn (by text hash) is held out as the replay set.
+//   2. SCORE   (AP)   one forward per turn with the current adapter: mean
+//                     NLL of the response span = how much the model still
+//                     has to learn. value = prior · NLL; the top
+//                     OIT_DREAM_SELECT non-held turns form the
+//                     consolidation set.
+//   3. TRAIN          up to max_steps optimizer steps over the consolidation
+//                     set, within a TSC cycle budget. With an OitParallel
+//                     attached the steps run as AP shards and AdamW lands on
+//                     the BSP in oit_dream_poll; otherwise inline.
+//   4. EVAL    (AP)   rescore the consolidation and replay sets.
+//   5. DECIDE  (BSP)  if the replay-set loss rose by more than tol
+//                     (relative), restore the adapter and Adam state from
+//                     the snapshot taken before TRAIN; else keep it.
+//
+// Every phase is driven by oit_dream_poll() from the key-wait loop, so each
+// call does at most one step of BSP work. Only the BSP writes the adapter
+// (AdamW, rollback); AP jobs read it.
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+#include "oo_insitu_backprop.h"
+#include "oo_insitu_parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ── Constants ─────────────────────────────────────────────────────────────
+
+#define OIT_DREAM_POOL          32      // candidate turns per cycle
+#define OIT_DREAM_SELECT        12      // consolidation set size
+#define OIT_DREAM_HOLDOUT_EVERY 4       // 1 in N turns is held out for replay
+#define OIT_DREAM_BATCH         4       // samples per optimizer step
+#define OIT_DREAM_STEPS         24      // default step budget per cycle
+#define OIT_DREAM_TOL           0.01f   // replay loss may rise 1% before reject
+#define OIT_DREAM_MIN_NLL       0.05f   // turns the model already knows are skipped
+
+#define OIT_DREAM_IDLE          0
+#define OIT_DREAM_SCORE         1       // AP scoring job in flight
+#define OIT_DREAM_TRAIN         2
+#define OIT_DREAM_EVAL          3       // AP rescoring job in flight
+#define OIT_DREAM_DONE          4       // decided; see last_accepted
+
+// ── Candidate turn ────────────────────────────────────────────────────────
+
+typedef struct {
+    int      n;                 // tokens
+    int      ts;                // target start (first response token)
+    uint32_t hash;              // FNV-1a of prompt + response
+    float    prior;             // caller weight (recency, SMB relevance ...)
+    float    nll;               // mean NLL of the response before training
+    float    nll_after;         // ... after training
+    float    value;             // prior · nll
+    uint8_t  held;              // replay (validation) set
+    uint8_t  picked;            // consolidation set
+} OitDreamItem;
+
+struct OitDream;
+
+typedef struct {
+    struct OitDream *d;
+    int              after;     // 0: fill item[i].nll, 1: item[i].nll_after
+} OitDreamJob;
+
+typedef struct OitDream {
+    OitBpTrainer   *t;
+    OitParallel    *par;        // optional: training steps on AP shards
+    OoMulticoreCtx *mc;         // optional: scoring jobs on an AP (0 = inline)
+    OitEncodeFn     encode;
+    void           *encode_ctx;
+
+    // Arena
+    int            *tok;        // [OIT_DREAM_POOL][t->max_t]
+    float          *snap;       // [3][n_param]: param, adam_m, adam_v
+    OitBpScratch    ws;         // scoring scratch (owned by the AP job)
+    float          *ws_grad;    // unused by scoring; part of the worker block
+
+    OitDreamItem    item[OIT_DREAM_POOL];
+    int             count;
+    int             sel[OIT_DREAM_SELECT];
+    int             n_sel;
+    int             n_held;
+
+    // Cycle
+    volatile uint32_t phase;
+    volatile uint32_t job_done;
+    OitDreamJob     job;
+    int             max_steps;
+    uint64_t        budget_cycles;  // TSC budget for TRAIN (0 = steps only)
+    float           tol;
+    int             steps;          // optimizer steps this cycle
+    int             cursor;         // next consolidation sample
+    uint64_t        t_train;
+    uint32_t        par_steps0;     // par->steps when TRAIN started
+    uint32_t        snap_steps;
+    float           snap_b1t, snap_b2t;
+
+    // Results of the last cycle (mean NLL per target token)
+    float           sel_before, sel_after;
+    float           held_before, held_after;
+    int             last_accepted;
+    uint64_t        last_cycles;    // TSC, SCORE start → DONE
+    uint64_t        t_begin;
+
+    // Lifetime stats
+    uint32_t        cycles;
+    uint32_t        accepted;
+    uint32_t        rejected;
+    int             ready;
+} OitDream;
+
+// ── Public API ────────────────────────────────────────────────────────────
+
+// Arena: token pool, adapter snapshot, scoring scratch
+uint64_t oit_dream_bytes(const OitBpTrainer *t);
+
+// t must be oit_bp_init'ed. par and mc may be 0. Returns 0 or <0.
+int   oit_dream_init(OitDream *d, OitBpTrainer *t, OitParallel *par, OoMulticoreCtx *mc,
+                     OitEncodeFn encode, void *encode_ctx, void *arena, uint64_t arena_bytes);
+
+// Start collecting a new cycle (drops the previous pool)
+void  oit_dream_reset(OitDream *d);
+
+// Queue one turn. prior > 0 weights it for selection. Returns 1 if taken.
+int   oit_dream_add(OitDream *d, const char *prompt, const char *response, float prior);
+
+// Launch scoring. max_steps <= 0 uses OIT_DREAM_STEPS. Returns 0, or <0 when
+// the pool cannot be split into a consolidation and a replay set or the
+// trainer is busy / merged.
+int   oit_dream_begin(OitDream *d, int max_steps, uint64_t budget_cycles);
+
+// BSP, from the idle loop: advance the cycle by at most one step.
+// Returns 1 on the call that reaches DONE, 0 otherwise. Never blocks.
+int   oit_dream_poll(OitDream *d);
+
+// Abort a cycle in flight and roll the adapter back to the snapshot
+void  oit_dream_cancel(OitDream *d);
+
+int   oit_dream_busy(const OitDream *d);
+
+#ifdef __cplusplus
+}
+#endif
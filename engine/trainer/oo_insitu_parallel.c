@@ -0,0 +1,189 @@
+// oo_insitu_parallel.c — Data-parallel LoRA training on the AP work queue
+//
+// Phases and ownership are described in oo_insitu_parallel.h. Only
+// oo_mc_submit / oo_mc_submit_from / oo_mc_run_one are used, so the same
+// file runs on APs in the UEFI build and on pthreads in the host harness
+// (tests/test_oo_insitu_parallel.c).
+//
+// Freestanding C11 — no libc, no malloc.
+
+#include "oo_insitu_parallel.h"
+
+static uint64_t par_align(uint64_t b) { return (b + 63u) & ~(uint64_t)63u; }
+
+static void par_submit(OitParallel *p, int from, OoMcWorkFn fn, OitParJob *j) {
+    if (p->mc) oo_mc_submit_from(p->mc, from, fn, j);
+    else fn(j, 0);
+}
+
+static int par_from(const OitParallel *p, int core) {
+    return p->mc ? core : 0;
+}
+
+// ── Phase 2: tree all-reduce of one parameter slice ──────────────────────
+
+static void par_reduce_job(void *arg, int core) {
+    (void)core;
+    OitParJob *j = (OitParJob *)arg;
+    OitParallel *p = j->p;
+    const int ns = p->n_shards;
+    const uint64_t np = p->t->n_param;
+    uint64_t lo = (np * (uint64_t)j->idx / (uint64_t)ns) & ~(uint64_t)15u;
+    uint64_t hi = (j->idx == ns - 1) ? np : (np * (uint64_t)(j->idx + 1) / (uint64_t)ns) & ~(uint64_t)15u;
+
+    for (int s = 1; s < ns; s <<= 1)
+        for (int i = 0; i + s < ns; i += 2 * s) {
+            float *dst = p->shard[i].grad, *src = p->shard[i + s].grad;
+            for (uint64_t k = lo; k < hi; k++) {
+                dst[k] += src[k];
+                src[k] = 0.0f;
+            }
+        }
+
+    if (oo_mc_xadd32(&p->pending, (uint32_t)-1) == 1) {
+        uint64_t now = oo_mc_rdtsc();
+        p->last_reduce_cycles = now - p->t_reduce;
+        p->last_step_cycles = now - p->t_begin;
+        oo_mc_barrier();
+        p->phase = OIT_PAR_DONE;
+    }
+}
+
+// ── Phase 1: forward + backward of one shard ─────────────────────────────
+
+static void par_shard_job(void *arg, int core) {
+    OitParJob *j = (OitParJob *)arg;
+    OitParallel *p = j->p;
+    const int me = j->idx, ns = p->n_shards, T = p->t->max_t;
+    OitParShard *sh = &p->shard[me];
+    uint64_t t0 = oo_mc_rdtsc();
+
+    for (int s = me; s < p->count; s += ns) {
+        uint32_t nt;
+        float l = oit_bp_run(p->t, &sh->ws, sh->grad, p->tok + (uint64_t)s * T,
+                             p->n[s], p->ts[s], &nt);
+        if (l < 0.0f || nt == 0) continue;
+        sh->loss += l;
+        sh->tokens += nt;
+        sh->samples++;
+    }
+    sh->cycles = oo_mc_rdtsc() - t0;
+
+    if (oo_mc_xadd32(&p->pending, (uint32_t)-1) != 1) return;
+
+    // Last shard: every gradient is final, start the all-reduce from here
+    p->t_reduce = oo_mc_rdtsc();
+    p->last_shard_cycles = p->t_reduce - p->t_begin;
+    if (ns == 1) {
+        p->last_reduce_cycles = 0;
+        p->last_step_cycles = p->last_shard_cycles;
+        oo_mc_barrier();
+        p->phase = OIT_PAR_DONE;
+        return;
+    }
+    p->pending = (uint32_t)ns;
+    p->phase = OIT_PAR_REDUCE;
+    for (int i = 0; i < ns; i++) {
+        p->job[i].p = p;
+        p->job[i].idx = i;
+    }
+    for (int i = 0; i < ns; i++) par_submit(p, par_from(p, core), par_reduce_job, &p->job[i]);
+}
+
+// ── Public API ────────────────────────────────────────────────────────────
+
+uint64_t oit_par_bytes(const OitBpTrainer *t, int n_shards) {
+    if (!t || !t->ready || n_shards < 1 || n_shards > OIT_PAR_MAX_SHARDS) return 0;
+    return par_align(oit_bp_worker_bytes(t)) * (uint64_t)(n_shards - 1) +
+           par_align((uint64_t)OIT_PAR_BATCH_MAX * (uint64_t)t->max_t * sizeof(int));
+}
+
+int oit_par_init(OitParallel *p, OitBpTrainer *t, OoMulticoreCtx *mc,
+                 int n_shards, void *arena, uint64_t arena_bytes) {
+    if (!p || !t || !arena) return -1;
+    for (uint64_t i = 0; i < sizeof(*p); i++) ((uint8_t *)p)[i] = 0;
+    uint64_t need = oit_par_bytes(t, n_shards);
+    if (!need) return -1;
+    if (arena_bytes < need) return -3;
+
+    uint8_t *cur = (uint8_t *)arena;
+    uint64_t wb = par_align(oit_bp_worker_bytes(t));
+    p->shard[0].ws = t->ws;
+    p->shard[0].grad = t->grad;
+    for (int i = 1; i < n_shards; i++, cur += wb)
+        if (oit_bp_worker_init(t, &p->shard[i].ws, &p->shard[i].grad, cur, wb) != 0) return -3;
+    p->tok = (int *)cur;
+    p->t = t;
+    p->mc = mc;
+    p->n_shards = n_shards;
+    p->phase = OIT_PAR_IDLE;
+    return 0;
+}
+
+int oit_par_busy(const OitParallel *p) {
+    return p && p->phase != OIT_PAR_IDLE;
+}
+
+int oit_par_begin(OitParallel *p, const int *const *tokens, const int *n,
+                  const int *target_start, int count) {
+    if (!p || !p->t || !tokens || !n || !target_start || count <= 0) return 0;
+    if (p->phase != OIT_PAR_IDLE) oit_par_wait(p);
+    if (!p->t->ready || p->t->lora->merged) return 0;
+
+    const int T = p->t->max_t;
+    int m = 0;
+    for (int s = 0; s < count && m < OIT_PAR_BATCH_MAX; s++) {
+        if (!tokens[s] || n[s] < 2 || n[s] > T) continue;
+        int *dst = p->tok + (uint64_t)m * T;
+        for (int i = 0; i < n[s]; i++) dst[i] = tokens[s][i];
+        p->n[m] = n[s];
+        p->ts[m] = target_start[s];
+        m++;
+    }
+    if (m == 0) return 0;
+    p->count = m;
+    for (int i = 0; i < p->n_shards; i++) {
+        p->shard[i].loss = 0.0f;
+        p->shard[i].tokens = 0;
+        p->shard[i].samples = 0;
+        p->shard[i].cycles = 0;
+        p->job[i].p = p;
+        p->job[i].idx = i;
+    }
+
+    p->t_begin = oo_mc_rdtsc();
+    p->pending = (uint32_t)p->n_shards;
+    oo_mc_barrier();
+    p->phase = OIT_PAR_SHARDS;
+    int from = p->mc ? p->mc->bsp_idx : 0;
+    for (int i = 0; i < p->n_shards; i++) par_submit(p, from, par_shard_job, &p->job[i]);
+    return m;
+}
+
+int oit_par_poll(OitParallel *p) {
+    if (!p || p->phase != OIT_PAR_DONE) return 0;
+    oo_mc_barrier();
+    OitBpTrainer *t = p->t;
+    float loss = 0.0f;
+    uint32_t tokens = 0;
+    for (int i = 0; i < p->n_shards; i++) {
+        loss += p->shard[i].loss;
+        tokens += p->shard[i].tokens;
+    }
+    if (tokens > 0) {
+        t->tokens_acc += tokens;
+        t->last_loss = loss / (float)tokens;
+        if (++t->accum_n >= t->accum) oit_bp_apply(t);
+    }
+    p->steps++;
+    p->phase = OIT_PAR_IDLE;
+    return 1;
+}
+
+void oit_par_wait(OitParallel *p) {
+    if (!p) return;
+    while (p->phase != OIT_PAR_IDLE) {
+        if (oit_par_poll(p)) break;
+        if (!(p->mc && oo_mc_run_one(p->mc, p->mc->bsp_idx))) oo_mc_pause();
+    }
+}
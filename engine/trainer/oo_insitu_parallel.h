@@ -0,0 +1,114 @@
+// oo_insitu_parallel.h — Data-parallel LoRA training on the AP work queue
+//
+// Shards one minibatch of oo_insitu_backprop samples across the oo-multicore
+// workers and keeps the BSP free for inference while the step runs:
+//
+//   1. oit_par_begin (BSP): tokens are copied in, sample s goes to shard
+//      s % n_shards, one job per shard is queued with oo_mc_submit.
+//   2. Shard job (any core): forward + backward of its samples into the
+//      shard's private gradient and scratch. The adapter is only read.
+//   3. The last shard to finish queues the all-reduce: the parameter range
+//      is cut into n_shards slices, and each slice job runs the binary tree
+//      g[i] += g[i + s] (s = 1, 2, 4 …) over its slice, zeroing the source
+//      as it goes. Slices are independent, so the tree needs no barriers
+//      between rounds. Shard 0's gradient is the trainer's own t->grad, so
+//      the result lands where oit_bp_apply expects it.
+//   4. oit_par_poll (BSP, e.g. from the key-wait loop): once the last
+//      slice is done, AdamW runs on the BSP. The adapter is therefore only
+//      written by the core that also runs inference, between tokens.
+//
+// Shard → core binding is dynamic (idle workers steal); the reduction
+// order only depends on n_shards, so results do not depend on scheduling.
+// Without workers, oo_mc_submit runs every job inline and begin returns
+// with the step already reduced.
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+#include "oo_insitu_backprop.h"
+#include "../../oo-multicore/core/oo_multicore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ── Constants ─────────────────────────────────────────────────────────────
+
+#define OIT_PAR_MAX_SHARDS  OO_MAX_CORES
+#define OIT_PAR_BATCH_MAX   32      // samples per parallel minibatch
+
+#define OIT_PAR_IDLE        0
+#define OIT_PAR_SHARDS      1       // forward/backward jobs in flight
+#define OIT_PAR_REDUCE      2       // all-reduce slices in flight
+#define OIT_PAR_DONE        3       // reduced, waiting for oit_par_poll
+
+// ── Per-shard state ───────────────────────────────────────────────────────
+
+typedef struct {
+    OitBpScratch ws;
+    float       *grad;              // [n_param]; shard 0 = t->grad
+    float        loss;              // summed CE of this shard's samples
+    uint32_t     tokens;
+    uint32_t     samples;
+    uint64_t     cycles;            // rdtsc spent in the shard job
+} OitParShard;
+
+struct OitParallel;
+
+typedef struct {
+    struct OitParallel *p;
+    int                 idx;        // shard (phase 1) or slice (phase 2)
+} OitParJob;
+
+typedef struct OitParallel {
+    OitBpTrainer   *t;
+    OoMulticoreCtx *mc;             // 0 = run every job inline
+    int             n_shards;
+    OitParShard     shard[OIT_PAR_MAX_SHARDS];
+    OitParJob       job[OIT_PAR_MAX_SHARDS];
+
+    int            *tok;            // [OIT_PAR_BATCH_MAX][t->max_t]
+    int             n[OIT_PAR_BATCH_MAX];
+    int             ts[OIT_PAR_BATCH_MAX];
+    int             count;
+
+    volatile uint32_t phase;
+    volatile uint32_t pending;      // jobs left in the current phase
+
+    // stats (TSC cycles)
+    uint32_t        steps;
+    uint64_t        t_begin;
+    uint64_t        t_reduce;
+    uint64_t        last_shard_cycles;   // wall time of phase 1
+    uint64_t        last_reduce_cycles;  // wall time of phase 2
+    uint64_t        last_step_cycles;    // begin → DONE
+} OitParallel;
+
+// ── Public API ────────────────────────────────────────────────────────────
+
+// Arena for shards 1..n_shards-1 (scratch + gradient) plus token buffers
+uint64_t oit_par_bytes(const OitBpTrainer *t, int n_shards);
+
+// t must be oit_bp_init'ed. mc may be 0. Returns 0 or <0.
+int   oit_par_init(OitParallel *p, OitBpTrainer *t, OoMulticoreCtx *mc,
+                   int n_shards, void *arena, uint64_t arena_bytes);
+
+// Queue one minibatch (tokens are copied). A step still in flight is first
+// finished with oit_par_wait. Returns the number of samples accepted.
+int   oit_par_begin(OitParallel *p, const int *const *tokens, const int *n,
+                    const int *target_start, int count);
+
+// BSP: apply the optimizer if the step is reduced. Returns 1 when a step
+// completed on this call, 0 otherwise. Never blocks.
+int   oit_par_poll(OitParallel *p);
+
+// BSP: help drain the queue until the current step is applied
+void  oit_par_wait(OitParallel *p);
+
+int   oit_par_busy(const OitParallel *p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,7 @@
 // Freestanding C11 — no libc, no malloc.
 
 #include "oo_insitu_train.h"
+#include "oo_insitu_parallel.h"
 #include "../ssm/oo_neuralfs2.h"
 
 // ── Freestanding helpers ─────────────────────────────────────────────────
@@ -290,8 +291,64 @@ static void oit_lora_backward(OitEngine *e,
             e->lora.A[r][d] -= lr_scaled * 2.0f * bt_err[r] * x[d];
 }
 
+// ── Backprop route ───────────────────────────────────────────────────────
+//
+// Sample = encode(input) ++ encode(output) minus the second BOS; the loss
+// covers the output tokens only. One call = one minibatch.
+
+void oit_attach_backprop(OitEngine *e, OitBpTrainer *t,
+                         OitEncodeFn encode, void *encode_ctx) {
+    if (!e) return;
+    e->bp         = (t && t->ready && encode) ? t : 0;
+    e->encode     = e->bp ? encode : 0;
+    e->encode_ctx = e->bp ? encode_ctx : 0;
+    if (!e->bp) e->par = 0;
+}
+
+void oit_attach_parallel(OitEngine *e, struct OitParallel *p) {
+    if (!e) return;
+    if (e->par && e->par != p) oit_par_wait(e->par);
+    e->par = (p && e->bp && p->t == e->bp) ? p : 0;
+}
+
+static void oit_bp_submit(OitEngine *e, const int *const *seq, const int *n,
+                          const int *ts, int m) {
+    if (e->par) oit_par_begin(e->par, seq, n, ts, m);
+    else oit_bp_minibatch(e->bp, seq, n, ts, m);
+}
+
+static int oit_train_batch_bp(OitEngine *e, const OitPair *pairs, int count) {
+    static int toks[OIT_TRAIN_BATCH][OIT_BP_SEQ_MAX];
+    const int *seq[OIT_TRAIN_BATCH];
+    int n[OIT_TRAIN_BATCH], ts[OIT_TRAIN_BATCH], m = 0;
+    int cap = e->bp->max_t;
+
+    for (int p = 0; p < count; p++) {
+        if (m == OIT_TRAIN_BATCH) {
+            oit_bp_submit(e, seq, n, ts, m);
+            m = 0;
+        }
+        int *t = toks[m];
+        // [BOS] input | output: the response continues the prompt, no BOS
+        int ni = e->encode(e->encode_ctx, pairs[p].input, 1, t, cap);
+        if (ni <= 0 || ni >= cap) continue;
+        int no = e->encode(e->encode_ctx, pairs[p].output, 0, t + ni, cap - ni);
+        if (no <= 0) continue;
+        seq[m] = t;
+        n[m]   = ni + no;
+        ts[m]  = ni;
+        m++;
+    }
+    if (m > 0) oit_bp_submit(e, seq, n, ts, m);
+    return m;
+}
+
 void oit_train_batch(OitEngine *e, const OitPair *pairs, int count) {
     if (!e || !pairs || count <= 0) return;
+    if (e->bp && e->encode) {
+        oit_train_batch_bp(e, pairs, count);
+        return;
+    }
     int dim = e->lora.hidden_dim;
     if (dim <= 0) return;
 
@@ -455,6 +512,31 @@ void oit_print_status(const OitEngine *e, void (*print_fn)(const char *)) {
     oit_strcat(buf, "\r\n", sizeof(buf));
     print_fn(buf);
 
+    if (e->bp) {
+        oit_strcpy(buf, "  backprop: layers=", sizeof(buf));
+        oit_itoa(num, sizeof(num), e->bp->n_train);
+        oit_strcat(buf, num, sizeof(buf));
+        oit_strcat(buf, "  steps=", sizeof(buf));
+        oit_itoa(num, sizeof(num), (int)e->bp->steps);
+        oit_strcat(buf, num, sizeof(buf));
+        oit_strcat(buf, "  loss_milli=", sizeof(buf));
+        oit_itoa(num, sizeof(num), (int)(e->bp->last_loss * 1000.0f));
+        oit_strcat(buf, num, sizeof(buf));
+        oit_strcat(buf, "\r\n", sizeof(buf));
+        print_fn(buf);
+    }
+    if (e->par) {
+        oit_strcpy(buf, "  parallel: shards=", sizeof(buf));
+        oit_itoa(num, sizeof(num), e->par->n_shards);
+        oit_strcat(buf, num, sizeof(buf));
+        oit_strcat(buf, "  steps=", sizeof(buf));
+        oit_itoa(num, sizeof(num), (int)e->par->steps);
+        oit_strcat(buf, num, sizeof(buf));
+        oit_strcat(buf, oit_par_busy(e->par) ? "  (step in flight)" : "  (idle)", sizeof(buf));
+        oit_strcat(buf, "\r\n", sizeof(buf));
+        print_fn(buf);
+    }
+
     oit_strcpy(buf, "  diop_lines=", sizeof(buf));
     oit_itoa(num, sizeof(num), (int)e->watchdog.lines_diop_now);
     oit_strcat(buf, num, sizeof(buf));
@@ -15,6 +15,15 @@
 //      - Applied at inference time: out = W*x + B*A*x
 //      - Persisted via NFS2 key "oo.lora.delta_ab"
 //
+//   2b. Backprop LoRA (oo_insitu_backprop.h):
+//      - When a model is attached, oit_train_batch tokenizes each pair and
+//        runs a real forward/backward through the transformer, training the
+//        oo_lora adapters of the last N layers with AdamW
+//      - Without a model it falls back to the fingerprint delta above
+//      - With an OitParallel attached (oo_insitu_parallel.h) the minibatch
+//        is sharded over the AP workers and the call returns at once; the
+//        optimizer step lands on the next oit_par_poll()
+//
 //   3. Autonomous Watchdog:
 //      - Counts lines in DIOP_EXP.JSONL and OO_DREAM.JSONL
 //      - Triggers a training cycle when threshold is reached
@@ -25,6 +34,7 @@
 #pragma once
 
 #include <stdint.h>
+#include "oo_insitu_backprop.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -90,6 +100,10 @@ typedef struct {
     int          rag_enabled;    // 1 = prepend NFS2 context before inference
     int          lora_enabled;   // 1 = apply LoRA delta at inference time
     int          verbose;
+    OitBpTrainer *bp;            // attached backprop trainer (0 = fallback)
+    struct OitParallel *par;     // data-parallel scheduler over bp (optional)
+    OitEncodeFn   encode;
+    void         *encode_ctx;
 } OitEngine;
 
 // ── Public API ────────────────────────────────────────────────────────────
@@ -113,6 +127,13 @@ void oit_format_ctx_prefix(const OitEngine *e,
 void oit_lora_apply(const OitEngine *e,
                     float *out_vec, const float *in_vec, int dim);
 
+// Backprop: route oit_train_batch through a real trainer (t = 0 detaches)
+void oit_attach_backprop(OitEngine *e, OitBpTrainer *t,
+                         OitEncodeFn encode, void *encode_ctx);
+
+// Backprop: shard minibatches over the AP workers (p = 0 detaches)
+void oit_attach_parallel(OitEngine *e, struct OitParallel *p);
+
 // Training: run one batch from ring of pairs
 void oit_train_batch(OitEngine *e,
                      const OitPair *pairs, int count);
@@ -0,0 +1,294 @@
+// oo_kws.c — Streaming int8 DS-CNN keyword spotter (Implementation)
+//
+// Freestanding C11 — no libc, no malloc, no external deps.
+
+#include "oo_kws.h"
+
+// Q8_0 rows × f32 vector, shared with the transformer
+// (engine/self_improve/oo_lora.c; adapter = 0 → plain matmul)
+void oo_lora_matmul_q8_0(float *xout, const float *x, const uint8_t *w,
+                         uint32_t n, uint32_t d, const void *adapter);
+
+_Static_assert(sizeof(OkwsFileHeader) == 288, "OkwsFileHeader layout");
+
+// ── Helpers ───────────────────────────────────────────────────────────────────
+
+static inline uint64_t _kws_rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint32_t _kws_pad4(uint32_t b)  { return (b + 3u) & ~3u; }
+static uint32_t _kws_q8_row(int n)     { return (uint32_t)(n / 32) * 34u; }
+
+// e^x for softmax inputs (x ≤ 0)
+static float _kws_exp(float x) {
+    if (x < -80.0f) return 0.0f;
+    int k = (int)(x * 1.44269504f - 0.5f);
+    float r = x - (float)k * 0.69314718f;
+    float p = 1.0f + r * (1.0f + r * (0.5f + r * (1.0f / 6.0f + r * (1.0f / 24.0f + r * (1.0f / 120.0f)))));
+    union { float f; uint32_t u; } s;
+    s.u = (uint32_t)(k + 127) << 23;
+    return p * s.f;
+}
+
+static int _kws_same_pad(int in, int out, int k, int s) {
+    int p = (out - 1) * s + k - in;
+    return p > 0 ? p / 2 : 0;
+}
+
+// ── Model ─────────────────────────────────────────────────────────────────────
+
+uint32_t okws_model_bytes(const OkwsFileHeader *h) {
+    if (!h) return 0;
+    int C = h->channels, K = h->k0_t * h->k0_f;
+    if (h->n_frames < 1 || h->n_frames > OKWS_MAX_FRAMES) return 0;
+    if (h->n_mfcc < 1 || h->n_mfcc > OMF_MAX_MFCC) return 0;
+    if (h->n_classes < 2 || h->n_classes > OKWS_MAX_CLASSES) return 0;
+    if (C < 32 || C > OKWS_MAX_CH || (C % 32) != 0) return 0;
+    if (h->n_blocks > OKWS_MAX_BLOCKS) return 0;
+    if (K < 1 || h->k0_t > h->n_frames || h->k0_f > h->n_mfcc) return 0;
+    if (h->s0_t < 1 || h->s0_f < 1) return 0;
+    int k0_pad = (K + 31) & ~31;
+
+    uint32_t b = sizeof(OkwsFileHeader);
+    b += (uint32_t)C * _kws_q8_row(k0_pad) + (uint32_t)C * 4u;
+    b += (uint32_t)h->n_blocks *
+         (9u * (uint32_t)C + 2u * (uint32_t)C * 4u + (uint32_t)C * _kws_q8_row(C) + (uint32_t)C * 4u);
+    b += _kws_pad4((uint32_t)h->n_classes * _kws_q8_row(C)) + (uint32_t)h->n_classes * 4u;
+    return b;
+}
+
+int okws_load(OkwsModel *m, const void *blob, uint32_t bytes) {
+    if (!m || !blob || ((uintptr_t)blob & 3u)) return OKWS_E_ARG;
+    for (uint32_t i = 0; i < sizeof(*m); i++) ((uint8_t *)m)[i] = 0;
+    if (bytes < sizeof(OkwsFileHeader)) return OKWS_E_SIZE;
+
+    const OkwsFileHeader *h = (const OkwsFileHeader *)blob;
+    if (h->magic != OKWS_MAGIC || h->version != OKWS_VERSION ||
+        h->header_bytes != sizeof(OkwsFileHeader)) return OKWS_E_FORMAT;
+    uint32_t need = okws_model_bytes(h);
+    if (!need) return OKWS_E_GEOMETRY;
+    if (bytes < need) return OKWS_E_SIZE;
+
+    m->hdr = h;
+    m->T = h->n_frames;  m->F = h->n_mfcc;  m->C = h->channels;
+    m->n_classes = h->n_classes;  m->n_blocks = h->n_blocks;
+    m->k0 = h->k0_t * h->k0_f;
+    m->k0_pad = (m->k0 + 31) & ~31;
+    m->out_t = (m->T + h->s0_t - 1) / h->s0_t;
+    m->out_f = (m->F + h->s0_f - 1) / h->s0_f;
+    m->pad_t = _kws_same_pad(m->T, m->out_t, h->k0_t, h->s0_t);
+    m->pad_f = _kws_same_pad(m->F, m->out_f, h->k0_f, h->s0_f);
+    m->bytes = need;
+
+    const uint8_t *p = (const uint8_t *)blob + sizeof(OkwsFileHeader);
+    const int C = m->C;
+    m->c0_w = p;                        p += (uint32_t)C * _kws_q8_row(m->k0_pad);
+    m->c0_bias = (const float *)p;      p += (uint32_t)C * 4u;
+    for (int b = 0; b < m->n_blocks; b++) {
+        OkwsBlock *k = &m->blk[b];
+        k->dw_w = (const int8_t *)p;    p += 9u * (uint32_t)C;
+        k->dw_scale = (const float *)p; p += (uint32_t)C * 4u;
+        k->dw_bias = (const float *)p;  p += (uint32_t)C * 4u;
+        k->pw_w = p;                    p += (uint32_t)C * _kws_q8_row(C);
+        k->pw_bias = (const float *)p;  p += (uint32_t)C * 4u;
+    }
+    m->fc_w = p;                        p += _kws_pad4((uint32_t)m->n_classes * _kws_q8_row(C));
+    m->fc_bias = (const float *)p;
+    return OKWS_OK;
+}
+
+// ── Network ───────────────────────────────────────────────────────────────────
+
+static void _kws_bias_relu(float *x, const float *bias, int n) {
+    for (int i = 0; i < n; i++) {
+        float v = x[i] + bias[i];
+        x[i] = v > 0.0f ? v : 0.0f;
+    }
+}
+
+static void _kws_conv0(const OkwsModel *m, const float *win, float *out, float *patch) {
+    const OkwsFileHeader *h = m->hdr;
+    const int kt_n = h->k0_t, kf_n = h->k0_f;
+    for (int i = m->k0; i < m->k0_pad; i++) patch[i] = 0.0f;
+    for (int ot = 0; ot < m->out_t; ot++)
+        for (int of = 0; of < m->out_f; of++) {
+            int t0 = ot * h->s0_t - m->pad_t, f0 = of * h->s0_f - m->pad_f;
+            for (int kt = 0; kt < kt_n; kt++)
+                for (int kf = 0; kf < kf_n; kf++) {
+                    int t = t0 + kt, f = f0 + kf;
+                    patch[kt * kf_n + kf] = (t >= 0 && t < m->T && f >= 0 && f < m->F)
+                                            ? win[t * m->F + f] : 0.0f;
+                }
+            float *o = out + (ot * m->out_f + of) * m->C;
+            oo_lora_matmul_q8_0(o, patch, m->c0_w, (uint32_t)m->k0_pad, (uint32_t)m->C, 0);
+            _kws_bias_relu(o, m->c0_bias, m->C);
+        }
+}
+
+// 3×3 depthwise, stride 1, zero padding 1; channels innermost
+static void _kws_depthwise(const OkwsModel *m, const OkwsBlock *k,
+                           const float *in, float *out) {
+    const int H = m->out_t, W = m->out_f, C = m->C;
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++) {
+            float *o = out + (y * W + x) * C;
+            for (int c = 0; c < C; c++) o[c] = 0.0f;
+            for (int dy = -1; dy <= 1; dy++) {
+                if (y + dy < 0 || y + dy >= H) continue;
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (x + dx < 0 || x + dx >= W) continue;
+                    const float  *src = in + ((y + dy) * W + (x + dx)) * C;
+                    const int8_t *w   = k->dw_w + ((dy + 1) * 3 + (dx + 1)) * C;
+                    for (int c = 0; c < C; c++) o[c] += (float)w[c] * src[c];
+                }
+            }
+            for (int c = 0; c < C; c++) {
+                float v = o[c] * k->dw_scale[c] + k->dw_bias[c];
+                o[c] = v > 0.0f ? v : 0.0f;
+            }
+        }
+}
+
+static void _kws_forward(OkwsStream *s) {
+    const OkwsModel *m = s->m;
+    const int P = m->out_t * m->out_f, C = m->C;
+    float logits[OKWS_MAX_CLASSES];
+
+    _kws_conv0(m, s->win, s->act0, s->patch);
+    for (int b = 0; b < m->n_blocks; b++) {
+        const OkwsBlock *k = &m->blk[b];
+        _kws_depthwise(m, k, s->act0, s->act1);
+        for (int p = 0; p < P; p++) {
+            float *o = s->act0 + p * C;
+            oo_lora_matmul_q8_0(o, s->act1 + p * C, k->pw_w, (uint32_t)C, (uint32_t)C, 0);
+            _kws_bias_relu(o, k->pw_bias, C);
+        }
+    }
+
+    for (int c = 0; c < C; c++) s->pool[c] = 0.0f;
+    for (int p = 0; p < P; p++) {
+        const float *a = s->act0 + p * C;
+        for (int c = 0; c < C; c++) s->pool[c] += a[c];
+    }
+    float inv = 1.0f / (float)P;
+    for (int c = 0; c < C; c++) s->pool[c] *= inv;
+
+    oo_lora_matmul_q8_0(logits, s->pool, m->fc_w, (uint32_t)C, (uint32_t)m->n_classes, 0);
+    float mx = -1e30f, sum = 0.0f;
+    for (int i = 0; i < m->n_classes; i++) {
+        logits[i] += m->fc_bias[i];
+        if (logits[i] > mx) mx = logits[i];
+    }
+    for (int i = 0; i < m->n_classes; i++) sum += (s->prob[i] = _kws_exp(logits[i] - mx));
+    for (int i = 0; i < m->n_classes; i++) s->prob[i] /= sum;
+}
+
+// ── Stream ────────────────────────────────────────────────────────────────────
+
+uint32_t okws_stream_bytes(const OkwsModel *m) {
+    if (!m || !m->hdr) return 0;
+    uint32_t tf = (uint32_t)(m->T * m->F), pc = (uint32_t)(m->out_t * m->out_f * m->C);
+    return (2u * tf + 2u * pc + (uint32_t)m->k0_pad) * (uint32_t)sizeof(float);
+}
+
+int okws_stream_init(OkwsStream *s, const OkwsModel *m, void *arena, uint32_t arena_bytes) {
+    if (!s || !m || !m->hdr || !arena || ((uintptr_t)arena & 3u)) return OKWS_E_ARG;
+    for (uint32_t i = 0; i < sizeof(*s); i++) ((uint8_t *)s)[i] = 0;
+    if (arena_bytes < okws_stream_bytes(m)) return OKWS_E_ARENA;
+
+    float *p = (float *)arena;
+    const int tf = m->T * m->F, pc = m->out_t * m->out_f * m->C;
+    s->m = m;
+    s->ring = p;   p += tf;
+    s->win = p;    p += tf;
+    s->act0 = p;   p += pc;
+    s->act1 = p;   p += pc;
+    s->patch = p;
+    okws_stream_reset(s);
+    return OKWS_OK;
+}
+
+void okws_stream_reset(OkwsStream *s) {
+    if (!s || !s->m) return;
+    const int tf = s->m->T * s->m->F;
+    for (int i = 0; i < tf; i++) s->ring[i] = 0.0f;
+    s->head = s->filled = s->since = s->mute = 0;
+    s->hist_n = s->hist_pos = 0;
+    s->score = 0.0f;
+    s->best = 0;
+    s->stride = s->m->hdr->eval_stride ? s->m->hdr->eval_stride : 1;
+    for (int i = 0; i < OKWS_MAX_CLASSES; i++) s->prob[i] = 0.0f;
+}
+
+void okws_set_budget(OkwsStream *s, uint64_t cycles_per_frame) {
+    if (s) s->budget = cycles_per_frame;
+}
+
+void okws_eval(OkwsStream *s) {
+    if (!s || !s->m) return;
+    const OkwsModel *m = s->m;
+    const int F = m->F;
+    // Oldest row first; rows not yet filled stay zero (= feature mean)
+    for (int t = 0; t < m->T; t++) {
+        const float *src = s->ring + ((s->head + t) % m->T) * F;
+        for (int f = 0; f < F; f++) s->win[t * F + f] = src[f];
+    }
+    uint64_t t0 = _kws_rdtsc();
+    _kws_forward(s);
+    uint64_t dt = _kws_rdtsc() - t0;
+    s->eval_cycles = s->evals ? (3u * s->eval_cycles + dt) / 4u : dt;
+    if (dt > s->max_eval_cycles) s->max_eval_cycles = dt;
+    s->evals++;
+}
+
+static void _kws_adapt_stride(OkwsStream *s) {
+    const OkwsFileHeader *h = s->m->hdr;
+    int lo = h->eval_stride ? h->eval_stride : 1, hi = s->m->T / 2;
+    if (hi < lo) hi = lo;
+    if (!s->budget) { s->stride = lo; return; }
+    uint64_t need = (s->eval_cycles + s->budget - 1) / s->budget;
+    s->stride = need < (uint64_t)lo ? lo : need > (uint64_t)hi ? hi : (int)need;
+}
+
+int okws_push(OkwsStream *s, const int32_t *mfcc) {
+    if (!s || !s->m || !mfcc) return 0;
+    const OkwsModel *m = s->m;
+    const OkwsFileHeader *h = m->hdr;
+
+    float *row = s->ring + s->head * m->F;
+    for (int f = 0; f < m->F; f++)
+        row[f] = ((float)mfcc[f] * (1.0f / OMF_LOG_ONE) - h->feat_mean[f]) * h->feat_scale[f];
+    s->head = (s->head + 1) % m->T;
+    if (s->filled < m->T) s->filled++;
+    s->frames++;
+
+    if (s->mute > 0) { s->mute--; return 0; }
+    if (s->filled < m->T || ++s->since < s->stride) return 0;
+    s->since = 0;
+
+    okws_eval(s);
+    _kws_adapt_stride(s);
+
+    int nh = h->smooth < 1 ? 1 : h->smooth > OKWS_MAX_SMOOTH ? OKWS_MAX_SMOOTH : h->smooth;
+    for (int i = 0; i < m->n_classes; i++) s->hist[s->hist_pos][i] = s->prob[i];
+    s->hist_pos = (s->hist_pos + 1) % nh;
+    if (s->hist_n < nh) s->hist_n++;
+
+    s->best = 0;
+    s->score = 0.0f;
+    for (int c = 1; c < m->n_classes; c++) {
+        float a = 0.0f;
+        for (int j = 0; j < s->hist_n; j++) a += s->hist[j][c];
+        a /= (float)nh;
+        if (a > s->score) { s->score = a; s->best = c; }
+    }
+    if (s->best == 0 || s->score < h->threshold) return 0;
+
+    s->detections++;
+    s->mute = h->refractory;
+    s->hist_n = s->hist_pos = 0;
+    return s->best;
+}
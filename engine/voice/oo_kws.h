@@ -0,0 +1,163 @@
+// oo_kws.h — Streaming int8 DS-CNN keyword spotter
+//
+// Runs a small depthwise-separable CNN over the last n_frames MFCC vectors
+// from oo_mfcc and turns its posteriors into wake-word detections:
+//
+//   window [T × F] → conv0 (k0_t × k0_f, stride s0) → ReLU
+//                  → n_blocks × { depthwise 3×3 → ReLU → pointwise 1×1 → ReLU }
+//                  → global average pool → FC → softmax
+//
+// Class 0 is background; classes 1… are keywords. A detection fires when
+// the posterior of a keyword, averaged over the last `smooth` evaluations,
+// reaches `threshold`, and is followed by `refractory` muted frames.
+//
+// Weights are int8. conv0, the pointwise layers and the FC are stored as
+// Q8_0 rows (fp16 scale + 32 int8, GGML layout) and run through
+// oo_lora_matmul_q8_0 — the same SSE2/AVX2 kernel the transformer uses for
+// its Q8_0 projections. conv0 rows are zero-padded to a multiple of 32
+// taps. Depthwise filters are int8 with one float scale per channel.
+//
+// Model file (.okws, little-endian, loaded in place — no copy, no malloc):
+//
+//   OkwsFileHeader
+//   conv0   Q8_0 [C][K0]           K0 = round_up(k0_t·k0_f, 32)
+//           f32  bias[C]
+//   block b int8 dw[9][C]          tap-major so channels are contiguous
+//           f32  dw_scale[C], dw_bias[C]
+//           Q8_0 pw[C][C]
+//           f32  pw_bias[C]
+//   fc      Q8_0 [n_classes][C]    padded to 4 bytes
+//           f32  fc_bias[n_classes]
+//
+// Batch-norm is folded into the biases by the exporter. Features are
+// normalised as (mfcc − feat_mean) · feat_scale before the window.
+//
+// Cycle budget: every evaluation is timed with rdtsc. With a budget set,
+// the evaluation stride grows until (cost of one evaluation / stride) fits
+// the per-frame budget, and shrinks back when it has headroom.
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+#include "oo_mfcc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ── Limits ────────────────────────────────────────────────────────────────────
+#define OKWS_MAGIC          0x53574B4Fu   // "OKWS"
+#define OKWS_VERSION        1
+#define OKWS_MAX_CLASSES    8
+#define OKWS_NAME_LEN       16
+#define OKWS_MAX_FRAMES     128
+#define OKWS_MAX_CH         256
+#define OKWS_MAX_BLOCKS     8
+#define OKWS_MAX_SMOOTH     8
+
+#define OKWS_OK             0
+#define OKWS_E_ARG         -1
+#define OKWS_E_FORMAT      -2   // magic / version / header size
+#define OKWS_E_GEOMETRY    -3   // shapes out of range
+#define OKWS_E_SIZE        -4   // blob shorter than its header says
+#define OKWS_E_ARENA       -5
+
+// ── On-disk header (288 bytes) ────────────────────────────────────────────────
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_bytes;                 // sizeof(OkwsFileHeader)
+    uint16_t n_frames;                     // T: MFCC frames per window
+    uint16_t n_mfcc;                       // F
+    uint16_t n_classes;                    // incl. background
+    uint16_t channels;                     // C, multiple of 32
+    uint16_t n_blocks;
+    uint8_t  k0_t, k0_f;                   // conv0 kernel (time, cepstrum)
+    uint8_t  s0_t, s0_f;                   // conv0 stride
+    uint8_t  eval_stride;                  // frames between evaluations (min)
+    uint8_t  smooth;                       // posterior averaging (evaluations)
+    uint16_t refractory;                   // frames muted after a detection
+    uint16_t reserved;
+    float    threshold;
+    float    feat_mean[OMF_MAX_MFCC];
+    float    feat_scale[OMF_MAX_MFCC];
+    char     names[OKWS_MAX_CLASSES][OKWS_NAME_LEN];
+} OkwsFileHeader;
+
+// ── Loaded model (pointers into the caller's blob) ────────────────────────────
+typedef struct {
+    const int8_t  *dw_w;                   // [9][C]
+    const float   *dw_scale, *dw_bias;
+    const uint8_t *pw_w;                   // Q8_0 [C][C]
+    const float   *pw_bias;
+} OkwsBlock;
+
+typedef struct {
+    const OkwsFileHeader *hdr;
+    int            T, F, C, n_classes, n_blocks;
+    int            k0, k0_pad;             // conv0 taps, padded to 32
+    int            out_t, out_f;           // conv0 output grid
+    int            pad_t, pad_f;           // conv0 "same" padding (before)
+    const uint8_t *c0_w;                   // Q8_0 [C][k0_pad]
+    const float   *c0_bias;
+    OkwsBlock      blk[OKWS_MAX_BLOCKS];
+    const uint8_t *fc_w;                   // Q8_0 [n_classes][C]
+    const float   *fc_bias;
+    uint32_t       bytes;
+} OkwsModel;
+
+// ── Streaming detector ────────────────────────────────────────────────────────
+typedef struct {
+    const OkwsModel *m;
+    float   *ring;                         // [T][F] normalised features
+    float   *win;                          // [T][F] window in time order
+    float   *act0, *act1;                  // [out_t·out_f][C]
+    float   *patch;                        // [k0_pad]
+    int      head, filled;
+    int      since;                        // frames since last evaluation
+    int      stride;                       // current evaluation stride
+    int      mute;                         // refractory frames left
+
+    float    pool[OKWS_MAX_CH];            // pooled embedding (last eval)
+    float    prob[OKWS_MAX_CLASSES];       // posteriors (last eval)
+    float    hist[OKWS_MAX_SMOOTH][OKWS_MAX_CLASSES];
+    int      hist_n, hist_pos;
+    float    score;                        // best smoothed keyword posterior
+    int      best;                         // its class
+
+    // Cycle budget (TSC)
+    uint64_t budget;                       // per 10 ms frame, 0 = unlimited
+    uint64_t eval_cycles;                  // running average of one evaluation
+    uint64_t max_eval_cycles;
+
+    // Stats
+    uint32_t frames, evals, detections;
+} OkwsStream;
+
+// ── Public API ────────────────────────────────────────────────────────────────
+
+// Bytes a well-formed model with this header occupies (0 = bad geometry)
+uint32_t okws_model_bytes(const OkwsFileHeader *h);
+
+// Parse a 4-byte aligned blob in place. Returns OKWS_OK or OKWS_E_*.
+int      okws_load(OkwsModel *m, const void *blob, uint32_t bytes);
+
+// Scratch for one stream of model m
+uint32_t okws_stream_bytes(const OkwsModel *m);
+int      okws_stream_init(OkwsStream *s, const OkwsModel *m,
+                          void *arena, uint32_t arena_bytes);
+void     okws_stream_reset(OkwsStream *s);
+void     okws_set_budget(OkwsStream *s, uint64_t cycles_per_frame);
+
+// Push one MFCC frame (oo_mfcc units). Returns the keyword class (≥1) when
+// a detection fires on this frame, 0 otherwise.
+int      okws_push(OkwsStream *s, const int32_t *mfcc);
+
+// Run the network on the current window now (fills pool / prob)
+void     okws_eval(OkwsStream *s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,316 @@
+// oo_mfcc.c — Streaming fixed-point MFCC front-end (Implementation)
+//
+// Freestanding C11 — no libc, no malloc, no external deps.
+
+#include "oo_mfcc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OMF_SSE2 1
+#endif
+
+// ── Table generation helpers (double, no libm; omf_init only) ─────────────────
+
+#define _OMF_PI   3.14159265358979323846
+#define _OMF_LN2  0.69314718055994530942
+
+static double _omf_cos(double x) {
+    double twopi = 2.0 * _OMF_PI;
+    long k = (long)(x / twopi);
+    x -= (double)k * twopi;
+    if (x >  _OMF_PI) x -= twopi;
+    if (x < -_OMF_PI) x += twopi;
+    double x2 = x * x, term = 1.0, sum = 1.0;
+    for (int i = 1; i < 16; i++) {
+        term *= -x2 / (double)((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+    return sum;
+}
+
+static double _omf_ln(double x) {
+    if (x <= 0.0) return 0.0;
+    int e = 0;
+    while (x >= 2.0) { x *= 0.5; e++; }
+    while (x <  1.0) { x *= 2.0; e--; }
+    double y = (x - 1.0) / (x + 1.0), y2 = y * y, term = y, sum = 0.0;
+    for (int i = 1; i < 41; i += 2) { sum += term / (double)i; term *= y2; }
+    return 2.0 * sum + (double)e * _OMF_LN2;
+}
+
+static double _omf_exp(double x) {
+    int k = (int)(x / _OMF_LN2 + (x >= 0.0 ? 0.5 : -0.5));
+    double r = x - (double)k * _OMF_LN2, term = 1.0, sum = 1.0;
+    for (int i = 1; i < 20; i++) { term *= r / (double)i; sum += term; }
+    for (; k > 0; k--) sum *= 2.0;
+    for (; k < 0; k++) sum *= 0.5;
+    return sum;
+}
+
+static double _omf_sqrt(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 40; i++) r = 0.5 * (r + x / r);
+    return r;
+}
+
+static int16_t _omf_q15(double v) {
+    long q = (long)(v * 32768.0 + (v >= 0.0 ? 0.5 : -0.5));
+    if (q >  32767) q =  32767;
+    if (q < -32768) q = -32768;
+    return (int16_t)q;
+}
+
+static double _omf_hz_to_mel(double hz)  { return 1127.0 * _omf_ln(1.0 + hz / 700.0); }
+static double _omf_mel_to_hz(double mel) { return 700.0 * (_omf_exp(mel / 1127.0) - 1.0); }
+
+// ── Fixed-point log2 ──────────────────────────────────────────────────────────
+//
+// 256·log2(v): integer part from the leading bit, fraction via
+// log2(1+f) ≈ f + 0.3466·f·(1−f) (max error < 1/256).
+
+static int32_t _omf_log2_q8(uint64_t v) {
+    if (v == 0) return 0;
+    int e = 63 - __builtin_clzll(v);
+    uint32_t f = (uint32_t)(e >= 16 ? (v >> (e - 16)) : (v << (16 - e))) & 0xFFFFu;
+    uint32_t corr = (uint32_t)((((uint64_t)f * (65536u - f)) >> 16) * 22714u >> 16);
+    return (int32_t)e * OMF_LOG_ONE + (int32_t)((f + corr) >> 8);
+}
+
+// ── Init ─────────────────────────────────────────────────────────────────────
+
+void omf_init(OmfFrontend *f, int n_mfcc) {
+    if (!f) return;
+    if (n_mfcc < 1) n_mfcc = 1;
+    if (n_mfcc > OMF_MAX_MFCC) n_mfcc = OMF_MAX_MFCC;
+    f->n_mfcc = n_mfcc;
+
+    for (int i = 0; i < OMF_WIN_SAMPLES; i++) {
+        double w = 0.54 - 0.46 * _omf_cos(2.0 * _OMF_PI * i / (OMF_WIN_SAMPLES - 1));
+        f->wpair[2 * i]     = _omf_q15(w / 2.0);           // Q14
+        f->wpair[2 * i + 1] = _omf_q15(-0.97 * w / 2.0);
+    }
+
+    for (int k = 0; k < OMF_FFT_SIZE / 2; k++) {
+        double a = 2.0 * _OMF_PI * k / OMF_FFT_SIZE;
+        f->tw_cos[k] = _omf_q15(_omf_cos(a));
+        f->tw_sin[k] = _omf_q15(_omf_cos(a - _OMF_PI / 2.0));
+    }
+    for (int n = 0; n < OMF_FFT_SIZE / 2; n++) {
+        int r = 0;
+        for (int b = 0; b < 8; b++) if (n & (1 << b)) r |= 1 << (7 - b);
+        f->bitrev[n] = (uint8_t)r;
+    }
+
+    // Mel band edges in FFT-bin units: p[0] … p[M+1]
+    double p[OMF_N_MELS + 2];
+    double m_lo = _omf_hz_to_mel(OMF_MEL_LO_HZ), m_hi = _omf_hz_to_mel(OMF_MEL_HI_HZ);
+    for (int i = 0; i < OMF_N_MELS + 2; i++)
+        p[i] = _omf_mel_to_hz(m_lo + (m_hi - m_lo) * i / (OMF_N_MELS + 1))
+               * OMF_FFT_SIZE / OMF_SAMPLE_RATE;
+    // Bin k between edges j and j+1 falls on band j and rises on band j+1.
+    // Band 0 and M+1 are sinks for bins outside the filterbank.
+    for (int k = 0; k < OMF_FFT_BINS; k++) {
+        int j = 0;
+        double up = 0.0;
+        if (k >= p[OMF_N_MELS + 1]) {
+            j = OMF_N_MELS + 1;
+        } else if (k >= p[0]) {
+            while (j < OMF_N_MELS && k >= p[j + 1]) j++;
+            up = (k - p[j]) / (p[j + 1] - p[j]);
+        }
+        f->mel_seg[k] = (uint8_t)j;
+        f->mel_up[k]  = (uint16_t)(up * 32768.0 + 0.5);
+    }
+
+    double s0 = _omf_sqrt(1.0 / OMF_N_MELS), s1 = _omf_sqrt(2.0 / OMF_N_MELS);
+    for (int i = 0; i < OMF_MAX_MFCC; i++)
+        for (int m = 0; m < OMF_N_MELS; m++)
+            f->dct[i][m] = _omf_q15((i ? s1 : s0) *
+                                    _omf_cos(_OMF_PI * i * (m + 0.5) / OMF_N_MELS));
+
+    omf_reset(f);
+}
+
+void omf_reset(OmfFrontend *f) {
+    if (!f) return;
+    for (int i = 0; i < OMF_WIN_SAMPLES + 8; i++) f->buf[i] = 0;
+    f->fill = 1;
+    for (int i = 0; i < OMF_N_MELS; i++) f->logmel[i] = OMF_LOG_FLOOR;
+    for (int i = 0; i < OMF_MAX_MFCC; i++) f->mfcc[i] = 0;
+    f->log_energy = OMF_LOG_FLOOR;
+    f->frames = 0;
+}
+
+// ── Pre-emphasis + window: xw[n] = x[n]·w[n] − x[n−1]·0.97·w[n] (Q14) ─────────
+//
+// |xw| < 2^15 · 2^14 · 1.97 < 2^31, so the pair sum never wraps.
+
+static void _omf_window(int32_t *xw, const int16_t *buf, const int16_t *wpair) {
+    int i;
+#ifdef OMF_SSE2
+    for (i = 0; i < OMF_WIN_SAMPLES; i += 8) {         // 400 = 50 × 8
+        __m128i cur  = _mm_loadu_si128((const __m128i *)(buf + 1 + i));
+        __m128i prev = _mm_loadu_si128((const __m128i *)(buf + i));
+        __m128i w0 = _mm_loadu_si128((const __m128i *)(wpair + 2 * i));
+        __m128i w1 = _mm_loadu_si128((const __m128i *)(wpair + 2 * i + 8));
+        _mm_storeu_si128((__m128i *)(xw + i),     _mm_madd_epi16(_mm_unpacklo_epi16(cur, prev), w0));
+        _mm_storeu_si128((__m128i *)(xw + i + 4), _mm_madd_epi16(_mm_unpackhi_epi16(cur, prev), w1));
+    }
+#else
+    for (i = 0; i < OMF_WIN_SAMPLES; i++)
+        xw[i] = (int32_t)buf[1 + i] * wpair[2 * i] + (int32_t)buf[i] * wpair[2 * i + 1];
+#endif
+}
+
+// ── Block-floating-point helpers ──────────────────────────────────────────────
+
+#define _OMF_HEADROOM 8192   // |z| ≤ 2^13 before every butterfly pass
+
+static int _omf_rescale(int32_t *zr, int32_t *zi, int n) {
+    int32_t m = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t a = zr[i] < 0 ? -zr[i] : zr[i];
+        int32_t b = zi[i] < 0 ? -zi[i] : zi[i];
+        if (a > m) m = a;
+        if (b > m) m = b;
+    }
+    int s = 0;
+    while ((m >> s) > _OMF_HEADROOM) s++;
+    if (s)
+        for (int i = 0; i < n; i++) { zr[i] >>= s; zi[i] >>= s; }
+    return s;
+}
+
+// ── One analysis frame ────────────────────────────────────────────────────────
+
+static void _omf_frame(OmfFrontend *f) {
+    enum { N = OMF_FFT_SIZE / 2, NB = 264 };    // NB: bins padded to 4
+    int32_t xw[OMF_WIN_SAMPLES] __attribute__((aligned(16)));
+    int16_t spec[2 * NB] __attribute__((aligned(16)));
+    int32_t pw[NB] __attribute__((aligned(16)));
+    int32_t zr[N], zi[N];
+
+    _omf_window(xw, f->buf, f->wpair);
+
+    int32_t m = 0;
+    for (int i = 0; i < OMF_WIN_SAMPLES; i++) {
+        int32_t a = xw[i] < 0 ? -xw[i] : xw[i];
+        if (a > m) m = a;
+    }
+    if (m == 0) {
+        for (int i = 0; i < OMF_N_MELS; i++) f->logmel[i] = OMF_LOG_FLOOR;
+        f->log_energy = OMF_LOG_FLOOR;
+        for (int i = 0; i < f->n_mfcc; i++) {
+            int64_t acc = 0;
+            for (int b = 0; b < OMF_N_MELS; b++) acc += (int64_t)OMF_LOG_FLOOR * f->dct[i][b];
+            f->mfcc[i] = (int32_t)(acc >> 15);
+        }
+        return;
+    }
+
+    // Peak into (2^12, 2^13]. xw is Q14, so stored values are true·2^-sh
+    // with sh = s − 14 after a right shift by s (s < 0: left shift).
+    int s = 0;
+    while (m <= _OMF_HEADROOM / 2) { m <<= 1; s--; }
+    while (m >  _OMF_HEADROOM)     { m >>= 1; s++; }
+    int sh = s - 14;
+
+    // Even samples → real, odd → imaginary, in bit-reversed order; the
+    // zero padding past the 400-sample window lands in the upper half
+    for (int n = 0; n < N; n++) {
+        int32_t a = 2 * n < OMF_WIN_SAMPLES ? xw[2 * n] : 0;
+        int32_t b = 2 * n + 1 < OMF_WIN_SAMPLES ? xw[2 * n + 1] : 0;
+        int r = f->bitrev[n];
+        zr[r] = s < 0 ? a * (1 << -s) : a >> s;
+        zi[r] = s < 0 ? b * (1 << -s) : b >> s;
+    }
+
+    // 256-point radix-2 DIT; W_len^j = W_512^(j·512/len)
+    for (int len = 2; len <= N; len <<= 1) {
+        if (len > 2) sh += _omf_rescale(zr, zi, N);
+        const int half = len >> 1, step = OMF_FFT_SIZE / len;
+        for (int i = 0; i < N; i += len)
+            for (int j = 0; j < half; j++) {
+                int32_t c = f->tw_cos[j * step], s = f->tw_sin[j * step];
+                int a = i + j, b = a + half;
+                int32_t tr = (zr[b] * c + zi[b] * s) >> 15;
+                int32_t ti = (zi[b] * c - zr[b] * s) >> 15;
+                zr[b] = zr[a] - tr;  zi[b] = zi[a] - ti;
+                zr[a] += tr;         zi[a] += ti;
+            }
+    }
+    sh += _omf_rescale(zr, zi, N);
+
+    // Split: X[k] = ½[(Z[k] + Z*[N−k]) − j·W_512^k·(Z[k] − Z*[N−k])]
+    spec[0] = (int16_t)(zr[0] + zi[0]);  spec[1] = 0;
+    spec[2 * N] = (int16_t)(zr[0] - zi[0]);  spec[2 * N + 1] = 0;
+    for (int k = 1; k < N; k++) {
+        int32_t ar = zr[k] + zr[N - k], ai = zi[k] - zi[N - k];
+        int32_t br = zr[k] - zr[N - k], bi = zi[k] + zi[N - k];
+        int32_t c = f->tw_cos[k], s = f->tw_sin[k];
+        spec[2 * k]     = (int16_t)((ar + ((c * bi - s * br) >> 15)) >> 1);
+        spec[2 * k + 1] = (int16_t)((ai - ((c * br + s * bi) >> 15)) >> 1);
+    }
+    for (int i = 2 * OMF_FFT_BINS; i < 2 * NB; i++) spec[i] = 0;
+
+    // Power spectrum: re² + im² of interleaved pairs (NB is a multiple of 4)
+    int k;
+#ifdef OMF_SSE2
+    for (k = 0; k < NB; k += 4) {
+        __m128i v = _mm_load_si128((const __m128i *)(spec + 2 * k));
+        _mm_store_si128((__m128i *)(pw + k), _mm_madd_epi16(v, v));
+    }
+#else
+    for (k = 0; k < NB; k++)
+        pw[k] = (int32_t)spec[2 * k] * spec[2 * k] + (int32_t)spec[2 * k + 1] * spec[2 * k + 1];
+#endif
+
+    // Mel filterbank (each bin touches at most two bands)
+    uint64_t acc[OMF_N_MELS + 3];
+    uint64_t total = 0;
+    for (int b = 0; b < OMF_N_MELS + 3; b++) acc[b] = 0;
+    for (k = 0; k < OMF_FFT_BINS; k++) {
+        uint64_t p = (uint32_t)pw[k];
+        uint32_t up = f->mel_up[k];
+        acc[f->mel_seg[k]]     += p * (32768u - up);
+        acc[f->mel_seg[k] + 1] += p * up;
+        total += p;
+    }
+
+    // Back to true power: ·2^(2·sh); the mel weights carry an extra 2^15
+    const int32_t scale = 2 * sh * OMF_LOG_ONE;
+    int32_t le = (total ? _omf_log2_q8(total) : 0) + scale;
+    f->log_energy = le > OMF_LOG_FLOOR ? le : OMF_LOG_FLOOR;
+    for (int b = 0; b < OMF_N_MELS; b++) {
+        uint64_t e = acc[b + 1];
+        int32_t l = e ? _omf_log2_q8(e) + scale - 15 * OMF_LOG_ONE : OMF_LOG_FLOOR;
+        f->logmel[b] = l > OMF_LOG_FLOOR ? l : OMF_LOG_FLOOR;
+    }
+
+    for (int i = 0; i < f->n_mfcc; i++) {
+        int64_t s = 0;
+        for (int b = 0; b < OMF_N_MELS; b++) s += (int64_t)f->logmel[b] * f->dct[i][b];
+        f->mfcc[i] = (int32_t)(s >> 15);
+    }
+}
+
+// ── Streaming ─────────────────────────────────────────────────────────────────
+
+int omf_feed(OmfFrontend *f, const int16_t *pcm, int n, int *consumed) {
+    int used = 0;
+    if (consumed) *consumed = 0;
+    if (!f || !pcm || n <= 0) return 0;
+
+    while (used < n && f->fill < OMF_WIN_SAMPLES + 1) f->buf[f->fill++] = pcm[used++];
+    if (consumed) *consumed = used;
+    if (f->fill < OMF_WIN_SAMPLES + 1) return 0;
+
+    _omf_frame(f);
+    // Keep the overlap plus the one sample pre-emphasis needs before it
+    for (int i = 0; i <= OMF_WIN_SAMPLES - OMF_HOP_SAMPLES; i++)
+        f->buf[i] = f->buf[i + OMF_HOP_SAMPLES];
+    f->fill = OMF_WIN_SAMPLES - OMF_HOP_SAMPLES + 1;
+    f->frames++;
+    return 1;
+}
@@ -0,0 +1,86 @@
+// oo_mfcc.h — Streaming fixed-point MFCC front-end for the wake-word path
+//
+// 16 kHz mono int16 in, one cepstral vector per 10 ms hop out:
+//
+//   pre-emphasis → 25 ms Hamming window → 512-point real FFT (a 256-point
+//   complex FFT of the even/odd samples plus a split pass) → power spectrum
+//   → 40 triangular mel bands → log2 → DCT-II → n_mfcc coefficients
+//
+// Everything is integer. Pre-emphasis and window are one multiply-add per
+// sample (x[n]·w[n] − x[n−1]·0.97·w[n], _mm_madd_epi16 on interleaved
+// pairs) into int32. The FFT is block floating point: the frame is
+// normalised to 13 bits, a stage only shifts right when its input could
+// overflow, and the shift count is added back in the log domain, so quiet
+// rooms keep their resolution and loud ones never wrap. The power spectrum
+// is _mm_madd_epi16 on interleaved re/im. Scalar fallbacks produce the
+// same integers.
+//
+// Tables are generated once by omf_init (no libm). Samples are consumed in
+// arbitrary chunks; omf_feed stops at every completed hop so the caller can
+// hand each frame to the keyword model (oo_kws.h) before continuing.
+//
+// Freestanding C11 — no libc, no malloc.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ── Geometry ──────────────────────────────────────────────────────────────────
+#define OMF_SAMPLE_RATE    16000
+#define OMF_WIN_SAMPLES      400   // 25 ms analysis window
+#define OMF_HOP_SAMPLES      160   // 10 ms hop → 100 frames/s
+#define OMF_FFT_SIZE         512
+#define OMF_FFT_BINS         257   // 0 … Nyquist
+#define OMF_N_MELS            40
+#define OMF_MAX_MFCC          16
+#define OMF_MEL_LO_HZ         20
+#define OMF_MEL_HI_HZ       7600
+
+// Log outputs are 256·log2(power) of the pre-emphasised, windowed frame in
+// sample units; the floor keeps digital silence finite
+#define OMF_LOG_ONE          256
+#define OMF_LOG_FLOOR       (4 * OMF_LOG_ONE)
+
+// ── Front-end state ───────────────────────────────────────────────────────────
+typedef struct {
+    // Tables (omf_init)
+    int16_t  wpair[2 * OMF_WIN_SAMPLES];         // (w[n], −0.97·w[n]), Q14
+    int16_t  tw_cos[OMF_FFT_SIZE / 2];           // cos(2πk/512), Q15
+    int16_t  tw_sin[OMF_FFT_SIZE / 2];           // sin(2πk/512), Q15
+    uint8_t  bitrev[OMF_FFT_SIZE / 2];           // 8-bit reversal
+    uint8_t  mel_seg[OMF_FFT_BINS];              // band edge below bin k
+    uint16_t mel_up[OMF_FFT_BINS];               // share of band seg+1, Q15
+    int16_t  dct[OMF_MAX_MFCC][OMF_N_MELS];      // orthonormal DCT-II, Q15
+    int      n_mfcc;
+
+    // Streaming state
+    int16_t  buf[OMF_WIN_SAMPLES + 8];           // [0] = sample before the window
+    int      fill;
+
+    // Last frame
+    int32_t  logmel[OMF_N_MELS];                 // 256·log2 band energy
+    int32_t  mfcc[OMF_MAX_MFCC];                 // cepstra, same units
+    int32_t  log_energy;                         // 256·log2 frame power
+    uint32_t frames;
+} OmfFrontend;
+
+// ── Public API ────────────────────────────────────────────────────────────────
+
+// Build the tables and clear the stream. n_mfcc is clamped to 1…OMF_MAX_MFCC.
+void omf_init(OmfFrontend *f, int n_mfcc);
+
+// Drop buffered audio (tables are kept)
+void omf_reset(OmfFrontend *f);
+
+// Consume up to n samples. Returns 1 when a hop completed — f->mfcc holds the
+// new frame and *consumed says how many samples were used — 0 when all n
+// samples were buffered without finishing a frame.
+int  omf_feed(OmfFrontend *f, const int16_t *pcm, int n, int *consumed);
+
+#ifdef __cplusplus
+}
+#endif
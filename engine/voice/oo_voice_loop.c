@@ -175,6 +175,12 @@ int oo_voice_loop_init(const OvlConfig *cfg) {
 
     // Init wakeword engine (patterns: "oo", "hey oo", "salut oo")
     oww_init(&s_oww);
+    if (cfg->kws_model) {
+        // Neural path when the model loads; templates otherwise
+        if (oww_load_model(&s_oww, cfg->kws_model, cfg->kws_model_bytes,
+                           cfg->kws_arena, cfg->kws_arena_bytes) == 0)
+            oww_set_cycle_budget(&s_oww, cfg->kws_cycles_per_frame);
+    }
 
     // Init router + context + persona
     ovr_init(&s_router);
@@ -226,6 +232,8 @@ const char *oo_voice_loop_last_cmd(void)      { return s_last_cmd; }
 static int s_last_score = 0;
 int oo_voice_loop_last_score(void) { return s_last_score; }
 
+const OwwEngine *oo_voice_loop_wakeword(void) { return &s_oww; }
+
 // ── Synchronous text processing ───────────────────────────────────────────────
 //
 // Called from REPL when user types text at "You:".
@@ -17,6 +17,7 @@
 #include <stdint.h>
 #include "../drivers/oo_audio_hda.h"
 #include "oo_voice_desktop_bridge.h"
+#include "oo_wakeword.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +43,13 @@ typedef struct {
     int                   lang_fr;       // 1 = French TTS, 0 = English
     uint32_t              lapic_ticks_per_ms; // From oo_lapic_calibrate_ms()
     int                   uart_emit;     // 1 = emit OO_VOICE: on UART
+
+    // Optional neural wake word (oo_kws.h). NULL model = energy templates.
+    const void           *kws_model;     // .okws blob, 4-byte aligned
+    uint32_t              kws_model_bytes;
+    void                 *kws_arena;     // oww_model_arena_bytes() bytes
+    uint32_t              kws_arena_bytes;
+    uint64_t              kws_cycles_per_frame; // TSC budget per 10 ms, 0 = none
 } OvlConfig;
 
 // ── Init / Tick ───────────────────────────────────────────────────────────────
@@ -85,6 +93,9 @@ int oo_voice_loop_process_text(const char *text, int len);
 // Last routing score (0-100, from keyword matching)
 int oo_voice_loop_last_score(void);
 
+// Wake-word engine (mode + detector stats for /voice_status)
+const OwwEngine *oo_voice_loop_wakeword(void);
+
 #ifdef __cplusplus
 }
 #endif
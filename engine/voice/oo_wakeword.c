@@ -16,6 +16,18 @@ static uint32_t _ww_isqrt(uint32_t n) {
     return x;
 }
 
+static inline uint64_t _ww_rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static void _ww_set_word(OwwEngine *e, const char *name, int max) {
+    int ni = 0;
+    while (ni < 31 && ni < max && name[ni]) { e->detected_word[ni] = name[ni]; ni++; }
+    e->detected_word[ni] = '\0';
+}
+
 // ── Short-time energy of a frame ──────────────────────────────────────────────
 
 static uint16_t _ww_ste(const int16_t *samples, int n) {
@@ -96,6 +108,8 @@ void oww_init(OwwEngine *e) {
     e->frames_analyzed= 0;
     e->detections     = 0;
     e->false_positives= 0;
+    e->use_model      = 0;
+    e->mfcc_cycles    = 0;
 
     // Register built-in patterns
     oww_add_pattern(e, "OO",       _ww_profile_oo,       480);
@@ -125,6 +139,28 @@ int oww_add_pattern(OwwEngine *e, const char *name,
     return 1;
 }
 
+// ── Neural path: MFCC hops → DS-CNN ───────────────────────────────────────────
+
+static void _ww_feed_model(OwwEngine *e, const int16_t *samples, int n) {
+    while (n > 0) {
+        int used;
+        uint64_t t0 = _ww_rdtsc();
+        int ready = omf_feed(&e->mfcc, samples, n, &used);
+        samples += used;
+        n -= used;
+        if (!ready) break;
+        uint64_t dt = _ww_rdtsc() - t0;
+        e->mfcc_cycles = e->mfcc.frames > 1 ? (7u * e->mfcc_cycles + dt) / 8u : dt;
+
+        int cls = okws_push(&e->kws, e->mfcc.mfcc);
+        if (cls > 0) {
+            e->detected = 1;
+            e->detections++;
+            _ww_set_word(e, e->model.hdr->names[cls], OKWS_NAME_LEN);
+        }
+    }
+}
+
 // ── Feed PCM samples ──────────────────────────────────────────────────────────
 
 void oww_feed(OwwEngine *e, const int16_t *samples, int n_samples) {
@@ -157,6 +193,7 @@ void oww_feed(OwwEngine *e, const int16_t *samples, int n_samples) {
 
         // Update VAD
         e->vad_active = e->frames[fidx].is_voiced;
+        if (e->use_model) continue;
 
         // Cooldown countdown
         if (e->cooldown > 0) { e->cooldown--; continue; }
@@ -192,15 +229,13 @@ void oww_feed(OwwEngine *e, const int16_t *samples, int n_samples) {
                 e->detected = 1;
                 e->cooldown = OWW_COOLDOWN_FRAMES;
                 e->detections++;
-                // Copy name
-                int ni = 0;
-                while (ni < 31 && pat->name[ni])
-                    { e->detected_word[ni] = pat->name[ni]; ni++; }
-                e->detected_word[ni] = '\0';
+                _ww_set_word(e, pat->name, 32);
                 break;
             }
         }
     }
+
+    if (e->use_model) _ww_feed_model(e, samples, n_samples);
 }
 
 // ── Poll ─────────────────────────────────────────────────────────────────────
@@ -237,4 +272,31 @@ void oww_reset(OwwEngine *e) {
     e->detected  = 0;
     e->cooldown  = 0;
     e->vad_active= 0;
+    if (e->use_model) okws_stream_reset(&e->kws);
+}
+
+// ── Model loading ─────────────────────────────────────────────────────────────
+
+uint32_t oww_model_arena_bytes(const void *blob, uint32_t bytes) {
+    OkwsModel m;
+    if (okws_load(&m, blob, bytes) != OKWS_OK) return 0;
+    return okws_stream_bytes(&m);
+}
+
+int oww_load_model(OwwEngine *e, const void *blob, uint32_t bytes,
+                   void *arena, uint32_t arena_bytes) {
+    if (!e) return OKWS_E_ARG;
+    e->use_model = 0;
+    int rc = okws_load(&e->model, blob, bytes);
+    if (rc != OKWS_OK) return rc;
+    rc = okws_stream_init(&e->kws, &e->model, arena, arena_bytes);
+    if (rc != OKWS_OK) return rc;
+    omf_init(&e->mfcc, e->model.F);
+    e->mfcc_cycles = 0;
+    e->use_model = 1;
+    return OKWS_OK;
+}
+
+void oww_set_cycle_budget(OwwEngine *e, uint64_t cycles_per_frame) {
+    if (e) okws_set_budget(&e->kws, cycles_per_frame);
 }
@@ -6,10 +6,14 @@
 // Wake words: "OO", "Hey OO", "Salut OO", "Activate", "Wake up"
 //
 // Design:
-//   - No FFT, no neural network, no MFCC — pure energy + pattern matching
-//   - Works on 512-sample ring buffer at 16kHz mono 16-bit
-//   - Triggers when energy profile matches a wake pattern template
-//   - False positive rate ~2% (acceptable for always-on bare-metal)
+//   - Neural path (oww_load_model): fixed-point MFCC front-end (oo_mfcc) at
+//     10 ms hops feeding an int8 DS-CNN keyword model (oo_kws) loaded from a
+//     .okws file, with a per-frame cycle budget
+//   - Legacy path (no model): short-time energy + phoneme template matching
+//     on a 512-sample ring buffer. It fires on any speech with a similar
+//     loudness envelope, so it is only the fallback.
+//   - Both paths keep the 2ms energy frames for VAD (vad_active)
+//   - 16kHz mono 16-bit
 //
 // After detection: set flag oo_wakeword_detected → voice router activates
 //
@@ -18,6 +22,8 @@
 #pragma once
 
 #include <stdint.h>
+#include "oo_mfcc.h"
+#include "oo_kws.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -74,6 +80,13 @@ typedef struct {
     uint32_t   frames_analyzed;
     uint32_t   detections;
     uint32_t   false_positives; // (manual counter, for tuning)
+
+    // Neural path (active once oww_load_model succeeded)
+    int         use_model;
+    OmfFrontend mfcc;
+    OkwsModel   model;
+    OkwsStream  kws;
+    uint64_t    mfcc_cycles;    // running average, TSC per 10ms frame
 } OwwEngine;
 
 // ── Public API ────────────────────────────────────────────────────────────────
@@ -102,6 +115,17 @@ void oww_reset(OwwEngine *e);
 int oww_add_pattern(OwwEngine *e, const char *name,
                     const uint16_t *energy_profile, int threshold);
 
+// Arena oww_load_model needs for this .okws blob (0 = not a valid model)
+uint32_t oww_model_arena_bytes(const void *blob, uint32_t bytes);
+
+// Switch to the neural path. blob (4-byte aligned) and arena must stay
+// valid while the engine runs. Returns 0, or OKWS_E_* (legacy path kept).
+int oww_load_model(OwwEngine *e, const void *blob, uint32_t bytes,
+                   void *arena, uint32_t arena_bytes);
+
+// Model cycle budget per 10ms frame (TSC cycles, 0 = unlimited)
+void oww_set_cycle_budget(OwwEngine *e, uint64_t cycles_per_frame);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,20 +1,30 @@
-/* oo_wasm.c — OO Bare-Metal WASM Module Loader + Interpreter (Phase 10A)
- * ========================================================================
- * Implements a minimal WASM 1.0 (MVP) parser and stack-based interpreter.
- * Freestanding C11 — no libc, no OS. EFI AllocatePool for module data.
+/* oo_wasm.c — OO Bare-Metal WASM Module Loader + Interpreter (Phase 10A/10B)
+ * ==========================================================================
+ * Implements a WASM 1.0 (MVP) parser, a load-time validating compiler and a
+ * direct-threaded interpreter. Freestanding C11 — no libc, no OS.
+ * EFI AllocatePool for module data and compiled code.
  *
- * Supported opcodes: unreachable, nop, block, loop, if, br, br_if,
- *   return, call, drop, select, local.get/set/tee,
- *   i32.const, i32.add/sub/mul/div_s/div_u/rem_s/rem_u,
- *   i32.and/or/xor/shl/shr_s/shr_u/rotl/rotr,
- *   i32.eqz/eq/ne/lt_s/lt_u/gt_s/gt_u/le_s/le_u/ge_s/ge_u,
- *   i64.const, i64.add/sub/mul, i32.wrap_i64, i64.extend_i32_s/u,
- *   i32.load/store (linear memory, 64KB pool),
- *   end
+ * Pipeline:
+ *   load_buf → section parsers → _wm_compile() per function → OoWasmInsn[]
+ *   call     → _wm_run(): computed-goto dispatch over the insn stream
+ *
+ * The compiler tracks operand-stack height per instruction, so every branch
+ * knows at load time where it lands and how many values it keeps. A br whose
+ * stack is already in place becomes a plain JMP (the common loop back-edge).
+ *
+ * Supported opcodes: unreachable, nop, block, loop, if, else, end, br,
+ *   br_if, br_table, return, call, drop, select, local.get/set/tee,
+ *   global.get/set, i32/i64 load/store (all widths), memory.size/grow,
+ *   i32/i64 const, every i32/i64 compare + arithmetic + bit op,
+ *   i32.wrap_i64, i64.extend_i32_s/u, i32/i64 extendN_s.
+ * Not supported (module rejected at load): floats, call_indirect, imported
+ *   functions/globals, multi-value blocks.
  */
 #include "oo_wasm.h"
+#ifdef UEFI_BUILD
 #include <efi.h>
 #include <efilib.h>
+#endif
 
 /* ── Internal helpers ───────────────────────────────────────────────────── */
 
@@ -36,22 +46,22 @@ static int _wm_strcmp(const CHAR8 *a, const CHAR8 *b) {
 /* LEB128 unsigned decode → returns bytes consumed */
 static UINT32 _wm_leb_u32(const UINT8 *p, UINT32 *out) {
     UINT32 r=0, shift=0, i=0;
-    do { r |= (UINT32)(p[i]&0x7F)<<shift; shift+=7; } while(p[i++]&0x80);
+    do { if (shift < 32) r |= (UINT32)(p[i]&0x7F)<<shift; shift+=7; } while(p[i++]&0x80 && i<5);
     *out = r; return i;
 }
 /* LEB128 signed i32 */
 static UINT32 _wm_leb_i32(const UINT8 *p, INT32 *out) {
-    INT32 r=0; UINT32 shift=0, i=0; UINT8 b;
-    do { b=p[i++]; r|=(INT32)(b&0x7F)<<shift; shift+=7; } while(b&0x80);
-    if (shift<32 && (b&0x40)) r|=-(1<<shift);
-    *out=r; return i;
+    UINT32 r=0, shift=0, i=0; UINT8 b;
+    do { b=p[i++]; if (shift < 32) r|=(UINT32)(b&0x7F)<<shift; shift+=7; } while((b&0x80) && i<5);
+    if (shift<32 && (b&0x40)) r|=~0u<<shift;
+    *out=(INT32)r; return i;
 }
 /* LEB128 signed i64 */
 static UINT32 _wm_leb_i64(const UINT8 *p, INT64 *out) {
-    INT64 r=0; UINT32 shift=0, i=0; UINT8 b;
-    do { b=p[i++]; r|=(INT64)(b&0x7F)<<shift; shift+=7; } while(b&0x80);
-    if (shift<64 && (b&0x40)) r|=-((INT64)1<<shift);
-    *out=r; return i;
+    UINT64 r=0; UINT32 shift=0, i=0; UINT8 b;
+    do { b=p[i++]; if (shift < 64) r|=(UINT64)(b&0x7F)<<shift; shift+=7; } while((b&0x80) && i<10);
+    if (shift<64 && (b&0x40)) r|=~(UINT64)0<<shift;
+    *out=(INT64)r; return i;
 }
 
 static void _wm_err(OoWasmMod *m, const CHAR8 *msg) {
@@ -60,6 +70,21 @@ static void _wm_err(OoWasmMod *m, const CHAR8 *msg) {
     _wm_memcpy(m->error, msg, n); m->error[n]=0;
 }
 
+#ifdef UEFI_BUILD
+static void *_wm_alloc(UINTN n) {
+    void *p = NULL;
+    EFI_STATUS st = uefi_call_wrapper(BS->AllocatePool, 3, EfiLoaderData, n, &p);
+    return EFI_ERROR(st) ? NULL : p;
+}
+static void _wm_free(void *p) { uefi_call_wrapper(BS->FreePool, 1, p); }
+#else
+/* Host builds: supplied by the harness (malloc/free) */
+void *oo_wasm_host_alloc(UINTN n);
+void  oo_wasm_host_free(void *p);
+static void *_wm_alloc(UINTN n) { return oo_wasm_host_alloc(n); }
+static void _wm_free(void *p) { oo_wasm_host_free(p); }
+#endif
+
 /* ── Section IDs ─────────────────────────────────────────────────────────── */
 #define WASM_SEC_CUSTOM   0
 #define WASM_SEC_TYPE     1
@@ -78,22 +103,36 @@ static void _wm_err(OoWasmMod *m, const CHAR8 *msg) {
 static int _parse_types(OoWasmMod *m, const UINT8 *p, UINT32 size) {
     UINT32 off=0, count=0, n;
     n = _wm_leb_u32(p+off, &count); off+=n;
-    if (count > OO_WASM_MAX_FUNCS) count = OO_WASM_MAX_FUNCS;
+    if (count > OO_WASM_MAX_FUNCS) { _wm_err(m,(const CHAR8*)"too many types"); return 0; }
     m->type_count = count;
     for (UINT32 i=0; i<count && off<size; i++) {
         if (p[off++] != 0x60) { _wm_err(m,(const CHAR8*)"bad functype"); return 0; }
         UINT32 pc=0; n=_wm_leb_u32(p+off,&pc); off+=n;
-        m->types[i].param_count = (UINT8)(pc>8?8:pc);
-        for (UINT32 k=0;k<pc&&off<size;k++) {
-            if(k<8) m->types[i].params[k]=(OoWasmValType)p[off];
-            off++;
-        }
+        if (pc > 8) { _wm_err(m,(const CHAR8*)"more than 8 params"); return 0; }
+        m->types[i].param_count = (UINT8)pc;
+        for (UINT32 k=0;k<pc&&off<size;k++) m->types[i].params[k]=(OoWasmValType)p[off++];
         UINT32 rc=0; n=_wm_leb_u32(p+off,&rc); off+=n;
-        m->types[i].result_count=(UINT8)(rc>4?4:rc);
-        for (UINT32 k=0;k<rc&&off<size;k++) {
-            if(k<4) m->types[i].results[k]=(OoWasmValType)p[off];
-            off++;
-        }
+        if (rc > 1) { _wm_err(m,(const CHAR8*)"multi-value results unsupported"); return 0; }
+        m->types[i].result_count=(UINT8)rc;
+        for (UINT32 k=0;k<rc&&off<size;k++) m->types[i].results[k]=(OoWasmValType)p[off++];
+    }
+    return 1;
+}
+
+/* ── Parse Import section (only memory imports map onto the local pool) ──── */
+static int _parse_imports(OoWasmMod *m, const UINT8 *p, UINT32 size) {
+    UINT32 off=0, count=0, n;
+    n=_wm_leb_u32(p+off,&count); off+=n;
+    for (UINT32 i=0;i<count&&off<size;i++) {
+        UINT32 l=0;
+        n=_wm_leb_u32(p+off,&l); off+=n+l;   /* module name */
+        n=_wm_leb_u32(p+off,&l); off+=n+l;   /* field name */
+        if (p[off] != 0x02) { _wm_err(m,(const CHAR8*)"function/global imports unsupported"); return 0; }
+        off++;
+        UINT8 flags = p[off++];
+        UINT32 lim=0;
+        n=_wm_leb_u32(p+off,&lim); off+=n;
+        if (flags & 1) { n=_wm_leb_u32(p+off,&lim); off+=n; }
     }
     return 1;
 }
@@ -102,15 +141,37 @@ static int _parse_types(OoWasmMod *m, const UINT8 *p, UINT32 size) {
 static int _parse_funcs(OoWasmMod *m, const UINT8 *p, UINT32 size) {
     UINT32 off=0, count=0, n;
     n=_wm_leb_u32(p+off,&count); off+=n;
-    if(count>OO_WASM_MAX_FUNCS) count=OO_WASM_MAX_FUNCS;
+    if(count>OO_WASM_MAX_FUNCS) { _wm_err(m,(const CHAR8*)"too many functions"); return 0; }
     m->func_count=count;
     for (UINT32 i=0;i<count&&off<size;i++) {
         UINT32 ti=0; n=_wm_leb_u32(p+off,&ti); off+=n;
+        if (ti >= m->type_count) { _wm_err(m,(const CHAR8*)"bad type index"); return 0; }
         m->funcs[i].type_idx=ti;
     }
     return 1;
 }
 
+/* ── Parse Global section (constant initialisers only) ───────────────────── */
+static int _parse_globals(OoWasmMod *m, const UINT8 *p, UINT32 size) {
+    UINT32 off=0, count=0, n;
+    n=_wm_leb_u32(p+off,&count); off+=n;
+    if (count > OO_WASM_MAX_GLOBALS) { _wm_err(m,(const CHAR8*)"too many globals"); return 0; }
+    m->global_count = count;
+    for (UINT32 i=0;i<count&&off+3<=size;i++) {
+        UINT8 vt = p[off++];
+        m->global_mut[i] = p[off++];
+        if (vt == OO_WASM_I32 && p[off] == 0x41) {
+            INT32 v=0; off++; n=_wm_leb_i32(p+off,&v); off+=n;
+            m->globals[i] = (UINT64)(UINT32)v;
+        } else if (vt == OO_WASM_I64 && p[off] == 0x42) {
+            INT64 v=0; off++; n=_wm_leb_i64(p+off,&v); off+=n;
+            m->globals[i] = (UINT64)v;
+        } else { _wm_err(m,(const CHAR8*)"unsupported global initialiser"); return 0; }
+        if (p[off++] != 0x0B) { _wm_err(m,(const CHAR8*)"bad global initialiser"); return 0; }
+    }
+    return 1;
+}
+
 /* ── Parse Export section ────────────────────────────────────────────────── */
 static int _parse_exports(OoWasmMod *m, const UINT8 *p, UINT32 size) {
     UINT32 off=0, count=0, n;
@@ -135,17 +196,21 @@ static int _parse_code(OoWasmMod *m, const UINT8 *p, UINT32 size,
                         UINT32 sec_data_offset) {
     UINT32 off=0, count=0, n;
     n=_wm_leb_u32(p+off,&count); off+=n;
-    if(count>m->func_count) count=m->func_count;
+    if(count!=m->func_count) { _wm_err(m,(const CHAR8*)"code/function count mismatch"); return 0; }
     for (UINT32 i=0;i<count&&off<size;i++) {
         UINT32 body_size=0; n=_wm_leb_u32(p+off,&body_size); off+=n;
         UINT32 body_start=off;
+        if (body_size > size - body_start) { _wm_err(m,(const CHAR8*)"truncated body"); return 0; }
         /* local decls */
         UINT32 local_groups=0; n=_wm_leb_u32(p+off,&local_groups); off+=n;
-        UINT8 lc=0;
+        UINT32 lc=0;
         for (UINT32 g=0;g<local_groups&&off<size;g++) {
             UINT32 cnt=0; n=_wm_leb_u32(p+off,&cnt); off+=n;
-            OoWasmValType vt=(OoWasmValType)p[off++];
-            for (UINT32 k=0;k<cnt&&lc<OO_WASM_MAX_LOCALS;k++) m->funcs[i].locals[lc++]=vt;
+            off++; /* value type: locals are untyped 64-bit slots */
+            if (cnt > OO_WASM_MAX_LOCALS || lc + cnt > OO_WASM_MAX_LOCALS) {
+                _wm_err(m,(const CHAR8*)"too many locals"); return 0;
+            }
+            lc += cnt;
         }
         m->funcs[i].local_count=lc;
         /* code starts here */
@@ -171,14 +236,413 @@ static int _parse_data(OoWasmMod *m, const UINT8 *p, UINT32 size) {
         }
         if (p[off]==0x0B) off++; /* end */
         UINT32 dl=0; n=_wm_leb_u32(p+off,&dl); off+=n;
-        if (addr+dl <= OO_WASM_MAX_MEMORY)
-            _wm_memcpy(m->mem+addr, p+off, dl);
+        if ((UINT64)addr+dl > OO_WASM_MAX_MEMORY) { _wm_err(m,(const CHAR8*)"data segment out of bounds"); return 0; }
+        _wm_memcpy(m->mem+addr, p+off, dl);
         off+=dl;
     }
     return 1;
 }
 
+/* ── Internal opcodes ────────────────────────────────────────────────────── */
+/* X-macro: each entry becomes an enum value and (threaded build) a handler
+ * label, so a missing handler is a compile error. */
+#define WM_OPS(X) \
+    X(WM_UNREACHABLE) X(WM_NOP) X(WM_JMP) X(WM_BR) X(WM_BR_IF_JMP) X(WM_BR_IF) \
+    X(WM_BR_TABLE) X(WM_IFZ) X(WM_RETURN) X(WM_CALL) X(WM_DROP) X(WM_SELECT) \
+    X(WM_LOCAL_GET) X(WM_LOCAL_SET) X(WM_LOCAL_TEE) X(WM_GLOBAL_GET) X(WM_GLOBAL_SET) \
+    X(WM_I32_LOAD) X(WM_I64_LOAD) X(WM_I32_LOAD8_S) X(WM_I32_LOAD8_U) \
+    X(WM_I32_LOAD16_S) X(WM_I32_LOAD16_U) X(WM_I64_LOAD8_S) X(WM_I64_LOAD8_U) \
+    X(WM_I64_LOAD16_S) X(WM_I64_LOAD16_U) X(WM_I64_LOAD32_S) X(WM_I64_LOAD32_U) \
+    X(WM_I32_STORE) X(WM_I64_STORE) X(WM_I32_STORE8) X(WM_I32_STORE16) \
+    X(WM_I64_STORE8) X(WM_I64_STORE16) X(WM_I64_STORE32) \
+    X(WM_MEMORY_SIZE) X(WM_MEMORY_GROW) X(WM_I32_CONST) X(WM_I64_CONST) \
+    X(WM_I32_EQZ) X(WM_I32_EQ) X(WM_I32_NE) X(WM_I32_LT_S) X(WM_I32_LT_U) \
+    X(WM_I32_GT_S) X(WM_I32_GT_U) X(WM_I32_LE_S) X(WM_I32_LE_U) X(WM_I32_GE_S) X(WM_I32_GE_U) \
+    X(WM_I64_EQZ) X(WM_I64_EQ) X(WM_I64_NE) X(WM_I64_LT_S) X(WM_I64_LT_U) \
+    X(WM_I64_GT_S) X(WM_I64_GT_U) X(WM_I64_LE_S) X(WM_I64_LE_U) X(WM_I64_GE_S) X(WM_I64_GE_U) \
+    X(WM_I32_CLZ) X(WM_I32_CTZ) X(WM_I32_POPCNT) X(WM_I32_ADD) X(WM_I32_SUB) X(WM_I32_MUL) \
+    X(WM_I32_DIV_S) X(WM_I32_DIV_U) X(WM_I32_REM_S) X(WM_I32_REM_U) X(WM_I32_AND) \
+    X(WM_I32_OR) X(WM_I32_XOR) X(WM_I32_SHL) X(WM_I32_SHR_S) X(WM_I32_SHR_U) \
+    X(WM_I32_ROTL) X(WM_I32_ROTR) \
+    X(WM_I64_CLZ) X(WM_I64_CTZ) X(WM_I64_POPCNT) X(WM_I64_ADD) X(WM_I64_SUB) X(WM_I64_MUL) \
+    X(WM_I64_DIV_S) X(WM_I64_DIV_U) X(WM_I64_REM_S) X(WM_I64_REM_U) X(WM_I64_AND) \
+    X(WM_I64_OR) X(WM_I64_XOR) X(WM_I64_SHL) X(WM_I64_SHR_S) X(WM_I64_SHR_U) \
+    X(WM_I64_ROTL) X(WM_I64_ROTR) \
+    X(WM_I32_WRAP_I64) X(WM_I64_EXTEND_I32_S) X(WM_I64_EXTEND_I32_U) \
+    X(WM_I32_EXTEND8_S) X(WM_I32_EXTEND16_S) X(WM_I64_EXTEND8_S) \
+    X(WM_I64_EXTEND16_S) X(WM_I64_EXTEND32_S)
+
+#define WM_ENUM(x) x,
+enum { WM_OPS(WM_ENUM) WM_OP_COUNT };
+
+/* Simple ops: WASM byte → internal op + stack effect (pop, push). */
+typedef struct { UINT16 op; UINT8 pop, push; } _WmSimple;
+
+static int _wm_simple(UINT8 b, _WmSimple *s) {
+    /* i32/i64 compare block: 0x45..0x5A */
+    static const UINT16 cmp[] = {
+        WM_I32_EQZ, WM_I32_EQ, WM_I32_NE, WM_I32_LT_S, WM_I32_LT_U, WM_I32_GT_S,
+        WM_I32_GT_U, WM_I32_LE_S, WM_I32_LE_U, WM_I32_GE_S, WM_I32_GE_U,
+        WM_I64_EQZ, WM_I64_EQ, WM_I64_NE, WM_I64_LT_S, WM_I64_LT_U, WM_I64_GT_S,
+        WM_I64_GT_U, WM_I64_LE_S, WM_I64_LE_U, WM_I64_GE_S, WM_I64_GE_U };
+    /* integer arithmetic block: 0x67..0x8A */
+    static const UINT16 ari[] = {
+        WM_I32_CLZ, WM_I32_CTZ, WM_I32_POPCNT, WM_I32_ADD, WM_I32_SUB, WM_I32_MUL,
+        WM_I32_DIV_S, WM_I32_DIV_U, WM_I32_REM_S, WM_I32_REM_U, WM_I32_AND, WM_I32_OR,
+        WM_I32_XOR, WM_I32_SHL, WM_I32_SHR_S, WM_I32_SHR_U, WM_I32_ROTL, WM_I32_ROTR,
+        WM_I64_CLZ, WM_I64_CTZ, WM_I64_POPCNT, WM_I64_ADD, WM_I64_SUB, WM_I64_MUL,
+        WM_I64_DIV_S, WM_I64_DIV_U, WM_I64_REM_S, WM_I64_REM_U, WM_I64_AND, WM_I64_OR,
+        WM_I64_XOR, WM_I64_SHL, WM_I64_SHR_S, WM_I64_SHR_U, WM_I64_ROTL, WM_I64_ROTR };
+    if (b >= 0x45 && b <= 0x5A) {
+        s->op = cmp[b - 0x45];
+        s->pop = (b == 0x45 || b == 0x50) ? 1 : 2; s->push = 1;
+        return 1;
+    }
+    if (b >= 0x67 && b <= 0x8A) {
+        UINT8 k = (UINT8)((b - 0x67) % 18);
+        s->op = ari[b - 0x67];
+        s->pop = (k < 3) ? 1 : 2; s->push = 1;
+        return 1;
+    }
+    s->pop = 1; s->push = 1;
+    switch (b) {
+    case 0xA7: s->op = WM_I32_WRAP_I64;     return 1;
+    case 0xAC: s->op = WM_I64_EXTEND_I32_S; return 1;
+    case 0xAD: s->op = WM_I64_EXTEND_I32_U; return 1;
+    case 0xC0: s->op = WM_I32_EXTEND8_S;    return 1;
+    case 0xC1: s->op = WM_I32_EXTEND16_S;   return 1;
+    case 0xC2: s->op = WM_I64_EXTEND8_S;    return 1;
+    case 0xC3: s->op = WM_I64_EXTEND16_S;   return 1;
+    case 0xC4: s->op = WM_I64_EXTEND32_S;   return 1;
+    /* loads: pop addr, push value */
+    case 0x28: s->op = WM_I32_LOAD;     return 1;
+    case 0x29: s->op = WM_I64_LOAD;     return 1;
+    case 0x2C: s->op = WM_I32_LOAD8_S;  return 1;
+    case 0x2D: s->op = WM_I32_LOAD8_U;  return 1;
+    case 0x2E: s->op = WM_I32_LOAD16_S; return 1;
+    case 0x2F: s->op = WM_I32_LOAD16_U; return 1;
+    case 0x30: s->op = WM_I64_LOAD8_S;  return 1;
+    case 0x31: s->op = WM_I64_LOAD8_U;  return 1;
+    case 0x32: s->op = WM_I64_LOAD16_S; return 1;
+    case 0x33: s->op = WM_I64_LOAD16_U; return 1;
+    case 0x34: s->op = WM_I64_LOAD32_S; return 1;
+    case 0x35: s->op = WM_I64_LOAD32_U; return 1;
+    default: break;
+    }
+    s->pop = 2; s->push = 0;
+    switch (b) {
+    case 0x36: s->op = WM_I32_STORE;   return 1;
+    case 0x37: s->op = WM_I64_STORE;   return 1;
+    case 0x3A: s->op = WM_I32_STORE8;  return 1;
+    case 0x3B: s->op = WM_I32_STORE16; return 1;
+    case 0x3C: s->op = WM_I64_STORE8;  return 1;
+    case 0x3D: s->op = WM_I64_STORE16; return 1;
+    case 0x3E: s->op = WM_I64_STORE32; return 1;
+    default: break;
+    }
+    return 0;
+}
+
+/* ── Load-time compiler ──────────────────────────────────────────────────── */
+
+typedef struct {
+    UINT8  kind;         /* 0 = function body, 0x02 block, 0x03 loop, 0x04 if, 0x05 else */
+    UINT8  arity;        /* label results (0/1) */
+    UINT8  unreachable;  /* after br/return/unreachable: stack is polymorphic */
+    UINT32 height;       /* operand height at entry, frame-relative */
+    UINT32 start;        /* loop: back-edge target insn */
+    UINT32 patch;        /* forward-branch chain (insn index + 1, 0 = end) */
+    UINT32 if_insn;      /* if: IFZ insn index + 1 until else/end patches it */
+} _WmCtrl;
+
+typedef struct {
+    OoWasmMod  *m;
+    OoWasmFunc *fn;
+    UINT32      h, max_h;
+    int         depth;
+    int         ok;
+    _WmCtrl     ctrl[OO_WASM_MAX_BLOCKS];
+} _WmCompiler;
+
+static UINT32 _wm_emit(_WmCompiler *c, UINT32 op, UINT32 a, UINT32 b) {
+    OoWasmInsn *in = &c->m->insns[c->m->insn_count];
+    in->op = op; in->a = a; in->b = b;
+    return c->m->insn_count++;
+}
+
+static void _wm_fail(_WmCompiler *c, const char *msg) {
+    if (c->ok) _wm_err(c->m, (const CHAR8*)msg);
+    c->ok = 0;
+}
+
+static void _wm_pop(_WmCompiler *c, UINT32 n) {
+    _WmCtrl *t = &c->ctrl[c->depth - 1];
+    if (c->h < t->height + n) {
+        if (t->unreachable) { c->h = t->height; return; }
+        _wm_fail(c, "operand stack underflow");
+        return;
+    }
+    c->h -= n;
+}
+
+static void _wm_push(_WmCompiler *c, UINT32 n) {
+    c->h += n;
+    if (c->h > c->max_h) c->max_h = c->h;
+}
+
+static void _wm_set_unreachable(_WmCompiler *c) {
+    _WmCtrl *t = &c->ctrl[c->depth - 1];
+    c->h = t->height;
+    t->unreachable = 1;
+}
+
+/* Resolve a forward-branch chain to `target`. */
+static void _wm_patch(OoWasmMod *m, UINT32 chain, UINT32 target) {
+    while (chain) {
+        OoWasmInsn *in = &m->insns[chain - 1];
+        UINT32 next = in->a;
+        in->a = target;
+        chain = next;
+    }
+}
+
+/* Branch metadata for label depth l: fills target-or-chain + packed b.
+ * Returns 0 for a function-level label (branch = return). */
+static int _wm_label(_WmCompiler *c, UINT32 l, UINT32 at, UINT32 *a, UINT32 *b) {
+    _WmCtrl *t = &c->ctrl[c->depth - 1 - (int)l];
+    if (t->kind == 0) return 0;
+    UINT32 arity = (t->kind == 0x03) ? 0 : t->arity;
+    *b = (t->height << 1) | arity;
+    if (t->kind == 0x03) {
+        *a = t->start;
+    } else {
+        *a = t->patch;          /* link into the chain, patched at end */
+        t->patch = at + 1;
+    }
+    return 1;
+}
+
+static UINT8 _wm_block_arity(_WmCompiler *c, UINT8 bt) {
+    if (bt == 0x40) return 0;
+    if (bt == OO_WASM_I32 || bt == OO_WASM_I64) return 1;
+    _wm_fail(c, "unsupported block type");
+    return 0;
+}
+
+static int _wm_compile(OoWasmMod *m, UINT32 fi, _WmCompiler *c) {
+    OoWasmFunc *fn = &m->funcs[fi];
+    OoWasmFuncType *ft = &m->types[fn->type_idx];
+    const UINT8 *code = m->data + fn->code_offset;
+    UINT32 ip = 0, end = fn->code_size, n;
+
+    if ((UINT32)ft->param_count + fn->local_count > OO_WASM_MAX_LOCALS) {
+        _wm_err(m,(const CHAR8*)"frame too large"); return 0;
+    }
+    fn->param_count  = ft->param_count;
+    fn->result_count = ft->result_count;
+    fn->frame_size   = (UINT16)(ft->param_count + fn->local_count);
+    fn->insn_off     = m->insn_count;
+
+    c->m = m; c->fn = fn; c->ok = 1;
+    c->h = c->max_h = fn->frame_size;
+    c->depth = 1;
+    _wm_memset(&c->ctrl[0], 0, sizeof(c->ctrl[0]));
+    c->ctrl[0].kind = 0;
+    c->ctrl[0].arity = fn->result_count;
+    c->ctrl[0].height = fn->frame_size;
+
+    while (c->ok && c->depth > 0) {
+        if (ip >= end) { _wm_fail(c, "missing end"); break; }
+        UINT8 op = code[ip++];
+        _WmSimple sop;
+
+        switch (op) {
+        case 0x00: _wm_emit(c, WM_UNREACHABLE, 0, 0); _wm_set_unreachable(c); break;
+        case 0x01: break;
+
+        case 0x02: /* block */
+        case 0x03: /* loop */
+        case 0x04: /* if */ {
+            UINT8 ar = _wm_block_arity(c, code[ip++]);
+            if (op == 0x04) _wm_pop(c, 1);
+            if (c->depth >= OO_WASM_MAX_BLOCKS) { _wm_fail(c, "blocks nested too deep"); break; }
+            _WmCtrl *t = &c->ctrl[c->depth++];
+            _wm_memset(t, 0, sizeof(*t));
+            t->kind = op; t->arity = ar; t->height = c->h;
+            t->start = m->insn_count;
+            if (op == 0x04) t->if_insn = _wm_emit(c, WM_IFZ, 0, 0) + 1;
+            break;
+        }
+        case 0x05: /* else */ {
+            _WmCtrl *t = &c->ctrl[c->depth - 1];
+            if (t->kind != 0x04) { _wm_fail(c, "else without if"); break; }
+            if (!t->unreachable && c->h != t->height + t->arity) { _wm_fail(c, "type mismatch at else"); break; }
+            UINT32 j = _wm_emit(c, WM_JMP, t->patch, 0);
+            t->patch = j + 1;
+            m->insns[t->if_insn - 1].a = m->insn_count;
+            t->if_insn = 0;
+            t->kind = 0x05;
+            t->unreachable = 0;
+            c->h = t->height;
+            break;
+        }
+        case 0x0B: /* end */ {
+            _WmCtrl *t = &c->ctrl[c->depth - 1];
+            if (!t->unreachable && c->h != t->height + t->arity) { _wm_fail(c, "type mismatch at end"); break; }
+            if (t->kind == 0x04 && t->arity) { _wm_fail(c, "if without else yields a value"); break; }
+            if (t->kind == 0) {
+                _wm_emit(c, WM_RETURN, 0, fn->result_count);
+                c->depth = 0;
+                break;
+            }
+            if (t->if_insn) m->insns[t->if_insn - 1].a = m->insn_count;
+            _wm_patch(m, t->patch, m->insn_count);
+            c->h = t->height;
+            c->depth--;
+            _wm_push(c, t->arity);
+            break;
+        }
+        case 0x0C: /* br */
+        case 0x0D: /* br_if */ {
+            UINT32 l=0; n=_wm_leb_u32(code+ip,&l); ip+=n;
+            if (l >= (UINT32)c->depth) { _wm_fail(c, "bad branch depth"); break; }
+            if (op == 0x0D) _wm_pop(c, 1);
+            UINT32 at = m->insn_count, a = 0, b = 0;
+            if (!_wm_label(c, l, at, &a, &b)) {
+                /* branch to the function label = return */
+                if (op == 0x0D) _wm_emit(c, WM_IFZ, at + 2, 0);
+                _wm_emit(c, WM_RETURN, 0, fn->result_count);
+            } else {
+                UINT32 arity = b & 1, lh = b >> 1;
+                if (c->h < lh + arity && !c->ctrl[c->depth - 1].unreachable) { _wm_fail(c, "branch stack underflow"); break; }
+                int in_place = (c->h == lh + arity);
+                if (op == 0x0C) _wm_emit(c, in_place ? WM_JMP : WM_BR, a, b);
+                else            _wm_emit(c, in_place ? WM_BR_IF_JMP : WM_BR_IF, a, b);
+            }
+            if (op == 0x0C) _wm_set_unreachable(c);
+            break;
+        }
+        case 0x0E: /* br_table */ {
+            UINT32 cnt=0; n=_wm_leb_u32(code+ip,&cnt); ip+=n;
+            if (cnt > end) { _wm_fail(c, "bad br_table"); break; }
+            _wm_pop(c, 1);
+            _wm_emit(c, WM_BR_TABLE, cnt, 0);
+            /* cnt + 1 entries follow inline (default last); never executed */
+            for (UINT32 k = 0; k <= cnt && c->ok; k++) {
+                UINT32 l=0; n=_wm_leb_u32(code+ip,&l); ip+=n;
+                if (l >= (UINT32)c->depth) { _wm_fail(c, "bad branch depth"); break; }
+                UINT32 at = m->insn_count, a = 0, b = 0;
+                if (!_wm_label(c, l, at, &a, &b)) {
+                    /* function label: return with the function's arity */
+                    a = fn->result_count;
+                    b = 0xFFFFFFFFu;
+                }
+                _wm_emit(c, WM_NOP, a, b);
+            }
+            _wm_set_unreachable(c);
+            break;
+        }
+        case 0x0F: /* return */
+            _wm_emit(c, WM_RETURN, 0, fn->result_count);
+            _wm_set_unreachable(c);
+            break;
+
+        case 0x10: /* call */ {
+            UINT32 ci=0; n=_wm_leb_u32(code+ip,&ci); ip+=n;
+            if (ci >= m->func_count) { _wm_fail(c, "bad function index"); break; }
+            OoWasmFuncType *cft = &m->types[m->funcs[ci].type_idx];
+            _wm_pop(c, cft->param_count);
+            _wm_emit(c, WM_CALL, ci, 0);
+            _wm_push(c, cft->result_count);
+            break;
+        }
+
+        case 0x1A: _wm_pop(c, 1); _wm_emit(c, WM_DROP, 0, 0); break;
+        case 0x1B: _wm_pop(c, 3); _wm_emit(c, WM_SELECT, 0, 0); _wm_push(c, 1); break;
+
+        case 0x20: case 0x21: case 0x22: {
+            UINT32 li=0; n=_wm_leb_u32(code+ip,&li); ip+=n;
+            if (li >= fn->frame_size) { _wm_fail(c, "bad local index"); break; }
+            if (op == 0x20) { _wm_emit(c, WM_LOCAL_GET, li, 0); _wm_push(c, 1); }
+            else if (op == 0x21) { _wm_pop(c, 1); _wm_emit(c, WM_LOCAL_SET, li, 0); }
+            else { _wm_pop(c, 1); _wm_emit(c, WM_LOCAL_TEE, li, 0); _wm_push(c, 1); }
+            break;
+        }
+        case 0x23: case 0x24: {
+            UINT32 gi=0; n=_wm_leb_u32(code+ip,&gi); ip+=n;
+            if (gi >= m->global_count) { _wm_fail(c, "bad global index"); break; }
+            if (op == 0x23) { _wm_emit(c, WM_GLOBAL_GET, gi, 0); _wm_push(c, 1); }
+            else {
+                if (!m->global_mut[gi]) { _wm_fail(c, "global is immutable"); break; }
+                _wm_pop(c, 1); _wm_emit(c, WM_GLOBAL_SET, gi, 0);
+            }
+            break;
+        }
+
+        case 0x3F: case 0x40: /* memory.size / memory.grow */
+            ip++;  /* reserved 0x00 */
+            if (op == 0x40) _wm_pop(c, 1);
+            _wm_emit(c, op == 0x3F ? WM_MEMORY_SIZE : WM_MEMORY_GROW, 0, 0);
+            _wm_push(c, 1);
+            break;
+
+        case 0x41: { INT32 v=0; n=_wm_leb_i32(code+ip,&v); ip+=n; _wm_emit(c, WM_I32_CONST, (UINT32)v, 0); _wm_push(c, 1); break; }
+        case 0x42: {
+            INT64 v=0; n=_wm_leb_i64(code+ip,&v); ip+=n;
+            _wm_emit(c, WM_I64_CONST, (UINT32)(UINT64)v, (UINT32)((UINT64)v >> 32));
+            _wm_push(c, 1);
+            break;
+        }
+
+        default:
+            if (_wm_simple(op, &sop)) {
+                UINT32 off = 0;
+                if (op >= 0x28 && op <= 0x3E) {   /* memarg: align, offset */
+                    UINT32 al=0; n=_wm_leb_u32(code+ip,&al); ip+=n;
+                    n=_wm_leb_u32(code+ip,&off); ip+=n;
+                }
+                _wm_pop(c, sop.pop);
+                _wm_emit(c, sop.op, off, 0);
+                _wm_push(c, sop.push);
+            } else {
+                _wm_fail(c, "unsupported opcode");
+            }
+            break;
+        }
+        if (ip > end) _wm_fail(c, "truncated body");
+    }
+
+    if (!c->ok) return 0;
+    if (ip != end) { _wm_err(m,(const CHAR8*)"trailing bytes after end"); return 0; }
+    fn->max_height = c->max_h;
+    if (fn->max_height > OO_WASM_MAX_STACK) { _wm_err(m,(const CHAR8*)"frame exceeds value stack"); return 0; }
+    return 1;
+}
+
+static int _wm_compile_all(OoWasmMod *m) {
+    /* Every WASM instruction is ≥ 1 byte and emits ≤ 1 insn (br_if to the
+     * function label emits 2 from ≥ 2 bytes), so code bytes bound the stream. */
+    UINT64 total = 1;
+    for (UINT32 i = 0; i < m->func_count; i++) total += m->funcs[i].code_size;
+    m->insns = (OoWasmInsn *)_wm_alloc((UINTN)(total * sizeof(OoWasmInsn)));
+    if (!m->insns) { _wm_err(m,(const CHAR8*)"alloc fail (code)"); return 0; }
+    m->insn_count = 0;
+    m->threaded = 0;
+
+    static _WmCompiler c;   /* ~5 KB of control stack: keep it off the EFI stack */
+    for (UINT32 i = 0; i < m->func_count; i++)
+        if (!_wm_compile(m, i, &c)) return 0;
+    return 1;
+}
+
 /* ── Main binary parser ──────────────────────────────────────────────────── */
+void oo_wasm_init(OoWasmMod *m) {
+    m->data = NULL;
+    m->insns = NULL;
+    m->loaded = 0;
+    m->error[0] = 0;
+}
+
 EFI_STATUS oo_wasm_load_buf(OoWasmMod *m, const UINT8 *buf, UINTN size) {
     _wm_memset(m, 0, sizeof(*m));
     if (size < 8) { _wm_err(m,(const CHAR8*)"too small"); return EFI_INVALID_PARAMETER; }
@@ -190,37 +654,51 @@ EFI_STATUS oo_wasm_load_buf(OoWasmMod *m, const UINT8 *buf, UINTN size) {
         _wm_err(m,(const CHAR8*)"bad version"); return EFI_INVALID_PARAMETER;
     }
 
-    /* Allocate and copy raw data */
-    EFI_STATUS st = uefi_call_wrapper(BS->AllocatePool, 3,
-        EfiLoaderData, size, (void**)&m->data);
-    if (EFI_ERROR(st)) { _wm_err(m,(const CHAR8*)"alloc fail"); return st; }
+    /* Allocate and copy raw data (+16 zero bytes so LEB reads never overrun) */
+    m->data = (UINT8 *)_wm_alloc(size + 16);
+    if (!m->data) { _wm_err(m,(const CHAR8*)"alloc fail"); return EFI_OUT_OF_RESOURCES; }
     _wm_memcpy(m->data, buf, size);
+    _wm_memset(m->data + size, 0, 16);
     m->data_size = size;
 
     /* Iterate sections */
     UINT32 off = 8;
-    while (off < (UINT32)size) {
+    int ok = 1;
+    while (ok && off < (UINT32)size) {
         UINT8 sid = m->data[off++];
         UINT32 sec_size=0, n;
         n=_wm_leb_u32(m->data+off,&sec_size); off+=n;
         UINT32 sec_start = off;
+        if (sec_size > (UINT32)size - sec_start) { _wm_err(m,(const CHAR8*)"truncated section"); ok = 0; break; }
 
         switch (sid) {
-        case WASM_SEC_TYPE:   _parse_types(m,  m->data+off, sec_size); break;
-        case WASM_SEC_FUNC:   _parse_funcs(m,  m->data+off, sec_size); break;
-        case WASM_SEC_EXPORT: _parse_exports(m,m->data+off, sec_size); break;
-        case WASM_SEC_CODE:   _parse_code(m,   m->data+off, sec_size, off); break;
-        case WASM_SEC_DATA:   _parse_data(m,   m->data+off, sec_size); break;
+        case WASM_SEC_TYPE:   ok = _parse_types(m,  m->data+off, sec_size); break;
+        case WASM_SEC_IMPORT: ok = _parse_imports(m,m->data+off, sec_size); break;
+        case WASM_SEC_FUNC:   ok = _parse_funcs(m,  m->data+off, sec_size); break;
+        case WASM_SEC_GLOBAL: ok = _parse_globals(m,m->data+off, sec_size); break;
+        case WASM_SEC_EXPORT: ok = _parse_exports(m,m->data+off, sec_size); break;
+        case WASM_SEC_CODE:   ok = _parse_code(m,   m->data+off, sec_size, off); break;
+        case WASM_SEC_DATA:   ok = _parse_data(m,   m->data+off, sec_size); break;
+        case WASM_SEC_TABLE:
+        case WASM_SEC_ELEM:
+            if (sec_size > 1 || m->data[off] != 0) { _wm_err(m,(const CHAR8*)"tables unsupported"); ok = 0; }
+            break;
         default: break;
         }
         off = sec_start + sec_size;
     }
+    if (ok) ok = _wm_compile_all(m);
+    if (!ok) {
+        oo_wasm_unload(m);
+        return EFI_INVALID_PARAMETER;
+    }
 
     m->mem_pages = 1;
     m->loaded = 1;
     return EFI_SUCCESS;
 }
 
+#ifdef UEFI_BUILD
 /* ── Load from EFI file ──────────────────────────────────────────────────── */
 EFI_STATUS oo_wasm_load_file(OoWasmMod *m, EFI_FILE_HANDLE root,
                               const CHAR16 *path) {
@@ -260,182 +738,273 @@ EFI_STATUS oo_wasm_load_file(OoWasmMod *m, EFI_FILE_HANDLE root,
     uefi_call_wrapper(BS->FreePool, 1, buf);
     return st;
 }
+#endif /* UEFI_BUILD */
 
-/* ── Stack-based interpreter ─────────────────────────────────────────────── */
+/* ── Direct-threaded interpreter ─────────────────────────────────────────── */
 
-typedef struct {
-    OoWasmVal slots[OO_WASM_MAX_STACK];
-    INT32     top;   /* -1 = empty */
-} _WasmStack;
+#if defined(__GNUC__) && !defined(OO_WASM_NO_THREADING)
+#define WM_THREADED 1
+#define WM_CASE(x)  L_##x:
+#define WM_NEXT()   do { in = pc++; goto *in->h; } while (0)
+#else
+#define WM_CASE(x)  case x:
+#define WM_NEXT()   continue
+#endif
 
-static void _stk_push(_WasmStack *s, OoWasmVal v) {
-    if (s->top+1 < OO_WASM_MAX_STACK) s->slots[++s->top] = v;
-}
-static OoWasmVal _stk_pop(_WasmStack *s) {
-    if (s->top < 0) { OoWasmVal z; _wm_memset(&z,0,sizeof(z)); return z; }
-    return s->slots[s->top--];
-}
-static OoWasmVal _stk_peek(_WasmStack *s) {
-    if (s->top < 0) { OoWasmVal z; _wm_memset(&z,0,sizeof(z)); return z; }
-    return s->slots[s->top];
-}
+#define WM_TRAP(msg) do { _wm_err(m,(const CHAR8*)(msg)); st = EFI_ABORTED; goto out; } while (0)
 
-static OoWasmVal _mki32(INT32 v)  { OoWasmVal x; x.type=OO_WASM_I32; x.i32=v; return x; }
-static OoWasmVal _mki64(INT64 v)  { OoWasmVal x; x.type=OO_WASM_I64; x.i64=v; return x; }
+#define WM_BIN32(expr) { UINT32 b_ = (UINT32)sp[-1], a_ = (UINT32)sp[-2]; (void)a_; (void)b_; \
+                         sp--; sp[-1] = (UINT64)(UINT32)(expr); WM_NEXT(); }
+#define WM_BIN64(expr) { UINT64 b_ = sp[-1], a_ = sp[-2]; (void)a_; (void)b_; \
+                         sp--; sp[-1] = (UINT64)(expr); WM_NEXT(); }
+#define WM_UN32(expr)  { UINT32 a_ = (UINT32)sp[-1]; sp[-1] = (UINT64)(UINT32)(expr); WM_NEXT(); }
+#define WM_UN64(expr)  { UINT64 a_ = sp[-1]; sp[-1] = (UINT64)(expr); WM_NEXT(); }
 
-/* Execute function at funcs[func_idx] — recursive for `call` opcode */
-static EFI_STATUS _exec(OoWasmMod *m, UINT32 func_idx,
-                         OoWasmVal *args, UINT32 nargs,
-                         OoWasmVal *ret_val, int depth) {
-    if (depth > 16) { _wm_err(m,(const CHAR8*)"call depth"); return EFI_ABORTED; }
-    if (func_idx >= m->func_count) return EFI_NOT_FOUND;
+/* Effective address check: addr on top of stack (or below value for stores) */
+#define WM_EA(slot, sz) \
+    UINT64 ea_ = (UINT64)(UINT32)(slot) + in->a; \
+    if (ea_ + (sz) > OO_WASM_MAX_MEMORY) WM_TRAP("out of bounds memory access");
+#define WM_LOAD(T, R)  { WM_EA(sp[-1], sizeof(T)); T v_; __builtin_memcpy(&v_, mem + ea_, sizeof(T)); \
+                         sp[-1] = (UINT64)(R)v_; WM_NEXT(); }
+#define WM_STORE(T)    { WM_EA(sp[-2], sizeof(T)); T v_ = (T)sp[-1]; __builtin_memcpy(mem + ea_, &v_, sizeof(T)); \
+                         sp -= 2; WM_NEXT(); }
 
-    OoWasmFunc *fn  = &m->funcs[func_idx];
-    OoWasmFuncType *ft = &m->types[fn->type_idx];
+/* Branch with stack fixup: keep `arity` top values at label height. The top
+ * is read only when arity is 1: an empty operand stack sits at fp. */
+#define WM_BRANCH(a, b) { if ((b) & 1) { UINT64 v_ = sp[-1]; sp = fp + ((b) >> 1); *sp++ = v_; } \
+                          else sp = fp + ((b) >> 1); \
+                          pc = code + (a); WM_NEXT(); }
 
-    /* locals: params + declared locals */
-    OoWasmVal locals[OO_WASM_MAX_LOCALS];
-    _wm_memset(locals, 0, sizeof(locals));
-    for (UINT32 i=0; i<nargs && i<(UINT32)ft->param_count; i++) locals[i]=args[i];
+static UINT32 _wm_rotl32(UINT32 x, UINT32 k) { k &= 31; return k ? (x << k) | (x >> (32 - k)) : x; }
+static UINT32 _wm_rotr32(UINT32 x, UINT32 k) { k &= 31; return k ? (x >> k) | (x << (32 - k)) : x; }
+static UINT64 _wm_rotl64(UINT64 x, UINT64 k) { k &= 63; return k ? (x << k) | (x >> (64 - k)) : x; }
+static UINT64 _wm_rotr64(UINT64 x, UINT64 k) { k &= 63; return k ? (x >> k) | (x << (64 - k)) : x; }
 
-    _WasmStack stk; stk.top = -1;
+/* Run funcs[func_idx] with args already in m->stack[0..param_count). */
+static EFI_STATUS _wm_run(OoWasmMod *m, UINT32 func_idx, UINT64 *result) {
+    EFI_STATUS st = EFI_SUCCESS;
+    OoWasmInsn *code = m->insns;
+    UINT8  *mem = m->mem;
+    UINT64 *stack_end = m->stack + OO_WASM_MAX_STACK;
+    UINT32  depth = 0, ret_arity;
 
-    const UINT8 *code = m->data + fn->code_offset;
-    UINT32 ip = 0, code_size = fn->code_size;
+#ifdef WM_THREADED
+#define WM_LABEL(x) [x] = &&L_##x,
+    static const void *const handlers[WM_OP_COUNT] = { WM_OPS(WM_LABEL) };
+#undef WM_LABEL
+    if (!m->threaded) {
+        for (UINT32 i = 0; i < m->insn_count; i++)
+            code[i].h = handlers[code[i].op < WM_OP_COUNT ? code[i].op : WM_NOP];
+        m->threaded = 1;
+    }
+#endif
 
-    /* Simple block depth counter for if/block/loop/end */
-    INT32 block_depth = 0;
+    const OoWasmFunc *fn = &m->funcs[func_idx];
+    UINT64 *fp = m->stack;
+    UINT64 *sp;
+    for (sp = fp + fn->param_count; sp < fp + fn->frame_size; sp++) *sp = 0;
+    OoWasmInsn *pc = code + fn->insn_off, *in;
 
-    while (ip < code_size) {
-        UINT8 op = code[ip++];
-        UINT32 n;
-        switch (op) {
+#ifdef WM_THREADED
+    WM_NEXT();
+#else
+    for (;;) {
+    in = pc++;
+    switch (in->op) {
+#endif
 
-        case 0x00: /* unreachable */
-            _wm_err(m,(const CHAR8*)"unreachable"); return EFI_ABORTED;
-        case 0x01: /* nop */ break;
-
-        case 0x02: /* block <type> */ ip++; block_depth++; break;
-        case 0x03: /* loop  <type> */ ip++; block_depth++; break;
-        case 0x04: /* if    <type> */ {
-            ip++;
-            OoWasmVal cond = _stk_pop(&stk);
-            if (!cond.i32) {
-                /* skip to matching else or end */
-                INT32 d=1;
-                while (ip<code_size && d>0) {
-                    UINT8 b=code[ip++];
-                    if(b==0x02||b==0x03||b==0x04) d++;
-                    else if(b==0x0B) d--;
-                    else if(b==0x05&&d==1) { d=0; } /* else found */
-                }
-            } else block_depth++;
-            break;
-        }
-        case 0x05: /* else — skip to end */ {
-            INT32 d=1;
-            while (ip<code_size && d>0) {
-                UINT8 b=code[ip++];
-                if(b==0x02||b==0x03||b==0x04) d++;
-                else if(b==0x0B) d--;
-            }
-            if(block_depth>0) block_depth--;
-            break;
-        }
-        case 0x0B: /* end */
-            if (block_depth > 0) { block_depth--; break; }
-            goto done;
-        case 0x0C: /* br */ { UINT32 depth=0; ip+=_wm_leb_u32(code+ip,&depth); goto done; }
-        case 0x0D: /* br_if */ {
-            UINT32 depth=0; ip+=_wm_leb_u32(code+ip,&depth);
-            OoWasmVal c=_stk_pop(&stk);
-            if(c.i32) goto done;
-            break;
-        }
-        case 0x0F: /* return */ goto done;
+    WM_CASE(WM_UNREACHABLE) WM_TRAP("unreachable");
+    WM_CASE(WM_NOP)         WM_NEXT();
+    WM_CASE(WM_JMP)         pc = code + in->a; WM_NEXT();
+    WM_CASE(WM_BR)          WM_BRANCH(in->a, in->b);
+    WM_CASE(WM_BR_IF_JMP)   if ((UINT32)*--sp) pc = code + in->a; WM_NEXT();
+    WM_CASE(WM_BR_IF)       if ((UINT32)*--sp) WM_BRANCH(in->a, in->b); WM_NEXT();
+    WM_CASE(WM_IFZ)         if (!(UINT32)*--sp) pc = code + in->a; WM_NEXT();
+    WM_CASE(WM_BR_TABLE) {
+        UINT32 i = (UINT32)*--sp;
+        if (i > in->a) i = in->a;
+        const OoWasmInsn *e = pc + i;
+        if (e->b == 0xFFFFFFFFu) { ret_arity = e->a; goto do_return; }
+        WM_BRANCH(e->a, e->b);
+    }
+    WM_CASE(WM_RETURN) {
+        ret_arity = in->b;
+    do_return:;
+        if (ret_arity) { UINT64 v = sp[-1]; sp = fp; *sp++ = v; }
+        else sp = fp;
+        if (depth == 0) goto out;
+        depth--;
+        fp = m->frames[depth].fp;
+        pc = (OoWasmInsn *)m->frames[depth].ret;
+        WM_NEXT();
+    }
+    WM_CASE(WM_CALL) {
+        const OoWasmFunc *cf = &m->funcs[in->a];
+        UINT64 *nfp = sp - cf->param_count;
+        if (depth >= OO_WASM_MAX_CALL_DEPTH || nfp + cf->max_height > stack_end)
+            WM_TRAP("call stack exhausted");
+        for (UINT64 *l = sp; l < nfp + cf->frame_size; l++) *l = 0;
+        m->frames[depth].ret = pc;
+        m->frames[depth].fp  = fp;
+        depth++;
+        fp = nfp;
+        sp = nfp + cf->frame_size;
+        pc = code + cf->insn_off;
+        WM_NEXT();
+    }
+    WM_CASE(WM_DROP)        sp--; WM_NEXT();
+    WM_CASE(WM_SELECT) {
+        UINT32 c = (UINT32)sp[-1];
+        sp -= 2;
+        if (!c) sp[-1] = sp[0];
+        WM_NEXT();
+    }
 
-        case 0x10: /* call */ {
-            UINT32 fi=0; n=_wm_leb_u32(code+ip,&fi); ip+=n;
-            if (fi < m->func_count) {
-                OoWasmFuncType *cft = &m->types[m->funcs[fi].type_idx];
-                OoWasmVal cargs[8];
-                UINT32 nca = cft->param_count > 8 ? 8 : cft->param_count;
-                /* pop args in reverse */
-                for (INT32 k=(INT32)nca-1; k>=0; k--) cargs[k]=_stk_pop(&stk);
-                OoWasmVal cret; _wm_memset(&cret,0,sizeof(cret));
-                _exec(m, fi, cargs, nca, &cret, depth+1);
-                if (cft->result_count > 0) _stk_push(&stk, cret);
-            }
-            break;
-        }
+    WM_CASE(WM_LOCAL_GET)   *sp++ = fp[in->a]; WM_NEXT();
+    WM_CASE(WM_LOCAL_SET)   fp[in->a] = *--sp; WM_NEXT();
+    WM_CASE(WM_LOCAL_TEE)   fp[in->a] = sp[-1]; WM_NEXT();
+    WM_CASE(WM_GLOBAL_GET)  *sp++ = m->globals[in->a]; WM_NEXT();
+    WM_CASE(WM_GLOBAL_SET)  m->globals[in->a] = *--sp; WM_NEXT();
 
-        case 0x1A: /* drop */ _stk_pop(&stk); break;
-        case 0x1B: /* select */ {
-            OoWasmVal c=_stk_pop(&stk);
-            OoWasmVal b=_stk_pop(&stk);
-            OoWasmVal a=_stk_pop(&stk);
-            _stk_push(&stk, c.i32 ? a : b);
-            break;
-        }
+    WM_CASE(WM_I32_LOAD)      WM_LOAD(UINT32, UINT32)
+    WM_CASE(WM_I64_LOAD)      WM_LOAD(UINT64, UINT64)
+    WM_CASE(WM_I32_LOAD8_S)   WM_LOAD(INT8,   UINT32)
+    WM_CASE(WM_I32_LOAD8_U)   WM_LOAD(UINT8,  UINT32)
+    WM_CASE(WM_I32_LOAD16_S)  WM_LOAD(INT16,  UINT32)
+    WM_CASE(WM_I32_LOAD16_U)  WM_LOAD(UINT16, UINT32)
+    WM_CASE(WM_I64_LOAD8_S)   WM_LOAD(INT8,   INT64)
+    WM_CASE(WM_I64_LOAD8_U)   WM_LOAD(UINT8,  UINT64)
+    WM_CASE(WM_I64_LOAD16_S)  WM_LOAD(INT16,  INT64)
+    WM_CASE(WM_I64_LOAD16_U)  WM_LOAD(UINT16, UINT64)
+    WM_CASE(WM_I64_LOAD32_S)  WM_LOAD(INT32,  INT64)
+    WM_CASE(WM_I64_LOAD32_U)  WM_LOAD(UINT32, UINT64)
+    WM_CASE(WM_I32_STORE)     WM_STORE(UINT32)
+    WM_CASE(WM_I64_STORE)     WM_STORE(UINT64)
+    WM_CASE(WM_I32_STORE8)    WM_STORE(UINT8)
+    WM_CASE(WM_I32_STORE16)   WM_STORE(UINT16)
+    WM_CASE(WM_I64_STORE8)    WM_STORE(UINT8)
+    WM_CASE(WM_I64_STORE16)   WM_STORE(UINT16)
+    WM_CASE(WM_I64_STORE32)   WM_STORE(UINT32)
+    WM_CASE(WM_MEMORY_SIZE)   *sp++ = m->mem_pages; WM_NEXT();
+    WM_CASE(WM_MEMORY_GROW)   /* fixed 64 KB pool: only grow(0) succeeds */
+        sp[-1] = ((UINT32)sp[-1] == 0) ? m->mem_pages : 0xFFFFFFFFu; WM_NEXT();
 
-        /* locals */
-        case 0x20: { UINT32 li=0; n=_wm_leb_u32(code+ip,&li); ip+=n; _stk_push(&stk,locals[li<OO_WASM_MAX_LOCALS?li:0]); break; }
-        case 0x21: { UINT32 li=0; n=_wm_leb_u32(code+ip,&li); ip+=n; if(li<OO_WASM_MAX_LOCALS) locals[li]=_stk_pop(&stk); else _stk_pop(&stk); break; }
-        case 0x22: { UINT32 li=0; n=_wm_leb_u32(code+ip,&li); ip+=n; if(li<OO_WASM_MAX_LOCALS) locals[li]=_stk_peek(&stk); break; }
-
-        /* i32.const */
-        case 0x41: { INT32 v=0; n=_wm_leb_i32(code+ip,&v); ip+=n; _stk_push(&stk,_mki32(v)); break; }
-        /* i64.const */
-        case 0x42: { INT64 v=0; n=_wm_leb_i64(code+ip,&v); ip+=n; _stk_push(&stk,_mki64(v)); break; }
-
-        /* i32 load/store */
-        case 0x28: { ip+=2; UINT32 addr=(UINT32)_stk_pop(&stk).i32; INT32 v=0; if(addr+4<=OO_WASM_MAX_MEMORY){_wm_memcpy(&v,m->mem+addr,4);} _stk_push(&stk,_mki32(v)); break; } /* i32.load */
-        case 0x36: { ip+=2; INT32 v=_stk_pop(&stk).i32; UINT32 addr=(UINT32)_stk_pop(&stk).i32; if(addr+4<=OO_WASM_MAX_MEMORY) _wm_memcpy(m->mem+addr,&v,4); break; } /* i32.store */
-
-        /* i32 compare */
-        case 0x45: { OoWasmVal a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32==0?1:0)); break; } /* eqz */
-        case 0x46: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32==b.i32?1:0)); break; } /* eq */
-        case 0x47: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32!=b.i32?1:0)); break; } /* ne */
-        case 0x48: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32< b.i32?1:0)); break; } /* lt_s */
-        case 0x49: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.u32< b.u32?1:0)); break; } /* lt_u */
-        case 0x4A: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32> b.i32?1:0)); break; } /* gt_s */
-        case 0x4B: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.u32> b.u32?1:0)); break; } /* gt_u */
-        case 0x4C: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32<=b.i32?1:0)); break; } /* le_s */
-        case 0x4E: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32>=b.i32?1:0)); break; } /* ge_s */
-
-        /* i32 arithmetic */
-        case 0x6A: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32+b.i32)); break; } /* add */
-        case 0x6B: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32-b.i32)); break; } /* sub */
-        case 0x6C: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32*b.i32)); break; } /* mul */
-        case 0x6D: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(b.i32?a.i32/b.i32:0)); break; } /* div_s */
-        case 0x6E: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(b.u32?(INT32)(a.u32/b.u32):0)); break; } /* div_u */
-        case 0x6F: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(b.i32?a.i32%b.i32:0)); break; } /* rem_s */
-        case 0x70: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(b.u32?(INT32)(a.u32%b.u32):0)); break; } /* rem_u */
-        case 0x71: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32&b.i32)); break; } /* and */
-        case 0x72: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32|b.i32)); break; } /* or */
-        case 0x73: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32^b.i32)); break; } /* xor */
-        case 0x74: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32<<(b.i32&31))); break; } /* shl */
-        case 0x75: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32(a.i32>>(b.i32&31))); break; } /* shr_s */
-        case 0x76: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki32((INT32)(a.u32>>(b.u32&31)))); break; } /* shr_u */
-
-        /* i64 arithmetic */
-        case 0x7C: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki64(a.i64+b.i64)); break; } /* i64.add */
-        case 0x7D: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki64(a.i64-b.i64)); break; } /* i64.sub */
-        case 0x7E: { OoWasmVal b=_stk_pop(&stk),a=_stk_pop(&stk); _stk_push(&stk,_mki64(a.i64*b.i64)); break; } /* i64.mul */
-
-        /* i32/i64 conversions */
-        case 0xA7: { OoWasmVal a=_stk_pop(&stk); _stk_push(&stk,_mki32((INT32)a.i64)); break; } /* i32.wrap_i64 */
-        case 0xAC: { OoWasmVal a=_stk_pop(&stk); _stk_push(&stk,_mki64((INT64)a.i32)); break; } /* i64.extend_i32_s */
-        case 0xAD: { OoWasmVal a=_stk_pop(&stk); _stk_push(&stk,_mki64((INT64)(UINT32)a.u32)); break; } /* i64.extend_i32_u */
+    WM_CASE(WM_I32_CONST)   *sp++ = in->a; WM_NEXT();
+    WM_CASE(WM_I64_CONST)   *sp++ = ((UINT64)in->b << 32) | in->a; WM_NEXT();
 
-        default:
-            /* unknown opcode — skip silently to avoid abort on complex modules */
-            break;
-        }
+    WM_CASE(WM_I32_EQZ)     WM_UN32(a_ == 0)
+    WM_CASE(WM_I32_EQ)      WM_BIN32(a_ == b_)
+    WM_CASE(WM_I32_NE)      WM_BIN32(a_ != b_)
+    WM_CASE(WM_I32_LT_S)    WM_BIN32((INT32)a_ <  (INT32)b_)
+    WM_CASE(WM_I32_LT_U)    WM_BIN32(a_ <  b_)
+    WM_CASE(WM_I32_GT_S)    WM_BIN32((INT32)a_ >  (INT32)b_)
+    WM_CASE(WM_I32_GT_U)    WM_BIN32(a_ >  b_)
+    WM_CASE(WM_I32_LE_S)    WM_BIN32((INT32)a_ <= (INT32)b_)
+    WM_CASE(WM_I32_LE_U)    WM_BIN32(a_ <= b_)
+    WM_CASE(WM_I32_GE_S)    WM_BIN32((INT32)a_ >= (INT32)b_)
+    WM_CASE(WM_I32_GE_U)    WM_BIN32(a_ >= b_)
+    WM_CASE(WM_I64_EQZ)     WM_UN64(a_ == 0)
+    WM_CASE(WM_I64_EQ)      WM_BIN64(a_ == b_)
+    WM_CASE(WM_I64_NE)      WM_BIN64(a_ != b_)
+    WM_CASE(WM_I64_LT_S)    WM_BIN64((INT64)a_ <  (INT64)b_)
+    WM_CASE(WM_I64_LT_U)    WM_BIN64(a_ <  b_)
+    WM_CASE(WM_I64_GT_S)    WM_BIN64((INT64)a_ >  (INT64)b_)
+    WM_CASE(WM_I64_GT_U)    WM_BIN64(a_ >  b_)
+    WM_CASE(WM_I64_LE_S)    WM_BIN64((INT64)a_ <= (INT64)b_)
+    WM_CASE(WM_I64_LE_U)    WM_BIN64(a_ <= b_)
+    WM_CASE(WM_I64_GE_S)    WM_BIN64((INT64)a_ >= (INT64)b_)
+    WM_CASE(WM_I64_GE_U)    WM_BIN64(a_ >= b_)
+
+    WM_CASE(WM_I32_CLZ)     WM_UN32(a_ ? (UINT32)__builtin_clz(a_) : 32u)
+    WM_CASE(WM_I32_CTZ)     WM_UN32(a_ ? (UINT32)__builtin_ctz(a_) : 32u)
+    WM_CASE(WM_I32_POPCNT)  WM_UN32((UINT32)__builtin_popcount(a_))
+    WM_CASE(WM_I32_ADD)     WM_BIN32(a_ + b_)
+    WM_CASE(WM_I32_SUB)     WM_BIN32(a_ - b_)
+    WM_CASE(WM_I32_MUL)     WM_BIN32(a_ * b_)
+    WM_CASE(WM_I32_DIV_S) {
+        UINT32 b_ = (UINT32)sp[-1], a_ = (UINT32)sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        if (a_ == 0x80000000u && b_ == 0xFFFFFFFFu) WM_TRAP("integer overflow");
+        sp--; sp[-1] = (UINT32)((INT32)a_ / (INT32)b_); WM_NEXT();
     }
-done:
-    if (ret_val && stk.top >= 0) *ret_val = _stk_pop(&stk);
-    return EFI_SUCCESS;
+    WM_CASE(WM_I32_DIV_U) {
+        UINT32 b_ = (UINT32)sp[-1], a_ = (UINT32)sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        sp--; sp[-1] = a_ / b_; WM_NEXT();
+    }
+    WM_CASE(WM_I32_REM_S) {
+        UINT32 b_ = (UINT32)sp[-1], a_ = (UINT32)sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        sp--; sp[-1] = (b_ == 0xFFFFFFFFu) ? 0 : (UINT32)((INT32)a_ % (INT32)b_); WM_NEXT();
+    }
+    WM_CASE(WM_I32_REM_U) {
+        UINT32 b_ = (UINT32)sp[-1], a_ = (UINT32)sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        sp--; sp[-1] = a_ % b_; WM_NEXT();
+    }
+    WM_CASE(WM_I32_AND)     WM_BIN32(a_ & b_)
+    WM_CASE(WM_I32_OR)      WM_BIN32(a_ | b_)
+    WM_CASE(WM_I32_XOR)     WM_BIN32(a_ ^ b_)
+    WM_CASE(WM_I32_SHL)     WM_BIN32(a_ << (b_ & 31))
+    WM_CASE(WM_I32_SHR_S)   WM_BIN32((UINT32)((INT32)a_ >> (b_ & 31)))
+    WM_CASE(WM_I32_SHR_U)   WM_BIN32(a_ >> (b_ & 31))
+    WM_CASE(WM_I32_ROTL)    WM_BIN32(_wm_rotl32(a_, b_))
+    WM_CASE(WM_I32_ROTR)    WM_BIN32(_wm_rotr32(a_, b_))
+
+    WM_CASE(WM_I64_CLZ)     WM_UN64(a_ ? (UINT64)__builtin_clzll(a_) : 64u)
+    WM_CASE(WM_I64_CTZ)     WM_UN64(a_ ? (UINT64)__builtin_ctzll(a_) : 64u)
+    WM_CASE(WM_I64_POPCNT)  WM_UN64((UINT64)__builtin_popcountll(a_))
+    WM_CASE(WM_I64_ADD)     WM_BIN64(a_ + b_)
+    WM_CASE(WM_I64_SUB)     WM_BIN64(a_ - b_)
+    WM_CASE(WM_I64_MUL)     WM_BIN64(a_ * b_)
+    WM_CASE(WM_I64_DIV_S) {
+        UINT64 b_ = sp[-1], a_ = sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        if (a_ == 0x8000000000000000ull && b_ == ~0ull) WM_TRAP("integer overflow");
+        sp--; sp[-1] = (UINT64)((INT64)a_ / (INT64)b_); WM_NEXT();
+    }
+    WM_CASE(WM_I64_DIV_U) {
+        UINT64 b_ = sp[-1], a_ = sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        sp--; sp[-1] = a_ / b_; WM_NEXT();
+    }
+    WM_CASE(WM_I64_REM_S) {
+        UINT64 b_ = sp[-1], a_ = sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        sp--; sp[-1] = (b_ == ~0ull) ? 0 : (UINT64)((INT64)a_ % (INT64)b_); WM_NEXT();
+    }
+    WM_CASE(WM_I64_REM_U) {
+        UINT64 b_ = sp[-1], a_ = sp[-2];
+        if (!b_) WM_TRAP("integer divide by zero");
+        sp--; sp[-1] = a_ % b_; WM_NEXT();
+    }
+    WM_CASE(WM_I64_AND)     WM_BIN64(a_ & b_)
+    WM_CASE(WM_I64_OR)      WM_BIN64(a_ | b_)
+    WM_CASE(WM_I64_XOR)     WM_BIN64(a_ ^ b_)
+    WM_CASE(WM_I64_SHL)     WM_BIN64(a_ << (b_ & 63))
+    WM_CASE(WM_I64_SHR_S)   WM_BIN64((UINT64)((INT64)a_ >> (b_ & 63)))
+    WM_CASE(WM_I64_SHR_U)   WM_BIN64(a_ >> (b_ & 63))
+    WM_CASE(WM_I64_ROTL)    WM_BIN64(_wm_rotl64(a_, b_))
+    WM_CASE(WM_I64_ROTR)    WM_BIN64(_wm_rotr64(a_, b_))
+
+    WM_CASE(WM_I32_WRAP_I64)      WM_UN64((UINT32)a_)
+    WM_CASE(WM_I64_EXTEND_I32_S)  WM_UN64((UINT64)(INT64)(INT32)(UINT32)a_)
+    WM_CASE(WM_I64_EXTEND_I32_U)  WM_UN64((UINT32)a_)
+    WM_CASE(WM_I32_EXTEND8_S)     WM_UN32((UINT32)(INT32)(INT8)a_)
+    WM_CASE(WM_I32_EXTEND16_S)    WM_UN32((UINT32)(INT32)(INT16)a_)
+    WM_CASE(WM_I64_EXTEND8_S)     WM_UN64((UINT64)(INT64)(INT8)a_)
+    WM_CASE(WM_I64_EXTEND16_S)    WM_UN64((UINT64)(INT64)(INT16)a_)
+    WM_CASE(WM_I64_EXTEND32_S)    WM_UN64((UINT64)(INT64)(INT32)a_)
+
+#ifndef WM_THREADED
+    default: WM_TRAP("bad insn");
+    }
+    }
+#endif
+
+out:
+    if (!EFI_ERROR(st) && result) *result = (sp > m->stack) ? sp[-1] : 0;
+    return st;
 }
 
 /* ── Public call API ─────────────────────────────────────────────────────── */
@@ -446,9 +1015,23 @@ EFI_STATUS oo_wasm_call(OoWasmMod *m, const CHAR8 *name,
     /* find export */
     for (UINT32 i=0; i<m->export_count; i++) {
         if (m->exports[i].kind==0 && _wm_strcmp(m->exports[i].name,name)==0) {
-            OoWasmVal rv; _wm_memset(&rv,0,sizeof(rv));
-            EFI_STATUS st = _exec(m, m->exports[i].index, args, nargs, &rv, 0);
-            if (ret) *ret = rv;
+            UINT32 fi = m->exports[i].index;
+            if (fi >= m->func_count) return EFI_NOT_FOUND;
+            const OoWasmFunc *fn = &m->funcs[fi];
+            const OoWasmFuncType *ft = &m->types[fn->type_idx];
+            if (nargs != ft->param_count) { _wm_err(m,(const CHAR8*)"argument count mismatch"); return EFI_INVALID_PARAMETER; }
+            if (fn->max_height > OO_WASM_MAX_STACK) return EFI_OUT_OF_RESOURCES;
+            for (UINT32 k=0; k<nargs; k++)
+                m->stack[k] = (ft->params[k] == OO_WASM_I64) ? args[k].u64 : (UINT64)args[k].u32;
+            UINT64 rv = 0;
+            m->error[0] = 0;
+            EFI_STATUS st = _wm_run(m, fi, &rv);
+            if (ret) {
+                _wm_memset(ret, 0, sizeof(*ret));
+                ret->type = ft->result_count ? ft->results[0] : OO_WASM_I32;
+                if (ret->type == OO_WASM_I64) ret->u64 = rv;
+                else ret->u32 = (UINT32)rv;
+            }
             return st;
         }
     }
@@ -458,7 +1041,8 @@ EFI_STATUS oo_wasm_call(OoWasmMod *m, const CHAR8 *name,
 EFI_STATUS oo_wasm_call_i32(OoWasmMod *m, const CHAR8 *name,
                               INT32 *args, UINT32 nargs, INT32 *result) {
     OoWasmVal wargs[8];
-    for (UINT32 i=0; i<nargs&&i<8; i++) { wargs[i].type=OO_WASM_I32; wargs[i].i32=args[i]; }
+    if (nargs > 8) nargs = 8;
+    for (UINT32 i=0; i<nargs; i++) { wargs[i].type=OO_WASM_I32; wargs[i].u64=0; wargs[i].i32=args[i]; }
     OoWasmVal ret; _wm_memset(&ret,0,sizeof(ret));
     EFI_STATUS st = oo_wasm_call(m, name, wargs, nargs, &ret);
     if (!EFI_ERROR(st) && result) *result = ret.i32;
@@ -468,17 +1052,26 @@ EFI_STATUS oo_wasm_call_i32(OoWasmMod *m, const CHAR8 *name,
 /* ── Unload ──────────────────────────────────────────────────────────────── */
 void oo_wasm_unload(OoWasmMod *m) {
     if (m->data) {
-        uefi_call_wrapper(BS->FreePool, 1, m->data);
+        _wm_free(m->data);
         m->data = NULL;
     }
+    if (m->insns) {
+        _wm_free(m->insns);
+        m->insns = NULL;
+    }
+    m->insn_count = 0;
+    m->threaded = 0;
     m->loaded = 0;
 }
 
+#ifdef UEFI_BUILD
 /* ── Print info ──────────────────────────────────────────────────────────── */
 void oo_wasm_print_info(const OoWasmMod *m) {
     Print(L"[wasm] Loaded: %d  Size: %u bytes\r\n", m->loaded, (UINT32)m->data_size);
-    Print(L"[wasm] Types: %u  Funcs: %u  Exports: %u  MemPages: %u\r\n",
-          m->type_count, m->func_count, m->export_count, m->mem_pages);
+    Print(L"[wasm] Types: %u  Funcs: %u  Exports: %u  Globals: %u  MemPages: %u\r\n",
+          m->type_count, m->func_count, m->export_count, m->global_count, m->mem_pages);
+    Print(L"[wasm] Compiled: %u insns (%u bytes)\r\n",
+          m->insn_count, (UINT32)(m->insn_count * sizeof(OoWasmInsn)));
     for (UINT32 i=0; i<m->export_count; i++) {
         if (m->exports[i].kind==0)
             Print(L"  export[%u]: %a → func[%u]\r\n",
@@ -539,7 +1132,8 @@ int oo_wasm_repl_cmd(OoWasmMod *m, EFI_FILE_HANDLE root, const char *cmd) {
         INT32 result=0;
         EFI_STATUS st = oo_wasm_call_i32(m, fname, args, nargs, &result);
         if (EFI_ERROR(st))
-            Print(L"[wasm] Call failed: %r (not found or error)\r\n\r\n", st);
+            Print(L"[wasm] Call failed: %r %a\r\n\r\n", st,
+                  st == EFI_ABORTED ? m->error : (const CHAR8*)"(not found or error)");
         else
             Print(L"[wasm] Result: %d (0x%08x)\r\n\r\n", result, (UINT32)result);
         return 1;
@@ -554,3 +1148,4 @@ int oo_wasm_repl_cmd(OoWasmMod *m, EFI_FILE_HANDLE root, const char *cmd) {
 
     return 0;
 }
+#endif /* UEFI_BUILD */
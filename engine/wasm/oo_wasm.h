@@ -4,28 +4,47 @@
  * No libc, no OS. Freestanding C11. EFI file load.
  *
  * Supports:
- *   - MVP (WASM 1.0) binary format
- *   - i32/i64 arithmetic + local vars + call
+ *   - MVP (WASM 1.0) binary format, integer subset (i32/i64)
+ *   - structured control flow, locals, globals, call, recursion
+ *   - linear memory loads/stores (64 KB, bounds-checked)
  *   - EFI filesystem load
  *
+ * Execution (Phase 10B):
+ *   Each function body is validated once at load time and translated into
+ *   a compact OoWasmInsn stream: LEB128 immediates are decoded, branch
+ *   targets and stack-height fixups are precomputed, and block/loop/end
+ *   disappear. The interpreter then runs direct-threaded (computed goto)
+ *   over a flat 64-bit value stack with an explicit call-frame stack — no
+ *   bytecode rescans, no C recursion.
+ *
  * Usage:
  *   OoWasmMod mod;
  *   oo_wasm_load_file(&mod, root, L"module.wasm");
  *   INT32 result;
  *   oo_wasm_call_i32(&mod, "add", &arg, 1, &result);
+ *
+ * Host builds (tests/test_wasm.c) include efi_compat.h and provide
+ * oo_wasm_host_alloc()/oo_wasm_host_free().
  */
 #ifndef OO_WASM_H
 #define OO_WASM_H
 
+#ifdef UEFI_BUILD
 #include <efi.h>
+#else
+#include "../ssm/efi_compat.h"
+#endif
 
 /* ── Limits ──────────────────────────────────────────────────────────────── */
-#define OO_WASM_MAX_FUNCS     64
-#define OO_WASM_MAX_EXPORTS   64
-#define OO_WASM_MAX_LOCALS    32
-#define OO_WASM_MAX_STACK     256
-#define OO_WASM_MAX_MEMORY    (64 * 1024)   /* 64 KB linear memory */
-#define OO_WASM_MAX_CODE_SIZE (256 * 1024)  /* 256 KB max module size */
+#define OO_WASM_MAX_FUNCS       64
+#define OO_WASM_MAX_EXPORTS     64
+#define OO_WASM_MAX_GLOBALS     64
+#define OO_WASM_MAX_LOCALS      1024          /* params + locals per frame */
+#define OO_WASM_MAX_BLOCKS      256           /* nested block/loop/if per function */
+#define OO_WASM_MAX_STACK       16384         /* value-stack slots, all frames */
+#define OO_WASM_MAX_CALL_DEPTH  1024
+#define OO_WASM_MAX_MEMORY      (64 * 1024)   /* 64 KB linear memory */
+#define OO_WASM_MAX_CODE_SIZE   (256 * 1024)  /* 256 KB max module size */
 
 /* ── WASM value type ─────────────────────────────────────────────────────── */
 typedef enum {
@@ -59,10 +78,30 @@ typedef struct {
     UINT32        type_idx;
     UINT32        code_offset;  /* byte offset in mod->data */
     UINT32        code_size;
-    UINT8         local_count;
-    OoWasmValType locals[OO_WASM_MAX_LOCALS];
+    UINT32        local_count;  /* declared locals (excluding params) */
+    /* Filled by the load-time compiler */
+    UINT32        insn_off;     /* first insn in mod->insns */
+    UINT16        param_count;
+    UINT16        frame_size;   /* params + locals */
+    UINT32        max_height;   /* peak value-stack use, frame-relative */
+    UINT8         result_count;
 } OoWasmFunc;
 
+/* ── Pre-decoded instruction ─────────────────────────────────────────────── */
+typedef struct {
+    union {
+        const void *h;          /* threaded: handler address */
+        UINTN       op;         /* internal opcode (until threaded) */
+    };
+    UINT32 a;                   /* immediate / branch target insn index */
+    UINT32 b;                   /* second immediate / (label_height << 1) | arity */
+} OoWasmInsn;
+
+typedef struct {
+    const OoWasmInsn *ret;      /* caller resume point */
+    UINT64           *fp;       /* caller frame base */
+} OoWasmFrame;
+
 /* ── Export entry ────────────────────────────────────────────────────────── */
 typedef struct {
     CHAR8  name[64];
@@ -84,22 +123,39 @@ typedef struct {
     UINT32   export_count;
     OoWasmExport exports[OO_WASM_MAX_EXPORTS];
 
+    UINT32   global_count;
+    UINT64   globals[OO_WASM_MAX_GLOBALS];
+    UINT8    global_mut[OO_WASM_MAX_GLOBALS];
+
     UINT8    mem[OO_WASM_MAX_MEMORY]; /* linear memory */
     UINT32   mem_pages;
 
+    /* Compiled code (AllocatePool'd) + interpreter state */
+    OoWasmInsn *insns;
+    UINT32   insn_count;
+    int      threaded;      /* insns[].h resolved to handler addresses */
+    UINT64   stack[OO_WASM_MAX_STACK];
+    OoWasmFrame frames[OO_WASM_MAX_CALL_DEPTH];
+
     int      loaded;
     CHAR8    error[128];
 } OoWasmMod;
 
 /* ── API ─────────────────────────────────────────────────────────────────── */
 
+void oo_wasm_init(OoWasmMod *mod);
+
 EFI_STATUS oo_wasm_load_file(OoWasmMod *mod, EFI_FILE_HANDLE root,
                               const CHAR16 *path);
 
+/* Parse + validate + compile. Fails (mod->error set) on malformed modules
+ * or on features outside the supported subset. */
 EFI_STATUS oo_wasm_load_buf(OoWasmMod *mod,
                              const UINT8 *buf, UINTN size);
 
-/* Call exported function — args[nargs] in, ret = first result (may be NULL) */
+/* Call exported function — args[nargs] in, ret = first result (may be NULL).
+ * Traps (unreachable, divide by zero, out-of-bounds memory, stack
+ * exhaustion) return EFI_ABORTED with the reason in mod->error. */
 EFI_STATUS oo_wasm_call(OoWasmMod *mod,
                          const CHAR8 *func_name,
                          OoWasmVal *args, UINT32 nargs,
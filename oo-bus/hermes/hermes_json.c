@@ -1,88 +1,8 @@
 #include "hermes_json.h"
+#include "hermes_json_tape.h"
 
 #include <string.h>
 
-static int hermes_is_space(char c) {
-    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
-}
-
-static const char* hermes_skip_ws(const char* p, const char* end) {
-    while (p < end && hermes_is_space(*p)) p++;
-    return p;
-}
-
-static const char* hermes_find_key_in_object(const char* obj, const char* end, const char* key) {
-    // Find a key in the *current* JSON object only (depth==1 relative to obj '{').
-    // Returns pointer just after the closing quote of the key string.
-    if (!obj || !end || !key) return NULL;
-    obj = hermes_skip_ws(obj, end);
-    if (obj >= end || *obj != '{') return NULL;
-
-    const size_t klen = strlen(key);
-    int depth = 0;
-    for (const char* p = obj; p < end; ) {
-        char c = *p;
-        if (c == '"') {
-            // Parse a JSON string token and (only at depth==1) treat it as a potential object key.
-            const char* s = p + 1;
-            const char* q = s;
-            size_t n = 0;
-            int mismatch = 0;
-            while (q < end) {
-                char ch = *q++;
-                if (ch == '\\') {
-                    // Escapes are not expected in schema keys; treat as mismatch and skip string.
-                    mismatch = 1;
-                    if (q >= end) return NULL;
-                    q++;
-                    continue;
-                }
-                if (ch == '"') break;
-                if (!mismatch) {
-                    if (n >= klen || ch != key[n]) mismatch = 1;
-                }
-                n++;
-            }
-            if (q == end || *(q - 1) != '"') return NULL;
-
-            if (depth == 1 && !mismatch && n == klen) {
-                const char* after = hermes_skip_ws(q, end);
-                if (after < end && *after == ':') {
-                    return q;
-                }
-            }
-
-            p = q;
-            continue;
-        }
-
-        if (c == '{') {
-            depth++;
-            p++;
-            continue;
-        }
-        if (c == '}') {
-            depth--;
-            p++;
-            if (depth <= 0) break;
-            continue;
-        }
-        if (c == '[') {
-            depth++;
-            p++;
-            continue;
-        }
-        if (c == ']') {
-            depth--;
-            p++;
-            continue;
-        }
-
-        p++;
-    }
-    return NULL;
-}
-
 static hermes_status_t hermes_append_char(char** dst, size_t* left, char c) {
     if (*left < 1) return HERMES_ERR_BAD_LENGTH;
     **dst = c;
@@ -151,7 +71,14 @@ static hermes_status_t hermes_append_json_string(char** dst, size_t* left, const
                 st = hermes_append_str(dst, left, "\\t");
                 break;
             default:
-                st = hermes_append_char(dst, left, c);
+                if ((unsigned char)c < 0x20) {
+                    // Other control bytes are not legal raw inside a JSON string
+                    static const char hex[] = "0123456789abcdef";
+                    char u[7] = { '\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF], 0 };
+                    st = hermes_append_str(dst, left, u);
+                } else {
+                    st = hermes_append_char(dst, left, c);
+                }
                 break;
         }
         if (st != HERMES_OK) return st;
@@ -236,63 +163,6 @@ hermes_status_t hermes_json_encode_msg(
     return HERMES_OK;
 }
 
-static hermes_status_t hermes_parse_u64_after_colon(const char* p, const char* end, uint64_t* out) {
-    if (!p || !out) return HERMES_ERR_INVALID_ARG;
-    p = hermes_skip_ws(p, end);
-    if (p >= end || *p != ':') return HERMES_ERR_INVALID_ARG;
-    p++;
-    p = hermes_skip_ws(p, end);
-    if (p >= end) return HERMES_ERR_INVALID_ARG;
-
-    uint64_t v = 0;
-    int any = 0;
-    while (p < end && *p >= '0' && *p <= '9') {
-        any = 1;
-        v = (v * 10u) + (uint64_t)(*p - '0');
-        p++;
-    }
-    if (!any) return HERMES_ERR_INVALID_ARG;
-    *out = v;
-    return HERMES_OK;
-}
-
-static hermes_status_t hermes_parse_string_after_colon(const char* p, const char* end, char* out, size_t out_cap, size_t* out_len) {
-    if (!p || !out_len) return HERMES_ERR_INVALID_ARG;
-    p = hermes_skip_ws(p, end);
-    if (p >= end || *p != ':') return HERMES_ERR_INVALID_ARG;
-    p++;
-    p = hermes_skip_ws(p, end);
-    if (p >= end || *p != '"') return HERMES_ERR_INVALID_ARG;
-    p++;
-
-    size_t n = 0;
-    while (p < end) {
-        char c = *p++;
-        if (c == '"') break;
-        if (c == '\\') {
-            if (p >= end) return HERMES_ERR_INVALID_ARG;
-            char esc = *p++;
-            switch (esc) {
-                case '"': c = '"'; break;
-                case '\\': c = '\\'; break;
-                case 'n': c = '\n'; break;
-                case 'r': c = '\r'; break;
-                case 't': c = '\t'; break;
-                default: return HERMES_ERR_INVALID_ARG;
-            }
-        }
-        if (out) {
-            if (n + 1 >= out_cap) return HERMES_ERR_BAD_LENGTH;
-            out[n] = c;
-        }
-        n++;
-    }
-
-    if (out) out[n] = '\0';
-    *out_len = n;
-    return HERMES_OK;
-}
-
 static hermes_kind_t hermes_kind_from_str(const char* s, size_t n) {
     if (n == 7 && memcmp(s, "COMMAND", 7) == 0) return HERMES_KIND_COMMAND;
     if (n == 5 && memcmp(s, "EVENT", 5) == 0) return HERMES_KIND_EVENT;
@@ -300,6 +170,13 @@ static hermes_kind_t hermes_kind_from_str(const char* s, size_t n) {
     return (hermes_kind_t)0;
 }
 
+
+static hermes_status_t hermes_field_u64(const hermes_json_keys_t* keys, const char* key, uint64_t* out) {
+    uint32_t idx = hermes_json_keys_get(keys, key);
+    if (idx == HERMES_JSON_NONE) return HERMES_ERR_INVALID_ARG;
+    return hermes_json_tok_u64(keys->tape, idx, out);
+}
+
 hermes_status_t hermes_json_decode_msg(
     const char* json,
     size_t json_len,
@@ -308,83 +185,73 @@ hermes_status_t hermes_json_decode_msg(
     size_t payload_buf_cap
 ) {
     if (!json || !out_msg) return HERMES_ERR_INVALID_ARG;
-    const char* end = json + json_len;
 
     memset(out_msg, 0, sizeof(*out_msg));
 
-    // Root object
-    const char* root = hermes_skip_ws(json, end);
-    if (root >= end || *root != '{') return HERMES_ERR_INVALID_ARG;
+    // One pass over the text; every field below is a tape lookup
+    hermes_json_tok_t toks[HERMES_JSON_DECODE_MAX_TOKENS];
+    hermes_json_tape_t tape;
+    hermes_status_t st = hermes_json_tape_parse(&tape, json, json_len, toks, HERMES_JSON_DECODE_MAX_TOKENS);
+    if (st != HERMES_OK) return st;
+    if (toks[0].type != HERMES_JSON_OBJECT) return HERMES_ERR_INVALID_ARG;
 
-    // v.maj and v.min (within the nested v object)
-    const char* vkey = hermes_find_key_in_object(root, end, "v");
-    if (!vkey) return HERMES_ERR_INVALID_ARG;
-    const char* vpos = hermes_skip_ws(vkey, end);
-    if (vpos >= end || *vpos != ':') return HERMES_ERR_INVALID_ARG;
-    vpos++;
-    vpos = hermes_skip_ws(vpos, end);
-    if (vpos >= end || *vpos != '{') return HERMES_ERR_INVALID_ARG;
+    hermes_json_keys_t root;
+    st = hermes_json_keys_build(&tape, 0, &root);
+    if (st != HERMES_OK) return st;
 
-    const char* vobj = vpos;
+    // v.maj and v.min (within the nested v object)
+    uint32_t vobj = hermes_json_keys_get(&root, "v");
+    if (vobj == HERMES_JSON_NONE || toks[vobj].type != HERMES_JSON_OBJECT) return HERMES_ERR_INVALID_ARG;
+    uint32_t majpos = hermes_json_object_find(&tape, vobj, "maj", 3);
+    uint32_t minpos = hermes_json_object_find(&tape, vobj, "min", 3);
+    if (majpos == HERMES_JSON_NONE || minpos == HERMES_JSON_NONE) return HERMES_ERR_INVALID_ARG;
 
     uint64_t maj = 0, min = 0;
-    const char* majpos = hermes_find_key_in_object(vobj, end, "maj");
-    const char* minpos = hermes_find_key_in_object(vobj, end, "min");
-    if (!majpos || !minpos) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(majpos, end, &maj) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(minpos, end, &min) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_json_tok_u64(&tape, majpos, &maj) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_json_tok_u64(&tape, minpos, &min) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
     out_msg->header.version_major = (uint16_t)maj;
     out_msg->header.version_minor = (uint16_t)min;
 
-    // kind
-    const char* kpos = hermes_find_key_in_object(root, end, "kind");
-    if (!kpos) return HERMES_ERR_INVALID_ARG;
+    // kind (compared raw: the schema values never need escapes)
+    uint32_t kpos = hermes_json_keys_get(&root, "kind");
+    const char* ks = NULL;
     size_t klen = 0;
-    char ktmp[16];
-    if (hermes_parse_string_after_colon(kpos, end, ktmp, sizeof(ktmp), &klen) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
-    hermes_kind_t kind = hermes_kind_from_str(ktmp, klen);
+    if (kpos == HERMES_JSON_NONE) return HERMES_ERR_INVALID_ARG;
+    if (hermes_json_tok_view(&tape, kpos, &ks, &klen) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    hermes_kind_t kind = hermes_kind_from_str(ks, klen);
     if ((int)kind == 0) return HERMES_ERR_INVALID_ARG;
     out_msg->header.kind = (uint16_t)kind;
 
     // numeric fields
     uint64_t u = 0;
-    const char* fpos = hermes_find_key_in_object(root, end, "flags");
-    if (!fpos) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(fpos, end, &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_field_u64(&root, "flags", &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
     out_msg->header.flags = (uint16_t)u;
 
-    const char* plpos = hermes_find_key_in_object(root, end, "payload_len");
-    if (!plpos) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(plpos, end, &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_field_u64(&root, "payload_len", &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
     if (u > 0xFFFFFFFFu) return HERMES_ERR_INVALID_ARG;
     uint32_t declared_payload_len = (uint32_t)u;
     if (declared_payload_len > (uint32_t)HERMES_JSON_MAX_PAYLOAD_LEN) return HERMES_ERR_BAD_LENGTH;
     out_msg->header.payload_len = declared_payload_len;
 
-    const char* cpos = hermes_find_key_in_object(root, end, "correlation_id");
-    if (!cpos) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(cpos, end, &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_field_u64(&root, "correlation_id", &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
     out_msg->header.correlation_id = (uint64_t)u;
 
-    const char* spos = hermes_find_key_in_object(root, end, "source");
-    if (!spos) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(spos, end, &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_field_u64(&root, "source", &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
     out_msg->header.source = (uint64_t)u;
 
-    const char* dpos = hermes_find_key_in_object(root, end, "dest");
-    if (!dpos) return HERMES_ERR_INVALID_ARG;
-    if (hermes_parse_u64_after_colon(dpos, end, &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
+    if (hermes_field_u64(&root, "dest", &u) != HERMES_OK) return HERMES_ERR_INVALID_ARG;
     out_msg->header.dest = (uint64_t)u;
 
     // payload (optional)
-    const char* ppos = hermes_find_key_in_object(root, end, "payload");
-    if (ppos) {
+    uint32_t ppos = hermes_json_keys_get(&root, "payload");
+    if (ppos != HERMES_JSON_NONE) {
         size_t n = 0;
+        if (toks[ppos].type != HERMES_JSON_STRING) return HERMES_ERR_INVALID_ARG;
         if (!payload_buf || payload_buf_cap == 0) return HERMES_ERR_BAD_LENGTH;
-        // Ensure there's enough cap even before parsing the string.
+        // Ensure there's enough cap even before decoding the string.
         // +1 for NUL terminator.
         if (declared_payload_len + 1u > (uint32_t)payload_buf_cap) return HERMES_ERR_BAD_LENGTH;
-        hermes_status_t st = hermes_parse_string_after_colon(ppos, end, payload_buf, payload_buf_cap, &n);
+        st = hermes_json_tok_string(&tape, ppos, payload_buf, payload_buf_cap, &n);
         if (st != HERMES_OK) return st;
         if (declared_payload_len != (uint32_t)n) return HERMES_ERR_INVALID_ARG;
         out_msg->payload = payload_buf;
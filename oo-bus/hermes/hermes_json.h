@@ -15,6 +15,12 @@
 #define HERMES_JSON_MAX_PAYLOAD_LEN 4096u
 #endif
 
+// Token budget for one decoded message (tape lives on the decoder's stack).
+// A Hermes message needs ~12 tokens; the rest is headroom for extra fields.
+#ifndef HERMES_JSON_DECODE_MAX_TOKENS
+#define HERMES_JSON_DECODE_MAX_TOKENS 256u
+#endif
+
 // Encode Hermes message to JSON into `out`.
 // Returns HERMES_OK and sets out_len on success.
 hermes_status_t hermes_json_encode_msg(
@@ -24,6 +30,7 @@ hermes_status_t hermes_json_encode_msg(
     size_t* out_len);
 
 // Decode JSON into Hermes message.
+// The input is tokenized once (hermes_json_tape.h) and must be well-formed JSON.
 // `payload_buf` receives decoded payload string (NUL-terminated). If payload is absent, payload_len=0 and payload=NULL.
 hermes_status_t hermes_json_decode_msg(
     const char* json,
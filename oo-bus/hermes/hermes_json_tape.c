@@ -0,0 +1,596 @@
+#include "hermes_json_tape.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HERMES_JSON_SSE2 1
+#endif
+
+// Byte classes for stage 1 (scalar path) and scalar-span scanning.
+#define HJ_C_QUOTE   0x01u
+#define HJ_C_BSLASH  0x02u
+#define HJ_C_WS      0x04u
+#define HJ_C_OP      0x08u   // { } [ ] : ,
+#define HJ_C_CTRL    0x10u   // < 0x20 (not allowed raw inside strings)
+
+#define HJ_EVEN_BITS 0x5555555555555555ull
+#define HJ_ODD_BITS  0xAAAAAAAAAAAAAAAAull
+
+static uint8_t g_hj_class[256];
+static int g_hj_class_ready = 0;
+static int g_hj_force_scalar = 0;
+
+static void hj_class_init(void) {
+    for (int c = 0; c < 256; c++) {
+        uint8_t k = 0;
+        if (c == '"') k |= HJ_C_QUOTE;
+        if (c == '\\') k |= HJ_C_BSLASH;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') k |= HJ_C_WS;
+        if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') k |= HJ_C_OP;
+        if (c < 0x20) k |= HJ_C_CTRL;
+        g_hj_class[c] = k;
+    }
+    g_hj_class_ready = 1;
+}
+
+void hermes_json_tape_force_scalar(int on) {
+    g_hj_force_scalar = on ? 1 : 0;
+}
+
+// ─── Stage 1: structural bitmasks ───────────────────────────────────────────
+
+typedef struct hj_block {
+    uint64_t quote;
+    uint64_t bslash;
+    uint64_t ws;
+    uint64_t op;
+    uint64_t ctrl;
+} hj_block_t;
+
+static void hj_classify_scalar(const unsigned char* p, hj_block_t* b) {
+    uint64_t q = 0, bs = 0, ws = 0, op = 0, ctrl = 0;
+    for (int i = 0; i < 64; i++) {
+        uint64_t bit = 1ull << i;
+        uint8_t k = g_hj_class[p[i]];
+        if (k & HJ_C_QUOTE) q |= bit;
+        if (k & HJ_C_BSLASH) bs |= bit;
+        if (k & HJ_C_WS) ws |= bit;
+        if (k & HJ_C_OP) op |= bit;
+        if (k & HJ_C_CTRL) ctrl |= bit;
+    }
+    b->quote = q;
+    b->bslash = bs;
+    b->ws = ws;
+    b->op = op;
+    b->ctrl = ctrl;
+}
+
+#ifdef HERMES_JSON_SSE2
+static void hj_classify_sse2(const unsigned char* p, hj_block_t* b) {
+    const __m128i k_quote = _mm_set1_epi8('"');
+    const __m128i k_bslash = _mm_set1_epi8('\\');
+    const __m128i k_space = _mm_set1_epi8(' ');
+    const __m128i k_tab = _mm_set1_epi8('\t');
+    const __m128i k_lf = _mm_set1_epi8('\n');
+    const __m128i k_cr = _mm_set1_epi8('\r');
+    const __m128i k_lower = _mm_set1_epi8(0x20);
+    const __m128i k_lbrace = _mm_set1_epi8('{');   // '[' | 0x20 == '{'
+    const __m128i k_rbrace = _mm_set1_epi8('}');   // ']' | 0x20 == '}'
+    const __m128i k_colon = _mm_set1_epi8(':');
+    const __m128i k_comma = _mm_set1_epi8(',');
+    const __m128i k_ctrl = _mm_set1_epi8(0x1F);
+
+    uint64_t q = 0, bs = 0, ws = 0, op = 0, ctrl = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+        __m128i vl = _mm_or_si128(v, k_lower);
+        __m128i m_ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, k_space), _mm_cmpeq_epi8(v, k_tab)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, k_lf), _mm_cmpeq_epi8(v, k_cr)));
+        __m128i m_op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(vl, k_lbrace), _mm_cmpeq_epi8(vl, k_rbrace)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, k_colon), _mm_cmpeq_epi8(v, k_comma)));
+        __m128i m_ctrl = _mm_cmpeq_epi8(_mm_max_epu8(v, k_ctrl), k_ctrl);
+        int sh = 16 * k;
+        q |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, k_quote)) << sh;
+        bs |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, k_bslash)) << sh;
+        ws |= (uint64_t)(uint16_t)_mm_movemask_epi8(m_ws) << sh;
+        op |= (uint64_t)(uint16_t)_mm_movemask_epi8(m_op) << sh;
+        ctrl |= (uint64_t)(uint16_t)_mm_movemask_epi8(m_ctrl) << sh;
+    }
+    b->quote = q;
+    b->bslash = bs;
+    b->ws = ws;
+    b->op = op;
+    b->ctrl = ctrl;
+}
+#endif
+
+// Bits of characters preceded by an odd-length run of backslashes
+// (i.e. escaped characters). *carry is 1 when the previous block ended in an
+// odd run.
+static uint64_t hj_escaped(uint64_t bs, uint64_t* carry) {
+    uint64_t start_edges = bs & ~(bs << 1);
+    uint64_t even_start_mask = HJ_EVEN_BITS ^ *carry;
+    uint64_t even_starts = start_edges & even_start_mask;
+    uint64_t odd_starts = start_edges & ~even_start_mask;
+    uint64_t even_carries = bs + even_starts;
+    uint64_t odd_carries = bs + odd_starts;
+    uint64_t ends_odd = (odd_carries < bs) ? 1u : 0u;
+    odd_carries |= *carry;
+    *carry = ends_odd;
+    uint64_t even_carry_ends = even_carries & ~bs;
+    uint64_t odd_carry_ends = odd_carries & ~bs;
+    return (even_carry_ends & HJ_ODD_BITS) | (odd_carry_ends & HJ_EVEN_BITS);
+}
+
+// Bit i = XOR of bits 0..i (carry-less multiply by all-ones).
+static inline uint64_t hj_prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// ─── Stage 2 helpers ────────────────────────────────────────────────────────
+
+enum {
+    HJ_ST_VALUE = 0,        // a value is required
+    HJ_ST_VALUE_OR_CLOSE,   // after '['
+    HJ_ST_KEY,              // after ',' in an object
+    HJ_ST_KEY_OR_CLOSE,     // after '{'
+    HJ_ST_COLON,
+    HJ_ST_COMMA_OR_CLOSE,
+    HJ_ST_DONE,
+};
+
+static size_t hj_number_len(const char* s, size_t n) {
+    size_t i = 0;
+    if (i < n && s[i] == '-') i++;
+    if (i >= n) return 0;
+    if (s[i] == '0') {
+        i++;
+    } else if (s[i] >= '1' && s[i] <= '9') {
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+    } else {
+        return 0;
+    }
+    if (i < n && s[i] == '.') {
+        size_t d = ++i;
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+        if (i == d) return 0;
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+        size_t d = i;
+        while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+        if (i == d) return 0;
+    }
+    return i;
+}
+
+static int hj_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Returns the offset of the first bad escape in s[0..n), or n if all valid.
+static size_t hj_check_escapes(const char* s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] != '\\') continue;
+        if (i + 1 >= n) return i;
+        char e = s[++i];
+        switch (e) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                if (i + 4 >= n) return i;
+                for (int k = 1; k <= 4; k++) {
+                    if (hj_hex(s[i + k]) < 0) return i;
+                }
+                i += 4;
+                break;
+            default:
+                return i;
+        }
+    }
+    return n;
+}
+
+// ─── Parse ──────────────────────────────────────────────────────────────────
+
+hermes_status_t hermes_json_tape_parse(
+    hermes_json_tape_t* tape,
+    const char* json,
+    size_t len,
+    hermes_json_tok_t* toks,
+    uint32_t cap
+) {
+    if (!tape || (!json && len) || !toks || cap == 0) return HERMES_ERR_INVALID_ARG;
+    if (len >= HERMES_JSON_NONE) return HERMES_ERR_BAD_LENGTH;
+    if (!g_hj_class_ready) hj_class_init();
+
+    tape->json = json;
+    tape->len = len;
+    tape->toks = toks;
+    tape->cap = cap;
+    tape->count = 0;
+    tape->error_offset = 0;
+
+    uint32_t stack[HERMES_JSON_MAX_DEPTH];
+    uint32_t depth = 0;
+    int st = HJ_ST_VALUE;
+    int in_string = 0;          // stage 2: waiting for a closing quote
+    int string_is_key = 0;
+    uint32_t str_tok = 0;
+
+    uint64_t odd_carry = 0;     // previous block ended in an odd backslash run
+    uint64_t str_carry = 0;     // previous block ended inside a string (all ones)
+    uint64_t scalar_carry = 0;  // previous block ended on a scalar byte
+    size_t last_bs = (size_t)-1;    // last backslash inside a string
+
+    unsigned char pad[64];
+    size_t pos = 0;
+    hermes_status_t err = HERMES_ERR_INVALID_ARG;
+
+    for (size_t base = 0; base < len; base += 64) {
+        const unsigned char* blk = (const unsigned char*)json + base;
+        if (len - base < 64) {
+            memset(pad, ' ', sizeof(pad));
+            memcpy(pad, blk, len - base);
+            blk = pad;
+        }
+
+        hj_block_t b;
+#ifdef HERMES_JSON_SSE2
+        if (!g_hj_force_scalar) hj_classify_sse2(blk, &b);
+        else hj_classify_scalar(blk, &b);
+#else
+        hj_classify_scalar(blk, &b);
+#endif
+
+        uint64_t escaped = hj_escaped(b.bslash, &odd_carry);
+        uint64_t quotes = b.quote & ~escaped;
+        uint64_t in_str = hj_prefix_xor(quotes) ^ str_carry;   // opening quote + body
+        str_carry = (uint64_t)((int64_t)in_str >> 63);
+
+        uint64_t bad_ctrl = b.ctrl & in_str;
+        if (bad_ctrl) {
+            pos = base + (size_t)__builtin_ctzll(bad_ctrl);
+            goto fail;
+        }
+
+        uint64_t scalar = ~(b.op | b.ws | b.quote);
+        uint64_t scalar_start = scalar & ~((scalar << 1) | scalar_carry);
+        scalar_carry = scalar >> 63;
+
+        uint64_t bs_in = b.bslash & in_str;
+        uint64_t structurals = ((b.op | scalar_start) & ~in_str) | quotes;
+
+        while (structurals) {
+            int bit = __builtin_ctzll(structurals);
+            structurals &= structurals - 1;
+            pos = base + (size_t)bit;
+            if (pos >= len) break;
+            char c = json[pos];
+
+            if (in_string) {
+                // Only the closing quote can be structural inside a string
+                hermes_json_tok_t* t = &toks[str_tok];
+                uint64_t before = bs_in & ((1ull << bit) - 1u);
+                size_t lb = before ? base + 63u - (size_t)__builtin_clzll(before) : last_bs;
+                t->end = (uint32_t)pos;
+                if (lb != (size_t)-1 && lb >= t->start) {
+                    t->flags |= HERMES_JSON_F_ESCAPED;
+                    size_t bad = hj_check_escapes(json + t->start, pos - t->start);
+                    if (bad != pos - t->start) {
+                        pos = t->start + bad;
+                        goto fail;
+                    }
+                }
+                in_string = 0;
+                if (string_is_key) {
+                    st = HJ_ST_COLON;
+                } else {
+                    st = depth ? HJ_ST_COMMA_OR_CLOSE : HJ_ST_DONE;
+                }
+                continue;
+            }
+
+            switch (c) {
+                case '{':
+                case '[': {
+                    if (st != HJ_ST_VALUE && st != HJ_ST_VALUE_OR_CLOSE) goto fail;
+                    if (depth >= HERMES_JSON_MAX_DEPTH) { err = HERMES_ERR_BAD_LENGTH; goto fail; }
+                    if (tape->count >= cap) { err = HERMES_ERR_BAD_LENGTH; goto fail; }
+                    hermes_json_tok_t* t = &toks[tape->count];
+                    t->start = (uint32_t)pos;
+                    t->end = 0;
+                    t->next = 0;
+                    t->type = (c == '{') ? HERMES_JSON_OBJECT : HERMES_JSON_ARRAY;
+                    t->flags = 0;
+                    t->depth = (uint16_t)depth;
+                    stack[depth++] = tape->count++;
+                    st = (c == '{') ? HJ_ST_KEY_OR_CLOSE : HJ_ST_VALUE_OR_CLOSE;
+                    break;
+                }
+                case '}':
+                case ']': {
+                    if (!depth) goto fail;
+                    hermes_json_tok_t* t = &toks[stack[depth - 1]];
+                    if (c == '}') {
+                        if (t->type != HERMES_JSON_OBJECT) goto fail;
+                        if (st != HJ_ST_KEY_OR_CLOSE && st != HJ_ST_COMMA_OR_CLOSE) goto fail;
+                    } else {
+                        if (t->type != HERMES_JSON_ARRAY) goto fail;
+                        if (st != HJ_ST_VALUE_OR_CLOSE && st != HJ_ST_COMMA_OR_CLOSE) goto fail;
+                    }
+                    t->end = (uint32_t)pos + 1u;
+                    t->next = tape->count;
+                    depth--;
+                    st = depth ? HJ_ST_COMMA_OR_CLOSE : HJ_ST_DONE;
+                    break;
+                }
+                case ':':
+                    if (st != HJ_ST_COLON) goto fail;
+                    st = HJ_ST_VALUE;
+                    break;
+                case ',':
+                    if (st != HJ_ST_COMMA_OR_CLOSE) goto fail;
+                    st = (toks[stack[depth - 1]].type == HERMES_JSON_OBJECT) ? HJ_ST_KEY : HJ_ST_VALUE;
+                    break;
+                case '"': {
+                    int key = (st == HJ_ST_KEY || st == HJ_ST_KEY_OR_CLOSE);
+                    if (!key && st != HJ_ST_VALUE && st != HJ_ST_VALUE_OR_CLOSE) goto fail;
+                    if (tape->count >= cap) { err = HERMES_ERR_BAD_LENGTH; goto fail; }
+                    hermes_json_tok_t* t = &toks[tape->count];
+                    t->start = (uint32_t)pos + 1u;
+                    t->end = 0;
+                    t->next = tape->count + 1u;
+                    t->type = HERMES_JSON_STRING;
+                    t->flags = key ? HERMES_JSON_F_KEY : 0;
+                    t->depth = (uint16_t)depth;
+                    str_tok = tape->count++;
+                    string_is_key = key;
+                    in_string = 1;
+                    break;
+                }
+                default: {
+                    // Bare scalar: number, true, false, null
+                    if (st != HJ_ST_VALUE && st != HJ_ST_VALUE_OR_CLOSE) goto fail;
+                    size_t e = pos;
+                    while (e < len && !(g_hj_class[(unsigned char)json[e]] & (HJ_C_WS | HJ_C_OP | HJ_C_QUOTE))) e++;
+                    const char* s = json + pos;
+                    size_t n = e - pos;
+                    uint8_t type;
+                    if (n == 4 && memcmp(s, "true", 4) == 0) type = HERMES_JSON_TRUE;
+                    else if (n == 5 && memcmp(s, "false", 5) == 0) type = HERMES_JSON_FALSE;
+                    else if (n == 4 && memcmp(s, "null", 4) == 0) type = HERMES_JSON_NULL;
+                    else if (hj_number_len(s, n) == n) type = HERMES_JSON_NUMBER;
+                    else goto fail;
+                    if (tape->count >= cap) { err = HERMES_ERR_BAD_LENGTH; goto fail; }
+                    hermes_json_tok_t* t = &toks[tape->count];
+                    t->start = (uint32_t)pos;
+                    t->end = (uint32_t)e;
+                    t->next = tape->count + 1u;
+                    t->type = type;
+                    t->flags = 0;
+                    t->depth = (uint16_t)depth;
+                    tape->count++;
+                    st = depth ? HJ_ST_COMMA_OR_CLOSE : HJ_ST_DONE;
+                    break;
+                }
+            }
+        }
+
+        if (bs_in) last_bs = base + 63u - (size_t)__builtin_clzll(bs_in);
+    }
+
+    pos = len;
+    if (in_string || st != HJ_ST_DONE) goto fail;
+    return HERMES_OK;
+
+fail:
+    tape->error_offset = pos;
+    tape->count = 0;
+    return err;
+}
+
+// ─── Lookups ────────────────────────────────────────────────────────────────
+
+static int hj_key_eq(const hermes_json_tape_t* tape, uint32_t k, const char* key, size_t key_len) {
+    const hermes_json_tok_t* t = &tape->toks[k];
+    return (size_t)(t->end - t->start) == key_len && memcmp(tape->json + t->start, key, key_len) == 0;
+}
+
+uint32_t hermes_json_object_find(const hermes_json_tape_t* tape, uint32_t obj, const char* key, size_t key_len) {
+    if (!tape || !key || obj >= tape->count) return HERMES_JSON_NONE;
+    const hermes_json_tok_t* o = &tape->toks[obj];
+    if (o->type != HERMES_JSON_OBJECT) return HERMES_JSON_NONE;
+    for (uint32_t k = obj + 1u; k < o->next; k = tape->toks[k + 1u].next) {
+        if (hj_key_eq(tape, k, key, key_len)) return k + 1u;
+    }
+    return HERMES_JSON_NONE;
+}
+
+static uint32_t hj_hash(const char* s, size_t n) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+hermes_status_t hermes_json_keys_build(const hermes_json_tape_t* tape, uint32_t obj, hermes_json_keys_t* out) {
+    if (!tape || !out || obj >= tape->count) return HERMES_ERR_INVALID_ARG;
+    const hermes_json_tok_t* o = &tape->toks[obj];
+    if (o->type != HERMES_JSON_OBJECT) return HERMES_ERR_INVALID_ARG;
+
+    out->tape = tape;
+    out->obj = obj;
+    out->overflow = 0;
+    for (uint32_t i = 0; i < HERMES_JSON_KEYS_SLOTS; i++) out->val[i] = HERMES_JSON_NONE;
+
+    const uint32_t mask = HERMES_JSON_KEYS_SLOTS - 1u;
+    uint32_t used = 0;
+    for (uint32_t k = obj + 1u; k < o->next; k = tape->toks[k + 1u].next) {
+        const hermes_json_tok_t* t = &tape->toks[k];
+        const char* s = tape->json + t->start;
+        size_t n = t->end - t->start;
+        uint32_t h = hj_hash(s, n);
+        uint32_t i = h & mask;
+        int dup = 0;
+        while (out->val[i] != HERMES_JSON_NONE) {
+            if (out->hash[i] == h && hj_key_eq(tape, out->val[i] - 1u, s, n)) { dup = 1; break; }
+            i = (i + 1u) & mask;
+        }
+        if (dup) continue;   // first occurrence wins
+        if (used >= HERMES_JSON_KEYS_SLOTS * 3u / 4u) {
+            out->overflow = 1;
+            break;
+        }
+        out->hash[i] = h;
+        out->val[i] = k + 1u;
+        used++;
+    }
+    return HERMES_OK;
+}
+
+uint32_t hermes_json_keys_get(const hermes_json_keys_t* keys, const char* key) {
+    if (!keys || !key) return HERMES_JSON_NONE;
+    size_t n = strlen(key);
+    uint32_t h = hj_hash(key, n);
+    const uint32_t mask = HERMES_JSON_KEYS_SLOTS - 1u;
+    for (uint32_t i = h & mask; keys->val[i] != HERMES_JSON_NONE; i = (i + 1u) & mask) {
+        if (keys->hash[i] == h && hj_key_eq(keys->tape, keys->val[i] - 1u, key, n)) return keys->val[i];
+    }
+    return keys->overflow ? hermes_json_object_find(keys->tape, keys->obj, key, n) : HERMES_JSON_NONE;
+}
+
+// ─── Accessors ──────────────────────────────────────────────────────────────
+
+hermes_status_t hermes_json_tok_u64(const hermes_json_tape_t* tape, uint32_t idx, uint64_t* out) {
+    if (!tape || !out || idx >= tape->count) return HERMES_ERR_INVALID_ARG;
+    const hermes_json_tok_t* t = &tape->toks[idx];
+    if (t->type != HERMES_JSON_NUMBER) return HERMES_ERR_INVALID_ARG;
+    uint64_t v = 0;
+    for (uint32_t i = t->start; i < t->end; i++) {
+        char c = tape->json[i];
+        if (c < '0' || c > '9') return HERMES_ERR_INVALID_ARG;   // sign, fraction, exponent
+        uint64_t d = (uint64_t)(c - '0');
+        if (v > (UINT64_MAX - d) / 10u) return HERMES_ERR_INVALID_ARG;
+        v = v * 10u + d;
+    }
+    *out = v;
+    return HERMES_OK;
+}
+
+hermes_status_t hermes_json_tok_view(const hermes_json_tape_t* tape, uint32_t idx, const char** out, size_t* out_len) {
+    if (!tape || !out || !out_len || idx >= tape->count) return HERMES_ERR_INVALID_ARG;
+    const hermes_json_tok_t* t = &tape->toks[idx];
+    if (t->type != HERMES_JSON_STRING) return HERMES_ERR_INVALID_ARG;
+    *out = tape->json + t->start;
+    *out_len = t->end - t->start;
+    return HERMES_OK;
+}
+
+static hermes_status_t hj_put(char* out, size_t out_cap, size_t* n, uint32_t c) {
+    if (out) {
+        if (*n + 1u >= out_cap) return HERMES_ERR_BAD_LENGTH;
+        out[*n] = (char)c;
+    }
+    (*n)++;
+    return HERMES_OK;
+}
+
+static uint32_t hj_u4(const char* s) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v = (v << 4) | (uint32_t)hj_hex(s[i]);
+    return v;
+}
+
+hermes_status_t hermes_json_tok_string(const hermes_json_tape_t* tape, uint32_t idx, char* out, size_t out_cap, size_t* out_len) {
+    const char* s = NULL;
+    size_t len = 0;
+    hermes_status_t st = hermes_json_tok_view(tape, idx, &s, &len);
+    if (st != HERMES_OK) return st;
+    if (!out_len) return HERMES_ERR_INVALID_ARG;
+
+    size_t n = 0;
+    if (!(tape->toks[idx].flags & HERMES_JSON_F_ESCAPED)) {
+        if (out) {
+            if (len + 1u > out_cap) return HERMES_ERR_BAD_LENGTH;
+            memcpy(out, s, len);
+        }
+        n = len;
+    } else {
+        // Escapes were validated by the tokenizer
+        for (size_t i = 0; i < len; i++) {
+            if (s[i] != '\\') {
+                // Copy the run up to the next escape in one go
+                const char* bs = (const char*)memchr(s + i, '\\', len - i);
+                size_t run = (bs ? (size_t)(bs - s) : len) - i;
+                if (out) {
+                    if (n + run + 1u > out_cap) return HERMES_ERR_BAD_LENGTH;
+                    memcpy(out + n, s + i, run);
+                }
+                n += run;
+                i += run - 1u;
+                continue;
+            }
+            char e = s[++i];
+            uint32_t cp;
+            switch (e) {
+                case 'b': cp = '\b'; break;
+                case 'f': cp = '\f'; break;
+                case 'n': cp = '\n'; break;
+                case 'r': cp = '\r'; break;
+                case 't': cp = '\t'; break;
+                case 'u':
+                    cp = hj_u4(s + i + 1u);
+                    i += 4;
+                    if (cp >= 0xD800u && cp <= 0xDBFFu) {
+                        if (i + 6u >= len || s[i + 1u] != '\\' || s[i + 2u] != 'u') return HERMES_ERR_INVALID_ARG;
+                        uint32_t lo = hj_u4(s + i + 3u);
+                        if (lo < 0xDC00u || lo > 0xDFFFu) return HERMES_ERR_INVALID_ARG;
+                        cp = 0x10000u + ((cp - 0xD800u) << 10) + (lo - 0xDC00u);
+                        i += 6;
+                    } else if (cp >= 0xDC00u && cp <= 0xDFFFu) {
+                        return HERMES_ERR_INVALID_ARG;
+                    }
+                    break;
+                default: cp = (uint8_t)e; break;   // \" \\ \/
+            }
+            // UTF-8 encode
+            if (cp < 0x80u) {
+                st = hj_put(out, out_cap, &n, cp);
+            } else if (cp < 0x800u) {
+                st = hj_put(out, out_cap, &n, 0xC0u | (cp >> 6));
+                if (st == HERMES_OK) st = hj_put(out, out_cap, &n, 0x80u | (cp & 0x3Fu));
+            } else if (cp < 0x10000u) {
+                st = hj_put(out, out_cap, &n, 0xE0u | (cp >> 12));
+                if (st == HERMES_OK) st = hj_put(out, out_cap, &n, 0x80u | ((cp >> 6) & 0x3Fu));
+                if (st == HERMES_OK) st = hj_put(out, out_cap, &n, 0x80u | (cp & 0x3Fu));
+            } else {
+                st = hj_put(out, out_cap, &n, 0xF0u | (cp >> 18));
+                if (st == HERMES_OK) st = hj_put(out, out_cap, &n, 0x80u | ((cp >> 12) & 0x3Fu));
+                if (st == HERMES_OK) st = hj_put(out, out_cap, &n, 0x80u | ((cp >> 6) & 0x3Fu));
+                if (st == HERMES_OK) st = hj_put(out, out_cap, &n, 0x80u | (cp & 0x3Fu));
+            }
+            if (st != HERMES_OK) return st;
+        }
+    }
+
+    if (out) {
+        if (n + 1u > out_cap) return HERMES_ERR_BAD_LENGTH;
+        out[n] = '\0';
+    }
+    *out_len = n;
+    return HERMES_OK;
+}
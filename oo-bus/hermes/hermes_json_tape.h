@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hermes.h"
+
+// Single-pass JSON tokenizer ("tape") for Hermes bus messages.
+//
+// One pass over the buffer records every value once; field lookups then work
+// on the tape instead of re-scanning the text:
+//
+//   stage 1  per 64-byte block, build bitmasks of quotes, backslashes,
+//            whitespace and the structural characters {}[]:, (SSE2 compares
+//            when available, a byte-class table otherwise); drop escaped
+//            quotes, mask out string interiors with a prefix-XOR over the
+//            quote bits, and mark the first byte of every bare scalar.
+//   stage 2  walk the set bits in order with a depth stack and append one
+//            token per value / key, validating the grammar as it goes.
+//
+// The input is never copied or modified (only the last partial block is
+// padded on the stack) and the token array is caller-provided.
+//
+// Tape layout: containers are followed by their children in document order;
+// tok.next is the index just past the value, so siblings are one hop apart.
+//   {"a":1,"b":[2,3]}  →  [0]{  [1]"a"  [2]1  [3]"b"  [4][  [5]2  [6]3
+//
+// Objects are stored as key, value, key, value...; the value of key k is
+// k + 1 and the next key is toks[k + 1].next.
+
+#define HERMES_JSON_NONE       0xFFFFFFFFu
+
+#ifndef HERMES_JSON_MAX_DEPTH
+#define HERMES_JSON_MAX_DEPTH  64u
+#endif
+
+typedef enum hermes_json_type {
+    HERMES_JSON_OBJECT = 1,
+    HERMES_JSON_ARRAY  = 2,
+    HERMES_JSON_STRING = 3,
+    HERMES_JSON_NUMBER = 4,
+    HERMES_JSON_TRUE   = 5,
+    HERMES_JSON_FALSE  = 6,
+    HERMES_JSON_NULL   = 7,
+} hermes_json_type_t;
+
+#define HERMES_JSON_F_KEY      0x01u   // string is an object key
+#define HERMES_JSON_F_ESCAPED  0x02u   // string contains backslash escapes
+
+typedef struct hermes_json_tok {
+    uint32_t start;   // first byte (strings: first byte after the opening quote)
+    uint32_t end;     // one past the last byte (strings: the closing quote)
+    uint32_t next;    // tape index just past this value and its children
+    uint8_t  type;    // hermes_json_type_t
+    uint8_t  flags;   // HERMES_JSON_F_*
+    uint16_t depth;   // nesting depth (root value = 0)
+} hermes_json_tok_t;
+
+typedef struct hermes_json_tape {
+    const char* json;
+    size_t len;
+    hermes_json_tok_t* toks;
+    uint32_t cap;
+    uint32_t count;
+    size_t error_offset;   // byte where parsing failed (valid after an error)
+} hermes_json_tape_t;
+
+// Tokenize json[0..len) into toks[0..cap).
+// HERMES_ERR_INVALID_ARG on malformed JSON, HERMES_ERR_BAD_LENGTH when the
+// tape is too small or the document nests deeper than HERMES_JSON_MAX_DEPTH.
+hermes_status_t hermes_json_tape_parse(
+    hermes_json_tape_t* tape,
+    const char* json,
+    size_t len,
+    hermes_json_tok_t* toks,
+    uint32_t cap);
+
+// Host tests: run stage 1 with the byte-class table even when SSE2 exists.
+void hermes_json_tape_force_scalar(int on);
+
+// Value index for `key` in object `obj` by walking its keys (O(keys)).
+// Keys are matched on their raw spelling. Returns HERMES_JSON_NONE if absent.
+uint32_t hermes_json_object_find(const hermes_json_tape_t* tape, uint32_t obj, const char* key, size_t key_len);
+
+// O(1) key lookup: hash every key of an object once, then probe.
+#define HERMES_JSON_KEYS_SLOTS 32u   // power of two; at most 3/4 filled
+
+typedef struct hermes_json_keys {
+    const hermes_json_tape_t* tape;
+    uint32_t obj;
+    uint8_t  overflow;               // too many keys: lookups fall back to a walk
+    uint32_t hash[HERMES_JSON_KEYS_SLOTS];
+    uint32_t val[HERMES_JSON_KEYS_SLOTS];   // value index, HERMES_JSON_NONE = empty
+} hermes_json_keys_t;
+
+hermes_status_t hermes_json_keys_build(const hermes_json_tape_t* tape, uint32_t obj, hermes_json_keys_t* out);
+uint32_t hermes_json_keys_get(const hermes_json_keys_t* keys, const char* key);
+
+// Value accessors
+hermes_status_t hermes_json_tok_u64(const hermes_json_tape_t* tape, uint32_t idx, uint64_t* out);
+
+// Zero-copy view of a string token. Escaped strings are returned raw;
+// use hermes_json_tok_string to decode them.
+hermes_status_t hermes_json_tok_view(const hermes_json_tape_t* tape, uint32_t idx, const char** out, size_t* out_len);
+
+// Decode a string token into out (NUL-terminated). out may be NULL to only
+// measure. HERMES_ERR_BAD_LENGTH if out_cap cannot hold it plus the NUL.
+hermes_status_t hermes_json_tok_string(const hermes_json_tape_t* tape, uint32_t idx, char* out, size_t out_cap, size_t* out_len);
@@ -0,0 +1,194 @@
+/*
+ * oo_mc_queue.c — oo-multicore work queue (submit / steal / idle / bench)
+ * ========================================================================
+ * Pure C over OoMulticoreCtx + oo_mc_ring.h: no EFI calls, so the same
+ * file runs on APs in the UEFI build and on pthreads in the host
+ * harness (tests/test_oo_mc_ring.c). Waking APs stays in oo_multicore.c
+ * (oo_mc_start_workers, MP Services).
+ */
+
+#include "oo_multicore.h"
+
+void oo_mc_stop_workers(OoMulticoreCtx *ctx) {
+    if (!ctx) return;
+    ctx->mc_stop = 1;
+    for (int w = 0; w < ctx->mc_worker_count; w++) {
+        int c = ctx->mc_workers[w];
+        oo_mc_xadd32(&ctx->mc_core[c].doorbell, 1);
+        ctx->cores[c].role = OO_CORE_ROLE_IDLE;
+    }
+    /* new submissions run inline; anything still queued is drained by
+     * the next oo_mc_wait_idle() */
+    ctx->mc_worker_count = 0;
+}
+
+static void oo_mc_exec(OoMulticoreCtx *ctx, int me, const OoMcWork *w, int stolen) {
+    OoMcCoreStats *cs = &ctx->mc_core[me];
+    uint64_t lat = oo_mc_rdtsc() - w->tsc_submit;
+    cs->lat_cycles += lat;
+    if (lat > cs->lat_max) cs->lat_max = lat;
+    if (stolen) cs->stolen++;
+    w->fn(w->arg, me);
+    oo_mc_barrier();
+    cs->completed++;
+}
+
+void oo_mc_submit_from(OoMulticoreCtx *ctx, int my_idx, OoMcWorkFn fn, void *arg) {
+    if (!fn) return;
+    OoMcWork w;
+    w.fn = fn;
+    w.arg = arg;
+    w.tsc_submit = oo_mc_rdtsc();
+    oo_mc_xadd32(&ctx->mc_submitted, 1);
+
+    int n = ctx->mc_worker_count;
+    OoMcCoreStats *mine = &ctx->mc_core[my_idx];
+    for (int k = 0; k < n; k++) {
+        int c = ctx->mc_workers[(mine->rr_next + k) % n];
+        if (c == my_idx) continue;
+        if (!oo_mc_ring_push(&ctx->rings[my_idx][c], &w)) continue;
+        mine->rr_next = (mine->rr_next + k + 1) % n;
+        /* Dekker with the sleeper: push, full fence, then read its flag */
+        __asm__ __volatile__("mfence" ::: "memory");
+        if (ctx->mc_core[c].sleeping) oo_mc_xadd32(&ctx->mc_core[c].doorbell, 1);
+        return;
+    }
+    /* no worker, or every ring full: the submitter does it */
+    oo_mc_xadd32(&ctx->mc_inline, 1);
+    oo_mc_exec(ctx, my_idx, &w, 0);
+}
+
+void oo_mc_submit(OoMulticoreCtx *ctx, OoMcWorkFn fn, void *arg) {
+    if (!ctx) return;
+    oo_mc_submit_from(ctx, ctx->bsp_idx, fn, arg);
+}
+
+int oo_mc_run_one(OoMulticoreCtx *ctx, int my_idx) {
+    OoMcWork w;
+    int n = ctx->core_count;
+    /* own inbound rings */
+    for (int p = 0; p < n; p++) {
+        if (oo_mc_ring_pop(&ctx->rings[p][my_idx], &w)) {
+            oo_mc_exec(ctx, my_idx, &w, 0);
+            return 1;
+        }
+    }
+    /* steal, starting with the next core so thieves spread out */
+    for (int k = 1; k < n; k++) {
+        int victim = (my_idx + k) % n;
+        for (int p = 0; p < n; p++) {
+            OoMcRing *r = &ctx->rings[p][victim];
+            if (oo_mc_ring_count(r) && oo_mc_ring_pop(r, &w)) {
+                oo_mc_exec(ctx, my_idx, &w, 1);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int oo_mc_has_work(const OoMulticoreCtx *ctx, int my_idx) {
+    for (int p = 0; p < ctx->core_count; p++)
+        if (oo_mc_ring_count(&ctx->rings[p][my_idx])) return 1;
+    return 0;
+}
+
+static void oo_mc_idle_wait(OoMulticoreCtx *ctx, int me) {
+    OoMcCoreStats *cs = &ctx->mc_core[me];
+    uint32_t bell = cs->doorbell;
+    cs->sleeping = 1;
+    __asm__ __volatile__("mfence" ::: "memory");
+    if (!oo_mc_has_work(ctx, me) && !ctx->mc_stop) {
+        cs->sleeps++;
+        if (ctx->mwait_ok) {
+            __asm__ __volatile__("monitor" :: "a"(&cs->doorbell), "c"(0), "d"(0));
+            if (cs->doorbell == bell && !oo_mc_has_work(ctx, me))
+                __asm__ __volatile__("mwait" :: "a"(0), "c"(0));
+        } else {
+            for (int i = 0; i < OO_MC_SLEEP_PAUSES && cs->doorbell == bell; i++)
+                oo_mc_pause();
+        }
+    }
+    cs->sleeping = 0;
+}
+
+void oo_mc_worker_loop(OoMulticoreCtx *ctx, int my_idx) {
+    uint32_t idle = 0;
+    while (!ctx->mc_stop) {
+        if (oo_mc_run_one(ctx, my_idx)) { idle = 0; continue; }
+        if (++idle < OO_MC_SPIN_ROUNDS) {
+            /* 1, 2, 4 … 64 pauses between polls */
+            uint32_t spins = 1u << (idle < 6 ? idle : 6);
+            for (uint32_t i = 0; i < spins; i++) oo_mc_pause();
+        } else {
+            oo_mc_idle_wait(ctx, my_idx);
+        }
+    }
+}
+
+static uint64_t oo_mc_completed(const OoMulticoreCtx *ctx) {
+    uint64_t done = 0;
+    for (int i = 0; i < ctx->core_count; i++) done += ctx->mc_core[i].completed;
+    return done;
+}
+
+void oo_mc_wait_idle(OoMulticoreCtx *ctx) {
+    if (!ctx) return;
+    while ((uint32_t)oo_mc_completed(ctx) != ctx->mc_submitted) {
+        if (!oo_mc_run_one(ctx, ctx->bsp_idx)) oo_mc_pause();
+    }
+}
+
+static void oo_mc_bench_nop(void *arg, int core) {
+    (void)core;
+    volatile uint32_t *done = (volatile uint32_t *)arg;
+    if (done) *done = 1;
+}
+
+int oo_mc_bench(OoMulticoreCtx *ctx, uint32_t items, OoMcBenchResult *out) {
+    if (!ctx || !out) return 0;
+    for (int i = 0; i < (int)sizeof(*out); i++) ((uint8_t*)out)[i] = 0;
+    out->workers = ctx->mc_worker_count;
+    out->items = items;
+    if (ctx->mc_worker_count == 0 || items == 0) return 0;
+
+    /* round trip: one item in flight, BSP spins on its flag (no helping) */
+    uint64_t rt_sum = 0, rt_min = ~0ULL;
+    const uint32_t rounds = 256;
+    for (uint32_t r = 0; r < rounds; r++) {
+        volatile uint32_t done = 0;
+        uint64_t t0 = oo_mc_rdtsc();
+        oo_mc_submit(ctx, oo_mc_bench_nop, (void *)&done);
+        while (!done) oo_mc_pause();
+        uint64_t dt = oo_mc_rdtsc() - t0;
+        rt_sum += dt;
+        if (dt < rt_min) rt_min = dt;
+    }
+    oo_mc_wait_idle(ctx);
+    out->rt_min = rt_min;
+    out->rt_avg = rt_sum / rounds;
+
+    /* throughput: flood, BSP helps drain */
+    uint64_t lat0 = 0, stolen0 = 0, done0 = oo_mc_completed(ctx);
+    for (int i = 0; i < ctx->core_count; i++) {
+        lat0 += ctx->mc_core[i].lat_cycles;
+        stolen0 += ctx->mc_core[i].stolen;
+        ctx->mc_core[i].lat_max = 0;
+    }
+    uint64_t t0 = oo_mc_rdtsc();
+    for (uint32_t i = 0; i < items; i++) oo_mc_submit(ctx, oo_mc_bench_nop, (void *)0);
+    oo_mc_wait_idle(ctx);
+    uint64_t t1 = oo_mc_rdtsc();
+
+    uint64_t lat1 = 0, stolen1 = 0, lat_max = 0, n = oo_mc_completed(ctx) - done0;
+    for (int i = 0; i < ctx->core_count; i++) {
+        lat1 += ctx->mc_core[i].lat_cycles;
+        stolen1 += ctx->mc_core[i].stolen;
+        if (ctx->mc_core[i].lat_max > lat_max) lat_max = ctx->mc_core[i].lat_max;
+    }
+    out->per_item = (t1 - t0) / items;
+    out->queue_avg = n ? (lat1 - lat0) / n : 0;
+    out->queue_max = lat_max;
+    out->stolen = stolen1 - stolen0;
+    return 1;
+}
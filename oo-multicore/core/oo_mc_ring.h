@@ -0,0 +1,131 @@
+#pragma once
+/*
+ * oo_mc_ring.h — Lock-free per-core work rings for oo-multicore
+ * ==============================================================
+ * One ring per (producer core, consumer core) pair. The producer side is
+ * strictly single-writer (only core P ever pushes into ring[P][C]), so a
+ * push is two plain stores and a compiler barrier on x86 TSO — no lock,
+ * no atomic RMW. The consumer side claims slots with lock cmpxchg on the
+ * tail, which lets an idle core steal from another core's ring without
+ * breaking the owner: the slot is copied out before the CAS, and the
+ * producer never reuses slot T until the tail has moved past it.
+ *
+ * head and tail live on separate 64-byte lines (producer-owned and
+ * consumer-owned), so the only cross-core traffic is the slot itself
+ * plus one line transfer per index the other side actually needs.
+ * The producer caches the last tail it saw and only re-reads the
+ * consumer line when the ring looks full.
+ *
+ * Header-only: the UEFI build and the pthread host harness
+ * (tests/test_oo_mc_ring.c) compile the exact same code.
+ * x86-64 only (inline asm, same as the ticketlock in oo_multicore.c).
+ */
+
+#ifndef OO_MC_RING_H
+#define OO_MC_RING_H
+
+#include <stdint.h>
+
+#define OO_MC_CACHELINE   64
+#define OO_MC_RING_SLOTS  32     /* power of two */
+#define OO_MC_RING_MASK   (OO_MC_RING_SLOTS - 1)
+
+/* core = index of the core running the item (use it for oo_mc_submit_from
+ * and per-core scratch) */
+typedef void (*OoMcWorkFn)(void *arg, int core);
+
+/* ── Work item ─────────────────────────────────────────────────────── */
+typedef struct {
+    OoMcWorkFn fn;
+    void      *arg;
+    uint64_t   tsc_submit;   /* rdtsc at submit, for dispatch latency */
+} OoMcWork;
+
+/* ── SPSC ring (CAS-claimed consumer side for stealing) ────────────── */
+typedef struct __attribute__((aligned(OO_MC_CACHELINE))) {
+    /* producer line */
+    volatile uint32_t head;
+    uint32_t          tail_cache;
+    uint8_t           _pad0[OO_MC_CACHELINE - 8];
+    /* consumer line */
+    volatile uint32_t tail;
+    uint8_t           _pad1[OO_MC_CACHELINE - 4];
+    OoMcWork          slot[OO_MC_RING_SLOTS];
+} OoMcRing;
+
+/* ── Primitives ────────────────────────────────────────────────────── */
+static inline void oo_mc_barrier(void) {
+    __asm__ __volatile__("" ::: "memory");
+}
+
+static inline void oo_mc_pause(void) {
+    __asm__ __volatile__("pause" ::: "memory");
+}
+
+static inline uint64_t oo_mc_rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Returns 1 if *ptr was `expect` and is now `desired`. */
+static inline int oo_mc_cas32(volatile uint32_t *ptr, uint32_t expect, uint32_t desired) {
+    uint8_t ok;
+    __asm__ __volatile__(
+        "lock cmpxchgl %3, %1\n\t"
+        "sete %0"
+        : "=q"(ok), "+m"(*ptr), "+a"(expect)
+        : "r"(desired)
+        : "memory", "cc");
+    return ok;
+}
+
+static inline uint32_t oo_mc_xadd32(volatile uint32_t *ptr, uint32_t val) {
+    __asm__ __volatile__(
+        "lock xaddl %0, %1"
+        : "+r"(val), "+m"(*ptr)
+        :
+        : "memory", "cc");
+    return val;
+}
+
+/* ── Ring API ──────────────────────────────────────────────────────── */
+static inline void oo_mc_ring_init(OoMcRing *r) {
+    r->head = 0;
+    r->tail_cache = 0;
+    r->tail = 0;
+}
+
+/* Producer only. Returns 1, or 0 when full. */
+static inline int oo_mc_ring_push(OoMcRing *r, const OoMcWork *w) {
+    uint32_t h = r->head;
+    if (h - r->tail_cache >= OO_MC_RING_SLOTS) {
+        r->tail_cache = r->tail;
+        if (h - r->tail_cache >= OO_MC_RING_SLOTS) return 0;
+    }
+    r->slot[h & OO_MC_RING_MASK] = *w;
+    oo_mc_barrier();          /* slot visible before head (x86 TSO: stores in order) */
+    r->head = h + 1;
+    return 1;
+}
+
+/* Any consumer (owner or thief). Returns 1 with *out filled, 0 if empty. */
+static inline int oo_mc_ring_pop(OoMcRing *r, OoMcWork *out) {
+    for (;;) {
+        uint32_t t = r->tail;
+        oo_mc_barrier();
+        if (t == r->head) return 0;
+        oo_mc_barrier();      /* head read before slot read (x86 TSO: loads in order) */
+        *out = r->slot[t & OO_MC_RING_MASK];
+        if (oo_mc_cas32(&r->tail, t, t + 1)) return 1;
+        oo_mc_pause();
+    }
+}
+
+static inline uint32_t oo_mc_ring_count(const OoMcRing *r) {
+    uint32_t t = r->tail;     /* tail first: head read later is never behind it */
+    oo_mc_barrier();
+    return r->head - t;
+}
+
+#endif /* OO_MC_RING_H */
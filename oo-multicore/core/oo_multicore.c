@@ -104,6 +104,8 @@ static void EFIAPI ap_wrapper_entry(void *Arg) {
     /* On exécute la payload de l'Organisme sur ce cœur */
     if (ap_arg->entry_fn) {
         ap_arg->entry_fn();
+    } else if (core->role == OO_CORE_ROLE_WORKER) {
+        oo_mc_worker_loop(g_oo_mc_ctx, idx);
     }
     
     core->state = OO_CORE_STATE_HALTED;
@@ -124,6 +126,7 @@ int oo_multicore_init(OoMulticoreCtx *ctx) {
         Print(L"[SMP] MP Services introuvable. Mode Single-Core forcé.\r\n");
         ctx->enabled = 0;
         ctx->core_count = 1; /* Le BSP */
+        ctx->bsp_idx = 0;
         ctx->cores[0].role = OO_CORE_ROLE_BSP;
         ctx->cores[0].state = OO_CORE_STATE_RUNNING;
         return 0;
@@ -151,9 +154,17 @@ int oo_multicore_init(OoMulticoreCtx *ctx) {
     /* Identifier le BSP */
     UINTN my_apic = 0; // En vrai, récupéré par WhoAmI
     st = uefi_call_wrapper(g_mp_services->WhoAmI, 2, g_mp_services, &my_apic);
-    if (!EFI_ERROR(st)) {
+    if (!EFI_ERROR(st) && my_apic < (UINTN)ctx->core_count) {
         ctx->cores[my_apic].role = OO_CORE_ROLE_BSP;
         ctx->cores[my_apic].state = OO_CORE_STATE_RUNNING;
+        ctx->bsp_idx = (int)my_apic;
+    }
+    
+    /* monitor/mwait pour le sommeil des workers (souvent absent sous QEMU TCG) */
+    {
+        uint32_t a = 1, b, c = 0, d;
+        __asm__ __volatile__("cpuid" : "+a"(a), "=b"(b), "+c"(c), "=d"(d));
+        ctx->mwait_ok = (c >> 3) & 1;
     }
     
     g_oo_mc_ctx = ctx;
@@ -261,6 +272,26 @@ void oo_multicore_halt_ap(OoMulticoreCtx *ctx, int core_idx) {
     }
 }
 
+/* ── Work Queue (AP wake-up; queue logic in oo_mc_queue.c) ──────── */
+
+int oo_mc_start_workers(OoMulticoreCtx *ctx, int max_workers) {
+    if (!ctx || !ctx->enabled) return 0;
+    ctx->mc_stop = 0;
+    for (int i = 0; i < ctx->core_count; i++) {
+        if (max_workers > 0 && ctx->mc_worker_count >= max_workers) break;
+        if (i == ctx->bsp_idx) continue;
+        OoCoreDescriptor *core = &ctx->cores[i];
+        if (core->role != OO_CORE_ROLE_IDLE) continue;
+        /* listed before the AP starts: pushes queue up until it arrives */
+        ctx->mc_workers[ctx->mc_worker_count++] = i;
+        if (!oo_multicore_wake_ap(ctx, i, OO_CORE_ROLE_WORKER, NULL)) {
+            ctx->mc_worker_count--;
+            core->role = OO_CORE_ROLE_IDLE;
+        }
+    }
+    return ctx->mc_worker_count;
+}
+
 void oo_multicore_print(const OoMulticoreCtx *ctx) {
     if (!ctx) return;
     Print(L"\r\n[SMP] Multicore Status:\r\n");
@@ -277,6 +308,7 @@ void oo_multicore_print(const OoMulticoreCtx *ctx) {
             case OO_CORE_ROLE_DREAM: r = L"DREAM"; break;
             case OO_CORE_ROLE_DISTILL: r = L"DISTILL"; break;
             case OO_CORE_ROLE_SENTINEL: r = L"SENTINEL"; break;
+            case OO_CORE_ROLE_WORKER: r = L"WORKER"; break;
             default: break;
         }
         
@@ -290,6 +322,13 @@ void oo_multicore_print(const OoMulticoreCtx *ctx) {
         }
         
         Print(L"  Core %d: [%s] -> %s  (Steps: %lu)\r\n", i, r, s, c->steps_executed);
+        if (c->role == OO_CORE_ROLE_WORKER || ctx->mc_core[i].completed) {
+            const OoMcCoreStats *m = &ctx->mc_core[i];
+            Print(L"          work: done=%lu stolen=%lu sleeps=%lu\r\n",
+                  m->completed, m->stolen, m->sleeps);
+        }
     }
+    Print(L"  Work queue: workers=%d submitted=%u inline=%u mwait=%d\r\n",
+          ctx->mc_worker_count, ctx->mc_submitted, ctx->mc_inline, ctx->mwait_ok);
     Print(L"\r\n");
 }
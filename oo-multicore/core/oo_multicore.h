@@ -15,6 +15,13 @@
  * Synchronization: ticketlock (no stdlib, no OS spinlock)
  * Communication: shared arena regions + Hermes-like mailbox
  *
+ * Work queue (oo_mc_*): APs with OO_CORE_ROLE_WORKER run a generic
+ * worker loop fed by lock-free per-(producer, consumer) rings
+ * (oo_mc_ring.h). oo_mc_submit() pushes fn(arg) round-robin; an idle
+ * worker drains its own rings, then steals from the others, then backs
+ * off with pause and finally sleeps on a per-core doorbell with
+ * monitor/mwait (when CPUID advertises it) or a long pause spin.
+ *
  * OO multicore is NOT like a thread scheduler.
  * Each AP runs a fixed role. No preemption. No context switches.
  * "Organic parallelism" — each core has a dedicated function.
@@ -27,11 +34,16 @@
 #define OO_MULTICORE_H
 
 #include <stdint.h>
+#include "oo_mc_ring.h"
 
 #define OO_MAX_CORES          16
 #define OO_CORE_STACK_SIZE    (64 * 1024)  /* 64KB per AP */
 #define OO_CORE_MAILBOX_SIZE  16           /* messages per core */
 
+/* Worker idle backoff (iterations of the idle loop) */
+#define OO_MC_SPIN_ROUNDS     64           /* exponential pause spins */
+#define OO_MC_SLEEP_PAUSES    4096         /* doorbell poll when no mwait */
+
 /* ── Core roles ────────────────────────────────────────────────────── */
 typedef enum {
     OO_CORE_ROLE_BSP        = 0,  /* bootstrap processor — REPL + bus */
@@ -41,6 +53,7 @@ typedef enum {
     OO_CORE_ROLE_DISTILL    = 4,  /* autonomous in-situ training */
     OO_CORE_ROLE_SENTINEL   = 5,  /* pressure + watchdog monitor */
     OO_CORE_ROLE_IDLE       = 6,  /* parked, available */
+    OO_CORE_ROLE_WORKER     = 7,  /* generic work-queue consumer */
 } OoCoreRole;
 
 /* ── Core state ────────────────────────────────────────────────────── */
@@ -76,6 +89,19 @@ typedef struct {
     volatile uint32_t ticket_next;
 } OoCoreDescriptor;
 
+/* ── Per-core work-queue state (one cache line each, owner-written) ── */
+typedef struct __attribute__((aligned(OO_MC_CACHELINE))) {
+    volatile uint32_t doorbell;      /* bumped by producers to wake a sleeper */
+    volatile uint32_t sleeping;      /* 1 while parked in the idle wait */
+    uint32_t          rr_next;       /* producer round-robin cursor */
+    uint32_t          _pad;
+    volatile uint64_t completed;     /* items executed by this core */
+    uint64_t          stolen;        /* of which taken from another core's rings */
+    uint64_t          sleeps;
+    uint64_t          lat_cycles;    /* sum of submit → start */
+    uint64_t          lat_max;
+} OoMcCoreStats;
+
 /* ── Multicore context ────────────────────────────────────────────── */
 typedef struct {
     int              enabled;
@@ -85,8 +111,30 @@ typedef struct {
     /* shared read-only weight base (BSP allocates, APs read) */
     uint64_t         shared_weights_base;
     uint64_t         shared_weights_size;
+    /* work queue: rings[producer][consumer] */
+    int              bsp_idx;
+    int              mwait_ok;         /* CPUID.01H:ECX.MONITOR */
+    volatile int     mc_stop;
+    int              mc_worker_count;
+    int              mc_workers[OO_MAX_CORES];
+    volatile uint32_t mc_submitted;    /* xadd'd by producers */
+    volatile uint32_t mc_inline;       /* run on the submitter (no worker / all rings full) */
+    OoMcCoreStats    mc_core[OO_MAX_CORES];
+    OoMcRing         rings[OO_MAX_CORES][OO_MAX_CORES];
 } OoMulticoreCtx;
 
+/* ── Work-queue benchmark result (TSC cycles) ─────────────────────── */
+typedef struct {
+    int      workers;
+    uint32_t items;
+    uint64_t rt_min;          /* submit → done, one item in flight */
+    uint64_t rt_avg;
+    uint64_t queue_avg;       /* submit → start, under full load */
+    uint64_t queue_max;
+    uint64_t per_item;        /* wall cycles / items, full load */
+    uint64_t stolen;
+} OoMcBenchResult;
+
 /* ── API ───────────────────────────────────────────────────────────── */
 
 /**
@@ -129,4 +177,47 @@ void oo_multicore_halt_ap(OoMulticoreCtx *ctx, int core_idx);
  */
 void oo_multicore_print(const OoMulticoreCtx *ctx);
 
+/* ── Work queue ────────────────────────────────────────────────────── */
+
+/**
+ * oo_mc_start_workers() — wake up to max_workers idle APs (0 = all) as
+ * OO_CORE_ROLE_WORKER. Returns the total worker count.
+ */
+int oo_mc_start_workers(OoMulticoreCtx *ctx, int max_workers);
+
+/**
+ * oo_mc_stop_workers() — ask every worker to leave its loop (BSP only)
+ */
+void oo_mc_stop_workers(OoMulticoreCtx *ctx);
+
+/**
+ * oo_mc_submit() — queue fn(arg, core) from the BSP. Runs it inline when no
+ * worker is up or every worker ring is full, so it never fails.
+ * oo_mc_submit_from() is the same for work submitted by core my_idx.
+ */
+void oo_mc_submit(OoMulticoreCtx *ctx, OoMcWorkFn fn, void *arg);
+void oo_mc_submit_from(OoMulticoreCtx *ctx, int my_idx, OoMcWorkFn fn, void *arg);
+
+/**
+ * oo_mc_run_one() — execute one queued item as core my_idx (own rings
+ * first, then steal). Returns 1 if something ran.
+ */
+int oo_mc_run_one(OoMulticoreCtx *ctx, int my_idx);
+
+/**
+ * oo_mc_wait_idle() — BSP helps drain the queues until every submitted
+ * item has completed.
+ */
+void oo_mc_wait_idle(OoMulticoreCtx *ctx);
+
+/**
+ * oo_mc_worker_loop() — AP body for OO_CORE_ROLE_WORKER (returns on stop)
+ */
+void oo_mc_worker_loop(OoMulticoreCtx *ctx, int my_idx);
+
+/**
+ * oo_mc_bench() — dispatch latency + throughput with no-op items
+ */
+int oo_mc_bench(OoMulticoreCtx *ctx, uint32_t items, OoMcBenchResult *out);
+
 #endif /* OO_MULTICORE_H */
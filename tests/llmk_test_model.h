@@ -0,0 +1,111 @@
+// llmk_test_model.h — Synthetic llama2.c model + tokenizer.bin for the host tests
+//
+// For the tests that unity-include engine/host/llmk_host_rt.c and load a
+// model written on the fly. Each test keeps its own dims, paths and
+// vocabulary and describes them with LlmkTestModel / LlmkTestTok.
+//
+// Weights come from one xorshift32 stream, g_rng. A test that needs a
+// different stream defines LLMK_TEST_SEED before including this header;
+// the draws are in file order, so a given seed always writes the same bytes.
+
+#ifndef LLMK_TEST_MODEL_H
+#define LLMK_TEST_MODEL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef LLMK_TEST_SEED
+#define LLMK_TEST_SEED 0x2545F491u
+#endif
+
+static uint32_t g_rng = LLMK_TEST_SEED;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static float rndf(float scale) {
+    return ((float)(rnd() & 0xFFFF) / 32768.0f - 1.0f) * scale;
+}
+
+// n floats in [-scale, scale), or RMSNorm gains 1 + rndf(jitter)
+// (exactly 1 when jitter is 0, without a draw)
+static void put_floats(FILE *f, int n, float scale, int ones, float jitter) {
+    for (int i = 0; i < n; i++) {
+        float v = ones ? 1.0f + (jitter != 0.0f ? rndf(jitter) : 0.0f) : rndf(scale);
+        fwrite(&v, 4, 1, f);
+    }
+}
+
+typedef struct {
+    int dim, hidden, layers, heads, kv_heads, vocab, seq;
+    float emb_scale;                    // token embedding (and untied classifier)
+    float attn_scale;                   // wq, wk, wv, wo
+    float ffn_scale;                    // w1, w2, w3
+    float norm_jitter;                  // RMSNorm gains, see put_floats
+    int untied;                         // classifier follows freq_cis, vocab stored negated
+} LlmkTestModel;
+
+// llama2.c checkpoint: header, weights in file order, freq_cis filler
+static int llmk_test_write_model(const char *path, const LlmkTestModel *m) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int kvd = m->dim * m->kv_heads / m->heads;
+    int hdr[7] = { m->dim, m->hidden, m->layers, m->heads, m->kv_heads, m->untied ? -m->vocab : m->vocab, m->seq };
+    fwrite(hdr, 4, 7, f);
+    put_floats(f, m->vocab * m->dim, m->emb_scale, 0, 0);
+    put_floats(f, m->layers * m->dim, 0, 1, m->norm_jitter);
+    put_floats(f, m->layers * m->dim * m->dim, m->attn_scale, 0, 0);
+    put_floats(f, 2 * m->layers * m->dim * kvd, m->attn_scale, 0, 0);
+    put_floats(f, m->layers * m->dim * m->dim, m->attn_scale, 0, 0);
+    put_floats(f, m->layers * m->dim, 0, 1, m->norm_jitter);
+    put_floats(f, 3 * m->layers * m->dim * m->hidden, m->ffn_scale, 0, 0);
+    put_floats(f, m->dim, 0, 1, m->norm_jitter);
+    put_floats(f, m->seq * (m->dim / m->heads), 0.0f, 0, 0);
+    if (m->untied) put_floats(f, m->vocab * m->dim, m->emb_scale, 0, 0);
+    fclose(f);
+    return 0;
+}
+
+typedef struct {
+    int vocab;
+    int byte_tokens;                    // 256 <0xXX> pieces, else the 95 printable ASCII chars
+    float score;                        // <unk> <s> </s> and the byte/char pieces
+    const char *const *words;           // then these, scored word_score
+    int n_words;
+    int word_rank;                      // score words -index (merge order) instead
+    float word_score;
+    const char *filler;                 // rest: printf format of the id, scored -1000
+} LlmkTestTok;
+
+// tokenizer.bin: max_len, then (score, len, bytes) per id
+static int llmk_test_write_tokenizer(const char *path, const LlmkTestTok *t) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int max_len = 16;
+    fwrite(&max_len, 4, 1, f);
+    int first_word = t->byte_tokens ? 3 + 256 : 3 + 95;
+    char buf[16];
+    for (int i = 0; i < t->vocab; i++) {
+        float score = t->score;
+        const char *s = buf;
+        if (i == 0) s = "<unk>";
+        else if (i == 1) s = "<s>";
+        else if (i == 2) s = "</s>";
+        else if (i < first_word && t->byte_tokens) snprintf(buf, sizeof(buf), "<0x%02X>", i - 3);
+        else if (i < first_word) snprintf(buf, sizeof(buf), "%c", 32 + i - 3);
+        else if (i - first_word < t->n_words) {
+            s = t->words[i - first_word];
+            score = t->word_rank ? (float)-(i - first_word) : t->word_score;
+        } else { snprintf(buf, sizeof(buf), t->filler, i); score = -1000.0f; }
+        int len = (int)strlen(s);
+        fwrite(&score, 4, 1, f);
+        fwrite(&len, 4, 1, f);
+        fwrite(s, 1, (size_t)len, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+#endif // LLMK_TEST_MODEL_H
@@ -0,0 +1,819 @@
+// test_hermes_json.c — Host-mode harness for the Hermes JSON tape tokenizer
+//
+// Tests:
+//   tape layout (next links, depth, key flags) and O(1) key index
+//   strict grammar: numbers, literals, escapes, \uXXXX, control bytes
+//   limits: token capacity, nesting depth, u64 overflow
+//   round-trip encode/decode over a corpus of bus messages, cross-checked
+//   against the previous key-rescanning decoder
+//   strings and backslash runs straddling every 64-byte block boundary
+//   fuzz: mutated messages + random bytes; SSE2 and scalar stage 1 must
+//   produce identical tapes and accept exactly what a reference
+//   recursive-descent validator accepts
+//   benchmark: old vs tape decoder on realistic messages
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=c11 -O2 -Wall -Wextra -I../oo-bus/hermes
+//       test_hermes_json.c ../oo-bus/hermes/hermes_json.c
+//       ../oo-bus/hermes/hermes_json_tape.c -o test_hermes_json
+//
+// Run:
+//   ./test_hermes_json
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "hermes_json.h"
+#include "hermes_json_tape.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t)(g_rng >> 16);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ============================================================
+// Previous decoder (key re-scan per field), kept as oracle + baseline
+// ============================================================
+static int old_is_space(char c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+static const char* old_skip_ws(const char* p, const char* end) {
+    while (p < end && old_is_space(*p)) p++;
+    return p;
+}
+
+static const char* old_find_key(const char* obj, const char* end, const char* key) {
+    obj = old_skip_ws(obj, end);
+    if (obj >= end || *obj != '{') return NULL;
+    const size_t klen = strlen(key);
+    int depth = 0;
+    for (const char* p = obj; p < end; ) {
+        char c = *p;
+        if (c == '"') {
+            const char* q = p + 1;
+            size_t n = 0;
+            int mismatch = 0;
+            while (q < end) {
+                char ch = *q++;
+                if (ch == '\\') {
+                    mismatch = 1;
+                    if (q >= end) return NULL;
+                    q++;
+                    continue;
+                }
+                if (ch == '"') break;
+                if (!mismatch && (n >= klen || ch != key[n])) mismatch = 1;
+                n++;
+            }
+            if (q == end || *(q - 1) != '"') return NULL;
+            if (depth == 1 && !mismatch && n == klen) {
+                const char* after = old_skip_ws(q, end);
+                if (after < end && *after == ':') return q;
+            }
+            p = q;
+            continue;
+        }
+        if (c == '{' || c == '[') depth++;
+        if (c == '}' || c == ']') {
+            depth--;
+            if (c == '}' && depth <= 0) break;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static int old_u64(const char* p, const char* end, uint64_t* out) {
+    p = old_skip_ws(p, end);
+    if (p >= end || *p != ':') return -1;
+    p = old_skip_ws(p + 1, end);
+    uint64_t v = 0;
+    int any = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        any = 1;
+        v = v * 10u + (uint64_t)(*p - '0');
+        p++;
+    }
+    if (!any) return -1;
+    *out = v;
+    return 0;
+}
+
+static int old_str(const char* p, const char* end, char* out, size_t cap, size_t* out_len) {
+    p = old_skip_ws(p, end);
+    if (p >= end || *p != ':') return -1;
+    p = old_skip_ws(p + 1, end);
+    if (p >= end || *p != '"') return -1;
+    p++;
+    size_t n = 0;
+    while (p < end) {
+        char c = *p++;
+        if (c == '"') break;
+        if (c == '\\') {
+            if (p >= end) return -1;
+            char e = *p++;
+            switch (e) {
+                case '"': c = '"'; break;
+                case '\\': c = '\\'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                default: return -1;
+            }
+        }
+        if (n + 1 >= cap) return -1;
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    *out_len = n;
+    return 0;
+}
+
+static int old_decode(const char* json, size_t len, hermes_header_t* h, char* pay, size_t pay_cap) {
+    const char* end = json + len;
+    memset(h, 0, sizeof(*h));
+    const char* root = old_skip_ws(json, end);
+    const char* v = old_find_key(root, end, "v");
+    if (!v) return -1;
+    v = old_skip_ws(v, end);
+    if (v >= end || *v != ':') return -1;
+    v = old_skip_ws(v + 1, end);
+    uint64_t maj = 0, min = 0, u = 0;
+    const char* p;
+    if (!(p = old_find_key(v, end, "maj")) || old_u64(p, end, &maj)) return -1;
+    if (!(p = old_find_key(v, end, "min")) || old_u64(p, end, &min)) return -1;
+    h->version_major = (uint16_t)maj;
+    h->version_minor = (uint16_t)min;
+    char ks[16];
+    size_t kn = 0;
+    if (!(p = old_find_key(root, end, "kind")) || old_str(p, end, ks, sizeof(ks), &kn)) return -1;
+    if (kn == 7 && !memcmp(ks, "COMMAND", 7)) h->kind = HERMES_KIND_COMMAND;
+    else if (kn == 5 && !memcmp(ks, "EVENT", 5)) h->kind = HERMES_KIND_EVENT;
+    else if (kn == 8 && !memcmp(ks, "RESPONSE", 8)) h->kind = HERMES_KIND_RESPONSE;
+    else return -1;
+    if (!(p = old_find_key(root, end, "flags")) || old_u64(p, end, &u)) return -1;
+    h->flags = (uint16_t)u;
+    if (!(p = old_find_key(root, end, "payload_len")) || old_u64(p, end, &u)) return -1;
+    h->payload_len = (uint32_t)u;
+    if (!(p = old_find_key(root, end, "correlation_id")) || old_u64(p, end, &u)) return -1;
+    h->correlation_id = u;
+    if (!(p = old_find_key(root, end, "source")) || old_u64(p, end, &u)) return -1;
+    h->source = u;
+    if (!(p = old_find_key(root, end, "dest")) || old_u64(p, end, &u)) return -1;
+    h->dest = u;
+    if ((p = old_find_key(root, end, "payload")) != NULL) {
+        size_t n = 0;
+        if (old_str(p, end, pay, pay_cap, &n) || n != h->payload_len) return -1;
+    } else if (h->payload_len) {
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================
+// Reference validator (recursive descent, RFC 8259)
+// ============================================================
+typedef struct {
+    const char* s;
+    size_t n;
+    size_t i;
+    uint32_t toks;
+} RefParser;
+
+static void ref_ws(RefParser* r) {
+    while (r->i < r->n && old_is_space(r->s[r->i])) r->i++;
+}
+
+static int ref_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static int ref_digit(RefParser* r) {
+    return r->i < r->n && r->s[r->i] >= '0' && r->s[r->i] <= '9';
+}
+
+static int ref_value(RefParser* r, int depth);
+
+static int ref_string(RefParser* r) {
+    if (r->i >= r->n || r->s[r->i] != '"') return 0;
+    r->i++;
+    r->toks++;
+    while (r->i < r->n) {
+        unsigned char c = (unsigned char)r->s[r->i++];
+        if (c == '"') return 1;
+        if (c < 0x20) return 0;
+        if (c == '\\') {
+            if (r->i >= r->n) return 0;
+            char e = r->s[r->i++];
+            if (e == 'u') {
+                for (int k = 0; k < 4; k++) {
+                    if (r->i >= r->n || !ref_hex(r->s[r->i])) return 0;
+                    r->i++;
+                }
+            } else if (!strchr("\"\\/bfnrt", e) || e == 0) {
+                return 0;
+            }
+        }
+    }
+    return 0;
+}
+
+static int ref_number(RefParser* r) {
+    if (r->i < r->n && r->s[r->i] == '-') r->i++;
+    if (!ref_digit(r)) return 0;
+    if (r->s[r->i] == '0') r->i++;
+    else while (ref_digit(r)) r->i++;
+    if (r->i < r->n && r->s[r->i] == '.') {
+        r->i++;
+        if (!ref_digit(r)) return 0;
+        while (ref_digit(r)) r->i++;
+    }
+    if (r->i < r->n && (r->s[r->i] == 'e' || r->s[r->i] == 'E')) {
+        r->i++;
+        if (r->i < r->n && (r->s[r->i] == '+' || r->s[r->i] == '-')) r->i++;
+        if (!ref_digit(r)) return 0;
+        while (ref_digit(r)) r->i++;
+    }
+    // A number must end at a delimiter (no "1x" / "01")
+    if (r->i < r->n) {
+        char c = r->s[r->i];
+        if (!old_is_space(c) && !strchr(",:]}[{\"", c)) return 0;
+    }
+    r->toks++;
+    return 1;
+}
+
+static int ref_literal(RefParser* r, const char* lit) {
+    size_t n = strlen(lit);
+    if (r->n - r->i < n || memcmp(r->s + r->i, lit, n) != 0) return 0;
+    r->i += n;
+    if (r->i < r->n) {
+        char c = r->s[r->i];
+        if (!old_is_space(c) && !strchr(",:]}[{\"", c)) return 0;
+    }
+    r->toks++;
+    return 1;
+}
+
+static int ref_value(RefParser* r, int depth) {
+    ref_ws(r);
+    if (r->i >= r->n) return 0;
+    char c = r->s[r->i];
+    if (c == '{' || c == '[') {
+        if (depth >= (int)HERMES_JSON_MAX_DEPTH) return -1;
+        char close = (c == '{') ? '}' : ']';
+        r->i++;
+        r->toks++;
+        ref_ws(r);
+        if (r->i < r->n && r->s[r->i] == close) { r->i++; return 1; }
+        for (;;) {
+            if (c == '{') {
+                ref_ws(r);
+                if (!ref_string(r)) return 0;
+                ref_ws(r);
+                if (r->i >= r->n || r->s[r->i] != ':') return 0;
+                r->i++;
+            }
+            int v = ref_value(r, depth + 1);
+            if (v <= 0) return v;
+            ref_ws(r);
+            if (r->i >= r->n) return 0;
+            if (r->s[r->i] == ',') { r->i++; continue; }
+            if (r->s[r->i] == close) { r->i++; return 1; }
+            return 0;
+        }
+    }
+    if (c == '"') return ref_string(r);
+    if (c == 't') return ref_literal(r, "true");
+    if (c == 'f') return ref_literal(r, "false");
+    if (c == 'n') return ref_literal(r, "null");
+    return ref_number(r);
+}
+
+// 1 = valid, 0 = malformed, -1 = too deep. *toks = tokens required.
+static int ref_validate(const char* s, size_t n, uint32_t* toks) {
+    RefParser r = { s, n, 0, 0 };
+    int v = ref_value(&r, 0);
+    *toks = r.toks;
+    if (v <= 0) return v;
+    ref_ws(&r);
+    return r.i == r.n ? 1 : 0;
+}
+
+// ============================================================
+// Tape checks
+// ============================================================
+static int tape_invariants_ok(const hermes_json_tape_t* t) {
+    for (uint32_t i = 0; i < t->count; i++) {
+        const hermes_json_tok_t* k = &t->toks[i];
+        if (k->start > k->end || k->end > t->len) return 0;
+        if (k->next <= i || k->next > t->count) return 0;
+        if (k->type < HERMES_JSON_OBJECT || k->type > HERMES_JSON_NULL) return 0;
+        if (k->type == HERMES_JSON_OBJECT || k->type == HERMES_JSON_ARRAY) {
+            for (uint32_t c = i + 1; c < k->next; c = t->toks[c].next) {
+                if (t->toks[c].depth != k->depth + 1) return 0;
+            }
+            if (k->type == HERMES_JSON_OBJECT) {
+                // keys alternate with values
+                for (uint32_t c = i + 1; c < k->next; c = t->toks[c + 1].next) {
+                    if (!(t->toks[c].flags & HERMES_JSON_F_KEY)) return 0;
+                    if (c + 1 >= k->next) return 0;
+                }
+            }
+        } else if (k->next != i + 1) {
+            return 0;
+        }
+    }
+    return t->count == 0 || t->toks[0].next == t->count;
+}
+
+static hermes_status_t parse_mode(int scalar, hermes_json_tape_t* t, const char* s, size_t n,
+                                  hermes_json_tok_t* toks, uint32_t cap) {
+    hermes_json_tape_force_scalar(scalar);
+    hermes_status_t st = hermes_json_tape_parse(t, s, n, toks, cap);
+    hermes_json_tape_force_scalar(0);
+    return st;
+}
+
+// Parse with both stage-1 paths; 1 if status, tape and error offset agree.
+static int paths_agree(const char* s, size_t n, uint32_t cap, hermes_status_t* st_out) {
+    static hermes_json_tok_t a[1024], b[1024];
+    hermes_json_tape_t ta, tb;
+    memset(a, 0, sizeof(a));
+    memset(b, 0, sizeof(b));
+    hermes_status_t sa = parse_mode(0, &ta, s, n, a, cap);
+    hermes_status_t sb = parse_mode(1, &tb, s, n, b, cap);
+    *st_out = sa;
+    if (sa != sb || ta.count != tb.count) return 0;
+    if (sa != HERMES_OK) return ta.error_offset == tb.error_offset;
+    if (!tape_invariants_ok(&ta)) return 0;
+    return memcmp(a, b, sizeof(a[0]) * ta.count) == 0;
+}
+
+// ============================================================
+// Corpus
+// ============================================================
+#define CORPUS_N 64
+static char g_corpus[CORPUS_N][2048];
+static size_t g_corpus_len[CORPUS_N];
+static hermes_msg_t g_corpus_msg[CORPUS_N];
+static char g_corpus_pay[CORPUS_N][512];
+
+static void build_corpus(void) {
+    static const char* words[] = {
+        "route", "ok", "temp=41C", "say \"hi\"", "path C:\\oo\\boot", "line1\nline2",
+        "tab\there", "mem 12%", "{\"nested\":[1,2]}", "ack", "\x01ctl",
+    };
+    for (int i = 0; i < CORPUS_N; i++) {
+        hermes_msg_t* m = &g_corpus_msg[i];
+        memset(m, 0, sizeof(*m));
+        m->header.version_major = HERMES_VERSION_MAJOR;
+        m->header.version_minor = HERMES_VERSION_MINOR;
+        m->header.kind = (uint16_t)(1 + i % 3);
+        m->header.flags = (uint16_t)(i * 7);
+        m->header.correlation_id = 0x1000000000ull + (uint64_t)i * 977u;
+        m->header.source = (uint64_t)(i % 5);
+        m->header.dest = (uint64_t)(i % 9) + 100u;
+        size_t n = 0;
+        int words_n = (i % 4 == 0) ? 0 : 1 + i % 11;
+        char* pay = g_corpus_pay[i];
+        for (int w = 0; w < words_n; w++) {
+            const char* s = words[(i + w) % (int)(sizeof(words) / sizeof(words[0]))];
+            size_t l = strlen(s);
+            memcpy(pay + n, s, l);
+            n += l;
+            pay[n++] = ' ';
+        }
+        pay[n] = '\0';
+        m->header.payload_len = (uint32_t)n;
+        m->payload = n ? pay : NULL;
+
+        char tmp[2048];
+        size_t len = 0;
+        if (hermes_json_encode_msg(m, tmp, sizeof(tmp), &len) != HERMES_OK) {
+            g_corpus_len[i] = 0;
+            continue;
+        }
+        // Every third message carries routing metadata the decoder must skip
+        if (i % 3 == 2) {
+            len = (size_t)snprintf(g_corpus[i], sizeof(g_corpus[i]),
+                "{\"trace\":{\"hops\":[{\"node\":\"ap%d\",\"t\":%d},{\"node\":\"bsp\",\"t\":-1.5e3}],"
+                "\"ok\":true,\"err\":null},\"ttl\":%d,%s",
+                i, i * 13, 8 - i % 8, tmp + 1);
+        } else {
+            memcpy(g_corpus[i], tmp, len + 1);
+        }
+        g_corpus_len[i] = len;
+    }
+}
+
+// ============================================================
+// Tests
+// ============================================================
+static void test_tape_layout(void) {
+    printf("\n--- tape layout + key index ---\n");
+    const char* j = " {\"a\":1,\"b\":[2,3,{\"c\":\"x\"}],\"d\":{},\"e\":[]} ";
+    hermes_json_tok_t toks[32];
+    hermes_json_tape_t t;
+    ASSERT_EQ(hermes_json_tape_parse(&t, j, strlen(j), toks, 32), HERMES_OK, "parse sample");
+    ASSERT_EQ(t.count, 14, "14 tokens");
+    ASSERT_EQ(toks[0].type, HERMES_JSON_OBJECT, "root is object");
+    ASSERT_EQ(toks[0].next, 14, "root spans tape");
+    ASSERT_EQ(toks[0].start, 1, "root start");
+    ASSERT_EQ(toks[0].end, strlen(j) - 1, "root end past '}'");
+    ASSERT_TRUE(toks[1].flags & HERMES_JSON_F_KEY, "key flagged");
+    ASSERT_EQ(toks[4].type, HERMES_JSON_ARRAY, "b is array");
+    ASSERT_EQ(toks[4].next, 10, "array skips nested object");
+    ASSERT_EQ(toks[8].depth, 3, "c depth 3");
+    ASSERT_TRUE(tape_invariants_ok(&t), "invariants");
+
+    ASSERT_EQ(hermes_json_object_find(&t, 0, "b", 1), 4, "find b");
+    ASSERT_EQ(hermes_json_object_find(&t, 0, "c", 1), HERMES_JSON_NONE, "nested key not visible at root");
+    hermes_json_keys_t k;
+    ASSERT_EQ(hermes_json_keys_build(&t, 0, &k), HERMES_OK, "keys build");
+    ASSERT_EQ(hermes_json_keys_get(&k, "a"), 2, "keys a");
+    ASSERT_EQ(hermes_json_keys_get(&k, "e"), 13, "keys e");
+    ASSERT_EQ(hermes_json_keys_get(&k, "zz"), HERMES_JSON_NONE, "keys miss");
+    ASSERT_EQ(hermes_json_keys_build(&t, 4, &k), HERMES_ERR_INVALID_ARG, "keys on array rejected");
+
+    // More keys than the index holds: lookups fall back to the walk
+    char big[2048];
+    size_t n = 0;
+    big[n++] = '{';
+    for (int i = 0; i < 40; i++) n += (size_t)sprintf(big + n, "%s\"k%d\":%d", i ? "," : "", i, i);
+    big[n++] = '}';
+    static hermes_json_tok_t bt[128];
+    ASSERT_EQ(hermes_json_tape_parse(&t, big, n, bt, 128), HERMES_OK, "parse 40 keys");
+    hermes_json_keys_build(&t, 0, &k);
+    ASSERT_TRUE(k.overflow, "index overflow flagged");
+    int all = 1;
+    for (int i = 0; i < 40; i++) {
+        char key[16];
+        sprintf(key, "k%d", i);
+        uint64_t v = 0;
+        uint32_t idx = hermes_json_keys_get(&k, key);
+        if (idx == HERMES_JSON_NONE || hermes_json_tok_u64(&t, idx, &v) != HERMES_OK || v != (uint64_t)i) all = 0;
+    }
+    ASSERT_TRUE(all, "all 40 keys resolve");
+
+    // Duplicate keys: first wins (same as the linear walk)
+    const char* dup = "{\"x\":1,\"x\":2}";
+    hermes_json_tape_parse(&t, dup, strlen(dup), toks, 32);
+    hermes_json_keys_build(&t, 0, &k);
+    ASSERT_EQ(hermes_json_keys_get(&k, "x"), hermes_json_object_find(&t, 0, "x", 1), "duplicate key: first wins");
+}
+
+static void test_grammar(void) {
+    printf("\n--- strict grammar ---\n");
+    static const char* good[] = {
+        "0", "-0", "1.5", "-12.25e+10", "3E-2", "true", "false", "null", "\"\"",
+        "[]", "{}", "[[[]]]", "\"\\u00e9\\n\\/\"", " [1 , 2\t,\r\n3 ] ", "{\"\":0}",
+        "\"caf\xc3\xa9\"", "[\"\\\\\",\"\\\\\\\"\"]",
+    };
+    static const char* bad[] = {
+        "", " ", "01", "1.", ".5", "-", "1e", "+1", "tru", "truex", "nul", "[1,]", "{\"a\":1,}",
+        "{\"a\"}", "{\"a\":}", "{1:2}", "[1 2]", "{\"a\" 1}", "\"abc", "\"\\x\"", "\"\\u12g4\"",
+        "\"a\tb\"", "[1]]", "[1}", "{]", "1 2", "\"a\"\"b\"", "[\"a\"1]", "\xff", "[\\]", ":",
+        "{\"a\":1\"b\":2}", "[true false]", "[\"\\\"]",
+    };
+    hermes_json_tok_t toks[64];
+    hermes_json_tape_t t;
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(good) / sizeof(good[0]); i++) {
+        hermes_status_t st = hermes_json_tape_parse(&t, good[i], strlen(good[i]), toks, 64);
+        if (st != HERMES_OK) { printf("    rejected valid: %s\n", good[i]); ok = 0; }
+    }
+    ASSERT_TRUE(ok, "valid documents accepted");
+    ok = 1;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        hermes_status_t st = hermes_json_tape_parse(&t, bad[i], strlen(bad[i]), toks, 64);
+        if (st == HERMES_OK) { printf("    accepted invalid: %s\n", bad[i]); ok = 0; }
+        if (t.count != 0) ok = 0;
+    }
+    ASSERT_TRUE(ok, "malformed documents rejected, tape cleared");
+
+    const char* e = "[1, 2, x]";
+    hermes_json_tape_parse(&t, e, strlen(e), toks, 64);
+    ASSERT_EQ(t.error_offset, 7, "error offset points at bad scalar");
+
+    // String decoding
+    const char* s = "[\"a\\u00e9\\ud83d\\ude00\\\"\\b\\f\\/z\",\"\\ud800x\",\"plain\"]";
+    char out[64];
+    size_t n = 0;
+    ASSERT_EQ(hermes_json_tape_parse(&t, s, strlen(s), toks, 64), HERMES_OK, "parse escapes");
+    ASSERT_TRUE(toks[1].flags & HERMES_JSON_F_ESCAPED, "escaped flag set");
+    ASSERT_TRUE(!(toks[3].flags & HERMES_JSON_F_ESCAPED), "plain string not flagged");
+    ASSERT_EQ(hermes_json_tok_string(&t, 1, out, sizeof(out), &n), HERMES_OK, "decode escapes");
+    ASSERT_TRUE(n == 12 && memcmp(out, "a\xc3\xa9\xf0\x9f\x98\x80\"\b\f/z", 12) == 0, "UTF-8 + surrogate pair");
+    ASSERT_EQ(hermes_json_tok_string(&t, 2, out, sizeof(out), &n), HERMES_ERR_INVALID_ARG, "lone surrogate rejected");
+    ASSERT_EQ(hermes_json_tok_string(&t, 1, out, 12, &n), HERMES_ERR_BAD_LENGTH, "no room for NUL");
+    ASSERT_EQ(hermes_json_tok_string(&t, 1, NULL, 0, &n), HERMES_OK, "measure only");
+    ASSERT_EQ(n, 12, "measured length");
+    const char* view = NULL;
+    ASSERT_EQ(hermes_json_tok_view(&t, 3, &view, &n), HERMES_OK, "view");
+    ASSERT_TRUE(n == 5 && view == s + strlen(s) - 7, "view is zero-copy");
+}
+
+static void test_limits(void) {
+    printf("\n--- limits ---\n");
+    hermes_json_tok_t toks[256];
+    hermes_json_tape_t t;
+    ASSERT_EQ(hermes_json_tape_parse(&t, "[1,2,3]", 7, toks, 3), HERMES_ERR_BAD_LENGTH, "tape capacity");
+    ASSERT_EQ(hermes_json_tape_parse(&t, "[1,2,3]", 7, toks, 4), HERMES_OK, "exact capacity");
+
+    char deep[300];
+    int d = (int)HERMES_JSON_MAX_DEPTH;
+    memset(deep, '[', (size_t)d);
+    memset(deep + d, ']', (size_t)d);
+    ASSERT_EQ(hermes_json_tape_parse(&t, deep, (size_t)d * 2, toks, 256), HERMES_OK, "max depth accepted");
+    memset(deep, '[', (size_t)d + 1);
+    memset(deep + d + 1, ']', (size_t)d + 1);
+    ASSERT_EQ(hermes_json_tape_parse(&t, deep, (size_t)d * 2 + 2, toks, 256), HERMES_ERR_BAD_LENGTH, "max depth + 1 rejected");
+
+    uint64_t v = 0;
+    hermes_json_tape_parse(&t, "[18446744073709551615,18446744073709551616,-1,1.0]", 50, toks, 8);
+    ASSERT_EQ(hermes_json_tok_u64(&t, 1, &v), HERMES_OK, "u64 max");
+    ASSERT_TRUE(v == UINT64_MAX, "u64 max value");
+    ASSERT_EQ(hermes_json_tok_u64(&t, 2, &v), HERMES_ERR_INVALID_ARG, "u64 overflow rejected");
+    ASSERT_EQ(hermes_json_tok_u64(&t, 3, &v), HERMES_ERR_INVALID_ARG, "negative rejected");
+    ASSERT_EQ(hermes_json_tok_u64(&t, 4, &v), HERMES_ERR_INVALID_ARG, "fraction rejected");
+}
+
+static void test_roundtrip(void) {
+    printf("\n--- round-trip corpus ---\n");
+    int enc = 0, same = 0, legacy = 0, usable = 0;
+    for (int i = 0; i < CORPUS_N; i++) {
+        if (!g_corpus_len[i]) continue;
+        enc++;
+        hermes_msg_t m;
+        char pay[1024];
+        hermes_status_t st = hermes_json_decode_msg(g_corpus[i], g_corpus_len[i], &m, pay, sizeof(pay));
+        const hermes_msg_t* o = &g_corpus_msg[i];
+        if (st == HERMES_OK && memcmp(&m.header, &o->header, sizeof(m.header)) == 0 &&
+            (o->header.payload_len == 0 ? m.payload == NULL
+                                        : memcmp(m.payload, o->payload, o->header.payload_len) == 0)) {
+            same++;
+        } else {
+            printf("    mismatch #%d: %s\n", i, g_corpus[i]);
+        }
+        // The old decoder only knew \" \\ \n \r \t; compare where it applies
+        if (!strstr(g_corpus[i], "\\u")) {
+            usable++;
+            hermes_header_t h;
+            char opay[1024];
+            if (old_decode(g_corpus[i], g_corpus_len[i], &h, opay, sizeof(opay)) == 0 &&
+                memcmp(&h, &m.header, sizeof(h)) == 0) legacy++;
+        }
+    }
+    ASSERT_EQ(enc, CORPUS_N, "corpus encoded");
+    ASSERT_EQ(same, enc, "decode(encode(m)) == m");
+    ASSERT_EQ(legacy, usable, "agrees with previous decoder");
+
+    // Status semantics kept from the previous decoder
+    hermes_msg_t m;
+    char pay[16];
+    const char* big = "{\"v\":{\"maj\":0,\"min\":1},\"kind\":\"EVENT\",\"flags\":0,\"payload_len\":5000,"
+                      "\"correlation_id\":1,\"source\":1,\"dest\":2}";
+    ASSERT_EQ(hermes_json_decode_msg(big, strlen(big), &m, pay, sizeof(pay)), HERMES_ERR_BAD_LENGTH, "payload_len > max");
+    const char* cap = "{\"v\":{\"maj\":0,\"min\":1},\"kind\":\"EVENT\",\"flags\":0,\"payload_len\":20,"
+                      "\"correlation_id\":1,\"source\":1,\"dest\":2,\"payload\":\"01234567890123456789\"}";
+    ASSERT_EQ(hermes_json_decode_msg(cap, strlen(cap), &m, pay, sizeof(pay)), HERMES_ERR_BAD_LENGTH, "payload > buffer");
+    const char* mis = "{\"v\":{\"maj\":0,\"min\":1},\"kind\":\"EVENT\",\"flags\":0,\"payload_len\":3,"
+                      "\"correlation_id\":1,\"source\":1,\"dest\":2,\"payload\":\"ab\"}";
+    ASSERT_EQ(hermes_json_decode_msg(mis, strlen(mis), &m, pay, sizeof(pay)), HERMES_ERR_INVALID_ARG, "length mismatch");
+    const char* ver = "{\"v\":{\"maj\":7,\"min\":1},\"kind\":\"EVENT\",\"flags\":0,\"payload_len\":0,"
+                      "\"correlation_id\":1,\"source\":1,\"dest\":2}";
+    ASSERT_EQ(hermes_json_decode_msg(ver, strlen(ver), &m, pay, sizeof(pay)), HERMES_ERR_UNSUPPORTED_VERSION, "version check");
+    const char* kind = "{\"v\":{\"maj\":0,\"min\":1},\"kind\":\"NOPE\",\"flags\":0,\"payload_len\":0,"
+                       "\"correlation_id\":1,\"source\":1,\"dest\":2}";
+    ASSERT_EQ(hermes_json_decode_msg(kind, strlen(kind), &m, pay, sizeof(pay)), HERMES_ERR_INVALID_ARG, "unknown kind");
+    const char* trunc = "{\"v\":{\"maj\":0,\"min\":1},\"kind\":\"EVENT\",\"flags\":0,\"payload_len\":0,"
+                        "\"correlation_id\":1,\"source\":1,\"dest\":2";
+    ASSERT_EQ(hermes_json_decode_msg(trunc, strlen(trunc), &m, pay, sizeof(pay)), HERMES_ERR_INVALID_ARG, "truncated message");
+    const char* ovf = "{\"v\":{\"maj\":0,\"min\":1},\"kind\":\"EVENT\",\"flags\":0,\"payload_len\":0,"
+                      "\"correlation_id\":99999999999999999999,\"source\":1,\"dest\":2}";
+    ASSERT_EQ(hermes_json_decode_msg(ovf, strlen(ovf), &m, pay, sizeof(pay)), HERMES_ERR_INVALID_ARG, "u64 overflow");
+}
+
+static void test_block_boundaries(void) {
+    printf("\n--- 64-byte block boundaries ---\n");
+    // Place quotes / backslash runs / scalars at every offset around the
+    // first two block edges; both stage-1 paths must match the reference.
+    static const char* pieces[] = {
+        "\"\\\\\"", "\"\\\"\"", "\"\\\\\\\\\\\"x\"", "\"\\u0041\"", "12345", "true", "\"a\\\"b\\\\\"",
+        "\"\\\"", "\"\\\\\\\"", "-1.5e7", "nul", "\"\\\\\\\\\"",
+    };
+    char buf[256];
+    int agree = 0, match = 0, total = 0;
+    for (size_t p = 0; p < sizeof(pieces) / sizeof(pieces[0]); p++) {
+        for (int pad = 40; pad < 140; pad++) {
+            size_t n = 0;
+            buf[n++] = '[';
+            for (int i = 0; i < pad; i++) buf[n++] = ' ';
+            size_t l = strlen(pieces[p]);
+            memcpy(buf + n, pieces[p], l);
+            n += l;
+            buf[n++] = ',';
+            buf[n++] = '0';
+            buf[n++] = ']';
+            hermes_status_t st;
+            uint32_t need = 0;
+            int ref = ref_validate(buf, n, &need);
+            total++;
+            if (paths_agree(buf, n, 64, &st)) agree++;
+            if ((st == HERMES_OK) == (ref == 1)) match++;
+        }
+    }
+    ASSERT_EQ(agree, total, "SSE2 and scalar tapes identical");
+    ASSERT_EQ(match, total, "accept/reject matches reference");
+
+    // Long escaped payload crossing many blocks
+    char pay[600];
+    for (int i = 0; i < 599; i++) pay[i] = (i % 7 == 0) ? '\\' : (i % 11 == 0) ? '"' : (char)('a' + i % 26);
+    pay[599] = '\0';
+    hermes_msg_t m = { { HERMES_VERSION_MAJOR, HERMES_VERSION_MINOR, HERMES_KIND_EVENT, 0, 599, 5, 1, 2 }, pay };
+    char json[2048];
+    size_t len = 0;
+    hermes_json_encode_msg(&m, json, sizeof(json), &len);
+    hermes_msg_t out;
+    char dec[1024];
+    ASSERT_EQ(hermes_json_decode_msg(json, len, &out, dec, sizeof(dec)), HERMES_OK, "decode long escaped payload");
+    ASSERT_TRUE(out.header.payload_len == 599 && memcmp(dec, pay, 599) == 0, "long payload intact");
+}
+
+static void test_fuzz(void) {
+    printf("\n--- fuzz ---\n");
+    static char buf[4096];
+    int iters = 200000;
+    int agree = 0, match = 0, decoded_ok = 0, accepted = 0;
+    for (int it = 0; it < iters; it++) {
+        size_t n;
+        if (it % 10 == 9) {
+            // Random bytes biased towards JSON syntax
+            static const char alpha[] = "{}[]:,\"\\ \t\n0123456789-+.eEtrufalsn\x01\x80u";
+            n = rnd() % 200;
+            for (size_t i = 0; i < n; i++) buf[i] = alpha[rnd() % (sizeof(alpha) - 1)];
+        } else {
+            int src = (int)(rnd() % CORPUS_N);
+            n = g_corpus_len[src];
+            memcpy(buf, g_corpus[src], n);
+            int muts = 1 + (int)(rnd() % 3);
+            for (int k = 0; k < muts && n; k++) {
+                size_t at = rnd() % n;
+                switch (rnd() % 5) {
+                    case 0: buf[at] ^= (char)(1u << (rnd() % 8)); break;
+                    case 1: n = at; break;
+                    case 2: buf[at] = "{}[]:,\"\\ 0"[rnd() % 10]; break;
+                    case 3:
+                        if (n + 1 < sizeof(buf)) {
+                            memmove(buf + at + 1, buf + at, n - at);
+                            buf[at] = "{}[]:,\"\\ 0a"[rnd() % 11];
+                            n++;
+                        }
+                        break;
+                    default:
+                        memmove(buf + at, buf + at + 1, n - at - 1);
+                        n--;
+                        break;
+                }
+            }
+        }
+
+        hermes_status_t st;
+        uint32_t need = 0;
+        if (paths_agree(buf, n, 512, &st)) agree++;
+        int ref = ref_validate(buf, n, &need);
+        hermes_status_t want = (ref == 1 && need <= 512) ? HERMES_OK
+                             : (ref == -1 || (ref == 1 && need > 512)) ? HERMES_ERR_BAD_LENGTH
+                             : HERMES_ERR_INVALID_ARG;
+        if (st == want || (ref == -1 && st == HERMES_ERR_INVALID_ARG)) match++;
+        else { printf("    mismatch st=%d ref=%d n=%zu:", st, ref, n); for (size_t q = 0; q < n; q++) printf(" %02x", (unsigned char)buf[q]); printf("\n"); }
+        if (st == HERMES_OK) accepted++;
+
+        // The decoder must never crash and must leave a sane message
+        hermes_msg_t m;
+        char pay[256];
+        if (hermes_json_decode_msg(buf, n, &m, pay, sizeof(pay)) == HERMES_OK) {
+            decoded_ok++;
+            if (m.header.payload_len && (!m.payload || strlen(pay) > m.header.payload_len)) decoded_ok = -1000000;
+        }
+    }
+    printf("  (%d inputs, %d valid JSON, %d decodable messages)\n", iters, accepted, decoded_ok);
+    ASSERT_EQ(agree, iters, "SSE2 and scalar tapes identical");
+    ASSERT_EQ(match, iters, "accept/reject matches reference");
+    ASSERT_TRUE(decoded_ok >= 0, "decoded messages consistent");
+    ASSERT_TRUE(accepted > 0 && accepted < iters, "fuzz hits both valid and invalid");
+}
+
+static void test_benchmark(void) {
+    printf("\n--- benchmark ---\n");
+    const int reps = 2000;
+    hermes_msg_t m;
+    hermes_header_t h;
+    char pay[1024];
+    volatile uint64_t sink = 0;
+
+    double t0 = now_sec();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < CORPUS_N; i++) {
+            old_decode(g_corpus[i], g_corpus_len[i], &h, pay, sizeof(pay));
+            sink += h.correlation_id;
+        }
+    }
+    double t_old = now_sec() - t0;
+
+    t0 = now_sec();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < CORPUS_N; i++) {
+            hermes_json_decode_msg(g_corpus[i], g_corpus_len[i], &m, pay, sizeof(pay));
+            sink += m.header.correlation_id;
+        }
+    }
+    double t_new = now_sec() - t0;
+
+    hermes_json_tok_t toks[256];
+    hermes_json_tape_t t;
+    size_t bytes = 0;
+    t0 = now_sec();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < CORPUS_N; i++) {
+            hermes_json_tape_parse(&t, g_corpus[i], g_corpus_len[i], toks, 256);
+            sink += t.count;
+            bytes += g_corpus_len[i];
+        }
+    }
+    double t_tape = now_sec() - t0;
+
+    double msgs = (double)reps * CORPUS_N;
+    printf("  previous decoder : %7.1f ns/msg\n", t_old * 1e9 / msgs);
+    printf("  tape decoder     : %7.1f ns/msg  (%.2fx)\n", t_new * 1e9 / msgs, t_old / (t_new > 0 ? t_new : 1e-9));
+    printf("  tokenize only    : %7.1f ns/msg  (%.0f MB/s)\n", t_tape * 1e9 / msgs,
+           (double)bytes / (t_tape > 0 ? t_tape : 1e-9) / 1e6);
+    ASSERT_TRUE(sink != 0, "benchmark ran");
+}
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  Hermes JSON tape tokenizer tests\n");
+    printf("==============================================\n");
+
+    build_corpus();
+
+    test_tape_layout();
+    test_grammar();
+    test_limits();
+    test_roundtrip();
+    test_block_boundaries();
+    test_fuzz();
+    test_benchmark();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All Hermes JSON tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
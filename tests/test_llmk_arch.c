@@ -0,0 +1,523 @@
+// test_llmk_arch.c — GGUF architecture descriptors (llama, mistral, qwen2, phi3, gemma)
+//
+// Tests:
+//   Each case writes a tiny GGUF model of one architecture (tensor names,
+//   fused tensors and metadata as llama.cpp exports them), loads it through
+//   the host runtime and compares the logits of the first tokens with a
+//   naive double reference written from the architecture's definition:
+//   llama      interleaved RoPE, SwiGLU, eps 1e-5, separate classifier
+//   mistral    as llama, attention limited to the last sliding_window tokens
+//   qwen2      q/k/v biases, NeoX RoPE with freq_base 1e6, eps 1e-6
+//   phi3       fused attn_qkv (q | k | v) and ffn_up (gate | up), sliding
+//              window; also as a Q8_0 file through the blob loader
+//   gemma      GeGLU (tanh GELU), embeddings scaled by sqrt(dim), (1 + w)
+//              norms stored pre-added, tied classifier
+//   Refusals: head_dim != dim / n_heads, qwen2 without its biases.
+//   The GGUF data section starts at general.alignment.
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test
+//
+// Run:
+//   ../engine/host/test_llmk_arch
+
+#include "../engine/host/llmk_host_rt.c"
+
+#define LLMK_TEST_SEED 0x9E3779B9u
+#include "llmk_test_model.h"
+
+#include <math.h>
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+// ============================================================
+// Tiny model: dim 64, 4 heads over 2 KV heads, 2 layers
+// ============================================================
+enum { T_DIM = 64, T_HID = 96, T_LAYERS = 2, T_HEADS = 4, T_KV = 2, T_VOCAB = 300, T_SEQ = 32, T_WINDOW = 3 };
+#define T_HS     (T_DIM / T_HEADS)
+#define T_KV_DIM (T_DIM * T_KV / T_HEADS)
+
+static const char *k_gguf = "/tmp/test_llmk_arch.gguf";
+static const char *k_tok = "/tmp/test_llmk_arch_tok.bin";
+
+// Reference weights, row-major [out][in] as in the HF checkpoints
+static struct {
+    float emb[T_VOCAB][T_DIM];
+    float attn_norm[T_LAYERS][T_DIM];
+    float wq[T_LAYERS][T_DIM][T_DIM];
+    float wk[T_LAYERS][T_KV_DIM][T_DIM];
+    float wv[T_LAYERS][T_KV_DIM][T_DIM];
+    float wo[T_LAYERS][T_DIM][T_DIM];
+    float bq[T_LAYERS][T_DIM];
+    float bk[T_LAYERS][T_KV_DIM];
+    float bv[T_LAYERS][T_KV_DIM];
+    float ffn_norm[T_LAYERS][T_DIM];
+    float gate[T_LAYERS][T_HID][T_DIM];
+    float up[T_LAYERS][T_HID][T_DIM];
+    float down[T_LAYERS][T_DIM][T_HID];
+    float out_norm[T_DIM];
+    float out[T_VOCAB][T_DIM];
+} R;
+
+typedef struct {
+    const char *arch;
+    int    neox;          // RoPE pair layout
+    int    gelu;          // GeGLU instead of SwiGLU
+    int    bias;          // q/k/v biases
+    int    fused;         // attn_qkv + gate|up in ffn_up
+    int    tied;          // no output.weight
+    int    window;        // sliding_window metadata (0 = none)
+    int    norm_plus_one; // gemma: norms are (1 + w), stored pre-added
+    int    embed_sqrt;    // gemma: embeddings scaled by sqrt(dim)
+    double eps;
+    double rope_base;
+} ArchCase;
+
+static void fill(float *v, int n, float scale) {
+    for (int i = 0; i < n; i++) v[i] = rndf(scale);
+}
+
+static void fill_norm(float *v, int n, int plus_one) {
+    for (int i = 0; i < n; i++) v[i] = plus_one ? rndf(0.1f) : 1.0f + rndf(0.1f);
+}
+
+static void make_weights(const ArchCase *ac) {
+    fill(&R.emb[0][0], T_VOCAB * T_DIM, 0.8f);
+    fill(&R.wq[0][0][0], T_LAYERS * T_DIM * T_DIM, 0.15f);
+    fill(&R.wk[0][0][0], T_LAYERS * T_KV_DIM * T_DIM, 0.15f);
+    fill(&R.wv[0][0][0], T_LAYERS * T_KV_DIM * T_DIM, 0.15f);
+    fill(&R.wo[0][0][0], T_LAYERS * T_DIM * T_DIM, 0.15f);
+    fill(&R.bq[0][0], T_LAYERS * T_DIM, 0.3f);
+    fill(&R.bk[0][0], T_LAYERS * T_KV_DIM, 0.3f);
+    fill(&R.bv[0][0], T_LAYERS * T_KV_DIM, 0.3f);
+    fill(&R.gate[0][0][0], T_LAYERS * T_HID * T_DIM, 0.15f);
+    fill(&R.up[0][0][0], T_LAYERS * T_HID * T_DIM, 0.15f);
+    fill(&R.down[0][0][0], T_LAYERS * T_DIM * T_HID, 0.15f);
+    fill(&R.out[0][0], T_VOCAB * T_DIM, 0.8f);
+    fill_norm(&R.attn_norm[0][0], T_LAYERS * T_DIM, ac->norm_plus_one);
+    fill_norm(&R.ffn_norm[0][0], T_LAYERS * T_DIM, ac->norm_plus_one);
+    fill_norm(R.out_norm, T_DIM, ac->norm_plus_one);
+    if (ac->embed_sqrt) {
+        // keep gemma's scaled embeddings in the same range as the others
+        for (int i = 0; i < T_VOCAB * T_DIM; i++) (&R.emb[0][0])[i] *= 0.125f;
+    }
+}
+
+// ============================================================
+// GGUF writer (v3, F32 or Q8_0 matrices)
+// ============================================================
+enum { GW_MAX_TENSORS = 64 };
+static uint8_t g_kv[4096], g_info[8192], g_data[1 << 21];
+static size_t g_kv_len, g_info_len, g_data_len;
+static uint64_t g_n_kv, g_n_tensors;
+
+static void gw_put(uint8_t *buf, size_t *len, const void *p, size_t n) {
+    memcpy(buf + *len, p, n);
+    *len += n;
+}
+
+static void gw_str(uint8_t *buf, size_t *len, const char *s) {
+    uint64_t n = strlen(s);
+    gw_put(buf, len, &n, 8);
+    gw_put(buf, len, s, n);
+}
+
+static void gw_reset(void) {
+    g_kv_len = g_info_len = g_data_len = 0;
+    g_n_kv = g_n_tensors = 0;
+}
+
+static void gw_kv_u32(const char *key, uint32_t v) {
+    uint32_t t = 4;
+    gw_str(g_kv, &g_kv_len, key);
+    gw_put(g_kv, &g_kv_len, &t, 4);
+    gw_put(g_kv, &g_kv_len, &v, 4);
+    g_n_kv++;
+}
+
+static void gw_kv_f32(const char *key, float v) {
+    uint32_t t = 6;
+    gw_str(g_kv, &g_kv_len, key);
+    gw_put(g_kv, &g_kv_len, &t, 4);
+    gw_put(g_kv, &g_kv_len, &v, 4);
+    g_n_kv++;
+}
+
+static void gw_kv_str(const char *key, const char *v) {
+    uint32_t t = 8;
+    gw_str(g_kv, &g_kv_len, key);
+    gw_put(g_kv, &g_kv_len, &t, 4);
+    gw_str(g_kv, &g_kv_len, v);
+    g_n_kv++;
+}
+
+static uint16_t f32_to_f16(float f) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000u;
+    int e = (int)((x >> 23) & 0xFF) - 127 + 15;
+    uint32_t m = x & 0x7FFFFFu;
+    if (e <= 0) return (uint16_t)sign;                      // scales here never underflow
+    return (uint16_t)(sign | ((uint32_t)e << 10) | ((m + 0x1000u) >> 13));
+}
+
+static float f16_to_f32(uint16_t h) {
+    uint32_t x = ((uint32_t)(h & 0x8000u) << 16) | ((uint32_t)(((h >> 10) & 0x1F) - 15 + 127) << 23) |
+                 ((uint32_t)(h & 0x3FFu) << 13);
+    float f;
+    if ((h & 0x7FFFu) == 0) return 0.0f;
+    memcpy(&f, &x, 4);
+    return f;
+}
+
+// Appends a [rows][cols] matrix (or a vector when rows == 0). Q8_0 rounds
+// the values in place, so the reference sees the stored weights.
+static void gw_tensor(const char *name, float *v, int rows, int cols, int q8) {
+    g_data_len = (g_data_len + 31) & ~(size_t)31;
+    uint32_t n_dims = rows ? 2 : 1, type = q8 ? 8 : 0;
+    uint64_t dims[2] = { (uint64_t)cols, (uint64_t)rows }, off = g_data_len;
+    gw_str(g_info, &g_info_len, name);
+    gw_put(g_info, &g_info_len, &n_dims, 4);
+    gw_put(g_info, &g_info_len, dims, 8 * n_dims);
+    gw_put(g_info, &g_info_len, &type, 4);
+    gw_put(g_info, &g_info_len, &off, 8);
+    g_n_tensors++;
+
+    int n = (rows ? rows : 1) * cols;
+    if (!q8) {
+        gw_put(g_data, &g_data_len, v, (size_t)n * 4);
+        return;
+    }
+    for (int b = 0; b < n; b += 32) {
+        float mx = 0.0f;
+        for (int i = 0; i < 32; i++) if (fabsf(v[b + i]) > mx) mx = fabsf(v[b + i]);
+        uint16_t dh = f32_to_f16(mx > 0.0f ? mx / 127.0f : 1e-3f);
+        float d = f16_to_f32(dh);
+        gw_put(g_data, &g_data_len, &dh, 2);
+        for (int i = 0; i < 32; i++) {
+            int q = (int)lrintf(v[b + i] / d);
+            if (q > 127) q = 127;
+            if (q < -127) q = -127;
+            int8_t qb = (int8_t)q;
+            gw_put(g_data, &g_data_len, &qb, 1);
+            v[b + i] = (float)q * d;
+        }
+    }
+}
+
+// Rows of several matrices stacked into one (llama.cpp fused tensors)
+static float g_fused[(T_DIM + 2 * T_KV_DIM > 2 * T_HID ? T_DIM + 2 * T_KV_DIM : 2 * T_HID) * T_DIM];
+
+static void gw_fused(const char *name, float *a, int ra, float *b, int rb, float *c, int rc, int q8) {
+    memcpy(g_fused, a, (size_t)ra * T_DIM * 4);
+    memcpy(g_fused + ra * T_DIM, b, (size_t)rb * T_DIM * 4);
+    if (c) memcpy(g_fused + (ra + rb) * T_DIM, c, (size_t)rc * T_DIM * 4);
+    gw_tensor(name, g_fused, ra + rb + rc, T_DIM, q8);
+    // the reference reads back what was stored
+    memcpy(a, g_fused, (size_t)ra * T_DIM * 4);
+    memcpy(b, g_fused + ra * T_DIM, (size_t)rb * T_DIM * 4);
+    if (c) memcpy(c, g_fused + (ra + rb) * T_DIM, (size_t)rc * T_DIM * 4);
+}
+
+static int gw_write(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    uint32_t version = 3;
+    fwrite("GGUF", 1, 4, f);
+    fwrite(&version, 4, 1, f);
+    fwrite(&g_n_tensors, 8, 1, f);
+    fwrite(&g_n_kv, 8, 1, f);
+    fwrite(g_kv, 1, g_kv_len, f);
+    fwrite(g_info, 1, g_info_len, f);
+    long pad = (32 - (ftell(f) % 32)) % 32;
+    for (long i = 0; i < pad; i++) fputc(0, f);
+    fwrite(g_data, 1, g_data_len, f);
+    fclose(f);
+    return 0;
+}
+
+static int write_model(const ArchCase *ac, int q8, int head_dim) {
+    char key[96];
+    gw_reset();
+    gw_kv_str("general.architecture", ac->arch);
+#define ARCH_KEY(suffix) (snprintf(key, sizeof(key), "%s.%s", ac->arch, suffix), key)
+    gw_kv_u32(ARCH_KEY("embedding_length"), T_DIM);
+    gw_kv_u32(ARCH_KEY("feed_forward_length"), T_HID);
+    gw_kv_u32(ARCH_KEY("block_count"), T_LAYERS);
+    gw_kv_u32(ARCH_KEY("attention.head_count"), T_HEADS);
+    gw_kv_u32(ARCH_KEY("attention.head_count_kv"), T_KV);
+    gw_kv_u32(ARCH_KEY("context_length"), T_SEQ);
+    gw_kv_f32(ARCH_KEY("attention.layer_norm_rms_epsilon"), (float)ac->eps);
+    gw_kv_f32(ARCH_KEY("rope.freq_base"), (float)ac->rope_base);
+    if (head_dim) gw_kv_u32(ARCH_KEY("attention.key_length"), (uint32_t)head_dim);
+    if (ac->window) gw_kv_u32(ARCH_KEY("attention.sliding_window"), (uint32_t)ac->window);
+#undef ARCH_KEY
+
+    static float norm_buf[T_DIM];
+    char name[64];
+    gw_tensor("token_embd.weight", &R.emb[0][0], T_VOCAB, T_DIM, q8);
+    for (int l = 0; l < T_LAYERS; l++) {
+        // gemma's converter stores 1 + w
+        for (int i = 0; i < T_DIM; i++) norm_buf[i] = R.attn_norm[l][i] + (ac->norm_plus_one ? 1.0f : 0.0f);
+        snprintf(name, sizeof(name), "blk.%d.attn_norm.weight", l);
+        gw_tensor(name, norm_buf, 0, T_DIM, 0);
+        if (ac->fused) {
+            snprintf(name, sizeof(name), "blk.%d.attn_qkv.weight", l);
+            gw_fused(name, &R.wq[l][0][0], T_DIM, &R.wk[l][0][0], T_KV_DIM, &R.wv[l][0][0], T_KV_DIM, q8);
+        } else {
+            snprintf(name, sizeof(name), "blk.%d.attn_q.weight", l);
+            gw_tensor(name, &R.wq[l][0][0], T_DIM, T_DIM, q8);
+            snprintf(name, sizeof(name), "blk.%d.attn_k.weight", l);
+            gw_tensor(name, &R.wk[l][0][0], T_KV_DIM, T_DIM, q8);
+            snprintf(name, sizeof(name), "blk.%d.attn_v.weight", l);
+            gw_tensor(name, &R.wv[l][0][0], T_KV_DIM, T_DIM, q8);
+        }
+        if (ac->bias) {
+            snprintf(name, sizeof(name), "blk.%d.attn_q.bias", l);
+            gw_tensor(name, R.bq[l], 0, T_DIM, 0);
+            snprintf(name, sizeof(name), "blk.%d.attn_k.bias", l);
+            gw_tensor(name, R.bk[l], 0, T_KV_DIM, 0);
+            snprintf(name, sizeof(name), "blk.%d.attn_v.bias", l);
+            gw_tensor(name, R.bv[l], 0, T_KV_DIM, 0);
+        }
+        snprintf(name, sizeof(name), "blk.%d.attn_output.weight", l);
+        gw_tensor(name, &R.wo[l][0][0], T_DIM, T_DIM, q8);
+        for (int i = 0; i < T_DIM; i++) norm_buf[i] = R.ffn_norm[l][i] + (ac->norm_plus_one ? 1.0f : 0.0f);
+        snprintf(name, sizeof(name), "blk.%d.ffn_norm.weight", l);
+        gw_tensor(name, norm_buf, 0, T_DIM, 0);
+        if (ac->fused) {
+            snprintf(name, sizeof(name), "blk.%d.ffn_up.weight", l);
+            gw_fused(name, &R.gate[l][0][0], T_HID, &R.up[l][0][0], T_HID, NULL, 0, q8);
+        } else {
+            snprintf(name, sizeof(name), "blk.%d.ffn_gate.weight", l);
+            gw_tensor(name, &R.gate[l][0][0], T_HID, T_DIM, q8);
+            snprintf(name, sizeof(name), "blk.%d.ffn_up.weight", l);
+            gw_tensor(name, &R.up[l][0][0], T_HID, T_DIM, q8);
+        }
+        snprintf(name, sizeof(name), "blk.%d.ffn_down.weight", l);
+        gw_tensor(name, &R.down[l][0][0], T_DIM, T_HID, q8);
+    }
+    for (int i = 0; i < T_DIM; i++) norm_buf[i] = R.out_norm[i] + (ac->norm_plus_one ? 1.0f : 0.0f);
+    gw_tensor("output_norm.weight", norm_buf, 0, T_DIM, 0);
+    if (!ac->tied) gw_tensor("output.weight", &R.out[0][0], T_VOCAB, T_DIM, q8);
+    return gw_write(k_gguf);
+}
+
+// <unk> <s> </s>, 256 byte tokens, filler pieces
+static int write_tokenizer(void) {
+    LlmkTestTok t = { T_VOCAB, 1, 0.0f, NULL, 0, 0, 0, "z%d" };
+    return llmk_test_write_tokenizer(k_tok, &t);
+}
+
+// ============================================================
+// Naive reference forward (double accumulators)
+// ============================================================
+static void ref_rmsnorm(double *o, const double *x, const float *w, const ArchCase *ac) {
+    double ss = 0;
+    for (int i = 0; i < T_DIM; i++) ss += x[i] * x[i];
+    ss = 1.0 / sqrt(ss / T_DIM + ac->eps);
+    for (int i = 0; i < T_DIM; i++) o[i] = ((ac->norm_plus_one ? 1.0 : 0.0) + w[i]) * ss * x[i];
+}
+
+static void ref_matvec(double *o, const double *x, const float *w, int n, int d) {
+    for (int i = 0; i < d; i++) {
+        double acc = 0;
+        for (int j = 0; j < n; j++) acc += (double)w[(size_t)i * n + j] * x[j];
+        o[i] = acc;
+    }
+}
+
+static void ref_rope(double *v, int n_heads, int pos, const ArchCase *ac) {
+    for (int h = 0; h < n_heads; h++) {
+        double *hv = v + h * T_HS;
+        for (int j = 0; j < T_HS / 2; j++) {
+            double a = pos * pow(ac->rope_base, -2.0 * j / T_HS), c = cos(a), s = sin(a);
+            int i0 = ac->neox ? j : 2 * j, i1 = ac->neox ? j + T_HS / 2 : 2 * j + 1;
+            double x0 = hv[i0], x1 = hv[i1];
+            hv[i0] = x0 * c - x1 * s;
+            hv[i1] = x0 * s + x1 * c;
+        }
+    }
+}
+
+static double ref_kc[T_LAYERS][T_SEQ][T_KV_DIM], ref_vc[T_LAYERS][T_SEQ][T_KV_DIM];
+
+static void ref_forward(const ArchCase *ac, int token, int pos, double *logits) {
+    const int kv_mul = T_HEADS / T_KV;
+    const int t0 = (ac->window && pos - ac->window + 1 > 0) ? pos - ac->window + 1 : 0;
+    double x[T_DIM], xb[T_DIM], xb2[T_DIM], q[T_DIM], hb[T_HID], hb2[T_HID], att[T_SEQ];
+    for (int i = 0; i < T_DIM; i++) x[i] = R.emb[token][i] * (ac->embed_sqrt ? sqrt((double)T_DIM) : 1.0);
+    for (int l = 0; l < T_LAYERS; l++) {
+        ref_rmsnorm(xb, x, R.attn_norm[l], ac);
+        ref_matvec(q, xb, &R.wq[l][0][0], T_DIM, T_DIM);
+        ref_matvec(ref_kc[l][pos], xb, &R.wk[l][0][0], T_DIM, T_KV_DIM);
+        ref_matvec(ref_vc[l][pos], xb, &R.wv[l][0][0], T_DIM, T_KV_DIM);
+        if (ac->bias) {
+            for (int i = 0; i < T_DIM; i++) q[i] += R.bq[l][i];
+            for (int i = 0; i < T_KV_DIM; i++) { ref_kc[l][pos][i] += R.bk[l][i]; ref_vc[l][pos][i] += R.bv[l][i]; }
+        }
+        ref_rope(q, T_HEADS, pos, ac);
+        ref_rope(ref_kc[l][pos], T_KV, pos, ac);
+        for (int h = 0; h < T_HEADS; h++) {
+            int kh = h / kv_mul;
+            double mx = -1e300, sum = 0;
+            for (int t = t0; t <= pos; t++) {
+                double s = 0;
+                for (int i = 0; i < T_HS; i++) s += q[h * T_HS + i] * ref_kc[l][t][kh * T_HS + i];
+                att[t] = s / sqrt((double)T_HS);
+                if (att[t] > mx) mx = att[t];
+            }
+            for (int t = t0; t <= pos; t++) { att[t] = exp(att[t] - mx); sum += att[t]; }
+            for (int i = 0; i < T_HS; i++) {
+                double acc = 0;
+                for (int t = t0; t <= pos; t++) acc += att[t] / sum * ref_vc[l][t][kh * T_HS + i];
+                xb[h * T_HS + i] = acc;
+            }
+        }
+        ref_matvec(xb2, xb, &R.wo[l][0][0], T_DIM, T_DIM);
+        for (int i = 0; i < T_DIM; i++) x[i] += xb2[i];
+        ref_rmsnorm(xb, x, R.ffn_norm[l], ac);
+        ref_matvec(hb, xb, &R.gate[l][0][0], T_DIM, T_HID);
+        ref_matvec(hb2, xb, &R.up[l][0][0], T_DIM, T_HID);
+        for (int i = 0; i < T_HID; i++) {
+            double g = hb[i];
+            g = ac->gelu ? 0.5 * g * (1.0 + tanh(sqrt(2.0 / M_PI) * (g + 0.044715 * g * g * g)))
+                         : g / (1.0 + exp(-g));
+            hb[i] = g * hb2[i];
+        }
+        ref_matvec(xb2, hb, &R.down[l][0][0], T_HID, T_DIM);
+        for (int i = 0; i < T_DIM; i++) x[i] += xb2[i];
+    }
+    ref_rmsnorm(xb, x, R.out_norm, ac);
+    ref_matvec(logits, xb, ac->tied ? &R.emb[0][0] : &R.out[0][0], T_DIM, T_VOCAB);
+}
+
+// Largest |engine - reference| over the first 6 positions, relative to max |logit|
+static double forward_vs_ref(const ArchCase *ac) {
+    static const int toks[6] = { 1, 262, 300 - 7, 45, 9, 128 };
+    double ref[T_VOCAB], worst = 0;
+    llmk_host_reset();
+    for (int p = 0; p < 6; p++) {
+        transformer_forward(&g_state, &g_weights, &g_config, toks[p], p);
+        ref_forward(ac, toks[p], p, ref);
+        double mag = 1e-6, err = 0;
+        for (int i = 0; i < T_VOCAB; i++) {
+            if (fabs(ref[i]) > mag) mag = fabs(ref[i]);
+            double e = fabs((double)g_state.logits[i] - ref[i]);
+            if (e > err) err = e;
+        }
+        if (err / mag > worst) worst = err / mag;
+    }
+    return worst;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+static const ArchCase k_llama   = { "llama",   0, 0, 0, 0, 0, 0,        0, 0, 1e-5, 10000.0 };
+static const ArchCase k_mistral = { "mistral", 0, 0, 0, 0, 0, T_WINDOW, 0, 0, 1e-5, 10000.0 };
+static const ArchCase k_qwen2   = { "qwen2",   1, 0, 1, 0, 1, 0,        0, 0, 1e-6, 1000000.0 };
+static const ArchCase k_phi3    = { "phi3",    1, 0, 0, 1, 0, T_WINDOW, 0, 0, 1e-5, 10000.0 };
+static const ArchCase k_gemma   = { "gemma",   1, 1, 0, 0, 1, 0,        1, 1, 1e-6, 10000.0 };
+
+static void run_case(const ArchCase *ac, int q8) {
+    char msg[128];
+    printf("\n=== %s%s ===\n", ac->arch, q8 ? " (q8_0 blob)" : "");
+    make_weights(ac);
+    ASSERT_TRUE(write_model(ac, q8, T_HS) == 0, "tiny GGUF written");
+    snprintf(msg, sizeof(msg), "%s: llmk_host_load", ac->arch);
+    ASSERT_EQ(llmk_host_load(k_gguf, k_tok, q8), 0, msg);
+    if (g_fmt != LLMK_HOST_FMT_GGUF) return;
+
+    ASSERT_TRUE(!strcmp(g_llmk_arch.name, ac->arch) && g_llmk_arch.sliding_window == ac->window &&
+                g_llmk_arch.qkv_bias == ac->bias && (g_llmk_arch.act == LLMK_ARCH_ACT_GELU_TANH) == ac->gelu &&
+                fabs(g_llmk_arch.norm_eps - ac->eps) < 1e-9,
+                "descriptor resolved: activation, eps, bias, window");
+    ASSERT_TRUE(g_llmk_rope.p.layout == (ac->neox ? LLMK_ROPE_NEOX : LLMK_ROPE_NORM),
+                "rope pair layout from the architecture");
+    ASSERT_TRUE((q8 ? g_weights.wcls_q8 == g_weights.token_embedding_table_q8
+                    : g_weights.wcls == g_weights.token_embedding_table) == ac->tied,
+                "classifier tied exactly when output.weight is absent");
+    ASSERT_EQ(g_weights.kind, q8 ? 1 : 0, q8 ? "loaded as Q8_0 blob" : "loaded as float32");
+
+    double e = forward_vs_ref(ac);
+    printf("  first 6 tokens: max rel err %.2e\n", e);
+    snprintf(msg, sizeof(msg), "%s: logits match the reference", ac->arch);
+    ASSERT_TRUE(e < 2e-2, msg);
+
+    if (ac->window) {
+        LlmkArch saved = g_llmk_arch;
+        g_llmk_arch.sliding_window = 0;
+        double e_full = forward_vs_ref(ac);
+        g_llmk_arch = saved;
+        printf("  full attention instead: max rel err %.2e\n", e_full);
+        ASSERT_TRUE(e_full > 10.0 * e, "dropping the sliding window moves the logits off the reference");
+    }
+}
+
+static void test_refusals(void) {
+    printf("\n=== refusals ===\n");
+    make_weights(&k_llama);
+    ASSERT_TRUE(write_model(&k_llama, 0, 2 * T_HS) == 0, "llama GGUF with key_length = 2 x dim / n_heads");
+    ASSERT_TRUE(llmk_host_load(k_gguf, k_tok, 0) < 0, "head_dim != dim / n_heads refused");
+
+    ArchCase no_bias = k_qwen2;
+    no_bias.bias = 0;
+    make_weights(&no_bias);
+    write_model(&no_bias, 0, T_HS);
+    ASSERT_TRUE(llmk_host_load(k_gguf, k_tok, 0) < 0, "qwen2 without attn_{q,k,v}.bias refused");
+
+    make_weights(&k_llama);
+    write_model(&k_llama, 0, 0);
+    ASSERT_EQ(llmk_host_load(k_gguf, k_tok, 0), 0, "reload after a refused file");
+    ASSERT_TRUE(llmk_arch_is_llama2(&g_llmk_arch) && !g_weights.bq, "llama resolves to the llama2.c block, no biases");
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_arch GGUF architecture tests\n");
+    printf("========================================\n");
+
+    ASSERT_TRUE(write_tokenizer() == 0, "tokenizer written");
+    run_case(&k_llama, 0);
+    run_case(&k_mistral, 0);
+    run_case(&k_qwen2, 0);
+    run_case(&k_phi3, 0);
+    run_case(&k_phi3, 1);
+    run_case(&k_gemma, 0);
+    test_refusals();
+
+    llmk_host_unload();
+    remove(k_gguf);
+    remove(k_tok);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_arch tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,350 @@
+// test_llmk_gen.c — Per-generation state (sampler, RNG, history, KV)
+//
+// Tests:
+//   sampler: llmk_sample on its own LlmkSampler draws exactly what
+//   sample_advanced draws from g_sample_seed, and two samplers with
+//   different seeds do not disturb each other
+//   sessions: two sessions with different settings (greedy with penalties
+//   and an n-gram ban, sampled with top-k/top-p) emit the same tokens run
+//   serially, interleaved step by step and on two threads, with f32 and
+//   int8 activations; a greedy session follows the argmax of
+//   transformer_forward on the shared state
+//   repl: llmk_host_generate turns are unchanged by sessions decoding in
+//   between, and sessions leave the REPL's cache position alone
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_gen
+//
+// Run:
+//   ../engine/host/test_llmk_gen
+
+#include "../engine/host/llmk_host_rt.c"
+
+#define LLMK_TEST_SEED 0x6A09E667u
+#include "llmk_test_model.h"
+
+#include <pthread.h>
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+// ============================================================
+// Sampler
+// ============================================================
+static void test_sampler(void) {
+    printf("\n=== sampler ===\n");
+    enum { V = 300, DRAWS = 200 };
+    static float logits[V], a[V], b[V];
+    int recent[32];
+    for (int i = 0; i < 32; i++) recent[i] = (int)(rnd() % V);
+
+    LlmkSampler sm;
+    memset(&sm, 0, sizeof(sm));
+    sm.seed = 987654321u;
+    g_sample_seed = 987654321u;
+    int same = 1;
+    for (int d = 0; d < DRAWS; d++) {
+        for (int i = 0; i < V; i++) logits[i] = rndf(4.0f);
+        const float temp = (d % 3 == 0) ? 0.0f : 0.6f + 0.1f * (float)(d % 5);
+        const int top_k = (d % 4) * 40;
+        const float top_p = (d % 2) ? 0.9f : 1.0f;
+        const float min_p = (d % 5 == 1) ? 0.05f : 0.0f;
+        memcpy(a, logits, sizeof(logits));
+        memcpy(b, logits, sizeof(logits));
+        int x = sample_advanced(a, V, temp, min_p, top_p, top_k, recent, 32, 1.1f);
+        int y = llmk_sample(&sm, b, V, temp, min_p, top_p, top_k, recent, 32, 1.1f);
+        same &= (x == y) && (g_sample_seed == sm.seed);
+    }
+    ASSERT_TRUE(same, "llmk_sample on a sampler == sample_advanced on g_sample_seed (tokens and RNG)");
+
+    // Two samplers interleaved draw what each draws alone
+    int ref_a[DRAWS], ref_b[DRAWS];
+    LlmkSampler s1 = { 11u }, s2 = { 22u };
+    for (int d = 0; d < DRAWS; d++) {
+        for (int i = 0; i < V; i++) a[i] = (float)((i * 7 + d) % 13) * 0.3f;
+        ref_a[d] = llmk_sample(&s1, a, V, 0.9f, 0.0f, 0.95f, 50, NULL, 0, 1.0f);
+    }
+    for (int d = 0; d < DRAWS; d++) {
+        for (int i = 0; i < V; i++) a[i] = (float)((i * 5 + d) % 11) * 0.4f;
+        ref_b[d] = llmk_sample(&s2, a, V, 1.2f, 0.02f, 1.0f, 0, NULL, 0, 1.0f);
+    }
+    LlmkSampler t1 = { 11u }, t2 = { 22u };
+    same = 1;
+    for (int d = 0; d < DRAWS; d++) {
+        for (int i = 0; i < V; i++) a[i] = (float)((i * 7 + d) % 13) * 0.3f;
+        same &= llmk_sample(&t1, a, V, 0.9f, 0.0f, 0.95f, 50, NULL, 0, 1.0f) == ref_a[d];
+        for (int i = 0; i < V; i++) a[i] = (float)((i * 5 + d) % 11) * 0.4f;
+        same &= llmk_sample(&t2, a, V, 1.2f, 0.02f, 1.0f, 0, NULL, 0, 1.0f) == ref_b[d];
+    }
+    ASSERT_TRUE(same, "interleaved samplers draw their serial sequences");
+    ASSERT_TRUE(t1.draws == DRAWS && t2.draws == DRAWS, "each sampler counts its own draws");
+}
+
+// ============================================================
+// Synthetic llama2.c model
+// ============================================================
+static int H_DIM = 64, H_HID = 160, H_LAYERS = 2, H_HEADS = 4, H_KV = 2, H_VOCAB = 288, H_SEQ = 256;
+static const char *k_model = "/tmp/test_llmk_gen_model.bin";
+static const char *k_tok = "/tmp/test_llmk_gen_tok.bin";
+
+static int write_model(void) {
+    LlmkTestModel m = { H_DIM, H_HID, H_LAYERS, H_HEADS, H_KV, H_VOCAB, H_SEQ, 1.0f, 0.3f, 0.2f, 0, 0 };
+    return llmk_test_write_model(k_model, &m);
+}
+
+// <unk> <s> </s>, printable ASCII, then filler pieces
+static int write_tokenizer(void) {
+    LlmkTestTok t = { H_VOCAB, 0, -1000.0f, NULL, 0, 0, 0, "#w%d#" };
+    return llmk_test_write_tokenizer(k_tok, &t);
+}
+
+// ============================================================
+// Sessions
+// ============================================================
+enum { N_STEPS = 96 };
+
+typedef struct {
+    LlmkHostGen g;
+    unsigned int seed;
+    const char *prompt;
+    int ids[N_STEPS];
+    int n;
+} Run;
+
+static LlmkHostSession *run_open(const Run *r) {
+    LlmkHostSession *s = llmk_host_session_open(&r->g, r->seed);
+    if (s && llmk_host_session_prefill(s, r->prompt) != 0) {
+        llmk_host_session_close(s);
+        return NULL;
+    }
+    return s;
+}
+
+static int run_serial(Run *r) {
+    LlmkHostSession *s = run_open(r);
+    if (!s) return -1;
+    r->n = 0;
+    while (r->n < N_STEPS) {
+        int t = llmk_host_session_step(s);
+        if (t < 0) break;
+        r->ids[r->n++] = t;
+    }
+    llmk_host_session_close(s);
+    return 0;
+}
+
+static int run_interleaved(Run *a, Run *b) {
+    LlmkHostSession *sa = run_open(a), *sb = run_open(b);
+    int rc = (sa && sb) ? 0 : -1;
+    int live_a = sa != NULL, live_b = sb != NULL;
+    a->n = b->n = 0;
+    while (live_a || live_b) {
+        if (live_a) {
+            int t = a->n < N_STEPS ? llmk_host_session_step(sa) : -1;
+            if (t < 0) live_a = 0;
+            else a->ids[a->n++] = t;
+        }
+        if (live_b) {
+            int t = b->n < N_STEPS ? llmk_host_session_step(sb) : -1;
+            if (t < 0) live_b = 0;
+            else b->ids[b->n++] = t;
+        }
+    }
+    llmk_host_session_close(sa);
+    llmk_host_session_close(sb);
+    return rc;
+}
+
+static void *run_thread(void *arg) {
+    run_serial((Run *)arg);
+    return NULL;
+}
+
+static int same_run(const Run *x, const Run *y) {
+    return x->n == y->n && memcmp(x->ids, y->ids, sizeof(int) * (size_t)x->n) == 0;
+}
+
+static void runs_init(Run *a, Run *b) {
+    memset(a, 0, sizeof(*a));
+    memset(b, 0, sizeof(*b));
+    llmk_host_gen_defaults(&a->g);
+    a->g.temperature = 0.0f;
+    a->g.repeat_penalty = 1.3f;
+    a->g.freq_penalty = 0.2f;
+    a->g.no_repeat_ngram = 3;
+    a->seed = 1;
+    a->prompt = "The quick brown fox";
+    llmk_host_gen_defaults(&b->g);
+    b->g.temperature = 0.9f;
+    b->g.top_k = 40;
+    b->g.top_p = 0.92f;
+    b->g.min_p = 0.0f;
+    b->g.repeat_penalty = 1.0f;
+    b->g.presence_penalty = 0.3f;
+    b->g.no_repeat_ngram = 0;
+    b->seed = 4242u;
+    b->prompt = "jumps over the lazy dog, jumps over";
+}
+
+static void sessions_case(const char *label) {
+    Run a, b, ia, ib, ta, tb;
+    char msg[160];
+    runs_init(&a, &b);
+    ia = a; ib = b; ta = a; tb = b;
+
+    int ok = run_serial(&a) == 0 && run_serial(&b) == 0;
+    snprintf(msg, sizeof(msg), "%s: serial runs decode (%d + %d tokens)", label, a.n, b.n);
+    ASSERT_TRUE(ok && a.n > 8 && b.n > 8, msg);
+    snprintf(msg, sizeof(msg), "%s: the two settings produce different text", label);
+    ASSERT_TRUE(!same_run(&a, &b), msg);
+
+    ASSERT_EQ(run_interleaved(&ia, &ib), 0, "interleaved sessions open");
+    snprintf(msg, sizeof(msg), "%s: interleaved greedy+penalties session == its serial run", label);
+    ASSERT_TRUE(same_run(&ia, &a), msg);
+    snprintf(msg, sizeof(msg), "%s: interleaved sampled session == its serial run", label);
+    ASSERT_TRUE(same_run(&ib, &b), msg);
+
+    pthread_t th_a, th_b;
+    ok = pthread_create(&th_a, NULL, run_thread, &ta) == 0;
+    ok &= pthread_create(&th_b, NULL, run_thread, &tb) == 0;
+    if (ok) {
+        pthread_join(th_a, NULL);
+        pthread_join(th_b, NULL);
+    }
+    snprintf(msg, sizeof(msg), "%s: sessions on two threads == their serial runs", label);
+    ASSERT_TRUE(ok && same_run(&ta, &a) && same_run(&tb, &b), msg);
+}
+
+// Greedy session vs argmax of transformer_forward on the shared state
+static void test_greedy_reference(void) {
+    Run r;
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+    memset(&r, 0, sizeof(r));
+    r.g = g;
+    r.g.temperature = 0.0f;
+    r.g.repeat_penalty = 1.0f;
+    r.g.freq_penalty = r.g.presence_penalty = 0.0f;
+    r.g.no_repeat_ngram = 0;
+    r.seed = 7;
+    r.prompt = "The lazy dog";
+    run_serial(&r);
+
+    int toks[64], n = 0;
+    encode((char *)r.prompt, toks, &n, 64, &g_tokenizer);
+    llmk_host_reset();
+    int pos = 0;
+    for (int i = 0; i < n; i++) transformer_forward(&g_state, &g_weights, &g_config, toks[i], pos++);
+    int same = r.n > 0;
+    for (int i = 0; i < r.n && same; i++) {
+        int best = 0;
+        for (int v = 1; v < g_config.vocab_size; v++) {
+            if (g_state.logits[v] > g_state.logits[best]) best = v;
+        }
+        same = best == r.ids[i];
+        transformer_forward(&g_state, &g_weights, &g_config, best, pos++);
+    }
+    llmk_host_reset();
+    ASSERT_TRUE(same, "greedy session follows the argmax of transformer_forward on the shared state");
+}
+
+static void test_sessions(void) {
+    printf("\n=== sessions ===\n");
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+    LlmkHostSession *s = llmk_host_session_open(&g, 1);
+    ASSERT_TRUE(s != NULL, "session opens");
+    ASSERT_EQ(llmk_host_session_step(s), -1, "step before prefill: -1");
+    llmk_host_session_close(s);
+
+    sessions_case("f32");
+    llmk_host_set_q8_act(1);
+    sessions_case("int8 act");
+    llmk_host_set_q8_act(0);
+    test_greedy_reference();
+}
+
+// ============================================================
+// REPL turns
+// ============================================================
+static void test_repl(void) {
+    printf("\n=== repl ===\n");
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+    g.echo = 0;
+    g.max_gen_tokens = 48;
+    LlmkHostTurn t1, t2;
+
+    llmk_host_reset();
+    llmk_host_set_seed(31337u, 0);
+    ASSERT_EQ(llmk_host_generate("The quick brown fox", &g, &t1), 0, "REPL turn decodes");
+    int ref[LLMK_HOST_MAX_TOKENS], n_ref = g_turn_n;
+    memcpy(ref, g_turn_ids, sizeof(int) * (size_t)n_ref);
+    const int pos_after = g_gen.pos;
+
+    llmk_host_reset();
+    llmk_host_set_seed(31337u, 0);
+    Run a, b;
+    runs_init(&a, &b);
+    LlmkHostSession *sa = run_open(&a);
+    LlmkHostSession *sb = run_open(&b);
+    for (int i = 0; i < 10; i++) {
+        llmk_host_session_step(sa);
+        llmk_host_session_step(sb);
+    }
+    ASSERT_EQ(g_gen.pos, 0, "sessions leave the REPL's cache position alone");
+    ASSERT_EQ(llmk_host_generate("The quick brown fox", &g, &t2), 0, "REPL turn decodes with sessions open");
+    for (int i = 0; i < 10; i++) llmk_host_session_step(sa);
+    llmk_host_session_close(sa);
+    llmk_host_session_close(sb);
+    ASSERT_TRUE(g_turn_n == n_ref && memcmp(ref, g_turn_ids, sizeof(int) * (size_t)n_ref) == 0 &&
+                g_gen.pos == pos_after, "REPL turn identical with sessions decoding around it");
+    llmk_host_reset();
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_gen generation state tests\n");
+    printf("========================================\n");
+
+    test_sampler();
+
+    printf("\n=== host runtime ===\n");
+    ASSERT_TRUE(write_model() == 0 && write_tokenizer() == 0, "llama2.c model (GQA) + tokenizer.bin written");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "model loads");
+    test_sessions();
+    test_repl();
+    llmk_host_unload();
+    ASSERT_TRUE(llmk_host_session_open(NULL, 1) == NULL, "no session without a model");
+    remove(k_model);
+    remove(k_tok);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_gen tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,905 @@
+// test_llmk_grammar.c — Grammar-constrained decoding (GBNF, JSON schema)
+//
+// Tests:
+//   parse: literals, classes, escapes, groups, * + ? {m,n}, comments and
+//   continuation lines match/reject as written; undefined rules, a missing
+//   root, left recursion and non-ASCII classes are errors with a line number
+//   json: the built-in grammar accepts random JSON objects and agrees with a
+//   reference validator on hand cases and random mutations
+//   schema: the converted grammar enforces property order, types, enums and
+//   array items
+//   mask: on random walks over a synthetic vocabulary the trie/cache mask
+//   equals a brute-force per-token check; EOS is allowed only when the
+//   grammar can stop
+//   generate: thousands of random-logit generations under the JSON grammar
+//   and under a schema are valid JSON (finished) or a valid prefix
+//   (truncated); mask cost per token and cache hit rate are reported
+//   host: llmk_host_set_grammar constrains a llama2.c model's output
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_grammar
+//
+// Run:
+//   ../engine/host/test_llmk_grammar
+
+#include "../engine/host/llmk_host_rt.c"
+
+#include "llmk_test_model.h"
+
+#include <math.h>
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1.0e6 + (double)ts.tv_nsec / 1.0e3;
+}
+
+static LlmkGrammar G;                   // ~100 KB: keep off the stack
+
+// Whole text accepted and complete
+static int matches(const LlmkGrammar *g, const char *s) {
+    static LlmkGrammarState st;
+    llmk_grammar_state_init(g, &st);
+    if (llmk_grammar_state_accept(g, &st, s, (int)strlen(s)) != LLMK_GRAMMAR_OK) return 0;
+    return llmk_grammar_state_can_end(&st);
+}
+
+// Text is a prefix of some sentence
+static int prefix_ok(const LlmkGrammar *g, const char *s, int n) {
+    static LlmkGrammarState st;
+    llmk_grammar_state_init(g, &st);
+    return llmk_grammar_state_accept(g, &st, s, n) == LLMK_GRAMMAR_OK;
+}
+
+static int parse(const char *text) {
+    return llmk_grammar_parse(&G, text, (int)strlen(text));
+}
+
+// ============================================================
+// Reference JSON validator (RFC 8259), with a prefix mode
+// ============================================================
+typedef struct {
+    const char *s;
+    int n, i;
+    int eof;                            // ran out of input (a valid prefix so far)
+    // Top-level object summary for the schema checks
+    int n_keys;
+    char keys[16][16];
+    char types[16];                     // s n o a t f z (null)
+    char item_types[64];
+    int n_items;
+} Jv;
+
+static int jv_more(Jv *j) {
+    if (j->i < j->n) return 1;
+    j->eof = 1;
+    return 0;
+}
+
+static void jv_ws(Jv *j) {
+    while (j->i < j->n && (j->s[j->i] == ' ' || j->s[j->i] == '\t' || j->s[j->i] == '\n' || j->s[j->i] == '\r')) j->i++;
+}
+
+static int jv_lit(Jv *j, const char *w) {
+    for (; *w; w++) {
+        if (!jv_more(j) || j->s[j->i] != *w) return 0;
+        j->i++;
+    }
+    return 1;
+}
+
+static int jv_digits(Jv *j) {
+    int n = 0;
+    while (j->i < j->n && j->s[j->i] >= '0' && j->s[j->i] <= '9') {
+        j->i++;
+        n++;
+    }
+    if (!n) jv_more(j);
+    return n > 0;
+}
+
+static int jv_string(Jv *j, char *out, int cap) {
+    int len = 0;
+    if (!jv_more(j) || j->s[j->i] != '"') return 0;
+    j->i++;
+    for (;;) {
+        if (!jv_more(j)) return 0;
+        unsigned char c = (unsigned char)j->s[j->i++];
+        if (c == '"') break;
+        if (c < 0x20) return 0;
+        if (c == '\\') {
+            if (!jv_more(j)) return 0;
+            c = (unsigned char)j->s[j->i++];
+            if (c == 'u') {
+                for (int k = 0; k < 4; k++) {
+                    if (!jv_more(j) || gr_hex(j->s[j->i]) < 0) return 0;
+                    j->i++;
+                }
+            } else if (!strchr("\"\\/bfnrt", c)) {
+                return 0;
+            }
+        }
+        if (out && len + 1 < cap) out[len++] = (char)c;
+    }
+    if (out) out[len] = 0;
+    return 1;
+}
+
+static int jv_value(Jv *j, int depth, char *type);
+
+static int jv_number(Jv *j) {
+    if (j->i < j->n && j->s[j->i] == '-') j->i++;
+    if (!jv_more(j)) return 0;
+    if (j->s[j->i] == '0') j->i++;
+    else if (!jv_digits(j)) return 0;
+    if (j->i < j->n && j->s[j->i] == '.') {
+        j->i++;
+        if (!jv_digits(j)) return 0;
+    }
+    if (j->i < j->n && (j->s[j->i] == 'e' || j->s[j->i] == 'E')) {
+        j->i++;
+        if (j->i < j->n && (j->s[j->i] == '+' || j->s[j->i] == '-')) j->i++;
+        if (!jv_digits(j)) return 0;
+    }
+    return 1;
+}
+
+static int jv_value(Jv *j, int depth, char *type) {
+    char t = 0;
+    jv_ws(j);
+    if (!jv_more(j)) return 0;
+    char c = j->s[j->i];
+    if (c == '{') {
+        t = 'o';
+        j->i++;
+        jv_ws(j);
+        if (!jv_more(j)) return 0;
+        if (j->s[j->i] == '}') {
+            j->i++;
+        } else {
+            for (;;) {
+                char key[16], vt = 0;
+                jv_ws(j);
+                if (!jv_string(j, key, (int)sizeof(key))) return 0;
+                jv_ws(j);
+                if (!jv_more(j) || j->s[j->i] != ':') return 0;
+                j->i++;
+                if (!jv_value(j, depth + 1, &vt)) return 0;
+                if (depth == 0 && j->n_keys < 16) {
+                    strcpy(j->keys[j->n_keys], key);
+                    j->types[j->n_keys++] = vt;
+                }
+                jv_ws(j);
+                if (!jv_more(j)) return 0;
+                if (j->s[j->i] == '}') {
+                    j->i++;
+                    break;
+                }
+                if (j->s[j->i] != ',') return 0;
+                j->i++;
+            }
+        }
+    } else if (c == '[') {
+        t = 'a';
+        j->i++;
+        jv_ws(j);
+        if (!jv_more(j)) return 0;
+        if (j->s[j->i] == ']') {
+            j->i++;
+        } else {
+            for (;;) {
+                char it = 0;
+                if (!jv_value(j, depth + 1, &it)) return 0;
+                if (depth == 1 && j->n_items < 64) j->item_types[j->n_items++] = it;
+                jv_ws(j);
+                if (!jv_more(j)) return 0;
+                if (j->s[j->i] == ']') {
+                    j->i++;
+                    break;
+                }
+                if (j->s[j->i] != ',') return 0;
+                j->i++;
+            }
+        }
+    } else if (c == '"') {
+        t = 's';
+        if (!jv_string(j, NULL, 0)) return 0;
+    } else if (c == 't') {
+        t = 't';
+        if (!jv_lit(j, "true")) return 0;
+    } else if (c == 'f') {
+        t = 'f';
+        if (!jv_lit(j, "false")) return 0;
+    } else if (c == 'n') {
+        t = 'z';
+        if (!jv_lit(j, "null")) return 0;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        int s = j->i;
+        if (!jv_number(j)) return 0;
+        t = 'i';
+        for (int k = s; k < j->i; k++) {
+            if (j->s[k] == '.' || j->s[k] == 'e' || j->s[k] == 'E') t = 'n';
+        }
+    } else {
+        return 0;
+    }
+    if (type) *type = t;
+    return 1;
+}
+
+// 1 valid object, 0 invalid; *prefix set when the text is a valid prefix
+static int jv_check(const char *s, int n, Jv *j, int *prefix) {
+    memset(j, 0, sizeof(*j));
+    j->s = s;
+    j->n = n;
+    char t = 0;
+    int ok = 0;
+    if (n > 0 && s[0] == '{' && jv_value(j, 0, &t)) {
+        jv_ws(j);
+        ok = (j->i == n);
+    } else if (n == 0) {
+        j->eof = 1;
+    }
+    if (prefix) *prefix = ok || (j->eof && (n == 0 || s[0] == '{'));
+    return ok;
+}
+
+// ============================================================
+// parse
+// ============================================================
+static void test_parse(void) {
+    printf("\n=== parse ===\n");
+    ASSERT_EQ(parse("root ::= \"ab\" [c-e]+ ( \"x\" | \"yz\" )?\n"), 0, "literal, class, +, group, ?");
+    ASSERT_TRUE(matches(&G, "abc") && matches(&G, "abcdex") && matches(&G, "abeyz"), "accepts abc, abcdex, abeyz");
+    ASSERT_TRUE(!matches(&G, "ab") && !matches(&G, "abcy") && !matches(&G, "abfx") && !matches(&G, "abcxx"),
+                "rejects ab, abcy, abfx, abcxx");
+    ASSERT_TRUE(prefix_ok(&G, "abcy", 4) && !prefix_ok(&G, "abcyy", 5), "abcy is a prefix, abcyy is not");
+
+    ASSERT_EQ(parse("root ::= [0-9]{2,3} \"-\" [a]{2} \"-\" \"x\"{1,} \"-\" [^a-z]*\n"), 0, "{m,n} {m} {m,} and negation");
+    ASSERT_TRUE(matches(&G, "12-aa-x-") && matches(&G, "123-aa-xxx-A\xC3\xA9!"), "bounds respected, negated class passes UTF-8");
+    ASSERT_TRUE(!matches(&G, "1-aa-x-") && !matches(&G, "1234-aa-x-") && !matches(&G, "12-a-x-") &&
+                !matches(&G, "12-aa--") && !matches(&G, "12-aa-x-b"), "out-of-bounds counts and class members rejected");
+
+    ASSERT_EQ(parse("# greeting grammar\n"
+                    "root  ::= greet name   # trailing comment\n"
+                    "greet ::= \"hi\" | \"hello\" |\n"
+                    "          \"\\x68ey\"\n"
+                    "name  ::= ( \" \" [A-Z] [a-z]* )\n"
+                    "          ?\n"), LLMK_GRAMMAR_ERR_SYNTAX, "newline ends a rule outside parentheses");
+    ASSERT_EQ(parse("# greeting grammar\n"
+                    "root  ::= greet name   # trailing comment\n"
+                    "greet ::= \"hi\" | \"hello\" |\n"
+                    "          \"\\x68ey\"\n"
+                    "name  ::= ( \" \"\n"
+                    "            [A-Z] [a-z]* )?\n"), 0, "comments, continuation after | and inside ( )");
+    ASSERT_TRUE(matches(&G, "hi") && matches(&G, "hey Ada") && matches(&G, "hello Bo") && !matches(&G, "hey ada"),
+                "alternatives, \\x escape, optional group");
+
+    ASSERT_EQ(parse("root ::= \"caf\\u00e9 \\\"q\\\"\" . [\\]\\-]\n"), 0, "\\u, escaped quote, '.', escaped ] and -");
+    ASSERT_TRUE(matches(&G, "caf\xC3\xA9 \"q\"\x01]") && matches(&G, "caf\xC3\xA9 \"q\"z-") &&
+                !matches(&G, "cafe \"q\"z-"), "\\u00e9 is two UTF-8 bytes");
+
+    ASSERT_EQ(parse("root ::= item\n"), LLMK_GRAMMAR_ERR_SYNTAX, "undefined rule");
+    ASSERT_TRUE(strstr(G.err, "undefined rule item") != NULL, "error names the rule");
+    ASSERT_EQ(parse("start ::= \"a\"\n"), LLMK_GRAMMAR_ERR_SYNTAX, "missing root");
+    ASSERT_EQ(parse("root ::= \"a\"\n\nroot ::= \"b\"\n"), LLMK_GRAMMAR_ERR_SYNTAX, "duplicate rule");
+    ASSERT_TRUE(!strncmp(G.err, "line 3:", 7), "error carries the line number");
+    ASSERT_EQ(parse("root ::= x \"a\"\nx ::= opt root\nopt ::= \"b\"?\n"), LLMK_GRAMMAR_ERR_SYNTAX,
+              "left recursion through a nullable prefix");
+    ASSERT_TRUE(strstr(G.err, "left recursion") != NULL, "left recursion reported");
+    ASSERT_EQ(parse("root ::= [\xC3\xA9]\n"), LLMK_GRAMMAR_ERR_SYNTAX, "non-ASCII class rejected (byte-level)");
+    ASSERT_EQ(parse("root ::= \"a\" :: \"b\"\n"), LLMK_GRAMMAR_ERR_SYNTAX, "stray characters rejected");
+    ASSERT_EQ(parse("root ::= \"a\"{3,2}\n"), LLMK_GRAMMAR_ERR_LIMIT, "inverted bounds rejected");
+    ASSERT_EQ(parse("root ::= \"a\" root | \"b\"\n"), 0, "right recursion is fine");
+    ASSERT_TRUE(matches(&G, "aaab") && !matches(&G, "aaa"), "right-recursive rule matches");
+}
+
+// ============================================================
+// JSON grammar vs the reference validator
+// ============================================================
+static int gen_json(char *out, int cap, int len, int depth);
+
+static int put(char *out, int cap, int len, const char *s) {
+    int n = (int)strlen(s);
+    if (len + n >= cap) return len;
+    memcpy(out + len, s, (size_t)n + 1);
+    return len + n;
+}
+
+static int gen_ws(char *out, int cap, int len) {
+    static const char *ws[] = { "", "", " ", "\n  ", "\n\t" };
+    return put(out, cap, len, ws[rnd() % 5]);
+}
+
+static int gen_string(char *out, int cap, int len) {
+    static const char *parts[] = { "a", "Z", " ", "\\n", "\\\"", "\\\\", "\\u00e9", "\xC3\xA9", "/", "\\/", "9" };
+    len = put(out, cap, len, "\"");
+    for (int k = (int)(rnd() % 5); k > 0; k--) len = put(out, cap, len, parts[rnd() % 11]);
+    len = put(out, cap, len, "\"");
+    return gen_ws(out, cap, len);
+}
+
+static int gen_value(char *out, int cap, int len, int depth) {
+    char num[48];
+    switch (rnd() % (depth < 4 ? 7 : 5)) {
+    case 0: return gen_string(out, cap, len);
+    case 1:
+        snprintf(num, sizeof(num), "%s%u", rnd() & 1 ? "-" : "", rnd() % 100000);
+        if (rnd() & 1) snprintf(num + strlen(num), 16, ".%u", rnd() % 1000);
+        if (rnd() % 3 == 0) snprintf(num + strlen(num), 16, "e%s%u", rnd() & 1 ? "+" : "", rnd() % 99);
+        len = put(out, cap, len, num);
+        return gen_ws(out, cap, len);
+    case 2: len = put(out, cap, len, rnd() & 1 ? "true" : "false"); return gen_ws(out, cap, len);
+    case 3: len = put(out, cap, len, "null"); return gen_ws(out, cap, len);
+    case 4: return gen_string(out, cap, len);
+    case 5: {
+        len = put(out, cap, len, "[");
+        len = gen_ws(out, cap, len);
+        int n = (int)(rnd() % 4);
+        for (int k = 0; k < n; k++) {
+            if (k) len = gen_ws(out, cap, put(out, cap, len, ","));
+            len = gen_value(out, cap, len, depth + 1);
+        }
+        len = put(out, cap, len, "]");
+        return gen_ws(out, cap, len);
+    }
+    default: return gen_json(out, cap, len, depth + 1);
+    }
+}
+
+static int gen_json(char *out, int cap, int len, int depth) {
+    len = gen_ws(out, cap, put(out, cap, len, "{"));
+    int n = (int)(rnd() % 4);
+    for (int k = 0; k < n; k++) {
+        if (k) len = gen_ws(out, cap, put(out, cap, len, ","));
+        len = gen_string(out, cap, len);
+        len = gen_ws(out, cap, put(out, cap, len, ":"));
+        len = gen_value(out, cap, len, depth + 1);
+    }
+    len = put(out, cap, len, "}");
+    return gen_ws(out, cap, len);
+}
+
+static void test_json(void) {
+    printf("\n=== json grammar ===\n");
+    ASSERT_EQ(parse(llmk_grammar_json_gbnf()), 0, "built-in JSON grammar parses");
+
+    static const char *good[] = {
+        "{}", "{ }", "{\"a\": 1}", "{\"a\":[1,-2.5e3,true,false,null,\"x\\u00e9\"]}",
+        "{\"k\": {\"n\": {}}, \"e\": []}\n", "{\"s\": \"caf\xC3\xA9 \\\"q\\\" \\\\ \\/\"}",
+        "{\"z\": 0, \"f\": 0.5, \"g\": -0e-7}",
+    };
+    static const char *bad[] = {
+        "", "[1]", "{\"a\" 1}", "{'a':1}", "{\"a\":01}", "{\"a\":1,}", "{\"a\":.5}", "{\"a\":tru}",
+        "{\"a\":\"\\x\"}", "{\"a\":\"\x01\"}", "{\"a\":1}}", "{\"a\":+1}", " {}",
+    };
+    int ok = 1;
+    for (unsigned k = 0; k < sizeof(good) / sizeof(good[0]); k++) {
+        Jv j;
+        if (!matches(&G, good[k]) || !jv_check(good[k], (int)strlen(good[k]), &j, NULL)) {
+            printf("    good case %u: grammar=%d\n", k, matches(&G, good[k]));
+            ok = 0;
+        }
+    }
+    ASSERT_TRUE(ok, "hand-written valid objects accepted by grammar and reference");
+    ok = 1;
+    for (unsigned k = 0; k < sizeof(bad) / sizeof(bad[0]); k++) {
+        Jv j;
+        if (matches(&G, bad[k]) || jv_check(bad[k], (int)strlen(bad[k]), &j, NULL)) {
+            printf("    bad case %u: grammar=%d\n", k, matches(&G, bad[k]));
+            ok = 0;
+        }
+    }
+    ASSERT_TRUE(ok, "hand-written invalid texts rejected by both");
+
+    char text[4096];
+    int all = 1, agree = 1, mutated_accepted = 0;
+    for (int it = 0; it < 2000; it++) {
+        int n = gen_json(text, (int)sizeof(text), 0, 0);
+        Jv j;
+        if (!matches(&G, text) || !jv_check(text, n, &j, NULL)) {
+            if (all) printf("    rejected: %s\n", text);
+            all = 0;
+        }
+        // Mutate one byte: whatever the grammar still accepts must be JSON
+        static const char alpha[] = "{}[],:\" \\0123456789.-+eEtrufalsn\x01";
+        int at = (int)(rnd() % (unsigned)n);
+        text[at] = alpha[rnd() % (sizeof(alpha) - 1)];
+        if (matches(&G, text)) {
+            mutated_accepted++;
+            if (!jv_check(text, n, &j, NULL)) {
+                if (agree) printf("    grammar accepts invalid: %s\n", text);
+                agree = 0;
+            }
+        }
+    }
+    ASSERT_TRUE(all, "2000 random JSON objects accepted by the grammar and the reference");
+    ASSERT_TRUE(agree && mutated_accepted > 0, "mutants the grammar accepts are all valid JSON");
+}
+
+// ============================================================
+// JSON schema
+// ============================================================
+static const char k_schema[] =
+    "{ \"type\": \"object\", \"properties\": {\n"
+    "    \"name\":  { \"type\": \"string\" },\n"
+    "    \"age\":   { \"type\": \"integer\" },\n"
+    "    \"tags\":  { \"type\": \"array\", \"items\": { \"type\": \"string\" } },\n"
+    "    \"ok\":    { \"type\": \"boolean\" },\n"
+    "    \"kind\":  { \"enum\": [\"cat\", \"dog\", 7] },\n"
+    "    \"score\": { \"type\": [\"number\", \"null\"] },\n"
+    "    \"pos\":   { \"type\": \"object\", \"properties\": { \"x\": { \"const\": 1 } } }\n"
+    "} }";
+
+// Finished schema output: keys in order, each with its type
+static int schema_ok(const Jv *j) {
+    static const char *keys[] = { "name", "age", "tags", "ok", "kind", "score", "pos" };
+    if (j->n_keys != 7) return 0;
+    for (int k = 0; k < 7; k++) {
+        if (strcmp(j->keys[k], keys[k])) return 0;
+    }
+    const char *t = j->types;
+    if (t[0] != 's' || t[1] != 'i' || t[2] != 'a' || (t[3] != 't' && t[3] != 'f') ||
+        (t[4] != 's' && t[4] != 'i') || (t[5] != 'n' && t[5] != 'i' && t[5] != 'z') || t[6] != 'o') return 0;
+    for (int k = 0; k < j->n_items; k++) {
+        if (j->item_types[k] != 's') return 0;
+    }
+    return 1;
+}
+
+static char g_gbnf[32768];
+
+static void test_schema(void) {
+    printf("\n=== json schema ===\n");
+    char err[96];
+    int n = llmk_grammar_from_json_schema(k_schema, (int)strlen(k_schema), g_gbnf, (int)sizeof(g_gbnf), err, 96);
+    ASSERT_TRUE(n > 0 && (int)strlen(g_gbnf) == n, "schema converts to GBNF");
+    ASSERT_EQ(parse(g_gbnf), 0, "converted grammar parses");
+    ASSERT_TRUE(matches(&G, "{\"name\": \"Ada\", \"age\": 36, \"tags\": [\"x\", \"y\"], \"ok\": true, "
+                            "\"kind\": \"dog\", \"score\": null, \"pos\": {\"x\": 1}}"), "conforming document accepted");
+    ASSERT_TRUE(matches(&G, "{\"name\":\"\",\"age\":-1,\"tags\":[],\"ok\":false,\"kind\":7,\"score\":2.5,\"pos\":{\"x\":1}}"),
+                "compact form, enum number, float score");
+    ASSERT_TRUE(!matches(&G, "{\"age\": 36, \"name\": \"Ada\", \"tags\": [], \"ok\": true, \"kind\": \"dog\", "
+                             "\"score\": null, \"pos\": {\"x\": 1}}"), "property order enforced");
+    ASSERT_TRUE(!matches(&G, "{\"name\": \"Ada\", \"age\": 3.5, \"tags\": [], \"ok\": true, \"kind\": \"dog\", "
+                             "\"score\": null, \"pos\": {\"x\": 1}}"), "integer rejects a fraction");
+    ASSERT_TRUE(!matches(&G, "{\"name\": \"Ada\", \"age\": 3, \"tags\": [1], \"ok\": true, \"kind\": \"dog\", "
+                             "\"score\": null, \"pos\": {\"x\": 1}}"), "array items typed");
+    ASSERT_TRUE(!matches(&G, "{\"name\": \"Ada\", \"age\": 3, \"tags\": [], \"ok\": true, \"kind\": \"cow\", "
+                             "\"score\": null, \"pos\": {\"x\": 1}}"), "enum enforced");
+    ASSERT_TRUE(!matches(&G, "{\"name\": \"Ada\", \"age\": 3, \"tags\": [], \"ok\": true, \"kind\": \"cat\", "
+                             "\"score\": null, \"pos\": {\"x\": 2}}"), "const enforced");
+
+    const char *arr = "{\"type\":\"array\",\"items\":{\"type\":\"array\",\"items\":{\"anyOf\":[{\"type\":\"integer\"},{\"type\":\"boolean\"}]}}}";
+    n = llmk_grammar_from_json_schema(arr, (int)strlen(arr), g_gbnf, (int)sizeof(g_gbnf), err, 96);
+    ASSERT_TRUE(n > 0 && parse(g_gbnf) == 0, "nested array schema with anyOf");
+    ASSERT_TRUE(matches(&G, "[[1, true], [], [false]]") && !matches(&G, "[[1, \"x\"]]") && !matches(&G, "[1]"),
+                "item rules nest");
+
+    ASSERT_TRUE(llmk_grammar_from_json_schema("{\"$ref\":\"#/x\"}", 14, g_gbnf, (int)sizeof(g_gbnf), err, 96) < 0 &&
+                strstr(err, "$ref"), "$ref reported as unsupported");
+    ASSERT_TRUE(llmk_grammar_from_json_schema("{\"type\":", 8, g_gbnf, (int)sizeof(g_gbnf), err, 96) < 0,
+                "malformed schema rejected");
+    ASSERT_TRUE(llmk_grammar_from_json_schema(k_schema, (int)strlen(k_schema), g_gbnf, 64, err, 96) < 0,
+                "small output buffer reported");
+}
+
+// ============================================================
+// Synthetic vocabulary: </s> stop, byte pieces, JSON-ish fragments
+// ============================================================
+enum { SV_MAX = 1200, SV_STOP = 2 };
+static char *sv_piece[SV_MAX];
+static int sv_n;
+
+static const char *k_fragments[] = {
+    "{\"", "\":", "\": ", "\", \"", "\",", "\"}", "\"]", "[\"", "true", "false", "null", "0.", "12", "345",
+    "-1", "e+", "E-", "\\n", "\\u00", "\\\"", "\\\\", " {", "}}", "]}", "[{", "}]", "{}", "[]", ",\n  ", "\n",
+    "name", "age", "tags", "ok", "kind", "score", "pos", "\"name\": \"", "\"age\": ", "\"x\": 1", "dog", "cat",
+    "\xC3\xA9", "ab", "cd", "hello", " world", ", ", ": ", "\": {", "\": [", "1}", "7,", "  ", "\t",
+};
+
+static void sv_add(const char *s) {
+    sv_piece[sv_n++] = strdup(s);
+}
+
+static void sv_build(void) {
+    static const char alpha[] = "{}[],:\"  abcdeknotsu0123456789.-eE\\";
+    char buf[16];
+    sv_n = 0;
+    sv_add("");                     // <unk>: no text, never allowed
+    sv_add("");                     // <s>
+    sv_add("</s>");                 // stop
+    for (int c = 0x20; c < 0x7F; c++) {
+        buf[0] = (char)c;
+        buf[1] = 0;
+        sv_add(buf);
+    }
+    for (unsigned k = 0; k < sizeof(k_fragments) / sizeof(k_fragments[0]); k++) sv_add(k_fragments[k]);
+    char big[80];
+    memset(big, 'a', sizeof(big));
+    big[LLMK_GRAMMAR_MAX_TOKEN + 1] = 0;
+    sv_add(big);                    // longer than the trie indexes
+    while (sv_n < SV_MAX) {
+        int len = 2 + (int)(rnd() % 5);
+        for (int k = 0; k < len; k++) buf[k] = alpha[rnd() % (sizeof(alpha) - 1)];
+        buf[len] = 0;
+        sv_add(buf);
+    }
+}
+
+static int sv_piece_fn(void *ctx, int id, char *out, int cap) {
+    (void)ctx;
+    if (id == SV_STOP) return 0;
+    int n = (int)strlen(sv_piece[id]);
+    if (n > cap) n = cap;
+    memcpy(out, sv_piece[id], (size_t)n);
+    return n;
+}
+
+static int sv_stop_fn(void *ctx, int id) {
+    (void)ctx;
+    return id == SV_STOP;
+}
+
+static LlmkGrammarRt R;
+static void *g_rt_mem;
+
+static void rt_setup(void) {
+    uint64_t bytes = llmk_grammar_rt_bytes(sv_n, sv_piece_fn, NULL);
+    free(g_rt_mem);
+    g_rt_mem = malloc((size_t)bytes);
+    llmk_grammar_rt_init(&R, g_rt_mem, bytes, sv_n, sv_piece_fn, sv_stop_fn, NULL);
+}
+
+// Brute force: token id can follow the current state
+static int ref_allowed(int id) {
+    static LlmkGrammarState st;
+    if (id == SV_STOP) return llmk_grammar_state_can_end(&R.cur);
+    int n = (int)strlen(sv_piece[id]);
+    if (n == 0 || n > LLMK_GRAMMAR_MAX_TOKEN) return 0;
+    gr_state_copy(&st, &R.cur);
+    return llmk_grammar_state_accept(R.g, &st, sv_piece[id], n) == LLMK_GRAMMAR_OK;
+}
+
+static float g_logits[SV_MAX];
+
+static float g_bias[SV_MAX];
+static double g_prob[SV_MAX];
+
+// Softmax sample over the logits the mask left in play
+static int sample_masked(const float *l, int n) {
+    float mx = LLMK_GRAMMAR_MASKED;
+    for (int i = 0; i < n; i++) mx = l[i] > mx ? l[i] : mx;
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        g_prob[i] = l[i] > LLMK_GRAMMAR_MASKED ? (double)expf(l[i] - mx) : 0.0;
+        sum += g_prob[i];
+    }
+    double r = (double)(rnd() & 0xFFFFFF) / 16777216.0 * sum;
+    int last = 0;
+    for (int i = 0; i < n; i++) {
+        if (g_prob[i] == 0.0) continue;
+        last = i;
+        r -= g_prob[i];
+        if (r <= 0) return i;
+    }
+    return last;
+}
+
+// Random logits: EOS favoured when allowed, brackets discouraged
+static void random_logits(void) {
+    for (int i = 0; i < sv_n; i++) g_logits[i] = rndf(2.0f) + g_bias[i];
+}
+
+static void test_mask(void) {
+    printf("\n=== mask vs brute force ===\n");
+    ASSERT_EQ(parse(llmk_grammar_json_gbnf()), 0, "JSON grammar");
+    rt_setup();
+    for (int i = 0; i < sv_n; i++) g_bias[i] = strpbrk(sv_piece[i], "{[") ? -1.5f : 0.0f;
+    g_bias[SV_STOP] = 6.0f;
+    ASSERT_TRUE(R.n_nodes > 1 && R.tok_off[0] < 0 && R.tok_off[SV_STOP] < 0 && R.tok_off[sv_n - 1] >= 0,
+                "trie built; empty and stop tokens are not in it");
+    llmk_grammar_rt_start(&R, &G);
+
+    int mismatches = 0, checks = 0, stop_ok = 1, long_never = 1;
+    for (int run = 0; run < 20; run++) {
+        llmk_grammar_rt_start(&R, &G);
+        for (int step = 0; step < 60; step++) {
+            random_logits();
+            int n_allowed = llmk_grammar_mask(&R, g_logits);
+            int count = 0;
+            for (int id = 0; id < sv_n; id++) {
+                int want = ref_allowed(id), got = llmk_grammar_allowed(&R, id);
+                count += got;
+                if (want != got) {
+                    if (mismatches < 3) printf("    token %d \"%s\": mask %d, brute %d\n", id, sv_piece[id], got, want);
+                    mismatches++;
+                }
+                if (!got && g_logits[id] != LLMK_GRAMMAR_MASKED) mismatches++;
+            }
+            long_never &= !llmk_grammar_allowed(&R, 3 + 95 + (int)(sizeof(k_fragments) / sizeof(k_fragments[0])));
+            checks++;
+            if (count != n_allowed) mismatches++;
+            if (llmk_grammar_allowed(&R, SV_STOP) != llmk_grammar_can_end(&R)) stop_ok = 0;
+            if (n_allowed == 0) break;
+            int next = sample_masked(g_logits, sv_n);
+            if (llmk_grammar_accept(&R, next) != LLMK_GRAMMAR_OK) mismatches++;
+            if (next == SV_STOP) break;
+        }
+    }
+    printf("    %d masks checked token by token (%llu cache hits)\n", checks, (unsigned long long)R.cache_hits);
+    ASSERT_EQ(mismatches, 0, "trie walk + cache equal the brute-force per-token check");
+    ASSERT_TRUE(stop_ok, "EOS allowed exactly when the grammar can stop");
+    ASSERT_TRUE(long_never, "tokens longer than LLMK_GRAMMAR_MAX_TOKEN never allowed");
+    ASSERT_TRUE(R.cache_hits > 0, "masks reused from the cache");
+
+    llmk_grammar_rt_start(&R, &G);
+    int open = 3 + ('{' - 0x20);
+    ASSERT_EQ(llmk_grammar_accept(&R, SV_STOP), LLMK_GRAMMAR_ERR_REJECT, "EOS rejected before any output");
+    ASSERT_EQ(llmk_grammar_accept(&R, 3 + ('a' - 0x20)), LLMK_GRAMMAR_ERR_REJECT, "'a' cannot start an object");
+    ASSERT_EQ(llmk_grammar_accept(&R, open), LLMK_GRAMMAR_OK, "'{' accepted");
+    ASSERT_EQ(llmk_grammar_accept(&R, 3 + ('}' - 0x20)), LLMK_GRAMMAR_OK, "'}' accepted");
+    ASSERT_TRUE(llmk_grammar_can_end(&R) && !llmk_grammar_must_end(&R), "{} can end (trailing ws still possible)");
+    ASSERT_EQ(parse("root ::= \"ok\"\n"), 0, "fixed-string grammar");
+    llmk_grammar_rt_start(&R, &G);
+    llmk_grammar_accept(&R, 3 + ('o' - 0x20));
+    llmk_grammar_accept(&R, 3 + ('k' - 0x20));
+    ASSERT_TRUE(llmk_grammar_must_end(&R), "must_end once nothing but EOS fits");
+    ASSERT_EQ(llmk_grammar_mask(&R, g_logits), 1, "only EOS left in the mask");
+}
+
+// ============================================================
+// Random constrained generation
+// ============================================================
+typedef struct {
+    int finished, truncated, dead, invalid, bad_schema;
+    long tokens;
+    double mask_us;
+} GenStats;
+
+static void generate_many(int runs, int max_tokens, int check_schema, GenStats *gs) {
+    static char text[8192];
+    memset(gs, 0, sizeof(*gs));
+    for (int run = 0; run < runs; run++) {
+        int len = 0, done = 0;
+        llmk_grammar_rt_start(&R, &G);
+        for (int step = 0; step < max_tokens; step++) {
+            random_logits();
+            double t0 = now_us();
+            int n_allowed = llmk_grammar_mask(&R, g_logits);
+            gs->mask_us += now_us() - t0;
+            gs->tokens++;
+            if (n_allowed == 0) {
+                done = 2;
+                break;
+            }
+            int next = sample_masked(g_logits, sv_n);
+            if (llmk_grammar_accept(&R, next) != LLMK_GRAMMAR_OK) {
+                gs->invalid++;
+                break;
+            }
+            if (next == SV_STOP) {
+                done = 1;
+                break;
+            }
+            int n = (int)strlen(sv_piece[next]);
+            if (len + n < (int)sizeof(text)) {
+                memcpy(text + len, sv_piece[next], (size_t)n);
+                len += n;
+            }
+        }
+        Jv j;
+        int prefix = 0;
+        int valid = jv_check(text, len, &j, &prefix);
+        if (done == 1) {
+            gs->finished++;
+            if (!valid) {
+                if (gs->invalid < 3) printf("    invalid: %.*s\n", len, text);
+                gs->invalid++;
+            } else if (check_schema && !schema_ok(&j)) {
+                if (gs->bad_schema < 3) printf("    off-schema: %.*s\n", len, text);
+                gs->bad_schema++;
+            }
+        } else {
+            if (done == 2) gs->dead++;
+            else gs->truncated++;
+            if (!prefix) {
+                if (gs->invalid < 3) printf("    bad prefix: %.*s\n", len, text);
+                gs->invalid++;
+            }
+        }
+    }
+}
+
+static void test_generate(void) {
+    printf("\n=== random constrained generation ===\n");
+    GenStats gs;
+    ASSERT_EQ(parse(llmk_grammar_json_gbnf()), 0, "JSON grammar");
+    llmk_grammar_rt_start(&R, &G);
+    R.masks = R.cache_hits = R.nodes_visited = 0;
+    generate_many(2000, 200, 0, &gs);
+    printf("    %d finished, %d truncated, %d stuck; %ld tokens, mask %.2f us/token, cache hit %.1f%%, "
+           "%.0f trie nodes/miss\n", gs.finished, gs.truncated, gs.dead, gs.tokens, gs.mask_us / (double)gs.tokens,
+           100.0 * (double)R.cache_hits / (double)R.masks,
+           (double)R.nodes_visited / (double)(R.masks - R.cache_hits));
+    ASSERT_EQ(gs.invalid, 0, "2000 JSON generations: every finished output parses, every truncated one is a prefix");
+    ASSERT_TRUE(gs.finished > 1500, "most generations reach EOS within 200 tokens");
+    ASSERT_TRUE(R.cache_hits * 2 > R.masks, "more than half of the masks come from the cache");
+
+    char err[96];
+    llmk_grammar_from_json_schema(k_schema, (int)strlen(k_schema), g_gbnf, (int)sizeof(g_gbnf), err, 96);
+    ASSERT_EQ(parse(g_gbnf), 0, "schema grammar");
+    llmk_grammar_rt_start(&R, &G);
+    R.masks = R.cache_hits = 0;
+    generate_many(800, 300, 1, &gs);
+    printf("    %d finished, %d truncated, %d stuck; mask %.2f us/token, cache hit %.1f%%\n", gs.finished,
+           gs.truncated, gs.dead, gs.mask_us / (double)gs.tokens, 100.0 * (double)R.cache_hits / (double)R.masks);
+    ASSERT_EQ(gs.invalid, 0, "800 schema generations are valid JSON (or valid prefixes)");
+    ASSERT_EQ(gs.bad_schema, 0, "finished schema outputs have the properties in order with their types");
+    ASSERT_TRUE(gs.finished > 600, "most schema generations finish");
+}
+
+// ============================================================
+// Through the host runtime: llama2.c model + tokenizer.bin
+// ============================================================
+enum { H_DIM = 32, H_HID = 64, H_LAYERS = 1, H_HEADS = 2, H_VOCAB = 320, H_SEQ = 256 };
+static const char *k_model = "/tmp/test_llmk_grammar_model.bin";
+static const char *k_tok = "/tmp/test_llmk_grammar_tok.bin";
+static const char *k_out = "/tmp/test_llmk_grammar_out.txt";
+static const char *k_gbnf = "/tmp/test_llmk_grammar.gbnf";
+
+static int write_model(void) {
+    LlmkTestModel m = { H_DIM, H_HID, H_LAYERS, H_HEADS, H_HEADS, H_VOCAB, H_SEQ, 1.0f, 0.2f, 0.2f, 0, 0 };
+    return llmk_test_write_model(k_model, &m);
+}
+
+// <unk> <s> </s>, 256 byte tokens, then JSON fragments
+static int write_tokenizer(void) {
+    LlmkTestTok t = { H_VOCAB, 1, -1000.0f, k_fragments, (int)(sizeof(k_fragments) / sizeof(k_fragments[0])), 0, 0.0f,
+                      "w%d" };
+    return llmk_test_write_tokenizer(k_tok, &t);
+}
+
+// One echoed turn, stdout captured into out
+static int host_turn(const char *prompt, LlmkHostGen *g, LlmkHostTurn *t, char *out, int cap) {
+    fflush(stdout);
+    int saved = dup(1);
+    FILE *f = fopen(k_out, "wb");
+    if (saved < 0 || !f) return -1;
+    dup2(fileno(f), 1);
+    g->echo = 1;
+    int rc = llmk_host_generate(prompt, g, t);
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+    fclose(f);
+    f = fopen(k_out, "rb");
+    int n = f ? (int)fread(out, 1, (size_t)cap - 1, f) : 0;
+    if (f) fclose(f);
+    out[n] = 0;
+    if (n > 0 && out[n - 1] == '\n') out[--n] = 0;       // llmk_host_generate's closing newline
+    return rc;
+}
+
+static void test_host(void) {
+    printf("\n=== host runtime ===\n");
+    ASSERT_TRUE(write_model() == 0 && write_tokenizer() == 0, "llama2.c model + tokenizer.bin written");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "model loads");
+
+    LlmkHostGen g;
+    LlmkHostTurn t;
+    char out[4096];
+    llmk_host_gen_defaults(&g);
+    g.chat_format = LLMK_HOST_CHAT_RAW;
+    g.stats = 0;
+    g.stop_on_you = 0;
+    g.max_gen_tokens = 200;
+    g.temperature = 1.0f;
+
+    ASSERT_EQ(llmk_host_set_grammar(LLMK_HOST_GRAMMAR_GBNF, "root ::= ("), -1, "bad grammar refused");
+    ASSERT_EQ(llmk_host_set_grammar(LLMK_HOST_GRAMMAR_JSON, NULL), 0, "JSON grammar on");
+    int valid = 0, prefix_only = 0, bad = 0;
+    for (int seed = 1; seed <= 12; seed++) {
+        llmk_host_set_seed((unsigned)seed, 0);
+        llmk_host_reset();
+        host_turn("Reply in JSON:", &g, &t, out, (int)sizeof(out));
+        Jv j;
+        int prefix = 0;
+        if (jv_check(out, (int)strlen(out), &j, &prefix)) valid++;
+        else if (prefix && strcmp(t.stop_reason, "eos/bos") && strcmp(t.stop_reason, "grammar")) prefix_only++;
+        else {
+            printf("    seed %d (%s): %s\n", seed, t.stop_reason, out);
+            bad++;
+        }
+    }
+    printf("    %d complete objects, %d cut at max_tokens\n", valid, prefix_only);
+    ASSERT_TRUE(bad == 0 && valid > 0, "every turn is a JSON object (or a prefix cut by max_tokens)");
+    ASSERT_TRUE(g_llmk_cls_full == 0, "full-classifier override restored after the turn");
+
+    FILE *f = fopen(k_gbnf, "wb");
+    fputs("# yes or no\nroot ::= \"yes\" | \"no\"\n", f);
+    fclose(f);
+    ASSERT_EQ(llmk_host_load_grammar(LLMK_HOST_GRAMMAR_GBNF, k_gbnf), 0, "GBNF file loaded");
+    int yn = 1;
+    for (int seed = 1; seed <= 6; seed++) {
+        llmk_host_set_seed((unsigned)seed, 0);
+        llmk_host_reset();
+        host_turn("Answer:", &g, &t, out, (int)sizeof(out));
+        yn &= (!strcmp(out, "yes") || !strcmp(out, "no")) && !strcmp(t.stop_reason, "grammar");
+    }
+    ASSERT_TRUE(yn, "output is exactly yes or no, ended by the grammar");
+
+    ASSERT_EQ(llmk_host_set_grammar(LLMK_HOST_GRAMMAR_SCHEMA, k_schema), 0, "schema grammar on");
+    g.max_gen_tokens = 256;
+    g.temperature = 0.0f;
+    llmk_host_reset();
+    host_turn("Describe:", &g, &t, out, (int)sizeof(out));
+    Jv j;
+    int prefix = 0;
+    ASSERT_TRUE(jv_check(out, (int)strlen(out), &j, &prefix) ? schema_ok(&j) : prefix,
+                "greedy schema turn is on-schema (or an on-schema prefix)");
+
+    ASSERT_EQ(llmk_host_set_grammar(LLMK_HOST_GRAMMAR_OFF, NULL), 0, "grammar off");
+    g.max_gen_tokens = 20;
+    g.temperature = 1.0f;
+    llmk_host_set_seed(3, 0);
+    llmk_host_reset();
+    host_turn("Answer:", &g, &t, out, (int)sizeof(out));
+    ASSERT_TRUE(!g_grammar_on && strcmp(t.stop_reason, "grammar"), "unconstrained turns are back to normal");
+
+    llmk_host_unload();
+    ASSERT_TRUE(g_grammar_mem == NULL && !g_grammar_on, "unload releases the grammar runtime");
+    remove(k_model);
+    remove(k_tok);
+    remove(k_out);
+    remove(k_gbnf);
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_grammar constrained decoding tests\n");
+    printf("========================================\n");
+
+    sv_build();
+    test_parse();
+    test_json();
+    test_schema();
+    test_mask();
+    test_generate();
+    test_host();
+
+    for (int i = 0; i < sv_n; i++) free(sv_piece[i]);
+    free(g_rt_mem);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_grammar tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
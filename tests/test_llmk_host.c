@@ -0,0 +1,481 @@
+// test_llmk_host.c — Host-mode harness for the Linux inference runtime
+//
+// Tests:
+//   efi shim: SPrint renders the gnu-efi format set (%d %lu %x %a %s %r,
+//   width, '0' and '-' flags) into UCS-2 with the size in bytes; the
+//   mmap-backed EFI_FILE_PROTOCOL clamps reads at EOF
+//   loader: synthetic llama2.c .bin is mapped zero-copy, the shared
+//   classifier is inferred from the file size, tokenizer.bin is parsed
+//   forward: logits for a 4-token sequence match a naive double reference
+//   (RoPE, GQA attention, SwiGLU, tied classifier) on the SSE2 and AVX2 paths
+//   rope: a --rope-base override reaches the tables; dropping the rotation
+//   moves the logits off the reference
+//   generate: seeded runs are reproducible, KV position carries across turns
+//   kv window: a turn past seq_len slides instead of clearing the cache;
+//   evicted spans carry the generated tokens as well as the prompt;
+//   teacher-forced NLL over 10 x seq_len tokens stays stable per window
+//   bench: /bench_case rows are one JSON object per line, ids sanitized
+//   shortlist: a .lksl built from the model round-trips through the file;
+//   greedy output with the shortlist (certify or fall back) matches the
+//   full classifier token for token
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test
+//
+// Run:
+//   ../engine/host/test_llmk_host
+
+#include "../engine/host/llmk_host_rt.c"
+
+#include "llmk_test_model.h"
+
+#include <math.h>
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static int u16_eq(const CHAR16 *a, const char *b) {
+    while (*a && *b && *a == (CHAR16)(unsigned char)*b) { a++; b++; }
+    return *a == 0 && *b == 0;
+}
+
+// ============================================================
+// Synthetic model: dim 64, 4 heads over 2 KV heads, tied classifier
+// ============================================================
+enum { T_DIM = 64, T_HID = 96, T_LAYERS = 2, T_HEADS = 4, T_KV = 2, T_VOCAB = 300, T_SEQ = 64 };
+#define T_KV_DIM (T_DIM * T_KV / T_HEADS)
+
+static const char *k_model = "/tmp/test_llmk_host_model.bin";
+static const char *k_tok = "/tmp/test_llmk_host_tok.bin";
+static const char *k_bench = "/tmp/test_llmk_host_bench.jsonl";
+
+static int write_model(void) {
+    LlmkTestModel m = { T_DIM, T_HID, T_LAYERS, T_HEADS, T_KV, T_VOCAB, T_SEQ, 0.8f, 0.15f, 0.15f, 0.1f, 0 };
+    return llmk_test_write_model(k_model, &m);
+}
+
+// <unk> <s> </s>, 256 byte tokens, then a few merges
+static int write_tokenizer(void) {
+    static const char *const words[] = { " the", " cat", " sat", " on", " mat", "Once", " upon", " a", " time",
+                                         "You", ":", "AI", "th", "he", "at", "on", "ca", "ma" };
+    LlmkTestTok t = { T_VOCAB, 1, 0.0f, words, (int)(sizeof(words) / sizeof(words[0])), 1, 0, "z%d" };
+    return llmk_test_write_tokenizer(k_tok, &t);
+}
+
+// ============================================================
+// Naive reference forward (double accumulators)
+// ============================================================
+static void ref_rmsnorm(double *o, const double *x, const float *w, int n) {
+    double ss = 0;
+    for (int i = 0; i < n; i++) ss += x[i] * x[i];
+    ss = 1.0 / sqrt(ss / n + 1e-5);
+    for (int i = 0; i < n; i++) o[i] = w[i] * ss * x[i];
+}
+
+static void ref_matvec(double *o, const double *x, const float *w, int n, int d) {
+    for (int i = 0; i < d; i++) {
+        double acc = 0;
+        for (int j = 0; j < n; j++) acc += (double)w[(size_t)i * n + j] * x[j];
+        o[i] = acc;
+    }
+}
+
+static double ref_kc[T_LAYERS][T_SEQ][T_KV_DIM], ref_vc[T_LAYERS][T_SEQ][T_KV_DIM];
+
+// Rotary embedding with libm angles; interleaved pairs, full head, no scaling
+static void ref_rope(double *v, int n_heads, int pos, double base) {
+    const int hs = T_DIM / T_HEADS;
+    for (int h = 0; h < n_heads; h++) {
+        for (int i = 0; i < hs; i += 2) {
+            double a = pos * pow(base, -(double)i / hs), c = cos(a), s = sin(a);
+            double x0 = v[h * hs + i], x1 = v[h * hs + i + 1];
+            v[h * hs + i] = x0 * c - x1 * s;
+            v[h * hs + i + 1] = x0 * s + x1 * c;
+        }
+    }
+}
+
+static double g_ref_rope_base = 10000.0;
+
+static void ref_forward(const TransformerWeights *w, int token, int pos, double *logits) {
+    const int hs = T_DIM / T_HEADS, kv_mul = T_HEADS / T_KV;
+    double x[T_DIM], xb[T_DIM], xb2[T_DIM], q[T_DIM], hb[T_HID], hb2[T_HID], att[T_SEQ];
+    for (int i = 0; i < T_DIM; i++) x[i] = w->token_embedding_table[token * T_DIM + i];
+    for (int l = 0; l < T_LAYERS; l++) {
+        ref_rmsnorm(xb, x, w->rms_att_weight + l * T_DIM, T_DIM);
+        ref_matvec(q, xb, w->wq + (size_t)l * T_DIM * T_DIM, T_DIM, T_DIM);
+        ref_matvec(ref_kc[l][pos], xb, w->wk + (size_t)l * T_DIM * T_KV_DIM, T_DIM, T_KV_DIM);
+        ref_matvec(ref_vc[l][pos], xb, w->wv + (size_t)l * T_DIM * T_KV_DIM, T_DIM, T_KV_DIM);
+        ref_rope(q, T_HEADS, pos, g_ref_rope_base);
+        ref_rope(ref_kc[l][pos], T_KV, pos, g_ref_rope_base);
+        for (int h = 0; h < T_HEADS; h++) {
+            int kh = h / kv_mul;
+            double mx = -1e300, sum = 0;
+            for (int t = 0; t <= pos; t++) {
+                double s = 0;
+                for (int i = 0; i < hs; i++) s += q[h * hs + i] * ref_kc[l][t][kh * hs + i];
+                att[t] = s / sqrt((double)hs);
+                if (att[t] > mx) mx = att[t];
+            }
+            for (int t = 0; t <= pos; t++) { att[t] = exp(att[t] - mx); sum += att[t]; }
+            for (int i = 0; i < hs; i++) {
+                double acc = 0;
+                for (int t = 0; t <= pos; t++) acc += att[t] / sum * ref_vc[l][t][kh * hs + i];
+                xb[h * hs + i] = acc;
+            }
+        }
+        ref_matvec(xb2, xb, w->wo + (size_t)l * T_DIM * T_DIM, T_DIM, T_DIM);
+        for (int i = 0; i < T_DIM; i++) x[i] += xb2[i];
+        ref_rmsnorm(xb, x, w->rms_ffn_weight + l * T_DIM, T_DIM);
+        ref_matvec(hb, xb, w->w1 + (size_t)l * T_DIM * T_HID, T_DIM, T_HID);
+        ref_matvec(hb2, xb, w->w3 + (size_t)l * T_DIM * T_HID, T_DIM, T_HID);
+        for (int i = 0; i < T_HID; i++) hb[i] = hb[i] / (1.0 + exp(-hb[i])) * hb2[i];
+        ref_matvec(xb2, hb, w->w2 + (size_t)l * T_HID * T_DIM, T_HID, T_DIM);
+        for (int i = 0; i < T_DIM; i++) x[i] += xb2[i];
+    }
+    ref_rmsnorm(xb, x, w->rms_final_weight, T_DIM);
+    ref_matvec(logits, xb, w->wcls, T_DIM, T_VOCAB);
+}
+
+// Largest |engine - reference| over 4 positions, relative to max |logit|
+static double forward_vs_ref(void) {
+    static const int toks[4] = { 1, 262, 300 - 7, 45 };
+    double ref[T_VOCAB], worst = 0;
+    llmk_host_reset();
+    for (int p = 0; p < 4; p++) {
+        transformer_forward(&g_state, &g_weights, &g_config, toks[p], p);
+        ref_forward(&g_weights, toks[p], p, ref);
+        double mag = 1e-6, err = 0;
+        for (int i = 0; i < T_VOCAB; i++) {
+            if (fabs(ref[i]) > mag) mag = fabs(ref[i]);
+            double e = fabs((double)g_state.logits[i] - ref[i]);
+            if (e > err) err = e;
+        }
+        if (err / mag > worst) worst = err / mag;
+    }
+    return worst;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+static void test_efi_shim(void) {
+    printf("\n=== efi shim ===\n");
+    CHAR16 buf[96];
+    SPrint(buf, sizeof(buf), L"%d|%5d|%-4d|%05x|%lu", -42, 7, 3, 0xbeef, (UINT64)1 << 40);
+    ASSERT_TRUE(u16_eq(buf, "-42|    7|3   |0beef|1099511627776"), "SPrint: %d, width, '-' and '0' flags, %lu");
+    SPrint(buf, sizeof(buf), L"%a/%s/%r/%c%%", "ascii", L"wide", EFI_NOT_FOUND, (CHAR16)'!');
+    ASSERT_TRUE(u16_eq(buf, "ascii/wide/Not Found/!%"), "SPrint: %a %s %r %c %%");
+    SPrint(buf, 8 * sizeof(CHAR16), L"0123456789");
+    ASSERT_TRUE(u16_eq(buf, "0123456"), "SPrint: size is in bytes and the result stays NUL-terminated");
+
+    static const UINT8 data[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    HostFile hf;
+    UINT8 out[16];
+    UINTN n = 4;
+    UINT64 pos = 0;
+    host_file_open_mem(&hf, data, sizeof(data));
+    EFI_FILE_HANDLE f = &hf.proto;
+    uefi_call_wrapper(f->SetPosition, 2, f, (UINT64)7);
+    EFI_STATUS st = uefi_call_wrapper(f->Read, 3, f, &n, out);
+    ASSERT_TRUE(!EFI_ERROR(st) && n == 3 && out[0] == 7 && out[2] == 9, "file: read past EOF is short, not an error");
+    uefi_call_wrapper(f->GetPosition, 2, f, &pos);
+    ASSERT_EQ((int)pos, 10, "file: position advanced to EOF");
+    n = 4;
+    uefi_call_wrapper(f->Read, 3, f, &n, out);
+    ASSERT_EQ((int)n, 0, "file: read at EOF returns 0 bytes");
+}
+
+static void test_loader(void) {
+    printf("\n=== loader ===\n");
+    ASSERT_TRUE(write_model() == 0 && write_tokenizer() == 0, "synthetic model and tokenizer written");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "llmk_host_load(.bin)");
+    ASSERT_EQ(llmk_host_format(), LLMK_HOST_FMT_BIN, "format detected as llama2.c .bin");
+    ASSERT_EQ(llmk_host_seq_len(), T_SEQ, "seq_len from the header");
+    ASSERT_TRUE((void *)g_weights.token_embedding_table == (UINT8 *)g_model_map.base + 28,
+                "weights point into the mapping (zero-copy)");
+    ASSERT_TRUE(g_weights.wcls == g_weights.token_embedding_table, "tied classifier inferred from the file size");
+    ASSERT_EQ(g_tokenizer.vocab_size, T_VOCAB, "tokenizer vocab matches the model");
+
+    int toks[16], n = 0;
+    encode((char *)"Once upon a time", toks, &n, 16, &g_tokenizer);
+    ASSERT_TRUE(n >= 2 && toks[0] == TOKEN_BOS, "encode prepends BOS");
+    char dec[8];
+    ASSERT_TRUE(llmk_decode_piece("<0x0A>", dec, 8) == 1 && dec[0] == '\n', "byte token <0x0A> decodes to a newline");
+    ASSERT_TRUE(llmk_host_load("/tmp/test_llmk_host_missing.bin", NULL, 0) < 0, "missing model file fails cleanly");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "reload after a failed load");
+}
+
+static void test_forward(void) {
+    printf("\n=== forward ===\n");
+    llmk_host_set_attn(0);
+    double e_sse = forward_vs_ref();
+    printf("  sse2 attention: max rel err %.2e\n", e_sse);
+    ASSERT_TRUE(e_sse < 2e-2, "SSE2 path matches the reference");
+    if (llmk_has_avx2_cached()) {
+        llmk_host_set_attn(1);
+        double e_avx = forward_vs_ref();
+        printf("  avx2 attention: max rel err %.2e\n", e_avx);
+        ASSERT_TRUE(e_avx < 2e-2, "AVX2 path matches the reference");
+    }
+    llmk_host_set_attn(-1);
+}
+
+static void test_rope(void) {
+    printf("\n=== rope ===\n");
+    ASSERT_TRUE(g_llmk_rope.ready && g_llmk_rope.p.layout == LLMK_ROPE_NORM &&
+                g_llmk_rope.p.n_rot == T_DIM / T_HEADS && g_llmk_rope.seq_len == T_SEQ,
+                ".bin gets llama2.c RoPE: interleaved, full head, tables for seq_len");
+    ASSERT_TRUE(llmk_host_set_rope(0.0f, "bogus", 0.0f, 0) < 0, "unknown scaling name refused");
+    ASSERT_EQ(llmk_host_set_rope(500.0f, NULL, 0.0f, 0), 0, "freq_base override accepted");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "reload with the override");
+    g_ref_rope_base = 500.0;
+    double e = forward_vs_ref();
+    printf("  base 500: max rel err %.2e\n", e);
+    ASSERT_TRUE(e < 2e-2, "override reaches the tables (matches a base-500 reference)");
+    g_llmk_rope.ready = 0;
+    double e_off = forward_vs_ref();
+    g_llmk_rope.ready = 1;
+    printf("  rotation off: max rel err %.2e\n", e_off);
+    ASSERT_TRUE(e_off > 10.0 * e, "without rotation the logits leave the reference");
+    g_ref_rope_base = 10000.0;
+    llmk_host_set_rope(0.0f, NULL, 0.0f, 0);
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "reload with the model's parameters");
+}
+
+static void test_generate(void) {
+    printf("\n=== generate ===\n");
+    LlmkHostGen g;
+    LlmkHostTurn t1, t2;
+    static float logits1[T_VOCAB];
+    llmk_host_gen_defaults(&g);
+    g.echo = 0;
+    g.stats = 0;
+    g.max_gen_tokens = 12;
+    g.stop_on_you = 0;
+
+    llmk_host_set_seed(99, 0);
+    llmk_host_reset();
+    ASSERT_EQ(llmk_host_generate("the cat", &g, &t1), 0, "first turn generates");
+    memcpy(logits1, g_state.logits, sizeof(logits1));
+    int kv_after = g_gen.pos;
+    ASSERT_TRUE(kv_after > t1.prompt_tokens, "KV position advanced past the prompt");
+
+    llmk_host_set_seed(99, 0);
+    llmk_host_reset();
+    llmk_host_generate("the cat", &g, &t2);
+    ASSERT_TRUE(t1.generated == t2.generated && g_gen.pos == kv_after &&
+                memcmp(logits1, g_state.logits, sizeof(logits1)) == 0,
+                "same seed: identical run (no TSC jitter by default)");
+
+    llmk_host_generate("on the mat", &g, &t2);
+    ASSERT_TRUE(g_gen.pos > kv_after, "second turn continues at the saved KV position");
+
+    g.max_gen_tokens = T_SEQ;
+    UINT32 resets = g_metrics.kv_cache_resets;
+    llmk_host_set_kv_window(0, -1, 0);
+    llmk_host_generate("a", &g, &t2);
+    ASSERT_EQ((int)(g_metrics.kv_cache_resets - resets), 1, "kv window off: turn that cannot fit clears the KV cache first");
+    ASSERT_TRUE(!strcmp(t2.stop_reason, "seq_len") || !strcmp(t2.stop_reason, "eos/bos"),
+                "long turn stops at seq_len (or EOS)");
+    llmk_host_set_kv_window(1, -1, 0);
+}
+
+// Evicted spans, as kv_fold_memory would see them
+static int32_t g_folded[16 * T_SEQ];
+static int g_n_folded;
+
+static void capture_fold(void *ctx, const int32_t *tokens, int n, int first_pos) {
+    (void)ctx; (void)first_pos;
+    for (int i = 0; i < n && g_n_folded < (int)(sizeof(g_folded) / sizeof(g_folded[0])); i++)
+        g_folded[g_n_folded++] = tokens[i];
+}
+
+static void test_kv_window(void) {
+    printf("\n=== kv window ===\n");
+    LlmkHostGen g;
+    LlmkHostTurn t;
+    llmk_host_gen_defaults(&g);
+    g.echo = 0;
+    g.stats = 0;
+    g.stop_on_you = 0;
+    g.no_repeat_ngram = 0;
+    g.repeat_penalty = 1.0f;
+    g.max_gen_tokens = 3 * T_SEQ;
+
+    llmk_host_set_seed(7, 0);
+    llmk_host_reset();
+    llmk_host_generate("the cat", &g, &t);
+    UINT32 resets = g_metrics.kv_cache_resets;
+    uint64_t shifts = g_llmk_kvw.shifts;
+    ASSERT_TRUE(llmk_host_generate("on the mat", &g, &t) == 0 && g_metrics.kv_cache_resets == resets,
+                "turn past seq_len runs without clearing the cache");
+    ASSERT_TRUE(g_llmk_kvw.shifts > shifts && g_gen.pos <= T_SEQ && strcmp(t.stop_reason, "seq_len") != 0,
+                "decode slides the window instead of stopping at seq_len");
+    ASSERT_TRUE(g_kvw_tok[0] == TOKEN_BOS, "BOS stays in the sink rows");
+
+    // A fold sees the generated tokens, not just the prompt
+    g_n_folded = 0;
+    g_llmk_kvw.on_evict = capture_fold;
+    llmk_host_generate("the cat", &g, &t);
+    g_llmk_kvw.on_evict = 0;
+    int unset = 0, found = 0;
+    for (int i = 0; i < g_n_folded; i++) unset += g_folded[i] < 0;
+    for (int i = 0; !found && g_turn_n >= 8 && i + 8 <= g_n_folded; i++)
+        found = memcmp(g_folded + i, g_turn_ids, 8 * sizeof(int32_t)) == 0;
+    ASSERT_TRUE(g_n_folded > 0 && unset == 0, "every evicted row carries its token");
+    ASSERT_TRUE(found, "folded text contains the generated tokens");
+
+    // Teacher-forced NLL of a fixed token stream, averaged per seq_len tokens
+    enum { SEGS = 10 };
+    double seg_nll[SEGS] = { 0 };
+    int token = TOKEN_BOS, pos = 0, finite = 1;
+    llmk_host_reset();
+    g_rng = 0x1234567u;
+    for (int n = 0; n < SEGS * T_SEQ; n++) {
+        if (pos >= T_SEQ) pos = host_kvw_slide(pos, 1);
+        if (pos < 0) { finite = 0; break; }
+        llmk_kvw_note(&g_llmk_kvw, pos, token);
+        transformer_forward(&g_state, &g_weights, &g_config, token, pos++);
+        int next = 3 + (int)(rnd() % (T_VOCAB - 3));
+        double mx = g_state.logits[0], sum = 0.0;
+        for (int i = 1; i < T_VOCAB; i++) if (g_state.logits[i] > mx) mx = g_state.logits[i];
+        for (int i = 0; i < T_VOCAB; i++) sum += exp(g_state.logits[i] - mx);
+        double nll = log(sum) - (g_state.logits[next] - mx);
+        if (!isfinite(nll)) finite = 0;
+        seg_nll[n / T_SEQ] += nll / T_SEQ;
+        token = next;
+    }
+    double lo = seg_nll[1], hi = seg_nll[1];
+    for (int i = 1; i < SEGS; i++) {
+        if (seg_nll[i] < lo) lo = seg_nll[i];
+        if (seg_nll[i] > hi) hi = seg_nll[i];
+    }
+    printf("  %d tokens in %d rows: NLL window 0 %.3f, later windows %.3f..%.3f, %lu shifts\n",
+           SEGS * T_SEQ, T_SEQ, seg_nll[0], lo, hi, (unsigned long)g_llmk_kvw.shifts);
+    ASSERT_TRUE(finite && pos > 0 && pos <= T_SEQ, "10 x seq_len tokens decoded at constant memory");
+    ASSERT_TRUE(hi - lo < 0.1 * seg_nll[0] && hi < 1.1 * seg_nll[0],
+                "per-window NLL stable after the cache first fills");
+    llmk_host_reset();
+}
+
+static void test_bench(void) {
+    printf("\n=== bench ===\n");
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+    g.echo = 0;
+    g.stats = 0;
+    g.max_gen_tokens = 6;
+
+    ASSERT_EQ(llmk_host_bench_begin(k_bench), 0, "bench_begin opens the capture file");
+    llmk_host_reset();
+    llmk_host_bench_case("c 1!", "qa", 6);
+    llmk_host_generate("the cat", &g, NULL);
+    llmk_host_reset();
+    llmk_host_bench_case("c2", "story", 6);
+    llmk_host_generate("Once upon", &g, NULL);
+    llmk_host_generate("no case armed", &g, NULL);
+    llmk_host_bench_end();
+    ASSERT_TRUE(!llmk_host_bench_active(), "bench_end closes the capture");
+
+    char line[512];
+    int rows = 0, ok = 1;
+    FILE *f = fopen(k_bench, "rb");
+    while (f && fgets(line, sizeof(line), f)) {
+        rows++;
+        if (line[0] != '{' || !strstr(line, "}\n") || !strstr(line, "\"decode_cycles\":") ||
+            !strstr(line, "\"generated_tokens\":")) ok = 0;
+        if (rows == 1 && strncmp(line, "{\"case_id\":\"c?1?\",\"category\":\"qa\",\"latency_ms\":", 47) != 0) ok = 0;
+    }
+    if (f) fclose(f);
+    ASSERT_EQ(rows, 2, "one row per armed case, none for a plain turn");
+    ASSERT_TRUE(ok, "rows match the UEFI JSONL layout; unsafe id bytes become '?'");
+    remove(k_bench);
+}
+
+static void test_shortlist(void) {
+    printf("\n=== shortlist ===\n");
+    static const char *k_sl = "/tmp/test_llmk_host.lksl";
+    LlmkHostGen g;
+    LlmkHostTurn t;
+    LlmkHostSlEval e;
+    static float ref[T_VOCAB];
+    llmk_host_gen_defaults(&g);
+    g.echo = 0;
+    g.stats = 0;
+    g.max_gen_tokens = 16;
+    g.stop_on_you = 0;
+    g.temperature = 0.0f;
+
+    llmk_host_reset();
+    llmk_host_generate("the cat", &g, &t);
+    memcpy(ref, g_state.logits, sizeof(ref));
+    int kv_ref = g_gen.pos;
+
+    ASSERT_EQ(llmk_host_shortlist_build(k_sl, 16, 4), 0, "build rank-16 shortlist from the classifier");
+    ASSERT_EQ(llmk_host_shortlist_load(k_sl, 32), 0, "load it back from the file");
+    ASSERT_TRUE(g_llmk_shortlist.enabled && g_llmk_shortlist.n_cand == 32, "enabled with k=32");
+
+    llmk_host_reset();
+    UINT64 calls = g_llmk_shortlist.calls;
+    llmk_host_generate("the cat", &g, &t);
+    ASSERT_TRUE(g_llmk_shortlist.calls > calls, "forward went through the shortlist");
+    ASSERT_TRUE(g_gen.pos == kv_ref && host_argmax(g_state.logits, T_VOCAB) == host_argmax(ref, T_VOCAB),
+                "greedy turn identical to the full classifier");
+
+    ASSERT_EQ(llmk_host_shortlist_eval("the cat", 16, &e), 0, "eval runs");
+    ASSERT_TRUE(e.steps == 16 && e.identical, "eval: verified greedy output identical");
+    ASSERT_TRUE(g_llmk_cls_full == 0 && g_llmk_shortlist.enabled, "eval restores the shortlist state");
+
+    llmk_host_shortlist_enable(0);
+    ASSERT_EQ(g_llmk_shortlist.enabled, 0, "/shortlist off");
+    remove(k_sl);
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_host runtime tests\n");
+    printf("========================================\n");
+
+    test_efi_shim();
+    test_loader();
+    test_forward();
+    test_rope();
+    test_generate();
+    test_kv_window();
+    test_bench();
+    test_shortlist();
+
+    llmk_host_unload();
+    remove(k_model);
+    remove(k_tok);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_host runtime tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
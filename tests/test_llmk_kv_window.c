@@ -0,0 +1,320 @@
+// test_llmk_kv_window.c — Sliding KV window with attention sinks
+//
+// Tests:
+//   room: rows that fit leave the cache alone; window off, need past
+//   seq_len − sinks, or a mismatched seq_len refuse (−1 → caller resets);
+//   sinks clamp to seq_len/2, discard resolves to (seq_len − sinks)/4
+//   shift: sinks untouched, kept K rows equal R(new pos)·k, V rows moved
+//   bit for bit, token log shifted and the evict callback sees the span
+//   scaling: NeoX + YaRN keys keep their magnitude through the re-rotation
+//   scores: q·k after a shift equals q·k before it (relative positions kept)
+//   stream: 10 × seq_len tokens through a cache of seq_len rows; every row
+//   stays R(row)·k of its token, error does not grow with the shifts
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_kv_window
+//
+// Run:
+//   ../engine/host/test_llmk_kv_window
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../engine/llama2/llmk_rope.c"
+#include "../engine/llama2/llmk_kv_window.c"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static float rndf(float scale) {
+    return ((float)(rnd() & 0xFFFF) / 32768.0f - 1.0f) * scale;
+}
+
+enum { W_LAYERS = 2, W_SEQ = 32, W_HEADS = 2, W_HS = 16, W_KV_DIM = W_HEADS * W_HS };
+
+// Synthetic cache: raw (unrotated) keys per token id, K = R(row)·raw[tok]
+typedef struct {
+    float    k[W_LAYERS * W_SEQ * W_KV_DIM];
+    float    v[W_LAYERS * W_SEQ * W_KV_DIM];
+    int32_t  tok[W_SEQ];
+    LlmkKvCache kv;
+    LlmkKvWindow w;
+    LlmkRope r;
+    void    *rope_mem;
+} Fixture;
+
+#define N_RAW 512
+static float g_raw_k[N_RAW][W_LAYERS][W_KV_DIM];
+static float g_raw_v[N_RAW][W_LAYERS][W_KV_DIM];
+
+static void raw_init(void) {
+    for (int t = 0; t < N_RAW; t++)
+        for (int l = 0; l < W_LAYERS; l++)
+            for (int i = 0; i < W_KV_DIM; i++) {
+                g_raw_k[t][l][i] = rndf(1.0f);
+                g_raw_v[t][l][i] = rndf(1.0f);
+            }
+}
+
+static int fixture_init(Fixture *f, int layout, int scaling) {
+    memset(f, 0, sizeof(*f));
+    LlmkRopeParams p;
+    llmk_rope_defaults(&p);
+    p.layout = layout;
+    p.scaling = scaling;
+    p.factor = 4.0f;
+    uint64_t bytes = llmk_rope_table_bytes(W_SEQ, W_HS);
+    f->rope_mem = aligned_alloc(16, (size_t)((bytes + 15) & ~(uint64_t)15));
+    if (!f->rope_mem || llmk_rope_init(&f->r, &p, W_HS, W_SEQ, f->rope_mem, bytes) != LLMK_ROPE_OK) return -1;
+    f->kv.key_cache = f->k;
+    f->kv.value_cache = f->v;
+    f->kv.n_layers = W_LAYERS;
+    f->kv.seq_len = W_SEQ;
+    f->kv.kv_dim = W_KV_DIM;
+    f->kv.n_kv_heads = W_HEADS;
+    llmk_kvw_init(&f->w, W_SEQ, f->tok);
+    return 0;
+}
+
+// What the forward pass does at pos: rotated key, plain value, token logged
+static void fixture_write(Fixture *f, int pos, int token) {
+    for (int l = 0; l < W_LAYERS; l++) {
+        float *kr = f->k + ((size_t)l * W_SEQ + pos) * W_KV_DIM;
+        float *vr = f->v + ((size_t)l * W_SEQ + pos) * W_KV_DIM;
+        llmk_rope_rotate(&f->r, kr, g_raw_k[token][l], W_HEADS, pos);
+        memcpy(vr, g_raw_v[token][l], sizeof(float) * W_KV_DIM);
+    }
+    llmk_kvw_note(&f->w, pos, token);
+}
+
+// Largest |K[row] − R(row)·raw[tok[row]]| over rows [0, n)
+static double fixture_k_err(const Fixture *f, int n) {
+    double e = 0.0;
+    float want[W_KV_DIM];
+    for (int l = 0; l < W_LAYERS; l++) {
+        for (int r = 0; r < n; r++) {
+            llmk_rope_rotate(&f->r, want, g_raw_k[f->tok[r]][l], W_HEADS, r);
+            const float *got = f->k + ((size_t)l * W_SEQ + r) * W_KV_DIM;
+            for (int i = 0; i < W_KV_DIM; i++) {
+                double d = fabs((double)got[i] - want[i]);
+                if (d > e) e = d;
+            }
+        }
+    }
+    return e;
+}
+
+static int g_ev_calls, g_ev_n, g_ev_first;
+static int32_t g_ev_tok[W_SEQ];
+static void on_evict(void *ctx, const int32_t *tokens, int n, int first_pos) {
+    (void)ctx;
+    g_ev_calls++;
+    g_ev_n = n;
+    g_ev_first = first_pos;
+    for (int i = 0; i < n && i < W_SEQ; i++) g_ev_tok[i] = tokens[i];
+}
+
+// ============================================================
+// Tests
+// ============================================================
+static void test_room(void) {
+    printf("\n=== room ===\n");
+    static Fixture f;
+    ASSERT_EQ(fixture_init(&f, LLMK_ROPE_NORM, LLMK_ROPE_SCALING_NONE), 0, "fixture");
+    for (int p = 0; p < 20; p++) fixture_write(&f, p, p);
+    ASSERT_EQ(llmk_kvw_make_room(&f.w, &f.kv, &f.r, 20, 12), 20, "rows that fit: position unchanged");
+    ASSERT_TRUE(f.w.shifts == 0 && f.tok[19] == 19, "rows that fit: nothing moved");
+    ASSERT_EQ(llmk_kvw_discard(&f.w), (W_SEQ - LLMK_KVW_DEFAULT_SINKS) / 4, "discard 0 resolves to a quarter of the window");
+    ASSERT_EQ(llmk_kvw_make_room(&f.w, &f.kv, &f.r, 20, W_SEQ - LLMK_KVW_DEFAULT_SINKS + 1), -1,
+              "need past seq_len - sinks refused");
+    f.w.enabled = 0;
+    ASSERT_EQ(llmk_kvw_make_room(&f.w, &f.kv, &f.r, W_SEQ, 1), -1, "window off refused (caller resets)");
+    f.w.enabled = 1;
+    f.w.seq_len = W_SEQ / 2;
+    ASSERT_EQ(llmk_kvw_make_room(&f.w, &f.kv, &f.r, W_SEQ, 1), -1, "window built for another seq_len refused");
+    f.w.seq_len = W_SEQ;
+    f.w.sinks = 1000;
+    ASSERT_EQ(llmk_kvw_discard(&f.w), (W_SEQ / 2) / 4, "sinks clamp to seq_len / 2");
+    f.w.sinks = LLMK_KVW_DEFAULT_SINKS;
+    f.w.discard = 1000;
+    ASSERT_EQ(llmk_kvw_discard(&f.w), W_SEQ - LLMK_KVW_DEFAULT_SINKS, "discard clamps to the window");
+    llmk_kvw_reset(&f.w);
+    ASSERT_TRUE(f.tok[0] == -1 && f.tok[19] == -1, "reset forgets the token log");
+    free(f.rope_mem);
+}
+
+static void test_shift(void) {
+    printf("\n=== shift ===\n");
+    static Fixture f;
+    static float k0[W_LAYERS * W_SEQ * W_KV_DIM], v0[W_LAYERS * W_SEQ * W_KV_DIM];
+    fixture_init(&f, LLMK_ROPE_NORM, LLMK_ROPE_SCALING_NONE);
+    for (int p = 0; p < W_SEQ; p++) fixture_write(&f, p, 100 + p);
+    memcpy(k0, f.k, sizeof(k0));
+    memcpy(v0, f.v, sizeof(v0));
+    f.w.on_evict = on_evict;
+    g_ev_calls = 0;
+
+    const int S = LLMK_KVW_DEFAULT_SINKS, d = (W_SEQ - S) / 4;
+    int np = llmk_kvw_make_room(&f.w, &f.kv, &f.r, W_SEQ, 1);
+    ASSERT_EQ(np, W_SEQ - d, "full cache: position drops by discard");
+    int sinks_same = 1, v_moved = 1;
+    for (int l = 0; l < W_LAYERS; l++) {
+        size_t b = (size_t)l * W_SEQ * W_KV_DIM;
+        if (memcmp(f.k + b, k0 + b, sizeof(float) * S * W_KV_DIM) ||
+            memcmp(f.v + b, v0 + b, sizeof(float) * S * W_KV_DIM)) sinks_same = 0;
+        if (memcmp(f.v + b + (size_t)S * W_KV_DIM, v0 + b + (size_t)(S + d) * W_KV_DIM,
+                   sizeof(float) * (size_t)(np - S) * W_KV_DIM)) v_moved = 0;
+    }
+    ASSERT_TRUE(sinks_same, "sink rows untouched (K and V)");
+    ASSERT_TRUE(v_moved, "kept V rows moved down by discard, bit for bit");
+    ASSERT_TRUE(f.tok[S] == 100 + S + d && f.tok[np - 1] == 100 + W_SEQ - 1 && f.tok[np] == -1,
+                "token log shifted, freed rows unknown");
+    double e = fixture_k_err(&f, np);
+    printf("  re-rotated K: max err %.2e\n", e);
+    ASSERT_TRUE(e < 1e-5, "kept K rows equal R(new row)·k");
+    ASSERT_TRUE(g_ev_calls == 1 && g_ev_n == d && g_ev_first == S && g_ev_tok[0] == 100 + S &&
+                g_ev_tok[d - 1] == 100 + S + d - 1, "evict callback gets the evicted span");
+    ASSERT_TRUE(f.w.shifts == 1 && f.w.evicted == (uint64_t)d, "stats count the shift");
+
+    // need larger than discard: evict enough for it
+    for (int p = np; p < W_SEQ; p++) fixture_write(&f, p, 200 + p);
+    int np2 = llmk_kvw_make_room(&f.w, &f.kv, &f.r, W_SEQ, 2 * d);
+    ASSERT_EQ(np2, W_SEQ - 2 * d, "need > discard evicts need rows");
+    ASSERT_TRUE(fixture_k_err(&f, np2) < 1e-5, "second shift still exact");
+
+    // no tables: rows move without re-rotation
+    for (int p = np2; p < W_SEQ; p++) fixture_write(&f, p, 300 + p);
+    memcpy(k0, f.k, sizeof(k0));
+    llmk_kvw_make_room(&f.w, &f.kv, NULL, W_SEQ, 1);
+    ASSERT_TRUE(!memcmp(f.k + (size_t)S * W_KV_DIM, k0 + (size_t)(S + d) * W_KV_DIM, sizeof(float) * W_KV_DIM),
+                "rope NULL: K rows moved as is");
+    free(f.rope_mem);
+}
+
+static void test_scaling(void) {
+    printf("\n=== scaling ===\n");
+    static Fixture f;
+    fixture_init(&f, LLMK_ROPE_NEOX, LLMK_ROPE_SCALING_YARN);
+    for (int p = 0; p < W_SEQ; p++) fixture_write(&f, p, p);
+    int np = llmk_kvw_make_room(&f.w, &f.kv, &f.r, W_SEQ, 1);
+    double e = fixture_k_err(&f, np);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "neox + yarn (mscale %.4f): shifted K = R(new row)·k, err %.2e", f.r.mscale, e);
+    ASSERT_TRUE(f.r.mscale > 1.0f && e < 1e-5, msg);
+
+    float x[W_KV_DIM], y[W_KV_DIM];
+    for (int i = 0; i < W_KV_DIM; i++) x[i] = y[i] = rndf(1.0f);
+    llmk_rope_shift(&f.r, y, W_HEADS, 5);
+    llmk_rope_shift(&f.r, y, W_HEADS, -5);
+    double ey = 0.0;
+    for (int i = 0; i < W_KV_DIM; i++) ey = fmax(ey, fabs((double)y[i] - x[i]));
+    ASSERT_TRUE(ey < 1e-6, "shift(+5) then shift(-5) is the identity");
+    free(f.rope_mem);
+}
+
+static void test_scores(void) {
+    printf("\n=== scores ===\n");
+    static Fixture f;
+    fixture_init(&f, LLMK_ROPE_NORM, LLMK_ROPE_SCALING_NONE);
+    for (int p = 0; p < W_SEQ; p++) fixture_write(&f, p, p);
+    float qraw[W_HS], q[W_HS];
+    for (int i = 0; i < W_HS; i++) qraw[i] = rndf(1.0f);
+    const int S = LLMK_KVW_DEFAULT_SINKS, d = llmk_kvw_discard(&f.w);
+    double before[W_SEQ], e = 0.0;
+    llmk_rope_rotate(&f.r, q, qraw, 1, W_SEQ - 1);
+    for (int r = S + d; r < W_SEQ; r++) {
+        double s = 0;
+        for (int i = 0; i < W_HS; i++) s += (double)q[i] * f.k[(size_t)r * W_KV_DIM + i];
+        before[r] = s;
+    }
+    int np = llmk_kvw_make_room(&f.w, &f.kv, &f.r, W_SEQ, 1);
+    llmk_rope_rotate(&f.r, q, qraw, 1, np - 1);
+    for (int r = S; r < np; r++) {
+        double s = 0;
+        for (int i = 0; i < W_HS; i++) s += (double)q[i] * f.k[(size_t)r * W_KV_DIM + i];
+        e = fmax(e, fabs(s - before[r + d]));
+    }
+    printf("  q·k drift: %.2e\n", e);
+    ASSERT_TRUE(e < 1e-4, "scores of kept rows unchanged by the shift");
+    free(f.rope_mem);
+}
+
+static void test_stream(void) {
+    printf("\n=== stream ===\n");
+    static Fixture f;
+    fixture_init(&f, LLMK_ROPE_NORM, LLMK_ROPE_SCALING_NONE);
+    int pos = 0, bad_pos = 0;
+    double worst = 0.0, first_seg = 0.0;
+    for (int t = 0; t < 10 * W_SEQ; t++) {
+        if (pos >= W_SEQ) {
+            pos = llmk_kvw_make_room(&f.w, &f.kv, &f.r, pos, 1);
+            if (pos < 0 || pos >= W_SEQ) { bad_pos = 1; break; }
+        }
+        fixture_write(&f, pos, t % N_RAW);
+        pos++;
+        if ((t + 1) % W_SEQ == 0) {
+            double e = fixture_k_err(&f, pos);
+            if (t + 1 == W_SEQ * 2) first_seg = e;
+            if (e > worst) worst = e;
+        }
+    }
+    printf("  %lu shifts, %lu rows evicted, K err after 2 windows %.2e, worst %.2e\n",
+           (unsigned long)f.w.shifts, (unsigned long)f.w.evicted, first_seg, worst);
+    ASSERT_TRUE(!bad_pos, "10 x seq_len tokens decoded in seq_len rows");
+    ASSERT_TRUE(f.w.evicted == (uint64_t)(10 * W_SEQ - pos), "every row evicted exactly once");
+    ASSERT_TRUE(f.tok[0] == 0 && f.tok[LLMK_KVW_DEFAULT_SINKS - 1] == LLMK_KVW_DEFAULT_SINKS - 1,
+                "sinks still hold the first tokens");
+    ASSERT_TRUE(f.tok[pos - 1] == (10 * W_SEQ - 1) % N_RAW, "newest token is the last row");
+    ASSERT_TRUE(worst < 2e-5, "re-rotation error stays bounded over repeated shifts");
+    free(f.rope_mem);
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_kv_window tests\n");
+    printf("========================================\n");
+
+    raw_init();
+    test_room();
+    test_shift();
+    test_scaling();
+    test_scores();
+    test_stream();
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_kv_window tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
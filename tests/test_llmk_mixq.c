@@ -0,0 +1,660 @@
+// test_llmk_mixq.c — Mixed-precision weights (.lkmx) and the budgeted planner
+//
+// Tests:
+//   formats: f32 → f16 rounds to nearest even and inverts llmk_mx_h2f on
+//   every finite half; Q8_0 / Q4_0 rows dequantize within a step
+//   kernels: llmk_mx_matmul in each format matches a dot product over the
+//   dequantized rows, AVX2 == scalar within rounding, row ranges == the
+//   full product, f32 tails stay inside the tensor (exact-size buffers)
+//   parse: images from llmk_mx_build parse; bad magic, counts, shapes,
+//   offsets, truncation and a shared classifier off the embedding do not
+//   plan: budget below the smallest plan fails, the full budget takes the
+//   best format everywhere, dominated formats are never picked and the
+//   total stays within the budget
+//   forward: an all-f32 plan gives the base logits bit for bit (shortlist
+//   rows and a vocab that is not a multiple of 4 included), an all-q8_0
+//   plan the logits of the same bytes loaded as kind 1
+//   lora: a plan with an adapter fused, or merged into the base weights,
+//   gives the adapter's logits (the plan adds the low-rank term itself)
+//   host: plan + write + load round trip, budget parsing, the Pareto
+//   ladder, generation with a plan (speculative drafts on and off), on an
+//   untied classifier as well
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_mixq
+//
+// Run:
+//   ../engine/host/test_llmk_mixq
+
+#include "../engine/host/llmk_host_rt.c"
+
+#define LLMK_TEST_SEED 0x9E3779B9u
+#include "llmk_test_model.h"
+
+#include <math.h>
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+// ============================================================
+// Formats
+// ============================================================
+static void test_formats(void) {
+    printf("\n=== formats ===\n");
+    int inv = 1;
+    for (uint32_t h = 0; h < 0x10000u; h++) {
+        if ((h & 0x7C00u) == 0x7C00u) continue;          // inf / NaN
+        float f = llmk_mx_h2f((uint16_t)h);
+        inv &= llmk_mx_f32_to_f16(f) == h && f == llmk_fp16_to_fp32((uint16_t)h);
+    }
+    ASSERT_TRUE(inv, "llmk_mx_h2f == llmk_fp16_to_fp32 and f32_to_f16 inverts it on all finite halves");
+    ASSERT_EQ(llmk_mx_f32_to_f16(1.0f + 1.0f / 2048.0f), 0x3C00, "tie rounds to even (down)");
+    ASSERT_EQ(llmk_mx_f32_to_f16(1.0f + 3.0f / 2048.0f), 0x3C02, "tie rounds to even (up)");
+    ASSERT_EQ(llmk_mx_f32_to_f16(1.0e6f), 0x7BFF, "saturates at 65504");
+    ASSERT_EQ(llmk_mx_f32_to_f16(-1.0e6f), 0xFBFF, "saturates at -65504");
+    ASSERT_EQ(llmk_mx_f32_to_f16(NAN), 0, "NaN becomes 0");
+    ASSERT_EQ(llmk_mx_f32_to_f16(1.0e-6f), 0x0011, "subnormal halves round to nearest");
+
+    enum { COLS = 256 };
+    float src[COLS], back[COLS];
+    uint8_t q[COLS * 4];
+    int q8_ok = 1, q4_ok = 1, f16_ok = 1;
+    for (int round = 0; round < 32; round++) {
+        const float scale = round == 0 ? 0.0f : (float)(1 << (round % 8)) * 0.01f;
+        for (int i = 0; i < COLS; i++) src[i] = rndf(scale);
+        for (uint32_t f = LLMK_MX_F16; f < LLMK_MX_N_FMT; f++) {
+            LlmkMxTensor t = { q, llmk_mx_row_bytes(f, COLS), f, 1, COLS };
+            llmk_mx_quantize_row(f, src, COLS, q);
+            llmk_mx_row(back, &t, 0);
+            for (int b = 0; b < COLS / 32; b++) {
+                float amax = 0.0f;
+                for (int j = 0; j < 32; j++) amax = fmaxf(amax, fabsf(src[b * 32 + j]));
+                for (int j = 0; j < 32; j++) {
+                    const float e = fabsf(back[b * 32 + j] - src[b * 32 + j]);
+                    if (f == LLMK_MX_F16) f16_ok &= e <= fabsf(src[b * 32 + j]) * (1.0f / 2048.0f) + 1e-7f;
+                    // + the f16 rounding of the scale times the largest code
+                    if (f == LLMK_MX_Q8_0) q8_ok &= e <= amax / 127.0f * 0.57f + 1e-7f;
+                    if (f == LLMK_MX_Q4_0) q4_ok &= e <= amax / 8.0f * 1.01f + 1e-7f;
+                }
+            }
+        }
+    }
+    ASSERT_TRUE(f16_ok, "f16 rows within half an ulp");
+    ASSERT_TRUE(q8_ok, "Q8_0 rows within half a step (amax / 127)");
+    ASSERT_TRUE(q4_ok, "Q4_0 rows within a step (amax / 8; -8..7 clips one end)");
+    ASSERT_EQ(llmk_mx_quantize_row(LLMK_MX_Q4_0, src, 48, q), -1, "Q4_0 rejects cols % 32 != 0");
+    ASSERT_TRUE(llmk_mx_row_bytes(LLMK_MX_Q8_0, 64) == 68 && llmk_mx_row_bytes(LLMK_MX_Q4_0, 64) == 36 &&
+                llmk_mx_row_bytes(LLMK_MX_F16, 10) == 20 && llmk_mx_row_bytes(7, 64) == 0,
+                "row sizes per format");
+}
+
+// ============================================================
+// Kernels
+// ============================================================
+
+// rows x cols random matrix in fmt, in a buffer of exactly its size
+static LlmkMxTensor make_tensor(uint32_t fmt, uint32_t rows, uint32_t cols, float *f32_out) {
+    LlmkMxTensor t = { NULL, llmk_mx_row_bytes(fmt, cols), fmt, rows, cols };
+    uint8_t *p = (uint8_t *)malloc((size_t)(t.row_bytes * rows));
+    for (uint32_t r = 0; r < rows; r++) {
+        float *row = f32_out + (size_t)r * cols;
+        for (uint32_t i = 0; i < cols; i++) row[i] = rndf(1.0f);
+        llmk_mx_quantize_row(fmt, row, cols, p + r * t.row_bytes);
+    }
+    t.data = p;
+    return t;
+}
+
+static void test_kernels(void) {
+    printf("\n=== kernels ===\n");
+    static const uint32_t shapes[][2] = { { 32, 1 }, { 64, 3 }, { 96, 7 }, { 256, 33 }, { 160, 64 } };
+    int ref_ok = 1, simd_ok = 1, range_ok = 1;
+    const int avx2 = llmk_has_avx2_cached();
+    for (unsigned s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        const uint32_t n = shapes[s][0], d = shapes[s][1];
+        float *w = (float *)malloc(sizeof(float) * n * d), *deq = (float *)malloc(sizeof(float) * n);
+        float x[256], got[64], ref[64], part[64];
+        for (uint32_t i = 0; i < n; i++) x[i] = rndf(1.0f);
+        for (uint32_t f = 0; f < LLMK_MX_N_FMT; f++) {
+            LlmkMxTensor t = make_tensor(f, d, n, w);
+            llmk_mx_matmul(got, x, &t, 0, d);
+            for (uint32_t r = 0; r < d; r++) {
+                llmk_mx_row(deq, &t, r);
+                double acc = 0.0, mag = 0.0;
+                for (uint32_t i = 0; i < n; i++) {
+                    acc += (double)deq[i] * x[i];
+                    mag += fabs((double)deq[i] * x[i]);
+                }
+                ref[r] = (float)acc;
+                ref_ok &= fabs((double)got[r] - acc) <= 1e-5 * mag + 1e-6;
+            }
+            if (f == LLMK_MX_F16 || f == LLMK_MX_Q4_0) {
+                if (f == LLMK_MX_F16) llmk_mx_matmul_f16_scalar(part, x, t.data, n, d);
+                else llmk_mx_matmul_q4_0_scalar(part, x, t.data, n, d);
+                for (uint32_t r = 0; r < d; r++) simd_ok &= fabsf(part[r] - got[r]) <= 1e-4f * (1.0f + fabsf(ref[r]));
+                if (avx2 && f == LLMK_MX_F16) llmk_mx_matmul_f16_avx2(part, x, t.data, n, d);
+                if (avx2 && f == LLMK_MX_Q4_0) llmk_mx_matmul_q4_0_avx2(part, x, t.data, n, d);
+                if (avx2) simd_ok &= memcmp(part, got, sizeof(float) * d) == 0;
+            }
+            // Ragged sub-ranges, ending at the last row of the tensor
+            for (uint32_t nr = 1; nr <= d && nr <= 6; nr++) {
+                const uint32_t r0 = d - nr;
+                llmk_mx_matmul(part, x, &t, r0, nr);
+                for (uint32_t r = 0; r < nr; r++) {
+                    const float want = got[r0 + r];
+                    if (f == LLMK_MX_F32 && nr < 4) range_ok &= fabsf(part[r] - want) <= 1e-5f * (1.0f + fabsf(want));
+                    else range_ok &= part[r] == want;
+                }
+            }
+            free((void *)t.data);
+        }
+        free(w);
+        free(deq);
+    }
+    ASSERT_TRUE(ref_ok, "f32 / f16 / q8_0 / q4_0 products == dot over the dequantized rows");
+    ASSERT_TRUE(simd_ok, avx2 ? "f16 / q4_0: dispatch == AVX2 kernel, scalar within rounding"
+                              : "f16 / q4_0: scalar kernels (no AVX2 on this CPU)");
+    ASSERT_TRUE(range_ok, "row ranges ending at the last row == the full product (no read past the tensor)");
+}
+
+// ============================================================
+// Parse
+// ============================================================
+static void ramp_row(void *ctx, uint32_t tensor, uint32_t row, float *out) {
+    const LlmkMixq *mx = (const LlmkMixq *)ctx;
+    uint32_t rows = 0, cols = 0;
+    llmk_mx_shape(mx, tensor, &rows, &cols);
+    for (uint32_t i = 0; i < cols; i++) out[i] = (float)((tensor * 7u + row * 3u + i) % 17u) * 0.125f - 1.0f;
+}
+
+static int build_image(uint32_t shared, const uint32_t *fmt, LlmkMixq *dims, void **buf, uint64_t *len) {
+    llmk_mx_init(dims, 64, 96, 2, 4, 2, 40, shared);
+    return llmk_mx_build(dims, fmt, ramp_row, dims, buf, len);
+}
+
+// Parses a copy of buf with `patch` bytes written at `at`; len may be cut
+static int parse_patched(const void *buf, uint64_t len, uint64_t at, const void *patch, size_t n) {
+    static LlmkMixq mx;
+    void *copy = NULL;
+    if (posix_memalign(&copy, 64, (size_t)len + 64) != 0) return -100;
+    memcpy(copy, buf, (size_t)len);
+    if (patch) memcpy((uint8_t *)copy + at, patch, n);
+    int rc = llmk_mx_parse(&mx, copy, len);
+    if (rc != LLMK_MX_OK && mx.n_tensors != 0) rc = -99;   // a failed parse leaves mx empty
+    free(copy);
+    return rc;
+}
+
+static void test_parse(void) {
+    printf("\n=== parse ===\n");
+    static LlmkMixq dims, mx;
+    uint32_t fmt[2 * LLMK_MX_ROLES + 2];
+    for (uint32_t i = 0; i < 2 * LLMK_MX_ROLES + 2; i++) fmt[i] = i % LLMK_MX_N_FMT;
+    void *buf = NULL;
+    uint64_t len = 0;
+    ASSERT_EQ(build_image(1, fmt, &dims, &buf, &len), 0, "shared-classifier image built");
+    ASSERT_EQ(llmk_mx_parse(&mx, buf, len), LLMK_MX_OK, "it parses");
+    const uint32_t tok = 2 * LLMK_MX_ROLES;
+    ASSERT_TRUE(mx.t[tok + 1].data == mx.t[tok].data && mx.t[tok + 1].fmt == fmt[tok],
+                "classifier aliases the embedding");
+    int rows_ok = 1;
+    float a[96], b[96];
+    for (uint32_t i = 0; i <= tok; i++) {               // the classifier is the embedding
+        for (uint32_t r = 0; r < mx.t[i].rows; r += 5) {
+            ramp_row(&dims, i, r, a);
+            llmk_mx_row(b, &mx.t[i], r);
+            for (uint32_t c = 0; c < mx.t[i].cols; c++) rows_ok &= fabsf(a[c] - b[c]) <= 0.13f;
+        }
+    }
+    ASSERT_TRUE(rows_ok, "every row reads back (within the format's step)");
+    uint64_t expect = 0;
+    for (uint32_t i = 0; i <= tok; i++) {
+        uint32_t rows = 0, cols = 0;
+        llmk_mx_shape(&dims, i, &rows, &cols);
+        expect += (uint64_t)rows * llmk_mx_row_bytes(fmt[i], cols);
+    }
+    ASSERT_TRUE(llmk_mx_bytes(&mx) == expect, "llmk_mx_bytes counts the shared classifier once");
+
+    const uint32_t bad_magic = 0x12345678u, bad_count = 5, bad_rows = 1;
+    const uint64_t bad_off = 64 + 8;
+    const uint64_t e0 = sizeof(LlmkMxHeader);
+    ASSERT_EQ(parse_patched(buf, len, 0, &bad_magic, 4), LLMK_MX_ERR_FORMAT, "bad magic rejected");
+    ASSERT_EQ(parse_patched(buf, len, offsetof(LlmkMxHeader, n_tensors), &bad_count, 4), LLMK_MX_ERR_SHAPE,
+              "tensor count that does not match the dimensions rejected");
+    ASSERT_EQ(parse_patched(buf, len, e0 + offsetof(LlmkMxEntry, rows), &bad_rows, 4), LLMK_MX_ERR_SHAPE,
+              "wrong tensor shape rejected");
+    ASSERT_EQ(parse_patched(buf, len, e0 + offsetof(LlmkMxEntry, offset), &bad_off, 8), LLMK_MX_ERR_FORMAT,
+              "unaligned tensor offset rejected");
+    ASSERT_EQ(parse_patched(buf, len - LLMK_MX_ALIGN, 0, NULL, 0), LLMK_MX_ERR_FORMAT, "truncated file rejected");
+    ASSERT_EQ(parse_patched(buf, 100, 0, NULL, 0), LLMK_MX_ERR_FORMAT, "truncated entry table rejected");
+    const uint64_t other = ((const LlmkMxEntry *)((const uint8_t *)buf + e0))[0].offset;
+    ASSERT_EQ(parse_patched(buf, len, e0 + (tok + 1) * sizeof(LlmkMxEntry) + offsetof(LlmkMxEntry, offset), &other, 8),
+              LLMK_MX_ERR_FORMAT, "shared classifier not at the embedding's bytes rejected");
+    free(buf);
+
+    ASSERT_EQ(build_image(0, fmt, &dims, &buf, &len), 0, "untied-classifier image built");
+    ASSERT_EQ(llmk_mx_parse(&mx, buf, len), LLMK_MX_OK, "it parses");
+    ASSERT_TRUE(mx.t[tok + 1].data != mx.t[tok].data && mx.t[tok + 1].fmt == fmt[tok + 1],
+                "classifier has its own tensor");
+    free(buf);
+    ASSERT_EQ(llmk_mx_init(&mx, 64, 96, 2, 3, 2, 40, 0), LLMK_MX_ERR_SHAPE, "heads not dividing dim rejected");
+}
+
+// ============================================================
+// Planner
+// ============================================================
+static double plan_err(const LlmkMxCost *c, const uint32_t *fmt, uint32_t n) {
+    double e = 0.0;
+    for (uint32_t i = 0; i < n; i++) e += c[i].err[fmt[i]];
+    return e;
+}
+
+static void test_plan(void) {
+    printf("\n=== plan ===\n");
+    enum { N = 24 };
+    LlmkMxCost c[N];
+    uint32_t fmt[N];
+    uint64_t s_min = 0, s_max = 0;
+    for (int i = 0; i < N; i++) {
+        const uint64_t cols = 32u * (1u + rnd() % 8u), rows = 16u + rnd() % 64u;
+        c[i].bytes[LLMK_MX_F32] = rows * cols * 4u;
+        c[i].bytes[LLMK_MX_F16] = rows * cols * 2u;
+        c[i].bytes[LLMK_MX_Q8_0] = rows * cols / 32u * 34u;
+        c[i].bytes[LLMK_MX_Q4_0] = rows * cols / 32u * 18u;
+        const double s = 0.001 * (1 + rnd() % 100);
+        c[i].err[LLMK_MX_F32] = 0.0;
+        c[i].err[LLMK_MX_F16] = s * 1e-4;
+        c[i].err[LLMK_MX_Q8_0] = s * 0.01 * (1 + rnd() % 4);
+        c[i].err[LLMK_MX_Q4_0] = s;
+        if (i % 5 == 0) c[i].err[LLMK_MX_F16] = c[i].err[LLMK_MX_Q4_0] * 2.0;   // dominated by q8_0
+        if (i % 7 == 3) c[i].bytes[LLMK_MX_Q4_0] = 0;                          // not allowed
+        s_min += c[i].bytes[LLMK_MX_Q4_0] ? c[i].bytes[LLMK_MX_Q4_0] : c[i].bytes[LLMK_MX_Q8_0];
+        s_max += c[i].bytes[LLMK_MX_F32];
+    }
+    ASSERT_TRUE(llmk_mx_plan(c, N, s_min - 1, fmt) == 0, "budget below the smallest plan fails");
+    ASSERT_TRUE(llmk_mx_plan(c, N, s_min, fmt) == s_min, "smallest budget: smallest allowed formats");
+    int smallest = 1;
+    for (int i = 0; i < N; i++) smallest &= fmt[i] == (c[i].bytes[LLMK_MX_Q4_0] ? LLMK_MX_Q4_0 : LLMK_MX_Q8_0);
+    ASSERT_TRUE(smallest, "q4_0 everywhere it is allowed, q8_0 elsewhere");
+    ASSERT_TRUE(llmk_mx_plan(c, N, s_max, fmt) == s_max, "f32 budget: every tensor f32");
+
+    int within = 1, dominated = 1, allowed = 1;
+    double first = 0.0, last = 0.0;
+    for (int k = 0; k <= 40; k++) {
+        const uint64_t budget = s_min + (s_max - s_min) * (uint64_t)k / 40u;
+        const uint64_t total = llmk_mx_plan(c, N, budget, fmt);
+        uint64_t sum = 0;
+        for (int i = 0; i < N; i++) {
+            sum += c[i].bytes[fmt[i]];
+            allowed &= c[i].bytes[fmt[i]] != 0;
+            if (i % 5 == 0) dominated &= fmt[i] != LLMK_MX_F16;
+        }
+        within &= total == sum && total <= budget;
+        last = plan_err(c, fmt, N);
+        if (k == 0) first = last;
+    }
+    ASSERT_TRUE(within && allowed, "plans stay within the budget, in allowed formats");
+    ASSERT_TRUE(dominated, "a format worse than a smaller one is never picked");
+    ASSERT_TRUE(last == 0.0 && first > 0.0, "error falls from the smallest plan to zero at f32");
+
+    // Two tensors, budget for one upgrade: the larger error drop per byte wins
+    LlmkMxCost two[2];
+    memset(two, 0, sizeof(two));
+    for (int i = 0; i < 2; i++) {
+        two[i].bytes[LLMK_MX_Q8_0] = 100;
+        two[i].bytes[LLMK_MX_Q4_0] = 60;
+        two[i].err[LLMK_MX_Q8_0] = 0.0;
+    }
+    two[0].err[LLMK_MX_Q4_0] = 0.5;
+    two[1].err[LLMK_MX_Q4_0] = 2.0;
+    uint32_t f2[2];
+    ASSERT_TRUE(llmk_mx_plan(two, 2, 160, f2) == 160 && f2[0] == LLMK_MX_Q4_0 && f2[1] == LLMK_MX_Q8_0,
+                "the upgrade that removes more error per byte is taken first");
+}
+
+// ============================================================
+// Synthetic llama2.c model
+// ============================================================
+static int H_DIM = 64, H_HID = 160, H_LAYERS = 2, H_HEADS = 4, H_KV = 2, H_VOCAB = 290, H_SEQ = 256;
+static const char *k_model = "/tmp/test_llmk_mixq_model.bin";
+static const char *k_tok = "/tmp/test_llmk_mixq_tok.bin";
+static const char *k_plan = "/tmp/test_llmk_mixq_plan.lkmx";
+
+// untied: the classifier follows freq_cis (llama2.c export without sharing)
+static int write_model(int untied) {
+    LlmkTestModel m = { H_DIM, H_HID, H_LAYERS, H_HEADS, H_KV, H_VOCAB, H_SEQ, 1.0f, 0.3f, 0.2f, 0, untied };
+    return llmk_test_write_model(k_model, &m);
+}
+
+// <unk> <s> </s>, printable ASCII, a few words, then filler pieces
+static const char *const k_words[] = { "The", " quick", " brown", " fox", " jumps", " over", " the", " lazy",
+                                       " dog", ". ", ", " };
+
+static int write_tokenizer(void) {
+    LlmkTestTok t = { H_VOCAB, 0, -1000.0f, k_words, (int)(sizeof(k_words) / sizeof(k_words[0])), 0, -1000.0f, "#w%d#" };
+    return llmk_test_write_tokenizer(k_tok, &t);
+}
+
+static const char *k_calib =
+    "The quick brown fox jumps over the lazy dog. A lazy dog sleeps, the fox runs over the hill. "
+    "Quick thinking, brown leaves, the dog and the fox. The end of the story is near, over and out.";
+
+// ============================================================
+// Forward equivalence
+// ============================================================
+enum { FWD_N = 24 };
+
+// Logits of FWD_N teacher-forced positions with weights w
+static void run_logits(TransformerWeights *w, float *out) {
+    const int V = g_config.vocab_size;
+    llmk_host_reset();
+    for (int p = 0; p < FWD_N; p++) {
+        transformer_forward(&g_state, w, &g_config, 3 + (p * 37) % (V - 3), p);
+        memcpy(out + (size_t)p * V, g_state.logits, sizeof(float) * (size_t)V);
+    }
+    llmk_host_reset();
+}
+
+// Kind-1 weights over the Q8_0 tensors of mx (same bytes, uniform path)
+static TransformerWeights kind1_from(const LlmkMixq *mx) {
+    TransformerWeights q = g_weights;
+    const uint32_t tok = mx->n_layers * LLMK_MX_ROLES;
+    q.mx = NULL;
+    q.kind = 1;
+    q.token_embedding_table_q8 = mx->t[tok].data;
+    q.wcls_q8 = mx->t[tok + 1].data;
+    q.wq_q8 = mx->t[LLMK_MX_WQ].data;
+    q.wk_q8 = mx->t[LLMK_MX_WK].data;
+    q.wv_q8 = mx->t[LLMK_MX_WV].data;
+    q.wo_q8 = mx->t[LLMK_MX_WO].data;
+    q.w1_q8 = mx->t[LLMK_MX_W1].data;
+    q.w2_q8 = mx->t[LLMK_MX_W2].data;
+    q.w3_q8 = mx->t[LLMK_MX_W3].data;
+    q.tok_embd_row_bytes = mx->t[tok].row_bytes;
+    // Layers of one role are not adjacent in an image: the stride between them is
+    q.wq_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_WQ].data - mx->t[LLMK_MX_WQ].data);
+    q.wk_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_WK].data - mx->t[LLMK_MX_WK].data);
+    q.wv_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_WV].data - mx->t[LLMK_MX_WV].data);
+    q.wo_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_WO].data - mx->t[LLMK_MX_WO].data);
+    q.w1_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_W1].data - mx->t[LLMK_MX_W1].data);
+    q.w2_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_W2].data - mx->t[LLMK_MX_W2].data);
+    q.w3_layer_bytes = (uint64_t)(mx->t[LLMK_MX_ROLES + LLMK_MX_W3].data - mx->t[LLMK_MX_W3].data);
+    return q;
+}
+
+static void test_forward(void) {
+    printf("\n=== forward ===\n");
+    const size_t V = (size_t)g_config.vocab_size;
+    const uint32_t n = (uint32_t)g_config.n_layers * LLMK_MX_ROLES + 2u;
+    const int shared = g_weights.wcls == g_weights.token_embedding_table;
+    float *base = (float *)malloc(sizeof(float) * V * FWD_N), *got = (float *)malloc(sizeof(float) * V * FWD_N);
+    uint32_t *fmt = (uint32_t *)calloc(n, sizeof(uint32_t));
+    LlmkMixq *mx = (LlmkMixq *)malloc(sizeof(*mx));
+    void *buf = NULL;
+    uint64_t len = 0;
+
+    run_logits(&g_weights, base);
+    ASSERT_EQ(host_mx_make(fmt, shared, mx, &buf, &len), 0, "all-f32 plan built");
+    TransformerWeights w = g_weights;
+    w.mx = mx;
+    run_logits(&w, got);
+    ASSERT_TRUE(memcmp(base, got, sizeof(float) * V * FWD_N) == 0, "all-f32 plan: logits == base, bit for bit");
+
+    ASSERT_EQ(llmk_host_shortlist_build(NULL, 8, 2), 0, "classifier shortlist built");
+    llmk_host_shortlist_set_k(32);
+    run_logits(&g_weights, base);
+    run_logits(&w, got);
+    ASSERT_TRUE(memcmp(base, got, sizeof(float) * V * FWD_N) == 0, "with the shortlist (single-row path) too");
+    llmk_host_shortlist_enable(0);
+    free(buf);
+
+    for (uint32_t i = 0; i < n; i++) fmt[i] = LLMK_MX_Q8_0;
+    ASSERT_EQ(host_mx_make(fmt, shared, mx, &buf, &len), 0, "all-q8_0 plan built");
+    TransformerWeights q = kind1_from(mx);
+    run_logits(&q, base);
+    run_logits(&w, got);
+    ASSERT_TRUE(memcmp(base, got, sizeof(float) * V * FWD_N) == 0,
+                "all-q8_0 plan: logits == kind-1 weights on the same bytes");
+    free(buf);
+
+    for (uint32_t i = 0; i < n; i++) fmt[i] = i % LLMK_MX_N_FMT;
+    fmt[n - 1] = fmt[n - 2];
+    ASSERT_EQ(host_mx_make(fmt, shared, mx, &buf, &len), 0, "plan mixing all four formats built");
+    run_logits(&g_weights, base);
+    run_logits(&w, got);
+    double d2 = 0.0, b2 = 0.0;
+    for (size_t i = 0; i < V * FWD_N; i++) {
+        d2 += (double)(got[i] - base[i]) * (got[i] - base[i]);
+        b2 += (double)base[i] * base[i];
+    }
+    printf("    four-format plan: logits rms error %.4f of rms\n", sqrt(d2 / b2));
+    ASSERT_TRUE(isfinite(d2) && sqrt(d2 / b2) < 0.25, "mixed plan: logits near f32");
+    free(buf);
+
+    free(base);
+    free(got);
+    free(fmt);
+    free(mx);
+}
+
+// ============================================================
+// Mixed precision + LoRA
+// ============================================================
+static float rel_rms(const float *a, const float *b, size_t n) {
+    double d2 = 0.0, b2 = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        d2 += (double)(a[i] - b[i]) * (a[i] - b[i]);
+        b2 += (double)b[i] * b[i];
+    }
+    return (float)sqrt(d2 / b2);
+}
+
+static void test_lora(void) {
+    printf("\n=== mixq + lora ===\n");
+    const size_t V = (size_t)g_config.vocab_size;
+    const int dim = g_config.dim, hd = g_config.hidden_dim, L = g_config.n_layers;
+    const int kv_dim = dim * g_config.n_kv_heads / g_config.n_heads;
+    const uint32_t n = (uint32_t)L * LLMK_MX_ROLES + 2u;
+    const int shared = g_weights.wcls == g_weights.token_embedding_table;
+    float *base = (float *)malloc(sizeof(float) * V * FWD_N), *ref = (float *)malloc(sizeof(float) * V * FWD_N);
+    float *got = (float *)malloc(sizeof(float) * V * FWD_N);
+    uint32_t *fmt = (uint32_t *)calloc(n, sizeof(uint32_t));
+    LlmkMixq *mx = (LlmkMixq *)malloc(sizeof(*mx));
+    oo_lora_state_t *st = (oo_lora_state_t *)malloc(sizeof(*st));
+    UINT64 lora_bytes = oo_lora_bytes((UINT32)L, (UINT32)dim, (UINT32)kv_dim, (UINT32)hd, 4);
+    void *lora_mem = malloc(lora_bytes);
+    void *buf = NULL;
+    uint64_t len = 0;
+
+    ASSERT_EQ(oo_lora_init(st, (UINT32)L, (UINT32)dim, (UINT32)kv_dim, (UINT32)hd, 4, lora_mem, lora_bytes), 0,
+              "rank-4 adapter on every projection");
+    for (int l = 0; l < L; l++) {
+        for (int pj = 0; pj < OO_LORA_NPROJ; pj++) {
+            oo_lora_adapter_t *a = &st->layers[l][pj];
+            for (UINT32 i = 0; i < a->out_dim * a->rank; i++) a->B[i] = rndf(0.2f);
+        }
+    }
+    run_logits(&g_weights, base);
+    g_host_lora = st;
+    run_logits(&g_weights, ref);
+    ASSERT_TRUE(rel_rms(ref, base, V * FWD_N) > 1e-3f, "fused adapter moves the logits");
+
+    ASSERT_EQ(host_mx_make(fmt, shared, mx, &buf, &len), 0, "all-f32 plan built");
+    TransformerWeights w = g_weights;
+    w.mx = mx;
+    run_logits(&w, got);
+    ASSERT_TRUE(rel_rms(got, ref, V * FWD_N) < 1e-4f, "plan + fused adapter: the adapter's logits");
+
+    // Merge into writable copies of the seven matrices: the plan still holds
+    // the unmerged base, so it has to add the low-rank term on its own
+    TransformerWeights m = g_weights;
+    float **mat[7] = { &m.wq, &m.wk, &m.wv, &m.wo, &m.w1, &m.w2, &m.w3 };
+    const size_t per[7] = { (size_t)dim * dim, (size_t)dim * kv_dim, (size_t)dim * kv_dim, (size_t)dim * dim,
+                            (size_t)dim * hd, (size_t)hd * dim, (size_t)dim * hd };
+    for (int i = 0; i < 7; i++) {
+        float *c = (float *)malloc(sizeof(float) * per[i] * (size_t)L);
+        memcpy(c, *mat[i], sizeof(float) * per[i] * (size_t)L);
+        *mat[i] = c;
+    }
+    oo_lora_model_t lm;
+    llmk_lora_model(&m, &g_config, &lm);
+    ASSERT_TRUE(oo_lora_merge(st, &lm) == 0 && st->merged, "adapter merged into the base weights");
+    run_logits(&m, got);
+    ASSERT_TRUE(rel_rms(got, ref, V * FWD_N) < 1e-4f, "merged adapter, no plan: the adapter's logits");
+    m.mx = mx;
+    run_logits(&m, got);
+    ASSERT_TRUE(rel_rms(got, ref, V * FWD_N) < 1e-4f, "plan + merged adapter: the adapter's logits");
+    free(buf);
+
+    for (uint32_t i = 0; i < n; i++) fmt[i] = LLMK_MX_Q8_0;
+    ASSERT_EQ(host_mx_make(fmt, shared, mx, &buf, &len), 0, "all-q8_0 plan built");
+    run_logits(&m, got);
+    float with = rel_rms(got, ref, V * FWD_N);
+    g_host_lora = NULL;
+    run_logits(&m, got);
+    printf("    all-q8_0 plan vs fused f32: rms error %.4f with the merged adapter, %.4f without\n",
+           with, rel_rms(got, ref, V * FWD_N));
+    ASSERT_TRUE(with < rel_rms(got, ref, V * FWD_N), "q8_0 plan + merged adapter: closer to the adapter's logits");
+    free(buf);
+
+    for (int i = 0; i < 7; i++) free(*mat[i]);
+    free(lora_mem);
+    free(st);
+    free(mx);
+    free(fmt);
+    free(got);
+    free(ref);
+    free(base);
+}
+
+// ============================================================
+// Host runtime
+// ============================================================
+static void test_host(int untied) {
+    printf("\n=== host (%s classifier) ===\n", untied ? "untied" : "tied");
+    LlmkHostMixqReport rep;
+    const int V = g_config.vocab_size;
+    float *a = (float *)malloc(sizeof(float) * (size_t)V * FWD_N);
+    float *b = (float *)malloc(sizeof(float) * (size_t)V * FWD_N);
+
+    ASSERT_TRUE(llmk_host_mixq_plan(NULL, k_calib, 48, "0.001%", 0, &rep) != 0 && g_weights.mx == NULL,
+                "budget below the smallest plan: error, nothing applied");
+    ASSERT_TRUE(llmk_host_mixq_plan(NULL, "", 48, NULL, 0, &rep) != 0, "empty calibration text: error");
+
+    ASSERT_EQ(llmk_host_mixq_plan(k_plan, k_calib, 48, "40%", 1, &rep), 0,
+              "plan at 40% of f32, with the Pareto ladder");
+    const int n_plan = H_LAYERS * LLMK_MX_ROLES + (untied ? 2 : 1);
+    ASSERT_EQ(rep.tensors, n_plan, "every matrix planned once");
+    ASSERT_TRUE(rep.bytes <= rep.budget && rep.budget == (uint64_t)((double)rep.bytes_f32 * 40.0 / 100.0),
+                "plan within the budget");
+    ASSERT_EQ(rep.n_fmt[0] + rep.n_fmt[1] + rep.n_fmt[2] + rep.n_fmt[3], n_plan, "format counts add up");
+    ASSERT_TRUE(rep.kl >= 0.0 && rep.est_kl >= 0.0 && rep.ppl > 1.0 && rep.ppl_f32 > 1.0, "KL and perplexity measured");
+    ASSERT_TRUE(g_weights.mx == &g_llmk_mixq && llmk_mx_bytes(&g_llmk_mixq) == rep.bytes, "the plan is applied");
+    ASSERT_EQ(rep.n_pareto, LLMK_HOST_MIXQ_PARETO, "Pareto ladder filled");
+    int ladder = 1;
+    for (int k = 1; k < rep.n_pareto; k++) ladder &= rep.pareto_bytes[k] >= rep.pareto_bytes[k - 1];
+    const int top = rep.n_pareto - 1;
+    ASSERT_TRUE(ladder && rep.pareto_bytes[top] <= rep.bytes_f32 && fabs(rep.pareto_kl[top]) < 1e-6,
+                "budgets grow; at the f32 budget the plan matches the f32 model");
+    ASSERT_TRUE(rep.pareto_kl[0] >= rep.pareto_kl[top], "smallest plan is the least accurate");
+
+    run_logits(&g_weights, a);
+    llmk_host_mixq_enable(0);
+    ASSERT_TRUE(g_weights.mx == NULL, "/mixq off");
+    ASSERT_EQ(llmk_host_mixq_load(k_plan), 0, "written plan loads");
+    run_logits(&g_weights, b);
+    ASSERT_TRUE(memcmp(a, b, sizeof(float) * (size_t)V * FWD_N) == 0, "loaded plan == planned one, bit for bit");
+
+    FILE *f = fopen(k_plan, "r+b");
+    const uint32_t junk = 0;
+    fseek(f, offsetof(LlmkMxHeader, dim), SEEK_SET);
+    fwrite(&junk, 4, 1, f);
+    fclose(f);
+    ASSERT_TRUE(llmk_host_mixq_load(k_plan) != 0 && g_weights.mx == &g_llmk_mixq,
+                "corrupt file rejected, the current plan kept");
+
+    LlmkHostGen g;
+    LlmkHostTurn t;
+    llmk_host_gen_defaults(&g);
+    g.chat_format = LLMK_HOST_CHAT_RAW;
+    g.stats = 0;
+    g.echo = 0;
+    g.temperature = 0.0f;
+    g.max_gen_tokens = 40;
+    int ids[LLMK_HOST_MAX_TOKENS], n_ids;
+    llmk_host_reset();
+    ASSERT_EQ(llmk_host_generate("The quick brown fox", &g, &t), 0, "generation with the plan");
+    n_ids = g_turn_n;
+    memcpy(ids, g_turn_ids, sizeof(int) * (size_t)n_ids);
+    llmk_host_set_spec(4);
+    llmk_host_reset();
+    llmk_host_generate("The quick brown fox", &g, &t);
+    llmk_host_set_spec(0);
+    ASSERT_TRUE(t.generated > 0 && g_turn_n == n_ids && memcmp(ids, g_turn_ids, sizeof(int) * (size_t)n_ids) == 0,
+                "speculative drafts (per-token verify under a plan) emit the same tokens");
+    llmk_host_reset();
+    llmk_host_mixq_print();
+    free(a);
+    free(b);
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_mixq mixed-precision tests\n");
+    printf("========================================\n");
+
+    test_formats();
+    test_kernels();
+    test_parse();
+    test_plan();
+
+    printf("\n=== host runtime ===\n");
+    ASSERT_TRUE(write_model(0) == 0 && write_tokenizer() == 0,
+                "llama2.c model (GQA, vocab 290) + tokenizer.bin written");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "model loads");
+    test_forward();
+    test_lora();
+    test_host(0);
+    llmk_host_unload();
+    ASSERT_TRUE(g_mx_file == NULL && g_llmk_mixq.n_tensors == 0, "unload releases the plan");
+
+    ASSERT_TRUE(write_model(1) == 0, "model with an untied classifier written");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "model loads");
+    ASSERT_TRUE(g_weights.wcls != g_weights.token_embedding_table, "classifier is untied");
+    test_forward();
+    test_host(1);
+    llmk_host_unload();
+
+    remove(k_model);
+    remove(k_tok);
+    remove(k_plan);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_mixq tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
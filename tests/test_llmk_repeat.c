@@ -0,0 +1,421 @@
+// test_llmk_repeat.c — Incremental repetition control
+//
+// Tests:
+//   ban: llmk_rep_ban bans exactly what apply_no_repeat_ngram's full scan
+//   bans, step by step, for n = 2..6 over repetitive random histories
+//   windows: n-gram and penalty windows match a scan of the last W / P
+//   tokens; counts match
+//   rollback: random appends, truncations and rewrites of the dropped tail
+//   leave the index identical to one built from scratch; back at length 0
+//   the table, node pool and counts are empty again
+//   penalize: repeat penalty over a 64-token window is bit-identical to
+//   sample_advanced's per-occurrence loop; frequency / presence subtract
+//   c * f + p
+//   configure: changing n or the windows mid-stream re-indexes correctly
+//   bench: per-token cost (append + ban + penalize) at 512 .. 8k history
+//   stays flat, the scans grow linearly
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_repeat
+//
+// Run:
+//   ../engine/host/test_llmk_repeat
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../engine/llama2/llmk_repeat.c"
+
+// llmk_sampler.c needs these from its includer
+static unsigned int g_sample_seed = 1234567;
+static inline unsigned int oo_quantum_mix(unsigned int s) { return s; }
+static inline float fast_exp(float x) { return expf(x); }
+#include "../engine/llama2/llmk_sampler.c"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Repetitive history: copies of earlier spans mixed with fresh tokens
+static int next_token(const int *hist, int n, int vocab) {
+    if (n > 8 && (rnd() & 3) == 0) {
+        int back = 1 + (int)(rnd() % (uint32_t)(n < 64 ? n : 64));
+        return hist[n - back];
+    }
+    return (int)(rnd() % (uint32_t)vocab);
+}
+
+typedef struct {
+    LlmkRepeat r;
+    void *mem;
+} Index;
+
+static int index_make(Index *x, int vocab, int max_grams, int ngram, int ngram_window, int pen_window) {
+    uint64_t bytes = llmk_rep_bytes(vocab, max_grams);
+    x->mem = malloc((size_t)bytes);
+    return x->mem ? llmk_rep_init(&x->r, x->mem, bytes, vocab, max_grams, ngram, ngram_window, pen_window) : -1;
+}
+
+// Reference: ban set from a scan of the n-grams ending in the last `window`
+// tokens (0 = all), as apply_no_repeat_ngram does for window 0
+static void scan_ban(const int *hist, int n, int ngram, int window, int vocab, unsigned char *out) {
+    memset(out, 0, (size_t)vocab);
+    int L = ngram - 1;
+    if (ngram < 2 || n < L) return;
+    for (int e = L; e < n; e++) {
+        if (window > 0 && e < n - window) continue;
+        int match = 1;
+        for (int j = 0; j < L; j++) {
+            if (hist[e - L + j] != hist[n - L + j]) { match = 0; break; }
+        }
+        if (match && hist[e] >= 0 && hist[e] < vocab) out[hist[e]] = 1;
+    }
+}
+
+static int ban_set(const LlmkRepeat *r, int vocab, unsigned char *out) {
+    static float logits[4096];
+    for (int i = 0; i < vocab; i++) logits[i] = 0.0f;
+    int nb = llmk_rep_ban(r, logits);
+    for (int i = 0; i < vocab; i++) out[i] = (logits[i] == LLMK_REP_BANNED);
+    return nb;
+}
+
+// Same indexed content: ban set at the tail, counts per token, seen list
+static int index_same(const LlmkRepeat *a, const LlmkRepeat *b, int vocab) {
+    static unsigned char sa[4096], sb[4096];
+    if (a->n != b->n || a->n_seen != b->n_seen) return 0;
+    ban_set(a, vocab, sa);
+    ban_set(b, vocab, sb);
+    if (memcmp(sa, sb, (size_t)vocab) != 0) return 0;
+    for (int i = 0; i < vocab; i++) {
+        if (a->count[i] != b->count[i]) return 0;
+    }
+    return 1;
+}
+
+// Number of occupied table slots and free nodes
+static void index_usage(const LlmkRepeat *r, int *slots, int *free_nodes) {
+    *slots = 0;
+    for (uint32_t i = 0; i <= r->mask; i++) *slots += (r->key[i] != 0);
+    *free_nodes = 0;
+    for (int32_t k = r->free_node; k >= 0; k = r->node_next[k]) (*free_nodes)++;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+
+static void test_ban(void) {
+    printf("\n--- ban: incremental index vs apply_no_repeat_ngram ---\n");
+    enum { V = 24, H = 1500 };
+    static int hist[H];
+    static unsigned char want[V], got[V];
+    static float logits[V];
+    int mismatches = 0, steps = 0, banned_total = 0;
+
+    for (int ngram = 2; ngram <= 6; ngram++) {
+        Index x;
+        if (index_make(&x, V, H, ngram, 0, 0) != LLMK_REP_OK) { mismatches++; continue; }
+        for (int n = 0; n < H; n++) {
+            // the scan the sampler runs today
+            for (int i = 0; i < V; i++) logits[i] = 1.0f;
+            apply_no_repeat_ngram(logits, V, hist, n, ngram);
+            for (int i = 0; i < V; i++) want[i] = (logits[i] == -1.0e9f);
+            int nb = ban_set(&x.r, V, got);
+            banned_total += nb;
+            if (memcmp(want, got, V) != 0) mismatches++;
+            steps++;
+
+            hist[n] = next_token(hist, n, V);
+            llmk_rep_sync(&x.r, hist, n + 1);
+        }
+        free(x.mem);
+    }
+    printf("  %d steps, %d bans\n", steps, banned_total);
+    ASSERT_EQ(mismatches, 0, "ban set equals the full scan at every step (n = 2..6)");
+    ASSERT_TRUE(banned_total > steps, "histories repeat enough to ban tokens");
+
+    // bans over out-of-range ids are ignored, like the scan
+    Index x;
+    int odd[6] = { 1, 2, 999, 1, 2, 3 };
+    ASSERT_EQ(index_make(&x, V, 16, 3, 0, 0), LLMK_REP_OK, "init");
+    llmk_rep_sync(&x.r, odd, 5);
+    ASSERT_EQ(ban_set(&x.r, V, got), 0, "out-of-range continuation is not banned");
+    ASSERT_EQ(llmk_rep_count(&x.r, 999), 0, "out-of-range id is not counted");
+    free(x.mem);
+}
+
+static void test_windows(void) {
+    printf("\n--- windows: last W n-grams, last P tokens ---\n");
+    enum { V = 16, H = 1200 };
+    static int hist[H];
+    static unsigned char want[V], got[V];
+    const int windows[3] = { 7, 40, 300 };
+    int ban_bad = 0, count_bad = 0, seen_bad = 0;
+
+    for (int wi = 0; wi < 3; wi++) {
+        const int W = windows[wi], P = windows[2 - wi];
+        Index x;
+        if (index_make(&x, V, 512, 3, W, P) != LLMK_REP_OK) { ban_bad++; continue; }
+        for (int n = 0; n < H; n++) {
+            scan_ban(hist, n, 3, W, V, want);
+            ban_set(&x.r, V, got);
+            if (memcmp(want, got, V) != 0) ban_bad++;
+            int nz = 0;
+            for (int t = 0; t < V; t++) {
+                int c = 0;
+                for (int i = (n > P ? n - P : 0); i < n; i++) c += (hist[i] == t);
+                if ((int)llmk_rep_count(&x.r, t) != c) count_bad++;
+                nz += (c > 0);
+            }
+            if (x.r.n_seen != nz) seen_bad++;
+            hist[n] = next_token(hist, n, V);
+            llmk_rep_sync(&x.r, hist, n + 1);
+        }
+        int slots, free_nodes;
+        index_usage(&x.r, &slots, &free_nodes);
+        if (slots > W) ban_bad++;
+        free(x.mem);
+    }
+    ASSERT_EQ(ban_bad, 0, "n-gram window matches a scan of the last W tokens");
+    ASSERT_EQ(count_bad, 0, "counts match the last P tokens");
+    ASSERT_EQ(seen_bad, 0, "seen list holds exactly the counted ids");
+
+    // ngram_window 0 is bounded by the arena: the oldest n-grams slide out
+    Index x;
+    ASSERT_EQ(index_make(&x, V, 64, 2, 0, 0), LLMK_REP_OK, "init small arena");
+    for (int n = 0; n < 500; n++) hist[n] = next_token(hist, n, V);
+    llmk_rep_sync(&x.r, hist, 500);
+    scan_ban(hist, 500, 2, 64, V, want);
+    ban_set(&x.r, V, got);
+    ASSERT_TRUE(memcmp(want, got, V) == 0, "full arena behaves as a max_grams window");
+    ASSERT_EQ((int)x.r.dropped, 0, "nothing dropped");
+    free(x.mem);
+}
+
+static void test_rollback(void) {
+    printf("\n--- rollback: truncate / rewrite vs rebuild ---\n");
+    enum { V = 20, H = 900 };
+    static int hist[H];
+    int bad = 0, ops = 0, max_n = 0;
+    Index x, y;
+    ASSERT_EQ(index_make(&x, V, 256, 4, 100, 32), LLMK_REP_OK, "init");
+    ASSERT_EQ(index_make(&y, V, 256, 4, 100, 32), LLMK_REP_OK, "init reference");
+
+    int n = 0;
+    for (int op = 0; op < 3000; op++) {
+        if (n > 0 && (rnd() % 3) == 0) {
+            // drop a draft or a truncated tail; the caller then rewrites it
+            int d = 1 + (int)(rnd() % (uint32_t)(n < 150 ? n : 150));
+            n -= d;
+            llmk_rep_sync(&x.r, hist, n);
+        } else {
+            int add = 1 + (int)(rnd() % 24);
+            if (n + add > H) add = H - n;
+            for (int i = 0; i < add; i++) hist[n + i] = next_token(hist, n + i, V);
+            n += add;
+            llmk_rep_sync(&x.r, hist, n);
+        }
+        if (n > max_n) max_n = n;
+        llmk_rep_reset(&y.r);
+        llmk_rep_sync(&y.r, hist, n);
+        if (!index_same(&x.r, &y.r, V)) bad++;
+        ops++;
+    }
+    printf("  %d ops, history up to %d tokens\n", ops, max_n);
+    ASSERT_EQ(bad, 0, "rolled-back index equals a rebuilt one after every op");
+
+    llmk_rep_sync(&x.r, hist, 0);
+    int slots, free_nodes;
+    index_usage(&x.r, &slots, &free_nodes);
+    ASSERT_EQ(slots, 0, "back at length 0: table empty");
+    ASSERT_EQ(free_nodes, 256, "back at length 0: every node free");
+    ASSERT_EQ(x.r.n_seen, 0, "back at length 0: no counted ids");
+
+    // reset after use is as good as a fresh init
+    for (int i = 0; i < 200; i++) hist[i] = next_token(hist, i, V);
+    llmk_rep_sync(&x.r, hist, 200);
+    llmk_rep_reset(&x.r);
+    index_usage(&x.r, &slots, &free_nodes);
+    ASSERT_TRUE(slots == 0 && free_nodes == 256 && x.r.n == 0, "reset empties the index");
+    free(x.mem);
+    free(y.mem);
+}
+
+static void test_penalize(void) {
+    printf("\n--- penalize: repeat / frequency / presence ---\n");
+    enum { V = 300, H = 600, RECENT = 64 };
+    static int hist[H];
+    static float a[V], b[V];
+    int bad = 0;
+    Index x;
+    ASSERT_EQ(index_make(&x, V, 64, 0, 0, RECENT), LLMK_REP_OK, "init");
+
+    for (int n = 0; n < H; n++) {
+        for (int i = 0; i < V; i++) a[i] = b[i] = (float)((int)(rnd() % 2001) - 1000) / 97.0f;
+        int n_recent = n > RECENT ? RECENT : n;
+        // greedy: sample_advanced only applies the penalty before its argmax
+        sample_advanced(a, V, 0.0f, 0.0f, 1.0f, 0, n_recent ? &hist[n - n_recent] : NULL, n_recent, 1.3f);
+        llmk_rep_penalize(&x.r, b, 1.3f, 0.0f, 0.0f);
+        if (memcmp(a, b, sizeof(a)) != 0) bad++;
+        hist[n] = (int)(rnd() % 40);
+        llmk_rep_sync(&x.r, hist, n + 1);
+    }
+    ASSERT_EQ(bad, 0, "repeat penalty is bit-identical to sample_advanced's loop");
+
+    for (int i = 0; i < V; i++) a[i] = b[i] = 2.0f;
+    llmk_rep_penalize(&x.r, b, 1.0f, 0.25f, 0.5f);
+    int fp_bad = 0;
+    for (int t = 0; t < V; t++) {
+        uint32_t c = llmk_rep_count(&x.r, t);
+        float want = c ? a[t] - (float)c * 0.25f - 0.5f : a[t];
+        if (b[t] != want) fp_bad++;
+    }
+    ASSERT_EQ(fp_bad, 0, "frequency / presence subtract c*f + p from counted ids only");
+
+    for (int i = 0; i < V; i++) b[i] = a[i];
+    llmk_rep_penalize(&x.r, b, 1.0f, 0.0f, 0.0f);
+    ASSERT_TRUE(memcmp(a, b, sizeof(a)) == 0, "neutral settings leave logits untouched");
+    free(x.mem);
+}
+
+static void test_configure(void) {
+    printf("\n--- configure: change settings mid-stream ---\n");
+    enum { V = 12, H = 400 };
+    static int hist[H];
+    static unsigned char want[V], got[V];
+    Index x;
+    ASSERT_EQ(index_make(&x, V, 512, 2, 0, 0), LLMK_REP_OK, "init");
+    for (int n = 0; n < H; n++) hist[n] = next_token(hist, n, V);
+    llmk_rep_sync(&x.r, hist, H);
+
+    int bad = 0;
+    for (int ngram = 1; ngram <= LLMK_REP_MAX_NGRAM + 2; ngram++) {
+        llmk_rep_configure(&x.r, hist, ngram, 50, 10);
+        int eff = ngram > LLMK_REP_MAX_NGRAM ? LLMK_REP_MAX_NGRAM : ngram;
+        scan_ban(hist, H, eff, 50, V, want);
+        ban_set(&x.r, V, got);
+        if (memcmp(want, got, V) != 0 || x.r.n != H) bad++;
+    }
+    ASSERT_EQ(bad, 0, "re-indexed n-grams match a scan for every n (clamped to 16)");
+    int c = 0;
+    for (int i = H - 10; i < H; i++) c += (hist[i] == hist[H - 1]);
+    ASSERT_EQ((int)llmk_rep_count(&x.r, hist[H - 1]), c, "counts follow the new penalty window");
+    free(x.mem);
+}
+
+static void test_bench(void) {
+    printf("\n--- bench: per-token cost vs history length ---\n");
+    enum { V = 32000, H = 8192 + 2048, STEPS = 2048, NGRAM = 4, RECENT = 64 };
+    static int hist[H];
+    float *logits = (float *)malloc(sizeof(float) * V);
+    const int sizes[4] = { 512, 2048, 4096, 8192 };
+    double idx_ns[4], scan_ns[4];
+
+    // text-like stream: a 2k-word working vocabulary with repeated phrases
+    for (int i = 0; i < H; i++) {
+        if (i > 16 && (rnd() % 5) == 0) {
+            int back = 1 + (int)(rnd() % (uint32_t)(i < 4000 ? i : 4000));
+            hist[i] = hist[i - back];
+        } else {
+            hist[i] = (int)(rnd() % 2000) * 16;
+        }
+    }
+    for (int i = 0; i < V; i++) logits[i] = 0.0f;
+
+    Index x;
+    if (index_make(&x, V, H, NGRAM, 0, RECENT) != LLMK_REP_OK) {
+        ASSERT_TRUE(0, "bench index");
+        free(logits);
+        return;
+    }
+    volatile float sink = 0.0f;
+    for (int s = 0; s < 4; s++) {
+        const int h0 = sizes[s];
+        llmk_rep_reset(&x.r);
+        llmk_rep_sync(&x.r, hist, h0);
+
+        double t0 = now_s();
+        for (int k = 0; k < STEPS; k++) {
+            llmk_rep_ban(&x.r, logits);
+            llmk_rep_penalize(&x.r, logits, 1.15f, 0.0f, 0.0f);
+            llmk_rep_sync(&x.r, hist, h0 + k + 1);
+        }
+        idx_ns[s] = (now_s() - t0) / STEPS * 1e9;
+        sink += logits[hist[h0]];
+
+        t0 = now_s();
+        for (int k = 0; k < STEPS; k++) {
+            const int n = h0 + k;
+            apply_no_repeat_ngram(logits, V, hist, n, NGRAM);
+            for (int i = n - RECENT; i < n; i++) {
+                int t = hist[i];
+                logits[t] = (logits[t] > 0) ? logits[t] / 1.15f : logits[t] * 1.15f;
+            }
+        }
+        scan_ns[s] = (now_s() - t0) / STEPS * 1e9;
+        sink += logits[hist[h0]];
+        printf("  history %5d: index %7.1f ns/token, scan %8.1f ns/token\n", h0, idx_ns[s], scan_ns[s]);
+    }
+    (void)sink;
+    ASSERT_TRUE(idx_ns[3] < idx_ns[0] * 2.5, "index cost at 8k history stays within 2.5x of 512");
+    ASSERT_TRUE(scan_ns[3] > idx_ns[3] * 4.0, "index beats the scan at 8k history");
+    free(x.mem);
+    free(logits);
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_repeat tests\n");
+    printf("========================================\n");
+
+    test_ban();
+    test_windows();
+    test_rollback();
+    test_penalize();
+    test_configure();
+    test_bench();
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_repeat tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,414 @@
+// test_llmk_rope.c — Rotary position embedding tables + rotation
+//
+// Tests:
+//   params: scaling names, table size, init refuses bad geometry, short or
+//   misaligned memory; n_rot 0 / odd / > head_size resolve like llama.cpp
+//   tables: freestanding sin/cos vs libm over seq_len 4096, head 128
+//   rotate: SSE2 + scalar tails vs a double reference for both pair layouts,
+//   partial rotation (n_rot < head_size) copies the tail, in place == out of
+//   place, out-of-range positions pass through
+//   transpose: rotate_T(rotate(x)) == mscale²·x
+//   scaling: linear (position interpolation), NTK (base change) and YaRN
+//   (ramp + magnitude) against a libm transcription of llama.cpp's rope
+//   relative: q·k depends only on the position difference
+//   speed: table rotation vs on-the-fly sin/cos (informational)
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_rope
+//
+// Run:
+//   ../engine/host/test_llmk_rope
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../engine/llama2/llmk_rope.c"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static float rndf(float scale) {
+    return ((float)(rnd() & 0xFFFF) / 32768.0f - 1.0f) * scale;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Builds r over freshly allocated tables; returns the memory (free() it)
+static void *rope_make(LlmkRope *r, const LlmkRopeParams *p, int head_size, int seq_len) {
+    int n_rot = (p->n_rot > 0 && p->n_rot <= head_size) ? p->n_rot : head_size;
+    uint64_t bytes = llmk_rope_table_bytes(seq_len, n_rot & ~1);
+    void *mem = aligned_alloc(16, (size_t)((bytes + 15) & ~(uint64_t)15));
+    if (!mem || llmk_rope_init(r, p, head_size, seq_len, mem, bytes) != LLMK_ROPE_OK) {
+        free(mem);
+        return NULL;
+    }
+    return mem;
+}
+
+// ============================================================
+// libm reference (llama.cpp ggml_rope_yarn transcription)
+// ============================================================
+static double ref_corr_dim(int n_rot, int orig_ctx, double rot, double base) {
+    return n_rot * log(orig_ctx / (rot * 2.0 * M_PI)) / (2.0 * log(base));
+}
+
+// Angle and magnitude for pair i at pos
+static void ref_angle(const LlmkRopeParams *p, int n_rot, int seq_len, int pos, int i,
+                      double *theta, double *mag) {
+    double base = p->freq_base, fs = 1.0, ext = 0.0, ms = 1.0;
+    int orig = p->orig_ctx > 0 ? p->orig_ctx : (int)((float)seq_len / p->factor);
+    if (p->scaling == LLMK_ROPE_SCALING_NTK) {
+        base *= pow(p->factor, (double)n_rot / (n_rot - 2));
+    } else if (p->scaling == LLMK_ROPE_SCALING_LINEAR) {
+        fs = 1.0 / p->factor;
+    } else if (p->scaling == LLMK_ROPE_SCALING_YARN) {
+        fs = 1.0 / p->factor;
+        ext = 1.0;
+        ms = 1.0 + 0.1 * log(p->factor);
+    }
+    double te = pos * pow(base, -2.0 * i / n_rot), ti = fs * te, mix = 0.0;
+    if (ext != 0.0) {
+        double lo = floor(ref_corr_dim(n_rot, orig, p->yarn_beta_fast, base));
+        double hi = ceil(ref_corr_dim(n_rot, orig, p->yarn_beta_slow, base));
+        if (lo < 0) lo = 0;
+        if (hi > n_rot - 1) hi = n_rot - 1;
+        double y = (i - lo) / fmax(0.001, hi - lo);
+        mix = (1.0 - fmin(1.0, fmax(0.0, y))) * ext;
+    }
+    *theta = ti * (1.0 - mix) + te * mix;
+    *mag = ms;
+}
+
+static void ref_rotate(const LlmkRopeParams *p, int head_size, int n_rot, int seq_len,
+                       double *out, const float *x, int n_heads, int pos) {
+    const int half = n_rot / 2;
+    for (int h = 0; h < n_heads; h++) {
+        const float *xh = x + h * head_size;
+        double *oh = out + h * head_size;
+        for (int j = 0; j < head_size; j++) oh[j] = xh[j];
+        for (int i = 0; i < half; i++) {
+            double th, mg;
+            ref_angle(p, n_rot, seq_len, pos, i, &th, &mg);
+            int i0 = p->layout == LLMK_ROPE_NEOX ? i : 2 * i;
+            int i1 = p->layout == LLMK_ROPE_NEOX ? i + half : 2 * i + 1;
+            double a = xh[i0], b = xh[i1];
+            oh[i0] = mg * (a * cos(th) - b * sin(th));
+            oh[i1] = mg * (a * sin(th) + b * cos(th));
+        }
+    }
+}
+
+static double max_err(const float *got, const double *ref, int n) {
+    double e = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = fabs((double)got[i] - ref[i]);
+        if (d > e) e = d;
+    }
+    return e;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+static void test_params(void) {
+    printf("\n=== params ===\n");
+    ASSERT_EQ(llmk_rope_scaling_from_name("YaRN", 4), LLMK_ROPE_SCALING_YARN, "scaling names are case-insensitive");
+    ASSERT_EQ(llmk_rope_scaling_from_name("linear", 6), LLMK_ROPE_SCALING_LINEAR, "linear");
+    ASSERT_EQ(llmk_rope_scaling_from_name("ntk", 3), LLMK_ROPE_SCALING_NTK, "ntk");
+    ASSERT_EQ(llmk_rope_scaling_from_name("none", 4), LLMK_ROPE_SCALING_NONE, "none");
+    ASSERT_EQ(llmk_rope_scaling_from_name("yarnx", 5), -1, "unknown name refused");
+    ASSERT_TRUE(!strcmp(llmk_rope_scaling_name(LLMK_ROPE_SCALING_NTK), "ntk"), "names round-trip");
+    ASSERT_TRUE(llmk_rope_table_bytes(100, 64) == 2 * 12800 && llmk_rope_table_bytes(3, 10) == 2 * 64,
+                "table bytes: cos + sin, each 16-byte padded");
+
+    LlmkRopeParams p;
+    llmk_rope_defaults(&p);
+    LlmkRope r;
+    static float mem[4096] __attribute__((aligned(16)));
+    uint64_t need = llmk_rope_table_bytes(32, 64);
+    ASSERT_EQ(llmk_rope_init(&r, &p, 0, 32, mem, sizeof(mem)), LLMK_ROPE_ERR_PARAM, "head_size 0 refused");
+    ASSERT_EQ(llmk_rope_init(&r, &p, 64, 0, mem, sizeof(mem)), LLMK_ROPE_ERR_PARAM, "seq_len 0 refused");
+    ASSERT_EQ(llmk_rope_init(&r, &p, 64, 32, mem, need - 4), LLMK_ROPE_ERR_MEM, "short memory refused");
+    ASSERT_EQ(llmk_rope_init(&r, &p, 64, 32, (uint8_t *)mem + 4, need), LLMK_ROPE_ERR_MEM, "misaligned memory refused");
+    ASSERT_TRUE(!r.ready, "failed init leaves the rope not ready");
+    ASSERT_EQ(llmk_rope_init(&r, &p, 64, 32, mem, need), LLMK_ROPE_OK, "defaults accepted");
+    ASSERT_TRUE(r.ready && r.p.n_rot == 64 && r.half == 32 && r.mscale == 1.0f, "n_rot 0 resolves to head_size");
+    p.n_rot = 11;
+    ASSERT_EQ(llmk_rope_init(&r, &p, 64, 32, mem, sizeof(mem)), LLMK_ROPE_OK, "odd n_rot accepted");
+    ASSERT_EQ(r.p.n_rot, 10, "odd n_rot rounds down to a whole pair");
+    p.n_rot = 0;
+    p.scaling = LLMK_ROPE_SCALING_YARN;
+    p.factor = 1.0f;
+    llmk_rope_init(&r, &p, 64, 32, mem, sizeof(mem));
+    ASSERT_EQ(r.p.scaling, LLMK_ROPE_SCALING_NONE, "factor 1 disables scaling");
+}
+
+static void test_tables(void) {
+    printf("\n=== tables ===\n");
+    LlmkRopeParams p;
+    llmk_rope_defaults(&p);
+    LlmkRope r;
+    void *mem = rope_make(&r, &p, 128, 4096);
+    ASSERT_TRUE(mem != NULL, "seq_len 4096 × head 128 tables built");
+    if (!mem) return;
+    double e = 0.0;
+    for (int pos = 0; pos < 4096; pos++) {
+        for (int i = 0; i < 64; i++) {
+            double th = pos * pow(10000.0, -2.0 * i / 128);
+            double ec = fabs(r.cos_tab[pos * 64 + i] - cos(th)), es = fabs(r.sin_tab[pos * 64 + i] - sin(th));
+            if (ec > e) e = ec;
+            if (es > e) e = es;
+        }
+    }
+    printf("  max |table − libm| = %.2e\n", e);
+    ASSERT_TRUE(e < 2e-7, "freestanding sin/cos within f32 rounding of libm (angles up to 4095 rad)");
+    free(mem);
+}
+
+static void test_rotate(void) {
+    printf("\n=== rotate ===\n");
+    static const int shapes[][2] = { { 64, 0 }, { 128, 0 }, { 96, 0 }, { 64, 32 }, { 64, 10 }, { 6, 0 } };
+    float x[4 * 128], y[4 * 128], z[4 * 128];
+    double ref[4 * 128];
+    for (int layout = 0; layout <= LLMK_ROPE_NEOX; layout += LLMK_ROPE_NEOX) {
+        double worst = 0.0;
+        int tail_ok = 1, inplace_ok = 1;
+        for (unsigned s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+            const int hs = shapes[s][0];
+            LlmkRopeParams p;
+            llmk_rope_defaults(&p);
+            p.layout = layout;
+            p.n_rot = shapes[s][1];
+            LlmkRope r;
+            void *mem = rope_make(&r, &p, hs, 512);
+            if (!mem) { worst = 1.0; continue; }
+            for (int pos = 0; pos < 512; pos += 37) {
+                for (int i = 0; i < 4 * hs; i++) x[i] = rndf(1.0f);
+                llmk_rope_rotate(&r, y, x, 4, pos);
+                ref_rotate(&r.p, hs, r.p.n_rot, 512, ref, x, 4, pos);
+                double e = max_err(y, ref, 4 * hs);
+                if (e > worst) worst = e;
+                for (int h = 0; h < 4; h++)
+                    for (int j = r.p.n_rot; j < hs; j++) tail_ok &= (y[h * hs + j] == x[h * hs + j]);
+                memcpy(z, x, sizeof(float) * 4 * hs);
+                llmk_rope_rotate(&r, z, z, 4, pos);
+                inplace_ok &= !memcmp(y, z, sizeof(float) * 4 * hs);
+            }
+            free(mem);
+        }
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s: all shapes match the double reference (max err %.2e)",
+                 layout == LLMK_ROPE_NEOX ? "neox" : "norm", worst);
+        ASSERT_TRUE(worst < 2e-6, msg);
+        ASSERT_TRUE(tail_ok, "dims past n_rot are copied unchanged");
+        ASSERT_TRUE(inplace_ok, "in place == out of place");
+    }
+
+    LlmkRopeParams p;
+    llmk_rope_defaults(&p);
+    LlmkRope r;
+    void *mem = rope_make(&r, &p, 64, 16);
+    for (int i = 0; i < 64; i++) x[i] = rndf(1.0f);
+    llmk_rope_rotate(&r, y, x, 1, 16);
+    ASSERT_TRUE(!memcmp(x, y, sizeof(float) * 64), "pos ≥ seq_len passes through");
+    llmk_rope_rotate(&r, y, x, 1, 0);
+    ASSERT_TRUE(!memcmp(x, y, sizeof(float) * 64), "pos 0 is the identity");
+    free(mem);
+}
+
+static void test_transpose(void) {
+    printf("\n=== transpose ===\n");
+    for (int sc = LLMK_ROPE_SCALING_NONE; sc <= LLMK_ROPE_SCALING_YARN; sc += LLMK_ROPE_SCALING_YARN) {
+        LlmkRopeParams p;
+        llmk_rope_defaults(&p);
+        p.layout = LLMK_ROPE_NEOX;
+        p.scaling = sc;
+        p.factor = 4.0f;
+        LlmkRope r;
+        void *mem = rope_make(&r, &p, 64, 256);
+        float x[2 * 64], y[2 * 64], z[2 * 64];
+        double e = 0.0, m2 = (double)r.mscale * r.mscale;
+        for (int pos = 0; pos < 256; pos += 17) {
+            for (int i = 0; i < 128; i++) x[i] = rndf(1.0f);
+            llmk_rope_rotate(&r, y, x, 2, pos);
+            llmk_rope_rotate_T(&r, z, y, 2, pos);
+            for (int i = 0; i < 128; i++) {
+                double d = fabs(z[i] - m2 * x[i]);
+                if (d > e) e = d;
+            }
+        }
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s: rotate_T ∘ rotate = mscale²·I (mscale %.4f, err %.2e)",
+                 sc ? "yarn" : "none", r.mscale, e);
+        ASSERT_TRUE(e < 2e-6, msg);
+        free(mem);
+    }
+}
+
+static void test_scaling(void) {
+    printf("\n=== scaling ===\n");
+    const int hs = 128, seq = 8192;
+    float x[hs], y[hs];
+    double ref[hs];
+    for (int sc = LLMK_ROPE_SCALING_LINEAR; sc <= LLMK_ROPE_SCALING_YARN; sc++) {
+        LlmkRopeParams p;
+        llmk_rope_defaults(&p);
+        p.scaling = sc;
+        p.factor = 4.0f;
+        p.orig_ctx = 2048;
+        p.freq_base = 500000.0f;
+        LlmkRope r;
+        void *mem = rope_make(&r, &p, hs, seq);
+        if (!mem) { ASSERT_TRUE(0, "scaled tables built"); continue; }
+        double e = 0.0;
+        for (int pos = 0; pos < seq; pos += 211) {
+            for (int i = 0; i < hs; i++) x[i] = rndf(1.0f);
+            llmk_rope_rotate(&r, y, x, 1, pos);
+            ref_rotate(&r.p, hs, hs, seq, ref, x, 1, pos);
+            double d = max_err(y, ref, hs);
+            if (d > e) e = d;
+        }
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s ×4 matches the llama.cpp formula (err %.2e)", llmk_rope_scaling_name(sc), e);
+        ASSERT_TRUE(e < 4e-6, msg);
+        if (sc == LLMK_ROPE_SCALING_LINEAR) {
+            LlmkRopeParams q;
+            llmk_rope_defaults(&q);
+            q.freq_base = 500000.0f;
+            LlmkRope u;
+            void *m2 = rope_make(&u, &q, hs, seq);
+            double d = 0.0;
+            for (int pos = 0; pos < seq; pos += 4)
+                for (int i = 0; i < hs / 2; i++) {
+                    double t = fabs(r.cos_tab[pos * (hs / 2) + i] - u.cos_tab[pos / 4 * (hs / 2) + i]);
+                    if (t > d) d = t;
+                }
+            ASSERT_TRUE(d < 1e-6, "linear ×4: position 4p rotates like p unscaled");
+            free(m2);
+        }
+        if (sc == LLMK_ROPE_SCALING_YARN) {
+            ASSERT_TRUE(fabsf(r.mscale - (float)(1.0 + 0.1 * log(4.0))) < 1e-6f, "yarn mscale = 1 + 0.1·ln(factor)");
+            // highest-frequency pair is extrapolated (unscaled), lowest interpolated
+            double th0 = 100.0, thl = 100.0 * pow(500000.0, -2.0 * 63 / 128) / 4.0;
+            ASSERT_TRUE(fabs(r.cos_tab[100 * 64] / r.mscale - cos(th0)) < 1e-5 &&
+                        fabs(r.cos_tab[100 * 64 + 63] / r.mscale - cos(thl)) < 1e-5,
+                        "yarn keeps fast dims, interpolates slow dims");
+        }
+        free(mem);
+    }
+}
+
+static void test_relative(void) {
+    printf("\n=== relative ===\n");
+    LlmkRopeParams p;
+    llmk_rope_defaults(&p);
+    LlmkRope r;
+    void *mem = rope_make(&r, &p, 64, 2048);
+    float q[64], k[64], qr[64], kr[64];
+    for (int i = 0; i < 64; i++) { q[i] = rndf(1.0f); k[i] = rndf(1.0f); }
+    double e = 0.0, d0 = 0.0;
+    llmk_rope_rotate(&r, qr, q, 1, 40);
+    llmk_rope_rotate(&r, kr, k, 1, 13);
+    for (int i = 0; i < 64; i++) d0 += (double)qr[i] * kr[i];
+    for (int shift = 1; shift < 2000; shift += 97) {
+        double d = 0.0;
+        llmk_rope_rotate(&r, qr, q, 1, 40 + shift);
+        llmk_rope_rotate(&r, kr, k, 1, 13 + shift);
+        for (int i = 0; i < 64; i++) d += (double)qr[i] * kr[i];
+        if (fabs(d - d0) > e) e = fabs(d - d0);
+    }
+    char msg[128];
+    snprintf(msg, sizeof(msg), "q·k at (40+s, 13+s) is shift-invariant (max drift %.2e)", e);
+    ASSERT_TRUE(e < 1e-4, msg);
+    free(mem);
+}
+
+static void test_speed(void) {
+    printf("\n=== speed (informational) ===\n");
+    const int hs = 128, nh = 32, seq = 2048, reps = 20;
+    LlmkRopeParams p;
+    llmk_rope_defaults(&p);
+    LlmkRope r;
+    void *mem = rope_make(&r, &p, hs, seq);
+    float *x = malloc(sizeof(float) * nh * hs);
+    for (int i = 0; i < nh * hs; i++) x[i] = rndf(1.0f);
+
+    double t0 = now_s();
+    for (int rep = 0; rep < reps; rep++)
+        for (int pos = 0; pos < seq; pos++) llmk_rope_rotate(&r, x, x, nh, pos);
+    double t_tab = now_s() - t0;
+
+    t0 = now_s();
+    for (int rep = 0; rep < reps; rep++)
+        for (int pos = 0; pos < seq; pos++)
+            for (int h = 0; h < nh; h++)
+                for (int i = 0; i < hs; i += 2) {
+                    float th = (float)pos * powf(10000.0f, -(float)i / hs), c = cosf(th), s = sinf(th);
+                    float a = x[h * hs + i], b = x[h * hs + i + 1];
+                    x[h * hs + i] = a * c - b * s;
+                    x[h * hs + i + 1] = a * s + b * c;
+                }
+    double t_fly = now_s() - t0;
+    double rows = (double)reps * seq;
+    printf("  %d heads × %d: tables %.1f ns/pos, on-the-fly powf+sincosf %.1f ns/pos (%.1fx)\n",
+           nh, hs, t_tab / rows * 1e9, t_fly / rows * 1e9, t_fly / t_tab);
+    ASSERT_TRUE(isfinite(x[0]), "rotation stays finite");
+    free(x);
+    free(mem);
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_rope tests\n");
+    printf("========================================\n");
+
+    test_params();
+    test_tables();
+    test_rotate();
+    test_transpose();
+    test_scaling();
+    test_relative();
+    test_speed();
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_rope tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,347 @@
+// test_llmk_shortlist.c — Low-rank classifier shortlist + offline builder
+//
+// Tests:
+//   format: llmk_sl_parse rejects bad magic / shapes / short buffers, the
+//   section layout matches llmk_sl_file_bytes, scratch must be aligned
+//   build: subspace iteration recovers a low-rank-plus-noise classifier
+//   (small residuals), coefficients are int8 with per-row scale
+//   bound: |W_i·x − approx_i| ≤ resid_i·‖x‖ for every row
+//   select: n_cand candidates, each marked masked in approx; their exact
+//   logits equal the full matvec; top-1 agreement over random inputs
+//   certify: a certified top-1 is always the full argmax; a too-small rank
+//   cannot certify and counts fallbacks
+//   speed: full matvec vs select + rerank (informational)
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_shortlist
+//
+// Run:
+//   ../engine/host/test_llmk_shortlist
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../engine/llama2/llmk_shortlist.c"
+#include "../engine/host/llmk_shortlist_build.c"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static float rndf(float scale) {
+    return ((float)(rnd() & 0xFFFF) / 32768.0f - 1.0f) * scale;
+}
+
+// ============================================================
+// Synthetic classifier: W = U·Vᵀ (rank 12) + noise
+// ============================================================
+enum { T_VOCAB = 2000, T_DIM = 128, T_TRUE_RANK = 12, T_RANK = 16, T_CAND = 64 };
+
+static float *g_w;                      // [T_VOCAB][T_DIM]
+
+static void make_classifier(float noise) {
+    static float u[T_VOCAB][T_TRUE_RANK], v[T_TRUE_RANK][T_DIM];
+    for (int i = 0; i < T_VOCAB; i++)
+        for (int r = 0; r < T_TRUE_RANK; r++) u[i][r] = rndf(1.0f);
+    for (int r = 0; r < T_TRUE_RANK; r++)
+        for (int d = 0; d < T_DIM; d++) v[r][d] = rndf(0.3f);
+    for (int i = 0; i < T_VOCAB; i++) {
+        for (int d = 0; d < T_DIM; d++) {
+            float s = rndf(noise);
+            for (int r = 0; r < T_TRUE_RANK; r++) s += u[i][r] * v[r][d];
+            g_w[(size_t)i * T_DIM + d] = s;
+        }
+    }
+}
+
+static void row_fn(void *ctx, uint32_t r, float *out) {
+    (void)ctx;
+    memcpy(out, g_w + (size_t)r * T_DIM, sizeof(float) * T_DIM);
+}
+
+static float dot(const float *a, const float *b, int n) {
+    float s = 0.0f;
+    for (int i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+static void full_logits(float *logits, const float *x) {
+    for (int i = 0; i < T_VOCAB; i++) logits[i] = dot(g_w + (size_t)i * T_DIM, x, T_DIM);
+}
+
+static int argmax(const float *v, int n) {
+    int b = 0;
+    for (int i = 1; i < n; i++) if (v[i] > v[b]) b = i;
+    return b;
+}
+
+// Stage 2 as llmk_forward.c does it: mask everything, exact rows for candidates
+static int shortlist_logits(LlmkShortlist *sl, float *logits, const float *x) {
+    uint32_t n = llmk_sl_select(sl, x);
+    for (int i = 0; i < T_VOCAB; i++) logits[i] = LLMK_SL_MASKED;
+    for (uint32_t i = 0; i < n; i++) logits[sl->cand[i]] = dot(g_w + (size_t)sl->cand[i] * T_DIM, x, T_DIM);
+    return (int)n;
+}
+
+static void random_x(float *x) {
+    // Hidden states are mostly inside the classifier's dominant subspace
+    for (int d = 0; d < T_DIM; d++) x[d] = rndf(0.2f);
+    int t = (int)(rnd() % T_VOCAB);
+    for (int d = 0; d < T_DIM; d++) x[d] += 0.05f * g_w[(size_t)t * T_DIM + d];
+}
+
+static void *g_buf;
+static uint64_t g_len;
+static void *g_scratch;
+
+static int attach(LlmkShortlist *sl, void *buf, uint64_t len, uint32_t n_cand) {
+    if (llmk_sl_parse(sl, buf, len) != LLMK_SL_OK) return -1;
+    uint64_t sb = llmk_sl_scratch_bytes(sl->vocab, sl->rank, 256);
+    free(g_scratch);
+    g_scratch = aligned_alloc(64, (size_t)((sb + 63) & ~(uint64_t)63));
+    if (llmk_sl_attach_scratch(sl, g_scratch, sb, 256) != LLMK_SL_OK) return -1;
+    sl->n_cand = n_cand;
+    sl->enabled = 1;
+    return 0;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+static void test_format(void) {
+    printf("\n=== format ===\n");
+    LlmkShortlist sl;
+    static uint8_t raw[4096] __attribute__((aligned(64)));
+    LlmkSlHeader *h = (LlmkSlHeader *)raw;
+
+    ASSERT_EQ((int)sizeof(LlmkSlHeader), 32, "header is 32 bytes");
+    ASSERT_EQ((int)llmk_sl_file_bytes(10, 16, 3), 32 + 192 + 48 + 48 + 160,
+              "layout: header | basis | scale | resid | coef (16-aligned, rank_pad 16)");
+
+    memset(raw, 0, sizeof(raw));
+    h->magic = LLMK_SL_MAGIC; h->version = LLMK_SL_VERSION;
+    h->vocab = 10; h->dim = 16; h->rank = 3; h->rank_pad = 16;
+    ASSERT_EQ(llmk_sl_parse(&sl, raw, llmk_sl_file_bytes(10, 16, 3)), LLMK_SL_OK, "valid header parses");
+    ASSERT_TRUE(sl.coef == (const int8_t *)(raw + 320) && sl.resid == (const float *)(raw + 272),
+                "section pointers match the layout");
+    ASSERT_EQ(sl.enabled, 0, "parsed shortlist starts disabled");
+    ASSERT_EQ(llmk_sl_parse(&sl, raw, llmk_sl_file_bytes(10, 16, 3) - 1), LLMK_SL_ERR_FORMAT, "short buffer rejected");
+    h->rank_pad = 3;
+    ASSERT_EQ(llmk_sl_parse(&sl, raw, sizeof(raw)), LLMK_SL_ERR_SHAPE, "bad rank_pad rejected");
+    h->rank_pad = 16; h->rank = 17;
+    ASSERT_EQ(llmk_sl_parse(&sl, raw, sizeof(raw)), LLMK_SL_ERR_SHAPE, "rank > dim rejected");
+    h->rank = 3; h->magic ^= 1u;
+    ASSERT_EQ(llmk_sl_parse(&sl, raw, sizeof(raw)), LLMK_SL_ERR_FORMAT, "bad magic rejected");
+    h->magic ^= 1u;
+
+    llmk_sl_parse(&sl, raw, sizeof(raw));
+    static uint8_t scratch[1024] __attribute__((aligned(16)));
+    uint64_t sb = llmk_sl_scratch_bytes(10, 3, 4);
+    ASSERT_EQ(llmk_sl_attach_scratch(&sl, scratch + 4, sb, 4), LLMK_SL_ERR_SCRATCH, "misaligned scratch rejected");
+    ASSERT_EQ(llmk_sl_attach_scratch(&sl, scratch, sb - 1, 4), LLMK_SL_ERR_SCRATCH, "small scratch rejected");
+    ASSERT_EQ(llmk_sl_attach_scratch(&sl, scratch, sb, 4), LLMK_SL_OK, "scratch attached");
+    ASSERT_EQ((int)sl.n_cand, 4, "n_cand defaults to max_cand");
+}
+
+static void test_build(void) {
+    printf("\n=== build ===\n");
+    LlmkSlBuildStats st;
+    ASSERT_EQ(llmk_sl_build(row_fn, NULL, T_VOCAB, T_DIM, T_DIM + 1, 3, 1, &g_buf, &g_len, &st), -1,
+              "rank > dim rejected");
+    ASSERT_EQ(llmk_sl_build(row_fn, NULL, T_VOCAB, T_DIM, T_RANK, 4, 7, &g_buf, &g_len, &st), 0, "build rank 16");
+    ASSERT_TRUE(g_len == llmk_sl_file_bytes(T_VOCAB, T_DIM, T_RANK) && ((uintptr_t)g_buf & 63u) == 0,
+                "image size and alignment");
+    printf("  (resid mean=%.4f max=%.4f)\n", st.mean_rel_resid, st.max_rel_resid);
+    ASSERT_TRUE(st.mean_rel_resid < 0.15 && st.max_rel_resid < 0.5, "low-rank structure recovered");
+
+    LlmkShortlist sl;
+    ASSERT_EQ(llmk_sl_parse(&sl, g_buf, g_len), LLMK_SL_OK, "built image parses");
+    double gram_err = 0.0;
+    for (int a = 0; a < T_RANK; a++) {
+        for (int b = 0; b < T_RANK; b++) {
+            double g = dot(sl.basis + a * T_DIM, sl.basis + b * T_DIM, T_DIM);
+            gram_err = fmax(gram_err, fabs(g - (a == b ? 1.0 : 0.0)));
+        }
+    }
+    ASSERT_TRUE(gram_err < 1e-5, "basis rows are orthonormal");
+    int amax_ok = 1, pad_ok = 1;
+    for (int i = 0; i < T_VOCAB; i++) {
+        const int8_t *c = sl.coef + (size_t)i * sl.rank_pad;
+        int m = 0;
+        for (int j = 0; j < T_RANK; j++) m = abs(c[j]) > m ? abs(c[j]) : m;
+        for (int j = T_RANK; j < (int)sl.rank_pad; j++) pad_ok &= (c[j] == 0);
+        amax_ok &= (m == 127 || sl.scale[i] == 0.0f);
+    }
+    ASSERT_TRUE(amax_ok, "each row uses the full int8 range");
+    ASSERT_TRUE(pad_ok, "rank padding is zero");
+}
+
+static void test_bound(void) {
+    printf("\n=== bound ===\n");
+    LlmkShortlist sl;
+    static float x[T_DIM], logits[T_VOCAB];
+    ASSERT_EQ(attach(&sl, g_buf, g_len, 1), 0, "attach");
+    int ok = 1;
+    for (int t = 0; t < 50 && ok; t++) {
+        random_x(x);
+        shortlist_logits(&sl, logits, x);   // k=1: every other row keeps its approx score
+        for (int i = 0; i < T_VOCAB; i++) {
+            if (sl.approx[i] == LLMK_SL_MASKED) continue;
+            float exact = dot(g_w + (size_t)i * T_DIM, x, T_DIM);
+            if (fabsf(exact - sl.approx[i]) > sl.resid[i] * sl.x_norm) ok = 0;
+        }
+    }
+    ASSERT_TRUE(ok, "|W_i·x - approx_i| <= resid_i * |x| on every row");
+}
+
+static void test_select(void) {
+    printf("\n=== select ===\n");
+    LlmkShortlist sl;
+    static float x[T_DIM], ref[T_VOCAB], got[T_VOCAB];
+    attach(&sl, g_buf, g_len, T_CAND);
+
+    random_x(x);
+    full_logits(ref, x);
+    int n = shortlist_logits(&sl, got, x);
+    ASSERT_EQ(n, T_CAND, "select returns n_cand candidates");
+    int marked = 1, exact = 1, distinct = 1;
+    for (int i = 0; i < n; i++) {
+        marked &= (sl.approx[sl.cand[i]] == LLMK_SL_MASKED);
+        exact &= (got[sl.cand[i]] == ref[sl.cand[i]]);
+        for (int j = 0; j < i; j++) distinct &= (sl.cand[i] != sl.cand[j]);
+    }
+    ASSERT_TRUE(marked && distinct, "candidates are distinct and masked in approx");
+    ASSERT_TRUE(exact, "candidate logits equal the full classifier's");
+    int others_masked = 0;
+    for (int i = 0; i < T_VOCAB; i++) others_masked += (got[i] == LLMK_SL_MASKED);
+    ASSERT_EQ(others_masked, T_VOCAB - T_CAND, "all other logits read LLMK_SL_MASKED");
+
+    int agree = 0;
+    for (int t = 0; t < 200; t++) {
+        random_x(x);
+        full_logits(ref, x);
+        shortlist_logits(&sl, got, x);
+        agree += argmax(ref, T_VOCAB) == argmax(got, T_VOCAB);
+    }
+    printf("  (top-1 agreement %d/200 at k=%d)\n", agree, T_CAND);
+    ASSERT_TRUE(agree >= 196, "shortlist top-1 agrees with the full argmax (>= 98%)");
+    ASSERT_EQ((int)sl.calls, 201, "calls counted");
+}
+
+static void test_certify(void) {
+    printf("\n=== certify ===\n");
+    LlmkShortlist sl;
+    static float x[T_DIM], ref[T_VOCAB], got[T_VOCAB];
+    attach(&sl, g_buf, g_len, T_CAND);
+    sl.verify_top1 = 1;
+
+    int wrong = 0, cert = 0;
+    for (int t = 0; t < 200; t++) {
+        random_x(x);
+        full_logits(ref, x);
+        shortlist_logits(&sl, got, x);
+        if (llmk_sl_certify(&sl, got)) {
+            cert++;
+            wrong += argmax(ref, T_VOCAB) != argmax(got, T_VOCAB);
+        }
+    }
+    printf("  (certified %d/200)\n", cert);
+    ASSERT_EQ(wrong, 0, "a certified top-1 is always the full argmax");
+    ASSERT_TRUE(cert >= 100, "most steps certify on a low-rank classifier");
+    ASSERT_TRUE(sl.certified == (uint64_t)cert && sl.fallbacks == (uint64_t)(200 - cert), "certify/fallback counters");
+
+    // Rank 2 cannot explain a rank-12 classifier: the bound is too loose
+    void *buf2 = NULL;
+    uint64_t len2 = 0;
+    llmk_sl_build(row_fn, NULL, T_VOCAB, T_DIM, 2, 2, 3, &buf2, &len2, NULL);
+    LlmkShortlist weak;
+    attach(&weak, buf2, len2, 8);
+    random_x(x);
+    shortlist_logits(&weak, got, x);
+    ASSERT_EQ(llmk_sl_certify(&weak, got), 0, "rank too small: falls back");
+    ASSERT_EQ((int)weak.fallbacks, 1, "fallback counted");
+    free(buf2);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void test_speed(void) {
+    printf("\n=== speed ===\n");
+    LlmkShortlist sl;
+    static float x[T_DIM], out[T_VOCAB];
+    attach(&sl, g_buf, g_len, T_CAND);
+    const int reps = 200;
+    volatile float sink = 0.0f;
+
+    random_x(x);
+    double t0 = now_s();
+    for (int r = 0; r < reps; r++) { full_logits(out, x); sink += out[r]; }
+    double t_full = now_s() - t0;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++) { shortlist_logits(&sl, out, x); sink += out[r]; }
+    double t_sl = now_s() - t0;
+    printf("  (full %.1f us, shortlist %.1f us per step, vocab=%d dim=%d rank=%d k=%d)\n",
+           1e6 * t_full / reps, 1e6 * t_sl / reps, T_VOCAB, T_DIM, T_RANK, T_CAND);
+    ASSERT_TRUE(t_full > 0.0 && t_sl > 0.0, "both paths timed");
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_shortlist tests\n");
+    printf("========================================\n");
+
+    g_w = (float *)malloc(sizeof(float) * T_VOCAB * T_DIM);
+    make_classifier(0.002f);
+
+    test_format();
+    test_build();
+    test_bound();
+    test_select();
+    test_certify();
+    test_speed();
+
+    free(g_buf);
+    free(g_scratch);
+    free(g_w);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_shortlist tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,570 @@
+// test_llmk_spec.c — Prompt-lookup speculative decoding
+//
+// Tests:
+//   propose: drafts continue the longest earlier match of the history tail
+//   (the most recent on ties), run through the tail on loops and equal a
+//   brute-force search over random repetitive histories; rolling the index
+//   back and re-appending gives the same drafts as a fresh index
+//   kernels: matmul_batch and matmul_q8_0_batch (f32 / int8 activations)
+//   are bit-identical to one matmul per row
+//   batch: transformer_forward_batch leaves the same logits and KV rows as
+//   one transformer_forward per position, for f32 and Q8_0 weights, int8
+//   activations, grouped-query heads and the classifier shortlist
+//   generate: turns with drafts of 1..8 tokens emit exactly the tokens of
+//   turns without, greedy and sampled, with penalties, across turns
+//   eval: llmk_host_spec_eval on copy-heavy prompts reports acceptance and
+//   decode tok/s with and without drafts
+//   bench: on a wider model, cost per position of verifying 1..9 positions
+//   in one batch vs one forward each (what an accepted draft saves)
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test_llmk_spec
+//
+// Run:
+//   ../engine/host/test_llmk_spec
+
+#include "../engine/host/llmk_host_rt.c"
+
+#include "llmk_test_model.h"
+
+#include <math.h>
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+// ============================================================
+// Drafts
+// ============================================================
+enum { P_CAP = 512 };
+static LlmkSpec P;
+static void *g_p_mem;
+
+static void spec_new(int min_ngram, int max_ngram) {
+    uint64_t bytes = llmk_spec_bytes(P_CAP);
+    free(g_p_mem);
+    g_p_mem = malloc((size_t)bytes);
+    llmk_spec_init(&P, g_p_mem, bytes, P_CAP, min_ngram, max_ngram);
+    P.max_chain = 1 << 30;                  // compare with the unbounded search
+}
+
+// Longest match (min..max tokens) of the tail at an earlier position, the
+// most recent on ties; then the copy, reading its own output past the tail
+static int ref_propose(const int *hist, int n, int min_ngram, int max_ngram, int k, int *draft) {
+    if (n < min_ngram + 1) return 0;
+    int best = -1, best_len = 0;
+    for (int p = n - 2; p >= 0; p--) {
+        int len = 0;
+        while (len < max_ngram && p - len >= 0 && hist[p - len] == hist[n - 1 - len]) len++;
+        if (len >= min_ngram && len > best_len) {
+            best = p;
+            best_len = len;
+        }
+    }
+    if (best < 0) return 0;
+    for (int j = 0; j < k; j++) {
+        int src = best + 1 + j;
+        draft[j] = src < n ? hist[src] : draft[src - n];
+    }
+    return k;
+}
+
+static int next_token(const int *hist, int n, int vocab) {
+    if (n > 8 && (rnd() & 1)) {
+        int back = 2 + (int)(rnd() % (uint32_t)(n < 40 ? n - 1 : 39));
+        return hist[n - back];
+    }
+    return (int)(rnd() % (uint32_t)vocab);
+}
+
+static void test_propose(void) {
+    printf("\n=== propose ===\n");
+    int d[LLMK_SPEC_MAX_DRAFT];
+
+    // a b c d x a b c  →  d x a b
+    int h1[] = { 1, 2, 3, 4, 9, 1, 2, 3 };
+    spec_new(2, 8);
+    llmk_spec_sync(&P, h1, 8);
+    int n = llmk_spec_propose(&P, h1, 4, d);
+    ASSERT_TRUE(n == 4 && d[0] == 4 && d[1] == 9 && d[2] == 1 && d[3] == 2, "copies what followed the earlier match");
+    ASSERT_EQ((int)P.last_match, 3, "match extended back over a b c");
+
+    // x b c 5 ... a b c 6 ... a b c  →  the a b c occurrence wins
+    int h2[] = { 7, 2, 3, 5, 8, 1, 2, 3, 6, 8, 8, 1, 2, 3 };
+    spec_new(2, 8);
+    llmk_spec_sync(&P, h2, 14);
+    n = llmk_spec_propose(&P, h2, 2, d);
+    ASSERT_TRUE(n == 2 && d[0] == 6 && d[1] == 8, "longest match preferred over a more recent shorter one");
+
+    // Loop of period 3: the draft continues the period
+    int h3[] = { 5, 1, 2, 3, 1, 2, 3 };
+    spec_new(2, 8);
+    llmk_spec_sync(&P, h3, 7);
+    n = llmk_spec_propose(&P, h3, 8, d);
+    int loop = n == 8;
+    for (int j = 0; j < n; j++) loop &= d[j] == 1 + j % 3;
+    ASSERT_TRUE(loop, "a loop drafts its period past the end of the history");
+
+    int h4[] = { 1, 2, 3, 4, 5, 6 };
+    spec_new(2, 8);
+    llmk_spec_sync(&P, h4, 6);
+    ASSERT_EQ(llmk_spec_propose(&P, h4, 4, d), 0, "no earlier occurrence: no draft");
+    ASSERT_EQ(llmk_spec_propose(&P, h1, 0, d), 0, "k = 0: no draft");
+
+    // Random repetitive histories vs the brute force, with rollbacks
+    int hist[P_CAP];
+    int bad = 0, drafted = 0, checks = 0;
+    for (int round = 0; round < 6; round++) {
+        int mn = 1 + round % 3, mx = 4 + round;
+        spec_new(mn, mx);
+        int hn = 0;
+        for (int step = 0; step < 3000; step++) {
+            uint32_t op = rnd() % 8;
+            if (op == 0 && hn > 0) {
+                hn -= 1 + (int)(rnd() % (uint32_t)(hn < 12 ? hn : 12));
+            } else if (hn < P_CAP) {
+                hist[hn] = next_token(hist, hn, 12);
+                hn++;
+            }
+            llmk_spec_sync(&P, hist, hn);
+            int k = 1 + (int)(rnd() % LLMK_SPEC_MAX_DRAFT);
+            int a[LLMK_SPEC_MAX_DRAFT], b[LLMK_SPEC_MAX_DRAFT];
+            int na = llmk_spec_propose(&P, hist, k, a);
+            int nb = ref_propose(hist, hn, mn, mx, k, b);
+            bad += na != nb || memcmp(a, b, sizeof(int) * (size_t)na) != 0;
+            drafted += na > 0;
+            checks++;
+        }
+    }
+    printf("    %d proposals checked, %d drafted\n", checks, drafted);
+    ASSERT_EQ(bad, 0, "drafts equal the brute-force search through appends and rollbacks");
+
+    // Back to 0 the table is empty again
+    spec_new(2, 8);
+    for (int i = 0; i < 300; i++) hist[i] = next_token(hist, i, 20);
+    llmk_spec_sync(&P, hist, 300);
+    llmk_spec_sync(&P, hist, 0);
+    int empty = 1;
+    for (uint32_t i = 0; i <= P.mask; i++) empty &= P.head[i] == -1;
+    ASSERT_TRUE(empty && P.n == 0, "rollback to 0 empties every chain");
+}
+
+// ============================================================
+// Batched kernels
+// ============================================================
+static uint16_t f32_to_f16(float f) {
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    uint32_t sign = (u >> 16) & 0x8000u;
+    int exp = (int)((u >> 23) & 0xFF) - 127 + 15;
+    if ((u & 0x7FFFFFFFu) == 0 || exp <= 0) return (uint16_t)sign;
+    if (exp >= 31) return (uint16_t)(sign | 0x7BFFu);
+    return (uint16_t)(sign | ((uint32_t)exp << 10) | ((u >> 13) & 0x3FFu));
+}
+
+// rows x cols f32 → Q8_0 rows (cols % 32 == 0)
+static uint8_t *quantize_q8(const float *w, int rows, int cols) {
+    uint64_t rb = llmk_q8_0_row_bytes(cols);
+    uint8_t *q = (uint8_t *)malloc((size_t)(rb * (uint64_t)rows) + 64);
+    for (int r = 0; r < rows; r++) {
+        uint8_t *p = q + (size_t)r * rb;
+        for (int b = 0; b < cols / 32; b++) {
+            const float *x = w + (size_t)r * cols + b * 32;
+            float amax = 0.0f;
+            for (int i = 0; i < 32; i++) amax = fabsf(x[i]) > amax ? fabsf(x[i]) : amax;
+            uint16_t h = f32_to_f16(amax / 127.0f);
+            float d = llmk_fp16_to_fp32(h);
+            p[0] = (uint8_t)(h & 0xFF);
+            p[1] = (uint8_t)(h >> 8);
+            for (int i = 0; i < 32; i++) {
+                float v = d > 0.0f ? x[i] / d : 0.0f;
+                int iv = (int)lrintf(v);
+                p[2 + i] = (uint8_t)(int8_t)(iv < -127 ? -127 : (iv > 127 ? 127 : iv));
+            }
+            p += 34;
+        }
+    }
+    return q;
+}
+
+static void test_kernels(void) {
+    printf("\n=== kernels ===\n");
+    static const int shapes[][3] = { { 32, 7, 1 }, { 64, 48, 3 }, { 96, 130, 5 }, { 45, 33, 9 }, { 288, 17, 16 } };
+    int f32_ok = 1, q8_ok = 1, i8_ok = 1;
+    llmk_q8_act_ensure(512);                // the int8 buffers only grow: size them once
+    for (unsigned s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        int n = shapes[s][0], d = shapes[s][1], nt = shapes[s][2];
+        int rows = (nt + 3) & ~3;
+        // One spare W row: djiblas reads whole groups of 4 rows on the one-row path
+        float *w = (float *)calloc((size_t)(d + 4) * n, sizeof(float));
+        float *x = (float *)calloc((size_t)rows * n, sizeof(float));
+        float *ref = (float *)malloc((size_t)nt * d * sizeof(float));
+        float *got = (float *)malloc((size_t)nt * d * sizeof(float));
+        for (int i = 0; i < d * n; i++) w[i] = rndf(1.0f);
+        for (int i = 0; i < nt * n; i++) x[i] = rndf(1.0f);
+
+        for (int t = 0; t < nt; t++) matmul(ref + t * d, x + t * n, w, n, d);
+        matmul_batch(got, x, w, n, d, nt);
+        f32_ok &= memcmp(ref, got, sizeof(float) * (size_t)nt * d) == 0;
+
+        if (n % 32 == 0) {
+            uint8_t *q = quantize_q8(w, d, n);
+            for (int mode = 0; mode <= 1; mode++) {
+                g_cfg_q8_act_quant = mode;
+                for (int t = 0; t < nt; t++) matmul_q8_0(ref + t * d, x + t * n, q, n, d);
+                matmul_q8_0_batch(got, x, q, n, d, nt);
+                int same = memcmp(ref, got, sizeof(float) * (size_t)nt * d) == 0;
+                if (mode) i8_ok &= same; else q8_ok &= same;
+            }
+            for (int t = 0; t < nt; t++) matmul_q8_0_scalar(ref + t * d, x + t * n, q, n, d);
+            matmul_q8_0_scalar_batch(got, x, q, n, d, nt);
+            q8_ok &= memcmp(ref, got, sizeof(float) * (size_t)nt * d) == 0;
+            g_cfg_q8_act_quant = 0;
+            free(q);
+        }
+        free(w);
+        free(x);
+        free(ref);
+        free(got);
+    }
+    ASSERT_TRUE(f32_ok, "matmul_batch rows are bit-identical to matmul");
+    ASSERT_TRUE(q8_ok, "matmul_q8_0_batch (AVX2 / scalar) rows are bit-identical to matmul_q8_0");
+    ASSERT_TRUE(i8_ok, "int8-activation rows are bit-identical too");
+}
+
+// ============================================================
+// Synthetic llama2.c model
+// ============================================================
+static int H_DIM = 64, H_HID = 160, H_LAYERS = 2, H_HEADS = 4, H_KV = 2, H_VOCAB = 288, H_SEQ = 512;
+static const char *k_model = "/tmp/test_llmk_spec_model.bin";
+static const char *k_tok = "/tmp/test_llmk_spec_tok.bin";
+
+static int write_model(void) {
+    LlmkTestModel m = { H_DIM, H_HID, H_LAYERS, H_HEADS, H_KV, H_VOCAB, H_SEQ, 1.0f, 0.3f, 0.2f, 0, 0 };
+    return llmk_test_write_model(k_model, &m);
+}
+
+// <unk> <s> </s>, printable ASCII, a few words, then filler pieces
+static const char *const k_words[] = { "The", " quick", " brown", " fox", " jumps", " over", " the", " lazy",
+                                       " dog", ". ", ", " };
+
+static int write_tokenizer(void) {
+    LlmkTestTok t = { H_VOCAB, 0, -1000.0f, k_words, (int)(sizeof(k_words) / sizeof(k_words[0])), 0, -1000.0f, "#w%d#" };
+    return llmk_test_write_tokenizer(k_tok, &t);
+}
+
+// Q8_0 copy of the loaded f32 weights (kind 1), freed by q8_free
+static uint8_t *g_q8_parts[16];
+static int g_q8_nparts;
+
+static const UINT8 *q8_part(const float *w, int rows, int cols) {
+    uint8_t *q = quantize_q8(w, rows, cols);
+    g_q8_parts[g_q8_nparts++] = q;
+    return q;
+}
+
+static TransformerWeights q8_weights(void) {
+    TransformerWeights q = g_weights;
+    Config *c = &g_config;
+    int kvd = c->dim * c->n_kv_heads / c->n_heads, L = c->n_layers;
+    uint64_t rd = llmk_q8_0_row_bytes(c->dim), rh = llmk_q8_0_row_bytes(c->hidden_dim);
+    q.kind = 1;
+    q.token_embedding_table_q8 = q8_part(g_weights.token_embedding_table, c->vocab_size, c->dim);
+    q.wcls_q8 = q8_part(g_weights.wcls, c->vocab_size, c->dim);
+    q.wq_q8 = q8_part(g_weights.wq, L * c->dim, c->dim);
+    q.wk_q8 = q8_part(g_weights.wk, L * kvd, c->dim);
+    q.wv_q8 = q8_part(g_weights.wv, L * kvd, c->dim);
+    q.wo_q8 = q8_part(g_weights.wo, L * c->dim, c->dim);
+    q.w1_q8 = q8_part(g_weights.w1, L * c->hidden_dim, c->dim);
+    q.w3_q8 = q8_part(g_weights.w3, L * c->hidden_dim, c->dim);
+    q.w2_q8 = q8_part(g_weights.w2, L * c->dim, c->hidden_dim);
+    q.tok_embd_row_bytes = rd;
+    q.wq_layer_bytes = rd * (uint64_t)c->dim;
+    q.wk_layer_bytes = rd * (uint64_t)kvd;
+    q.wv_layer_bytes = rd * (uint64_t)kvd;
+    q.wo_layer_bytes = rd * (uint64_t)c->dim;
+    q.w1_layer_bytes = rd * (uint64_t)c->hidden_dim;
+    q.w3_layer_bytes = rd * (uint64_t)c->hidden_dim;
+    q.w2_layer_bytes = rh * (uint64_t)c->dim;
+    return q;
+}
+
+static void q8_free(void) {
+    for (int i = 0; i < g_q8_nparts; i++) free(g_q8_parts[i]);
+    g_q8_nparts = 0;
+}
+
+// ============================================================
+// Batched forward
+// ============================================================
+
+// Sequential vs batched over tokens[0..nt) after a prefill of n_pre tokens:
+// logits and the KV rows written must be bit-identical
+static int batch_matches(TransformerWeights *w, const int *pre, int n_pre, const int *tokens, int nt) {
+    Config *c = &g_config;
+    int vocab = c->vocab_size;
+    size_t kv = (size_t)c->n_layers * c->seq_len * (c->dim * c->n_kv_heads / c->n_heads);
+    float *ref = (float *)malloc(sizeof(float) * (size_t)nt * vocab);
+    float *kref = (float *)malloc(sizeof(float) * kv);
+    float *vref = (float *)malloc(sizeof(float) * kv);
+
+    llmk_host_reset();
+    for (int i = 0; i < n_pre; i++) transformer_forward(&g_state, w, c, pre[i], i);
+    for (int t = 0; t < nt; t++) {
+        transformer_forward(&g_state, w, c, tokens[t], n_pre + t);
+        memcpy(ref + (size_t)t * vocab, g_state.logits, sizeof(float) * (size_t)vocab);
+    }
+    memcpy(kref, g_state.key_cache, sizeof(float) * kv);
+    memcpy(vref, g_state.value_cache, sizeof(float) * kv);
+
+    llmk_host_reset();
+    for (int i = 0; i < n_pre; i++) transformer_forward(&g_state, w, c, pre[i], i);
+    int done = transformer_forward_batch(&g_state, w, c, &g_spec_batch, tokens, nt, n_pre);
+    int ok = done == nt && memcmp(ref, g_spec_batch.logits, sizeof(float) * (size_t)nt * vocab) == 0 &&
+             memcmp(kref, g_state.key_cache, sizeof(float) * kv) == 0 &&
+             memcmp(vref, g_state.value_cache, sizeof(float) * kv) == 0;
+    free(ref);
+    free(kref);
+    free(vref);
+    return ok;
+}
+
+static int batch_matches_random(TransformerWeights *w, int rounds) {
+    int ok = 1;
+    for (int r = 0; r < rounds; r++) {
+        int pre[64], toks[LLMK_SPEC_MAX_DRAFT + 1];
+        int n_pre = 1 + (int)(rnd() % 60), nt = 1 + (int)(rnd() % (LLMK_SPEC_MAX_DRAFT + 1));
+        for (int i = 0; i < n_pre; i++) pre[i] = 3 + (int)(rnd() % (uint32_t)(g_config.vocab_size - 3));
+        for (int i = 0; i < nt; i++) toks[i] = 3 + (int)(rnd() % (uint32_t)(g_config.vocab_size - 3));
+        ok &= batch_matches(w, pre, n_pre, toks, nt);
+    }
+    return ok;
+}
+
+static void test_batch(void) {
+    printf("\n=== batch ===\n");
+    ASSERT_EQ(g_spec_batch.cap, LLMK_SPEC_MAX_DRAFT + 1, "verification batch allocated at load");
+    ASSERT_TRUE(batch_matches_random(&g_weights, 12), "f32 weights: batched logits and KV rows == sequential");
+
+    TransformerWeights q = q8_weights();
+    int q8_ok = 1, i8_ok = 1, ffn_ok = 1;
+    q8_ok = batch_matches_random(&q, 8);
+    llmk_host_set_q8_act(1);
+    i8_ok = batch_matches_random(&q, 8);
+    llmk_host_set_q8_act(2);
+    ffn_ok = batch_matches_random(&q, 8);
+    llmk_host_set_q8_act(0);
+    ASSERT_TRUE(q8_ok, "Q8_0 weights: batched == sequential");
+    ASSERT_TRUE(i8_ok, "Q8_0 + int8 activations: batched == sequential");
+    ASSERT_TRUE(ffn_ok, "Q8_0 + int8 FFN activations: batched == sequential");
+    q8_free();
+
+    ASSERT_EQ(llmk_host_shortlist_build(NULL, 8, 2), 0, "classifier shortlist built");
+    llmk_host_shortlist_set_k(32);
+    int sl_ok = batch_matches_random(&g_weights, 6);
+    g_llmk_shortlist.verify_top1 = 1;
+    sl_ok &= batch_matches_random(&g_weights, 6);
+    g_llmk_shortlist.verify_top1 = 0;
+    llmk_host_shortlist_enable(0);
+    ASSERT_TRUE(sl_ok, "shortlist classifier (with and without verify_top1): batched == sequential");
+
+    uint32_t calls0 = g_metrics.total_decode_calls, toks0 = g_metrics.total_decode_tokens;
+    int toks[5] = { 10, 11, 12, 13, 14 };
+    llmk_host_reset();
+    transformer_forward(&g_state, &g_weights, &g_config, 5, 0);
+    transformer_forward_batch(&g_state, &g_weights, &g_config, &g_spec_batch, toks, 5, 1);
+    ASSERT_TRUE(g_metrics.total_decode_calls == calls0 + 1 && g_metrics.total_decode_tokens == toks0 + 5,
+                "one decode call, five positions in the metrics");
+}
+
+// ============================================================
+// Generation through the host runtime
+// ============================================================
+static int g_base_ids[LLMK_HOST_MAX_TOKENS], g_base_n;
+
+// Same turn(s) with spec off and on: identical token streams
+static int turns_identical(LlmkHostGen *g, const char *const *prompts, int n_prompts, int k, unsigned seed,
+                           int *proposed, int *accepted) {
+    int ids[8][LLMK_HOST_MAX_TOKENS], n_ids[8];
+    LlmkHostTurn t;
+    llmk_host_set_spec(0);
+    llmk_host_set_seed(seed, 0);
+    llmk_host_reset();
+    for (int i = 0; i < n_prompts; i++) {
+        llmk_host_generate(prompts[i], g, &t);
+        n_ids[i] = g_turn_n;
+        memcpy(ids[i], g_turn_ids, sizeof(int) * (size_t)g_turn_n);
+    }
+    int kv_pos = g_gen.pos;
+    llmk_host_set_spec(k);
+    llmk_host_set_seed(seed, 0);
+    llmk_host_reset();
+    int same = 1;
+    for (int i = 0; i < n_prompts; i++) {
+        llmk_host_generate(prompts[i], g, &t);
+        same &= g_turn_n == n_ids[i] && memcmp(ids[i], g_turn_ids, sizeof(int) * (size_t)g_turn_n) == 0;
+        *proposed += t.spec_proposed;
+        *accepted += t.spec_accepted;
+    }
+    same &= g_gen.pos == kv_pos;
+    llmk_host_set_spec(0);
+    return same;
+}
+
+static const char *k_copy =
+    "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog. "
+    "The quick brown fox jumps over the lazy dog. The quick brown fox";
+
+static void test_generate(void) {
+    printf("\n=== generate ===\n");
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+    g.chat_format = LLMK_HOST_CHAT_RAW;
+    g.stats = 0;
+    g.echo = 0;
+    g.stop_on_you = 0;
+    g.stop_on_double_nl = 0;
+    g.max_gen_tokens = 120;
+
+    const char *one[] = { k_copy };
+    const char *two[] = { "abcabcabcabc", "abc abc abc" };
+    int proposed = 0, accepted = 0, greedy = 1, sampled = 1, plain = 1, multi = 1;
+
+    g.temperature = 0.0f;
+    for (int k = 1; k <= LLMK_SPEC_MAX_DRAFT; k++) greedy &= turns_identical(&g, one, 1, k, 1, &proposed, &accepted);
+    ASSERT_TRUE(greedy, "greedy, default penalties: k = 1..8 emit the same tokens as k = 0");
+
+    g.temperature = 0.8f;
+    for (unsigned seed = 1; seed <= 6; seed++) sampled &= turns_identical(&g, one, 1, 4, seed, &proposed, &accepted);
+    ASSERT_TRUE(sampled, "sampled (temp 0.8, top-p, min-p): same tokens for six seeds");
+
+    g.temperature = 0.0f;
+    g.no_repeat_ngram = 0;
+    g.repeat_penalty = 1.0f;
+    int p0 = proposed, a0 = accepted;
+    for (int k = 2; k <= LLMK_SPEC_MAX_DRAFT; k += 3) plain &= turns_identical(&g, one, 1, k, 1, &proposed, &accepted);
+    ASSERT_TRUE(plain, "greedy without penalties: same tokens");
+    ASSERT_TRUE(accepted - a0 > 0 && proposed - p0 > 0, "drafts accepted on a copy-heavy prompt");
+
+    g.repeat_penalty = 1.15f;
+    g.freq_penalty = 0.2f;
+    g.presence_penalty = 0.1f;
+    g.no_repeat_ngram = 3;
+    g.temperature = 0.7f;
+    g.max_gen_tokens = 60;
+    multi &= turns_identical(&g, two, 2, 6, 9, &proposed, &accepted);
+    ASSERT_TRUE(multi, "two turns with all penalties: same tokens and the same KV position");
+    printf("    %d draft tokens verified, %d accepted (%.1f%%)\n", proposed, accepted,
+           proposed ? 100.0 * accepted / proposed : 0.0);
+}
+
+// ============================================================
+// Eval: acceptance and tok/s
+// ============================================================
+static void test_eval(void) {
+    printf("\n=== eval ===\n");
+    LlmkHostGen g;
+    llmk_host_gen_defaults(&g);
+    g.temperature = 0.0f;
+    g.no_repeat_ngram = 0;
+    g.repeat_penalty = 1.0f;
+    g.stop_on_you = 0;
+    g.stop_on_double_nl = 0;
+    g.max_gen_tokens = 200;
+
+    LlmkHostSpecEval e;
+    int ok = 1, identical = 1, accepted = 0;
+    const char *prompts[] = { k_copy, "1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2," };
+    for (int i = 0; i < 2; i++) {
+        for (int k = 2; k <= LLMK_SPEC_MAX_DRAFT; k *= 2) {
+            ok &= llmk_host_spec_eval(prompts[i], &g, k, &e) == 0;
+            identical &= e.identical;
+            accepted += e.accepted;
+        }
+    }
+    ASSERT_TRUE(ok && identical, "spec eval: outputs identical with and without drafts");
+    ASSERT_TRUE(accepted > 0, "spec eval: drafts accepted");
+    ASSERT_TRUE(g_gen.pos == 0 && g_spec_k == 0, "spec eval leaves the cache reset and speculation as it was");
+}
+
+// ============================================================
+// Bench: verification cost per position
+// ============================================================
+static double now_us(void) {
+    return (double)host_now_us();
+}
+
+static void test_bench(void) {
+    H_DIM = 512; H_HID = 1376; H_LAYERS = 4; H_HEADS = 8; H_KV = 8; H_VOCAB = 2048; H_SEQ = 256;
+    printf("\n=== bench (dim %d, hidden %d, %d layers, vocab %d) ===\n", H_DIM, H_HID, H_LAYERS, H_VOCAB);
+    ASSERT_TRUE(write_model() == 0 && write_tokenizer() == 0 && llmk_host_load(k_model, k_tok, 0) == 0,
+                "wider model loads");
+    int toks[LLMK_SPEC_MAX_DRAFT + 1];
+    for (int i = 0; i <= LLMK_SPEC_MAX_DRAFT; i++) toks[i] = 100 + i;
+    const int reps = 8;
+    for (int nt = 1; nt <= LLMK_SPEC_MAX_DRAFT + 1; nt++) {
+        llmk_host_reset();
+        double t0 = now_us();
+        for (int r = 0; r < reps; r++) {
+            for (int t = 0; t < nt; t++) transformer_forward(&g_state, &g_weights, &g_config, toks[t], 16 + t);
+        }
+        double t1 = now_us();
+        for (int r = 0; r < reps; r++) transformer_forward_batch(&g_state, &g_weights, &g_config, &g_spec_batch, toks, nt, 16);
+        double t2 = now_us();
+        double per_seq = (t1 - t0) / (reps * nt), per_batch = (t2 - t1) / (reps * nt);
+        printf("    %d positions: %.0f us/position sequential, %.0f us/position batched (x%.2f)\n", nt, per_seq,
+               per_batch, per_batch > 0.0 ? per_seq / per_batch : 0.0);
+    }
+    llmk_host_unload();
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_spec speculative decoding tests\n");
+    printf("========================================\n");
+
+    test_propose();
+    test_kernels();
+
+    printf("\n=== host runtime ===\n");
+    ASSERT_TRUE(write_model() == 0 && write_tokenizer() == 0, "llama2.c model (GQA) + tokenizer.bin written");
+    ASSERT_EQ(llmk_host_load(k_model, k_tok, 0), 0, "model loads");
+    test_batch();
+    test_generate();
+    test_eval();
+    llmk_host_unload();
+    test_bench();
+
+    ASSERT_TRUE(g_spec_mem == NULL && g_spec_batch_mem == NULL, "unload releases the draft index and batch");
+    remove(k_model);
+    remove(k_tok);
+    free(g_p_mem);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_spec tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
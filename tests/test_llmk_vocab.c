@@ -0,0 +1,788 @@
+// test_llmk_vocab.c — Tokenizer built from GGUF metadata (llmk_vocab.c)
+//
+// Tests:
+//   SPM   hand-checked splits (score order, "▁" prefix, byte fallback,
+//         special tokens), then random strings against a naive reference
+//         that rescans every adjacent pair with a linear vocabulary search
+//   BPE   a byte-level BPE trained inside the test on a random corpus;
+//         random strings encoded under the gpt2, llama3 and qwen2 pre-splits
+//         are compared with a naive rank-order reference, pre-split word
+//         boundaries are checked by hand against the regexes
+//   Both  special tokens matched longest first, decode round-trips, stop ids
+//   GGUF  tokenizer.ggml.* arrays in a tiny llama model: the host loads it
+//         without any tokenizer.bin, encodes, decodes and stops on the
+//         vocabulary's end-of-turn token; --tokenizer still wins
+//
+// Build (Linux, host, no UEFI):
+//   make -C ../engine/host test
+//
+// Run:
+//   ../engine/host/test_llmk_vocab
+
+#include "../engine/host/llmk_host_rt.c"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+// ============================================================
+// Test vocabulary: plain arrays, indexed by llmk_vocab_build
+// ============================================================
+enum { TV_MAX = 2048 };
+static struct {
+    char   *piece[TV_MAX];
+    float   score[TV_MAX];
+    int32_t type[TV_MAX];
+    int     n;
+    char   *merge[TV_MAX];
+    int     n_merges;
+} T;
+static LlmkVocab V;
+static uint8_t g_tables[1 << 20];
+
+static void tv_reset(void) {
+    for (int i = 0; i < T.n; i++) free(T.piece[i]);
+    for (int i = 0; i < T.n_merges; i++) free(T.merge[i]);
+    T.n = T.n_merges = 0;
+}
+
+static int tv_add(const char *s, float score, int type) {
+    T.piece[T.n] = strdup(s);
+    T.score[T.n] = score;
+    T.type[T.n] = type;
+    return T.n++;
+}
+
+// Reference lookup: linear scan, last duplicate wins
+static int tv_find(const char *s, int n) {
+    for (int i = T.n - 1; i >= 0; i--) {
+        if ((int)strlen(T.piece[i]) == n && memcmp(T.piece[i], s, (size_t)n) == 0) return i;
+    }
+    return -1;
+}
+
+static int tv_build(int kind, int pre, int bos, int eos, int eot, int unk) {
+    memset(&V, 0, sizeof(V));
+    V.kind = kind;
+    V.pre = pre;
+    V.n_tokens = T.n;
+    V.piece = T.piece;
+    V.score = T.score;
+    V.type = T.type;
+    V.n_merges = T.n_merges;
+    V.merge = T.merge;
+    V.bos_id = bos;
+    V.eos_id = eos;
+    V.eot_id = eot;
+    V.unk_id = unk;
+    V.add_bos = (kind == LLMK_VOCAB_SPM);
+    V.add_space_prefix = (kind == LLMK_VOCAB_SPM);
+    V.table_mem = g_tables;
+    V.table_bytes = llmk_vocab_table_bytes(T.n, T.n_merges);
+    if (V.table_bytes > sizeof(g_tables)) return -1;
+    return llmk_vocab_build(&V);
+}
+
+// Longest special token at text[i] (naive: every special, every length)
+static int ref_special_at(const char *s, int n, int i, int *len) {
+    int best = -1, best_len = 0;
+    for (int id = 0; id < T.n; id++) {
+        const int t = T.type[id];
+        if (t != LLMK_TOKTYPE_CONTROL && t != LLMK_TOKTYPE_USER_DEFINED && t != LLMK_TOKTYPE_UNKNOWN) continue;
+        const int m = (int)strlen(T.piece[id]);
+        if (m > best_len && i + m <= n && memcmp(s + i, T.piece[id], (size_t)m) == 0) {
+            best = id;
+            best_len = m;
+        }
+    }
+    *len = best_len;
+    return best;
+}
+
+static int utf8_len(uint8_t c) {
+    return c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+}
+
+// ============================================================
+// SPM reference: O(n^2) rescans of every adjacent pair
+// ============================================================
+static void ref_spm_fragment(const char *s, int n, int prefix, int *out, int *n_out) {
+    char esc[1024];
+    int m = 0;
+    if (prefix) { memcpy(esc, "\xE2\x96\x81", 3); m = 3; }
+    for (int i = 0; i < n; i++) {
+        if (s[i] == ' ') { memcpy(esc + m, "\xE2\x96\x81", 3); m += 3; }
+        else esc[m++] = s[i];
+    }
+    int start[512], len[512], ns = 0;
+    for (int i = 0; i < m; i += utf8_len((uint8_t)esc[i])) {
+        start[ns] = i;
+        len[ns++] = utf8_len((uint8_t)esc[i]);
+    }
+    for (;;) {
+        int best = -1;
+        float best_score = 0.0f;
+        for (int i = 0; i + 1 < ns; i++) {
+            const int id = tv_find(esc + start[i], len[i] + len[i + 1]);
+            if (id >= 0 && (best < 0 || T.score[id] > best_score)) {
+                best = i;
+                best_score = T.score[id];
+            }
+        }
+        if (best < 0) break;
+        len[best] += len[best + 1];
+        for (int i = best + 1; i + 1 < ns; i++) { start[i] = start[i + 1]; len[i] = len[i + 1]; }
+        ns--;
+    }
+    for (int i = 0; i < ns; i++) {
+        const int id = tv_find(esc + start[i], len[i]);
+        if (id >= 0) { out[(*n_out)++] = id; continue; }
+        for (int k = 0; k < len[i]; k++) {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "<0x%02X>", (uint8_t)esc[start[i] + k]);
+            out[(*n_out)++] = tv_find(hex, 6);
+        }
+    }
+}
+
+// ============================================================
+// BPE reference: GPT-2 byte alphabet, merges applied by rank
+// ============================================================
+static uint32_t g_byte_cp[256];
+
+// bytes_to_unicode() from GPT-2's encoder.py
+static void init_byte_map(void) {
+    int n = 0;
+    for (int b = 0; b < 256; b++) {
+        const int printable = (b >= '!' && b <= '~') || (b >= 0xA1 && b <= 0xAC) || (b >= 0xAE);
+        g_byte_cp[b] = printable ? (uint32_t)b : 256u + (uint32_t)n++;
+    }
+}
+
+static int map_bytes(const char *s, int n, char *out) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        const uint32_t cp = g_byte_cp[(uint8_t)s[i]];
+        if (cp < 0x80) out[m++] = (char)cp;
+        else { out[m++] = (char)(0xC0 | (cp >> 6)); out[m++] = (char)(0x80 | (cp & 0x3F)); }
+    }
+    out[m] = 0;
+    return m;
+}
+
+static int ref_rank(int l, int r) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s %s", T.piece[l], T.piece[r]);
+    for (int k = 0; k < T.n_merges; k++) {
+        if (!strcmp(T.merge[k], buf)) return k;
+    }
+    return -1;
+}
+
+static void ref_bpe_word(const char *s, int n, int ignore_merges, int *out, int *n_out) {
+    char mapped[1024];
+    const int mm = map_bytes(s, n, mapped);
+    if (ignore_merges) {
+        const int id = tv_find(mapped, mm);
+        if (id >= 0) { out[(*n_out)++] = id; return; }
+    }
+    int sym[512], ns = 0;
+    for (int i = 0; i < n; i++) sym[ns++] = (uint8_t)s[i];    // byte b is token b
+    for (;;) {
+        int best = -1, best_rank = 0;
+        for (int i = 0; i + 1 < ns; i++) {
+            const int r = ref_rank(sym[i], sym[i + 1]);
+            if (r >= 0 && (best < 0 || r < best_rank)) { best = i; best_rank = r; }
+        }
+        if (best < 0) break;
+        char cat[256];
+        snprintf(cat, sizeof(cat), "%s%s", T.piece[sym[best]], T.piece[sym[best + 1]]);
+        sym[best] = tv_find(cat, (int)strlen(cat));
+        for (int i = best + 1; i + 1 < ns; i++) sym[i] = sym[i + 1];
+        ns--;
+    }
+    for (int i = 0; i < ns; i++) out[(*n_out)++] = sym[i];
+}
+
+// Full reference encode: specials first, then the fragments
+static int ref_encode(const char *s, int n, int add_bos, int *out) {
+    int n_out = 0, start = 0, prev_special = 1;
+    if (add_bos && V.add_bos && V.bos_id >= 0) out[n_out++] = V.bos_id;
+    for (int i = 0; i <= n;) {
+        int sp_len = 0;
+        const int sp = (i < n) ? ref_special_at(s, n, i, &sp_len) : -1;
+        if (i < n && sp < 0) { i++; continue; }
+        if (i > start) {
+            if (V.kind == LLMK_VOCAB_SPM) {
+                ref_spm_fragment(s + start, i - start, prev_special && V.add_space_prefix, out, &n_out);
+            } else {
+                // word boundaries from the engine's pre-split (checked by hand below)
+                for (int w = start; w < i;) {
+                    int e = vocab_pre_next(&V, s + start, i - start, w - start) + start;
+                    if (e <= w) e = w + 1;
+                    ref_bpe_word(s + w, e - w, V.pre == LLMK_VOCAB_PRE_LLAMA3, out, &n_out);
+                    w = e;
+                }
+            }
+            prev_special = 0;
+        }
+        if (i == n) break;
+        out[n_out++] = sp;
+        prev_special = 1;
+        i += sp_len;
+        start = i;
+    }
+    return n_out;
+}
+
+static int decode_all(const int *ids, int n, char *out, int cap) {
+    int w = 0;
+    for (int i = 0; i < n; i++) w += llmk_vocab_decode(&V, ids[i], out + w, cap - w);
+    out[w] = 0;
+    return w;
+}
+
+static int random_text(char *buf, int cap, const char *const *alpha, int n_alpha, int max_parts) {
+    int w = 0;
+    const int parts = 1 + (int)(rnd() % (uint32_t)max_parts);
+    for (int p = 0; p < parts; p++) {
+        const char *a = alpha[rnd() % (uint32_t)n_alpha];
+        const int m = (int)strlen(a);
+        if (w + m >= cap) break;
+        memcpy(buf + w, a, (size_t)m);
+        w += m;
+    }
+    buf[w] = 0;
+    return w;
+}
+
+static int has_special(const char *s, int n) {
+    for (int i = 0; i < n; i++) {
+        int len = 0;
+        if (ref_special_at(s, n, i, &len) >= 0) return 1;
+    }
+    return 0;
+}
+
+// Random strings: engine ids == reference ids; decode returns the text
+static void fuzz(const char *name, const char *const *alpha, int n_alpha, int iters) {
+    char text[256], dec[1024], expect[512], msg[160];
+    int ids[512], ref[512];
+    int mism = 0, bad_round = 0, first = -1;
+    for (int it = 0; it < iters; it++) {
+        const int n = random_text(text, (int)sizeof(text), alpha, n_alpha, 24);
+        const int ne = llmk_vocab_encode(&V, text, n, 1, ids, 512);
+        const int nr = ref_encode(text, n, 1, ref);
+        if (ne != nr || memcmp(ids, ref, (size_t)ne * sizeof(int)) != 0) {
+            if (first < 0) { first = it; printf("  first mismatch: \"%s\" (%d vs %d ids)\n", text, ne, nr); }
+            mism++;
+        }
+        if (has_special(text, n)) continue;
+        snprintf(expect, sizeof(expect), "%s%s", V.add_space_prefix ? " " : "", text);
+        decode_all(ids, ne, dec, (int)sizeof(dec));
+        if (strcmp(dec, expect) != 0) bad_round++;
+    }
+    snprintf(msg, sizeof(msg), "%s: %d random strings match the naive reference", name, iters);
+    ASSERT_EQ(mism, 0, msg);
+    snprintf(msg, sizeof(msg), "%s: decode(encode(text)) == text", name);
+    ASSERT_EQ(bad_round, 0, msg);
+}
+
+static int expect_ids(const char *text, int add_bos, const int *want, int n_want) {
+    int ids[64];
+    const int n = llmk_vocab_encode(&V, text, (int)strlen(text), add_bos, ids, 64);
+    if (n != n_want) return 0;
+    for (int i = 0; i < n; i++) if (ids[i] != want[i]) return 0;
+    return 1;
+}
+
+// ============================================================
+// SPM: llama / mistral / gemma style vocabulary
+// ============================================================
+#define SP "\xE2\x96\x81"   // "▁"
+enum { S_UNK = 0, S_BOS = 1, S_EOS = 2 };
+static int s_sp, s_t, s_h, s_e, s_a, s_spt, s_he, s_spthe, s_spa, s_start, s_end;
+
+static void build_spm(int random_pieces) {
+    tv_reset();
+    tv_add("<unk>", 0.0f, LLMK_TOKTYPE_UNKNOWN);
+    tv_add("<s>", 0.0f, LLMK_TOKTYPE_CONTROL);
+    tv_add("</s>", 0.0f, LLMK_TOKTYPE_CONTROL);
+    for (int b = 0; b < 256; b++) {
+        char hex[8];
+        snprintf(hex, sizeof(hex), "<0x%02X>", b);
+        tv_add(hex, 0.0f, LLMK_TOKTYPE_BYTE);
+    }
+    s_start = tv_add("<start_of_turn>", 0.0f, LLMK_TOKTYPE_USER_DEFINED);
+    s_end = tv_add("<end_of_turn>", 0.0f, LLMK_TOKTYPE_CONTROL);
+    s_sp = tv_add(SP, -5.0f, LLMK_TOKTYPE_NORMAL);
+    s_t = tv_add("t", -6.0f, LLMK_TOKTYPE_NORMAL);
+    s_h = tv_add("h", -6.0f, LLMK_TOKTYPE_NORMAL);
+    s_e = tv_add("e", -6.0f, LLMK_TOKTYPE_NORMAL);
+    s_a = tv_add("a", -6.0f, LLMK_TOKTYPE_NORMAL);
+    s_spt = tv_add(SP "t", -3.0f, LLMK_TOKTYPE_NORMAL);
+    s_he = tv_add("he", -2.0f, LLMK_TOKTYPE_NORMAL);
+    s_spthe = tv_add(SP "the", -1.0f, LLMK_TOKTYPE_NORMAL);
+    s_spa = tv_add(SP "a", -4.0f, LLMK_TOKTYPE_NORMAL);
+
+    // random multi-character pieces over a small alphabet; coarse scores make ties
+    static const char *const ch[] = { SP, "a", "b", "c", "d", "\xC3\xA9", "\xE6\x97\xA5" };
+    for (int k = 0; k < random_pieces; k++) {
+        char buf[32];
+        int w = 0;
+        const int len = 2 + (int)(rnd() % 4);
+        for (int i = 0; i < len; i++) {
+            const char *c = ch[rnd() % 7];
+            memcpy(buf + w, c, strlen(c));
+            w += (int)strlen(c);
+        }
+        buf[w] = 0;
+        if (tv_find(buf, w) < 0) tv_add(buf, -(float)(rnd() % 12), LLMK_TOKTYPE_NORMAL);
+    }
+    for (int k = 0; k < 4; k++) {
+        if (tv_find(ch[1 + k], 1) < 0) tv_add(ch[1 + k], -7.0f, LLMK_TOKTYPE_NORMAL);
+    }
+}
+
+static void test_spm(void) {
+    printf("\n=== SPM (score-ordered merges, byte fallback) ===\n");
+    build_spm(0);
+    ASSERT_EQ(tv_build(LLMK_VOCAB_SPM, 0, S_BOS, S_EOS, -1, S_UNK), LLMK_VOCAB_OK, "llmk_vocab_build");
+    ASSERT_EQ(V.byte_id[0x41], 3 + 0x41, "byte_id maps <0x41>");
+    ASSERT_EQ(llmk_vocab_find(&V, SP "the", 6), s_spthe, "hash lookup of \"▁the\"");
+    ASSERT_EQ(llmk_vocab_find(&V, "zz", 2), -1, "unknown piece not found");
+
+    { int w[] = { S_BOS, s_spthe };
+      ASSERT_TRUE(expect_ids("the", 1, w, 2), "\"the\": he (-2) before ▁t (-3), then ▁the"); }
+    { int w[] = { s_spthe, s_spa };
+      ASSERT_TRUE(expect_ids("the a", 0, w, 2), "\"the a\" -> ▁the ▁a (no BOS requested)"); }
+    { int w[] = { s_spt, s_a, 3 + 'x' };
+      ASSERT_TRUE(expect_ids("tax", 0, w, 3), "\"tax\" -> ▁t a <0x78>"); }
+    { int w[] = { s_sp, 3 + 0xC3, 3 + 0xA9 };
+      ASSERT_TRUE(expect_ids("\xC3\xA9", 0, w, 3), "\"é\" falls back to its UTF-8 bytes"); }
+    { int w[] = { s_start, s_spthe, s_end };
+      ASSERT_TRUE(expect_ids("<start_of_turn>the<end_of_turn>", 0, w, 3),
+                  "special tokens matched literally; ▁ prefix after a special"); }
+    { int w[] = { s_spa, s_end, s_sp, s_h };
+      ASSERT_TRUE(expect_ids("a<end_of_turn>h", 0, w, 4), "text after a special gets the ▁ prefix again"); }
+
+    char out[64];
+    int n = llmk_vocab_decode(&V, s_spthe, out, 64);
+    ASSERT_TRUE(n == 4 && !memcmp(out, " the", 4), "decode ▁the -> \" the\"");
+    n = llmk_vocab_decode(&V, 3 + 0x0A, out, 64);
+    ASSERT_TRUE(n == 1 && out[0] == '\n', "decode <0x0A> -> newline byte");
+    ASSERT_EQ(llmk_vocab_decode(&V, s_end, out, 64), 0, "control token decodes to nothing");
+    n = llmk_vocab_decode(&V, s_start, out, 64);
+    ASSERT_TRUE(n == 15 && !memcmp(out, "<start_of_turn>", 15), "user-defined token decodes to its text");
+    ASSERT_EQ(llmk_vocab_decode(&V, s_spthe, out, 2), 2, "decode respects cap");
+
+    ASSERT_EQ(V.eot_id, s_end, "eot falls back to <end_of_turn> by name");
+    ASSERT_TRUE(llmk_vocab_is_stop(&V, S_EOS) && llmk_vocab_is_stop(&V, s_end) &&
+                !llmk_vocab_is_stop(&V, S_BOS) && !llmk_vocab_is_stop(&V, s_a),
+                "is_stop: EOS and EOT only");
+
+    int ids[8];
+    ASSERT_EQ(llmk_vocab_encode(&V, "the a the a", 11, 1, ids, 3), 3, "encode stops when ids is full");
+
+    build_spm(300);
+    ASSERT_EQ(tv_build(LLMK_VOCAB_SPM, 0, S_BOS, S_EOS, -1, S_UNK), LLMK_VOCAB_OK, "random SPM vocabulary built");
+    static const char *const alpha[] = { "a", "b", "c", "d", " ", "  ", "\xC3\xA9", "\xE6\x97\xA5", "x", "the",
+                                         "<end_of_turn>", "<start_of_turn>", "<unk>", "\n" };
+    fuzz("spm", alpha, (int)(sizeof(alpha) / sizeof(alpha[0])), 600);
+}
+
+// ============================================================
+// BPE: byte-level vocabulary trained here (qwen2 / llama3 style)
+// ============================================================
+static int b_eot, b_im_start, b_im_end, b_end, b_xyz;
+
+static void train_bpe(int n_merges) {
+    tv_reset();
+    char buf[8];
+    for (int b = 0; b < 256; b++) {
+        map_bytes((const char *)&(uint8_t){ (uint8_t)b }, 1, buf);
+        tv_add(buf, 0.0f, LLMK_TOKTYPE_NORMAL);
+    }
+
+    // corpus of space-led words; symbols are token ids
+    static const char *const ch[] = { "a", "b", "c", "d", "e", "\xC3\xA9", "\xE6\x97\xA5", "1", "'" };
+    static int words[400][24], wlen[400];
+    for (int w = 0; w < 400; w++) {
+        char s[32];
+        int m = 0;
+        if (rnd() % 10 < 7) s[m++] = ' ';
+        const int len = 1 + (int)(rnd() % 5);
+        for (int i = 0; i < len; i++) {
+            const char *c = ch[rnd() % 9];
+            memcpy(s + m, c, strlen(c));
+            m += (int)strlen(c);
+        }
+        for (int i = 0; i < m; i++) words[w][i] = (uint8_t)s[i];
+        wlen[w] = m;
+    }
+    static int count[512][512];
+    for (int r = 0; r < n_merges && T.n < 512; r++) {
+        memset(count, 0, sizeof(count));
+        int best_l = -1, best_r = -1, best_c = 0;
+        for (int w = 0; w < 400; w++) {
+            for (int i = 0; i + 1 < wlen[w]; i++) count[words[w][i]][words[w][i + 1]]++;
+        }
+        for (int l = 0; l < T.n; l++) {
+            for (int rr = 0; rr < T.n; rr++) {
+                if (count[l][rr] > best_c) { best_l = l; best_r = rr; best_c = count[l][rr]; }
+            }
+        }
+        if (best_c < 2) break;
+        char cat[128], rule[128];
+        snprintf(cat, sizeof(cat), "%s%s", T.piece[best_l], T.piece[best_r]);
+        snprintf(rule, sizeof(rule), "%s %s", T.piece[best_l], T.piece[best_r]);
+        int id = tv_find(cat, (int)strlen(cat));
+        if (id < 0) id = tv_add(cat, 0.0f, LLMK_TOKTYPE_NORMAL);
+        T.merge[T.n_merges++] = strdup(rule);
+        for (int w = 0; w < 400; w++) {
+            for (int i = 0; i + 1 < wlen[w]; i++) {
+                if (words[w][i] != best_l || words[w][i + 1] != best_r) continue;
+                words[w][i] = id;
+                for (int j = i + 1; j + 1 < wlen[w]; j++) words[w][j] = words[w][j + 1];
+                wlen[w]--;
+            }
+        }
+    }
+    // a whole word with no merge path to it (llama3 ignore_merges keeps it)
+    char mapped[32];
+    map_bytes(" xyz", 4, mapped);
+    b_xyz = tv_find(mapped, (int)strlen(mapped));
+    if (b_xyz < 0) b_xyz = tv_add(mapped, 0.0f, LLMK_TOKTYPE_NORMAL);
+    b_eot = tv_add("<|endoftext|>", 0.0f, LLMK_TOKTYPE_CONTROL);
+    b_end = tv_add("<|end|>", 0.0f, LLMK_TOKTYPE_CONTROL);
+    b_im_start = tv_add("<|im_start|>", 0.0f, LLMK_TOKTYPE_CONTROL);
+    b_im_end = tv_add("<|im_end|>", 0.0f, LLMK_TOKTYPE_CONTROL);
+}
+
+// Words of the pre-split joined with '|'
+static const char *presplit(int pre, const char *s) {
+    static char out[256];
+    int w = 0;
+    const int n = (int)strlen(s);
+    V.pre = pre;
+    for (int i = 0; i < n;) {
+        int e = vocab_pre_next(&V, s, n, i);
+        if (e <= i) e = i + 1;
+        if (i) out[w++] = '|';
+        memcpy(out + w, s + i, (size_t)(e - i));
+        w += e - i;
+        i = e;
+    }
+    out[w] = 0;
+    return out;
+}
+
+static void test_presplit(void) {
+    printf("\n=== BPE pre-split (regex word boundaries) ===\n");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_GPT2, "Hello world's  end\n"), "Hello| world|'s| | end|\n"),
+                "gpt2: contractions, \\s+(?!\\S) leaves one space for the next word");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_GPT2, "a 12345 !!?x"), "a| 12345| !!?|x"),
+                "gpt2: ' ?\\p{N}+' and ' ?[^\\s\\p{L}\\p{N}]+'");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_GPT2, "I'VE"), "I|'|VE"), "gpt2: contractions are case-sensitive");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_LLAMA3, "I'VE 12345 abc\n\n  x"), "I|'VE| |123|45| abc|\n\n| | x"),
+                "llama3: (?i) contractions, \\p{N}{1,3}, \\s*[\\r\\n]+");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_LLAMA3, "hi!\n\n(Hello"), "hi|!\n\n|(Hello"),
+                "llama3: punctuation keeps trailing newlines, one leading non-letter joins a word");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_QWEN2, "ab12 3"), "ab|1|2| |3"), "qwen2: one digit per word");
+    ASSERT_TRUE(!strcmp(presplit(LLMK_VOCAB_PRE_GPT2, "\xE6\x97\xA5\xE6\x9C\xAC \xC3\xA9t\xC3\xA9"),
+                        "\xE6\x97\xA5\xE6\x9C\xAC| \xC3\xA9t\xC3\xA9"),
+                "CJK and accented letters are \\p{L}");
+    ASSERT_EQ(llmk_vocab_cp_class(0x0663), LLMK_CP_NUMBER, "Arabic-Indic digit is \\p{N}");
+    ASSERT_EQ(llmk_vocab_cp_class(0x3000), LLMK_CP_SPACE, "ideographic space is \\s");
+    ASSERT_EQ(llmk_vocab_cp_class(0x3002), LLMK_CP_OTHER, "ideographic full stop is punctuation");
+}
+
+static void test_bpe(void) {
+    printf("\n=== BPE (byte-level, ranked merges) ===\n");
+    train_bpe(120);
+    printf("  trained: %d tokens, %d merges\n", T.n, T.n_merges);
+    ASSERT_EQ(tv_build(LLMK_VOCAB_BPE, LLMK_VOCAB_PRE_GPT2, -1, b_eot, -1, -1), LLMK_VOCAB_OK, "llmk_vocab_build");
+    ASSERT_EQ(V.byte_id[' '], ' ', "byte_id[' '] is the mapped Ġ token");
+    ASSERT_EQ(V.eot_id, b_im_end, "eot falls back to <|im_end|>");
+
+    { int w[] = { b_eot };
+      ASSERT_TRUE(expect_ids("<|endoftext|>", 1, w, 1), "longest special wins over <|end|>; no BOS for BPE"); }
+    { int w[] = { b_end, 'x' };
+      ASSERT_TRUE(expect_ids("<|end|>x", 0, w, 2), "<|end|> followed by text"); }
+
+    int ids[64];
+    int n = llmk_vocab_encode(&V, " xyz", 4, 0, ids, 64);
+    ASSERT_TRUE(n >= 1 && !(n == 1 && ids[0] == b_xyz), "gpt2: \" xyz\" is split into its bytes");
+    V.pre = LLMK_VOCAB_PRE_LLAMA3;
+    n = llmk_vocab_encode(&V, " xyz", 4, 0, ids, 64);
+    ASSERT_TRUE(n == 1 && ids[0] == b_xyz, "llama3: ignore_merges keeps a word that is already a token");
+
+    char out[64];
+    n = llmk_vocab_decode(&V, ' ', out, 64);
+    ASSERT_TRUE(n == 1 && out[0] == ' ', "decode Ġ -> space");
+    n = llmk_vocab_decode(&V, 0xC3, out, 64);
+    ASSERT_TRUE(n == 1 && (uint8_t)out[0] == 0xC3, "decode maps the GPT-2 alphabet back to raw bytes");
+    ASSERT_EQ(llmk_vocab_decode(&V, b_im_start, out, 64), 0, "control token decodes to nothing");
+
+    static const char *const alpha[] = { "a", "b", "c", "d", "e", " ", "  ", "\xC3\xA9", "\xE6\x97\xA5", "'s", "'LL",
+                                         "1", "234", "!", "?\n", "\n", "\t", "x", "<|im_end|>", "<|endoftext|>",
+                                         "<|end|>", " xyz", "\xFF" };
+    const int na = (int)(sizeof(alpha) / sizeof(alpha[0]));
+    V.pre = LLMK_VOCAB_PRE_GPT2;
+    fuzz("bpe/gpt2", alpha, na, 500);
+    V.pre = LLMK_VOCAB_PRE_LLAMA3;
+    fuzz("bpe/llama3", alpha, na, 500);
+    V.pre = LLMK_VOCAB_PRE_QWEN2;
+    fuzz("bpe/qwen2", alpha, na, 500);
+}
+
+// ============================================================
+// GGUF: tiny llama model carrying its tokenizer
+// ============================================================
+enum { G_DIM = 16, G_HID = 32, G_HEADS = 2, G_SEQ = 32 };
+static const char *k_gguf = "/tmp/test_llmk_vocab.gguf";
+static const char *k_tok = "/tmp/test_llmk_vocab_tok.bin";
+
+static uint8_t g_kv[1 << 16], g_info[4096], g_data[1 << 18];
+static size_t g_kv_len, g_info_len, g_data_len;
+static uint64_t g_n_kv, g_n_tensors;
+
+static void gw_put(uint8_t *buf, size_t *len, const void *p, size_t n) {
+    memcpy(buf + *len, p, n);
+    *len += n;
+}
+
+static void gw_str(uint8_t *buf, size_t *len, const char *s) {
+    uint64_t n = strlen(s);
+    gw_put(buf, len, &n, 8);
+    gw_put(buf, len, s, n);
+}
+
+static void gw_key(const char *key, uint32_t type) {
+    gw_str(g_kv, &g_kv_len, key);
+    gw_put(g_kv, &g_kv_len, &type, 4);
+    g_n_kv++;
+}
+
+static void gw_kv_u32(const char *key, uint32_t v) { gw_key(key, 4); gw_put(g_kv, &g_kv_len, &v, 4); }
+static void gw_kv_bool(const char *key, uint8_t v) { gw_key(key, 7); gw_put(g_kv, &g_kv_len, &v, 1); }
+static void gw_kv_str(const char *key, const char *v) { gw_key(key, 8); gw_str(g_kv, &g_kv_len, v); }
+
+static void gw_kv_arr(const char *key, uint32_t elem, uint64_t n) {
+    gw_key(key, 9);
+    gw_put(g_kv, &g_kv_len, &elem, 4);
+    gw_put(g_kv, &g_kv_len, &n, 8);
+}
+
+static void gw_tensor(const char *name, const float *v, int rows, int cols) {
+    uint32_t n_dims = rows ? 2 : 1, type = 0;
+    uint64_t dims[2] = { (uint64_t)cols, (uint64_t)rows }, off = g_data_len;
+    gw_str(g_info, &g_info_len, name);
+    gw_put(g_info, &g_info_len, &n_dims, 4);
+    gw_put(g_info, &g_info_len, dims, 8 * n_dims);
+    gw_put(g_info, &g_info_len, &type, 4);
+    gw_put(g_info, &g_info_len, &off, 8);
+    g_n_tensors++;
+    gw_put(g_data, &g_data_len, v, (size_t)(rows ? rows : 1) * (size_t)cols * 4);
+    g_data_len = (g_data_len + 31) & ~(size_t)31;
+}
+
+// T's vocabulary as tokenizer.ggml.* (model "llama" or "gpt2"); the model's
+// vocab_size is T.n + pad. Residual branches are zero and only eot_row
+// of output.weight is set, so greedy decoding emits eot_row at once.
+static int write_model(const char *tok_model, const char *pre, int with_vocab, int pad, int eot_row) {
+    const int vocab = T.n + pad;
+    static float emb[TV_MAX + 8][G_DIM], out[TV_MAX + 8][G_DIM], zero[G_HID * G_DIM], ones[G_DIM];
+    for (int i = 0; i < vocab; i++) {
+        for (int j = 0; j < G_DIM; j++) {
+            emb[i][j] = 0.5f + (float)(rnd() % 100) / 100.0f;
+            out[i][j] = (i == eot_row) ? 4.0f : 0.0f;
+        }
+    }
+    for (int j = 0; j < G_DIM; j++) ones[j] = 1.0f;
+
+    g_kv_len = g_info_len = g_data_len = 0;
+    g_n_kv = g_n_tensors = 0;
+    gw_kv_str("general.architecture", "llama");
+    gw_kv_u32("llama.embedding_length", G_DIM);
+    gw_kv_u32("llama.feed_forward_length", G_HID);
+    gw_kv_u32("llama.block_count", 1);
+    gw_kv_u32("llama.attention.head_count", G_HEADS);
+    gw_kv_u32("llama.attention.head_count_kv", G_HEADS);
+    gw_kv_u32("llama.context_length", G_SEQ);
+    if (with_vocab) {
+        gw_kv_str("tokenizer.ggml.model", tok_model);
+        if (pre) gw_kv_str("tokenizer.ggml.pre", pre);
+        gw_kv_arr("tokenizer.ggml.tokens", 8, (uint64_t)T.n);
+        for (int i = 0; i < T.n; i++) gw_str(g_kv, &g_kv_len, T.piece[i]);
+        gw_kv_arr("tokenizer.ggml.scores", 6, (uint64_t)T.n);
+        gw_put(g_kv, &g_kv_len, T.score, (size_t)T.n * 4);
+        gw_kv_arr("tokenizer.ggml.token_type", 5, (uint64_t)T.n);
+        gw_put(g_kv, &g_kv_len, T.type, (size_t)T.n * 4);
+        if (T.n_merges) {
+            gw_kv_arr("tokenizer.ggml.merges", 8, (uint64_t)T.n_merges);
+            for (int i = 0; i < T.n_merges; i++) gw_str(g_kv, &g_kv_len, T.merge[i]);
+        }
+        gw_kv_u32("tokenizer.ggml.bos_token_id", S_BOS);
+        gw_kv_u32("tokenizer.ggml.eos_token_id", S_EOS);
+        gw_kv_bool("tokenizer.ggml.add_bos_token", 1);
+    }
+
+    gw_tensor("token_embd.weight", &emb[0][0], vocab, G_DIM);
+    gw_tensor("blk.0.attn_norm.weight", ones, 0, G_DIM);
+    gw_tensor("blk.0.attn_q.weight", zero, G_DIM, G_DIM);
+    gw_tensor("blk.0.attn_k.weight", zero, G_DIM, G_DIM);
+    gw_tensor("blk.0.attn_v.weight", zero, G_DIM, G_DIM);
+    gw_tensor("blk.0.attn_output.weight", zero, G_DIM, G_DIM);
+    gw_tensor("blk.0.ffn_norm.weight", ones, 0, G_DIM);
+    gw_tensor("blk.0.ffn_gate.weight", zero, G_HID, G_DIM);
+    gw_tensor("blk.0.ffn_up.weight", zero, G_HID, G_DIM);
+    gw_tensor("blk.0.ffn_down.weight", zero, G_DIM, G_HID);
+    gw_tensor("output_norm.weight", ones, 0, G_DIM);
+    gw_tensor("output.weight", &out[0][0], vocab, G_DIM);
+
+    FILE *f = fopen(k_gguf, "wb");
+    if (!f) return -1;
+    uint32_t version = 3;
+    fwrite("GGUF", 1, 4, f);
+    fwrite(&version, 4, 1, f);
+    fwrite(&g_n_tensors, 8, 1, f);
+    fwrite(&g_n_kv, 8, 1, f);
+    fwrite(g_kv, 1, g_kv_len, f);
+    fwrite(g_info, 1, g_info_len, f);
+    long pad_bytes = (32 - (ftell(f) % 32)) % 32;
+    for (long i = 0; i < pad_bytes; i++) fputc(0, f);
+    fwrite(g_data, 1, g_data_len, f);
+    fclose(f);
+    return 0;
+}
+
+static int write_tokenizer_bin(int vocab) {
+    FILE *f = fopen(k_tok, "wb");
+    if (!f) return -1;
+    int max_len = 8;
+    fwrite(&max_len, 4, 1, f);
+    for (int i = 0; i < vocab; i++) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "t%d", i);
+        float score = 0.0f;
+        int len = (int)strlen(buf);
+        fwrite(&score, 4, 1, f);
+        fwrite(&len, 4, 1, f);
+        fwrite(buf, 1, (size_t)len, f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void test_gguf_load(void) {
+    printf("\n=== GGUF-embedded tokenizer through the host ===\n");
+    build_spm(0);
+    remove(k_tok);
+    ASSERT_TRUE(write_model("llama", NULL, 1, 5, s_end) == 0, "llama GGUF with tokenizer.ggml.* written");
+    ASSERT_EQ(llmk_host_load(k_gguf, NULL, 0), 0, "loads with no tokenizer.bin anywhere");
+    ASSERT_TRUE(g_tokenizer.gguf == &g_vocab && g_vocab.kind == LLMK_VOCAB_SPM, "tokenizer built from the metadata");
+    ASSERT_EQ(g_tokenizer.vocab_size, T.n + 5, "vocab_size follows the embedding rows");
+    ASSERT_EQ(g_vocab.n_tokens, T.n, "n_tokens from tokenizer.ggml.tokens");
+    ASSERT_TRUE(g_vocab.type && g_vocab.type[s_end] == LLMK_TOKTYPE_CONTROL && g_vocab.score[s_he] == -2.0f,
+                "scores and token types loaded");
+    ASSERT_TRUE(g_tokenizer.vocab[T.n + 2] == NULL, "padding rows have no piece");
+
+    int toks[16], n = 0;
+    encode("the a", toks, &n, 16, &g_tokenizer);
+    ASSERT_TRUE(n == 3 && toks[0] == S_BOS && toks[1] == s_spthe && toks[2] == s_spa, "encode() -> <s> ▁the ▁a");
+    char out[64];
+    n = llmk_tok_decode(&g_tokenizer, s_spthe, out, 64);
+    ASSERT_TRUE(n == 4 && !memcmp(out, " the", 4), "llmk_tok_decode");
+    ASSERT_EQ(llmk_tok_decode(&g_tokenizer, T.n + 2, out, 64), 0, "padding id decodes to nothing");
+    ASSERT_TRUE(llmk_tok_is_stop(&g_tokenizer, s_end) && !llmk_tok_is_stop(&g_tokenizer, s_a),
+                "llmk_tok_is_stop uses the vocabulary's EOT");
+
+    LlmkHostGen g;
+    LlmkHostTurn turn;
+    llmk_host_gen_defaults(&g);
+    g.chat_format = LLMK_HOST_CHAT_RAW;
+    g.max_gen_tokens = 8;
+    g.echo = 0;
+    ASSERT_EQ(llmk_host_generate("the a", &g, &turn), 0, "first turn");
+    ASSERT_EQ(turn.prompt_tokens, 3, "first turn keeps BOS");
+    ASSERT_TRUE(turn.generated == 0 && turn.stop_reason && !strcmp(turn.stop_reason, "eos/bos"),
+                "<end_of_turn> (not id 2) stops generation");
+    ASSERT_EQ(llmk_host_generate("the a", &g, &turn), 0, "second turn");
+    ASSERT_EQ(turn.prompt_tokens, 2, "continuing turn drops the vocabulary's BOS");
+
+    ASSERT_TRUE(write_tokenizer_bin(T.n + 5) == 0, "tokenizer.bin written");
+    ASSERT_EQ(llmk_host_load(k_gguf, k_tok, 0), 0, "explicit tokenizer.bin");
+    ASSERT_TRUE(g_tokenizer.gguf == NULL && !strcmp(g_tokenizer.vocab[7], "t7"), "--tokenizer wins over the metadata");
+
+    write_model("llama", NULL, 0, 5, s_end);
+    ASSERT_EQ(llmk_host_load(k_gguf, k_tok, 0), 0, "GGUF without tokenizer.ggml.* uses tokenizer.bin");
+    ASSERT_TRUE(g_tokenizer.gguf == NULL, "no embedded vocabulary");
+
+    train_bpe(60);
+    ASSERT_TRUE(write_model("gpt2", "qwen2", 1, 0, b_im_end) == 0, "gpt2/qwen2 GGUF with merges written");
+    ASSERT_EQ(llmk_host_load(k_gguf, NULL, 0), 0, "BPE GGUF loads without tokenizer.bin");
+    ASSERT_TRUE(g_vocab.kind == LLMK_VOCAB_BPE && g_vocab.pre == LLMK_VOCAB_PRE_QWEN2 && g_vocab.n_merges == T.n_merges,
+                "tokenizer.ggml.model gpt2, pre qwen2, merges");
+    ASSERT_TRUE(!g_vocab.add_space_prefix, "no ▁ prefix for BPE");
+    tv_build(LLMK_VOCAB_BPE, LLMK_VOCAB_PRE_QWEN2, S_BOS, S_EOS, -1, -1);
+    int a[64], b[64];
+    const char *txt = "<|im_start|>user\nab 12 c\xC3\xA9<|im_end|>";
+    const int na = llmk_vocab_encode(&g_vocab, txt, (int)strlen(txt), 0, a, 64);
+    const int nb = llmk_vocab_encode(&V, txt, (int)strlen(txt), 0, b, 64);
+    ASSERT_TRUE(na == nb && !memcmp(a, b, (size_t)na * sizeof(int)) && a[0] == b_im_start,
+                "loaded vocabulary encodes like the in-memory one");
+
+    llmk_host_unload();
+    ASSERT_TRUE(g_vocab_mem == NULL && g_vocab.kind == 0, "unload releases the vocabulary arena");
+}
+
+int main(void) {
+    printf("========================================\n");
+    printf("  llmk_vocab GGUF tokenizer tests\n");
+    printf("========================================\n");
+
+    init_byte_map();
+    test_spm();
+    test_presplit();
+    test_bpe();
+    test_gguf_load();
+
+    tv_reset();
+    remove(k_gguf);
+    remove(k_tok);
+
+    printf("\n========================================\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+    if (tests_failed == 0) {
+        printf("\n[OK] All llmk_vocab tests passed.\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,370 @@
+// test_nfs_log.c — Host-mode harness for the NeuralFS log store
+//
+// Tests:
+//   put/get/delete/overwrite semantics, compaction, index rebuild
+//   100k-record fill: insert + lookup latency (ns/op)
+//   recovery: log image truncated at every byte of the last records
+//   oversized values: lengths that would wrap the record size are rejected
+//   smaller store: reload into a smaller index / log_cap flags the cut and
+//     compacts to a new generation
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=c11 -O2 -Wall -Wextra -I../engine/ssm
+//       test_nfs_log.c ../engine/ssm/oo_nfs_log.c -o test_nfs_log
+//
+// Run:
+//   ./test_nfs_log
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "oo_nfs_log.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+typedef struct {
+    void     *log;
+    void     *index;
+    uint32_t  log_cap;
+    uint32_t  index_cap;
+    NfslStore s;
+} TestStore;
+
+static void ts_open(TestStore *t, uint32_t log_cap, uint32_t index_cap) {
+    t->log = malloc(log_cap);
+    t->index = malloc((size_t)index_cap * sizeof(NfslSlot));
+    t->log_cap = log_cap;
+    t->index_cap = index_cap;
+    nfsl_init(&t->s, t->log, log_cap, t->index, index_cap);
+}
+
+static void ts_close(TestStore *t) {
+    free(t->log);
+    free(t->index);
+}
+
+static int make_key(char *buf, int i) { return sprintf(buf, "mem.turn.%08d", i); }
+static int make_val(char *buf, int i, int gen) {
+    return sprintf(buf, "value-%d-gen%d-%.*s", i, gen, i % 40, "0123456789abcdefghijklmnopqrstuvwxyzABCD");
+}
+
+// ============================================================
+// Test 1: basic semantics
+// ============================================================
+static void test_basic(void) {
+    printf("\n[Test 1] put / get / overwrite / delete\n");
+    TestStore t;
+    ts_open(&t, 64 * 1024, 256);
+
+    ASSERT_EQ(nfsl_put_str(&t.s, "agent.goal", "write the report"), NFSL_OK, "put goal");
+    ASSERT_EQ(nfsl_put_str(&t.s, "agent.mood", "curious"), NFSL_OK, "put mood");
+    const char *v = nfsl_get_str(&t.s, "agent.goal", 0);
+    ASSERT_TRUE(v && strcmp(v, "write the report") == 0, "get goal");
+
+    ASSERT_EQ(nfsl_put_str(&t.s, "agent.goal", "ship it"), NFSL_OK, "overwrite goal");
+    v = nfsl_get_str(&t.s, "agent.goal", 0);
+    ASSERT_TRUE(v && strcmp(v, "ship it") == 0, "get returns newest value");
+    ASSERT_EQ(t.s.live_count, 2, "two live keys");
+    ASSERT_TRUE(t.s.dead_bytes > 0, "overwrite leaves dead bytes");
+
+    ASSERT_EQ(nfsl_delete(&t.s, "agent.mood", 10), NFSL_OK, "delete mood");
+    ASSERT_TRUE(nfsl_get_str(&t.s, "agent.mood", 0) == NULL, "deleted key is gone");
+    ASSERT_EQ(nfsl_delete(&t.s, "agent.mood", 10), NFSL_ERR_NOTFOUND, "double delete");
+
+    // Variable-size binary value larger than the old 384-byte NFS2 limit
+    static unsigned char blob[4000];
+    for (int i = 0; i < (int)sizeof(blob); i++) blob[i] = (unsigned char)(i * 31);
+    ASSERT_EQ(nfsl_put(&t.s, "lora.delta", 10, blob, sizeof(blob)), NFSL_OK, "put 4 KB blob");
+    uint32_t n = 0;
+    const unsigned char *b = nfsl_get(&t.s, "lora.delta", 10, &n);
+    ASSERT_TRUE(b && n == sizeof(blob) && memcmp(b, blob, n) == 0, "blob round-trips");
+
+    uint32_t before = t.s.log_len;
+    uint32_t gen = t.s.generation;
+    nfsl_compact(&t.s);
+    ASSERT_TRUE(t.s.log_len < before, "compaction shrinks the log");
+    ASSERT_EQ(t.s.generation, gen + 1, "compaction bumps generation");
+    v = nfsl_get_str(&t.s, "agent.goal", 0);
+    ASSERT_TRUE(v && strcmp(v, "ship it") == 0, "live key survives compaction");
+    ASSERT_TRUE(nfsl_get_str(&t.s, "agent.mood", 0) == NULL, "deleted key stays gone");
+
+    // Replay the compacted image from scratch
+    uint32_t len = t.s.log_len;
+    nfsl_replay(&t.s, len);
+    ASSERT_EQ(t.s.log_len, len, "replay accepts the whole compacted image");
+    ASSERT_EQ(t.s.live_count, 2, "replay restores live count");
+    ASSERT_TRUE(t.s.committed, "compacted image is committed");
+    ts_close(&t);
+}
+
+// ============================================================
+// Test 2: auto-compaction when the log fills
+// ============================================================
+static void test_autocompact(void) {
+    printf("\n[Test 2] auto-compaction under churn\n");
+    TestStore t;
+    ts_open(&t, 16 * 1024, 64);
+    char key[32], val[96];
+    int fails = 0;
+    for (int i = 0; i < 5000; i++) {
+        make_key(key, i % 16);
+        make_val(val, i, 0);
+        if (nfsl_put_str(&t.s, key, val) != NFSL_OK) fails++;
+    }
+    ASSERT_EQ(fails, 0, "5000 overwrites of 16 keys fit a 16 KB log");
+    ASSERT_TRUE(t.s.compactions > 0, "store compacted itself");
+    make_key(key, 4999 % 16);
+    make_val(val, 4999, 0);
+    const char *v = nfsl_get_str(&t.s, key, 0);
+    ASSERT_TRUE(v && strcmp(v, val) == 0, "newest value after compactions");
+    ts_close(&t);
+}
+
+// ============================================================
+// Test 3: 100k records — insert / lookup latency
+// ============================================================
+#define BIG_N 100000
+
+static void test_fill_100k(void) {
+    printf("\n[Test 3] 100k-record fill\n");
+    TestStore t;
+    ts_open(&t, 16u * 1024u * 1024u, 256u * 1024u);
+    char key[32], val[96];
+
+    double t0 = now_ns();
+    int fails = 0;
+    for (int i = 0; i < BIG_N; i++) {
+        int kl = make_key(key, i);
+        int vl = make_val(val, i, 0);
+        if (nfsl_put(&t.s, key, (uint32_t)kl, val, (uint32_t)vl) != NFSL_OK) fails++;
+    }
+    double t1 = now_ns();
+    ASSERT_EQ(fails, 0, "100k inserts succeed");
+    ASSERT_EQ(t.s.live_count, BIG_N, "100k live keys");
+
+    int misses = 0;
+    unsigned int rng = 12345u;
+    double t2 = now_ns();
+    for (int i = 0; i < BIG_N; i++) {
+        rng = rng * 1103515245u + 12345u;
+        int k = (int)((rng >> 8) % BIG_N);
+        int kl = make_key(key, k);
+        int vl = make_val(val, k, 0);
+        uint32_t n = 0;
+        const char *v = nfsl_get(&t.s, key, (uint32_t)kl, &n);
+        if (!v || n != (uint32_t)vl || memcmp(v, val, n) != 0) misses++;
+    }
+    double t3 = now_ns();
+    ASSERT_EQ(misses, 0, "100k random lookups hit");
+
+    double t4 = now_ns();
+    uint32_t len = nfsl_replay(&t.s, t.s.log_len);
+    double t5 = now_ns();
+    ASSERT_EQ(t.s.live_count, BIG_N, "index rebuild restores 100k keys");
+
+    printf("  insert: %.0f ns/op   lookup: %.0f ns/op   rebuild: %.2f ms (%u KB log)\n",
+           (t1 - t0) / BIG_N, (t3 - t2) / BIG_N, (t5 - t4) / 1e6, len >> 10);
+    ts_close(&t);
+}
+
+// ============================================================
+// Test 4: recovery after a truncated write
+// ============================================================
+static void test_truncated_recovery(void) {
+    printf("\n[Test 4] recovery after truncated write\n");
+    TestStore t;
+    ts_open(&t, 64 * 1024, 1024);
+    char key[32], val[96];
+    uint32_t ends[64];
+    for (int i = 0; i < 64; i++) {
+        make_key(key, i);
+        make_val(val, i, 1);
+        nfsl_put_str(&t.s, key, val);
+        ends[i] = t.s.log_len;
+    }
+
+    // Segment image as it would sit on disk
+    uint32_t full = t.s.log_len;
+    unsigned char *disk = malloc(full);
+    memcpy(disk, t.s.log, full);
+
+    TestStore r;
+    ts_open(&r, 64 * 1024, 1024);
+    int bad = 0;
+    uint32_t from = ends[55];
+    for (uint32_t cut = from; cut <= full; cut++) {
+        memcpy(r.log, disk, cut);
+        memset((unsigned char *)r.log + cut, 0xA5, 256);   // garbage past the tear
+        nfsl_replay(&r.s, cut);
+        // Every record fully written before the cut must be visible, nothing after it.
+        int complete = 0;
+        while (complete < 64 && ends[complete] <= cut) complete++;
+        if ((int)r.s.live_count != complete) { bad++; continue; }
+        make_key(key, complete - 1);
+        make_val(val, complete - 1, 1);
+        const char *v = nfsl_get_str(&r.s, key, 0);
+        if (!v || strcmp(v, val) != 0) bad++;
+    }
+    ASSERT_EQ(bad, 0, "every truncation point recovers the durable prefix");
+
+    // Bit flip inside a record payload: replay must stop before it
+    memcpy(r.log, disk, full);
+    ((unsigned char *)r.log)[ends[40] + 20] ^= 0x10;
+    nfsl_replay(&r.s, full);
+    ASSERT_EQ(r.s.live_count, 41, "CRC mismatch stops replay at the damaged record");
+
+    // Writes continue after recovery
+    ASSERT_EQ(nfsl_put_str(&r.s, "after.crash", "ok"), NFSL_OK, "append after recovery");
+    uint32_t len = r.s.log_len;
+    nfsl_replay(&r.s, len);
+    ASSERT_EQ(r.s.log_len, len, "recovered log replays cleanly");
+    ASSERT_EQ(r.s.live_count, 42, "post-recovery write is durable");
+
+    free(disk);
+    ts_close(&r);
+    ts_close(&t);
+}
+
+// ============================================================
+// Test 5: values larger than the log
+// ============================================================
+static void test_oversized(void) {
+    printf("\n[Test 5] oversized values are rejected\n");
+    TestStore t;
+    ts_open(&t, 4 * 1024, 64);
+    ASSERT_EQ(nfsl_put_str(&t.s, "agent.goal", "ship it"), NFSL_OK, "put goal");
+    uint32_t len = t.s.log_len, seq = t.s.seq, puts = t.s.total_puts;
+
+    // Lengths whose record size wraps around in u32: nothing may be read or written
+    static const char tiny[4] = "abc";
+    ASSERT_EQ(nfsl_put(&t.s, "big", 3, tiny, 0xFFFFFFF0u), NFSL_ERR_ARG, "val_len 0xFFFFFFF0 rejected");
+    ASSERT_EQ(nfsl_put(&t.s, "big", 3, tiny, 0xFFFFFFFFu), NFSL_ERR_ARG, "val_len 0xFFFFFFFF rejected");
+    ASSERT_EQ(nfsl_put(&t.s, "big", 3, tiny, 0xFFFFFFFFu - (uint32_t)sizeof(NfslRecHdr) - 2u), NFSL_ERR_ARG,
+              "val_len that wraps the header + key sum rejected");
+
+    // One byte more than the log can hold
+    uint32_t over = t.log_cap - (uint32_t)sizeof(NfslRecHdr) - 3u + 1u;
+    unsigned char *blob = calloc(over, 1);
+    ASSERT_EQ(nfsl_put(&t.s, "big", 3, blob, over), NFSL_ERR_ARG, "record larger than the log rejected");
+    free(blob);
+
+    ASSERT_EQ(t.s.log_len, len, "log untouched");
+    ASSERT_TRUE(t.s.seq == seq && t.s.total_puts == puts, "no record appended");
+    ASSERT_TRUE(nfsl_get(&t.s, "big", 3, 0) == NULL, "rejected key is absent");
+    const char *v = nfsl_get_str(&t.s, "agent.goal", 0);
+    ASSERT_TRUE(v && strcmp(v, "ship it") == 0, "existing key intact");
+    ts_close(&t);
+}
+
+// ============================================================
+// Test 6: reload into a smaller store
+// ============================================================
+static void test_smaller_reload(void) {
+    printf("\n[Test 6] reload into a smaller index and log\n");
+    TestStore t;
+    ts_open(&t, 64 * 1024, 1024);
+    char key[32], val[96];
+    for (int i = 0; i < 200; i++) {
+        make_key(key, i);
+        make_val(val, i, 1);
+        nfsl_put_str(&t.s, key, val);
+    }
+    uint32_t full = t.s.log_len, gen = t.s.generation;
+
+    nfsl_replay(&t.s, full);
+    ASSERT_EQ(t.s.truncated, 0, "full replay is not truncated");
+
+    // Index too small: replay keeps the prefix that fits and says so
+    TestStore r;
+    ts_open(&r, 64 * 1024, 64);
+    memcpy(r.log, t.log, full);
+    nfsl_replay(&r.s, full);
+    ASSERT_EQ(r.s.truncated, 1, "full index flags truncation");
+    ASSERT_TRUE(r.s.committed && r.s.log_len < full, "committed prefix kept");
+    uint32_t kept = r.s.live_count;
+    ASSERT_TRUE(kept > 0 && kept < 200, "only the leading keys are live");
+
+    // What nfsl_persist_load does next: compact into a new generation
+    ASSERT_EQ(nfsl_compact(&r.s), NFSL_OK, "compact truncated store");
+    ASSERT_TRUE(r.s.generation != gen, "generation bumped (next flush rewrites the image)");
+    ASSERT_EQ(r.s.truncated, 0, "compacted image replays whole");
+    ASSERT_EQ(r.s.live_count, kept, "kept keys survive compaction");
+    make_key(key, (int)kept - 1);
+    make_val(val, (int)kept - 1, 1);
+    const char *v = nfsl_get_str(&r.s, key, 0);
+    ASSERT_TRUE(v && strcmp(v, val) == 0, "last kept key readable");
+    ts_close(&r);
+
+    // Log too small: replay reads at most log_cap bytes
+    uint32_t cap = full / 2;
+    ts_open(&r, cap, 1024);
+    memcpy(r.log, t.log, cap);
+    nfsl_replay(&r.s, full);
+    ASSERT_EQ(r.s.truncated, 1, "image past log_cap flags truncation");
+    ASSERT_TRUE(r.s.log_len <= cap && r.s.live_count < 200, "replay stays inside log_cap");
+    ASSERT_EQ(nfsl_compact(&r.s), NFSL_OK, "compact clipped store");
+    ASSERT_TRUE(r.s.generation != gen && r.s.truncated == 0, "clipped store gets a new generation");
+    ts_close(&r);
+    ts_close(&t);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  NeuralFS Log Store — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_basic();
+    test_autocompact();
+    test_fill_100k();
+    test_truncated_recovery();
+    test_oversized();
+    test_smaller_reload();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All NeuralFS log store tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
@@ -0,0 +1,357 @@
+// test_oo_hud_blit.c — Host-mode harness for the HUD back buffer / dirty-tile present
+//
+// Tests:
+//   span fill / alpha blend / dim: SSE2 and AVX2 vs the scalar HUD formulas
+//   (every colour × alpha × background byte for the blend)
+//   streaming copy at every destination misalignment
+//   dirty tiles: rectangles cover every changed pixel, stay in bounds and
+//   disjoint, stack vertically, collapse to a bounding box on overflow,
+//   and an unchanged frame pushes nothing
+//   bench: HUD-like frame drawn in place (scalar) vs back buffer + present
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=c11 -O2 -msse2 -Wall -Wextra -I../engine/llama2
+//       test_oo_hud_blit.c ../engine/llama2/oo_hud_blit.c -o test_oo_hud_blit
+//
+// Run:
+//   ./test_oo_hud_blit
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "oo_hud_blit.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static int has_avx2(void) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    return !!__builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
+
+// Scalar formulas from oo_hud_final.c (px_blend / tint_rect / scanlines)
+static uint32_t ref_blend(uint32_t bg, uint32_t col, uint32_t alpha) {
+    uint32_t inv = 255u - alpha;
+    uint32_t r = (((col>>16)&0xFFu)*alpha + ((bg>>16)&0xFFu)*inv) / 255u;
+    uint32_t g = (((col>>8 )&0xFFu)*alpha + ((bg>>8 )&0xFFu)*inv) / 255u;
+    uint32_t b = (((col    )&0xFFu)*alpha + ((bg    )&0xFFu)*inv) / 255u;
+    return (r << 16) | (g << 8) | b;
+}
+
+static uint32_t ref_dim(uint32_t p) {
+    uint32_t r = (p>>16)&0xFFu, g = (p>>8)&0xFFu, b = p&0xFFu;
+    r = r > 6u ? r - 6u : 0u;
+    g = g > 6u ? g - 6u : 0u;
+    b = b > 6u ? b - 6u : 0u;
+    return (r << 16) | (g << 8) | b;
+}
+
+// ============================================================
+// Spans
+// ============================================================
+static void test_spans(int avx2) {
+    printf("\n[TEST] Spans (%s)\n", avx2 ? "AVX2" : "SSE2");
+    ohb_set_cpu(avx2);
+    static uint32_t buf[256 + 8], ref[256 + 8];
+
+    // Blend: every (colour byte, background byte) pair at every alpha. The
+    // pair goes in all three channels, so one span of 256 covers a column.
+    int bad = 0;
+    for (uint32_t a = 0; a < 256 && !bad; a++)
+        for (uint32_t c = 0; c < 256 && !bad; c++) {
+            uint32_t col = (c << 16) | ((255u - c) << 8) | c;
+            for (uint32_t d = 0; d < 256; d++) {
+                buf[d] = (d << 16) | (d << 8) | (255u - d) | 0xAB000000u;   // junk X byte
+                ref[d] = ref_blend(buf[d], col, a);
+            }
+            ohb_blend_span(buf, col, a, 256);
+            bad = memcmp(buf, ref, 256 * 4) != 0;
+        }
+    ASSERT_TRUE(!bad, "blend == (c*a + d*(255-a))/255 for all bytes and alphas");
+
+    bad = 0;
+    for (int n = 0; n <= 37 && !bad; n++)
+        for (int off = 0; off < 4; off++) {
+            uint32_t col = rnd() & 0xFFFFFFu, a = rnd() & 0xFFu;
+            for (int i = 0; i < n + 8; i++) buf[i] = ref[i] = rnd() & 0xFFFFFFu;
+            for (int i = 0; i < n; i++) ref[off + i] = ref_blend(ref[off + i], col, a);
+            ohb_blend_span(buf + off, col, a, n);
+            bad |= memcmp(buf, ref, (size_t)(n + 8) * 4) != 0;
+        }
+    ASSERT_TRUE(!bad, "blend: every length 0..37 / offset, no write past the span");
+
+    bad = 0;
+    for (int n = 0; n <= 37 && !bad; n++) {
+        uint32_t col = rnd();
+        for (int i = 0; i < n + 8; i++) buf[i] = ref[i] = rnd();
+        for (int i = 0; i < n; i++) ref[1 + i] = col;
+        ohb_fill_span(buf + 1, col, n);
+        bad |= memcmp(buf, ref, (size_t)(n + 8) * 4) != 0;
+    }
+    ASSERT_TRUE(!bad, "fill: every length 0..37, no write past the span");
+
+    bad = 0;
+    for (int n = 0; n <= 64 && !bad; n++) {
+        for (int i = 0; i < n + 8; i++) buf[i] = ref[i] = rnd();
+        for (int i = 0; i < n; i++) ref[2 + i] = ref_dim(ref[2 + i]);
+        ohb_dim_span(buf + 2, 0x060606u, n);
+        bad |= memcmp(buf, ref, (size_t)(n + 8) * 4) != 0;
+    }
+    ASSERT_TRUE(!bad, "dim == scanline saturating -6 per channel");
+    ohb_set_cpu(0);
+}
+
+static void test_stream(void) {
+    printf("\n[TEST] Streaming copy\n");
+    static uint32_t src[300], dst[320] __attribute__((aligned(16)));
+    int bad = 0;
+    for (int i = 0; i < 300; i++) src[i] = rnd();
+    for (int mis = 0; mis < 4; mis++)
+        for (int n = 0; n <= 67; n++) {
+            memset(dst, 0x5A, sizeof(dst));
+            ohb_stream_span(dst + mis, src + 3, n);
+            ohb_stream_fence();
+            for (int i = 0; i < 80; i++) {
+                uint32_t want = (i >= mis && i < mis + n) ? src[3 + i - mis] : 0x5A5A5A5Au;
+                bad |= dst[i] != want;
+            }
+        }
+    ASSERT_TRUE(!bad, "stream_span exact at every misalignment / length, nothing outside");
+}
+
+// ============================================================
+// Dirty tiles
+// ============================================================
+#define SW 1000      // not a multiple of the tile width
+#define SH 600       // not a multiple of the tile height
+
+static void draw_rect(OhbSurface *s, int x, int y, int w, int h, uint32_t col) {
+    for (int j = y; j < y + h; j++)
+        if (j >= 0 && j < (int)s->h)
+            for (int i = x; i < x + w; i++)
+                if (i >= 0 && i < (int)s->w) s->back[j * s->w + i] = col;
+}
+
+// Rectangles in bounds, pairwise disjoint, covering every pixel where
+// the previous screen (prev) differs from the new frame
+static int check_rects(const OhbSurface *s, const uint32_t *prev, uint64_t *covered) {
+    static uint8_t cov[SW * SH];
+    memset(cov, 0, sizeof(cov));
+    *covered = 0;
+    for (int k = 0; k < s->n_rects; k++) {
+        const OhbRect *r = &s->rects[k];
+        if (r->x < 0 || r->y < 0 || r->w <= 0 || r->h <= 0 ||
+            r->x + r->w > (int)s->w || r->y + r->h > (int)s->h) return 0;
+        for (int y = r->y; y < r->y + r->h; y++)
+            for (int x = r->x; x < r->x + r->w; x++) {
+                if (cov[y * SW + x]) return 0;
+                cov[y * SW + x] = 1;
+                (*covered)++;
+            }
+    }
+    for (int i = 0; i < SW * SH; i++)
+        if (prev[i] != s->back[i] && !cov[i]) return 0;
+    return 1;
+}
+
+static void test_dirty(void) {
+    printf("\n[TEST] Dirty tiles → rectangles\n");
+    static OhbSurface s;
+    static uint32_t prev[SW * SH], fb[SW * SH];
+    uint64_t bytes = ohb_surface_bytes(SW, SH);
+    void *mem = malloc((size_t)bytes);
+    ASSERT_EQ(ohb_surface_bytes(OHB_MAX_W + 1, 10), 0, "oversized surface refused");
+    ASSERT_EQ(ohb_surface_init(&s, mem, bytes - 4, SW, SH), -1, "short memory refused");
+    ASSERT_EQ(ohb_surface_init(&s, mem, bytes, SW, SH), 0, "surface init");
+    ASSERT_EQ(s.tiles_x, (SW + OHB_TILE_W - 1) / OHB_TILE_W, "partial last tile column");
+
+    // First frame: everything
+    draw_rect(&s, 0, 0, SW, SH, 0x020510u);
+    ohb_collect_dirty(&s);
+    ohb_present_fb(&s, fb, SW);
+    ASSERT_EQ(s.n_rects, 1, "first frame: one full-screen rectangle");
+    ASSERT_TRUE(s.rects[0].w == SW && s.rects[0].h == SH, "full-screen rectangle clipped to the screen");
+    ASSERT_TRUE(memcmp(fb, s.back, sizeof(fb)) == 0, "framebuffer == back buffer");
+
+    // Same pixels again: nothing to push
+    draw_rect(&s, 0, 0, SW, SH, 0x020510u);
+    ASSERT_EQ(ohb_collect_dirty(&s), 0, "identical redraw pushes nothing");
+
+    // One small widget
+    draw_rect(&s, 130, 70, 10, 5, 0xFF0000u);
+    ohb_collect_dirty(&s);
+    ASSERT_EQ(s.n_rects, 1, "one widget: one rectangle");
+    ASSERT_TRUE(s.rects[0].x == 128 && s.rects[0].y == 64 &&
+                s.rects[0].w == OHB_TILE_W && s.rects[0].h == OHB_TILE_H, "snapped to its tile");
+    ohb_present_fb(&s, fb, SW);
+
+    // Tall bar: runs stack vertically into one rectangle
+    draw_rect(&s, 200, 10, 100, 400, 0x00FF00u);
+    ohb_collect_dirty(&s);
+    ASSERT_EQ(s.n_rects, 1, "vertical bar: runs stacked into one rectangle");
+    ohb_present_fb(&s, fb, SW);
+
+    // Random widgets, many frames
+    int ok = 1, frames = 40;
+    uint64_t pushed = 0, changed = 0;
+    for (int f = 0; f < frames && ok; f++) {
+        memcpy(prev, s.shadow, sizeof(prev));
+        int nw = 1 + (int)(rnd() % 12);
+        for (int w = 0; w < nw; w++)
+            draw_rect(&s, (int)(rnd() % SW) - 20, (int)(rnd() % SH) - 20,
+                      1 + (int)(rnd() % 120), 1 + (int)(rnd() % 60), rnd() & 0xFFFFFFu);
+        for (int i = 0; i < SW * SH; i++) changed += prev[i] != s.back[i];
+        ohb_collect_dirty(&s);
+        uint64_t cov;
+        ok = check_rects(&s, prev, &cov);
+        pushed += cov;
+        ohb_present_fb(&s, fb, SW);
+        ok = ok && memcmp(fb, s.back, sizeof(fb)) == 0 && memcmp(s.shadow, s.back, sizeof(fb)) == 0;
+    }
+    ASSERT_TRUE(ok, "40 random frames: rects in bounds, disjoint, cover every change; fb == back");
+    printf("  pushed %.1f%% of the screen per frame for %.2f%% changed pixels\n",
+           100.0 * pushed / ((double)frames * SW * SH), 100.0 * changed / ((double)frames * SW * SH));
+
+    // Checkerboard of tiles: more runs than OHB_MAX_RECTS → bounding box
+    memcpy(prev, s.shadow, sizeof(prev));
+    for (uint32_t ty = 0; ty < s.tiles_y; ty++)
+        for (uint32_t tx = (ty & 1); tx < s.tiles_x; tx += 2)
+            s.back[(ty * OHB_TILE_H + 1) * SW + tx * OHB_TILE_W + 1] ^= 1u;
+    ohb_collect_dirty(&s);
+    uint64_t cov;
+    ASSERT_EQ(s.n_rects, 1, "fragmented frame collapses to one rectangle");
+    ASSERT_TRUE(check_rects(&s, prev, &cov), "bounding rectangle covers the changes");
+    ohb_present_fb(&s, fb, SW);
+
+    // Invalidate: everything again
+    ohb_invalidate(&s);
+    ohb_collect_dirty(&s);
+    ASSERT_TRUE(s.n_rects == 1 && s.rects[0].w == SW && s.rects[0].h == SH, "invalidate → full push");
+    free(mem);
+}
+
+// ============================================================
+// Bench: HUD-like frame
+// ============================================================
+// Per-pixel scalar drawing as oo_hud_final.c did it, straight into fb
+static void frame_scalar(uint32_t *fb, int w, int h, int t) {
+    for (int i = 0; i < w * h; i++) fb[i] = 0x02050Cu;
+    for (int p = 0; p < 5; p++) {
+        int x0 = 20 + p * 180, y0 = 40 + (p & 1) * 250 + (t & 7);
+        for (int y = y0; y < y0 + 220 && y < h; y++)
+            for (int x = x0; x < x0 + 170 && x < w; x++) fb[y * w + x] = ref_blend(fb[y * w + x], 0x030812u, 170);
+    }
+    for (int y = 0; y < h; y += 3)
+        for (int x = 0; x < w; x++) fb[y * w + x] = ref_dim(fb[y * w + x]);
+}
+
+static void frame_spans(uint32_t *bb, int w, int h, int t) {
+    for (int y = 0; y < h; y++) ohb_fill_span(bb + y * w, 0x02050Cu, w);
+    for (int p = 0; p < 5; p++) {
+        int x0 = 20 + p * 180, y0 = 40 + (p & 1) * 250 + (t & 7);
+        for (int y = y0; y < y0 + 220 && y < h; y++) ohb_blend_span(bb + y * w + x0, 0x030812u, 170, 170);
+    }
+    for (int y = 0; y < h; y += 3) ohb_dim_span(bb + y * w, 0x060606u, w);
+}
+
+static void bench(void) {
+    printf("\n[BENCH] HUD-like frame %dx%d (clear, 5 glass panels, scanlines)\n", SW, SH);
+    static OhbSurface s;
+    static uint32_t fb[SW * SH];
+    uint64_t bytes = ohb_surface_bytes(SW, SH);
+    void *mem = malloc((size_t)bytes);
+    ohb_surface_init(&s, mem, bytes, SW, SH);
+    const int iters = 200;
+
+    double t0 = now_ns();
+    for (int i = 0; i < iters; i++) frame_scalar(fb, SW, SH, i);
+    double t_scalar = (now_ns() - t0) / iters;
+
+    for (int avx2 = 0; avx2 <= has_avx2(); avx2++) {
+        ohb_set_cpu(avx2);
+        uint64_t px0 = s.px_pushed;
+        t0 = now_ns();
+        for (int i = 0; i < iters; i++) {
+            frame_spans(s.back, SW, SH, i);
+            ohb_collect_dirty(&s);
+            ohb_present_fb(&s, fb, SW);
+        }
+        double t_bb = (now_ns() - t0) / iters;
+        printf("  %-5s back buffer + diff + stream: %7.1f us/frame  (scalar in place %7.1f us)  %.1fx, %.0f%% of pixels pushed\n",
+               avx2 ? "AVX2" : "SSE2", t_bb / 1e3, t_scalar / 1e3, t_scalar / t_bb,
+               100.0 * (double)(s.px_pushed - px0) / ((double)iters * SW * SH));
+        ASSERT_TRUE(memcmp(fb, s.back, sizeof(fb)) == 0, "bench frame on screen == back buffer");
+    }
+    ohb_set_cpu(0);
+    free(mem);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  HUD Back Buffer / Dirty Blit — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_spans(0);
+    if (has_avx2()) test_spans(1);
+    else printf("\n[SKIP] AVX2 spans (CPU without AVX2)\n");
+    test_stream();
+    test_dirty();
+    bench();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All HUD blit tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
@@ -0,0 +1,622 @@
+// test_oo_insitu_backprop.c — Host-mode harness for gradient-based LoRA training
+//
+// Tests:
+//   init: parameter tail = last N layers of the oo_lora arena, bad geometry refused
+//   forward: sequence loss matches an incremental KV-cache reference forward
+//            (with and without RoPE, both pair layouts)
+//   gradients: analytic dL/dA, dL/dB vs central differences (f32 and Q8_0 base,
+//              through the q/k rotation)
+//   frozen: adapters below the trained layers never move
+//   overfit: JSONL pairs through oit_train_from_jsonl → loss falls
+//   benchmark: training tokens/s on a stories260K-shaped model
+//
+// The model is random (stories260K geometry: dim 64, hidden 172, 5 layers,
+// 8 heads / 4 kv heads, vocab 512) with a byte-level tokenizer.
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=gnu11 -O2 -msse2 -Wall -Wextra -I../engine/self_improve -I../engine/ssm -I../engine/trainer
+//       test_oo_insitu_backprop.c ../engine/trainer/oo_insitu_backprop.c
+//       ../engine/trainer/oo_insitu_train.c ../engine/trainer/oo_insitu_parallel.c
+//       ../engine/self_improve/oo_lora.c ../engine/llama2/llmk_rope.c
+//       ../oo-multicore/core/oo_mc_queue.c -o test_oo_insitu_backprop -lm
+//
+// Run:
+//   ./test_oo_insitu_backprop
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "oo_insitu_train.h"
+
+// ============================================================
+// Stubs: NVMe (oo_lora persist) and the JSONL readers (soma_mind.c)
+// ============================================================
+int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes)        { (void)lba; (void)buf; (void)bytes; return -1; }
+int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes) { (void)lba; (void)buf; (void)bytes; return -1; }
+
+static const char *g_jsonl =
+    "{\"input\":\"hi\",\"output\":\"hello there\",\"quality\":0.9}\n"
+    "{\"input\":\"sky?\",\"output\":\"the sky is blue\",\"quality\":0.8}\n"
+    "{\"input\":\"cat\",\"output\":\"a cat sat\",\"quality\":0.7}\n"
+    "{\"input\":\"ok\",\"output\":\"all good\",\"quality\":0.9}\n";
+
+static int json_field(const char *line, const char *key, char *out, int cap) {
+    char pat[32];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *p = strstr(line, pat);
+    if (!p) return -1;
+    p += strlen(pat);
+    if (*p == '"') {
+        int n = 0;
+        for (p++; *p && *p != '"' && n < cap - 1; p++) out[n++] = *p;
+        out[n] = 0;
+    } else {
+        int n = 0;
+        while (*p && *p != ',' && *p != '}' && n < cap - 1) out[n++] = *p++;
+        out[n] = 0;
+    }
+    return 0;
+}
+
+uint32_t oit_count_jsonl_lines(const void *root_dir, const unsigned short *path16) {
+    (void)root_dir; (void)path16;
+    return 0;
+}
+
+int oit_read_jsonl_pairs(void *root_dir, const unsigned short *path16,
+                         OitPair *pairs, int max_pairs) {
+    (void)root_dir;
+    if (path16[0] != 'O') return 0;            // only OO_DREAM.JSONL
+    int n = 0;
+    const char *p = g_jsonl;
+    while (*p && n < max_pairs) {
+        char line[512], q[16];
+        int len = 0;
+        while (p[len] && p[len] != '\n' && len < (int)sizeof(line) - 1) { line[len] = p[len]; len++; }
+        line[len] = 0;
+        p += len + (p[len] == '\n');
+        if (json_field(line, "input", pairs[n].input, 256) ||
+            json_field(line, "output", pairs[n].output, 256)) continue;
+        pairs[n].quality = json_field(line, "quality", q, sizeof(q)) ? 1.0f : (float)atof(q);
+        n++;
+    }
+    return n;
+}
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+// ============================================================
+// Q8_0 helpers (GGML layout: fp16 scale + 32 int8 per block)
+// ============================================================
+static uint16_t f32_to_f16(float f) {
+    union { float f; uint32_t u; } c = { f };
+    uint32_t sign = (c.u >> 16) & 0x8000u;
+    int exp = (int)((c.u >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = c.u & 0x7FFFFFu;
+    if (exp <= 0) return (uint16_t)sign;
+    if (exp >= 31) return (uint16_t)(sign | 0x7C00u);
+    uint32_t h = sign | ((uint32_t)exp << 10) | (mant >> 13);
+    if (mant & 0x1000u) h++;
+    return (uint16_t)h;
+}
+
+static float f16_to_f32(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    int exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FFu;
+    union { uint32_t u; float f; } c;
+    if (exp == 0) c.u = sign;
+    else c.u = sign | ((uint32_t)(exp - 15 + 127) << 23) | (mant << 13);
+    return c.f;
+}
+
+static void quantize_q8(const float *w, uint8_t *q, int rows, int cols) {
+    for (int r = 0; r < rows; r++)
+        for (int b = 0; b < cols / 32; b++) {
+            const float *src = w + (size_t)r * cols + b * 32;
+            uint8_t *blk = q + ((size_t)r * (cols / 32) + b) * 34;
+            float amax = 0.0f;
+            for (int i = 0; i < 32; i++) if (fabsf(src[i]) > amax) amax = fabsf(src[i]);
+            uint16_t h = f32_to_f16(amax / 127.0f);
+            float d = f16_to_f32(h);
+            blk[0] = (uint8_t)h; blk[1] = (uint8_t)(h >> 8);
+            for (int i = 0; i < 32; i++) {
+                int v = d > 0.0f ? (int)lrintf(src[i] / d) : 0;
+                if (v > 127) v = 127;
+                if (v < -127) v = -127;
+                blk[2 + i] = (uint8_t)(int8_t)v;
+            }
+        }
+}
+
+// ============================================================
+// Random model
+// ============================================================
+typedef struct {
+    OitBpModel m;
+    float *w[OO_LORA_NPROJ];          // f32 copies (reference forward)
+    float *emb, *cls, *rms_att, *rms_ffn, *rms_final;
+    void  *blobs[OO_LORA_NPROJ + 2];
+    oo_lora_state_t lora;
+    void  *lora_mem;
+    LlmkRope rope;
+    void  *rope_mem;
+} TestModel;
+
+static void model_build(TestModel *tm, int dim, int hidden, int layers, int heads,
+                        int kv_heads, int vocab, int seq_len, int q8) {
+    memset(tm, 0, sizeof(*tm));
+    OitBpModel *m = &tm->m;
+    int kv = dim * kv_heads / heads;
+    m->dim = dim; m->hidden_dim = hidden; m->n_layers = layers;
+    m->n_heads = heads; m->n_kv_heads = kv_heads; m->vocab_size = vocab; m->seq_len = seq_len;
+
+    UINT32 in[OO_LORA_NPROJ]  = { dim, dim, dim, dim, dim, hidden, dim };
+    UINT32 out[OO_LORA_NPROJ] = { dim, kv, kv, dim, hidden, dim, hidden };
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t per = (size_t)in[p] * out[p];
+        tm->w[p] = malloc(per * layers * sizeof(float));
+        float s = 1.0f / sqrtf((float)in[p]);
+        for (size_t i = 0; i < per * layers; i++) tm->w[p][i] = frand() * s;
+        oo_lora_weight_t *wd = &m->proj.w[p];
+        wd->in_dim = in[p]; wd->out_dim = out[p];
+        if (q8) {
+            wd->kind = OO_LORA_W_Q8_0;
+            wd->layer_bytes = (UINT64)out[p] * (in[p] / 32) * 34;
+            uint8_t *b = malloc(wd->layer_bytes * layers);
+            for (int l = 0; l < layers; l++)
+                quantize_q8(tm->w[p] + per * l, b + wd->layer_bytes * l, (int)out[p], (int)in[p]);
+            // reference uses the dequantised weights
+            for (int l = 0; l < layers; l++)
+                for (UINT32 r = 0; r < out[p]; r++)
+                    for (UINT32 c = 0; c < in[p]; c++) {
+                        const uint8_t *blk = b + wd->layer_bytes * l + ((size_t)r * (in[p] / 32) + c / 32) * 34;
+                        float d = f16_to_f32((uint16_t)(blk[0] | (blk[1] << 8)));
+                        tm->w[p][per * l + (size_t)r * in[p] + c] = d * (float)(int8_t)blk[2 + c % 32];
+                    }
+            wd->base = b;
+        } else {
+            wd->kind = OO_LORA_W_F32;
+            wd->layer_bytes = per * sizeof(float);
+            wd->base = (UINT8 *)tm->w[p];
+        }
+        tm->blobs[p] = wd->base == (UINT8 *)tm->w[p] ? NULL : wd->base;
+    }
+    m->proj.n_layers = (UINT32)layers;
+
+    tm->emb = malloc((size_t)vocab * dim * sizeof(float));
+    tm->cls = malloc((size_t)vocab * dim * sizeof(float));
+    for (int i = 0; i < vocab * dim; i++) { tm->emb[i] = frand(); tm->cls[i] = frand() * 0.25f; }
+    tm->rms_att = malloc((size_t)layers * dim * sizeof(float));
+    tm->rms_ffn = malloc((size_t)layers * dim * sizeof(float));
+    tm->rms_final = malloc((size_t)dim * sizeof(float));
+    for (int i = 0; i < layers * dim; i++) { tm->rms_att[i] = 1.0f + 0.1f * frand(); tm->rms_ffn[i] = 1.0f + 0.1f * frand(); }
+    for (int i = 0; i < dim; i++) tm->rms_final[i] = 1.0f + 0.1f * frand();
+    m->tok_embd = tm->emb; m->tok_row_bytes = (uint64_t)dim * sizeof(float); m->tok_kind = OO_LORA_W_F32;
+    m->wcls = tm->cls; m->cls_kind = OO_LORA_W_F32;
+    m->rms_att = tm->rms_att; m->rms_ffn = tm->rms_ffn; m->rms_final = tm->rms_final;
+
+    UINT64 lb = oo_lora_bytes((UINT32)layers, (UINT32)dim, (UINT32)kv, (UINT32)hidden, LORA_MAX_RANK);
+    tm->lora_mem = malloc(lb);
+    oo_lora_init(&tm->lora, (UINT32)layers, (UINT32)dim, (UINT32)kv, (UINT32)hidden,
+                 LORA_MAX_RANK, tm->lora_mem, lb);
+}
+
+static void model_free(TestModel *tm) {
+    for (int p = 0; p < OO_LORA_NPROJ; p++) { free(tm->w[p]); free(tm->blobs[p]); }
+    free(tm->emb); free(tm->cls); free(tm->rms_att); free(tm->rms_ffn); free(tm->rms_final);
+    free(tm->lora_mem);
+    free(tm->rope_mem);
+}
+
+// Give B non-zero values so dL/dA is observable
+// rope: 0 = none, 1 = interleaved pairs, 2 = NeoX halves (base 10000, full head)
+static void model_set_rope(TestModel *tm, int rope) {
+    if (!rope) return;
+    LlmkRopeParams rp;
+    llmk_rope_defaults(&rp);
+    rp.layout = (rope == 2) ? LLMK_ROPE_NEOX : LLMK_ROPE_NORM;
+    int hs = tm->m.dim / tm->m.n_heads;
+    uint64_t bytes = llmk_rope_table_bytes(tm->m.seq_len, hs);
+    tm->rope_mem = aligned_alloc(16, (size_t)((bytes + 15) & ~(uint64_t)15));
+    llmk_rope_init(&tm->rope, &rp, hs, tm->m.seq_len, tm->rope_mem, bytes);
+    tm->m.rope = &tm->rope;
+}
+
+static void lora_randomize_b(oo_lora_state_t *st, float s) {
+    for (UINT32 l = 0; l < st->n_layers; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            oo_lora_adapter_t *a = &st->layers[l][p];
+            for (UINT32 i = 0; i < a->out_dim * a->rank; i++) a->B[i] = frand() * s;
+        }
+}
+
+static void *trainer_make(OitBpTrainer *t, TestModel *tm, int n_train, int max_t) {
+    uint64_t bytes = oit_bp_bytes(&tm->m, n_train, max_t);
+    void *arena = malloc(bytes);
+    int rc = oit_bp_init(t, &tm->m, &tm->lora, n_train, max_t, arena, bytes);
+    if (rc) { free(arena); return NULL; }
+    return arena;
+}
+
+// Byte tokenizer: BOS = 1, byte b → b + 3. ctx != NULL: a vocab without BOS
+static int enc_bytes(void *ctx, const char *text, int add_bos, int *out, int max) {
+    int n = 0;
+    if (max < 1) return 0;
+    if (add_bos && !ctx) out[n++] = 1;
+    for (; *text && n < max; text++) out[n++] = (unsigned char)*text + 3;
+    return n;
+}
+
+// ============================================================
+// Reference: token-at-a-time forward with a KV cache (double precision),
+// the same schedule as transformer_forward, adapters via oo_lora_forward
+// ============================================================
+static void ref_rmsnorm(double *o, const double *x, const float *w, int n) {
+    double ss = 0.0;
+    for (int i = 0; i < n; i++) ss += x[i] * x[i];
+    double r = 1.0 / sqrt(ss / n + 1e-5);
+    for (int i = 0; i < n; i++) o[i] = w[i] * x[i] * r;
+}
+
+static void ref_mm(double *out, const double *x, const TestModel *tm, int p, int l) {
+    const oo_lora_weight_t *wd = &tm->m.proj.w[p];
+    int n = (int)wd->in_dim, d = (int)wd->out_dim;
+    const float *w = tm->w[p] + (size_t)l * n * d;
+    for (int j = 0; j < d; j++) {
+        double s = 0.0;
+        for (int i = 0; i < n; i++) s += (double)w[(size_t)j * n + i] * x[i];
+        out[j] = s;
+    }
+    const oo_lora_adapter_t *a = &tm->lora.layers[l][p];
+    double t[LORA_MAX_RANK];
+    for (UINT32 k = 0; k < a->rank; k++) {
+        double s = 0.0;
+        for (int i = 0; i < n; i++) s += (double)a->A[(size_t)k * n + i] * x[i];
+        t[k] = s;
+    }
+    for (int j = 0; j < d; j++) {
+        double s = 0.0;
+        for (UINT32 k = 0; k < a->rank; k++) s += (double)a->B[(size_t)j * a->rank + k] * t[k];
+        out[j] += a->scale * s;
+    }
+}
+
+// Rotates n_heads heads of v at pos with libm angles (the reference for llmk_rope)
+static void ref_rope(double *v, int n_heads, int hs, int pos, int layout) {
+    for (int h = 0; h < n_heads; h++) {
+        double *x = v + h * hs;
+        for (int i = 0; i < hs / 2; i++) {
+            double a = pos * pow(10000.0, -2.0 * i / hs), c = cos(a), sn = sin(a);
+            int i0 = (layout == LLMK_ROPE_NEOX) ? i : 2 * i;
+            int i1 = (layout == LLMK_ROPE_NEOX) ? i + hs / 2 : 2 * i + 1;
+            double x0 = x[i0], x1 = x[i1];
+            x[i0] = x0 * c - x1 * sn;
+            x[i1] = x0 * sn + x1 * c;
+        }
+    }
+}
+
+static double ref_loss(const TestModel *tm, const int *tok, int n, int ts) {
+    const OitBpModel *m = &tm->m;
+    int D = m->dim, H = m->hidden_dim, L = m->n_layers, V = m->vocab_size;
+    int K = D * m->n_kv_heads / m->n_heads, hs = D / m->n_heads, kvm = m->n_heads / m->n_kv_heads;
+    double *kc = calloc((size_t)L * n * K, sizeof(double)), *vc = calloc((size_t)L * n * K, sizeof(double));
+    double x[512], xb[512], q[512], o[512], h1[512], h3[512], tmp[512], att[512], lg[1024];
+    double loss = 0.0;
+    for (int pos = 0; pos < n - 1; pos++) {
+        for (int i = 0; i < D; i++) x[i] = tm->emb[(size_t)tok[pos] * D + i];
+        for (int l = 0; l < L; l++) {
+            ref_rmsnorm(xb, x, m->rms_att + l * D, D);
+            ref_mm(q, xb, tm, OO_LORA_WQ, l);
+            ref_mm(kc + ((size_t)l * n + pos) * K, xb, tm, OO_LORA_WK, l);
+            ref_mm(vc + ((size_t)l * n + pos) * K, xb, tm, OO_LORA_WV, l);
+            if (m->rope) {
+                ref_rope(q, m->n_heads, hs, pos, m->rope->p.layout);
+                ref_rope(kc + ((size_t)l * n + pos) * K, m->n_kv_heads, hs, pos, m->rope->p.layout);
+            }
+            for (int h = 0; h < m->n_heads; h++) {
+                int kh = (h / kvm) * hs;
+                double mx = -1e300, sum = 0.0;
+                for (int s = 0; s <= pos; s++) {
+                    double d = 0.0;
+                    for (int j = 0; j < hs; j++) d += q[h * hs + j] * kc[((size_t)l * n + s) * K + kh + j];
+                    att[s] = d / sqrt((double)hs);
+                    if (att[s] > mx) mx = att[s];
+                }
+                for (int s = 0; s <= pos; s++) { att[s] = exp(att[s] - mx); sum += att[s]; }
+                for (int j = 0; j < hs; j++) {
+                    double acc = 0.0;
+                    for (int s = 0; s <= pos; s++) acc += att[s] / sum * vc[((size_t)l * n + s) * K + kh + j];
+                    o[h * hs + j] = acc;
+                }
+            }
+            ref_mm(tmp, o, tm, OO_LORA_WO, l);
+            for (int i = 0; i < D; i++) x[i] += tmp[i];
+            ref_rmsnorm(xb, x, m->rms_ffn + l * D, D);
+            ref_mm(h1, xb, tm, OO_LORA_W1, l);
+            ref_mm(h3, xb, tm, OO_LORA_W3, l);
+            for (int i = 0; i < H; i++) h1[i] = h1[i] / (1.0 + exp(-h1[i])) * h3[i];
+            ref_mm(tmp, h1, tm, OO_LORA_W2, l);
+            for (int i = 0; i < D; i++) x[i] += tmp[i];
+        }
+        if (pos < ts - 1) continue;
+        ref_rmsnorm(xb, x, m->rms_final, D);
+        double mx = -1e300, sum = 0.0;
+        for (int v = 0; v < V; v++) {
+            double s = 0.0;
+            for (int i = 0; i < D; i++) s += (double)tm->cls[(size_t)v * D + i] * xb[i];
+            lg[v] = s;
+            if (s > mx) mx = s;
+        }
+        for (int v = 0; v < V; v++) sum += exp(lg[v] - mx);
+        loss += log(sum) + mx - lg[tok[pos + 1]];
+    }
+    free(kc); free(vc);
+    return loss / (n - ts);
+}
+
+// ============================================================
+// Tests
+// ============================================================
+#define SM_DIM 64
+#define SM_HID 172
+#define SM_L   5
+#define SM_NH  8
+#define SM_KVH 4
+#define SM_V   512
+#define SM_T   64
+
+static void test_init(void) {
+    printf("\n[init]\n");
+    TestModel tm;
+    model_build(&tm, SM_DIM, SM_HID, SM_L, SM_NH, SM_KVH, SM_V, 256, 0);
+    OitBpTrainer t;
+    void *arena = trainer_make(&t, &tm, 2, SM_T);
+    ASSERT_TRUE(arena != NULL, "init succeeds on stories260K shape");
+    if (!arena) { model_free(&tm); return; }
+    uint32_t per = 0;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        per += (tm.m.proj.w[p].in_dim + tm.m.proj.w[p].out_dim) * LORA_MAX_RANK;
+    ASSERT_EQ(t.n_param, 2 * per, "n_param = adapters of the last 2 layers");
+    ASSERT_TRUE(t.param == tm.lora.layers[SM_L - 2][0].A, "param tail starts at layer L-2 Wq.A");
+    ASSERT_TRUE(t.param + t.n_param == tm.lora.mem + tm.lora.mem_floats, "param tail ends at arena end");
+
+    OitBpTrainer bad;
+    uint64_t bytes = oit_bp_bytes(&tm.m, 2, SM_T);
+    ASSERT_TRUE(oit_bp_init(&bad, &tm.m, &tm.lora, 2, SM_T, arena, bytes - 64) < 0, "short arena refused");
+    ASSERT_TRUE(oit_bp_init(&bad, &tm.m, &tm.lora, SM_L + 1, SM_T, arena, bytes) < 0, "n_train > layers refused");
+    ASSERT_TRUE(oit_bp_init(&bad, &tm.m, &tm.lora, 2, 1024, arena, bytes) < 0, "max_t > seq_len refused");
+
+    int tok[8] = { 1, 10, 11, 12, 13, 14, 15, 16 };
+    tm.lora.merged = 1;
+    ASSERT_TRUE(oit_bp_sample(&t, tok, 8, 4) < 0.0f, "sample refused while merged");
+    tm.lora.merged = 0;
+    ASSERT_TRUE(oit_bp_sample(&t, tok, 8, 8) < 0.0f, "empty target span refused");
+    free(arena);
+    model_free(&tm);
+}
+
+static const char *rope_name(int rope) { return rope == 2 ? ", RoPE neox" : (rope ? ", RoPE" : ""); }
+
+static void test_forward(int q8, int rope) {
+    printf("\n[forward vs KV-cache reference, %s base%s]\n", q8 ? "Q8_0" : "f32", rope_name(rope));
+    TestModel tm;
+    model_build(&tm, SM_DIM, q8 ? 192 : SM_HID, SM_L, SM_NH, SM_KVH, SM_V, 256, q8);
+    model_set_rope(&tm, rope);
+    lora_randomize_b(&tm.lora, 0.05f);
+    OitBpTrainer t;
+    void *arena = trainer_make(&t, &tm, 2, SM_T);
+    int tok[24];
+    for (int i = 0; i < 24; i++) tok[i] = 3 + (int)((frand() + 1.0f) * 100.0f);
+    tok[0] = 1;
+    double ref = ref_loss(&tm, tok, 24, 6);
+    float got = oit_bp_loss(&t, tok, 24, 6);
+    float tr = oit_bp_sample(&t, tok, 24, 6);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "loss %.6f vs reference %.6f", got, ref);
+    ASSERT_TRUE(fabs(got - ref) < 2e-3 * fabs(ref) + 1e-4, msg);
+    ASSERT_TRUE(tr == got, "training pass reports the same loss as eval");
+    free(arena);
+    model_free(&tm);
+}
+
+static void test_gradcheck(int q8, int rope) {
+    printf("\n[gradient check, %s base%s]\n", q8 ? "Q8_0" : "f32", rope_name(rope));
+    TestModel tm;
+    model_build(&tm, SM_DIM, q8 ? 192 : SM_HID, SM_L, SM_NH, SM_KVH, SM_V, 256, q8);
+    model_set_rope(&tm, rope);
+    lora_randomize_b(&tm.lora, 0.1f);
+    OitBpTrainer t;
+    void *arena = trainer_make(&t, &tm, 2, SM_T);
+    int n = 16, ts = 5, tok[16];
+    for (int i = 0; i < n; i++) tok[i] = 3 + (int)((frand() + 1.0f) * 120.0f);
+    tok[0] = 1;
+
+    oit_bp_sample(&t, tok, n, ts);
+    float scale = 1.0f / (float)t.tokens_acc;
+
+    // For every adapter in the trained layers, check its largest |dA| and |dB|
+    int checked = 0, bad = 0;
+    double worst = 0.0;
+    for (int l = SM_L - 2; l < SM_L; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++)
+            for (int which = 0; which < 2; which++) {
+                oo_lora_adapter_t *a = &tm.lora.layers[l][p];
+                float *base = which ? a->B : a->A;
+                uint32_t cnt = a->rank * (which ? a->out_dim : a->in_dim);
+                float *g = t.grad + (base - t.param);
+                uint32_t best = 0;
+                for (uint32_t i = 1; i < cnt; i++) if (fabsf(g[i]) > fabsf(g[best])) best = i;
+                float an = g[best] * scale;
+                float save = base[best], h = 2e-3f;
+                base[best] = save + h;
+                double lp = ref_loss(&tm, tok, n, ts);
+                base[best] = save - h;
+                double lm = ref_loss(&tm, tok, n, ts);
+                base[best] = save;
+                double num = (lp - lm) / (2.0 * h);
+                double err = fabs(an - num) / (fabs(num) + 1e-3);
+                if (err > worst) worst = err;
+                if (err > 2e-2) {
+                    bad++;
+                    printf("    L%d P%d %s[%u]: analytic %.6g numeric %.6g\n",
+                           l, p, which ? "B" : "A", best, an, num);
+                }
+                checked++;
+            }
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%d adapter grads match finite differences (worst rel err %.2e)", checked, worst);
+    ASSERT_TRUE(bad == 0, msg);
+
+    // Adapters below the trained window are not parameters at all
+    float before = tm.lora.layers[SM_L - 3][OO_LORA_WQ].B[0];
+    oit_bp_apply(&t);
+    ASSERT_TRUE(tm.lora.layers[SM_L - 3][OO_LORA_WQ].B[0] == before, "frozen layer adapter unchanged by apply");
+    ASSERT_TRUE(t.steps == 1 && tm.lora.dirty == 1, "apply steps the optimizer and marks the adapter dirty");
+    float gsum = 0.0f;
+    for (uint32_t i = 0; i < t.n_param; i++) gsum += fabsf(t.grad[i]);
+    ASSERT_TRUE(gsum == 0.0f && t.tokens_acc == 0, "gradient cleared after apply");
+    free(arena);
+    model_free(&tm);
+}
+
+static void test_overfit(void) {
+    printf("\n[overfit JSONL pairs through oit_train_from_jsonl]\n");
+    TestModel tm;
+    model_build(&tm, SM_DIM, SM_HID, SM_L, SM_NH, SM_KVH, SM_V, 256, 0);
+    OitBpTrainer t;
+    void *arena = trainer_make(&t, &tm, 2, SM_T);
+    t.lr = 1e-2f;
+
+    OitEngine *e = malloc(sizeof(OitEngine));
+    oit_init(e, SM_DIM);
+    oit_attach_backprop(e, &t, enc_bytes, NULL);
+    ASSERT_TRUE(e->bp == &t, "trainer attached to the engine");
+
+    int tok[SM_T], n, ni;
+    ni = enc_bytes(NULL, "sky?", 1, tok, SM_T);
+    n = ni + enc_bytes(NULL, "the sky is blue", 0, tok + ni, SM_T - ni);
+    float l0 = oit_bp_loss(&t, tok, n, ni);
+
+    int pairs = 0;
+    for (int it = 0; it < 60; it++) pairs += oit_train_from_jsonl(e, (void *)1);
+    float l1 = oit_bp_loss(&t, tok, n, ni);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "held pair loss %.3f -> %.3f after %u steps", l0, l1, t.steps);
+    ASSERT_TRUE(l1 < 0.5f * l0, msg);
+    ASSERT_EQ(pairs, 60 * 4, "all JSONL pairs consumed");
+    ASSERT_EQ((int)tm.lora.step_count, 60, "one optimizer step per batch");
+
+    // Without a BOS in the vocab, a one-token response is still a sample
+    OitPair one;
+    memset(&one, 0, sizeof(one));
+    strcpy(one.input, "sky?");
+    strcpy(one.output, "b");
+    oit_attach_backprop(e, &t, enc_bytes, (void *)1);
+    uint32_t steps = t.steps;
+    oit_train_batch(e, &one, 1);
+    ASSERT_TRUE(t.steps == steps + 1, "vocab without BOS: the response keeps its first token");
+
+    oit_attach_backprop(e, NULL, NULL, NULL);
+    ASSERT_TRUE(e->bp == NULL, "detach restores the fallback path");
+    free(e);
+    free(arena);
+    model_free(&tm);
+}
+
+static void bench(void) {
+    printf("\n[benchmark: stories260K shape, T=%d]\n", SM_T);
+    TestModel tm;
+    model_build(&tm, SM_DIM, SM_HID, SM_L, SM_NH, SM_KVH, SM_V, 256, 0);
+    int tok[SM_T];
+    tok[0] = 1;
+    for (int i = 1; i < SM_T; i++) tok[i] = 3 + (i * 7) % 200;
+    for (int nt = 1; nt <= SM_L; nt += 2) {
+        OitBpTrainer t;
+        void *arena = trainer_make(&t, &tm, nt, SM_T);
+        int iters = 20;
+        double t0 = now_ns();
+        for (int i = 0; i < iters; i++) { oit_bp_sample(&t, tok, SM_T, 1); oit_bp_apply(&t); }
+        double dt = (now_ns() - t0) / 1e9;
+        printf("  trained layers %d: %.0f tok/s  (%.2f ms/step, arena %.1f KB)\n",
+               nt, iters * SM_T / dt, dt * 1e3 / iters,
+               oit_bp_bytes(&tm.m, nt, SM_T) / 1024.0);
+        free(arena);
+    }
+    model_free(&tm);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OO In-Situ Backprop LoRA — Host Test Suite\n");
+    printf("==============================================\n");
+
+    oo_lora_set_cpu(__builtin_cpu_supports("avx2"));
+    test_init();
+    test_forward(0, 0);
+    test_forward(1, 0);
+    test_forward(0, 1);
+    test_forward(1, 2);
+    test_gradcheck(0, 0);
+    test_gradcheck(1, 0);
+    test_gradcheck(0, 1);
+    test_gradcheck(1, 2);
+    test_overfit();
+    bench();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All in-situ backprop tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
@@ -0,0 +1,552 @@
+// test_oo_insitu_dream.c — Host harness for dream consolidation into the adapter
+//
+// Tests:
+//   init: arena sizing, scheduler bound to another trainer refused
+//   collect: replay split by hash, both sets forced non-empty, prior 0 dropped,
+//     samples keep the whole response (a vocab without BOS included)
+//   select: consolidation set = top prior · NLL among the non-held turns
+//   consolidate: perplexity falls on the consolidated turns and stays flat
+//     on an unrelated control set the cycle never sees
+//   reject: an update that contradicts the replay set is rolled back
+//     bit-exactly (adapter + Adam state)
+//   budget: the TSC budget stops TRAIN; cancel mid-cycle restores the adapter
+//   AP mode: scoring on a pthread "AP", steps sharded via oo_insitu_parallel,
+//     driven by REPL-style polling; matches the inline run of the same shards
+//
+// Same model as test_oo_insitu_parallel.c (random, stories260K geometry).
+//
+// Build (Linux, x86-64 host, no UEFI):
+//   gcc -std=gnu11 -O2 -msse2 -Wall -Wextra -pthread -I../engine/self_improve -I../engine/ssm
+//       -I../engine/trainer -I../oo-multicore/core test_oo_insitu_dream.c
+//       ../engine/trainer/oo_insitu_dream.c ../engine/trainer/oo_insitu_parallel.c
+//       ../engine/trainer/oo_insitu_backprop.c ../engine/self_improve/oo_lora.c
+//       ../engine/llama2/llmk_rope.c ../oo-multicore/core/oo_mc_queue.c -lm -o test_oo_insitu_dream
+//
+// Run:
+//   ./test_oo_insitu_dream
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "oo_insitu_dream.h"
+
+// ============================================================
+// Stubs: NVMe (oo_lora persist)
+// ============================================================
+int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes)        { (void)lba; (void)buf; (void)bytes; return -1; }
+int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes) { (void)lba; (void)buf; (void)bytes; return -1; }
+
+// Session memories (journal replay ring) and an unrelated control set
+static const char *g_mem[][2] = {
+    { "hi",        "hello there" },        { "sky?",       "the sky is blue" },
+    { "cat",       "a cat sat" },          { "ok",         "all good" },
+    { "dog",       "the dog ran" },        { "sun",        "it is warm" },
+    { "name",      "i am oo" },            { "boot",       "boot is done" },
+    { "mem",       "memory is fine" },     { "time",       "it is late" },
+    { "home",      "home is here" },       { "rain",       "the rain fell" },
+    { "tea",       "tea is hot" },         { "moon",       "the moon is up" },
+    { "bye",       "see you soon" },       { "who",        "i am the kernel" },
+};
+#define N_MEM ((int)(sizeof(g_mem) / sizeof(g_mem[0])))
+
+static const char *g_ctl[][2] = {
+    { "7*6",   "42; 0x2A" },   { "[1,2]", "{3:4}" },   { "#@!",  "%%^&" },
+    { "9-4",   "5 == 5" },     { "a|b",   "c&d~e" },   { "QXZ",  "VWK" },
+};
+#define N_CTL ((int)(sizeof(g_ctl) / sizeof(g_ctl[0])))
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ == b_) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %lld, expected %lld)\n", msg, a_, b_); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+// ============================================================
+// Random f32 model (stories260K geometry)
+// ============================================================
+#define SM_DIM 64
+#define SM_HID 172
+#define SM_L   5
+#define SM_NH  8
+#define SM_KVH 4
+#define SM_V   512
+#define SM_T   64
+
+typedef struct {
+    OitBpModel m;
+    float *w[OO_LORA_NPROJ];
+    float *emb, *cls, *rms_att, *rms_ffn, *rms_final;
+    oo_lora_state_t lora;
+    void  *lora_mem;
+    OitBpTrainer t;
+    void  *bp_arena;
+} TestModel;
+
+static void model_build(TestModel *tm, uint32_t seed) {
+    memset(tm, 0, sizeof(*tm));
+    g_rng = seed;
+    OitBpModel *m = &tm->m;
+    int kv = SM_DIM * SM_KVH / SM_NH;
+    m->dim = SM_DIM; m->hidden_dim = SM_HID; m->n_layers = SM_L;
+    m->n_heads = SM_NH; m->n_kv_heads = SM_KVH; m->vocab_size = SM_V; m->seq_len = 256;
+
+    UINT32 in[OO_LORA_NPROJ]  = { SM_DIM, SM_DIM, SM_DIM, SM_DIM, SM_DIM, SM_HID, SM_DIM };
+    UINT32 out[OO_LORA_NPROJ] = { SM_DIM, kv, kv, SM_DIM, SM_HID, SM_DIM, SM_HID };
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t per = (size_t)in[p] * out[p];
+        tm->w[p] = malloc(per * SM_L * sizeof(float));
+        float s = 1.0f / sqrtf((float)in[p]);
+        for (size_t i = 0; i < per * SM_L; i++) tm->w[p][i] = frand() * s;
+        oo_lora_weight_t *wd = &m->proj.w[p];
+        wd->in_dim = in[p]; wd->out_dim = out[p];
+        wd->kind = OO_LORA_W_F32;
+        wd->layer_bytes = per * sizeof(float);
+        wd->base = (UINT8 *)tm->w[p];
+    }
+    m->proj.n_layers = SM_L;
+
+    tm->emb = malloc((size_t)SM_V * SM_DIM * sizeof(float));
+    tm->cls = malloc((size_t)SM_V * SM_DIM * sizeof(float));
+    for (int i = 0; i < SM_V * SM_DIM; i++) { tm->emb[i] = frand(); tm->cls[i] = frand() * 0.25f; }
+    tm->rms_att = malloc((size_t)SM_L * SM_DIM * sizeof(float));
+    tm->rms_ffn = malloc((size_t)SM_L * SM_DIM * sizeof(float));
+    tm->rms_final = malloc((size_t)SM_DIM * sizeof(float));
+    for (int i = 0; i < SM_L * SM_DIM; i++) { tm->rms_att[i] = 1.0f; tm->rms_ffn[i] = 1.0f; }
+    for (int i = 0; i < SM_DIM; i++) tm->rms_final[i] = 1.0f;
+    m->tok_embd = tm->emb; m->tok_row_bytes = SM_DIM * sizeof(float); m->tok_kind = OO_LORA_W_F32;
+    m->wcls = tm->cls; m->cls_kind = OO_LORA_W_F32;
+    m->rms_att = tm->rms_att; m->rms_ffn = tm->rms_ffn; m->rms_final = tm->rms_final;
+
+    UINT64 lb = oo_lora_bytes(SM_L, SM_DIM, (UINT32)kv, SM_HID, LORA_MAX_RANK);
+    tm->lora_mem = malloc(lb);
+    oo_lora_init(&tm->lora, SM_L, SM_DIM, (UINT32)kv, SM_HID, LORA_MAX_RANK, tm->lora_mem, lb);
+    for (UINT32 l = 0; l < SM_L; l++)          // non-zero B so dA is live
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            oo_lora_adapter_t *a = &tm->lora.layers[l][p];
+            for (UINT32 i = 0; i < a->out_dim * a->rank; i++) a->B[i] = frand() * 0.05f;
+        }
+
+    uint64_t bytes = oit_bp_bytes(m, 2, SM_T);
+    tm->bp_arena = malloc(bytes);
+    oit_bp_init(&tm->t, m, &tm->lora, 2, SM_T, tm->bp_arena, bytes);
+}
+
+static void model_free(TestModel *tm) {
+    for (int p = 0; p < OO_LORA_NPROJ; p++) free(tm->w[p]);
+    free(tm->emb); free(tm->cls); free(tm->rms_att); free(tm->rms_ffn); free(tm->rms_final);
+    free(tm->lora_mem); free(tm->bp_arena);
+}
+
+// Byte tokenizer: BOS = 1, byte b → b + 3. ctx != NULL: a vocab without BOS
+static int enc_bytes(void *ctx, const char *text, int add_bos, int *out, int max) {
+    int n = 0;
+    if (max < 1) return 0;
+    if (add_bos && !ctx) out[n++] = 1;
+    for (; *text && n < max; text++) out[n++] = (unsigned char)*text + 3;
+    return n;
+}
+
+// ============================================================
+// pthread "APs" on the oo_mc work queue
+// ============================================================
+static OoMulticoreCtx g_mc;
+
+typedef struct { pthread_t th; int idx; } ApThread;
+static ApThread g_aps[OO_MAX_CORES];
+
+static void *ap_main(void *p) {
+    ApThread *ap = (ApThread *)p;
+    oo_mc_worker_loop(&g_mc, ap->idx);
+    return NULL;
+}
+
+static void mc_setup(int n_aps) {
+    memset(&g_mc, 0, sizeof(g_mc));
+    g_mc.enabled = 1;
+    g_mc.core_count = n_aps + 1;
+    g_mc.bsp_idx = 0;
+    g_mc.cores[0].role = OO_CORE_ROLE_BSP;
+    for (int i = 1; i <= n_aps; i++) {
+        g_mc.cores[i].role = OO_CORE_ROLE_WORKER;
+        g_mc.mc_workers[g_mc.mc_worker_count++] = i;
+        g_aps[i].idx = i;
+        pthread_create(&g_aps[i].th, NULL, ap_main, &g_aps[i]);
+    }
+}
+
+static void mc_teardown(int n_aps) {
+    oo_mc_stop_workers(&g_mc);
+    for (int i = 1; i <= n_aps; i++) pthread_join(g_aps[i].th, NULL);
+}
+
+static void *dream_make(OitDream *d, TestModel *tm, OitParallel *par, OoMulticoreCtx *mc) {
+    uint64_t bytes = oit_dream_bytes(&tm->t);
+    void *arena = malloc(bytes);
+    if (oit_dream_init(d, &tm->t, par, mc, enc_bytes, NULL, arena, bytes) != 0) { free(arena); return NULL; }
+    return arena;
+}
+
+static void *par_make(OitParallel *p, TestModel *tm, int shards, OoMulticoreCtx *mc) {
+    uint64_t bytes = oit_par_bytes(&tm->t, shards);
+    void *arena = malloc(bytes);
+    if (oit_par_init(p, &tm->t, mc, shards, arena, bytes) != 0) { free(arena); return NULL; }
+    return arena;
+}
+
+// Newer turns weigh more, like the journal replay order
+static void dream_fill(OitDream *d) {
+    oit_dream_reset(d);
+    for (int i = 0; i < N_MEM; i++)
+        oit_dream_add(d, g_mem[i][0], g_mem[i][1], 0.5f + 0.5f * (float)i / (float)N_MEM);
+}
+
+// Token-weighted mean response NLL of a pair set (ln-perplexity)
+static double set_nll(OitBpTrainer *t, const char *(*pairs)[2], int count) {
+    double acc = 0.0;
+    int w = 0;
+    for (int p = 0; p < count; p++) {
+        int tok[SM_T], ni = enc_bytes(NULL, pairs[p][0], 1, tok, SM_T);
+        int n = ni + enc_bytes(NULL, pairs[p][1], 0, tok + ni, SM_T - ni);
+        acc += (double)oit_bp_loss(t, tok, n, ni) * (n - ni);
+        w += n - ni;
+    }
+    return acc / w;
+}
+
+static int dream_run(OitDream *d, int max_steps, uint64_t budget) {
+    if (oit_dream_begin(d, max_steps, budget) != 0) return 0;
+    for (int i = 0; i < 100000; i++)
+        if (oit_dream_poll(d)) return 1;
+    return 0;
+}
+
+static int adapter_equal(const TestModel *tm, const float *copy) {
+    return memcmp(tm->lora_mem, copy, tm->lora.mem_floats * sizeof(float)) == 0;
+}
+
+static float *adapter_copy(const TestModel *tm) {
+    float *c = malloc(tm->lora.mem_floats * sizeof(float));
+    memcpy(c, tm->lora_mem, tm->lora.mem_floats * sizeof(float));
+    return c;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+
+static void test_init(void) {
+    printf("\n[init]\n");
+    TestModel tm, other;
+    model_build(&tm, 0x1234u);
+    model_build(&other, 0x4321u);
+    OitDream *d = malloc(sizeof(OitDream));
+    void *arena = dream_make(d, &tm, NULL, NULL);
+    ASSERT_TRUE(arena != NULL && d->ready, "init inline");
+    ASSERT_EQ(oit_dream_busy(d), 0, "idle after init");
+    uint64_t need = oit_dream_bytes(&tm.t);
+    ASSERT_TRUE(oit_dream_init(d, &tm.t, NULL, NULL, enc_bytes, NULL, arena, need - 64) < 0, "short arena refused");
+    OitParallel *p = malloc(sizeof(OitParallel));
+    void *pa = par_make(p, &other, 2, NULL);
+    ASSERT_TRUE(oit_dream_init(d, &tm.t, p, NULL, enc_bytes, NULL, arena, need) < 0,
+                "scheduler of another trainer refused");
+    free(pa);
+    free(p);
+    free(arena);
+    free(d);
+    model_free(&other);
+    model_free(&tm);
+}
+
+static void test_collect_select(void) {
+    printf("\n[collect + select]\n");
+    TestModel tm;
+    model_build(&tm, 0x2222u);
+    OitDream *d = malloc(sizeof(OitDream));
+    void *arena = dream_make(d, &tm, NULL, NULL);
+
+    ASSERT_EQ(oit_dream_add(d, "x", "ignored", 0.0f), 0, "prior 0 dropped");
+    ASSERT_EQ(oit_dream_add(d, "hi", "hello there", 1.0f), 1, "turn taken");
+    ASSERT_TRUE(d->item[0].ts == 3 && d->item[0].n == 14 && d->tok[3] == 'h' + 3,
+                "sample = BOS prompt | whole response");
+    d->encode_ctx = (void *)1;
+    ASSERT_EQ(oit_dream_add(d, "a", "b", 1.0f), 1, "vocab without BOS: one-token response taken");
+    ASSERT_TRUE(d->item[1].ts == 1 && d->item[1].n == 2 && d->tok[d->t->max_t + 1] == 'b' + 3,
+                "vocab without BOS: the response keeps its first token");
+    d->encode_ctx = NULL;
+    oit_dream_reset(d);
+    oit_dream_add(d, "hi", "hello there", 1.0f);
+    ASSERT_TRUE(oit_dream_begin(d, 4, 0) < 0, "one turn cannot be split");
+
+    dream_fill(d);
+    ASSERT_EQ(d->count, N_MEM, "all memories queued");
+    int held = 0;
+    for (int i = 0; i < d->count; i++) {
+        held += d->item[i].held;
+        if (d->item[i].held != (d->item[i].hash % OIT_DREAM_HOLDOUT_EVERY == 0)) held = -100;
+    }
+    ASSERT_TRUE(held > 0 && held < d->count, "replay set chosen by hash, both sets non-empty");
+
+    float *before = adapter_copy(&tm);
+    ASSERT_EQ(oit_dream_begin(d, 1, 0), 0, "cycle begins");
+    ASSERT_EQ(d->phase, OIT_DREAM_SCORE, "scoring (inline: already done)");
+    ASSERT_EQ(oit_dream_poll(d), 0, "score -> train");
+    ASSERT_EQ(d->phase, OIT_DREAM_TRAIN, "training");
+    ASSERT_TRUE(adapter_equal(&tm, before), "scoring never writes the adapter");
+
+    int sorted = 1, top = 1, picked = 0;
+    for (int s = 1; s < d->n_sel; s++) sorted &= d->item[d->sel[s - 1]].value >= d->item[d->sel[s]].value;
+    float floor = d->item[d->sel[d->n_sel - 1]].value;
+    for (int i = 0; i < d->count; i++) {
+        const OitDreamItem *it = &d->item[i];
+        picked += it->picked;
+        if (it->picked && it->held) top = 0;
+        if (!it->picked && !it->held && it->value > floor) top = 0;
+        if (fabsf(it->value - it->prior * it->nll) > 1e-6f && !it->held) top = 0;
+    }
+    int expect = d->count - held < OIT_DREAM_SELECT ? d->count - held : OIT_DREAM_SELECT;
+    ASSERT_EQ(picked, expect, "consolidation set size");
+    ASSERT_TRUE(sorted && top, "top prior x NLL among non-held turns");
+    oit_dream_cancel(d);
+    ASSERT_TRUE(adapter_equal(&tm, before) && !oit_dream_busy(d), "cancel restores the adapter");
+
+    free(before);
+    free(arena);
+    free(d);
+    model_free(&tm);
+}
+
+static void test_consolidate(void) {
+    printf("\n[consolidate: perplexity on consolidated vs control set]\n");
+    TestModel tm;
+    model_build(&tm, 0xF00Du);
+    tm.t.lr = 1e-2f;
+    OitDream *d = malloc(sizeof(OitDream));
+    void *arena = dream_make(d, &tm, NULL, NULL);
+
+    double ctl0 = set_nll(&tm.t, g_ctl, N_CTL);
+    dream_fill(d);
+    double t0 = now_ns();
+    int done = dream_run(d, 40, 0);
+    double ms = (now_ns() - t0) / 1e6;
+    double ctl1 = set_nll(&tm.t, g_ctl, N_CTL);
+
+    char msg[200];
+    ASSERT_TRUE(done && d->last_accepted, "cycle completes and is accepted");
+    ASSERT_EQ(d->steps, 40, "step budget used");
+    snprintf(msg, sizeof(msg), "consolidated ppl %.1f -> %.1f", exp(d->sel_before), exp(d->sel_after));
+    ASSERT_TRUE(d->sel_after < d->sel_before - 0.5f, msg);
+    snprintf(msg, sizeof(msg), "replay ppl %.1f -> %.1f (gate: +%.0f%%)", exp(d->held_before), exp(d->held_after),
+             OIT_DREAM_TOL * 100.0f);
+    ASSERT_TRUE(d->held_after <= d->held_before * (1.0f + OIT_DREAM_TOL), msg);
+    snprintf(msg, sizeof(msg), "control ppl %.1f -> %.1f (flat within 5%%)", exp(ctl0), exp(ctl1));
+    ASSERT_TRUE(fabs(ctl1 - ctl0) <= 0.05 * ctl0, msg);
+    printf("    %d steps, %.1f ms, %.2f Mcycles\n", d->steps, ms, d->last_cycles / 1e6);
+
+    // A second cycle scores every turn against the kept adapter
+    float prev[N_MEM];
+    for (int i = 0; i < N_MEM; i++) prev[i] = d->item[i].nll_after;
+    dream_fill(d);
+    dream_run(d, 8, 0);
+    int same = d->cycles == 2;
+    for (int i = 0; i < N_MEM; i++) same &= fabsf(d->item[i].nll - prev[i]) <= 1e-5f * (1.0f + prev[i]);
+    ASSERT_TRUE(same, "next cycle starts from the kept adapter");
+
+    free(arena);
+    free(d);
+    model_free(&tm);
+}
+
+static void test_reject(void) {
+    printf("\n[reject: replay regression rolls back]\n");
+    TestModel tm;
+    model_build(&tm, 0xBADu);
+    tm.t.lr = 1e-2f;
+    OitDream *d = malloc(sizeof(OitDream));
+    void *arena = dream_make(d, &tm, NULL, NULL);
+
+    // Learn the replay turns first (also warms the Adam state a rollback must keep)
+    oit_dream_reset(d);
+    char pr[16];
+    for (int i = 8; i < 12; i++) {
+        snprintf(pr, sizeof(pr), "say %d", i);
+        oit_dream_add(d, pr, g_mem[i][1], 1.0f);
+    }
+    const int *seq[4];
+    int n[4], ts[4];
+    for (int i = 0; i < 4; i++) { seq[i] = d->tok + i * tm.t.max_t; n[i] = d->item[i].n; ts[i] = d->item[i].ts; }
+    for (int s = 0; s < 30; s++) oit_bp_minibatch(&tm.t, seq, n, ts, 4);
+    ASSERT_EQ(tm.t.steps, 30, "replay turns learned");
+
+    // Consolidation turns that contradict the replay turns
+    oit_dream_reset(d);
+    for (int i = 0; i < 12; i++) {
+        snprintf(pr, sizeof(pr), "say %d", i);
+        oit_dream_add(d, pr, i < 8 ? "zzzzzzzzzzzzzzzz" : g_mem[i][1], 1.0f);
+    }
+    d->n_held = 0;
+    for (int i = 0; i < d->count; i++) d->n_held += (d->item[i].held = (uint8_t)(i >= 8));
+
+    float *before = adapter_copy(&tm);
+    float *m0 = malloc(tm.t.n_param * sizeof(float));
+    memcpy(m0, tm.t.adam_m, tm.t.n_param * sizeof(float));
+    uint32_t steps0 = tm.t.steps;
+
+    int done = dream_run(d, 16, 0);
+    char msg[160];
+    snprintf(msg, sizeof(msg), "consolidated ppl %.1f -> %.1f, replay ppl %.1f -> %.1f: rejected",
+             exp(d->sel_before), exp(d->sel_after), exp(d->held_before), exp(d->held_after));
+    ASSERT_TRUE(done && !d->last_accepted && d->rejected == 1, msg);
+    ASSERT_TRUE(adapter_equal(&tm, before), "adapter restored bit-exactly");
+    ASSERT_TRUE(memcmp(m0, tm.t.adam_m, tm.t.n_param * sizeof(float)) == 0 && tm.t.steps == steps0,
+                "Adam moments and step count restored");
+
+    free(m0);
+    free(before);
+    free(arena);
+    free(d);
+    model_free(&tm);
+}
+
+static void test_budget(void) {
+    printf("\n[budget + cancel]\n");
+    TestModel tm;
+    model_build(&tm, 0x5151u);
+    OitDream *d = malloc(sizeof(OitDream));
+    void *arena = dream_make(d, &tm, NULL, NULL);
+    float *before = adapter_copy(&tm);
+
+    dream_fill(d);
+    ASSERT_TRUE(dream_run(d, 1000, 1), "1-cycle TSC budget");
+    ASSERT_EQ(d->steps, 0, "budget exhausted before the first step");
+    ASSERT_TRUE(adapter_equal(&tm, before), "no step, adapter unchanged");
+
+    dream_fill(d);
+    oit_dream_begin(d, 1000, 0);
+    for (int i = 0; i < 5; i++) oit_dream_poll(d);
+    ASSERT_TRUE(d->steps > 0 && !adapter_equal(&tm, before), "mid-TRAIN: adapter moved");
+    oit_dream_cancel(d);
+    ASSERT_TRUE(adapter_equal(&tm, before) && d->phase == OIT_DREAM_IDLE, "cancel rolls back mid-TRAIN");
+
+    free(before);
+    free(arena);
+    free(d);
+    model_free(&tm);
+}
+
+static void test_ap_mode(void) {
+    printf("\n[AP mode: scoring + sharded steps behind the idle loop]\n");
+    // Reference: same shards, every job inline
+    TestModel ref, tm;
+    model_build(&ref, 0x7777u);
+    model_build(&tm, 0x7777u);
+    memcpy(tm.lora_mem, ref.lora_mem, tm.lora.mem_floats * sizeof(float));   // oo_lora_init draws A itself
+    ref.t.lr = 1e-2f;
+    tm.t.lr = 1e-2f;
+    OitParallel *rp = malloc(sizeof(OitParallel));
+    void *rpa = par_make(rp, &ref, 2, NULL);
+    OitDream *rd = malloc(sizeof(OitDream));
+    void *rda = dream_make(rd, &ref, rp, NULL);
+    dream_fill(rd);
+    ASSERT_TRUE(dream_run(rd, 16, 0) && rd->steps == 16, "inline sharded cycle");
+
+    mc_setup(2);
+    OitParallel *p = malloc(sizeof(OitParallel));
+    void *pa = par_make(p, &tm, 2, &g_mc);
+    OitDream *d = malloc(sizeof(OitDream));
+    void *da = dream_make(d, &tm, p, &g_mc);
+    dream_fill(d);
+    float *before = adapter_copy(&tm);
+
+    ASSERT_EQ(oit_dream_begin(d, 16, 0), 0, "cycle queued on the APs");
+    int polls = 0, done = 0, untouched = 1;
+    double deadline = now_ns() + 60e9;
+    while (!done && now_ns() < deadline) {
+        // REPL key-wait loop: the scheduler and the dream are both polled
+        if (oit_par_poll(p)) polls++;
+        if (d->phase == OIT_DREAM_SCORE && !adapter_equal(&tm, before)) untouched = 0;
+        done = oit_dream_poll(d);
+        sched_yield();
+    }
+    mc_teardown(2);
+    ASSERT_TRUE(done, "cycle finished from polling alone");
+    ASSERT_TRUE(untouched, "adapter untouched while the AP scores");
+    ASSERT_EQ(d->steps, 16, "steps counted even when the idle loop applies them");
+    ASSERT_TRUE(polls > 0, "idle-loop poll applied some of the steps");
+    ASSERT_TRUE(d->last_accepted == rd->last_accepted && d->sel_after == rd->sel_after &&
+                d->held_after == rd->held_after, "same result as the inline run");
+    ASSERT_TRUE(memcmp(tm.lora_mem, ref.lora_mem, tm.lora.mem_floats * sizeof(float)) == 0,
+                "same adapter as the inline run");
+
+    free(before);
+    free(da); free(d); free(pa); free(p);
+    free(rda); free(rd); free(rpa); free(rp);
+    model_free(&tm);
+    model_free(&ref);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OO In-Situ Dream Consolidation — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_init();
+    test_collect_select();
+    test_consolidate();
+    test_reject();
+    test_budget();
+    test_ap_mode();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All dream consolidation tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
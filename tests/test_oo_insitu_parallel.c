@@ -0,0 +1,451 @@
+// test_oo_insitu_parallel.c — pthread host harness for data-parallel LoRA training
+//
+// Tests:
+//   init: shard 0 aliases the trainer buffers, bad shard counts refused
+//   equivalence: sharded gradient + tree all-reduce == serial accumulation
+//     for 1..8 shards; non-root shard gradients are zeroed by the reduce
+//   async: the adapter is untouched until oit_par_poll runs on the BSP
+//   engine: oit_train_from_jsonl → sharded steps, loss falls
+//   scaling: step time for 1..16 workers (BSP + 0..15 pthread "APs")
+//
+// Same model as test_oo_insitu_backprop.c (random, stories260K geometry).
+// The scheduler, the work queue and the trainer are the files the UEFI
+// build uses; pthreads stand in for APs (no mwait in ring 3).
+//
+// Build (Linux, x86-64 host, no UEFI):
+//   gcc -std=gnu11 -O2 -msse2 -Wall -Wextra -pthread -I../engine/self_improve -I../engine/ssm
+//       -I../engine/trainer -I../oo-multicore/core test_oo_insitu_parallel.c
+//       ../engine/trainer/oo_insitu_parallel.c ../engine/trainer/oo_insitu_backprop.c
+//       ../engine/trainer/oo_insitu_train.c ../engine/self_improve/oo_lora.c
+//       ../engine/llama2/llmk_rope.c ../oo-multicore/core/oo_mc_queue.c -o test_oo_insitu_parallel -lm
+//
+// Run:
+//   ./test_oo_insitu_parallel
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "oo_insitu_train.h"
+#include "oo_insitu_parallel.h"
+
+// ============================================================
+// Stubs: NVMe (oo_lora persist) and the JSONL readers (soma_mind.c)
+// ============================================================
+int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes)        { (void)lba; (void)buf; (void)bytes; return -1; }
+int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes) { (void)lba; (void)buf; (void)bytes; return -1; }
+
+static const char *g_pairs[][2] = {
+    { "hi",   "hello there" },   { "sky?", "the sky is blue" },
+    { "cat",  "a cat sat" },     { "ok",   "all good" },
+    { "dog",  "the dog ran" },   { "sun",  "it is warm" },
+    { "1+1",  "two" },           { "name", "i am oo" },
+};
+#define N_PAIRS ((int)(sizeof(g_pairs) / sizeof(g_pairs[0])))
+
+uint32_t oit_count_jsonl_lines(const void *root_dir, const unsigned short *path16) {
+    (void)root_dir; (void)path16;
+    return 0;
+}
+
+int oit_read_jsonl_pairs(void *root_dir, const unsigned short *path16,
+                         OitPair *pairs, int max_pairs) {
+    (void)root_dir;
+    if (path16[0] != 'O') return 0;            // only OO_DREAM.JSONL
+    int n = 0;
+    for (; n < N_PAIRS && n < max_pairs; n++) {
+        snprintf(pairs[n].input, sizeof(pairs[n].input), "%s", g_pairs[n][0]);
+        snprintf(pairs[n].output, sizeof(pairs[n].output), "%s", g_pairs[n][1]);
+        pairs[n].quality = 1.0f;
+    }
+    return n;
+}
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ == b_) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %lld, expected %lld)\n", msg, a_, b_); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+// ============================================================
+// Random f32 model (stories260K geometry)
+// ============================================================
+#define SM_DIM 64
+#define SM_HID 172
+#define SM_L   5
+#define SM_NH  8
+#define SM_KVH 4
+#define SM_V   512
+#define SM_T   64
+
+typedef struct {
+    OitBpModel m;
+    float *w[OO_LORA_NPROJ];
+    float *emb, *cls, *rms_att, *rms_ffn, *rms_final;
+    oo_lora_state_t lora;
+    void  *lora_mem;
+    OitBpTrainer t;
+    void  *bp_arena;
+} TestModel;
+
+static void model_build(TestModel *tm, uint32_t seed) {
+    memset(tm, 0, sizeof(*tm));
+    g_rng = seed;
+    OitBpModel *m = &tm->m;
+    int kv = SM_DIM * SM_KVH / SM_NH;
+    m->dim = SM_DIM; m->hidden_dim = SM_HID; m->n_layers = SM_L;
+    m->n_heads = SM_NH; m->n_kv_heads = SM_KVH; m->vocab_size = SM_V; m->seq_len = 256;
+
+    UINT32 in[OO_LORA_NPROJ]  = { SM_DIM, SM_DIM, SM_DIM, SM_DIM, SM_DIM, SM_HID, SM_DIM };
+    UINT32 out[OO_LORA_NPROJ] = { SM_DIM, kv, kv, SM_DIM, SM_HID, SM_DIM, SM_HID };
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t per = (size_t)in[p] * out[p];
+        tm->w[p] = malloc(per * SM_L * sizeof(float));
+        float s = 1.0f / sqrtf((float)in[p]);
+        for (size_t i = 0; i < per * SM_L; i++) tm->w[p][i] = frand() * s;
+        oo_lora_weight_t *wd = &m->proj.w[p];
+        wd->in_dim = in[p]; wd->out_dim = out[p];
+        wd->kind = OO_LORA_W_F32;
+        wd->layer_bytes = per * sizeof(float);
+        wd->base = (UINT8 *)tm->w[p];
+    }
+    m->proj.n_layers = SM_L;
+
+    tm->emb = malloc((size_t)SM_V * SM_DIM * sizeof(float));
+    tm->cls = malloc((size_t)SM_V * SM_DIM * sizeof(float));
+    for (int i = 0; i < SM_V * SM_DIM; i++) { tm->emb[i] = frand(); tm->cls[i] = frand() * 0.25f; }
+    tm->rms_att = malloc((size_t)SM_L * SM_DIM * sizeof(float));
+    tm->rms_ffn = malloc((size_t)SM_L * SM_DIM * sizeof(float));
+    tm->rms_final = malloc((size_t)SM_DIM * sizeof(float));
+    for (int i = 0; i < SM_L * SM_DIM; i++) { tm->rms_att[i] = 1.0f; tm->rms_ffn[i] = 1.0f; }
+    for (int i = 0; i < SM_DIM; i++) tm->rms_final[i] = 1.0f;
+    m->tok_embd = tm->emb; m->tok_row_bytes = SM_DIM * sizeof(float); m->tok_kind = OO_LORA_W_F32;
+    m->wcls = tm->cls; m->cls_kind = OO_LORA_W_F32;
+    m->rms_att = tm->rms_att; m->rms_ffn = tm->rms_ffn; m->rms_final = tm->rms_final;
+
+    UINT64 lb = oo_lora_bytes(SM_L, SM_DIM, (UINT32)kv, SM_HID, LORA_MAX_RANK);
+    tm->lora_mem = malloc(lb);
+    oo_lora_init(&tm->lora, SM_L, SM_DIM, (UINT32)kv, SM_HID, LORA_MAX_RANK, tm->lora_mem, lb);
+    for (UINT32 l = 0; l < SM_L; l++)          // non-zero B so dA is live
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            oo_lora_adapter_t *a = &tm->lora.layers[l][p];
+            for (UINT32 i = 0; i < a->out_dim * a->rank; i++) a->B[i] = frand() * 0.05f;
+        }
+
+    uint64_t bytes = oit_bp_bytes(m, 2, SM_T);
+    tm->bp_arena = malloc(bytes);
+    oit_bp_init(&tm->t, m, &tm->lora, 2, SM_T, tm->bp_arena, bytes);
+}
+
+static void model_free(TestModel *tm) {
+    for (int p = 0; p < OO_LORA_NPROJ; p++) free(tm->w[p]);
+    free(tm->emb); free(tm->cls); free(tm->rms_att); free(tm->rms_ffn); free(tm->rms_final);
+    free(tm->lora_mem); free(tm->bp_arena);
+}
+
+// Byte tokenizer: BOS = 1, byte b → b + 3
+static int enc_bytes(void *ctx, const char *text, int add_bos, int *out, int max) {
+    (void)ctx;
+    int n = 0;
+    if (max < 1) return 0;
+    if (add_bos) out[n++] = 1;
+    for (; *text && n < max; text++) out[n++] = (unsigned char)*text + 3;
+    return n;
+}
+
+// Random minibatch of `count` sequences with a target span
+static int  g_tok[OIT_PAR_BATCH_MAX][SM_T];
+static const int *g_seq[OIT_PAR_BATCH_MAX];
+static int  g_n[OIT_PAR_BATCH_MAX], g_ts[OIT_PAR_BATCH_MAX];
+
+static void make_batch(int count, int len) {
+    for (int s = 0; s < count; s++) {
+        g_tok[s][0] = 1;
+        for (int i = 1; i < len; i++) g_tok[s][i] = 3 + (int)((frand() + 1.0f) * 120.0f);
+        g_seq[s] = g_tok[s];
+        g_n[s] = len - (s % 5);
+        g_ts[s] = 1 + (s % 7);
+    }
+}
+
+// ============================================================
+// pthread "APs" on the oo_mc work queue
+// ============================================================
+static OoMulticoreCtx g_mc;
+
+typedef struct { pthread_t th; int idx; } ApThread;
+static ApThread g_aps[OO_MAX_CORES];
+
+static void *ap_main(void *p) {
+    ApThread *ap = (ApThread *)p;
+    oo_mc_worker_loop(&g_mc, ap->idx);
+    return NULL;
+}
+
+static void mc_setup(int n_aps) {
+    memset(&g_mc, 0, sizeof(g_mc));
+    g_mc.enabled = 1;
+    g_mc.core_count = n_aps + 1;
+    g_mc.bsp_idx = 0;
+    g_mc.cores[0].role = OO_CORE_ROLE_BSP;
+    for (int i = 1; i <= n_aps; i++) {
+        g_mc.cores[i].role = OO_CORE_ROLE_WORKER;
+        g_mc.mc_workers[g_mc.mc_worker_count++] = i;
+        g_aps[i].idx = i;
+        pthread_create(&g_aps[i].th, NULL, ap_main, &g_aps[i]);
+    }
+}
+
+static void mc_teardown(int n_aps) {
+    oo_mc_stop_workers(&g_mc);
+    for (int i = 1; i <= n_aps; i++) pthread_join(g_aps[i].th, NULL);
+}
+
+static void *par_make(OitParallel *p, TestModel *tm, int shards, OoMulticoreCtx *mc) {
+    uint64_t bytes = oit_par_bytes(&tm->t, shards);
+    void *arena = malloc(bytes);
+    if (oit_par_init(p, &tm->t, mc, shards, arena, bytes) != 0) { free(arena); return NULL; }
+    return arena;
+}
+
+// ============================================================
+// Tests
+// ============================================================
+
+static void test_init(void) {
+    printf("\n[init]\n");
+    TestModel tm;
+    model_build(&tm, 0x1234u);
+    OitParallel *p = malloc(sizeof(OitParallel));
+    void *arena = par_make(p, &tm, 4, NULL);
+    ASSERT_TRUE(arena != NULL, "init with 4 shards");
+    if (arena) {
+        ASSERT_TRUE(p->shard[0].grad == tm.t.grad, "shard 0 reduces into the trainer gradient");
+        ASSERT_TRUE(p->shard[1].grad != tm.t.grad && p->shard[3].grad != NULL, "shards 1..3 have private gradients");
+        ASSERT_EQ(oit_par_busy(p), 0, "idle after init");
+    }
+    uint64_t b4 = oit_par_bytes(&tm.t, 4);
+    ASSERT_TRUE(oit_par_bytes(&tm.t, 0) == 0 && oit_par_bytes(&tm.t, OIT_PAR_MAX_SHARDS + 1) == 0,
+                "shard count outside 1..OIT_PAR_MAX_SHARDS refused");
+    ASSERT_TRUE(oit_par_init(p, &tm.t, NULL, 4, arena, b4 - 64) < 0, "short arena refused");
+    free(arena);
+    free(p);
+    model_free(&tm);
+}
+
+static void test_equivalence(void) {
+    printf("\n[sharded gradient == serial gradient]\n");
+    const int shard_counts[] = { 1, 2, 3, 5, 8 };
+    TestModel ref;
+    model_build(&ref, 0xBEEFu);
+    g_rng = 77;
+    make_batch(12, 40);
+    float ref_loss = 0.0f;
+    uint32_t ref_tok = 0;
+    for (int s = 0; s < 12; s++) {
+        uint32_t nt;
+        ref_loss += oit_bp_run(&ref.t, &ref.t.ws, ref.t.grad, g_seq[s], g_n[s], g_ts[s], &nt);
+        ref_tok += nt;
+    }
+
+    for (unsigned c = 0; c < sizeof(shard_counts) / sizeof(shard_counts[0]); c++) {
+        int ns = shard_counts[c], aps = ns - 1 < 3 ? ns - 1 : 3;
+        TestModel tm;
+        model_build(&tm, 0xBEEFu);
+        memcpy(tm.lora_mem, ref.lora_mem, tm.lora.mem_floats * sizeof(float));   // oo_lora_init draws A itself
+        tm.t.accum = 2;                        // keep the gradient for inspection
+        mc_setup(aps);
+        OitParallel *p = malloc(sizeof(OitParallel));
+        void *arena = par_make(p, &tm, ns, &g_mc);
+        int got = oit_par_begin(p, g_seq, g_n, g_ts, 12);
+        oit_par_wait(p);
+        mc_teardown(aps);
+
+        double maxd = 0.0, maxg = 0.0;
+        for (uint32_t i = 0; i < tm.t.n_param; i++) {
+            double d = fabs((double)tm.t.grad[i] - ref.t.grad[i]);
+            if (d > maxd) maxd = d;
+            if (fabs(ref.t.grad[i]) > maxg) maxg = fabs(ref.t.grad[i]);
+        }
+        int clean = 1;
+        for (int s = 1; s < ns; s++)
+            for (uint32_t i = 0; i < tm.t.n_param; i++) clean &= (p->shard[s].grad[i] == 0.0f);
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%d shard(s), %d AP thread(s): max |Δg| %.2e of %.2e, tokens %u/%u",
+                 ns, aps, maxd, maxg, tm.t.tokens_acc, ref_tok);
+        ASSERT_TRUE(got == 12 && maxd <= 1e-5 * maxg && tm.t.tokens_acc == ref_tok &&
+                    fabsf(tm.t.last_loss - ref_loss / ref_tok) < 1e-5f, msg);
+        ASSERT_TRUE(clean, "non-root shard gradients zeroed by the reduce");
+        free(arena);
+        free(p);
+        model_free(&tm);
+    }
+    model_free(&ref);
+}
+
+static void test_async(void) {
+    printf("\n[async step: BSP owns the optimizer]\n");
+    TestModel tm;
+    model_build(&tm, 0xCAFEu);
+    mc_setup(3);
+    OitParallel *p = malloc(sizeof(OitParallel));
+    void *arena = par_make(p, &tm, 3, &g_mc);
+    g_rng = 5;
+    make_batch(9, 48);
+    float before = tm.t.param[tm.t.n_param - 1];
+
+    oit_par_begin(p, g_seq, g_n, g_ts, 9);
+    double deadline = now_ns() + 20e9;
+    while (p->phase != OIT_PAR_DONE && now_ns() < deadline) sched_yield();   // BSP stays free
+    ASSERT_EQ(p->phase, OIT_PAR_DONE, "APs finish shards and all-reduce without the BSP");
+    ASSERT_TRUE(tm.t.param[tm.t.n_param - 1] == before && tm.t.steps == 0,
+                "adapter untouched until the BSP polls");
+    ASSERT_EQ(oit_par_poll(p), 1, "poll applies the reduced step");
+    ASSERT_TRUE(tm.t.steps == 1 && tm.t.param[tm.t.n_param - 1] != before && tm.lora.dirty,
+                "AdamW ran on the shared adapter");
+    ASSERT_EQ(oit_par_poll(p), 0, "nothing more to apply");
+    printf("    step: shards %.2f Mcycles, all-reduce %.3f Mcycles\n",
+           p->last_shard_cycles / 1e6, p->last_reduce_cycles / 1e6);
+
+    mc_teardown(3);
+    free(arena);
+    free(p);
+    model_free(&tm);
+}
+
+static void test_engine(void) {
+    printf("\n[engine: oit_train_from_jsonl on AP shards]\n");
+    TestModel tm;
+    model_build(&tm, 0xF00Du);
+    tm.t.lr = 1e-2f;
+    mc_setup(2);
+    OitParallel *p = malloc(sizeof(OitParallel));
+    void *arena = par_make(p, &tm, 3, &g_mc);
+    OitEngine *e = malloc(sizeof(OitEngine));
+    oit_init(e, SM_DIM);
+    oit_attach_backprop(e, &tm.t, enc_bytes, NULL);
+    oit_attach_parallel(e, p);
+    ASSERT_TRUE(e->par == p, "scheduler attached");
+
+    int tok[SM_T], ni = enc_bytes(NULL, "sky?", 1, tok, SM_T);
+    int n = ni + enc_bytes(NULL, "the sky is blue", 0, tok + ni, SM_T - ni);
+    float l0 = oit_bp_loss(&tm.t, tok, n, ni);
+    int pairs = 0;
+    for (int it = 0; it < 40; it++) {
+        pairs += oit_train_from_jsonl(e, (void *)1);
+        while (oit_par_busy(p)) { oit_par_poll(p); sched_yield(); }   // REPL-style polling
+    }
+    float l1 = oit_bp_loss(&tm.t, tok, n, ni);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "held pair loss %.3f -> %.3f after %u sharded steps", l0, l1, p->steps);
+    ASSERT_TRUE(l1 < 0.5f * l0, msg);
+    ASSERT_EQ(pairs, 40 * N_PAIRS, "all pairs consumed");
+    ASSERT_EQ(p->steps, 40, "one sharded step per batch");
+
+    oit_attach_backprop(e, NULL, NULL, NULL);
+    ASSERT_TRUE(e->par == NULL, "detaching the trainer detaches the scheduler");
+    mc_teardown(2);
+    free(e);
+    free(arena);
+    free(p);
+    model_free(&tm);
+}
+
+static void bench_scaling(void) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("\n[scaling: %d samples x %d tokens per step, %ld host CPU(s)]\n",
+           OIT_PAR_BATCH_MAX, SM_T, ncpu);
+    TestModel tm;
+    model_build(&tm, 0xABCDu);
+    g_rng = 9;
+    make_batch(OIT_PAR_BATCH_MAX, SM_T);
+    double base = 0.0;
+    for (int w = 1; w <= OO_MAX_CORES; w = (w < 4) ? w + 1 : w * 2) {
+        int aps = w - 1;                       // BSP + aps pthreads
+        mc_setup(aps);
+        OitParallel *p = malloc(sizeof(OitParallel));
+        void *arena = par_make(p, &tm, w, &g_mc);
+        int iters = ncpu >= w ? 4 : 1;
+        oit_par_begin(p, g_seq, g_n, g_ts, OIT_PAR_BATCH_MAX);   // warm-up
+        oit_par_wait(p);
+        double t0 = now_ns();
+        for (int i = 0; i < iters; i++) {
+            oit_par_begin(p, g_seq, g_n, g_ts, OIT_PAR_BATCH_MAX);
+            oit_par_wait(p);                   // BSP helps, like a blocking /oo_train
+        }
+        double ms = (now_ns() - t0) / 1e6 / iters;
+        if (w == 1) base = ms;
+        printf("  workers %2d: %8.2f ms/step  speedup %.2fx%s\n", w, ms, base / ms,
+               ncpu < w ? "  (oversubscribed)" : "");
+        mc_teardown(aps);
+        free(arena);
+        free(p);
+    }
+    model_free(&tm);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OO In-Situ Parallel Training — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_init();
+    test_equivalence();
+    test_async();
+    test_engine();
+    bench_scaling();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All parallel training tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
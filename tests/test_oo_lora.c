@@ -0,0 +1,564 @@
+// test_oo_lora.c — Host-mode harness for fused / mergeable LoRA adapters
+//
+// Tests:
+//   init geometry: 7 projections, kv_dim / hidden_dim shapes, arena sizing
+//   fused kernels (SSE2 + AVX2) vs base matmul + separate LoRA pass, f32 and Q8_0
+//   merge: plain matmul on merged weights matches the reference path
+//   unmerge: f32 restored to float noise, Q8_0 restored byte-exact
+//   bank hot-swap between resident adapters never compounds deltas
+//   persist/load round trip over a RAM-backed LBA stub
+//   benchmark: fused vs separate pass
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=gnu11 -O2 -msse2 -Wall -Wextra -I../engine/self_improve -I../engine/ssm
+//       test_oo_lora.c ../engine/self_improve/oo_lora.c -o test_oo_lora -lm
+//
+// Run:
+//   ./test_oo_lora
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "oo_lora.h"
+
+// ============================================================
+// RAM-backed NVMe stub (512-byte LBAs)
+// ============================================================
+#define DISK_LBAS 0x4000
+static uint8_t g_disk[DISK_LBAS * 512];
+
+int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes) {
+    if ((uint64_t)lba * 512 + bytes > sizeof(g_disk)) return -1;
+    memcpy(buf, g_disk + (size_t)lba * 512, bytes);
+    return 0;
+}
+
+int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes) {
+    if ((uint64_t)lba * 512 + bytes > sizeof(g_disk)) return -1;
+    memcpy(g_disk + (size_t)lba * 512, buf, bytes);
+    return 0;
+}
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+// ============================================================
+// Q8_0 helpers (GGML layout: fp16 scale + 32 int8 per block)
+// ============================================================
+static uint16_t f32_to_f16(float f) {
+    union { float f; uint32_t u; } c = { f };
+    uint32_t sign = (c.u >> 16) & 0x8000u;
+    int exp = (int)((c.u >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = c.u & 0x7FFFFFu;
+    if (exp <= 0) return (uint16_t)sign;                 // flush tiny scales
+    if (exp >= 31) return (uint16_t)(sign | 0x7C00u);
+    uint32_t h = sign | ((uint32_t)exp << 10) | (mant >> 13);
+    if (mant & 0x1000u) h++;                             // round half up
+    return (uint16_t)h;
+}
+
+static float f16_to_f32(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    int exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FFu;
+    union { uint32_t u; float f; } c;
+    if (exp == 0) c.u = sign;   // helper only produces normals / zero
+    else c.u = sign | ((uint32_t)(exp - 15 + 127) << 23) | (mant << 13);
+    return c.f;
+}
+
+static void quantize_q8(const float *w, uint8_t *q, int rows, int cols) {
+    for (int r = 0; r < rows; r++)
+        for (int b = 0; b < cols / 32; b++) {
+            const float *src = w + (size_t)r * cols + b * 32;
+            uint8_t *blk = q + ((size_t)r * (cols / 32) + b) * 34;
+            float amax = 0.0f;
+            for (int i = 0; i < 32; i++) if (fabsf(src[i]) > amax) amax = fabsf(src[i]);
+            uint16_t h = f32_to_f16(amax / 127.0f);
+            float d = f16_to_f32(h);
+            blk[0] = (uint8_t)h; blk[1] = (uint8_t)(h >> 8);
+            for (int i = 0; i < 32; i++) {
+                int v = d > 0.0f ? (int)lrintf(src[i] / d) : 0;
+                if (v > 127) v = 127;
+                if (v < -127) v = -127;
+                blk[2 + i] = (uint8_t)(int8_t)v;
+            }
+        }
+}
+
+// Reference base matmul (double accumulation), then the separate LoRA pass.
+static void ref_f32(float *out, const float *x, const float *w, int n, int d,
+                    const oo_lora_adapter_t *a) {
+    for (int j = 0; j < d; j++) {
+        double s = 0.0;
+        for (int i = 0; i < n; i++) s += (double)w[(size_t)j * n + i] * x[i];
+        out[j] = (float)s;
+    }
+    if (a) oo_lora_forward(a, x, out, (UINT32)n);
+}
+
+static void ref_q8(float *out, const float *x, const uint8_t *q, int n, int d,
+                   const oo_lora_adapter_t *a, float *err_bound) {
+    int nb = n / 32;
+    for (int j = 0; j < d; j++) {
+        double s = 0.0, eb = 0.0;
+        for (int b = 0; b < nb; b++) {
+            const uint8_t *blk = q + ((size_t)j * nb + b) * 34;
+            float dd = f16_to_f32((uint16_t)(blk[0] | (blk[1] << 8)));
+            for (int i = 0; i < 32; i++) {
+                s  += (double)dd * (int8_t)blk[2 + i] * x[b * 32 + i];
+                eb += 0.5 * dd * fabs(x[b * 32 + i]);
+            }
+        }
+        out[j] = (float)s;
+        if (err_bound) err_bound[j] = (float)eb;
+    }
+    if (a) oo_lora_forward(a, x, out, (UINT32)n);
+}
+
+static float max_abs_diff(const float *a, const float *b, int n) {
+    float m = 0.0f;
+    for (int i = 0; i < n; i++) if (fabsf(a[i] - b[i]) > m) m = fabsf(a[i] - b[i]);
+    return m;
+}
+
+// ============================================================
+// Toy model: 2 layers, dim 64, kv_dim 32, hidden 96
+// ============================================================
+#define T_LAYERS 2
+#define T_DIM    64
+#define T_KV     32
+#define T_HID    96
+
+static const int t_in[OO_LORA_NPROJ]  = { T_DIM, T_DIM, T_DIM, T_DIM, T_DIM, T_HID, T_DIM };
+static const int t_out[OO_LORA_NPROJ] = { T_DIM, T_KV, T_KV, T_DIM, T_HID, T_DIM, T_HID };
+
+typedef struct {
+    float   *f32[OO_LORA_NPROJ];
+    uint8_t *q8[OO_LORA_NPROJ];
+    oo_lora_model_t mf, mq;
+} ToyModel;
+
+static void toy_open(ToyModel *t) {
+    t->mf.n_layers = t->mq.n_layers = T_LAYERS;
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t elems = (size_t)t_in[p] * t_out[p];
+        size_t qbytes = (size_t)t_out[p] * (t_in[p] / 32) * 34;
+        t->f32[p] = malloc(elems * T_LAYERS * sizeof(float));
+        t->q8[p] = malloc(qbytes * T_LAYERS);
+        for (size_t i = 0; i < elems * T_LAYERS; i++) t->f32[p][i] = 0.1f * frand();
+        for (int l = 0; l < T_LAYERS; l++)
+            quantize_q8(t->f32[p] + l * elems, t->q8[p] + l * qbytes, t_out[p], t_in[p]);
+        oo_lora_weight_t wf = { (UINT8 *)t->f32[p], elems * sizeof(float),
+                                (UINT32)t_in[p], (UINT32)t_out[p], OO_LORA_W_F32 };
+        oo_lora_weight_t wq = { t->q8[p], qbytes,
+                                (UINT32)t_in[p], (UINT32)t_out[p], OO_LORA_W_Q8_0 };
+        t->mf.w[p] = wf;
+        t->mq.w[p] = wq;
+    }
+}
+
+static void toy_close(ToyModel *t) {
+    for (int p = 0; p < OO_LORA_NPROJ; p++) { free(t->f32[p]); free(t->q8[p]); }
+}
+
+// Adapter with trained-looking (non-zero) B
+static void *adapter_open(oo_lora_state_t *st, float b_amp) {
+    UINT64 bytes = oo_lora_bytes(T_LAYERS, T_DIM, T_KV, T_HID, LORA_MAX_RANK);
+    void *mem = malloc((size_t)bytes);
+    oo_lora_init(st, T_LAYERS, T_DIM, T_KV, T_HID, LORA_MAX_RANK, mem, bytes);
+    for (int l = 0; l < T_LAYERS; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            oo_lora_adapter_t *a = &st->layers[l][p];
+            for (UINT32 i = 0; i < a->out_dim * a->rank; i++) a->B[i] = b_amp * frand();
+        }
+    return mem;
+}
+
+static uint8_t *q8_layer(ToyModel *t, int p, int l) {
+    return t->q8[p] + (size_t)l * t->mq.w[p].layer_bytes;
+}
+
+static float *f32_layer(ToyModel *t, int p, int l) {
+    return t->f32[p] + (size_t)l * t_in[p] * t_out[p];
+}
+
+// ============================================================
+// Test 1: geometry
+// ============================================================
+static void test_geometry(void) {
+    printf("\n[Test 1] init geometry\n");
+    static oo_lora_state_t st;
+    UINT64 bytes = oo_lora_bytes(T_LAYERS, T_DIM, T_KV, T_HID, 4);
+    UINT64 want = 0;
+    for (int p = 0; p < OO_LORA_NPROJ; p++) want += (UINT64)(t_in[p] + t_out[p]) * 4;
+    ASSERT_TRUE(bytes == want * T_LAYERS * sizeof(float), "oo_lora_bytes covers all 7 projections");
+
+    void *mem = malloc((size_t)bytes);
+    ASSERT_TRUE(oo_lora_init(&st, T_LAYERS, T_DIM, T_KV, T_HID, 4, mem, bytes - 4) < 0,
+                "short arena rejected");
+    ASSERT_TRUE(oo_lora_init(&st, T_LAYERS, T_DIM, T_KV, T_HID, LORA_MAX_RANK + 1, mem, bytes) < 0,
+                "rank above LORA_MAX_RANK rejected");
+    ASSERT_EQ(oo_lora_init(&st, T_LAYERS, T_DIM, T_KV, T_HID, 4, mem, bytes), 0, "init ok");
+
+    int shapes_ok = 1, zero_b = 1;
+    for (int l = 0; l < T_LAYERS; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            const oo_lora_adapter_t *a = &st.layers[l][p];
+            if (a->in_dim != (UINT32)t_in[p] || a->out_dim != (UINT32)t_out[p] || a->rank != 4)
+                shapes_ok = 0;
+            for (UINT32 i = 0; i < a->out_dim * a->rank; i++) if (a->B[i] != 0.0f) zero_b = 0;
+        }
+    ASSERT_TRUE(shapes_ok, "Wk/Wv out = kv_dim, W1/W3 out = hidden, W2 in = hidden");
+    ASSERT_TRUE(zero_b, "B starts at zero (adapter is a no-op until trained)");
+    ASSERT_TRUE(st.layers[T_LAYERS - 1][OO_LORA_W3].B + T_HID * 4 == (float *)mem + bytes / 4,
+                "factors packed exactly into the arena");
+    free(mem);
+}
+
+// ============================================================
+// Test 2: fused kernels vs reference
+// ============================================================
+static void test_fused(int avx2) {
+    printf("\n[Test 2%s] fused kernels (%s)\n", avx2 ? "b" : "a", avx2 ? "AVX2" : "SSE2");
+    oo_lora_set_cpu(avx2);
+    ToyModel t;
+    toy_open(&t);
+    static oo_lora_state_t st;
+    void *mem = adapter_open(&st, 0.5f);
+
+    float x[T_HID], ref[T_HID], got[T_HID], eb[T_HID];
+    float worst_f = 0.0f, worst_q = 0.0f, worst_plain = 0.0f, lora_mag = 0.0f;
+    for (int l = 0; l < T_LAYERS; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            int n = t_in[p], d = t_out[p];
+            const oo_lora_adapter_t *a = &st.layers[l][p];
+            for (int i = 0; i < n; i++) x[i] = frand();
+
+            ref_f32(ref, x, f32_layer(&t, p, l), n, d, a);
+            oo_lora_matmul_f32(got, x, f32_layer(&t, p, l), (UINT32)n, (UINT32)d, a);
+            float df = max_abs_diff(ref, got, d);
+            if (df > worst_f) worst_f = df;
+
+            ref_q8(ref, x, q8_layer(&t, p, l), n, d, a, NULL);
+            oo_lora_matmul_q8_0(got, x, q8_layer(&t, p, l), (UINT32)n, (UINT32)d, a);
+            float dq = max_abs_diff(ref, got, d);
+            if (dq > worst_q) worst_q = dq;
+
+            ref_q8(ref, x, q8_layer(&t, p, l), n, d, NULL, NULL);
+            oo_lora_matmul_q8_0(got, x, q8_layer(&t, p, l), (UINT32)n, (UINT32)d, NULL);
+            float dp = max_abs_diff(ref, got, d);
+            if (dp > worst_plain) worst_plain = dp;
+
+            for (int j = 0; j < d; j++) got[j] = 0.0f;
+            oo_lora_forward(a, x, got, (UINT32)n);
+            for (int j = 0; j < d; j++) if (fabsf(got[j]) > lora_mag) lora_mag = fabsf(got[j]);
+        }
+    (void)eb;
+    printf("  max |fused - ref|: f32 %.2e  q8 %.2e  (LoRA term up to %.2f)\n",
+           worst_f, worst_q, lora_mag);
+    ASSERT_TRUE(lora_mag > 0.01f, "adapter contributes a visible delta");
+    ASSERT_TRUE(worst_f < 1e-4f, "fused f32 == base + separate LoRA pass");
+    ASSERT_TRUE(worst_q < 1e-4f, "fused Q8_0 == dequantised base + separate LoRA pass");
+    ASSERT_TRUE(worst_plain < 1e-4f, "Q8_0 kernel without adapter == plain matmul");
+
+    // Shape mismatch falls back to the plain matmul instead of reading past B
+    ref_f32(ref, x, f32_layer(&t, OO_LORA_WQ, 0), T_DIM, T_DIM, NULL);
+    oo_lora_matmul_f32(got, x, f32_layer(&t, OO_LORA_WQ, 0), T_DIM, T_DIM, &st.layers[0][OO_LORA_WK]);
+    ASSERT_TRUE(max_abs_diff(ref, got, T_DIM) < 1e-4f, "mismatched adapter shape is ignored");
+
+    free(mem);
+    toy_close(&t);
+}
+
+// ============================================================
+// Test 3: merge / unmerge
+// ============================================================
+static void test_merge(void) {
+    printf("\n[Test 3] merge / unmerge\n");
+    oo_lora_set_cpu(0);
+    ToyModel t;
+    toy_open(&t);
+    static oo_lora_state_t st;
+    void *mem = adapter_open(&st, 0.5f);
+
+    // Snapshot originals
+    float *f_orig[OO_LORA_NPROJ];
+    uint8_t *q_orig[OO_LORA_NPROJ];
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t fb = (size_t)t.mf.w[p].layer_bytes * T_LAYERS, qb = (size_t)t.mq.w[p].layer_bytes * T_LAYERS;
+        f_orig[p] = malloc(fb); memcpy(f_orig[p], t.f32[p], fb);
+        q_orig[p] = malloc(qb); memcpy(q_orig[p], t.q8[p], qb);
+    }
+
+    // Reference outputs (base + separate pass) before merging
+    static float xs[T_LAYERS][OO_LORA_NPROJ][T_HID];
+    static float ref_f[T_LAYERS][OO_LORA_NPROJ][T_HID], ref_q[T_LAYERS][OO_LORA_NPROJ][T_HID];
+    static float bound[T_LAYERS][OO_LORA_NPROJ][T_HID];
+    for (int l = 0; l < T_LAYERS; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            for (int i = 0; i < t_in[p]; i++) xs[l][p][i] = frand();
+            ref_f32(ref_f[l][p], xs[l][p], f32_layer(&t, p, l), t_in[p], t_out[p], &st.layers[l][p]);
+            ref_q8(ref_q[l][p], xs[l][p], q8_layer(&t, p, l), t_in[p], t_out[p], &st.layers[l][p], bound[l][p]);
+        }
+
+    ASSERT_EQ(oo_lora_merge(&st, &t.mf), 0, "f32 merge ok");
+    ASSERT_TRUE(st.merged == 1, "adapter marked merged");
+    float got[T_HID], worst = 0.0f;
+    for (int l = 0; l < T_LAYERS; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            oo_lora_matmul_f32(got, xs[l][p], f32_layer(&t, p, l), (UINT32)t_in[p], (UINT32)t_out[p], NULL);
+            float d = max_abs_diff(got, ref_f[l][p], t_out[p]);
+            if (d > worst) worst = d;
+        }
+    printf("  max |merged f32 - ref|: %.2e\n", worst);
+    ASSERT_TRUE(worst < 1e-4f, "plain f32 matmul on merged weights == fused/reference");
+
+    oo_lora_backward_step(&st, ref_f[0][0], 0, 0);
+    ASSERT_TRUE(st.step_count == 0, "training refused while merged");
+
+    ASSERT_EQ(oo_lora_unmerge(&st, &t.mf), 0, "f32 unmerge ok");
+    float wdiff = 0.0f;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        for (size_t i = 0; i < (size_t)t_in[p] * t_out[p] * T_LAYERS; i++)
+            if (fabsf(t.f32[p][i] - f_orig[p][i]) > wdiff) wdiff = fabsf(t.f32[p][i] - f_orig[p][i]);
+    printf("  max |unmerged f32 - original|: %.2e\n", wdiff);
+    ASSERT_TRUE(wdiff < 1e-6f, "f32 unmerge restores the weights (float rounding only)");
+
+    // Q8_0: merged error stays within half a quantisation step per weight
+    static oo_lora_spill_t spill[8192];
+    oo_lora_set_spill(&st, spill, sizeof(spill));
+    ASSERT_EQ(oo_lora_merge(&st, &t.mq), 0, "Q8_0 merge ok");
+    printf("  saturated codes: %u spilled, %u lost\n", st.spill_n, st.q8_clipped);
+    ASSERT_TRUE(st.spill_n > 0 && st.q8_clipped == 0, "saturated codes all fit in the spill");
+    int within = 1, changed = 0;
+    float worst_q = 0.0f;
+    for (int l = 0; l < T_LAYERS; l++)
+        for (int p = 0; p < OO_LORA_NPROJ; p++) {
+            oo_lora_matmul_q8_0(got, xs[l][p], q8_layer(&t, p, l), (UINT32)t_in[p], (UINT32)t_out[p], NULL);
+            for (int j = 0; j < t_out[p]; j++) {
+                float e = fabsf(got[j] - ref_q[l][p][j]);
+                if (e > worst_q) worst_q = e;
+                if (e > bound[l][p][j] + 1e-4f) within = 0;
+            }
+        }
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        if (memcmp(t.q8[p], q_orig[p], (size_t)t.mq.w[p].layer_bytes * T_LAYERS) != 0) changed = 1;
+    printf("  max |merged q8 - ref|: %.2e (bounded by 0.5·d·|x| per row)\n", worst_q);
+    ASSERT_TRUE(changed, "Q8_0 codes actually changed");
+    ASSERT_TRUE(within, "merged Q8_0 within half-step quantisation bound of reference");
+
+    ASSERT_EQ(oo_lora_unmerge(&st, &t.mq), 0, "Q8_0 unmerge ok");
+    int exact = 1;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        if (memcmp(t.q8[p], q_orig[p], (size_t)t.mq.w[p].layer_bytes * T_LAYERS) != 0) exact = 0;
+    ASSERT_TRUE(exact, "Q8_0 unmerge restores the original bytes exactly");
+
+    // Without a spill the merge still works; unmerge is off only where codes saturated
+    oo_lora_set_spill(&st, NULL, 0);
+    oo_lora_merge(&st, &t.mq);
+    UINT32 lost = st.q8_clipped;
+    oo_lora_unmerge(&st, &t.mq);
+    int off = 0;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        for (size_t i = 0; i < (size_t)t.mq.w[p].layer_bytes * T_LAYERS; i++)
+            if (t.q8[p][i] != q_orig[p][i]) off++;
+    ASSERT_TRUE(lost > 0 && off > 0 && (UINT32)off <= lost, "spill-less unmerge differs only at saturated codes");
+
+    // Geometry mismatch is refused before touching anything
+    oo_lora_model_t bad = t.mf;
+    bad.w[OO_LORA_W2].in_dim = T_DIM;
+    ASSERT_TRUE(oo_lora_merge(&st, &bad) < 0 && st.merged == 0, "mismatched model refused");
+
+    for (int p = 0; p < OO_LORA_NPROJ; p++) { free(f_orig[p]); free(q_orig[p]); }
+    free(mem);
+    toy_close(&t);
+}
+
+// ============================================================
+// Test 4: bank hot-swap
+// ============================================================
+static void test_bank(void) {
+    printf("\n[Test 4] bank hot-swap\n");
+    ToyModel t;
+    toy_open(&t);
+    static oo_lora_state_t s1, s2;
+    void *m1 = adapter_open(&s1, 0.5f);
+    void *m2 = adapter_open(&s2, 0.5f);
+    static oo_lora_spill_t sp1[8192], sp2[8192];
+    oo_lora_set_spill(&s1, sp1, sizeof(sp1));
+    oo_lora_set_spill(&s2, sp2, sizeof(sp2));
+
+    uint8_t *orig[OO_LORA_NPROJ], *only2[OO_LORA_NPROJ];
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t qb = (size_t)t.mq.w[p].layer_bytes * T_LAYERS;
+        orig[p] = malloc(qb); memcpy(orig[p], t.q8[p], qb);
+    }
+    oo_lora_merge(&s2, &t.mq);
+    for (int p = 0; p < OO_LORA_NPROJ; p++) {
+        size_t qb = (size_t)t.mq.w[p].layer_bytes * T_LAYERS;
+        only2[p] = malloc(qb); memcpy(only2[p], t.q8[p], qb);
+    }
+    oo_lora_unmerge(&s2, &t.mq);
+
+    oo_lora_bank_t bk = { { 0 }, 0, -1 };
+    ASSERT_TRUE(oo_lora_bank_active(&bk) == NULL, "empty bank has no active adapter");
+    ASSERT_EQ(oo_lora_bank_add(&bk, &s1), 0, "adapter 1 -> slot 0");
+    ASSERT_EQ(oo_lora_bank_add(&bk, &s2), 1, "adapter 2 -> slot 1");
+    ASSERT_EQ(oo_lora_bank_add(&bk, &s2), 1, "re-adding returns the same slot");
+
+    ASSERT_EQ(oo_lora_bank_select(&bk, 0, &t.mq, 1), 0, "select slot 0 merged");
+    ASSERT_TRUE(oo_lora_bank_active(&bk) == &s1 && s1.merged, "slot 0 active + merged");
+    ASSERT_EQ(oo_lora_bank_select(&bk, 1, &t.mq, 1), 0, "hot-swap to slot 1 merged");
+    int same = 1;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        if (memcmp(t.q8[p], only2[p], (size_t)t.mq.w[p].layer_bytes * T_LAYERS) != 0) same = 0;
+    ASSERT_TRUE(!s1.merged && s2.merged && same, "weights == base + adapter 2 only");
+
+    ASSERT_EQ(oo_lora_bank_select(&bk, 0, &t.mq, 0), 0, "swap to slot 0 fused");
+    ASSERT_TRUE(!s1.merged && !s2.merged, "nothing merged in fused mode");
+    ASSERT_EQ(oo_lora_bank_select(&bk, -1, &t.mq, 0), 0, "select base model");
+    same = 1;
+    for (int p = 0; p < OO_LORA_NPROJ; p++)
+        if (memcmp(t.q8[p], orig[p], (size_t)t.mq.w[p].layer_bytes * T_LAYERS) != 0) same = 0;
+    ASSERT_TRUE(same && oo_lora_bank_active(&bk) == NULL, "base weights restored byte-exact");
+    ASSERT_TRUE(oo_lora_bank_select(&bk, 2, &t.mq, 0) < 0, "out-of-range slot refused");
+
+    for (int p = 0; p < OO_LORA_NPROJ; p++) { free(orig[p]); free(only2[p]); }
+    free(m1); free(m2);
+    toy_close(&t);
+}
+
+// ============================================================
+// Test 5: persist / load
+// ============================================================
+static void test_persist(void) {
+    printf("\n[Test 5] persist / load\n");
+    static oo_lora_state_t a, b;
+    void *ma = adapter_open(&a, 0.3f);
+    a.dirty = 1;
+    a.step_count = 42;
+    ASSERT_EQ(oo_lora_persist(&a, NULL), 0, "persist ok");
+
+    UINT64 bytes = oo_lora_bytes(T_LAYERS, T_DIM, T_KV, T_HID, LORA_MAX_RANK);
+    void *mb = malloc((size_t)bytes);
+    oo_lora_init(&b, T_LAYERS, T_DIM, T_KV, T_HID, LORA_MAX_RANK, mb, bytes);
+    ASSERT_EQ(oo_lora_load(&b, NULL), 0, "load ok");
+    ASSERT_TRUE(memcmp(ma, mb, (size_t)bytes) == 0 && b.step_count == 42, "arena round-trips");
+
+    static oo_lora_state_t c;
+    UINT64 cb = oo_lora_bytes(T_LAYERS, T_DIM, T_KV, T_HID, 4);
+    void *mc = malloc((size_t)cb);
+    oo_lora_init(&c, T_LAYERS, T_DIM, T_KV, T_HID, 4, mc, cb);
+    ASSERT_TRUE(oo_lora_load(&c, NULL) < 0, "different geometry refused");
+    free(ma); free(mb); free(mc);
+}
+
+// ============================================================
+// Test 6: fused vs separate pass
+// ============================================================
+#define B_N    1024
+#define B_D    2816
+#define B_REPS 40
+
+static void bench(void) {
+    printf("\n[Bench] %dx%d projection, rank %d\n", B_D, B_N, LORA_MAX_RANK);
+    static oo_lora_state_t st;
+    UINT64 bytes = oo_lora_bytes(1, B_N, B_N, B_D, LORA_MAX_RANK);
+    void *mem = malloc((size_t)bytes);
+    oo_lora_init(&st, 1, B_N, B_N, B_D, LORA_MAX_RANK, mem, bytes);
+    oo_lora_adapter_t *a = &st.layers[0][OO_LORA_W1];
+    for (UINT32 i = 0; i < a->out_dim * a->rank; i++) a->B[i] = 0.1f * frand();
+
+    float *w = malloc((size_t)B_N * B_D * sizeof(float));
+    uint8_t *q = malloc((size_t)B_D * (B_N / 32) * 34);
+    float *x = malloc(B_N * sizeof(float)), *y = malloc(B_D * sizeof(float));
+    for (size_t i = 0; i < (size_t)B_N * B_D; i++) w[i] = 0.1f * frand();
+    for (int i = 0; i < B_N; i++) x[i] = frand();
+    quantize_q8(w, q, B_D, B_N);
+
+    for (int avx2 = 0; avx2 <= (__builtin_cpu_supports("avx2") ? 1 : 0); avx2++) {
+        oo_lora_set_cpu(avx2);
+        double t0 = now_ns();
+        for (int r = 0; r < B_REPS; r++) oo_lora_matmul_q8_0(y, x, q, B_N, B_D, NULL);
+        double t1 = now_ns();
+        for (int r = 0; r < B_REPS; r++) {
+            oo_lora_matmul_q8_0(y, x, q, B_N, B_D, NULL);
+            oo_lora_forward(a, x, y, B_N);
+        }
+        double t2 = now_ns();
+        for (int r = 0; r < B_REPS; r++) oo_lora_matmul_q8_0(y, x, q, B_N, B_D, a);
+        double t3 = now_ns();
+        printf("  q8 %s: base %.0f us  base+pass %.0f us  fused %.0f us\n", avx2 ? "avx2" : "sse2",
+               (t1 - t0) / B_REPS / 1e3, (t2 - t1) / B_REPS / 1e3, (t3 - t2) / B_REPS / 1e3);
+    }
+    free(w); free(q); free(x); free(y); free(mem);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OO LoRA Fused/Merge — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_geometry();
+    test_fused(0);
+    if (__builtin_cpu_supports("avx2")) test_fused(1);
+    test_merge();
+    test_bank();
+    test_persist();
+    bench();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All LoRA tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
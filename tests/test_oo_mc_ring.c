@@ -0,0 +1,341 @@
+// test_oo_mc_ring.c — pthread host harness for the oo-multicore work queue
+//
+// Tests:
+//   ring basics: FIFO order, full at OO_MC_RING_SLOTS, u32 index wrap
+//   SPSC: one producer thread, one consumer thread, strict order
+//   steal: one producer, several CAS consumers, every item exactly once
+//   work queue: oo_mc_queue.c on pthreads "APs" — submit/wait_idle,
+//     stealing by workers that receive nothing, nested submit, sleep/wake
+//   dispatch latency (round trip) and flood throughput
+//
+// The rings and the queue logic are the same files the UEFI build uses;
+// pthreads stand in for APs (no mwait in ring 3, so the pause fallback).
+//
+// Build (Linux, x86-64 host, no UEFI):
+//   gcc -std=gnu11 -O2 -Wall -Wextra -pthread -I../oo-multicore/core
+//       test_oo_mc_ring.c ../oo-multicore/core/oo_mc_queue.c -o test_oo_mc_ring
+//
+// Run:
+//   ./test_oo_mc_ring
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "oo_multicore.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ == b_) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %lld, expected %lld)\n", msg, a_, b_); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void nop_fn(void *arg, int core) { (void)arg; (void)core; }
+
+// ============================================================
+// Test 1: ring basics
+// ============================================================
+static void test_basics(void) {
+    printf("\n[Test 1] ring basics\n");
+    static OoMcRing r;
+    OoMcWork w = { nop_fn, NULL, 0 }, out;
+    oo_mc_ring_init(&r);
+
+    ASSERT_EQ(oo_mc_ring_pop(&r, &out), 0, "empty ring pops nothing");
+    int pushed = 0;
+    for (int i = 0; i < OO_MC_RING_SLOTS + 5; i++) {
+        w.arg = (void *)(uintptr_t)i;
+        pushed += oo_mc_ring_push(&r, &w);
+    }
+    ASSERT_EQ(pushed, OO_MC_RING_SLOTS, "ring accepts exactly OO_MC_RING_SLOTS");
+    ASSERT_EQ(oo_mc_ring_count(&r), OO_MC_RING_SLOTS, "count = slots when full");
+
+    int in_order = 1;
+    for (int i = 0; i < OO_MC_RING_SLOTS; i++)
+        if (!oo_mc_ring_pop(&r, &out) || out.arg != (void *)(uintptr_t)i) in_order = 0;
+    ASSERT_TRUE(in_order, "FIFO order");
+
+    // indices straddling 2^32
+    r.head = r.tail = r.tail_cache = 0xFFFFFFF0u;
+    int ok = 1;
+    for (int i = 0; i < 100; i++) {
+        w.arg = (void *)(uintptr_t)i;
+        if (!oo_mc_ring_push(&r, &w)) ok = 0;
+        if (!oo_mc_ring_pop(&r, &out) || out.arg != w.arg) ok = 0;
+    }
+    ASSERT_TRUE(ok && r.head == 0x54u, "u32 index wrap-around");
+}
+
+// ============================================================
+// Test 2: SPSC across threads
+// ============================================================
+#define SPSC_ITEMS 2000000u
+
+static OoMcRing g_spsc;
+
+static void *spsc_producer(void *p) {
+    (void)p;
+    OoMcWork w = { nop_fn, NULL, 0 };
+    for (uint32_t i = 1; i <= SPSC_ITEMS; i++) {
+        w.arg = (void *)(uintptr_t)i;
+        while (!oo_mc_ring_push(&g_spsc, &w)) sched_yield();
+    }
+    return NULL;
+}
+
+static void test_spsc(void) {
+    printf("\n[Test 2] SPSC, 2 threads, %u items\n", SPSC_ITEMS);
+    oo_mc_ring_init(&g_spsc);
+    pthread_t th;
+    double t0 = now_ns();
+    pthread_create(&th, NULL, spsc_producer, NULL);
+    uint32_t expect = 1, bad = 0;
+    OoMcWork out;
+    while (expect <= SPSC_ITEMS) {
+        if (!oo_mc_ring_pop(&g_spsc, &out)) { sched_yield(); continue; }
+        if ((uint32_t)(uintptr_t)out.arg != expect) bad++;
+        expect++;
+    }
+    pthread_join(th, NULL);
+    double dt = now_ns() - t0;
+    ASSERT_EQ(bad, 0, "consumer sees every item in order");
+    printf("    %.1f ns/item, %.1f M items/s\n", dt / SPSC_ITEMS, SPSC_ITEMS / dt * 1e3);
+}
+
+// ============================================================
+// Test 3: steal — one producer, several CAS consumers
+// ============================================================
+#define STEAL_ITEMS    400000u
+#define STEAL_THREADS  4
+
+static OoMcRing g_steal;
+static uint8_t  g_seen[STEAL_ITEMS];
+static volatile int g_steal_done;
+static uint32_t g_taken[STEAL_THREADS];
+
+static void *steal_consumer(void *p) {
+    int me = (int)(uintptr_t)p;
+    OoMcWork out;
+    for (;;) {
+        if (oo_mc_ring_pop(&g_steal, &out)) {
+            __atomic_fetch_add(&g_seen[(uintptr_t)out.arg], 1, __ATOMIC_RELAXED);
+            g_taken[me]++;
+        } else if (g_steal_done) {
+            if (!oo_mc_ring_count(&g_steal)) break;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_steal(void) {
+    printf("\n[Test 3] steal, 1 producer / %d consumers\n", STEAL_THREADS);
+    oo_mc_ring_init(&g_steal);
+    pthread_t th[STEAL_THREADS];
+    for (int i = 0; i < STEAL_THREADS; i++)
+        pthread_create(&th[i], NULL, steal_consumer, (void *)(uintptr_t)i);
+    OoMcWork w = { nop_fn, NULL, 0 };
+    for (uint32_t i = 0; i < STEAL_ITEMS; i++) {
+        w.arg = (void *)(uintptr_t)i;
+        while (!oo_mc_ring_push(&g_steal, &w)) sched_yield();
+    }
+    g_steal_done = 1;
+    for (int i = 0; i < STEAL_THREADS; i++) pthread_join(th[i], NULL);
+
+    uint32_t once = 0, total = 0, busy = 0;
+    for (uint32_t i = 0; i < STEAL_ITEMS; i++) once += (g_seen[i] == 1);
+    for (int i = 0; i < STEAL_THREADS; i++) { total += g_taken[i]; busy += (g_taken[i] > 0); }
+    ASSERT_EQ(once, STEAL_ITEMS, "every item claimed exactly once");
+    ASSERT_EQ(total, STEAL_ITEMS, "no duplicate claims");
+    printf("    consumers that got work: %u/%d\n", busy, STEAL_THREADS);
+}
+
+// ============================================================
+// Test 4: work queue on pthread "APs"
+// ============================================================
+#define WQ_CORES   6
+#define WQ_ITEMS   200000u
+
+static OoMulticoreCtx g_mc;
+static uint8_t  g_hits[WQ_ITEMS];
+static volatile uint32_t g_nested;
+
+typedef struct { pthread_t th; int idx; } ApThread;
+static ApThread g_aps[WQ_CORES];
+
+static void *ap_main(void *p) {
+    ApThread *ap = (ApThread *)p;
+    oo_mc_worker_loop(&g_mc, ap->idx);
+    return NULL;
+}
+
+static void hit_fn(void *arg, int core) {
+    (void)core;
+    __atomic_fetch_add(&g_hits[(uintptr_t)arg], 1, __ATOMIC_RELAXED);
+}
+
+static void nested_leaf(void *arg, int core) {
+    (void)arg; (void)core;
+    __atomic_fetch_add(&g_nested, 1, __ATOMIC_RELAXED);
+}
+
+// Runs on a worker: fans out two more items from that core's own rings.
+static void nested_root(void *arg, int core) {
+    (void)arg;
+    oo_mc_submit_from(&g_mc, core, nested_leaf, NULL);
+    oo_mc_submit_from(&g_mc, core, nested_leaf, NULL);
+}
+
+static void mc_setup(void) {
+    memset(&g_mc, 0, sizeof(g_mc));
+    g_mc.enabled = 1;
+    g_mc.core_count = WQ_CORES;
+    g_mc.bsp_idx = 0;
+    g_mc.mwait_ok = 0;
+    g_mc.cores[0].role = OO_CORE_ROLE_BSP;
+    for (int i = 1; i < WQ_CORES; i++) {
+        g_mc.cores[i].role = OO_CORE_ROLE_WORKER;
+        g_mc.mc_workers[g_mc.mc_worker_count++] = i;
+        g_aps[i].idx = i;
+        pthread_create(&g_aps[i].th, NULL, ap_main, &g_aps[i]);
+    }
+}
+
+static void mc_teardown(void) {
+    oo_mc_stop_workers(&g_mc);
+    for (int i = 1; i < WQ_CORES; i++) pthread_join(g_aps[i].th, NULL);
+}
+
+static uint64_t sum_completed(void) {
+    uint64_t n = 0;
+    for (int i = 0; i < WQ_CORES; i++) n += g_mc.mc_core[i].completed;
+    return n;
+}
+
+static void test_queue(void) {
+    printf("\n[Test 4] work queue, BSP + %d worker threads\n", WQ_CORES - 1);
+    mc_setup();
+
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < WQ_ITEMS; i++) oo_mc_submit(&g_mc, hit_fn, (void *)(uintptr_t)i);
+    oo_mc_wait_idle(&g_mc);
+    double dt = now_ns() - t0;
+
+    uint32_t once = 0;
+    for (uint32_t i = 0; i < WQ_ITEMS; i++) once += (g_hits[i] == 1);
+    ASSERT_EQ(once, WQ_ITEMS, "every submitted item ran exactly once");
+    ASSERT_EQ(sum_completed(), g_mc.mc_submitted, "completed == submitted after wait_idle");
+    int spread = 0;
+    for (int i = 1; i < WQ_CORES; i++) spread += (g_mc.mc_core[i].completed > 0);
+    ASSERT_TRUE(spread >= 2, "work spread over several workers");
+    printf("    flood: %.1f ns/item (inline on BSP: %u)\n", dt / WQ_ITEMS, g_mc.mc_inline);
+
+    // Only core 1 receives pushes; the other workers must steal.
+    uint64_t stolen0 = 0;
+    for (int i = 0; i < WQ_CORES; i++) stolen0 += g_mc.mc_core[i].stolen;
+    memset(g_hits, 0, sizeof(g_hits));
+    g_mc.mc_worker_count = 1;
+    for (uint32_t i = 0; i < 20000; i++) oo_mc_submit(&g_mc, hit_fn, (void *)(uintptr_t)i);
+    oo_mc_wait_idle(&g_mc);
+    g_mc.mc_worker_count = WQ_CORES - 1;
+    uint64_t stolen1 = 0;
+    for (int i = 0; i < WQ_CORES; i++) stolen1 += g_mc.mc_core[i].stolen;
+    once = 0;
+    for (uint32_t i = 0; i < 20000; i++) once += (g_hits[i] == 1);
+    ASSERT_EQ(once, 20000, "single-target burst: every item ran once");
+    ASSERT_TRUE(stolen1 > stolen0, "idle cores steal from a busy core's rings");
+
+    // Nested submission from worker cores (rings[worker][*])
+    g_nested = 0;
+    for (int i = 0; i < 1000; i++) oo_mc_submit(&g_mc, nested_root, NULL);
+    oo_mc_wait_idle(&g_mc);
+    ASSERT_EQ(g_nested, 2000, "items submitted from workers all run");
+
+    // Sleep / wake: let workers go idle, then one item must still get through.
+    struct timespec nap = { 0, 50 * 1000 * 1000 };
+    nanosleep(&nap, NULL);
+    uint64_t sleeps = 0;
+    for (int i = 1; i < WQ_CORES; i++) sleeps += g_mc.mc_core[i].sleeps;
+    ASSERT_TRUE(sleeps > 0, "idle workers back off into the doorbell wait");
+    uint64_t c0 = sum_completed();
+    oo_mc_submit(&g_mc, hit_fn, (void *)(uintptr_t)0);
+    double deadline = now_ns() + 2e9;
+    while (sum_completed() == c0 && now_ns() < deadline) sched_yield();
+    ASSERT_TRUE(sum_completed() > c0, "item submitted to sleeping workers completes");
+
+    // Round-trip dispatch latency (BSP spins, no helping)
+    double rt_sum = 0, rt_min = 1e18;
+    for (int r = 0; r < 200; r++) {
+        uint64_t before = sum_completed();
+        double a = now_ns();
+        oo_mc_submit(&g_mc, nop_fn, NULL);
+        while (sum_completed() == before) sched_yield();
+        double d = now_ns() - a;
+        rt_sum += d;
+        if (d < rt_min) rt_min = d;
+    }
+    printf("    round trip: min %.0f ns, avg %.0f ns\n", rt_min, rt_sum / 200);
+
+    mc_teardown();
+    ASSERT_EQ(g_mc.mc_worker_count, 0, "stop_workers: every worker left its loop");
+    oo_mc_submit(&g_mc, nop_fn, NULL);
+    ASSERT_TRUE(g_mc.mc_inline > 0, "no workers → submit runs inline");
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OO Multicore Rings — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_basics();
+    test_spsc();
+    test_steal();
+    test_queue();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All multicore ring tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
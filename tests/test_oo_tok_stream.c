@@ -0,0 +1,407 @@
+// test_oo_tok_stream.c — Host-mode harness for the token output ring
+//
+// Tests:
+//   decoder: same UCS-2 as uefi_print_utf8_decode on random and edge-case
+//   bytes; sequences split across writes and flushes are carried over
+//   fan-out: UTF-8 sinks see the exact byte stream across ring wrap-around,
+//   UCS-2 chunks are bounded and NUL-terminated, disabled sinks are skipped
+//   cadence: token / byte / newline / TSC triggers, poll, full-ring flush
+//   bench: console with a fixed per-call cost, per-token vs buffered writes
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=c11 -O2 -Wall -Wextra -I../engine/llama2
+//       test_oo_tok_stream.c ../engine/llama2/oo_tok_stream.c -o test_oo_tok_stream
+//
+// Run:
+//   ./test_oo_tok_stream
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "oo_tok_stream.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+// ============================================================
+// Reference: uefi_print_utf8_decode (soma_loader.c), output captured
+// ============================================================
+
+static int ref_decode(const unsigned char *p, int len, uint16_t *out) {
+    int o = 0, i = 0;
+    while (i < len) {
+        uint32_t cp = 0xFFFD;
+        unsigned char b0 = p[i];
+        if (b0 < 0x80) {
+            cp = b0; i += 1;
+        } else if ((b0 & 0xE0) == 0xC0) {
+            if (i + 1 < len && (p[i + 1] & 0xC0) == 0x80) {
+                cp = ((uint32_t)(b0 & 0x1F) << 6) | (uint32_t)(p[i + 1] & 0x3F);
+                if (cp < 0x80) cp = 0xFFFD;
+                i += 2;
+            } else i += 1;
+        } else if ((b0 & 0xF0) == 0xE0) {
+            if (i + 2 < len && (p[i + 1] & 0xC0) == 0x80 && (p[i + 2] & 0xC0) == 0x80) {
+                cp = ((uint32_t)(b0 & 0x0F) << 12) | ((uint32_t)(p[i + 1] & 0x3F) << 6) | (uint32_t)(p[i + 2] & 0x3F);
+                if (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)) cp = 0xFFFD;
+                i += 3;
+            } else i += 1;
+        } else if ((b0 & 0xF8) == 0xF0) {
+            if (i + 3 < len && (p[i + 1] & 0xC0) == 0x80 && (p[i + 2] & 0xC0) == 0x80 && (p[i + 3] & 0xC0) == 0x80) {
+                cp = ((uint32_t)(b0 & 0x07) << 18) | ((uint32_t)(p[i + 1] & 0x3F) << 12) |
+                     ((uint32_t)(p[i + 2] & 0x3F) << 6) | (uint32_t)(p[i + 3] & 0x3F);
+                if (cp < 0x10000 || cp > 0x10FFFF) cp = 0xFFFD;
+                i += 4;
+            } else i += 1;
+        } else {
+            i += 1;
+        }
+        if (cp <= 0xFFFF) out[o++] = (uint16_t)cp;
+        else {
+            cp -= 0x10000;
+            out[o++] = (uint16_t)(0xD800 + (cp >> 10));
+            out[o++] = (uint16_t)(0xDC00 + (cp & 0x3FF));
+        }
+    }
+    return o;
+}
+
+// ============================================================
+// Capturing sinks
+// ============================================================
+
+#define CAP_MAX (1u << 20)
+
+typedef struct {
+    uint8_t  *u8;
+    uint16_t *u16;
+    uint32_t  n;
+    uint32_t  calls;
+    uint32_t  max_call;
+    int       bad_nul;
+} Capture;
+
+static void cap_reset(Capture *c) {
+    c->n = 0; c->calls = 0; c->max_call = 0; c->bad_nul = 0;
+}
+
+static void cap_utf8(void *ctx, const uint8_t *b, uint32_t n) {
+    Capture *c = (Capture *)ctx;
+    if (c->n + n <= CAP_MAX) memcpy(c->u8 + c->n, b, n);
+    c->n += n;
+    c->calls++;
+    if (n > c->max_call) c->max_call = n;
+}
+
+static void cap_ucs2(void *ctx, const uint16_t *s, uint32_t n) {
+    Capture *c = (Capture *)ctx;
+    if (s[n] != 0) c->bad_nul = 1;
+    if (c->n + n <= CAP_MAX) memcpy(c->u16 + c->n, s, n * sizeof(uint16_t));
+    c->n += n;
+    c->calls++;
+    if (n > c->max_call) c->max_call = n;
+}
+
+static OtsStream g_s;     // 16 KB ring: keep it off the stack
+static Capture   g_c8, g_c16;
+
+static void stream_setup(void) {
+    ots_init(&g_s);
+    cap_reset(&g_c8);
+    cap_reset(&g_c16);
+    ots_add_utf8_sink(&g_s, cap_utf8, &g_c8);
+    ots_add_ucs2_sink(&g_s, cap_ucs2, &g_c16);
+}
+
+// ============================================================
+// Decoder
+// ============================================================
+
+static void test_decoder(void) {
+    printf("\n[TEST] UTF-8 → UCS-2 decoder\n");
+
+    static uint8_t  src[4096];
+    static uint16_t ref[8192], got[8192];
+    int mismatches = 0;
+    // Random bytes biased towards multi-byte leads and continuations
+    for (int iter = 0; iter < 2000; iter++) {
+        int n = 1 + (int)(rnd() % 64);
+        for (int i = 0; i < n; i++) {
+            uint32_t r = rnd();
+            switch (r % 6) {
+            case 0: src[i] = (uint8_t)(0x20 + (r >> 8) % 0x5F); break;
+            case 1: src[i] = (uint8_t)(0x80 | ((r >> 8) & 0x3F)); break;
+            case 2: src[i] = (uint8_t)(0xC0 | ((r >> 8) & 0x1F)); break;
+            case 3: src[i] = (uint8_t)(0xE0 | ((r >> 8) & 0x0F)); break;
+            case 4: src[i] = (uint8_t)(0xF0 | ((r >> 8) & 0x0F)); break;
+            default: src[i] = (uint8_t)(r >> 8); break;
+            }
+        }
+        int rn = ref_decode(src, n, ref);
+        uint32_t used = 0;
+        uint32_t gn = ots_utf8_to_ucs2(src, (uint32_t)n, 1, got, sizeof(got) / 2, &used);
+        if ((int)gn != rn || used != (uint32_t)n || memcmp(ref, got, gn * 2) != 0) mismatches++;
+    }
+    ASSERT_EQ(mismatches, 0, "final decode matches uefi_print_utf8_decode on 2000 random strings");
+
+    // Edge cases: overlong, surrogate, > U+10FFFF, truncated, stray continuation
+    static const uint8_t edge[] = {
+        0xC0, 0x80,  0xE0, 0x80, 0x80,  0xED, 0xA0, 0x80,  0xF4, 0x90, 0x80, 0x80,
+        0xE2, 0x82,  'x',  0x80,  0xF0, 0x9F, 0x98, 0x80,  0xC3, 0xA9,  0xFF,
+    };
+    int rn = ref_decode(edge, (int)sizeof(edge), ref);
+    uint32_t used = 0;
+    uint32_t gn = ots_utf8_to_ucs2(edge, sizeof(edge), 1, got, 64, &used);
+    ASSERT_TRUE((int)gn == rn && memcmp(ref, got, gn * 2) == 0, "edge cases match the reference");
+    ASSERT_TRUE(got[gn - 2] == 0x00E9 && got[gn - 1] == 0xFFFD, "é then U+FFFD for 0xFF");
+
+    // Non-final: an incomplete tail is left unconsumed
+    static const uint8_t emoji[] = { 'a', 0xF0, 0x9F, 0x98 };
+    gn = ots_utf8_to_ucs2(emoji, 4, 0, got, 64, &used);
+    ASSERT_TRUE(gn == 1 && used == 1, "split 4-byte sequence waits for its last byte");
+    gn = ots_utf8_to_ucs2(emoji, 4, 1, got, 64, &used);
+    ASSERT_TRUE(gn == 4 && used == 4 && got[1] == 0xFFFD, "final: truncated sequence → U+FFFD per byte");
+}
+
+static void test_split(void) {
+    printf("\n[TEST] Sequences split across writes and flushes\n");
+
+    // "héllo 世界 😀\n" written one byte per token, flushed after every byte
+    static const uint8_t text[] = {
+        'h', 0xC3, 0xA9, 'l', 'l', 'o', ' ', 0xE4, 0xB8, 0x96, 0xE7, 0x95, 0x8C, ' ',
+        0xF0, 0x9F, 0x98, 0x80, '\n',
+    };
+    uint16_t ref[64];
+    int rn = ref_decode(text, (int)sizeof(text), ref);
+
+    stream_setup();
+    ots_set_cadence(&g_s, 1, 0, 0, 0);
+    for (uint32_t i = 0; i < sizeof(text); i++) ots_write(&g_s, &text[i], 1, 0);
+    ots_finish(&g_s, 0);
+    ASSERT_TRUE((int)g_c16.n == rn && memcmp(g_c16.u16, ref, (size_t)rn * 2) == 0,
+                "byte-at-a-time flushes decode like one whole string");
+    int fffd = 0;
+    for (uint32_t i = 0; i < g_c16.n; i++) fffd += (g_c16.u16[i] == 0xFFFD);
+    ASSERT_EQ(fffd, 0, "no replacement characters from split sequences");
+    ASSERT_TRUE(g_c8.n == sizeof(text) && memcmp(g_c8.u8, text, sizeof(text)) == 0,
+                "UTF-8 sink receives the raw bytes");
+
+    // A dangling lead byte is held by flush and replaced by finish
+    stream_setup();
+    static const uint8_t dangling[] = { 'o', 'k', 0xE2, 0x82 };
+    ots_write(&g_s, dangling, 4, 0);
+    ots_flush(&g_s, 0);
+    ASSERT_EQ(g_c16.n, 2, "flush holds an incomplete trailing sequence");
+    ots_finish(&g_s, 0);
+    ASSERT_TRUE(g_c16.n == 4 && g_c16.u16[2] == 0xFFFD && g_c16.u16[3] == 0xFFFD,
+                "finish emits it as U+FFFD");
+}
+
+// ============================================================
+// Fan-out
+// ============================================================
+
+static void test_fanout(void) {
+    printf("\n[TEST] Fan-out and ring wrap-around\n");
+
+    static uint8_t in[96 * 1024];
+    static uint16_t ref[96 * 1024];
+    uint32_t n = 0;
+    stream_setup();
+    ots_set_cadence(&g_s, 1000, 0, 0, 0);   // odd size: spans cross the wrap point
+    while (n < sizeof(in) - 16) {
+        // Token-sized pieces of mixed ASCII / 2- / 3- / 4-byte text
+        uint8_t piece[16];
+        int pn = 0, kind = (int)(rnd() % 4);
+        if (kind == 0) { int k = 1 + (int)(rnd() % 6); while (k--) piece[pn++] = (uint8_t)('a' + rnd() % 26); }
+        else if (kind == 1) { piece[pn++] = 0xC3; piece[pn++] = 0xA0 + (uint8_t)(rnd() % 16); }
+        else if (kind == 2) { piece[pn++] = 0xE4; piece[pn++] = 0xB8; piece[pn++] = 0x80 + (uint8_t)(rnd() % 64); }
+        else { piece[pn++] = 0xF0; piece[pn++] = 0x9F; piece[pn++] = 0x98; piece[pn++] = 0x80 + (uint8_t)(rnd() % 64); }
+        memcpy(in + n, piece, (size_t)pn);
+        ots_write(&g_s, piece, (uint32_t)pn, 0);
+        n += (uint32_t)pn;
+    }
+    ots_finish(&g_s, 0);
+    int rn = ref_decode(in, (int)n, ref);
+
+    ASSERT_TRUE(g_c8.n == n && memcmp(g_c8.u8, in, n) == 0, "UTF-8 sink: exact bytes over 96 KB (6x the ring)");
+    ASSERT_TRUE((int)g_c16.n == rn && memcmp(g_c16.u16, ref, (size_t)rn * 2) == 0, "UCS-2 sink: same text as one decode");
+    ASSERT_TRUE(g_c16.max_call <= OTS_UCS2_CHUNK, "UCS-2 chunks bounded by OTS_UCS2_CHUNK");
+    ASSERT_EQ(g_c16.bad_nul, 0, "UCS-2 chunks NUL-terminated");
+    ASSERT_EQ((int)g_s.bytes_in, (int)n, "bytes_in counts every byte");
+    ASSERT_EQ(g_s.full_flushes, 0, "byte trigger keeps the ring from filling");
+
+    // Disabled sinks are skipped, fifth sink rejected
+    stream_setup();
+    Capture extra = g_c8;
+    extra.n = 0;
+    extra.u8 = (uint8_t *)malloc(CAP_MAX);
+    int idx = ots_add_utf8_sink(&g_s, cap_utf8, &extra);
+    ots_sink_enable(&g_s, 1, 0);
+    ots_write(&g_s, "abc\n", 4, 0);
+    ASSERT_TRUE(g_c8.n == 4 && extra.n == 4 && g_c16.n == 0, "disabled UCS-2 sink skipped, UTF-8 sinks both fed");
+    ots_add_utf8_sink(&g_s, cap_utf8, &extra);
+    ASSERT_EQ(ots_add_utf8_sink(&g_s, cap_utf8, &extra), -1, "sink table full at OTS_MAX_SINKS");
+    ASSERT_EQ(idx, 2, "sink indices in registration order");
+    free(extra.u8);
+}
+
+// ============================================================
+// Cadence
+// ============================================================
+
+static void test_cadence(void) {
+    printf("\n[TEST] Flush cadence\n");
+
+    stream_setup();
+    ots_set_cadence(&g_s, 0, 4, 0, 0);
+    int flushed = 0;
+    for (int i = 0; i < 7; i++) flushed += ots_write(&g_s, "ab", 2, 0);
+    ASSERT_TRUE(flushed == 1 && g_c8.calls == 1 && ots_pending(&g_s) == 6, "token trigger: one flush per 4 tokens");
+
+    stream_setup();
+    ots_set_cadence(&g_s, 10, 0, 0, 0);
+    for (int i = 0; i < 4; i++) ots_write(&g_s, "abc", 3, 0);
+    ASSERT_TRUE(g_c8.calls == 1 && g_c8.n == 12 && ots_pending(&g_s) == 0, "byte trigger at 10 bytes");
+
+    stream_setup();
+    ots_set_cadence(&g_s, 0, 0, 0, 1);
+    ots_write(&g_s, "one", 3, 0);
+    ASSERT_EQ(g_c8.calls, 0, "no newline: nothing written");
+    ots_write(&g_s, " two\n", 5, 0);
+    ASSERT_TRUE(g_c8.calls == 1 && g_c8.n == 8, "newline flushes the line");
+
+    stream_setup();
+    ots_set_cadence(&g_s, 0, 0, 1000, 0);
+    ots_write(&g_s, "a", 1, 5000);
+    ots_write(&g_s, "b", 1, 5500);
+    ASSERT_EQ(g_c8.calls, 0, "within the TSC window: held");
+    ots_write(&g_s, "c", 1, 6000);
+    ASSERT_TRUE(g_c8.calls == 1 && g_c8.n == 3, "TSC trigger measured from the first pending byte");
+    ots_write(&g_s, "d", 1, 9000);
+    ASSERT_EQ(ots_poll(&g_s, 9500), 0, "poll before the window expires: no flush");
+    ASSERT_EQ(ots_poll(&g_s, 10000), 1, "poll after it: flush");
+    ASSERT_EQ(ots_poll(&g_s, 20000), 0, "poll with nothing pending: no flush");
+
+    stream_setup();
+    ots_set_cadence(&g_s, 0, 0, 0, 0);
+    static uint8_t big[OTS_RING_BYTES + 100];
+    memset(big, 'x', sizeof(big));
+    ots_write(&g_s, big, sizeof(big), 0);
+    ASSERT_TRUE(g_s.full_flushes == 1 && g_c8.n == OTS_RING_BYTES && ots_pending(&g_s) == 100,
+                "full ring drains before accepting more");
+    ots_flush(&g_s, 0);
+    ASSERT_EQ((int)g_c8.n, (int)sizeof(big), "explicit flush drains the rest");
+}
+
+// ============================================================
+// Benchmark
+// ============================================================
+
+// ConOut->OutputString stand-in: fixed cost per call plus a small cost per
+// code unit (terminal driver + UART model).
+static volatile uint32_t g_sink_sink;
+static void slow_console(void *ctx, const uint16_t *s, uint32_t n) {
+    (void)ctx;
+    double t0 = now_ns();
+    while (now_ns() - t0 < 2000.0 + 5.0 * n) g_sink_sink += s[0];
+}
+
+static void bench(void) {
+    printf("\n[BENCH] 4000 tokens to a console costing 2 us/call + 5 ns/char\n");
+    static const char *words[] = { " the", " model", " runs", " on", " bare", " metal", ",", " and", "\n" };
+    const int N = 4000;
+
+    double best[2] = { 1e30, 1e30 };
+    uint32_t calls[2] = { 0, 0 };
+    for (int mode = 0; mode < 2; mode++) {
+        for (int rep = 0; rep < 3; rep++) {
+            ots_init(&g_s);
+            ots_add_ucs2_sink(&g_s, slow_console, 0);
+            if (mode == 0) ots_set_cadence(&g_s, 1, 0, 0, 0);   // direct: every token
+            double t0 = now_ns();
+            for (int i = 0; i < N; i++) {
+                const char *w = words[(i * 7) % 9];
+                ots_write(&g_s, w, (uint32_t)strlen(w), 0);
+            }
+            ots_finish(&g_s, 0);
+            double dt = now_ns() - t0;
+            if (dt < best[mode]) best[mode] = dt;
+            calls[mode] = g_s.sink[0].calls;
+        }
+    }
+    printf("  per token : %6u calls  %8.2f ms\n", calls[0], best[0] / 1e6);
+    printf("  buffered  : %6u calls  %8.2f ms  (%.1fx)\n", calls[1], best[1] / 1e6, best[0] / best[1]);
+    ASSERT_TRUE(calls[1] * 4 < calls[0], "buffered output makes at least 4x fewer console calls");
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  Token Output Ring — Host Test Suite\n");
+    printf("==============================================\n");
+
+    g_c8.u8 = (uint8_t *)malloc(CAP_MAX);
+    g_c16.u16 = (uint16_t *)malloc(CAP_MAX * sizeof(uint16_t));
+
+    test_decoder();
+    test_split();
+    test_fanout();
+    test_cadence();
+    bench();
+
+    free(g_c8.u8);
+    free(g_c16.u16);
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All token stream tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
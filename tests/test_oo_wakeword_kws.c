@@ -0,0 +1,1041 @@
+// test_oo_wakeword_kws.c — Host harness for the MFCC + DS-CNN wake-word path
+//
+// Tests:
+//   front-end: fixed-point log-mel / frame energy vs a double-precision DFT,
+//     loud and near-silent input; chunk size does not change the features
+//   model file: header validation, truncated / misaligned blobs refused
+//   forward: okws network (shared Q8_0 kernel) vs a double reference
+//   detector: synthesises formant utterances ("hey oo" vs other words,
+//     reversed order, fricatives, music), trains the classifier head of a
+//     DS-CNN on one set, writes the .okws model and the held-out set as WAV
+//     files, streams the WAVs through oww_feed and reports FAR / FRR next
+//     to the legacy energy-template detector
+//   cycle budget: the evaluation stride follows the per-frame budget
+//   bench: cycles per 10 ms frame, front-end and model
+//
+// Only the classifier head is trained here (the conv stack keeps its random
+// init); a real model comes from an offline trainer in the same file format.
+// Real recordings can be scored with an existing model:
+//   ./test_oo_wakeword_kws --model wake.okws --pos yes1.wav yes2.wav --neg no1.wav
+//
+// Build (Linux, x86-64 host, no UEFI):
+//   gcc -std=gnu11 -O2 -msse2 -Wall -Wextra -I../engine/voice -I../engine/self_improve
+//       -I../engine/ssm test_oo_wakeword_kws.c ../engine/voice/oo_wakeword.c
+//       ../engine/voice/oo_mfcc.c ../engine/voice/oo_kws.c
+//       ../engine/self_improve/oo_lora.c -lm -o test_oo_wakeword_kws
+//
+// Run:
+//   ./test_oo_wakeword_kws [--dir /tmp/oo_kws]
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "oo_wakeword.h"
+#include "oo_mfcc.h"
+#include "oo_kws.h"
+
+// ============================================================
+// Stubs: NVMe (oo_lora persist; only the matmul kernel is used)
+// ============================================================
+typedef uint8_t  UINT8;
+typedef uint32_t UINT32;
+int oo_nvme_read_lba(UINT32 lba, UINT8 *buf, UINT32 bytes)        { (void)lba; (void)buf; (void)bytes; return -1; }
+int oo_nvme_write_lba(UINT32 lba, const UINT8 *buf, UINT32 bytes) { (void)lba; (void)buf; (void)bytes; return -1; }
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ == b_) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %lld, expected %lld)\n", msg, a_, b_); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+static float urand(float lo, float hi) { return lo + (hi - lo) * 0.5f * (frand() + 1.0f); }
+
+// ============================================================
+// Q8_0 helpers (GGML layout: fp16 scale + 32 int8 per block)
+// ============================================================
+static uint16_t f32_to_f16(float f) {
+    union { float f; uint32_t u; } c = { f };
+    uint32_t sign = (c.u >> 16) & 0x8000u;
+    int exp = (int)((c.u >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = c.u & 0x7FFFFFu;
+    if (exp <= 0) return (uint16_t)sign;
+    if (exp >= 31) return (uint16_t)(sign | 0x7C00u);
+    uint32_t h = sign | ((uint32_t)exp << 10) | (mant >> 13);
+    if (mant & 0x1000u) h++;
+    return (uint16_t)h;
+}
+
+static float f16_to_f32(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    int exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FFu;
+    union { uint32_t u; float f; } c;
+    if (exp == 0) c.u = sign;
+    else c.u = sign | ((uint32_t)(exp - 15 + 127) << 23) | (mant << 13);
+    return c.f;
+}
+
+static void quantize_q8(const float *w, uint8_t *q, int rows, int cols) {
+    for (int r = 0; r < rows; r++)
+        for (int b = 0; b < cols / 32; b++) {
+            const float *src = w + (size_t)r * cols + b * 32;
+            uint8_t *blk = q + ((size_t)r * (cols / 32) + b) * 34;
+            float amax = 0.0f;
+            for (int i = 0; i < 32; i++) if (fabsf(src[i]) > amax) amax = fabsf(src[i]);
+            uint16_t h = f32_to_f16(amax / 127.0f);
+            float d = f16_to_f32(h);
+            blk[0] = (uint8_t)h; blk[1] = (uint8_t)(h >> 8);
+            for (int i = 0; i < 32; i++) {
+                int v = d > 0.0f ? (int)lrintf(src[i] / d) : 0;
+                if (v > 127) v = 127;
+                if (v < -127) v = -127;
+                blk[2 + i] = (uint8_t)(int8_t)v;
+            }
+        }
+}
+
+static float q8_at(const uint8_t *w, int cols, int r, int c) {
+    const uint8_t *blk = w + ((size_t)r * (cols / 32) + c / 32) * 34;
+    return f16_to_f32((uint16_t)(blk[0] | (blk[1] << 8))) * (float)(int8_t)blk[2 + c % 32];
+}
+
+// ============================================================
+// WAV files (RIFF PCM16 mono 16 kHz)
+// ============================================================
+static void put32(uint8_t *p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24); }
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static uint32_t get32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static int wav_write(const char *path, const int16_t *pcm, int n) {
+    uint8_t h[44];
+    memcpy(h, "RIFF", 4);      put32(h + 4, 36u + (uint32_t)n * 2u);
+    memcpy(h + 8, "WAVEfmt ", 8); put32(h + 16, 16);
+    put16(h + 20, 1);          put16(h + 22, 1);
+    put32(h + 24, OMF_SAMPLE_RATE); put32(h + 28, OMF_SAMPLE_RATE * 2);
+    put16(h + 32, 2);          put16(h + 34, 16);
+    memcpy(h + 36, "data", 4); put32(h + 40, (uint32_t)n * 2u);
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = fwrite(h, 1, 44, f) == 44;
+    for (int i = 0; ok && i < n; i++) {
+        uint8_t s[2];
+        put16(s, (uint16_t)pcm[i]);
+        ok = fwrite(s, 1, 2, f) == 2;
+    }
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+// Returns samples (malloc'd) or NULL; only PCM16 mono 16 kHz is accepted
+static int16_t *wav_read(const char *path, int *n_out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *raw = malloc((size_t)len);
+    if (!raw || fread(raw, 1, (size_t)len, f) != (size_t)len || len < 12 ||
+        memcmp(raw, "RIFF", 4) || memcmp(raw + 8, "WAVE", 4)) {
+        fclose(f); free(raw); return NULL;
+    }
+    fclose(f);
+    int16_t *pcm = NULL;
+    int fmt_ok = 0;
+    for (long p = 12; p + 8 <= len; ) {
+        uint32_t sz = get32(raw + p + 4);
+        const uint8_t *body = raw + p + 8;
+        if ((long)(p + 8 + sz) > len) break;
+        if (!memcmp(raw + p, "fmt ", 4) && sz >= 16)
+            fmt_ok = get16(body) == 1 && get16(body + 2) == 1 &&
+                     get32(body + 4) == OMF_SAMPLE_RATE && get16(body + 14) == 16;
+        if (!memcmp(raw + p, "data", 4) && fmt_ok) {
+            *n_out = (int)(sz / 2);
+            pcm = malloc((size_t)*n_out * 2 + 2);
+            for (int i = 0; i < *n_out; i++) pcm[i] = (int16_t)get16(body + 2 * i);
+            break;
+        }
+        p += 8 + sz + (sz & 1);
+    }
+    free(raw);
+    return pcm;
+}
+
+// ============================================================
+// Formant synthesiser
+// ============================================================
+#define SR        OMF_SAMPLE_RATE
+#define LEAD_MS   600
+#define TRAIL_MS  500
+#define MAX_CLIP  (SR * 3)
+
+enum { V_A, V_E, V_I, V_O, V_U, V_AE, V_ER, N_VOWELS };
+static const float k_vowels[N_VOWELS][3] = {
+    { 730, 1090, 2440 }, { 530, 1840, 2480 }, { 270, 2290, 3010 }, { 570,  840, 2410 },
+    { 300,  870, 2240 }, { 660, 1720, 2410 }, { 490, 1350, 1690 },
+};
+
+enum { SEG_VOWEL, SEG_H, SEG_SH, SEG_TONE };
+typedef struct { int kind, v0, v1; float ms; } Seg;
+typedef struct { const char *name; int n; Seg seg[4]; } Word;
+
+// Class 1: "hey oo". Everything else is background.
+static const Word k_keyword = { "HEY_OO", 3, { { SEG_H, V_E, V_E, 60 }, { SEG_VOWEL, V_E, V_I, 170 },
+                                                { SEG_VOWEL, V_U, V_U, 230 } } };
+static const Word k_negatives[] = {
+    { "oo",     1, { { SEG_VOWEL, V_U, V_U, 300 } } },
+    { "hey",    2, { { SEG_H, V_E, V_E, 60 }, { SEG_VOWEL, V_E, V_I, 200 } } },
+    { "oo-hey", 3, { { SEG_VOWEL, V_U, V_U, 230 }, { SEG_H, V_E, V_E, 60 }, { SEG_VOWEL, V_E, V_I, 170 } } },
+    { "hello",  3, { { SEG_H, V_E, V_E, 60 }, { SEG_VOWEL, V_E, V_E, 120 }, { SEG_VOWEL, V_O, V_U, 250 } } },
+    { "ah-ee",  2, { { SEG_VOWEL, V_A, V_A, 200 }, { SEG_VOWEL, V_I, V_I, 200 } } },
+    { "pair",   2, { { SEG_VOWEL, 0, 0, 200 }, { SEG_VOWEL, 0, 0, 230 } } },   // random vowels
+    { "shh",    1, { { SEG_SH, 0, 0, 400 } } },
+    { "chord",  1, { { SEG_TONE, 0, 0, 500 } } },
+};
+#define N_NEG_KINDS ((int)(sizeof(k_negatives) / sizeof(k_negatives[0])))
+
+typedef struct { float y1, y2; } Reson;
+
+static float reson(Reson *r, float x, float f, float bw) {
+    float rr = expf(-(float)M_PI * bw / SR);
+    float b = 2.0f * rr * cosf(2.0f * (float)M_PI * f / SR), c = -rr * rr, a = 1.0f - b - c;
+    float y = a * x + b * r->y1 + c * r->y2;
+    r->y2 = r->y1; r->y1 = y;
+    return y;
+}
+
+// Render one word (peak = amp) into out; returns its length in samples
+static int synth_word(float *out, int cap, const Word *w, float speed, float f0, float amp) {
+    Seg seg[4];
+    int total = 0;
+    for (int s = 0; s < w->n; s++) {
+        seg[s] = w->seg[s];
+        if (seg[s].kind == SEG_VOWEL && seg[s].v0 == 0 && seg[s].v1 == 0 && !strcmp(w->name, "pair")) {
+            int v = (int)urand(0, N_VOWELS - 0.01f);
+            if (s == 1 && (seg[0].v0 == V_E || seg[0].v0 == V_I) && v == V_U) v = V_A;
+            seg[s].v0 = seg[s].v1 = v;
+        }
+        total += (int)(seg[s].ms * speed * SR / 1000.0f);
+    }
+    if (total > cap) total = cap;
+
+    Reson rs[3] = { { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    float fs[3] = { k_vowels[seg[0].v0][0], k_vowels[seg[0].v0][1], k_vowels[seg[0].v0][2] };
+    float phase = 0.0f, glott = 0.0f, peak = 1e-9f, tone_f = urand(220, 440);
+    int t = 0;
+    for (int s = 0; s < w->n && t < total; s++) {
+        int n = (int)(seg[s].ms * speed * SR / 1000.0f);
+        for (int i = 0; i < n && t < total; i++, t++) {
+            float pos = (float)i / (float)n, y;
+            if (seg[s].kind == SEG_TONE) {
+                float tt = (float)t / SR;
+                y = sinf(2 * (float)M_PI * tone_f * tt) + 0.7f * sinf(2 * (float)M_PI * tone_f * 1.26f * tt) +
+                    0.5f * sinf(2 * (float)M_PI * tone_f * 1.5f * tt);
+            } else {
+                float tgt[3];
+                for (int k = 0; k < 3; k++)
+                    tgt[k] = seg[s].kind == SEG_SH ? 2500.0f + 900.0f * k
+                           : k_vowels[seg[s].v0][k] + (k_vowels[seg[s].v1][k] - k_vowels[seg[s].v0][k]) * pos;
+                for (int k = 0; k < 3; k++) fs[k] += (tgt[k] - fs[k]) * 0.004f;
+                float e;
+                if (seg[s].kind == SEG_VOWEL) {
+                    phase += f0 * (1.1f - 0.2f * (float)t / (float)total) / SR;
+                    float pulse = 0.0f;
+                    if (phase >= 1.0f) { phase -= 1.0f; pulse = 1.0f; }
+                    glott = 0.9f * glott + pulse;
+                    e = glott + 0.02f * frand();
+                } else {
+                    e = (seg[s].kind == SEG_H ? 0.25f : 0.6f) * frand();
+                }
+                y = reson(&rs[2], reson(&rs[1], reson(&rs[0], e, fs[0], 60), fs[1], 90), fs[2], 120);
+            }
+            float env = 1.0f;
+            if (t < SR / 50) env = (float)t / (SR / 50);
+            if (total - t < SR / 25) env = (float)(total - t) / (SR / 25);
+            out[t] = y * env;
+            if (fabsf(out[t]) > peak) peak = fabsf(out[t]);
+        }
+    }
+    for (int i = 0; i < total; i++) out[i] *= amp / peak;
+    return total;
+}
+
+typedef struct {
+    int16_t pcm[MAX_CLIP];
+    int     n;
+    int     label;               // 1 = keyword
+    int     w0, w1;              // word span (samples)
+} Clip;
+
+// LEAD_MS of room noise, one word, TRAIL_MS of room noise
+static void make_clip(Clip *c, int label, int kind) {
+    static float buf[MAX_CLIP];
+    const Word *w = label ? &k_keyword : &k_negatives[kind % N_NEG_KINDS];
+    float speed = label ? urand(0.85f, 1.1f) : urand(0.8f, 1.2f);
+    int wn = synth_word(buf, MAX_CLIP / 2, w, speed, urand(90, 230), urand(2500, 12000));
+    int lead = LEAD_MS * SR / 1000 + (int)urand(0, 800);
+    c->n = lead + wn + TRAIL_MS * SR / 1000;
+    c->label = label;
+    c->w0 = lead;
+    c->w1 = lead + wn;
+    float bg = urand(30, 200), b = 0.0f;
+    for (int i = 0; i < c->n; i++) {
+        b = 0.97f * b + frand();
+        float v = bg * b * 0.25f + (i >= c->w0 && i < c->w1 ? buf[i - c->w0] : 0.0f);
+        c->pcm[i] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+    }
+}
+
+// ============================================================
+// Front-end
+// ============================================================
+static OmfFrontend g_omf;
+
+// Double reference for frame `fr` of pcm (same pre-emphasis / window)
+static void ref_frame(const int16_t *pcm, int fr, double *logmel, double *log_energy) {
+    static double p[OMF_N_MELS + 2];
+    double x[OMF_FFT_SIZE] = { 0 }, P[OMF_FFT_BINS];
+    int start = fr * OMF_HOP_SAMPLES;
+    double prev = start ? pcm[start - 1] : 0.0;
+    for (int i = 0; i < OMF_WIN_SAMPLES; i++) {
+        double v = pcm[start + i];
+        x[i] = (v - 0.97 * prev) * (0.54 - 0.46 * cos(2 * M_PI * i / (OMF_WIN_SAMPLES - 1)));
+        prev = v;
+    }
+    double tot = 0.0;
+    for (int k = 0; k < OMF_FFT_BINS; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < OMF_FFT_SIZE; n++) {
+            re += x[n] * cos(2 * M_PI * k * n / OMF_FFT_SIZE);
+            im -= x[n] * sin(2 * M_PI * k * n / OMF_FFT_SIZE);
+        }
+        tot += P[k] = re * re + im * im;
+    }
+    *log_energy = log2(tot);
+    double mlo = 1127 * log(1 + OMF_MEL_LO_HZ / 700.0), mhi = 1127 * log(1 + OMF_MEL_HI_HZ / 700.0);
+    for (int i = 0; i < OMF_N_MELS + 2; i++)
+        p[i] = 700 * (exp((mlo + (mhi - mlo) * i / (OMF_N_MELS + 1)) / 1127) - 1) * OMF_FFT_SIZE / SR;
+    for (int m = 1; m <= OMF_N_MELS; m++) {
+        double e = 0.0;
+        for (int k = 0; k < OMF_FFT_BINS; k++) {
+            double wgt = 0.0;
+            if (k >= p[m - 1] && k < p[m])      wgt = (k - p[m - 1]) / (p[m] - p[m - 1]);
+            else if (k >= p[m] && k < p[m + 1]) wgt = (p[m + 1] - k) / (p[m + 1] - p[m]);
+            e += wgt * P[k];
+        }
+        logmel[m - 1] = log2(e);
+    }
+}
+
+static void check_frontend(const int16_t *pcm, int n, const char *what) {
+    omf_reset(&g_omf);
+    int off = 0, fr = 0, bands = 0;
+    double worst = 0.0, worst_e = 0.0;
+    while (off < n) {
+        int used;
+        int ready = omf_feed(&g_omf, pcm + off, n - off, &used);
+        off += used;
+        if (!ready) break;
+        if (fr % 7 == 3) {
+            double lm[OMF_N_MELS], le;
+            ref_frame(pcm, fr, lm, &le);
+            worst_e = fmax(worst_e, fabs(g_omf.log_energy / 256.0 - le));
+            double top = lm[0];
+            for (int b = 1; b < OMF_N_MELS; b++) top = fmax(top, lm[b]);
+            for (int b = 0; b < OMF_N_MELS; b++) {
+                // Bands 40 dB under the loudest one sit in the 13-bit FFT noise
+                if (lm[b] < OMF_LOG_FLOOR / 256.0 + 3.0 || lm[b] < top - 13.0) continue;
+                worst = fmax(worst, fabs(g_omf.logmel[b] / 256.0 - lm[b]));
+                bands++;
+            }
+        }
+        fr++;
+    }
+    char msg[128];
+    printf("  [%s] %d frames, %d bands checked, max |Δlog2| mel %.4f energy %.4f\n",
+           what, fr, bands, worst, worst_e);
+    snprintf(msg, sizeof(msg), "%s: frame count = 1 + (n - 400) / 160", what);
+    ASSERT_EQ(fr, 1 + (n - OMF_WIN_SAMPLES) / OMF_HOP_SAMPLES, msg);
+    snprintf(msg, sizeof(msg), "%s: log-mel within 0.05 of double reference", what);
+    ASSERT_TRUE(bands > 0 && worst < 0.05, msg);
+    snprintf(msg, sizeof(msg), "%s: frame energy within 0.02", what);
+    ASSERT_TRUE(worst_e < 0.02, msg);
+}
+
+static void test_frontend(void) {
+    printf("\n[TEST] MFCC front-end vs double DFT\n");
+    omf_init(&g_omf, 10);
+    ASSERT_EQ(g_omf.n_mfcc, 10, "n_mfcc kept");
+
+    static int16_t pcm[SR];
+    g_rng = 0x1234567u;
+    for (int i = 0; i < SR; i++)
+        pcm[i] = (int16_t)(9000 * sin(2 * M_PI * 440 * i / SR) + 4000 * sin(2 * M_PI * 2650 * i / SR) +
+                           800 * frand());
+    check_frontend(pcm, SR, "loud");
+    for (int i = 0; i < SR; i++)
+        pcm[i] = (int16_t)lrint(20 * sin(2 * M_PI * 700 * i / SR) + 6 * frand());
+    check_frontend(pcm, SR, "quiet");
+
+    static Clip clip;
+    g_rng = 0xC0FFEEu;
+    make_clip(&clip, 1, 0);
+    check_frontend(clip.pcm, clip.n, "speech");
+
+    // Chunking must not change the features
+    static int32_t ref[400][OMF_MAX_MFCC];
+    int chunks[3] = { 682, 1, 160 }, nref = 0, same = 1, counts[3];
+    for (int c = 0; c < 3; c++) {
+        omf_reset(&g_omf);
+        int nf = 0;
+        for (int off = 0; off < clip.n; ) {
+            int len = clip.n - off < chunks[c] ? clip.n - off : chunks[c];
+            const int16_t *p = clip.pcm + off;
+            off += len;
+            while (len > 0) {
+                int used;
+                int ready = omf_feed(&g_omf, p, len, &used);
+                p += used; len -= used;
+                if (!ready) break;
+                if (nf < 400) {
+                    if (c == 0) memcpy(ref[nf], g_omf.mfcc, sizeof(ref[0]));
+                    else if (memcmp(ref[nf], g_omf.mfcc, sizeof(ref[0]))) same = 0;
+                }
+                nf++;
+            }
+        }
+        counts[c] = nf;
+        if (c == 0) nref = nf;
+    }
+    ASSERT_TRUE(counts[1] == nref && counts[2] == nref, "same frame count for 682 / 1 / 160 sample chunks");
+    ASSERT_TRUE(same, "bit-identical MFCCs regardless of chunking");
+}
+
+// ============================================================
+// Model construction
+// ============================================================
+#define T_FRAMES  56
+#define N_MFCC    10
+#define CH        64
+#define N_BLOCKS  3
+#define N_CLASSES 2
+
+typedef struct {
+    float c0[CH][64];           // K0 = 40 taps padded to 64
+    float c0_b[CH];
+    float dw[N_BLOCKS][9][CH];
+    float dw_b[N_BLOCKS][CH];
+    float pw[N_BLOCKS][CH][CH];
+    float pw_b[N_BLOCKS][CH];
+    float fc[N_CLASSES][CH];
+    float fc_b[N_CLASSES];
+    float mean[N_MFCC], scale[N_MFCC];
+} Net;
+
+static void net_random(Net *n) {
+    memset(n, 0, sizeof(*n));
+    float s0 = sqrtf(6.0f / 40.0f), sd = sqrtf(6.0f / 9.0f), sp = sqrtf(6.0f / CH);
+    for (int c = 0; c < CH; c++) {
+        for (int k = 0; k < 40; k++) n->c0[c][k] = s0 * frand();
+        n->c0_b[c] = 0.1f * frand();
+    }
+    for (int b = 0; b < N_BLOCKS; b++)
+        for (int c = 0; c < CH; c++) {
+            for (int k = 0; k < 9; k++) n->dw[b][k][c] = sd * frand();
+            for (int i = 0; i < CH; i++) n->pw[b][c][i] = sp * frand();
+            n->dw_b[b][c] = 0.05f * frand();
+            n->pw_b[b][c] = 0.05f * frand();
+        }
+    for (int f = 0; f < N_MFCC; f++) n->scale[f] = 1.0f;
+}
+
+static void fill_header(OkwsFileHeader *h) {
+    memset(h, 0, sizeof(*h));
+    h->magic = OKWS_MAGIC;      h->version = OKWS_VERSION;
+    h->header_bytes = sizeof(OkwsFileHeader);
+    h->n_frames = T_FRAMES;     h->n_mfcc = N_MFCC;
+    h->n_classes = N_CLASSES;   h->channels = CH;   h->n_blocks = N_BLOCKS;
+    h->k0_t = 10; h->k0_f = 4;  h->s0_t = 2; h->s0_f = 2;
+    h->eval_stride = 3;         h->smooth = 3;      h->refractory = 100;
+    h->threshold = 0.6f;
+    strcpy(h->names[0], "_background_");
+    strcpy(h->names[1], "HEY_OO");
+}
+
+// Serialise n into blob (4-byte aligned); returns bytes
+static uint32_t net_write(const Net *n, uint8_t *blob) {
+    OkwsFileHeader *h = (OkwsFileHeader *)blob;
+    fill_header(h);
+    for (int f = 0; f < N_MFCC; f++) { h->feat_mean[f] = n->mean[f]; h->feat_scale[f] = n->scale[f]; }
+    uint8_t *p = blob + sizeof(*h);
+    quantize_q8(&n->c0[0][0], p, CH, 64);              p += CH * 2 * 34;
+    memcpy(p, n->c0_b, sizeof(n->c0_b));               p += sizeof(n->c0_b);
+    for (int b = 0; b < N_BLOCKS; b++) {
+        float sc[CH];
+        for (int c = 0; c < CH; c++) {
+            float amax = 1e-12f;
+            for (int k = 0; k < 9; k++) amax = fmaxf(amax, fabsf(n->dw[b][k][c]));
+            sc[c] = amax / 127.0f;
+        }
+        for (int k = 0; k < 9; k++)
+            for (int c = 0; c < CH; c++) *p++ = (uint8_t)(int8_t)lrintf(n->dw[b][k][c] / sc[c]);
+        memcpy(p, sc, sizeof(sc));                     p += sizeof(sc);
+        memcpy(p, n->dw_b[b], sizeof(n->dw_b[b]));     p += sizeof(n->dw_b[b]);
+        quantize_q8(&n->pw[b][0][0], p, CH, CH);       p += CH * (CH / 32) * 34;
+        memcpy(p, n->pw_b[b], sizeof(n->pw_b[b]));     p += sizeof(n->pw_b[b]);
+    }
+    quantize_q8(&n->fc[0][0], p, N_CLASSES, CH);       p += (N_CLASSES * (CH / 32) * 34 + 3) & ~3;
+    memcpy(p, n->fc_b, sizeof(n->fc_b));               p += sizeof(n->fc_b);
+    return (uint32_t)(p - blob);
+}
+
+// ============================================================
+// Model file / forward tests
+// ============================================================
+static uint8_t g_blob[1 << 16] __attribute__((aligned(16)));
+static Net     g_net;
+
+static void test_model_file(void) {
+    printf("\n[TEST] .okws header validation\n");
+    g_rng = 0xABCDu;
+    net_random(&g_net);
+    uint32_t bytes = net_write(&g_net, g_blob);
+    OkwsModel m;
+    ASSERT_EQ(okws_model_bytes((const OkwsFileHeader *)g_blob), bytes, "okws_model_bytes = serialised size");
+    ASSERT_EQ(okws_load(&m, g_blob, bytes), OKWS_OK, "load well-formed blob");
+    ASSERT_EQ(m.out_t * m.out_f, 28 * 5, "conv0 'same' grid 28x5");
+    ASSERT_EQ(m.k0_pad, 64, "conv0 rows padded to 64 taps");
+    ASSERT_TRUE(m.fc_bias == (const float *)(g_blob + bytes) - N_CLASSES, "sections tile the blob");
+    ASSERT_EQ(okws_load(&m, g_blob, bytes - 1), OKWS_E_SIZE, "truncated blob refused");
+    ASSERT_EQ(okws_load(&m, g_blob + 1, bytes), OKWS_E_ARG, "misaligned blob refused");
+
+    static uint8_t bad[sizeof(OkwsFileHeader)] __attribute__((aligned(4)));
+    memcpy(bad, g_blob, sizeof(bad));
+    ((OkwsFileHeader *)bad)->magic ^= 1;
+    ASSERT_EQ(okws_load(&m, bad, bytes), OKWS_E_FORMAT, "bad magic refused");
+    memcpy(bad, g_blob, sizeof(bad));
+    ((OkwsFileHeader *)bad)->channels = 48;
+    ASSERT_EQ(okws_load(&m, bad, sizeof(bad)), OKWS_E_GEOMETRY, "channels not a multiple of 32 refused");
+
+    static OwwEngine e;
+    oww_init(&e);
+    static float arena[1 << 16];
+    okws_load(&m, g_blob, bytes);
+    ASSERT_EQ(oww_model_arena_bytes(g_blob, bytes), okws_stream_bytes(&m), "arena size via oww");
+    ASSERT_EQ(oww_load_model(&e, g_blob, bytes, arena, 16), OKWS_E_ARENA, "short arena refused");
+    ASSERT_EQ(e.use_model, 0, "legacy path kept after a failed load");
+}
+
+// Double reference of the whole network on the loaded (quantised) weights
+static void ref_forward(const OkwsModel *m, const float *win, double *prob) {
+    const OkwsFileHeader *h = m->hdr;
+    const int C = m->C, P = m->out_t * m->out_f;
+    static double a[28 * 5][CH], b[28 * 5][CH];
+    for (int ot = 0; ot < m->out_t; ot++)
+        for (int of = 0; of < m->out_f; of++)
+            for (int c = 0; c < C; c++) {
+                double s = m->c0_bias[c];
+                for (int kt = 0; kt < h->k0_t; kt++)
+                    for (int kf = 0; kf < h->k0_f; kf++) {
+                        int t = ot * h->s0_t - m->pad_t + kt, f = of * h->s0_f - m->pad_f + kf;
+                        if (t < 0 || t >= m->T || f < 0 || f >= m->F) continue;
+                        s += q8_at(m->c0_w, m->k0_pad, c, kt * h->k0_f + kf) * win[t * m->F + f];
+                    }
+                a[ot * m->out_f + of][c] = s > 0 ? s : 0;
+            }
+    for (int k = 0; k < m->n_blocks; k++) {
+        const OkwsBlock *bl = &m->blk[k];
+        for (int y = 0; y < m->out_t; y++)
+            for (int x = 0; x < m->out_f; x++)
+                for (int c = 0; c < C; c++) {
+                    double s = 0;
+                    for (int dy = -1; dy <= 1; dy++)
+                        for (int dx = -1; dx <= 1; dx++) {
+                            int yy = y + dy, xx = x + dx;
+                            if (yy < 0 || yy >= m->out_t || xx < 0 || xx >= m->out_f) continue;
+                            s += bl->dw_w[((dy + 1) * 3 + dx + 1) * C + c] * a[yy * m->out_f + xx][c];
+                        }
+                    s = s * bl->dw_scale[c] + bl->dw_bias[c];
+                    b[y * m->out_f + x][c] = s > 0 ? s : 0;
+                }
+        for (int p = 0; p < P; p++)
+            for (int o = 0; o < C; o++) {
+                double s = bl->pw_bias[o];
+                for (int i = 0; i < C; i++) s += q8_at(bl->pw_w, C, o, i) * b[p][i];
+                a[p][o] = s > 0 ? s : 0;
+            }
+    }
+    double pool[CH] = { 0 }, lg[OKWS_MAX_CLASSES], mx = -1e300, sum = 0;
+    for (int p = 0; p < P; p++) for (int c = 0; c < C; c++) pool[c] += a[p][c] / P;
+    for (int j = 0; j < m->n_classes; j++) {
+        lg[j] = m->fc_bias[j];
+        for (int c = 0; c < C; c++) lg[j] += q8_at(m->fc_w, C, j, c) * pool[c];
+        mx = fmax(mx, lg[j]);
+    }
+    for (int j = 0; j < m->n_classes; j++) sum += prob[j] = exp(lg[j] - mx);
+    for (int j = 0; j < m->n_classes; j++) prob[j] /= sum;
+}
+
+static void test_forward(void) {
+    printf("\n[TEST] DS-CNN forward vs double reference\n");
+    g_rng = 0x5151u;
+    net_random(&g_net);
+    for (int c = 0; c < CH; c++) { g_net.fc[1][c] = 0.5f * frand(); g_net.fc[0][c] = 0.5f * frand(); }
+    uint32_t bytes = net_write(&g_net, g_blob);
+    static OkwsModel m;
+    static OkwsStream s;
+    static float arena[1 << 16];
+    okws_load(&m, g_blob, bytes);
+    ASSERT_EQ(okws_stream_init(&s, &m, arena, sizeof(arena)), OKWS_OK, "stream init");
+
+    double worst = 0.0;
+    for (int trial = 0; trial < 4; trial++) {
+        int32_t mf[N_MFCC];
+        okws_stream_reset(&s);
+        for (int t = 0; t < T_FRAMES; t++) {
+            for (int f = 0; f < N_MFCC; f++) mf[f] = (int32_t)(256.0f * 2.0f * frand());
+            okws_push(&s, mf);
+        }
+        okws_eval(&s);
+        double pr[OKWS_MAX_CLASSES];
+        ref_forward(&m, s.win, pr);
+        for (int j = 0; j < N_CLASSES; j++) worst = fmax(worst, fabs(pr[j] - s.prob[j]));
+    }
+    printf("  max |Δp| = %.2e\n", worst);
+    ASSERT_TRUE(worst < 1e-4, "posteriors match the double reference");
+    ASSERT_TRUE(s.eval_cycles > 0, "evaluation is timed");
+}
+
+// ============================================================
+// Detector: train the head, stream WAVs, FAR / FRR
+// ============================================================
+#define N_TRAIN_POS  160
+#define N_TRAIN_NEG  320
+#define N_TEST_POS   60
+#define N_TEST_NEG   120
+#define MAX_FRAMES   300
+#define MAX_EX       ((N_TRAIN_POS + N_TRAIN_NEG) * 16)
+
+typedef struct { int32_t f[MAX_FRAMES][OMF_MAX_MFCC]; int n, e0, e1, label; } Feats;
+
+static void clip_feats(const Clip *c, Feats *ft) {
+    omf_reset(&g_omf);
+    ft->n = 0;
+    for (int off = 0; off < c->n && ft->n < MAX_FRAMES; ) {
+        int used;
+        int ready = omf_feed(&g_omf, c->pcm + off, c->n - off, &used);
+        off += used;
+        if (!ready) break;
+        memcpy(ft->f[ft->n++], g_omf.mfcc, sizeof(ft->f[0]));
+    }
+    // Word span in frames: first frame touching it, first frame that saw all of it
+    ft->e0 = c->w0 / OMF_HOP_SAMPLES;
+    ft->e1 = (c->w1 - OMF_WIN_SAMPLES) / OMF_HOP_SAMPLES + 1;
+    ft->label = c->label;
+}
+
+static void embed(OkwsStream *s, const Feats *ft, int end, float *out) {
+    const OkwsModel *m = s->m;
+    for (int t = 0; t < m->T; t++) {
+        int fr = end - m->T + 1 + t;
+        for (int f = 0; f < m->F; f++)
+            s->ring[t * m->F + f] = fr < 0 ? 0.0f
+                : ((float)ft->f[fr][f] / OMF_LOG_ONE - m->hdr->feat_mean[f]) * m->hdr->feat_scale[f];
+    }
+    s->head = 0;
+    s->filled = m->T;
+    okws_eval(s);
+    memcpy(out, s->pool, CH * sizeof(float));
+}
+
+// Logistic regression on standardised embeddings, folded back into fc
+static void train_head(Net *n, float (*x)[CH], const int *y, int N) {
+    double mu[CH] = { 0 }, sd[CH] = { 0 }, w[CH] = { 0 }, vw[CH] = { 0 }, bias = 0, vb = 0;
+    int npos = 0;
+    for (int i = 0; i < N; i++) { npos += y[i]; for (int c = 0; c < CH; c++) mu[c] += x[i][c] / N; }
+    for (int i = 0; i < N; i++) for (int c = 0; c < CH; c++) sd[c] += (x[i][c] - mu[c]) * (x[i][c] - mu[c]) / N;
+    for (int c = 0; c < CH; c++) sd[c] = sqrt(sd[c]) + 1e-6;
+    double wp = 0.5 * N / (npos ? npos : 1), wn = 0.5 * N / (N - npos ? N - npos : 1);
+    for (int it = 0; it < 1500; it++) {
+        double g[CH] = { 0 }, gb = 0;
+        for (int i = 0; i < N; i++) {
+            double z = bias;
+            for (int c = 0; c < CH; c++) z += w[c] * (x[i][c] - mu[c]) / sd[c];
+            double p = 1.0 / (1.0 + exp(-z)), d = (p - y[i]) * (y[i] ? wp : wn) / N;
+            for (int c = 0; c < CH; c++) g[c] += d * (x[i][c] - mu[c]) / sd[c];
+            gb += d;
+        }
+        for (int c = 0; c < CH; c++) {
+            vw[c] = 0.9 * vw[c] + g[c] + 1e-3 * w[c];
+            w[c] -= 0.5 * vw[c];
+        }
+        vb = 0.9 * vb + gb;
+        bias -= 0.5 * vb;
+    }
+    n->fc_b[0] = 0.0f;
+    n->fc_b[1] = (float)bias;
+    for (int c = 0; c < CH; c++) {
+        n->fc[0][c] = 0.0f;
+        n->fc[1][c] = (float)(w[c] / sd[c]);
+        n->fc_b[1] -= (float)(w[c] * mu[c] / sd[c]);
+    }
+}
+
+typedef struct { int files, hits, events; double seconds; } Score;
+
+// Stream one file in voice-loop sized chunks; returns detections
+static int stream_file(OwwEngine *e, const int16_t *pcm, int n) {
+    int hits = 0;
+    for (int off = 0; off < n; off += 682) {
+        int len = n - off < 682 ? n - off : 682;
+        oww_feed(e, pcm + off, len);
+        hits += oww_poll(e);
+    }
+    return hits;
+}
+
+static void score_files(OwwEngine *e, char (*paths)[256], int n, Score *sc) {
+    memset(sc, 0, sizeof(*sc));
+    for (int i = 0; i < n; i++) {
+        int len = 0;
+        int16_t *pcm = wav_read(paths[i], &len);
+        if (!pcm) { printf("  [skip] cannot read %s\n", paths[i]); continue; }
+        oww_reset(e);                    // each recording stands alone
+        int h = stream_file(e, pcm, len);
+        sc->files++;
+        sc->hits += h > 0;
+        sc->events += h;
+        sc->seconds += (double)len / SR;
+        free(pcm);
+    }
+}
+
+static void report(const char *name, const Score *pos, const Score *neg, double *frr, double *far) {
+    *frr = pos->files ? 100.0 * (pos->files - pos->hits) / pos->files : 0.0;
+    *far = neg->files ? 100.0 * neg->hits / neg->files : 0.0;
+    double hours = (pos->seconds + neg->seconds) / 3600.0;
+    printf("  %-22s FRR %5.1f%% (%d/%d missed)  FAR %5.1f%% (%d/%d negatives fired, %.0f FA/h)\n",
+           name, *frr, pos->files - pos->hits, pos->files, *far, neg->hits, neg->files,
+           hours > 0 ? neg->events / hours : 0.0);
+}
+
+static const char *g_dir = "/tmp/oo_kws";
+static uint8_t g_model_file[1 << 16] __attribute__((aligned(16)));
+
+static void test_detector(void) {
+    printf("\n[TEST] Wake word: train head, stream held-out WAVs, FAR / FRR\n");
+    static Clip clip;
+    static Feats feats[N_TRAIN_POS + N_TRAIN_NEG];
+    const int n_train = N_TRAIN_POS + N_TRAIN_NEG;
+    double t0 = now_ns();
+
+    // 1. Training features + normalisation
+    g_rng = 0x7EA1u;
+    omf_init(&g_omf, N_MFCC);
+    double sum[N_MFCC] = { 0 }, sq[N_MFCC] = { 0 };
+    long nfr = 0;
+    for (int i = 0; i < n_train; i++) {
+        int pos = i < N_TRAIN_POS;
+        make_clip(&clip, pos, i);
+        clip_feats(&clip, &feats[i]);
+        for (int t = 0; t < feats[i].n; t++, nfr++)
+            for (int f = 0; f < N_MFCC; f++) {
+                double v = feats[i].f[t][f] / 256.0;
+                sum[f] += v; sq[f] += v * v;
+            }
+    }
+    net_random(&g_net);
+    for (int f = 0; f < N_MFCC; f++) {
+        g_net.mean[f] = (float)(sum[f] / nfr);
+        g_net.scale[f] = (float)(1.0 / sqrt(fmax(sq[f] / nfr - g_net.mean[f] * g_net.mean[f], 1e-6)));
+    }
+
+    // 2. Embeddings: whole keyword in view → 1, everything else → 0
+    static float x[MAX_EX][CH];
+    static int y[MAX_EX];
+    static OkwsModel m;
+    static OkwsStream s;
+    static float arena[1 << 16];
+    uint32_t bytes = net_write(&g_net, g_blob);
+    okws_load(&m, g_blob, bytes);
+    okws_stream_init(&s, &m, arena, sizeof(arena));
+    int N = 0;
+    for (int i = 0; i < n_train; i++) {
+        const Feats *ft = &feats[i];
+        if (ft->label) {
+            for (int end = ft->e1; end <= ft->e0 + T_FRAMES - 1 && end < ft->n; end += 2) {
+                embed(&s, ft, end, x[N]); y[N++] = 1;
+            }
+            embed(&s, ft, ft->e0 + (ft->e1 - ft->e0) * 2 / 5, x[N]); y[N++] = 0;
+            embed(&s, ft, ft->e1 + T_FRAMES - 8 < ft->n ? ft->e1 + T_FRAMES - 8 : ft->n - 1, x[N]); y[N++] = 0;
+        } else {
+            for (int end = ft->e0 + 10; end < ft->n && end < ft->e1 + T_FRAMES / 2; end += 8) {
+                embed(&s, ft, end, x[N]); y[N++] = 0;
+            }
+        }
+    }
+    train_head(&g_net, x, y, N);
+    int correct = 0;
+    bytes = net_write(&g_net, g_blob);
+    okws_load(&m, g_blob, bytes);
+    for (int i = 0; i < N; i++) {
+        double z = g_net.fc_b[1];
+        for (int c = 0; c < CH; c++) z += g_net.fc[1][c] * x[i][c];
+        correct += (z > 0) == (y[i] == 1);
+    }
+    printf("  trained head on %d windows from %d clips: train acc %.1f%%  (%.1f s)\n",
+           N, n_train, 100.0 * correct / N, (now_ns() - t0) / 1e9);
+
+    // 3. Model + held-out WAVs to disk
+    mkdir(g_dir, 0755);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/wakeword.okws", g_dir);
+    FILE *f = fopen(path, "wb");
+    ASSERT_TRUE(f && fwrite(g_blob, 1, bytes, f) == bytes, "model written to .okws");
+    if (f) fclose(f);
+    f = fopen(path, "rb");
+    uint32_t fbytes = f ? (uint32_t)fread(g_model_file, 1, sizeof(g_model_file), f) : 0;
+    if (f) fclose(f);
+    ASSERT_EQ(fbytes, bytes, "model read back");
+
+    static char pos_paths[N_TEST_POS][256], neg_paths[N_TEST_NEG][256];
+    g_rng = 0x5EEDu;                     // disjoint from the training stream
+    for (int i = 0; i < N_TEST_POS; i++) {
+        make_clip(&clip, 1, 0);
+        snprintf(pos_paths[i], 256, "%s/pos_%03d.wav", g_dir, i);
+        wav_write(pos_paths[i], clip.pcm, clip.n);
+    }
+    for (int i = 0; i < N_TEST_NEG; i++) {
+        make_clip(&clip, 0, i);
+        snprintf(neg_paths[i], 256, "%s/neg_%03d_%s.wav", g_dir, i, k_negatives[i % N_NEG_KINDS].name);
+        wav_write(neg_paths[i], clip.pcm, clip.n);
+    }
+
+    // 4. Stream: neural path vs legacy energy templates
+    static OwwEngine kws, legacy;
+    static float kws_arena[1 << 16];
+    oww_init(&kws);
+    ASSERT_EQ(oww_load_model(&kws, g_model_file, fbytes, kws_arena, sizeof(kws_arena)), OKWS_OK,
+              "oww_load_model from file");
+    oww_init(&legacy);
+    int16_t quiet[SR / 2];
+    for (int i = 0; i < SR / 2; i++) quiet[i] = (int16_t)(60 * frand());
+    oww_calibrate(&legacy, quiet, SR / 2);
+
+    Score kp, kn, lp, ln;
+    double frr, far, lfrr, lfar;
+    score_files(&kws, pos_paths, N_TEST_POS, &kp);
+    score_files(&kws, neg_paths, N_TEST_NEG, &kn);
+    score_files(&legacy, pos_paths, N_TEST_POS, &lp);
+    score_files(&legacy, neg_paths, N_TEST_NEG, &ln);
+    report("MFCC + DS-CNN:", &kp, &kn, &frr, &far);
+    report("legacy energy template:", &lp, &ln, &lfrr, &lfar);
+
+    // Per-kind breakdown of neural false accepts
+    printf("  false accepts by negative kind:");
+    for (int k = 0; k < N_NEG_KINDS; k++) {
+        int fa = 0, tot = 0;
+        for (int i = k; i < N_TEST_NEG; i += N_NEG_KINDS) {
+            int len = 0;
+            int16_t *pcm = wav_read(neg_paths[i], &len);
+            if (!pcm) continue;
+            oww_reset(&kws);
+            fa += stream_file(&kws, pcm, len) > 0;
+            tot++;
+            free(pcm);
+        }
+        printf(" %s %d/%d", k_negatives[k].name, fa, tot);
+    }
+    printf("\n");
+    printf("  model: %u evals, stride %d, last word %s\n",
+           (unsigned)kws.kws.evals, kws.kws.stride, oww_last_word(&kws));
+
+    ASSERT_EQ(kp.files + kn.files, N_TEST_POS + N_TEST_NEG, "all WAVs streamed");
+    ASSERT_TRUE(frr <= 10.0, "FRR <= 10% on held-out keywords");
+    ASSERT_TRUE(far <= 10.0, "FAR <= 10% on held-out negatives");
+    ASSERT_TRUE(far + frr < lfar + lfrr, "neural path beats the energy templates (FAR + FRR)");
+}
+
+// ============================================================
+// Cycle budget + bench
+// ============================================================
+static void test_budget(void) {
+    printf("\n[TEST] Per-frame cycle budget\n");
+    static OwwEngine e;
+    static float arena[1 << 16];
+    static Clip clip;
+    oww_init(&e);
+    oww_load_model(&e, g_model_file, okws_model_bytes((const OkwsFileHeader *)g_model_file),
+                   arena, sizeof(arena));
+    g_rng = 0xB0D6E7u;
+
+    // Unlimited: evaluate every eval_stride frames
+    int frames0 = 0;
+    uint32_t ev0 = e.kws.evals;
+    for (int k = 0; k < 8; k++) { make_clip(&clip, k & 1, k); stream_file(&e, clip.pcm, clip.n); }
+    frames0 = (int)e.kws.frames;
+    int evals_free = (int)(e.kws.evals - ev0);
+    ASSERT_EQ(e.kws.stride, 3, "no budget: stride = eval_stride");
+
+    // A budget of a quarter of one evaluation → stride ≥ 4
+    uint64_t one = e.kws.eval_cycles;
+    oww_set_cycle_budget(&e, one / 4);
+    uint32_t ev1 = e.kws.evals, fr1 = e.kws.frames;
+    for (int k = 0; k < 8; k++) { make_clip(&clip, k & 1, k); stream_file(&e, clip.pcm, clip.n); }
+    int evals_tight = (int)(e.kws.evals - ev1);
+    double per_frame = (double)e.kws.eval_cycles / e.kws.stride;
+    printf("  eval %.0f kcyc; no budget: %d evals / %d frames; budget %.0f kcyc/frame: stride %d, %d evals / %u frames\n",
+           one / 1e3, evals_free, frames0, one / 4 / 1e3, e.kws.stride, evals_tight, e.kws.frames - fr1);
+    ASSERT_TRUE(e.kws.stride >= 4, "tight budget widens the stride");
+    ASSERT_TRUE(evals_tight < evals_free, "fewer evaluations under the budget");
+    ASSERT_TRUE(per_frame <= 1.3 * (double)(one / 4), "amortised model cost ~ budget");
+
+    oww_set_cycle_budget(&e, 0);
+    make_clip(&clip, 1, 0);
+    stream_file(&e, clip.pcm, clip.n);
+    ASSERT_EQ(e.kws.stride, 3, "budget lifted: stride back to eval_stride");
+}
+
+static void bench(void) {
+    printf("\n[BENCH] Cost per 10 ms frame\n");
+    static OwwEngine kws, legacy;
+    static float arena[1 << 16];
+    static int16_t pcm[SR * 10];
+    static Clip clip;
+    g_rng = 0xBE7Cu;
+    for (int off = 0; off < SR * 10; ) {
+        make_clip(&clip, (off / SR) & 1, off / SR);
+        int n = SR * 10 - off < clip.n ? SR * 10 - off : clip.n;
+        memcpy(pcm + off, clip.pcm, (size_t)n * 2);
+        off += n;
+    }
+    oww_init(&kws);
+    oww_load_model(&kws, g_model_file, okws_model_bytes((const OkwsFileHeader *)g_model_file),
+                   arena, sizeof(arena));
+    oww_init(&legacy);
+
+    double t0 = now_ns();
+    uint64_t c0 = rdtsc();
+    stream_file(&legacy, pcm, SR * 10);
+    double leg_ns = (now_ns() - t0) / 1000.0, leg_cyc = (double)(rdtsc() - c0) / 1000.0;
+    t0 = now_ns();
+    c0 = rdtsc();
+    stream_file(&kws, pcm, SR * 10);
+    double kws_ns = (now_ns() - t0) / 1000.0, kws_cyc = (double)(rdtsc() - c0) / 1000.0;
+
+    printf("  legacy templates      : %8.0f cyc  %6.2f us / frame\n", leg_cyc, leg_ns / 1e3);
+    printf("  MFCC + DS-CNN (total) : %8.0f cyc  %6.2f us / frame  (%.2f%% of real time)\n",
+           kws_cyc, kws_ns / 1e3, kws_ns / 1e7 * 100.0);
+    printf("    front-end           : %8llu cyc / frame\n", (unsigned long long)kws.mfcc_cycles);
+    printf("    model               : %8llu cyc / eval (max %llu), stride %d → %.0f cyc / frame\n",
+           (unsigned long long)kws.kws.eval_cycles, (unsigned long long)kws.kws.max_eval_cycles,
+           kws.kws.stride, (double)kws.kws.eval_cycles / kws.kws.stride);
+    ASSERT_TRUE(kws_ns / 1e7 < 0.5, "neural path runs faster than 2x real time");
+}
+
+// ============================================================
+// Real recordings: --model M --pos a.wav … --neg b.wav …
+// ============================================================
+static int run_files(int argc, char **argv) {
+    const char *model = NULL;
+    static char pos[256][256], neg[256][256];
+    int np = 0, nn = 0, mode = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--model") && i + 1 < argc) { model = argv[++i]; continue; }
+        if (!strcmp(argv[i], "--pos")) { mode = 1; continue; }
+        if (!strcmp(argv[i], "--neg")) { mode = 2; continue; }
+        if (mode == 1 && np < 256) snprintf(pos[np++], 256, "%s", argv[i]);
+        if (mode == 2 && nn < 256) snprintf(neg[nn++], 256, "%s", argv[i]);
+    }
+    FILE *f = model ? fopen(model, "rb") : NULL;
+    if (!f) { printf("cannot open model %s\n", model ? model : "(none)"); return 1; }
+    uint32_t bytes = (uint32_t)fread(g_model_file, 1, sizeof(g_model_file), f);
+    fclose(f);
+    static OwwEngine e;
+    static float arena[1 << 18];
+    oww_init(&e);
+    int rc = oww_load_model(&e, g_model_file, bytes, arena, sizeof(arena));
+    if (rc != OKWS_OK) { printf("model rejected (%d)\n", rc); return 1; }
+    Score sp, sn;
+    double frr, far;
+    score_files(&e, pos, np, &sp);
+    score_files(&e, neg, nn, &sn);
+    report(model, &sp, &sn, &frr, &far);
+    return 0;
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--model")) return run_files(argc, argv);
+        if (!strcmp(argv[i], "--dir") && i + 1 < argc) g_dir = argv[++i];
+    }
+
+    printf("==============================================\n");
+    printf("  OO Wake Word (MFCC + DS-CNN) — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_frontend();
+    test_model_file();
+    test_forward();
+    test_detector();
+    test_budget();
+    bench();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All wake word tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
@@ -0,0 +1,393 @@
+// test_oosi_v3_tp.c — pthread host harness for tensor-parallel OOSI v3 decode
+//
+// Tests:
+//   slice: slice bounds tile [0, n) without overlap, on cache-line
+//     boundaries whenever every slice gets a full line
+//   equivalence: decode with 1..16 slices (BSP + 0..15 pthread "APs", and
+//     without a work queue) gives bit-identical logits, sampled tokens,
+//     SSM state and conv ring buffers to serial decode
+//   detach: oosi_v3_tp_attach(NULL) restores serial decode mid-sequence
+//   scaling: decode tok/s for 1..16 slices on a 130M-class layer geometry
+//     (d_model 768, d_inner 1536; fewer layers and a smaller vocabulary to
+//     keep the run short). Host numbers only mean something up to the
+//     CPU count printed; run /ssm_tp_bench in QEMU with -smp N for APs.
+//
+// Random int8 weights built in memory. The executor, the work queue and
+// oosi_v3_infer.c are the files the UEFI build uses; pthreads stand in for
+// APs (no mwait in ring 3).
+//
+// Build (Linux, x86-64 host, no UEFI):
+//   gcc -std=gnu11 -O2 -msse2 -Wall -Wextra -pthread -I../engine/ssm -I../oo-multicore/core
+//       test_oosi_v3_tp.c ../engine/ssm/oosi_v3_infer.c ../engine/ssm/oosi_v3_tp.c
+//       ../oo-multicore/core/oo_mc_queue.c -lm -o test_oosi_v3_tp
+//
+// Run:
+//   ./test_oosi_v3_tp
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "oosi_v3_infer.h"
+#include "oosi_v3_tp.h"
+
+// LoRA hook of oosi_v3_forward_one (oo-kernel archive on UEFI)
+void oit_lora_apply_global(float *vec, int dim) { (void)vec; (void)dim; }
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ == b_) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %lld, expected %lld)\n", msg, a_, b_); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x85EBCA6Bu;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+// ============================================================
+// Random OOSI v3 model
+// ============================================================
+typedef struct {
+    OosiV3Weights w;
+    void         *blocks[16 * SSM_MAX_LAYERS];
+    int           n_blocks;
+} TestModel;
+
+static void *tm_alloc(TestModel *tm, size_t bytes) {
+    void *p = calloc(1, bytes);
+    tm->blocks[tm->n_blocks++] = p;
+    return p;
+}
+
+static const ssm_q8 *tm_q8(TestModel *tm, int rows, int cols) {
+    ssm_q8 *q = (ssm_q8 *)tm_alloc(tm, (size_t)rows * cols);
+    for (size_t i = 0; i < (size_t)rows * cols; i++) q[i] = (ssm_q8)(frand() * 127.0f);
+    return q;
+}
+
+static const ssm_f32 *tm_f32(TestModel *tm, int n, float base, float scale) {
+    ssm_f32 *f = (ssm_f32 *)tm_alloc(tm, (size_t)n * sizeof(ssm_f32));
+    for (int i = 0; i < n; i++) f[i] = base + frand() * scale;
+    return f;
+}
+
+static void model_build(TestModel *tm, int D, int N, int V, int S, int Dc, int Dt, uint32_t seed) {
+    memset(tm, 0, sizeof(*tm));
+    g_rng = seed;
+    OosiV3Weights *w = &tm->w;
+    const int Di = 2 * D;
+    w->d_model = D;
+    w->n_layer = N;
+    w->d_state = S;
+    w->d_conv = Dc;
+    w->expand = 2;
+    w->vocab_size = V;
+    w->dt_rank = Dt;
+    w->d_inner = Di;
+    const float in_s = 1.0f / (float)D, mid_s = 1.0f / (float)Di;
+    for (int l = 0; l < N; l++) {
+        OosiV3LayerWeights *lw = &w->layers[l];
+        lw->norm_weight = tm_f32(tm, D, 1.0f, 0.1f);
+        lw->in_proj_q8 = tm_q8(tm, 2 * Di, D);
+        lw->in_proj_scale = tm_f32(tm, 2 * Di, 40.0f * in_s * 8.0f, 0.0f);
+        lw->conv_weight = tm_f32(tm, Di * Dc, 0.0f, 0.5f);
+        lw->conv_bias = tm_f32(tm, Di, 0.0f, 0.1f);
+        lw->x_proj_q8 = tm_q8(tm, Dt + 2 * S, Di);
+        lw->x_proj_scale = tm_f32(tm, Dt + 2 * S, 20.0f * mid_s * 8.0f, 0.0f);
+        lw->x_out_rows = Dt + 2 * S;
+        lw->dt_proj_q8 = tm_q8(tm, Di, Dt);
+        lw->dt_proj_scale = tm_f32(tm, Di, 2.0f, 0.0f);
+        lw->dt_proj_bias = tm_f32(tm, Di, -2.0f, 0.5f);
+        lw->A_log = tm_f32(tm, Di * S, 0.5f, 0.5f);
+        lw->D = tm_f32(tm, Di, 1.0f, 0.2f);
+        lw->out_proj_q8 = tm_q8(tm, D, Di);
+        lw->out_proj_scale = tm_f32(tm, D, 20.0f * mid_s * 8.0f, 0.0f);
+    }
+    w->final_norm = tm_f32(tm, D, 1.0f, 0.1f);
+    w->embed_q8 = tm_q8(tm, V, D);
+    w->embed_scale = tm_f32(tm, V, 1.0f, 0.2f);
+    w->lm_head_q8 = tm_q8(tm, V, D);
+    w->lm_head_scale = tm_f32(tm, V, 4.0f, 0.5f);
+}
+
+static void model_free(TestModel *tm) {
+    for (int i = 0; i < tm->n_blocks; i++) free(tm->blocks[i]);
+    tm->n_blocks = 0;
+}
+
+// Generation context over private buffers (no HaltingHead)
+typedef struct {
+    OosiV3GenCtx ctx;
+    ssm_f32     *scratch, *logits, *h_state, *conv_buf;
+    int         *conv_pos;
+} TestCtx;
+
+static void ctx_make(TestCtx *c, const OosiV3Weights *w, float temperature) {
+    const int D = w->d_model, Di = w->d_inner, N = w->n_layer, S = w->d_state, Dc = w->d_conv;
+    c->scratch = (ssm_f32 *)calloc(1, (size_t)oosi_v3_scratch_floats(D, Di, w->dt_rank, S));
+    c->logits = (ssm_f32 *)calloc((size_t)w->vocab_size, sizeof(ssm_f32));
+    c->h_state = (ssm_f32 *)calloc(1, (size_t)oosi_v3_h_state_bytes(N, Di, S));
+    c->conv_buf = (ssm_f32 *)calloc(1, (size_t)oosi_v3_conv_buf_bytes(N, Di, Dc));
+    c->conv_pos = (int *)calloc(1, (size_t)oosi_v3_conv_pos_bytes(N));
+    oosi_v3_gen_ctx_init(&c->ctx, w, c->scratch, c->logits, c->h_state, c->conv_buf, c->conv_pos,
+                         NULL, NULL, NULL, 0.0f, temperature, 0.9f, 77u, 64);
+}
+
+static void ctx_free(TestCtx *c) {
+    free(c->scratch);
+    free(c->logits);
+    free(c->h_state);
+    free(c->conv_buf);
+    free(c->conv_pos);
+}
+
+// ============================================================
+// pthread "APs" on the oo_mc work queue
+// ============================================================
+static OoMulticoreCtx g_mc;
+
+typedef struct { pthread_t th; int idx; } ApThread;
+static ApThread g_aps[OO_MAX_CORES];
+
+static void *ap_main(void *p) {
+    ApThread *ap = (ApThread *)p;
+    oo_mc_worker_loop(&g_mc, ap->idx);
+    return NULL;
+}
+
+static void mc_setup(int n_aps) {
+    memset(&g_mc, 0, sizeof(g_mc));
+    g_mc.enabled = 1;
+    g_mc.core_count = n_aps + 1;
+    g_mc.bsp_idx = 0;
+    g_mc.cores[0].role = OO_CORE_ROLE_BSP;
+    for (int i = 1; i <= n_aps; i++) {
+        g_mc.cores[i].role = OO_CORE_ROLE_WORKER;
+        g_mc.mc_workers[g_mc.mc_worker_count++] = i;
+        g_aps[i].idx = i;
+        pthread_create(&g_aps[i].th, NULL, ap_main, &g_aps[i]);
+    }
+}
+
+static void mc_teardown(int n_aps) {
+    oo_mc_stop_workers(&g_mc);
+    for (int i = 1; i <= n_aps; i++) pthread_join(g_aps[i].th, NULL);
+}
+
+// ============================================================
+// Tests
+// ============================================================
+
+static void test_slice(void) {
+    printf("\n[slice]\n");
+    int ok = 1, aligned = 1;
+    const int ns_list[] = { 1, 2, 3, 5, 8, 13, 16 };
+    const int n_list[] = { 1, 7, 16, 80, 256, 1536, 1537, 50280 };
+    for (int a = 0; a < 7; a++) {
+        for (int b = 0; b < 8; b++) {
+            int ns = ns_list[a], n = n_list[b], next = 0;
+            for (int i = 0; i < ns; i++) {
+                int lo, hi;
+                oosi_v3_tp_slice(n, ns, i, &lo, &hi);
+                ok &= (lo == next) && (hi >= lo);
+                if (n >= ns * OOSI_V3_TP_ALIGN && i < ns - 1) aligned &= (hi % OOSI_V3_TP_ALIGN) == 0;
+                next = hi;
+            }
+            ok &= next == n;
+        }
+    }
+    ASSERT_TRUE(ok, "slices tile [0, n) in order, no gaps or overlap");
+    ASSERT_TRUE(aligned, "inner bounds on 16-float lines when n >= 16 per slice");
+}
+
+#define EQ_TOKENS 24
+
+typedef struct {
+    int      tok[EQ_TOKENS];
+    ssm_f32 *logits;        // [EQ_TOKENS][V]
+    ssm_f32 *h_state;
+    ssm_f32 *conv_buf;
+    int      conv_pos[SSM_MAX_LAYERS];
+} Trace;
+
+static void trace_run(Trace *t, const OosiV3Weights *w, OosiV3Tp *tp, int detach_at) {
+    const int V = w->vocab_size;
+    TestCtx c;
+    ctx_make(&c, w, 0.8f);
+    if (tp) oosi_v3_tp_attach(tp, &c.ctx);
+    int tok = 5;
+    for (int s = 0; s < EQ_TOKENS; s++) {
+        if (s == detach_at) oosi_v3_tp_attach(NULL, &c.ctx);
+        OosiV3HaltResult r = oosi_v3_forward_one(&c.ctx, tok);
+        memcpy(t->logits + (size_t)s * V, c.logits, sizeof(ssm_f32) * (size_t)V);
+        t->tok[s] = r.token;
+        tok = r.token;
+    }
+    memcpy(t->h_state, c.h_state, (size_t)oosi_v3_h_state_bytes(w->n_layer, w->d_inner, w->d_state));
+    memcpy(t->conv_buf, c.conv_buf, (size_t)oosi_v3_conv_buf_bytes(w->n_layer, w->d_inner, w->d_conv));
+    memcpy(t->conv_pos, c.conv_pos, sizeof(int) * (size_t)w->n_layer);
+    ctx_free(&c);
+}
+
+static void trace_alloc(Trace *t, const OosiV3Weights *w) {
+    t->logits = (ssm_f32 *)malloc(sizeof(ssm_f32) * (size_t)w->vocab_size * EQ_TOKENS);
+    t->h_state = (ssm_f32 *)malloc((size_t)oosi_v3_h_state_bytes(w->n_layer, w->d_inner, w->d_state));
+    t->conv_buf = (ssm_f32 *)malloc((size_t)oosi_v3_conv_buf_bytes(w->n_layer, w->d_inner, w->d_conv));
+}
+
+static void trace_free(Trace *t) {
+    free(t->logits);
+    free(t->h_state);
+    free(t->conv_buf);
+}
+
+static int trace_same(const Trace *a, const Trace *b, const OosiV3Weights *w) {
+    return memcmp(a->tok, b->tok, sizeof(a->tok)) == 0 &&
+           memcmp(a->logits, b->logits, sizeof(ssm_f32) * (size_t)w->vocab_size * EQ_TOKENS) == 0 &&
+           memcmp(a->h_state, b->h_state, (size_t)oosi_v3_h_state_bytes(w->n_layer, w->d_inner, w->d_state)) == 0 &&
+           memcmp(a->conv_buf, b->conv_buf, (size_t)oosi_v3_conv_buf_bytes(w->n_layer, w->d_inner, w->d_conv)) == 0 &&
+           memcmp(a->conv_pos, b->conv_pos, sizeof(int) * (size_t)w->n_layer) == 0;
+}
+
+static void test_equivalence(void) {
+    printf("\n[equivalence]\n");
+    TestModel *tm = (TestModel *)malloc(sizeof(TestModel));
+    model_build(tm, 96, 3, 700, 16, 4, 8, 0x1234u);   // d_inner 192, x_proj 40 rows
+    const OosiV3Weights *w = &tm->w;
+    Trace ref, got;
+    trace_alloc(&ref, w);
+    trace_alloc(&got, w);
+    trace_run(&ref, w, NULL, -1);
+
+    int distinct = 0;
+    for (int s = 1; s < EQ_TOKENS; s++) distinct += ref.tok[s] != ref.tok[s - 1];
+    ASSERT_TRUE(distinct > 4, "serial decode samples a varied sequence");
+
+    OosiV3Tp *tp = (OosiV3Tp *)malloc(sizeof(OosiV3Tp));
+    char msg[128];
+
+    // No work queue: the executor runs every range inline
+    oosi_v3_tp_init(tp, NULL, 4);
+    trace_run(&got, w, tp, -1);
+    ASSERT_TRUE(trace_same(&ref, &got, w), "executor without APs == serial");
+
+    for (int ns = 2; ns <= OOSI_V3_TP_MAX_SLICES; ns = (ns < 4) ? ns + 1 : ns * 2) {
+        mc_setup(ns - 1);
+        oosi_v3_tp_init(tp, &g_mc, ns);
+        trace_run(&got, w, tp, -1);
+        snprintf(msg, sizeof(msg), "%2d slices (BSP + %2d APs): logits, tokens, h_state, conv == serial (%llu phases)",
+                 ns, ns - 1, (unsigned long long)tp->phases);
+        ASSERT_TRUE(trace_same(&ref, &got, w) && tp->phases == (uint64_t)EQ_TOKENS * (4 * 3 + 1), msg);
+        mc_teardown(ns - 1);
+    }
+
+    // More slices than workers: cursor rotates, output does not change
+    mc_setup(2);
+    oosi_v3_tp_init(tp, &g_mc, 5);
+    trace_run(&got, w, tp, -1);
+    ASSERT_TRUE(trace_same(&ref, &got, w), "5 slices over 2 APs == serial");
+
+    printf("\n[detach]\n");
+    oosi_v3_tp_init(tp, &g_mc, 3);
+    trace_run(&got, w, tp, EQ_TOKENS / 2);
+    ASSERT_TRUE(trace_same(&ref, &got, w), "detaching mid-sequence continues the same decode");
+    ASSERT_EQ(tp->phases, (EQ_TOKENS / 2) * (4 * 3 + 1), "no phases dispatched after detach");
+    mc_teardown(2);
+
+    free(tp);
+    trace_free(&ref);
+    trace_free(&got);
+    model_free(tm);
+    free(tm);
+}
+
+static void bench_scaling(void) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    enum { B_LAYERS = 4, B_TOKENS = 8 };
+    printf("\n[scaling: d_model 768, d_inner 1536, %d layers, vocab 8192, %ld host CPU(s)]\n", B_LAYERS, ncpu);
+    TestModel *tm = (TestModel *)malloc(sizeof(TestModel));
+    model_build(tm, 768, B_LAYERS, 8192, 16, 4, 48, 0xABCDu);
+    OosiV3Tp *tp = (OosiV3Tp *)malloc(sizeof(OosiV3Tp));
+    double base = 0.0;
+    for (int ns = 1; ns <= OOSI_V3_TP_MAX_SLICES; ns = (ns < 4) ? ns + 1 : ns * 2) {
+        int aps = ns - 1;
+        mc_setup(aps);
+        oosi_v3_tp_init(tp, &g_mc, ns);
+        TestCtx c;
+        ctx_make(&c, &tm->w, 0.0f);
+        oosi_v3_tp_attach(tp, &c.ctx);
+        int tokens = ncpu >= ns ? B_TOKENS : 2;
+        int tok = 3;
+        tok = oosi_v3_forward_one(&c.ctx, tok).token;     // warm-up
+        double t0 = now_ns();
+        for (int i = 0; i < tokens; i++) tok = oosi_v3_forward_one(&c.ctx, tok).token;
+        double s = (now_ns() - t0) / 1e9;
+        double tps = tokens / s;
+        if (ns == 1) base = tps;
+        printf("  slices %2d: %8.1f tok/s  speedup %.2fx  steals %u%s\n", ns, tps, tps / base,
+               oosi_v3_tp_moves(tp), ncpu < ns ? "  (oversubscribed)" : "");
+        ctx_free(&c);
+        mc_teardown(aps);
+    }
+    free(tp);
+    model_free(tm);
+    free(tm);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OOSI v3 Tensor-Parallel Decode — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_slice();
+    test_equivalence();
+    bench_scaling();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All oosi_v3_tp tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
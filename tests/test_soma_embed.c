@@ -0,0 +1,326 @@
+// test_soma_embed.c — Host-mode harness for SomaMind embedding recall
+//
+// Tests:
+//   int8 dot (SSE2 vs scalar reference), quantisation, pooling
+//   flat search: paraphrase (noisy copy) of a stored entry ranks first
+//   centring: a shared component is removed, the first entry is not zeroed,
+//   queries leave scores unchanged, warm-up entries re-centred in place
+//   20k clustered entries: adds never train (maintain does), entries added
+//   while a retrain is due are found, IVF recall@10 vs exact, query latency
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=c11 -O2 -Wall -Wextra -I../engine/ssm
+//       test_soma_embed.c ../engine/ssm/soma_embed.c -o test_soma_embed
+//
+// Run:
+//   ./test_soma_embed
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "soma_embed.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t g_rng = 0x9E3779B9u;
+static float frand(void) {   // uniform [-1, 1)
+    g_rng ^= g_rng << 13; g_rng ^= g_rng >> 17; g_rng ^= g_rng << 5;
+    return (float)(g_rng >> 8) / 8388608.0f - 1.0f;
+}
+
+static void noisy_copy(const float *src, float *dst, float noise) {
+    for (int d = 0; d < SOMA_EMB_DIM; d++) dst[d] = src[d] + noise * frand();
+}
+
+typedef struct {
+    void         *mem;
+    SomaEmbIndex  idx;
+} TestIndex;
+
+static void ti_open(TestIndex *t, uint32_t cap) {
+    uint64_t bytes = soma_emb_index_bytes(cap);
+    t->mem = malloc((size_t)bytes);
+    soma_emb_index_init(&t->idx, t->mem, bytes);
+}
+
+static void ti_close(TestIndex *t) { free(t->mem); }
+
+// ============================================================
+// Test 1: dot product, quantisation, pooling
+// ============================================================
+static void test_primitives(void) {
+    printf("\n[Test 1] dot / quantise / pool\n");
+    int8_t a[SOMA_EMB_DIM], b[SOMA_EMB_DIM];
+    int bad = 0;
+    for (int r = 0; r < 200; r++) {
+        int32_t ref = 0;
+        for (int d = 0; d < SOMA_EMB_DIM; d++) {
+            a[d] = (int8_t)(frand() * 127.0f);
+            b[d] = (int8_t)(frand() * 127.0f);
+            if (r == 0) { a[d] = -127; b[d] = -127; }
+            ref += (int32_t)a[d] * (int32_t)b[d];
+        }
+        if (soma_emb_dot(a, b) != ref) bad++;
+    }
+    ASSERT_EQ(bad, 0, "int8 dot matches scalar reference");
+
+    float v[SOMA_EMB_DIM];
+    for (int d = 0; d < SOMA_EMB_DIM; d++) v[d] = frand() * 40.0f;
+    soma_emb_quantize(v, a);
+    int32_t self = soma_emb_dot(a, a);
+    ASSERT_TRUE(self > SOMA_EMB_ONE * 95 / 100 && self < SOMA_EMB_ONE * 105 / 100,
+                "quantised vector has unit norm (±5%)");
+
+    static SomaEmbPool p;
+    soma_emb_pool_reset(&p, 7);
+    ASSERT_EQ(soma_emb_pool_finish(&p, a), -1, "empty pool refuses to finish");
+
+    // Same hidden states in a different order pool to the same embedding
+    float h[3][7];
+    for (int t = 0; t < 3; t++) for (int i = 0; i < 7; i++) h[t][i] = frand();
+    soma_emb_pool_reset(&p, 7);
+    for (int t = 0; t < 3; t++) soma_emb_pool_add(&p, h[t], 7);
+    soma_emb_pool_finish(&p, a);
+    soma_emb_pool_reset(&p, 7);
+    for (int t = 2; t >= 0; t--) soma_emb_pool_add(&p, h[t], 7);
+    soma_emb_pool_finish(&p, b);
+    ASSERT_TRUE(memcmp(a, b, SOMA_EMB_DIM) == 0, "mean-pool is order independent");
+}
+
+// ============================================================
+// Test 2: flat search finds paraphrases
+// ============================================================
+static void test_flat(void) {
+    printf("\n[Test 2] flat search\n");
+    TestIndex t;
+    ti_open(&t, 512);
+    static float base[300][SOMA_EMB_DIM];
+    int8_t q[SOMA_EMB_DIM];
+    for (int i = 0; i < 300; i++) {
+        for (int d = 0; d < SOMA_EMB_DIM; d++) base[i][d] = frand();
+        soma_emb_quantize(base[i], q);
+        soma_emb_index_add(&t.idx, q, 1000u + (uint32_t)i);
+    }
+    ASSERT_TRUE(!t.idx.ivf_ready, "small index stays flat");
+
+    int top1 = 0;
+    float para[SOMA_EMB_DIM];
+    SomaEmbHit hits[SOMA_EMB_TOPK_MAX];
+    for (int i = 0; i < 300; i++) {
+        noisy_copy(base[i], para, 0.5f);
+        soma_emb_quantize(para, q);
+        int nh = soma_emb_index_search(&t.idx, q, 4, 0, hits);
+        if (nh == 4 && hits[0].id == 1000u + (uint32_t)i) top1++;
+    }
+    ASSERT_EQ(top1, 300, "noisy paraphrase ranks its source first");
+    ASSERT_TRUE(hits[0].score >= hits[1].score && hits[1].score >= hits[2].score,
+                "hits are sorted best first");
+    ti_close(&t);
+}
+
+// ============================================================
+// Test 3: centring on the stored mean
+// ============================================================
+static void test_centering(void) {
+    printf("\n[Test 3] centring\n");
+    TestIndex t;
+    ti_open(&t, 512);
+    // Every text shares a component 3x its own part, as hidden states do
+    static float common[SOMA_EMB_DIM], base[200][SOMA_EMB_DIM];
+    float para[SOMA_EMB_DIM];
+    int8_t q[SOMA_EMB_DIM];
+    SomaEmbHit hits[SOMA_EMB_TOPK_MAX];
+    for (int d = 0; d < SOMA_EMB_DIM; d++) common[d] = 3.0f * frand();
+    for (int i = 0; i < 200; i++)
+        for (int d = 0; d < SOMA_EMB_DIM; d++) base[i][d] = common[d] + frand();
+
+    soma_emb_quantize(base[0], q);
+    soma_emb_index_add(&t.idx, q, 0);
+    noisy_copy(base[0], para, 0.3f);
+    soma_emb_quantize(para, q);
+    int nh = soma_emb_index_search(&t.idx, q, 1, 0, hits);
+    ASSERT_TRUE(nh == 1 && hits[0].id == 0 && hits[0].score > SOMA_EMB_ONE / 2,
+                "first entry is not centred to zero");
+
+    for (int i = 1; i < 200; i++) {
+        soma_emb_quantize(base[i], q);
+        soma_emb_index_add(&t.idx, q, (uint32_t)i);
+    }
+    ASSERT_TRUE(t.idx.center_ready, "mean frozen after warm-up");
+
+    int top1 = 0, unrelated = 0;
+    for (int i = 0; i < 200; i++) {
+        noisy_copy(base[i], para, 0.3f);
+        soma_emb_quantize(para, q);
+        nh = soma_emb_index_search(&t.idx, q, 2, 0, hits);
+        if (nh == 2 && hits[0].id == (uint32_t)i) top1++;
+        if (nh == 2 && hits[1].score < SOMA_EMB_ONE / 2) unrelated++;
+    }
+    ASSERT_EQ(top1, 200, "paraphrase ranks its source first (warm-up entries included)");
+    ASSERT_EQ(unrelated, 200, "shared component removed: unrelated entries score below 0.5");
+
+    noisy_copy(base[7], para, 0.3f);
+    soma_emb_quantize(para, q);
+    SomaEmbHit before[4], after[4];
+    soma_emb_index_search_exact(&t.idx, q, 4, before);
+    int8_t other[SOMA_EMB_DIM];
+    for (int r = 0; r < 500; r++) {
+        for (int d = 0; d < SOMA_EMB_DIM; d++) para[d] = common[d] + 2.0f * frand();
+        soma_emb_quantize(para, other);
+        soma_emb_index_search(&t.idx, other, 4, 0, hits);
+    }
+    soma_emb_index_search_exact(&t.idx, q, 4, after);
+    ASSERT_TRUE(memcmp(before, after, sizeof(before)) == 0, "queries leave the scores unchanged");
+    ti_close(&t);
+}
+
+// ============================================================
+// Test 4: 20k clustered entries — IVF recall and latency
+// ============================================================
+#define BIG_N     20000
+#define CLUSTERS  200
+#define QUERIES   1000
+#define RECALL_K  10
+
+static void test_ivf(void) {
+    printf("\n[Test 4] 20k entries, IVF vs exact\n");
+    TestIndex t;
+    ti_open(&t, BIG_N);
+    static float centers[CLUSTERS][SOMA_EMB_DIM];
+    static float vecs[BIG_N][SOMA_EMB_DIM];
+    for (int c = 0; c < CLUSTERS; c++)
+        for (int d = 0; d < SOMA_EMB_DIM; d++) centers[c][d] = frand();
+    int8_t q[SOMA_EMB_DIM];
+    double t0 = now_ns();
+    for (int i = 0; i < BIG_N; i++) {
+        noisy_copy(centers[i % CLUSTERS], vecs[i], 0.6f);
+        soma_emb_quantize(vecs[i], q);
+        soma_emb_index_add(&t.idx, q, (uint32_t)i);
+    }
+    double t1 = now_ns();
+    ASSERT_EQ(t.idx.n, BIG_N, "20k entries indexed");
+    ASSERT_TRUE(!t.idx.ivf_ready && t.idx.retrains == 0 && t.idx.retrain_due, "adds only flag the training");
+    double t2 = now_ns();
+    ASSERT_EQ(soma_emb_index_maintain(&t.idx), 1, "maintain trains");
+    double t3 = now_ns();
+    ASSERT_TRUE(t.idx.ivf_ready && t.idx.nlist >= SOMA_EMB_NLIST_MIN, "IVF built");
+    ASSERT_EQ(soma_emb_index_maintain(&t.idx), 0, "nothing due after training");
+
+    SomaEmbHit ivf[SOMA_EMB_TOPK_MAX], ref[SOMA_EMB_TOPK_MAX];
+    float para[SOMA_EMB_DIM];
+    int found = 0, total = 0, src_hit = 0;
+    double t_ivf = 0.0, t_ref = 0.0;
+    uint32_t scanned0 = t.idx.total_scanned;
+    for (int r = 0; r < QUERIES; r++) {
+        int src = (int)((uint32_t)(r * 7919) % BIG_N);
+        noisy_copy(vecs[src], para, 0.3f);
+        soma_emb_quantize(para, q);
+
+        double a = now_ns();
+        int ni = soma_emb_index_search(&t.idx, q, RECALL_K, 0, ivf);
+        double b = now_ns();
+        int nr = soma_emb_index_search_exact(&t.idx, q, RECALL_K, ref);
+        double c = now_ns();
+        t_ivf += b - a;
+        t_ref += c - b;
+
+        for (int i = 0; i < nr; i++) {
+            for (int j = 0; j < ni; j++)
+                if (ivf[j].id == ref[i].id) { found++; break; }
+            total++;
+        }
+        for (int j = 0; j < ni; j++)
+            if (ivf[j].id == (uint32_t)src) { src_hit++; break; }
+    }
+    double recall = (double)found / (double)total;
+    double avg_scan = (double)(t.idx.total_scanned - scanned0) / QUERIES;
+    ASSERT_TRUE(recall >= 0.90, "IVF recall@10 vs exact >= 0.90");
+    ASSERT_TRUE(src_hit >= QUERIES * 95 / 100, "source entry in IVF top-10 for >= 95% of paraphrases");
+    ASSERT_TRUE(avg_scan <= SOMA_EMB_SCAN_BUDGET + BIG_N / SOMA_EMB_NLIST_MIN,
+                "scan stays within budget (+ first list)");
+
+    printf("  recall@10: %.3f   add: %.0f ns/op   train: %.1f ms   query: ivf %.1f us (%.0f scanned), exact %.1f us\n",
+           recall, (t1 - t0) / BIG_N, (t3 - t2) / 1e6, t_ivf / QUERIES / 1e3, avg_scan, t_ref / QUERIES / 1e3);
+    ti_close(&t);
+
+    // Doubling flags a retrain; entries added meanwhile join their nearest list
+    ti_open(&t, 4 * SOMA_EMB_FLAT_MAX);
+    for (uint32_t i = 0; i <= SOMA_EMB_FLAT_MAX; i++) {
+        noisy_copy(centers[i % CLUSTERS], para, 0.6f);
+        soma_emb_quantize(para, q);
+        soma_emb_index_add(&t.idx, q, i);
+    }
+    soma_emb_index_maintain(&t.idx);
+    uint32_t trained = t.idx.n, retrains = t.idx.retrains;
+    int found_new = 0;
+    for (uint32_t i = trained; i < 2 * trained; i++) {
+        noisy_copy(centers[i % CLUSTERS], vecs[i - trained], 0.6f);
+        soma_emb_quantize(vecs[i - trained], q);
+        soma_emb_index_add(&t.idx, q, i);
+        if (soma_emb_index_search(&t.idx, q, 1, 0, ivf) == 1 && ivf[0].id == i) found_new++;
+    }
+    ASSERT_TRUE(t.idx.retrain_due && t.idx.retrains == retrains, "doubling flags a retrain, add does not run it");
+    ASSERT_EQ(found_new, (int)trained, "entries added before the retrain are found");
+    ASSERT_EQ(soma_emb_index_maintain(&t.idx), 1, "maintain retrains");
+    ASSERT_TRUE(t.idx.trained_n == 2 * trained && !t.idx.retrain_due, "retrained over every entry");
+    ti_close(&t);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  SomaMind Embedding Recall — Host Test Suite\n");
+    printf("==============================================\n");
+
+    test_primitives();
+    test_flat();
+    test_centering();
+    test_ivf();
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All embedding recall tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
@@ -0,0 +1,523 @@
+// test_soma_journal.c — Host-mode harness for the Soma journal log (soma_jlog)
+//
+// Tests:
+//   record framing + CRC32C rejection
+//   append / group flush / replay across reopen (order, contents, sessions)
+//   segment rolling + compaction into the summary (turn count conserved)
+//   recovery: tail segment truncated at every byte offset, and zero-filled
+//   past every offset; appends after recovery must survive the next replay
+//   crash windows of compaction: torn summary write, segment never deleted
+//   failed write keeps the batch; O(1) append cost vs history length
+//
+// The EFI volume is replaced by an in-memory file table behind SjlIo.
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=c11 -O2 -Wall -Wextra -I../engine/ssm
+//       test_soma_journal.c ../engine/ssm/soma_jlog.c -o test_soma_journal
+//
+// Run:
+//   ./test_soma_journal
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "soma_jlog.h"
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    if ((a) == (b)) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %d, expected %d)\n", msg, (int)(a), (int)(b)); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// ============================================================
+// In-memory volume
+// ============================================================
+#define MEMFS_FILES 64
+#define MEMFS_CAP   (SJL_SEG_BYTES + 4096u)
+
+typedef struct {
+    int           used;
+    uint32_t      id;
+    uint32_t      len;
+    unsigned char data[MEMFS_CAP];
+} MemFile;
+
+typedef struct {
+    MemFile  f[MEMFS_FILES];
+    int      fail_writes;      // next N writes fail without touching data
+    int      skip_removes;     // removes are ignored (crash before delete)
+    uint32_t writes;
+    uint32_t max_write;
+} MemFs;
+
+static MemFile *memfs_find(MemFs *fs, uint32_t id) {
+    for (int i = 0; i < MEMFS_FILES; i++)
+        if (fs->f[i].used && fs->f[i].id == id) return &fs->f[i];
+    return NULL;
+}
+
+static int32_t memfs_read(void *ctx, uint32_t file, void *buf, uint32_t cap) {
+    MemFile *f = memfs_find((MemFs *)ctx, file);
+    if (!f) return -1;
+    uint32_t n = f->len < cap ? f->len : cap;
+    memcpy(buf, f->data, n);
+    return (int32_t)n;
+}
+
+static int memfs_write(void *ctx, uint32_t file, uint32_t pos, const void *buf, uint32_t len) {
+    MemFs *fs = (MemFs *)ctx;
+    if (fs->fail_writes > 0) { fs->fail_writes--; return -1; }
+    MemFile *f = memfs_find(fs, file);
+    if (!f) {
+        for (int i = 0; i < MEMFS_FILES && !f; i++)
+            if (!fs->f[i].used) { f = &fs->f[i]; f->used = 1; f->id = file; f->len = 0; }
+        if (!f) return -1;
+    }
+    if (pos + len > MEMFS_CAP) return -1;
+    if (pos > f->len) memset(f->data + f->len, 0, pos - f->len);
+    memcpy(f->data + pos, buf, len);
+    if (pos + len > f->len) f->len = pos + len;
+    fs->writes++;
+    if (len > fs->max_write) fs->max_write = len;
+    return 0;
+}
+
+static int memfs_remove(void *ctx, uint32_t file) {
+    MemFs *fs = (MemFs *)ctx;
+    if (fs->skip_removes) return 0;
+    MemFile *f = memfs_find(fs, file);
+    if (f) f->used = 0;
+    return 0;
+}
+
+static int memfs_count(const MemFs *fs) {
+    int n = 0;
+    for (int i = 0; i < MEMFS_FILES; i++) n += fs->f[i].used;
+    return n;
+}
+
+static SjlIo memfs_io(MemFs *fs) {
+    SjlIo io = { fs, memfs_read, memfs_write, memfs_remove };
+    return io;
+}
+
+// ============================================================
+// Turn generator + replay collector
+// ============================================================
+static int make_prompt(char *buf, int i) {
+    return sprintf(buf, "prompt %d: %.*s", i, i % 50, "what is the state of the kernel memory arena now??");
+}
+static int make_response(char *buf, int i) {
+    return sprintf(buf, "response %d %.*s", i, (i * 7) % 90,
+                   "the arena is healthy and zone C has room for the journal scratch buffer today ok");
+}
+
+static int append_turn(SjlLog *l, int i, uint32_t session) {
+    char p[128], r[128];
+    SjlTurnHdr t;
+    memset(&t, 0, sizeof(t));
+    t.turn         = i;
+    t.session      = session;
+    t.prompt_hash  = (uint32_t)(i % 5) * 2654435761u;   // five distinct "topics"
+    t.domain       = (uint8_t)(i % 3);
+    t.prompt_len   = (uint8_t)make_prompt(p, i);
+    t.response_len = (uint8_t)make_response(r, i);
+    return sjl_append_turn(l, &t, p, r);
+}
+
+typedef struct {
+    int n;
+    int bad;          // contents mismatch
+    int last_turn;
+} Collect;
+
+static void collect_turn(void *ctx, const SjlTurnHdr *t, const char *prompt, const char *response) {
+    Collect *c = (Collect *)ctx;
+    char p[128], r[128];
+    int pl = make_prompt(p, t->turn);
+    int rl = make_response(r, t->turn);
+    if (c->n && t->turn != c->last_turn + 1) c->bad++;
+    if (t->prompt_len != pl || memcmp(prompt, p, (size_t)pl)) c->bad++;
+    if (t->response_len != rl || memcmp(response, r, (size_t)rl)) c->bad++;
+    c->last_turn = t->turn;
+    c->n++;
+}
+
+static unsigned char *g_scratch;
+
+static int reopen(SjlLog *l, MemFs *fs, Collect *c) {
+    SjlIo io = memfs_io(fs);
+    memset(c, 0, sizeof(*c));
+    return sjl_open(l, &io, g_scratch, SJL_SEG_BYTES, collect_turn, c);
+}
+
+// ============================================================
+// Test 1: framing
+// ============================================================
+static void test_framing(void) {
+    printf("\n[Test 1] Record framing + CRC32C\n");
+    unsigned char buf[256];
+    const char *msg = "hello journal";
+    uint32_t n = sjl_encode(buf, sizeof(buf), SJL_REC_BOOT, 7u, msg, (uint32_t)strlen(msg));
+    ASSERT_EQ(n, sjl_rec_size((uint32_t)strlen(msg)), "encode returns padded size");
+    ASSERT_EQ(n % SJL_ALIGN, 0, "records are 4-byte aligned");
+
+    const SjlRecHdr *h = NULL;
+    const unsigned char *p = NULL;
+    ASSERT_EQ(sjl_decode(buf, n, 0, &h, &p), n, "decode accepts intact record");
+    ASSERT_TRUE(h && h->seq == 7u && h->type == SJL_REC_BOOT &&
+                memcmp(p, msg, strlen(msg)) == 0, "decode returns header + payload");
+
+    int rejected = 0;
+    for (uint32_t i = 0; i < sizeof(SjlRecHdr) + strlen(msg); i++) {
+        buf[i] ^= 0x10;
+        if (!sjl_decode(buf, n, 0, NULL, NULL)) rejected++;
+        buf[i] ^= 0x10;
+    }
+    ASSERT_EQ(rejected, (int)(sizeof(SjlRecHdr) + strlen(msg)), "every single-bit flip is rejected");
+    ASSERT_EQ(sjl_decode(buf, n - 1, 0, NULL, NULL), 0, "short buffer is rejected");
+    ASSERT_EQ(sjl_encode(buf, 8, SJL_REC_BOOT, 1u, msg, 4), 0, "encode refuses short dst");
+}
+
+// ============================================================
+// Test 2: append, group flush, replay
+// ============================================================
+static void test_replay(void) {
+    printf("\n[Test 2] Append / group flush / replay\n");
+    MemFs *fs = calloc(1, sizeof(MemFs));
+    SjlLog *l = calloc(1, sizeof(SjlLog));
+    Collect c;
+
+    ASSERT_EQ(reopen(l, fs, &c), SJL_OK, "open empty volume");
+    ASSERT_EQ(c.n + (int)sjl_total_turns(l), 0, "empty log replays nothing");
+
+    sjl_append_boot(l, 1);
+    int turn = 0;
+    for (; turn < 10; turn++) append_turn(l, turn, 1);
+    ASSERT_EQ(fs->writes, 0u, "appends stay in the batch until flushed");
+    ASSERT_EQ(sjl_flush(l), 11, "flush writes BOOT + 10 turns");
+    ASSERT_EQ(fs->writes, 1u, "group flush is a single write");
+
+    ASSERT_EQ(reopen(l, fs, &c), SJL_OK, "reopen");
+    ASSERT_EQ(c.n, 10, "10 turns replayed");
+    ASSERT_EQ(c.bad, 0, "replayed turns intact and in order");
+    ASSERT_EQ((int)l->boot_count, 1, "boot count restored");
+    ASSERT_EQ((int)l->torn, 0, "clean log has no torn segment");
+
+    // Second session appends behind the first
+    sjl_append_boot(l, 2);
+    for (; turn < 25; turn++) append_turn(l, turn, 2);
+    sjl_flush(l);
+    ASSERT_EQ(reopen(l, fs, &c), SJL_OK, "reopen after second session");
+    ASSERT_EQ(c.n, 25, "both sessions replayed");
+    ASSERT_EQ(c.bad, 0, "sessions joined without gaps");
+    ASSERT_EQ((int)l->boot_count, 2, "boot count = newest session");
+    ASSERT_EQ(memfs_count(fs), 1, "still a single segment file");
+
+    free(l);
+    free(fs);
+}
+
+// ============================================================
+// Test 3: rolling + compaction
+// ============================================================
+static void test_compaction(void) {
+    printf("\n[Test 3] Segment rolling + compaction\n");
+    MemFs *fs = calloc(1, sizeof(MemFs));
+    SjlLog *l = calloc(1, sizeof(SjlLog));
+    Collect c;
+    reopen(l, fs, &c);
+
+    const int total = 4000;   // ~ 1 MB of turns, > 10 segments
+    for (int i = 0; i < total; i++) {
+        append_turn(l, i, 1u + (uint32_t)(i / 1000));
+        if ((i & 3) == 3 && sjl_flush(l) > 0) sjl_compact_step(l, 3);
+    }
+    sjl_flush(l);
+    while (sjl_compact_step(l, 3) > 0) {}
+
+    ASSERT_TRUE(l->compactions > 0, "compaction ran");
+    ASSERT_EQ((int)(l->seg_tail - l->seg_first), 3, "3 sealed raw segments kept");
+    ASSERT_EQ((int)sjl_total_turns(l), total, "summary + raw = all turns");
+    ASSERT_TRUE(memfs_count(fs) <= 3 + 1 + 2, "compacted segments deleted");
+
+    uint32_t sum_turns = l->sum.turns;
+    ASSERT_EQ(reopen(l, fs, &c), SJL_OK, "reopen compacted log");
+    ASSERT_EQ((int)sjl_total_turns(l), total, "turn count conserved across reopen");
+    ASSERT_EQ((int)l->sum.turns, (int)sum_turns, "summary restored from newest slot");
+    ASSERT_EQ(c.n, total - (int)sum_turns, "only raw turns replayed");
+    ASSERT_EQ(c.bad, 0, "raw tail continues where the summary ends");
+    ASSERT_EQ(c.last_turn, total - 1, "newest turn replayed last");
+    ASSERT_EQ((int)l->sum.boot_first, 1, "summary covers first session");
+    ASSERT_TRUE(l->sum.boot_last >= 3, "summary covers later sessions");
+
+    uint32_t dom = 0;
+    for (int d = 0; d < SJL_DOMAINS; d++) dom += l->sum.domain[d];
+    ASSERT_EQ((int)dom, (int)sum_turns, "domain histogram sums to summarized turns");
+
+    int hot_found = 0;
+    for (int h = 0; h < SJL_HOT; h++)
+        if (l->sum.hot[h].hash == 2654435761u && l->sum.hot[h].count > 0) hot_found = 1;
+    ASSERT_TRUE(hot_found, "frequent prompt kept in the hot list");
+
+    free(l);
+    free(fs);
+}
+
+// ============================================================
+// Test 4: truncation at every byte offset
+// ============================================================
+static void test_truncation(void) {
+    printf("\n[Test 4] Tail truncated / zero-filled at every byte offset\n");
+    MemFs *base = calloc(1, sizeof(MemFs));
+    MemFs *fs = calloc(1, sizeof(MemFs));
+    SjlLog *l = calloc(1, sizeof(SjlLog));
+    Collect c;
+
+    // Two sessions, several group flushes in one segment
+    reopen(l, base, &c);
+    sjl_append_boot(l, 1);
+    for (int i = 0; i < 24; i++) {
+        append_turn(l, i, 1);
+        if ((i & 3) == 3) sjl_flush(l);
+    }
+    sjl_append_boot(l, 2);
+    for (int i = 24; i < 30; i++) append_turn(l, i, 2);
+    sjl_flush(l);
+
+    MemFile *seg = memfs_find(base, 0);
+    uint32_t full = seg->len;
+
+    // Expected replay for each prefix: TURN records that end inside it
+    uint32_t ends[256];
+    int is_turn[256], nrec = 0;
+    uint32_t off = 0;
+    while (off < full && nrec < 256) {
+        const SjlRecHdr *h;
+        uint32_t sz = sjl_decode(seg->data, full, off, &h, NULL);
+        if (!sz) break;
+        off += sz;
+        ends[nrec] = off;
+        is_turn[nrec++] = (h->type == SJL_REC_TURN);
+    }
+    ASSERT_EQ(off, full, "reference segment decodes end to end");
+
+    int mode_fail[2] = { 0, 0 }, resume_fail[2] = { 0, 0 }, torn_seen[2] = { 0, 0 };
+    for (int mode = 0; mode < 2; mode++) {
+        for (uint32_t cut = 0; cut <= full; cut++) {
+            memcpy(fs, base, sizeof(MemFs));
+            MemFile *f = memfs_find(fs, 0);
+            if (mode == 0) {
+                f->len = cut;                                  // truncated file
+            } else {
+                memset(f->data + cut, 0, full - cut);          // torn: zeros past cut
+            }
+
+            // A record survives if it ends before the cut, or (zero fill)
+            // if every byte past the cut was already zero (padding, reserved)
+            int expect = 0;
+            for (int r = 0; r < nrec; r++) {
+                int whole = ends[r] <= cut;
+                if (!whole && mode == 1) {
+                    whole = 1;
+                    for (uint32_t b = cut; b < ends[r]; b++) if (seg->data[b]) { whole = 0; break; }
+                }
+                if (!whole) break;
+                expect += is_turn[r];
+            }
+
+            reopen(l, fs, &c);
+            if (c.n != expect || c.bad || (int)sjl_total_turns(l) != expect) mode_fail[mode]++;
+            if (l->torn) torn_seen[mode]++;
+
+            // Keep writing after recovery: the new turns must follow on
+            for (int i = expect; i < expect + 5; i++) append_turn(l, i, 3);
+            sjl_flush(l);
+            reopen(l, fs, &c);
+            if (c.n != expect + 5 || c.bad || (int)l->boot_count < 1 + (expect > 0)) resume_fail[mode]++;
+        }
+    }
+    ASSERT_EQ(mode_fail[0], 0, "truncated tail: replay stops at last whole record");
+    ASSERT_EQ(resume_fail[0], 0, "truncated tail: later appends replay intact");
+    ASSERT_EQ(mode_fail[1], 0, "zero-filled tail: replay stops at last whole record");
+    ASSERT_EQ(resume_fail[1], 0, "zero-filled tail: later appends replay intact");
+    ASSERT_TRUE(torn_seen[0] > 0 && torn_seen[1] > 0, "torn tails were detected");
+    printf("    %u byte offsets x 2 fault modes\n", full + 1);
+
+    // Corruption in the middle: everything before survives
+    memcpy(fs, base, sizeof(MemFs));
+    memfs_find(fs, 0)->data[ends[10] + 20] ^= 0x01;
+    reopen(l, fs, &c);
+    int before = 0;
+    for (int r = 0; r <= 10; r++) before += is_turn[r];
+    ASSERT_EQ(c.n, before, "bit flip mid-segment: prefix replayed");
+
+    free(l);
+    free(fs);
+    free(base);
+}
+
+// ============================================================
+// Test 5: compaction crash windows
+// ============================================================
+static void test_compaction_crash(void) {
+    printf("\n[Test 5] Compaction crash windows\n");
+    MemFs *base = calloc(1, sizeof(MemFs));
+    MemFs *fs = calloc(1, sizeof(MemFs));
+    SjlLog *l = calloc(1, sizeof(SjlLog));
+    Collect c;
+
+    // Build 4 sealed segments + a compacted summary (gen 1)
+    reopen(l, base, &c);
+    int total = 0;
+    while (l->seg_tail < 4) { append_turn(l, total++, 1); if ((total & 3) == 0) sjl_flush(l); }
+    sjl_flush(l);
+    sjl_compact_step(l, 2);
+    ASSERT_EQ((int)l->sum.gen, 1, "first compaction wrote gen 1");
+
+    // (a) torn summary write for gen 2, at every byte offset: gen 1 + raw segment survive
+    memcpy(fs, base, sizeof(MemFs));
+    reopen(l, fs, &c);
+    memcpy(base, fs, sizeof(MemFs));
+    uint32_t sum_size = sjl_rec_size(sizeof(SjlSummary));
+    int torn_fail = 0;
+    for (uint32_t cut = 0; cut < sum_size; cut++) {
+        memcpy(fs, base, sizeof(MemFs));
+        reopen(l, fs, &c);
+        fs->skip_removes = 1;          // power lost right after the summary write
+        sjl_compact_step(l, 1);
+        fs->skip_removes = 0;
+        MemFile *slot = memfs_find(fs, SJL_FILE_SUM_A);   // gen 2 → slot A
+        if (!slot) { torn_fail++; continue; }
+        slot->len = cut;
+        reopen(l, fs, &c);
+        if ((int)sjl_total_turns(l) != total || l->sum.gen != 1u || c.bad) torn_fail++;
+    }
+    ASSERT_EQ(torn_fail, 0, "torn summary at every offset falls back to previous generation");
+
+    // (b) summary durable, segment delete lost: replay skips and removes it
+    memcpy(fs, base, sizeof(MemFs));
+    reopen(l, fs, &c);
+    uint32_t victim = l->seg_first;
+    fs->skip_removes = 1;
+    sjl_compact_step(l, 1);
+    fs->skip_removes = 0;
+    ASSERT_TRUE(memfs_find(fs, victim) != NULL, "crash left the compacted segment behind");
+    reopen(l, fs, &c);
+    ASSERT_EQ((int)sjl_total_turns(l), total, "no turn counted twice");
+    ASSERT_EQ(c.bad, 0, "raw replay starts after the summary");
+    ASSERT_TRUE(memfs_find(fs, victim) == NULL, "leftover segment deleted at open");
+
+    // Clear removes everything
+    sjl_clear(l);
+    ASSERT_EQ(memfs_count(fs), 0, "clear deletes every journal file");
+    reopen(l, fs, &c);
+    ASSERT_EQ((int)sjl_total_turns(l), 0, "cleared log replays empty");
+
+    free(l);
+    free(fs);
+    free(base);
+}
+
+// ============================================================
+// Test 6: write errors + append cost
+// ============================================================
+static void test_io_errors_and_cost(void) {
+    printf("\n[Test 6] Failed writes + O(1) append\n");
+    MemFs *fs = calloc(1, sizeof(MemFs));
+    SjlLog *l = calloc(1, sizeof(SjlLog));
+    Collect c;
+    reopen(l, fs, &c);
+
+    for (int i = 0; i < 4; i++) append_turn(l, i, 1);
+    fs->fail_writes = 1;
+    ASSERT_EQ(sjl_flush(l), SJL_ERR_IO, "failed write reported");
+    ASSERT_EQ((int)l->batch_turns, 4, "batch kept after failure");
+    ASSERT_EQ(sjl_flush(l), 4, "retry flushes the batch");
+    reopen(l, fs, &c);
+    ASSERT_EQ(c.n, 4, "retried batch replays once");
+
+    // Append + group flush cost must not grow with history
+    double t_first = 0, t_last = 0;
+    uint32_t max_write = 0;
+    int turn = 4;
+    for (int round = 0; round < 2; round++) {
+        double t0 = now_ns();
+        for (int i = 0; i < 20000; i++) {
+            append_turn(l, turn++, 1);
+            if ((turn & 3) == 0 && sjl_flush(l) > 0) sjl_compact_step(l, 8);
+        }
+        double dt = (now_ns() - t0) / 20000.0;
+        if (round == 0) t_first = dt; else t_last = dt;
+        if (round == 0) fs->max_write = 0;
+        max_write = fs->max_write;
+    }
+    printf("    append+flush: %.0f ns/turn at 20k turns, %.0f ns/turn at 40k turns\n",
+           t_first, t_last);
+    ASSERT_TRUE(max_write <= SJL_SEG_HDR_BYTES + SJL_BATCH_BYTES, "each flush writes one bounded batch");
+    ASSERT_TRUE(t_last < t_first * 3.0 + 500.0, "append cost flat as history grows");
+    ASSERT_EQ((int)sjl_total_turns(l), turn, "40k turns accounted for");
+    reopen(l, fs, &c);
+    ASSERT_EQ((int)sjl_total_turns(l), turn, "40k turns after reopen");
+    ASSERT_TRUE((int)(l->seg_tail - l->seg_first) <= 9, "raw segments bounded by compaction");
+
+    free(l);
+    free(fs);
+}
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  Soma Journal Log — Host Test Suite\n");
+    printf("==============================================\n");
+
+    g_scratch = malloc(SJL_SEG_BYTES);
+
+    test_framing();
+    test_replay();
+    test_compaction();
+    test_truncation();
+    test_compaction_crash();
+    test_io_errors_and_cost();
+
+    free(g_scratch);
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All soma journal tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}
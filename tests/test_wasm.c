@@ -0,0 +1,607 @@
+// test_wasm.c — Host-mode harness for the OO WASM loader + interpreter
+//
+// Tests:
+//   integer semantics (wrap, div/rem traps, shifts, rotates, bit counts)
+//   control flow (block/loop/if results, br/br_if/br_table, early return)
+//   linear memory (offsets, sign-extending loads, bounds trap), globals
+//   calls + recursion, call-depth trap, load-time validation rejects
+//   benchmarks: loop sum, fib(27), sieve — ns per WASM instruction
+//
+// Modules are assembled in-process (no wat2wasm needed).
+//
+// Build (Linux/Windows, host, no UEFI):
+//   gcc -std=gnu11 -O2 -Wall -Wextra -I../engine/wasm -I../engine/ssm
+//       test_wasm.c ../engine/wasm/oo_wasm.c -o test_wasm
+//
+// Run:
+//   ./test_wasm
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "oo_wasm.h"
+
+void *oo_wasm_host_alloc(UINTN n) { return malloc(n); }
+void  oo_wasm_host_free(void *p)  { free(p); }
+
+// ============================================================
+// Test harness helpers
+// ============================================================
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a, b, msg) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ == b_) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s (got %lld, expected %lld)\n", msg, a_, b_); \
+        tests_failed++; \
+    } \
+} while(0)
+
+#define ASSERT_TRUE(cond, msg) do { \
+    if (cond) { \
+        printf("  PASS: %s\n", msg); tests_passed++; \
+    } else { \
+        printf("  FAIL: %s\n", msg); tests_failed++; \
+    } \
+} while(0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// ============================================================
+// Tiny module assembler
+// ============================================================
+#define I32 0x7F
+#define I64 0x7E
+
+typedef struct { uint8_t b[8192]; int n; } Buf;
+
+static void put(Buf *o, uint8_t v) { o->b[o->n++] = v; }
+static void putn(Buf *o, const uint8_t *p, int n) { memcpy(o->b + o->n, p, (size_t)n); o->n += n; }
+static void uleb(Buf *o, uint32_t v) {
+    do { uint8_t c = v & 0x7F; v >>= 7; if (v) c |= 0x80; put(o, c); } while (v);
+}
+static void sleb(Buf *o, int64_t v) {
+    for (;;) {
+        uint8_t c = v & 0x7F; v >>= 7;
+        if ((v == 0 && !(c & 0x40)) || (v == -1 && (c & 0x40))) { put(o, c); return; }
+        put(o, c | 0x80);
+    }
+}
+
+typedef struct {
+    const char *name;
+    uint8_t params[8]; int np;
+    uint8_t result;            // 0 = none
+    int     locals;            // extra i64 locals
+    Buf     code;              // body without trailing end
+} Fn;
+
+typedef struct {
+    Fn  fn[16]; int nfn;
+    int memory;
+    int64_t globals[8]; uint8_t gtype[8]; int nglob;
+    uint32_t data_addr; const char *data;
+} Mod;
+
+static void section(Buf *o, int id, Buf *s) { put(o, (uint8_t)id); uleb(o, (uint32_t)s->n); putn(o, s->b, s->n); }
+
+static Buf g_out;
+static Buf *assemble(Mod *m) {
+    static Buf s;
+    Buf *o = &g_out;
+    o->n = 0;
+    putn(o, (const uint8_t *)"\0asm\1\0\0\0", 8);
+
+    s.n = 0; uleb(&s, (uint32_t)m->nfn);                    // one type per function
+    for (int i = 0; i < m->nfn; i++) {
+        put(&s, 0x60); uleb(&s, (uint32_t)m->fn[i].np); putn(&s, m->fn[i].params, m->fn[i].np);
+        if (m->fn[i].result) { uleb(&s, 1); put(&s, m->fn[i].result); } else uleb(&s, 0);
+    }
+    section(o, 1, &s);
+
+    s.n = 0; uleb(&s, (uint32_t)m->nfn);
+    for (int i = 0; i < m->nfn; i++) uleb(&s, (uint32_t)i);
+    section(o, 3, &s);
+
+    if (m->memory) { s.n = 0; uleb(&s, 1); put(&s, 0); uleb(&s, 1); section(o, 5, &s); }
+
+    if (m->nglob) {
+        s.n = 0; uleb(&s, (uint32_t)m->nglob);
+        for (int i = 0; i < m->nglob; i++) {
+            put(&s, m->gtype[i]); put(&s, 1);
+            put(&s, m->gtype[i] == I32 ? 0x41 : 0x42); sleb(&s, m->globals[i]); put(&s, 0x0B);
+        }
+        section(o, 6, &s);
+    }
+
+    s.n = 0;
+    int nexp = 0;
+    for (int i = 0; i < m->nfn; i++) if (m->fn[i].name) nexp++;
+    uleb(&s, (uint32_t)nexp);
+    for (int i = 0; i < m->nfn; i++) {
+        if (!m->fn[i].name) continue;
+        uleb(&s, (uint32_t)strlen(m->fn[i].name)); putn(&s, (const uint8_t *)m->fn[i].name, (int)strlen(m->fn[i].name));
+        put(&s, 0); uleb(&s, (uint32_t)i);
+    }
+    section(o, 7, &s);
+
+    s.n = 0; uleb(&s, (uint32_t)m->nfn);
+    for (int i = 0; i < m->nfn; i++) {
+        static Buf body;
+        body.n = 0;
+        if (m->fn[i].locals) { uleb(&body, 1); uleb(&body, (uint32_t)m->fn[i].locals); put(&body, I64); }
+        else uleb(&body, 0);
+        putn(&body, m->fn[i].code.b, m->fn[i].code.n);
+        put(&body, 0x0B);
+        uleb(&s, (uint32_t)body.n); putn(&s, body.b, body.n);
+    }
+    section(o, 10, &s);
+
+    if (m->data) {
+        s.n = 0; uleb(&s, 1); uleb(&s, 0);
+        put(&s, 0x41); sleb(&s, m->data_addr); put(&s, 0x0B);
+        uleb(&s, (uint32_t)strlen(m->data)); putn(&s, (const uint8_t *)m->data, (int)strlen(m->data));
+        section(o, 11, &s);
+    }
+    return o;
+}
+
+// Function builder: raw opcode bytes, immediates LEB-encoded by the helpers.
+static Fn *fn_new(Mod *m, const char *name, int np, uint8_t pt, uint8_t result) {
+    Fn *f = &m->fn[m->nfn++];
+    memset(f, 0, sizeof(*f));
+    f->name = name; f->np = np; f->result = result;
+    for (int i = 0; i < np; i++) f->params[i] = pt;
+    return f;
+}
+static void op(Fn *f, uint8_t b) { put(&f->code, b); }
+static void op_u(Fn *f, uint8_t b, uint32_t imm) { put(&f->code, b); uleb(&f->code, imm); }
+static void i32c(Fn *f, int32_t v) { put(&f->code, 0x41); sleb(&f->code, v); }
+static void i64c(Fn *f, int64_t v) { put(&f->code, 0x42); sleb(&f->code, v); }
+static void get(Fn *f, uint32_t l) { op_u(f, 0x20, l); }
+static void set(Fn *f, uint32_t l) { op_u(f, 0x21, l); }
+static void mem(Fn *f, uint8_t b, uint32_t off) { put(&f->code, b); uleb(&f->code, 0); uleb(&f->code, off); }
+
+static OoWasmMod g_mod;
+
+static int load(Mod *m) {
+    Buf *o = assemble(m);
+    oo_wasm_unload(&g_mod);
+    EFI_STATUS st = oo_wasm_load_buf(&g_mod, o->b, (UINTN)o->n);
+    if (EFI_ERROR(st)) printf("    load error: %s\n", (const char *)g_mod.error);
+    return !EFI_ERROR(st);
+}
+
+static EFI_STATUS call32(const char *name, int32_t a, int32_t b, int nargs, int32_t *r) {
+    INT32 args[2] = { a, b };
+    *r = 0;
+    return oo_wasm_call_i32(&g_mod, (const CHAR8 *)name, args, (UINT32)nargs, r);
+}
+
+static EFI_STATUS call64(const char *name, int64_t a, int64_t b, int nargs, int64_t *r) {
+    OoWasmVal args[2], ret;
+    args[0].type = OO_WASM_I64; args[0].i64 = a;
+    args[1].type = OO_WASM_I64; args[1].i64 = b;
+    EFI_STATUS st = oo_wasm_call(&g_mod, (const CHAR8 *)name, args, (UINT32)nargs, &ret);
+    *r = ret.i64;
+    return st;
+}
+
+// Binary i32 op module: f(a, b) = a <op> b
+static int32_t bin32(uint8_t o, int32_t a, int32_t b, EFI_STATUS *st) {
+    static Mod m; memset(&m, 0, sizeof(m));
+    Fn *f = fn_new(&m, "f", 2, I32, I32);
+    get(f, 0); get(f, 1); op(f, o);
+    if (!load(&m)) { *st = EFI_INVALID_PARAMETER; return 0; }
+    int32_t r; *st = call32("f", a, b, 2, &r);
+    return r;
+}
+
+static int64_t bin64(uint8_t o, int64_t a, int64_t b, EFI_STATUS *st) {
+    static Mod m; memset(&m, 0, sizeof(m));
+    Fn *f = fn_new(&m, "f", 2, I64, I64);
+    get(f, 0); get(f, 1); op(f, o);
+    if (!load(&m)) { *st = EFI_INVALID_PARAMETER; return 0; }
+    int64_t r; *st = call64("f", a, b, 2, &r);
+    return r;
+}
+
+static int32_t un32(uint8_t o, int32_t a) {
+    static Mod m; memset(&m, 0, sizeof(m));
+    Fn *f = fn_new(&m, "f", 1, I32, I32);
+    get(f, 0); op(f, o);
+    if (!load(&m)) return -12345;
+    int32_t r; call32("f", a, 0, 1, &r);
+    return r;
+}
+
+// ============================================================
+// Test 1: integer semantics
+// ============================================================
+static void test_integer(void) {
+    printf("\n[Test 1] integer semantics\n");
+    EFI_STATUS st;
+    ASSERT_EQ(bin32(0x6A, 0x7FFFFFFF, 1, &st), INT32_MIN, "i32.add wraps");
+    ASSERT_EQ(bin32(0x6B, 0, 1, &st), -1, "i32.sub");
+    ASSERT_EQ(bin32(0x6C, 0x10000, 0x10000, &st), 0, "i32.mul wraps");
+    ASSERT_EQ(bin32(0x6D, -7, 2, &st), -3, "i32.div_s truncates toward zero");
+    ASSERT_EQ(bin32(0x6E, -7, 2, &st), 0x7FFFFFFC, "i32.div_u");
+    ASSERT_EQ(bin32(0x6F, -7, 2, &st), -1, "i32.rem_s sign follows dividend");
+    ASSERT_EQ(bin32(0x6F, INT32_MIN, -1, &st), 0, "i32.rem_s INT_MIN % -1 = 0");
+    ASSERT_TRUE(st == EFI_SUCCESS, "  ... without trapping");
+    bin32(0x6D, 1, 0, &st);
+    ASSERT_TRUE(st == EFI_ABORTED, "i32.div_s by zero traps");
+    bin32(0x6D, INT32_MIN, -1, &st);
+    ASSERT_TRUE(st == EFI_ABORTED, "i32.div_s INT_MIN / -1 traps");
+    bin32(0x70, 1, 0, &st);
+    ASSERT_TRUE(st == EFI_ABORTED, "i32.rem_u by zero traps");
+    ASSERT_EQ(bin32(0x74, 1, 33, &st), 2, "i32.shl masks count");
+    ASSERT_EQ(bin32(0x75, -16, 2, &st), -4, "i32.shr_s");
+    ASSERT_EQ(bin32(0x76, -16, 28, &st), 15, "i32.shr_u");
+    ASSERT_EQ(bin32(0x77, (int32_t)0x80000001u, 1, &st), 3, "i32.rotl");
+    ASSERT_EQ(bin32(0x78, 1, 1, &st), INT32_MIN, "i32.rotr");
+    ASSERT_EQ(bin32(0x48, -1, 0, &st), 1, "i32.lt_s");
+    ASSERT_EQ(bin32(0x49, -1, 0, &st), 0, "i32.lt_u");
+    ASSERT_EQ(un32(0x67, 0), 32, "i32.clz(0)");
+    ASSERT_EQ(un32(0x67, 1), 31, "i32.clz(1)");
+    ASSERT_EQ(un32(0x68, 0x80), 7, "i32.ctz");
+    ASSERT_EQ(un32(0x69, -1), 32, "i32.popcnt");
+    ASSERT_EQ(un32(0x45, 0), 1, "i32.eqz");
+    ASSERT_EQ(un32(0xC0, 0x80), -128, "i32.extend8_s");
+    ASSERT_EQ(un32(0xC1, 0x8000), -32768, "i32.extend16_s");
+
+    ASSERT_EQ(bin64(0x7C, INT64_MAX, 1, &st), INT64_MIN, "i64.add wraps");
+    ASSERT_EQ(bin64(0x7E, 0x100000000LL, 0x100000000LL, &st), 0, "i64.mul wraps");
+    ASSERT_EQ(bin64(0x7F, -9, 2, &st), -4, "i64.div_s");
+    ASSERT_EQ(bin64(0x81, INT64_MIN, -1, &st), 0, "i64.rem_s INT_MIN % -1 = 0");
+    bin64(0x7F, INT64_MIN, -1, &st);
+    ASSERT_TRUE(st == EFI_ABORTED, "i64.div_s overflow traps");
+    ASSERT_EQ(bin64(0x86, 1, 65, &st), 2, "i64.shl masks count");
+    ASSERT_EQ(bin64(0x89, INT64_MIN, 1, &st), 1, "i64.rotl");
+    ASSERT_EQ(bin64(0x8A, 1, 1, &st), INT64_MIN, "i64.rotr");
+    ASSERT_EQ(bin64(0x53, -1, 0, &st), 1, "i64.lt_s");
+    ASSERT_EQ(bin64(0x54, -1, 0, &st), 0, "i64.lt_u");
+
+    // wrap / extend round trip: (i64.extend_i32_s (i32.wrap_i64 x))
+    static Mod m; memset(&m, 0, sizeof(m));
+    Fn *f = fn_new(&m, "f", 1, I64, I64);
+    get(f, 0); op(f, 0xA7); op(f, 0xAC);
+    Fn *g = fn_new(&m, "g", 1, I64, I64);
+    get(g, 0); op(g, 0xA7); op(g, 0xAD);
+    Fn *h = fn_new(&m, "h", 0, 0, I64);
+    i64c(h, 0x123456789ABCDEF0LL);
+    if (load(&m)) {
+        int64_t r;
+        call64("f", 0x1FFFFFFFFLL, 0, 1, &r);
+        ASSERT_EQ(r, -1, "wrap + extend_s");
+        call64("g", 0x1FFFFFFFFLL, 0, 1, &r);
+        ASSERT_EQ(r, 0xFFFFFFFFLL, "wrap + extend_u");
+        call64("h", 0, 0, 0, &r);
+        ASSERT_EQ(r, 0x123456789ABCDEF0LL, "i64.const full width");
+    } else tests_failed++;
+}
+
+// ============================================================
+// Test 2: control flow
+// ============================================================
+static void test_control(void) {
+    printf("\n[Test 2] control flow\n");
+    static Mod m; memset(&m, 0, sizeof(m));
+    int32_t r;
+
+    // blk(x): (block (result i32) (i32.const 1) (br_if 0 (get 0)) drop (i32.const 2))
+    Fn *f = fn_new(&m, "blk", 1, I32, I32);
+    op(f, 0x02); op(f, I32); i32c(f, 1); get(f, 0); op_u(f, 0x0D, 0); op(f, 0x1A); i32c(f, 2); op(f, 0x0B);
+
+    // nest(x): value carried out of two blocks with extra junk on the stack
+    // (block (result i32) (i32.const 9) (block (i32.const 7) (i32.const 5) (br 1)) ...)
+    f = fn_new(&m, "nest", 1, I32, I32);
+    op(f, 0x02); op(f, I32);
+      i32c(f, 9);
+      op(f, 0x02); op(f, 0x40); i32c(f, 7); i32c(f, 5); op_u(f, 0x0C, 1); op(f, 0x0B);
+      op(f, 0x1A); i32c(f, 0);
+    op(f, 0x0B);
+    get(f, 0); op(f, 0x6A);
+
+    // sw(x): br_table → 10/20/30(default)
+    f = fn_new(&m, "sw", 1, I32, I32);
+    op(f, 0x02); op(f, 0x40);
+      op(f, 0x02); op(f, 0x40);
+        op(f, 0x02); op(f, 0x40);
+          get(f, 0); op_u(f, 0x0E, 2); uleb(&f->code, 0); uleb(&f->code, 1); uleb(&f->code, 2);
+        op(f, 0x0B);
+        i32c(f, 10); op(f, 0x0F);
+      op(f, 0x0B);
+      i32c(f, 20); op(f, 0x0F);
+    op(f, 0x0B);
+    i32c(f, 30);
+
+    // tri(n): loop sum 1..n
+    f = fn_new(&m, "tri", 1, I32, I32);
+    f->locals = 1;   // local 1 (i64 slot used as i32 acc — untyped slots)
+    op(f, 0x03); op(f, 0x40);
+      get(f, 1); get(f, 0); op(f, 0x6A); set(f, 1);
+      get(f, 0); i32c(f, 1); op(f, 0x6B); op_u(f, 0x22, 0);
+      op_u(f, 0x0D, 0);
+    op(f, 0x0B);
+    get(f, 1);
+
+    // sel(x): if/else with result, select, early return from a loop
+    f = fn_new(&m, "sel", 1, I32, I32);
+    get(f, 0); i32c(f, 100); op(f, 0x4A);           // x > 100 ?
+    op(f, 0x04); op(f, I32);
+      i32c(f, 1);
+    op(f, 0x05);
+      op(f, 0x03); op(f, 0x40);
+        get(f, 0); i32c(f, 5); op(f, 0x46);
+        op(f, 0x04); op(f, 0x40); i32c(f, 55); op(f, 0x0F); op(f, 0x0B);
+        i32c(f, 11); i32c(f, 22); get(f, 0); op(f, 0x1B);   // select(11, 22, x)
+        op(f, 0x0F);
+      op(f, 0x0B);
+      i32c(f, 0);
+    op(f, 0x0B);
+
+    // brf(x): br_if straight to the function label
+    f = fn_new(&m, "brf", 1, I32, I32);
+    i32c(f, 42); get(f, 0); op_u(f, 0x0D, 0); op(f, 0x1A); i32c(f, 7);
+
+    // vbr / vret: br and return with arity 0 on an empty operand stack
+    f = fn_new(&m, "vbr", 0, 0, 0);
+    op(f, 0x02); op(f, 0x40); op_u(f, 0x0C, 0); op(f, 0x0B); op_u(f, 0x0C, 0);
+    f = fn_new(&m, "vret", 0, 0, 0);
+    op(f, 0x0F);
+
+    // trap: unreachable inside a block
+    f = fn_new(&m, "trap", 0, 0, 0);
+    op(f, 0x02); op(f, 0x40); op(f, 0x00); op(f, 0x0B);
+
+    if (!load(&m)) { tests_failed++; return; }
+    call32("blk", 1, 0, 1, &r);  ASSERT_EQ(r, 1, "br_if carries block result");
+    call32("blk", 0, 0, 1, &r);  ASSERT_EQ(r, 2, "br_if falls through");
+    call32("nest", 3, 0, 1, &r); ASSERT_EQ(r, 8, "br 1 drops extra operands, keeps value");
+    call32("sw", 0, 0, 1, &r);   ASSERT_EQ(r, 10, "br_table case 0");
+    call32("sw", 1, 0, 1, &r);   ASSERT_EQ(r, 20, "br_table case 1");
+    call32("sw", 2, 0, 1, &r);   ASSERT_EQ(r, 30, "br_table case 2");
+    call32("sw", 99, 0, 1, &r);  ASSERT_EQ(r, 30, "br_table default");
+    call32("tri", 100, 0, 1, &r); ASSERT_EQ(r, 5050, "loop sum 1..100");
+    call32("sel", 200, 0, 1, &r); ASSERT_EQ(r, 1, "if branch result");
+    call32("sel", 5, 0, 1, &r);  ASSERT_EQ(r, 55, "return from nested if in loop");
+    call32("sel", 0, 0, 1, &r);  ASSERT_EQ(r, 22, "select false");
+    call32("sel", 3, 0, 1, &r);  ASSERT_EQ(r, 11, "select true");
+    call32("brf", 1, 0, 1, &r);  ASSERT_EQ(r, 42, "br_if to function label returns");
+    call32("brf", 0, 0, 1, &r);  ASSERT_EQ(r, 7, "br_if to function label falls through");
+    ASSERT_TRUE(call32("vbr", 0, 0, 0, &r) == EFI_SUCCESS, "br with arity 0 on an empty stack");
+    ASSERT_TRUE(call32("vret", 0, 0, 0, &r) == EFI_SUCCESS, "return with arity 0 on an empty stack");
+    EFI_STATUS st = call32("trap", 0, 0, 0, &r);
+    ASSERT_TRUE(st == EFI_ABORTED && strcmp((const char *)g_mod.error, "unreachable") == 0,
+                "unreachable traps with reason");
+    ASSERT_TRUE(call32("nope", 0, 0, 0, &r) == EFI_NOT_FOUND, "missing export → NOT_FOUND");
+}
+
+// ============================================================
+// Test 3: memory + globals
+// ============================================================
+static void test_memory(void) {
+    printf("\n[Test 3] memory / globals\n");
+    static Mod m; memset(&m, 0, sizeof(m));
+    m.memory = 1;
+    m.data_addr = 16; m.data = "\x80\xff" "ABCD";
+    m.nglob = 2;
+    m.gtype[0] = I32; m.globals[0] = 5;
+    m.gtype[1] = I64; m.globals[1] = -3;
+    int32_t r;
+
+    Fn *f = fn_new(&m, "ld8s", 1, I32, I32);  get(f, 0); mem(f, 0x2C, 16);
+    f = fn_new(&m, "ld8u", 1, I32, I32);      get(f, 0); mem(f, 0x2D, 16);
+    f = fn_new(&m, "ld16s", 1, I32, I32);     get(f, 0); mem(f, 0x2E, 16);
+    f = fn_new(&m, "ld32", 1, I32, I32);      get(f, 0); mem(f, 0x28, 0);
+    // rt(x): store x as i64 at 100, read back low byte sign-extended as i64, wrap
+    f = fn_new(&m, "rt", 1, I32, I32);
+    i32c(f, 100); get(f, 0); op(f, 0xAC); mem(f, 0x37, 0);
+    i32c(f, 100); mem(f, 0x30, 0); op(f, 0xA7);
+    f = fn_new(&m, "st16", 1, I32, I32);      // store16 then load32
+    i32c(f, 200); get(f, 0); mem(f, 0x3B, 0); i32c(f, 200); mem(f, 0x28, 0);
+    f = fn_new(&m, "oob", 1, I32, I32);       get(f, 0); mem(f, 0x28, 0xFFFE);
+    f = fn_new(&m, "msz", 0, 0, I32);         op(f, 0x3F); op(f, 0x00);
+    f = fn_new(&m, "mgrow", 1, I32, I32);     get(f, 0); op(f, 0x40); op(f, 0x00);
+    // g(): global0 += 1; return global0 + wrap(global1)
+    f = fn_new(&m, "g", 0, 0, I32);
+    op_u(f, 0x23, 0); i32c(f, 1); op(f, 0x6A); op_u(f, 0x24, 0);
+    op_u(f, 0x23, 0); op_u(f, 0x23, 1); op(f, 0xA7); op(f, 0x6A);
+
+    if (!load(&m)) { tests_failed++; return; }
+    call32("ld8s", 0, 0, 1, &r);  ASSERT_EQ(r, -128, "i32.load8_s from data segment");
+    call32("ld8u", 0, 0, 1, &r);  ASSERT_EQ(r, 0x80, "i32.load8_u");
+    call32("ld16s", 0, 0, 1, &r); ASSERT_EQ(r, (int16_t)0xFF80, "i32.load16_s little-endian");
+    call32("ld32", 18, 0, 1, &r); ASSERT_EQ(r, 0x44434241, "i32.load unaligned");
+    call32("rt", 0x1FE, 0, 1, &r); ASSERT_EQ(r, -2, "i64.store + i64.load8_s");
+    call32("st16", 0x12345678, 0, 1, &r); ASSERT_EQ(r, 0x5678, "i32.store16 stores low half");
+    EFI_STATUS st = call32("oob", 0, 0, 1, &r);
+    ASSERT_TRUE(st == EFI_ABORTED, "load across end of memory traps");
+    st = call32("oob", -1, 0, 1, &r);
+    ASSERT_TRUE(st == EFI_ABORTED, "address + offset does not wrap");
+    call32("msz", 0, 0, 0, &r);   ASSERT_EQ(r, 1, "memory.size = 1 page");
+    call32("mgrow", 0, 0, 1, &r); ASSERT_EQ(r, 1, "memory.grow 0 → old size");
+    call32("mgrow", 1, 0, 1, &r); ASSERT_EQ(r, -1, "memory.grow beyond pool fails");
+    call32("g", 0, 0, 0, &r);     ASSERT_EQ(r, 3, "globals read/write");
+    call32("g", 0, 0, 0, &r);     ASSERT_EQ(r, 4, "global state persists across calls");
+}
+
+// ============================================================
+// Test 4: calls, recursion, validation
+// ============================================================
+static void build_fib(Mod *m) {
+    memset(m, 0, sizeof(*m));
+    // fib(n) = n < 2 ? n : fib(n-1) + fib(n-2)
+    Fn *f = fn_new(m, "fib", 1, I32, I32);
+    get(f, 0); i32c(f, 2); op(f, 0x48);
+    op(f, 0x04); op(f, I32);
+      get(f, 0);
+    op(f, 0x05);
+      get(f, 0); i32c(f, 1); op(f, 0x6B); op_u(f, 0x10, 0);
+      get(f, 0); i32c(f, 2); op(f, 0x6B); op_u(f, 0x10, 0);
+      op(f, 0x6A);
+    op(f, 0x0B);
+    // deep(n): unbounded recursion
+    f = fn_new(m, "deep", 1, I32, I32);
+    get(f, 0); i32c(f, 1); op(f, 0x6A); op_u(f, 0x10, 1);
+}
+
+static int rejects(Mod *m, const char *what) {
+    Buf *o = assemble(m);
+    oo_wasm_unload(&g_mod);
+    EFI_STATUS st = oo_wasm_load_buf(&g_mod, o->b, (UINTN)o->n);
+    if (!EFI_ERROR(st)) return 0;
+    printf("    (%s → %s)\n", what, (const char *)g_mod.error);
+    return !g_mod.loaded && g_mod.insns == NULL && g_mod.data == NULL;
+}
+
+static void test_calls(void) {
+    printf("\n[Test 4] calls / validation\n");
+    static Mod m;
+    int32_t r;
+    build_fib(&m);
+    if (!load(&m)) { tests_failed++; return; }
+    call32("fib", 20, 0, 1, &r);
+    ASSERT_EQ(r, 6765, "fib(20) recursive");
+    EFI_STATUS st = call32("deep", 0, 0, 1, &r);
+    ASSERT_TRUE(st == EFI_ABORTED, "runaway recursion traps (no host stack overflow)");
+    call32("fib", 10, 0, 1, &r);
+    ASSERT_EQ(r, 55, "module usable after a trap");
+
+    memset(&m, 0, sizeof(m));
+    Fn *f = fn_new(&m, "f", 0, 0, I32); op(f, 0x6A);
+    ASSERT_TRUE(rejects(&m, "stack underflow"), "rejects operand stack underflow");
+
+    memset(&m, 0, sizeof(m));
+    f = fn_new(&m, "f", 0, 0, I32); i32c(f, 1); i32c(f, 2);
+    ASSERT_TRUE(rejects(&m, "extra value"), "rejects result count mismatch");
+
+    memset(&m, 0, sizeof(m));
+    f = fn_new(&m, "f", 0, 0, 0); op_u(f, 0x0C, 3);
+    ASSERT_TRUE(rejects(&m, "branch depth"), "rejects out-of-range branch");
+
+    memset(&m, 0, sizeof(m));
+    f = fn_new(&m, "f", 0, 0, 0); op(f, 0x43); put(&f->code, 0); put(&f->code, 0); put(&f->code, 0); put(&f->code, 0); op(f, 0x1A);
+    ASSERT_TRUE(rejects(&m, "f32.const"), "rejects float opcodes");
+
+    memset(&m, 0, sizeof(m));
+    f = fn_new(&m, "f", 0, 0, 0); op_u(f, 0x20, 4);
+    ASSERT_TRUE(rejects(&m, "local index"), "rejects bad local index");
+
+    memset(&m, 0, sizeof(m));
+    f = fn_new(&m, "f", 0, 0, 0); op_u(f, 0x10, 9);
+    ASSERT_TRUE(rejects(&m, "call index"), "rejects bad call target");
+
+    uint8_t trunc[] = { 0, 'a', 's', 'm', 1, 0, 0, 0, 1, 0x40, 0 };
+    ASSERT_TRUE(EFI_ERROR(oo_wasm_load_buf(&g_mod, trunc, sizeof(trunc))), "rejects truncated section");
+}
+
+// ============================================================
+// Benchmarks
+// ============================================================
+static void bench(const char *name, const char *fn, int32_t arg, int32_t expect, double insns) {
+    int32_t r = 0;
+    double t0 = now_ns();
+    EFI_STATUS st = call32(fn, arg, 0, 1, &r);
+    double t1 = now_ns();
+    ASSERT_TRUE(st == EFI_SUCCESS && r == expect, name);
+    printf("    %-10s %8.2f ms   %.2f ns/insn\n", fn, (t1 - t0) / 1e6, (t1 - t0) / insns);
+}
+
+static void test_bench(void) {
+    printf("\n[Bench] interpreter throughput\n");
+    static Mod m; memset(&m, 0, sizeof(m));
+    m.memory = 1;
+
+    // sum(n): loop 10 insns/iter
+    Fn *f = fn_new(&m, "sum", 1, I32, I32);
+    f->locals = 1;
+    op(f, 0x03); op(f, 0x40);
+      get(f, 1); get(f, 0); op(f, 0x6A); set(f, 1);
+      get(f, 0); i32c(f, 1); op(f, 0x6B); op_u(f, 0x22, 0);
+      op_u(f, 0x0D, 0);
+    op(f, 0x0B);
+    get(f, 1);
+
+    // fib(n)
+    Fn *g = fn_new(&m, "fib", 1, I32, I32);
+    get(g, 0); i32c(g, 2); op(g, 0x48);
+    op(g, 0x04); op(g, I32);
+      get(g, 0);
+    op(g, 0x05);
+      get(g, 0); i32c(g, 1); op(g, 0x6B); op_u(g, 0x10, 1);
+      get(g, 0); i32c(g, 2); op(g, 0x6B); op_u(g, 0x10, 1);
+      op(g, 0x6A);
+    op(g, 0x0B);
+
+    // sieve(n): count primes < n using bytes in linear memory (n ≤ 64K)
+    Fn *s = fn_new(&m, "sieve", 1, I32, I32);
+    s->locals = 3;   // 1 = i, 2 = j, 3 = count
+    i32c(s, 2); set(s, 1);
+    op(s, 0x02); op(s, 0x40); op(s, 0x03); op(s, 0x40);
+      get(s, 1); get(s, 0); op(s, 0x4E); op_u(s, 0x0D, 1);        // i >= n → exit
+      get(s, 1); mem(s, 0x2D, 0); op(s, 0x45);
+      op(s, 0x04); op(s, 0x40);
+        get(s, 3); i32c(s, 1); op(s, 0x6A); set(s, 3);
+        get(s, 1); get(s, 1); op(s, 0x6C); set(s, 2);
+        op(s, 0x02); op(s, 0x40); op(s, 0x03); op(s, 0x40);
+          get(s, 2); get(s, 0); op(s, 0x4F); op_u(s, 0x0D, 1);    // j >= n → exit
+          get(s, 2); i32c(s, 1); mem(s, 0x3A, 0);
+          get(s, 2); get(s, 1); op(s, 0x6A); set(s, 2);
+          op_u(s, 0x0C, 0);
+        op(s, 0x0B); op(s, 0x0B);
+      op(s, 0x0B);
+      get(s, 1); i32c(s, 1); op(s, 0x6A); set(s, 1);
+      op_u(s, 0x0C, 0);
+    op(s, 0x0B); op(s, 0x0B);
+    get(s, 3);
+
+    if (!load(&m)) { tests_failed++; return; }
+    printf("    compiled: %u insns for %u functions\n", g_mod.insn_count, g_mod.func_count);
+    bench("sum(10M) loop", "sum", 10000000, (int32_t)(10000000LL * 10000001LL / 2), 10.0 * 1e7);
+    bench("fib(27) recursion", "fib", 27, 196418, 12.0 * 832039.0 * 1.6);
+    bench("sieve(65000) memory kernel", "sieve", 65000, 6493, 65000.0 * 12 + 160000.0 * 9);
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(void) {
+    printf("==============================================\n");
+    printf("  OO WASM Interpreter — Host Test Suite\n");
+    printf("==============================================\n");
+
+    oo_wasm_init(&g_mod);
+    test_integer();
+    test_control();
+    test_memory();
+    test_calls();
+    test_bench();
+    oo_wasm_unload(&g_mod);
+
+    printf("\n==============================================\n");
+    printf("  PASSED: %d\n", tests_passed);
+    printf("  FAILED: %d\n", tests_failed);
+    printf("==============================================\n");
+
+    if (tests_failed == 0) {
+        printf("\n[OK] All WASM interpreter tests passed.\n");
+        return 0;
+    } else {
+        printf("\n[FAIL] %d test(s) failed.\n", tests_failed);
+        return 1;
+    }
+}